@@ -0,0 +1,718 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_auxadc_svc.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This source file defines the AUXADC sampling service.
+*
+*  The scan runs in the timer task. It only tries the AUXADC semaphore, a
+*  period that finds it taken by a one-shot reading is skipped, not queued.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <string.h>
+#include "cmsis_os.h"
+#include "opl1000.h"
+#include "hal_auxadc.h"
+#include "hal_auxadc_internal.h"
+#include "hal_auxadc_svc.h"
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define AOS                     ((S_Aos_Reg_t *) AOS_BASE)
+#define RF                      ((S_Rf_Reg_t *) RF_BASE)
+
+#define RF_RG_EOCB              (1 << 16)   // the bit[16] of RG_AUX_ADC_ECL_OUT: End of conversion sign
+#define HAL_AUX_SVC_EOC_POLL    0xFF
+
+#define HAL_AUX_SVC_Q16         16
+
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list
+typedef struct
+{
+    volatile uint32_t RET_MUX;            // 0x000
+    volatile uint32_t MODE_CTL;           // 0x004
+    volatile uint32_t OSC_SEL;            // 0x008
+    volatile uint32_t SLP_TIMER_CURR_L;   // 0x00C
+    volatile uint32_t SLP_TIMER_CURR_H;   // 0x010
+    volatile uint32_t SLP_TIMER_PRESET_L; // 0x014
+    volatile uint32_t SLP_TIMER_PRESET_H; // 0x018
+    volatile uint32_t PS_TIMER_PRESET;    // 0x01C
+    volatile uint32_t RET_SF_VAL_CTL;     // 0x020
+    volatile uint32_t PMU_SF_VAL_CTL;     // 0x024
+    volatile uint32_t HPBG_CTL;           // 0x028
+    volatile uint32_t LPBG_CTL;           // 0x02C
+    volatile uint32_t BUCK_CTL;           // 0x030
+    volatile uint32_t ON1_TIME;           // 0x034
+    volatile uint32_t ON2_TIME;           // 0x038
+    volatile uint32_t ON3_TIME;           // 0x03C
+    volatile uint32_t ON4_TIME;           // 0x040
+    volatile uint32_t ON5_TIME;           // 0x044
+    volatile uint32_t ON6_TIME;           // 0x048
+    volatile uint32_t ON7_TIME;           // 0x04C
+    volatile uint32_t CPOR_N_ON_TIME;     // 0x050
+    volatile uint32_t reserve_054;        // 0x054, reserved
+    volatile uint32_t SPS_TIMER_PRESET;   // 0x058
+    volatile uint32_t SON1_TIME;          // 0x05C
+    volatile uint32_t SON2_TIME;          // 0x060
+    volatile uint32_t SON3_TIME;          // 0x064
+    volatile uint32_t SON4_TIME;          // 0x068
+    volatile uint32_t SON5_TIME;          // 0x06C
+    volatile uint32_t SON6_TIME;          // 0x070
+    volatile uint32_t SON7_TIME;          // 0x074
+    volatile uint32_t SCPOR_N_ON_TIME;    // 0x078
+    volatile uint32_t PU_CTL;             // 0x07C
+    volatile uint32_t OSC_CTL;            // 0x080
+    volatile uint32_t PMS_SPARE;          // 0x084, HW reservd for debug
+    volatile uint32_t ADC_CTL;            // 0x088
+    volatile uint32_t LDO_CTL;            // 0x08C
+    volatile uint32_t RG_PD_IE;           // 0x090
+    volatile uint32_t RG_PD_PE;           // 0x094
+    volatile uint32_t RG_PD_O_INV;        // 0x098
+    volatile uint32_t RG_PD_DS;           // 0x09C
+    volatile uint32_t RG_GPO;             // 0x0A0
+    volatile uint32_t RG_PD_I_INV;        // 0x0A4
+    volatile uint32_t RG_PDOV_MODE;       // 0x0A8
+    volatile uint32_t RG_PD_DIR;          // 0x0AC
+    volatile uint32_t RG_PD_OENP_INV;     // 0x0B0
+    volatile uint32_t RG_PDOC_MODE;       // 0x0B4
+    volatile uint32_t RG_GPI;             // 0x0B8
+    volatile uint32_t reserve_0bc;        // 0x0BC, reserved
+    volatile uint32_t RG_PDI_SRC_IO_A;    // 0x0C0
+    volatile uint32_t RG_PDI_SRC_IO_B;    // 0x0C4
+    volatile uint32_t RG_PDI_SRC_IO_C;    // 0x0C8
+    volatile uint32_t RG_PDI_SRC_IO_D;    // 0x0CC
+    volatile uint32_t RG_PTS_INMUX_A;     // 0x0D0
+    volatile uint32_t RG_PTS_INMUX_B;     // 0x0D4
+    volatile uint32_t RG_PTS_INMUX_C;     // 0x0D8
+    volatile uint32_t RG_PTS_INMUX_D;     // 0x0DC
+    volatile uint32_t RG_SRAM_IOS_EN;     // 0x0E0
+    volatile uint32_t RG_SRAM_RET_OFF;    // 0x0E4
+    volatile uint32_t RG_PHY_WR_SRAM;     // 0x0E8
+    volatile uint32_t RG_PHY_RD_SRAM;     // 0x0EC
+    volatile uint32_t CAL_CEN;            // 0x0F0
+    volatile uint32_t CAL_STR;            // 0x0F4
+    volatile uint32_t SDM_PT_SEL;         // 0x0F8
+    volatile uint32_t SDM_CTL;            // 0x0FC
+    volatile uint32_t R_STRAP_MODE_CTL;   // 0x100
+    volatile uint32_t R_APS_SWRST;        // 0x104
+    volatile uint32_t R_MSQ_SWRST;        // 0x108
+    volatile uint32_t RG_SPARE;           // 0x10C
+    volatile uint32_t RG_PTS_INMUX_E;     // 0x110
+    volatile uint32_t RG_PTS_INMUX_F;     // 0x114
+    volatile uint32_t RG_SRAM_RET_ACK;    // 0x118
+    volatile uint32_t RG_MSQ_ROM_MAP;     // 0x11C
+    volatile uint32_t RG_AOS_ID;          // 0x120
+    volatile uint32_t RG_SPARE_1;         // 0x124
+    volatile uint32_t RG_RSTS;            // 0x128
+    volatile uint32_t RG_SPARE_2;         // 0x12C
+    volatile uint32_t RG_SPARE_3;         // 0x130
+    volatile uint32_t R_M3CLK_SEL;        // 0x134
+    volatile uint32_t R_M0CLK_SEL;        // 0x138
+    volatile uint32_t R_RFPHY_SEL;        // 0x13C
+    volatile uint32_t R_SCRT_EN;          // 0x140
+    volatile uint32_t reserve_144[21];    // 0x144 ~ 0x194, move to sys_reg
+    volatile uint32_t R_CLK_MMFACTOR_CM3; // 0x198
+} S_Aos_Reg_t;
+
+typedef struct
+{
+    volatile uint32_t reserve_000[2];     // 0x000 ~ 0x004, reserved
+    volatile uint32_t RG_SPARE;           // 0x008
+    volatile uint32_t reserve_00C[15];    // 0x00C ~ 0x044, reserved
+    volatile uint32_t RG_CK_GATE_CTRL;    // 0x048
+    volatile uint32_t reserve_04C[4];     // 0x04C ~ 0x058, reserved
+    volatile uint32_t AUXADC_CTRL0;       // 0x05C
+    volatile uint32_t reserve_060[1];     // 0x060 ~ 0x060, reserved
+    volatile uint32_t RG_AUX_IN_SEL;      // 0x064
+    volatile uint32_t reserve_068[10];    // 0x068 ~ 0x08C, reserved
+    volatile uint32_t PU_VAL;             // 0x090
+    volatile uint32_t reserve_094[14];    // 0x094 ~ 0x0C8, reserved
+    volatile uint32_t AUX_ADC_CK_GEN_CTL; // 0x0CC
+    volatile uint32_t RG_AUX_ADC_ECL_OUT; // 0x0D0
+} S_Rf_Reg_t;
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+extern uint8_t g_ubHalAux_Init;
+extern E_HalAux_Src_t g_tHalAux_CurrentType;
+extern T_HalAuxCalData g_tHalAux_CalData;
+extern osSemaphoreId g_taHalAux_SemaphoreId;
+
+
+// Sec 5: declaration of global function prototype
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static uint8_t g_ubHalAuxSvc_Active;
+static uint8_t g_ubHalAuxSvc_TempOn;            // the temperature sensor is on for the scan list
+static T_HalAuxSvcCfg g_tHalAuxSvc_Cfg;
+static osTimerId g_tHalAuxSvc_TimerId;
+static T_Hal_Aux_AdcValueGet_Fp g_tHalAuxSvc_AdcValueGet;   // the power-cycling one
+
+static uint32_t g_ulHalAuxSvc_SlopeVbat;        // mV per LSB, Q16
+static uint32_t g_ulHalAuxSvc_SlopeIo;          // mV per LSB, Q16
+static E_HalAux_Src_t g_tHalAuxSvc_LastSrc;
+static uint8_t g_ubHalAuxSvc_LastGpio;
+
+static T_HalAuxSvcSample g_taHalAuxSvc_Ring[HAL_AUX_SVC_RING_NUM];
+static uint32_t g_ulHalAuxSvc_RingHead;         // the next to write
+static uint32_t g_ulHalAuxSvc_RingNum;
+static T_HalAuxSvcSample g_taHalAuxSvc_Latest[HAL_AUX_SVC_CH_MAX];
+static T_HalAuxSvcStat g_tHalAuxSvc_Stat;
+
+
+// Sec 7: declaration of static function prototype
+
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+static void Hal_Aux_SvcTempSensor(uint8_t ubOn)
+{
+    volatile uint32_t tmp;
+
+    tmp = AOS->HPBG_CTL;
+    tmp &= ~(0x1 << 18);
+    tmp |= ((ubOn ? 0x1 : 0x0) << 18);
+    AOS->HPBG_CTL = tmp;
+}
+
+static void Hal_Aux_SvcPower(uint8_t ubOn)
+{
+    volatile uint32_t tmp;
+    uint32_t ulBit = (ubOn) ? 0x1 : 0x0;
+
+    // AUXADC
+    tmp = AOS->ADC_CTL;
+    tmp &= ~(0x1 << 0);
+    tmp |= (ulBit << 0);
+    AOS->ADC_CTL = tmp;
+
+    // PU of AUXADC
+    tmp = RF->PU_VAL;
+    tmp &= ~(0x1 << 26);
+    tmp |= (ulBit << 26);
+    RF->PU_VAL = tmp;
+
+    // clock to AUXADC
+    tmp = RF->RG_CK_GATE_CTRL;
+    tmp &= ~(0x1 << 6);
+    tmp |= (ulBit << 6);
+    RF->RG_CK_GATE_CTRL = tmp;
+
+    // Idle (non-trigger)
+    tmp = RF->AUX_ADC_CK_GEN_CTL;
+    tmp &= ~(0x1 << 0);
+    tmp |= (0x0 << 0);
+    RF->AUX_ADC_CK_GEN_CTL = tmp;
+}
+
+static uint8_t Hal_Aux_SvcConvert(uint32_t *pulValue)
+{
+    volatile uint32_t tmp;
+    volatile uint32_t i;
+    uint8_t ubRet = HAL_AUX_FAIL;
+
+    // Trigger
+    tmp = RF->AUX_ADC_CK_GEN_CTL;
+    tmp &= ~(0x1 << 0);
+    tmp |= (0x1 << 0);
+    RF->AUX_ADC_CK_GEN_CTL = tmp;
+
+    // get the ADC value
+    i = 0;
+    while (RF->RG_AUX_ADC_ECL_OUT & RF_RG_EOCB)
+    {
+        if (i >= HAL_AUX_SVC_EOC_POLL)
+            goto done;
+        i++;
+    }
+    *pulValue = RF->RG_AUX_ADC_ECL_OUT & 0x03FF;
+
+    ubRet = HAL_AUX_OK;
+
+done:
+    // Idle (non-trigger), ready for the next trigger
+    tmp = RF->AUX_ADC_CK_GEN_CTL;
+    tmp &= ~(0x1 << 0);
+    tmp |= (0x0 << 0);
+    RF->AUX_ADC_CK_GEN_CTL = tmp;
+
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Aux_AdcValueGet_patch
+*
+* DESCRIPTION:
+*   get the ADC value from AUXADC, without the power cycle while the
+*   service keeps the AUXADC on
+*
+* PARAMETERS
+*   1. pulValue : [Out] the ADC value
+*
+* RETURNS
+*   1. HAL_AUX_OK   : success
+*   2. HAL_AUX_FAIL : fail
+*
+*************************************************************************/
+static uint8_t Hal_Aux_AdcValueGet_patch(uint32_t *pulValue)
+{
+    uint8_t ubTemp = 0;
+    uint8_t ubRet;
+
+    if (!g_ubHalAuxSvc_Active)
+        return g_tHalAuxSvc_AdcValueGet(pulValue);
+
+    // the scan list does not keep the temperature sensor on
+    ubTemp = ((g_tHalAux_CurrentType == HAL_AUX_SRC_TEMP_SEN) && (!g_ubHalAuxSvc_TempOn));
+    if (ubTemp)
+        Hal_Aux_SvcTempSensor(1);
+
+    ubRet = Hal_Aux_SvcConvert(pulValue);
+
+    if (ubTemp)
+        Hal_Aux_SvcTempSensor(0);
+
+    // the next scan has to settle again
+    g_tHalAuxSvc_LastSrc = HAL_AUX_SRC_MAX;
+
+    return ubRet;
+}
+
+// mV per LSB in Q16 from the V per LSB of the calibration data
+static uint32_t Hal_Aux_SvcSlopeQ16(float fSlope)
+{
+    if (fSlope <= 0)
+        return 0;
+
+    return (uint32_t)(fSlope * 1000 * (1 << HAL_AUX_SVC_Q16) + 0.5f);
+}
+
+static uint16_t Hal_Aux_SvcMilliVolt(const T_HalAuxSvcCh *ptCh, uint32_t ulSum, uint32_t ulNum)
+{
+    uint32_t ulSlope;
+    uint32_t ulOffset;
+    uint64_t ullMv;
+
+    if (ptCh->tSrc == HAL_AUX_SRC_VBAT)
+    {
+        ulSlope = g_ulHalAuxSvc_SlopeVbat;
+        ulOffset = g_tHalAux_CalData.uwDcOffsetVbat;
+    }
+    else if (ptCh->tSrc == HAL_AUX_SRC_GPIO)
+    {
+        ulSlope = g_ulHalAuxSvc_SlopeIo;
+        ulOffset = g_tHalAux_CalData.uwDcOffsetIo;
+    }
+    else
+    {
+        return HAL_AUX_SVC_MV_NONE;
+    }
+
+    // check the base(DC offset), on the sum to keep the resolution of the average
+    ulOffset *= ulNum;
+    if (ulSum <= ulOffset)
+        return HAL_AUX_BASE_VBAT;
+
+    ullMv = ((uint64_t)(ulSum - ulOffset) * ulSlope) / ulNum;
+    ullMv = (ullMv + (1 << (HAL_AUX_SVC_Q16 - 1))) >> HAL_AUX_SVC_Q16;
+
+    if (ullMv >= HAL_AUX_SVC_MV_NONE)
+        ullMv = HAL_AUX_SVC_MV_NONE - 1;
+
+    return (uint16_t)ullMv;
+}
+
+static void Hal_Aux_SvcPush(const T_HalAuxSvcSample *ptSample)
+{
+    uint32_t ulIdx;
+
+    if (g_ulHalAuxSvc_RingNum >= HAL_AUX_SVC_RING_NUM)
+    {
+        // drop the oldest
+        g_ulHalAuxSvc_RingNum--;
+        g_tHalAuxSvc_Stat.ulOverrun++;
+    }
+
+    ulIdx = g_ulHalAuxSvc_RingHead;
+    memcpy(&g_taHalAuxSvc_Ring[ulIdx], ptSample, sizeof(T_HalAuxSvcSample));
+
+    g_ulHalAuxSvc_RingHead = (ulIdx + 1) % HAL_AUX_SVC_RING_NUM;
+    g_ulHalAuxSvc_RingNum++;
+}
+
+static void Hal_Aux_SvcTimer(void const *argument)
+{
+    const T_HalAuxSvcCh *ptCh;
+    T_HalAuxSvcSample tSample;
+    uint32_t ulValue;
+    uint32_t ulSum;
+    uint32_t ulTick;
+    uint8_t ubDiscard;
+    uint8_t i, j;
+
+    if (!g_ubHalAuxSvc_Active)
+        return;
+
+    // a one-shot reading is in progress, do not hold up the timer task
+    if (osSemaphoreWait(g_taHalAux_SemaphoreId, 0) != osOK)
+    {
+        g_tHalAuxSvc_Stat.ulSkip++;
+        return;
+    }
+
+    if (!g_ubHalAuxSvc_Active)
+        goto done;
+
+    ulTick = osKernelSysTick();
+
+    for (i=0; i<g_tHalAuxSvc_Cfg.ubChNum; i++)
+    {
+        ptCh = &g_tHalAuxSvc_Cfg.taCh[i];
+
+        if (HAL_AUX_OK != Hal_Aux_SourceSelect(ptCh->tSrc, ptCh->ubGpioIdx))
+            continue;
+
+        // the input changed, let it settle
+        ubDiscard = 0;
+        if ((ptCh->tSrc != g_tHalAuxSvc_LastSrc) || ((ptCh->tSrc == HAL_AUX_SRC_GPIO) && (ptCh->ubGpioIdx != g_ubHalAuxSvc_LastGpio)))
+            ubDiscard = g_tHalAuxSvc_Cfg.ubDiscard;
+        g_tHalAuxSvc_LastSrc = ptCh->tSrc;
+        g_ubHalAuxSvc_LastGpio = ptCh->ubGpioIdx;
+
+        for (j=0; j<ubDiscard; j++)
+            Hal_Aux_SvcConvert(&ulValue);
+
+        ulSum = 0;
+        for (j=0; j<g_tHalAuxSvc_Cfg.ubOversample; j++)
+        {
+            if (HAL_AUX_OK != Hal_Aux_SvcConvert(&ulValue))
+                break;
+            ulSum += ulValue;
+        }
+        g_tHalAuxSvc_Stat.ulConvert += ubDiscard + j;
+
+        if (j < g_tHalAuxSvc_Cfg.ubOversample)
+        {
+            g_tHalAuxSvc_Stat.ulFail++;
+            g_tHalAuxSvc_LastSrc = HAL_AUX_SRC_MAX;
+            continue;
+        }
+
+        tSample.ulTick = ulTick;
+        tSample.ubCh = i;
+        tSample.uwRaw = (uint16_t)((ulSum + (j / 2)) / j);
+        tSample.uwMilliVolt = Hal_Aux_SvcMilliVolt(ptCh, ulSum, j);
+
+        Hal_Aux_SvcPush(&tSample);
+        memcpy(&g_taHalAuxSvc_Latest[i], &tSample, sizeof(T_HalAuxSvcSample));
+    }
+
+    g_tHalAuxSvc_Stat.ulScan++;
+
+done:
+    osSemaphoreRelease(g_taHalAux_SemaphoreId);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Aux_SvcStart
+*
+* DESCRIPTION:
+*   power the AUXADC up and start to scan the channel list periodically
+*
+* PARAMETERS
+*   1. ptCfg : [In] the period, averaging and the channel list
+*
+* RETURNS
+*   1. HAL_AUX_OK   : success
+*   2. HAL_AUX_FAIL : fail, or the service is running already
+*
+*************************************************************************/
+uint8_t Hal_Aux_SvcStart(const T_HalAuxSvcCfg *ptCfg)
+{
+    osTimerDef_t tTimerDef;
+    uint8_t ubRet = HAL_AUX_FAIL;
+    uint8_t i;
+
+    // check init
+    if ((g_ubHalAux_Init != 1) || (g_ubHalAuxSvc_Active))
+        return ubRet;
+
+    if ((ptCfg == NULL) || (ptCfg->ubChNum == 0) || (ptCfg->ubChNum > HAL_AUX_SVC_CH_MAX))
+        return ubRet;
+
+    if ((ptCfg->ubOversample == 0) || (ptCfg->ubOversample > HAL_AUX_SVC_OVERSAMPLE_MAX) || (ptCfg->ulPeriodMs < HAL_AUX_SVC_PERIOD_MIN))
+        return ubRet;
+
+    for (i=0; i<ptCfg->ubChNum; i++)
+    {
+        if (ptCfg->taCh[i].tSrc >= HAL_AUX_SRC_MAX)
+            return ubRet;
+        if ((ptCfg->taCh[i].tSrc == HAL_AUX_SRC_GPIO) && (ptCfg->taCh[i].ubGpioIdx >= HAL_AUX_GPIO_NUM_MAX))
+            return ubRet;
+    }
+
+    if (g_tHalAuxSvc_TimerId == NULL)
+    {
+        tTimerDef.ptimer = Hal_Aux_SvcTimer;
+        g_tHalAuxSvc_TimerId = osTimerCreate(&tTimerDef, osTimerPeriodic, NULL);
+        if (g_tHalAuxSvc_TimerId == NULL)
+            return ubRet;
+    }
+
+    // wait the semaphore
+    osSemaphoreWait(g_taHalAux_SemaphoreId, osWaitForever);
+
+    memcpy(&g_tHalAuxSvc_Cfg, ptCfg, sizeof(T_HalAuxSvcCfg));
+    memset(g_taHalAuxSvc_Latest, 0, sizeof(g_taHalAuxSvc_Latest));
+    g_ulHalAuxSvc_RingHead = 0;
+    g_ulHalAuxSvc_RingNum = 0;
+    g_tHalAuxSvc_LastSrc = HAL_AUX_SRC_MAX;
+
+    // the float calibration data, converted once
+    g_ulHalAuxSvc_SlopeVbat = Hal_Aux_SvcSlopeQ16(g_tHalAux_CalData.fSlopeVbat);
+    g_ulHalAuxSvc_SlopeIo = Hal_Aux_SvcSlopeQ16(g_tHalAux_CalData.fSlopeIo);
+
+    g_ubHalAuxSvc_TempOn = 0;
+    for (i=0; i<ptCfg->ubChNum; i++)
+    {
+        if (ptCfg->taCh[i].tSrc == HAL_AUX_SRC_TEMP_SEN)
+            g_ubHalAuxSvc_TempOn = 1;
+    }
+
+    Hal_Aux_SvcPower(1);
+    if (g_ubHalAuxSvc_TempOn)
+        Hal_Aux_SvcTempSensor(1);
+
+    g_tHalAuxSvc_AdcValueGet = Hal_Aux_AdcValueGet;
+    Hal_Aux_AdcValueGet = Hal_Aux_AdcValueGet_patch;
+    g_ubHalAuxSvc_Active = 1;
+
+    if (osTimerStart(g_tHalAuxSvc_TimerId, ptCfg->ulPeriodMs) != osOK)
+    {
+        g_ubHalAuxSvc_Active = 0;
+        Hal_Aux_AdcValueGet = g_tHalAuxSvc_AdcValueGet;
+        Hal_Aux_SvcTempSensor(0);
+        Hal_Aux_SvcPower(0);
+        goto done;
+    }
+
+    ubRet = HAL_AUX_OK;
+
+done:
+    // release the semaphore
+    osSemaphoreRelease(g_taHalAux_SemaphoreId);
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Aux_SvcStop
+*
+* DESCRIPTION:
+*   stop the scan and power the AUXADC down, the ring buffer is kept
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void Hal_Aux_SvcStop(void)
+{
+    if (!g_ubHalAuxSvc_Active)
+        return;
+
+    osTimerStop(g_tHalAuxSvc_TimerId);
+
+    // wait the semaphore, a running scan finishes first
+    osSemaphoreWait(g_taHalAux_SemaphoreId, osWaitForever);
+
+    g_ubHalAuxSvc_Active = 0;
+    Hal_Aux_AdcValueGet = g_tHalAuxSvc_AdcValueGet;
+
+    if (g_ubHalAuxSvc_TempOn)
+        Hal_Aux_SvcTempSensor(0);
+    g_ubHalAuxSvc_TempOn = 0;
+    Hal_Aux_SvcPower(0);
+
+    // release the semaphore
+    osSemaphoreRelease(g_taHalAux_SemaphoreId);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Aux_SvcActive
+*
+* DESCRIPTION:
+*   check if the service is running
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   1: running, 0: stopped
+*
+*************************************************************************/
+uint8_t Hal_Aux_SvcActive(void)
+{
+    return g_ubHalAuxSvc_Active;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Aux_SvcRead
+*
+* DESCRIPTION:
+*   take the oldest samples out of the ring buffer
+*
+* PARAMETERS
+*   1. ptSample : [Out] the samples
+*   2. ulNum    : [In] the size of ptSample
+*
+* RETURNS
+*   the number of samples
+*
+*************************************************************************/
+uint32_t Hal_Aux_SvcRead(T_HalAuxSvcSample *ptSample, uint32_t ulNum)
+{
+    uint32_t ulTail;
+    uint32_t i = 0;
+
+    if ((ptSample == NULL) || (g_taHalAux_SemaphoreId == NULL))
+        return 0;
+
+    // wait the semaphore
+    osSemaphoreWait(g_taHalAux_SemaphoreId, osWaitForever);
+
+    ulTail = (g_ulHalAuxSvc_RingHead + HAL_AUX_SVC_RING_NUM - g_ulHalAuxSvc_RingNum) % HAL_AUX_SVC_RING_NUM;
+
+    while ((i < ulNum) && (g_ulHalAuxSvc_RingNum > 0))
+    {
+        memcpy(&ptSample[i], &g_taHalAuxSvc_Ring[ulTail], sizeof(T_HalAuxSvcSample));
+        ulTail = (ulTail + 1) % HAL_AUX_SVC_RING_NUM;
+        g_ulHalAuxSvc_RingNum--;
+        i++;
+    }
+
+    // release the semaphore
+    osSemaphoreRelease(g_taHalAux_SemaphoreId);
+    return i;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Aux_SvcLatestGet
+*
+* DESCRIPTION:
+*   get the latest sample of a channel, the ring buffer is not touched
+*
+* PARAMETERS
+*   1. ubCh     : [In] the index in the channel list
+*   2. ptSample : [Out] the sample
+*
+* RETURNS
+*   1. HAL_AUX_OK   : success
+*   2. HAL_AUX_FAIL : fail, no sample yet
+*
+*************************************************************************/
+uint8_t Hal_Aux_SvcLatestGet(uint8_t ubCh, T_HalAuxSvcSample *ptSample)
+{
+    uint8_t ubRet = HAL_AUX_FAIL;
+
+    if ((ptSample == NULL) || (ubCh >= HAL_AUX_SVC_CH_MAX) || (g_taHalAux_SemaphoreId == NULL))
+        return ubRet;
+
+    // wait the semaphore
+    osSemaphoreWait(g_taHalAux_SemaphoreId, osWaitForever);
+
+    // no scan has reached the channel yet
+    if ((ubCh >= g_tHalAuxSvc_Cfg.ubChNum) || (g_taHalAuxSvc_Latest[ubCh].ulTick == 0))
+        goto done;
+
+    memcpy(ptSample, &g_taHalAuxSvc_Latest[ubCh], sizeof(T_HalAuxSvcSample));
+    ubRet = HAL_AUX_OK;
+
+done:
+    // release the semaphore
+    osSemaphoreRelease(g_taHalAux_SemaphoreId);
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Aux_SvcStatGet
+*
+* DESCRIPTION:
+*   get the counters of the service
+*
+* PARAMETERS
+*   1. ptStat : [Out] the counters
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void Hal_Aux_SvcStatGet(T_HalAuxSvcStat *ptStat)
+{
+    memcpy(ptStat, &g_tHalAuxSvc_Stat, sizeof(T_HalAuxSvcStat));
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Aux_SvcStatReset
+*
+* DESCRIPTION:
+*   clear the counters of the service
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void Hal_Aux_SvcStatReset(void)
+{
+    memset(&g_tHalAuxSvc_Stat, 0, sizeof(T_HalAuxSvcStat));
+}
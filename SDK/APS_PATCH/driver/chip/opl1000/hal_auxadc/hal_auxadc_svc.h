@@ -0,0 +1,129 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_auxadc_svc.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This include file defines the AUXADC sampling service.
+*
+*  Hal_Aux_SvcStart() powers the AUXADC up and keeps it on; a periodic timer
+*  then scans the channel list. Every channel is converted ubOversample
+*  times (after ubDiscard settling conversions when the input changed) and
+*  the average is converted to mV in fixed point with the calibration data
+*  of the AUXADC. The results go to a ring buffer (the oldest is dropped
+*  when it is full) and to the latest value of the channel.
+*
+*  Hal_Aux_VbatGet / Hal_Aux_IoVoltageGet keep working while the service
+*  runs, they share the AUXADC semaphore and skip the power cycle.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+#ifndef _HAL_AUXADC_SVC_H_
+#define _HAL_AUXADC_SVC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <stdint.h>
+#include "hal_auxadc.h"
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HAL_AUX_SVC_CH_MAX              8
+#define HAL_AUX_SVC_RING_NUM            32
+#define HAL_AUX_SVC_OVERSAMPLE_MAX      64
+#define HAL_AUX_SVC_PERIOD_MIN          10      // ms
+
+#define HAL_AUX_SVC_MV_NONE             0xFFFF  // no calibration for the source
+
+
+/******************************
+Declaration of data structure
+******************************/
+// Sec 3: structure, uniou, enum, linked list
+typedef struct
+{
+    E_HalAux_Src_t tSrc;
+    uint8_t ubGpioIdx;                  // HAL_AUX_SRC_GPIO only
+} T_HalAuxSvcCh;
+
+typedef struct
+{
+    uint32_t ulPeriodMs;                // one scan of the list per period
+    uint8_t ubOversample;               // conversions averaged per channel, 1 ~ HAL_AUX_SVC_OVERSAMPLE_MAX
+    uint8_t ubDiscard;                  // conversions dropped after the input changed
+    uint8_t ubChNum;
+    T_HalAuxSvcCh taCh[HAL_AUX_SVC_CH_MAX];
+} T_HalAuxSvcCfg;
+
+typedef struct
+{
+    uint32_t ulTick;                    // osKernelSysTick of the scan
+    uint8_t ubCh;                       // index in T_HalAuxSvcCfg.taCh
+    uint16_t uwRaw;                     // averaged ADC value
+    uint16_t uwMilliVolt;               // or HAL_AUX_SVC_MV_NONE
+} T_HalAuxSvcSample;
+
+typedef struct
+{
+    uint32_t ulScan;
+    uint32_t ulConvert;
+    uint32_t ulSkip;                    // the AUXADC was busy at the period
+    uint32_t ulFail;                    // conversion time-out
+    uint32_t ulOverrun;                 // samples dropped from the full ring
+} T_HalAuxSvcStat;
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+
+// Sec 5: declaration of global function prototype
+uint8_t Hal_Aux_SvcStart(const T_HalAuxSvcCfg *ptCfg);
+void Hal_Aux_SvcStop(void);
+uint8_t Hal_Aux_SvcActive(void);
+uint32_t Hal_Aux_SvcRead(T_HalAuxSvcSample *ptSample, uint32_t ulNum);
+uint8_t Hal_Aux_SvcLatestGet(uint8_t ubCh, T_HalAuxSvcSample *ptSample);
+void Hal_Aux_SvcStatGet(T_HalAuxSvcStat *ptStat);
+void Hal_Aux_SvcStatReset(void);
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+
+
+// Sec 7: declaration of static function prototype
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HAL_AUXADC_SVC_H_
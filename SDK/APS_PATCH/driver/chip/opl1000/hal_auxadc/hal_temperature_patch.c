@@ -0,0 +1,439 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_temperature_patch.c
+*
+*  Project:
+*  --------
+*  OPL1000 Project - the Temperature Sensor patch file
+*
+*  Description:
+*  ------------
+*  This implement file is include the fixed-point conversion of the
+*  Temperature Sensor.
+*
+*  The M3 has no FPU, so the resistor is computed from the voltages in mV
+*  and ohms, and the thermistor table is searched in integer. The float
+*  functions of the ROM are kept as wrappers of the fixed-point ones.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <stdlib.h>
+#include <string.h>
+#include "hal_auxadc.h"
+#include "hal_temperature.h"
+#include "hal_temperature_internal.h"
+#include "hal_temperature_patch.h"
+#include "boot_sequence.h"
+#include "mw_fim_default_group03_patch.h"
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HAL_TMPR_RESISTOR_MAX       10000   // the table unit, the same as the ROM
+
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+RET_DATA int32_t g_lHalTmpr_Offset;                     // milli-degree
+
+
+// Sec 5: declaration of global function prototype
+extern void Hal_Tmpr_Init_impl(void);
+extern uint8_t Hal_Tmpr_TemperatureGet_impl(uint8_t ubGpioIdx, float *pfTemperature);
+extern uint8_t Hal_Tmpr_CompareResistor_impl(float fResistor, float *pfTemperature);
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static uint8_t g_ubHalTmprFix_Init;                     // 1: the integer table is valid
+static uint32_t g_ulaHalTmprFix_Thermistor[HAL_TMPR_STEP_MAX];  // ohm, descending
+static uint32_t g_ulHalTmprFix_VolDivResistor;          // ohm
+static int32_t g_lHalTmprFix_BaseTemperature;           // milli-degree
+
+
+// Sec 7: declaration of static function prototype
+
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Tmpr_FixOhm
+*
+* DESCRIPTION:
+*   convert a value of the calibration data (kohm) to ohm
+*
+* PARAMETERS
+*   1. fValue : [In] the value in kohm
+*
+* RETURNS
+*   the value in ohm, 0 for a negative one
+*
+*************************************************************************/
+static uint32_t Hal_Tmpr_FixOhm(float fValue)
+{
+    if (fValue <= 0)
+        return 0;
+
+    if (fValue >= (float)(0xFFFFFFFF / HAL_TMPR_FIX_OHM_PER_UNIT))
+        return 0xFFFFFFFF;
+
+    return (uint32_t)(fValue * HAL_TMPR_FIX_OHM_PER_UNIT + 0.5f);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Tmpr_FixTableUpdate
+*
+* DESCRIPTION:
+*   copy the calibration data to the integer table, call it again after
+*   g_tHalTmpr_CalData is changed
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   1. HAL_TMPR_OK   : success
+*   2. HAL_TMPR_FAIL : the table is not descending, the float conversion is used
+*
+*************************************************************************/
+uint8_t Hal_Tmpr_FixTableUpdate(void)
+{
+    uint8_t ubRet = HAL_TMPR_FAIL;
+    uint8_t i;
+
+    g_ubHalTmprFix_Init = 0;
+
+    for (i=0; i<HAL_TMPR_STEP_MAX; i++)
+    {
+        g_ulaHalTmprFix_Thermistor[i] = Hal_Tmpr_FixOhm(g_tHalTmpr_CalData.faThermistor[i]);
+
+        // the binary search needs a strictly descending table
+        if ((i > 0) && (g_ulaHalTmprFix_Thermistor[i] >= g_ulaHalTmprFix_Thermistor[i-1]))
+            goto done;
+    }
+
+    g_ulHalTmprFix_VolDivResistor = Hal_Tmpr_FixOhm(g_tHalTmpr_CalData.fVolDivResistor);
+
+    if (g_tHalTmpr_CalData.fBaseTemperature < 0)
+        g_lHalTmprFix_BaseTemperature = (int32_t)(g_tHalTmpr_CalData.fBaseTemperature * HAL_TMPR_FIX_MILLI - 0.5f);
+    else
+        g_lHalTmprFix_BaseTemperature = (int32_t)(g_tHalTmpr_CalData.fBaseTemperature * HAL_TMPR_FIX_MILLI + 0.5f);
+
+    g_ubHalTmprFix_Init = 1;
+    ubRet = HAL_TMPR_OK;
+
+done:
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Tmpr_Init
+*
+* DESCRIPTION:
+*   Temperature Sensor init, load the offset and build the integer table
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void Hal_Tmpr_Init_patch(void)
+{
+    Hal_Tmpr_Init_impl();
+
+    // cold boot
+    if (0 == Boot_CheckWarmBoot())
+    {
+        if (MW_FIM_OK != MwFim_FileRead(MW_FIM_IDX_GP03_PATCH_CAL_TMPR_OFFSET, 0, MW_FIM_CAL_TMPR_OFFSET_SIZE, (uint8_t*)&g_lHalTmpr_Offset))
+        {
+            // if fail, get the default value
+            g_lHalTmpr_Offset = g_lMwFimDefaultCalTmprOffset;
+        }
+    }
+
+    Hal_Tmpr_FixTableUpdate();
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Tmpr_CompareResistorFix
+*
+* DESCRIPTION:
+*   compare the resistor to get the temperature, without the offset
+*
+* PARAMETERS
+*   1. ulResistor    : [In] the resistor in ohm
+*   2. plMilliDegree : [Out] the temperature in milli-degree
+*
+* RETURNS
+*   1. HAL_TMPR_OK   : success
+*   2. HAL_TMPR_FAIL : fail
+*
+*************************************************************************/
+uint8_t Hal_Tmpr_CompareResistorFix(uint32_t ulResistor, int32_t *plMilliDegree)
+{
+    const uint32_t *pulTable = g_ulaHalTmprFix_Thermistor;
+    uint32_t ulStep;
+    uint32_t ulFrac;
+    uint8_t ubLow;
+    uint8_t ubHigh;
+    uint8_t ubMid;
+    uint8_t ubRet = HAL_TMPR_FAIL;
+
+    if (g_ubHalTmprFix_Init != 1)
+        goto done;
+
+    // max resistor : min temperature
+    if (ulResistor >= pulTable[0])
+    {
+        *plMilliDegree = g_lHalTmprFix_BaseTemperature;
+    }
+    // min resistor : max temperature
+    else if (ulResistor < pulTable[HAL_TMPR_STEP_MAX - 1])
+    {
+        *plMilliDegree = g_lHalTmprFix_BaseTemperature + (HAL_TMPR_STEP_MAX - 1) * HAL_TMPR_FIX_MILLI;
+    }
+    // others
+    else
+    {
+        // table[low] > resistor >= table[high]
+        ubLow = 0;
+        ubHigh = HAL_TMPR_STEP_MAX - 1;
+        while ((ubHigh - ubLow) > 1)
+        {
+            ubMid = (ubLow + ubHigh) >> 1;
+            if (pulTable[ubMid] > ulResistor)
+                ubLow = ubMid;
+            else
+                ubHigh = ubMid;
+        }
+
+        // 1 - (R - table[high]) / (table[low] - table[high]), rounded
+        ulStep = pulTable[ubLow] - pulTable[ubHigh];
+        ulFrac = ((ulResistor - pulTable[ubHigh]) * HAL_TMPR_FIX_MILLI + (ulStep >> 1)) / ulStep;
+
+        *plMilliDegree = g_lHalTmprFix_BaseTemperature + (ubLow + 1) * HAL_TMPR_FIX_MILLI - (int32_t)ulFrac;
+    }
+
+    ubRet = HAL_TMPR_OK;
+
+done:
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Tmpr_MilliDegreeGet
+*
+* DESCRIPTION:
+*   get the temperature in milli-degree, the offset is included
+*
+* PARAMETERS
+*   1. ubGpioIdx     : [In] the index of GPIO
+*   2. plMilliDegree : [Out] the temperature
+*
+* RETURNS
+*   1. HAL_TMPR_OK   : success
+*   2. HAL_TMPR_FAIL : fail
+*
+*************************************************************************/
+uint8_t Hal_Tmpr_MilliDegreeGet(uint8_t ubGpioIdx, int32_t *plMilliDegree)
+{
+    float fVbat;
+    float fIoVoltage;
+    uint32_t ulVbat;
+    uint32_t ulIoVoltage;
+    uint32_t ulResistor;
+    uint8_t ubRet = HAL_TMPR_FAIL;
+
+    // check init
+    if (g_ubHalTmprFix_Init != 1)
+        goto done;
+
+    if (HAL_AUX_OK != Hal_Aux_VbatGet(&fVbat))
+        goto done;
+
+    if (HAL_AUX_OK != Hal_Aux_IoVoltageGet(ubGpioIdx, &fIoVoltage))
+        goto done;
+
+    // mV
+    ulVbat = (fVbat > 0) ? (uint32_t)(fVbat * 1000 + 0.5f) : 0;
+    ulIoVoltage = (fIoVoltage > 0) ? (uint32_t)(fIoVoltage * 1000 + 0.5f) : 0;
+
+    // R1 = R2 * (Vbat - Vio) / Vio
+    if (ulIoVoltage == 0)
+    {
+        ulResistor = HAL_TMPR_RESISTOR_MAX * HAL_TMPR_FIX_OHM_PER_UNIT;
+    }
+    else if (ulIoVoltage >= ulVbat)
+    {
+        ulResistor = 0;
+    }
+    else
+    {
+        ulResistor = (uint32_t)(((uint64_t)g_ulHalTmprFix_VolDivResistor * (ulVbat - ulIoVoltage) + (ulIoVoltage >> 1)) / ulIoVoltage);
+    }
+
+    if (HAL_TMPR_OK != Hal_Tmpr_CompareResistorFix(ulResistor, plMilliDegree))
+        goto done;
+
+    *plMilliDegree += g_lHalTmpr_Offset;
+
+    ubRet = HAL_TMPR_OK;
+
+done:
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Tmpr_TemperatureGet
+*
+* DESCRIPTION:
+*   get the temperature, the offset is included
+*
+* PARAMETERS
+*   1. ubGpioIdx     : [In] the index of GPIO
+*   2. pfTemperature : [Out] the temperature
+*
+* RETURNS
+*   1. HAL_TMPR_OK   : success
+*   2. HAL_TMPR_FAIL : fail
+*
+*************************************************************************/
+uint8_t Hal_Tmpr_TemperatureGet_patch(uint8_t ubGpioIdx, float *pfTemperature)
+{
+    int32_t lMilliDegree;
+    uint8_t ubRet = HAL_TMPR_FAIL;
+
+    if (g_ubHalTmprFix_Init != 1)
+    {
+        // the table is not usable for the integer search
+        if (HAL_TMPR_OK != Hal_Tmpr_TemperatureGet_impl(ubGpioIdx, pfTemperature))
+            goto done;
+
+        *pfTemperature += (float)g_lHalTmpr_Offset / HAL_TMPR_FIX_MILLI;
+    }
+    else
+    {
+        if (HAL_TMPR_OK != Hal_Tmpr_MilliDegreeGet(ubGpioIdx, &lMilliDegree))
+            goto done;
+
+        *pfTemperature = (float)lMilliDegree / HAL_TMPR_FIX_MILLI;
+    }
+
+    ubRet = HAL_TMPR_OK;
+
+done:
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Tmpr_CompareResistor
+*
+* DESCRIPTION:
+*   compare the resistor to get the temperature
+*
+* PARAMETERS
+*   1. fResistor     : [In] the resistor
+*   2. pfTemperature : [Out] the temperature
+*
+* RETURNS
+*   1. HAL_TMPR_OK   : success
+*   2. HAL_TMPR_FAIL : fail
+*
+*************************************************************************/
+uint8_t Hal_Tmpr_CompareResistor_patch(float fResistor, float *pfTemperature)
+{
+    int32_t lMilliDegree;
+
+    if (HAL_TMPR_OK != Hal_Tmpr_CompareResistorFix(Hal_Tmpr_FixOhm(fResistor), &lMilliDegree))
+        return Hal_Tmpr_CompareResistor_impl(fResistor, pfTemperature);
+
+    *pfTemperature = (float)lMilliDegree / HAL_TMPR_FIX_MILLI;
+    return HAL_TMPR_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Tmpr_OffsetSet
+*
+* DESCRIPTION:
+*   set the calibration offset and write it to MW_FIM
+*
+* PARAMETERS
+*   1. lMilliDegree : [In] the offset in milli-degree
+*
+* RETURNS
+*   1. HAL_TMPR_OK   : success
+*   2. HAL_TMPR_FAIL : fail
+*
+*************************************************************************/
+uint8_t Hal_Tmpr_OffsetSet(int32_t lMilliDegree)
+{
+    uint8_t ubRet = HAL_TMPR_FAIL;
+
+    if (MW_FIM_OK != MwFim_FileWrite(MW_FIM_IDX_GP03_PATCH_CAL_TMPR_OFFSET, 0, MW_FIM_CAL_TMPR_OFFSET_SIZE, (uint8_t*)&lMilliDegree))
+        goto done;
+
+    g_lHalTmpr_Offset = lMilliDegree;
+
+    ubRet = HAL_TMPR_OK;
+
+done:
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Tmpr_OffsetGet
+*
+* DESCRIPTION:
+*   get the calibration offset
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   the offset in milli-degree
+*
+*************************************************************************/
+int32_t Hal_Tmpr_OffsetGet(void)
+{
+    return g_lHalTmpr_Offset;
+}
@@ -0,0 +1,94 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_temperature_patch.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This include file defines the fixed-point conversion of the Temperature
+*  Sensor.
+*
+*  The thermistor table of the calibration data is copied to integer ohms
+*  once, then a resistor is looked up by binary search and interpolated in
+*  milli-degree. The calibration offset is kept in MW_FIM and added to every
+*  temperature reading.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+#ifndef _HAL_TEMPERATURE_PATCH_H_
+#define _HAL_TEMPERATURE_PATCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <stdint.h>
+#include "hal_temperature.h"
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HAL_TMPR_FIX_OHM_PER_UNIT   1000    // the thermistor table is in kohm
+#define HAL_TMPR_FIX_MILLI          1000
+
+
+/******************************
+Declaration of data structure
+******************************/
+// Sec 3: structure, uniou, enum, linked list
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+extern T_HalTmprCalData g_tHalTmpr_CalData;     // the ROM copy of MW_FIM_IDX_GP03_CAL_TEMPERATURE
+
+
+// Sec 5: declaration of global function prototype
+void Hal_Tmpr_Init_patch(void);
+uint8_t Hal_Tmpr_TemperatureGet_patch(uint8_t ubGpioIdx, float *pfTemperature);
+uint8_t Hal_Tmpr_CompareResistor_patch(float fResistor, float *pfTemperature);
+
+uint8_t Hal_Tmpr_MilliDegreeGet(uint8_t ubGpioIdx, int32_t *plMilliDegree);
+uint8_t Hal_Tmpr_CompareResistorFix(uint32_t ulResistor, int32_t *plMilliDegree);
+uint8_t Hal_Tmpr_FixTableUpdate(void);
+
+uint8_t Hal_Tmpr_OffsetSet(int32_t lMilliDegree);
+int32_t Hal_Tmpr_OffsetGet(void);
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+
+
+// Sec 7: declaration of static function prototype
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HAL_TEMPERATURE_PATCH_H_
@@ -0,0 +1,773 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_i2c_master.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This source file defines the queued I2C master transactions.
+*  Ref. document is << DesignWare DW_apb_i2c Databook >>
+*
+*  The commands are fed from the TX empty interrupt, at most
+*  HAL_I2C_MASTER_RX_WINDOW reads are outstanding so the RX FIFO never
+*  overflows. STOP_DET ends a transaction, TX_ABRT fails it.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "hal_system.h"
+#include "hal_vic.h"
+#include "hal_i2c_master.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define I2C       ((S_I2c_Reg_t *) I2C_BASE)
+
+#define I2C_TICK_PER_US          ( SystemCoreClockGet()/1000000 )
+#define I2C_NS_PER_US            1000
+#define I2C_FS_SPIKE_MAX         50   /* UNIT: ns */
+#define I2C_STD_SCL_LOW_MIN      4700 /* UNIT: ns */
+#define I2C_STD_SCL_HIGH_MIN     4000 /* UNIT: ns */
+#define I2C_FS_SCL_LOW_MIN       1300 /* UNIT: ns */
+#define I2C_FS_SCL_HIGH_MIN      600  /* UNIT: ns */
+
+#define I2C_CON_SLAVE_DISABLE    (1<<6)
+#define I2C_CON_RESTART_EN       (1<<5)
+#define I2C_CON_MASTER_10BIT     (1<<4)
+#define I2C_CON_SPEED_STD        (1<<1)
+#define I2C_CON_SPEED_FAST       (2<<1)
+#define I2C_CON_MASTER_MODE      (1<<0)
+
+#define I2C_TAR_10BIT            (1<<12)
+#define I2C_TAR_TARGET_ADDR_MASK (0x3FF)
+
+#define I2C_DATA_RESTART_BIT     (1<<10)
+#define I2C_DATA_STOP_BIT        (1<<9)
+#define I2C_DATA_CMD_WRITE       (0<<8)
+#define I2C_DATA_CMD_READ        (1<<8)
+#define I2C_DATA_CMD_DATA_MASK   (0xFF)
+
+#define I2C_STATUS_TX_NOT_FULL   (1<<1)
+
+#define I2C_INT_RX_FULL          (1<<2)
+#define I2C_INT_TX_EMPTY         (1<<4)
+#define I2C_INT_TX_ABRT          (1<<6)
+#define I2C_INT_STOP_DET         (1<<9)
+
+#define I2C_ABRT_NOACK_MASK      (0x1F)     // 7B/10B address, data, general call
+#define I2C_ABRT_ARB_LOST        (1<<12)
+
+#define I2C_ENABLE_EN            1
+#define I2C_ENABLE_STATUS_EN     1
+#define I2C_DISABLE_POLL_MAX     0x3000
+
+#define HAL_I2C_MASTER_IRQ_SAVE(u32Pm)      do { u32Pm = __get_PRIMASK(); __disable_irq(); } while(0)
+#define HAL_I2C_MASTER_IRQ_RESTORE(u32Pm)   __set_PRIMASK(u32Pm)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    volatile uint32_t CON;               // 0x00
+    volatile uint32_t TAR;               // 0x04
+    volatile uint32_t SAR;               // 0x08
+    volatile uint32_t HS_MADDR;          // 0x0C
+    volatile uint32_t DATA_CMD;          // 0x10
+    volatile uint32_t SS_SCL_HCNT;       // 0x14
+    volatile uint32_t SS_SCL_LCNT;       // 0x18
+    volatile uint32_t FS_SCL_HCNT;       // 0x1C
+    volatile uint32_t FS_SCL_LCNT;       // 0x20
+    volatile uint32_t HS_SCL_HCNT;       // 0x24
+    volatile uint32_t HS_SCL_LCNT;       // 0x28
+    volatile uint32_t INTR_STAT;         // 0x2C
+    volatile uint32_t INTR_MASK;         // 0x30
+    volatile uint32_t RAW_INTR_MASK;     // 0x34
+    volatile uint32_t RX_TL;             // 0x38
+    volatile uint32_t TX_TL;             // 0x3C
+    volatile uint32_t CIR_INTR;          // 0x40
+    volatile uint32_t CLR_RX_UNDER;      // 0x44
+    volatile uint32_t CLR_RX_OVER;       // 0x48
+    volatile uint32_t CLR_TX_OVER;       // 0x4C
+    volatile uint32_t CLR_RD_REQ;        // 0x50
+    volatile uint32_t CLR_TX_ABRT;       // 0x54
+    volatile uint32_t CLR_RX_DONE;       // 0x58
+    volatile uint32_t CLR_ACTIVITY;      // 0x5C
+    volatile uint32_t CLR_STOP_DET;      // 0x60
+    volatile uint32_t CLR_START_DET;     // 0x64
+    volatile uint32_t CLR_GEN_CALL;      // 0x68
+    volatile uint32_t ENABLE;            // 0x6C
+    volatile uint32_t STATUS;            // 0x70
+    volatile uint32_t TXFLR;             // 0x74
+    volatile uint32_t RXFLR;             // 0x78
+    volatile uint32_t SDA_HOLD;          // 0x7C
+    volatile uint32_t TX_ABRT_SOURCE;    // 0x80
+    volatile uint32_t SLV_DATA_NACK_ONLY;// 0x84
+    volatile uint32_t DMA_CR;            // 0x88
+    volatile uint32_t DMA_TDLR;          // 0x8C
+    volatile uint32_t DMA_RDLR;          // 0x90
+    volatile uint32_t SDA_SETUP;         // 0x94
+    volatile uint32_t ACK_GENERAL_CALL;  // 0x98
+    volatile uint32_t ENABLE_STATUS;     // 0x9C
+    volatile uint32_t FS_SPKLEN;         // 0xA0
+    volatile uint32_t HS_SPKLEN;         // 0xA4
+} S_I2c_Reg_t;
+
+typedef struct
+{
+    uint8_t u8Init;
+    const S_I2cDev_t *ptDev;        // the device the controller is programmed for
+    S_I2cXfer_t *ptHead;            // the active transaction
+    S_I2cXfer_t *ptTail;
+    uint32_t u32Queued;
+    uint32_t u32Seq;
+    uint32_t u32TimerSeq;           // the transaction the time-out timer runs for
+    osTimerId tTimer;
+    osSemaphoreId tLock;            // Hal_I2c_MasterTransfer callers
+    osSemaphoreId tDone;
+    S_I2cMasterStat_t tStat;
+} S_I2cMaster_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+static S_I2cMaster_t g_tI2cMaster;
+static T_Hal_I2c_IntHandler g_tI2cMasterSlaveHandler;     // the handler of the slave mode
+
+// Sec 7: declaration of static function prototype
+static void _Hal_I2c_MasterStart(void);
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static uint32_t _Hal_I2c_MasterEnable(uint8_t u8Enable)
+{
+    uint32_t u32Count = 0;
+
+    if (u8Enable)
+    {
+        I2C->ENABLE = I2C_ENABLE_EN;
+        return 0;
+    }
+
+    // ref to << 3.8.3 Disabling DW_apb_i2c >>
+    I2C->ENABLE = 0;
+    while (I2C->ENABLE_STATUS & I2C_ENABLE_STATUS_EN)
+    {
+        if (u32Count > I2C_DISABLE_POLL_MAX)
+            return 1;
+        u32Count++;
+    }
+
+    return 0;
+}
+
+static void _Hal_I2c_MasterConfig(const S_I2cDev_t *ptDev)
+{
+    uint32_t u32Con = I2C_CON_MASTER_MODE | I2C_CON_SLAVE_DISABLE | I2C_CON_RESTART_EN;
+    uint32_t u32Tar = ptDev->u16Addr & I2C_TAR_TARGET_ADDR_MASK;
+
+    if (g_tI2cMaster.ptDev == ptDev)
+        return;
+
+    _Hal_I2c_MasterEnable(0);
+
+    if (ptDev->eAddrMode == I2C_10BIT)
+    {
+        u32Con |= I2C_CON_MASTER_10BIT;
+        u32Tar |= I2C_TAR_10BIT;
+    }
+
+    // the low period of the fast mode is 1300ns, not the spike length
+    if (ptDev->eSpeed == I2C_SPEED_FAST)
+    {
+        u32Con |= I2C_CON_SPEED_FAST;
+        I2C->FS_SCL_HCNT = I2C_FS_SCL_HIGH_MIN * I2C_TICK_PER_US / I2C_NS_PER_US;
+        I2C->FS_SCL_LCNT = I2C_FS_SCL_LOW_MIN * I2C_TICK_PER_US / I2C_NS_PER_US;
+    }
+    else
+    {
+        u32Con |= I2C_CON_SPEED_STD;
+        I2C->SS_SCL_HCNT = I2C_STD_SCL_HIGH_MIN * I2C_TICK_PER_US / I2C_NS_PER_US;
+        I2C->SS_SCL_LCNT = I2C_STD_SCL_LOW_MIN * I2C_TICK_PER_US / I2C_NS_PER_US;
+    }
+    I2C->FS_SPKLEN = I2C_FS_SPIKE_MAX * I2C_TICK_PER_US / I2C_NS_PER_US;
+
+    I2C->CON = u32Con;
+    I2C->TAR = u32Tar;
+    I2C->TX_TL = 0;
+    I2C->RX_TL = 0;
+    I2C->INTR_MASK = 0;
+
+    _Hal_I2c_MasterEnable(1);
+
+    g_tI2cMaster.ptDev = ptDev;
+}
+
+static void _Hal_I2c_MasterRecover(void)
+{
+    // the bus may still be held by the controller, start from reset
+    I2C->INTR_MASK = 0;
+    Hal_Sys_ApsModuleRst(ASP_RST_I2C);
+
+    g_tI2cMaster.ptDev = NULL;
+    g_tI2cMaster.tStat.u32Recover++;
+}
+
+static void _Hal_I2c_MasterFill(void)
+{
+    S_I2cXfer_t *ptXfer = g_tI2cMaster.ptHead;
+    uint32_t u32Total = ptXfer->u32TxLen + ptXfer->u32RxLen;
+    uint32_t u32Cmd = 0;
+    uint32_t u32Out = 0;
+    uint8_t u8Window = 0;
+
+    while ((ptXfer->u32CmdIdx < u32Total) && (I2C->STATUS & I2C_STATUS_TX_NOT_FULL))
+    {
+        if (ptXfer->u32CmdIdx < ptXfer->u32TxLen)
+        {
+            u32Cmd = I2C_DATA_CMD_WRITE | ptXfer->pu8TxData[ptXfer->u32CmdIdx];
+        }
+        else
+        {
+            // reads already issued and not received yet
+            u32Out = ptXfer->u32CmdIdx - ptXfer->u32TxLen - ptXfer->u32RxIdx;
+            if (u32Out >= HAL_I2C_MASTER_RX_WINDOW)
+            {
+                u8Window = 1;
+                break;
+            }
+
+            u32Cmd = I2C_DATA_CMD_READ;
+
+            // the direction changes: repeated START
+            if ((ptXfer->u32CmdIdx == ptXfer->u32TxLen) && (ptXfer->u32TxLen))
+                u32Cmd |= I2C_DATA_RESTART_BIT;
+        }
+
+        if (ptXfer->u32CmdIdx == u32Total - 1)
+            u32Cmd |= I2C_DATA_STOP_BIT;
+
+        I2C->DATA_CMD = u32Cmd;
+        ptXfer->u32CmdIdx++;
+    }
+
+    u32Out = 0;
+    if (ptXfer->u32CmdIdx > ptXfer->u32TxLen)
+        u32Out = ptXfer->u32CmdIdx - ptXfer->u32TxLen - ptXfer->u32RxIdx;
+
+    // interrupt when every outstanding read is back
+    I2C->RX_TL = (u32Out) ? (u32Out - 1) : 0;
+
+    // waiting for the window to open is up to RX_FULL, TX_EMPTY would fire all along
+    if ((ptXfer->u32CmdIdx < u32Total) && (!u8Window))
+        I2C->INTR_MASK |= I2C_INT_TX_EMPTY;
+    else
+        I2C->INTR_MASK &= ~I2C_INT_TX_EMPTY;
+}
+
+static void _Hal_I2c_MasterDrain(void)
+{
+    S_I2cXfer_t *ptXfer = g_tI2cMaster.ptHead;
+    uint32_t u32Num = I2C->RXFLR;
+    uint32_t u32Data = 0;
+
+    while (u32Num--)
+    {
+        u32Data = I2C->DATA_CMD;
+
+        if (ptXfer->u32RxIdx < ptXfer->u32RxLen)
+            ptXfer->pu8RxData[ptXfer->u32RxIdx++] = (uint8_t)(u32Data & I2C_DATA_CMD_DATA_MASK);
+    }
+}
+
+static void _Hal_I2c_MasterFinish(uint32_t u32Status)
+{
+    S_I2cXfer_t *ptXfer = g_tI2cMaster.ptHead;
+
+    I2C->INTR_MASK = 0;
+
+    switch (u32Status)
+    {
+        case HAL_I2C_XFER_DONE:
+            g_tI2cMaster.tStat.u32Bytes += ptXfer->u32TxLen + ptXfer->u32RxLen;
+            break;
+        case HAL_I2C_XFER_NACK:
+            g_tI2cMaster.tStat.u32Nack++;
+            break;
+        case HAL_I2C_XFER_ARB_LOST:
+            g_tI2cMaster.tStat.u32ArbLost++;
+            _Hal_I2c_MasterRecover();
+            break;
+        case HAL_I2C_XFER_TIMEOUT:
+            g_tI2cMaster.tStat.u32Timeout++;
+            _Hal_I2c_MasterRecover();
+            break;
+        default:
+            break;
+    }
+    g_tI2cMaster.tStat.u32Xfers++;
+
+    g_tI2cMaster.ptHead = ptXfer->ptNext;
+    if (g_tI2cMaster.ptHead == NULL)
+        g_tI2cMaster.ptTail = NULL;
+    g_tI2cMaster.u32Queued--;
+
+    ptXfer->ptNext = NULL;
+    ptXfer->u32Status = u32Status;
+
+    if (ptXfer->fpCallBack)
+        ptXfer->fpCallBack(ptXfer);
+}
+
+static void _Hal_I2c_MasterStart(void)
+{
+    S_I2cXfer_t *ptXfer = NULL;
+    uint32_t u32Clr = 0;
+
+    while ((ptXfer = g_tI2cMaster.ptHead) != NULL)
+    {
+        _Hal_I2c_MasterConfig(ptXfer->ptDev);
+
+        // leftovers of the previous transaction
+        u32Clr = I2C->CIR_INTR;
+        (void)u32Clr;
+
+        ptXfer->u32Status = HAL_I2C_XFER_ACTIVE;
+        ptXfer->u32Seq = ++g_tI2cMaster.u32Seq;
+
+        g_tI2cMaster.u32TimerSeq = ptXfer->u32Seq;
+        if (osTimerStart(g_tI2cMaster.tTimer, (ptXfer->u32TimeoutMs) ? ptXfer->u32TimeoutMs : HAL_I2C_MASTER_TIMEOUT_DEF) == osOK)
+        {
+            I2C->INTR_MASK = I2C_INT_RX_FULL | I2C_INT_TX_ABRT | I2C_INT_STOP_DET;
+            _Hal_I2c_MasterFill();
+            return;
+        }
+
+        // no time-out, do not start what may never finish
+        _Hal_I2c_MasterFinish(HAL_I2C_XFER_ERROR);
+    }
+}
+
+static void _Hal_I2c_MasterIntHandler(void)
+{
+    S_I2cXfer_t *ptXfer = g_tI2cMaster.ptHead;
+    uint32_t u32Stat = I2C->INTR_STAT;
+    uint32_t u32Clr = 0;
+
+    g_tI2cMaster.tStat.u32Irqs++;
+
+    if (ptXfer == NULL)
+    {
+        I2C->INTR_MASK = 0;
+        u32Clr = I2C->CIR_INTR;
+        (void)u32Clr;
+        return;
+    }
+
+    if (u32Stat & I2C_INT_TX_ABRT)
+    {
+        // the controller flushed the TX FIFO and sent STOP (unless it lost the bus)
+        ptXfer->u32AbrtSrc = I2C->TX_ABRT_SOURCE;
+        u32Clr = I2C->CLR_TX_ABRT;
+        _Hal_I2c_MasterDrain();
+
+        if (ptXfer->u32AbrtSrc & I2C_ABRT_ARB_LOST)
+            _Hal_I2c_MasterFinish(HAL_I2C_XFER_ARB_LOST);
+        else if (ptXfer->u32AbrtSrc & I2C_ABRT_NOACK_MASK)
+            _Hal_I2c_MasterFinish(HAL_I2C_XFER_NACK);
+        else
+            _Hal_I2c_MasterFinish(HAL_I2C_XFER_ERROR);
+
+        _Hal_I2c_MasterStart();
+        return;
+    }
+
+    if (u32Stat & I2C_INT_RX_FULL)
+        _Hal_I2c_MasterDrain();
+
+    if (u32Stat & I2C_INT_STOP_DET)
+    {
+        u32Clr = I2C->CLR_STOP_DET;
+        _Hal_I2c_MasterDrain();
+
+        if (ptXfer->u32CmdIdx == ptXfer->u32TxLen + ptXfer->u32RxLen)
+        {
+            _Hal_I2c_MasterFinish((ptXfer->u32RxIdx == ptXfer->u32RxLen) ? HAL_I2C_XFER_DONE : HAL_I2C_XFER_ERROR);
+            _Hal_I2c_MasterStart();
+            return;
+        }
+    }
+
+    if (u32Stat & (I2C_INT_RX_FULL | I2C_INT_TX_EMPTY))
+        _Hal_I2c_MasterFill();
+
+    (void)u32Clr;
+}
+
+static void _Hal_I2c_MasterTimeout(void const *argument)
+{
+    S_I2cXfer_t *ptXfer = NULL;
+    uint32_t u32Pm = 0;
+
+    HAL_I2C_MASTER_IRQ_SAVE(u32Pm);
+
+    // the timer is restarted for every transaction, only the last one counts
+    ptXfer = g_tI2cMaster.ptHead;
+    if ((ptXfer) && (ptXfer->u32Status == HAL_I2C_XFER_ACTIVE) && (ptXfer->u32Seq == g_tI2cMaster.u32TimerSeq))
+    {
+        _Hal_I2c_MasterFinish(HAL_I2C_XFER_TIMEOUT);
+        _Hal_I2c_MasterStart();
+    }
+
+    HAL_I2C_MASTER_IRQ_RESTORE(u32Pm);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_I2c_IntHandler_patch
+*
+* DESCRIPTION:
+*   the handler of I2C, the queued transactions or the slave mode
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+static void Hal_I2c_IntHandler_patch(void)
+{
+    if (g_tI2cMaster.ptHead)
+        _Hal_I2c_MasterIntHandler();
+    else if (g_tI2cMasterSlaveHandler)
+        g_tI2cMasterSlaveHandler();
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_I2c_MasterEngineInit
+*
+* DESCRIPTION:
+*   1. Prepare the queued transactions and enable the I2C interrupt.
+*      The pins must be set up by Hal_Pinmux_I2c_Init() before, the
+*      controller is programmed per transaction.
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   0: setting complete
+*   1: error
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Hal_I2c_MasterEngineInit(void)
+{
+    osSemaphoreDef_t tSemaphoreDef;
+    osTimerDef_t tTimerDef;
+
+    if (g_tI2cMaster.u8Init)
+        return 0;
+
+    memset(&g_tI2cMaster, 0, sizeof(S_I2cMaster_t));
+
+    tSemaphoreDef.dummy = 0;
+    g_tI2cMaster.tLock = osSemaphoreCreate(&tSemaphoreDef, 1);
+    g_tI2cMaster.tDone = osSemaphoreCreate(&tSemaphoreDef, 1);
+    tTimerDef.ptimer = _Hal_I2c_MasterTimeout;
+    g_tI2cMaster.tTimer = osTimerCreate(&tTimerDef, osTimerOnce, NULL);
+    if ((g_tI2cMaster.tLock == NULL) || (g_tI2cMaster.tDone == NULL) || (g_tI2cMaster.tTimer == NULL))
+        return 1;
+
+    osSemaphoreWait(g_tI2cMaster.tDone, 0);
+
+    // Enable clock of module
+    Hal_Sys_ApsClkEn(1, APS_CLK_I2C);
+    I2C->INTR_MASK = 0;
+
+    g_tI2cMasterSlaveHandler = Hal_I2c_IntHandler;
+    Hal_I2c_IntHandler = Hal_I2c_IntHandler_patch;
+
+    // VIC 1) Clear interrupt
+    Hal_Vic_IntClear(I2C_IRQn);
+    // VIC 2) un-Mask VIC
+    Hal_Vic_IntMask(I2C_IRQn, 0);
+    // VIC 3) Enable VIC
+    Hal_Vic_IntEn(I2C_IRQn, 1);
+
+    // NVIC 1) Clean NVIC
+    NVIC_ClearPendingIRQ(I2C_IRQn);
+    // NVIC 2) Set prority
+    NVIC_SetPriority(I2C_IRQn, IRQ_PRIORITY_I2C);
+    // NVIC 3) Enable NVIC
+    NVIC_EnableIRQ(I2C_IRQn);
+
+    g_tI2cMaster.u8Init = 1;
+    return 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_I2c_MasterSubmit
+*
+* DESCRIPTION:
+*   1. Queue a transaction, it starts at once if the bus is idle.
+*      May be called from a completion callback.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptXfer   : the transaction, see S_I2cXfer_t
+*
+* RETURNS
+*   0: queued
+*   1: error
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Hal_I2c_MasterSubmit(S_I2cXfer_t *ptXfer)
+{
+    uint32_t u32Pm = 0;
+
+    if (!g_tI2cMaster.u8Init)
+        return 1;
+
+    if ((ptXfer == NULL) || (ptXfer->ptDev == NULL) || ((ptXfer->u32TxLen + ptXfer->u32RxLen) == 0))
+        return 1;
+
+    if (((ptXfer->u32TxLen) && (ptXfer->pu8TxData == NULL)) || ((ptXfer->u32RxLen) && (ptXfer->pu8RxData == NULL)))
+        return 1;
+
+    ptXfer->u32CmdIdx = 0;
+    ptXfer->u32RxIdx = 0;
+    ptXfer->u32AbrtSrc = 0;
+    ptXfer->ptNext = NULL;
+    ptXfer->u32Status = HAL_I2C_XFER_QUEUED;
+
+    HAL_I2C_MASTER_IRQ_SAVE(u32Pm);
+
+    if (g_tI2cMaster.ptTail)
+        g_tI2cMaster.ptTail->ptNext = ptXfer;
+    else
+        g_tI2cMaster.ptHead = ptXfer;
+    g_tI2cMaster.ptTail = ptXfer;
+
+    g_tI2cMaster.u32Queued++;
+    if (g_tI2cMaster.u32Queued > g_tI2cMaster.tStat.u32QueueMax)
+        g_tI2cMaster.tStat.u32QueueMax = g_tI2cMaster.u32Queued;
+
+    if (g_tI2cMaster.ptHead == ptXfer)
+        _Hal_I2c_MasterStart();
+
+    HAL_I2C_MASTER_IRQ_RESTORE(u32Pm);
+
+    return 0;
+}
+
+static void _Hal_I2c_MasterDoneCallBack(S_I2cXfer_t *ptXfer)
+{
+    osSemaphoreRelease(g_tI2cMaster.tDone);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_I2c_MasterTransfer
+*
+* DESCRIPTION:
+*   1. Queue a transaction and wait for it. fpCallBack and pArg of the
+*      transaction are used by this function.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptXfer   : the transaction, see S_I2cXfer_t
+*
+* RETURNS
+*   0: done
+*   1: error, see ptXfer->u32Status
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Hal_I2c_MasterTransfer(S_I2cXfer_t *ptXfer)
+{
+    uint32_t u32Ret = 1;
+
+    if (!g_tI2cMaster.u8Init)
+        return 1;
+
+    osSemaphoreWait(g_tI2cMaster.tLock, osWaitForever);
+
+    ptXfer->fpCallBack = _Hal_I2c_MasterDoneCallBack;
+    ptXfer->pArg = NULL;
+
+    if (Hal_I2c_MasterSubmit(ptXfer))
+        goto done;
+
+    // the time-out timer completes it in any case
+    osSemaphoreWait(g_tI2cMaster.tDone, osWaitForever);
+
+    if (ptXfer->u32Status == HAL_I2C_XFER_DONE)
+        u32Ret = 0;
+
+done:
+    osSemaphoreRelease(g_tI2cMaster.tLock);
+    return u32Ret;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_I2c_MasterWriteRead
+*
+* DESCRIPTION:
+*   1. Write then read one device with a repeated START in between, and
+*      wait for the result
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptDev     : the device
+*   2. pu8TxData : data to write
+*   3. u32TxLen  : length to write, may be 0
+*   4. pu8RxData : buffer to read into
+*   5. u32RxLen  : length to read, may be 0
+*
+* RETURNS
+*   HAL_I2C_XFER_DONE or the failure, refer to S_I2cXfer_t.u32Status
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Hal_I2c_MasterWriteRead(const S_I2cDev_t *ptDev, const uint8_t *pu8TxData, uint32_t u32TxLen, uint8_t *pu8RxData, uint32_t u32RxLen)
+{
+    S_I2cXfer_t tXfer;
+
+    memset(&tXfer, 0, sizeof(S_I2cXfer_t));
+    tXfer.ptDev = ptDev;
+    tXfer.pu8TxData = pu8TxData;
+    tXfer.u32TxLen = u32TxLen;
+    tXfer.pu8RxData = pu8RxData;
+    tXfer.u32RxLen = u32RxLen;
+    tXfer.u32Status = HAL_I2C_XFER_ERROR;
+
+    Hal_I2c_MasterTransfer(&tXfer);
+
+    return tXfer.u32Status;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_I2c_MasterBusy
+*
+* DESCRIPTION:
+*   1. Check if transactions are still queued
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   0: idle
+*   1: busy
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint8_t Hal_I2c_MasterBusy(void)
+{
+    return (g_tI2cMaster.ptHead != NULL);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_I2c_MasterStatGet
+*
+* DESCRIPTION:
+*   1. Get the transaction statistics
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptStat   : [OUT] the statistics
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_I2c_MasterStatGet(S_I2cMasterStat_t *ptStat)
+{
+    uint32_t u32Pm = 0;
+
+    HAL_I2C_MASTER_IRQ_SAVE(u32Pm);
+    memcpy(ptStat, &g_tI2cMaster.tStat, sizeof(S_I2cMasterStat_t));
+    HAL_I2C_MASTER_IRQ_RESTORE(u32Pm);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_I2c_MasterStatReset
+*
+* DESCRIPTION:
+*   1. Clear the transaction statistics
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_I2c_MasterStatReset(void)
+{
+    uint32_t u32Pm = 0;
+
+    HAL_I2C_MASTER_IRQ_SAVE(u32Pm);
+    memset(&g_tI2cMaster.tStat, 0, sizeof(S_I2cMasterStat_t));
+    g_tI2cMaster.tStat.u32QueueMax = g_tI2cMaster.u32Queued;
+    HAL_I2C_MASTER_IRQ_RESTORE(u32Pm);
+}
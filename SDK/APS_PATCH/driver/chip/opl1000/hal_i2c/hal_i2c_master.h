@@ -0,0 +1,135 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_i2c_master.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This include file defines the queued I2C master transactions.
+*
+*  A transaction (S_I2cXfer_t) writes u32TxLen bytes to its device and then
+*  reads u32RxLen bytes behind a repeated START, with one STOP at the end.
+*  Either part may be empty. Transactions are queued with
+*  Hal_I2c_MasterSubmit() and run from the I2C interrupt; the callback gets
+*  the status (done, NACK, arbitration lost, time-out) in interrupt or timer
+*  context.
+*
+*  After an arbitration loss or a time-out the controller is reset and
+*  programmed again before the next transaction.
+*
+******************************************************************************/
+
+#ifndef __HAL_I2C_MASTER_H__
+#define __HAL_I2C_MASTER_H__
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdint.h>
+#include "hal_i2c.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HAL_I2C_MASTER_RX_WINDOW        4       // read commands in flight
+#define HAL_I2C_MASTER_TIMEOUT_DEF      100     // ms, S_I2cXfer_t.u32TimeoutMs = 0
+
+// S_I2cXfer_t.u32Status
+#define HAL_I2C_XFER_IDLE               0
+#define HAL_I2C_XFER_QUEUED             1
+#define HAL_I2C_XFER_ACTIVE             2
+#define HAL_I2C_XFER_DONE               3
+#define HAL_I2C_XFER_NACK               4       // address or data not acknowledged
+#define HAL_I2C_XFER_ARB_LOST           5
+#define HAL_I2C_XFER_TIMEOUT            6
+#define HAL_I2C_XFER_ERROR              7
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    uint16_t u16Addr;
+    E_I2cAddrMode_t eAddrMode;
+    E_I2cSpeed_t eSpeed;
+} S_I2cDev_t;
+
+struct S_I2cXfer;
+typedef void (*T_Hal_I2c_XferCallBack)(struct S_I2cXfer *ptXfer);
+
+typedef struct S_I2cXfer
+{
+    const S_I2cDev_t *ptDev;
+    const uint8_t *pu8TxData;
+    uint32_t u32TxLen;
+    uint8_t *pu8RxData;
+    uint32_t u32RxLen;
+    uint32_t u32TimeoutMs;
+    T_Hal_I2c_XferCallBack fpCallBack;
+    void *pArg;
+
+    // owned by the driver
+    volatile uint32_t u32Status;
+    uint32_t u32AbrtSrc;            // TX_ABRT_SOURCE of a failed transaction
+    uint32_t u32CmdIdx;
+    uint32_t u32RxIdx;
+    uint32_t u32Seq;
+    struct S_I2cXfer *ptNext;
+} S_I2cXfer_t;
+
+typedef struct
+{
+    uint32_t u32Xfers;
+    uint32_t u32Bytes;
+    uint32_t u32Irqs;
+    uint32_t u32Nack;
+    uint32_t u32ArbLost;
+    uint32_t u32Timeout;
+    uint32_t u32Recover;            // controller resets
+    uint32_t u32QueueMax;
+} S_I2cMasterStat_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+uint32_t Hal_I2c_MasterEngineInit(void);
+uint32_t Hal_I2c_MasterSubmit(S_I2cXfer_t *ptXfer);
+uint32_t Hal_I2c_MasterTransfer(S_I2cXfer_t *ptXfer);
+uint32_t Hal_I2c_MasterWriteRead(const S_I2cDev_t *ptDev, const uint8_t *pu8TxData, uint32_t u32TxLen, uint8_t *pu8RxData, uint32_t u32RxLen);
+uint8_t Hal_I2c_MasterBusy(void);
+void Hal_I2c_MasterStatGet(S_I2cMasterStat_t *ptStat);
+void Hal_I2c_MasterStatReset(void);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+#endif
@@ -0,0 +1,518 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_pwm_wave.c
+*
+*  Project:
+*  --------
+*  OPL1000 Project - the PWM waveform implement file
+*
+*  Description:
+*  ------------
+*  This implement file is include the timer-driven PWM waveforms.
+*
+*  The timer runs in periodic mode. When a slice ends, the counter reloads
+*  by itself with LOAD, which was set to the length of the slice that just
+*  started; the interrupt then writes the PWM registers of that slice and
+*  sets LOAD to the slice after it.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <string.h>
+#include "opl1000.h"
+#include "hal_tmr.h"
+#include "hal_pwm.h"
+#include "hal_pwm_wave.h"
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define TMR0                        ((S_Tmr_Reg_t *) TIM0_BASE)
+#define TMR1                        ((S_Tmr_Reg_t *) TIM1_BASE)
+
+// AOS R_M3CLK_SEL: the PWM runs on 22MHz, see Hal_Sys_PwmSrcSelect
+#define AOS_R_M3CLK_SEL             (*(volatile uint32_t *)(AOS_BASE + 0x134))
+#define AOS_PWM_CLK_MASK            (0x1 << 27)
+
+// the longest cycle Hal_Pwm_SimpleConfigSet can make: the max period times the max hold
+#define HAL_PWM_WAVE_TICK_MAX       (HAL_PWM_MAX_PERIOD * HAL_PWM_MAX_HOLD)
+
+#define TIMER_MAX_VALUE             0xFFFFFFFF
+
+#define TIMER_CTRL_EN               (0x01 << 0)
+#define TIMER_CTRL_EXT_CLOCK        (0x01 << 2)
+#define TIMER_CTRL_IRQEN            (0x01 << 3)
+
+#define HAL_PWM_WAVE_IRQ_SAVE(ulPm)     do { ulPm = __get_PRIMASK(); __disable_irq(); } while(0)
+#define HAL_PWM_WAVE_IRQ_RESTORE(ulPm)  __set_PRIMASK(ulPm)
+
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list
+typedef struct
+{
+    volatile uint32_t CTRL;                 // 0x000
+    volatile uint32_t VALUE;                // 0x004
+    volatile uint32_t LOAD;                 // 0x008
+    volatile uint32_t INTSTATUS;            // 0x00C
+} S_Tmr_Reg_t;
+
+typedef struct
+{
+    uint32_t ulStep;
+    uint32_t ulSlice;
+    uint32_t ulLoop;
+} S_Hal_Pwm_WavePos_t;
+
+typedef struct
+{
+    S_Tmr_Reg_t *ptTmr;
+    const S_Hal_Pwm_WaveSeq_t *ptSeq;
+    volatile uint8_t ubActive;
+    uint8_t ubIdxMask;                      // all the channels of the sequence
+    S_Hal_Pwm_WavePos_t tPos;               // the slice being played
+    uint32_t ulReload;                      // the LOAD of the slice being played
+    S_Hal_Pwm_WaveStat_t tStat;
+} S_Hal_Pwm_Wave_t;
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+extern uint32_t Tmr_TickOfUs;
+extern uint32_t Tmr_Ratio;
+extern uint32_t g_ulHalPwm_32kValue;
+
+
+// Sec 5: declaration of global function prototype
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static S_Hal_Pwm_Wave_t g_taHalPwmWave[HAL_PWM_WAVE_TMR_MAX];
+
+
+// Sec 7: declaration of static function prototype
+static void Hal_Pwm_WaveIsr(uint32_t ulTmrIdx);
+
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Pwm_WaveReload
+*
+* DESCRIPTION:
+*   the LOAD value of the timer for a time, the same rounding as Hal_Tmr_Start
+*
+* PARAMETERS
+*   1. ulUs : [In] the time (us)
+*
+* RETURNS
+*   the LOAD value
+*
+*************************************************************************/
+static uint32_t Hal_Pwm_WaveReload(uint32_t ulUs)
+{
+    if (ulUs > (TIMER_MAX_VALUE / Tmr_TickOfUs * Tmr_Ratio))
+        return TIMER_MAX_VALUE;
+
+    return (ulUs * Tmr_TickOfUs + Tmr_Ratio / 2) / Tmr_Ratio - 1;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Pwm_WaveHzCheck
+*
+* DESCRIPTION:
+*   check a frequency against the current clock source of the PWM, the same
+*   limits as Hal_Pwm_SimpleConfigSet
+*
+* PARAMETERS
+*   1. ulHz : [In] the frequency
+*
+* RETURNS
+*   1. 1 : the clock source can make it
+*   2. 0 : too high or too low
+*
+*************************************************************************/
+static uint8_t Hal_Pwm_WaveHzCheck(uint32_t ulHz)
+{
+    uint32_t ulClock;
+    uint32_t ulTickPerCycle;
+
+    if (AOS_R_M3CLK_SEL & AOS_PWM_CLK_MASK)
+        ulClock = XTAL;
+    else
+        ulClock = g_ulHalPwm_32kValue;
+
+    if ((ulHz == 0) || (ulHz > ulClock))
+        return 0;
+
+    ulTickPerCycle = (ulClock + (ulHz / 2)) / ulHz;     // rounding
+    if (ulTickPerCycle > HAL_PWM_WAVE_TICK_MAX)
+        return 0;
+
+    return 1;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Pwm_WaveNext
+*
+* DESCRIPTION:
+*   move the position to the next slice
+*
+* PARAMETERS
+*   1. ptSeq : [In] the sequence
+*   2. ptPos : [In/Out] the position
+*
+* RETURNS
+*   1. 1 : the position is valid
+*   2. 0 : the last repeat is over
+*
+*************************************************************************/
+static uint8_t Hal_Pwm_WaveNext(const S_Hal_Pwm_WaveSeq_t *ptSeq, S_Hal_Pwm_WavePos_t *ptPos)
+{
+    ptPos->ulSlice++;
+    if (ptPos->ulSlice < ptSeq->ptStep[ptPos->ulStep].uwSlices)
+        return 1;
+
+    ptPos->ulSlice = 0;
+    ptPos->ulStep++;
+    if (ptPos->ulStep < ptSeq->ulStepNum)
+        return 1;
+
+    ptPos->ulStep = 0;
+    ptPos->ulLoop++;
+    if ((ptSeq->ulRepeat == 0) || (ptPos->ulLoop < ptSeq->ulRepeat))
+        return 1;
+
+    return 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Pwm_WaveApply
+*
+* DESCRIPTION:
+*   write the PWM registers of a slice
+*
+* PARAMETERS
+*   1. ptSeq : [In] the sequence
+*   2. ptPos : [In] the position
+*
+* RETURNS
+*   HAL_PWM_RET_FAIL   : fail, the registers are not changed
+*   HAL_PWM_RET_PASS   : pass
+*
+*************************************************************************/
+static uint8_t Hal_Pwm_WaveApply(const S_Hal_Pwm_WaveSeq_t *ptSeq, const S_Hal_Pwm_WavePos_t *ptPos)
+{
+    const S_Hal_Pwm_WaveStep_t *ptStep = &ptSeq->ptStep[ptPos->ulStep];
+    int32_t lDuty = ptStep->ubDuty;
+    int32_t lDelta;
+    int32_t lDen;
+
+    // linear from ubDuty (the first slice) to ubDutyEnd (the last slice), rounding
+    if (ptStep->uwSlices > 1)
+    {
+        lDelta = ((int32_t)ptStep->ubDutyEnd - ptStep->ubDuty) * (int32_t)ptPos->ulSlice;
+        lDen = ptStep->uwSlices - 1;
+
+        if (lDelta >= 0)
+            lDuty += (lDelta * 2 + lDen) / (lDen * 2);
+        else
+            lDuty -= (-lDelta * 2 + lDen) / (lDen * 2);
+    }
+
+    return Hal_Pwm_SimpleConfigSet(ptStep->ubIdxMask, (uint8_t)lDuty, ptStep->ulHz);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Pwm_WaveIsr
+*
+* DESCRIPTION:
+*   the timer callback, a slice ended and the next one is running
+*
+* PARAMETERS
+*   1. ulTmrIdx : [In] the timer index
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+static void Hal_Pwm_WaveIsr(uint32_t ulTmrIdx)
+{
+    S_Hal_Pwm_Wave_t *ptWave = &g_taHalPwmWave[ulTmrIdx];
+    const S_Hal_Pwm_WaveSeq_t *ptSeq = ptWave->ptSeq;
+    S_Hal_Pwm_WavePos_t tNext;
+    uint32_t ulReload;
+    uint32_t ulLate;
+
+    if (!ptWave->ubActive)
+        return;
+
+    ulReload = ptWave->ptTmr->LOAD;
+
+    // the counter was reloaded at the edge, the ticks since then
+    ulLate = ((ulReload - ptWave->ptTmr->VALUE) * Tmr_Ratio) / Tmr_TickOfUs;
+    if (ulLate > ptWave->tStat.ulLateMaxUs)
+        ptWave->tStat.ulLateMaxUs = ulLate;
+
+    // the end of the last repeat
+    if (!Hal_Pwm_WaveNext(ptSeq, &ptWave->tPos))
+    {
+        Hal_Tmr_Stop(ulTmrIdx);
+        ptWave->ubActive = 0;
+
+        if (!(ptSeq->ubFlags & HAL_PWM_WAVE_KEEP_LAST))
+            Hal_Pwm_Disable(ptWave->ubIdxMask);
+
+        ptWave->tStat.ulSeqDone++;
+
+        if (ptSeq->fpCallBack)
+            ptSeq->fpCallBack(ulTmrIdx);
+        return;
+    }
+
+    if ((ptWave->tPos.ulStep == 0) && (ptWave->tPos.ulSlice == 0))
+        ptWave->tStat.ulSeqDone++;
+
+    // e.g. the clock source was changed: the channels keep the previous slice
+    if (HAL_PWM_RET_PASS != Hal_Pwm_WaveApply(ptSeq, &ptWave->tPos))
+        ptWave->tStat.ulApplyFail++;
+
+    ptWave->tStat.ulSlices++;
+    ptWave->ulReload = ulReload;
+
+    // the length of the slice after this one, taken at the next edge
+    tNext = ptWave->tPos;
+    if (Hal_Pwm_WaveNext(ptSeq, &tNext))
+        ptWave->ptTmr->LOAD = Hal_Pwm_WaveReload(ptSeq->ptStep[tNext.ulStep].ulSliceUs);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Pwm_WaveStart
+*
+* DESCRIPTION:
+*   play a sequence on the timer
+*
+* PARAMETERS
+*   1. ulTmrIdx : [In] the timer index, 0 or 1
+*   2. ptSeq    : [In] the sequence, it is used until the end or Hal_Pwm_WaveStop
+*
+* RETURNS
+*   HAL_PWM_RET_FAIL   : fail
+*   HAL_PWM_RET_PASS   : pass
+*
+*************************************************************************/
+uint8_t Hal_Pwm_WaveStart(uint32_t ulTmrIdx, const S_Hal_Pwm_WaveSeq_t *ptSeq)
+{
+    S_Hal_Pwm_Wave_t *ptWave;
+    const S_Hal_Pwm_WaveStep_t *ptStep;
+    S_Hal_Pwm_WavePos_t tNext;
+    uint32_t ulPm;
+    uint8_t ubIdxMask = 0;
+    uint8_t bRet = HAL_PWM_RET_FAIL;
+    uint32_t i;
+
+    // error check
+    if ((ulTmrIdx >= HAL_PWM_WAVE_TMR_MAX) || (ptSeq == NULL) || (ptSeq->ptStep == NULL) || (ptSeq->ulStepNum == 0))
+        goto done;
+
+    for (i=0; i<ptSeq->ulStepNum; i++)
+    {
+        ptStep = &ptSeq->ptStep[i];
+
+        if (((ptStep->ubIdxMask & HAL_PWM_IDX_ALL) == 0) || (!Hal_Pwm_WaveHzCheck(ptStep->ulHz)) || (ptStep->uwSlices == 0)
+            || (ptStep->ubDuty > 100) || (ptStep->ubDutyEnd > 100)
+            || (ptStep->ulSliceUs < HAL_PWM_WAVE_SLICE_MIN_US) || (ptStep->ulSliceUs > HAL_PWM_WAVE_SLICE_MAX_US))
+            goto done;
+
+        ubIdxMask |= (ptStep->ubIdxMask & HAL_PWM_IDX_ALL);
+    }
+
+    ptWave = &g_taHalPwmWave[ulTmrIdx];
+    if (ptWave->ubActive)
+        goto done;
+
+    ptWave->ptTmr = (ulTmrIdx == 0) ? TMR0 : TMR1;
+    ptWave->ptSeq = ptSeq;
+    ptWave->ubIdxMask = ubIdxMask;
+    memset(&ptWave->tPos, 0, sizeof(ptWave->tPos));
+
+    Hal_Tmr_Init(ulTmrIdx);
+    Hal_Tmr_CallBackFuncSet(ulTmrIdx, Hal_Pwm_WaveIsr);
+
+    // the first slice is written before the channels run
+    if (HAL_PWM_RET_PASS != Hal_Pwm_WaveApply(ptSeq, &ptWave->tPos))
+        goto done;
+
+    ptWave->ulReload = Hal_Pwm_WaveReload(ptSeq->ptStep[0].ulSliceUs);
+    ptWave->ubActive = 1;
+    ptWave->tStat.ulSlices++;
+
+    HAL_PWM_WAVE_IRQ_SAVE(ulPm);
+
+    if (ptSeq->ubFlags & HAL_PWM_WAVE_SYNC_START)
+        Hal_Pwm_SyncEnable(ubIdxMask);
+    else
+        Hal_Pwm_Enable(ubIdxMask);
+
+    // VALUE is written, so the counter does not reload at once
+    ptWave->ptTmr->CTRL = 0;
+    ptWave->ptTmr->LOAD = ptWave->ulReload;
+    ptWave->ptTmr->VALUE = ptWave->ulReload;
+    ptWave->ptTmr->CTRL = TIMER_CTRL_EN | TIMER_CTRL_IRQEN | TIMER_CTRL_EXT_CLOCK;
+
+    tNext = ptWave->tPos;
+    if (Hal_Pwm_WaveNext(ptSeq, &tNext))
+        ptWave->ptTmr->LOAD = Hal_Pwm_WaveReload(ptSeq->ptStep[tNext.ulStep].ulSliceUs);
+
+    HAL_PWM_WAVE_IRQ_RESTORE(ulPm);
+
+    bRet = HAL_PWM_RET_PASS;
+
+done:
+    return bRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Pwm_WaveStop
+*
+* DESCRIPTION:
+*   stop the sequence and its channels, the callback is not called
+*
+* PARAMETERS
+*   1. ulTmrIdx : [In] the timer index
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void Hal_Pwm_WaveStop(uint32_t ulTmrIdx)
+{
+    S_Hal_Pwm_Wave_t *ptWave;
+    uint32_t ulPm;
+
+    if (ulTmrIdx >= HAL_PWM_WAVE_TMR_MAX)
+        return;
+
+    ptWave = &g_taHalPwmWave[ulTmrIdx];
+
+    HAL_PWM_WAVE_IRQ_SAVE(ulPm);
+
+    if (ptWave->ubActive)
+    {
+        Hal_Tmr_Stop(ulTmrIdx);
+        Hal_Tmr_IntClear(ulTmrIdx);
+        Hal_Pwm_Disable(ptWave->ubIdxMask);
+        ptWave->ubActive = 0;
+    }
+
+    HAL_PWM_WAVE_IRQ_RESTORE(ulPm);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Pwm_WaveActive
+*
+* DESCRIPTION:
+*   check if a sequence is playing on the timer
+*
+* PARAMETERS
+*   1. ulTmrIdx : [In] the timer index
+*
+* RETURNS
+*   1 : playing
+*   0 : idle
+*
+*************************************************************************/
+uint8_t Hal_Pwm_WaveActive(uint32_t ulTmrIdx)
+{
+    if (ulTmrIdx >= HAL_PWM_WAVE_TMR_MAX)
+        return 0;
+
+    return g_taHalPwmWave[ulTmrIdx].ubActive;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Pwm_WaveStatGet
+*
+* DESCRIPTION:
+*   get the counters of the timer
+*
+* PARAMETERS
+*   1. ulTmrIdx : [In] the timer index
+*   2. ptStat   : [Out] the counters
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void Hal_Pwm_WaveStatGet(uint32_t ulTmrIdx, S_Hal_Pwm_WaveStat_t *ptStat)
+{
+    uint32_t ulPm;
+
+    if (ulTmrIdx >= HAL_PWM_WAVE_TMR_MAX)
+        return;
+
+    HAL_PWM_WAVE_IRQ_SAVE(ulPm);
+    *ptStat = g_taHalPwmWave[ulTmrIdx].tStat;
+    HAL_PWM_WAVE_IRQ_RESTORE(ulPm);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Hal_Pwm_WaveStatReset
+*
+* DESCRIPTION:
+*   clear the counters of the timer
+*
+* PARAMETERS
+*   1. ulTmrIdx : [In] the timer index
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void Hal_Pwm_WaveStatReset(uint32_t ulTmrIdx)
+{
+    uint32_t ulPm;
+
+    if (ulTmrIdx >= HAL_PWM_WAVE_TMR_MAX)
+        return;
+
+    HAL_PWM_WAVE_IRQ_SAVE(ulPm);
+    memset(&g_taHalPwmWave[ulTmrIdx].tStat, 0, sizeof(S_Hal_Pwm_WaveStat_t));
+    HAL_PWM_WAVE_IRQ_RESTORE(ulPm);
+}
@@ -0,0 +1,132 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_pwm_wave.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This include file defines the timer-driven PWM waveforms.
+*
+*  A sequence is a list of steps played on Timer0 or Timer1. A step sets the
+*  frequency and duty of its PWM channels for uwSlices slices of ulSliceUs
+*  each; the duty moves linearly from ubDuty to ubDutyEnd over the slices,
+*  so a ramp is one step and a constant level is a step of one slice. The
+*  whole list is played ulRepeat times, a pulse train is an on step and an
+*  off (duty 0) step repeated.
+*
+*  The duration of the next slice is loaded into the timer one slice ahead,
+*  so the edges do not drift with the interrupt latency.
+*
+*  The PWM pins must be muxed by the caller, and the clock source of the PWM
+*  (Hal_Pwm_ClockSourceSet) must be set first: Hal_Pwm_WaveStart refuses a
+*  frequency that clock cannot make. If it is changed while a sequence
+*  plays, the slices it cannot make keep the previous setting and are
+*  counted in ulApplyFail.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+#ifndef _HAL_PWM_WAVE_H_
+#define _HAL_PWM_WAVE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <stdint.h>
+#include "hal_pwm.h"
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HAL_PWM_WAVE_TMR_MAX        2       // Timer0 and Timer1
+
+#define HAL_PWM_WAVE_SLICE_MIN_US   50      // the interrupt must finish inside a slice
+#define HAL_PWM_WAVE_SLICE_MAX_US   100000000
+
+// S_Hal_Pwm_WaveSeq_t.ubFlags
+#define HAL_PWM_WAVE_SYNC_START     0x01    // start the channels with Hal_Pwm_SyncEnable, the other channels are stopped
+#define HAL_PWM_WAVE_KEEP_LAST      0x02    // keep the channels running with the last slice at the end
+
+
+/******************************
+Declaration of data structure
+******************************/
+// Sec 3: structure, uniou, enum, linked list
+typedef struct
+{
+    uint32_t ulHz;
+    uint32_t ulSliceUs;         // the time of one slice
+    uint16_t uwSlices;          // 1 ~ 65535
+    uint8_t ubIdxMask;          // HAL_PWM_IDX_x
+    uint8_t ubDuty;             // the percentage of duty at the first slice
+    uint8_t ubDutyEnd;          // the percentage of duty at the last slice
+} S_Hal_Pwm_WaveStep_t;
+
+typedef void (*T_Hal_Pwm_WaveCallBack)(uint32_t ulTmrIdx);
+
+typedef struct
+{
+    const S_Hal_Pwm_WaveStep_t *ptStep;
+    uint32_t ulStepNum;
+    uint32_t ulRepeat;          // 0: until Hal_Pwm_WaveStop
+    uint8_t ubFlags;
+    T_Hal_Pwm_WaveCallBack fpCallBack;  // timer interrupt context, at the end of the last repeat
+} S_Hal_Pwm_WaveSeq_t;
+
+typedef struct
+{
+    uint32_t ulSlices;
+    uint32_t ulSeqDone;
+    uint32_t ulLateMaxUs;       // the worst interrupt latency after a slice edge
+    uint32_t ulApplyFail;       // slices Hal_Pwm_SimpleConfigSet refused
+} S_Hal_Pwm_WaveStat_t;
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+
+// Sec 5: declaration of global function prototype
+uint8_t Hal_Pwm_WaveStart(uint32_t ulTmrIdx, const S_Hal_Pwm_WaveSeq_t *ptSeq);
+void Hal_Pwm_WaveStop(uint32_t ulTmrIdx);
+uint8_t Hal_Pwm_WaveActive(uint32_t ulTmrIdx);
+void Hal_Pwm_WaveStatGet(uint32_t ulTmrIdx, S_Hal_Pwm_WaveStat_t *ptStat);
+void Hal_Pwm_WaveStatReset(uint32_t ulTmrIdx);
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+
+
+// Sec 7: declaration of static function prototype
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HAL_PWM_WAVE_H_
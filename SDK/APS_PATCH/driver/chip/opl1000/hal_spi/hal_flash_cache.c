@@ -0,0 +1,544 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_flash_cache.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This source file defines the read cache in front of the SPI0 flash.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <string.h>
+#include "cmsis_os.h"
+#include "hal_flash.h"
+#include "hal_flash_internal.h"
+#include "hal_flash_cache.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HAL_FLASH_CACHE_ADDR_NONE       0xFFFFFFFF
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    uint32_t u32Addr;
+    uint32_t u32Age;
+    uint8_t u8Valid;
+    uint8_t u8Prefetched;
+    uint8_t u8aData[HAL_FLASH_CACHE_LINE_SIZE];
+} S_FlashCacheLine_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+extern osSemaphoreId g_taHalFlashSemaphoreId[SPI_IDX_MAX];
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+#if (HAL_FLASH_CACHE_LINE_NUM > 0)
+static S_FlashCacheLine_t g_taHalFlashCacheLine[HAL_FLASH_CACHE_LINE_NUM];
+static uint32_t g_u32HalFlashCacheAge;
+static uint32_t g_u32HalFlashCacheLastLine = HAL_FLASH_CACHE_ADDR_NONE;
+static uint8_t g_u8HalFlashCacheEnable;
+static S_FlashCacheStat_t g_tHalFlashCacheStat;
+
+// the uncached functions
+static T_Hal_Flash_AddrRead_Internal          g_tHalFlashCacheBusRead;
+static T_Hal_Flash_AddrProgram_Internal       g_tHalFlashCacheProgram;
+static T_Hal_Flash_PageAddrProgram_Internal   g_tHalFlashCachePageProgram;
+static T_Hal_Flash_4KSectorAddrErase_Internal g_tHalFlashCacheErase;
+static T_Hal_Flash_Reset_Internal             g_tHalFlashCacheReset;
+#endif
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+#if (HAL_FLASH_CACHE_LINE_NUM > 0)
+static uint32_t _Hal_Flash_CacheBusRead(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data)
+{
+    if (u32SpiIdx == SPI_IDX_0)
+    {
+        g_tHalFlashCacheStat.u32BusReads++;
+        g_tHalFlashCacheStat.u32BusBytes += u32Size;
+    }
+
+    return g_tHalFlashCacheBusRead(u32SpiIdx, u32StartAddr, u8UseQuadMode, u32Size, pu8Data);
+}
+
+static S_FlashCacheLine_t *_Hal_Flash_CacheLookup(uint32_t u32LineAddr)
+{
+    uint32_t i;
+
+    for (i = 0; i < HAL_FLASH_CACHE_LINE_NUM; i++)
+    {
+        if ((g_taHalFlashCacheLine[i].u8Valid) && (g_taHalFlashCacheLine[i].u32Addr == u32LineAddr))
+            return &g_taHalFlashCacheLine[i];
+    }
+
+    return NULL;
+}
+
+static S_FlashCacheLine_t *_Hal_Flash_CacheFill(uint32_t u32LineAddr, uint8_t u8UseQuadMode)
+{
+    S_FlashCacheLine_t *ptLine = &g_taHalFlashCacheLine[0];
+    uint32_t i;
+
+    // an invalid line, or the least recently used one
+    for (i = 0; i < HAL_FLASH_CACHE_LINE_NUM; i++)
+    {
+        if (!g_taHalFlashCacheLine[i].u8Valid)
+        {
+            ptLine = &g_taHalFlashCacheLine[i];
+            break;
+        }
+
+        if ((g_u32HalFlashCacheAge - g_taHalFlashCacheLine[i].u32Age) > (g_u32HalFlashCacheAge - ptLine->u32Age))
+            ptLine = &g_taHalFlashCacheLine[i];
+    }
+
+    ptLine->u8Valid = 0;
+
+    if (0 != _Hal_Flash_CacheBusRead(SPI_IDX_0, u32LineAddr, u8UseQuadMode, HAL_FLASH_CACHE_LINE_SIZE, ptLine->u8aData))
+        return NULL;
+
+    ptLine->u32Addr = u32LineAddr;
+    ptLine->u32Age = ++g_u32HalFlashCacheAge;
+    ptLine->u8Prefetched = 0;
+    ptLine->u8Valid = 1;
+
+    return ptLine;
+}
+
+static void _Hal_Flash_CachePrefetch(uint32_t u32LineAddr, uint8_t u8UseQuadMode)
+{
+    S_FlashCacheLine_t *ptLine;
+    uint32_t u32Addr;
+    uint32_t i;
+
+    for (i = 1; i <= HAL_FLASH_CACHE_PREFETCH; i++)
+    {
+        u32Addr = u32LineAddr + (i * HAL_FLASH_CACHE_LINE_SIZE);
+
+        if (_Hal_Flash_CacheLookup(u32Addr))
+            continue;
+
+        // past the end of the flash the read fails, just stop
+        ptLine = _Hal_Flash_CacheFill(u32Addr, u8UseQuadMode);
+        if (ptLine == NULL)
+            break;
+
+        ptLine->u8Prefetched = 1;
+        g_tHalFlashCacheStat.u32Prefetch++;
+    }
+}
+
+static void _Hal_Flash_CacheInvalidate(uint32_t u32Addr, uint32_t u32Size)
+{
+    S_FlashCacheLine_t *ptLine;
+    uint32_t i;
+
+    for (i = 0; i < HAL_FLASH_CACHE_LINE_NUM; i++)
+    {
+        ptLine = &g_taHalFlashCacheLine[i];
+
+        if (!ptLine->u8Valid)
+            continue;
+
+        if ((ptLine->u32Addr < (u32Addr + u32Size)) && (u32Addr < (ptLine->u32Addr + HAL_FLASH_CACHE_LINE_SIZE)))
+        {
+            ptLine->u8Valid = 0;
+            g_tHalFlashCacheStat.u32Invalidate++;
+        }
+    }
+
+    g_u32HalFlashCacheLastLine = HAL_FLASH_CACHE_ADDR_NONE;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_AddrRead (cached)
+*
+* DESCRIPTION:
+*   1. Read n bytes from the start address through the cache
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx      : Index of SPI. refert to E_SpiIdx_t
+*   2. u32StartAddr : Start address
+*   3. u8UseQuadMode: Qaud-mode select. 1 for enable/0 for disable
+*   4. u32Size      : Data size
+*   5. pu8Data      : Data buffer
+*
+* RETURNS
+*   0: setting complete
+*   1: error
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+static uint32_t Hal_Flash_AddrRead_Internal_cache(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data)
+{
+    S_FlashCacheLine_t *ptLine;
+    uint32_t u32LineAddr;
+    uint32_t u32Offset;
+    uint32_t u32DataSize;
+
+    if ((u32SpiIdx != SPI_IDX_0) || (!g_u8HalFlashCacheEnable) || (u32Size == 0) || (pu8Data == NULL))
+        return _Hal_Flash_CacheBusRead(u32SpiIdx, u32StartAddr, u8UseQuadMode, u32Size, pu8Data);
+
+    if (u32Size >= HAL_FLASH_CACHE_BYPASS_SIZE)
+    {
+        g_tHalFlashCacheStat.u32Bypass++;
+        return _Hal_Flash_CacheBusRead(u32SpiIdx, u32StartAddr, u8UseQuadMode, u32Size, pu8Data);
+    }
+
+    while (u32Size > 0)
+    {
+        u32LineAddr = u32StartAddr & ~(HAL_FLASH_CACHE_LINE_SIZE - 1);
+        u32Offset = u32StartAddr - u32LineAddr;
+        u32DataSize = HAL_FLASH_CACHE_LINE_SIZE - u32Offset;
+        if (u32DataSize > u32Size)
+            u32DataSize = u32Size;
+
+        ptLine = _Hal_Flash_CacheLookup(u32LineAddr);
+        if (ptLine)
+        {
+            g_tHalFlashCacheStat.u32Hit++;
+
+            if (ptLine->u8Prefetched)
+            {
+                ptLine->u8Prefetched = 0;
+                g_tHalFlashCacheStat.u32PrefetchHit++;
+            }
+
+            ptLine->u32Age = ++g_u32HalFlashCacheAge;
+        }
+        else
+        {
+            ptLine = _Hal_Flash_CacheFill(u32LineAddr, u8UseQuadMode);
+            if (ptLine == NULL)
+                return 1;
+
+            g_tHalFlashCacheStat.u32Miss++;
+        }
+
+        memcpy(pu8Data, &ptLine->u8aData[u32Offset], u32DataSize);
+
+        // sequential access: keep the next lines ready
+        if ((u32LineAddr != g_u32HalFlashCacheLastLine) &&
+            (u32LineAddr == (g_u32HalFlashCacheLastLine + HAL_FLASH_CACHE_LINE_SIZE)))
+        {
+            _Hal_Flash_CachePrefetch(u32LineAddr, u8UseQuadMode);
+        }
+
+        g_u32HalFlashCacheLastLine = u32LineAddr;
+
+        u32StartAddr += u32DataSize;
+        pu8Data += u32DataSize;
+        u32Size -= u32DataSize;
+    }
+
+    return 0;
+}
+
+static uint32_t Hal_Flash_AddrProgram_Internal_cache(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data)
+{
+    uint32_t u32Ret = g_tHalFlashCacheProgram(u32SpiIdx, u32StartAddr, u8UseQuadMode, u32Size, pu8Data);
+
+    // also after a failure, part of the data may be written
+    if (u32SpiIdx == SPI_IDX_0)
+        _Hal_Flash_CacheInvalidate(u32StartAddr, u32Size);
+
+    return u32Ret;
+}
+
+static uint32_t Hal_Flash_PageAddrProgram_Internal_cache(E_SpiIdx_t u32SpiIdx, uint32_t u32PageAddr, uint8_t u8UseQuadMode, uint8_t *pu8Data)
+{
+    uint32_t u32Ret = g_tHalFlashCachePageProgram(u32SpiIdx, u32PageAddr, u8UseQuadMode, pu8Data);
+
+    if (u32SpiIdx == SPI_IDX_0)
+        _Hal_Flash_CacheInvalidate(u32PageAddr & ~0xFF, 0x100);
+
+    return u32Ret;
+}
+
+static uint32_t Hal_Flash_4KSectorAddrErase_Internal_cache(E_SpiIdx_t u32SpiIdx, uint32_t u32SecAddr)
+{
+    uint32_t u32Ret = g_tHalFlashCacheErase(u32SpiIdx, u32SecAddr);
+
+    if (u32SpiIdx == SPI_IDX_0)
+        _Hal_Flash_CacheInvalidate(u32SecAddr & ~0xFFF, 0x1000);
+
+    return u32Ret;
+}
+
+static void Hal_Flash_Reset_Internal_cache(E_SpiIdx_t u32SpiIdx)
+{
+    g_tHalFlashCacheReset(u32SpiIdx);
+
+    if (u32SpiIdx == SPI_IDX_0)
+        _Hal_Flash_CacheInvalidate(0, HAL_FLASH_CACHE_ADDR_NONE);
+}
+#endif //#if (HAL_FLASH_CACHE_LINE_NUM > 0)
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_CacheInit
+*
+* DESCRIPTION:
+*   1. Put the cache in front of the current *_Internal flash functions.
+*      Call once, after the flash patch functions are set.
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_Flash_CacheInit(void)
+{
+#if (HAL_FLASH_CACHE_LINE_NUM > 0)
+    if (g_tHalFlashCacheBusRead)
+        return;
+
+    memset(g_taHalFlashCacheLine, 0, sizeof(g_taHalFlashCacheLine));
+    memset(&g_tHalFlashCacheStat, 0, sizeof(g_tHalFlashCacheStat));
+    g_u32HalFlashCacheLastLine = HAL_FLASH_CACHE_ADDR_NONE;
+
+    g_tHalFlashCacheBusRead     = Hal_Flash_AddrRead_Internal;
+    g_tHalFlashCacheProgram     = Hal_Flash_AddrProgram_Internal;
+    g_tHalFlashCachePageProgram = Hal_Flash_PageAddrProgram_Internal;
+    g_tHalFlashCacheErase       = Hal_Flash_4KSectorAddrErase_Internal;
+    g_tHalFlashCacheReset       = Hal_Flash_Reset_Internal;
+
+    Hal_Flash_AddrRead_Internal          = Hal_Flash_AddrRead_Internal_cache;
+    Hal_Flash_AddrProgram_Internal       = Hal_Flash_AddrProgram_Internal_cache;
+    Hal_Flash_PageAddrProgram_Internal   = Hal_Flash_PageAddrProgram_Internal_cache;
+    Hal_Flash_4KSectorAddrErase_Internal = Hal_Flash_4KSectorAddrErase_Internal_cache;
+    Hal_Flash_Reset_Internal             = Hal_Flash_Reset_Internal_cache;
+
+    g_u8HalFlashCacheEnable = HAL_FLASH_CACHE_ENABLE_DEF;
+#endif
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_CacheEnable
+*
+* DESCRIPTION:
+*   1. Enable or disable the cache, the lines are dropped either way.
+*      Called from a task (takes the flash semaphore).
+*
+* CALLS
+*
+* PARAMETERS
+*   1. u8Enable     : 1 for enable/0 for disable
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_Flash_CacheEnable(uint8_t u8Enable)
+{
+#if (HAL_FLASH_CACHE_LINE_NUM > 0)
+    if (!g_tHalFlashCacheBusRead)
+        return;
+
+    osSemaphoreWait(g_taHalFlashSemaphoreId[SPI_IDX_0], osWaitForever);
+
+    _Hal_Flash_CacheInvalidate(0, HAL_FLASH_CACHE_ADDR_NONE);
+    g_u8HalFlashCacheEnable = u8Enable ? 1 : 0;
+
+    osSemaphoreRelease(g_taHalFlashSemaphoreId[SPI_IDX_0]);
+#else
+    (void)u8Enable;
+#endif
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_CacheIsEnabled
+*
+* DESCRIPTION:
+*   1. Get the cache state
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   1: enabled
+*   0: disabled
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint8_t Hal_Flash_CacheIsEnabled(void)
+{
+#if (HAL_FLASH_CACHE_LINE_NUM > 0)
+    return g_u8HalFlashCacheEnable;
+#else
+    return 0;
+#endif
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_CacheInvalidate
+*
+* DESCRIPTION:
+*   1. Drop the lines of an address range, for flash changed without the
+*      HAL (e.g. by the M0). Called from a task (takes the flash semaphore).
+*
+* CALLS
+*
+* PARAMETERS
+*   1. u32Addr      : Start address
+*   2. u32Size      : Size
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_Flash_CacheInvalidate(uint32_t u32Addr, uint32_t u32Size)
+{
+#if (HAL_FLASH_CACHE_LINE_NUM > 0)
+    if (!g_tHalFlashCacheBusRead)
+        return;
+
+    osSemaphoreWait(g_taHalFlashSemaphoreId[SPI_IDX_0], osWaitForever);
+    _Hal_Flash_CacheInvalidate(u32Addr, u32Size);
+    osSemaphoreRelease(g_taHalFlashSemaphoreId[SPI_IDX_0]);
+#else
+    (void)u32Addr;
+    (void)u32Size;
+#endif
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_CacheInvalidate_Internal
+*
+* DESCRIPTION:
+*   1. Same as Hal_Flash_CacheInvalidate, for a caller that already holds
+*      the flash semaphore of SPI0.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. u32Addr      : Start address
+*   2. u32Size      : Size
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_Flash_CacheInvalidate_Internal(uint32_t u32Addr, uint32_t u32Size)
+{
+#if (HAL_FLASH_CACHE_LINE_NUM > 0)
+    if (!g_tHalFlashCacheBusRead)
+        return;
+
+    _Hal_Flash_CacheInvalidate(u32Addr, u32Size);
+#else
+    (void)u32Addr;
+    (void)u32Size;
+#endif
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_CacheStatGet
+*
+* DESCRIPTION:
+*   1. Get the cache statistics
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptStat       : [OUT] statistics
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_Flash_CacheStatGet(S_FlashCacheStat_t *ptStat)
+{
+#if (HAL_FLASH_CACHE_LINE_NUM > 0)
+    *ptStat = g_tHalFlashCacheStat;
+#else
+    memset(ptStat, 0, sizeof(S_FlashCacheStat_t));
+#endif
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_CacheStatReset
+*
+* DESCRIPTION:
+*   1. Clear the cache statistics
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_Flash_CacheStatReset(void)
+{
+#if (HAL_FLASH_CACHE_LINE_NUM > 0)
+    memset(&g_tHalFlashCacheStat, 0, sizeof(g_tHalFlashCacheStat));
+#endif
+}
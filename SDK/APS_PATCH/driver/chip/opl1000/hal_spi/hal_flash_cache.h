@@ -0,0 +1,115 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_flash_cache.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This include file defines the read cache in front of the SPI0 flash.
+*
+*  Lines of HAL_FLASH_CACHE_LINE_SIZE bytes are filled on a read miss, the
+*  next line is prefetched when misses are sequential. Program and erase go
+*  to the flash directly and invalidate the lines they touch. Reads of
+*  HAL_FLASH_CACHE_BYPASS_SIZE bytes or more are not cached.
+*
+*  The cache wraps the *_Internal flash function pointers, so it is coherent
+*  as long as every program/erase on the M3 goes through them.
+*
+*  Limitation: the cache does not see flash written by the M0, which has
+*  its own SPI0 access. Code that lets the M0 change flash the M3 also
+*  reads must call Hal_Flash_CacheInvalidate() on that range once the M0 is
+*  done; the AT flash commands (at+writeflash/at+eraseflash on
+*  0xF8000 - 0xFFFFF) do so for their range.
+*
+******************************************************************************/
+
+#ifndef __HAL_FLASH_CACHE_H__
+#define __HAL_FLASH_CACHE_H__
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include "hal_flash.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#ifndef HAL_FLASH_CACHE_LINE_NUM
+#define HAL_FLASH_CACHE_LINE_NUM        8       // 0: no cache
+#endif
+
+#ifndef HAL_FLASH_CACHE_ENABLE_DEF
+#define HAL_FLASH_CACHE_ENABLE_DEF      1       // 0: start disabled, the bus counters still run
+#endif
+
+#ifndef HAL_FLASH_CACHE_LINE_SIZE
+#define HAL_FLASH_CACHE_LINE_SIZE       256     // power of 2
+#endif
+
+#ifndef HAL_FLASH_CACHE_BYPASS_SIZE
+#define HAL_FLASH_CACHE_BYPASS_SIZE     1024
+#endif
+
+#ifndef HAL_FLASH_CACHE_PREFETCH
+#define HAL_FLASH_CACHE_PREFETCH        1       // lines read ahead on a sequential miss
+#endif
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    uint32_t u32Hit;                // lines served from the cache
+    uint32_t u32Miss;               // lines read from the flash on demand
+    uint32_t u32Prefetch;           // lines read ahead
+    uint32_t u32PrefetchHit;        // prefetched lines used later
+    uint32_t u32Bypass;             // reads not cached
+    uint32_t u32Invalidate;         // lines dropped by program/erase
+    uint32_t u32BusReads;           // read transactions issued to the flash
+    uint32_t u32BusBytes;           // bytes read from the flash
+} S_FlashCacheStat_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+void Hal_Flash_CacheInit(void);
+void Hal_Flash_CacheEnable(uint8_t u8Enable);
+uint8_t Hal_Flash_CacheIsEnabled(void);
+void Hal_Flash_CacheInvalidate(uint32_t u32Addr, uint32_t u32Size);
+void Hal_Flash_CacheInvalidate_Internal(uint32_t u32Addr, uint32_t u32Size);
+void Hal_Flash_CacheStatGet(S_FlashCacheStat_t *ptStat);
+void Hal_Flash_CacheStatReset(void);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+#endif
@@ -33,6 +33,7 @@ Head Block of The File
 // Sec 0: Comment block of the file
 
 // Sec 1: Include File 
+#include <string.h>
 #include "hal_flash.h"
 #include "hal_flash_internal.h"
 #include "cmsis_os.h"
@@ -52,6 +53,18 @@ Head Block of The File
 #define SPI_SR_TX_NOT_FULL           (1<<1)
 #define SPI_TIMEOUT 0x5000
 
+#define HAL_FLASH_FIFO_DEPTH         4   // RX FIFO size
+#define HAL_FLASH_HEADER_MAX         6   // address, mode and dummy bytes after the command
+
+#define HAL_FLASH_QUAD_IO_UNKNOWN    0
+#define HAL_FLASH_QUAD_IO_ON         1
+#define HAL_FLASH_QUAD_IO_OFF        2
+
+// compared in single-bit and quad I/O before 0xEB is used: the boot agent,
+// never blank and never erased at run time
+#define HAL_FLASH_QUAD_IO_CHECK_ADDR 0x0
+#define HAL_FLASH_QUAD_IO_CHECK_SIZE 16
+
 typedef struct
 {
     volatile uint32_t CTRLR0;  // 0x00
@@ -93,13 +106,19 @@ Declaration of Global Variables & Functions
 extern uint8_t g_u8aHalFlashID[SPI_IDX_MAX];
 
 // Sec 5: declaration of global function prototype
+extern uint32_t Hal_Flash_Init_Internal_impl(E_SpiIdx_t u32SpiIdx);
 
 /***************************************************
 Declaration of static Global Variables &  Functions
 ***************************************************/
 // Sec 6: declaration of static global  variable
+static uint8_t g_u8aHalFlashReadMode[SPI_IDX_MAX] = {HAL_FLASH_READ_MODE_AUTO, HAL_FLASH_READ_MODE_AUTO, HAL_FLASH_READ_MODE_AUTO};
+static uint8_t g_u8aHalFlashQuadIo[SPI_IDX_MAX] = {HAL_FLASH_QUAD_IO_UNKNOWN, HAL_FLASH_QUAD_IO_UNKNOWN, HAL_FLASH_QUAD_IO_UNKNOWN};
+static S_FlashReadStat_t g_taHalFlashReadStat[SPI_IDX_MAX];
 
 // Sec 7: declaration of static function prototype
+static uint32_t _Hal_Flash_ReadStream(S_Spi_Reg_t *pSpi, uint32_t u32StartAddr, E_FlashReadMode_t eMode, uint32_t u32Size, uint8_t *pu8Data);
+static void _Hal_Flash_ReadAbort(S_Spi_Reg_t *pSpi);
 
 /***********
 C Functions
@@ -379,169 +398,174 @@ uint32_t Hal_Flash_AddrProgram_Internal_patch(E_SpiIdx_t u32SpiIdx, uint32_t u32
 
 /*************************************************************************
 * FUNCTION:
-*  Hal_Flash_AddrRead
+*  _Hal_Flash_QuadIoCheck
 *
 * DESCRIPTION:
-*   1. Read n bytes from the start address
+*   1. Check the part can do quad I/O read (0xEB): known vendor and the QE
+*      bit is set in the status register
+*   2. Read HAL_FLASH_QUAD_IO_CHECK_SIZE bytes with 0x0B and with 0xEB and
+*      compare them. A board without IO2/IO3 or a part that does not take
+*      0xEB returns wrong data, not a timeout, so the status bits alone are
+*      not enough. Blank data proves nothing (floating lines read 0xFF) and
+*      turns quad I/O off too.
 *
 * CALLS
 *
 * PARAMETERS
-*   1. eSpiIdx      : Index of SPI. refert to E_SpiIdx_t
-*   2. u32StartAddr : Start address
-*   3. u8UseQuadMode: Qaud-mode select. 1 for enable/0 for disable
-*   4. u32Size      : Data size
-*   5. pu8Data      : Data buffer
+*   1. eSpiIdx      : Index of SPI. Only SPI_IDX_0
 *
 * RETURNS
-*   0: setting complete
-*   1: error 
+*   HAL_FLASH_QUAD_IO_ON / HAL_FLASH_QUAD_IO_OFF
 * 
 * GLOBALS AFFECTED
 * 
 *************************************************************************/
-uint32_t Hal_Flash_AddrRead_Internal_patch(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data)
+static uint8_t _Hal_Flash_QuadIoCheck(E_SpiIdx_t u32SpiIdx)
 {
-    S_Spi_Reg_t *pSpi = 0;
-    uint32_t u32Idx = 0;
-    uint32_t u32Temp = 0;
-    uint32_t u32QuadBit = 0;
-    
-    uint32_t u32TimeOut;
+    uint8_t u8aRef[HAL_FLASH_QUAD_IO_CHECK_SIZE];
+    uint8_t u8aQuad[HAL_FLASH_QUAD_IO_CHECK_SIZE];
+    uint32_t u32Status_0 = 0;
+    uint32_t u32Status_1 = 0;
     uint32_t i;
 
-    if (u32SpiIdx == SPI_IDX_0)
-	{
-        pSpi = SPI_0;
-	}
-    else if (u32SpiIdx == SPI_IDX_1)
-    {
-        pSpi = SPI_1;
-    }
-    else if (u32SpiIdx == SPI_IDX_2)
-    {
-        pSpi = SPI_2;
-    }
-    else
-    {
-        return 1;
-    }
+    if (u32SpiIdx != SPI_IDX_0)
+        return HAL_FLASH_QUAD_IO_OFF;
 
-    if (g_u8aHalFlashID[u32SpiIdx] == NO_FLASH)
-        return 1;
-    
-    if ((u32Size == 0) || (pu8Data == NULL))
-        return 1;
+    if ((g_u8aHalFlashID[u32SpiIdx] != GIGADEVICE_ID) &&
+        (g_u8aHalFlashID[u32SpiIdx] != MACRONIX_ID) &&
+        (g_u8aHalFlashID[u32SpiIdx] != WINBOND_NEX_ID))
+        return HAL_FLASH_QUAD_IO_OFF;
 
-    // read cmd
-    if (u8UseQuadMode)
+    if (0 != _Hal_Flash_StatusGet(u32SpiIdx, &u32Status_0, &u32Status_1))
+        return HAL_FLASH_QUAD_IO_OFF;
+
+    // QE: Macronix SR bit 6, GigaDevice/Winbond SR bit 9
+    if (g_u8aHalFlashID[u32SpiIdx] == MACRONIX_ID)
     {
-        u32Temp = TAG_DFS_08 | TAG_CS_CONT | TAG_1_BIT | TAG_WRITE | 0x6B;
-        pSpi->DR[0] = u32Temp;
+        if (!(u32Status_0 & 0x40))
+            return HAL_FLASH_QUAD_IO_OFF;
     }
     else
     {
-        u32Temp = TAG_DFS_08 | TAG_CS_CONT | TAG_1_BIT | TAG_WRITE | 0x0B;
-        pSpi->DR[0] = u32Temp;
+        if (!(u32Status_1 & 0x02))
+            return HAL_FLASH_QUAD_IO_OFF;
     }
-    u32TimeOut = 0;
-    while( !(pSpi->SR & SPI_SR_RX_NOT_EMPTY) )
+
+    if (0 != _Hal_Flash_ReadStream(SPI_0, HAL_FLASH_QUAD_IO_CHECK_ADDR, HAL_FLASH_READ_MODE_FAST, HAL_FLASH_QUAD_IO_CHECK_SIZE, u8aRef))
     {
-        // Wait for RX not Empty...
-        
-        //Time-out check
-        if( u32TimeOut > SPI_TIMEOUT )
-            return 1;
-        u32TimeOut++;
+        _Hal_Flash_ReadAbort(SPI_0);
+        return HAL_FLASH_QUAD_IO_OFF;
     }
-    u32Temp = pSpi->DR[0];  // dummy
-    
-    // Addr
-    u32Temp = TAG_DFS_08 | TAG_CS_CONT | TAG_1_BIT | TAG_WRITE | ( (u32StartAddr>>16) & 0xFF );
-    pSpi->DR[0] = u32Temp;
-    u32Temp = TAG_DFS_08 | TAG_CS_CONT | TAG_1_BIT | TAG_WRITE | ( (u32StartAddr>>8) & 0xFF );
-    pSpi->DR[0] = u32Temp;
-    u32Temp = TAG_DFS_08 | TAG_CS_CONT | TAG_1_BIT | TAG_WRITE | (u32StartAddr & 0xFF);
-    pSpi->DR[0] = u32Temp;
-    u32Temp = TAG_DFS_08 | TAG_CS_CONT | TAG_1_BIT | TAG_WRITE | DUMMY;
-    pSpi->DR[0] = u32Temp;
-    
-    u32TimeOut = 0;
-    while( !(pSpi->SR & SPI_SR_RX_NOT_EMPTY) )
+
+    if (0 != _Hal_Flash_ReadStream(SPI_0, HAL_FLASH_QUAD_IO_CHECK_ADDR, HAL_FLASH_READ_MODE_QUAD_IO, HAL_FLASH_QUAD_IO_CHECK_SIZE, u8aQuad))
     {
-        // Wait for RX not Empty...
-        
-        //Time-out check
-        if( u32TimeOut > SPI_TIMEOUT )
-            return 1;
-        u32TimeOut++;
+        _Hal_Flash_ReadAbort(SPI_0);
+        return HAL_FLASH_QUAD_IO_OFF;
     }
-    u32Temp = pSpi->DR[0];  // dummy
-    
-    u32TimeOut = 0;
-    while( !(pSpi->SR & SPI_SR_RX_NOT_EMPTY) )
+
+    if (0 != memcmp(u8aRef, u8aQuad, HAL_FLASH_QUAD_IO_CHECK_SIZE))
+        return HAL_FLASH_QUAD_IO_OFF;
+
+    for (i = 0; i < HAL_FLASH_QUAD_IO_CHECK_SIZE; i++)
     {
-        // Wait for RX not Empty...
-        
-        //Time-out check
-        if( u32TimeOut > SPI_TIMEOUT )
-            return 1;
-        u32TimeOut++;
+        if (u8aRef[i] != 0xFF)
+            return HAL_FLASH_QUAD_IO_ON;
     }
-    u32Temp = pSpi->DR[0];  // dummy
-    
-    u32TimeOut = 0;
-    while( !(pSpi->SR & SPI_SR_RX_NOT_EMPTY) )
+
+    return HAL_FLASH_QUAD_IO_OFF;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  _Hal_Flash_ReadStream
+*
+* DESCRIPTION:
+*   1. Read n bytes in one transaction (one CS assertion)
+*   2. The TX FIFO is refilled as soon as an RX entry is taken, so the
+*      transfer never waits for a batch to drain. At most
+*      HAL_FLASH_FIFO_DEPTH entries are in flight (RX FIFO size).
+*
+* CALLS
+*
+* PARAMETERS
+*   1. pSpi         : SPI registers
+*   2. u32StartAddr : Start address
+*   3. eMode        : Read mode, refer to E_FlashReadMode_t (not AUTO)
+*   4. u32Size      : Data size
+*   5. pu8Data      : Data buffer
+*
+* RETURNS
+*   0: setting complete
+*   1: error 
+* 
+* GLOBALS AFFECTED
+* 
+*************************************************************************/
+static uint32_t _Hal_Flash_ReadStream(S_Spi_Reg_t *pSpi, uint32_t u32StartAddr, E_FlashReadMode_t eMode, uint32_t u32Size, uint8_t *pu8Data)
+{
+    uint8_t u8aHeader[HAL_FLASH_HEADER_MAX];
+    uint32_t u32HeaderNum = 0;
+    uint32_t u32HeaderTag = 0;
+    uint32_t u32ReadTag = 0;
+    uint32_t u32Total = 0;
+    uint32_t u32Sent = 0;
+    uint32_t u32Recv = 0;
+    uint32_t u32Temp = 0;
+    uint32_t u32TimeOut;
+
+    u8aHeader[0] = (u32StartAddr >> 16) & 0xFF;
+    u8aHeader[1] = (u32StartAddr >> 8) & 0xFF;
+    u8aHeader[2] = u32StartAddr & 0xFF;
+
+    if (eMode == HAL_FLASH_READ_MODE_QUAD_IO)
     {
-        // Wait for RX not Empty...
-        
-        //Time-out check
-        if( u32TimeOut > SPI_TIMEOUT )
-            return 1;
-        u32TimeOut++;
+        // cmd 1-bit, addr + mode byte + 4 dummy clocks 4-bit, data 4-bit
+        u8aHeader[3] = 0x00;    // M7-0: no continuous read mode
+        u8aHeader[4] = DUMMY;
+        u8aHeader[5] = DUMMY;
+        u32HeaderNum = 6;
+        u32HeaderTag = TAG_DFS_08 | TAG_CS_CONT | TAG_4_BIT | TAG_WRITE;
+        u32ReadTag = TAG_DFS_08 | TAG_4_BIT | TAG_READ;
+        u32Temp = 0xEB;
     }
-    u32Temp = pSpi->DR[0];  // dummy
-    
-    u32TimeOut = 0;
-    while( !(pSpi->SR & SPI_SR_RX_NOT_EMPTY) )
+    else
     {
-        // Wait for RX not Empty...
-        
-        //Time-out check
-        if( u32TimeOut > SPI_TIMEOUT )
-            return 1;
-        u32TimeOut++;
+        // cmd, addr and 8 dummy clocks 1-bit, data 1-bit or 4-bit
+        u8aHeader[3] = DUMMY;
+        u32HeaderNum = 4;
+        u32HeaderTag = TAG_DFS_08 | TAG_CS_CONT | TAG_1_BIT | TAG_WRITE;
+
+        if (eMode == HAL_FLASH_READ_MODE_QUAD_OUT)
+        {
+            u32ReadTag = TAG_DFS_08 | TAG_4_BIT | TAG_READ;
+            u32Temp = 0x6B;
+        }
+        else
+        {
+            u32ReadTag = TAG_DFS_08 | TAG_1_BIT | TAG_READ;
+            u32Temp = 0x0B;
+        }
     }
-    u32Temp = pSpi->DR[0];  // dummy
-    
-    // read data
-    // decide the quad mode or standard mode
-    if (u8UseQuadMode)
-        u32QuadBit = TAG_4_BIT;
-    else
-        u32QuadBit = TAG_1_BIT;
 
-    // 4 bytes per round
-    u32Temp = TAG_DFS_08 | TAG_CS_CONT | u32QuadBit | TAG_READ | DUMMY;
-    for (u32Idx=0; (u32Idx+4)<u32Size; u32Idx+=4)
+    // entries: cmd + header + data
+    u32Total = 1 + u32HeaderNum + u32Size;
+
+    while (u32Recv < u32Total)
     {
-        pSpi->DR[0] = u32Temp;
-        pSpi->DR[0] = u32Temp;
-        pSpi->DR[0] = u32Temp;
-        pSpi->DR[0] = u32Temp;
-        
-        u32TimeOut = 0;
-        while( !(pSpi->SR & SPI_SR_RX_NOT_EMPTY) )
+        while ((u32Sent < u32Total) && ((u32Sent - u32Recv) < HAL_FLASH_FIFO_DEPTH))
         {
-            // Wait for RX not Empty...
-            
-            //Time-out check
-            if( u32TimeOut > SPI_TIMEOUT )
-                return 1;
-            u32TimeOut++;
+            if (u32Sent == 0)
+                pSpi->DR[0] = TAG_DFS_08 | TAG_CS_CONT | TAG_1_BIT | TAG_WRITE | u32Temp;
+            else if (u32Sent <= u32HeaderNum)
+                pSpi->DR[0] = u32HeaderTag | u8aHeader[u32Sent - 1];
+            else if (u32Sent != (u32Total - 1))
+                pSpi->DR[0] = u32ReadTag | TAG_CS_CONT | DUMMY;
+            else
+                pSpi->DR[0] = u32ReadTag | TAG_CS_COMP | DUMMY; // complete
+
+            u32Sent++;
         }
-        pu8Data[u32Idx] = (uint8_t)( pSpi->DR[0] & 0xFF );
-        
+
         u32TimeOut = 0;
         while( !(pSpi->SR & SPI_SR_RX_NOT_EMPTY) )
         {
@@ -552,56 +576,312 @@ uint32_t Hal_Flash_AddrRead_Internal_patch(E_SpiIdx_t u32SpiIdx, uint32_t u32Sta
                 return 1;
             u32TimeOut++;
         }
-        pu8Data[u32Idx+1] = (uint8_t)( pSpi->DR[0] & 0xFF );
-        
-        u32TimeOut = 0;
-        while( !(pSpi->SR & SPI_SR_RX_NOT_EMPTY) )
+
+        if (u32Recv > u32HeaderNum)
+            pu8Data[u32Recv - u32HeaderNum - 1] = (uint8_t)( pSpi->DR[0] & 0xFF );
+        else
+            u32Temp = pSpi->DR[0];  // dummy
+
+        u32Recv++;
+    }
+
+    return 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  _Hal_Flash_ReadAbort
+*
+* DESCRIPTION:
+*   1. Close a transaction that timed out: raise CS and drop the RX FIFO
+*
+* CALLS
+*
+* PARAMETERS
+*   1. pSpi         : SPI registers
+*
+* RETURNS
+*   None
+* 
+* GLOBALS AFFECTED
+* 
+*************************************************************************/
+static void _Hal_Flash_ReadAbort(S_Spi_Reg_t *pSpi)
+{
+    uint32_t u32Temp = 0;
+    uint32_t u32TimeOut;
+
+    pSpi->DR[0] = TAG_DFS_08 | TAG_CS_COMP | TAG_1_BIT | TAG_READ | DUMMY;
+
+    for (u32TimeOut = 0; u32TimeOut <= SPI_TIMEOUT; u32TimeOut++)
+    {
+        if (pSpi->SR & SPI_SR_RX_NOT_EMPTY)
         {
-            // Wait for RX not Empty...
-            
-            //Time-out check
-            if( u32TimeOut > SPI_TIMEOUT )
-                return 1;
-            u32TimeOut++;
+            u32Temp = pSpi->DR[0];  // dummy
+            u32TimeOut = 0;
         }
-        pu8Data[u32Idx+2] = (uint8_t)( pSpi->DR[0] & 0xFF );
-        
-        u32TimeOut = 0;
-        while( !(pSpi->SR & SPI_SR_RX_NOT_EMPTY) )
+        else if (pSpi->TXFLR == 0)
         {
-            // Wait for RX not Empty...
-            
-            //Time-out check
-            if( u32TimeOut > SPI_TIMEOUT )
-                return 1;
-            u32TimeOut++;
+            break;
         }
-        pu8Data[u32Idx+3] = (uint8_t)( pSpi->DR[0] & 0xFF );
     }
 
-    // the rest data
-    for (i=u32Idx; i<u32Size; i++)
+    (void)u32Temp;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_Init_Internal
+*
+* DESCRIPTION:
+*   1. Identify the part and enable the quad mode (ROM)
+*   2. Check once whether quad I/O reads give the right data, see
+*      _Hal_Flash_QuadIoCheck
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx      : Index of SPI. refert to E_SpiIdx_t
+*
+* RETURNS
+*   0: setting complete
+*   1: error 
+* 
+* GLOBALS AFFECTED
+* 
+*************************************************************************/
+uint32_t Hal_Flash_Init_Internal_patch(E_SpiIdx_t u32SpiIdx)
+{
+    if (0 != Hal_Flash_Init_Internal_impl(u32SpiIdx))
+        return 1;
+
+    if (u32SpiIdx == SPI_IDX_0)
+        g_u8aHalFlashQuadIo[u32SpiIdx] = _Hal_Flash_QuadIoCheck(u32SpiIdx);
+
+    return 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_AddrRead
+*
+* DESCRIPTION:
+*   1. Read n bytes from the start address
+*   2. The read is split into transactions at HAL_FLASH_READ_CHUNK
+*      boundaries, each streamed with the mode given by
+*      Hal_Flash_ReadModeGet()
+*   3. A transaction that times out in a quad mode is done again in
+*      single-bit mode, and in AUTO mode quad I/O is not used on the part
+*      any more. Wrong data is not seen here: AUTO only picks quad I/O after
+*      _Hal_Flash_QuadIoCheck has compared it with a single-bit read
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx      : Index of SPI. refert to E_SpiIdx_t
+*   2. u32StartAddr : Start address
+*   3. u8UseQuadMode: Qaud-mode select. 1 for enable/0 for disable
+*   4. u32Size      : Data size
+*   5. pu8Data      : Data buffer
+*
+* RETURNS
+*   0: setting complete
+*   1: error 
+* 
+* GLOBALS AFFECTED
+* 
+*************************************************************************/
+uint32_t Hal_Flash_AddrRead_Internal_patch(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data)
+{
+    S_Spi_Reg_t *pSpi = 0;
+    E_FlashReadMode_t eMode;
+    uint32_t u32DataSize = 0;
+
+    if (u32SpiIdx == SPI_IDX_0)
+	{
+        pSpi = SPI_0;
+	}
+    else if (u32SpiIdx == SPI_IDX_1)
     {
-        if (i != (u32Size-1))
-            u32Temp = TAG_DFS_08 | TAG_CS_CONT | u32QuadBit | TAG_READ | DUMMY;
-        else
-            u32Temp = TAG_DFS_08 | TAG_CS_COMP | u32QuadBit | TAG_READ | DUMMY; // complete
-        pSpi->DR[0] = u32Temp;
+        pSpi = SPI_1;
     }
-    for (i=u32Idx; i<u32Size; i++)
+    else if (u32SpiIdx == SPI_IDX_2)
     {
-        u32TimeOut = 0;
-        while( !(pSpi->SR & SPI_SR_RX_NOT_EMPTY) )
+        pSpi = SPI_2;
+    }
+    else
+    {
+        return 1;
+    }
+
+    if (g_u8aHalFlashID[u32SpiIdx] == NO_FLASH)
+        return 1;
+    
+    if ((u32Size == 0) || (pu8Data == NULL))
+        return 1;
+
+    eMode = Hal_Flash_ReadModeGet(u32SpiIdx, u8UseQuadMode);
+
+    g_taHalFlashReadStat[u32SpiIdx].u32Reads++;
+
+    while (u32Size > 0)
+    {
+        u32DataSize = HAL_FLASH_READ_CHUNK - (u32StartAddr & (HAL_FLASH_READ_CHUNK - 1));
+        if (u32DataSize > u32Size)
+            u32DataSize = u32Size;
+
+        if (0 != _Hal_Flash_ReadStream(pSpi, u32StartAddr, eMode, u32DataSize, pu8Data))
         {
-            // Wait for RX not Empty...
-            
-            //Time-out check
-            if( u32TimeOut > SPI_TIMEOUT )
+            _Hal_Flash_ReadAbort(pSpi);
+
+            if (eMode == HAL_FLASH_READ_MODE_FAST)
                 return 1;
-            u32TimeOut++;
+
+            if (g_u8aHalFlashReadMode[u32SpiIdx] == HAL_FLASH_READ_MODE_AUTO)
+                g_u8aHalFlashQuadIo[u32SpiIdx] = HAL_FLASH_QUAD_IO_OFF;
+
+            g_taHalFlashReadStat[u32SpiIdx].u32Fallback++;
+            eMode = HAL_FLASH_READ_MODE_FAST;
+            continue;
         }
-        pu8Data[i] = (uint8_t)( pSpi->DR[0] & 0xFF );
+
+        g_taHalFlashReadStat[u32SpiIdx].u32Bytes += u32DataSize;
+        if (eMode == HAL_FLASH_READ_MODE_QUAD_IO)
+            g_taHalFlashReadStat[u32SpiIdx].u32QuadIoBytes += u32DataSize;
+
+        u32StartAddr += u32DataSize;
+        pu8Data += u32DataSize;
+        u32Size -= u32DataSize;
     }
 
     return 0;
 }
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_ReadModeSet
+*
+* DESCRIPTION:
+*   1. Select the read mode used by Hal_Flash_AddrRead
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx      : Index of SPI. refert to E_SpiIdx_t
+*   2. eMode        : Read mode. refer to E_FlashReadMode_t
+*
+* RETURNS
+*   None
+* 
+* GLOBALS AFFECTED
+* 
+*************************************************************************/
+void Hal_Flash_ReadModeSet(E_SpiIdx_t u32SpiIdx, E_FlashReadMode_t eMode)
+{
+    if ((u32SpiIdx >= SPI_IDX_MAX) || (eMode >= HAL_FLASH_READ_MODE_MAX))
+        return;
+
+    g_u8aHalFlashReadMode[u32SpiIdx] = eMode;
+
+    // check the part again on the next read
+    g_u8aHalFlashQuadIo[u32SpiIdx] = HAL_FLASH_QUAD_IO_UNKNOWN;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_ReadModeGet
+*
+* DESCRIPTION:
+*   1. Get the read mode used for a read request
+*   2. AUTO picks quad I/O on SPI_IDX_0 only, once _Hal_Flash_QuadIoCheck
+*      has passed. On the other ports the part is not known and the request
+*      (u8UseQuadMode) is followed, as the ROM driver does
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx      : Index of SPI. refert to E_SpiIdx_t
+*   2. u8UseQuadMode: Qaud-mode select of the request
+*
+* RETURNS
+*   refer to E_FlashReadMode_t (never AUTO)
+* 
+* GLOBALS AFFECTED
+* 
+*************************************************************************/
+E_FlashReadMode_t Hal_Flash_ReadModeGet(E_SpiIdx_t u32SpiIdx, uint8_t u8UseQuadMode)
+{
+    if (u32SpiIdx >= SPI_IDX_MAX)
+        return HAL_FLASH_READ_MODE_FAST;
+
+    if (g_u8aHalFlashReadMode[u32SpiIdx] != HAL_FLASH_READ_MODE_AUTO)
+        return (E_FlashReadMode_t)g_u8aHalFlashReadMode[u32SpiIdx];
+
+    if (u32SpiIdx != SPI_IDX_0)
+        return (u8UseQuadMode) ? HAL_FLASH_READ_MODE_QUAD_OUT : HAL_FLASH_READ_MODE_FAST;
+
+    // checked by the init, again after Hal_Flash_ReadModeSet
+    if (g_u8aHalFlashQuadIo[u32SpiIdx] == HAL_FLASH_QUAD_IO_UNKNOWN)
+        g_u8aHalFlashQuadIo[u32SpiIdx] = _Hal_Flash_QuadIoCheck(u32SpiIdx);
+
+    if (g_u8aHalFlashQuadIo[u32SpiIdx] == HAL_FLASH_QUAD_IO_ON)
+        return HAL_FLASH_READ_MODE_QUAD_IO;
+
+    if (u8UseQuadMode)
+        return HAL_FLASH_READ_MODE_QUAD_OUT;
+
+    return HAL_FLASH_READ_MODE_FAST;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_ReadStatGet
+*
+* DESCRIPTION:
+*   1. Get the read statistics
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx      : Index of SPI. refert to E_SpiIdx_t
+*   2. ptStat       : [OUT] statistics
+*
+* RETURNS
+*   None
+* 
+* GLOBALS AFFECTED
+* 
+*************************************************************************/
+void Hal_Flash_ReadStatGet(E_SpiIdx_t u32SpiIdx, S_FlashReadStat_t *ptStat)
+{
+    if (u32SpiIdx >= SPI_IDX_MAX)
+        return;
+
+    *ptStat = g_taHalFlashReadStat[u32SpiIdx];
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_ReadStatReset
+*
+* DESCRIPTION:
+*   1. Clear the read statistics
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx      : Index of SPI. refert to E_SpiIdx_t
+*
+* RETURNS
+*   None
+* 
+* GLOBALS AFFECTED
+* 
+*************************************************************************/
+void Hal_Flash_ReadStatReset(E_SpiIdx_t u32SpiIdx)
+{
+    if (u32SpiIdx >= SPI_IDX_MAX)
+        return;
+
+    memset(&g_taHalFlashReadStat[u32SpiIdx], 0, sizeof(S_FlashReadStat_t));
+}
@@ -39,11 +39,30 @@ Head Block of The File
 #include "hal_flash.h"
 
 // Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+// reads are split into transactions at this boundary (one flash page)
+#define HAL_FLASH_READ_CHUNK        256
 
 /********************************************
 Declaration of data structure
 ********************************************/
 // Sec 3: structure, uniou, enum, linked list...
+typedef enum
+{
+    HAL_FLASH_READ_MODE_AUTO,       // SPI_IDX_0: quad I/O (0xEB) if checked at init, otherwise and other ports: as requested by the caller
+    HAL_FLASH_READ_MODE_FAST,       // 0x0B, 1-1-1
+    HAL_FLASH_READ_MODE_QUAD_OUT,   // 0x6B, 1-1-4
+    HAL_FLASH_READ_MODE_QUAD_IO,    // 0xEB, 1-4-4
+
+    HAL_FLASH_READ_MODE_MAX
+} E_FlashReadMode_t;
+
+typedef struct
+{
+    uint32_t u32Reads;
+    uint32_t u32Bytes;
+    uint32_t u32QuadIoBytes;        // bytes read with 0xEB
+    uint32_t u32Fallback;           // transactions retried in single-bit mode after a quad read timed out
+} S_FlashReadStat_t;
 
 /********************************************
 Declaration of Global Variables & Functions
@@ -51,9 +70,15 @@ Declaration of Global Variables & Functions
 // Sec 4: declaration of global  variable
 
 // Sec 5: declaration of global function prototype
+extern uint32_t Hal_Flash_Init_Internal_patch(E_SpiIdx_t u32SpiIdx);
 extern uint32_t Hal_Flash_AddrProgram_Internal_patch(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data);
 extern uint32_t Hal_Flash_AddrRead_Internal_patch(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data);
 
+void Hal_Flash_ReadModeSet(E_SpiIdx_t u32SpiIdx, E_FlashReadMode_t eMode);
+E_FlashReadMode_t Hal_Flash_ReadModeGet(E_SpiIdx_t u32SpiIdx, uint8_t u8UseQuadMode);
+void Hal_Flash_ReadStatGet(E_SpiIdx_t u32SpiIdx, S_FlashReadStat_t *ptStat);
+void Hal_Flash_ReadStatReset(E_SpiIdx_t u32SpiIdx);
+
 /***************************************************
 Declaration of static Global Variables &  Functions
 ***************************************************/
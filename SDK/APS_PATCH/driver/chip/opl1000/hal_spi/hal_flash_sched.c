@@ -0,0 +1,618 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_flash_sched.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This source file defines the background erase and the operation latency
+*  statistics of the SPI0 flash.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <string.h>
+#include "cmsis_os.h"
+#include "hal_spi.h"
+#include "hal_tick.h"
+#include "hal_flash.h"
+#include "hal_flash_internal.h"
+#include "hal_flash_cache.h"
+#include "hal_flash_sched.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HAL_FLASH_SCHED_ADDR_NONE       0xFFFFFFFF
+
+#define HAL_FLASH_SCHED_STATUS_WIP      0x01
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+extern osSemaphoreId g_taHalFlashSemaphoreId[SPI_IDX_MAX];
+extern uint8_t g_u8aHalFlashID[SPI_IDX_MAX];
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+static uint32_t g_u32HalFlashSchedEraseAddr = HAL_FLASH_SCHED_ADDR_NONE;   // background erase in flight
+static uint32_t g_u32HalFlashSchedEraseTick;
+static uint32_t g_u32HalFlashSchedSuspendCnt;
+static uint8_t g_u8HalFlashSchedSuspended;                                  // a read is between suspend and resume
+static S_FlashSchedStat_t g_tHalFlashSchedStat;
+
+// the functions below the scheduler
+static T_Hal_Flash_AddrRead_Internal          g_tHalFlashSchedRead;
+static T_Hal_Flash_PageAddrRead_Internal      g_tHalFlashSchedPageRead;
+static T_Hal_Flash_AddrProgram_Internal       g_tHalFlashSchedProgram;
+static T_Hal_Flash_PageAddrProgram_Internal   g_tHalFlashSchedPageProgram;
+static T_Hal_Flash_4KSectorAddrErase_Internal g_tHalFlashSchedErase;
+static T_Hal_Flash_Reset_Internal             g_tHalFlashSchedReset;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static uint32_t _Hal_Flash_SchedTick(void)
+{
+    uint32_t u32Tick = 0;
+
+    Hal_Tick_DiffEx(0, &u32Tick);
+    return u32Tick;
+}
+
+static void _Hal_Flash_SchedLatency(E_FlashOp_t eOp, uint32_t u32StartTick)
+{
+    S_FlashOpStat_t *ptOp = &g_tHalFlashSchedStat.taOp[eOp];
+    uint32_t u32Us;
+    uint32_t u32Val;
+    uint32_t i = 0;
+
+    u32Us = (uint32_t)(((uint64_t)Hal_Tick_Diff(u32StartTick) * 1000) / Hal_Tick_PerMilliSec());
+
+    u32Val = u32Us / HAL_FLASH_SCHED_HIST_BASE;
+    while ((u32Val > 0) && (i < (HAL_FLASH_SCHED_HIST_NUM - 1)))
+    {
+        u32Val >>= 1;
+        i++;
+    }
+
+    ptOp->u32Count++;
+    ptOp->u32TotalUs += u32Us;
+    if (u32Us > ptOp->u32MaxUs)
+        ptOp->u32MaxUs = u32Us;
+    ptOp->u32aHist[i]++;
+}
+
+static void _Hal_Flash_SchedCmd(uint8_t u8Cmd)
+{
+    uint32_t u32Temp = TAG_DFS_08 | TAG_CS_COMP | TAG_1_BIT | TAG_WRITE | u8Cmd;  // complete
+
+    Hal_Spi_Data_Send(SPI_IDX_0, u32Temp);
+    Hal_Spi_Data_Recv(SPI_IDX_0, &u32Temp); // dummy
+}
+
+// the caller holds the flash semaphore
+static void _Hal_Flash_SchedEraseDone(void)
+{
+    _Hal_Flash_SchedLatency(HAL_FLASH_OP_ERASE_BG, g_u32HalFlashSchedEraseTick);
+    g_u32HalFlashSchedEraseAddr = HAL_FLASH_SCHED_ADDR_NONE;
+}
+
+static void _Hal_Flash_SchedEraseFinish(void)
+{
+    if (g_u32HalFlashSchedEraseAddr == HAL_FLASH_SCHED_ADDR_NONE)
+        return;
+
+    g_tHalFlashSchedStat.u32EraseWait++;
+    _Hal_Flash_WriteDoneCheck(SPI_IDX_0);
+    _Hal_Flash_SchedEraseDone();
+}
+
+static uint8_t _Hal_Flash_SchedSuspendCmd(uint8_t *pu8Suspend, uint8_t *pu8Resume)
+{
+    if (g_u8aHalFlashID[SPI_IDX_0] == MACRONIX_ID)
+    {
+        *pu8Suspend = 0xB0;
+        *pu8Resume = 0x30;
+    }
+    else if ((g_u8aHalFlashID[SPI_IDX_0] == GIGADEVICE_ID) || (g_u8aHalFlashID[SPI_IDX_0] == WINBOND_NEX_ID))
+    {
+        *pu8Suspend = 0x75;
+        *pu8Resume = 0x7A;
+    }
+    else
+    {
+        return 0;
+    }
+
+    return 1;
+}
+
+// the flash is idle or the background erase is suspended when it returns 1
+static uint8_t _Hal_Flash_SchedReadBegin(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint32_t u32Size)
+{
+    uint32_t u32SecAddr = g_u32HalFlashSchedEraseAddr;
+    uint8_t u8Suspend;
+    uint8_t u8Resume;
+
+    if ((u32SpiIdx != SPI_IDX_0) || (u32SecAddr == HAL_FLASH_SCHED_ADDR_NONE))
+        return 0;
+
+    // the sector being erased: wait for the final content
+    if ((u32StartAddr < (u32SecAddr + 0x1000)) && (u32SecAddr < (u32StartAddr + u32Size)))
+    {
+        _Hal_Flash_SchedEraseFinish();
+        return 0;
+    }
+
+    if ((g_u32HalFlashSchedSuspendCnt >= HAL_FLASH_SCHED_SUSPEND_MAX) || (!_Hal_Flash_SchedSuspendCmd(&u8Suspend, &u8Resume)))
+    {
+        g_tHalFlashSchedStat.u32SuspendSkip++;
+        _Hal_Flash_SchedEraseFinish();
+        return 0;
+    }
+
+    // ignored by the flash if the erase is already done
+    _Hal_Flash_SchedCmd(u8Suspend);
+    _Hal_Flash_WriteDoneCheck(SPI_IDX_0);
+
+    g_u8HalFlashSchedSuspended = 1;
+    g_u32HalFlashSchedSuspendCnt++;
+    g_tHalFlashSchedStat.u32Suspend++;
+    return 1;
+}
+
+static void _Hal_Flash_SchedReadEnd(uint8_t u8Suspended, uint32_t u32StartTick)
+{
+    uint8_t u8Suspend = 0;
+    uint8_t u8Resume = 0;
+
+    if (!u8Suspended)
+    {
+        _Hal_Flash_SchedLatency(HAL_FLASH_OP_READ, u32StartTick);
+        return;
+    }
+
+    _Hal_Flash_SchedSuspendCmd(&u8Suspend, &u8Resume);
+    _Hal_Flash_SchedCmd(u8Resume);
+    g_u8HalFlashSchedSuspended = 0;
+
+    _Hal_Flash_SchedLatency(HAL_FLASH_OP_SUSPEND, u32StartTick);
+}
+
+static uint32_t Hal_Flash_AddrRead_Internal_sched(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data)
+{
+    uint32_t u32StartTick = _Hal_Flash_SchedTick();
+    uint32_t u32Ret;
+    uint8_t u8Suspended;
+
+    u8Suspended = _Hal_Flash_SchedReadBegin(u32SpiIdx, u32StartAddr, u32Size);
+    u32Ret = g_tHalFlashSchedRead(u32SpiIdx, u32StartAddr, u8UseQuadMode, u32Size, pu8Data);
+
+    if (u32SpiIdx == SPI_IDX_0)
+        _Hal_Flash_SchedReadEnd(u8Suspended, u32StartTick);
+
+    return u32Ret;
+}
+
+static uint32_t Hal_Flash_PageAddrRead_Internal_sched(E_SpiIdx_t u32SpiIdx, uint32_t u32PageAddr, uint8_t u8UseQuadMode, uint8_t *pu8Data)
+{
+    uint32_t u32StartTick = _Hal_Flash_SchedTick();
+    uint32_t u32Ret;
+    uint8_t u8Suspended;
+
+    u8Suspended = _Hal_Flash_SchedReadBegin(u32SpiIdx, u32PageAddr & ~0xFF, 0x100);
+    u32Ret = g_tHalFlashSchedPageRead(u32SpiIdx, u32PageAddr, u8UseQuadMode, pu8Data);
+
+    if (u32SpiIdx == SPI_IDX_0)
+        _Hal_Flash_SchedReadEnd(u8Suspended, u32StartTick);
+
+    return u32Ret;
+}
+
+static uint32_t Hal_Flash_AddrProgram_Internal_sched(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data)
+{
+    uint32_t u32StartTick;
+    uint32_t u32Ret;
+
+    if (u32SpiIdx != SPI_IDX_0)
+        return g_tHalFlashSchedProgram(u32SpiIdx, u32StartAddr, u8UseQuadMode, u32Size, pu8Data);
+
+    _Hal_Flash_SchedEraseFinish();
+
+    u32StartTick = _Hal_Flash_SchedTick();
+    u32Ret = g_tHalFlashSchedProgram(u32SpiIdx, u32StartAddr, u8UseQuadMode, u32Size, pu8Data);
+    _Hal_Flash_SchedLatency(HAL_FLASH_OP_PROGRAM, u32StartTick);
+
+    return u32Ret;
+}
+
+static uint32_t Hal_Flash_PageAddrProgram_Internal_sched(E_SpiIdx_t u32SpiIdx, uint32_t u32PageAddr, uint8_t u8UseQuadMode, uint8_t *pu8Data)
+{
+    uint32_t u32StartTick;
+    uint32_t u32Ret;
+
+    if (u32SpiIdx != SPI_IDX_0)
+        return g_tHalFlashSchedPageProgram(u32SpiIdx, u32PageAddr, u8UseQuadMode, pu8Data);
+
+    _Hal_Flash_SchedEraseFinish();
+
+    u32StartTick = _Hal_Flash_SchedTick();
+    u32Ret = g_tHalFlashSchedPageProgram(u32SpiIdx, u32PageAddr, u8UseQuadMode, pu8Data);
+    _Hal_Flash_SchedLatency(HAL_FLASH_OP_PROGRAM, u32StartTick);
+
+    return u32Ret;
+}
+
+static uint32_t Hal_Flash_4KSectorAddrErase_Internal_sched(E_SpiIdx_t u32SpiIdx, uint32_t u32SecAddr)
+{
+    uint32_t u32StartTick;
+    uint32_t u32Ret;
+
+    if (u32SpiIdx != SPI_IDX_0)
+        return g_tHalFlashSchedErase(u32SpiIdx, u32SecAddr);
+
+    _Hal_Flash_SchedEraseFinish();
+
+    u32StartTick = _Hal_Flash_SchedTick();
+    u32Ret = g_tHalFlashSchedErase(u32SpiIdx, u32SecAddr);
+    _Hal_Flash_SchedLatency(HAL_FLASH_OP_ERASE, u32StartTick);
+
+    return u32Ret;
+}
+
+static void Hal_Flash_Reset_Internal_sched(E_SpiIdx_t u32SpiIdx)
+{
+    if (u32SpiIdx == SPI_IDX_0)
+        _Hal_Flash_SchedEraseFinish();
+
+    g_tHalFlashSchedReset(u32SpiIdx);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_SchedInit
+*
+* DESCRIPTION:
+*   1. Put the scheduler in front of the current *_Internal flash functions.
+*      Call once, after the flash patch functions are set and before
+*      Hal_Flash_CacheInit, so that cache hits are not counted as reads.
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_Flash_SchedInit(void)
+{
+    if (g_tHalFlashSchedRead)
+        return;
+
+    memset(&g_tHalFlashSchedStat, 0, sizeof(g_tHalFlashSchedStat));
+    g_u32HalFlashSchedEraseAddr = HAL_FLASH_SCHED_ADDR_NONE;
+
+    g_tHalFlashSchedRead        = Hal_Flash_AddrRead_Internal;
+    g_tHalFlashSchedPageRead    = Hal_Flash_PageAddrRead_Internal;
+    g_tHalFlashSchedProgram     = Hal_Flash_AddrProgram_Internal;
+    g_tHalFlashSchedPageProgram = Hal_Flash_PageAddrProgram_Internal;
+    g_tHalFlashSchedErase       = Hal_Flash_4KSectorAddrErase_Internal;
+    g_tHalFlashSchedReset       = Hal_Flash_Reset_Internal;
+
+    Hal_Flash_AddrRead_Internal          = Hal_Flash_AddrRead_Internal_sched;
+    Hal_Flash_PageAddrRead_Internal      = Hal_Flash_PageAddrRead_Internal_sched;
+    Hal_Flash_AddrProgram_Internal       = Hal_Flash_AddrProgram_Internal_sched;
+    Hal_Flash_PageAddrProgram_Internal   = Hal_Flash_PageAddrProgram_Internal_sched;
+    Hal_Flash_4KSectorAddrErase_Internal = Hal_Flash_4KSectorAddrErase_Internal_sched;
+    Hal_Flash_Reset_Internal             = Hal_Flash_Reset_Internal_sched;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_EraseStart
+*
+* DESCRIPTION:
+*   1. Start to erase a sector (4 KB) and return without waiting for it.
+*      Only one background erase is in flight, use Hal_Flash_EraseBusy to
+*      know when it is done.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx    : Index of SPI. Only SPI_IDX_0
+*   2. u32SecAddr : Address of sector
+*
+* RETURNS
+*   0: setting complete
+*   1: error, or another background erase is in flight
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Hal_Flash_EraseStart(E_SpiIdx_t u32SpiIdx, uint32_t u32SecAddr)
+{
+    uint32_t u32Temp = 0;
+    uint32_t u32Addr = 0;
+    uint32_t u32Ret = 1;
+
+    if ((u32SpiIdx != SPI_IDX_0) || (!g_tHalFlashSchedRead))
+        return 1;
+
+    if (g_u8aHalFlashID[u32SpiIdx] == NO_FLASH)
+        return 1;
+
+    // wait the semaphore
+    osSemaphoreWait(g_taHalFlashSemaphoreId[u32SpiIdx], osWaitForever);
+
+    if (g_u32HalFlashSchedEraseAddr != HAL_FLASH_SCHED_ADDR_NONE)
+        goto done;
+
+    u32Addr = u32SecAddr & ~0xFFF; // aligned
+
+    _Hal_Flash_WriteEn(u32SpiIdx);
+
+    // Cmd
+    u32Temp = TAG_DFS_08 | TAG_CS_CONT | TAG_1_BIT | TAG_WRITE | 0x20;
+    Hal_Spi_Data_Send(u32SpiIdx, u32Temp);
+
+    // Addr
+    u32Temp = TAG_DFS_08 | TAG_CS_CONT | TAG_1_BIT | TAG_WRITE | ( (u32Addr>>16) & 0xFF );
+    Hal_Spi_Data_Send(u32SpiIdx, u32Temp);
+    u32Temp = TAG_DFS_08 | TAG_CS_CONT | TAG_1_BIT | TAG_WRITE | ( (u32Addr>>8) & 0xFF );
+    Hal_Spi_Data_Send(u32SpiIdx, u32Temp);
+    u32Temp = TAG_DFS_08 | TAG_CS_COMP | TAG_1_BIT | TAG_WRITE | (u32Addr & 0xFF); // Complete
+    Hal_Spi_Data_Send(u32SpiIdx, u32Temp);
+
+    Hal_Spi_Data_Recv(u32SpiIdx, &u32Temp); // dummy
+    Hal_Spi_Data_Recv(u32SpiIdx, &u32Temp); // dummy
+    Hal_Spi_Data_Recv(u32SpiIdx, &u32Temp); // dummy
+    Hal_Spi_Data_Recv(u32SpiIdx, &u32Temp); // dummy
+
+    g_u32HalFlashSchedEraseAddr = u32Addr;
+    g_u32HalFlashSchedEraseTick = _Hal_Flash_SchedTick();
+    g_u32HalFlashSchedSuspendCnt = 0;
+
+    // lines cached before the erase, dropped before any reader can refill
+    // them; later fills wait for the erase to end
+    Hal_Flash_CacheInvalidate_Internal(u32Addr, 0x1000);
+
+    u32Ret = 0;
+
+done:
+    // release the semaphore
+    osSemaphoreRelease(g_taHalFlashSemaphoreId[u32SpiIdx]);
+
+    return u32Ret;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_EraseBusy
+*
+* DESCRIPTION:
+*   1. Check if the background erase is still running
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx    : Index of SPI. Only SPI_IDX_0
+*
+* RETURNS
+*   1: busy
+*   0: idle
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint8_t Hal_Flash_EraseBusy(E_SpiIdx_t u32SpiIdx)
+{
+    uint32_t u32Status_0 = 0;
+    uint32_t u32Status_1 = 0;
+    uint8_t u8Busy = 0;
+
+    if ((u32SpiIdx != SPI_IDX_0) || (g_u32HalFlashSchedEraseAddr == HAL_FLASH_SCHED_ADDR_NONE))
+        return 0;
+
+    osSemaphoreWait(g_taHalFlashSemaphoreId[u32SpiIdx], osWaitForever);
+
+    if (g_u32HalFlashSchedEraseAddr != HAL_FLASH_SCHED_ADDR_NONE)
+    {
+        if ((0 == _Hal_Flash_StatusGet(u32SpiIdx, &u32Status_0, &u32Status_1)) && (!(u32Status_0 & HAL_FLASH_SCHED_STATUS_WIP)))
+            _Hal_Flash_SchedEraseDone();
+        else
+            u8Busy = 1;
+    }
+
+    osSemaphoreRelease(g_taHalFlashSemaphoreId[u32SpiIdx]);
+    return u8Busy;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_EraseWait
+*
+* DESCRIPTION:
+*   1. Wait until the background erase is done
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx    : Index of SPI. Only SPI_IDX_0
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_Flash_EraseWait(E_SpiIdx_t u32SpiIdx)
+{
+    if ((u32SpiIdx != SPI_IDX_0) || (g_u32HalFlashSchedEraseAddr == HAL_FLASH_SCHED_ADDR_NONE))
+        return;
+
+    osSemaphoreWait(g_taHalFlashSemaphoreId[u32SpiIdx], osWaitForever);
+    _Hal_Flash_SchedEraseFinish();
+    osSemaphoreRelease(g_taHalFlashSemaphoreId[u32SpiIdx]);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_WipWait
+*
+* DESCRIPTION:
+*   1. Poll WIP until it clears or u32Ms has passed, without the semaphore.
+*      One _Hal_Flash_WriteDoneCheck gives up after its poll count, before
+*      a slow part ends a 4KB erase.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx    : Index of SPI. refert to E_SpiIdx_t
+*   2. u32Ms      : the longest wait
+*
+* RETURNS
+*   0: not busy
+*   1: still busy
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Hal_Flash_WipWait(E_SpiIdx_t u32SpiIdx, uint32_t u32Ms)
+{
+    uint32_t u32StartTick = _Hal_Flash_SchedTick();
+    uint32_t u32Ret;
+
+    do
+    {
+        u32Ret = _Hal_Flash_WriteDoneCheck(u32SpiIdx);
+    } while ((u32Ret) && ((Hal_Tick_Diff(u32StartTick) / Hal_Tick_PerMilliSec()) < u32Ms));
+
+    return u32Ret;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_EraseSettle
+*
+* DESCRIPTION:
+*   1. Let the background erase end without the semaphore, for the crash
+*      capture: the interrupts are disabled and the owner of the semaphore
+*      may be the task that faulted. An erase suspended by a read is
+*      resumed first, then WIP is polled for HAL_FLASH_SCHED_SETTLE_MS.
+*   2. The erase is forgotten in both cases. If it did not end, the next
+*      reset of the flash aborts it and the sector is left partly erased,
+*      like after a power cut in the middle of the erase.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx    : Index of SPI. Only SPI_IDX_0
+*
+* RETURNS
+*   0: no background erase, or it ended
+*   1: still busy, it will be aborted
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Hal_Flash_EraseSettle(E_SpiIdx_t u32SpiIdx)
+{
+    uint32_t u32Ret;
+    uint8_t u8Suspend;
+    uint8_t u8Resume;
+
+    if ((u32SpiIdx != SPI_IDX_0) || (g_u32HalFlashSchedEraseAddr == HAL_FLASH_SCHED_ADDR_NONE))
+        return 0;
+
+    if ((g_u8HalFlashSchedSuspended) && (_Hal_Flash_SchedSuspendCmd(&u8Suspend, &u8Resume)))
+        _Hal_Flash_SchedCmd(u8Resume);
+
+    u32Ret = Hal_Flash_WipWait(SPI_IDX_0, HAL_FLASH_SCHED_SETTLE_MS);
+
+    g_u8HalFlashSchedSuspended = 0;
+    g_u32HalFlashSchedEraseAddr = HAL_FLASH_SCHED_ADDR_NONE;
+
+    return u32Ret;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_SchedStatGet
+*
+* DESCRIPTION:
+*   1. Get the latency statistics
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptStat       : [OUT] statistics
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_Flash_SchedStatGet(S_FlashSchedStat_t *ptStat)
+{
+    *ptStat = g_tHalFlashSchedStat;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Flash_SchedStatReset
+*
+* DESCRIPTION:
+*   1. Clear the latency statistics
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_Flash_SchedStatReset(void)
+{
+    memset(&g_tHalFlashSchedStat, 0, sizeof(g_tHalFlashSchedStat));
+}
@@ -0,0 +1,123 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_flash_sched.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This include file defines the background erase and the operation latency
+*  statistics of the SPI0 flash.
+*
+*  Hal_Flash_EraseStart() issues a sector erase and returns at once, the
+*  flash semaphore is not held while the erase runs. A read arriving in the
+*  meantime suspends the erase, reads and resumes it (at most
+*  HAL_FLASH_SCHED_SUSPEND_MAX times per erase, then the read waits the
+*  erase out). A program, erase or reset waits the erase out first. A read
+*  of the sector being erased also waits, so it never sees half-erased data.
+*
+*  Hal_Flash_EraseSettle() ends the background erase without the semaphore,
+*  for the crash capture that resets the flash before it writes its record;
+*  Hal_Flash_WipWait() waits out a slow erase the same way.
+*
+*  Every *_Internal operation is timed into a log2 histogram, the first
+*  bucket is below HAL_FLASH_SCHED_HIST_BASE us.
+*
+******************************************************************************/
+
+#ifndef __HAL_FLASH_SCHED_H__
+#define __HAL_FLASH_SCHED_H__
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include "hal_flash.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#ifndef HAL_FLASH_SCHED_SUSPEND_MAX
+#define HAL_FLASH_SCHED_SUSPEND_MAX     8       // suspends per erase, 0: never suspend
+#endif
+
+#ifndef HAL_FLASH_SCHED_SETTLE_MS
+#define HAL_FLASH_SCHED_SETTLE_MS       500     // above the longest 4KB erase of the parts (400 ms)
+#endif
+
+#define HAL_FLASH_SCHED_HIST_NUM        16
+#define HAL_FLASH_SCHED_HIST_BASE       32      // us
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef enum
+{
+    HAL_FLASH_OP_READ = 0,
+    HAL_FLASH_OP_PROGRAM,
+    HAL_FLASH_OP_ERASE,             // erase in the caller's context
+    HAL_FLASH_OP_ERASE_BG,          // from Hal_Flash_EraseStart to the end of the erase
+    HAL_FLASH_OP_SUSPEND,           // read including suspend and resume
+
+    HAL_FLASH_OP_MAX
+} E_FlashOp_t;
+
+typedef struct
+{
+    uint32_t u32Count;
+    uint32_t u32TotalUs;
+    uint32_t u32MaxUs;
+    uint32_t u32aHist[HAL_FLASH_SCHED_HIST_NUM];
+} S_FlashOpStat_t;
+
+typedef struct
+{
+    S_FlashOpStat_t taOp[HAL_FLASH_OP_MAX];
+    uint32_t u32Suspend;            // erases suspended for a read
+    uint32_t u32SuspendSkip;        // reads that waited, the suspend budget was used up
+    uint32_t u32EraseWait;          // operations that waited for the background erase
+} S_FlashSchedStat_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+void Hal_Flash_SchedInit(void);
+uint32_t Hal_Flash_EraseStart(E_SpiIdx_t u32SpiIdx, uint32_t u32SecAddr);
+uint8_t Hal_Flash_EraseBusy(E_SpiIdx_t u32SpiIdx);
+void Hal_Flash_EraseWait(E_SpiIdx_t u32SpiIdx);
+uint32_t Hal_Flash_EraseSettle(E_SpiIdx_t u32SpiIdx);
+uint32_t Hal_Flash_WipWait(E_SpiIdx_t u32SpiIdx, uint32_t u32Ms);
+void Hal_Flash_SchedStatGet(S_FlashSchedStat_t *ptStat);
+void Hal_Flash_SchedStatReset(void);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+#endif
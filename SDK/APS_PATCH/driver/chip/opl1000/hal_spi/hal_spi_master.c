@@ -0,0 +1,730 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_spi_master.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This source file defines the queued block transfers of the SPI1/SPI2
+*  master ports.
+*
+*  The DMA engine only moves memory to memory (no peripheral request line),
+*  so a block is pumped through the FIFO by the RX full interrupt: at most
+*  HAL_SPI_MASTER_FIFO_DEPTH frames are in flight, which the RX FIFO can
+*  always hold, and the threshold is set so the refill overlaps the frames
+*  still on the wire.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "hal_vic.h"
+#include "hal_tick.h"
+#include "hal_spi_master.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SPI_1     ((S_Spi_Reg_t *) SPI1_BASE)
+#define SPI_2     ((S_Spi_Reg_t *) SPI2_BASE)
+
+#define SPI_CTL_OPR_MODE_TX_RX       (0<<8)
+#define SPI_CTL_FMT_MOTO             (0<<4)
+
+#define SPI_SSIER_EN                 (1<<0)
+#define SPI_SSIER_TAG                (1<<1)
+
+#define SPI_INT_RX_UNDERFLOW         (1<<2)
+#define SPI_INT_RX_OVERFLOW          (1<<3)
+#define SPI_INT_RX_FULL              (1<<4)
+
+#define HAL_SPI_MASTER_IRQ_SAVE(u32Pm)      do { u32Pm = __get_PRIMASK(); __disable_irq(); } while(0)
+#define HAL_SPI_MASTER_IRQ_RESTORE(u32Pm)   __set_PRIMASK(u32Pm)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    volatile uint32_t CTRLR0;  // 0x00
+	volatile uint32_t CTRLR1;  // 0x04
+	volatile uint32_t SSIENR;  // 0x08
+	volatile uint32_t MWCR;    // 0x0C
+	volatile uint32_t SER;     // 0x10
+	volatile uint32_t BAUDR;   // 0x14
+	volatile uint32_t TXFTLR;  // 0x18
+	volatile uint32_t RXFTLR;  // 0x1C
+	volatile uint32_t TXFLR;   // 0x20
+	volatile uint32_t RXFLR;   // 0x24
+	volatile uint32_t SR;      // 0x28
+	volatile uint32_t IMR;     // 0x2C
+	volatile uint32_t ISR;     // 0x30
+	volatile uint32_t PISR;    // 0x34
+	volatile uint32_t TXOICR;  // 0x38
+	volatile uint32_t RXOICR;  // 0x3C
+	volatile uint32_t RXUICR;  // 0x40
+	volatile uint32_t MSTICR;  // 0x44
+	volatile uint32_t ICR;     // 0x48
+	volatile uint32_t DMACR;   // 0x4C
+	volatile uint32_t DMATDLR; // 0x50
+	volatile uint32_t DMARDLR; // 0x54
+	volatile uint32_t IDR;     // 0x58
+	volatile uint32_t SSI_VER; // 0x5C
+	volatile uint32_t DR[36];  // 0x60 ~ 0xEC
+} S_Spi_Reg_t;
+
+typedef struct
+{
+    S_Spi_Reg_t *pSpi;
+    IRQn_Type eIrq;
+    uint8_t u8Init;
+    const S_SpiDev_t *ptDev;        // the device the port is programmed for
+    S_SpiXfer_t *ptHead;            // the active transfer
+    S_SpiXfer_t *ptTail;
+    uint32_t u32Queued;
+    uint32_t u32InFlight;
+    uint32_t u32Start;
+    osSemaphoreId tLock;            // Hal_Spi_MasterTransfer callers
+    osSemaphoreId tDone;
+    S_SpiMasterStat_t tStat;
+} S_SpiMasterPort_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+static S_SpiMasterPort_t g_taSpiMasterPort[SPI_IDX_MAX];
+
+// Sec 7: declaration of static function prototype
+static void _Hal_Spi_MasterStart(S_SpiMasterPort_t *ptPort);
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static S_SpiMasterPort_t *_Hal_Spi_MasterPortGet(E_SpiIdx_t eSpiIdx)
+{
+    // SPI0 is the flash
+    if ((eSpiIdx != SPI_IDX_1) && (eSpiIdx != SPI_IDX_2))
+        return NULL;
+
+    if (!g_taSpiMasterPort[eSpiIdx].u8Init)
+        return NULL;
+
+    return &g_taSpiMasterPort[eSpiIdx];
+}
+
+static void _Hal_Spi_MasterCsSet(const S_SpiDev_t *ptDev, uint8_t u8Select)
+{
+    if (ptDev->s8CsGpio == HAL_SPI_CS_HW)
+        return;
+
+    Hal_Vic_GpioOutput((E_GpioIdx_t)ptDev->s8CsGpio, (u8Select) ? GPIO_LEVEL_LOW : GPIO_LEVEL_HIGH);
+}
+
+static void _Hal_Spi_MasterConfig(S_SpiMasterPort_t *ptPort, const S_SpiDev_t *ptDev)
+{
+    S_Spi_Reg_t *pSpi = ptPort->pSpi;
+
+    if (ptPort->ptDev == ptDev)
+        return;
+
+    // CTRLR0 and BAUDR are only writable while the port is disabled
+    pSpi->SSIENR = 0;
+    pSpi->CTRLR0 = SPI_CTL_OPR_MODE_TX_RX |
+                   (ptDev->ePolar << 7) |
+                   (ptDev->ePhase << 6) |
+                   SPI_CTL_FMT_MOTO |
+                   (ptDev->eDataSize);
+    Hal_Spi_BaudRateSet(ptDev->eSpiIdx, ptDev->u32Baud);
+    pSpi->SER = 0x0001;
+    pSpi->RXFTLR = 0;
+    pSpi->IMR = 0;
+    pSpi->SSIENR = SPI_SSIER_EN | SPI_SSIER_TAG;
+
+    ptPort->ptDev = ptDev;
+    ptPort->tStat.u32Reconfig++;
+}
+
+static void _Hal_Spi_MasterFill(S_SpiMasterPort_t *ptPort)
+{
+    S_SpiXfer_t *ptXfer = ptPort->ptHead;
+    S_Spi_Reg_t *pSpi = ptPort->pSpi;
+    uint32_t u32Tag = 0;
+    uint32_t u32Data = 0;
+    uint32_t u32Thr = 0;
+    uint8_t u8Is16 = (ptXfer->ptDev->eDataSize == SPI_DFS_16_bit);
+
+    u32Tag = ((u8Is16) ? TAG_DFS_16 : TAG_DFS_08) | TAG_1_BIT;
+
+    while ((ptPort->u32InFlight < HAL_SPI_MASTER_FIFO_DEPTH) && (ptXfer->u32TxIdx < ptXfer->u32Frames))
+    {
+        if (ptXfer->pTxData)
+        {
+            if (u8Is16)
+                u32Data = TAG_WRITE | ((const uint16_t *)ptXfer->pTxData)[ptXfer->u32TxIdx];
+            else
+                u32Data = TAG_WRITE | ((const uint8_t *)ptXfer->pTxData)[ptXfer->u32TxIdx];
+        }
+        else
+        {
+            u32Data = TAG_READ;
+        }
+
+        ptXfer->u32TxIdx++;
+
+        // hardware CS is released after the last frame of the block
+        if ((ptXfer->u32TxIdx == ptXfer->u32Frames) && !(ptXfer->u8Flags & HAL_SPI_XFER_KEEP_CS))
+            u32Data |= TAG_CS_COMP;
+        else
+            u32Data |= TAG_CS_CONT;
+
+        pSpi->DR[0] = u32Tag | u32Data;
+        ptPort->u32InFlight++;
+    }
+
+    // more to send: interrupt at half the frames in flight so the FIFO never runs dry,
+    // otherwise when all of them are back
+    if (ptXfer->u32TxIdx < ptXfer->u32Frames)
+        u32Thr = (ptPort->u32InFlight + 1) / 2;
+    else
+        u32Thr = ptPort->u32InFlight;
+
+    pSpi->RXFTLR = u32Thr - 1;
+}
+
+static void _Hal_Spi_MasterDrain(S_SpiMasterPort_t *ptPort)
+{
+    S_SpiXfer_t *ptXfer = ptPort->ptHead;
+    S_Spi_Reg_t *pSpi = ptPort->pSpi;
+    uint32_t u32Num = pSpi->RXFLR;
+    uint32_t u32Data = 0;
+
+    while (u32Num--)
+    {
+        u32Data = pSpi->DR[0];
+
+        if ((ptXfer->pRxData) && (ptXfer->u32RxIdx < ptXfer->u32Frames))
+        {
+            if (ptXfer->ptDev->eDataSize == SPI_DFS_16_bit)
+                ((uint16_t *)ptXfer->pRxData)[ptXfer->u32RxIdx] = (uint16_t)u32Data;
+            else
+                ((uint8_t *)ptXfer->pRxData)[ptXfer->u32RxIdx] = (uint8_t)u32Data;
+        }
+
+        ptXfer->u32RxIdx++;
+        ptPort->u32InFlight--;
+    }
+}
+
+static void _Hal_Spi_MasterFinish(S_SpiMasterPort_t *ptPort, uint32_t u32Status)
+{
+    S_SpiXfer_t *ptXfer = ptPort->ptHead;
+    uint32_t u32Ticks = Hal_Tick_Diff(ptPort->u32Start);
+
+    if (!(ptXfer->u8Flags & HAL_SPI_XFER_KEEP_CS))
+        _Hal_Spi_MasterCsSet(ptXfer->ptDev, 0);
+
+    ptPort->tStat.u32Xfers++;
+    ptPort->tStat.u32Frames += ptXfer->u32RxIdx;
+    ptPort->tStat.u32BusyUs += (uint32_t)(((uint64_t)u32Ticks * 1000) / Hal_Tick_PerMilliSec());
+
+    if (u32Status != HAL_SPI_XFER_DONE)
+        ptPort->tStat.u32Errors++;
+
+    ptPort->ptHead = ptXfer->ptNext;
+    if (ptPort->ptHead == NULL)
+        ptPort->ptTail = NULL;
+    ptPort->u32Queued--;
+    ptPort->u32InFlight = 0;
+
+    ptXfer->ptNext = NULL;
+    ptXfer->u32Status = u32Status;
+
+    if (ptXfer->fpCallBack)
+        ptXfer->fpCallBack(ptXfer);
+}
+
+static void _Hal_Spi_MasterStart(S_SpiMasterPort_t *ptPort)
+{
+    S_SpiXfer_t *ptXfer = ptPort->ptHead;
+
+    if (ptXfer == NULL)
+    {
+        ptPort->pSpi->IMR = 0;
+        return;
+    }
+
+    _Hal_Spi_MasterConfig(ptPort, ptXfer->ptDev);
+    _Hal_Spi_MasterCsSet(ptXfer->ptDev, 1);
+
+    ptXfer->u32Status = HAL_SPI_XFER_ACTIVE;
+    Hal_Tick_DiffEx(0, &ptPort->u32Start);
+    ptPort->u32InFlight = 0;
+
+    _Hal_Spi_MasterFill(ptPort);
+    ptPort->pSpi->IMR = SPI_INT_RX_FULL | SPI_INT_RX_OVERFLOW | SPI_INT_RX_UNDERFLOW;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Spi_MasterInit
+*
+* DESCRIPTION:
+*   1. Prepare SPI1/SPI2 for the queued transfers and enable its interrupt.
+*      The pins must be set up by Hal_Pinmux_Spi_Init() before.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx  : SPI_IDX_1 or SPI_IDX_2
+*
+* RETURNS
+*   0: setting complete
+*   1: error
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Hal_Spi_MasterInit(E_SpiIdx_t eSpiIdx)
+{
+    S_SpiMasterPort_t *ptPort = NULL;
+    osSemaphoreDef_t tSemaphoreDef;
+
+    if ((eSpiIdx != SPI_IDX_1) && (eSpiIdx != SPI_IDX_2))
+        return 1;
+
+    ptPort = &g_taSpiMasterPort[eSpiIdx];
+
+    if (ptPort->u8Init)
+        return 0;
+
+    memset(ptPort, 0, sizeof(S_SpiMasterPort_t));
+    ptPort->pSpi = (eSpiIdx == SPI_IDX_1) ? SPI_1 : SPI_2;
+    ptPort->eIrq = (eSpiIdx == SPI_IDX_1) ? SPI1_IRQn : SPI2_IRQn;
+
+    tSemaphoreDef.dummy = 0;
+    ptPort->tLock = osSemaphoreCreate(&tSemaphoreDef, 1);
+    ptPort->tDone = osSemaphoreCreate(&tSemaphoreDef, 1);
+    if ((ptPort->tLock == NULL) || (ptPort->tDone == NULL))
+        return 1;
+
+    osSemaphoreWait(ptPort->tDone, 0);
+
+    ptPort->pSpi->IMR = 0;
+
+    // VIC 1) Clear interrupt
+    Hal_Vic_IntClear(ptPort->eIrq);
+    // VIC 2) Level type, it stays pending while the RX FIFO is above the threshold
+    Hal_Vic_IntTypeSel(ptPort->eIrq, INT_TYPE_LEVEL);
+    // VIC 3) Unmask and enable
+    Hal_Vic_IntMask(ptPort->eIrq, 0);
+    Hal_Vic_IntEn(ptPort->eIrq, 1);
+
+    // NVIC 1) Clean NVIC
+    NVIC_ClearPendingIRQ(ptPort->eIrq);
+    // NVIC 2) Set prority
+    NVIC_SetPriority(ptPort->eIrq, (eSpiIdx == SPI_IDX_1) ? IRQ_PRIORITY_SPI1 : IRQ_PRIORITY_SPI2);
+    // NVIC 3) Enable NVIC
+    NVIC_EnableIRQ(ptPort->eIrq);
+
+    ptPort->u8Init = 1;
+    return 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Spi_MasterSubmit
+*
+* DESCRIPTION:
+*   1. Queue a transfer, it starts at once if the port is idle.
+*      May be called from a completion callback.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptXfer   : the transfer, see S_SpiXfer_t
+*
+* RETURNS
+*   0: queued
+*   1: error
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Hal_Spi_MasterSubmit(S_SpiXfer_t *ptXfer)
+{
+    S_SpiMasterPort_t *ptPort = NULL;
+    uint32_t u32Pm = 0;
+
+    if ((ptXfer == NULL) || (ptXfer->ptDev == NULL) || (ptXfer->u32Frames == 0))
+        return 1;
+
+    if ((ptXfer->ptDev->eDataSize != SPI_DFS_08_bit) && (ptXfer->ptDev->eDataSize != SPI_DFS_16_bit))
+        return 1;
+
+    ptPort = _Hal_Spi_MasterPortGet(ptXfer->ptDev->eSpiIdx);
+    if (ptPort == NULL)
+        return 1;
+
+    ptXfer->u32TxIdx = 0;
+    ptXfer->u32RxIdx = 0;
+    ptXfer->ptNext = NULL;
+    ptXfer->u32Status = HAL_SPI_XFER_QUEUED;
+
+    HAL_SPI_MASTER_IRQ_SAVE(u32Pm);
+
+    if (ptPort->ptTail)
+        ptPort->ptTail->ptNext = ptXfer;
+    else
+        ptPort->ptHead = ptXfer;
+    ptPort->ptTail = ptXfer;
+
+    ptPort->u32Queued++;
+    if (ptPort->u32Queued > ptPort->tStat.u32QueueMax)
+        ptPort->tStat.u32QueueMax = ptPort->u32Queued;
+
+    if (ptPort->ptHead == ptXfer)
+        _Hal_Spi_MasterStart(ptPort);
+
+    HAL_SPI_MASTER_IRQ_RESTORE(u32Pm);
+
+    return 0;
+}
+
+static void _Hal_Spi_MasterDoneCallBack(S_SpiXfer_t *ptXfer)
+{
+    osSemaphoreRelease(((S_SpiMasterPort_t *)ptXfer->pArg)->tDone);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Spi_MasterTransfer
+*
+* DESCRIPTION:
+*   1. Queue a transfer and wait for it. fpCallBack and pArg of the
+*      transfer are used by this function.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptXfer       : the transfer, see S_SpiXfer_t
+*   2. u32TimeoutMs : how long to wait for it
+*
+* RETURNS
+*   0: done
+*   1: error or time-out (the transfer is aborted, see Hal_Spi_MasterAbort)
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Hal_Spi_MasterTransfer(S_SpiXfer_t *ptXfer, uint32_t u32TimeoutMs)
+{
+    S_SpiMasterPort_t *ptPort = NULL;
+    uint32_t u32Ret = 1;
+
+    if ((ptXfer == NULL) || (ptXfer->ptDev == NULL))
+        return 1;
+
+    ptPort = _Hal_Spi_MasterPortGet(ptXfer->ptDev->eSpiIdx);
+    if (ptPort == NULL)
+        return 1;
+
+    osSemaphoreWait(ptPort->tLock, osWaitForever);
+
+    ptXfer->fpCallBack = _Hal_Spi_MasterDoneCallBack;
+    ptXfer->pArg = ptPort;
+
+    if (Hal_Spi_MasterSubmit(ptXfer))
+        goto done;
+
+    if (osSemaphoreWait(ptPort->tDone, u32TimeoutMs) != osOK)
+    {
+        // the device stalled: take the transfer back so the interrupt no longer
+        // touches it, or, if it completed meanwhile, consume the token of the
+        // callback so it cannot wake up the next caller
+        if (Hal_Spi_MasterAbort(ptXfer) != HAL_SPI_XFER_ABORTED)
+            osSemaphoreWait(ptPort->tDone, 0);
+    }
+
+    if (ptXfer->u32Status == HAL_SPI_XFER_DONE)
+        u32Ret = 0;
+
+done:
+    osSemaphoreRelease(ptPort->tLock);
+    return u32Ret;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Spi_MasterAbort
+*
+* DESCRIPTION:
+*   1. Take a queued or active transfer back from the port. An active one
+*      is stopped: the FIFOs are flushed, CS is released and the next
+*      transfer is started. The callback is not called.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptXfer   : the transfer, see S_SpiXfer_t
+*
+* RETURNS
+*   the final status of the transfer:
+*   HAL_SPI_XFER_ABORTED: it was still queued or active
+*   others: it had completed before, the callback has run
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Hal_Spi_MasterAbort(S_SpiXfer_t *ptXfer)
+{
+    S_SpiMasterPort_t *ptPort = NULL;
+    S_SpiXfer_t *ptPrev = NULL;
+    S_SpiXfer_t *ptCur = NULL;
+    uint32_t u32Pm = 0;
+    uint32_t u32Status = 0;
+
+    if ((ptXfer == NULL) || (ptXfer->ptDev == NULL))
+        return HAL_SPI_XFER_IDLE;
+
+    ptPort = _Hal_Spi_MasterPortGet(ptXfer->ptDev->eSpiIdx);
+    if (ptPort == NULL)
+        return ptXfer->u32Status;
+
+    HAL_SPI_MASTER_IRQ_SAVE(u32Pm);
+
+    for (ptCur = ptPort->ptHead; ptCur != NULL; ptPrev = ptCur, ptCur = ptCur->ptNext)
+    {
+        if (ptCur == ptXfer)
+            break;
+    }
+
+    if (ptCur == NULL)
+        goto done;
+
+    if (ptPrev)
+        ptPrev->ptNext = ptXfer->ptNext;
+    else
+        ptPort->ptHead = ptXfer->ptNext;
+    if (ptPort->ptTail == ptXfer)
+        ptPort->ptTail = ptPrev;
+    ptPort->u32Queued--;
+
+    ptXfer->ptNext = NULL;
+    ptXfer->u32Status = HAL_SPI_XFER_ABORTED;
+    ptPort->tStat.u32Errors++;
+
+    if (ptPrev == NULL)
+    {
+        // it was on the wire: drop the frames in flight and go on with the queue
+        ptPort->pSpi->IMR = 0;
+        ptPort->pSpi->SSIENR = 0;
+        ptPort->pSpi->SSIENR = SPI_SSIER_EN | SPI_SSIER_TAG;
+        ptPort->u32InFlight = 0;
+        _Hal_Spi_MasterCsSet(ptXfer->ptDev, 0);
+        _Hal_Spi_MasterStart(ptPort);
+    }
+
+done:
+    u32Status = ptXfer->u32Status;
+    HAL_SPI_MASTER_IRQ_RESTORE(u32Pm);
+
+    return u32Status;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Spi_MasterBusy
+*
+* DESCRIPTION:
+*   1. Check if the port still has transfers queued
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx  : SPI_IDX_1 or SPI_IDX_2
+*
+* RETURNS
+*   0: idle
+*   1: busy
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint8_t Hal_Spi_MasterBusy(E_SpiIdx_t eSpiIdx)
+{
+    S_SpiMasterPort_t *ptPort = _Hal_Spi_MasterPortGet(eSpiIdx);
+
+    if (ptPort == NULL)
+        return 0;
+
+    return (ptPort->ptHead != NULL);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Spi_MasterIntHandler
+*
+* DESCRIPTION:
+*   1. SPI1/SPI2 interrupt: collect the received frames, send the next
+*      ones and complete the active transfer
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx  : SPI_IDX_1 or SPI_IDX_2
+*
+* RETURNS
+*   none
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_Spi_MasterIntHandler(E_SpiIdx_t eSpiIdx)
+{
+    S_SpiMasterPort_t *ptPort = _Hal_Spi_MasterPortGet(eSpiIdx);
+    S_Spi_Reg_t *pSpi = NULL;
+    S_SpiXfer_t *ptXfer = NULL;
+    uint32_t u32Isr = 0;
+
+    if (ptPort == NULL)
+        return;
+
+    pSpi = ptPort->pSpi;
+    ptPort->tStat.u32Irqs++;
+
+    while ((ptXfer = ptPort->ptHead) != NULL)
+    {
+        u32Isr = pSpi->ISR;
+
+        if (u32Isr & (SPI_INT_RX_OVERFLOW | SPI_INT_RX_UNDERFLOW))
+        {
+            // frames were lost: flush the port and give the transfer back
+            (void)pSpi->ICR;
+            pSpi->SSIENR = 0;
+            pSpi->SSIENR = SPI_SSIER_EN | SPI_SSIER_TAG;
+            _Hal_Spi_MasterFinish(ptPort, HAL_SPI_XFER_ERROR);
+            _Hal_Spi_MasterStart(ptPort);
+            continue;
+        }
+
+        if (!(u32Isr & SPI_INT_RX_FULL))
+            break;
+
+        _Hal_Spi_MasterDrain(ptPort);
+
+        if (ptXfer->u32RxIdx >= ptXfer->u32Frames)
+        {
+            _Hal_Spi_MasterFinish(ptPort, HAL_SPI_XFER_DONE);
+            _Hal_Spi_MasterStart(ptPort);
+        }
+        else if (ptXfer->u32TxIdx < ptXfer->u32Frames)
+        {
+            _Hal_Spi_MasterFill(ptPort);
+        }
+        else
+        {
+            // the tail is on the wire
+            pSpi->RXFTLR = ptPort->u32InFlight - 1;
+        }
+    }
+
+    if (ptPort->ptHead == NULL)
+        pSpi->IMR = 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Spi_MasterStatGet
+*
+* DESCRIPTION:
+*   1. Get the transfer statistics of the port
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx  : SPI_IDX_1 or SPI_IDX_2
+*   2. ptStat   : [OUT] the statistics
+*
+* RETURNS
+*   none
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_Spi_MasterStatGet(E_SpiIdx_t eSpiIdx, S_SpiMasterStat_t *ptStat)
+{
+    S_SpiMasterPort_t *ptPort = _Hal_Spi_MasterPortGet(eSpiIdx);
+    uint32_t u32Pm = 0;
+
+    if (ptPort == NULL)
+    {
+        memset(ptStat, 0, sizeof(S_SpiMasterStat_t));
+        return;
+    }
+
+    HAL_SPI_MASTER_IRQ_SAVE(u32Pm);
+    memcpy(ptStat, &ptPort->tStat, sizeof(S_SpiMasterStat_t));
+    HAL_SPI_MASTER_IRQ_RESTORE(u32Pm);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Hal_Spi_MasterStatReset
+*
+* DESCRIPTION:
+*   1. Clear the transfer statistics of the port
+*
+* CALLS
+*
+* PARAMETERS
+*   1. eSpiIdx  : SPI_IDX_1 or SPI_IDX_2
+*
+* RETURNS
+*   none
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Hal_Spi_MasterStatReset(E_SpiIdx_t eSpiIdx)
+{
+    S_SpiMasterPort_t *ptPort = _Hal_Spi_MasterPortGet(eSpiIdx);
+    uint32_t u32Pm = 0;
+
+    if (ptPort == NULL)
+        return;
+
+    HAL_SPI_MASTER_IRQ_SAVE(u32Pm);
+    memset(&ptPort->tStat, 0, sizeof(S_SpiMasterStat_t));
+    ptPort->tStat.u32QueueMax = ptPort->u32Queued;
+    HAL_SPI_MASTER_IRQ_RESTORE(u32Pm);
+}
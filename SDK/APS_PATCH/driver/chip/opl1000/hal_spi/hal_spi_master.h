@@ -0,0 +1,140 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_spi_master.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This include file defines the queued block transfers of the SPI1/SPI2
+*  master ports.
+*
+*  A transfer (S_SpiXfer_t) names its device (S_SpiDev_t: clock, mode, frame
+*  size and chip select), the TX/RX buffers and a completion callback. It is
+*  queued with Hal_Spi_MasterSubmit() and runs in the background: the port
+*  is reprogrammed only when the device changes, the frames are written in
+*  tag mode so the hardware CS stays asserted over the whole block, and the
+*  RX full interrupt drains and refills the 4-entry FIFO. The callback runs
+*  in interrupt context once the last frame is received.
+*
+*  The transfer memory belongs to the caller until the callback (or the
+*  status leaving HAL_SPI_XFER_QUEUED/ACTIVE) hands it back, or until
+*  Hal_Spi_MasterAbort returns. An aborted transfer gets no callback.
+*
+******************************************************************************/
+
+#ifndef __HAL_SPI_MASTER_H__
+#define __HAL_SPI_MASTER_H__
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdint.h>
+#include "hal_spi.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HAL_SPI_MASTER_FIFO_DEPTH       4       // RX FIFO entries, frames in flight
+
+#define HAL_SPI_CS_HW                   (-1)    // S_SpiDev_t.s8CsGpio: the SS pin of the port
+
+// S_SpiXfer_t.u8Flags
+#define HAL_SPI_XFER_KEEP_CS            (1<<0)  // leave CS asserted, the next transfer continues the frame
+
+// S_SpiXfer_t.u32Status
+#define HAL_SPI_XFER_IDLE               0
+#define HAL_SPI_XFER_QUEUED             1
+#define HAL_SPI_XFER_ACTIVE             2
+#define HAL_SPI_XFER_DONE               3
+#define HAL_SPI_XFER_ERROR              4       // RX overrun/underrun
+#define HAL_SPI_XFER_ABORTED            5       // taken back by Hal_Spi_MasterAbort
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    E_SpiIdx_t eSpiIdx;                 // SPI_IDX_1 or SPI_IDX_2
+    uint32_t u32Baud;
+    E_SpiClkPolarity_t ePolar;
+    E_SpiClkPhase_t ePhase;
+    E_SpiDataFrameSize_t eDataSize;     // SPI_DFS_08_bit or SPI_DFS_16_bit
+    int8_t s8CsGpio;                    // E_GpioIdx_t driven low while selected, or HAL_SPI_CS_HW
+} S_SpiDev_t;
+
+struct S_SpiXfer;
+typedef void (*T_Hal_Spi_XferCallBack)(struct S_SpiXfer *ptXfer);
+
+typedef struct S_SpiXfer
+{
+    const S_SpiDev_t *ptDev;
+    const void *pTxData;                // NULL: read only, the frames are clocked out as TAG_READ
+    void *pRxData;                      // NULL: the received frames are dropped
+    uint32_t u32Frames;                 // uint8_t or uint16_t items, by the frame size
+    uint8_t u8Flags;
+    T_Hal_Spi_XferCallBack fpCallBack;  // interrupt context, may submit the next transfer
+    void *pArg;
+
+    // owned by the driver
+    volatile uint32_t u32Status;
+    uint32_t u32TxIdx;
+    uint32_t u32RxIdx;
+    struct S_SpiXfer *ptNext;
+} S_SpiXfer_t;
+
+typedef struct
+{
+    uint32_t u32Xfers;
+    uint32_t u32Frames;
+    uint32_t u32Irqs;
+    uint32_t u32Reconfig;           // the device changed between transfers
+    uint32_t u32Errors;
+    uint32_t u32QueueMax;           // most transfers waiting at once
+    uint32_t u32BusyUs;             // from the first frame to the callback, summed
+} S_SpiMasterStat_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+uint32_t Hal_Spi_MasterInit(E_SpiIdx_t eSpiIdx);
+uint32_t Hal_Spi_MasterSubmit(S_SpiXfer_t *ptXfer);
+uint32_t Hal_Spi_MasterTransfer(S_SpiXfer_t *ptXfer, uint32_t u32TimeoutMs);
+uint32_t Hal_Spi_MasterAbort(S_SpiXfer_t *ptXfer);
+uint8_t Hal_Spi_MasterBusy(E_SpiIdx_t eSpiIdx);
+void Hal_Spi_MasterIntHandler(E_SpiIdx_t eSpiIdx);
+void Hal_Spi_MasterStatGet(E_SpiIdx_t eSpiIdx, S_SpiMasterStat_t *ptStat);
+void Hal_Spi_MasterStatReset(E_SpiIdx_t eSpiIdx);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+#endif
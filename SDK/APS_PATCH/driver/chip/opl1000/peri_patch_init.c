@@ -47,7 +47,11 @@ Head Block of The File
 #include "hal_dma.h"
 
 #include "hal_flash_patch.h"
+#include "hal_flash_cache.h"
+#include "hal_flash_sched.h"
 #include "hal_system_patch.h"
+#include "hal_temperature_internal.h"
+#include "hal_temperature_patch.h"
 
 
 // Sec 2: Constant Definitions, Imported Symbols, miscellaneous
@@ -119,8 +123,11 @@ void peripheral_patch_init(void)
     // spi
 
     // flash
+    Hal_Flash_Init_Internal        = Hal_Flash_Init_Internal_patch;
     Hal_Flash_AddrProgram_Internal = Hal_Flash_AddrProgram_Internal_patch;
     Hal_Flash_AddrRead_Internal    = Hal_Flash_AddrRead_Internal_patch;
+    Hal_Flash_SchedInit();
+    Hal_Flash_CacheInit();
 
     // i2c
 
@@ -132,5 +139,10 @@ void peripheral_patch_init(void)
 
     // dma
 
+    // temperature sensor
+    Hal_Tmpr_Init = Hal_Tmpr_Init_patch;
+    Hal_Tmpr_TemperatureGet = Hal_Tmpr_TemperatureGet_patch;
+    Hal_Tmpr_CompareResistor = Hal_Tmpr_CompareResistor_patch;
+
     // Peripheral
 }
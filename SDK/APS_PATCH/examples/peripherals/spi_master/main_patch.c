@@ -41,6 +41,10 @@ Head Block of The File
 *       
 *  spi_send_data() is an example of access an external SPI slave device through 
            SPI1 and SPI2 port 
+*
+*  spi_queue_send() sends the same string as one queued block transfer
+*   (hal_spi_master.h): the whole string goes out under one CS assertion, the
+*   completion callback reports the received bytes.
 *  
 *  SPI1 and SPI2 signal pin and parameters are defined by OPL1000_periph.spi
 * 
@@ -58,6 +62,7 @@ Head Block of The File
 #include "sys_os_config.h"
 #include "Hal_pinmux_spi.h"
 #include "hal_flash_patch.h"
+#include "hal_spi_master.h"
 
 // Sec 2: Constant Definitions, Imported Symbols, miscellaneous
 #define DUMMY          0x00
@@ -93,6 +98,10 @@ Declaration of static Global Variables & Functions
 ***************************************************/
 // Sec 6: declaration of static global variable
 static osThreadId g_tAppThread;
+static S_SpiDev_t g_tSpiDev;
+static S_SpiXfer_t g_tSpiXfer;
+static uint8_t g_u8aSpiTx[32];
+static uint8_t g_u8aSpiRx[32];
 
 // Sec 7: declaration of static function prototype
 static void __Patch_EntryPoint(void) __attribute__((section(".ARM.__at_0x00420000")));
@@ -101,6 +110,7 @@ static void Main_FlashLayoutUpdate(void);
 void Main_AppInit_patch(void);
 static void spi_flash_test(void);
 static void spi_send_data(int idx);
+static void spi_queue_send(int idx);
 static void Main_AppThread(void *argu);
 static void spi_test(void);
 
@@ -221,6 +231,9 @@ void Main_AppInit_patch(void)
 *************************************************************************/
 static void Main_AppThread(void *argu)
 {
+    // the same data through the transfer queue
+    spi_queue_send(SPI2_IDX);
+
     while (1)
     {	
         osDelay(1500);      // delay 1500 ms		
@@ -312,6 +325,69 @@ static void spi_send_data(int idx)
     }    
 }
 
+static void spi_queue_done(S_SpiXfer_t *ptXfer)
+{
+    // interrupt context, only record the result
+    *(uint32_t *)ptXfer->pArg = ptXfer->u32Status;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   spi_queue_send
+*
+* DESCRIPTION:
+*   an example of a queued block transfer to external SPI slave device.
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+static void spi_queue_send(int idx)
+{
+    static volatile uint32_t u32Status;
+    T_OPL1000_Spi *spi;
+
+    spi = &OPL1000_periph.spi[idx];
+    if (Hal_Spi_MasterInit(spi->index))
+    {
+        printf("SPI%d queue init fail \r\n", idx+1);
+        return;
+    }
+
+    g_tSpiDev.eSpiIdx = spi->index;
+    g_tSpiDev.u32Baud = spi->baudrate;
+    g_tSpiDev.ePolar = spi->polar;
+    g_tSpiDev.ePhase = spi->phase;
+    g_tSpiDev.eDataSize = SPI_DFS_08_bit;
+    g_tSpiDev.s8CsGpio = HAL_SPI_CS_HW;
+
+    sprintf((char *)g_u8aSpiTx, "Hello from SPI%d queue \r\n", idx+1);
+
+    memset(&g_tSpiXfer, 0, sizeof(g_tSpiXfer));
+    g_tSpiXfer.ptDev = &g_tSpiDev;
+    g_tSpiXfer.pTxData = g_u8aSpiTx;
+    g_tSpiXfer.pRxData = g_u8aSpiRx;
+    g_tSpiXfer.u32Frames = strlen((char *)g_u8aSpiTx);
+    g_tSpiXfer.fpCallBack = spi_queue_done;
+    g_tSpiXfer.pArg = (void *)&u32Status;
+
+    u32Status = HAL_SPI_XFER_QUEUED;
+    if (Hal_Spi_MasterSubmit(&g_tSpiXfer))
+    {
+        printf("SPI%d submit fail \r\n", idx+1);
+        return;
+    }
+
+    // the thread is free to do other work here
+    while (Hal_Spi_MasterBusy(spi->index))
+        osDelay(1);
+
+    printf("SPI%d queued %u bytes, status %u \r\n", idx+1, g_tSpiXfer.u32Frames, u32Status);
+}
+
 /*************************************************************************
 * FUNCTION:
 *   SPI test 
@@ -23,7 +23,11 @@
 #include "common.h"
 #include "sys_common_api.h"
 #include "hal_flash.h"
+#include "hal_flash_cache.h"
 #include "at_cmd_task.h"
+#include "net_stats.h"
+#include "sys_fault.h"
+#include "mw_log_flash.h"
 
 //#define AT_FLASH_CHECK_BEFORE_WRITE
 //#define AT_DEBUG
@@ -432,6 +436,12 @@ int at_cmd_sys_write_flash(char *buf, int len, int mode)
                         goto done;
                     }
 
+                    // the area may also be written by the M0, drop what the cache holds
+                    if(u32SpiIdx == SPI_IDX_0)
+                    {
+                        Hal_Flash_CacheInvalidate(u32EraseStart, u32EraseUnit);
+                    }
+
                     u32EraseStart += u32EraseUnit;
                 }
             }
@@ -483,6 +493,12 @@ int at_cmd_sys_write_flash(char *buf, int len, int mode)
                     goto done;
                 }
 
+                // read back from the flash, not from lines cached before the M0 changed it
+                if(u32SpiIdx == SPI_IDX_0)
+                {
+                    Hal_Flash_CacheInvalidate(u32Addr + u32Offset, u32ProcSize);
+                }
+
                 if(Hal_Flash_AddrRead(u32SpiIdx, u32Addr + u32Offset, 0, u32ProcSize, u8aReadBuf))
                 {
                     AT_LOG("Hal_Flash_AddrRead fail\r\n");
@@ -591,6 +607,11 @@ int at_cmd_sys_erase_flash(char *buf, int len, int mode)
                     goto done;
                 }
 
+                if(u32SpiIdx == SPI_IDX_0)
+                {
+                    Hal_Flash_CacheInvalidate(u32EraseStart, u32EraseUnit);
+                }
+
                 u32EraseStart += u32EraseUnit;
             }
 
@@ -627,5 +648,8 @@ _at_command_t gAtCmdTbl_ext[] =
     { "at+readflash",           at_cmd_sys_read_flash,    "Read flash" },
     { "at+writeflash",          at_cmd_sys_write_flash,   "Write flash" },
     { "at+eraseflash",          at_cmd_sys_erase_flash,   "Erase flash" },
+    { "at+netstats",            net_stats_at_cmd,         "Network statistics" },
+    { "at+crash",               Sys_FaultAtCmd,           "Crash record of the last fault" },
+    { "at+logflash",            MwLogFlash_AtCmd,         "Tracer lines kept in flash" },
     { NULL,                     NULL,                     NULL},
 };
@@ -25,6 +25,7 @@
 #include "sys_os_config.h"
 
 #include "at_cmd_task_patch.h"
+#include "sys_wdt.h"
 
 #define CONFIG_MAX_SOCKETS_NUM      5
 
@@ -194,14 +195,20 @@ void at_task_patch(void *pvParameters)
     osEvent rxEvent;
     xATMessage *rxMsg;
     at_uart_buffer_t *pData;
+    int iWdtId;
 
     tracer_log(LOG_HIGH_LEVEL, "AT task is created successfully! \r\n");
     msg_print_uart1("\r\n>");
 
+    // watchdog supervisor: only the handling of a command has a deadline
+    iWdtId = Sys_WdtRegister("at", SYS_WDT_DEADLINE_AT_MS, NULL);
+
     for(;;)
     {
         /** wait event */
+        Sys_WdtIdle(iWdtId);
         rxEvent = osMessageGet(xAtQueue, osWaitForever);
+        Sys_WdtBusy(iWdtId);
         if(rxEvent.status != osEventMessage) continue;
 
         rxMsg = (xATMessage *) rxEvent.value.p;
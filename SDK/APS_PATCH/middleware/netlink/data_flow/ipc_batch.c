@@ -0,0 +1,546 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "cmsis_os.h"
+#include "sys_common.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "ipc_batch.h"
+
+
+#define IPC_BATCH_OWN_NONE              0
+#define IPC_BATCH_OWN_WRITE             1   // M3 moves the write index
+#define IPC_BATCH_OWN_READ              2   // M3 moves the read index
+
+#define IPC_BATCH_LATENCY_MAX           100 // ms
+
+#define IPC_BATCH_PARAM_MAX             4
+
+// the indexes M3 moves in the command and message rings, BLE TX included
+#define IPC_BATCH_CTRL_NUM              (IPC_BATCH_RB_MAX + IPC_BLE_TX_RB_NUM)
+
+#define IPC_BATCH_CRIT_ENTER(x)         do { x = __get_PRIMASK(); __disable_irq(); } while(0)
+#define IPC_BATCH_CRIT_EXIT(x)          __set_PRIMASK(x)
+
+
+typedef struct
+{
+    const char *sName;
+    uint32_t dwWrite;               // address of the write index
+    uint32_t dwRead;                // address of the read index
+    uint32_t dwNum;
+    uint8_t bOwn;                   // IPC_BATCH_OWN_XXX
+} T_IpcBatchRbInfo;
+
+
+static const T_IpcBatchRbInfo g_taIpcBatchRb[IPC_BATCH_RB_MAX] =
+{
+    {"cmd",         IPC_CMD_QUEUE_WRITE,            IPC_CMD_QUEUE_READ,             IPC_CMD_BUF_NUM,            IPC_BATCH_OWN_WRITE},
+    {"evt",         IPC_EVT_QUEUE_WRITE,            IPC_EVT_QUEUE_READ,             IPC_EVT_BUF_NUM,            IPC_BATCH_OWN_READ},
+    {"ble_cmd",     IPC_BLE_CMD_QUEUE_WRITE,        IPC_BLE_CMD_QUEUE_READ,         IPC_BLE_CMD_BUF_NUM,        IPC_BATCH_OWN_WRITE},
+    {"ble_evt",     IPC_BLE_EVT_QUEUE_WRITE,        IPC_BLE_EVT_QUEUE_READ,         IPC_BLE_EVT_BUF_NUM,        IPC_BATCH_OWN_READ},
+    {"ble_rx",      IPC_BLE_RX_QUEUE_WRITE,         IPC_BLE_RX_QUEUE_READ,          IPC_BLE_RX_BUF_NUM,         IPC_BATCH_OWN_READ},
+    {"wifi_cmd",    IPC_WIFI_CMD_QUEUE_WRITE,       IPC_WIFI_CMD_QUEUE_READ,        IPC_WIFI_CMD_BUF_NUM,       IPC_BATCH_OWN_WRITE},
+    {"wifi_evt",    IPC_WIFI_EVT_QUEUE_WRITE,       IPC_WIFI_EVT_QUEUE_READ,        IPC_WIFI_EVT_BUF_NUM,       IPC_BATCH_OWN_READ},
+    {"msq_tx",      IPC_WIFI_MSQ_TX_QUEUE_WRITE,    IPC_WIFI_MSQ_TX_QUEUE_READ,     IPC_WIFI_MSQ_TX_BUF_NUM,    IPC_BATCH_OWN_NONE},
+    {"msq_rx",      IPC_WIFI_MSQ_RX_QUEUE_WRITE,    IPC_WIFI_MSQ_RX_QUEUE_READ,     IPC_WIFI_MSQ_RX_BUF_NUM,    IPC_BATCH_OWN_NONE},
+    {"aps_tx",      IPC_WIFI_APS_TX_QUEUE_WRITE,    IPC_WIFI_APS_TX_QUEUE_READ,     IPC_WIFI_APS_TX_BUF_NUM,    IPC_BATCH_OWN_NONE},
+    {"aps_rx",      IPC_WIFI_APS_RX_QUEUE_WRITE,    IPC_WIFI_APS_RX_QUEUE_READ,     IPC_WIFI_APS_RX_BUF_NUM,    IPC_BATCH_OWN_NONE},
+    {"m0_msg",      IPC_M0_MSG_QUEUE_WRITE,         IPC_M0_MSG_QUEUE_READ,          IPC_M0_MSG_BUF_NUM,         IPC_BATCH_OWN_READ},
+    {"m3_msg",      IPC_M3_MSG_QUEUE_WRITE,         IPC_M3_MSG_QUEUE_READ,          IPC_M3_MSG_BUF_NUM,         IPC_BATCH_OWN_WRITE},
+};
+
+// keep the original doorbell and the setting for the warm boot
+RET_DATA T_Hal_Vic_IpcIntTrig g_fpIpcBatchTrig;
+RET_DATA uint32_t g_dwIpcBatchNum;
+RET_DATA uint32_t g_dwIpcBatchLatency;
+
+static osTimerId g_tIpcBatchTimer = NULL;
+static uint8_t g_bIpcBatchTimerOn = 0;
+
+// the ring indexes at the last doorbell
+static uint32_t g_dwaIpcBatchCtrl[IPC_BATCH_CTRL_NUM] = {0};
+static uint32_t g_dwIpcBatchTxWrite = 0;
+static uint32_t g_dwIpcBatchRxRead = 0;
+
+static T_IpcBatchStat g_tIpcBatchStat = {0};
+
+
+static uint32_t ipc_batch_index(uint32_t dwAddr)
+{
+    return *(volatile uint32_t *)dwAddr;
+}
+
+// the index may run free or wrap at dwNum, both give the same count
+static uint32_t ipc_batch_diff(uint32_t dwTo, uint32_t dwFrom, uint32_t dwNum)
+{
+    uint32_t dwDiff = dwTo - dwFrom;
+
+    if(dwDiff > dwNum)
+    {
+        dwDiff &= (dwNum - 1);
+    }
+
+    return dwDiff;
+}
+
+/*
+ * the index of every command and message ring M3 moves, in dwaIdx
+ *
+ * the indexes are kept one by one: a sum of them gives the same value when
+ * one index moves forward while another wraps at dwNum
+ */
+static void ipc_batch_ctrl_get(uint32_t *dwaIdx)
+{
+    uint32_t dwNum = 0;
+    uint32_t i = 0;
+
+    for(i = 0; i < IPC_BATCH_RB_MAX; i++)
+    {
+        if(g_taIpcBatchRb[i].bOwn == IPC_BATCH_OWN_WRITE)
+        {
+            dwaIdx[dwNum++] = ipc_batch_index(g_taIpcBatchRb[i].dwWrite);
+        }
+        else if(g_taIpcBatchRb[i].bOwn == IPC_BATCH_OWN_READ)
+        {
+            dwaIdx[dwNum++] = ipc_batch_index(g_taIpcBatchRb[i].dwRead);
+        }
+    }
+
+    // BLE TX: one ring per connection
+    for(i = 0; i < IPC_BLE_TX_RB_NUM; i++)
+    {
+        dwaIdx[dwNum++] = ipc_batch_index(IPC_BLE_TX_QUEUE_WRITE + (i * (8 + (IPC_BLE_TX_BUF_SIZE * IPC_BLE_TX_BUF_NUM))));
+    }
+
+    for(; dwNum < IPC_BATCH_CTRL_NUM; dwNum++)
+    {
+        dwaIdx[dwNum] = 0;
+    }
+}
+
+// 1: a command or message ring moved since the last doorbell
+static uint8_t ipc_batch_ctrl_moved(const uint32_t *dwaIdx)
+{
+    uint32_t i = 0;
+
+    for(i = 0; i < IPC_BATCH_CTRL_NUM; i++)
+    {
+        if(dwaIdx[i] != g_dwaIpcBatchCtrl[i])
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void ipc_batch_high_water(void)
+{
+    uint32_t dwCount = 0;
+    uint32_t i = 0;
+
+    for(i = 0; i < IPC_BATCH_RB_MAX; i++)
+    {
+        dwCount = ipc_batch_rb_count(i, NULL);
+
+        if(dwCount > g_tIpcBatchStat.dwaHighWater[i])
+        {
+            g_tIpcBatchStat.dwaHighWater[i] = dwCount;
+        }
+    }
+}
+
+// called with the interrupt disabled
+// dwaIdx: the indexes of ipc_batch_ctrl_get, NULL to read them here
+static void ipc_batch_raise(const uint32_t *dwaIdx, uint32_t dwTxWrite, uint32_t dwRxRead)
+{
+    g_tIpcBatchStat.dwTxDesc += ipc_batch_diff(dwTxWrite, g_dwIpcBatchTxWrite, IPC_WIFI_APS_TX_BUF_NUM);
+
+    if(dwaIdx)
+    {
+        memcpy(g_dwaIpcBatchCtrl, dwaIdx, sizeof(g_dwaIpcBatchCtrl));
+    }
+    else
+    {
+        ipc_batch_ctrl_get(g_dwaIpcBatchCtrl);
+    }
+
+    g_dwIpcBatchTxWrite = dwTxWrite;
+    g_dwIpcBatchRxRead = dwRxRead;
+
+    g_tIpcBatchStat.dwRaise += 1;
+    g_fpIpcBatchTrig(IPC_BATCH_DOORBELL);
+}
+
+static void ipc_batch_timeout(void const *argu)
+{
+    uint32_t dwTxWrite = 0;
+    uint32_t dwRxRead = 0;
+    uint32_t dwMask = 0;
+
+    IPC_BATCH_CRIT_ENTER(dwMask);
+
+    g_bIpcBatchTimerOn = 0;
+
+    dwTxWrite = ipc_batch_index(IPC_WIFI_APS_TX_QUEUE_WRITE);
+    dwRxRead = ipc_batch_index(IPC_WIFI_APS_RX_QUEUE_READ);
+
+    if((dwTxWrite != g_dwIpcBatchTxWrite) || (dwRxRead != g_dwIpcBatchRxRead))
+    {
+        g_tIpcBatchStat.dwFlushTimer += 1;
+        ipc_batch_raise(NULL, dwTxWrite, dwRxRead);
+    }
+
+    IPC_BATCH_CRIT_EXIT(dwMask);
+}
+
+/*
+ * the replacement of Hal_Vic_IpcIntTrig
+ */
+static void ipc_batch_trig(E_IpcIdx_t eIpc)
+{
+    uint32_t dwaIdx[IPC_BATCH_CTRL_NUM];
+    uint32_t dwTxWrite = 0;
+    uint32_t dwRxRead = 0;
+    uint32_t dwPending = 0;
+    uint32_t dwMask = 0;
+    uint8_t bArm = 0;
+
+    if(eIpc != IPC_BATCH_DOORBELL)
+    {
+        g_fpIpcBatchTrig(eIpc);
+        return;
+    }
+
+    IPC_BATCH_CRIT_ENTER(dwMask);
+
+    g_tIpcBatchStat.dwRequest += 1;
+    ipc_batch_high_water();
+
+    ipc_batch_ctrl_get(dwaIdx);
+    dwTxWrite = ipc_batch_index(IPC_WIFI_APS_TX_QUEUE_WRITE);
+    dwRxRead = ipc_batch_index(IPC_WIFI_APS_RX_QUEUE_READ);
+
+    if((g_dwIpcBatchNum <= 1) || (!g_tIpcBatchTimer))
+    {
+        ipc_batch_raise(dwaIdx, dwTxWrite, dwRxRead);
+        goto done;
+    }
+
+    if(ipc_batch_ctrl_moved(dwaIdx))
+    {
+        g_tIpcBatchStat.dwFlushCtrl += 1;
+        ipc_batch_raise(dwaIdx, dwTxWrite, dwRxRead);
+        goto done;
+    }
+
+    // one free slot left in the APS TX ring, do not let the producer wait
+    if(ipc_batch_rb_count(IPC_BATCH_RB_WIFI_APS_TX, NULL) >= (IPC_WIFI_APS_TX_BUF_NUM - 1))
+    {
+        g_tIpcBatchStat.dwFlushFull += 1;
+        ipc_batch_raise(dwaIdx, dwTxWrite, dwRxRead);
+        goto done;
+    }
+
+    dwPending = ipc_batch_diff(dwTxWrite, g_dwIpcBatchTxWrite, IPC_WIFI_APS_TX_BUF_NUM) +
+                ipc_batch_diff(dwRxRead, g_dwIpcBatchRxRead, IPC_WIFI_APS_RX_BUF_NUM);
+
+    if(dwPending >= g_dwIpcBatchNum)
+    {
+        g_tIpcBatchStat.dwFlushBatch += 1;
+        ipc_batch_raise(dwaIdx, dwTxWrite, dwRxRead);
+        goto done;
+    }
+
+    if(!dwPending)
+    {
+        // nothing moved, the peer is already told
+        goto done;
+    }
+
+    g_tIpcBatchStat.dwHeld += 1;
+
+    if(!g_bIpcBatchTimerOn)
+    {
+        g_bIpcBatchTimerOn = 1;
+        bArm = 1;
+    }
+
+done:
+    IPC_BATCH_CRIT_EXIT(dwMask);
+
+    if(bArm)
+    {
+        osTimerStart(g_tIpcBatchTimer, g_dwIpcBatchLatency);
+    }
+
+    return;
+}
+
+/*
+ * install the doorbell wrapper
+ *
+ * the setting is kept on the warm boot
+ */
+void ipc_batch_init(void)
+{
+    if(Hal_Vic_IpcIntTrig != ipc_batch_trig)
+    {
+        g_fpIpcBatchTrig = Hal_Vic_IpcIntTrig;
+        Hal_Vic_IpcIntTrig = ipc_batch_trig;
+    }
+
+    if(!g_dwIpcBatchNum)
+    {
+        g_dwIpcBatchNum = IPC_BATCH_NUM_DEF;
+        g_dwIpcBatchLatency = IPC_BATCH_LATENCY_DEF;
+    }
+
+    ipc_batch_ctrl_get(g_dwaIpcBatchCtrl);
+    g_dwIpcBatchTxWrite = ipc_batch_index(IPC_WIFI_APS_TX_QUEUE_WRITE);
+    g_dwIpcBatchRxRead = ipc_batch_index(IPC_WIFI_APS_RX_QUEUE_READ);
+
+    if(g_dwIpcBatchNum > 1)
+    {
+        ipc_batch_set(g_dwIpcBatchNum, g_dwIpcBatchLatency);
+    }
+}
+
+/*
+ * dwBatch: descriptors per doorbell, 1 ~ IPC_BATCH_NUM_MAX (1: no batch)
+ * dwLatencyMs: the longest time a doorbell is held, 1 ~ 100
+ *
+ * task context only
+ */
+int ipc_batch_set(uint32_t dwBatch, uint32_t dwLatencyMs)
+{
+    osTimerDef_t tTimerDef;
+    int iRet = -1;
+
+    if((!dwBatch) || (dwBatch > IPC_BATCH_NUM_MAX))
+    {
+        goto done;
+    }
+
+    if((!dwLatencyMs) || (dwLatencyMs > IPC_BATCH_LATENCY_MAX))
+    {
+        goto done;
+    }
+
+    if((dwBatch > 1) && (!g_tIpcBatchTimer))
+    {
+        tTimerDef.ptimer = ipc_batch_timeout;
+        g_tIpcBatchTimer = osTimerCreate(&tTimerDef, osTimerOnce, NULL);
+
+        if(!g_tIpcBatchTimer)
+        {
+            goto done;
+        }
+    }
+
+    g_dwIpcBatchLatency = dwLatencyMs;
+    g_dwIpcBatchNum = dwBatch;
+
+    if(dwBatch <= 1)
+    {
+        // send whatever is held
+        ipc_batch_flush();
+    }
+
+    iRet = 0;
+
+done:
+    return iRet;
+}
+
+void ipc_batch_get(uint32_t *pdwBatch, uint32_t *pdwLatencyMs)
+{
+    if(pdwBatch)
+    {
+        *pdwBatch = g_dwIpcBatchNum;
+    }
+
+    if(pdwLatencyMs)
+    {
+        *pdwLatencyMs = g_dwIpcBatchLatency;
+    }
+}
+
+void ipc_batch_flush(void)
+{
+    uint32_t dwTxWrite = 0;
+    uint32_t dwRxRead = 0;
+    uint32_t dwMask = 0;
+
+    if(!g_fpIpcBatchTrig)
+    {
+        return;
+    }
+
+    IPC_BATCH_CRIT_ENTER(dwMask);
+
+    dwTxWrite = ipc_batch_index(IPC_WIFI_APS_TX_QUEUE_WRITE);
+    dwRxRead = ipc_batch_index(IPC_WIFI_APS_RX_QUEUE_READ);
+
+    if((dwTxWrite != g_dwIpcBatchTxWrite) || (dwRxRead != g_dwIpcBatchRxRead))
+    {
+        ipc_batch_raise(NULL, dwTxWrite, dwRxRead);
+    }
+
+    IPC_BATCH_CRIT_EXIT(dwMask);
+}
+
+void ipc_batch_stat_get(T_IpcBatchStat *ptStat)
+{
+    uint32_t dwMask = 0;
+
+    IPC_BATCH_CRIT_ENTER(dwMask);
+    memcpy(ptStat, &g_tIpcBatchStat, sizeof(T_IpcBatchStat));
+    IPC_BATCH_CRIT_EXIT(dwMask);
+}
+
+void ipc_batch_stat_reset(void)
+{
+    uint32_t dwMask = 0;
+
+    IPC_BATCH_CRIT_ENTER(dwMask);
+    memset(&g_tIpcBatchStat, 0, sizeof(T_IpcBatchStat));
+    IPC_BATCH_CRIT_EXIT(dwMask);
+}
+
+/*
+ * the entries in the ring now, and the size of the ring in *pdwTotal
+ */
+uint32_t ipc_batch_rb_count(uint32_t dwRb, uint32_t *pdwTotal)
+{
+    const T_IpcBatchRbInfo *ptRb = NULL;
+
+    if(dwRb >= IPC_BATCH_RB_MAX)
+    {
+        return 0;
+    }
+
+    ptRb = &(g_taIpcBatchRb[dwRb]);
+
+    if(pdwTotal)
+    {
+        *pdwTotal = ptRb->dwNum;
+    }
+
+    return ipc_batch_diff(ipc_batch_index(ptRb->dwWrite), ipc_batch_index(ptRb->dwRead), ptRb->dwNum);
+}
+
+const char *ipc_batch_rb_name(uint32_t dwRb)
+{
+    if(dwRb >= IPC_BATCH_RB_MAX)
+    {
+        return "";
+    }
+
+    return g_taIpcBatchRb[dwRb].sName;
+}
+
+static void ipc_batch_dump(void)
+{
+    T_IpcBatchStat tStat;
+    uint32_t dwBatch = 0;
+    uint32_t dwLatency = 0;
+    uint32_t dwTotal = 0;
+    uint32_t dwCount = 0;
+    uint32_t i = 0;
+
+    ipc_batch_get(&dwBatch, &dwLatency);
+    ipc_batch_stat_get(&tStat);
+
+    tracer_cli(LOG_HIGH_LEVEL, "ipcbatch: batch=%u latency=%u ms\n", dwBatch, dwLatency);
+    tracer_cli(LOG_HIGH_LEVEL, "request=%u raise=%u held=%u\n", tStat.dwRequest, tStat.dwRaise, tStat.dwHeld);
+    tracer_cli(LOG_HIGH_LEVEL, "flush: batch=%u full=%u timer=%u ctrl=%u\n",
+               tStat.dwFlushBatch, tStat.dwFlushFull, tStat.dwFlushTimer, tStat.dwFlushCtrl);
+
+    // x100: doorbells per 100 APS TX descriptors
+    tracer_cli(LOG_HIGH_LEVEL, "aps_tx desc=%u raise/100 desc=%u\n", tStat.dwTxDesc,
+               (tStat.dwTxDesc) ? ((tStat.dwRaise * 100) / tStat.dwTxDesc) : 0);
+
+    for(i = 0; i < IPC_BATCH_RB_MAX; i++)
+    {
+        dwCount = ipc_batch_rb_count(i, &dwTotal);
+
+        tracer_cli(LOG_HIGH_LEVEL, "  %-10s used=%u size=%u high=%u\n",
+                   ipc_batch_rb_name(i), dwCount, dwTotal, tStat.dwaHighWater[i]);
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   ipc_batch_cmd
+*
+* DESCRIPTION:
+*   diag command: ipcbatch [stat|reset|flush|set <batch> <latency_ms>]
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void ipc_batch_cmd(char *sCmd)
+{
+    char *baParam[IPC_BATCH_PARAM_MAX + 1] = {0};
+    uint32_t dwNum = 0;
+    uint32_t dwBatch = 0;
+    uint32_t dwLatency = 0;
+
+    dwNum = ParseParam(sCmd, baParam, IPC_BATCH_PARAM_MAX + 1);
+
+    if((dwNum < 2) || (!strcmp(baParam[1], "stat")))
+    {
+        ipc_batch_dump();
+    }
+    else if(!strcmp(baParam[1], "reset"))
+    {
+        ipc_batch_stat_reset();
+        tracer_cli(LOG_HIGH_LEVEL, "ipcbatch: reset=1\n");
+    }
+    else if(!strcmp(baParam[1], "flush"))
+    {
+        ipc_batch_flush();
+        tracer_cli(LOG_HIGH_LEVEL, "ipcbatch: flush=1\n");
+    }
+    else if((!strcmp(baParam[1], "set")) && (dwNum >= 3))
+    {
+        ipc_batch_get(&dwBatch, &dwLatency);
+
+        dwBatch = strtoul(baParam[2], NULL, 0);
+
+        if(dwNum >= 4)
+        {
+            dwLatency = strtoul(baParam[3], NULL, 0);
+        }
+
+        if(ipc_batch_set(dwBatch, dwLatency))
+        {
+            tracer_cli(LOG_HIGH_LEVEL, "ipcbatch: invalid, batch 1 ~ %u, latency 1 ~ %u ms\n",
+                       IPC_BATCH_NUM_MAX, IPC_BATCH_LATENCY_MAX);
+        }
+        else
+        {
+            tracer_cli(LOG_HIGH_LEVEL, "ipcbatch: batch=%u latency=%u ms\n", dwBatch, dwLatency);
+        }
+    }
+    else
+    {
+        tracer_cli(LOG_HIGH_LEVEL, "usage: ipcbatch [stat|reset|flush|set <batch> [latency_ms]]\n");
+    }
+}
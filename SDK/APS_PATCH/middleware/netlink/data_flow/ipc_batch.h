@@ -0,0 +1,84 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#ifndef __IPC_BATCH_H__
+#define __IPC_BATCH_H__
+
+
+#include "ipc_patch.h"
+#include "hal_vic.h"
+
+
+/*
+ * Doorbell coalescing of the APS -> MSQ rings.
+ *
+ * Every produce/consume of the IPC rings rings the IPC_BATCH_DOORBELL of
+ * the peer, and the peer drains all the rings for one doorbell. When only
+ * the Wi-Fi data rings (APS TX write, APS RX read) moved since the last
+ * doorbell, it is held back until dwBatch descriptors are pending, the
+ * APS TX ring is full, or dwLatencyMs passed. Any command or message ring
+ * rings the doorbell at once and takes the pending data with it.
+ *
+ * dwBatch <= 1 passes every doorbell through (the default).
+ */
+#define IPC_BATCH_DOORBELL              IPC_IDX_2
+
+#define IPC_BATCH_NUM_DEF               1
+#define IPC_BATCH_NUM_MAX               IPC_WIFI_APS_TX_BUF_NUM
+#define IPC_BATCH_LATENCY_DEF           1   // ms
+
+
+typedef enum
+{
+    IPC_BATCH_RB_CMD = 0,
+    IPC_BATCH_RB_EVT,
+    IPC_BATCH_RB_BLE_CMD,
+    IPC_BATCH_RB_BLE_EVT,
+    IPC_BATCH_RB_BLE_RX,
+    IPC_BATCH_RB_WIFI_CMD,
+    IPC_BATCH_RB_WIFI_EVT,
+    IPC_BATCH_RB_WIFI_MSQ_TX,
+    IPC_BATCH_RB_WIFI_MSQ_RX,
+    IPC_BATCH_RB_WIFI_APS_TX,
+    IPC_BATCH_RB_WIFI_APS_RX,
+    IPC_BATCH_RB_M0_MSG,
+    IPC_BATCH_RB_M3_MSG,
+
+    IPC_BATCH_RB_MAX
+} T_IpcBatchRb;
+
+typedef struct
+{
+    uint32_t dwRequest;             // doorbells asked by the IPC rings
+    uint32_t dwRaise;               // doorbells sent to the peer
+    uint32_t dwHeld;                // data doorbells held back
+    uint32_t dwFlushBatch;          // sent for dwBatch pending
+    uint32_t dwFlushFull;           // sent for the full APS TX ring
+    uint32_t dwFlushTimer;          // sent by the latency timer
+    uint32_t dwFlushCtrl;           // sent with a command or message
+    uint32_t dwTxDesc;              // APS TX descriptors posted
+    uint32_t dwaHighWater[IPC_BATCH_RB_MAX];    // the most entries seen in the ring
+} T_IpcBatchStat;
+
+
+void ipc_batch_init(void);
+int ipc_batch_set(uint32_t dwBatch, uint32_t dwLatencyMs);
+void ipc_batch_get(uint32_t *pdwBatch, uint32_t *pdwLatencyMs);
+void ipc_batch_flush(void);
+void ipc_batch_stat_get(T_IpcBatchStat *ptStat);
+void ipc_batch_stat_reset(void);
+uint32_t ipc_batch_rb_count(uint32_t dwRb, uint32_t *pdwTotal);
+const char *ipc_batch_rb_name(uint32_t dwRb);
+
+void ipc_batch_cmd(char *sCmd);
+
+
+#endif //#ifndef __IPC_BATCH_H__
@@ -0,0 +1,438 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "msg.h"
+#include "diag_task.h"
+#include "hal_tick.h"
+#include "hal_flash.h"
+#include "hal_flash_patch.h"
+#include "hal_flash_cache.h"
+#include "hal_flash_sched.h"
+#include "mw_fim.h"
+#include "mw_flash_svc.h"
+#include "diag_cmd_flash.h"
+
+
+#define DIAG_FLASH_PARAM_MAX            5
+
+#define DIAG_FLASH_LOG(...)             tracer_cli(LOG_HIGH_LEVEL, __VA_ARGS__)
+
+static const char *g_saDiagFlashMode[HAL_FLASH_READ_MODE_MAX] =
+{
+    "auto",
+    "fast",
+    "quad",
+    "qio",
+};
+
+static E_FlashReadMode_t g_eDiagFlashMode = HAL_FLASH_READ_MODE_AUTO;
+
+
+static int diag_flash_mode_parse(const char *sMode, E_FlashReadMode_t *peMode)
+{
+    uint32_t i = 0;
+
+    for(i = 0; i < HAL_FLASH_READ_MODE_MAX; i++)
+    {
+        if(!strcmp(sMode, g_saDiagFlashMode[i]))
+        {
+            *peMode = (E_FlashReadMode_t)i;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static void diag_flash_stat_dump(void)
+{
+    S_FlashReadStat_t tStat;
+
+    Hal_Flash_ReadStatGet(SPI_IDX_0, &tStat);
+
+    DIAG_FLASH_LOG("flashrd: mode=%s active=%s reads=%u bytes=%u qio_bytes=%u fallback=%u\n",
+                   g_saDiagFlashMode[g_eDiagFlashMode],
+                   g_saDiagFlashMode[Hal_Flash_ReadModeGet(SPI_IDX_0, 0)],
+                   tStat.u32Reads, tStat.u32Bytes, tStat.u32QuadIoBytes, tStat.u32Fallback);
+}
+
+static void diag_flash_bench(uint32_t u32Addr, uint32_t u32Size, uint32_t u32Loops)
+{
+    uint8_t *pu8Ref = NULL;
+    uint8_t *pu8Buf = NULL;
+    uint32_t u32Mode = 0;
+    uint32_t u32Start = 0;
+    uint32_t u32Ticks = 0;
+    uint32_t u32Us = 0;
+    uint32_t u32Kbps = 0;
+    uint32_t u32Err = 0;
+    uint32_t i = 0;
+    uint8_t u8Cache = Hal_Flash_CacheIsEnabled();
+
+    pu8Ref = (uint8_t *)malloc(u32Size);
+    pu8Buf = (uint8_t *)malloc(u32Size);
+
+    if((!pu8Ref) || (!pu8Buf))
+    {
+        DIAG_FLASH_LOG("flashrd: malloc fail\n");
+        goto done;
+    }
+
+    // every loop has to go to the bus
+    Hal_Flash_CacheEnable(0);
+
+    // reference data with the plain single-bit fast read
+    Hal_Flash_ReadModeSet(SPI_IDX_0, HAL_FLASH_READ_MODE_FAST);
+
+    if(Hal_Flash_AddrRead(SPI_IDX_0, u32Addr, 0, u32Size, pu8Ref))
+    {
+        DIAG_FLASH_LOG("flashrd: read fail\n");
+        goto done;
+    }
+
+    for(u32Mode = HAL_FLASH_READ_MODE_FAST; u32Mode < HAL_FLASH_READ_MODE_MAX; u32Mode++)
+    {
+        Hal_Flash_ReadModeSet(SPI_IDX_0, (E_FlashReadMode_t)u32Mode);
+        u32Err = 0;
+
+        Hal_Tick_DiffEx(0, &u32Start);
+
+        for(i = 0; i < u32Loops; i++)
+        {
+            if(Hal_Flash_AddrRead(SPI_IDX_0, u32Addr, 0, u32Size, pu8Buf))
+            {
+                u32Err++;
+            }
+        }
+
+        u32Ticks = Hal_Tick_Diff(u32Start);
+        u32Us = (uint32_t)(((uint64_t)u32Ticks * 1000) / Hal_Tick_PerMilliSec());
+
+        if(memcmp(pu8Ref, pu8Buf, u32Size))
+        {
+            u32Err++;
+        }
+
+        // bytes per ms == kB/s, in bits
+        u32Kbps = u32Us ? (uint32_t)(((uint64_t)u32Size * u32Loops * 8 * 1000) / u32Us) : 0;
+
+        DIAG_FLASH_LOG("flashrd: bench mode=%s size=%u loops=%u time_us=%u kbps=%u err=%u\n",
+                       g_saDiagFlashMode[u32Mode], u32Size, u32Loops, u32Us, u32Kbps, u32Err);
+    }
+
+done:
+    Hal_Flash_ReadModeSet(SPI_IDX_0, g_eDiagFlashMode);
+    Hal_Flash_CacheEnable(u8Cache);
+
+    if(pu8Ref)
+    {
+        free(pu8Ref);
+    }
+
+    if(pu8Buf)
+    {
+        free(pu8Buf);
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   diag_cmd_flash_read
+*
+* DESCRIPTION:
+*   diag command: flashrd [stat|mode <m>|reset|bench <addr> <size> [loops]]
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void diag_cmd_flash_read(char *sCmd)
+{
+    char *baParam[DIAG_FLASH_PARAM_MAX + 1] = {0};
+    uint32_t u32Num = 0;
+    uint32_t u32Addr = 0;
+    uint32_t u32Size = 0;
+    uint32_t u32Loops = DIAG_FLASH_BENCH_LOOPS_DEF;
+    E_FlashReadMode_t eMode = HAL_FLASH_READ_MODE_AUTO;
+
+    u32Num = ParseParam(sCmd, baParam, DIAG_FLASH_PARAM_MAX + 1);
+
+    if((u32Num < 2) || (!strcmp(baParam[1], "stat")))
+    {
+        diag_flash_stat_dump();
+    }
+    else if((!strcmp(baParam[1], "mode")) && (u32Num >= 3))
+    {
+        if(diag_flash_mode_parse(baParam[2], &eMode))
+        {
+            goto usage;
+        }
+
+        g_eDiagFlashMode = eMode;
+        Hal_Flash_ReadModeSet(SPI_IDX_0, eMode);
+        diag_flash_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "reset"))
+    {
+        Hal_Flash_ReadStatReset(SPI_IDX_0);
+        diag_flash_stat_dump();
+    }
+    else if((!strcmp(baParam[1], "bench")) && (u32Num >= 4))
+    {
+        u32Addr = strtoul(baParam[2], NULL, 0);
+        u32Size = strtoul(baParam[3], NULL, 0);
+
+        if(u32Num >= 5)
+        {
+            u32Loops = strtoul(baParam[4], NULL, 0);
+        }
+
+        if((!u32Size) || (u32Size > DIAG_FLASH_BENCH_SIZE_MAX) || (!u32Loops))
+        {
+            goto usage;
+        }
+
+        diag_flash_bench(u32Addr, u32Size, u32Loops);
+    }
+    else
+    {
+        goto usage;
+    }
+
+    return;
+
+usage:
+    DIAG_FLASH_LOG("usage: flashrd [stat|mode auto|fast|quad|qio|reset|bench <addr> <size> [loops]]\n");
+}
+
+static void diag_flash_cache_stat_dump(void)
+{
+    S_FlashCacheStat_t tStat;
+
+    Hal_Flash_CacheStatGet(&tStat);
+
+    DIAG_FLASH_LOG("flashcache: enable=%u lines=%u line_size=%u hit=%u miss=%u prefetch=%u prefetch_hit=%u bypass=%u invalidate=%u bus_reads=%u bus_bytes=%u\n",
+                   Hal_Flash_CacheIsEnabled(), HAL_FLASH_CACHE_LINE_NUM, HAL_FLASH_CACHE_LINE_SIZE,
+                   tStat.u32Hit, tStat.u32Miss, tStat.u32Prefetch, tStat.u32PrefetchHit,
+                   tStat.u32Bypass, tStat.u32Invalidate, tStat.u32BusReads, tStat.u32BusBytes);
+}
+
+static void diag_flash_cache_fim(uint32_t u32FileId, uint32_t u32Size, uint32_t u32Loops)
+{
+    uint8_t *pu8Buf = NULL;
+    uint8_t u8Enable = Hal_Flash_CacheIsEnabled();
+    uint8_t u8Pass = 0;
+    uint32_t u32Start = 0;
+    uint32_t u32Ticks = 0;
+    uint32_t u32Bytes = 0;
+    uint32_t u32Err = 0;
+    uint32_t i = 0;
+    S_FlashCacheStat_t tStat;
+
+    pu8Buf = (uint8_t *)malloc(u32Size);
+    if(!pu8Buf)
+    {
+        DIAG_FLASH_LOG("flashcache: malloc fail\n");
+        return;
+    }
+
+    // uncached first, then cached (the first cached lookup fills the lines)
+    for(u8Pass = 0; u8Pass < 2; u8Pass++)
+    {
+        Hal_Flash_CacheEnable(u8Pass);
+        Hal_Flash_CacheStatGet(&tStat);
+        u32Bytes = tStat.u32BusBytes;
+        u32Err = 0;
+
+        Hal_Tick_DiffEx(0, &u32Start);
+
+        for(i = 0; i < u32Loops; i++)
+        {
+            if(MwFim_FileRead(u32FileId, 0, u32Size, pu8Buf) != MW_FIM_OK)
+            {
+                u32Err++;
+            }
+        }
+
+        u32Ticks = Hal_Tick_Diff(u32Start);
+        Hal_Flash_CacheStatGet(&tStat);
+
+        DIAG_FLASH_LOG("flashcache: fim id=0x%08x cache=%u loops=%u avg_us=%u bus_bytes=%u err=%u\n",
+                       u32FileId, u8Pass, u32Loops,
+                       (uint32_t)(((uint64_t)u32Ticks * 1000) / Hal_Tick_PerMilliSec() / u32Loops),
+                       tStat.u32BusBytes - u32Bytes, u32Err);
+    }
+
+    Hal_Flash_CacheEnable(u8Enable);
+    free(pu8Buf);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   diag_cmd_flash_cache
+*
+* DESCRIPTION:
+*   diag command: flashcache [stat|on|off|reset|fim <id> <size> [loops]]
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void diag_cmd_flash_cache(char *sCmd)
+{
+    char *baParam[DIAG_FLASH_PARAM_MAX + 1] = {0};
+    uint32_t u32Num = 0;
+    uint32_t u32FileId = 0;
+    uint32_t u32Size = 0;
+    uint32_t u32Loops = DIAG_FLASH_BENCH_LOOPS_DEF;
+
+    u32Num = ParseParam(sCmd, baParam, DIAG_FLASH_PARAM_MAX + 1);
+
+    if((u32Num < 2) || (!strcmp(baParam[1], "stat")))
+    {
+        diag_flash_cache_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "on"))
+    {
+        Hal_Flash_CacheEnable(1);
+        diag_flash_cache_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "off"))
+    {
+        Hal_Flash_CacheEnable(0);
+        diag_flash_cache_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "reset"))
+    {
+        Hal_Flash_CacheStatReset();
+        diag_flash_cache_stat_dump();
+    }
+    else if((!strcmp(baParam[1], "fim")) && (u32Num >= 4))
+    {
+        u32FileId = strtoul(baParam[2], NULL, 0);
+        u32Size = strtoul(baParam[3], NULL, 0);
+
+        if(u32Num >= 5)
+        {
+            u32Loops = strtoul(baParam[4], NULL, 0);
+        }
+
+        if((!u32Size) || (u32Size > DIAG_FLASH_BENCH_SIZE_MAX) || (!u32Loops))
+        {
+            goto usage;
+        }
+
+        diag_flash_cache_fim(u32FileId, u32Size, u32Loops);
+    }
+    else
+    {
+        goto usage;
+    }
+
+    return;
+
+usage:
+    DIAG_FLASH_LOG("usage: flashcache [stat|on|off|reset|fim <id> <size> [loops]]\n");
+}
+
+static const char *g_saDiagFlashOp[HAL_FLASH_OP_MAX] =
+{
+    "read",
+    "program",
+    "erase",
+    "erase_bg",
+    "suspend",
+};
+
+static void diag_flash_svc_stat_dump(void)
+{
+    S_FlashSchedStat_t tSched;
+    T_MwFlashSvcStat tSvc;
+    S_FlashOpStat_t *ptOp = NULL;
+    char saHist[HAL_FLASH_SCHED_HIST_NUM * 11 + 1];
+    uint32_t u32Len = 0;
+    uint32_t i = 0;
+    uint32_t j = 0;
+
+    Hal_Flash_SchedStatGet(&tSched);
+    MwFlashSvc_StatGet(&tSvc);
+
+    DIAG_FLASH_LOG("flashsvc: erase_ahead=%u erase_demand=%u erase_later=%u erase_sync=%u writer_wait=%u start_fail=%u\n",
+                   tSvc.ulEraseAhead, tSvc.ulEraseDemand, tSvc.ulEraseLater, tSvc.ulEraseSync,
+                   tSvc.ulWriterWait, tSvc.ulStartFail);
+    DIAG_FLASH_LOG("flashsvc: suspend=%u suspend_skip=%u erase_wait=%u hist_base_us=%u\n",
+                   tSched.u32Suspend, tSched.u32SuspendSkip, tSched.u32EraseWait, HAL_FLASH_SCHED_HIST_BASE);
+
+    // hist: bucket 0 is below hist_base_us, bucket n below hist_base_us << n
+    for(i = 0; i < HAL_FLASH_OP_MAX; i++)
+    {
+        ptOp = &tSched.taOp[i];
+        u32Len = 0;
+
+        for(j = 0; j < HAL_FLASH_SCHED_HIST_NUM; j++)
+        {
+            u32Len += snprintf(&saHist[u32Len], sizeof(saHist) - u32Len, "%s%u", (j) ? "," : "", ptOp->u32aHist[j]);
+        }
+
+        DIAG_FLASH_LOG("flashsvc: op=%s count=%u avg_us=%u max_us=%u hist=%s\n",
+                       g_saDiagFlashOp[i], ptOp->u32Count,
+                       (ptOp->u32Count) ? (ptOp->u32TotalUs / ptOp->u32Count) : 0,
+                       ptOp->u32MaxUs, saHist);
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   diag_cmd_flash_svc
+*
+* DESCRIPTION:
+*   diag command: flashsvc [stat|reset]
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void diag_cmd_flash_svc(char *sCmd)
+{
+    char *baParam[DIAG_FLASH_PARAM_MAX + 1] = {0};
+    uint32_t u32Num = 0;
+
+    u32Num = ParseParam(sCmd, baParam, DIAG_FLASH_PARAM_MAX + 1);
+
+    if((u32Num < 2) || (!strcmp(baParam[1], "stat")))
+    {
+        diag_flash_svc_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "reset"))
+    {
+        Hal_Flash_SchedStatReset();
+        MwFlashSvc_StatReset();
+        diag_flash_svc_stat_dump();
+    }
+    else
+    {
+        DIAG_FLASH_LOG("usage: flashsvc [stat|reset]\n");
+    }
+}
@@ -0,0 +1,42 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#ifndef __DIAG_CMD_FLASH_H__
+#define __DIAG_CMD_FLASH_H__
+
+#define DIAG_FLASH_BENCH_SIZE_MAX       (4 * 1024)
+#define DIAG_FLASH_BENCH_LOOPS_DEF      (16)
+
+/*
+ * flashrd [stat]                       read mode and statistics of SPI0 flash
+ * flashrd mode auto|fast|quad|qio      select the read mode
+ * flashrd reset                        clear the statistics
+ * flashrd bench <addr> <size> [loops]  read throughput of every mode, checked against fast read
+ */
+void diag_cmd_flash_read(char *sCmd);
+
+/*
+ * flashcache [stat]                    read cache state and counters, bus_* count all SPI0
+ *                                      reads since boot (cold-boot traffic until reset)
+ * flashcache on|off                    enable/disable the read cache
+ * flashcache reset                     clear the counters
+ * flashcache fim <id> <size> [loops]   MW_FIM file read latency without and with the cache
+ */
+void diag_cmd_flash_cache(char *sCmd);
+
+/*
+ * flashsvc [stat]                      erase service counters and the latency histogram of
+ *                                      every SPI0 operation (log2 buckets from hist_base_us)
+ * flashsvc reset                       clear the counters
+ */
+void diag_cmd_flash_svc(char *sCmd);
+
+#endif //#ifndef __DIAG_CMD_FLASH_H__
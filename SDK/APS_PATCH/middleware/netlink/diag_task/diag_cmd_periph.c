@@ -0,0 +1,599 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "msg.h"
+#include "diag_task.h"
+#include "hal_spi_master.h"
+#include "hal_i2c_master.h"
+#include "hal_auxadc_svc.h"
+#include "hal_tick.h"
+#include "hal_temperature_internal.h"
+#include "hal_temperature_patch.h"
+#include "hal_pwm_wave.h"
+#include "diag_cmd_periph.h"
+
+
+#define DIAG_PERIPH_PARAM_MAX           (4 + HAL_AUX_SVC_CH_MAX)
+
+#define DIAG_PERIPH_LOG(...)            tracer_cli(LOG_HIGH_LEVEL, __VA_ARGS__)
+
+#define DIAG_I2C_SCAN_FIRST             0x08
+#define DIAG_I2C_SCAN_LAST              0x77
+
+#define DIAG_AUX_READ_NUM               8
+
+#define DIAG_TMPR_SWEEP_STEP            7       // ohm
+#define DIAG_TMPR_BENCH_LOOPS           1000
+
+#define DIAG_PWM_WAVE_TMR               1
+#define DIAG_PWM_WAVE_FADE_HZ           500
+#define DIAG_PWM_WAVE_FADE_SLICE_US     10000
+
+
+extern uint8_t Hal_Tmpr_CompareResistor_impl(float fResistor, float *pfTemperature);
+
+
+// played from the timer interrupt, kept until the next pwmwave command
+static S_Hal_Pwm_WaveStep_t g_taDiagPwmWaveStep[2];
+static S_Hal_Pwm_WaveSeq_t g_tDiagPwmWaveSeq;
+
+
+// the names of E_HalAux_Src_t, "gpio" takes the IO index behind it (gpio3)
+static const char *g_saDiagAuxSrc[HAL_AUX_SRC_MAX] =
+{
+    "gpio",
+    "vbat",
+    "vco",
+    "rf",
+    "temp",
+    "hpbg",
+    "lpbg",
+    "pmu",
+};
+
+
+static void diag_spi_master_stat_dump(void)
+{
+    S_SpiMasterStat_t tStat;
+    E_SpiIdx_t eIdx = SPI_IDX_1;
+    uint32_t u32Kbps = 0;
+
+    for(eIdx = SPI_IDX_1; eIdx < SPI_IDX_MAX; eIdx++)
+    {
+        Hal_Spi_MasterStatGet(eIdx, &tStat);
+
+        // frames over the time a transfer was active, 8-bit frames assumed
+        u32Kbps = (tStat.u32BusyUs) ? (uint32_t)(((uint64_t)tStat.u32Frames * 8 * 1000) / tStat.u32BusyUs) : 0;
+
+        DIAG_PERIPH_LOG("spim: port=%u busy=%u xfers=%u frames=%u irqs=%u reconfig=%u errors=%u queue_max=%u busy_us=%u kbps=%u\n",
+                        eIdx, Hal_Spi_MasterBusy(eIdx), tStat.u32Xfers, tStat.u32Frames, tStat.u32Irqs,
+                        tStat.u32Reconfig, tStat.u32Errors, tStat.u32QueueMax, tStat.u32BusyUs, u32Kbps);
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   diag_cmd_spi_master
+*
+* DESCRIPTION:
+*   diag command: spim [stat|reset]
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void diag_cmd_spi_master(char *sCmd)
+{
+    char *baParam[DIAG_PERIPH_PARAM_MAX + 1] = {0};
+    uint32_t u32Num = 0;
+
+    u32Num = ParseParam(sCmd, baParam, DIAG_PERIPH_PARAM_MAX + 1);
+
+    if((u32Num < 2) || (!strcmp(baParam[1], "stat")))
+    {
+        diag_spi_master_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "reset"))
+    {
+        Hal_Spi_MasterStatReset(SPI_IDX_1);
+        Hal_Spi_MasterStatReset(SPI_IDX_2);
+        diag_spi_master_stat_dump();
+    }
+    else
+    {
+        DIAG_PERIPH_LOG("usage: spim [stat|reset]\n");
+    }
+}
+
+static void diag_i2c_master_stat_dump(void)
+{
+    S_I2cMasterStat_t tStat;
+
+    Hal_I2c_MasterStatGet(&tStat);
+
+    DIAG_PERIPH_LOG("i2cm: busy=%u xfers=%u bytes=%u irqs=%u nack=%u arb_lost=%u timeout=%u recover=%u queue_max=%u\n",
+                    Hal_I2c_MasterBusy(), tStat.u32Xfers, tStat.u32Bytes, tStat.u32Irqs, tStat.u32Nack,
+                    tStat.u32ArbLost, tStat.u32Timeout, tStat.u32Recover, tStat.u32QueueMax);
+}
+
+static void diag_i2c_master_scan(E_I2cSpeed_t eSpeed)
+{
+    S_I2cDev_t tDev;
+    uint8_t u8Data = 0;
+    uint32_t u32Found = 0;
+    uint32_t u32Status = 0;
+
+    tDev.eAddrMode = I2C_07BIT;
+    tDev.eSpeed = eSpeed;
+
+    for(tDev.u16Addr = DIAG_I2C_SCAN_FIRST; tDev.u16Addr <= DIAG_I2C_SCAN_LAST; tDev.u16Addr++)
+    {
+        // a one byte read, absent devices do not acknowledge the address
+        u32Status = Hal_I2c_MasterWriteRead(&tDev, NULL, 0, &u8Data, 1);
+
+        if(u32Status == HAL_I2C_XFER_DONE)
+        {
+            DIAG_PERIPH_LOG("i2cm: found addr=0x%02X\n", tDev.u16Addr);
+            u32Found++;
+        }
+        else if(u32Status != HAL_I2C_XFER_NACK)
+        {
+            DIAG_PERIPH_LOG("i2cm: addr=0x%02X status=%u, stop\n", tDev.u16Addr, u32Status);
+            break;
+        }
+    }
+
+    DIAG_PERIPH_LOG("i2cm: scan found=%u\n", u32Found);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   diag_cmd_i2c_master
+*
+* DESCRIPTION:
+*   diag command: i2cm [stat|reset|scan [fast]]
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void diag_cmd_i2c_master(char *sCmd)
+{
+    char *baParam[DIAG_PERIPH_PARAM_MAX + 1] = {0};
+    uint32_t u32Num = 0;
+
+    u32Num = ParseParam(sCmd, baParam, DIAG_PERIPH_PARAM_MAX + 1);
+
+    if((u32Num < 2) || (!strcmp(baParam[1], "stat")))
+    {
+        diag_i2c_master_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "reset"))
+    {
+        Hal_I2c_MasterStatReset();
+        diag_i2c_master_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "scan"))
+    {
+        diag_i2c_master_scan(((u32Num > 2) && (!strcmp(baParam[2], "fast"))) ? I2C_SPEED_FAST : I2C_SPEED_STANDARD);
+    }
+    else
+    {
+        DIAG_PERIPH_LOG("usage: i2cm [stat|reset|scan [fast]]\n");
+    }
+}
+
+static int diag_aux_src_parse(const char *sSrc, T_HalAuxSvcCh *ptCh)
+{
+    uint32_t i = 0;
+    uint32_t u32Len = 0;
+
+    for(i = 0; i < HAL_AUX_SRC_MAX; i++)
+    {
+        u32Len = strlen(g_saDiagAuxSrc[i]);
+
+        if(strncmp(sSrc, g_saDiagAuxSrc[i], u32Len))
+            continue;
+
+        if(i == HAL_AUX_SRC_GPIO)
+        {
+            if(sSrc[u32Len] == 0)
+                return -1;
+            ptCh->ubGpioIdx = (uint8_t)strtoul(&sSrc[u32Len], NULL, 0);
+        }
+        else if(sSrc[u32Len] != 0)
+        {
+            continue;
+        }
+
+        ptCh->tSrc = (E_HalAux_Src_t)i;
+        return 0;
+    }
+
+    return -1;
+}
+
+static void diag_aux_svc_stat_dump(void)
+{
+    T_HalAuxSvcStat tStat;
+
+    Hal_Aux_SvcStatGet(&tStat);
+
+    DIAG_PERIPH_LOG("auxsvc: active=%u scan=%u convert=%u skip=%u fail=%u overrun=%u\n",
+                    Hal_Aux_SvcActive(), tStat.ulScan, tStat.ulConvert, tStat.ulSkip, tStat.ulFail, tStat.ulOverrun);
+}
+
+static void diag_aux_svc_read(uint32_t u32Max)
+{
+    T_HalAuxSvcSample taSample[DIAG_AUX_READ_NUM];
+    uint32_t u32Total = 0;
+    uint32_t u32Num = 0;
+    uint32_t i = 0;
+
+    do
+    {
+        u32Num = Hal_Aux_SvcRead(taSample, (u32Max - u32Total < DIAG_AUX_READ_NUM) ? (u32Max - u32Total) : DIAG_AUX_READ_NUM);
+
+        for(i = 0; i < u32Num; i++)
+        {
+            if(taSample[i].uwMilliVolt == HAL_AUX_SVC_MV_NONE)
+                DIAG_PERIPH_LOG("auxsvc: tick=%u ch=%u raw=%u\n", taSample[i].ulTick, taSample[i].ubCh, taSample[i].uwRaw);
+            else
+                DIAG_PERIPH_LOG("auxsvc: tick=%u ch=%u raw=%u mv=%u\n", taSample[i].ulTick, taSample[i].ubCh, taSample[i].uwRaw, taSample[i].uwMilliVolt);
+        }
+
+        u32Total += u32Num;
+    } while((u32Num == DIAG_AUX_READ_NUM) && (u32Total < u32Max));
+
+    DIAG_PERIPH_LOG("auxsvc: read=%u\n", u32Total);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   diag_cmd_aux_svc
+*
+* DESCRIPTION:
+*   diag command: auxsvc [stat|reset|stop|read [num]|start <period_ms> <oversample> <src>...]
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void diag_cmd_aux_svc(char *sCmd)
+{
+    char *baParam[DIAG_PERIPH_PARAM_MAX + 1] = {0};
+    T_HalAuxSvcCfg tCfg;
+    uint32_t u32Num = 0;
+    uint32_t i = 0;
+
+    u32Num = ParseParam(sCmd, baParam, DIAG_PERIPH_PARAM_MAX + 1);
+
+    if((u32Num < 2) || (!strcmp(baParam[1], "stat")))
+    {
+        diag_aux_svc_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "reset"))
+    {
+        Hal_Aux_SvcStatReset();
+        diag_aux_svc_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "stop"))
+    {
+        Hal_Aux_SvcStop();
+        diag_aux_svc_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "read"))
+    {
+        diag_aux_svc_read((u32Num > 2) ? strtoul(baParam[2], NULL, 0) : HAL_AUX_SVC_RING_NUM);
+    }
+    else if((!strcmp(baParam[1], "start")) && (u32Num > 4))
+    {
+        memset(&tCfg, 0, sizeof(tCfg));
+        tCfg.ulPeriodMs = strtoul(baParam[2], NULL, 0);
+        tCfg.ubOversample = (uint8_t)strtoul(baParam[3], NULL, 0);
+        tCfg.ubDiscard = 1;
+
+        for(i = 4; (i < u32Num) && (tCfg.ubChNum < HAL_AUX_SVC_CH_MAX); i++)
+        {
+            if(diag_aux_src_parse(baParam[i], &tCfg.taCh[tCfg.ubChNum]))
+            {
+                DIAG_PERIPH_LOG("auxsvc: unknown source %s\n", baParam[i]);
+                return;
+            }
+            tCfg.ubChNum++;
+        }
+
+        if(HAL_AUX_OK != Hal_Aux_SvcStart(&tCfg))
+        {
+            DIAG_PERIPH_LOG("auxsvc: start fail\n");
+            return;
+        }
+
+        diag_aux_svc_stat_dump();
+    }
+    else
+    {
+        DIAG_PERIPH_LOG("usage: auxsvc [stat|reset|stop|read [num]|start <period_ms> <oversample> <src>...]\n");
+    }
+}
+
+static int32_t diag_tmpr_float_to_milli(float fValue)
+{
+    return (fValue < 0) ? (int32_t)(fValue * 1000 - 0.5f) : (int32_t)(fValue * 1000 + 0.5f);
+}
+
+// compare the integer conversion with the float one of the ROM over the whole table
+static void diag_tmpr_sweep(void)
+{
+    uint32_t u32Min = 0;
+    uint32_t u32Max = 0;
+    uint32_t u32Res = 0;
+    uint32_t u32Num = 0;
+    uint32_t u32DiffMax = 0;
+    uint32_t u32DiffRes = 0;
+    uint32_t u32Diff = 0;
+    int32_t s32Fix = 0;
+    float fTemp = 0;
+
+    u32Max = (uint32_t)(g_tHalTmpr_CalData.faThermistor[0] * HAL_TMPR_FIX_OHM_PER_UNIT) + HAL_TMPR_FIX_OHM_PER_UNIT;
+    u32Min = (uint32_t)(g_tHalTmpr_CalData.faThermistor[HAL_TMPR_STEP_MAX - 1] * HAL_TMPR_FIX_OHM_PER_UNIT);
+    u32Min = (u32Min > HAL_TMPR_FIX_OHM_PER_UNIT) ? (u32Min - HAL_TMPR_FIX_OHM_PER_UNIT) : 0;
+
+    for(u32Res = u32Min; u32Res <= u32Max; u32Res += DIAG_TMPR_SWEEP_STEP)
+    {
+        if(HAL_TMPR_OK != Hal_Tmpr_CompareResistorFix(u32Res, &s32Fix))
+        {
+            DIAG_PERIPH_LOG("tmpr: no integer table\n");
+            return;
+        }
+
+        Hal_Tmpr_CompareResistor_impl((float)u32Res / HAL_TMPR_FIX_OHM_PER_UNIT, &fTemp);
+
+        u32Diff = (uint32_t)abs(diag_tmpr_float_to_milli(fTemp) - s32Fix);
+
+        if(u32Diff > u32DiffMax)
+        {
+            u32DiffMax = u32Diff;
+            u32DiffRes = u32Res;
+        }
+
+        u32Num++;
+    }
+
+    DIAG_PERIPH_LOG("tmpr: sweep ohm=%u~%u points=%u max_diff_mdeg=%u at_ohm=%u\n", u32Min, u32Max, u32Num, u32DiffMax, u32DiffRes);
+}
+
+static void diag_tmpr_bench(uint32_t u32Loops)
+{
+    uint32_t u32Res = 0;
+    uint32_t u32Start = 0;
+    uint32_t u32Float = 0;
+    uint32_t u32Fix = 0;
+    uint32_t i = 0;
+    int32_t s32Fix = 0;
+    float fTemp = 0;
+
+    if(!u32Loops)
+        u32Loops = DIAG_TMPR_BENCH_LOOPS;
+
+    // the middle of the table, the float one walks half of it
+    u32Res = (uint32_t)(g_tHalTmpr_CalData.faThermistor[HAL_TMPR_STEP_MAX / 2] * HAL_TMPR_FIX_OHM_PER_UNIT);
+
+    Hal_Tick_DiffEx(0, &u32Start);
+
+    for(i = 0; i < u32Loops; i++)
+    {
+        Hal_Tmpr_CompareResistor_impl((float)(u32Res + (i & 0xFF)) / HAL_TMPR_FIX_OHM_PER_UNIT, &fTemp);
+    }
+
+    u32Float = Hal_Tick_Diff(u32Start);
+
+    Hal_Tick_DiffEx(0, &u32Start);
+
+    for(i = 0; i < u32Loops; i++)
+    {
+        Hal_Tmpr_CompareResistorFix(u32Res + (i & 0xFF), &s32Fix);
+    }
+
+    u32Fix = Hal_Tick_Diff(u32Start);
+
+    // the tick of hal_tick is the core clock
+    DIAG_PERIPH_LOG("tmpr: bench loops=%u float_cycles=%u fix_cycles=%u\n", u32Loops, u32Float / u32Loops, u32Fix / u32Loops);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   diag_cmd_tmpr
+*
+* DESCRIPTION:
+*   diag command: tmpr [<gpio>|offset [<mdeg>]|sweep|bench [loops]]
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void diag_cmd_tmpr(char *sCmd)
+{
+    char *baParam[DIAG_PERIPH_PARAM_MAX + 1] = {0};
+    uint32_t u32Num = 0;
+    int32_t s32Value = 0;
+
+    u32Num = ParseParam(sCmd, baParam, DIAG_PERIPH_PARAM_MAX + 1);
+
+    if(u32Num < 2)
+    {
+        DIAG_PERIPH_LOG("usage: tmpr [<gpio>|offset [<mdeg>]|sweep|bench [loops]]\n");
+    }
+    else if(!strcmp(baParam[1], "offset"))
+    {
+        if((u32Num > 2) && (HAL_TMPR_OK != Hal_Tmpr_OffsetSet(strtol(baParam[2], NULL, 0))))
+        {
+            DIAG_PERIPH_LOG("tmpr: offset write fail\n");
+            return;
+        }
+
+        DIAG_PERIPH_LOG("tmpr: offset_mdeg=%d\n", Hal_Tmpr_OffsetGet());
+    }
+    else if(!strcmp(baParam[1], "sweep"))
+    {
+        diag_tmpr_sweep();
+    }
+    else if(!strcmp(baParam[1], "bench"))
+    {
+        diag_tmpr_bench((u32Num > 2) ? strtoul(baParam[2], NULL, 0) : DIAG_TMPR_BENCH_LOOPS);
+    }
+    else
+    {
+        if(HAL_TMPR_OK != Hal_Tmpr_MilliDegreeGet((uint8_t)strtoul(baParam[1], NULL, 0), &s32Value))
+        {
+            DIAG_PERIPH_LOG("tmpr: read fail\n");
+            return;
+        }
+
+        DIAG_PERIPH_LOG("tmpr: mdeg=%d offset_mdeg=%d\n", s32Value, Hal_Tmpr_OffsetGet());
+    }
+}
+
+static void diag_pwm_wave_stat_dump(void)
+{
+    S_Hal_Pwm_WaveStat_t tStat;
+
+    Hal_Pwm_WaveStatGet(DIAG_PWM_WAVE_TMR, &tStat);
+
+    DIAG_PERIPH_LOG("pwmwave: tmr=%u active=%u slices=%u seq_done=%u late_max_us=%u apply_fail=%u\n",
+                    DIAG_PWM_WAVE_TMR, Hal_Pwm_WaveActive(DIAG_PWM_WAVE_TMR), tStat.ulSlices, tStat.ulSeqDone, tStat.ulLateMaxUs,
+                    tStat.ulApplyFail);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   diag_cmd_pwm_wave
+*
+* DESCRIPTION:
+*   diag command: pwmwave [stat|reset|stop|fade <mask> <ms>|pulse <mask> <hz> <on_us> <off_us> <count>]
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void diag_cmd_pwm_wave(char *sCmd)
+{
+    char *baParam[DIAG_PERIPH_PARAM_MAX + 1] = {0};
+    S_Hal_Pwm_WaveStep_t *ptStep = g_taDiagPwmWaveStep;
+    uint32_t u32Num = 0;
+    uint32_t u32Slices = 0;
+    uint8_t u8Mask = 0;
+
+    u32Num = ParseParam(sCmd, baParam, DIAG_PERIPH_PARAM_MAX + 1);
+
+    if((u32Num < 2) || (!strcmp(baParam[1], "stat")))
+    {
+        diag_pwm_wave_stat_dump();
+        return;
+    }
+    else if(!strcmp(baParam[1], "reset"))
+    {
+        Hal_Pwm_WaveStatReset(DIAG_PWM_WAVE_TMR);
+        diag_pwm_wave_stat_dump();
+        return;
+    }
+    else if(!strcmp(baParam[1], "stop"))
+    {
+        Hal_Pwm_WaveStop(DIAG_PWM_WAVE_TMR);
+        diag_pwm_wave_stat_dump();
+        return;
+    }
+
+    Hal_Pwm_WaveStop(DIAG_PWM_WAVE_TMR);
+    memset(g_taDiagPwmWaveStep, 0, sizeof(g_taDiagPwmWaveStep));
+    memset(&g_tDiagPwmWaveSeq, 0, sizeof(g_tDiagPwmWaveSeq));
+
+    if((!strcmp(baParam[1], "fade")) && (u32Num > 3))
+    {
+        // up and down, each half of the period, until stopped
+        u8Mask = (uint8_t)strtoul(baParam[2], NULL, 0);
+        u32Slices = (strtoul(baParam[3], NULL, 0) * 1000 / 2) / DIAG_PWM_WAVE_FADE_SLICE_US;
+        u32Slices = (u32Slices < 2) ? 2 : ((u32Slices > 0xFFFF) ? 0xFFFF : u32Slices);
+
+        ptStep[0].ulHz = DIAG_PWM_WAVE_FADE_HZ;
+        ptStep[0].ulSliceUs = DIAG_PWM_WAVE_FADE_SLICE_US;
+        ptStep[0].uwSlices = (uint16_t)u32Slices;
+        ptStep[0].ubIdxMask = u8Mask;
+        ptStep[0].ubDuty = 0;
+        ptStep[0].ubDutyEnd = 100;
+
+        ptStep[1] = ptStep[0];
+        ptStep[1].ubDuty = 100;
+        ptStep[1].ubDutyEnd = 0;
+
+        g_tDiagPwmWaveSeq.ulRepeat = 0;
+        g_tDiagPwmWaveSeq.ubFlags = HAL_PWM_WAVE_SYNC_START;
+    }
+    else if((!strcmp(baParam[1], "pulse")) && (u32Num > 6))
+    {
+        // a burst of the carrier, then a gap, count times
+        u8Mask = (uint8_t)strtoul(baParam[2], NULL, 0);
+
+        ptStep[0].ulHz = strtoul(baParam[3], NULL, 0);
+        ptStep[0].ulSliceUs = strtoul(baParam[4], NULL, 0);
+        ptStep[0].uwSlices = 1;
+        ptStep[0].ubIdxMask = u8Mask;
+        ptStep[0].ubDuty = 50;
+        ptStep[0].ubDutyEnd = 50;
+
+        ptStep[1] = ptStep[0];
+        ptStep[1].ulSliceUs = strtoul(baParam[5], NULL, 0);
+        ptStep[1].ubDuty = 0;
+        ptStep[1].ubDutyEnd = 0;
+
+        g_tDiagPwmWaveSeq.ulRepeat = strtoul(baParam[6], NULL, 0);
+        g_tDiagPwmWaveSeq.ubFlags = HAL_PWM_WAVE_SYNC_START;
+
+        if(!g_tDiagPwmWaveSeq.ulRepeat)
+            g_tDiagPwmWaveSeq.ulRepeat = 1;
+    }
+    else
+    {
+        DIAG_PERIPH_LOG("usage: pwmwave [stat|reset|stop|fade <mask> <ms>|pulse <mask> <hz> <on_us> <off_us> <count>]\n");
+        return;
+    }
+
+    g_tDiagPwmWaveSeq.ptStep = g_taDiagPwmWaveStep;
+    g_tDiagPwmWaveSeq.ulStepNum = 2;
+
+    if(HAL_PWM_RET_PASS != Hal_Pwm_WaveStart(DIAG_PWM_WAVE_TMR, &g_tDiagPwmWaveSeq))
+    {
+        DIAG_PERIPH_LOG("pwmwave: start fail\n");
+        return;
+    }
+
+    diag_pwm_wave_stat_dump();
+}
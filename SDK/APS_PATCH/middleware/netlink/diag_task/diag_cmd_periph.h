@@ -0,0 +1,59 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#ifndef __DIAG_CMD_PERIPH_H__
+#define __DIAG_CMD_PERIPH_H__
+
+/*
+ * spim [stat]                          queued transfer counters of SPI1/SPI2 (ports not
+ *                                      opened by Hal_Spi_MasterInit read as 0)
+ * spim reset                           clear the counters
+ */
+void diag_cmd_spi_master(char *sCmd);
+
+/*
+ * i2cm [stat]                          queued I2C master transaction counters
+ * i2cm reset                           clear the counters
+ * i2cm scan [fast]                     one byte read from 0x08..0x77, list the devices that
+ *                                      acknowledge (Hal_I2c_MasterEngineInit must have run)
+ */
+void diag_cmd_i2c_master(char *sCmd);
+
+/*
+ * auxsvc [stat]                        AUXADC sampling service counters
+ * auxsvc start <period_ms> <oversample> <src>...
+ *                                      scan the sources every period, src is vbat|vco|rf|temp|
+ *                                      hpbg|lpbg|pmu or gpio<n> (gpio3)
+ * auxsvc read [num]                    take samples out of the ring buffer
+ * auxsvc stop                          stop and power the AUXADC down
+ * auxsvc reset                         clear the counters
+ */
+void diag_cmd_aux_svc(char *sCmd);
+
+/*
+ * tmpr <gpio>                          temperature of the thermistor on the IO, milli-degree
+ * tmpr offset [<mdeg>]                 show or set (and write to MW_FIM) the calibration offset
+ * tmpr sweep                           compare the integer conversion with the float one
+ * tmpr bench [loops]                   cycles per conversion of both
+ */
+void diag_cmd_tmpr(char *sCmd);
+
+/*
+ * pwmwave [stat]                       waveform counters of Timer1
+ * pwmwave fade <mask> <ms>             fade the channels up and down, one round per <ms>
+ * pwmwave pulse <mask> <hz> <on_us> <off_us> <count>
+ *                                      pulse train: <on_us> of 50% duty, <off_us> low, <count> times
+ * pwmwave stop                         stop the waveform and the channels
+ * pwmwave reset                        clear the counters
+ */
+void diag_cmd_pwm_wave(char *sCmd);
+
+#endif //#ifndef __DIAG_CMD_PERIPH_H__
@@ -0,0 +1,157 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "msg.h"
+#include "diag_task.h"
+#include "diag_cmd_table_ext.h"
+#include "lwip_bench.h"
+#include "mem_if_patch.h"
+#include "tcp_if_patch.h"
+#include "net_stats.h"
+#include "diag_cmd_flash.h"
+#include "diag_cmd_periph.h"
+#include "ipc_batch.h"
+#include "wifi_scan_cache.h"
+#include "wifi_pwr_policy.h"
+#include "sys_fault.h"
+#include "sys_cpu_stat.h"
+#include "sys_heap_stat.h"
+#include "sys_stack.h"
+#include "sys_boot.h"
+#include "sys_wdt.h"
+#include "mw_log_flash.h"
+#include "mw_fs.h"
+#include "scrt_aead.h"
+#include "mw_crypto_test.h"
+
+
+static ParseUnknownCommand_fp_t g_fpDiagCmdExtUnknown = NULL;
+
+static void diag_cmd_ext_help(char *sCmd);
+
+/**
+  * @brief extern diag command table for all modules
+  *
+  */
+T_DiagCmdExt gDiagCmdTbl_ext[] =
+{
+    { "exthelp",        diag_cmd_ext_help,      "List the extended diag commands" },
+    { "lwipbench",      lwip_bench_cmd,         "lwIP loopback throughput/latency/memory benchmark" },
+    { "lwipmem",        lwip_mem_patch_cmd,     "lwIP mem_malloc pool statistics and profile" },
+    { "tcptune",        tcp_autotune_cmd,       "TCP window/send buffer autotuning state" },
+    { "netstats",       net_stats_cmd,          "Network statistics: netif/lwIP/IPC counters" },
+    { "ipcbatch",       ipc_batch_cmd,          "IPC doorbell coalescing, ring high-water marks" },
+    { "scancache",      wifi_scan_cache_cmd,    "Wi-Fi scan cache and channel-targeted reconnect" },
+    { "wifipwr",        wifi_pwr_policy_cmd,    "Adaptive DTIM skip policy, latency budget and awake estimate" },
+    { "flashrd",        diag_cmd_flash_read,    "SPI flash read mode, statistics and benchmark" },
+    { "flashcache",     diag_cmd_flash_cache,   "SPI flash read cache statistics and MW_FIM lookup timing" },
+    { "flashsvc",       diag_cmd_flash_svc,     "SPI flash erase service counters and operation latency" },
+    { "spim",           diag_cmd_spi_master,    "SPI1/SPI2 queued transfer counters and throughput" },
+    { "i2cm",           diag_cmd_i2c_master,    "I2C master transaction counters and bus scan" },
+    { "auxsvc",         diag_cmd_aux_svc,       "AUXADC periodic sampling service" },
+    { "tmpr",           diag_cmd_tmpr,          "Temperature sensor, offset and conversion check" },
+    { "pwmwave",        diag_cmd_pwm_wave,      "Timer-driven PWM fade and pulse trains" },
+    { "crash",          Sys_FaultCmd,           "Crash record of the last fault or watchdog timeout" },
+    { "top",            Sys_CpuStatCmd,         "CPU usage per task, context switches and ISR time" },
+    { "heap",           Sys_HeapStatCmd,        "Heap free, largest block, fragmentation, live bytes per site and task" },
+    { "stack",          Sys_StackCmd,           "Stack high-water mark per task and the worst case of all boots" },
+    { "boot",           Sys_BootCmd,            "Boot timeline, the M0 wait and the init steps" },
+    { "wdt",            Sys_WdtCmd,             "Watchdog supervisor clients, deadlines and misses" },
+    { "logflash",       MwLogFlash_Cmd,         "Tracer lines kept in flash, dump and erase" },
+    { "fs",             MwFs_Cmd,               "File system of the user data, bench and power-loss stress" },
+    { "tlsaead",        mbedtls_scrt_aead_cmd,  "TLS AES-CCM/GCM records on SCRT, test and bench" },
+    { "crypto",         MwCryptoTest_Cmd,       "Crypto known-answer tests and benchmark on SCRT, mbedTLS and tinycrypt" },
+    { NULL,             NULL,                   NULL },
+};
+
+static void diag_cmd_ext_help(char *sCmd)
+{
+    T_DiagCmdExt *ptCmd = NULL;
+
+    (void)sCmd;
+
+    tracer_cli(LOG_HIGH_LEVEL, "\n");
+
+    for(ptCmd = gDiagCmdTbl_ext; ptCmd->sCmd; ptCmd++)
+    {
+        tracer_cli(LOG_HIGH_LEVEL, "%-16s %s\n", ptCmd->sCmd, ptCmd->sUsage);
+    }
+}
+
+/*
+ * Compare the first token of the command line without modifying it, so the
+ * line can still be handed to the original handler if no entry matches.
+ */
+static T_DiagCmdExt *diag_cmd_ext_find(char *sCmd)
+{
+    T_DiagCmdExt *ptCmd = NULL;
+    uint32_t u32Len = 0;
+    char cEnd = 0;
+
+    if(!sCmd)
+    {
+        goto done;
+    }
+
+    while((*sCmd == ' ') || (*sCmd == '\t'))
+    {
+        sCmd++;
+    }
+
+    for(ptCmd = gDiagCmdTbl_ext; ptCmd->sCmd; ptCmd++)
+    {
+        u32Len = strlen(ptCmd->sCmd);
+
+        if(strncmp(sCmd, ptCmd->sCmd, u32Len))
+        {
+            continue;
+        }
+
+        cEnd = sCmd[u32Len];
+
+        if((cEnd == 0) || (cEnd == ' ') || (cEnd == '\t') || (cEnd == '\r') || (cEnd == '\n'))
+        {
+            return ptCmd;
+        }
+    }
+
+done:
+    return NULL;
+}
+
+static void ParseUnknownCommand_patch(char *sCmd)
+{
+    T_DiagCmdExt *ptCmd = diag_cmd_ext_find(sCmd);
+
+    if(ptCmd)
+    {
+        ptCmd->fpHandler(sCmd);
+        return;
+    }
+
+    if(g_fpDiagCmdExtUnknown)
+    {
+        g_fpDiagCmdExtUnknown(sCmd);
+    }
+}
+
+void diag_cmd_ext_init_patch(void)
+{
+    if(ParseUnknownCommand != ParseUnknownCommand_patch)
+    {
+        g_fpDiagCmdExtUnknown = ParseUnknownCommand;
+        ParseUnknownCommand = ParseUnknownCommand_patch;
+    }
+}
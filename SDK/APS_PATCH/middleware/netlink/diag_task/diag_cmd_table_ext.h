@@ -0,0 +1,38 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#ifndef __DIAG_CMD_TABLE_EXT_H__
+#define __DIAG_CMD_TABLE_EXT_H__
+
+#include "diag_task.h"
+
+/*
+ * The extended diag commands are looked up by the first token of the command
+ * line. Any command that is not in the table is passed back to the original
+ * ParseUnknownCommand handler.
+ */
+typedef void (*T_DiagCmdExtFp)(char *sCmd);
+
+typedef struct
+{
+    const char      *sCmd;
+    T_DiagCmdExtFp  fpHandler;
+    const char      *sUsage;
+} T_DiagCmdExt;
+
+extern T_DiagCmdExt gDiagCmdTbl_ext[];
+
+/*
+   Interface Initialization: DIAG extended command table
+ */
+void diag_cmd_ext_init_patch(void);
+
+#endif
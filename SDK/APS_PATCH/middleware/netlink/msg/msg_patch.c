@@ -25,6 +25,8 @@
 #include "sys_os_config_patch.h"
 #include "mw_fim.h"
 #include "mw_fim_default_group01_patch.h"
+#include "sys_fault.h"
+#include "mw_log_flash.h"
 
 
 #define TRACER_GET_MSG_LEN
@@ -419,6 +421,17 @@ int tracer_msg_patch(uint8_t bType, uint8_t bLevel, char *sFmt, ...)
         goto done;
     }
 
+    // the flash log keeps the lines of the task levels in every mode
+    if((bType == TRACER_TYPE_LOG) && (MwLogFlash_LevelCheck(bLevel)))
+    {
+        if((!tracer_level_get_ext(tracer_task_handle_get(&bIsr), &bTaskLevel)) && (bLevel & bTaskLevel))
+        {
+            va_start(tList, sFmt);
+            MwLogFlash_VPut(bLevel, sFmt, tList);
+            va_end(tList);
+        }
+    }
+
     if(g_bTracerLogMode == TRACER_MODE_DISABLE)
     {
         goto done;
@@ -565,6 +578,9 @@ int tracer_msg_patch(uint8_t bType, uint8_t bLevel, char *sFmt, ...)
         ptMsg->ptCb->tInfo.bType = bType;
         ptMsg->ptCb->tInfo.bLevel = bTaskLevel;
         ptMsg->ptCb->tInfo.dwHandle = dwHandle;
+
+        // the last lines go to the crash record
+        Sys_FaultTraceAdd(ptMsg->ptCb->baBuf);
     }
 
     if(osMessagePut(g_tTracerQueueId, (uint32_t)ptMsg, 0) != osOK)
@@ -0,0 +1,2631 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  mw_crypto_test.c
+*
+*  Project:
+*  --------
+*  OPL1000 Project - the crypto self-test and benchmark implement file
+*
+*  Description:
+*  ------------
+*  This implement file is include the crypto self-test and benchmark function
+*  and api.
+*
+*  The vectors: FIPS-197 C.1 (AES), SP 800-38A F.2.1 / F.5.1 (CBC, CTR),
+*  RFC 3610 packet 1 (CCM), GCM test case 2, FIPS 180-2 "abc" (SHA),
+*  RFC 2202 / RFC 4231 case 2 (HMAC), BLE Core 7.1.2.1 P-256 data set 1
+*  (ECDH), the NIST CTR_DRBG vector of the self test of mbedtls, RFC 6070
+*  (PBKDF2-HMAC-SHA1) and RFC 7914 11 (PBKDF2-HMAC-SHA256).
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "sys_os_config_patch.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "hal_tick.h"
+#include "scrt.h"
+
+#include "tinycrypt/constants.h"
+#include "tinycrypt/aes.h"
+#include "tinycrypt/cbc_mode.h"
+#include "tinycrypt/ctr_mode.h"
+#include "tinycrypt/ccm_mode.h"
+#include "tinycrypt/sha256.h"
+#include "tinycrypt/hmac.h"
+#include "tinycrypt/hmac_prng.h"
+#include "tinycrypt/ecc.h"
+#include "tinycrypt/ecc_dh.h"
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+#include "mbedtls/aes.h"
+#include "mbedtls/md.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/ctr_drbg.h"
+#if defined(MBEDTLS_CCM_C)
+#include "mbedtls/ccm.h"
+#endif
+#if defined(MBEDTLS_GCM_C)
+#include "mbedtls/gcm.h"
+#endif
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+#include "mbedtls/ecdh.h"
+#define MW_CRYPTO_TEST_MBEDTLS_ECDH
+#endif
+
+#include "mw_crypto_test.h"
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define MW_CRYPTO_TEST_CASE_OK          0
+#define MW_CRYPTO_TEST_CASE_FAIL        -1
+#define MW_CRYPTO_TEST_CASE_NA          1           // the provider is not ready
+
+#define MW_CRYPTO_TEST_KAT_PASS         0
+#define MW_CRYPTO_TEST_KAT_FAIL         1
+#define MW_CRYPTO_TEST_KAT_NA           2
+#define MW_CRYPTO_TEST_KAT_SKIP         3           // not run
+
+#define MW_CRYPTO_TEST_PAD              32          // the IV of tinycrypt CBC, the tag, the token word of the engine
+#define MW_CRYPTO_TEST_SCRT_PAD         4           // the engine writes a token word after the data
+#define MW_CRYPTO_TEST_STACK_FILL       0xC5C5C5C5  // not SYS_STACK_FILL, the task stack is filled with it already
+#define MW_CRYPTO_TEST_STACK_GAP        32          // words between the caller and the painted area
+
+#define MW_CRYPTO_TEST_CCM_NONCE_LEN    13          // the only nonce of tinycrypt
+#define MW_CRYPTO_TEST_CCM_TAG_LEN      8
+#define MW_CRYPTO_TEST_GCM_IV_LEN       12
+#define MW_CRYPTO_TEST_GCM_TAG_LEN      16
+#define MW_CRYPTO_TEST_ECC_LEN          32
+#define MW_CRYPTO_TEST_MAC_MAX          32
+#define MW_CRYPTO_TEST_SALT_MAX         32
+#define MW_CRYPTO_TEST_SCRT_KEY_MAX     64          // the HMAC key is copied to the mailbox
+#define MW_CRYPTO_TEST_PBKDF2_ITER      4096        // the cost of a WPA2 passphrase
+#define MW_CRYPTO_TEST_PBKDF2_LEN       32
+#define MW_CRYPTO_TEST_PRNG_SEED_LEN    32
+
+#define MW_CRYPTO_TEST_PARAM_MAX        4
+
+#define MW_CRYPTO_TEST_IN               ((uint8_t *)g_ulaMwCryptoTestIn)
+#define MW_CRYPTO_TEST_OUT              ((uint8_t *)g_ulaMwCryptoTestOut)
+
+#define MW_CRYPTO_TEST_CRIT_ENTER(x)    do { x = __get_PRIMASK(); __disable_irq(); } while(0)
+#define MW_CRYPTO_TEST_CRIT_EXIT(x)     __set_PRIMASK(x)
+
+
+/******************************
+Declaration of data structure
+******************************/
+// Sec 3: structure, uniou, enum, linked list
+typedef int (*T_MwCryptoTestFp)(const void *pArg);
+
+// 0: success
+typedef int (*T_MwCryptoTestHmacFp)(const uint8_t *pubKey, uint32_t ulKeyLen,
+                                    const uint8_t *pubData, uint32_t ulLen, uint8_t *pubMac);
+
+typedef struct
+{
+    const char *sAlgo;
+    const char *sProv;
+    uint32_t ulUnit;                // bytes of an operation, 0: latency only
+    T_MwCryptoTestFp fpKat;
+    T_MwCryptoTestFp fpOp;          // one operation of the benchmark
+    const void *pArg;
+} T_MwCryptoTestCase;
+
+// a HMAC provider, for the HMAC and PBKDF2 cases
+typedef struct
+{
+    T_MwCryptoTestHmacFp fpHmac;
+    uint32_t ulLen;                 // bytes of the MAC
+    const uint8_t *pubHmacKat;      // the MAC of RFC 2202 / RFC 4231 case 2
+    const char *sPass;              // the PBKDF2 vector
+    const char *sSalt;
+    uint32_t ulIter;
+    const uint8_t *pubPbkdf2Kat;
+    uint32_t ulPbkdf2Len;
+} T_MwCryptoTestMac;
+
+typedef struct
+{
+    const uint8_t *pubData;
+    uint32_t ulLen;
+    uint32_t ulOff;
+} T_MwCryptoTestEntropy;
+
+typedef struct
+{
+    uint8_t ubKat;                  // MW_CRYPTO_TEST_KAT_xxx
+    uint32_t ulOps;                 // operations of the benchmark, 0: not run
+    uint32_t ulUs;
+    uint32_t ulStack;               // bytes, 0: not measured
+} T_MwCryptoTestResult;
+
+typedef struct
+{
+    uint32_t ulMode;
+    uint32_t ulBenchMs;
+    char sFilter[MW_CRYPTO_TEST_FILTER_MAX + 1];    // "": all cases
+} T_MwCryptoTestReq;
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+
+// Sec 5: declaration of global function prototype
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static uint8_t g_ubMwCryptoTestBusy;
+static T_MwCryptoTestReq g_tMwCryptoTestReq;
+
+static uint32_t g_ulaMwCryptoTestIn[(MW_CRYPTO_TEST_BUF_SIZE + MW_CRYPTO_TEST_PAD) / 4];
+static uint32_t g_ulaMwCryptoTestOut[(MW_CRYPTO_TEST_BUF_SIZE + MW_CRYPTO_TEST_PAD) / 4];
+
+// FIPS-197 C.1
+static const uint8_t g_ubaMwCryptoTestAesKey[16] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+static const uint8_t g_ubaMwCryptoTestAesPt[16] =
+{
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+static const uint8_t g_ubaMwCryptoTestAesCt[16] =
+{
+    0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+
+// SP 800-38A F.2.1 and F.5.1, the first block
+static const uint8_t g_ubaMwCryptoTestModeKey[16] =
+{
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+static const uint8_t g_ubaMwCryptoTestModePt[16] =
+{
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a
+};
+static const uint8_t g_ubaMwCryptoTestCbcIv[16] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+static const uint8_t g_ubaMwCryptoTestCbcCt[16] =
+{
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d
+};
+static const uint8_t g_ubaMwCryptoTestCtr[16] =
+{
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+};
+static const uint8_t g_ubaMwCryptoTestCtrCt[16] =
+{
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce
+};
+
+// RFC 3610 packet vector #1
+static const uint8_t g_ubaMwCryptoTestCcmKey[16] =
+{
+    0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf
+};
+static const uint8_t g_ubaMwCryptoTestCcmNonce[MW_CRYPTO_TEST_CCM_NONCE_LEN] =
+{
+    0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5
+};
+static const uint8_t g_ubaMwCryptoTestCcmAad[8] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07
+};
+static const uint8_t g_ubaMwCryptoTestCcmPt[23] =
+{
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+    0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e
+};
+static const uint8_t g_ubaMwCryptoTestCcmCt[23] =
+{
+    0x58, 0x8c, 0x97, 0x9a, 0x61, 0xc6, 0x63, 0xd2, 0xf0, 0x66, 0xd0, 0xc2, 0xc0, 0xf9, 0x89, 0x80,
+    0x6d, 0x5f, 0x6b, 0x61, 0xda, 0xc3, 0x84
+};
+static const uint8_t g_ubaMwCryptoTestCcmTag[MW_CRYPTO_TEST_CCM_TAG_LEN] =
+{
+    0x17, 0xe8, 0xd1, 0x2c, 0xfd, 0xf9, 0x26, 0xe0
+};
+
+#if defined(MBEDTLS_GCM_C)
+// GCM test case 2: the key, the IV and the plain text are all zero
+static const uint8_t g_ubaMwCryptoTestGcmCt[16] =
+{
+    0x03, 0x88, 0xda, 0xce, 0x60, 0xb6, 0xa3, 0x92, 0xf3, 0x28, 0xc2, 0xb9, 0x71, 0xb2, 0xfe, 0x78
+};
+static const uint8_t g_ubaMwCryptoTestGcmTag[MW_CRYPTO_TEST_GCM_TAG_LEN] =
+{
+    0xab, 0x6e, 0x47, 0xd4, 0x2c, 0xec, 0x13, 0xbd, 0xf5, 0x3a, 0x67, 0xb2, 0x12, 0x57, 0xbd, 0xdf
+};
+#endif
+
+// "abc"
+static const uint8_t g_ubaMwCryptoTestSha1[20] =
+{
+    0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e, 0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c,
+    0x9c, 0xd0, 0xd8, 0x9d
+};
+static const uint8_t g_ubaMwCryptoTestSha256[32] =
+{
+    0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+    0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+};
+
+// HMAC case 2: the key "Jefe"
+static const char g_sMwCryptoTestHmacKey[] = "Jefe";
+static const char g_sMwCryptoTestHmacData[] = "what do ya want for nothing?";
+static const uint8_t g_ubaMwCryptoTestHmacSha1[20] =
+{
+    0xef, 0xfc, 0xdf, 0x6a, 0xe5, 0xeb, 0x2f, 0xa2, 0xd2, 0x74, 0x16, 0xd5, 0xf1, 0x84, 0xdf, 0x9c,
+    0x25, 0x9a, 0x7c, 0x79
+};
+static const uint8_t g_ubaMwCryptoTestHmacSha256[32] =
+{
+    0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7,
+    0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83, 0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43
+};
+
+// RFC 6070: "password", "salt", 2 iterations
+static const uint8_t g_ubaMwCryptoTestPbkdf2Sha1[20] =
+{
+    0xea, 0x6c, 0x01, 0x4d, 0xc7, 0x2d, 0x6f, 0x8c, 0xcd, 0x1e, 0xd9, 0x2a, 0xce, 0x1d, 0x41, 0xf0,
+    0xd8, 0xde, 0x89, 0x57
+};
+// RFC 7914 11: "passwd", "salt", 1 iteration, two blocks
+static const uint8_t g_ubaMwCryptoTestPbkdf2Sha256[64] =
+{
+    0x55, 0xac, 0x04, 0x6e, 0x56, 0xe3, 0x08, 0x9f, 0xec, 0x16, 0x91, 0xc2, 0x25, 0x44, 0xb6, 0x05,
+    0xf9, 0x41, 0x85, 0x21, 0x6d, 0xde, 0x04, 0x65, 0xe6, 0x8b, 0x9d, 0x57, 0xc2, 0x0d, 0xac, 0xbc,
+    0x49, 0xca, 0x9c, 0xcc, 0xf1, 0x79, 0xb6, 0x45, 0x99, 0x16, 0x64, 0xb3, 0x9d, 0x77, 0xef, 0x31,
+    0x7c, 0x71, 0xb8, 0x45, 0xb1, 0xe3, 0x0b, 0xd5, 0x09, 0x11, 0x20, 0x41, 0xd3, 0xa1, 0x97, 0x83
+};
+
+// BLE Core 7.1.2.1 P-256 data set 1, big endian
+static const uint8_t g_ubaMwCryptoTestEcdhAPriv[MW_CRYPTO_TEST_ECC_LEN] =
+{
+    0x3f, 0x49, 0xf6, 0xd4, 0xa3, 0xc5, 0x5f, 0x38, 0x74, 0xc9, 0xb3, 0xe3, 0xd2, 0x10, 0x3f, 0x50,
+    0x4a, 0xff, 0x60, 0x7b, 0xeb, 0x40, 0xb7, 0x99, 0x58, 0x99, 0xb8, 0xa6, 0xcd, 0x3c, 0x1a, 0xbd
+};
+static const uint8_t g_ubaMwCryptoTestEcdhAPubX[MW_CRYPTO_TEST_ECC_LEN] =
+{
+    0x20, 0xb0, 0x03, 0xd2, 0xf2, 0x97, 0xbe, 0x2c, 0x5e, 0x2c, 0x83, 0xa7, 0xe9, 0xf9, 0xa5, 0xb9,
+    0xef, 0xf4, 0x91, 0x11, 0xac, 0xf4, 0xfd, 0xdb, 0xcc, 0x03, 0x01, 0x48, 0x0e, 0x35, 0x9d, 0xe6
+};
+static const uint8_t g_ubaMwCryptoTestEcdhAPubY[MW_CRYPTO_TEST_ECC_LEN] =
+{
+    0xdc, 0x80, 0x9c, 0x49, 0x65, 0x2a, 0xeb, 0x6d, 0x63, 0x32, 0x9a, 0xbf, 0x5a, 0x52, 0x15, 0x5c,
+    0x76, 0x63, 0x45, 0xc2, 0x8f, 0xed, 0x30, 0x24, 0x74, 0x1c, 0x8e, 0xd0, 0x15, 0x89, 0xd2, 0x8b
+};
+static const uint8_t g_ubaMwCryptoTestEcdhBPriv[MW_CRYPTO_TEST_ECC_LEN] =
+{
+    0x55, 0x18, 0x8b, 0x3d, 0x32, 0xf6, 0xbb, 0x9a, 0x90, 0x0a, 0xfc, 0xfb, 0xee, 0xd4, 0xe7, 0x2a,
+    0x59, 0xcb, 0x9a, 0xc2, 0xf1, 0x9d, 0x7c, 0xfb, 0x6b, 0x4f, 0xdd, 0x49, 0xf4, 0x7f, 0xc5, 0xfd
+};
+static const uint8_t g_ubaMwCryptoTestEcdhKey[MW_CRYPTO_TEST_ECC_LEN] =
+{
+    0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05, 0x34, 0x10, 0x10, 0xa6, 0x0a, 0x39, 0x7d, 0x9b,
+    0x99, 0x79, 0x6b, 0x13, 0xb4, 0xf8, 0x66, 0xf1, 0x86, 0x8d, 0x34, 0xf3, 0x73, 0xbf, 0xa6, 0x98
+};
+
+// CTR_DRBG without prediction resistance, the vector of the self test of mbedtls
+static const uint8_t g_ubaMwCryptoTestDrbgEntropy[64] =
+{
+    0x5a, 0x19, 0x4d, 0x5e, 0x2b, 0x31, 0x58, 0x14, 0x54, 0xde, 0xf6, 0x75, 0xfb, 0x79, 0x58, 0xfe,
+    0xc7, 0xdb, 0x87, 0x3e, 0x56, 0x89, 0xfc, 0x9d, 0x03, 0x21, 0x7c, 0x68, 0xd8, 0x03, 0x38, 0x20,
+    0xf9, 0xe6, 0x5e, 0x04, 0xd8, 0x56, 0xf3, 0xa9, 0xc4, 0x4a, 0x4c, 0xbd, 0xc1, 0xd0, 0x08, 0x46,
+    0xf5, 0x98, 0x3d, 0x77, 0x1c, 0x1b, 0x13, 0x7e, 0x4e, 0x0f, 0x9d, 0x8e, 0xf4, 0x09, 0xf9, 0x2e
+};
+static const uint8_t g_ubaMwCryptoTestDrbgPers[16] =
+{
+    0x1b, 0x54, 0xb8, 0xff, 0x06, 0x42, 0xbf, 0xf5, 0x21, 0xf1, 0x5c, 0x1c, 0x0b, 0x66, 0x5f, 0x3f
+};
+static const uint8_t g_ubaMwCryptoTestDrbgResult[16] =
+{
+    0xa0, 0x54, 0x30, 0x3d, 0x8a, 0x7e, 0xa9, 0x88, 0x9d, 0x90, 0x3e, 0x07, 0x7c, 0x6f, 0x21, 0x8f
+};
+
+
+// Sec 7: declaration of static function prototype
+static int MwCryptoTest_AesEcbScrtKat(const void *pArg);
+static int MwCryptoTest_AesEcbScrtOp(const void *pArg);
+static int MwCryptoTest_AesEcbMbedKat(const void *pArg);
+static int MwCryptoTest_AesEcbMbedOp(const void *pArg);
+static int MwCryptoTest_AesEcbTcKat(const void *pArg);
+static int MwCryptoTest_AesEcbTcOp(const void *pArg);
+static int MwCryptoTest_AesCbcMbedKat(const void *pArg);
+static int MwCryptoTest_AesCbcMbedOp(const void *pArg);
+static int MwCryptoTest_AesCbcTcKat(const void *pArg);
+static int MwCryptoTest_AesCbcTcOp(const void *pArg);
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+static int MwCryptoTest_AesCtrMbedKat(const void *pArg);
+static int MwCryptoTest_AesCtrMbedOp(const void *pArg);
+#endif
+static int MwCryptoTest_AesCtrTcKat(const void *pArg);
+static int MwCryptoTest_AesCtrTcOp(const void *pArg);
+static int MwCryptoTest_AesCcmScrtKat(const void *pArg);
+static int MwCryptoTest_AesCcmScrtOp(const void *pArg);
+#if defined(MBEDTLS_CCM_C)
+static int MwCryptoTest_AesCcmMbedKat(const void *pArg);
+static int MwCryptoTest_AesCcmMbedOp(const void *pArg);
+#endif
+static int MwCryptoTest_AesCcmTcKat(const void *pArg);
+static int MwCryptoTest_AesCcmTcOp(const void *pArg);
+#if defined(MBEDTLS_GCM_C)
+static int MwCryptoTest_AesGcmMbedKat(const void *pArg);
+static int MwCryptoTest_AesGcmMbedOp(const void *pArg);
+#endif
+static int MwCryptoTest_Sha1MbedKat(const void *pArg);
+static int MwCryptoTest_Sha1MbedOp(const void *pArg);
+static int MwCryptoTest_Sha256MbedKat(const void *pArg);
+static int MwCryptoTest_Sha256MbedOp(const void *pArg);
+static int MwCryptoTest_Sha256TcKat(const void *pArg);
+static int MwCryptoTest_Sha256TcOp(const void *pArg);
+static int MwCryptoTest_HmacKat(const void *pArg);
+static int MwCryptoTest_HmacOp(const void *pArg);
+static int MwCryptoTest_EcdhScrt(const void *pArg);
+#if defined(MW_CRYPTO_TEST_MBEDTLS_ECDH)
+static int MwCryptoTest_EcdhMbed(const void *pArg);
+#endif
+static int MwCryptoTest_EcdhTcKat(const void *pArg);
+static int MwCryptoTest_EcdhTcOp(const void *pArg);
+static int MwCryptoTest_DrbgMbedKat(const void *pArg);
+static int MwCryptoTest_DrbgMbedOp(const void *pArg);
+static int MwCryptoTest_DrbgTcKat(const void *pArg);
+static int MwCryptoTest_DrbgTcOp(const void *pArg);
+static int MwCryptoTest_Pbkdf2Kat(const void *pArg);
+static int MwCryptoTest_Pbkdf2Op(const void *pArg);
+
+static int MwCryptoTest_HmacSha1Scrt(const uint8_t *pubKey, uint32_t ulKeyLen,
+                                     const uint8_t *pubData, uint32_t ulLen, uint8_t *pubMac);
+static int MwCryptoTest_HmacSha1Mbed(const uint8_t *pubKey, uint32_t ulKeyLen,
+                                     const uint8_t *pubData, uint32_t ulLen, uint8_t *pubMac);
+static int MwCryptoTest_HmacSha256Mbed(const uint8_t *pubKey, uint32_t ulKeyLen,
+                                       const uint8_t *pubData, uint32_t ulLen, uint8_t *pubMac);
+static int MwCryptoTest_HmacSha256Tc(const uint8_t *pubKey, uint32_t ulKeyLen,
+                                     const uint8_t *pubData, uint32_t ulLen, uint8_t *pubMac);
+
+static const T_MwCryptoTestMac g_tMwCryptoTestSha1Scrt =
+{
+    MwCryptoTest_HmacSha1Scrt, 20, g_ubaMwCryptoTestHmacSha1,
+    "password", "salt", 2, g_ubaMwCryptoTestPbkdf2Sha1, sizeof(g_ubaMwCryptoTestPbkdf2Sha1)
+};
+static const T_MwCryptoTestMac g_tMwCryptoTestSha1Mbed =
+{
+    MwCryptoTest_HmacSha1Mbed, 20, g_ubaMwCryptoTestHmacSha1,
+    "password", "salt", 2, g_ubaMwCryptoTestPbkdf2Sha1, sizeof(g_ubaMwCryptoTestPbkdf2Sha1)
+};
+static const T_MwCryptoTestMac g_tMwCryptoTestSha256Mbed =
+{
+    MwCryptoTest_HmacSha256Mbed, 32, g_ubaMwCryptoTestHmacSha256,
+    "passwd", "salt", 1, g_ubaMwCryptoTestPbkdf2Sha256, sizeof(g_ubaMwCryptoTestPbkdf2Sha256)
+};
+static const T_MwCryptoTestMac g_tMwCryptoTestSha256Tc =
+{
+    MwCryptoTest_HmacSha256Tc, 32, g_ubaMwCryptoTestHmacSha256,
+    "passwd", "salt", 1, g_ubaMwCryptoTestPbkdf2Sha256, sizeof(g_ubaMwCryptoTestPbkdf2Sha256)
+};
+
+// the providers a config of mbedtls leaves out have no case
+static const T_MwCryptoTestCase g_taMwCryptoTestCase[] =
+{
+    { "aes-ecb",        "scrt",         MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_AesEcbScrtKat, MwCryptoTest_AesEcbScrtOp, NULL },
+    { "aes-ecb",        "mbedtls",      MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_AesEcbMbedKat, MwCryptoTest_AesEcbMbedOp, NULL },
+    { "aes-ecb",        "tinycrypt",    MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_AesEcbTcKat,   MwCryptoTest_AesEcbTcOp,   NULL },
+    { "aes-cbc",        "mbedtls",      MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_AesCbcMbedKat, MwCryptoTest_AesCbcMbedOp, NULL },
+    { "aes-cbc",        "tinycrypt",    MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_AesCbcTcKat,   MwCryptoTest_AesCbcTcOp,   NULL },
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+    { "aes-ctr",        "mbedtls",      MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_AesCtrMbedKat, MwCryptoTest_AesCtrMbedOp, NULL },
+#endif
+    { "aes-ctr",        "tinycrypt",    MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_AesCtrTcKat,   MwCryptoTest_AesCtrTcOp,   NULL },
+    { "aes-ccm",        "scrt",         MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_AesCcmScrtKat, MwCryptoTest_AesCcmScrtOp, NULL },
+#if defined(MBEDTLS_CCM_C)
+    { "aes-ccm",        "mbedtls",      MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_AesCcmMbedKat, MwCryptoTest_AesCcmMbedOp, NULL },
+#endif
+    { "aes-ccm",        "tinycrypt",    MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_AesCcmTcKat,   MwCryptoTest_AesCcmTcOp,   NULL },
+#if defined(MBEDTLS_GCM_C)
+    { "aes-gcm",        "mbedtls",      MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_AesGcmMbedKat, MwCryptoTest_AesGcmMbedOp, NULL },
+#endif
+    { "sha1",           "mbedtls",      MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_Sha1MbedKat,   MwCryptoTest_Sha1MbedOp,   NULL },
+    { "sha256",         "mbedtls",      MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_Sha256MbedKat, MwCryptoTest_Sha256MbedOp, NULL },
+    { "sha256",         "tinycrypt",    MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_Sha256TcKat,   MwCryptoTest_Sha256TcOp,   NULL },
+    { "hmac-sha1",      "scrt",         MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_HmacKat,       MwCryptoTest_HmacOp,       &g_tMwCryptoTestSha1Scrt },
+    { "hmac-sha1",      "mbedtls",      MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_HmacKat,       MwCryptoTest_HmacOp,       &g_tMwCryptoTestSha1Mbed },
+    { "hmac-sha256",    "mbedtls",      MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_HmacKat,       MwCryptoTest_HmacOp,       &g_tMwCryptoTestSha256Mbed },
+    { "hmac-sha256",    "tinycrypt",    MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_HmacKat,       MwCryptoTest_HmacOp,       &g_tMwCryptoTestSha256Tc },
+    { "ecdh-p256",      "scrt",         0,                       MwCryptoTest_EcdhScrt,      MwCryptoTest_EcdhScrt,     NULL },
+#if defined(MW_CRYPTO_TEST_MBEDTLS_ECDH)
+    { "ecdh-p256",      "mbedtls",      0,                       MwCryptoTest_EcdhMbed,      MwCryptoTest_EcdhMbed,     NULL },
+#endif
+    { "ecdh-p256",      "tinycrypt",    0,                       MwCryptoTest_EcdhTcKat,     MwCryptoTest_EcdhTcOp,     NULL },
+    { "drbg",           "mbedtls",      MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_DrbgMbedKat,   MwCryptoTest_DrbgMbedOp,   NULL },
+    { "drbg",           "tinycrypt",    MW_CRYPTO_TEST_BUF_SIZE, MwCryptoTest_DrbgTcKat,     MwCryptoTest_DrbgTcOp,     NULL },
+    { "pbkdf2-sha1",    "scrt",         0,                       MwCryptoTest_Pbkdf2Kat,     MwCryptoTest_Pbkdf2Op,     &g_tMwCryptoTestSha1Scrt },
+    { "pbkdf2-sha1",    "mbedtls",      0,                       MwCryptoTest_Pbkdf2Kat,     MwCryptoTest_Pbkdf2Op,     &g_tMwCryptoTestSha1Mbed },
+    { "pbkdf2-sha256",  "mbedtls",      0,                       MwCryptoTest_Pbkdf2Kat,     MwCryptoTest_Pbkdf2Op,     &g_tMwCryptoTestSha256Mbed },
+    { "pbkdf2-sha256",  "tinycrypt",    0,                       MwCryptoTest_Pbkdf2Kat,     MwCryptoTest_Pbkdf2Op,     &g_tMwCryptoTestSha256Tc },
+};
+
+#define MW_CRYPTO_TEST_CASE_NUM     (sizeof(g_taMwCryptoTestCase) / sizeof(g_taMwCryptoTestCase[0]))
+
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Reverse
+*
+* DESCRIPTION:
+*   copy the bytes in the reverse order, between big and little endian
+*
+* PARAMETERS
+*   1. pubDst : [Out] the output
+*   2. pubSrc : [In] the input
+*   3. ulLen  : [In] the length
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+static void MwCryptoTest_Reverse(uint8_t *pubDst, const uint8_t *pubSrc, uint32_t ulLen)
+{
+    uint32_t i;
+
+    for (i = 0; i < ulLen; i++)
+        pubDst[i] = pubSrc[ulLen - 1 - i];
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Check
+*
+* DESCRIPTION:
+*   compare the output with the vector
+*
+* PARAMETERS
+*   1. pubOut : [In] the output
+*   2. pubKat : [In] the vector
+*   3. ulLen  : [In] the length
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_OK : the same
+*   MW_CRYPTO_TEST_CASE_FAIL : not the same
+*
+*************************************************************************/
+static int MwCryptoTest_Check(const uint8_t *pubOut, const uint8_t *pubKat, uint32_t ulLen)
+{
+    return (memcmp(pubOut, pubKat, ulLen) == 0) ? MW_CRYPTO_TEST_CASE_OK : MW_CRYPTO_TEST_CASE_FAIL;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesEcbScrtKat
+*
+* DESCRIPTION:
+*   AES-128 of the engine, FIPS-197 C.1 both ways
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesEcbScrtKat(const void *pArg)
+{
+    uint8_t ubaCt[16 + MW_CRYPTO_TEST_SCRT_PAD];
+    uint8_t ubaPt[16 + MW_CRYPTO_TEST_SCRT_PAD];
+
+    if (nl_scrt_aes_ecb(1, (unsigned char *)g_ubaMwCryptoTestAesKey, 16,
+                        (unsigned char *)g_ubaMwCryptoTestAesPt, ubaCt, 16) != 1)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (MwCryptoTest_Check(ubaCt, g_ubaMwCryptoTestAesCt, 16))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    if (nl_scrt_aes_ecb(0, (unsigned char *)g_ubaMwCryptoTestAesKey, 16, ubaCt, ubaPt, 16) != 1)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MwCryptoTest_Check(ubaPt, g_ubaMwCryptoTestAesPt, 16);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesEcbScrtOp
+*
+* DESCRIPTION:
+*   AES-128-ECB encryption of the buffer by the engine, one request
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesEcbScrtOp(const void *pArg)
+{
+    if (nl_scrt_aes_ecb(1, (unsigned char *)g_ubaMwCryptoTestAesKey, 16,
+                        MW_CRYPTO_TEST_IN, MW_CRYPTO_TEST_OUT, MW_CRYPTO_TEST_BUF_SIZE) != 1)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesEcbMbedKat
+*
+* DESCRIPTION:
+*   AES-128 of mbedtls, FIPS-197 C.1 both ways
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesEcbMbedKat(const void *pArg)
+{
+    mbedtls_aes_context tAes;
+    uint8_t ubaCt[16];
+    uint8_t ubaPt[16];
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    mbedtls_aes_init(&tAes);
+
+    if (mbedtls_aes_setkey_enc(&tAes, g_ubaMwCryptoTestAesKey, 128))
+        goto done;
+    if (mbedtls_aes_crypt_ecb(&tAes, MBEDTLS_AES_ENCRYPT, g_ubaMwCryptoTestAesPt, ubaCt))
+        goto done;
+    if (MwCryptoTest_Check(ubaCt, g_ubaMwCryptoTestAesCt, 16))
+        goto done;
+
+    if (mbedtls_aes_setkey_dec(&tAes, g_ubaMwCryptoTestAesKey, 128))
+        goto done;
+    if (mbedtls_aes_crypt_ecb(&tAes, MBEDTLS_AES_DECRYPT, ubaCt, ubaPt))
+        goto done;
+
+    iRet = MwCryptoTest_Check(ubaPt, g_ubaMwCryptoTestAesPt, 16);
+
+done:
+    mbedtls_aes_free(&tAes);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesEcbMbedOp
+*
+* DESCRIPTION:
+*   AES-128-ECB encryption of the buffer by mbedtls, the key schedule included
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesEcbMbedOp(const void *pArg)
+{
+    mbedtls_aes_context tAes;
+    uint32_t ulOff;
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    mbedtls_aes_init(&tAes);
+
+    if (mbedtls_aes_setkey_enc(&tAes, g_ubaMwCryptoTestAesKey, 128))
+        goto done;
+
+    for (ulOff = 0; ulOff < MW_CRYPTO_TEST_BUF_SIZE; ulOff += 16)
+    {
+        if (mbedtls_aes_crypt_ecb(&tAes, MBEDTLS_AES_ENCRYPT, MW_CRYPTO_TEST_IN + ulOff, MW_CRYPTO_TEST_OUT + ulOff))
+            goto done;
+    }
+
+    iRet = MW_CRYPTO_TEST_CASE_OK;
+
+done:
+    mbedtls_aes_free(&tAes);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesEcbTcKat
+*
+* DESCRIPTION:
+*   AES-128 of tinycrypt, FIPS-197 C.1 both ways
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesEcbTcKat(const void *pArg)
+{
+    struct tc_aes_key_sched_struct tSched;
+    uint8_t ubaCt[16];
+    uint8_t ubaPt[16];
+
+    if (tc_aes128_set_encrypt_key(&tSched, g_ubaMwCryptoTestAesKey) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_aes_encrypt(ubaCt, g_ubaMwCryptoTestAesPt, &tSched) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (MwCryptoTest_Check(ubaCt, g_ubaMwCryptoTestAesCt, 16))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    if (tc_aes128_set_decrypt_key(&tSched, g_ubaMwCryptoTestAesKey) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_aes_decrypt(ubaPt, ubaCt, &tSched) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MwCryptoTest_Check(ubaPt, g_ubaMwCryptoTestAesPt, 16);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesEcbTcOp
+*
+* DESCRIPTION:
+*   AES-128-ECB encryption of the buffer by tinycrypt, the key schedule included
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesEcbTcOp(const void *pArg)
+{
+    struct tc_aes_key_sched_struct tSched;
+    uint32_t ulOff;
+
+    if (tc_aes128_set_encrypt_key(&tSched, g_ubaMwCryptoTestAesKey) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    for (ulOff = 0; ulOff < MW_CRYPTO_TEST_BUF_SIZE; ulOff += 16)
+    {
+        if (tc_aes_encrypt(MW_CRYPTO_TEST_OUT + ulOff, MW_CRYPTO_TEST_IN + ulOff, &tSched) != TC_CRYPTO_SUCCESS)
+            return MW_CRYPTO_TEST_CASE_FAIL;
+    }
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCbcMbedKat
+*
+* DESCRIPTION:
+*   AES-128-CBC of mbedtls, SP 800-38A F.2.1 both ways
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCbcMbedKat(const void *pArg)
+{
+    mbedtls_aes_context tAes;
+    uint8_t ubaIv[16];
+    uint8_t ubaCt[16];
+    uint8_t ubaPt[16];
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    mbedtls_aes_init(&tAes);
+
+    memcpy(ubaIv, g_ubaMwCryptoTestCbcIv, sizeof(ubaIv));
+    if (mbedtls_aes_setkey_enc(&tAes, g_ubaMwCryptoTestModeKey, 128))
+        goto done;
+    if (mbedtls_aes_crypt_cbc(&tAes, MBEDTLS_AES_ENCRYPT, 16, ubaIv, g_ubaMwCryptoTestModePt, ubaCt))
+        goto done;
+    if (MwCryptoTest_Check(ubaCt, g_ubaMwCryptoTestCbcCt, 16))
+        goto done;
+
+    memcpy(ubaIv, g_ubaMwCryptoTestCbcIv, sizeof(ubaIv));
+    if (mbedtls_aes_setkey_dec(&tAes, g_ubaMwCryptoTestModeKey, 128))
+        goto done;
+    if (mbedtls_aes_crypt_cbc(&tAes, MBEDTLS_AES_DECRYPT, 16, ubaIv, ubaCt, ubaPt))
+        goto done;
+
+    iRet = MwCryptoTest_Check(ubaPt, g_ubaMwCryptoTestModePt, 16);
+
+done:
+    mbedtls_aes_free(&tAes);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCbcMbedOp
+*
+* DESCRIPTION:
+*   AES-128-CBC encryption of the buffer by mbedtls
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCbcMbedOp(const void *pArg)
+{
+    mbedtls_aes_context tAes;
+    uint8_t ubaIv[16];
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    mbedtls_aes_init(&tAes);
+
+    memcpy(ubaIv, g_ubaMwCryptoTestCbcIv, sizeof(ubaIv));
+    if (mbedtls_aes_setkey_enc(&tAes, g_ubaMwCryptoTestModeKey, 128))
+        goto done;
+    if (mbedtls_aes_crypt_cbc(&tAes, MBEDTLS_AES_ENCRYPT, MW_CRYPTO_TEST_BUF_SIZE, ubaIv,
+                              MW_CRYPTO_TEST_IN, MW_CRYPTO_TEST_OUT))
+        goto done;
+
+    iRet = MW_CRYPTO_TEST_CASE_OK;
+
+done:
+    mbedtls_aes_free(&tAes);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCbcTcKat
+*
+* DESCRIPTION:
+*   AES-128-CBC of tinycrypt, SP 800-38A F.2.1 (the output is the IV and
+*   the cipher text)
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCbcTcKat(const void *pArg)
+{
+    struct tc_aes_key_sched_struct tSched;
+    uint8_t ubaOut[16 + 16];
+
+    if (tc_aes128_set_encrypt_key(&tSched, g_ubaMwCryptoTestModeKey) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_cbc_mode_encrypt(ubaOut, sizeof(ubaOut), g_ubaMwCryptoTestModePt, 16,
+                            g_ubaMwCryptoTestCbcIv, &tSched) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MwCryptoTest_Check(&ubaOut[16], g_ubaMwCryptoTestCbcCt, 16);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCbcTcOp
+*
+* DESCRIPTION:
+*   AES-128-CBC encryption of the buffer by tinycrypt
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCbcTcOp(const void *pArg)
+{
+    struct tc_aes_key_sched_struct tSched;
+
+    if (tc_aes128_set_encrypt_key(&tSched, g_ubaMwCryptoTestModeKey) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_cbc_mode_encrypt(MW_CRYPTO_TEST_OUT, MW_CRYPTO_TEST_BUF_SIZE + 16, MW_CRYPTO_TEST_IN,
+                            MW_CRYPTO_TEST_BUF_SIZE, g_ubaMwCryptoTestCbcIv, &tSched) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCtrMbedKat
+*
+* DESCRIPTION:
+*   AES-128-CTR of mbedtls, SP 800-38A F.5.1
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCtrMbedKat(const void *pArg)
+{
+    mbedtls_aes_context tAes;
+    uint8_t ubaCtr[16];
+    uint8_t ubaStream[16];
+    uint8_t ubaCt[16];
+    size_t tOff = 0;
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    mbedtls_aes_init(&tAes);
+
+    memcpy(ubaCtr, g_ubaMwCryptoTestCtr, sizeof(ubaCtr));
+    if (mbedtls_aes_setkey_enc(&tAes, g_ubaMwCryptoTestModeKey, 128))
+        goto done;
+    if (mbedtls_aes_crypt_ctr(&tAes, 16, &tOff, ubaCtr, ubaStream, g_ubaMwCryptoTestModePt, ubaCt))
+        goto done;
+
+    iRet = MwCryptoTest_Check(ubaCt, g_ubaMwCryptoTestCtrCt, 16);
+
+done:
+    mbedtls_aes_free(&tAes);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCtrMbedOp
+*
+* DESCRIPTION:
+*   AES-128-CTR of the buffer by mbedtls
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCtrMbedOp(const void *pArg)
+{
+    mbedtls_aes_context tAes;
+    uint8_t ubaCtr[16];
+    uint8_t ubaStream[16];
+    size_t tOff = 0;
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    mbedtls_aes_init(&tAes);
+
+    memcpy(ubaCtr, g_ubaMwCryptoTestCtr, sizeof(ubaCtr));
+    if (mbedtls_aes_setkey_enc(&tAes, g_ubaMwCryptoTestModeKey, 128))
+        goto done;
+    if (mbedtls_aes_crypt_ctr(&tAes, MW_CRYPTO_TEST_BUF_SIZE, &tOff, ubaCtr, ubaStream,
+                              MW_CRYPTO_TEST_IN, MW_CRYPTO_TEST_OUT))
+        goto done;
+
+    iRet = MW_CRYPTO_TEST_CASE_OK;
+
+done:
+    mbedtls_aes_free(&tAes);
+    return iRet;
+}
+#endif
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCtrTcKat
+*
+* DESCRIPTION:
+*   AES-128-CTR of tinycrypt, SP 800-38A F.5.1
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCtrTcKat(const void *pArg)
+{
+    struct tc_aes_key_sched_struct tSched;
+    uint8_t ubaCtr[16];
+    uint8_t ubaCt[16];
+
+    memcpy(ubaCtr, g_ubaMwCryptoTestCtr, sizeof(ubaCtr));
+    if (tc_aes128_set_encrypt_key(&tSched, g_ubaMwCryptoTestModeKey) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_ctr_mode(ubaCt, 16, g_ubaMwCryptoTestModePt, 16, ubaCtr, &tSched) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MwCryptoTest_Check(ubaCt, g_ubaMwCryptoTestCtrCt, 16);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCtrTcOp
+*
+* DESCRIPTION:
+*   AES-128-CTR of the buffer by tinycrypt
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCtrTcOp(const void *pArg)
+{
+    struct tc_aes_key_sched_struct tSched;
+    uint8_t ubaCtr[16];
+
+    memcpy(ubaCtr, g_ubaMwCryptoTestCtr, sizeof(ubaCtr));
+    if (tc_aes128_set_encrypt_key(&tSched, g_ubaMwCryptoTestModeKey) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_ctr_mode(MW_CRYPTO_TEST_OUT, MW_CRYPTO_TEST_BUF_SIZE, MW_CRYPTO_TEST_IN,
+                    MW_CRYPTO_TEST_BUF_SIZE, ubaCtr, &tSched) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCcmScrtKat
+*
+* DESCRIPTION:
+*   AES-128-CCM of the engine, RFC 3610 packet vector #1 both ways
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCcmScrtKat(const void *pArg)
+{
+    uint8_t ubaCt[32 + MW_CRYPTO_TEST_SCRT_PAD];     // whole blocks
+    uint8_t ubaPt[32 + MW_CRYPTO_TEST_SCRT_PAD];
+    uint8_t ubaTag[MW_CRYPTO_TEST_CCM_TAG_LEN];
+
+    if (nl_scrt_aes_ccm(1, (unsigned char *)g_ubaMwCryptoTestCcmKey, 16,
+                        (unsigned char *)g_ubaMwCryptoTestCcmNonce, MW_CRYPTO_TEST_CCM_NONCE_LEN,
+                        (unsigned char *)g_ubaMwCryptoTestCcmAad, sizeof(g_ubaMwCryptoTestCcmAad),
+                        (unsigned char *)g_ubaMwCryptoTestCcmPt, ubaCt, sizeof(g_ubaMwCryptoTestCcmPt),
+                        ubaTag, MW_CRYPTO_TEST_CCM_TAG_LEN) != 1)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (MwCryptoTest_Check(ubaCt, g_ubaMwCryptoTestCcmCt, sizeof(g_ubaMwCryptoTestCcmCt)))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (MwCryptoTest_Check(ubaTag, g_ubaMwCryptoTestCcmTag, MW_CRYPTO_TEST_CCM_TAG_LEN))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    if (nl_scrt_aes_ccm(0, (unsigned char *)g_ubaMwCryptoTestCcmKey, 16,
+                        (unsigned char *)g_ubaMwCryptoTestCcmNonce, MW_CRYPTO_TEST_CCM_NONCE_LEN,
+                        (unsigned char *)g_ubaMwCryptoTestCcmAad, sizeof(g_ubaMwCryptoTestCcmAad),
+                        ubaPt, ubaCt, sizeof(g_ubaMwCryptoTestCcmPt),
+                        ubaTag, MW_CRYPTO_TEST_CCM_TAG_LEN) != 1)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MwCryptoTest_Check(ubaPt, g_ubaMwCryptoTestCcmPt, sizeof(g_ubaMwCryptoTestCcmPt));
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCcmScrtOp
+*
+* DESCRIPTION:
+*   AES-128-CCM encryption of the buffer by the engine, 8 bytes of the
+*   additional data and an 8-byte tag
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCcmScrtOp(const void *pArg)
+{
+    uint8_t ubaTag[MW_CRYPTO_TEST_CCM_TAG_LEN];
+
+    if (nl_scrt_aes_ccm(1, (unsigned char *)g_ubaMwCryptoTestCcmKey, 16,
+                        (unsigned char *)g_ubaMwCryptoTestCcmNonce, MW_CRYPTO_TEST_CCM_NONCE_LEN,
+                        (unsigned char *)g_ubaMwCryptoTestCcmAad, sizeof(g_ubaMwCryptoTestCcmAad),
+                        MW_CRYPTO_TEST_IN, MW_CRYPTO_TEST_OUT, MW_CRYPTO_TEST_BUF_SIZE,
+                        ubaTag, MW_CRYPTO_TEST_CCM_TAG_LEN) != 1)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+#if defined(MBEDTLS_CCM_C)
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCcmMbedKat
+*
+* DESCRIPTION:
+*   AES-128-CCM of mbedtls, RFC 3610 packet vector #1 both ways. With
+*   MBEDTLS_SCRT_AEAD the record goes to the engine when the offload is on.
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCcmMbedKat(const void *pArg)
+{
+    mbedtls_ccm_context tCcm;
+    uint8_t ubaCt[sizeof(g_ubaMwCryptoTestCcmPt)];
+    uint8_t ubaPt[sizeof(g_ubaMwCryptoTestCcmPt)];
+    uint8_t ubaTag[MW_CRYPTO_TEST_CCM_TAG_LEN];
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    mbedtls_ccm_init(&tCcm);
+
+    if (mbedtls_ccm_setkey(&tCcm, MBEDTLS_CIPHER_ID_AES, g_ubaMwCryptoTestCcmKey, 128))
+        goto done;
+    if (mbedtls_ccm_encrypt_and_tag(&tCcm, sizeof(ubaCt), g_ubaMwCryptoTestCcmNonce, MW_CRYPTO_TEST_CCM_NONCE_LEN,
+                                    g_ubaMwCryptoTestCcmAad, sizeof(g_ubaMwCryptoTestCcmAad),
+                                    g_ubaMwCryptoTestCcmPt, ubaCt, ubaTag, MW_CRYPTO_TEST_CCM_TAG_LEN))
+        goto done;
+    if (MwCryptoTest_Check(ubaCt, g_ubaMwCryptoTestCcmCt, sizeof(ubaCt)))
+        goto done;
+    if (MwCryptoTest_Check(ubaTag, g_ubaMwCryptoTestCcmTag, MW_CRYPTO_TEST_CCM_TAG_LEN))
+        goto done;
+
+    if (mbedtls_ccm_auth_decrypt(&tCcm, sizeof(ubaCt), g_ubaMwCryptoTestCcmNonce, MW_CRYPTO_TEST_CCM_NONCE_LEN,
+                                 g_ubaMwCryptoTestCcmAad, sizeof(g_ubaMwCryptoTestCcmAad),
+                                 ubaCt, ubaPt, ubaTag, MW_CRYPTO_TEST_CCM_TAG_LEN))
+        goto done;
+
+    iRet = MwCryptoTest_Check(ubaPt, g_ubaMwCryptoTestCcmPt, sizeof(ubaPt));
+
+done:
+    mbedtls_ccm_free(&tCcm);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCcmMbedOp
+*
+* DESCRIPTION:
+*   AES-128-CCM encryption of the buffer by mbedtls
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCcmMbedOp(const void *pArg)
+{
+    mbedtls_ccm_context tCcm;
+    uint8_t ubaTag[MW_CRYPTO_TEST_CCM_TAG_LEN];
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    mbedtls_ccm_init(&tCcm);
+
+    if (mbedtls_ccm_setkey(&tCcm, MBEDTLS_CIPHER_ID_AES, g_ubaMwCryptoTestCcmKey, 128))
+        goto done;
+    if (mbedtls_ccm_encrypt_and_tag(&tCcm, MW_CRYPTO_TEST_BUF_SIZE, g_ubaMwCryptoTestCcmNonce, MW_CRYPTO_TEST_CCM_NONCE_LEN,
+                                    g_ubaMwCryptoTestCcmAad, sizeof(g_ubaMwCryptoTestCcmAad),
+                                    MW_CRYPTO_TEST_IN, MW_CRYPTO_TEST_OUT, ubaTag, MW_CRYPTO_TEST_CCM_TAG_LEN))
+        goto done;
+
+    iRet = MW_CRYPTO_TEST_CASE_OK;
+
+done:
+    mbedtls_ccm_free(&tCcm);
+    return iRet;
+}
+#endif
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCcmTcKat
+*
+* DESCRIPTION:
+*   AES-128-CCM of tinycrypt, RFC 3610 packet vector #1 both ways (the
+*   output is the cipher text and the tag)
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCcmTcKat(const void *pArg)
+{
+    struct tc_aes_key_sched_struct tSched;
+    struct tc_ccm_mode_struct tCcm;
+    uint8_t ubaNonce[MW_CRYPTO_TEST_CCM_NONCE_LEN];
+    uint8_t ubaCt[sizeof(g_ubaMwCryptoTestCcmPt) + MW_CRYPTO_TEST_CCM_TAG_LEN];
+    uint8_t ubaPt[sizeof(g_ubaMwCryptoTestCcmPt)];
+
+    memcpy(ubaNonce, g_ubaMwCryptoTestCcmNonce, sizeof(ubaNonce));
+    if (tc_aes128_set_encrypt_key(&tSched, g_ubaMwCryptoTestCcmKey) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_ccm_config(&tCcm, &tSched, ubaNonce, sizeof(ubaNonce), MW_CRYPTO_TEST_CCM_TAG_LEN) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    if (tc_ccm_generation_encryption(ubaCt, g_ubaMwCryptoTestCcmAad, sizeof(g_ubaMwCryptoTestCcmAad),
+                                     g_ubaMwCryptoTestCcmPt, sizeof(g_ubaMwCryptoTestCcmPt), &tCcm) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (MwCryptoTest_Check(ubaCt, g_ubaMwCryptoTestCcmCt, sizeof(g_ubaMwCryptoTestCcmCt)))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (MwCryptoTest_Check(&ubaCt[sizeof(g_ubaMwCryptoTestCcmCt)], g_ubaMwCryptoTestCcmTag, MW_CRYPTO_TEST_CCM_TAG_LEN))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    if (tc_ccm_decryption_verification(ubaPt, g_ubaMwCryptoTestCcmAad, sizeof(g_ubaMwCryptoTestCcmAad),
+                                       ubaCt, sizeof(ubaCt), &tCcm) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MwCryptoTest_Check(ubaPt, g_ubaMwCryptoTestCcmPt, sizeof(ubaPt));
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesCcmTcOp
+*
+* DESCRIPTION:
+*   AES-128-CCM encryption of the buffer by tinycrypt
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesCcmTcOp(const void *pArg)
+{
+    struct tc_aes_key_sched_struct tSched;
+    struct tc_ccm_mode_struct tCcm;
+    uint8_t ubaNonce[MW_CRYPTO_TEST_CCM_NONCE_LEN];
+
+    memcpy(ubaNonce, g_ubaMwCryptoTestCcmNonce, sizeof(ubaNonce));
+    if (tc_aes128_set_encrypt_key(&tSched, g_ubaMwCryptoTestCcmKey) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_ccm_config(&tCcm, &tSched, ubaNonce, sizeof(ubaNonce), MW_CRYPTO_TEST_CCM_TAG_LEN) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_ccm_generation_encryption(MW_CRYPTO_TEST_OUT, g_ubaMwCryptoTestCcmAad, sizeof(g_ubaMwCryptoTestCcmAad),
+                                     MW_CRYPTO_TEST_IN, MW_CRYPTO_TEST_BUF_SIZE, &tCcm) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+#if defined(MBEDTLS_GCM_C)
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesGcmMbedKat
+*
+* DESCRIPTION:
+*   AES-128-GCM of mbedtls, test case 2 both ways
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesGcmMbedKat(const void *pArg)
+{
+    mbedtls_gcm_context tGcm;
+    uint8_t ubaZero[16] = {0};
+    uint8_t ubaCt[16];
+    uint8_t ubaPt[16];
+    uint8_t ubaTag[MW_CRYPTO_TEST_GCM_TAG_LEN];
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    mbedtls_gcm_init(&tGcm);
+
+    if (mbedtls_gcm_setkey(&tGcm, MBEDTLS_CIPHER_ID_AES, ubaZero, 128))
+        goto done;
+    if (mbedtls_gcm_crypt_and_tag(&tGcm, MBEDTLS_GCM_ENCRYPT, 16, ubaZero, MW_CRYPTO_TEST_GCM_IV_LEN,
+                                  NULL, 0, ubaZero, ubaCt, MW_CRYPTO_TEST_GCM_TAG_LEN, ubaTag))
+        goto done;
+    if (MwCryptoTest_Check(ubaCt, g_ubaMwCryptoTestGcmCt, 16))
+        goto done;
+    if (MwCryptoTest_Check(ubaTag, g_ubaMwCryptoTestGcmTag, MW_CRYPTO_TEST_GCM_TAG_LEN))
+        goto done;
+
+    if (mbedtls_gcm_auth_decrypt(&tGcm, 16, ubaZero, MW_CRYPTO_TEST_GCM_IV_LEN, NULL, 0,
+                                 ubaTag, MW_CRYPTO_TEST_GCM_TAG_LEN, ubaCt, ubaPt))
+        goto done;
+
+    iRet = MwCryptoTest_Check(ubaPt, ubaZero, 16);
+
+done:
+    mbedtls_gcm_free(&tGcm);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_AesGcmMbedOp
+*
+* DESCRIPTION:
+*   AES-128-GCM encryption of the buffer by mbedtls, 8 bytes of the
+*   additional data as a TLS record
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_AesGcmMbedOp(const void *pArg)
+{
+    mbedtls_gcm_context tGcm;
+    uint8_t ubaTag[MW_CRYPTO_TEST_GCM_TAG_LEN];
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    mbedtls_gcm_init(&tGcm);
+
+    if (mbedtls_gcm_setkey(&tGcm, MBEDTLS_CIPHER_ID_AES, g_ubaMwCryptoTestModeKey, 128))
+        goto done;
+    if (mbedtls_gcm_crypt_and_tag(&tGcm, MBEDTLS_GCM_ENCRYPT, MW_CRYPTO_TEST_BUF_SIZE,
+                                  g_ubaMwCryptoTestCcmNonce, MW_CRYPTO_TEST_GCM_IV_LEN,
+                                  g_ubaMwCryptoTestCcmAad, sizeof(g_ubaMwCryptoTestCcmAad),
+                                  MW_CRYPTO_TEST_IN, MW_CRYPTO_TEST_OUT, MW_CRYPTO_TEST_GCM_TAG_LEN, ubaTag))
+        goto done;
+
+    iRet = MW_CRYPTO_TEST_CASE_OK;
+
+done:
+    mbedtls_gcm_free(&tGcm);
+    return iRet;
+}
+#endif
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Sha1MbedKat
+*
+* DESCRIPTION:
+*   SHA-1 of mbedtls, "abc"
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_Sha1MbedKat(const void *pArg)
+{
+    uint8_t ubaDigest[20];
+
+    mbedtls_sha1((const unsigned char *)"abc", 3, ubaDigest);
+
+    return MwCryptoTest_Check(ubaDigest, g_ubaMwCryptoTestSha1, sizeof(ubaDigest));
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Sha1MbedOp
+*
+* DESCRIPTION:
+*   SHA-1 of the buffer by mbedtls
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_Sha1MbedOp(const void *pArg)
+{
+    mbedtls_sha1(MW_CRYPTO_TEST_IN, MW_CRYPTO_TEST_BUF_SIZE, MW_CRYPTO_TEST_OUT);
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Sha256MbedKat
+*
+* DESCRIPTION:
+*   SHA-256 of mbedtls, "abc"
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_Sha256MbedKat(const void *pArg)
+{
+    uint8_t ubaDigest[32];
+
+    mbedtls_sha256((const unsigned char *)"abc", 3, ubaDigest, 0);
+
+    return MwCryptoTest_Check(ubaDigest, g_ubaMwCryptoTestSha256, sizeof(ubaDigest));
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Sha256MbedOp
+*
+* DESCRIPTION:
+*   SHA-256 of the buffer by mbedtls
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_Sha256MbedOp(const void *pArg)
+{
+    mbedtls_sha256(MW_CRYPTO_TEST_IN, MW_CRYPTO_TEST_BUF_SIZE, MW_CRYPTO_TEST_OUT, 0);
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Sha256Tc
+*
+* DESCRIPTION:
+*   SHA-256 of tinycrypt
+*
+* PARAMETERS
+*   1. pubData   : [In] the data
+*   2. ulLen     : [In] the length
+*   3. pubDigest : [Out] 32 bytes
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_Sha256Tc(const uint8_t *pubData, uint32_t ulLen, uint8_t *pubDigest)
+{
+    struct tc_sha256_state_struct tSha;
+
+    if (tc_sha256_init(&tSha) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_sha256_update(&tSha, pubData, ulLen) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_sha256_final(pubDigest, &tSha) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Sha256TcKat
+*
+* DESCRIPTION:
+*   SHA-256 of tinycrypt, "abc"
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_Sha256TcKat(const void *pArg)
+{
+    uint8_t ubaDigest[32];
+
+    if (MwCryptoTest_Sha256Tc((const uint8_t *)"abc", 3, ubaDigest))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MwCryptoTest_Check(ubaDigest, g_ubaMwCryptoTestSha256, sizeof(ubaDigest));
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Sha256TcOp
+*
+* DESCRIPTION:
+*   SHA-256 of the buffer by tinycrypt
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_Sha256TcOp(const void *pArg)
+{
+    return MwCryptoTest_Sha256Tc(MW_CRYPTO_TEST_IN, MW_CRYPTO_TEST_BUF_SIZE, MW_CRYPTO_TEST_OUT);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_HmacSha1Scrt
+*
+* DESCRIPTION:
+*   HMAC-SHA1 of the engine, the key up to MW_CRYPTO_TEST_SCRT_KEY_MAX bytes
+*
+* PARAMETERS
+*   1. pubKey   : [In] the key
+*   2. ulKeyLen : [In] the length of the key
+*   3. pubData  : [In] the data
+*   4. ulLen    : [In] the length of the data
+*   5. pubMac   : [Out] 20 bytes
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_HmacSha1Scrt(const uint8_t *pubKey, uint32_t ulKeyLen,
+                                     const uint8_t *pubData, uint32_t ulLen, uint8_t *pubMac)
+{
+    if (ulKeyLen > MW_CRYPTO_TEST_SCRT_KEY_MAX)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    if (nl_hmac_sha_1((uint8_t *)pubKey, (int)ulKeyLen, (uint8_t *)pubData, (int)ulLen, pubMac) != 1)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_HmacSha1Mbed
+*
+* DESCRIPTION:
+*   HMAC-SHA1 of mbedtls
+*
+* PARAMETERS
+*   1. pubKey   : [In] the key
+*   2. ulKeyLen : [In] the length of the key
+*   3. pubData  : [In] the data
+*   4. ulLen    : [In] the length of the data
+*   5. pubMac   : [Out] 20 bytes
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_HmacSha1Mbed(const uint8_t *pubKey, uint32_t ulKeyLen,
+                                     const uint8_t *pubData, uint32_t ulLen, uint8_t *pubMac)
+{
+    if (mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA1), pubKey, ulKeyLen, pubData, ulLen, pubMac))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_HmacSha256Mbed
+*
+* DESCRIPTION:
+*   HMAC-SHA256 of mbedtls
+*
+* PARAMETERS
+*   1. pubKey   : [In] the key
+*   2. ulKeyLen : [In] the length of the key
+*   3. pubData  : [In] the data
+*   4. ulLen    : [In] the length of the data
+*   5. pubMac   : [Out] 32 bytes
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_HmacSha256Mbed(const uint8_t *pubKey, uint32_t ulKeyLen,
+                                       const uint8_t *pubData, uint32_t ulLen, uint8_t *pubMac)
+{
+    if (mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), pubKey, ulKeyLen, pubData, ulLen, pubMac))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_HmacSha256Tc
+*
+* DESCRIPTION:
+*   HMAC-SHA256 of tinycrypt
+*
+* PARAMETERS
+*   1. pubKey   : [In] the key
+*   2. ulKeyLen : [In] the length of the key
+*   3. pubData  : [In] the data
+*   4. ulLen    : [In] the length of the data
+*   5. pubMac   : [Out] 32 bytes
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_HmacSha256Tc(const uint8_t *pubKey, uint32_t ulKeyLen,
+                                     const uint8_t *pubData, uint32_t ulLen, uint8_t *pubMac)
+{
+    struct tc_hmac_state_struct tHmac;
+
+    if (tc_hmac_set_key(&tHmac, pubKey, ulKeyLen) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_hmac_init(&tHmac) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_hmac_update(&tHmac, pubData, ulLen) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_hmac_final(pubMac, TC_SHA256_DIGEST_SIZE, &tHmac) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_HmacKat
+*
+* DESCRIPTION:
+*   HMAC of a provider, RFC 2202 / RFC 4231 case 2
+*
+* PARAMETERS
+*   1. pArg : [In] T_MwCryptoTestMac
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_HmacKat(const void *pArg)
+{
+    const T_MwCryptoTestMac *ptMac = (const T_MwCryptoTestMac *)pArg;
+    uint8_t ubaMac[MW_CRYPTO_TEST_MAC_MAX];
+
+    if (ptMac->fpHmac((const uint8_t *)g_sMwCryptoTestHmacKey, strlen(g_sMwCryptoTestHmacKey),
+                      (const uint8_t *)g_sMwCryptoTestHmacData, strlen(g_sMwCryptoTestHmacData), ubaMac))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MwCryptoTest_Check(ubaMac, ptMac->pubHmacKat, ptMac->ulLen);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_HmacOp
+*
+* DESCRIPTION:
+*   HMAC of the buffer by a provider
+*
+* PARAMETERS
+*   1. pArg : [In] T_MwCryptoTestMac
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_HmacOp(const void *pArg)
+{
+    const T_MwCryptoTestMac *ptMac = (const T_MwCryptoTestMac *)pArg;
+
+    return ptMac->fpHmac((const uint8_t *)g_sMwCryptoTestHmacKey, strlen(g_sMwCryptoTestHmacKey),
+                         MW_CRYPTO_TEST_IN, MW_CRYPTO_TEST_BUF_SIZE, MW_CRYPTO_TEST_OUT);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Pbkdf2
+*
+* DESCRIPTION:
+*   PBKDF2 (RFC 8018) over the HMAC of a provider, one whole HMAC per
+*   iteration as the supplicant does
+*
+* PARAMETERS
+*   1. ptMac     : [In] the HMAC
+*   2. pubPass   : [In] the password
+*   3. ulPassLen : [In] the length of the password
+*   4. pubSalt   : [In] the salt
+*   5. ulSaltLen : [In] the length of the salt, up to MW_CRYPTO_TEST_SALT_MAX
+*   6. ulIter    : [In] the iteration count
+*   7. pubOut    : [Out] the derived key
+*   8. ulOutLen  : [In] the length of the derived key
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_Pbkdf2(const T_MwCryptoTestMac *ptMac, const uint8_t *pubPass, uint32_t ulPassLen,
+                               const uint8_t *pubSalt, uint32_t ulSaltLen, uint32_t ulIter,
+                               uint8_t *pubOut, uint32_t ulOutLen)
+{
+    uint8_t ubaBuf[MW_CRYPTO_TEST_SALT_MAX + 4];
+    uint8_t ubaU[MW_CRYPTO_TEST_MAC_MAX];
+    uint8_t ubaNext[MW_CRYPTO_TEST_MAC_MAX];
+    uint8_t ubaT[MW_CRYPTO_TEST_MAC_MAX];
+    uint32_t ulBlock = 1;
+    uint32_t ulCopy;
+    uint32_t i, j;
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    if ((ulSaltLen > MW_CRYPTO_TEST_SALT_MAX) || (ptMac->ulLen > MW_CRYPTO_TEST_MAC_MAX) || (!ulIter))
+        goto done;
+
+    memcpy(ubaBuf, pubSalt, ulSaltLen);
+
+    while (ulOutLen)
+    {
+        // U1 = PRF(P, S || INT(i))
+        ubaBuf[ulSaltLen] = (uint8_t)(ulBlock >> 24);
+        ubaBuf[ulSaltLen + 1] = (uint8_t)(ulBlock >> 16);
+        ubaBuf[ulSaltLen + 2] = (uint8_t)(ulBlock >> 8);
+        ubaBuf[ulSaltLen + 3] = (uint8_t)ulBlock;
+
+        if (ptMac->fpHmac(pubPass, ulPassLen, ubaBuf, ulSaltLen + 4, ubaU))
+            goto done;
+        memcpy(ubaT, ubaU, ptMac->ulLen);
+
+        for (i = 1; i < ulIter; i++)
+        {
+            if (ptMac->fpHmac(pubPass, ulPassLen, ubaU, ptMac->ulLen, ubaNext))
+                goto done;
+            memcpy(ubaU, ubaNext, ptMac->ulLen);
+
+            for (j = 0; j < ptMac->ulLen; j++)
+                ubaT[j] ^= ubaU[j];
+        }
+
+        ulCopy = (ulOutLen < ptMac->ulLen) ? ulOutLen : ptMac->ulLen;
+        memcpy(pubOut, ubaT, ulCopy);
+        pubOut += ulCopy;
+        ulOutLen -= ulCopy;
+        ulBlock++;
+    }
+
+    iRet = MW_CRYPTO_TEST_CASE_OK;
+
+done:
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Pbkdf2Kat
+*
+* DESCRIPTION:
+*   PBKDF2 over the HMAC of a provider, RFC 6070 or RFC 7914
+*
+* PARAMETERS
+*   1. pArg : [In] T_MwCryptoTestMac
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_Pbkdf2Kat(const void *pArg)
+{
+    const T_MwCryptoTestMac *ptMac = (const T_MwCryptoTestMac *)pArg;
+    uint8_t ubaKey[64];
+
+    if (ptMac->ulPbkdf2Len > sizeof(ubaKey))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    if (MwCryptoTest_Pbkdf2(ptMac, (const uint8_t *)ptMac->sPass, strlen(ptMac->sPass),
+                            (const uint8_t *)ptMac->sSalt, strlen(ptMac->sSalt), ptMac->ulIter,
+                            ubaKey, ptMac->ulPbkdf2Len))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MwCryptoTest_Check(ubaKey, ptMac->pubPbkdf2Kat, ptMac->ulPbkdf2Len);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Pbkdf2Op
+*
+* DESCRIPTION:
+*   a WPA2 passphrase to the PSK: 4096 iterations, 32 bytes
+*
+* PARAMETERS
+*   1. pArg : [In] T_MwCryptoTestMac
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_Pbkdf2Op(const void *pArg)
+{
+    const T_MwCryptoTestMac *ptMac = (const T_MwCryptoTestMac *)pArg;
+
+    return MwCryptoTest_Pbkdf2(ptMac, (const uint8_t *)"password", 8, (const uint8_t *)"opulinks-ap", 11,
+                               MW_CRYPTO_TEST_PBKDF2_ITER, MW_CRYPTO_TEST_OUT, MW_CRYPTO_TEST_PBKDF2_LEN);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_EcdhScrt
+*
+* DESCRIPTION:
+*   ECDH P-256 of the engine: the DHKey of the private key of B and the
+*   public key of A. The engine takes the keys in little endian and gives
+*   the DHKey in big endian.
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx, MW_CRYPTO_TEST_CASE_NA before the OTP is ready
+*
+*************************************************************************/
+static int MwCryptoTest_EcdhScrt(const void *pArg)
+{
+    uint8_t ubaX[MW_CRYPTO_TEST_ECC_LEN];
+    uint8_t ubaY[MW_CRYPTO_TEST_ECC_LEN];
+    uint8_t ubaKey[MW_CRYPTO_TEST_ECC_LEN];
+    uint32_t ulaPriv[MW_CRYPTO_TEST_ECC_LEN / 4];
+
+    if (!nl_scrt_otp_status_get())
+        return MW_CRYPTO_TEST_CASE_NA;
+
+    MwCryptoTest_Reverse(ubaX, g_ubaMwCryptoTestEcdhAPubX, MW_CRYPTO_TEST_ECC_LEN);
+    MwCryptoTest_Reverse(ubaY, g_ubaMwCryptoTestEcdhAPubY, MW_CRYPTO_TEST_ECC_LEN);
+    MwCryptoTest_Reverse((uint8_t *)ulaPriv, g_ubaMwCryptoTestEcdhBPriv, MW_CRYPTO_TEST_ECC_LEN);
+
+    if (!nl_scrt_ecdh_dhkey_gen(ubaX, ubaY, ulaPriv, ubaKey, 0))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MwCryptoTest_Check(ubaKey, g_ubaMwCryptoTestEcdhKey, MW_CRYPTO_TEST_ECC_LEN);
+}
+
+#if defined(MW_CRYPTO_TEST_MBEDTLS_ECDH)
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_EcdhMbed
+*
+* DESCRIPTION:
+*   ECDH P-256 of mbedtls: the DHKey of the private key of B and the
+*   public key of A
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_EcdhMbed(const void *pArg)
+{
+    mbedtls_ecp_group tGrp;
+    mbedtls_ecp_point tQ;
+    mbedtls_mpi tD;
+    mbedtls_mpi tZ;
+    uint8_t ubaKey[MW_CRYPTO_TEST_ECC_LEN];
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    mbedtls_ecp_group_init(&tGrp);
+    mbedtls_ecp_point_init(&tQ);
+    mbedtls_mpi_init(&tD);
+    mbedtls_mpi_init(&tZ);
+
+    if (mbedtls_ecp_group_load(&tGrp, MBEDTLS_ECP_DP_SECP256R1))
+        goto done;
+    if (mbedtls_mpi_read_binary(&tQ.X, g_ubaMwCryptoTestEcdhAPubX, MW_CRYPTO_TEST_ECC_LEN))
+        goto done;
+    if (mbedtls_mpi_read_binary(&tQ.Y, g_ubaMwCryptoTestEcdhAPubY, MW_CRYPTO_TEST_ECC_LEN))
+        goto done;
+    if (mbedtls_mpi_lset(&tQ.Z, 1))
+        goto done;
+    if (mbedtls_mpi_read_binary(&tD, g_ubaMwCryptoTestEcdhBPriv, MW_CRYPTO_TEST_ECC_LEN))
+        goto done;
+
+    if (mbedtls_ecdh_compute_shared(&tGrp, &tZ, &tQ, &tD, NULL, NULL))
+        goto done;
+    if (mbedtls_mpi_write_binary(&tZ, ubaKey, sizeof(ubaKey)))
+        goto done;
+
+    iRet = MwCryptoTest_Check(ubaKey, g_ubaMwCryptoTestEcdhKey, MW_CRYPTO_TEST_ECC_LEN);
+
+done:
+    mbedtls_mpi_free(&tZ);
+    mbedtls_mpi_free(&tD);
+    mbedtls_ecp_point_free(&tQ);
+    mbedtls_ecp_group_free(&tGrp);
+    return iRet;
+}
+#endif
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_EcdhTcOp
+*
+* DESCRIPTION:
+*   ECDH P-256 of tinycrypt: the check of the public key of A and the
+*   DHKey with the private key of B
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_EcdhTcOp(const void *pArg)
+{
+    EccPoint tPub;
+    uint32_t ulaPriv[NUM_ECC_DIGITS];
+    uint32_t ulaSecret[NUM_ECC_DIGITS];
+    uint8_t ubaKey[MW_CRYPTO_TEST_ECC_LEN];
+
+    ecc_bytes2native(tPub.x, (uint8_t *)g_ubaMwCryptoTestEcdhAPubX);
+    ecc_bytes2native(tPub.y, (uint8_t *)g_ubaMwCryptoTestEcdhAPubY);
+    ecc_bytes2native(ulaPriv, (uint8_t *)g_ubaMwCryptoTestEcdhBPriv);
+
+    if (ecc_valid_public_key(&tPub) != 0)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (ecdh_shared_secret(ulaSecret, &tPub, ulaPriv) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    ecc_native2bytes(ubaKey, ulaSecret);
+
+    return MwCryptoTest_Check(ubaKey, g_ubaMwCryptoTestEcdhKey, MW_CRYPTO_TEST_ECC_LEN);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_EcdhTcKat
+*
+* DESCRIPTION:
+*   ECDH P-256 of tinycrypt: the public key of A from its private key (the
+*   random number of ecc_make_key is the private key itself), then the DHKey
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_EcdhTcKat(const void *pArg)
+{
+    EccPoint tPub;
+    uint32_t ulaPriv[NUM_ECC_DIGITS];
+    uint32_t ulaRandom[NUM_ECC_DIGITS * 2];
+    uint8_t ubaOut[MW_CRYPTO_TEST_ECC_LEN];
+
+    memset(ulaRandom, 0, sizeof(ulaRandom));
+    ecc_bytes2native(ulaRandom, (uint8_t *)g_ubaMwCryptoTestEcdhAPriv);
+
+    if (ecc_make_key(&tPub, ulaPriv, ulaRandom) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    ecc_native2bytes(ubaOut, tPub.x);
+    if (MwCryptoTest_Check(ubaOut, g_ubaMwCryptoTestEcdhAPubX, MW_CRYPTO_TEST_ECC_LEN))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    ecc_native2bytes(ubaOut, tPub.y);
+    if (MwCryptoTest_Check(ubaOut, g_ubaMwCryptoTestEcdhAPubY, MW_CRYPTO_TEST_ECC_LEN))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MwCryptoTest_EcdhTcOp(pArg);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Entropy
+*
+* DESCRIPTION:
+*   the entropy callback of CTR_DRBG, the bytes of the vector in turn
+*
+* PARAMETERS
+*   1. pParam : [In] T_MwCryptoTestEntropy
+*   2. pubBuf : [Out] the entropy
+*   3. tLen   : [In] the length
+*
+* RETURNS
+*   0 : success
+*
+*************************************************************************/
+static int MwCryptoTest_Entropy(void *pParam, unsigned char *pubBuf, size_t tLen)
+{
+    T_MwCryptoTestEntropy *ptEnt = (T_MwCryptoTestEntropy *)pParam;
+
+    while (tLen--)
+    {
+        *pubBuf++ = ptEnt->pubData[ptEnt->ulOff];
+        ptEnt->ulOff = (ptEnt->ulOff + 1) % ptEnt->ulLen;
+    }
+
+    return 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_DrbgMbedKat
+*
+* DESCRIPTION:
+*   CTR_DRBG of mbedtls: seed, generate, reseed and generate, the NIST
+*   vector without prediction resistance (the entropy length of the vector,
+*   as the self test of mbedtls)
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_DrbgMbedKat(const void *pArg)
+{
+    mbedtls_ctr_drbg_context tDrbg;
+    T_MwCryptoTestEntropy tEnt = {g_ubaMwCryptoTestDrbgEntropy, sizeof(g_ubaMwCryptoTestDrbgEntropy), 0};
+    uint8_t ubaOut[16];
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    mbedtls_ctr_drbg_init(&tDrbg);
+
+    if (mbedtls_ctr_drbg_seed_entropy_len(&tDrbg, MwCryptoTest_Entropy, &tEnt,
+                                          g_ubaMwCryptoTestDrbgPers, sizeof(g_ubaMwCryptoTestDrbgPers), 32))
+        goto done;
+    if (mbedtls_ctr_drbg_random(&tDrbg, ubaOut, sizeof(ubaOut)))
+        goto done;
+    if (mbedtls_ctr_drbg_reseed(&tDrbg, NULL, 0))
+        goto done;
+    if (mbedtls_ctr_drbg_random(&tDrbg, ubaOut, sizeof(ubaOut)))
+        goto done;
+
+    iRet = MwCryptoTest_Check(ubaOut, g_ubaMwCryptoTestDrbgResult, sizeof(ubaOut));
+
+done:
+    mbedtls_ctr_drbg_free(&tDrbg);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_DrbgMbedOp
+*
+* DESCRIPTION:
+*   CTR_DRBG of mbedtls: seed and fill the buffer
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_DrbgMbedOp(const void *pArg)
+{
+    mbedtls_ctr_drbg_context tDrbg;
+    T_MwCryptoTestEntropy tEnt = {g_ubaMwCryptoTestDrbgEntropy, sizeof(g_ubaMwCryptoTestDrbgEntropy), 0};
+    int iRet = MW_CRYPTO_TEST_CASE_FAIL;
+
+    mbedtls_ctr_drbg_init(&tDrbg);
+
+    if (mbedtls_ctr_drbg_seed_entropy_len(&tDrbg, MwCryptoTest_Entropy, &tEnt,
+                                          g_ubaMwCryptoTestDrbgPers, sizeof(g_ubaMwCryptoTestDrbgPers), 32))
+        goto done;
+    if (mbedtls_ctr_drbg_random(&tDrbg, MW_CRYPTO_TEST_OUT, MW_CRYPTO_TEST_BUF_SIZE))
+        goto done;
+
+    iRet = MW_CRYPTO_TEST_CASE_OK;
+
+done:
+    mbedtls_ctr_drbg_free(&tDrbg);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_DrbgTcGen
+*
+* DESCRIPTION:
+*   HMAC_DRBG of tinycrypt: seed and generate
+*
+* PARAMETERS
+*   1. ptPrng  : [In] the state
+*   2. pubSeed : [In] MW_CRYPTO_TEST_PRNG_SEED_LEN bytes
+*   3. pubOut  : [Out] the output
+*   4. ulLen   : [In] the length of the output
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_DrbgTcGen(struct tc_hmac_prng_struct *ptPrng, const uint8_t *pubSeed,
+                                  uint8_t *pubOut, uint32_t ulLen)
+{
+    if (tc_hmac_prng_init(ptPrng, g_ubaMwCryptoTestDrbgPers, sizeof(g_ubaMwCryptoTestDrbgPers)) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_hmac_prng_reseed(ptPrng, pubSeed, MW_CRYPTO_TEST_PRNG_SEED_LEN, NULL, 0) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_hmac_prng_generate(pubOut, ulLen, ptPrng) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_DrbgTcKat
+*
+* DESCRIPTION:
+*   HMAC_DRBG of tinycrypt, no vector of its own: no output before the
+*   seed, the same seed gives the same output and another seed another one
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_DrbgTcKat(const void *pArg)
+{
+    struct tc_hmac_prng_struct tPrng;
+    uint8_t ubaOut1[32];
+    uint8_t ubaOut2[32];
+
+    if (tc_hmac_prng_init(&tPrng, g_ubaMwCryptoTestDrbgPers, sizeof(g_ubaMwCryptoTestDrbgPers)) != TC_CRYPTO_SUCCESS)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (tc_hmac_prng_generate(ubaOut1, sizeof(ubaOut1), &tPrng) != TC_HMAC_PRNG_RESEED_REQ)
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    if (MwCryptoTest_DrbgTcGen(&tPrng, g_ubaMwCryptoTestDrbgEntropy, ubaOut1, sizeof(ubaOut1)))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (MwCryptoTest_DrbgTcGen(&tPrng, g_ubaMwCryptoTestDrbgEntropy, ubaOut2, sizeof(ubaOut2)))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (MwCryptoTest_Check(ubaOut1, ubaOut2, sizeof(ubaOut1)))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    if (MwCryptoTest_DrbgTcGen(&tPrng, &g_ubaMwCryptoTestDrbgEntropy[MW_CRYPTO_TEST_PRNG_SEED_LEN], ubaOut2, sizeof(ubaOut2)))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+    if (!MwCryptoTest_Check(ubaOut1, ubaOut2, sizeof(ubaOut1)))
+        return MW_CRYPTO_TEST_CASE_FAIL;
+
+    return MW_CRYPTO_TEST_CASE_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_DrbgTcOp
+*
+* DESCRIPTION:
+*   HMAC_DRBG of tinycrypt: seed and fill the buffer
+*
+* PARAMETERS
+*   1. pArg : [In] not used
+*
+* RETURNS
+*   MW_CRYPTO_TEST_CASE_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_DrbgTcOp(const void *pArg)
+{
+    struct tc_hmac_prng_struct tPrng;
+
+    return MwCryptoTest_DrbgTcGen(&tPrng, g_ubaMwCryptoTestDrbgEntropy, MW_CRYPTO_TEST_OUT, MW_CRYPTO_TEST_BUF_SIZE);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_StackPaint
+*
+* DESCRIPTION:
+*   fill MW_CRYPTO_TEST_STACK_PAINT words of the free stack under the
+*   caller, MW_CRYPTO_TEST_STACK_GAP words below the mark (this function
+*   runs in the gap)
+*
+* PARAMETERS
+*   1. pulMark : [In] a local of the caller, the top of the measure
+*
+* RETURNS
+*   the lowest word painted
+*
+*************************************************************************/
+static volatile uint32_t *MwCryptoTest_StackPaint(volatile uint32_t *pulMark)
+{
+    volatile uint32_t *pulLow = pulMark - MW_CRYPTO_TEST_STACK_GAP - MW_CRYPTO_TEST_STACK_PAINT;
+    uint32_t i;
+
+    for (i = 0; i < MW_CRYPTO_TEST_STACK_PAINT; i++)
+        pulLow[i] = MW_CRYPTO_TEST_STACK_FILL;
+
+    return pulLow;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_StackUsed
+*
+* DESCRIPTION:
+*   the bytes used under the mark since MwCryptoTest_StackPaint, from the
+*   lowest word changed. All the words changed: the area was not enough,
+*   the result is a lower bound.
+*
+* PARAMETERS
+*   1. pulMark : [In] the mark of MwCryptoTest_StackPaint
+*   2. pulLow  : [In] the lowest word painted
+*
+* RETURNS
+*   bytes, at least the gap
+*
+*************************************************************************/
+static uint32_t MwCryptoTest_StackUsed(volatile uint32_t *pulMark, volatile uint32_t *pulLow)
+{
+    uint32_t i;
+
+    for (i = 0; i < MW_CRYPTO_TEST_STACK_PAINT; i++)
+    {
+        if (pulLow[i] != MW_CRYPTO_TEST_STACK_FILL)
+            break;
+    }
+
+    return (uint32_t)(pulMark - (pulLow + i)) * 4;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Case
+*
+* DESCRIPTION:
+*   run a case: the KAT, one operation for the stack, then the benchmark.
+*   The benchmark is skipped when the KAT fails or the provider is not
+*   ready.
+*
+* PARAMETERS
+*   1. ptCase    : [In] the case
+*   2. ulMode    : [In] MW_CRYPTO_TEST_MODE_xxx
+*   3. ulBenchMs : [In] the time of the benchmark
+*   4. ptRes     : [Out] the result
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+static void MwCryptoTest_Case(const T_MwCryptoTestCase *ptCase, uint32_t ulMode, uint32_t ulBenchMs,
+                              T_MwCryptoTestResult *ptRes)
+{
+    volatile uint32_t ulMark = 0;
+    volatile uint32_t *pulLow = NULL;
+    uint32_t ulStart = 0;
+    uint32_t ulTicks = 0;
+    uint32_t ulLimit = 0;
+    uint32_t ulPerMs = 0;
+    int iRet = MW_CRYPTO_TEST_CASE_OK;
+
+    memset(ptRes, 0, sizeof(*ptRes));
+    ptRes->ubKat = MW_CRYPTO_TEST_KAT_SKIP;
+
+    if (ulMode & MW_CRYPTO_TEST_MODE_STACK)
+        pulLow = MwCryptoTest_StackPaint(&ulMark);
+
+    if (ulMode & MW_CRYPTO_TEST_MODE_KAT)
+    {
+        iRet = ptCase->fpKat(ptCase->pArg);
+        if (iRet == MW_CRYPTO_TEST_CASE_NA)
+        {
+            ptRes->ubKat = MW_CRYPTO_TEST_KAT_NA;
+            goto done;
+        }
+
+        ptRes->ubKat = (iRet == MW_CRYPTO_TEST_CASE_OK) ? MW_CRYPTO_TEST_KAT_PASS : MW_CRYPTO_TEST_KAT_FAIL;
+        if (iRet != MW_CRYPTO_TEST_CASE_OK)
+            goto done;
+    }
+
+    if (!(ulMode & MW_CRYPTO_TEST_MODE_BENCH))
+        goto done;
+
+    // the first operation, not timed: the stack, and the provider ready
+    iRet = ptCase->fpOp(ptCase->pArg);
+    if (iRet == MW_CRYPTO_TEST_CASE_NA)
+    {
+        ptRes->ubKat = MW_CRYPTO_TEST_KAT_NA;
+        goto done;
+    }
+    if (iRet != MW_CRYPTO_TEST_CASE_OK)
+    {
+        ptRes->ubKat = MW_CRYPTO_TEST_KAT_FAIL;
+        goto done;
+    }
+
+    if (pulLow)
+    {
+        ptRes->ulStack = MwCryptoTest_StackUsed(&ulMark, pulLow);
+        pulLow = NULL;
+    }
+
+    ulPerMs = Hal_Tick_PerMilliSec();
+    if (ulBenchMs > Hal_Tick_MilliSecMax())
+        ulBenchMs = Hal_Tick_MilliSecMax();
+    ulLimit = ulBenchMs * ulPerMs;
+
+    Hal_Tick_DiffEx(0, &ulStart);
+
+    do
+    {
+        if (ptCase->fpOp(ptCase->pArg) != MW_CRYPTO_TEST_CASE_OK)
+        {
+            ptRes->ubKat = MW_CRYPTO_TEST_KAT_FAIL;
+            break;
+        }
+
+        ptRes->ulOps++;
+        ulTicks = Hal_Tick_Diff(ulStart);
+    } while (ulTicks < ulLimit);
+
+    if (ulPerMs)
+        ptRes->ulUs = (uint32_t)(((uint64_t)ulTicks * 1000) / ulPerMs);
+
+done:
+    if (pulLow)
+        ptRes->ulStack = MwCryptoTest_StackUsed(&ulMark, pulLow);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Match
+*
+* DESCRIPTION:
+*   check the filter against the algorithm and the provider of a case
+*
+* PARAMETERS
+*   1. ptCase  : [In] the case
+*   2. sFilter : [In] a part of the name of the algorithm or the provider,
+*                     NULL or "": all
+*
+* RETURNS
+*   1 : match
+*   0 : not match
+*
+*************************************************************************/
+static uint8_t MwCryptoTest_Match(const T_MwCryptoTestCase *ptCase, const char *sFilter)
+{
+    if ((sFilter == NULL) || (sFilter[0] == '\0'))
+        return 1;
+
+    if (strstr(ptCase->sAlgo, sFilter) || strstr(ptCase->sProv, sFilter))
+        return 1;
+
+    return 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_RunCases
+*
+* DESCRIPTION:
+*   run the cases of the filter and print a line of each one, the caller
+*   owns g_ubMwCryptoTestBusy
+*
+* PARAMETERS
+*   1. ulMode    : [In] MW_CRYPTO_TEST_MODE_xxx
+*   2. sFilter   : [In] a part of the name of the algorithm or the provider
+*   3. ulBenchMs : [In] the time of each benchmark, 0: MW_CRYPTO_TEST_BENCH_MS
+*   4. ptSum     : [Out] the summary, can be NULL
+*
+* RETURNS
+*   MW_CRYPTO_TEST_OK
+*   MW_CRYPTO_TEST_ERR_xxx
+*
+*************************************************************************/
+static int MwCryptoTest_RunCases(uint32_t ulMode, const char *sFilter, uint32_t ulBenchMs, T_MwCryptoTestSum *ptSum)
+{
+    static const char *s_saKat[] = {"pass", "FAIL", "n/a", "-"};
+    const T_MwCryptoTestCase *ptCase = NULL;
+    T_MwCryptoTestResult tRes;
+    T_MwCryptoTestSum tSum;
+    uint32_t ulUsPerOp = 0;
+    uint32_t ulKBps = 0;
+    uint32_t i;
+    int iRet = MW_CRYPTO_TEST_OK;
+
+    memset(&tSum, 0, sizeof(tSum));
+
+    if (!ulBenchMs)
+        ulBenchMs = MW_CRYPTO_TEST_BENCH_MS;
+
+    // 1KB of a known pattern
+    for (i = 0; i < MW_CRYPTO_TEST_BUF_SIZE; i++)
+        MW_CRYPTO_TEST_IN[i] = (uint8_t)(i * 7 + 1);
+
+    tracer_cli(LOG_HIGH_LEVEL, "%-14s %-10s %-5s %8s %10s %8s %7s\n",
+               "algo", "provider", "kat", "ops", "us/op", "KB/s", "stack");
+
+    for (i = 0; i < MW_CRYPTO_TEST_CASE_NUM; i++)
+    {
+        ptCase = &g_taMwCryptoTestCase[i];
+        if (!MwCryptoTest_Match(ptCase, sFilter))
+            continue;
+
+        MwCryptoTest_Case(ptCase, ulMode, ulBenchMs, &tRes);
+
+        tSum.ulCase++;
+        if (tRes.ubKat == MW_CRYPTO_TEST_KAT_FAIL)
+            tSum.ulFail++;
+        else if (tRes.ubKat == MW_CRYPTO_TEST_KAT_NA)
+            tSum.ulNa++;
+        else
+            tSum.ulPass++;
+
+        ulUsPerOp = (tRes.ulOps) ? (tRes.ulUs / tRes.ulOps) : 0;
+        ulKBps = 0;
+        if ((ptCase->ulUnit) && (tRes.ulUs))
+            ulKBps = (uint32_t)(((uint64_t)ptCase->ulUnit * tRes.ulOps * 1000000) / tRes.ulUs / 1024);
+
+        tracer_cli(LOG_HIGH_LEVEL, "%-14s %-10s %-5s %8u %10u %8u %7u\n",
+                   ptCase->sAlgo, ptCase->sProv, s_saKat[tRes.ubKat], tRes.ulOps, ulUsPerOp, ulKBps, tRes.ulStack);
+
+        // the idle task feeds the watchdog
+        osDelay(1);
+    }
+
+    tracer_cli(LOG_HIGH_LEVEL, "crypto: %u cases, %u pass, %u fail, %u n/a\n",
+               tSum.ulCase, tSum.ulPass, tSum.ulFail, tSum.ulNa);
+
+    if (!tSum.ulCase)
+        iRet = MW_CRYPTO_TEST_ERR_NOENT;
+    else if (tSum.ulFail)
+        iRet = MW_CRYPTO_TEST_ERR_FAIL;
+
+    if (ptSum)
+        *ptSum = tSum;
+
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Lock
+*
+* DESCRIPTION:
+*   take the test, one run at a time (the buffers are shared)
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   1 : taken
+*   0 : busy
+*
+*************************************************************************/
+static uint8_t MwCryptoTest_Lock(void)
+{
+    uint32_t ulPrimask;
+    uint8_t ubTaken = 0;
+
+    MW_CRYPTO_TEST_CRIT_ENTER(ulPrimask);
+    if (!g_ubMwCryptoTestBusy)
+    {
+        g_ubMwCryptoTestBusy = 1;
+        ubTaken = 1;
+    }
+    MW_CRYPTO_TEST_CRIT_EXIT(ulPrimask);
+
+    return ubTaken;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Run
+*
+* DESCRIPTION:
+*   run the cases in the task of the caller and print a line of each one:
+*   the algorithm, the provider, the KAT, the operations, us per operation,
+*   KB/s (the cases of the 1KB buffer) and the stack used
+*
+* PARAMETERS
+*   1. ulMode    : [In] MW_CRYPTO_TEST_MODE_xxx, MW_CRYPTO_TEST_MODE_STACK
+*                       only when the caller has MW_CRYPTO_TEST_STACK_PAINT
+*                       words of the stack free
+*   2. sFilter   : [In] a part of the name of the algorithm or the provider,
+*                       NULL: all
+*   3. ulBenchMs : [In] the time of each benchmark, 0: MW_CRYPTO_TEST_BENCH_MS
+*   4. ptSum     : [Out] the summary, can be NULL
+*
+* RETURNS
+*   MW_CRYPTO_TEST_OK
+*   MW_CRYPTO_TEST_ERR_xxx
+*
+*************************************************************************/
+int MwCryptoTest_Run(uint32_t ulMode, const char *sFilter, uint32_t ulBenchMs, T_MwCryptoTestSum *ptSum)
+{
+    int iRet = MW_CRYPTO_TEST_ERR_INVAL;
+
+    if (!(ulMode & MW_CRYPTO_TEST_MODE_ALL))
+        goto done;
+
+    if (!MwCryptoTest_Lock())
+    {
+        iRet = MW_CRYPTO_TEST_ERR_BUSY;
+        goto done;
+    }
+
+    iRet = MwCryptoTest_RunCases(ulMode, sFilter, ulBenchMs, ptSum);
+    g_ubMwCryptoTestBusy = 0;
+
+done:
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Task
+*
+* DESCRIPTION:
+*   the task of MwCryptoTest_Start, it ends itself after the run
+*
+* PARAMETERS
+*   1. pParam : [In] T_MwCryptoTestReq
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+static void MwCryptoTest_Task(void *pParam)
+{
+    T_MwCryptoTestReq *ptReq = (T_MwCryptoTestReq *)pParam;
+
+    MwCryptoTest_RunCases(ptReq->ulMode | MW_CRYPTO_TEST_MODE_STACK, ptReq->sFilter, ptReq->ulBenchMs, NULL);
+
+    g_ubMwCryptoTestBusy = 0;
+    vTaskDelete(NULL);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Start
+*
+* DESCRIPTION:
+*   run the cases in a task of their own, with the stack measured. The
+*   lines are printed as the cases finish.
+*
+* PARAMETERS
+*   1. ulMode    : [In] MW_CRYPTO_TEST_MODE_KAT / MW_CRYPTO_TEST_MODE_BENCH
+*   2. sFilter   : [In] a part of the name of the algorithm or the provider,
+*                       up to MW_CRYPTO_TEST_FILTER_MAX bytes, NULL: all
+*   3. ulBenchMs : [In] the time of each benchmark, 0: MW_CRYPTO_TEST_BENCH_MS
+*
+* RETURNS
+*   MW_CRYPTO_TEST_OK : started
+*   MW_CRYPTO_TEST_ERR_xxx
+*
+*************************************************************************/
+int MwCryptoTest_Start(uint32_t ulMode, const char *sFilter, uint32_t ulBenchMs)
+{
+    osThreadDef_t tThreadDef;
+    int iRet = MW_CRYPTO_TEST_ERR_INVAL;
+
+    if (!(ulMode & MW_CRYPTO_TEST_MODE_ALL))
+        goto done;
+    if ((sFilter) && (strlen(sFilter) > MW_CRYPTO_TEST_FILTER_MAX))
+        goto done;
+
+    if (!MwCryptoTest_Lock())
+    {
+        iRet = MW_CRYPTO_TEST_ERR_BUSY;
+        goto done;
+    }
+
+    memset(&g_tMwCryptoTestReq, 0, sizeof(g_tMwCryptoTestReq));
+    g_tMwCryptoTestReq.ulMode = ulMode & MW_CRYPTO_TEST_MODE_ALL;
+    g_tMwCryptoTestReq.ulBenchMs = ulBenchMs;
+    if (sFilter)
+        strcpy(g_tMwCryptoTestReq.sFilter, sFilter);
+
+    tThreadDef.name = OS_TASK_NAME_CRYPTO_TEST;
+    tThreadDef.pthread = MwCryptoTest_Task;
+    tThreadDef.tpriority = OS_TASK_PRIORITY_CRYPTO_TEST;
+    tThreadDef.instances = 0;                           // reserved, it is no used
+    tThreadDef.stacksize = OS_TASK_STACK_SIZE_CRYPTO_TEST;
+    if (osThreadCreate(&tThreadDef, &g_tMwCryptoTestReq) == NULL)
+    {
+        g_ubMwCryptoTestBusy = 0;
+        iRet = MW_CRYPTO_TEST_ERR_BUSY;
+        goto done;
+    }
+
+    iRet = MW_CRYPTO_TEST_OK;
+
+done:
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwCryptoTest_Cmd
+*
+* DESCRIPTION:
+*   diag command: crypto [kat|bench|all] [filter] [ms]
+*     kat: the known answer tests only
+*     bench: the benchmarks only, all: both (the default)
+*     filter: a part of the name of the algorithm or the provider
+*             (aes, sha, ecdh, drbg, pbkdf2, scrt, mbedtls, tinycrypt), "*": all
+*     ms: the time of each benchmark, MW_CRYPTO_TEST_BENCH_MS by default
+*   It runs in a task of its own, with the stack measured.
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwCryptoTest_Cmd(char *sCmd)
+{
+    char *baParam[MW_CRYPTO_TEST_PARAM_MAX + 1] = {0};
+    const char *sFilter = NULL;
+    uint32_t ulNum = 0;
+    uint32_t ulMode = MW_CRYPTO_TEST_MODE_ALL;
+    uint32_t ulBenchMs = 0;
+    int iRet = MW_CRYPTO_TEST_OK;
+
+    ulNum = ParseParam(sCmd, baParam, MW_CRYPTO_TEST_PARAM_MAX + 1);
+
+    if (ulNum > 1)
+    {
+        if (!strcmp(baParam[1], "kat"))
+            ulMode = MW_CRYPTO_TEST_MODE_KAT;
+        else if (!strcmp(baParam[1], "bench"))
+            ulMode = MW_CRYPTO_TEST_MODE_BENCH;
+        else if (!strcmp(baParam[1], "all"))
+            ulMode = MW_CRYPTO_TEST_MODE_ALL;
+        else
+        {
+            tracer_cli(LOG_HIGH_LEVEL, "usage: crypto [kat|bench|all] [filter|*] [ms]\n");
+            goto done;
+        }
+    }
+
+    if ((ulNum > 2) && (strcmp(baParam[2], "*")))
+        sFilter = baParam[2];
+
+    if (ulNum > 3)
+        ulBenchMs = strtoul(baParam[3], NULL, 0);
+
+    iRet = MwCryptoTest_Start(ulMode, sFilter, ulBenchMs);
+
+done:
+    if (iRet != MW_CRYPTO_TEST_OK)
+        tracer_cli(LOG_HIGH_LEVEL, "crypto: fail %d\n", iRet);
+}
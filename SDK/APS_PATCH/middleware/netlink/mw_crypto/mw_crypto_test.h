@@ -0,0 +1,111 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  mw_crypto_test.h
+*
+*  Project:
+*  --------
+*  OPL1000 Project - the crypto self-test and benchmark definition file
+*
+*  Description:
+*  ------------
+*  This include file is the crypto self-test and benchmark definition file.
+*
+*  The same algorithms on each provider of the system:
+*  - scrt:      the security engine (AES-ECB, AES-CCM, HMAC-SHA1, ECDH P-256)
+*  - mbedtls:   the library of TLS, the algorithms of the config in use
+*  - tinycrypt: the library of BLE in the ROM
+*
+*  Each case runs the known answer test (KAT) of the algorithm, then the
+*  benchmark: one operation over and over for the given time, the throughput
+*  on a 1KB buffer or the latency of a whole operation (ECDH, PBKDF2).
+*  The stack used by the KAT and one operation is measured too.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+#ifndef _MW_CRYPTO_TEST_H_
+#define _MW_CRYPTO_TEST_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <stdint.h>
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define MW_CRYPTO_TEST_OK           0
+#define MW_CRYPTO_TEST_ERR_FAIL     -1      // a KAT fails
+#define MW_CRYPTO_TEST_ERR_BUSY     -2      // the test is running
+#define MW_CRYPTO_TEST_ERR_INVAL    -3
+#define MW_CRYPTO_TEST_ERR_NOENT    -4      // no case matches the filter
+
+// the modes of MwCryptoTest_Run
+#define MW_CRYPTO_TEST_MODE_KAT     0x0001
+#define MW_CRYPTO_TEST_MODE_BENCH   0x0002
+#define MW_CRYPTO_TEST_MODE_STACK   0x0004  // the caller has MW_CRYPTO_TEST_STACK_PAINT words free
+#define MW_CRYPTO_TEST_MODE_ALL     (MW_CRYPTO_TEST_MODE_KAT | MW_CRYPTO_TEST_MODE_BENCH)
+
+#define MW_CRYPTO_TEST_BENCH_MS     200     // the time of each benchmark
+#define MW_CRYPTO_TEST_BUF_SIZE     1024    // the bytes of an operation of the throughput
+#define MW_CRYPTO_TEST_STACK_PAINT  768     // words under the caller, less than OS_TASK_STACK_SIZE_CRYPTO_TEST
+#define MW_CRYPTO_TEST_FILTER_MAX   15      // bytes of the filter, no '\0'
+
+
+/******************************
+Declaration of data structure
+******************************/
+// Sec 3: structure, uniou, enum, linked list
+typedef struct
+{
+    uint32_t ulCase;
+    uint32_t ulPass;
+    uint32_t ulFail;
+    uint32_t ulNa;                  // the provider is not ready (the OTP of the engine)
+} T_MwCryptoTestSum;
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+
+// Sec 5: declaration of global function prototype
+int MwCryptoTest_Run(uint32_t ulMode, const char *sFilter, uint32_t ulBenchMs, T_MwCryptoTestSum *ptSum);
+int MwCryptoTest_Start(uint32_t ulMode, const char *sFilter, uint32_t ulBenchMs);
+
+void MwCryptoTest_Cmd(char *sCmd);
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+
+
+// Sec 7: declaration of static function prototype
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _MW_CRYPTO_TEST_H_
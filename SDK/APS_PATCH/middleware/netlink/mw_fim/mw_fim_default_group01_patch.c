@@ -63,6 +63,9 @@ uint32_t g_MwFimAddrBufferMacAddrBleSrc[MW_FIM_MAC_ADDR_SRC_WIFI_BLE_NUM];
 // the address buffer of rf config
 uint32_t g_ulaMwFimAddrBufferRfConfig[MW_FIM_RF_CFG_NUM];
 
+// the address buffer of the stack worst cases
+uint32_t g_ulaMwFimAddrBufferStackPeak[MW_FIM_STACK_PEAK_NUM];
+
 // the information table of group 01
 const T_MwFimFileInfo g_taMwFimGroupTable01_patch[] =
 {
@@ -78,6 +81,8 @@ const T_MwFimFileInfo g_taMwFimGroupTable01_patch[] =
     
     {MW_FIM_IDX_GP01_RF_CFG, MW_FIM_RF_CFG_NUM, MW_FIM_RF_CFG_SIZE, (uint8_t*)&g_tMwFimDefaultRfConfig, g_ulaMwFimAddrBufferRfConfig},
 
+    {MW_FIM_IDX_GP01_STACK_PEAK, MW_FIM_STACK_PEAK_NUM, MW_FIM_STACK_PEAK_SIZE, NULL, g_ulaMwFimAddrBufferStackPeak},
+
     // the end, don't modify and remove it
     {0xFFFFFFFF,            0x00,              0x00,               NULL,                            NULL}
 };
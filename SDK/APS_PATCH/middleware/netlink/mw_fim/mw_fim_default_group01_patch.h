@@ -28,6 +28,7 @@ extern "C" {
 #include "msg_patch.h"
 #include "sys_common_ctrl.h"
 #include "rf_cfg.h"
+#include "sys_stack.h"
 
 
 // Sec 2: Constant Definitions, Imported Symbols, miscellaneous
@@ -50,6 +51,8 @@ typedef enum
     MW_FIM_IDX_GP01_MAC_ADDR_BLE_SRC,
 
     MW_FIM_IDX_GP01_RF_CFG,
+
+    MW_FIM_IDX_GP01_STACK_PEAK,
     
     MW_FIM_IDX_GP01_PATCH_MAX
 } E_MwFimIdxGroup01_Patch;
@@ -80,6 +83,9 @@ Declaration of data structure
 #define MW_FIM_RF_CFG_SIZE                  sizeof(T_RfCfg)
 #define MW_FIM_RF_CFG_NUM                   1
 
+#define MW_FIM_STACK_PEAK_SIZE              sizeof(S_SysStackRecord_t)
+#define MW_FIM_STACK_PEAK_NUM               SYS_STACK_RECORD_NUM
+
 /********************************************
 Declaration of Global Variables & Functions
 ********************************************/
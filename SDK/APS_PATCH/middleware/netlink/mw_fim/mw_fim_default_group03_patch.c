@@ -63,11 +63,18 @@ const T_HalTmprCalData g_tMwFimDefaultCalTmpr_patch =
 // the address buffer of Temperature Sensor
 extern uint32_t g_ulaMwFimAddrBufferCalTmpr[MW_FIM_CAL_TEMPERATURE_NUM];
 
+// the calibration offset of Temperature Sensor
+const int32_t g_lMwFimDefaultCalTmprOffset = 0;
+
+// the address buffer of Temperature Sensor offset
+static uint32_t g_ulaMwFimAddrBufferCalTmprOffset[MW_FIM_CAL_TMPR_OFFSET_NUM];
+
 // the information table of group 03
 const T_MwFimFileInfo g_taMwFimGroupTable03_patch[] =
 {
     {MW_FIM_IDX_GP03_CAL_AUXADC,      MW_FIM_CAL_AUXADC_NUM,      MW_FIM_CAL_AUXADC_SIZE,      (uint8_t*)&g_tMwFimDefaultCalAuxadc_patch, g_ulaMwFimAddrBufferCalAuxadc},
     {MW_FIM_IDX_GP03_CAL_TEMPERATURE, MW_FIM_CAL_TEMPERATURE_NUM, MW_FIM_CAL_TEMPERATURE_SIZE, (uint8_t*)&g_tMwFimDefaultCalTmpr_patch,   g_ulaMwFimAddrBufferCalTmpr},
+    {MW_FIM_IDX_GP03_PATCH_CAL_TMPR_OFFSET, MW_FIM_CAL_TMPR_OFFSET_NUM, MW_FIM_CAL_TMPR_OFFSET_SIZE, (uint8_t*)&g_lMwFimDefaultCalTmprOffset, g_ulaMwFimAddrBufferCalTmprOffset},
 
     // the end, don't modify and remove it
     {0xFFFFFFFF,            0x00,              0x00,               NULL,                            NULL}
@@ -38,6 +38,7 @@ typedef enum
     MW_FIM_IDX_GP03_PATCH_START = 0x00030000,             // the start IDX of group 03
     MW_FIM_IDX_GP03_PATCH_CAL_AUXADC,
     MW_FIM_IDX_GP03_PATCH_CAL_TEMPERATURE,
+    MW_FIM_IDX_GP03_PATCH_CAL_TMPR_OFFSET,
     
     MW_FIM_IDX_GP03_PATCH_MAX
 } E_MwFimIdxGroup03_Patch;
@@ -47,6 +48,8 @@ typedef enum
 Declaration of data structure
 ******************************/
 // Sec 3: structure, uniou, enum, linked list
+#define MW_FIM_CAL_TMPR_OFFSET_SIZE     sizeof(int32_t)     // milli-degree added to the temperature
+#define MW_FIM_CAL_TMPR_OFFSET_NUM      1
 
 
 /********************************************
@@ -54,6 +57,7 @@ Declaration of Global Variables & Functions
 ********************************************/
 // Sec 4: declaration of global variable
 extern const T_MwFimFileInfo g_taMwFimGroupTable03_patch[];
+extern const int32_t g_lMwFimDefaultCalTmprOffset;
 
 
 // Sec 5: declaration of global function prototype
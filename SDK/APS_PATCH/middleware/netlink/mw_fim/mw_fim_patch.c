@@ -0,0 +1,285 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  mw_fim_patch.c
+*
+*  Project:
+*  --------
+*  OPL1000 Project - the Flash Item Management (FIM) patch implement file
+*
+*  Description:
+*  ------------
+*  This implement file is include the Flash Item Management (FIM) patch
+*  function.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <stdint.h>
+#include "mw_fim.h"
+#include "mw_fim_default.h"
+#include "hal_flash.h"
+#include "mw_flash_svc.h"
+#include "mw_fim_patch.h"
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define MW_FIM_SIGNATURE_GROUP      0x67726F70  // grop
+#define MW_FIM_SIGNATURE_FILE       0x46494C45  // FILE
+
+#define MW_FIM_VER_GROUP_SEQUENCE_MIN       0x01
+#define MW_FIM_VER_GROUP_SEQUENCE_OVER      0xFF
+
+#define MW_FIM_DATA_BUFFER_SIZE     64  // used for swap behavior
+
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list
+typedef uint8_t (*T_MwFim_GroupHeaderVerify_Fp)(uint32_t ulZoneIdx, T_MwFimGroupHeader *ptGroupHeader);
+typedef uint8_t (*T_MwFim_GroupSwap_Fp)(uint32_t ulZoneIdx, uint32_t ulGroupIdx);
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+// mw_fim_internal.h
+extern T_MwFimGroupStatus g_taMwFimGroupStatusTable[MW_FIM_ZONE_MAX][MW_FIM_GROUP_MAX];
+
+
+// Sec 5: declaration of global function prototype
+extern T_MwFim_GroupHeaderVerify_Fp MwFim_GroupHeaderVerify;
+extern T_MwFim_GroupSwap_Fp MwFim_GroupSwap;
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+
+
+// Sec 7: declaration of static function prototype
+
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+/*************************************************************************
+* FUNCTION:
+*   MwFim_GroupSwap
+*
+* DESCRIPTION:
+*   swap the current group
+*   the old block is erased by the flash service in the background
+*
+* PARAMETERS
+*   1. ulZoneIdx    : [In] the zone index
+*   2. ulGroupIdx   : [In] the group index
+*
+* RETURNS
+*   1. MW_FIM_OK   : success
+*   2. MW_FIM_FAIL : fail
+*
+*************************************************************************/
+uint8_t MwFim_GroupSwap_patch(uint32_t ulZoneIdx, uint32_t ulGroupIdx)
+{
+    T_MwFimGroupHeader tGroupHeader;
+    T_MwFimFileHeader tFileHeader;
+    T_MwFimFileInfo *ptFileTable;
+    uint32_t ulBlockAddr;
+    uint32_t ulFreeOffset;
+    uint8_t ubTargetBlockIdx;
+    uint8_t ubRet = MW_FIM_FAIL;
+    
+    uint32_t ulPrefix;
+    
+    uint8_t ubaDataBuffer[MW_FIM_DATA_BUFFER_SIZE];
+    uint32_t ulDataSize;
+    uint32_t ulDataOffset;
+    uint32_t ulDataHandleSize;
+    
+    uint8_t* pubData;
+    uint8_t ubDataSize;
+    uint8_t ubMinorVersion;
+    
+    uint32_t i, j;
+    
+    // read the original group header
+    ulBlockAddr = g_taMwFimZoneInfoTable[ulZoneIdx].ulBaseAddr 
+                  + g_taMwFimZoneInfoTable[ulZoneIdx].ulBlockSize * g_taMwFimGroupStatusTable[ulZoneIdx][ulGroupIdx].ubBlockIdx;
+    if (0 != Hal_Flash_AddrRead(SPI_IDX_0, ulBlockAddr, 0, sizeof(T_MwFimGroupHeader), (uint8_t*)&tGroupHeader))
+    {
+        //printf("FIM: #16\n");
+        goto done;
+    }
+    
+    // verify the header information of group
+    if (MW_FIM_OK != MwFim_GroupHeaderVerify(ulZoneIdx, &tGroupHeader))
+        goto done;
+    
+    // get the target block index from swap group
+    ubTargetBlockIdx = g_taMwFimGroupStatusTable[ulZoneIdx][0].ubBlockIdx;
+    
+    // get the start address of target block and set the offset of free space
+    ulBlockAddr = g_taMwFimZoneInfoTable[ulZoneIdx].ulBaseAddr + g_taMwFimZoneInfoTable[ulZoneIdx].ulBlockSize * ubTargetBlockIdx;
+    ulFreeOffset = sizeof(T_MwFimGroupHeader);
+    
+    // the erase of the swap group may be still queued
+    if (MW_FLASH_SVC_OK != MwFlashSvc_EraseSync(ulBlockAddr))
+        goto done;
+    
+    // copy the file data from the original group to swap group
+    ptFileTable = g_ptaMwFimGroupInfoTable[ulZoneIdx][ulGroupIdx];
+    i = 0;
+    ulPrefix = ((ulZoneIdx & 0xFF) << 24) + ((ulGroupIdx & 0xFF) << 16);
+    while ((ptFileTable[i].ulFileId & 0xFFFF0000) == ulPrefix)
+    {
+        for (j=0; j<ptFileTable[i].uwRecordMax; j++)
+        {
+            // check the file data is exist or not
+            if (ptFileTable[i].pulDataAddr[j] != 0xFFFFFFFF)
+            {
+                // 1. write the file header
+                tFileHeader.ulSignature = MW_FIM_SIGNATURE_FILE;
+                tFileHeader.ulFileId = ptFileTable[i].ulFileId;
+                tFileHeader.uwRecordIdx = j;
+                tFileHeader.uwDataSize = ptFileTable[i].uwDataSize;
+                if (0 != Hal_Flash_AddrProgram(SPI_IDX_0, ulBlockAddr + ulFreeOffset, 0, sizeof(T_MwFimFileHeader), (uint8_t*)&tFileHeader))
+                {
+                    //printf("FIM: #17\n");
+                    goto done;
+                }
+                
+                // update the information
+                ulFreeOffset = ulFreeOffset + sizeof(T_MwFimFileHeader);
+                
+                // 2. write the file data
+                ulDataSize = ptFileTable[i].uwDataSize;
+                ulDataOffset = 0;
+                while (ulDataSize > 0)
+                {
+                    // decide the handle size for this loop
+                    if (ulDataSize >= MW_FIM_DATA_BUFFER_SIZE)
+                        ulDataHandleSize = MW_FIM_DATA_BUFFER_SIZE;
+                    else
+                        ulDataHandleSize = ulDataSize;
+                    
+                    // read from the original address
+                    if (0 != Hal_Flash_AddrRead(SPI_IDX_0, ptFileTable[i].pulDataAddr[j] + ulDataOffset, 0, ulDataHandleSize, ubaDataBuffer))
+                    {
+                        //printf("FIM: #18\n");
+                        goto done;
+                    }
+                    
+                    // write into the target block
+                    if (0 != Hal_Flash_AddrProgram(SPI_IDX_0, ulBlockAddr + ulFreeOffset + ulDataOffset, 0, ulDataHandleSize, ubaDataBuffer))
+                    {
+                        //printf("FIM: #19\n");
+                        goto done;
+                    }
+                    
+                    // update the information
+                    ulDataSize = ulDataSize - ulDataHandleSize;
+                    ulDataOffset = ulDataOffset + ulDataHandleSize;
+                }
+                
+                // update the address of file
+                ptFileTable[i].pulDataAddr[j] = ulBlockAddr + ulFreeOffset;
+                
+                // update the information
+                ulFreeOffset = ulFreeOffset + ptFileTable[i].uwDataSize;
+            } // if (ptFileTable[i].pulDataAddr[j] != 0xFFFFFFFF)
+        } // for (j=0; j<ptFileTable[i].uwRecordMax; j++)
+        
+        i++;
+        if (i >= 0x10000)
+        {
+            //printf("FIM: #20\n");
+            break;
+        }
+    } // while ((ptFileTable[i].ulFileId & 0xFFFF0000) == ulPrefix)
+    
+    // 3. write the group header
+    // fill the group header
+    tGroupHeader.ulSignature = MW_FIM_SIGNATURE_GROUP;
+    tGroupHeader.ubZoneIdx = ulZoneIdx;
+    tGroupHeader.ubGroupIdx = ulGroupIdx;
+    tGroupHeader.ubMajorVersion = g_taMwFimGroupStatusTable[ulZoneIdx][ulGroupIdx].ubMajorVersion;
+    ubMinorVersion = g_taMwFimGroupStatusTable[ulZoneIdx][ulGroupIdx].ubMinorVersion + 1;
+    if (ubMinorVersion >= MW_FIM_VER_GROUP_SEQUENCE_OVER)
+        ubMinorVersion = MW_FIM_VER_GROUP_SEQUENCE_MIN;
+    tGroupHeader.ubMinorVersion = ubMinorVersion;
+    tGroupHeader.ulCheckSum = 0;
+    pubData = (uint8_t*)&tGroupHeader;
+    ubDataSize = sizeof(T_MwFimGroupHeader) - 4;        // 4 bytes check sum
+    for (i=0; i<ubDataSize; i++)
+    {
+        tGroupHeader.ulCheckSum = tGroupHeader.ulCheckSum + pubData[i];
+    }
+    // write the block
+    if (0 != Hal_Flash_AddrProgram(SPI_IDX_0, ulBlockAddr, 0, sizeof(T_MwFimGroupHeader), (uint8_t*)&tGroupHeader))
+    {
+        //printf("FIM: #21\n");
+        goto done;
+    }
+    
+    // 4. update the information of group
+    // swap
+    g_taMwFimGroupStatusTable[ulZoneIdx][0].ubBlockIdx = g_taMwFimGroupStatusTable[ulZoneIdx][ulGroupIdx].ubBlockIdx;
+    // the current group
+    g_taMwFimGroupStatusTable[ulZoneIdx][ulGroupIdx].ulFreeOffset = ulFreeOffset;
+    g_taMwFimGroupStatusTable[ulZoneIdx][ulGroupIdx].ubMinorVersion = ubMinorVersion;
+    g_taMwFimGroupStatusTable[ulZoneIdx][ulGroupIdx].ubBlockIdx = ubTargetBlockIdx;
+    
+    // 5. erase the swap group
+    ulBlockAddr = g_taMwFimZoneInfoTable[ulZoneIdx].ulBaseAddr 
+                  + g_taMwFimZoneInfoTable[ulZoneIdx].ulBlockSize * g_taMwFimGroupStatusTable[ulZoneIdx][0].ubBlockIdx;
+    // it is not needed until the next swap, MwFim_Init handles the old copy after a reset
+    if (MW_FLASH_SVC_OK != MwFlashSvc_EraseLater(ulBlockAddr))
+        Hal_Flash_4KSectorAddrErase(SPI_IDX_0, ulBlockAddr);
+    
+    ubRet = MW_FIM_OK;
+
+done:    
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   mw_fim_patch_init
+*
+* DESCRIPTION:
+*   the patch of FIM functions
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void mw_fim_patch_init(void)
+{
+    MwFim_GroupSwap = MwFim_GroupSwap_patch;
+}
@@ -0,0 +1,74 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  mw_fim_patch.h
+*
+*  Project:
+*  --------
+*  OPL1000 Project - the Flash Item Management (FIM) patch definition file
+*
+*  Description:
+*  ------------
+*  This include file is the Flash Item Management (FIM) patch definition file
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+#ifndef _MW_FIM_PATCH_H_
+#define _MW_FIM_PATCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+
+
+/******************************
+Declaration of data structure
+******************************/
+// Sec 3: structure, uniou, enum, linked list
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+
+// Sec 5: declaration of global function prototype
+void mw_fim_patch_init(void);
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+
+
+// Sec 7: declaration of static function prototype
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _MW_FIM_PATCH_H_
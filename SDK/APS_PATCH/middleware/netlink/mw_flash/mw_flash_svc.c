@@ -0,0 +1,604 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  mw_flash_svc.c
+*
+*  Project:
+*  --------
+*  OPL1000 Project - the flash erase service implement file
+*
+*  Description:
+*  ------------
+*  This implement file is include the flash erase service function and api.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <string.h>
+#include "cmsis_os.h"
+#include "sys_os_config_patch.h"
+#include "hal_flash.h"
+#include "hal_flash_sched.h"
+#include "mw_ota.h"
+#include "mw_flash_svc.h"
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define MW_FLASH_SVC_ADDR_NONE          0xFFFFFFFF
+#define MW_FLASH_SVC_SECTOR_SIZE        0x1000
+
+#define MW_FLASH_SVC_OWNER_LATER        -1      // the busy sector is from MwFlashSvc_EraseLater
+
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list
+typedef struct
+{
+    uint8_t ubUsed;
+    uint32_t ulStartAddr;
+    uint32_t ulEndAddr;         // sector aligned
+    uint32_t ulEraseAddr;       // the sectors before it are erased
+    uint32_t ulWriteAddr;       // the end of the written data
+} T_MwFlashSvcWriter;
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+
+// Sec 5: declaration of global function prototype
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static osThreadId g_tMwFlashSvcThread;
+static osSemaphoreId g_tMwFlashSvcLock;         // for the tables below
+static osSemaphoreId g_tMwFlashSvcWake;
+
+static T_MwFlashSvcWriter g_taMwFlashSvcWriter[MW_FLASH_SVC_WRITER_NUM];
+static uint32_t g_ulaMwFlashSvcPend[MW_FLASH_SVC_PEND_NUM];
+static uint32_t g_ulMwFlashSvcBusyAddr = MW_FLASH_SVC_ADDR_NONE;
+static int8_t g_bMwFlashSvcBusyOwner;
+static T_MwFlashSvcStat g_tMwFlashSvcStat;
+
+// OTA
+static int8_t g_bMwFlashSvcOtaWriter = -1;
+static T_MwOta_ImageEraseStart_Fp g_tMwFlashSvcOtaEraseStart;
+
+
+// Sec 7: declaration of static function prototype
+
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+// the caller holds g_tMwFlashSvcLock
+static void MwFlashSvc_BusyDone(void)
+{
+    T_MwFlashSvcWriter *ptWriter;
+
+    if (g_bMwFlashSvcBusyOwner == MW_FLASH_SVC_OWNER_LATER)
+    {
+        g_tMwFlashSvcStat.ulEraseLater++;
+    }
+    else
+    {
+        // the writer may be closed, or reopened somewhere else
+        ptWriter = &g_taMwFlashSvcWriter[g_bMwFlashSvcBusyOwner];
+        if ((ptWriter->ubUsed) && (ptWriter->ulEraseAddr == g_ulMwFlashSvcBusyAddr))
+        {
+            ptWriter->ulEraseAddr += MW_FLASH_SVC_SECTOR_SIZE;
+            g_tMwFlashSvcStat.ulEraseAhead++;
+        }
+    }
+
+    g_ulMwFlashSvcBusyAddr = MW_FLASH_SVC_ADDR_NONE;
+}
+
+static void MwFlashSvc_BusyWait(void)
+{
+    if (g_ulMwFlashSvcBusyAddr == MW_FLASH_SVC_ADDR_NONE)
+        return;
+
+    Hal_Flash_EraseWait(SPI_IDX_0);
+    MwFlashSvc_BusyDone();
+}
+
+static uint8_t MwFlashSvc_NextGet(uint32_t *pulSecAddr, int8_t *pbOwner)
+{
+    T_MwFlashSvcWriter *ptWriter;
+    uint32_t i;
+
+    for (i=0; i<MW_FLASH_SVC_PEND_NUM; i++)
+    {
+        if (g_ulaMwFlashSvcPend[i] != MW_FLASH_SVC_ADDR_NONE)
+        {
+            *pulSecAddr = g_ulaMwFlashSvcPend[i];
+            *pbOwner = MW_FLASH_SVC_OWNER_LATER;
+            g_ulaMwFlashSvcPend[i] = MW_FLASH_SVC_ADDR_NONE;
+            return 1;
+        }
+    }
+
+    for (i=0; i<MW_FLASH_SVC_WRITER_NUM; i++)
+    {
+        ptWriter = &g_taMwFlashSvcWriter[i];
+        if ((!ptWriter->ubUsed) || (ptWriter->ulEraseAddr >= ptWriter->ulEndAddr))
+            continue;
+
+        if ((MW_FLASH_SVC_ERASE_AHEAD > 0) &&
+            (ptWriter->ulEraseAddr >= (ptWriter->ulWriteAddr + MW_FLASH_SVC_ERASE_AHEAD * MW_FLASH_SVC_SECTOR_SIZE)))
+            continue;
+
+        *pulSecAddr = ptWriter->ulEraseAddr;
+        *pbOwner = (int8_t)i;
+        return 1;
+    }
+
+    return 0;
+}
+
+static void MwFlashSvc_Wake(void)
+{
+    osSemaphoreRelease(g_tMwFlashSvcWake);
+}
+
+static void MwFlashSvc_Task(void *argument)
+{
+    uint32_t ulSecAddr;
+    int8_t bOwner;
+    uint8_t ubBusy;
+
+    for (;;)
+    {
+        osSemaphoreWait(g_tMwFlashSvcLock, osWaitForever);
+
+        if ((g_ulMwFlashSvcBusyAddr != MW_FLASH_SVC_ADDR_NONE) && (!Hal_Flash_EraseBusy(SPI_IDX_0)))
+            MwFlashSvc_BusyDone();
+
+        if ((g_ulMwFlashSvcBusyAddr == MW_FLASH_SVC_ADDR_NONE) && (MwFlashSvc_NextGet(&ulSecAddr, &bOwner)))
+        {
+            if (0 == Hal_Flash_EraseStart(SPI_IDX_0, ulSecAddr))
+            {
+                g_ulMwFlashSvcBusyAddr = ulSecAddr;
+                g_bMwFlashSvcBusyOwner = bOwner;
+            }
+            else
+            {
+                // the writer erases it in place, a queued sector is dropped
+                g_tMwFlashSvcStat.ulStartFail++;
+                if (bOwner != MW_FLASH_SVC_OWNER_LATER)
+                    g_taMwFlashSvcWriter[bOwner].ulEndAddr = g_taMwFlashSvcWriter[bOwner].ulEraseAddr;
+            }
+        }
+
+        ubBusy = (g_ulMwFlashSvcBusyAddr != MW_FLASH_SVC_ADDR_NONE);
+
+        osSemaphoreRelease(g_tMwFlashSvcLock);
+
+        if (ubBusy)
+            osDelay(MW_FLASH_SVC_POLL_MS);
+        else
+            osSemaphoreWait(g_tMwFlashSvcWake, osWaitForever);
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFlashSvc_OtaEraseStart
+*
+* DESCRIPTION:
+*   declare the OTA image area as a sequential writer instead of erasing it
+*
+*************************************************************************/
+static uint8_t MwFlashSvc_OtaEraseStart(uint32_t ulImageAddr, uint32_t ulImageSize)
+{
+    if (g_bMwFlashSvcOtaWriter >= 0)
+    {
+        MwFlashSvc_WriterClose(g_bMwFlashSvcOtaWriter);
+        g_bMwFlashSvcOtaWriter = -1;
+    }
+
+    if (MW_FLASH_SVC_OK != MwFlashSvc_WriterOpen(ulImageAddr, ulImageSize, &g_bMwFlashSvcOtaWriter))
+    {
+        g_bMwFlashSvcOtaWriter = -1;
+        return g_tMwFlashSvcOtaEraseStart(ulImageAddr, ulImageSize);
+    }
+
+    return MW_OTA_OK;
+}
+
+static uint8_t MwFlashSvc_OtaEraseWait(uint32_t ulAddr, uint32_t ulSize)
+{
+    if (g_bMwFlashSvcOtaWriter < 0)
+        return MW_OTA_OK;
+
+    if (MW_FLASH_SVC_OK != MwFlashSvc_WriterReady(g_bMwFlashSvcOtaWriter, ulAddr, ulSize))
+    {
+        printf("To erase the image [%u] of MW_OTA is fail.\n", ulAddr);
+        return MW_OTA_FAIL;
+    }
+
+    return MW_OTA_OK;
+}
+
+static void MwFlashSvc_OtaEraseStop(void)
+{
+    if (g_bMwFlashSvcOtaWriter < 0)
+        return;
+
+    MwFlashSvc_WriterClose(g_bMwFlashSvcOtaWriter);
+    g_bMwFlashSvcOtaWriter = -1;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFlashSvc_Init
+*
+* DESCRIPTION:
+*   create the erase task and take over the image erase of OTA
+*   (call it after MwOta_PreInitCold)
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwFlashSvc_Init(void)
+{
+    osSemaphoreDef_t tSemaphoreDef;
+    osThreadDef_t tThreadDef;
+    uint32_t i;
+
+    if (g_tMwFlashSvcThread != NULL)
+        return;
+
+    memset(g_taMwFlashSvcWriter, 0, sizeof(g_taMwFlashSvcWriter));
+    memset(&g_tMwFlashSvcStat, 0, sizeof(g_tMwFlashSvcStat));
+    for (i=0; i<MW_FLASH_SVC_PEND_NUM; i++)
+        g_ulaMwFlashSvcPend[i] = MW_FLASH_SVC_ADDR_NONE;
+    g_ulMwFlashSvcBusyAddr = MW_FLASH_SVC_ADDR_NONE;
+
+    // create the semaphore
+    tSemaphoreDef.dummy = 0;                            // reserved, it is no used
+    g_tMwFlashSvcLock = osSemaphoreCreate(&tSemaphoreDef, 1);
+    if (g_tMwFlashSvcLock == NULL)
+    {
+        printf("To create the semaphore for MwFlashSvc is fail.\n");
+        return;
+    }
+
+    g_tMwFlashSvcWake = osSemaphoreCreate(&tSemaphoreDef, 1);
+    if (g_tMwFlashSvcWake == NULL)
+    {
+        printf("To create the semaphore for MwFlashSvc is fail.\n");
+        return;
+    }
+    osSemaphoreWait(g_tMwFlashSvcWake, 0);              // nothing to do yet
+
+    // create the thread
+    tThreadDef.name = OS_TASK_NAME_FLASH_SVC;
+    tThreadDef.pthread = MwFlashSvc_Task;
+    tThreadDef.tpriority = OS_TASK_PRIORITY_FLASH_SVC;
+    tThreadDef.instances = 0;                           // reserved, it is no used
+    tThreadDef.stacksize = OS_TASK_STACK_SIZE_FLASH_SVC;
+    g_tMwFlashSvcThread = osThreadCreate(&tThreadDef, NULL);
+    if (g_tMwFlashSvcThread == NULL)
+    {
+        printf("To create the thread for MwFlashSvc is fail.\n");
+        return;
+    }
+
+    // OTA
+    g_tMwFlashSvcOtaEraseStart = MwOta_ImageEraseStart;
+    MwOta_ImageEraseStart = MwFlashSvc_OtaEraseStart;
+    MwOta_ImageEraseWait = MwFlashSvc_OtaEraseWait;
+    MwOta_ImageEraseStop = MwFlashSvc_OtaEraseStop;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFlashSvc_WriterOpen
+*
+* DESCRIPTION:
+*   declare an area written sequentially from the start address
+*
+* PARAMETERS
+*   1. ulAddr   : [In] the start address
+*   2. ulSize   : [In] the area size
+*   3. pbHandle : [Out] the writer handle
+*
+* RETURNS
+*   MW_FLASH_SVC_OK   : successful
+*   MW_FLASH_SVC_FAIL : fail, no task or no free writer
+*
+*************************************************************************/
+uint8_t MwFlashSvc_WriterOpen(uint32_t ulAddr, uint32_t ulSize, int8_t *pbHandle)
+{
+    T_MwFlashSvcWriter *ptWriter;
+    uint8_t ubRet = MW_FLASH_SVC_FAIL;
+    uint32_t i;
+
+    if ((g_tMwFlashSvcThread == NULL) || (ulSize == 0))
+        return MW_FLASH_SVC_FAIL;
+
+    osSemaphoreWait(g_tMwFlashSvcLock, osWaitForever);
+
+    for (i=0; i<MW_FLASH_SVC_WRITER_NUM; i++)
+    {
+        ptWriter = &g_taMwFlashSvcWriter[i];
+        if (ptWriter->ubUsed)
+            continue;
+
+        ptWriter->ulStartAddr = ulAddr & ~(MW_FLASH_SVC_SECTOR_SIZE - 1);
+        ptWriter->ulEndAddr = (ulAddr + ulSize + MW_FLASH_SVC_SECTOR_SIZE - 1) & ~(MW_FLASH_SVC_SECTOR_SIZE - 1);
+        ptWriter->ulEraseAddr = ptWriter->ulStartAddr;
+        ptWriter->ulWriteAddr = ptWriter->ulStartAddr;
+        ptWriter->ubUsed = 1;
+
+        *pbHandle = (int8_t)i;
+        ubRet = MW_FLASH_SVC_OK;
+        break;
+    }
+
+    osSemaphoreRelease(g_tMwFlashSvcLock);
+
+    if (ubRet == MW_FLASH_SVC_OK)
+        MwFlashSvc_Wake();
+
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFlashSvc_WriterReady
+*
+* DESCRIPTION:
+*   make sure the sectors of the data are erased before writing them
+*
+* PARAMETERS
+*   1. bHandle : [In] the writer handle
+*   2. ulAddr  : [In] the start address of the data
+*   3. ulSize  : [In] the data size
+*
+* RETURNS
+*   MW_FLASH_SVC_OK   : successful
+*   MW_FLASH_SVC_FAIL : fail
+*
+*************************************************************************/
+uint8_t MwFlashSvc_WriterReady(int8_t bHandle, uint32_t ulAddr, uint32_t ulSize)
+{
+    T_MwFlashSvcWriter *ptWriter;
+    uint32_t ulEndAddr = ulAddr + ulSize;
+    uint8_t ubRet = MW_FLASH_SVC_FAIL;
+
+    if ((bHandle < 0) || (bHandle >= MW_FLASH_SVC_WRITER_NUM))
+        return MW_FLASH_SVC_FAIL;
+
+    osSemaphoreWait(g_tMwFlashSvcLock, osWaitForever);
+
+    ptWriter = &g_taMwFlashSvcWriter[bHandle];
+    if ((!ptWriter->ubUsed) || (ulAddr < ptWriter->ulStartAddr))
+        goto done;
+
+    // written backwards, the area was erased already
+    if (ulEndAddr > ptWriter->ulWriteAddr)
+        ptWriter->ulWriteAddr = ulEndAddr;
+
+    while (ptWriter->ulEraseAddr < ulEndAddr)
+    {
+        if (g_ulMwFlashSvcBusyAddr == ptWriter->ulEraseAddr)
+        {
+            g_tMwFlashSvcStat.ulWriterWait++;
+            MwFlashSvc_BusyWait();
+            continue;
+        }
+
+        if (0 != Hal_Flash_4KSectorAddrErase(SPI_IDX_0, ptWriter->ulEraseAddr))
+            goto done;
+
+        ptWriter->ulEraseAddr += MW_FLASH_SVC_SECTOR_SIZE;
+        g_tMwFlashSvcStat.ulEraseDemand++;
+    }
+
+    ubRet = MW_FLASH_SVC_OK;
+
+done:
+    osSemaphoreRelease(g_tMwFlashSvcLock);
+
+    // the window moved
+    if (ubRet == MW_FLASH_SVC_OK)
+        MwFlashSvc_Wake();
+
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFlashSvc_WriterClose
+*
+* DESCRIPTION:
+*   stop erasing for the writer
+*
+* PARAMETERS
+*   1. bHandle : [In] the writer handle
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwFlashSvc_WriterClose(int8_t bHandle)
+{
+    if ((bHandle < 0) || (bHandle >= MW_FLASH_SVC_WRITER_NUM))
+        return;
+
+    osSemaphoreWait(g_tMwFlashSvcLock, osWaitForever);
+    g_taMwFlashSvcWriter[bHandle].ubUsed = 0;
+    osSemaphoreRelease(g_tMwFlashSvcLock);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFlashSvc_EraseLater
+*
+* DESCRIPTION:
+*   queue a sector to be erased by the task
+*
+* PARAMETERS
+*   1. ulSecAddr : [In] the address of sector
+*
+* RETURNS
+*   MW_FLASH_SVC_OK   : successful
+*   MW_FLASH_SVC_FAIL : fail, the caller should erase it
+*
+*************************************************************************/
+uint8_t MwFlashSvc_EraseLater(uint32_t ulSecAddr)
+{
+    uint8_t ubRet = MW_FLASH_SVC_FAIL;
+    uint32_t i;
+
+    if (g_tMwFlashSvcThread == NULL)
+        return MW_FLASH_SVC_FAIL;
+
+    ulSecAddr &= ~(MW_FLASH_SVC_SECTOR_SIZE - 1);
+
+    osSemaphoreWait(g_tMwFlashSvcLock, osWaitForever);
+
+    for (i=0; i<MW_FLASH_SVC_PEND_NUM; i++)
+    {
+        if (g_ulaMwFlashSvcPend[i] == ulSecAddr)
+        {
+            ubRet = MW_FLASH_SVC_OK;
+            goto done;
+        }
+    }
+
+    for (i=0; i<MW_FLASH_SVC_PEND_NUM; i++)
+    {
+        if (g_ulaMwFlashSvcPend[i] == MW_FLASH_SVC_ADDR_NONE)
+        {
+            g_ulaMwFlashSvcPend[i] = ulSecAddr;
+            ubRet = MW_FLASH_SVC_OK;
+            break;
+        }
+    }
+
+done:
+    osSemaphoreRelease(g_tMwFlashSvcLock);
+
+    if (ubRet == MW_FLASH_SVC_OK)
+        MwFlashSvc_Wake();
+
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFlashSvc_EraseSync
+*
+* DESCRIPTION:
+*   finish the erase of a sector queued by MwFlashSvc_EraseLater
+*
+* PARAMETERS
+*   1. ulSecAddr : [In] the address of sector
+*
+* RETURNS
+*   MW_FLASH_SVC_OK   : successful, or not queued
+*   MW_FLASH_SVC_FAIL : fail
+*
+*************************************************************************/
+uint8_t MwFlashSvc_EraseSync(uint32_t ulSecAddr)
+{
+    uint8_t ubRet = MW_FLASH_SVC_OK;
+    uint32_t i;
+
+    if (g_tMwFlashSvcThread == NULL)
+        return MW_FLASH_SVC_OK;
+
+    ulSecAddr &= ~(MW_FLASH_SVC_SECTOR_SIZE - 1);
+
+    osSemaphoreWait(g_tMwFlashSvcLock, osWaitForever);
+
+    if (g_ulMwFlashSvcBusyAddr == ulSecAddr)
+        MwFlashSvc_BusyWait();
+
+    for (i=0; i<MW_FLASH_SVC_PEND_NUM; i++)
+    {
+        if (g_ulaMwFlashSvcPend[i] == ulSecAddr)
+        {
+            g_ulaMwFlashSvcPend[i] = MW_FLASH_SVC_ADDR_NONE;
+            g_tMwFlashSvcStat.ulEraseSync++;
+
+            if (0 != Hal_Flash_4KSectorAddrErase(SPI_IDX_0, ulSecAddr))
+                ubRet = MW_FLASH_SVC_FAIL;
+        }
+    }
+
+    osSemaphoreRelease(g_tMwFlashSvcLock);
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFlashSvc_StatGet
+*
+* DESCRIPTION:
+*   get the statistics
+*
+* PARAMETERS
+*   1. ptStat : [Out] the statistics
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwFlashSvc_StatGet(T_MwFlashSvcStat *ptStat)
+{
+    *ptStat = g_tMwFlashSvcStat;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFlashSvc_StatReset
+*
+* DESCRIPTION:
+*   clear the statistics
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwFlashSvc_StatReset(void)
+{
+    memset(&g_tMwFlashSvcStat, 0, sizeof(g_tMwFlashSvcStat));
+}
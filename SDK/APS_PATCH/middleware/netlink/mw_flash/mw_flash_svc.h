@@ -0,0 +1,115 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  mw_flash_svc.h
+*
+*  Project:
+*  --------
+*  OPL1000 Project - the flash erase service definition file
+*
+*  Description:
+*  ------------
+*  This include file is the flash erase service definition file.
+*
+*  A sequential writer declares its area with MwFlashSvc_WriterOpen. A low
+*  priority task then erases the sectors in front of the writer, at most
+*  MW_FLASH_SVC_ERASE_AHEAD sectors ahead of the last written address, one
+*  sector at a time through Hal_Flash_EraseStart (reads suspend it). Before
+*  each write the writer calls MwFlashSvc_WriterReady, which erases in place
+*  whatever the task has not done yet.
+*
+*  MwFlashSvc_EraseLater queues a single sector whose erase nobody waits for
+*  (e.g. the FIM swap block), MwFlashSvc_EraseSync completes it before the
+*  sector is used again.
+*
+*  Program and erase from all the clients are serialized by the flash
+*  semaphore of the HAL.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+#ifndef _MW_FLASH_SVC_H_
+#define _MW_FLASH_SVC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <stdint.h>
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define MW_FLASH_SVC_OK                 1
+#define MW_FLASH_SVC_FAIL               0
+
+#define MW_FLASH_SVC_WRITER_NUM         2
+#define MW_FLASH_SVC_PEND_NUM           4       // sectors queued by MwFlashSvc_EraseLater
+#define MW_FLASH_SVC_ERASE_AHEAD        8       // sectors, 0: the whole area
+#define MW_FLASH_SVC_POLL_MS            2       // poll the background erase
+
+
+/******************************
+Declaration of data structure
+******************************/
+// Sec 3: structure, uniou, enum, linked list
+typedef struct
+{
+    uint32_t ulEraseAhead;      // sectors erased by the task for a writer
+    uint32_t ulEraseDemand;     // sectors a writer had to erase itself
+    uint32_t ulEraseLater;      // sectors erased by the task for MwFlashSvc_EraseLater
+    uint32_t ulEraseSync;       // queued sectors needed before the task got to them
+    uint32_t ulWriterWait;      // a writer waited for the sector the task was erasing
+    uint32_t ulStartFail;       // Hal_Flash_EraseStart failed
+} T_MwFlashSvcStat;
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+
+// Sec 5: declaration of global function prototype
+void MwFlashSvc_Init(void);
+
+uint8_t MwFlashSvc_WriterOpen(uint32_t ulAddr, uint32_t ulSize, int8_t *pbHandle);
+uint8_t MwFlashSvc_WriterReady(int8_t bHandle, uint32_t ulAddr, uint32_t ulSize);
+void MwFlashSvc_WriterClose(int8_t bHandle);
+
+uint8_t MwFlashSvc_EraseLater(uint32_t ulSecAddr);
+uint8_t MwFlashSvc_EraseSync(uint32_t ulSecAddr);
+
+void MwFlashSvc_StatGet(T_MwFlashSvcStat *ptStat);
+void MwFlashSvc_StatReset(void);
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+
+
+// Sec 7: declaration of static function prototype
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _MW_FLASH_SVC_H_
@@ -0,0 +1,1156 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  mw_log_flash.c
+*
+*  Project:
+*  --------
+*  OPL1000 Project - the flash log implement file
+*
+*  Description:
+*  ------------
+*  This implement file is include the flash log function and api.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "sys_os_config_patch.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "at_cmd.h"
+#include "at_cmd_common.h"
+#include "at_cmd_data_process.h"
+#include "hal_system.h"
+#include "hal_flash.h"
+#include "mw_flash_svc.h"
+#include "mw_log_flash.h"
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define MW_LOG_FLASH_ADDR_NONE          0xFFFFFFFF
+#define MW_LOG_FLASH_LEVEL_DEF          (LOG_HIGH_LEVEL | LOG_MED_LEVEL)
+#define MW_LOG_FLASH_RATE_NUM           3           // LOW, MED, HIGH
+#define MW_LOG_FLASH_RATE_WINDOW        100000      // ms, the longest refill counted
+#define MW_LOG_FLASH_BLANK_CHUNK        64
+#define MW_LOG_FLASH_PARAM_MAX          3
+
+#define MW_LOG_FLASH_CRIT_ENTER(x)      do { x = __get_PRIMASK(); __disable_irq(); } while(0)
+#define MW_LOG_FLASH_CRIT_EXIT(x)       __set_PRIMASK(x)
+
+
+/******************************
+Declaration of data structure
+******************************/
+// Sec 3: structure, uniou, enum, linked list
+typedef struct
+{
+    uint32_t ulPerSec;          // lines per second
+    uint32_t ulBurst;           // lines
+} T_MwLogFlashRate;
+
+typedef struct
+{
+    uint32_t ulSkip;            // the records before the last ones asked
+    uint32_t ulNum;
+    uint8_t ubOut;
+} T_MwLogFlashDump;
+
+// a valid record, in the order of the sequence
+typedef void (*T_MwLogFlashVisitFp)(const T_MwLogFlashRec *ptRec, const char *sText, void *pCtx);
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+
+// Sec 5: declaration of global function prototype
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static osThreadId g_tMwLogFlashThread;
+static osSemaphoreId g_tMwLogFlashLock;         // the flash and the state of the head
+static osSemaphoreId g_tMwLogFlashWake;
+
+// the lines not written yet: the head of the record and the text
+static uint8_t g_ubaMwLogFlashRam[MW_LOG_FLASH_RAM_SIZE];
+static uint32_t g_ulMwLogFlashRamIn;
+static uint32_t g_ulMwLogFlashRamOut;
+static uint32_t g_ulMwLogFlashRamUsed;
+
+static uint8_t g_ubMwLogFlashEnable = 1;
+static uint8_t g_ubMwLogFlashLevel = MW_LOG_FLASH_LEVEL_DEF;
+
+// keep the erase count of the sectors low under a flood of logs
+static const T_MwLogFlashRate g_taMwLogFlashRate[MW_LOG_FLASH_RATE_NUM] =
+{
+    {1, 8},                     // LOG_LOW_LEVEL
+    {1, 16},                    // LOG_MED_LEVEL
+    {2, 32},                    // LOG_HIGH_LEVEL
+};
+static uint32_t g_ulaMwLogFlashToken[MW_LOG_FLASH_RATE_NUM] = {8000, 16000, 32000};   // 1/1000 line
+static uint32_t g_ulMwLogFlashTokenTick;
+
+static uint8_t g_ubMwLogFlashMounted;
+static int32_t g_lMwLogFlashHead = -1;          // the sector written, -1: none
+static uint32_t g_ulMwLogFlashOff;              // the free offset in the head
+static uint32_t g_ulMwLogFlashSecSeq;
+static uint32_t g_ulMwLogFlashSeq;
+static uint16_t g_uwMwLogFlashBoot;
+static uint32_t g_ulMwLogFlashAhead = MW_LOG_FLASH_ADDR_NONE;   // queued to the erase service
+static uint32_t g_ulMwLogFlashCut;
+static T_MwLogFlashStat g_tMwLogFlashStat;
+
+
+// Sec 7: declaration of static function prototype
+
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static uint16_t MwLogFlash_Crc16(uint16_t uwCrc, const uint8_t *pubData, uint32_t ulSize)
+{
+    uint32_t i;
+
+    while (ulSize--)
+    {
+        uwCrc ^= (uint16_t)(*pubData++) << 8;
+
+        for (i=0; i<8; i++)
+            uwCrc = (uwCrc & 0x8000) ? ((uwCrc << 1) ^ 0x1021) : (uwCrc << 1);
+    }
+
+    return uwCrc;
+}
+
+static uint32_t MwLogFlash_SecAddr(uint32_t ulSec)
+{
+    return MW_LOG_FLASH_ADDR + (ulSec * MW_LOG_FLASH_SECTOR_SIZE);
+}
+
+static uint32_t MwLogFlash_RecSize(uint8_t ubLen)
+{
+    return (sizeof(T_MwLogFlashRec) + ubLen + 3) & ~3;
+}
+
+static uint8_t MwLogFlash_IsBlank(const uint8_t *pubData, uint32_t ulSize)
+{
+    while (ulSize--)
+    {
+        if (*pubData++ != 0xFF)
+            return 0;
+    }
+
+    return 1;
+}
+
+static uint16_t MwLogFlash_RecCrc(const T_MwLogFlashRec *ptRec, const uint8_t *pubText)
+{
+    T_MwLogFlashRec tRec = *ptRec;
+
+    tRec.uwCrc = 0;
+
+    return MwLogFlash_Crc16(MwLogFlash_Crc16(0xFFFF, (uint8_t *)&tRec, sizeof(tRec)), pubText, tRec.ubLen);
+}
+
+// 1: the head of the sector is valid
+static uint8_t MwLogFlash_SecRead(uint32_t ulSec, T_MwLogFlashSec *ptSec)
+{
+    if (0 != Hal_Flash_AddrRead(SPI_IDX_0, MwLogFlash_SecAddr(ulSec), 0, sizeof(T_MwLogFlashSec), (uint8_t *)ptSec))
+        return 0;
+
+    return ((ptSec->ulMagic == MW_LOG_FLASH_SEC_MAGIC) && (ptSec->ulSeqInv == ~ptSec->ulSeq));
+}
+
+// 0: valid, 1: blank (the end of the sector), -1: broken (cut by a power loss)
+static int MwLogFlash_RecRead(uint32_t ulSec, uint32_t ulOff, T_MwLogFlashRec *ptRec, char *sText)
+{
+    uint32_t ulAddr = MwLogFlash_SecAddr(ulSec) + ulOff;
+
+    if ((ulOff + sizeof(T_MwLogFlashRec)) > MW_LOG_FLASH_SECTOR_SIZE)
+        return 1;
+
+    if (0 != Hal_Flash_AddrRead(SPI_IDX_0, ulAddr, 0, sizeof(T_MwLogFlashRec), (uint8_t *)ptRec))
+        return -1;
+
+    if (MwLogFlash_IsBlank((uint8_t *)ptRec, sizeof(T_MwLogFlashRec)))
+        return 1;
+
+    if ((ptRec->ubMagic != MW_LOG_FLASH_REC_MAGIC) || (ptRec->ubLen > MW_LOG_FLASH_TEXT_MAX) ||
+        ((ulOff + MwLogFlash_RecSize(ptRec->ubLen)) > MW_LOG_FLASH_SECTOR_SIZE))
+        return -1;
+
+    if (0 != Hal_Flash_AddrRead(SPI_IDX_0, ulAddr + sizeof(T_MwLogFlashRec), 0, ptRec->ubLen, (uint8_t *)sText))
+        return -1;
+
+    if (ptRec->uwCrc != MwLogFlash_RecCrc(ptRec, (uint8_t *)sText))
+        return -1;
+
+    sText[ptRec->ubLen] = 0;
+    return 0;
+}
+
+// 1: nothing programmed from ulOff to the end of the sector
+static uint8_t MwLogFlash_TailBlank(uint32_t ulSec, uint32_t ulOff)
+{
+    uint8_t ubaBuf[MW_LOG_FLASH_BLANK_CHUNK];
+    uint32_t ulSize;
+
+    while (ulOff < MW_LOG_FLASH_SECTOR_SIZE)
+    {
+        ulSize = MW_LOG_FLASH_SECTOR_SIZE - ulOff;
+        if (ulSize > sizeof(ubaBuf))
+            ulSize = sizeof(ubaBuf);
+
+        if (0 != Hal_Flash_AddrRead(SPI_IDX_0, MwLogFlash_SecAddr(ulSec) + ulOff, 0, ulSize, ubaBuf))
+            return 0;
+
+        if (!MwLogFlash_IsBlank(ubaBuf, ulSize))
+            return 0;
+
+        ulOff += ulSize;
+    }
+
+    return 1;
+}
+
+// the valid sectors, oldest first
+static uint32_t MwLogFlash_SecOrder(uint32_t *pulSec, uint32_t *pulSeq)
+{
+    T_MwLogFlashSec tSec;
+    uint32_t ulNum = 0;
+    uint32_t i, j;
+
+    for (i=0; i<MW_LOG_FLASH_SECTOR_NUM; i++)
+    {
+        if (!MwLogFlash_SecRead(i, &tSec))
+            continue;
+
+        for (j=ulNum; (j > 0) && (pulSeq[j - 1] > tSec.ulSeq); j--)
+        {
+            pulSec[j] = pulSec[j - 1];
+            pulSeq[j] = pulSeq[j - 1];
+        }
+
+        pulSec[j] = i;
+        pulSeq[j] = tSec.ulSeq;
+        ulNum++;
+    }
+
+    return ulNum;
+}
+
+// the records of a sector, the caller holds the lock
+static uint32_t MwLogFlash_SecScan(uint32_t ulSec, T_MwLogFlashVisitFp fpVisit, void *pCtx, uint32_t *pulEnd, uint8_t *pubTorn)
+{
+    T_MwLogFlashRec tRec;
+    char sText[MW_LOG_FLASH_TEXT_MAX + 1];
+    uint32_t ulOff = sizeof(T_MwLogFlashSec);
+    uint32_t ulNum = 0;
+    int iRet;
+
+    *pubTorn = 0;
+
+    for (;;)
+    {
+        iRet = MwLogFlash_RecRead(ulSec, ulOff, &tRec, sText);
+        if (iRet > 0)
+            break;
+
+        if (iRet < 0)
+        {
+            // nothing after a broken record is trusted
+            *pubTorn = 1;
+            ulOff = MW_LOG_FLASH_SECTOR_SIZE;
+            break;
+        }
+
+        if (fpVisit)
+            fpVisit(&tRec, sText, pCtx);
+
+        ulNum++;
+        ulOff += MwLogFlash_RecSize(tRec.ubLen);
+    }
+
+    *pulEnd = ulOff;
+    return ulNum;
+}
+
+static void MwLogFlash_MountVisit(const T_MwLogFlashRec *ptRec, const char *sText, void *pCtx)
+{
+    if ((int32_t)(ptRec->ulSeq - g_ulMwLogFlashSeq) > 0)
+        g_ulMwLogFlashSeq = ptRec->ulSeq;
+
+    if ((int16_t)(ptRec->uwBoot - g_uwMwLogFlashBoot) > 0)
+        g_uwMwLogFlashBoot = ptRec->uwBoot;
+}
+
+// find the head, the last sequence and the last boot, the caller holds the lock
+static void MwLogFlash_Mount(void)
+{
+    uint32_t ulaSec[MW_LOG_FLASH_SECTOR_NUM];
+    uint32_t ulaSeq[MW_LOG_FLASH_SECTOR_NUM];
+    T_MwLogFlashSec tSec;
+    uint32_t ulNum;
+    uint32_t ulEnd = 0;
+    uint32_t ulNext;
+    uint8_t ubTorn = 0;
+    uint32_t i;
+
+    g_lMwLogFlashHead = -1;
+    g_ulMwLogFlashOff = 0;
+    g_ulMwLogFlashSecSeq = 0;
+    g_ulMwLogFlashSeq = 0;
+    g_uwMwLogFlashBoot = 0;
+
+    ulNum = MwLogFlash_SecOrder(ulaSec, ulaSeq);
+
+    for (i=0; i<ulNum; i++)
+        MwLogFlash_SecScan(ulaSec[i], MwLogFlash_MountVisit, NULL, &ulEnd, &ubTorn);
+
+    g_uwMwLogFlashBoot++;
+
+    if (ulNum == 0)
+        goto done;
+
+    // the end of the last sector scanned is the free offset of the head
+    g_lMwLogFlashHead = ulaSec[ulNum - 1];
+    g_ulMwLogFlashSecSeq = ulaSeq[ulNum - 1];
+    g_ulMwLogFlashOff = ulEnd;
+
+    // a record cut before its head was programmed leaves bits after the end
+    if ((ubTorn) || (!MwLogFlash_TailBlank(g_lMwLogFlashHead, g_ulMwLogFlashOff)))
+    {
+        g_ulMwLogFlashOff = MW_LOG_FLASH_SECTOR_SIZE;
+        g_tMwLogFlashStat.ulSecTorn++;
+    }
+
+    // the sector after the head is erased before it is used
+    ulNext = (g_lMwLogFlashHead + 1) % MW_LOG_FLASH_SECTOR_NUM;
+    if (0 == Hal_Flash_AddrRead(SPI_IDX_0, MwLogFlash_SecAddr(ulNext), 0, sizeof(tSec), (uint8_t *)&tSec))
+    {
+        if ((!MwLogFlash_IsBlank((uint8_t *)&tSec, sizeof(tSec))) &&
+            (MW_FLASH_SVC_OK == MwFlashSvc_EraseLater(MwLogFlash_SecAddr(ulNext))))
+            g_ulMwLogFlashAhead = MwLogFlash_SecAddr(ulNext);
+    }
+
+done:
+    g_ubMwLogFlashMounted = 1;
+}
+
+// every program of the log, g_ulMwLogFlashCut stops the system in the middle of one
+static uint8_t MwLogFlash_Program(uint32_t ulAddr, uint32_t ulSize, uint8_t *pubData)
+{
+    if (g_ulMwLogFlashCut)
+    {
+        if (ulSize > g_ulMwLogFlashCut)
+            ulSize = g_ulMwLogFlashCut;
+
+        Hal_Flash_AddrProgram(SPI_IDX_0, ulAddr, 0, ulSize, pubData);
+        tracer_cli(LOG_HIGH_LEVEL, "log_flash: cut at 0x%X after %u bytes, reset\n", ulAddr, ulSize);
+
+        Hal_Sys_SwResetAll();
+        while (1)
+            ;
+    }
+
+    if (0 != Hal_Flash_AddrProgram(SPI_IDX_0, ulAddr, 0, ulSize, pubData))
+    {
+        g_tMwLogFlashStat.ulProgFail++;
+        return MW_LOG_FLASH_FAIL;
+    }
+
+    return MW_LOG_FLASH_OK;
+}
+
+// erase the next sector and start it, the caller holds the lock
+static uint8_t MwLogFlash_SecOpen(void)
+{
+    T_MwLogFlashSec tSec;
+    uint32_t ulSec;
+    uint32_t ulAddr;
+    uint8_t ubErased = 0;
+
+    ulSec = (g_lMwLogFlashHead < 0) ? 0 : ((g_lMwLogFlashHead + 1) % MW_LOG_FLASH_SECTOR_NUM);
+    ulAddr = MwLogFlash_SecAddr(ulSec);
+
+    // done by the service, or finished now
+    if (g_ulMwLogFlashAhead == ulAddr)
+        ubErased = (MW_FLASH_SVC_OK == MwFlashSvc_EraseSync(ulAddr));
+
+    g_ulMwLogFlashAhead = MW_LOG_FLASH_ADDR_NONE;
+
+    if ((!ubErased) && (0 != Hal_Flash_4KSectorAddrErase(SPI_IDX_0, ulAddr)))
+        return MW_LOG_FLASH_FAIL;
+
+    g_ulMwLogFlashSecSeq++;
+    tSec.ulMagic = MW_LOG_FLASH_SEC_MAGIC;
+    tSec.ulSeq = g_ulMwLogFlashSecSeq;
+    tSec.ulSeqInv = ~g_ulMwLogFlashSecSeq;
+    tSec.ulReserved = 0xFFFFFFFF;
+
+    g_lMwLogFlashHead = ulSec;
+    g_ulMwLogFlashOff = MW_LOG_FLASH_SECTOR_SIZE;       // closed until the head is programmed
+
+    if (MW_LOG_FLASH_OK != MwLogFlash_Program(ulAddr, sizeof(tSec), (uint8_t *)&tSec))
+        return MW_LOG_FLASH_FAIL;
+
+    g_ulMwLogFlashOff = sizeof(tSec);
+    g_tMwLogFlashStat.ulSecOpen++;
+
+    // one sector ahead: it holds the oldest lines
+    ulAddr = MwLogFlash_SecAddr((ulSec + 1) % MW_LOG_FLASH_SECTOR_NUM);
+    if (MW_FLASH_SVC_OK == MwFlashSvc_EraseLater(ulAddr))
+        g_ulMwLogFlashAhead = ulAddr;
+
+    return MW_LOG_FLASH_OK;
+}
+
+// the caller holds the lock, pubBuf: the head of the record and the text
+static uint8_t MwLogFlash_RecWrite(uint8_t *pubBuf)
+{
+    T_MwLogFlashRec *ptRec = (T_MwLogFlashRec *)pubBuf;
+    uint32_t ulSize = MwLogFlash_RecSize(ptRec->ubLen);
+
+    if ((g_lMwLogFlashHead < 0) || ((g_ulMwLogFlashOff + ulSize) > MW_LOG_FLASH_SECTOR_SIZE))
+    {
+        if (MW_LOG_FLASH_OK != MwLogFlash_SecOpen())
+            return MW_LOG_FLASH_FAIL;
+    }
+
+    ptRec->ulSeq = ++g_ulMwLogFlashSeq;
+    ptRec->uwBoot = g_uwMwLogFlashBoot;
+    ptRec->uwCrc = MwLogFlash_RecCrc(ptRec, pubBuf + sizeof(T_MwLogFlashRec));
+
+    if (MW_LOG_FLASH_OK != MwLogFlash_Program(MwLogFlash_SecAddr(g_lMwLogFlashHead) + g_ulMwLogFlashOff,
+                                              sizeof(T_MwLogFlashRec) + ptRec->ubLen, pubBuf))
+    {
+        // the place is unknown now, go on in the next sector
+        g_ulMwLogFlashOff = MW_LOG_FLASH_SECTOR_SIZE;
+        return MW_LOG_FLASH_FAIL;
+    }
+
+    g_ulMwLogFlashOff += ulSize;
+    g_tMwLogFlashStat.ulWritten++;
+
+    return MW_LOG_FLASH_OK;
+}
+
+// the caller is in the critical section
+static void MwLogFlash_RamCopy(uint32_t ulPos, uint8_t *pubData, uint32_t ulSize, uint8_t ubIn)
+{
+    uint32_t i;
+
+    for (i=0; i<ulSize; i++)
+    {
+        if (ubIn)
+            g_ubaMwLogFlashRam[(ulPos + i) % MW_LOG_FLASH_RAM_SIZE] = pubData[i];
+        else
+            pubData[i] = g_ubaMwLogFlashRam[(ulPos + i) % MW_LOG_FLASH_RAM_SIZE];
+    }
+}
+
+// take the oldest line, 0: none
+static uint32_t MwLogFlash_RamPop(uint8_t *pubBuf)
+{
+    T_MwLogFlashRec *ptRec = (T_MwLogFlashRec *)pubBuf;
+    uint32_t ulPrimask;
+    uint32_t ulSize = 0;
+
+    MW_LOG_FLASH_CRIT_ENTER(ulPrimask);
+
+    if (g_ulMwLogFlashRamUsed < sizeof(T_MwLogFlashRec))
+        goto done;
+
+    MwLogFlash_RamCopy(g_ulMwLogFlashRamOut, pubBuf, sizeof(T_MwLogFlashRec), 0);
+    ulSize = sizeof(T_MwLogFlashRec) + ptRec->ubLen;
+    MwLogFlash_RamCopy(g_ulMwLogFlashRamOut, pubBuf, ulSize, 0);
+
+    g_ulMwLogFlashRamOut = (g_ulMwLogFlashRamOut + ulSize) % MW_LOG_FLASH_RAM_SIZE;
+    g_ulMwLogFlashRamUsed -= ulSize;
+
+done:
+    MW_LOG_FLASH_CRIT_EXIT(ulPrimask);
+    return ulSize;
+}
+
+static uint8_t MwLogFlash_TokenTake(uint8_t ubLevel)
+{
+    uint32_t ulNow = osKernelSysTick();
+    uint32_t ulDiff;
+    uint32_t ulPrimask;
+    uint32_t ulIdx;
+    uint32_t ulMax;
+    uint8_t ubRet = 0;
+    uint32_t i;
+
+    if (ubLevel & LOG_HIGH_LEVEL)
+        ulIdx = 2;
+    else if (ubLevel & LOG_MED_LEVEL)
+        ulIdx = 1;
+    else
+        ulIdx = 0;
+
+    MW_LOG_FLASH_CRIT_ENTER(ulPrimask);
+
+    ulDiff = ulNow - g_ulMwLogFlashTokenTick;
+    if (ulDiff > MW_LOG_FLASH_RATE_WINDOW)
+        ulDiff = MW_LOG_FLASH_RATE_WINDOW;
+
+    g_ulMwLogFlashTokenTick = ulNow;
+
+    // lines per second are 1/1000 line per ms
+    for (i=0; i<MW_LOG_FLASH_RATE_NUM; i++)
+    {
+        ulMax = g_taMwLogFlashRate[i].ulBurst * 1000;
+        g_ulaMwLogFlashToken[i] += ulDiff * g_taMwLogFlashRate[i].ulPerSec;
+        if (g_ulaMwLogFlashToken[i] > ulMax)
+            g_ulaMwLogFlashToken[i] = ulMax;
+    }
+
+    if (g_ulaMwLogFlashToken[ulIdx] >= 1000)
+    {
+        g_ulaMwLogFlashToken[ulIdx] -= 1000;
+        ubRet = 1;
+    }
+    else
+    {
+        g_tMwLogFlashStat.ulDropRate++;
+    }
+
+    MW_LOG_FLASH_CRIT_EXIT(ulPrimask);
+    return ubRet;
+}
+
+static void MwLogFlash_Task(void *argument)
+{
+    uint8_t ubaBuf[sizeof(T_MwLogFlashRec) + MW_LOG_FLASH_TEXT_MAX];
+
+    osSemaphoreWait(g_tMwLogFlashLock, osWaitForever);
+    MwLogFlash_Mount();
+    osSemaphoreRelease(g_tMwLogFlashLock);
+
+    for (;;)
+    {
+        // the lines of the boot are waiting already
+        while (MwLogFlash_RamPop(ubaBuf))
+        {
+            osSemaphoreWait(g_tMwLogFlashLock, osWaitForever);
+            MwLogFlash_RecWrite(ubaBuf);
+            osSemaphoreRelease(g_tMwLogFlashLock);
+        }
+
+        osSemaphoreWait(g_tMwLogFlashWake, osWaitForever);
+
+        // collect a batch
+        osDelay(MW_LOG_FLASH_FLUSH_MS);
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwLogFlash_Init
+*
+* DESCRIPTION:
+*   create the task of the flash log, it finds the head in the flash first
+*   (the lines before it are kept in RAM)
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwLogFlash_Init(void)
+{
+    osSemaphoreDef_t tSemaphoreDef;
+    osThreadDef_t tThreadDef;
+
+    if (g_tMwLogFlashThread != NULL)
+        return;
+
+    // create the semaphore
+    tSemaphoreDef.dummy = 0;                            // reserved, it is no used
+    g_tMwLogFlashLock = osSemaphoreCreate(&tSemaphoreDef, 1);
+    if (g_tMwLogFlashLock == NULL)
+    {
+        printf("To create the semaphore for MwLogFlash is fail.\n");
+        return;
+    }
+
+    g_tMwLogFlashWake = osSemaphoreCreate(&tSemaphoreDef, 1);
+    if (g_tMwLogFlashWake == NULL)
+    {
+        printf("To create the semaphore for MwLogFlash is fail.\n");
+        return;
+    }
+    osSemaphoreWait(g_tMwLogFlashWake, 0);              // nothing to do yet
+
+    // create the thread
+    tThreadDef.name = OS_TASK_NAME_LOG_FLASH;
+    tThreadDef.pthread = MwLogFlash_Task;
+    tThreadDef.tpriority = OS_TASK_PRIORITY_LOG_FLASH;
+    tThreadDef.instances = 0;                           // reserved, it is no used
+    tThreadDef.stacksize = OS_TASK_STACK_SIZE_LOG_FLASH;
+    g_tMwLogFlashThread = osThreadCreate(&tThreadDef, NULL);
+    if (g_tMwLogFlashThread == NULL)
+    {
+        printf("To create the thread for MwLogFlash is fail.\n");
+        return;
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwLogFlash_VPut
+*
+* DESCRIPTION:
+*   add a line of the tracer, from a task or an ISR. The line is dropped
+*   over the rate of its level or when the RAM ring is full.
+*
+* PARAMETERS
+*   1. ubLevel : [In] LOG_xxx_LEVEL of the line
+*   2. sFmt    : [In] the format
+*   3. tList   : [In] the arguments
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwLogFlash_VPut(uint8_t ubLevel, const char *sFmt, va_list tList)
+{
+    T_MwLogFlashRec tRec;
+    char sText[MW_LOG_FLASH_TEXT_MAX + 1];
+    uint32_t ulPrimask;
+    uint32_t ulSize;
+    uint8_t ubWake = 0;
+    int iLen;
+
+    if (!MwLogFlash_LevelCheck(ubLevel))
+        return;
+
+    if (!MwLogFlash_TokenTake(ubLevel))
+        return;
+
+    iLen = vsnprintf(sText, sizeof(sText), sFmt, tList);
+    if (iLen > MW_LOG_FLASH_TEXT_MAX)
+        iLen = MW_LOG_FLASH_TEXT_MAX;
+
+    // the dump ends the lines
+    while ((iLen > 0) && ((sText[iLen - 1] == '\n') || (sText[iLen - 1] == '\r')))
+        iLen--;
+
+    if (iLen <= 0)
+        return;
+
+    // the sequence, the boot and the CRC are set by the task
+    memset(&tRec, 0, sizeof(tRec));
+    tRec.ubMagic = MW_LOG_FLASH_REC_MAGIC;
+    tRec.ubLevel = ubLevel;
+    tRec.ubLen = (uint8_t)iLen;
+    tRec.ulTick = osKernelSysTick();
+
+    ulSize = sizeof(tRec) + iLen;
+
+    MW_LOG_FLASH_CRIT_ENTER(ulPrimask);
+
+    if ((g_ulMwLogFlashRamUsed + ulSize) > MW_LOG_FLASH_RAM_SIZE)
+    {
+        g_tMwLogFlashStat.ulDropFull++;
+    }
+    else
+    {
+        ubWake = (g_ulMwLogFlashRamUsed == 0);
+
+        MwLogFlash_RamCopy(g_ulMwLogFlashRamIn, (uint8_t *)&tRec, sizeof(tRec), 1);
+        MwLogFlash_RamCopy(g_ulMwLogFlashRamIn + sizeof(tRec), (uint8_t *)sText, iLen, 1);
+        g_ulMwLogFlashRamIn = (g_ulMwLogFlashRamIn + ulSize) % MW_LOG_FLASH_RAM_SIZE;
+        g_ulMwLogFlashRamUsed += ulSize;
+    }
+
+    MW_LOG_FLASH_CRIT_EXIT(ulPrimask);
+
+    if ((ubWake) && (g_tMwLogFlashWake != NULL))
+        osSemaphoreRelease(g_tMwLogFlashWake);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwLogFlash_EnableSet
+*
+* DESCRIPTION:
+*   turn the flash log on or off, the lines in flash are kept
+*
+* PARAMETERS
+*   1. ubEnable : [In] 0: off, 1: on
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwLogFlash_EnableSet(uint8_t ubEnable)
+{
+    g_ubMwLogFlashEnable = ubEnable ? 1 : 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwLogFlash_LevelSet
+*
+* DESCRIPTION:
+*   set the levels kept in flash
+*
+* PARAMETERS
+*   1. ubLevel : [In] the mask of LOG_xxx_LEVEL
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwLogFlash_LevelSet(uint8_t ubLevel)
+{
+    g_ubMwLogFlashLevel = ubLevel & LOG_ALL_LEVEL;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwLogFlash_LevelCheck
+*
+* DESCRIPTION:
+*   check if a line of the level is kept, before it is formatted
+*
+* PARAMETERS
+*   1. ubLevel : [In] LOG_xxx_LEVEL of the line
+*
+* RETURNS
+*   1 : kept
+*   0 : not kept
+*
+*************************************************************************/
+uint8_t MwLogFlash_LevelCheck(uint8_t ubLevel)
+{
+    return ((g_ubMwLogFlashEnable) && (ubLevel & g_ubMwLogFlashLevel));
+}
+
+// every valid record, oldest first, the lock is held for one record at a time
+static uint32_t MwLogFlash_Walk(T_MwLogFlashVisitFp fpVisit, void *pCtx)
+{
+    uint32_t ulaSec[MW_LOG_FLASH_SECTOR_NUM];
+    uint32_t ulaSeq[MW_LOG_FLASH_SECTOR_NUM];
+    T_MwLogFlashSec tSec;
+    T_MwLogFlashRec tRec;
+    char sText[MW_LOG_FLASH_TEXT_MAX + 1];
+    uint32_t ulSecNum;
+    uint32_t ulNum = 0;
+    uint32_t ulOff;
+    uint32_t i;
+    int iRet;
+
+    osSemaphoreWait(g_tMwLogFlashLock, osWaitForever);
+    ulSecNum = MwLogFlash_SecOrder(ulaSec, ulaSeq);
+    osSemaphoreRelease(g_tMwLogFlashLock);
+
+    for (i=0; i<ulSecNum; i++)
+    {
+        ulOff = sizeof(T_MwLogFlashSec);
+
+        for (;;)
+        {
+            osSemaphoreWait(g_tMwLogFlashLock, osWaitForever);
+
+            // the sector may be erased for the head in the meantime
+            if ((!MwLogFlash_SecRead(ulaSec[i], &tSec)) || (tSec.ulSeq != ulaSeq[i]))
+                iRet = 1;
+            else
+                iRet = MwLogFlash_RecRead(ulaSec[i], ulOff, &tRec, sText);
+
+            osSemaphoreRelease(g_tMwLogFlashLock);
+
+            if (iRet != 0)
+                break;
+
+            if (fpVisit)
+                fpVisit(&tRec, sText, pCtx);
+
+            ulNum++;
+            ulOff += MwLogFlash_RecSize(tRec.ubLen);
+        }
+    }
+
+    return ulNum;
+}
+
+static char MwLogFlash_LevelChar(uint8_t ubLevel)
+{
+    if (ubLevel & LOG_HIGH_LEVEL)
+        return 'H';
+
+    if (ubLevel & LOG_MED_LEVEL)
+        return 'M';
+
+    return 'L';
+}
+
+static void MwLogFlash_DumpVisit(const T_MwLogFlashRec *ptRec, const char *sText, void *pCtx)
+{
+    T_MwLogFlashDump *ptDump = (T_MwLogFlashDump *)pCtx;
+
+    if (ptDump->ulSkip)
+    {
+        ptDump->ulSkip--;
+        return;
+    }
+
+    if (ptDump->ubOut == MW_LOG_FLASH_OUT_AT)
+    {
+        msg_print_uart1("+LOGFLASH:%u,%u,%u,%c,%s\r\n", ptRec->ulSeq, ptRec->uwBoot, ptRec->ulTick,
+                        MwLogFlash_LevelChar(ptRec->ubLevel), sText);
+    }
+    else
+    {
+        // printf() is the tracer, which copies its lines here: print directly
+        tracer_cli(LOG_HIGH_LEVEL, "%6u %4u %6u.%03u %c %s\n", ptRec->ulSeq, ptRec->uwBoot,
+                   ptRec->ulTick / 1000, ptRec->ulTick % 1000, MwLogFlash_LevelChar(ptRec->ubLevel), sText);
+    }
+
+    ptDump->ulNum++;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwLogFlash_Dump
+*
+* DESCRIPTION:
+*   print the lines in flash, oldest first
+*
+* PARAMETERS
+*   1. ulLast : [In] the last lines only, 0: all
+*   2. ubOut  : [In] MW_LOG_FLASH_OUT_CLI / MW_LOG_FLASH_OUT_AT
+*
+* RETURNS
+*   the number of lines printed
+*
+*************************************************************************/
+uint32_t MwLogFlash_Dump(uint32_t ulLast, uint8_t ubOut)
+{
+    T_MwLogFlashDump tDump;
+    uint32_t ulNum;
+
+    if (!g_ubMwLogFlashMounted)
+        return 0;
+
+    memset(&tDump, 0, sizeof(tDump));
+    tDump.ubOut = ubOut;
+
+    if (ulLast)
+    {
+        ulNum = MwLogFlash_Walk(NULL, NULL);
+        if (ulNum > ulLast)
+            tDump.ulSkip = ulNum - ulLast;
+    }
+
+    MwLogFlash_Walk(MwLogFlash_DumpVisit, &tDump);
+
+    return tDump.ulNum;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwLogFlash_Erase
+*
+* DESCRIPTION:
+*   erase all the lines in flash, the sequence goes on
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   MW_LOG_FLASH_OK   : successful
+*   MW_LOG_FLASH_FAIL : fail
+*
+*************************************************************************/
+uint8_t MwLogFlash_Erase(void)
+{
+    uint8_t ubRet = MW_LOG_FLASH_OK;
+    uint32_t ulAddr;
+    uint32_t i;
+
+    if (!g_ubMwLogFlashMounted)
+        return MW_LOG_FLASH_FAIL;
+
+    osSemaphoreWait(g_tMwLogFlashLock, osWaitForever);
+
+    for (i=0; i<MW_LOG_FLASH_SECTOR_NUM; i++)
+    {
+        ulAddr = MwLogFlash_SecAddr(i);
+
+        // not in the queue of the service any more
+        if (g_ulMwLogFlashAhead == ulAddr)
+            MwFlashSvc_EraseSync(ulAddr);
+
+        if (0 != Hal_Flash_4KSectorAddrErase(SPI_IDX_0, ulAddr))
+            ubRet = MW_LOG_FLASH_FAIL;
+    }
+
+    g_ulMwLogFlashAhead = MW_LOG_FLASH_ADDR_NONE;
+    g_lMwLogFlashHead = -1;
+    g_ulMwLogFlashOff = 0;
+
+    osSemaphoreRelease(g_tMwLogFlashLock);
+    return ubRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwLogFlash_CutSet
+*
+* DESCRIPTION:
+*   the test of a power loss: the next program of the log stops after
+*   ulBytes and the system is reset
+*
+* PARAMETERS
+*   1. ulBytes : [In] the bytes programmed, 0: off
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwLogFlash_CutSet(uint32_t ulBytes)
+{
+    g_ulMwLogFlashCut = ulBytes;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwLogFlash_StatGet
+*
+* DESCRIPTION:
+*   get the statistics
+*
+* PARAMETERS
+*   1. ptStat : [Out] the statistics
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwLogFlash_StatGet(T_MwLogFlashStat *ptStat)
+{
+    *ptStat = g_tMwLogFlashStat;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwLogFlash_Status
+*
+* DESCRIPTION:
+*   print the state of the flash log
+*
+* PARAMETERS
+*   1. ubOut : [In] MW_LOG_FLASH_OUT_CLI / MW_LOG_FLASH_OUT_AT
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwLogFlash_Status(uint8_t ubOut)
+{
+    T_MwLogFlashStat tStat;
+    uint32_t ulNum = 0;
+
+    if (g_ubMwLogFlashMounted)
+        ulNum = MwLogFlash_Walk(NULL, NULL);
+
+    MwLogFlash_StatGet(&tStat);
+
+    if (ubOut == MW_LOG_FLASH_OUT_AT)
+    {
+        msg_print_uart1("+LOGFLASH:%u,%u,%u,%u,%u,%u\r\n", g_ubMwLogFlashEnable, g_ubMwLogFlashLevel,
+                        ulNum, tStat.ulWritten, tStat.ulDropRate + tStat.ulDropFull, tStat.ulSecTorn);
+        return;
+    }
+
+    tracer_cli(LOG_HIGH_LEVEL, "logflash: %s level=0x%02X 0x%X+%u*%uKB lines=%u head=%d/%u seq=%u boot=%u\n",
+               g_ubMwLogFlashEnable ? "on" : "off", g_ubMwLogFlashLevel, MW_LOG_FLASH_ADDR,
+               MW_LOG_FLASH_SECTOR_NUM, MW_LOG_FLASH_SECTOR_SIZE / 1024, ulNum,
+               g_lMwLogFlashHead, g_ulMwLogFlashOff, g_ulMwLogFlashSeq, g_uwMwLogFlashBoot);
+    tracer_cli(LOG_HIGH_LEVEL, "logflash: written=%u drop_rate=%u drop_full=%u ram=%u/%u sectors=%u torn=%u prog_fail=%u\n",
+               tStat.ulWritten, tStat.ulDropRate, tStat.ulDropFull, g_ulMwLogFlashRamUsed, MW_LOG_FLASH_RAM_SIZE,
+               tStat.ulSecOpen, tStat.ulSecTorn, tStat.ulProgFail);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwLogFlash_Cmd
+*
+* DESCRIPTION:
+*   diag command: logflash [dump [n]|erase|level <mask>|on|off|cut <bytes>]
+*     no argument: the state and the counters
+*     dump: the lines in flash, the last n only
+*     erase: erase them
+*     level: the levels kept, 0x04 high, 0x02 med, 0x01 low
+*     on/off: the flash log
+*     cut: a power loss after <bytes> of the next program, then reset
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwLogFlash_Cmd(char *sCmd)
+{
+    char *baParam[MW_LOG_FLASH_PARAM_MAX + 1] = {0};
+    uint32_t ulNum = 0;
+
+    ulNum = ParseParam(sCmd, baParam, MW_LOG_FLASH_PARAM_MAX + 1);
+
+    if (ulNum < 2)
+    {
+        MwLogFlash_Status(MW_LOG_FLASH_OUT_CLI);
+        goto done;
+    }
+
+    if (!strcmp(baParam[1], "dump"))
+    {
+        ulNum = MwLogFlash_Dump((ulNum > 2) ? strtoul(baParam[2], NULL, 0) : 0, MW_LOG_FLASH_OUT_CLI);
+        tracer_cli(LOG_HIGH_LEVEL, "logflash: %u lines\n", ulNum);
+        goto done;
+    }
+
+    if (!strcmp(baParam[1], "erase"))
+    {
+        tracer_cli(LOG_HIGH_LEVEL, "logflash: erase %s\n", (MW_LOG_FLASH_OK == MwLogFlash_Erase()) ? "ok" : "fail");
+        goto done;
+    }
+
+    if ((!strcmp(baParam[1], "level")) && (ulNum > 2))
+    {
+        MwLogFlash_LevelSet((uint8_t)strtoul(baParam[2], NULL, 16));
+        goto done;
+    }
+
+    if (!strcmp(baParam[1], "on"))
+    {
+        MwLogFlash_EnableSet(1);
+        goto done;
+    }
+
+    if (!strcmp(baParam[1], "off"))
+    {
+        MwLogFlash_EnableSet(0);
+        goto done;
+    }
+
+    if ((!strcmp(baParam[1], "cut")) && (ulNum > 2))
+    {
+        MwLogFlash_CutSet(strtoul(baParam[2], NULL, 0));
+        goto done;
+    }
+
+    tracer_cli(LOG_HIGH_LEVEL, "usage: logflash [dump [n]|erase|level <mask>|on|off|cut <bytes>]\n");
+
+done:
+    return;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwLogFlash_AtCmd
+*
+* DESCRIPTION:
+*   at+logflash?           : +LOGFLASH:<on>,<level>,<lines>,<written>,<dropped>,<torn>
+*   at+logflash=0          : erase the lines
+*   at+logflash=1[,<n>]    : +LOGFLASH:<seq>,<boot>,<ms>,<H/M/L>,<text> per line,
+*                            the last n only
+*
+* PARAMETERS
+*   buf  : [In] the command
+*   len  : [In] the length
+*   mode : [In] AT_CMD_MODE_xxx
+*
+* RETURNS
+*   1 : OK
+*   0 : ERROR
+*
+*************************************************************************/
+int MwLogFlash_AtCmd(char *buf, int len, int mode)
+{
+    int argc = 0;
+    char *argv[AT_MAX_CMD_ARGS] = {0};
+    int iRet = 0;
+
+    _at_cmd_buf_to_argc_argv(buf, &argc, argv, AT_MAX_CMD_ARGS);
+
+    msg_print_uart1("\r\n");
+
+    switch (mode)
+    {
+        case AT_CMD_MODE_READ:
+            MwLogFlash_Status(MW_LOG_FLASH_OUT_AT);
+            break;
+
+        case AT_CMD_MODE_SET:
+            if ((argc == 2) && (atoi(argv[1]) == 0))
+            {
+                if (MW_LOG_FLASH_OK != MwLogFlash_Erase())
+                {
+                    goto done;
+                }
+            }
+            else if (((argc == 2) || (argc == 3)) && (atoi(argv[1]) == 1))
+            {
+                MwLogFlash_Dump((argc == 3) ? strtoul(argv[2], NULL, 0) : 0, MW_LOG_FLASH_OUT_AT);
+            }
+            else
+            {
+                goto done;
+            }
+            break;
+
+        default:
+            goto done;
+    }
+
+    iRet = 1;
+
+done:
+    if (iRet)
+    {
+        msg_print_uart1("\r\nOK\r\n");
+    }
+    else
+    {
+        msg_print_uart1("\r\nERROR\r\n");
+    }
+
+    return iRet;
+}
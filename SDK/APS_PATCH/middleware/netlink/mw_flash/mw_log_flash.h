@@ -0,0 +1,149 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  mw_log_flash.h
+*
+*  Project:
+*  --------
+*  OPL1000 Project - the flash log definition file
+*
+*  Description:
+*  ------------
+*  This include file is the flash log definition file.
+*
+*  The tracer logs that pass the task levels are copied here too, in every
+*  tracer mode, filtered by MwLogFlash_LevelSet and rate limited per level.
+*  A RAM ring holds them until the task appends them to a ring of sectors
+*  in flash, each record with a sequence number, the boot number, the tick
+*  and a CRC-16.
+*
+*  Every sector starts with a header of its own sequence, the newest one is
+*  the head. A record cut by a power loss fails its CRC, the rest of that
+*  sector is skipped and the writing goes on in the next sector. The sector
+*  after the head is kept erased by the flash erase service.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+#ifndef _MW_LOG_FLASH_H_
+#define _MW_LOG_FLASH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <stdint.h>
+#include <stdarg.h>
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define MW_LOG_FLASH_OK                 1
+#define MW_LOG_FLASH_FAIL               0
+
+#define MW_LOG_FLASH_ADDR               0x00084000      // after the crash record sector
+#define MW_LOG_FLASH_SECTOR_NUM         8
+#define MW_LOG_FLASH_SECTOR_SIZE        0x1000
+
+#define MW_LOG_FLASH_TEXT_MAX           96              // bytes of a line, no '\0'
+#define MW_LOG_FLASH_RAM_SIZE           1024            // the lines not written yet
+#define MW_LOG_FLASH_FLUSH_MS           500             // the lines are written in batches
+
+#define MW_LOG_FLASH_SEC_MAGIC          0x474F4C53      // "SLOG"
+#define MW_LOG_FLASH_REC_MAGIC          0x4C
+
+#define MW_LOG_FLASH_OUT_CLI            0
+#define MW_LOG_FLASH_OUT_AT             1
+
+
+/******************************
+Declaration of data structure
+******************************/
+// Sec 3: structure, uniou, enum, linked list
+// the head of a sector
+typedef struct
+{
+    uint32_t ulMagic;
+    uint32_t ulSeq;             // the sector sequence
+    uint32_t ulSeqInv;          // ~ulSeq
+    uint32_t ulReserved;
+} T_MwLogFlashSec;
+
+// the head of a record, the text follows, the next record is 4-byte aligned
+typedef struct
+{
+    uint8_t ubMagic;
+    uint8_t ubLevel;            // LOG_xxx_LEVEL
+    uint8_t ubLen;              // the text
+    uint8_t ubReserved;
+    uint32_t ulSeq;
+    uint32_t ulTick;            // ms since the boot
+    uint16_t uwBoot;
+    uint16_t uwCrc;             // CRC-16/CCITT of the head (uwCrc = 0) and the text
+} T_MwLogFlashRec;
+
+typedef struct
+{
+    uint32_t ulWritten;         // records
+    uint32_t ulDropRate;        // over the rate of the level
+    uint32_t ulDropFull;        // the RAM ring was full
+    uint32_t ulSecOpen;         // sectors started
+    uint32_t ulSecTorn;         // sectors closed after a broken record
+    uint32_t ulProgFail;
+} T_MwLogFlashStat;
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+
+// Sec 5: declaration of global function prototype
+void MwLogFlash_Init(void);
+void MwLogFlash_VPut(uint8_t ubLevel, const char *sFmt, va_list tList);
+
+void MwLogFlash_EnableSet(uint8_t ubEnable);
+void MwLogFlash_LevelSet(uint8_t ubLevel);
+uint8_t MwLogFlash_LevelCheck(uint8_t ubLevel);
+
+uint32_t MwLogFlash_Dump(uint32_t ulLast, uint8_t ubOut);
+uint8_t MwLogFlash_Erase(void);
+void MwLogFlash_CutSet(uint32_t ulBytes);
+
+void MwLogFlash_StatGet(T_MwLogFlashStat *ptStat);
+void MwLogFlash_Status(uint8_t ubOut);
+
+void MwLogFlash_Cmd(char *sCmd);
+int MwLogFlash_AtCmd(char *buf, int len, int mode);
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+
+
+// Sec 7: declaration of static function prototype
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _MW_LOG_FLASH_H_
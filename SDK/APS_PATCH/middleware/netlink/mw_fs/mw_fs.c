@@ -0,0 +1,1987 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  mw_fs.c
+*
+*  Project:
+*  --------
+*  OPL1000 Project - the file system implement file
+*
+*  Description:
+*  ------------
+*  This implement file is include the file system function and api.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmsis_os.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "hal_system.h"
+#include "hal_flash.h"
+#include "mw_flash_svc.h"
+#include "mw_fs.h"
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define MW_FS_META_MAGIC            0x4D534654      // "TFSM"
+#define MW_FS_DATA_MAGIC            0x44534654      // "TFSD"
+#define MW_FS_BLOCK_NONE            0xFFFFFFFF
+#define MW_FS_ROOT                  0xFF            // the parent of the top entries
+#define MW_FS_DATA_SIZE             (MW_FS_BLOCK_SIZE - sizeof(T_MwFsDataHdr))
+#define MW_FS_CHUNK                 64              // the copy of the data on the stack
+
+#define MW_FS_PARAM_MAX             4
+#define MW_FS_BENCH_BUF             256
+#define MW_FS_STRESS_DIR            "/stress"
+#define MW_FS_STRESS_FILE_NUM       4
+#define MW_FS_STRESS_LEN_MAX        6000            // more than one block
+#define MW_FS_STRESS_APPEND_MAX     1500
+
+
+/******************************
+Declaration of data structure
+******************************/
+// Sec 3: structure, uniou, enum, linked list
+// the head of the block of the table, the entries follow
+typedef struct
+{
+    uint32_t ulMagic;
+    uint32_t ulRev;
+    uint32_t ulEntryNum;            // MW_FS_ENTRY_MAX
+    uint32_t ulCrc;                 // CRC-32 of ulRev, ulEntryNum and the entries
+} T_MwFsMetaHdr;
+
+// the head of a data block
+typedef struct
+{
+    uint32_t ulMagic;
+    uint32_t ulPrev;                // the block before, MW_FS_BLOCK_NONE: the first one
+} T_MwFsDataHdr;
+
+typedef struct
+{
+    uint8_t ubType;                 // 0: free, MW_FS_TYPE_xxx
+    uint8_t ubParent;               // the index of the dir, MW_FS_ROOT
+    uint16_t uwReserved;
+    uint32_t ulHead;                // the newest data block
+    uint32_t ulSize;
+    char sName[MW_FS_NAME_MAX + 1];
+} T_MwFsEntry;
+
+typedef struct
+{
+    uint8_t ubUsed;
+    uint8_t ubEntry;
+    uint8_t ubDirty;                // changed, not committed
+    uint8_t ubOwn;                  // the head block is started by this handle, the rest of it is erased
+    uint32_t ulFlags;
+    uint32_t ulPos;
+    uint32_t ulHead;                // the view of this handle
+    uint32_t ulSize;
+    uint32_t ulBlkOff;              // the bytes in the head block
+} T_MwFsFile;
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+
+// Sec 5: declaration of global function prototype
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static osSemaphoreId g_tMwFsLock;
+static T_MwFsLayout g_tMwFsLayout;
+static uint8_t g_ubMwFsMounted;
+
+static T_MwFsEntry g_taMwFsEntry[MW_FS_ENTRY_MAX];
+static uint32_t g_ulMwFsRev;
+static uint32_t g_ulMwFsMeta = MW_FS_BLOCK_NONE;    // the block of the table
+
+static uint32_t g_ulaMwFsUsed[(MW_FS_BLOCK_MAX + 31) / 32];
+static uint32_t g_ulMwFsCursor;                     // the next block to take
+static uint32_t g_ulMwFsAhead = MW_FS_BLOCK_NONE;   // queued to the erase service
+
+static T_MwFsFile g_taMwFsFile[MW_FS_FILE_MAX];
+
+static uint32_t g_ulMwFsCut;
+static uint32_t g_ulMwFsErase;
+static uint32_t g_ulMwFsProgram;
+
+
+// Sec 7: declaration of static function prototype
+
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static uint32_t MwFs_Crc32(uint32_t ulCrc, const uint8_t *pubData, uint32_t ulSize)
+{
+    uint32_t i;
+
+    ulCrc = ~ulCrc;
+
+    while (ulSize--)
+    {
+        ulCrc ^= *pubData++;
+
+        for (i=0; i<8; i++)
+            ulCrc = (ulCrc & 1) ? ((ulCrc >> 1) ^ 0xEDB88320) : (ulCrc >> 1);
+    }
+
+    return ~ulCrc;
+}
+
+static uint32_t MwFs_Addr(uint32_t ulBlk, uint32_t ulOff)
+{
+    return g_tMwFsLayout.ulAddr + (ulBlk * MW_FS_BLOCK_SIZE) + ulOff;
+}
+
+static void MwFs_UsedSet(uint32_t ulBlk)
+{
+    g_ulaMwFsUsed[ulBlk / 32] |= (1UL << (ulBlk % 32));
+}
+
+static uint8_t MwFs_UsedGet(uint32_t ulBlk)
+{
+    return (g_ulaMwFsUsed[ulBlk / 32] >> (ulBlk % 32)) & 1;
+}
+
+static int MwFs_FlashRead(uint32_t ulBlk, uint32_t ulOff, void *pBuf, uint32_t ulSize)
+{
+    if (0 != Hal_Flash_AddrRead(SPI_IDX_0, MwFs_Addr(ulBlk, ulOff), 0, ulSize, (uint8_t *)pBuf))
+        return MW_FS_ERR_IO;
+
+    return MW_FS_OK;
+}
+
+// every program, g_ulMwFsCut stops the system in the middle of one
+static int MwFs_FlashProg(uint32_t ulBlk, uint32_t ulOff, const void *pBuf, uint32_t ulSize)
+{
+    if ((g_ulMwFsCut) && (--g_ulMwFsCut == 0))
+    {
+        Hal_Flash_AddrProgram(SPI_IDX_0, MwFs_Addr(ulBlk, ulOff), 0, ulSize / 2, (uint8_t *)pBuf);
+        printf("fs: cut at block %u +%u after %u of %u bytes, reset\n", ulBlk, ulOff, ulSize / 2, ulSize);
+
+        Hal_Sys_SwResetAll();
+        while (1)
+            ;
+    }
+
+    if (0 != Hal_Flash_AddrProgram(SPI_IDX_0, MwFs_Addr(ulBlk, ulOff), 0, ulSize, (uint8_t *)pBuf))
+        return MW_FS_ERR_IO;
+
+    g_ulMwFsProgram += ulSize;
+    return MW_FS_OK;
+}
+
+static int MwFs_BlockErase(uint32_t ulBlk)
+{
+    uint8_t ubErased = 0;
+
+    // done by the service, or finished now
+    if (g_ulMwFsAhead == ulBlk)
+    {
+        ubErased = (MW_FLASH_SVC_OK == MwFlashSvc_EraseSync(MwFs_Addr(ulBlk, 0)));
+        g_ulMwFsAhead = MW_FS_BLOCK_NONE;
+    }
+
+    if (!ubErased)
+    {
+        if (0 != Hal_Flash_4KSectorAddrErase(SPI_IDX_0, MwFs_Addr(ulBlk, 0)))
+            return MW_FS_ERR_IO;
+    }
+
+    g_ulMwFsErase++;
+    return MW_FS_OK;
+}
+
+// take a free block round-robin and erase it, the last one is for the table only
+static int MwFs_BlockAlloc(uint32_t *pulBlk, uint8_t ubMeta)
+{
+    uint32_t ulBlk = MW_FS_BLOCK_NONE;
+    uint32_t ulFree = 0;
+    uint32_t i;
+    int iRet;
+
+    for (i=0; i<g_tMwFsLayout.ulBlockNum; i++)
+    {
+        if (!MwFs_UsedGet((g_ulMwFsCursor + i) % g_tMwFsLayout.ulBlockNum))
+        {
+            if (ulBlk == MW_FS_BLOCK_NONE)
+                ulBlk = (g_ulMwFsCursor + i) % g_tMwFsLayout.ulBlockNum;
+
+            ulFree++;
+        }
+    }
+
+    if ((ulFree == 0) || ((!ubMeta) && (ulFree == 1)))
+        return MW_FS_ERR_NOSPC;
+
+    // kept until the next commit even if it is not written
+    MwFs_UsedSet(ulBlk);
+    g_ulMwFsCursor = (ulBlk + 1) % g_tMwFsLayout.ulBlockNum;
+
+    iRet = MwFs_BlockErase(ulBlk);
+    if (iRet != MW_FS_OK)
+        return iRet;
+
+    // the next one is erased in the background
+    if (g_ulMwFsAhead == MW_FS_BLOCK_NONE)
+    {
+        for (i=0; i<g_tMwFsLayout.ulBlockNum; i++)
+        {
+            if (!MwFs_UsedGet((g_ulMwFsCursor + i) % g_tMwFsLayout.ulBlockNum))
+            {
+                if (MW_FLASH_SVC_OK == MwFlashSvc_EraseLater(MwFs_Addr((g_ulMwFsCursor + i) % g_tMwFsLayout.ulBlockNum, 0)))
+                    g_ulMwFsAhead = (g_ulMwFsCursor + i) % g_tMwFsLayout.ulBlockNum;
+
+                break;
+            }
+        }
+    }
+
+    *pulBlk = ulBlk;
+    return MW_FS_OK;
+}
+
+// mark a chain, the blocks before a marked one are marked already
+static void MwFs_ChainMark(uint32_t ulBlk)
+{
+    T_MwFsDataHdr tHdr;
+    uint32_t i;
+
+    for (i=0; i<g_tMwFsLayout.ulBlockNum; i++)
+    {
+        if ((ulBlk >= g_tMwFsLayout.ulBlockNum) || (MwFs_UsedGet(ulBlk)))
+            break;
+
+        MwFs_UsedSet(ulBlk);
+
+        if ((MW_FS_OK != MwFs_FlashRead(ulBlk, 0, &tHdr, sizeof(tHdr))) || (tHdr.ulMagic != MW_FS_DATA_MAGIC))
+            break;
+
+        ulBlk = tHdr.ulPrev;
+    }
+}
+
+// the blocks of the table, of the committed files and of the open ones
+static void MwFs_UsedBuild(void)
+{
+    uint32_t i;
+
+    memset(g_ulaMwFsUsed, 0, sizeof(g_ulaMwFsUsed));
+
+    if (g_ulMwFsMeta != MW_FS_BLOCK_NONE)
+        MwFs_UsedSet(g_ulMwFsMeta);
+
+    for (i=0; i<MW_FS_ENTRY_MAX; i++)
+    {
+        if (g_taMwFsEntry[i].ubType == MW_FS_TYPE_FILE)
+            MwFs_ChainMark(g_taMwFsEntry[i].ulHead);
+    }
+
+    for (i=0; i<MW_FS_FILE_MAX; i++)
+    {
+        if (g_taMwFsFile[i].ubUsed)
+            MwFs_ChainMark(g_taMwFsFile[i].ulHead);
+    }
+}
+
+static uint32_t MwFs_MetaCrc(uint32_t ulRev)
+{
+    uint32_t ulaHead[2];
+
+    ulaHead[0] = ulRev;
+    ulaHead[1] = MW_FS_ENTRY_MAX;
+
+    return MwFs_Crc32(MwFs_Crc32(0, (uint8_t *)ulaHead, sizeof(ulaHead)), (uint8_t *)g_taMwFsEntry, sizeof(g_taMwFsEntry));
+}
+
+// write the table to a new block, the head last
+static int MwFs_Commit(void)
+{
+    T_MwFsMetaHdr tHdr;
+    uint32_t ulBlk;
+    int iRet;
+
+    iRet = MwFs_BlockAlloc(&ulBlk, 1);
+    if (iRet != MW_FS_OK)
+        goto done;
+
+    iRet = MwFs_FlashProg(ulBlk, sizeof(tHdr), g_taMwFsEntry, sizeof(g_taMwFsEntry));
+    if (iRet != MW_FS_OK)
+        goto done;
+
+    tHdr.ulMagic = MW_FS_META_MAGIC;
+    tHdr.ulRev = g_ulMwFsRev + 1;
+    tHdr.ulEntryNum = MW_FS_ENTRY_MAX;
+    tHdr.ulCrc = MwFs_MetaCrc(tHdr.ulRev);
+
+    iRet = MwFs_FlashProg(ulBlk, 0, &tHdr, sizeof(tHdr));
+    if (iRet != MW_FS_OK)
+        goto done;
+
+    g_ulMwFsMeta = ulBlk;
+    g_ulMwFsRev = tHdr.ulRev;
+
+    // the old table and the old blocks of the files are free now
+    MwFs_UsedBuild();
+
+done:
+    return iRet;
+}
+
+// the newest table with a valid CRC
+static int MwFs_MetaLoad(void)
+{
+    T_MwFsMetaHdr tHdr;
+    uint32_t ulLimit = MW_FS_BLOCK_NONE;
+    uint32_t ulBest;
+    uint32_t ulBestRev = 0;
+    uint32_t ulRevMax = 0;
+    uint32_t i;
+
+    for (;;)
+    {
+        ulBest = MW_FS_BLOCK_NONE;
+
+        for (i=0; i<g_tMwFsLayout.ulBlockNum; i++)
+        {
+            if (MW_FS_OK != MwFs_FlashRead(i, 0, &tHdr, sizeof(tHdr)))
+                return MW_FS_ERR_IO;
+
+            if ((tHdr.ulMagic != MW_FS_META_MAGIC) || (tHdr.ulEntryNum != MW_FS_ENTRY_MAX) || (tHdr.ulRev >= ulLimit))
+                continue;
+
+            if (tHdr.ulRev > ulRevMax)
+                ulRevMax = tHdr.ulRev;
+
+            if ((ulBest == MW_FS_BLOCK_NONE) || (tHdr.ulRev > ulBestRev))
+            {
+                ulBest = i;
+                ulBestRev = tHdr.ulRev;
+            }
+        }
+
+        if (ulBest == MW_FS_BLOCK_NONE)
+            return MW_FS_ERR_CORRUPT;
+
+        if (MW_FS_OK != MwFs_FlashRead(ulBest, 0, &tHdr, sizeof(tHdr)))
+            return MW_FS_ERR_IO;
+
+        if (MW_FS_OK != MwFs_FlashRead(ulBest, sizeof(tHdr), g_taMwFsEntry, sizeof(g_taMwFsEntry)))
+            return MW_FS_ERR_IO;
+
+        if (tHdr.ulCrc == MwFs_MetaCrc(tHdr.ulRev))
+            break;
+
+        // cut in the middle of the commit, try the one before
+        ulLimit = ulBestRev;
+    }
+
+    for (i=0; i<MW_FS_ENTRY_MAX; i++)
+        g_taMwFsEntry[i].sName[MW_FS_NAME_MAX] = 0;
+
+    // the next commit is above a broken one, not equal to it
+    g_ulMwFsMeta = ulBest;
+    g_ulMwFsRev = ulRevMax;
+
+    return MW_FS_OK;
+}
+
+static int MwFs_FormatLocked(void)
+{
+    uint32_t i;
+    int iRet;
+
+    memset(g_taMwFsFile, 0, sizeof(g_taMwFsFile));
+    memset(g_taMwFsEntry, 0, sizeof(g_taMwFsEntry));
+    memset(g_ulaMwFsUsed, 0, sizeof(g_ulaMwFsUsed));
+    g_ulMwFsMeta = MW_FS_BLOCK_NONE;
+    g_ulMwFsRev = 0;
+    g_ulMwFsCursor = 0;
+    g_ubMwFsMounted = 0;
+
+    // no old table may win
+    for (i=0; i<g_tMwFsLayout.ulBlockNum; i++)
+    {
+        iRet = MwFs_BlockErase(i);
+        if (iRet != MW_FS_OK)
+            return iRet;
+    }
+
+    iRet = MwFs_Commit();
+    if (iRet != MW_FS_OK)
+        return iRet;
+
+    g_ubMwFsMounted = 1;
+    return MW_FS_OK;
+}
+
+// the entry of a name in a dir, -1: none
+static int MwFs_EntryFind(uint8_t ubParent, const char *sName, uint32_t ulLen)
+{
+    uint32_t i;
+
+    for (i=0; i<MW_FS_ENTRY_MAX; i++)
+    {
+        if ((g_taMwFsEntry[i].ubType) && (g_taMwFsEntry[i].ubParent == ubParent) &&
+            (!strncmp(g_taMwFsEntry[i].sName, sName, ulLen)) && (g_taMwFsEntry[i].sName[ulLen] == 0))
+            return i;
+    }
+
+    return -1;
+}
+
+/*
+    resolve a path, "/" may be omitted at the start
+    *piEntry  : the entry, MW_FS_ROOT for "/", -1 if the last name is not found
+    *pubParent: the dir of the last name
+    *psName   : the last name, "" for "/"
+*/
+static int MwFs_Lookup(const char *sPath, int *piEntry, uint8_t *pubParent, const char **psName)
+{
+    uint8_t ubParent = MW_FS_ROOT;
+    const char *sEnd;
+    uint32_t ulLen;
+    int iEntry;
+
+    if (sPath == NULL)
+        return MW_FS_ERR_INVAL;
+
+    if (*sPath == '/')
+        sPath++;
+
+    if (*sPath == 0)
+    {
+        *piEntry = MW_FS_ROOT;
+        *pubParent = MW_FS_ROOT;
+        *psName = sPath;
+        return MW_FS_OK;
+    }
+
+    for (;;)
+    {
+        sEnd = strchr(sPath, '/');
+        ulLen = (sEnd != NULL) ? (sEnd - sPath) : strlen(sPath);
+
+        if (ulLen == 0)
+            return MW_FS_ERR_INVAL;
+
+        if (ulLen > MW_FS_NAME_MAX)
+            return MW_FS_ERR_NAMETOOLONG;
+
+        iEntry = MwFs_EntryFind(ubParent, sPath, ulLen);
+
+        // the last name
+        if (sEnd == NULL)
+            break;
+
+        if (iEntry < 0)
+            return MW_FS_ERR_NOENT;
+
+        if (g_taMwFsEntry[iEntry].ubType != MW_FS_TYPE_DIR)
+            return MW_FS_ERR_NOTDIR;
+
+        ubParent = iEntry;
+        sPath = sEnd + 1;
+    }
+
+    *piEntry = iEntry;
+    *pubParent = ubParent;
+    *psName = sPath;
+    return MW_FS_OK;
+}
+
+static int MwFs_EntryNew(uint8_t ubType, uint8_t ubParent, const char *sName)
+{
+    uint32_t i;
+
+    for (i=0; i<MW_FS_ENTRY_MAX; i++)
+    {
+        if (g_taMwFsEntry[i].ubType == 0)
+        {
+            memset(&g_taMwFsEntry[i], 0, sizeof(T_MwFsEntry));
+            g_taMwFsEntry[i].ubType = ubType;
+            g_taMwFsEntry[i].ubParent = ubParent;
+            g_taMwFsEntry[i].ulHead = MW_FS_BLOCK_NONE;
+            strncpy(g_taMwFsEntry[i].sName, sName, MW_FS_NAME_MAX);
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static uint8_t MwFs_EntryBusy(int iEntry)
+{
+    uint32_t i;
+
+    for (i=0; i<MW_FS_FILE_MAX; i++)
+    {
+        if ((g_taMwFsFile[i].ubUsed) && (g_taMwFsFile[i].ubEntry == iEntry))
+            return 1;
+    }
+
+    return 0;
+}
+
+static T_MwFsFile *MwFs_FileGet(int iFd)
+{
+    if ((iFd < 0) || (iFd >= MW_FS_FILE_MAX) || (!g_taMwFsFile[iFd].ubUsed))
+        return NULL;
+
+    return &g_taMwFsFile[iFd];
+}
+
+// the block of the data at ulPos, walking back from the head
+static int MwFs_BlockOf(T_MwFsFile *ptFile, uint32_t ulPos, uint32_t *pulBlk)
+{
+    T_MwFsDataHdr tHdr;
+    uint32_t ulBlk = ptFile->ulHead;
+    uint32_t ulStep;
+
+    ulStep = ((ptFile->ulSize + MW_FS_DATA_SIZE - 1) / MW_FS_DATA_SIZE) - 1 - (ulPos / MW_FS_DATA_SIZE);
+
+    while (ulStep--)
+    {
+        if ((ulBlk >= g_tMwFsLayout.ulBlockNum) || (MW_FS_OK != MwFs_FlashRead(ulBlk, 0, &tHdr, sizeof(tHdr))))
+            return MW_FS_ERR_IO;
+
+        if (tHdr.ulMagic != MW_FS_DATA_MAGIC)
+            return MW_FS_ERR_CORRUPT;
+
+        ulBlk = tHdr.ulPrev;
+    }
+
+    if (ulBlk >= g_tMwFsLayout.ulBlockNum)
+        return MW_FS_ERR_CORRUPT;
+
+    *pulBlk = ulBlk;
+    return MW_FS_OK;
+}
+
+// start a new head block, the data of the old head is copied if it is not full
+static int MwFs_HeadNew(T_MwFsFile *ptFile)
+{
+    T_MwFsDataHdr tHdr;
+    uint8_t ubaBuf[MW_FS_CHUNK];
+    uint32_t ulBlk;
+    uint32_t ulCopy = 0;
+    uint32_t ulOff;
+    uint32_t ulSize;
+    int iRet;
+
+    tHdr.ulMagic = MW_FS_DATA_MAGIC;
+    tHdr.ulPrev = ptFile->ulHead;
+
+    // a committed block is not written again
+    if ((ptFile->ulHead != MW_FS_BLOCK_NONE) && (ptFile->ulBlkOff < MW_FS_DATA_SIZE))
+    {
+        iRet = MwFs_FlashRead(ptFile->ulHead, 0, &tHdr, sizeof(tHdr));
+        if (iRet != MW_FS_OK)
+            return iRet;
+
+        ulCopy = ptFile->ulBlkOff;
+    }
+
+    iRet = MwFs_BlockAlloc(&ulBlk, 0);
+    if (iRet != MW_FS_OK)
+        return iRet;
+
+    iRet = MwFs_FlashProg(ulBlk, 0, &tHdr, sizeof(tHdr));
+    if (iRet != MW_FS_OK)
+        return iRet;
+
+    for (ulOff=0; ulOff<ulCopy; ulOff+=ulSize)
+    {
+        ulSize = ulCopy - ulOff;
+        if (ulSize > sizeof(ubaBuf))
+            ulSize = sizeof(ubaBuf);
+
+        iRet = MwFs_FlashRead(ptFile->ulHead, sizeof(tHdr) + ulOff, ubaBuf, ulSize);
+        if (iRet != MW_FS_OK)
+            return iRet;
+
+        iRet = MwFs_FlashProg(ulBlk, sizeof(tHdr) + ulOff, ubaBuf, ulSize);
+        if (iRet != MW_FS_OK)
+            return iRet;
+    }
+
+    ptFile->ulHead = ulBlk;
+    ptFile->ulBlkOff = ulCopy;
+    ptFile->ubOwn = 1;
+
+    return MW_FS_OK;
+}
+
+static int MwFs_SyncLocked(T_MwFsFile *ptFile)
+{
+    T_MwFsEntry *ptEntry = &g_taMwFsEntry[ptFile->ubEntry];
+    uint32_t ulHead;
+    uint32_t ulSize;
+    int iRet;
+
+    if (!ptFile->ubDirty)
+        return MW_FS_OK;
+
+    ulHead = ptEntry->ulHead;
+    ulSize = ptEntry->ulSize;
+
+    ptEntry->ulHead = ptFile->ulHead;
+    ptEntry->ulSize = ptFile->ulSize;
+
+    iRet = MwFs_Commit();
+    if (iRet != MW_FS_OK)
+    {
+        ptEntry->ulHead = ulHead;
+        ptEntry->ulSize = ulSize;
+        return iRet;
+    }
+
+    ptFile->ubDirty = 0;
+    return MW_FS_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Init
+*
+* DESCRIPTION:
+*   mount the file system in the partition, an empty one is formatted
+*
+* PARAMETERS
+*   1. ptLayout : [In] the partition, NULL: MW_FS_ADDR / MW_FS_BLOCK_NUM
+*
+* RETURNS
+*   MW_FS_OK    : successful
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_Init(T_MwFsLayout *ptLayout)
+{
+    osSemaphoreDef_t tSemaphoreDef;
+    int iRet = MW_FS_ERR_INVAL;
+
+    if (g_tMwFsLock == NULL)
+    {
+        // create the semaphore
+        tSemaphoreDef.dummy = 0;                            // reserved, it is no used
+        g_tMwFsLock = osSemaphoreCreate(&tSemaphoreDef, 1);
+        if (g_tMwFsLock == NULL)
+        {
+            printf("To create the semaphore for MwFs is fail.\n");
+            return MW_FS_ERR_IO;
+        }
+    }
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+
+    if (ptLayout != NULL)
+    {
+        g_tMwFsLayout = *ptLayout;
+    }
+    else
+    {
+        g_tMwFsLayout.ulAddr = MW_FS_ADDR;
+        g_tMwFsLayout.ulBlockNum = MW_FS_BLOCK_NUM;
+    }
+
+    g_ubMwFsMounted = 0;
+
+    if ((g_tMwFsLayout.ulAddr % MW_FS_BLOCK_SIZE) || (g_tMwFsLayout.ulBlockNum < 4) ||
+        (g_tMwFsLayout.ulBlockNum > MW_FS_BLOCK_MAX))
+        goto done;
+
+    memset(g_taMwFsFile, 0, sizeof(g_taMwFsFile));
+
+    iRet = MwFs_MetaLoad();
+    if (iRet == MW_FS_ERR_CORRUPT)
+    {
+        printf("fs: no file system at 0x%X, format\n", g_tMwFsLayout.ulAddr);
+        iRet = MwFs_FormatLocked();
+        goto done;
+    }
+
+    if (iRet != MW_FS_OK)
+        goto done;
+
+    MwFs_UsedBuild();
+    g_ulMwFsCursor = (g_ulMwFsMeta + 1) % g_tMwFsLayout.ulBlockNum;
+    g_ubMwFsMounted = 1;
+
+done:
+    osSemaphoreRelease(g_tMwFsLock);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Format
+*
+* DESCRIPTION:
+*   erase the partition and write an empty table, the open files are lost
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   MW_FS_OK    : successful
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_Format(void)
+{
+    int iRet;
+
+    if ((g_tMwFsLock == NULL) || (g_tMwFsLayout.ulBlockNum == 0))
+        return MW_FS_ERR_NOFS;
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+    iRet = MwFs_FormatLocked();
+    osSemaphoreRelease(g_tMwFsLock);
+
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Info
+*
+* DESCRIPTION:
+*   get the usage of the partition and the counters of the flash
+*
+* PARAMETERS
+*   1. ptInfo : [Out] the information
+*
+* RETURNS
+*   MW_FS_OK    : successful
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_Info(T_MwFsInfo *ptInfo)
+{
+    uint32_t i;
+
+    if (!g_ubMwFsMounted)
+        return MW_FS_ERR_NOFS;
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+
+    memset(ptInfo, 0, sizeof(T_MwFsInfo));
+    ptInfo->ulAddr = g_tMwFsLayout.ulAddr;
+    ptInfo->ulBlockNum = g_tMwFsLayout.ulBlockNum;
+    ptInfo->ulRev = g_ulMwFsRev;
+    ptInfo->ulErase = g_ulMwFsErase;
+    ptInfo->ulProgram = g_ulMwFsProgram;
+
+    for (i=0; i<g_tMwFsLayout.ulBlockNum; i++)
+    {
+        if (!MwFs_UsedGet(i))
+            ptInfo->ulBlockFree++;
+    }
+
+    for (i=0; i<MW_FS_ENTRY_MAX; i++)
+    {
+        if (g_taMwFsEntry[i].ubType)
+            ptInfo->ulEntryUsed++;
+    }
+
+    osSemaphoreRelease(g_tMwFsLock);
+    return MW_FS_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Open
+*
+* DESCRIPTION:
+*   open a file, a file is open once at a time
+*
+* PARAMETERS
+*   1. sPath   : [In] the path
+*   2. ulFlags : [In] MW_FS_O_xxx
+*
+* RETURNS
+*   >= 0 : the handle
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_Open(const char *sPath, uint32_t ulFlags)
+{
+    T_MwFsFile *ptFile = NULL;
+    const char *sName;
+    uint8_t ubParent;
+    int iEntry;
+    int iFd;
+    int iRet;
+    uint32_t i;
+
+    if (!g_ubMwFsMounted)
+        return MW_FS_ERR_NOFS;
+
+    if (!(ulFlags & MW_FS_O_RDWR))
+        return MW_FS_ERR_INVAL;
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+
+    iRet = MwFs_Lookup(sPath, &iEntry, &ubParent, &sName);
+    if (iRet != MW_FS_OK)
+        goto done;
+
+    if (iEntry == MW_FS_ROOT)
+    {
+        iRet = MW_FS_ERR_ISDIR;
+        goto done;
+    }
+
+    for (i=0; i<MW_FS_FILE_MAX; i++)
+    {
+        if (!g_taMwFsFile[i].ubUsed)
+        {
+            ptFile = &g_taMwFsFile[i];
+            break;
+        }
+    }
+
+    if (ptFile == NULL)
+    {
+        iRet = MW_FS_ERR_MFILE;
+        goto done;
+    }
+
+    iFd = i;
+
+    if (iEntry < 0)
+    {
+        if (!(ulFlags & MW_FS_O_CREAT))
+        {
+            iRet = MW_FS_ERR_NOENT;
+            goto done;
+        }
+
+        iEntry = MwFs_EntryNew(MW_FS_TYPE_FILE, ubParent, sName);
+        if (iEntry < 0)
+        {
+            iRet = MW_FS_ERR_NOSPC;
+            goto done;
+        }
+
+        iRet = MwFs_Commit();
+        if (iRet != MW_FS_OK)
+        {
+            g_taMwFsEntry[iEntry].ubType = 0;
+            goto done;
+        }
+    }
+    else
+    {
+        if ((ulFlags & MW_FS_O_CREAT) && (ulFlags & MW_FS_O_EXCL))
+        {
+            iRet = MW_FS_ERR_EXIST;
+            goto done;
+        }
+
+        if (g_taMwFsEntry[iEntry].ubType == MW_FS_TYPE_DIR)
+        {
+            iRet = MW_FS_ERR_ISDIR;
+            goto done;
+        }
+
+        if (MwFs_EntryBusy(iEntry))
+        {
+            iRet = MW_FS_ERR_BUSY;
+            goto done;
+        }
+    }
+
+    memset(ptFile, 0, sizeof(T_MwFsFile));
+    ptFile->ubUsed = 1;
+    ptFile->ubEntry = iEntry;
+    ptFile->ulFlags = ulFlags;
+    ptFile->ulHead = g_taMwFsEntry[iEntry].ulHead;
+    ptFile->ulSize = g_taMwFsEntry[iEntry].ulSize;
+
+    if (ptFile->ulSize)
+        ptFile->ulBlkOff = ptFile->ulSize - (((ptFile->ulSize - 1) / MW_FS_DATA_SIZE) * MW_FS_DATA_SIZE);
+
+    if ((ulFlags & MW_FS_O_TRUNC) && (ulFlags & MW_FS_O_WRONLY) && (ptFile->ulSize))
+    {
+        ptFile->ulHead = MW_FS_BLOCK_NONE;
+        ptFile->ulSize = 0;
+        ptFile->ulBlkOff = 0;
+        ptFile->ubDirty = 1;
+    }
+
+    iRet = iFd;
+
+done:
+    osSemaphoreRelease(g_tMwFsLock);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Read
+*
+* DESCRIPTION:
+*   read from the position of the handle
+*
+* PARAMETERS
+*   1. iFd    : [In] the handle
+*   2. pBuf   : [Out] the data
+*   3. ulSize : [In] the max size
+*
+* RETURNS
+*   >= 0 : the bytes read, 0 at the end
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_Read(int iFd, void *pBuf, uint32_t ulSize)
+{
+    T_MwFsFile *ptFile;
+    uint8_t *pubBuf = (uint8_t *)pBuf;
+    uint32_t ulBlk;
+    uint32_t ulOff;
+    uint32_t ulChunk;
+    int iTotal = 0;
+    int iRet = MW_FS_OK;
+
+    if (!g_ubMwFsMounted)
+        return MW_FS_ERR_NOFS;
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+
+    ptFile = MwFs_FileGet(iFd);
+    if ((ptFile == NULL) || (!(ptFile->ulFlags & MW_FS_O_RDONLY)))
+    {
+        iRet = MW_FS_ERR_BADF;
+        goto done;
+    }
+
+    while ((ulSize) && (ptFile->ulPos < ptFile->ulSize))
+    {
+        iRet = MwFs_BlockOf(ptFile, ptFile->ulPos, &ulBlk);
+        if (iRet != MW_FS_OK)
+            goto done;
+
+        ulOff = ptFile->ulPos % MW_FS_DATA_SIZE;
+        ulChunk = MW_FS_DATA_SIZE - ulOff;
+        if (ulChunk > (ptFile->ulSize - ptFile->ulPos))
+            ulChunk = ptFile->ulSize - ptFile->ulPos;
+        if (ulChunk > ulSize)
+            ulChunk = ulSize;
+
+        iRet = MwFs_FlashRead(ulBlk, sizeof(T_MwFsDataHdr) + ulOff, pubBuf, ulChunk);
+        if (iRet != MW_FS_OK)
+            goto done;
+
+        pubBuf += ulChunk;
+        ulSize -= ulChunk;
+        ptFile->ulPos += ulChunk;
+        iTotal += ulChunk;
+    }
+
+done:
+    osSemaphoreRelease(g_tMwFsLock);
+    return (iTotal) ? iTotal : iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Write
+*
+* DESCRIPTION:
+*   write at the end of the file, kept after MwFs_Sync / MwFs_Close
+*
+* PARAMETERS
+*   1. iFd    : [In] the handle
+*   2. pBuf   : [In] the data
+*   3. ulSize : [In] the size
+*
+* RETURNS
+*   >= 0 : the bytes written
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_Write(int iFd, const void *pBuf, uint32_t ulSize)
+{
+    T_MwFsFile *ptFile;
+    const uint8_t *pubBuf = (const uint8_t *)pBuf;
+    uint32_t ulChunk;
+    int iTotal = 0;
+    int iRet = MW_FS_OK;
+
+    if (!g_ubMwFsMounted)
+        return MW_FS_ERR_NOFS;
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+
+    ptFile = MwFs_FileGet(iFd);
+    if ((ptFile == NULL) || (!(ptFile->ulFlags & MW_FS_O_WRONLY)))
+    {
+        iRet = MW_FS_ERR_BADF;
+        goto done;
+    }
+
+    if (ptFile->ulFlags & MW_FS_O_APPEND)
+        ptFile->ulPos = ptFile->ulSize;
+
+    if (ptFile->ulPos != ptFile->ulSize)
+    {
+        iRet = MW_FS_ERR_INVAL;
+        goto done;
+    }
+
+    while (ulSize)
+    {
+        if ((ptFile->ulHead == MW_FS_BLOCK_NONE) || (ptFile->ulBlkOff == MW_FS_DATA_SIZE) || (!ptFile->ubOwn))
+        {
+            iRet = MwFs_HeadNew(ptFile);
+            if (iRet != MW_FS_OK)
+                goto done;
+        }
+
+        ulChunk = MW_FS_DATA_SIZE - ptFile->ulBlkOff;
+        if (ulChunk > ulSize)
+            ulChunk = ulSize;
+
+        iRet = MwFs_FlashProg(ptFile->ulHead, sizeof(T_MwFsDataHdr) + ptFile->ulBlkOff, pubBuf, ulChunk);
+        if (iRet != MW_FS_OK)
+            goto done;
+
+        pubBuf += ulChunk;
+        ulSize -= ulChunk;
+        ptFile->ulBlkOff += ulChunk;
+        ptFile->ulSize += ulChunk;
+        ptFile->ulPos = ptFile->ulSize;
+        ptFile->ubDirty = 1;
+        iTotal += ulChunk;
+    }
+
+done:
+    osSemaphoreRelease(g_tMwFsLock);
+    return (iTotal) ? iTotal : iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Seek
+*
+* DESCRIPTION:
+*   set the position of the handle, not after the end
+*
+* PARAMETERS
+*   1. iFd     : [In] the handle
+*   2. lOffset : [In] the offset
+*   3. iWhence : [In] MW_FS_SEEK_xxx
+*
+* RETURNS
+*   >= 0 : the position
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_Seek(int iFd, int32_t lOffset, int iWhence)
+{
+    T_MwFsFile *ptFile;
+    int32_t lPos;
+    int iRet;
+
+    if (!g_ubMwFsMounted)
+        return MW_FS_ERR_NOFS;
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+
+    ptFile = MwFs_FileGet(iFd);
+    if (ptFile == NULL)
+    {
+        iRet = MW_FS_ERR_BADF;
+        goto done;
+    }
+
+    if (iWhence == MW_FS_SEEK_SET)
+        lPos = lOffset;
+    else if (iWhence == MW_FS_SEEK_CUR)
+        lPos = (int32_t)ptFile->ulPos + lOffset;
+    else if (iWhence == MW_FS_SEEK_END)
+        lPos = (int32_t)ptFile->ulSize + lOffset;
+    else
+        lPos = -1;
+
+    if ((lPos < 0) || ((uint32_t)lPos > ptFile->ulSize))
+    {
+        iRet = MW_FS_ERR_INVAL;
+        goto done;
+    }
+
+    ptFile->ulPos = lPos;
+    iRet = lPos;
+
+done:
+    osSemaphoreRelease(g_tMwFsLock);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Sync
+*
+* DESCRIPTION:
+*   commit the data written, it is kept after a power loss
+*
+* PARAMETERS
+*   1. iFd : [In] the handle
+*
+* RETURNS
+*   MW_FS_OK    : successful
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_Sync(int iFd)
+{
+    T_MwFsFile *ptFile;
+    int iRet;
+
+    if (!g_ubMwFsMounted)
+        return MW_FS_ERR_NOFS;
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+
+    ptFile = MwFs_FileGet(iFd);
+    iRet = (ptFile != NULL) ? MwFs_SyncLocked(ptFile) : MW_FS_ERR_BADF;
+
+    osSemaphoreRelease(g_tMwFsLock);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Close
+*
+* DESCRIPTION:
+*   commit the data written and free the handle, the handle is freed even
+*   if the commit fails (the file keeps the last commit)
+*
+* PARAMETERS
+*   1. iFd : [In] the handle
+*
+* RETURNS
+*   MW_FS_OK    : successful
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_Close(int iFd)
+{
+    T_MwFsFile *ptFile;
+    int iRet;
+
+    if (!g_ubMwFsMounted)
+        return MW_FS_ERR_NOFS;
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+
+    ptFile = MwFs_FileGet(iFd);
+    if (ptFile == NULL)
+    {
+        iRet = MW_FS_ERR_BADF;
+        goto done;
+    }
+
+    iRet = MwFs_SyncLocked(ptFile);
+    ptFile->ubUsed = 0;
+
+    // the blocks of a lost write
+    if (iRet != MW_FS_OK)
+        MwFs_UsedBuild();
+
+done:
+    osSemaphoreRelease(g_tMwFsLock);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Stat
+*
+* DESCRIPTION:
+*   get the type and the size of a path
+*
+* PARAMETERS
+*   1. sPath  : [In] the path
+*   2. ptStat : [Out] the information
+*
+* RETURNS
+*   MW_FS_OK    : successful
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_Stat(const char *sPath, T_MwFsStat *ptStat)
+{
+    const char *sName;
+    uint8_t ubParent;
+    int iEntry;
+    int iRet;
+
+    if (!g_ubMwFsMounted)
+        return MW_FS_ERR_NOFS;
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+
+    iRet = MwFs_Lookup(sPath, &iEntry, &ubParent, &sName);
+    if (iRet != MW_FS_OK)
+        goto done;
+
+    memset(ptStat, 0, sizeof(T_MwFsStat));
+
+    if (iEntry == MW_FS_ROOT)
+    {
+        ptStat->ubType = MW_FS_TYPE_DIR;
+        strcpy(ptStat->sName, "/");
+    }
+    else if (iEntry >= 0)
+    {
+        ptStat->ubType = g_taMwFsEntry[iEntry].ubType;
+        ptStat->ulSize = g_taMwFsEntry[iEntry].ulSize;
+        strcpy(ptStat->sName, g_taMwFsEntry[iEntry].sName);
+    }
+    else
+    {
+        iRet = MW_FS_ERR_NOENT;
+    }
+
+done:
+    osSemaphoreRelease(g_tMwFsLock);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Remove
+*
+* DESCRIPTION:
+*   remove a file which is not open, or an empty dir
+*
+* PARAMETERS
+*   1. sPath : [In] the path
+*
+* RETURNS
+*   MW_FS_OK    : successful
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_Remove(const char *sPath)
+{
+    const char *sName;
+    uint8_t ubParent;
+    uint8_t ubType;
+    int iEntry;
+    int iRet;
+    uint32_t i;
+
+    if (!g_ubMwFsMounted)
+        return MW_FS_ERR_NOFS;
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+
+    iRet = MwFs_Lookup(sPath, &iEntry, &ubParent, &sName);
+    if (iRet != MW_FS_OK)
+        goto done;
+
+    if (iEntry < 0)
+    {
+        iRet = MW_FS_ERR_NOENT;
+        goto done;
+    }
+
+    if (iEntry == MW_FS_ROOT)
+    {
+        iRet = MW_FS_ERR_INVAL;
+        goto done;
+    }
+
+    if (MwFs_EntryBusy(iEntry))
+    {
+        iRet = MW_FS_ERR_BUSY;
+        goto done;
+    }
+
+    for (i=0; i<MW_FS_ENTRY_MAX; i++)
+    {
+        if ((g_taMwFsEntry[i].ubType) && (g_taMwFsEntry[i].ubParent == iEntry))
+        {
+            iRet = MW_FS_ERR_NOTEMPTY;
+            goto done;
+        }
+    }
+
+    ubType = g_taMwFsEntry[iEntry].ubType;
+    g_taMwFsEntry[iEntry].ubType = 0;
+
+    iRet = MwFs_Commit();
+    if (iRet != MW_FS_OK)
+        g_taMwFsEntry[iEntry].ubType = ubType;
+
+done:
+    osSemaphoreRelease(g_tMwFsLock);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Rename
+*
+* DESCRIPTION:
+*   rename or move a file or a dir, the new path must not exist
+*
+* PARAMETERS
+*   1. sOld : [In] the path
+*   2. sNew : [In] the new path
+*
+* RETURNS
+*   MW_FS_OK    : successful
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_Rename(const char *sOld, const char *sNew)
+{
+    T_MwFsEntry tOld;
+    const char *sName;
+    uint8_t ubParent;
+    uint8_t ubDir;
+    int iEntry;
+    int iNew;
+    int iRet;
+
+    if (!g_ubMwFsMounted)
+        return MW_FS_ERR_NOFS;
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+
+    iRet = MwFs_Lookup(sOld, &iEntry, &ubParent, &sName);
+    if (iRet != MW_FS_OK)
+        goto done;
+
+    if ((iEntry < 0) || (iEntry == MW_FS_ROOT))
+    {
+        iRet = (iEntry < 0) ? MW_FS_ERR_NOENT : MW_FS_ERR_INVAL;
+        goto done;
+    }
+
+    iRet = MwFs_Lookup(sNew, &iNew, &ubParent, &sName);
+    if (iRet != MW_FS_OK)
+        goto done;
+
+    if (iNew >= 0)
+    {
+        iRet = MW_FS_ERR_EXIST;
+        goto done;
+    }
+
+    // not into itself
+    for (ubDir = ubParent; ubDir != MW_FS_ROOT; ubDir = g_taMwFsEntry[ubDir].ubParent)
+    {
+        if (ubDir == iEntry)
+        {
+            iRet = MW_FS_ERR_INVAL;
+            goto done;
+        }
+    }
+
+    tOld = g_taMwFsEntry[iEntry];
+    g_taMwFsEntry[iEntry].ubParent = ubParent;
+    memset(g_taMwFsEntry[iEntry].sName, 0, sizeof(g_taMwFsEntry[iEntry].sName));
+    strncpy(g_taMwFsEntry[iEntry].sName, sName, MW_FS_NAME_MAX);
+
+    iRet = MwFs_Commit();
+    if (iRet != MW_FS_OK)
+        g_taMwFsEntry[iEntry] = tOld;
+
+done:
+    osSemaphoreRelease(g_tMwFsLock);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Mkdir
+*
+* DESCRIPTION:
+*   create a dir, the parent must exist
+*
+* PARAMETERS
+*   1. sPath : [In] the path
+*
+* RETURNS
+*   MW_FS_OK    : successful
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_Mkdir(const char *sPath)
+{
+    const char *sName;
+    uint8_t ubParent;
+    int iEntry;
+    int iRet;
+
+    if (!g_ubMwFsMounted)
+        return MW_FS_ERR_NOFS;
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+
+    iRet = MwFs_Lookup(sPath, &iEntry, &ubParent, &sName);
+    if (iRet != MW_FS_OK)
+        goto done;
+
+    if (iEntry != -1)
+    {
+        iRet = MW_FS_ERR_EXIST;
+        goto done;
+    }
+
+    iEntry = MwFs_EntryNew(MW_FS_TYPE_DIR, ubParent, sName);
+    if (iEntry < 0)
+    {
+        iRet = MW_FS_ERR_NOSPC;
+        goto done;
+    }
+
+    iRet = MwFs_Commit();
+    if (iRet != MW_FS_OK)
+        g_taMwFsEntry[iEntry].ubType = 0;
+
+done:
+    osSemaphoreRelease(g_tMwFsLock);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_DirRead
+*
+* DESCRIPTION:
+*   list a dir, one entry per call
+*
+* PARAMETERS
+*   1. sPath     : [In] the dir
+*   2. pulCookie : [In/Out] 0 at the start
+*   3. ptStat    : [Out] the entry
+*
+* RETURNS
+*   1 : an entry
+*   0 : the end
+*   MW_FS_ERR_xxx : fail
+*
+*************************************************************************/
+int MwFs_DirRead(const char *sPath, uint32_t *pulCookie, T_MwFsStat *ptStat)
+{
+    const char *sName;
+    uint8_t ubParent;
+    int iEntry;
+    int iRet;
+    uint32_t i;
+
+    if (!g_ubMwFsMounted)
+        return MW_FS_ERR_NOFS;
+
+    osSemaphoreWait(g_tMwFsLock, osWaitForever);
+
+    iRet = MwFs_Lookup(sPath, &iEntry, &ubParent, &sName);
+    if (iRet != MW_FS_OK)
+        goto done;
+
+    if (iEntry < 0)
+    {
+        iRet = MW_FS_ERR_NOENT;
+        goto done;
+    }
+
+    if ((iEntry != MW_FS_ROOT) && (g_taMwFsEntry[iEntry].ubType != MW_FS_TYPE_DIR))
+    {
+        iRet = MW_FS_ERR_NOTDIR;
+        goto done;
+    }
+
+    iRet = 0;
+
+    for (i=*pulCookie; i<MW_FS_ENTRY_MAX; i++)
+    {
+        if ((g_taMwFsEntry[i].ubType) && (g_taMwFsEntry[i].ubParent == iEntry))
+        {
+            memset(ptStat, 0, sizeof(T_MwFsStat));
+            ptStat->ubType = g_taMwFsEntry[i].ubType;
+            ptStat->ulSize = g_taMwFsEntry[i].ulSize;
+            strcpy(ptStat->sName, g_taMwFsEntry[i].sName);
+
+            *pulCookie = i + 1;
+            iRet = 1;
+            break;
+        }
+    }
+
+done:
+    osSemaphoreRelease(g_tMwFsLock);
+    return iRet;
+}
+
+static uint32_t MwFs_Rand(uint32_t *pulSeed)
+{
+    uint32_t x = *pulSeed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    *pulSeed = x;
+    return x;
+}
+
+// the content of a stress file: the generation in the first 4 bytes, then a hash of the offset
+static void MwFs_StressFill(uint32_t ulGen, uint32_t ulOff, uint8_t *pubBuf, uint32_t ulSize)
+{
+    uint32_t x;
+    uint32_t i;
+
+    for (i=0; i<ulSize; i++, ulOff++)
+    {
+        if (ulOff < sizeof(ulGen))
+        {
+            pubBuf[i] = (uint8_t)(ulGen >> (ulOff * 8));
+            continue;
+        }
+
+        x = ulGen ^ (ulOff * 0x9E3779B1);
+        x ^= x >> 15;
+        x *= 0x85EBCA6B;
+        x ^= x >> 13;
+        pubBuf[i] = (uint8_t)x;
+    }
+}
+
+static int MwFs_StressWrite(int iFd, uint32_t ulGen, uint32_t ulOff, uint32_t ulSize)
+{
+    uint8_t ubaBuf[MW_FS_CHUNK];
+    uint32_t ulChunk;
+
+    while (ulSize)
+    {
+        ulChunk = (ulSize > sizeof(ubaBuf)) ? sizeof(ubaBuf) : ulSize;
+        MwFs_StressFill(ulGen, ulOff, ubaBuf, ulChunk);
+
+        if (MwFs_Write(iFd, ubaBuf, ulChunk) != (int)ulChunk)
+            return MW_FS_ERR_IO;
+
+        ulOff += ulChunk;
+        ulSize -= ulChunk;
+    }
+
+    return MW_FS_OK;
+}
+
+// 1: the file is one of the versions written, a power loss keeps the old or the new one
+static uint8_t MwFs_StressVerify(const char *sPath, uint32_t *pulSize)
+{
+    uint8_t ubaBuf[MW_FS_CHUNK];
+    uint8_t ubaExp[MW_FS_CHUNK];
+    uint32_t ulGen = 0;
+    uint32_t ulOff = 0;
+    uint8_t ubRet = 0;
+    int iFd;
+    int iLen;
+
+    *pulSize = 0;
+
+    iFd = MwFs_Open(sPath, MW_FS_O_RDONLY);
+    if (iFd < 0)
+        return 0;
+
+    // created, cut before the first write
+    iLen = MwFs_Read(iFd, &ulGen, sizeof(ulGen));
+    if (iLen == 0)
+    {
+        ubRet = 1;
+        goto done;
+    }
+
+    if (iLen != sizeof(ulGen))
+        goto done;
+
+    ulOff = sizeof(ulGen);
+
+    while ((iLen = MwFs_Read(iFd, ubaBuf, sizeof(ubaBuf))) > 0)
+    {
+        MwFs_StressFill(ulGen, ulOff, ubaExp, iLen);
+        if (memcmp(ubaBuf, ubaExp, iLen))
+            goto done;
+
+        ulOff += iLen;
+    }
+
+    ubRet = (iLen == 0);
+
+done:
+    *pulSize = ulOff;
+    MwFs_Close(iFd);
+    return ubRet;
+}
+
+static void MwFs_StressCheck(void)
+{
+    T_MwFsStat tStat;
+    char sPath[32];
+    uint32_t ulBad = 0;
+    uint32_t ulSize;
+    uint32_t i;
+
+    for (i=0; i<MW_FS_STRESS_FILE_NUM; i++)
+    {
+        sprintf(sPath, "%s/s%u", MW_FS_STRESS_DIR, i);
+
+        if (MW_FS_OK != MwFs_Stat(sPath, &tStat))
+            continue;
+
+        if (MwFs_StressVerify(sPath, &ulSize))
+        {
+            printf("fs: %s %u bytes ok\n", sPath, ulSize);
+        }
+        else
+        {
+            printf("fs: %s bad at %u\n", sPath, ulSize);
+            ulBad++;
+        }
+    }
+
+    printf("fs: check %s\n", (ulBad) ? "FAIL" : "PASS");
+}
+
+// random rewrites, appends and removes of a few files, checked at the end
+static void MwFs_Stress(uint32_t ulOps, uint32_t ulSeed)
+{
+    char sPath[32];
+    uint32_t ulGen;
+    uint32_t ulSize;
+    uint32_t ulOp;
+    uint32_t i;
+    int iFd;
+    int iRet = MW_FS_OK;
+
+    if (ulSeed == 0)
+        ulSeed = osKernelSysTick() | 1;
+
+    printf("fs: stress %u ops, seed %u\n", ulOps, ulSeed);
+    MwFs_Mkdir(MW_FS_STRESS_DIR);
+
+    for (i=0; i<ulOps; i++)
+    {
+        sprintf(sPath, "%s/s%u", MW_FS_STRESS_DIR, MwFs_Rand(&ulSeed) % MW_FS_STRESS_FILE_NUM);
+        ulOp = MwFs_Rand(&ulSeed) % 8;
+
+        if (ulOp < 4)
+        {
+            ulGen = MwFs_Rand(&ulSeed);
+            ulSize = sizeof(ulGen) + (MwFs_Rand(&ulSeed) % MW_FS_STRESS_LEN_MAX);
+
+            iFd = MwFs_Open(sPath, MW_FS_O_WRONLY | MW_FS_O_CREAT | MW_FS_O_TRUNC);
+            if (iFd < 0)
+            {
+                iRet = iFd;
+                break;
+            }
+
+            iRet = MwFs_StressWrite(iFd, ulGen, 0, ulSize);
+            if (MwFs_Close(iFd) != MW_FS_OK)
+                iRet = MW_FS_ERR_IO;
+        }
+        else if (ulOp < 7)
+        {
+            iFd = MwFs_Open(sPath, MW_FS_O_RDWR | MW_FS_O_APPEND);
+            if (iFd == MW_FS_ERR_NOENT)
+                continue;
+
+            if (iFd < 0)
+            {
+                iRet = iFd;
+                break;
+            }
+
+            // the generation of the file goes on, an empty one is left as it is
+            iRet = MwFs_Read(iFd, &ulGen, sizeof(ulGen));
+            if (iRet != sizeof(ulGen))
+            {
+                MwFs_Close(iFd);
+
+                if (iRet == 0)
+                {
+                    iRet = MW_FS_OK;
+                    continue;
+                }
+
+                iRet = MW_FS_ERR_CORRUPT;
+                break;
+            }
+
+            ulSize = MwFs_Seek(iFd, 0, MW_FS_SEEK_END);
+            iRet = MwFs_StressWrite(iFd, ulGen, ulSize, 1 + (MwFs_Rand(&ulSeed) % MW_FS_STRESS_APPEND_MAX));
+            if (MwFs_Close(iFd) != MW_FS_OK)
+                iRet = MW_FS_ERR_IO;
+        }
+        else
+        {
+            iRet = MwFs_Remove(sPath);
+            if (iRet == MW_FS_ERR_NOENT)
+                iRet = MW_FS_OK;
+        }
+
+        if (iRet != MW_FS_OK)
+            break;
+    }
+
+    if (iRet != MW_FS_OK)
+        printf("fs: stress stopped at op %u, %d\n", i, iRet);
+
+    MwFs_StressCheck();
+}
+
+// the throughput and the wear of a file of ulKb
+static void MwFs_Bench(uint32_t ulKb)
+{
+    T_MwFsInfo tInfo;
+    uint8_t *pubBuf = NULL;
+    uint32_t ulErase;
+    uint32_t ulProgram;
+    uint32_t ulTick;
+    uint32_t ulWriteMs;
+    uint32_t ulReadMs;
+    uint32_t ulOff;
+    uint32_t ulBad = 0;
+    int iFd = -1;
+    uint32_t i;
+
+    pubBuf = (uint8_t *)malloc(MW_FS_BENCH_BUF);
+    if (pubBuf == NULL)
+    {
+        printf("fs: malloc fail\n");
+        goto done;
+    }
+
+    if (MW_FS_OK != MwFs_Info(&tInfo))
+        goto done;
+
+    ulErase = tInfo.ulErase;
+    ulProgram = tInfo.ulProgram;
+
+    iFd = MwFs_Open("/bench", MW_FS_O_WRONLY | MW_FS_O_CREAT | MW_FS_O_TRUNC);
+    if (iFd < 0)
+    {
+        printf("fs: open fail %d\n", iFd);
+        goto done;
+    }
+
+    ulTick = osKernelSysTick();
+
+    for (ulOff=0; ulOff<(ulKb * 1024); ulOff+=MW_FS_BENCH_BUF)
+    {
+        for (i=0; i<MW_FS_BENCH_BUF; i++)
+            pubBuf[i] = (uint8_t)(ulOff + i);
+
+        if (MwFs_Write(iFd, pubBuf, MW_FS_BENCH_BUF) != MW_FS_BENCH_BUF)
+        {
+            printf("fs: write fail at %u\n", ulOff);
+            break;
+        }
+    }
+
+    MwFs_Close(iFd);
+    ulWriteMs = osKernelSysTick() - ulTick;
+
+    iFd = MwFs_Open("/bench", MW_FS_O_RDONLY);
+    if (iFd < 0)
+        goto done;
+
+    ulTick = osKernelSysTick();
+
+    for (ulOff=0; MwFs_Read(iFd, pubBuf, MW_FS_BENCH_BUF) == MW_FS_BENCH_BUF; ulOff+=MW_FS_BENCH_BUF)
+    {
+        for (i=0; i<MW_FS_BENCH_BUF; i++)
+        {
+            if (pubBuf[i] != (uint8_t)(ulOff + i))
+                ulBad++;
+        }
+    }
+
+    ulReadMs = osKernelSysTick() - ulTick;
+    MwFs_Close(iFd);
+    MwFs_Remove("/bench");
+
+    MwFs_Info(&tInfo);
+
+    printf("fs: bench %u KB, write %u ms (%u KB/s), read %u ms (%u KB/s), %s\n",
+           ulOff / 1024, ulWriteMs, (ulOff / 1024) * 1000 / (ulWriteMs ? ulWriteMs : 1),
+           ulReadMs, (ulOff / 1024) * 1000 / (ulReadMs ? ulReadMs : 1), (ulBad) ? "BAD DATA" : "data ok");
+    printf("fs: bench erased %u blocks, programmed %u bytes (x%u.%02u of the data)\n",
+           tInfo.ulErase - ulErase, tInfo.ulProgram - ulProgram,
+           (tInfo.ulProgram - ulProgram) / (ulOff ? ulOff : 1),
+           ((tInfo.ulProgram - ulProgram) % (ulOff ? ulOff : 1)) * 100 / (ulOff ? ulOff : 1));
+
+done:
+    if (pubBuf)
+        free(pubBuf);
+}
+
+static void MwFs_Ls(const char *sPath)
+{
+    T_MwFsStat tStat;
+    uint32_t ulCookie = 0;
+    int iRet;
+
+    while ((iRet = MwFs_DirRead(sPath, &ulCookie, &tStat)) > 0)
+    {
+        if (tStat.ubType == MW_FS_TYPE_DIR)
+            printf("  %-23s <dir>\n", tStat.sName);
+        else
+            printf("  %-23s %u\n", tStat.sName, tStat.ulSize);
+    }
+
+    if (iRet < 0)
+        printf("fs: ls %s fail %d\n", sPath, iRet);
+}
+
+static void MwFs_Cat(const char *sPath)
+{
+    char baBuf[MW_FS_CHUNK];
+    int iFd;
+    int iLen;
+
+    iFd = MwFs_Open(sPath, MW_FS_O_RDONLY);
+    if (iFd < 0)
+    {
+        printf("fs: open %s fail %d\n", sPath, iFd);
+        return;
+    }
+
+    while ((iLen = MwFs_Read(iFd, baBuf, sizeof(baBuf))) > 0)
+        printf("%.*s", iLen, baBuf);
+
+    printf("\n");
+    MwFs_Close(iFd);
+}
+
+static int MwFs_Put(const char *sPath, const char *sText, uint32_t ulFlags)
+{
+    int iFd;
+    int iRet;
+
+    iFd = MwFs_Open(sPath, MW_FS_O_WRONLY | MW_FS_O_CREAT | ulFlags);
+    if (iFd < 0)
+        return iFd;
+
+    iRet = MwFs_Write(iFd, sText, strlen(sText));
+    if (iRet >= 0)
+        iRet = MW_FS_OK;
+
+    if (MwFs_Close(iFd) != MW_FS_OK)
+        iRet = MW_FS_ERR_IO;
+
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwFs_Cmd
+*
+* DESCRIPTION:
+*   diag command: fs [ls [dir]|cat|write|append|rm|mkdir|mv|format|bench|stress|check|cut]
+*     no argument: the usage of the partition
+*     ls [dir], cat <file>, rm <path>, mkdir <dir>, mv <old> <new>
+*     write <file> <text>: replace, append <file> <text>: add at the end
+*     format: erase the partition
+*     bench [kb]: write, read back and remove a file, the speed and the wear
+*     stress <ops> [seed]: random rewrites, appends and removes in /stress
+*     check: verify the files of /stress, after a reset in the middle
+*     cut <n>: the n-th program from now stops halfway and the system resets
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwFs_Cmd(char *sCmd)
+{
+    char *baParam[MW_FS_PARAM_MAX + 1] = {0};
+    T_MwFsInfo tInfo;
+    uint32_t ulNum = 0;
+    int iRet = MW_FS_OK;
+
+    ulNum = ParseParam(sCmd, baParam, MW_FS_PARAM_MAX + 1);
+
+    if (ulNum < 2)
+    {
+        iRet = MwFs_Info(&tInfo);
+        if (iRet == MW_FS_OK)
+        {
+            tracer_cli(LOG_HIGH_LEVEL, "fs: 0x%X %u blocks, %u free, %u/%u entries, rev %u, erased %u, programmed %u bytes\n",
+                       tInfo.ulAddr, tInfo.ulBlockNum, tInfo.ulBlockFree, tInfo.ulEntryUsed, MW_FS_ENTRY_MAX,
+                       tInfo.ulRev, tInfo.ulErase, tInfo.ulProgram);
+        }
+        goto done;
+    }
+
+    if (!strcmp(baParam[1], "ls"))
+        MwFs_Ls((ulNum > 2) ? baParam[2] : "/");
+    else if ((!strcmp(baParam[1], "cat")) && (ulNum > 2))
+        MwFs_Cat(baParam[2]);
+    else if ((!strcmp(baParam[1], "write")) && (ulNum > 3))
+        iRet = MwFs_Put(baParam[2], baParam[3], MW_FS_O_TRUNC);
+    else if ((!strcmp(baParam[1], "append")) && (ulNum > 3))
+        iRet = MwFs_Put(baParam[2], baParam[3], MW_FS_O_APPEND);
+    else if ((!strcmp(baParam[1], "rm")) && (ulNum > 2))
+        iRet = MwFs_Remove(baParam[2]);
+    else if ((!strcmp(baParam[1], "mkdir")) && (ulNum > 2))
+        iRet = MwFs_Mkdir(baParam[2]);
+    else if ((!strcmp(baParam[1], "mv")) && (ulNum > 3))
+        iRet = MwFs_Rename(baParam[2], baParam[3]);
+    else if (!strcmp(baParam[1], "format"))
+        iRet = MwFs_Format();
+    else if (!strcmp(baParam[1], "bench"))
+        MwFs_Bench((ulNum > 2) ? strtoul(baParam[2], NULL, 0) : 32);
+    else if ((!strcmp(baParam[1], "stress")) && (ulNum > 2))
+        MwFs_Stress(strtoul(baParam[2], NULL, 0), (ulNum > 3) ? strtoul(baParam[3], NULL, 0) : 0);
+    else if (!strcmp(baParam[1], "check"))
+        MwFs_StressCheck();
+    else if ((!strcmp(baParam[1], "cut")) && (ulNum > 2))
+        g_ulMwFsCut = strtoul(baParam[2], NULL, 0);
+    else
+        tracer_cli(LOG_HIGH_LEVEL, "usage: fs [ls [dir]|cat <file>|write <file> <text>|append <file> <text>|rm <path>|mkdir <dir>|mv <old> <new>|format|bench [kb]|stress <ops> [seed]|check|cut <n>]\n");
+
+done:
+    if (iRet != MW_FS_OK)
+        tracer_cli(LOG_HIGH_LEVEL, "fs: fail %d\n", iRet);
+}
@@ -0,0 +1,178 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  mw_fs.h
+*
+*  Project:
+*  --------
+*  OPL1000 Project - the file system definition file
+*
+*  Description:
+*  ------------
+*  This include file is the file system definition file.
+*
+*  A small power-safe file system for the user data (certificates, config
+*  blobs, recorded data) in a partition of 4KB blocks on SPI_IDX_0.
+*
+*  - Copy on write: a file is a chain of data blocks linked backward, the
+*    newest block first. The data written goes to new blocks (or to the
+*    erased end of a block started by the same handle), the old ones are
+*    untouched until the commit.
+*  - The directory is a table of MW_FS_ENTRY_MAX entries (files and dirs,
+*    each with the index of its parent). A commit writes the whole table
+*    with a higher revision and a CRC-32 to a free block, the newest valid
+*    one wins at the mount. A power loss at any point keeps the last commit.
+*  - Wear: the blocks, the table included, are taken round-robin over the
+*    partition, and the next free block is erased ahead by the flash erase
+*    service.
+*  - RAM: the table, a bitmap of the blocks and MW_FS_FILE_MAX handles,
+*    no block buffer.
+*
+*  Writes are sequential: at the end of the file, or after MW_FS_O_TRUNC.
+*  The changes of a file are committed by MwFs_Sync / MwFs_Close, the ones
+*  of the directory by each call.
+*
+******************************************************************************/
+/***********************
+Head Block of The File
+***********************/
+#ifndef _MW_FS_H_
+#define _MW_FS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sec 0: Comment block of the file
+
+
+// Sec 1: Include File
+#include <stdint.h>
+
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define MW_FS_OK                    0
+#define MW_FS_ERR_IO                -1      // the flash fails
+#define MW_FS_ERR_CORRUPT           -2      // no valid table, or a broken chain
+#define MW_FS_ERR_NOENT             -3
+#define MW_FS_ERR_EXIST             -4
+#define MW_FS_ERR_NOTDIR            -5
+#define MW_FS_ERR_ISDIR             -6
+#define MW_FS_ERR_NOTEMPTY          -7
+#define MW_FS_ERR_INVAL             -8
+#define MW_FS_ERR_NOSPC             -9      // no free block, or no free entry
+#define MW_FS_ERR_BADF              -10
+#define MW_FS_ERR_BUSY              -11     // the file is open
+#define MW_FS_ERR_NAMETOOLONG       -12
+#define MW_FS_ERR_MFILE             -13     // no free handle
+#define MW_FS_ERR_NOFS              -14     // not mounted
+
+// the default partition, up to the AT write area
+#define MW_FS_ADDR                  0x000C0000
+#define MW_FS_BLOCK_NUM             56
+#define MW_FS_BLOCK_SIZE            0x1000
+#define MW_FS_BLOCK_MAX             128     // the size of the bitmap
+
+#define MW_FS_ENTRY_MAX             32      // files and dirs
+#define MW_FS_NAME_MAX              23      // bytes of a name, no '\0'
+#define MW_FS_FILE_MAX              4       // open files
+
+// the flags of MwFs_Open
+#define MW_FS_O_RDONLY              0x0001
+#define MW_FS_O_WRONLY              0x0002
+#define MW_FS_O_RDWR                (MW_FS_O_RDONLY | MW_FS_O_WRONLY)
+#define MW_FS_O_CREAT               0x0100
+#define MW_FS_O_EXCL                0x0200
+#define MW_FS_O_TRUNC               0x0400
+#define MW_FS_O_APPEND              0x0800
+
+#define MW_FS_SEEK_SET              0
+#define MW_FS_SEEK_CUR              1
+#define MW_FS_SEEK_END              2
+
+#define MW_FS_TYPE_FILE             1
+#define MW_FS_TYPE_DIR              2
+
+
+/******************************
+Declaration of data structure
+******************************/
+// Sec 3: structure, uniou, enum, linked list
+// the partition
+typedef struct
+{
+    uint32_t ulAddr;                // 4KB aligned
+    uint32_t ulBlockNum;            // 4 ~ MW_FS_BLOCK_MAX
+} T_MwFsLayout;
+
+typedef struct
+{
+    uint8_t ubType;                 // MW_FS_TYPE_xxx
+    uint32_t ulSize;                // the committed size of a file
+    char sName[MW_FS_NAME_MAX + 1];
+} T_MwFsStat;
+
+typedef struct
+{
+    uint32_t ulAddr;
+    uint32_t ulBlockNum;
+    uint32_t ulBlockFree;
+    uint32_t ulEntryUsed;
+    uint32_t ulRev;                 // the revision of the table
+    uint32_t ulErase;               // blocks erased since the boot
+    uint32_t ulProgram;             // bytes programmed since the boot
+} T_MwFsInfo;
+
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+
+// Sec 5: declaration of global function prototype
+int MwFs_Init(T_MwFsLayout *ptLayout);
+int MwFs_Format(void);
+int MwFs_Info(T_MwFsInfo *ptInfo);
+
+int MwFs_Open(const char *sPath, uint32_t ulFlags);
+int MwFs_Read(int iFd, void *pBuf, uint32_t ulSize);
+int MwFs_Write(int iFd, const void *pBuf, uint32_t ulSize);
+int MwFs_Seek(int iFd, int32_t lOffset, int iWhence);
+int MwFs_Sync(int iFd);
+int MwFs_Close(int iFd);
+
+int MwFs_Stat(const char *sPath, T_MwFsStat *ptStat);
+int MwFs_Remove(const char *sPath);
+int MwFs_Rename(const char *sOld, const char *sNew);
+int MwFs_Mkdir(const char *sPath);
+int MwFs_DirRead(const char *sPath, uint32_t *pulCookie, T_MwFsStat *ptStat);
+
+void MwFs_Cmd(char *sCmd);
+
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+
+
+// Sec 7: declaration of static function prototype
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _MW_FS_H_
@@ -91,6 +91,9 @@ RET_DATA T_MwOta_HeaderSeqNumGet_Fp MwOta_HeaderSeqNumGet;
 RET_DATA T_MwOta_ImageCheckSumLocal_Fp MwOta_ImageCheckSumLocal;    // use the local buffer
 RET_DATA T_MwOta_ImageCheckSumAlloc_Fp MwOta_ImageCheckSumAlloc;    // use the alloc buffer
 RET_DATA T_MwOta_ImageCheckSumCompute_Fp MwOta_ImageCheckSumCompute;
+RET_DATA T_MwOta_ImageEraseStart_Fp MwOta_ImageEraseStart;
+RET_DATA T_MwOta_ImageEraseWait_Fp MwOta_ImageEraseWait;
+RET_DATA T_MwOta_ImageEraseStop_Fp MwOta_ImageEraseStop;
 
 
 /***************************************************
@@ -336,14 +339,8 @@ uint8_t MwOta_Prepare_impl(uint16_t uwProjectId, uint16_t uwChipId, uint16_t uwF
         return MW_OTA_FAIL;
     }
     // image
-    for (i=0; i<g_tMwOtaLayoutInfo.ulImageSize; i+= 0x1000)
-    {
-        if (0 != g_tMwOtaEraseFunc(SPI_IDX_0, g_ulMwOtaPrepareImageAddr + i))
-        {
-            printf("To erase the image [%u] of MW_OTA is fail.\n", g_ulMwOtaPrepareImageAddr + i);
-            return MW_OTA_FAIL;
-        }
-    }
+    if (MW_OTA_OK != MwOta_ImageEraseStart(g_ulMwOtaPrepareImageAddr, g_tMwOtaLayoutInfo.ulImageSize))
+        return MW_OTA_FAIL;
     
     // update the prepare status 
     g_ubMwOtaPrepareStatus = MW_OTA_PREPARE_READY;
@@ -381,6 +378,10 @@ uint8_t MwOta_DataIn_impl(uint8_t *pubAddr, uint32_t ulSize)
     if ((g_ulMwOtaPrepareWriteSize + ulSize) > g_tMwOtaPrepareHeaderInfo.ulImageSize)
         return MW_OTA_FAIL;
     
+    // the sectors must be erased before
+    if (MW_OTA_OK != MwOta_ImageEraseWait(g_ulMwOtaPrepareWriteAddr, ulSize))
+        return MW_OTA_FAIL;
+    
     // write the image data
     if (0 != g_tMwOtaWriteFunc(SPI_IDX_0, g_ulMwOtaPrepareWriteAddr, 0, ulSize, pubAddr))
     {
@@ -443,6 +444,9 @@ uint8_t MwOta_DataFinish_impl(void)
         return MW_OTA_FAIL;
     }
     
+    // the rest of the image area is not used
+    MwOta_ImageEraseStop();
+    
     return MW_OTA_OK;
 }
 
@@ -472,6 +476,7 @@ uint8_t MwOta_DataGiveUp_impl(void)
         return MW_OTA_FAIL;
     
     g_ubMwOtaPrepareStatus = MW_OTA_PREPARE_NONE;
+    MwOta_ImageEraseStop();
     
     return MW_OTA_OK;
 }
@@ -725,6 +730,81 @@ uint32_t MwOta_ImageCheckSumCompute_impl(uint8_t ubaData[])
     return ulCheckSum;
 }
 
+/*************************************************************************
+* FUNCTION:
+*   MwOta_ImageEraseStart
+*
+* DESCRIPTION:
+*   erase the image area
+*
+* PARAMETERS
+*   1. ulImageAddr : [In] the start address of image
+*   2. ulImageSize : [In] the size of image area
+*
+* RETURNS
+*   MW_OTA_OK   : successful
+*   MW_OTA_FAIL : fail
+*
+*************************************************************************/
+uint8_t MwOta_ImageEraseStart_impl(uint32_t ulImageAddr, uint32_t ulImageSize)
+{
+    uint32_t i;
+    
+    for (i=0; i<ulImageSize; i+= 0x1000)
+    {
+        if (0 != g_tMwOtaEraseFunc(SPI_IDX_0, ulImageAddr + i))
+        {
+            printf("To erase the image [%u] of MW_OTA is fail.\n", ulImageAddr + i);
+            return MW_OTA_FAIL;
+        }
+    }
+    
+    return MW_OTA_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwOta_ImageEraseWait
+*
+* DESCRIPTION:
+*   make sure the sectors are erased before writing the data
+*
+* PARAMETERS
+*   1. ulAddr : [In] the start address
+*   2. ulSize : [In] the data size
+*
+* RETURNS
+*   MW_OTA_OK   : successful
+*   MW_OTA_FAIL : fail
+*
+*************************************************************************/
+uint8_t MwOta_ImageEraseWait_impl(uint32_t ulAddr, uint32_t ulSize)
+{
+    (void)ulAddr;
+    (void)ulSize;
+
+    // the whole area is erased by MwOta_ImageEraseStart
+    return MW_OTA_OK;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   MwOta_ImageEraseStop
+*
+* DESCRIPTION:
+*   the image area is not written any more
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void MwOta_ImageEraseStop_impl(void)
+{
+}
+
 /*************************************************************************
 * FUNCTION:
 *   MwOta_PreInitCold
@@ -755,4 +835,7 @@ void MwOta_PreInitCold(void)
     MwOta_ImageCheckSumLocal = MwOta_ImageCheckSumLocal_impl;
     MwOta_ImageCheckSumAlloc = MwOta_ImageCheckSumAlloc_impl;
     MwOta_ImageCheckSumCompute = MwOta_ImageCheckSumCompute_impl;
+    MwOta_ImageEraseStart = MwOta_ImageEraseStart_impl;
+    MwOta_ImageEraseWait = MwOta_ImageEraseWait_impl;
+    MwOta_ImageEraseStop = MwOta_ImageEraseStop_impl;
 }
@@ -79,6 +79,9 @@ typedef uint16_t (*T_MwOta_HeaderSeqNumGet_Fp)(T_MwOtaFlashHeader *ptHeader);
 typedef uint32_t (*T_MwOta_ImageCheckSumLocal_Fp)(void);
 typedef uint32_t (*T_MwOta_ImageCheckSumAlloc_Fp)(void);
 typedef uint32_t (*T_MwOta_ImageCheckSumCompute_Fp)(uint8_t ubaData[]);
+typedef uint8_t (*T_MwOta_ImageEraseStart_Fp)(uint32_t ulImageAddr, uint32_t ulImageSize);
+typedef uint8_t (*T_MwOta_ImageEraseWait_Fp)(uint32_t ulAddr, uint32_t ulSize);
+typedef void (*T_MwOta_ImageEraseStop_Fp)(void);
 
 
 /********************************************
@@ -103,6 +106,9 @@ extern T_MwOta_HeaderSeqNumGet_Fp MwOta_HeaderSeqNumGet;
 extern T_MwOta_ImageCheckSumLocal_Fp MwOta_ImageCheckSumLocal;      // use the local buffer for 2nd boot loader
 extern T_MwOta_ImageCheckSumAlloc_Fp MwOta_ImageCheckSumAlloc;      // use the alloc buffer for the normal image
 extern T_MwOta_ImageCheckSumCompute_Fp MwOta_ImageCheckSumCompute;
+extern T_MwOta_ImageEraseStart_Fp MwOta_ImageEraseStart;            // erase the image area before the data in
+extern T_MwOta_ImageEraseWait_Fp MwOta_ImageEraseWait;              // before writing the data, for the deferred erase
+extern T_MwOta_ImageEraseStop_Fp MwOta_ImageEraseStop;
 
 void MwOta_PreInitCold(void);
 
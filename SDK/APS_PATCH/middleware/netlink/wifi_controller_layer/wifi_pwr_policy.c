@@ -0,0 +1,470 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmsis_os.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "wifi_api.h"
+#include "wifi_api_if.h"
+#include "driver_netlink.h"
+#include "controller_wifi_com_patch.h"
+#include "net_stats.h"
+#include "wifi_pwr_policy.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+#define WIFI_PWR_POLICY_PARAM_MAX       3
+#define WIFI_PWR_POLICY_CURVE_NUM       8
+
+/******************************************************
+ *               Global Variables
+ ******************************************************/
+static osTimerId g_tWifiPwrPolicyTimer = NULL;
+
+static uint32_t g_dwWifiPwrPolicyWakeUs = WIFI_PWR_POLICY_WAKE_US_DEF;
+static uint32_t g_dwWifiPwrPolicyPktUs = WIFI_PWR_POLICY_PKT_US_DEF;
+
+static uint32_t g_dwWifiPwrPolicyRxPkts = 0;
+static uint32_t g_dwWifiPwrPolicyTxPkts = 0;
+static uint32_t g_dwWifiPwrPolicyTxTick = 0;     // the last window with TX
+static uint32_t g_dwWifiPwrPolicyHoldTick = 0;   // every DTIM until this tick
+static uint32_t g_dwWifiPwrPolicyIdle = 0;       // idle windows in a row
+static uint8_t g_bWifiPwrPolicyConnected = 0;
+
+static wifi_pwr_policy_stat_t g_tWifiPwrPolicyStat;
+
+/******************************************************
+ *               Static Functions
+ ******************************************************/
+static uint32_t wifi_pwr_policy_delta(uint32_t now, uint32_t *last)
+{
+    // the counters may be cleared by "netstats reset"
+    uint32_t delta = (now >= *last) ? (now - *last) : now;
+
+    *last = now;
+    return delta;
+}
+
+static int wifi_pwr_policy_skip_apply(uint8_t skip, uint8_t force)
+{
+    if((!force) && (skip == g_tWifiPwrPolicyStat.skip))
+    {
+        return 0;
+    }
+
+    // share memory only, the application setting in flash is kept
+    if(!wpa_driver_netlink_sta_cfg(MLME_CMD_SET_PARAM, E_WIFI_PARAM_SKIP_DTIM_PERIODS, &skip))
+    {
+        return -1;
+    }
+
+    g_tWifiPwrPolicyStat.skip = skip;
+    g_tWifiPwrPolicyStat.change += 1;
+    return 0;
+}
+
+/*
+ * the DTIM period of the connected AP in ms, 0 if not connected
+ */
+static uint32_t wifi_pwr_policy_dtim_ms(void)
+{
+    wifi_ap_record_t ap;
+    uint32_t dtim = 0;
+
+    memset(&ap, 0, sizeof(ap));
+
+    if(wifi_sta_get_ap_info_api(&ap))
+    {
+        return 0;
+    }
+
+    if((!ap.beacon_interval) || (!ap.channel))
+    {
+        return 0;
+    }
+
+    dtim = (ap.dtim_period) ? ap.dtim_period : 1;
+
+    // TU is 1024 us
+    return (ap.beacon_interval * dtim * 1024) / 1000;
+}
+
+static uint8_t wifi_pwr_policy_skip_max(uint32_t dtim_ms)
+{
+    uint32_t skip = 0;
+
+    if((!dtim_ms) || (g_tWifiPwrPolicyStat.budget_ms < dtim_ms))
+    {
+        return 0;
+    }
+
+    skip = (g_tWifiPwrPolicyStat.budget_ms / dtim_ms) - 1;
+
+    if(skip > WIFI_MAX_SKIP_DTIM_PERIODS_PATCH)
+    {
+        skip = WIFI_MAX_SKIP_DTIM_PERIODS_PATCH;
+    }
+
+    return (uint8_t)skip;
+}
+
+static void wifi_pwr_policy_timeout(void const *argu)
+{
+    wifi_pwr_policy_stat_t *stat = &g_tWifiPwrPolicyStat;
+    T_NetStatsNetif netif;
+    uint32_t now = osKernelSysTick();
+    uint32_t rx = 0;
+    uint32_t tx = 0;
+    uint32_t target = 0;
+    uint32_t dtim_ms = 0;
+
+    if(!stat->budget_ms)
+    {
+        return;
+    }
+
+    net_stats_netif_get(&netif);
+    rx = wifi_pwr_policy_delta(netif.u32RxPkts, &g_dwWifiPwrPolicyRxPkts);
+    tx = wifi_pwr_policy_delta(netif.u32TxPkts, &g_dwWifiPwrPolicyTxPkts);
+
+    dtim_ms = wifi_pwr_policy_dtim_ms();
+
+    if(!dtim_ms)
+    {
+        g_bWifiPwrPolicyConnected = 0;
+        g_dwWifiPwrPolicyIdle = 0;
+        return;
+    }
+
+    stat->dtim_ms = dtim_ms;
+    stat->skip_max = wifi_pwr_policy_skip_max(dtim_ms);
+    stat->window += 1;
+
+    if(tx)
+    {
+        g_dwWifiPwrPolicyTxTick = now;
+    }
+
+    if((rx) || (tx) ||
+       ((now - g_dwWifiPwrPolicyTxTick) < WIFI_PWR_POLICY_LINGER_MS) ||
+       ((int32_t)(g_dwWifiPwrPolicyHoldTick - now) > 0))
+    {
+        stat->window_active += 1;
+        g_dwWifiPwrPolicyIdle = 0;
+        target = 0;
+    }
+    else
+    {
+        // double the wake period every idle window
+        if(g_dwWifiPwrPolicyIdle < 8)
+        {
+            g_dwWifiPwrPolicyIdle += 1;
+        }
+
+        target = (1 << g_dwWifiPwrPolicyIdle) - 1;
+    }
+
+    if(target > stat->skip_max)
+    {
+        target = stat->skip_max;
+    }
+
+    // send it once after every association, whatever M0 has now
+    if(!wifi_pwr_policy_skip_apply((uint8_t)target, (g_bWifiPwrPolicyConnected) ? 0 : 1))
+    {
+        g_bWifiPwrPolicyConnected = 1;
+    }
+
+    stat->awake_us_last = wifi_pwr_policy_awake_estimate(dtim_ms, stat->skip, rx + tx, WIFI_PWR_POLICY_WINDOW_MS);
+    stat->awake_us_avg = stat->awake_us_avg - (stat->awake_us_avg / 8) + (stat->awake_us_last / 8);
+}
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+/**
+  * @brief Set the downlink latency budget of the application
+  *
+  * @param[in] budget_ms: 0: policy off and the setting before it restored,
+  *                       otherwise up to WIFI_PWR_POLICY_BUDGET_MAX
+  *
+  * @attention The listen interval takes effect at the next association.
+  *
+  * @return    0  : success
+  * @return    other : failed
+  */
+int wifi_pwr_policy_budget_set(uint32_t budget_ms)
+{
+    wifi_pwr_policy_stat_t *stat = &g_tWifiPwrPolicyStat;
+    osTimerDef_t timer_def;
+    T_NetStatsNetif netif;
+    wifi_ap_record_t ap;
+    uint32_t li = 0;
+
+    if(budget_ms > WIFI_PWR_POLICY_BUDGET_MAX)
+    {
+        return -1;
+    }
+
+    if(!budget_ms)
+    {
+        if(stat->budget_ms)
+        {
+            stat->budget_ms = 0;
+            osTimerStop(g_tWifiPwrPolicyTimer);
+            wifi_pwr_policy_skip_apply(stat->skip_app, 1);
+
+            if(!wifi_config_set_listen_interval_api(stat->listen_interval_app))
+            {
+                stat->listen_interval = stat->listen_interval_app;
+            }
+        }
+
+        return 0;
+    }
+
+    if(!g_tWifiPwrPolicyTimer)
+    {
+        timer_def.ptimer = wifi_pwr_policy_timeout;
+        g_tWifiPwrPolicyTimer = osTimerCreate(&timer_def, osTimerPeriodic, NULL);
+
+        if(!g_tWifiPwrPolicyTimer)
+        {
+            return -1;
+        }
+    }
+
+    if(!stat->budget_ms)
+    {
+        wifi_config_get_skip_dtim(&stat->skip_app);
+        stat->skip = stat->skip_app;
+
+        wifi_config_get_listen_interval(&stat->listen_interval_app);
+        stat->listen_interval = stat->listen_interval_app;
+
+        net_stats_netif_get(&netif);
+        g_dwWifiPwrPolicyRxPkts = netif.u32RxPkts;
+        g_dwWifiPwrPolicyTxPkts = netif.u32TxPkts;
+        g_dwWifiPwrPolicyIdle = 0;
+        g_bWifiPwrPolicyConnected = 0;
+    }
+
+    stat->budget_ms = budget_ms;
+
+    // the AP must buffer the frames for the whole wake period
+    memset(&ap, 0, sizeof(ap));
+
+    if((!wifi_sta_get_ap_info_api(&ap)) && (ap.beacon_interval))
+    {
+        li = (budget_ms * 1000) / (ap.beacon_interval * 1024);
+    }
+    else
+    {
+        // 100 TU beacon
+        li = budget_ms / 102;
+    }
+
+    if(!li)
+    {
+        li = 1;
+    }
+    else if(li > 255)
+    {
+        li = 255;
+    }
+
+    if(!wifi_config_set_listen_interval_api((uint8_t)li))
+    {
+        stat->listen_interval = (uint8_t)li;
+    }
+
+    osTimerStart(g_tWifiPwrPolicyTimer, WIFI_PWR_POLICY_WINDOW_MS);
+    return 0;
+}
+
+uint32_t wifi_pwr_policy_budget_get(void)
+{
+    return g_tWifiPwrPolicyStat.budget_ms;
+}
+
+/**
+  * @brief Wake on every DTIM for the next ms, e.g. a request is sent and
+  *        the reply is expected
+  */
+void wifi_pwr_policy_hold(uint32_t ms)
+{
+    uint32_t until = osKernelSysTick() + ms;
+
+    if((int32_t)(until - g_dwWifiPwrPolicyHoldTick) > 0)
+    {
+        g_dwWifiPwrPolicyHoldTick = until;
+    }
+}
+
+void wifi_pwr_policy_cost_set(uint32_t wake_us, uint32_t pkt_us)
+{
+    g_dwWifiPwrPolicyWakeUs = wake_us;
+    g_dwWifiPwrPolicyPktUs = pkt_us;
+}
+
+/*
+ * the estimated awake time in us of a window_ms window
+ */
+uint32_t wifi_pwr_policy_awake_estimate(uint32_t dtim_ms, uint8_t skip, uint32_t pkts, uint32_t window_ms)
+{
+    uint32_t period = dtim_ms * (skip + 1);
+    uint32_t wakes = 0;
+
+    if(!period)
+    {
+        return 0;
+    }
+
+    // rounded up, a window always has one wake at least
+    wakes = (window_ms + period - 1) / period;
+
+    return (wakes * g_dwWifiPwrPolicyWakeUs) + (pkts * g_dwWifiPwrPolicyPktUs);
+}
+
+void wifi_pwr_policy_stat_get(wifi_pwr_policy_stat_t *stat)
+{
+    memcpy(stat, &g_tWifiPwrPolicyStat, sizeof(wifi_pwr_policy_stat_t));
+}
+
+void wifi_pwr_policy_stat_reset(void)
+{
+    wifi_pwr_policy_stat_t *stat = &g_tWifiPwrPolicyStat;
+
+    stat->window = 0;
+    stat->window_active = 0;
+    stat->change = 0;
+    stat->awake_us_last = 0;
+    stat->awake_us_avg = 0;
+}
+
+static void wifi_pwr_policy_stat_dump(void)
+{
+    wifi_pwr_policy_stat_t stat;
+
+    wifi_pwr_policy_stat_get(&stat);
+
+    tracer_cli(LOG_HIGH_LEVEL, "wifipwr: budget=%u ms dtim=%u ms skip=%u/%u app=%u li=%u/%u\n",
+               stat.budget_ms, stat.dtim_ms, stat.skip, stat.skip_max, stat.skip_app,
+               stat.listen_interval, stat.listen_interval_app);
+    tracer_cli(LOG_HIGH_LEVEL, "window=%u active=%u change=%u\n", stat.window, stat.window_active, stat.change);
+    tracer_cli(LOG_HIGH_LEVEL, "awake/s: last=%u us avg=%u us (wake=%u us pkt=%u us)\n",
+               stat.awake_us_last, stat.awake_us_avg, g_dwWifiPwrPolicyWakeUs, g_dwWifiPwrPolicyPktUs);
+}
+
+/*
+ * awake time and worst latency for each skip, for the packet rate given
+ */
+static void wifi_pwr_policy_curve_dump(uint32_t pkts)
+{
+    uint32_t dtim_ms = g_tWifiPwrPolicyStat.dtim_ms;
+    uint32_t skip = 0;
+    uint32_t i = 0;
+
+    if(!dtim_ms)
+    {
+        dtim_ms = wifi_pwr_policy_dtim_ms();
+    }
+
+    if(!dtim_ms)
+    {
+        // 100 TU beacon, DTIM 1
+        dtim_ms = 102;
+    }
+
+    tracer_cli(LOG_HIGH_LEVEL, "wifipwr: dtim=%u ms pkt/s=%u\n", dtim_ms, pkts);
+    tracer_cli(LOG_HIGH_LEVEL, "  skip  latency_ms  awake_us/s\n");
+
+    for(i = 0; i < WIFI_PWR_POLICY_CURVE_NUM; i++)
+    {
+        skip = (1 << i) - 1;
+
+        if(skip > WIFI_MAX_SKIP_DTIM_PERIODS_PATCH)
+        {
+            break;
+        }
+
+        tracer_cli(LOG_HIGH_LEVEL, "  %4u  %10u  %10u\n", skip, dtim_ms * (skip + 1),
+                   wifi_pwr_policy_awake_estimate(dtim_ms, (uint8_t)skip, pkts, 1000));
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   wifi_pwr_policy_cmd
+*
+* DESCRIPTION:
+*   diag command: wifipwr [stat|reset|budget <ms>|hold <ms>|cost <wake_us> <pkt_us>|curve [pkt/s]]
+*
+*   budget 0 turns the policy off
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void wifi_pwr_policy_cmd(char *sCmd)
+{
+    char *baParam[WIFI_PWR_POLICY_PARAM_MAX + 1] = {0};
+    uint32_t num = 0;
+
+    num = ParseParam(sCmd, baParam, WIFI_PWR_POLICY_PARAM_MAX + 1);
+
+    if((num < 2) || (!strcmp(baParam[1], "stat")))
+    {
+        wifi_pwr_policy_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "reset"))
+    {
+        wifi_pwr_policy_stat_reset();
+        tracer_cli(LOG_HIGH_LEVEL, "wifipwr: reset=1\n");
+    }
+    else if((!strcmp(baParam[1], "budget")) && (num >= 3))
+    {
+        if(wifi_pwr_policy_budget_set(strtoul(baParam[2], NULL, 0)))
+        {
+            tracer_cli(LOG_HIGH_LEVEL, "wifipwr: invalid, budget 0 ~ %u ms\n", WIFI_PWR_POLICY_BUDGET_MAX);
+        }
+        else
+        {
+            wifi_pwr_policy_stat_dump();
+        }
+    }
+    else if((!strcmp(baParam[1], "hold")) && (num >= 3))
+    {
+        wifi_pwr_policy_hold(strtoul(baParam[2], NULL, 0));
+        tracer_cli(LOG_HIGH_LEVEL, "wifipwr: hold=1\n");
+    }
+    else if((!strcmp(baParam[1], "cost")) && (num >= 4))
+    {
+        wifi_pwr_policy_cost_set(strtoul(baParam[2], NULL, 0), strtoul(baParam[3], NULL, 0));
+        tracer_cli(LOG_HIGH_LEVEL, "wifipwr: wake=%u us pkt=%u us\n", g_dwWifiPwrPolicyWakeUs, g_dwWifiPwrPolicyPktUs);
+    }
+    else if(!strcmp(baParam[1], "curve"))
+    {
+        wifi_pwr_policy_curve_dump((num >= 3) ? strtoul(baParam[2], NULL, 0) : 0);
+    }
+    else
+    {
+        tracer_cli(LOG_HIGH_LEVEL, "usage: wifipwr [stat|reset|budget <ms>|hold <ms>|cost <wake_us> <pkt_us>|curve [pkt/s]]\n");
+    }
+}
@@ -0,0 +1,83 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#ifndef __WIFI_PWR_POLICY_H__
+#define __WIFI_PWR_POLICY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Adaptive DTIM skipping for the connected STA.
+ *
+ * The application declares the downlink latency it can take (the budget).
+ * Every window the netif counters are checked: with traffic, or a TX in the
+ * last linger time (a reply is expected), or an application hold, the STA
+ * wakes on every DTIM. After that every idle window doubles the wake period,
+ * up to the longest one inside the budget. The skip count goes to M0 through
+ * the share memory and is not written to flash; the listen interval that
+ * covers the budget is set for the next association. Turning the policy
+ * off restores the skip count and the listen interval it found.
+ *
+ * The awake time is an estimate: wakes * wake_us + packets * pkt_us.
+ */
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+#define WIFI_PWR_POLICY_WINDOW_MS       1000
+#define WIFI_PWR_POLICY_LINGER_MS       2000    // keep every DTIM after a TX
+#define WIFI_PWR_POLICY_BUDGET_MAX      30000   // ms
+
+#define WIFI_PWR_POLICY_WAKE_US_DEF     3000    // beacon RX, including the XTAL start
+#define WIFI_PWR_POLICY_PKT_US_DEF      1000    // per data frame
+
+/******************************************************
+ *                    Structures
+ ******************************************************/
+typedef struct {
+    uint32_t budget_ms;                     /**< 0: policy off */
+    uint32_t dtim_ms;                       /**< DTIM period of the AP */
+    uint8_t skip;                           /**< DTIMs skipped now */
+    uint8_t skip_max;                       /**< the most the budget allows */
+    uint8_t listen_interval;                /**< in beacons, for the next association */
+    uint8_t skip_app;                       /**< the setting before the policy */
+    uint8_t listen_interval_app;            /**< the listen interval before the policy */
+    uint32_t window;                        /**< windows evaluated while connected */
+    uint32_t window_active;                 /**< windows with traffic, linger or hold */
+    uint32_t change;                        /**< skip updates sent to M0 */
+    uint32_t awake_us_last;                 /**< estimated awake time of the last window */
+    uint32_t awake_us_avg;                  /**< moving average of 1/8 */
+} wifi_pwr_policy_stat_t;
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+int wifi_pwr_policy_budget_set(uint32_t budget_ms);
+uint32_t wifi_pwr_policy_budget_get(void);
+void wifi_pwr_policy_hold(uint32_t ms);
+void wifi_pwr_policy_cost_set(uint32_t wake_us, uint32_t pkt_us);
+uint32_t wifi_pwr_policy_awake_estimate(uint32_t dtim_ms, uint8_t skip, uint32_t pkts, uint32_t window_ms);
+
+void wifi_pwr_policy_stat_get(wifi_pwr_policy_stat_t *stat);
+void wifi_pwr_policy_stat_reset(void);
+
+void wifi_pwr_policy_cmd(char *sCmd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WIFI_PWR_POLICY_H__ */
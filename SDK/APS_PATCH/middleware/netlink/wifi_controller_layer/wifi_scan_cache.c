@@ -0,0 +1,659 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmsis_os.h"
+#include "sys_common.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "wifi_event.h"
+#include "wifi_api_if.h"
+#include "wifi_event_handler_if.h"
+#include "wifi_scan_cache.h"
+
+/******************************************************
+ *                    Macros
+ ******************************************************/
+#define WIFI_SCAN_CACHE_CRIT_ENTER(x)   do { x = __get_PRIMASK(); __disable_irq(); } while(0)
+#define WIFI_SCAN_CACHE_CRIT_EXIT(x)    __set_PRIMASK(x)
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+#define WIFI_SCAN_CACHE_RSSI_NONE       (-127)
+
+#define WIFI_SCAN_CACHE_PATH_NONE       0
+#define WIFI_SCAN_CACHE_PATH_FAST       1
+#define WIFI_SCAN_CACHE_PATH_FULL       2
+
+#define WIFI_SCAN_CACHE_PARAM_MAX       3
+
+/******************************************************
+ *               Global Variables
+ ******************************************************/
+// keep the original handler for the warm boot
+RET_DATA wifi_event_process_handler_fp_t g_fpWifiScanCacheEvent;
+
+static wifi_scan_cache_entry_t g_taWifiScanCache[WIFI_SCAN_CACHE_NUM];
+static uint32_t g_dwWifiScanCacheAge = WIFI_SCAN_CACHE_AGE_DEF;
+
+static wifi_scan_cache_stat_t g_tWifiScanCacheStat;
+
+// the pending wifi_scan_cache_connect, for the time to associate
+static uint32_t g_dwWifiScanCacheConnTick = 0;
+static uint8_t g_bWifiScanCacheConnPath = WIFI_SCAN_CACHE_PATH_NONE;
+
+/******************************************************
+ *               Static Functions
+ ******************************************************/
+static uint8_t wifi_scan_cache_expired(const wifi_scan_cache_entry_t *entry, uint32_t now)
+{
+    return ((now - entry->tick) > (g_dwWifiScanCacheAge * 1000)) ? 1 : 0;
+}
+
+static void wifi_scan_cache_put(const uint8_t *ssid, uint8_t ssid_length, const uint8_t *bssid,
+                                uint8_t channel, int8_t rssi, wifi_auth_mode_t auth_mode, uint32_t now)
+{
+    wifi_scan_cache_entry_t *entry = NULL;
+    uint32_t oldest = 0;
+    uint32_t mask = 0;
+    uint8_t found = 0;
+    int i = 0;
+
+    if((!ssid_length) || (ssid_length >= WIFI_MAX_LENGTH_OF_SSID) || (!channel))
+    {
+        // hidden or invalid
+        return;
+    }
+
+    // tick 0 is the unused entry
+    if(!now)
+    {
+        now = 1;
+    }
+
+    WIFI_SCAN_CACHE_CRIT_ENTER(mask);
+
+    for(i = 0; i < WIFI_SCAN_CACHE_NUM; i++)
+    {
+        if((g_taWifiScanCache[i].tick) &&
+           (!memcmp(g_taWifiScanCache[i].bssid, bssid, WIFI_MAC_ADDRESS_LENGTH)))
+        {
+            entry = &g_taWifiScanCache[i];
+            found = 1;
+            break;
+        }
+    }
+
+    if(!entry)
+    {
+        // a free entry, or the oldest one
+        for(i = 0; i < WIFI_SCAN_CACHE_NUM; i++)
+        {
+            if(!g_taWifiScanCache[i].tick)
+            {
+                entry = &g_taWifiScanCache[i];
+                break;
+            }
+
+            if((!entry) || ((now - g_taWifiScanCache[i].tick) > oldest))
+            {
+                entry = &g_taWifiScanCache[i];
+                oldest = now - g_taWifiScanCache[i].tick;
+            }
+        }
+    }
+
+    memset(entry->ssid, 0, sizeof(entry->ssid));
+    memcpy(entry->ssid, ssid, ssid_length);
+    entry->ssid_length = ssid_length;
+    memcpy(entry->bssid, bssid, WIFI_MAC_ADDRESS_LENGTH);
+    entry->channel = channel;
+    entry->auth_mode = auth_mode;
+    entry->tick = now;
+
+    // no rssi in the event, keep the one of the same BSSID
+    if((rssi != WIFI_SCAN_CACHE_RSSI_NONE) || (!found))
+    {
+        entry->rssi = rssi;
+    }
+
+    WIFI_SCAN_CACHE_CRIT_EXIT(mask);
+}
+
+static void wifi_scan_cache_hit_update(uint8_t hit)
+{
+    wifi_scan_cache_stat_t *stat = &g_tWifiScanCacheStat;
+
+    // moving average of 1/8
+    stat->hit_rate -= (stat->hit_rate / 8);
+
+    if(hit)
+    {
+        stat->hit_rate += (WIFI_SCAN_CACHE_RATE_ONE / 8);
+    }
+
+    if(stat->hit_rate > WIFI_SCAN_CACHE_RATE_ONE)
+    {
+        stat->hit_rate = WIFI_SCAN_CACHE_RATE_ONE;
+    }
+
+    stat->dwell = WIFI_SCAN_CACHE_DWELL_MAX -
+                  (((WIFI_SCAN_CACHE_DWELL_MAX - WIFI_SCAN_CACHE_DWELL_MIN) * stat->hit_rate) / WIFI_SCAN_CACHE_RATE_ONE);
+}
+
+/*
+ * read the last scan list into the cache, and pick the strongest AP of the
+ * configured SSID (and BSSID)
+ */
+static uint8_t wifi_scan_cache_pick(const wifi_sta_config_t *sta, uint8_t ssid_length, uint8_t *bssid)
+{
+    wifi_scan_list_t *list = NULL;
+    wifi_scan_info_t *info = NULL;
+    int best_rssi = WIFI_SCAN_CACHE_RSSI_NONE - 1;
+    uint8_t found = 0;
+    int i = 0;
+
+    list = (wifi_scan_list_t *)malloc(sizeof(wifi_scan_list_t));
+
+    if(!list)
+    {
+        goto done;
+    }
+
+    memset(list, 0, sizeof(wifi_scan_list_t));
+
+    if(wifi_scan_get_ap_list_api(list))
+    {
+        goto done;
+    }
+
+    if(list->num > WIFI_MAX_SCAN_AP_NUM)
+    {
+        list->num = WIFI_MAX_SCAN_AP_NUM;
+    }
+
+    wifi_scan_cache_update(list->ap_record, (uint16_t)list->num);
+
+    for(i = 0; i < list->num; i++)
+    {
+        info = &(list->ap_record[i]);
+
+        if((info->ssid_length != ssid_length) || (memcmp(info->ssid, sta->ssid, ssid_length)))
+        {
+            continue;
+        }
+
+        if((sta->bssid_present) && (memcmp(info->bssid, sta->bssid, WIFI_MAC_ADDRESS_LENGTH)))
+        {
+            continue;
+        }
+
+        if(info->rssi > best_rssi)
+        {
+            best_rssi = info->rssi;
+            memcpy(bssid, info->bssid, WIFI_MAC_ADDRESS_LENGTH);
+            found = 1;
+        }
+    }
+
+done:
+    if(list)
+    {
+        free(list);
+    }
+
+    return found;
+}
+
+/*
+ * the replacement of wifi_event_process_handler
+ */
+static int wifi_scan_cache_event(wifi_event_t event, uint8_t *payload, uint32_t length)
+{
+    wifi_event_sta_connected_t *conn = NULL;
+    wifi_scan_list_t *list = NULL;
+    uint32_t now = osKernelSysTick();
+    uint32_t elapsed = 0;
+
+    if(event == WIFI_EVENT_SCAN_COMPLETE)
+    {
+        list = (wifi_scan_list_t *)malloc(sizeof(wifi_scan_list_t));
+
+        if(list)
+        {
+            memset(list, 0, sizeof(wifi_scan_list_t));
+
+            if((!wifi_scan_get_ap_list_api(list)) && (list->num <= WIFI_MAX_SCAN_AP_NUM))
+            {
+                wifi_scan_cache_update(list->ap_record, (uint16_t)list->num);
+            }
+
+            free(list);
+        }
+    }
+    else if((event == WIFI_EVENT_STA_CONNECTED) && (payload) && (length >= sizeof(wifi_event_sta_connected_t)))
+    {
+        conn = (wifi_event_sta_connected_t *)payload;
+
+        wifi_scan_cache_put(conn->ssid, conn->ssid_len, conn->bssid, conn->channel,
+                            WIFI_SCAN_CACHE_RSSI_NONE, conn->authmode, now);
+
+        if(g_bWifiScanCacheConnPath != WIFI_SCAN_CACHE_PATH_NONE)
+        {
+            elapsed = now - g_dwWifiScanCacheConnTick;
+
+            g_tWifiScanCacheStat.assoc_ms_last = elapsed;
+
+            if(elapsed > g_tWifiScanCacheStat.assoc_ms_max)
+            {
+                g_tWifiScanCacheStat.assoc_ms_max = elapsed;
+            }
+
+            if(g_bWifiScanCacheConnPath == WIFI_SCAN_CACHE_PATH_FAST)
+            {
+                g_tWifiScanCacheStat.assoc_fast += 1;
+            }
+            else
+            {
+                g_tWifiScanCacheStat.assoc_full += 1;
+            }
+
+            g_bWifiScanCacheConnPath = WIFI_SCAN_CACHE_PATH_NONE;
+        }
+    }
+
+    return g_fpWifiScanCacheEvent(event, payload, length);
+}
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+/*
+ * hook the wifi event handler, the cache starts empty
+ */
+void wifi_scan_cache_init(void)
+{
+    if(wifi_event_process_handler_api != wifi_scan_cache_event)
+    {
+        g_fpWifiScanCacheEvent = wifi_event_process_handler_api;
+        wifi_event_process_handler_api = wifi_scan_cache_event;
+    }
+
+    memset(g_taWifiScanCache, 0, sizeof(g_taWifiScanCache));
+    wifi_scan_cache_stat_reset();
+}
+
+void wifi_scan_cache_update(const wifi_scan_info_t *ap_records, uint16_t number)
+{
+    uint32_t now = osKernelSysTick();
+    uint16_t i = 0;
+
+    for(i = 0; i < number; i++)
+    {
+        wifi_scan_cache_put(ap_records[i].ssid, ap_records[i].ssid_length, ap_records[i].bssid,
+                            ap_records[i].channel, (int8_t)ap_records[i].rssi, ap_records[i].auth_mode, now);
+    }
+}
+
+/*
+ * ssid: NULL for all the entries
+ *
+ * return the number of the entries copied, the strongest first
+ */
+int wifi_scan_cache_find(const uint8_t *ssid, uint8_t ssid_length, wifi_scan_cache_entry_t *entry, int max)
+{
+    wifi_scan_cache_entry_t *cache = NULL;
+    uint32_t now = osKernelSysTick();
+    uint32_t mask = 0;
+    int num = 0;
+    int i = 0;
+    int j = 0;
+
+    WIFI_SCAN_CACHE_CRIT_ENTER(mask);
+
+    for(i = 0; i < WIFI_SCAN_CACHE_NUM; i++)
+    {
+        cache = &g_taWifiScanCache[i];
+
+        if(!cache->tick)
+        {
+            continue;
+        }
+
+        if(wifi_scan_cache_expired(cache, now))
+        {
+            cache->tick = 0;
+            g_tWifiScanCacheStat.expired += 1;
+            continue;
+        }
+
+        if((ssid) && ((cache->ssid_length != ssid_length) || (memcmp(cache->ssid, ssid, ssid_length))))
+        {
+            continue;
+        }
+
+        // insert by rssi
+        for(j = num; j > 0; j--)
+        {
+            if(entry[j - 1].rssi >= cache->rssi)
+            {
+                break;
+            }
+
+            if(j < max)
+            {
+                entry[j] = entry[j - 1];
+            }
+        }
+
+        if(j < max)
+        {
+            entry[j] = *cache;
+
+            if(num < max)
+            {
+                num++;
+            }
+        }
+    }
+
+    WIFI_SCAN_CACHE_CRIT_EXIT(mask);
+
+    return num;
+}
+
+void wifi_scan_cache_clear(void)
+{
+    uint32_t mask = 0;
+
+    WIFI_SCAN_CACHE_CRIT_ENTER(mask);
+    memset(g_taWifiScanCache, 0, sizeof(g_taWifiScanCache));
+    WIFI_SCAN_CACHE_CRIT_EXIT(mask);
+}
+
+int wifi_scan_cache_age_set(uint32_t sec)
+{
+    if((!sec) || (sec > WIFI_SCAN_CACHE_AGE_MAX))
+    {
+        return -1;
+    }
+
+    g_dwWifiScanCacheAge = sec;
+    return 0;
+}
+
+uint32_t wifi_scan_cache_age_get(void)
+{
+    return g_dwWifiScanCacheAge;
+}
+
+/**
+  * @brief Connect to the AP of config, probing the cached channels first
+  *
+  * The channels of the SSID (or of the BSSID, if bssid_present) are scanned
+  * one by one, the strongest first. When none of them has the AP, one full
+  * scan is done. The AP found is connected by its BSSID; when there is none,
+  * config is handed to wifi_connection_connect as it is.
+  *
+  * @param[in] config: the STA configuration, not modified
+  *
+  * @return    the return value of wifi_connection_connect
+  */
+int wifi_scan_cache_connect(wifi_config_t *config)
+{
+    wifi_scan_cache_entry_t entry[WIFI_SCAN_CACHE_NUM];
+    wifi_config_t conn;
+    wifi_scan_config_t scan;
+    uint8_t ssid[WIFI_MAX_LENGTH_OF_SSID] = {0};
+    uint8_t channel[WIFI_SCAN_CACHE_CH_MAX] = {0};
+    uint8_t bssid[WIFI_MAC_ADDRESS_LENGTH] = {0};
+    uint8_t ssid_length = 0;
+    uint8_t ch_num = 0;
+    uint8_t found = 0;
+    int num = 0;
+    int ret = 0;
+    int i = 0;
+    int j = 0;
+
+    if(!config)
+    {
+        return -1;
+    }
+
+    memcpy(&conn, config, sizeof(wifi_config_t));
+
+    ssid_length = conn.sta_config.ssid_length;
+
+    if((!ssid_length) || (ssid_length >= WIFI_MAX_LENGTH_OF_SSID))
+    {
+        ssid_length = (uint8_t)strnlen((char *)conn.sta_config.ssid, WIFI_MAX_LENGTH_OF_SSID - 1);
+    }
+
+    memcpy(ssid, conn.sta_config.ssid, ssid_length);
+
+    g_tWifiScanCacheStat.connect += 1;
+    g_dwWifiScanCacheConnTick = osKernelSysTick();
+    g_bWifiScanCacheConnPath = WIFI_SCAN_CACHE_PATH_NONE;
+
+    // the cached channels, the strongest first
+    num = wifi_scan_cache_find(ssid, ssid_length, entry, WIFI_SCAN_CACHE_NUM);
+
+    for(i = 0; (i < num) && (ch_num < WIFI_SCAN_CACHE_CH_MAX); i++)
+    {
+        if((conn.sta_config.bssid_present) &&
+           (memcmp(entry[i].bssid, conn.sta_config.bssid, WIFI_MAC_ADDRESS_LENGTH)))
+        {
+            continue;
+        }
+
+        for(j = 0; j < ch_num; j++)
+        {
+            if(channel[j] == entry[i].channel)
+            {
+                break;
+            }
+        }
+
+        if(j == ch_num)
+        {
+            channel[ch_num++] = entry[i].channel;
+        }
+    }
+
+    memset(&scan, 0, sizeof(scan));
+    scan.ssid = ssid;
+    scan.bssid = (conn.sta_config.bssid_present) ? conn.sta_config.bssid : NULL;
+    scan.scan_type = WIFI_SCAN_TYPE_ACTIVE;
+
+    for(i = 0; i < ch_num; i++)
+    {
+        scan.channel = channel[i];
+        scan.scan_time.active.min = WIFI_SCAN_CACHE_DWELL_MIN;
+        scan.scan_time.active.max = g_tWifiScanCacheStat.dwell;
+
+        g_tWifiScanCacheStat.probe += 1;
+
+        if(wifi_scan_start_api(&scan, true))
+        {
+            continue;
+        }
+
+        found = wifi_scan_cache_pick(&conn.sta_config, ssid_length, bssid);
+        wifi_scan_cache_hit_update(found);
+
+        if(found)
+        {
+            g_tWifiScanCacheStat.probe_hit += 1;
+            g_bWifiScanCacheConnPath = WIFI_SCAN_CACHE_PATH_FAST;
+            goto connect;
+        }
+    }
+
+    // all channels, the default dwell
+    g_tWifiScanCacheStat.full_scan += 1;
+    g_bWifiScanCacheConnPath = WIFI_SCAN_CACHE_PATH_FULL;
+
+    scan.channel = 0;
+    memset(&scan.scan_time, 0, sizeof(scan.scan_time));
+
+    if(!wifi_scan_start_api(&scan, true))
+    {
+        found = wifi_scan_cache_pick(&conn.sta_config, ssid_length, bssid);
+
+        if(found)
+        {
+            g_tWifiScanCacheStat.full_hit += 1;
+        }
+    }
+
+connect:
+    if(found)
+    {
+        memcpy(conn.sta_config.bssid, bssid, WIFI_MAC_ADDRESS_LENGTH);
+        conn.sta_config.bssid_present = 1;
+    }
+
+    ret = wifi_connection_connect_api(&conn);
+
+    if(ret)
+    {
+        // no STA_CONNECTED will follow: do not time the next connection by this call
+        g_bWifiScanCacheConnPath = WIFI_SCAN_CACHE_PATH_NONE;
+    }
+
+    return ret;
+}
+
+void wifi_scan_cache_stat_get(wifi_scan_cache_stat_t *stat)
+{
+    memcpy(stat, &g_tWifiScanCacheStat, sizeof(wifi_scan_cache_stat_t));
+}
+
+void wifi_scan_cache_stat_reset(void)
+{
+    memset(&g_tWifiScanCacheStat, 0, sizeof(wifi_scan_cache_stat_t));
+
+    // start from 50%
+    g_tWifiScanCacheStat.hit_rate = WIFI_SCAN_CACHE_RATE_ONE / 2;
+    g_tWifiScanCacheStat.dwell = (WIFI_SCAN_CACHE_DWELL_MIN + WIFI_SCAN_CACHE_DWELL_MAX) / 2;
+}
+
+static void wifi_scan_cache_list_dump(void)
+{
+    wifi_scan_cache_entry_t entry[WIFI_SCAN_CACHE_NUM];
+    uint32_t now = osKernelSysTick();
+    int num = 0;
+    int i = 0;
+
+    num = wifi_scan_cache_find(NULL, 0, entry, WIFI_SCAN_CACHE_NUM);
+
+    tracer_cli(LOG_HIGH_LEVEL, "scancache: num=%d age=%u s\n", num, g_dwWifiScanCacheAge);
+
+    for(i = 0; i < num; i++)
+    {
+        tracer_cli(LOG_HIGH_LEVEL, "  %02x:%02x:%02x:%02x:%02x:%02x ch=%2u rssi=%4d auth=%d seen=%u s %s\n",
+                   entry[i].bssid[0], entry[i].bssid[1], entry[i].bssid[2],
+                   entry[i].bssid[3], entry[i].bssid[4], entry[i].bssid[5],
+                   entry[i].channel, entry[i].rssi, entry[i].auth_mode,
+                   (now - entry[i].tick) / 1000, entry[i].ssid);
+    }
+}
+
+static void wifi_scan_cache_stat_dump(void)
+{
+    wifi_scan_cache_stat_t stat;
+
+    wifi_scan_cache_stat_get(&stat);
+
+    tracer_cli(LOG_HIGH_LEVEL, "scancache: connect=%u probe=%u hit=%u full=%u full_hit=%u expired=%u\n",
+               stat.connect, stat.probe, stat.probe_hit, stat.full_scan, stat.full_hit, stat.expired);
+    tracer_cli(LOG_HIGH_LEVEL, "hit_rate=%u%% dwell=%u ms\n",
+               (stat.hit_rate * 100) / WIFI_SCAN_CACHE_RATE_ONE, stat.dwell);
+    tracer_cli(LOG_HIGH_LEVEL, "assoc: fast=%u full=%u last=%u ms max=%u ms\n",
+               stat.assoc_fast, stat.assoc_full, stat.assoc_ms_last, stat.assoc_ms_max);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   wifi_scan_cache_cmd
+*
+* DESCRIPTION:
+*   diag command: scancache [list|stat|reset|clear|age <sec>|connect]
+*
+*   connect: wifi_scan_cache_connect with the STA configuration
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void wifi_scan_cache_cmd(char *sCmd)
+{
+    char *baParam[WIFI_SCAN_CACHE_PARAM_MAX + 1] = {0};
+    wifi_config_t config;
+    uint32_t num = 0;
+    int ret = 0;
+
+    num = ParseParam(sCmd, baParam, WIFI_SCAN_CACHE_PARAM_MAX + 1);
+
+    if((num < 2) || (!strcmp(baParam[1], "list")))
+    {
+        wifi_scan_cache_list_dump();
+    }
+    else if(!strcmp(baParam[1], "stat"))
+    {
+        wifi_scan_cache_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "reset"))
+    {
+        wifi_scan_cache_stat_reset();
+        tracer_cli(LOG_HIGH_LEVEL, "scancache: reset=1\n");
+    }
+    else if(!strcmp(baParam[1], "clear"))
+    {
+        wifi_scan_cache_clear();
+        tracer_cli(LOG_HIGH_LEVEL, "scancache: clear=1\n");
+    }
+    else if((!strcmp(baParam[1], "age")) && (num >= 3))
+    {
+        if(wifi_scan_cache_age_set(strtoul(baParam[2], NULL, 0)))
+        {
+            tracer_cli(LOG_HIGH_LEVEL, "scancache: invalid, age 1 ~ %u s\n", WIFI_SCAN_CACHE_AGE_MAX);
+        }
+        else
+        {
+            tracer_cli(LOG_HIGH_LEVEL, "scancache: age=%u s\n", wifi_scan_cache_age_get());
+        }
+    }
+    else if(!strcmp(baParam[1], "connect"))
+    {
+        memset(&config, 0, sizeof(config));
+
+        if(wifi_get_config_api(WIFI_MODE_STA, &config))
+        {
+            tracer_cli(LOG_HIGH_LEVEL, "scancache: no STA config\n");
+            return;
+        }
+
+        ret = wifi_scan_cache_connect(&config);
+        tracer_cli(LOG_HIGH_LEVEL, "scancache: connect=%d\n", ret);
+    }
+    else
+    {
+        tracer_cli(LOG_HIGH_LEVEL, "usage: scancache [list|stat|reset|clear|age <sec>|connect]\n");
+    }
+}
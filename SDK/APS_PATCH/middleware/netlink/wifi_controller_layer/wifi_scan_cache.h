@@ -0,0 +1,100 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#ifndef __WIFI_SCAN_CACHE_H__
+#define __WIFI_SCAN_CACHE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "wifi_types.h"
+#include "wifi_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Scan result cache and channel-targeted reconnect.
+ *
+ * Every scan list read through wifi_scan_get_ap_list/wifi_scan_get_ap_records
+ * and every STA_CONNECTED event is recorded per BSSID. wifi_scan_cache_connect
+ * probes only the channels cached for the SSID before it falls back to a full
+ * scan. The dwell time of the probe follows the hit rate of the past probes:
+ * the more probes hit, the shorter the dwell.
+ */
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+#define WIFI_SCAN_CACHE_NUM             8
+#define WIFI_SCAN_CACHE_CH_MAX          3       // channels probed before the full scan
+
+#define WIFI_SCAN_CACHE_AGE_DEF         300     // sec
+#define WIFI_SCAN_CACHE_AGE_MAX         86400   // sec
+
+#define WIFI_SCAN_CACHE_DWELL_MIN       20      // ms, active scan per channel
+#define WIFI_SCAN_CACHE_DWELL_MAX       120     // ms
+
+#define WIFI_SCAN_CACHE_RATE_ONE        256     // hit rate 100%
+
+/******************************************************
+ *                    Structures
+ ******************************************************/
+typedef struct {
+    uint8_t ssid[WIFI_MAX_LENGTH_OF_SSID];
+    uint8_t ssid_length;
+    uint8_t bssid[WIFI_MAC_ADDRESS_LENGTH];
+    uint8_t channel;
+    int8_t rssi;
+    wifi_auth_mode_t auth_mode;
+    uint32_t tick;                          /**< osKernelSysTick of the last update, 0: unused */
+} wifi_scan_cache_entry_t;
+
+typedef struct {
+    uint32_t connect;                       /**< wifi_scan_cache_connect calls */
+    uint32_t probe;                         /**< channel probes */
+    uint32_t probe_hit;                     /**< probes found the AP */
+    uint32_t full_scan;                     /**< fell back to the full scan */
+    uint32_t full_hit;
+    uint32_t expired;                       /**< entries dropped by the age */
+    uint32_t hit_rate;                      /**< moving average, WIFI_SCAN_CACHE_RATE_ONE = 100% */
+    uint32_t dwell;                         /**< ms, the dwell of the next probe */
+    uint32_t assoc_ms_last;                 /**< wifi_scan_cache_connect to STA_CONNECTED */
+    uint32_t assoc_ms_max;
+    uint32_t assoc_fast;                    /**< connected after a probe hit */
+    uint32_t assoc_full;                    /**< connected after the full scan */
+} wifi_scan_cache_stat_t;
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+void wifi_scan_cache_init(void);
+
+void wifi_scan_cache_update(const wifi_scan_info_t *ap_records, uint16_t number);
+int wifi_scan_cache_find(const uint8_t *ssid, uint8_t ssid_length, wifi_scan_cache_entry_t *entry, int max);
+void wifi_scan_cache_clear(void);
+
+int wifi_scan_cache_age_set(uint32_t sec);
+uint32_t wifi_scan_cache_age_get(void);
+
+int wifi_scan_cache_connect(wifi_config_t *config);
+
+void wifi_scan_cache_stat_get(wifi_scan_cache_stat_t *stat);
+void wifi_scan_cache_stat_reset(void);
+
+void wifi_scan_cache_cmd(char *sCmd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WIFI_SCAN_CACHE_H__ */
@@ -0,0 +1,636 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmsis_os.h"
+#include "sys_os_config_patch.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "hal_tick.h"
+
+#include "lwip/opt.h"
+#include "lwip/sockets.h"
+#include "lwip/sys.h"
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+
+#include "mem_if_patch.h"
+#include "lwip_bench.h"
+
+
+#define LWIP_BENCH_PARAM_MAX            4
+
+#define LWIP_BENCH_LOG(...)             tracer_cli(LOG_HIGH_LEVEL, __VA_ARGS__)
+
+typedef struct
+{
+    int s32ListenSock;
+    uint32_t u32Bytes;
+    uint32_t u32EndTick;
+    int s32Result;
+    sys_sem_t tDone;
+} T_LwipBenchServer;
+
+static T_LwipBenchServer g_tLwipBenchServer;
+static uint8_t g_u8LwipBenchServerLive;   // server task of a timed out run not joined yet
+static uint8_t g_u8aLwipBenchBuf[LWIP_BENCH_TPUT_CHUNK_DEF];
+
+
+static uint32_t lwip_bench_tick_now(void)
+{
+    uint32_t u32Curr = 0;
+
+    Hal_Tick_DiffEx(0, &u32Curr);
+    return u32Curr;
+}
+
+static uint32_t lwip_bench_tick_to_us(uint32_t u32Ticks)
+{
+    uint32_t u32PerMs = Hal_Tick_PerMilliSec();
+
+    if(!u32PerMs)
+    {
+        return 0;
+    }
+
+    return (uint32_t)(((uint64_t)u32Ticks * 1000) / u32PerMs);
+}
+
+static int lwip_bench_sock_timeout(int s32Sock, uint32_t u32Ms)
+{
+    int s32Tmo = (int)u32Ms;
+
+    if(lwip_setsockopt(s32Sock, SOL_SOCKET, SO_RCVTIMEO, &s32Tmo, sizeof(s32Tmo)))
+    {
+        return -1;
+    }
+
+    if(lwip_setsockopt(s32Sock, SOL_SOCKET, SO_SNDTIMEO, &s32Tmo, sizeof(s32Tmo)))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static void lwip_bench_loopback_addr(struct sockaddr_in *ptAddr, uint16_t u16Port)
+{
+    memset(ptAddr, 0, sizeof(*ptAddr));
+    ptAddr->sin_len = sizeof(*ptAddr);
+    ptAddr->sin_family = AF_INET;
+    ptAddr->sin_port = htons(u16Port);
+    ptAddr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+/*
+ * Sink side of the throughput test: accept one connection and drain it until
+ * the peer closes. The end tick is taken here, so the measured time covers
+ * the data actually delivered to the application and not just queued.
+ */
+static void lwip_bench_server_task(void *argument)
+{
+    T_LwipBenchServer *ptSrv = (T_LwipBenchServer *)argument;
+    uint8_t u8aBuf[256];
+    int s32Sock = -1;
+    int s32Len = 0;
+
+    ptSrv->s32Result = -1;
+
+    s32Sock = lwip_accept(ptSrv->s32ListenSock, NULL, NULL);
+
+    if(s32Sock < 0)
+    {
+        goto done;
+    }
+
+    lwip_bench_sock_timeout(s32Sock, LWIP_BENCH_TIMEOUT_MS);
+
+    while(1)
+    {
+        s32Len = lwip_recv(s32Sock, u8aBuf, sizeof(u8aBuf), 0);
+
+        if(s32Len <= 0)
+        {
+            break;
+        }
+
+        ptSrv->u32Bytes += (uint32_t)s32Len;
+    }
+
+    ptSrv->u32EndTick = osKernelSysTick();
+
+    if(s32Len == 0)
+    {
+        ptSrv->s32Result = 0;
+    }
+
+done:
+    if(s32Sock >= 0)
+    {
+        lwip_close(s32Sock);
+    }
+
+    sys_sem_signal(&ptSrv->tDone);
+    vTaskDelete(NULL);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   lwip_bench_tput_run
+*
+* DESCRIPTION:
+*   Send u32Total bytes over a TCP connection to 127.0.0.1 and measure the
+*   time until the receiving task has read all of it.
+*
+* PARAMETERS
+*   u32Total :  [IN] total bytes to send
+*   u32Chunk :  [IN] bytes per lwip_send() call (<= LWIP_BENCH_TPUT_CHUNK_DEF)
+*   ptRes :     [OUT] result
+*
+* RETURNS
+*   0 : success
+*   -1 : fail
+*
+*************************************************************************/
+int lwip_bench_tput_run(uint32_t u32Total, uint32_t u32Chunk, T_LwipBenchTput *ptRes)
+{
+    T_LwipBenchServer *ptSrv = &g_tLwipBenchServer;
+    osThreadDef_t tTaskDef;
+    struct sockaddr_in tAddr;
+    int s32Sock = -1;
+    int s32Opt = 1;
+    int s32Len = 0;
+    uint32_t u32Sent = 0;
+    uint32_t u32Start = 0;
+    uint32_t u32Send = 0;
+    int iRet = -1;
+    uint8_t u8SemReady = 0;
+
+    if((!ptRes) || (!u32Total) || (!u32Chunk) || (u32Chunk > sizeof(g_u8aLwipBenchBuf)))
+    {
+        goto done;
+    }
+
+    memset(ptRes, 0, sizeof(*ptRes));
+
+    if(g_u8LwipBenchServerLive)
+    {
+        // join it first: it still uses g_tLwipBenchServer and its semaphore
+        if(sys_arch_sem_wait(&ptSrv->tDone, LWIP_BENCH_TIMEOUT_MS * 2) == SYS_ARCH_TIMEOUT)
+        {
+            goto done;
+        }
+
+        sys_sem_free(&ptSrv->tDone);
+        g_u8LwipBenchServerLive = 0;
+    }
+
+    memset(ptSrv, 0, sizeof(*ptSrv));
+    ptSrv->s32ListenSock = -1;
+
+    if(sys_sem_new(&ptSrv->tDone, 0) != ERR_OK)
+    {
+        goto done;
+    }
+
+    u8SemReady = 1;
+
+    ptSrv->s32ListenSock = lwip_socket(AF_INET, SOCK_STREAM, 0);
+
+    if(ptSrv->s32ListenSock < 0)
+    {
+        goto done;
+    }
+
+    lwip_setsockopt(ptSrv->s32ListenSock, SOL_SOCKET, SO_REUSEADDR, &s32Opt, sizeof(s32Opt));
+    lwip_bench_loopback_addr(&tAddr, LWIP_BENCH_PORT);
+
+    if(lwip_bind(ptSrv->s32ListenSock, (struct sockaddr *)&tAddr, sizeof(tAddr)))
+    {
+        goto done;
+    }
+
+    if(lwip_listen(ptSrv->s32ListenSock, 1))
+    {
+        goto done;
+    }
+
+    tTaskDef.name = OS_TASK_NAME_LWIP_BENCH;
+    tTaskDef.stacksize = OS_TASK_STACK_SIZE_LWIP_BENCH;
+    tTaskDef.tpriority = OS_TASK_PRIORITY_LWIP_BENCH;
+    tTaskDef.pthread = lwip_bench_server_task;
+
+    if(osThreadCreate(&tTaskDef, (void *)ptSrv) == NULL)
+    {
+        goto done;
+    }
+
+    s32Sock = lwip_socket(AF_INET, SOCK_STREAM, 0);
+
+    if(s32Sock < 0)
+    {
+        goto wait_server;
+    }
+
+    lwip_bench_sock_timeout(s32Sock, LWIP_BENCH_TIMEOUT_MS);
+    lwip_setsockopt(s32Sock, IPPROTO_TCP, TCP_NODELAY, &s32Opt, sizeof(s32Opt));
+
+    if(lwip_connect(s32Sock, (struct sockaddr *)&tAddr, sizeof(tAddr)))
+    {
+        goto wait_server;
+    }
+
+    memset(g_u8aLwipBenchBuf, 0xA5, sizeof(g_u8aLwipBenchBuf));
+    u32Start = osKernelSysTick();
+
+    while(u32Sent < u32Total)
+    {
+        u32Send = u32Total - u32Sent;
+
+        if(u32Send > u32Chunk)
+        {
+            u32Send = u32Chunk;
+        }
+
+        s32Len = lwip_send(s32Sock, g_u8aLwipBenchBuf, u32Send, 0);
+
+        if(s32Len <= 0)
+        {
+            break;
+        }
+
+        u32Sent += (uint32_t)s32Len;
+    }
+
+wait_server:
+    if(s32Sock >= 0)
+    {
+        lwip_close(s32Sock);
+        s32Sock = -1;
+    }
+
+    // also unblocks the accept() of the server task if connect() failed
+    lwip_close(ptSrv->s32ListenSock);
+    ptSrv->s32ListenSock = -1;
+
+    if(sys_arch_sem_wait(&ptSrv->tDone, LWIP_BENCH_TIMEOUT_MS * 2) == SYS_ARCH_TIMEOUT)
+    {
+        // the server task still owns the semaphore, the next run joins it
+        g_u8LwipBenchServerLive = 1;
+        u8SemReady = 0;
+        goto done;
+    }
+
+    if((ptSrv->s32Result) || (u32Sent != u32Total) || (ptSrv->u32Bytes != u32Total))
+    {
+        goto done;
+    }
+
+    ptRes->u32Bytes = ptSrv->u32Bytes;
+    ptRes->u32TimeMs = (ptSrv->u32EndTick - u32Start) * portTICK_PERIOD_MS;
+
+    if(!ptRes->u32TimeMs)
+    {
+        ptRes->u32TimeMs = 1;
+    }
+
+    ptRes->u32Kbps = (uint32_t)(((uint64_t)ptRes->u32Bytes * 8) / ptRes->u32TimeMs);
+
+    iRet = 0;
+
+done:
+    if(ptSrv->s32ListenSock >= 0)
+    {
+        lwip_close(ptSrv->s32ListenSock);
+        ptSrv->s32ListenSock = -1;
+    }
+
+    if(u8SemReady)
+    {
+        sys_sem_free(&ptSrv->tDone);
+    }
+
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   lwip_bench_latency_run
+*
+* DESCRIPTION:
+*   UDP ping-pong between two sockets bound to 127.0.0.1 in the calling
+*   task. Each round is send A->B, echo B->A, so one sample is two full
+*   trips through the stack and the tcpip thread.
+*
+* PARAMETERS
+*   u32Rounds : [IN] number of round trips
+*   u32Size :   [IN] datagram size (<= LWIP_BENCH_LAT_SIZE_MAX)
+*   ptRes :     [OUT] result
+*
+* RETURNS
+*   0 : success
+*   -1 : fail
+*
+*************************************************************************/
+int lwip_bench_latency_run(uint32_t u32Rounds, uint32_t u32Size, T_LwipBenchLatency *ptRes)
+{
+    struct sockaddr_in tAddrA;
+    struct sockaddr_in tAddrB;
+    struct sockaddr_in tFrom;
+    socklen_t tFromLen = 0;
+    int s32SockA = -1;
+    int s32SockB = -1;
+    int s32Len = 0;
+    uint32_t u32Start = 0;
+    uint32_t u32Us = 0;
+    uint64_t u64Sum = 0;
+    uint32_t u32Ok = 0;
+    uint32_t i = 0;
+    int iRet = -1;
+
+    if((!ptRes) || (!u32Rounds) || (!u32Size) || (u32Size > LWIP_BENCH_LAT_SIZE_MAX)
+       || (u32Size > sizeof(g_u8aLwipBenchBuf)))
+    {
+        goto done;
+    }
+
+    memset(ptRes, 0, sizeof(*ptRes));
+    ptRes->u32MinUs = 0xFFFFFFFF;
+
+    s32SockA = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+    s32SockB = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+
+    if((s32SockA < 0) || (s32SockB < 0))
+    {
+        goto done;
+    }
+
+    lwip_bench_loopback_addr(&tAddrA, LWIP_BENCH_PORT + 1);
+    lwip_bench_loopback_addr(&tAddrB, LWIP_BENCH_PORT + 2);
+
+    if((lwip_bind(s32SockA, (struct sockaddr *)&tAddrA, sizeof(tAddrA)))
+       || (lwip_bind(s32SockB, (struct sockaddr *)&tAddrB, sizeof(tAddrB))))
+    {
+        goto done;
+    }
+
+    lwip_bench_sock_timeout(s32SockA, 100);
+    lwip_bench_sock_timeout(s32SockB, 100);
+
+    memset(g_u8aLwipBenchBuf, 0x5A, u32Size);
+
+    for(i = 0; i < u32Rounds; i++)
+    {
+        u32Start = lwip_bench_tick_now();
+
+        if(lwip_sendto(s32SockA, g_u8aLwipBenchBuf, u32Size, 0, (struct sockaddr *)&tAddrB, sizeof(tAddrB)) != (int)u32Size)
+        {
+            ptRes->u32Lost++;
+            continue;
+        }
+
+        tFromLen = sizeof(tFrom);
+        s32Len = lwip_recvfrom(s32SockB, g_u8aLwipBenchBuf, u32Size, 0, (struct sockaddr *)&tFrom, &tFromLen);
+
+        if(s32Len <= 0)
+        {
+            ptRes->u32Lost++;
+            continue;
+        }
+
+        if(lwip_sendto(s32SockB, g_u8aLwipBenchBuf, s32Len, 0, (struct sockaddr *)&tFrom, tFromLen) != s32Len)
+        {
+            ptRes->u32Lost++;
+            continue;
+        }
+
+        if(lwip_recv(s32SockA, g_u8aLwipBenchBuf, u32Size, 0) <= 0)
+        {
+            ptRes->u32Lost++;
+            continue;
+        }
+
+        u32Us = lwip_bench_tick_to_us(Hal_Tick_Diff(u32Start));
+
+        if(u32Us < ptRes->u32MinUs)
+        {
+            ptRes->u32MinUs = u32Us;
+        }
+
+        if(u32Us > ptRes->u32MaxUs)
+        {
+            ptRes->u32MaxUs = u32Us;
+        }
+
+        u64Sum += u32Us;
+        u32Ok++;
+    }
+
+    ptRes->u32Rounds = u32Rounds;
+
+    if(!u32Ok)
+    {
+        ptRes->u32MinUs = 0;
+        goto done;
+    }
+
+    ptRes->u32AvgUs = (uint32_t)(u64Sum / u32Ok);
+
+    iRet = 0;
+
+done:
+    if(s32SockA >= 0)
+    {
+        lwip_close(s32SockA);
+    }
+
+    if(s32SockB >= 0)
+    {
+        lwip_close(s32SockB);
+    }
+
+    return iRet;
+}
+
+void lwip_bench_mem_get(T_LwipBenchMem *ptMem)
+{
+    uint32_t i = 0;
+
+    if(!ptMem)
+    {
+        return;
+    }
+
+    memset(ptMem, 0, sizeof(*ptMem));
+
+    ptMem->u32HeapFree = xPortGetFreeHeapSize();
+    ptMem->u32HeapMinEver = xPortGetMinimumEverFreeHeapSize();
+
+#if MEM_STATS
+    ptMem->u32MemUsed = lwip_stats.mem.used;
+    ptMem->u32MemMax = lwip_stats.mem.max;
+    ptMem->u32MemErr = lwip_stats.mem.err;
+#endif
+
+#if MEMP_STATS
+    for(i = 0; i < MEMP_MAX; i++)
+    {
+        if(lwip_stats.memp[i])
+        {
+            ptMem->u32MempErr += lwip_stats.memp[i]->err;
+        }
+    }
+#else
+    (void)i;
+#endif
+}
+
+/*
+ * All outputs are "key=value" lines prefixed by the section, so a host
+ * script can diff runs of different lwipopts.h builds directly.
+ */
+static void lwip_bench_cfg_dump(void)
+{
+    LWIP_BENCH_LOG("cfg: MEM_LIBC_MALLOC=%d MEM_USE_POOLS=%d MEMP_MEM_MALLOC=%d MEM_SIZE=%d\n",
+                   MEM_LIBC_MALLOC, MEM_USE_POOLS, MEMP_MEM_MALLOC, MEM_SIZE);
+    LWIP_BENCH_LOG("cfg: TCP_MSS=%d TCP_WND=%d TCP_SND_BUF=%d TCP_SND_QUEUELEN=%d\n",
+                   TCP_MSS, TCP_WND, TCP_SND_BUF, TCP_SND_QUEUELEN);
+    LWIP_BENCH_LOG("cfg: LWIP_MEM_PATCH_MODE=%d LWIP_MEM_PATCH_OVERFLOW_CHECK=%d\n",
+                   LWIP_MEM_PATCH_MODE, LWIP_MEM_PATCH_OVERFLOW_CHECK);
+    LWIP_BENCH_LOG("cfg: MEMP_NUM_PBUF=%d MEMP_NUM_TCP_PCB=%d MEMP_NUM_TCP_SEG=%d PBUF_POOL_SIZE=%d\n",
+                   MEMP_NUM_PBUF, MEMP_NUM_TCP_PCB, MEMP_NUM_TCP_SEG, PBUF_POOL_SIZE);
+}
+
+static void lwip_bench_mem_dump(void)
+{
+    T_LwipBenchMem tMem;
+    uint32_t i = 0;
+
+    lwip_bench_mem_get(&tMem);
+
+    LWIP_BENCH_LOG("mem: heap_free=%u heap_min=%u mem_used=%u mem_max=%u mem_err=%u memp_err=%u\n",
+                   tMem.u32HeapFree, tMem.u32HeapMinEver, tMem.u32MemUsed,
+                   tMem.u32MemMax, tMem.u32MemErr, tMem.u32MempErr);
+
+#if MEMP_STATS
+    for(i = 0; i < MEMP_MAX; i++)
+    {
+        const struct stats_mem *ptStat = lwip_stats.memp[i];
+
+        if(!ptStat)
+        {
+            continue;
+        }
+
+        LWIP_BENCH_LOG("memp: name=%s avail=%u used=%u max=%u err=%u\n",
+                       ptStat->name ? ptStat->name : "-",
+                       (uint32_t)ptStat->avail, (uint32_t)ptStat->used,
+                       (uint32_t)ptStat->max, (uint32_t)ptStat->err);
+    }
+#else
+    (void)i;
+#endif
+}
+
+static void lwip_bench_tput_cmd(uint32_t u32Total, uint32_t u32Chunk)
+{
+    T_LwipBenchTput tRes;
+
+    if(lwip_bench_tput_run(u32Total, u32Chunk, &tRes))
+    {
+        LWIP_BENCH_LOG("tput: result=fail total=%u chunk=%u\n", u32Total, u32Chunk);
+        return;
+    }
+
+    LWIP_BENCH_LOG("tput: result=ok bytes=%u time_ms=%u kbps=%u chunk=%u\n",
+                   tRes.u32Bytes, tRes.u32TimeMs, tRes.u32Kbps, u32Chunk);
+}
+
+static void lwip_bench_lat_cmd(uint32_t u32Rounds, uint32_t u32Size)
+{
+    T_LwipBenchLatency tRes;
+    int iRet = lwip_bench_latency_run(u32Rounds, u32Size, &tRes);
+
+    LWIP_BENCH_LOG("lat: result=%s rounds=%u size=%u lost=%u min_us=%u avg_us=%u max_us=%u\n",
+                   (iRet) ? "fail" : "ok", tRes.u32Rounds, u32Size, tRes.u32Lost,
+                   tRes.u32MinUs, tRes.u32AvgUs, tRes.u32MaxUs);
+}
+
+static uint32_t lwip_bench_arg(char **baParam, uint32_t u32Num, uint32_t u32Idx, uint32_t u32Def)
+{
+    if(u32Idx >= u32Num)
+    {
+        return u32Def;
+    }
+
+    return (uint32_t)strtoul(baParam[u32Idx], NULL, 0);
+}
+
+/*
+ * lwipbench cfg
+ * lwipbench mem
+ * lwipbench tput [total_bytes] [chunk_bytes]
+ * lwipbench lat [rounds] [size]
+ * lwipbench all
+ */
+void lwip_bench_cmd(char *sCmd)
+{
+    char *baParam[LWIP_BENCH_PARAM_MAX] = {0};
+    uint32_t u32Num = 0;
+
+    u32Num = ParseParam(sCmd, baParam, LWIP_BENCH_PARAM_MAX);
+
+    if(u32Num < 2)
+    {
+        goto usage;
+    }
+
+    if(!strcmp(baParam[1], "cfg"))
+    {
+        lwip_bench_cfg_dump();
+    }
+    else if(!strcmp(baParam[1], "mem"))
+    {
+        lwip_bench_mem_dump();
+    }
+    else if(!strcmp(baParam[1], "tput"))
+    {
+        lwip_bench_tput_cmd(lwip_bench_arg(baParam, u32Num, 2, LWIP_BENCH_TPUT_TOTAL_DEF),
+                            lwip_bench_arg(baParam, u32Num, 3, LWIP_BENCH_TPUT_CHUNK_DEF));
+    }
+    else if(!strcmp(baParam[1], "lat"))
+    {
+        lwip_bench_lat_cmd(lwip_bench_arg(baParam, u32Num, 2, LWIP_BENCH_LAT_ROUNDS_DEF),
+                           lwip_bench_arg(baParam, u32Num, 3, LWIP_BENCH_LAT_SIZE_DEF));
+    }
+    else if(!strcmp(baParam[1], "all"))
+    {
+        lwip_bench_cfg_dump();
+        lwip_bench_mem_dump();
+        lwip_bench_tput_cmd(LWIP_BENCH_TPUT_TOTAL_DEF, LWIP_BENCH_TPUT_CHUNK_DEF);
+        lwip_bench_lat_cmd(LWIP_BENCH_LAT_ROUNDS_DEF, LWIP_BENCH_LAT_SIZE_DEF);
+        lwip_bench_mem_dump();
+    }
+    else
+    {
+        goto usage;
+    }
+
+    return;
+
+usage:
+    LWIP_BENCH_LOG("lwipbench cfg|mem|all\n");
+    LWIP_BENCH_LOG("lwipbench tput [total_bytes] [chunk_bytes<=%d]\n", LWIP_BENCH_TPUT_CHUNK_DEF);
+    LWIP_BENCH_LOG("lwipbench lat [rounds] [size<=%d]\n", LWIP_BENCH_LAT_SIZE_MAX);
+}
@@ -0,0 +1,62 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#ifndef __LWIP_BENCH_H__
+#define __LWIP_BENCH_H__
+
+#include <stdint.h>
+
+#define LWIP_BENCH_PORT                 5101
+#define LWIP_BENCH_TPUT_TOTAL_DEF       (64 * 1024)
+#define LWIP_BENCH_TPUT_CHUNK_DEF       (1024)
+#define LWIP_BENCH_LAT_ROUNDS_DEF       (100)
+#define LWIP_BENCH_LAT_SIZE_DEF         (64)
+#define LWIP_BENCH_LAT_SIZE_MAX         (1024)
+#define LWIP_BENCH_TIMEOUT_MS           (10000)
+
+typedef struct
+{
+    uint32_t u32Bytes;
+    uint32_t u32TimeMs;
+    uint32_t u32Kbps;
+} T_LwipBenchTput;
+
+typedef struct
+{
+    uint32_t u32Rounds;
+    uint32_t u32Lost;
+    uint32_t u32MinUs;
+    uint32_t u32MaxUs;
+    uint32_t u32AvgUs;
+} T_LwipBenchLatency;
+
+typedef struct
+{
+    uint32_t u32HeapFree;
+    uint32_t u32HeapMinEver;
+    uint32_t u32MemUsed;
+    uint32_t u32MemMax;
+    uint32_t u32MemErr;
+    uint32_t u32MempErr;
+} T_LwipBenchMem;
+
+/*
+ * All benchmarks run over the loopback interface (127.0.0.1), so they only
+ * measure the stack itself with the option set it was built with
+ * (lwipopts.h / lwippools.h), not the Wi-Fi link.
+ */
+int lwip_bench_tput_run(uint32_t u32Total, uint32_t u32Chunk, T_LwipBenchTput *ptRes);
+int lwip_bench_latency_run(uint32_t u32Rounds, uint32_t u32Size, T_LwipBenchLatency *ptRes);
+void lwip_bench_mem_get(T_LwipBenchMem *ptMem);
+
+void lwip_bench_cmd(char *sCmd);
+
+#endif //#ifndef __LWIP_BENCH_H__
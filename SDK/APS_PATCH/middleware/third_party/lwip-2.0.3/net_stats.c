@@ -0,0 +1,474 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "msg.h"
+#include "diag_task.h"
+#include "at_cmd.h"
+#include "at_cmd_common.h"
+#include "at_cmd_data_process.h"
+#include "ipc.h"
+
+#include "lwip/opt.h"
+#include "lwip/sys.h"
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+
+#include "net_stats.h"
+
+
+#define NET_STATS_PARAM_MAX             2
+#define NET_STATS_LINE_SIZE             192
+
+typedef enum
+{
+    NET_STATS_OUT_CLI = 0,
+    NET_STATS_OUT_AT,
+} T_NetStatsOut;
+
+typedef struct
+{
+    uint8_t u8Out;
+    uint32_t u32Len;
+    char sLine[NET_STATS_LINE_SIZE];
+} T_NetStatsLine;
+
+#if NET_STATS_ENABLE
+T_NetStatsNetif g_tNetStatsNetif;
+#endif
+
+
+static void net_stats_line_begin(T_NetStatsLine *ptLine, uint8_t u8Out, const char *sGroup)
+{
+    ptLine->u8Out = u8Out;
+
+    if(u8Out == NET_STATS_OUT_AT)
+    {
+        ptLine->u32Len = snprintf(ptLine->sLine, NET_STATS_LINE_SIZE, "+NETSTATS:%s", sGroup);
+    }
+    else
+    {
+        ptLine->u32Len = snprintf(ptLine->sLine, NET_STATS_LINE_SIZE, "%s:", sGroup);
+    }
+}
+
+static void net_stats_line_add(T_NetStatsLine *ptLine, const char *sFmt, ...)
+{
+    va_list tArgs;
+    int iLen = 0;
+
+    if(ptLine->u32Len >= NET_STATS_LINE_SIZE - 1)
+    {
+        return;
+    }
+
+    ptLine->sLine[ptLine->u32Len++] = (ptLine->u8Out == NET_STATS_OUT_AT) ? ',' : ' ';
+
+    va_start(tArgs, sFmt);
+    iLen = vsnprintf(&ptLine->sLine[ptLine->u32Len], NET_STATS_LINE_SIZE - ptLine->u32Len, sFmt, tArgs);
+    va_end(tArgs);
+
+    if(iLen > 0)
+    {
+        ptLine->u32Len += iLen;
+    }
+
+    if(ptLine->u32Len >= NET_STATS_LINE_SIZE)
+    {
+        ptLine->u32Len = NET_STATS_LINE_SIZE - 1;
+    }
+}
+
+static void net_stats_line_end(T_NetStatsLine *ptLine)
+{
+    if(ptLine->u8Out == NET_STATS_OUT_AT)
+    {
+        msg_print_uart1("%s\r\n", ptLine->sLine);
+    }
+    else
+    {
+        tracer_cli(LOG_HIGH_LEVEL, "%s\n", ptLine->sLine);
+    }
+}
+
+#if LWIP_STATS
+static void net_stats_proto_dump(uint8_t u8Out, const char *sGroup, const struct stats_proto *ptProto)
+{
+    T_NetStatsLine tLine;
+
+    net_stats_line_begin(&tLine, u8Out, sGroup);
+    net_stats_line_add(&tLine, "xmit=%u", (uint32_t)ptProto->xmit);
+    net_stats_line_add(&tLine, "recv=%u", (uint32_t)ptProto->recv);
+    net_stats_line_add(&tLine, "fw=%u", (uint32_t)ptProto->fw);
+    net_stats_line_add(&tLine, "drop=%u", (uint32_t)ptProto->drop);
+    net_stats_line_add(&tLine, "chkerr=%u", (uint32_t)ptProto->chkerr);
+    net_stats_line_add(&tLine, "lenerr=%u", (uint32_t)ptProto->lenerr);
+    net_stats_line_add(&tLine, "memerr=%u", (uint32_t)ptProto->memerr);
+    net_stats_line_add(&tLine, "rterr=%u", (uint32_t)ptProto->rterr);
+    net_stats_line_add(&tLine, "proterr=%u", (uint32_t)ptProto->proterr);
+    net_stats_line_add(&tLine, "opterr=%u", (uint32_t)ptProto->opterr);
+    net_stats_line_add(&tLine, "err=%u", (uint32_t)ptProto->err);
+    net_stats_line_end(&tLine);
+}
+
+static void net_stats_mem_dump(uint8_t u8Out, const char *sGroup, const struct stats_mem *ptMem)
+{
+    T_NetStatsLine tLine;
+
+    net_stats_line_begin(&tLine, u8Out, sGroup);
+
+#if defined(LWIP_DEBUG) || LWIP_STATS_DISPLAY
+    if(ptMem->name)
+    {
+        net_stats_line_add(&tLine, "name=%s", ptMem->name);
+    }
+#endif
+
+    net_stats_line_add(&tLine, "avail=%u", (uint32_t)ptMem->avail);
+    net_stats_line_add(&tLine, "used=%u", (uint32_t)ptMem->used);
+    net_stats_line_add(&tLine, "max=%u", (uint32_t)ptMem->max);
+    net_stats_line_add(&tLine, "err=%u", (uint32_t)ptMem->err);
+    net_stats_line_end(&tLine);
+}
+
+static void net_stats_proto_reset(struct stats_proto *ptProto)
+{
+    memset(ptProto, 0, sizeof(*ptProto));
+}
+
+static void net_stats_mem_reset(struct stats_mem *ptMem)
+{
+    // avail/used describe the current state and are kept
+    ptMem->max = ptMem->used;
+    ptMem->err = 0;
+    ptMem->illegal = 0;
+}
+
+#if SYS_STATS
+static void net_stats_syselem_reset(struct stats_syselem *ptElem)
+{
+    ptElem->max = ptElem->used;
+    ptElem->err = 0;
+}
+#endif
+#endif //#if LWIP_STATS
+
+static void net_stats_ipc_dump(uint8_t u8Out, const char *sRing, uint32_t u32Used, uint32_t u32Size)
+{
+    T_NetStatsLine tLine;
+
+    net_stats_line_begin(&tLine, u8Out, "ipc");
+    net_stats_line_add(&tLine, "ring=%s", sRing);
+    net_stats_line_add(&tLine, "used=%u", u32Used);
+    net_stats_line_add(&tLine, "size=%u", u32Size);
+    net_stats_line_end(&tLine);
+}
+
+static void net_stats_dump(uint8_t u8Out)
+{
+    T_NetStatsNetif tNetif;
+    T_NetStatsLine tLine;
+    uint32_t u32Used = 0;
+    uint32_t u32Total = 0;
+    uint32_t i = 0;
+
+    net_stats_netif_get(&tNetif);
+
+    net_stats_line_begin(&tLine, u8Out, "netif_rx");
+    net_stats_line_add(&tLine, "pkts=%u", tNetif.u32RxPkts);
+    net_stats_line_add(&tLine, "bytes=%u", tNetif.u32RxBytes);
+    net_stats_line_add(&tLine, "nobuf=%u", tNetif.u32RxNoBuf);
+    net_stats_line_add(&tLine, "bad=%u", tNetif.u32RxBad);
+    net_stats_line_add(&tLine, "input_err=%u", tNetif.u32RxInputErr);
+    net_stats_line_add(&tLine, "unknown_type=%u", tNetif.u32RxUnknownType);
+    net_stats_line_end(&tLine);
+
+    net_stats_line_begin(&tLine, u8Out, "netif_tx");
+    net_stats_line_add(&tLine, "pkts=%u", tNetif.u32TxPkts);
+    net_stats_line_add(&tLine, "bytes=%u", tNetif.u32TxBytes);
+    net_stats_line_add(&tLine, "queue_full=%u", tNetif.u32TxQueueFull);
+    net_stats_line_add(&tLine, "retry=%u", tNetif.u32TxRetry);
+    net_stats_line_add(&tLine, "drop=%u", tNetif.u32TxDrop);
+    net_stats_line_add(&tLine, "stall=%u", tNetif.u32TxStall);
+    net_stats_line_add(&tLine, "stall_timeout=%u", tNetif.u32TxStallTimeout);
+    net_stats_line_add(&tLine, "stall_ms=%u", tNetif.u32TxStallMs);
+    net_stats_line_add(&tLine, "stall_max_ms=%u", tNetif.u32TxStallMaxMs);
+    net_stats_line_end(&tLine);
+
+#if LWIP_STATS
+#if LINK_STATS
+    net_stats_proto_dump(u8Out, "link", &lwip_stats.link);
+#endif
+#if ETHARP_STATS
+    net_stats_proto_dump(u8Out, "etharp", &lwip_stats.etharp);
+#endif
+#if IPFRAG_STATS
+    net_stats_proto_dump(u8Out, "ip_frag", &lwip_stats.ip_frag);
+#endif
+#if IP_STATS
+    net_stats_proto_dump(u8Out, "ip", &lwip_stats.ip);
+#endif
+#if ICMP_STATS
+    net_stats_proto_dump(u8Out, "icmp", &lwip_stats.icmp);
+#endif
+#if UDP_STATS
+    net_stats_proto_dump(u8Out, "udp", &lwip_stats.udp);
+#endif
+#if TCP_STATS
+    net_stats_proto_dump(u8Out, "tcp", &lwip_stats.tcp);
+#endif
+#if MEM_STATS
+    net_stats_mem_dump(u8Out, "mem", &lwip_stats.mem);
+#endif
+#if MEMP_STATS
+    for(i = 0; i < MEMP_MAX; i++)
+    {
+        if(lwip_stats.memp[i])
+        {
+            net_stats_mem_dump(u8Out, "memp", lwip_stats.memp[i]);
+        }
+    }
+#endif
+#if SYS_STATS
+    net_stats_line_begin(&tLine, u8Out, "sys");
+    net_stats_line_add(&tLine, "sem_used=%u", (uint32_t)lwip_stats.sys.sem.used);
+    net_stats_line_add(&tLine, "sem_max=%u", (uint32_t)lwip_stats.sys.sem.max);
+    net_stats_line_add(&tLine, "sem_err=%u", (uint32_t)lwip_stats.sys.sem.err);
+    net_stats_line_add(&tLine, "mutex_used=%u", (uint32_t)lwip_stats.sys.mutex.used);
+    net_stats_line_add(&tLine, "mutex_max=%u", (uint32_t)lwip_stats.sys.mutex.max);
+    net_stats_line_add(&tLine, "mutex_err=%u", (uint32_t)lwip_stats.sys.mutex.err);
+    net_stats_line_add(&tLine, "mbox_used=%u", (uint32_t)lwip_stats.sys.mbox.used);
+    net_stats_line_add(&tLine, "mbox_max=%u", (uint32_t)lwip_stats.sys.mbox.max);
+    net_stats_line_add(&tLine, "mbox_err=%u", (uint32_t)lwip_stats.sys.mbox.err);
+    net_stats_line_end(&tLine);
+#endif
+#endif //#if LWIP_STATS
+
+    // ring occupancy at the time of the query
+    u32Used = ipc_cmd_count_get(&u32Total);
+    net_stats_ipc_dump(u8Out, "cmd", u32Used, u32Total);
+
+    u32Used = ipc_evt_count_get(&u32Total);
+    net_stats_ipc_dump(u8Out, "evt", u32Used, u32Total);
+
+    u32Used = ipc_wifi_cmd_count_get(&u32Total);
+    net_stats_ipc_dump(u8Out, "wifi_cmd", u32Used, u32Total);
+
+    u32Used = ipc_wifi_evt_count_get(&u32Total);
+    net_stats_ipc_dump(u8Out, "wifi_evt", u32Used, u32Total);
+
+    net_stats_ipc_dump(u8Out, "wifi_msq_tx", ipc_wifi_msq_tx_count_get(), IPC_WIFI_MSQ_TX_BUF_NUM);
+    net_stats_ipc_dump(u8Out, "wifi_msq_rx", ipc_wifi_msq_rx_count_get(), IPC_WIFI_MSQ_RX_BUF_NUM);
+    net_stats_ipc_dump(u8Out, "wifi_aps_tx", ipc_wifi_aps_tx_count_get(), IPC_WIFI_APS_TX_BUF_NUM);
+    net_stats_ipc_dump(u8Out, "wifi_aps_rx", ipc_wifi_aps_rx_count_get(), IPC_WIFI_APS_RX_BUF_NUM);
+
+    (void)i;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   net_stats_netif_get
+*
+* DESCRIPTION:
+*   Take a copy of the Wi-Fi netif counters.
+*
+* PARAMETERS
+*   ptStat :    [OUT] counters
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void net_stats_netif_get(T_NetStatsNetif *ptStat)
+{
+#if NET_STATS_ENABLE
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    memcpy(ptStat, &g_tNetStatsNetif, sizeof(*ptStat));
+    SYS_ARCH_UNPROTECT(lev);
+#else
+    memset(ptStat, 0, sizeof(*ptStat));
+#endif
+}
+
+/*************************************************************************
+* FUNCTION:
+*   net_stats_reset
+*
+* DESCRIPTION:
+*   Clear the netif counters and the lwIP event/error counters. Gauges
+*   (avail/used) are kept and the high-water marks restart from them.
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void net_stats_reset(void)
+{
+    uint32_t i = 0;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+
+#if NET_STATS_ENABLE
+    memset(&g_tNetStatsNetif, 0, sizeof(g_tNetStatsNetif));
+#endif
+
+#if LWIP_STATS
+#if LINK_STATS
+    net_stats_proto_reset(&lwip_stats.link);
+#endif
+#if ETHARP_STATS
+    net_stats_proto_reset(&lwip_stats.etharp);
+#endif
+#if IPFRAG_STATS
+    net_stats_proto_reset(&lwip_stats.ip_frag);
+#endif
+#if IP_STATS
+    net_stats_proto_reset(&lwip_stats.ip);
+#endif
+#if ICMP_STATS
+    net_stats_proto_reset(&lwip_stats.icmp);
+#endif
+#if UDP_STATS
+    net_stats_proto_reset(&lwip_stats.udp);
+#endif
+#if TCP_STATS
+    net_stats_proto_reset(&lwip_stats.tcp);
+#endif
+#if MEM_STATS
+    net_stats_mem_reset(&lwip_stats.mem);
+#endif
+#if MEMP_STATS
+    for(i = 0; i < MEMP_MAX; i++)
+    {
+        if(lwip_stats.memp[i])
+        {
+            net_stats_mem_reset(lwip_stats.memp[i]);
+        }
+    }
+#endif
+#if SYS_STATS
+    net_stats_syselem_reset(&lwip_stats.sys.sem);
+    net_stats_syselem_reset(&lwip_stats.sys.mutex);
+    net_stats_syselem_reset(&lwip_stats.sys.mbox);
+#endif
+#endif //#if LWIP_STATS
+
+    SYS_ARCH_UNPROTECT(lev);
+
+    (void)i;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   net_stats_cmd
+*
+* DESCRIPTION:
+*   diag command: netstats [show|reset]
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void net_stats_cmd(char *sCmd)
+{
+    char *baParam[NET_STATS_PARAM_MAX + 1] = {0};
+    uint32_t u32Num = 0;
+
+    u32Num = ParseParam(sCmd, baParam, NET_STATS_PARAM_MAX + 1);
+
+    if((u32Num < 2) || (!strcmp(baParam[1], "show")))
+    {
+        net_stats_dump(NET_STATS_OUT_CLI);
+    }
+    else if(!strcmp(baParam[1], "reset"))
+    {
+        net_stats_reset();
+        tracer_cli(LOG_HIGH_LEVEL, "netstats: reset=1\n");
+    }
+    else
+    {
+        tracer_cli(LOG_HIGH_LEVEL, "usage: netstats [show|reset]\n");
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   net_stats_at_cmd
+*
+* DESCRIPTION:
+*   at+netstats? : print all counters, one +NETSTATS line per group
+*   at+netstats=0 : reset the counters
+*
+* PARAMETERS
+*   buf :       [IN] command buffer
+*   len :       [IN] command length
+*   mode :      [IN] AT command mode
+*
+* RETURNS
+*   1 : success
+*   0 : fail
+*
+*************************************************************************/
+int net_stats_at_cmd(char *buf, int len, int mode)
+{
+    int argc = 0;
+    char *argv[AT_MAX_CMD_ARGS] = {0};
+    int iRet = 0;
+
+    _at_cmd_buf_to_argc_argv(buf, &argc, argv, AT_MAX_CMD_ARGS);
+
+    switch(mode)
+    {
+        case AT_CMD_MODE_READ:
+            msg_print_uart1("\r\n");
+            net_stats_dump(NET_STATS_OUT_AT);
+            break;
+
+        case AT_CMD_MODE_SET:
+            if((argc != 2) || (atoi(argv[1]) != 0))
+            {
+                goto done;
+            }
+
+            net_stats_reset();
+            break;
+
+        default:
+            goto done;
+    }
+
+    iRet = 1;
+
+done:
+    if(iRet)
+    {
+        msg_print_uart1("\r\nOK\r\n");
+    }
+    else
+    {
+        msg_print_uart1("\r\nERROR\r\n");
+    }
+
+    return iRet;
+}
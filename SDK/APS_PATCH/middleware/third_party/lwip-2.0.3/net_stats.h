@@ -0,0 +1,76 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#ifndef __NET_STATS_H__
+#define __NET_STATS_H__
+
+#include <stdint.h>
+
+/*
+ * Runtime network statistics
+ *
+ * Collects the Wi-Fi netif counters kept by wlannetif_patch.c and reports
+ * them together with the lwIP protocol/memp counters (LWIP_STATS) and the
+ * current occupancy of the M3/M0 IPC rings.
+ *
+ * Output is one "group: key=value ..." line per group on the CLI
+ * ("netstats") and "+NETSTATS:<group>,key=value,..." lines on AT
+ * ("at+netstats?"), so both can be parsed by a script. "netstats reset" and
+ * "at+netstats=0" clear the counters.
+ */
+
+#ifndef NET_STATS_ENABLE
+#define NET_STATS_ENABLE                1
+#endif
+
+typedef struct
+{
+    // RX: ethernetif_input
+    uint32_t u32RxPkts;
+    uint32_t u32RxBytes;
+    uint32_t u32RxNoBuf;            // dropped, no pbuf for the frame
+    uint32_t u32RxBad;              // dropped, NULL, oversized or shorter than the Ethernet header
+    uint32_t u32RxInputErr;         // dropped, netif->input() (tcpip mbox) refused it
+    uint32_t u32RxUnknownType;      // dropped, ethertype not handled
+
+    // TX: low_level_output
+    uint32_t u32TxPkts;
+    uint32_t u32TxBytes;
+    uint32_t u32TxQueueFull;        // wifi_mac_tx_start() returned TX_QUEUE_FULL
+    uint32_t u32TxRetry;            // fragments sent again after waiting for TxReadySem
+    uint32_t u32TxDrop;             // fragments given up after WLANNETIF_TX_RETRY_MAX
+
+    // TxReadySem waits
+    uint32_t u32TxStall;
+    uint32_t u32TxStallTimeout;
+    uint32_t u32TxStallMs;          // total time spent waiting
+    uint32_t u32TxStallMaxMs;
+} T_NetStatsNetif;
+
+#if NET_STATS_ENABLE
+extern T_NetStatsNetif g_tNetStatsNetif;
+
+#define NET_STATS_INC(x)                (g_tNetStatsNetif.x++)
+#define NET_STATS_ADD(x, n)             (g_tNetStatsNetif.x += (n))
+#define NET_STATS_MAX(x, n)             do { if((n) > g_tNetStatsNetif.x) g_tNetStatsNetif.x = (n); } while(0)
+#else
+#define NET_STATS_INC(x)
+#define NET_STATS_ADD(x, n)
+#define NET_STATS_MAX(x, n)
+#endif
+
+void net_stats_netif_get(T_NetStatsNetif *ptStat);
+void net_stats_reset(void);
+
+void net_stats_cmd(char *sCmd);
+int net_stats_at_cmd(char *buf, int len, int mode);
+
+#endif //#ifndef __NET_STATS_H__
@@ -0,0 +1,27 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/*
+ * Static pools behind mem_malloc() for LWIP_MEM_MODE_POOLS (mem_if_patch.h).
+ *
+ * LWIP_MEM_PATCH_POOL(number of blocks, block size in bytes)
+ *
+ * Keep the entries sorted by size. The list is meant to be regenerated from
+ * a profile: build with LWIP_MEM_MODE_PROFILE, run the target workload,
+ * then paste the output of "lwipmem gen" here.
+ *
+ * No include guard: this file is expanded several times.
+ */
+
+LWIP_MEM_PATCH_POOL(6, 128)
+LWIP_MEM_PATCH_POOL(4, 256)
+LWIP_MEM_PATCH_POOL(4, 512)
+LWIP_MEM_PATCH_POOL(4, 1600)
@@ -64,6 +64,7 @@
 #include "wlannetif_patch.h"
 #include "wifi_nvm.h"
 #include "sys_common_ctrl.h"
+#include "net_stats.h"
 
 #define TX_TASK_STACKSIZE           (512)
 #ifdef LWIP_DEBUG
@@ -72,6 +73,12 @@
 #define RX_TASK_STACKSIZE           (512)
 #endif
 
+// times a fragment is offered again after TX_QUEUE_FULL before it is dropped
+#define WLANNETIF_TX_RETRY_MAX      (3)
+
+// the longest frame low_level_input() takes: 1500 bytes and the Ethernet header
+#define WLANNETIF_RX_LEN_MAX        (1514)
+
 
 struct ethernetif {
   struct eth_addr *ethaddr;
@@ -142,14 +149,32 @@ low_level_init_patch(struct netif *netif)
     /* Do whatever else is needed to initialize interface. */
 }
 
+static void
+low_level_tx_wait_patch(void)
+{
+    u32_t ms;
+
+    NET_STATS_INC(u32TxStall);
+
+    ms = sys_arch_sem_wait(&TxReadySem, 1);
+
+    if (ms == SYS_ARCH_TIMEOUT) {
+        NET_STATS_INC(u32TxStallTimeout);
+        ms = 1;
+    }
+
+    NET_STATS_ADD(u32TxStallMs, ms);
+    NET_STATS_MAX(u32TxStallMaxMs, ms);
+}
+
 static err_t
 low_level_output_patch(struct netif *netif, struct pbuf *p)
 {
     struct ethernetif *ethernetif = netif->state;
     struct pbuf *q;
-    static int full_count = 0;
-    static int write_count = 0;
     u16_t len = 0;
+    u8_t retry;
+    u8_t dropped = 0;
     LWIP_UNUSED_ARG(ethernetif);
 #if ETH_PAD_SIZE
     pbuf_header(p, -ETH_PAD_SIZE); /* drop the padding word */
@@ -158,30 +183,101 @@ low_level_output_patch(struct netif *netif, struct pbuf *p)
         #ifdef TX_PKT_DUMP
         dump_buffer(q->payload, q->len, 1);
         #endif
-        if ( TX_QUEUE_FULL == wifi_mac_tx_start(q->payload, q->len) )
-        {
-            full_count++;
-            printf("__packet_tx_task: Tx WriteCount: %d  FullCount:%d\r\n", write_count, full_count);
-            sys_arch_sem_wait(&TxReadySem, 1);
-            printf("__packet_tx_task: recevie Tx ready event to wakeup\r\n");
-        }
-        else
+        for (retry = 0; TX_QUEUE_FULL == wifi_mac_tx_start(q->payload, q->len); retry++)
         {
-            full_count = 0;
-            write_count++;
+            NET_STATS_INC(u32TxQueueFull);
+
+            if (retry >= WLANNETIF_TX_RETRY_MAX) {
+                NET_STATS_INC(u32TxDrop);
+                dropped = 1;
+                break;
+            }
+
+            low_level_tx_wait_patch();
+            NET_STATS_INC(u32TxRetry);
         }
         len = len + q->len;
     }
 #if ETH_PAD_SIZE
     pbuf_header(p, ETH_PAD_SIZE); /* reclaim the padding word */
 #endif
-    LINK_STATS_INC(link.xmit);
+    if (dropped) {
+        LINK_STATS_INC(link.drop);
+    } else {
+        NET_STATS_INC(u32TxPkts);
+        NET_STATS_ADD(u32TxBytes, len);
+        LINK_STATS_INC(link.xmit);
+    }
   return ERR_OK;
 }
+
+/**
+ * Same as the ROM ethernetif_input(), with the reason of every dropped
+ * frame counted in net_stats.
+ */
+static void
+ethernetif_input_patch(struct netif *netif, void *buf, u16_t len)
+{
+  struct eth_hdr *ethhdr;
+  struct pbuf *p;
+
+  /* the frames low_level_input() refuses, and runts it would take: the
+     ethertype below is read from the header. The entry of the MAC RX queue
+     is given back as low_level_input() does for every frame. */
+  if ((buf == NULL) || (len < SIZEOF_ETH_HDR) || (len > WLANNETIF_RX_LEN_MAX)) {
+    NET_STATS_INC(u32RxBad);
+    wifi_mac_rx_queue_first_entry_free();
+    return;
+  }
+
+  /* move received packet into a new pbuf */
+  p = low_level_input(netif, buf, len);
+  /* no packet could be read, silently ignore this */
+  if (p == NULL) {
+    NET_STATS_INC(u32RxNoBuf);
+    return;
+  }
+
+  NET_STATS_INC(u32RxPkts);
+  NET_STATS_ADD(u32RxBytes, len);
+
+  /* points to packet payload, which starts with an Ethernet header */
+  ethhdr = p->payload;
+
+  switch (htons(ethhdr->type)) {
+  /* IP or ARP packet? */
+  case ETHTYPE_IP:
+#ifdef LWIP_IPV6
+  case ETHTYPE_IPV6:
+#endif
+  case ETHTYPE_ARP:
+#if PPPOE_SUPPORT
+  /* PPPoE packet? */
+  case ETHTYPE_PPPOEDISC:
+  case ETHTYPE_PPPOE:
+#endif /* PPPOE_SUPPORT */
+    /* full packet send to tcpip_thread to process */
+    if (netif->input(p, netif)!=ERR_OK)
+     { LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
+       NET_STATS_INC(u32RxInputErr);
+       pbuf_free(p);
+       p = NULL;
+     }
+    break;
+
+  default:
+    NET_STATS_INC(u32RxUnknownType);
+    pbuf_free(p);
+    p = NULL;
+    break;
+  }
+}
+
 void lwip_load_interface_wlannetif_patch(void)
 {
     low_level_init_adpt  = low_level_init_patch;
     low_level_output_adpt = low_level_output_patch;
+    ethernetif_input_adpt = ethernetif_input_patch;
     return;
 }
 
@@ -20,6 +20,8 @@ extern void lwip_load_interface_socket_patch(void);
 
 
 /* common */
+extern void lwip_load_interface_tcp_patch(void);
+extern void lwip_load_interface_mem_patch(void);
 
 
 /* network interface */
@@ -36,5 +38,7 @@ void lwip_module_interface_init_patch(void)
 {
     lwip_load_interface_socket_patch();
     lwip_load_interface_wlannetif_patch();
+    lwip_load_interface_mem_patch();
+    lwip_load_interface_tcp_patch();
     return;
 }
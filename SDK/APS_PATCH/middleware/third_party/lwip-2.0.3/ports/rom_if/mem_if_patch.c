@@ -0,0 +1,702 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwip/opt.h"
+#include "lwip/mem.h"
+#include "lwip/memp.h"
+#include "lwip/def.h"
+#include "lwip/sys.h"
+#include "lwip/stats.h"
+#include "mem_if.h"
+
+#include "msg.h"
+#include "diag_task.h"
+#include "mem_if_patch.h"
+
+
+#define LWIP_MEM_HDR_MAGIC              0xA7
+#define LWIP_MEM_HDR_HEAP               0xFF
+#define LWIP_MEM_GUARD                  0xDEADBEEF
+
+#if LWIP_MEM_PATCH_OVERFLOW_CHECK
+#define LWIP_MEM_GUARD_SIZE             4
+#else
+#define LWIP_MEM_GUARD_SIZE             0
+#endif
+
+// header + payload + guard, the payload stays MEM_ALIGNMENT aligned
+#define LWIP_MEM_BLK_SIZE(size)         (sizeof(T_LwipMemHdr) + LWIP_MEM_ALIGN_SIZE(size) + LWIP_MEM_GUARD_SIZE)
+
+#define LWIP_MEM_PARAM_MAX              3
+#define LWIP_MEM_LOG(...)               tracer_cli(LOG_HIGH_LEVEL, __VA_ARGS__)
+
+typedef struct
+{
+    uint16_t u16Size;           // requested size
+    uint8_t u8Pool;             // pool index or LWIP_MEM_HDR_HEAP
+    uint8_t u8Magic;
+} T_LwipMemHdr;
+
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_POOLS)
+typedef struct
+{
+    uint16_t u16Num;
+    uint16_t u16Size;
+} T_LwipMemPoolCfg;
+
+typedef struct
+{
+    uint8_t *pu8Free;           // free list, linked through the first word of the payload
+    uint16_t u16Used;
+    uint16_t u16Max;
+    uint32_t u32Err;
+} T_LwipMemPool;
+
+static const T_LwipMemPoolCfg g_taLwipMemPoolCfg[] =
+{
+#define LWIP_MEM_PATCH_POOL(num, size)  { (num), (size) },
+#include "lwippools_patch.h"
+#undef LWIP_MEM_PATCH_POOL
+};
+
+#define LWIP_MEM_POOL_NUM               (sizeof(g_taLwipMemPoolCfg) / sizeof(g_taLwipMemPoolCfg[0]))
+
+static uint32_t g_u32aLwipMemArena[(0
+#define LWIP_MEM_PATCH_POOL(num, size)  + ((num) * LWIP_MEM_BLK_SIZE(size))
+#include "lwippools_patch.h"
+#undef LWIP_MEM_PATCH_POOL
+                                    + 3) / 4];
+
+static T_LwipMemPool g_taLwipMemPool[LWIP_MEM_POOL_NUM];
+#else
+#define LWIP_MEM_POOL_NUM               0
+#endif
+
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_PROFILE)
+static T_LwipMemProfBucket g_taLwipMemProf[LWIP_MEM_PROF_BUCKET_NUM];
+#endif
+
+static T_LwipMemPatchStat g_tLwipMemStat;
+
+static mem_malloc_fp_t g_fpLwipMemMallocOrig = NULL;
+static mem_free_fp_t g_fpLwipMemFreeOrig = NULL;
+
+
+#if (LWIP_MEM_PATCH_MODE != LWIP_MEM_MODE_LIBC)
+
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_PROFILE)
+static uint32_t lwip_mem_prof_bucket(uint32_t u32Size)
+{
+    uint32_t u32Idx = (u32Size) ? ((u32Size - 1) / LWIP_MEM_PROF_BUCKET_SIZE) : 0;
+
+    if(u32Idx >= LWIP_MEM_PROF_BUCKET_NUM)
+    {
+        u32Idx = LWIP_MEM_PROF_BUCKET_NUM - 1;
+    }
+
+    return u32Idx;
+}
+#endif
+
+static void *lwip_mem_hdr_fill(uint8_t *pu8Blk, uint32_t u32Size, uint8_t u8Pool)
+{
+    T_LwipMemHdr *ptHdr = (T_LwipMemHdr *)pu8Blk;
+
+    ptHdr->u16Size = (uint16_t)u32Size;
+    ptHdr->u8Pool = u8Pool;
+    ptHdr->u8Magic = LWIP_MEM_HDR_MAGIC;
+
+#if LWIP_MEM_PATCH_OVERFLOW_CHECK
+    {
+        uint32_t u32Guard = LWIP_MEM_GUARD;
+
+        // the guard may sit at an unaligned offset if size is not aligned
+        memcpy(pu8Blk + sizeof(T_LwipMemHdr) + u32Size, &u32Guard, sizeof(u32Guard));
+    }
+#endif
+
+    return (void *)(pu8Blk + sizeof(T_LwipMemHdr));
+}
+
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_POOLS)
+static void lwip_mem_pool_init(void)
+{
+    uint8_t *pu8Blk = (uint8_t *)g_u32aLwipMemArena;
+    uint32_t u32BlkSize = 0;
+    uint32_t i = 0;
+    uint32_t j = 0;
+
+    for(i = 0; i < LWIP_MEM_POOL_NUM; i++)
+    {
+        u32BlkSize = LWIP_MEM_BLK_SIZE(g_taLwipMemPoolCfg[i].u16Size);
+
+        g_taLwipMemPool[i].pu8Free = NULL;
+
+        for(j = 0; j < g_taLwipMemPoolCfg[i].u16Num; j++)
+        {
+            *(uint8_t **)(pu8Blk + sizeof(T_LwipMemHdr)) = g_taLwipMemPool[i].pu8Free;
+            g_taLwipMemPool[i].pu8Free = pu8Blk;
+            pu8Blk += u32BlkSize;
+        }
+    }
+}
+
+/*
+ * Take a block from the smallest pool that fits. If that pool is empty, try
+ * the larger ones before giving up, so a burst of one size does not go to
+ * the heap while bigger blocks are idle.
+ */
+static uint8_t *lwip_mem_pool_take(uint32_t u32Size, uint8_t *pu8Pool)
+{
+    uint8_t *pu8Blk = NULL;
+    uint8_t u8First = 1;
+    uint32_t i = 0;
+
+    for(i = 0; i < LWIP_MEM_POOL_NUM; i++)
+    {
+        if(g_taLwipMemPoolCfg[i].u16Size < u32Size)
+        {
+            continue;
+        }
+
+        pu8Blk = g_taLwipMemPool[i].pu8Free;
+
+        if(pu8Blk)
+        {
+            g_taLwipMemPool[i].pu8Free = *(uint8_t **)(pu8Blk + sizeof(T_LwipMemHdr));
+            g_taLwipMemPool[i].u16Used++;
+
+            if(g_taLwipMemPool[i].u16Used > g_taLwipMemPool[i].u16Max)
+            {
+                g_taLwipMemPool[i].u16Max = g_taLwipMemPool[i].u16Used;
+            }
+
+            if(!u8First)
+            {
+                g_tLwipMemStat.u32Fallbacks++;
+            }
+
+            *pu8Pool = (uint8_t)i;
+            return pu8Blk;
+        }
+
+        g_taLwipMemPool[i].u32Err++;
+        u8First = 0;
+    }
+
+    if(!u8First)
+    {
+        g_tLwipMemStat.u32Fallbacks++;
+    }
+
+    return NULL;
+}
+#endif
+
+static void *mem_malloc_patch(mem_size_t size)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+    uint8_t *pu8Blk = NULL;
+    uint8_t u8Pool = LWIP_MEM_HDR_HEAP;
+    uint32_t u32HeapSize = 0;
+    uint8_t u8StatErr = 1;
+
+    if((size == 0) || (size > 0xFFFF))
+    {
+        goto fail;
+    }
+
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_POOLS)
+    SYS_ARCH_PROTECT(lev);
+    pu8Blk = lwip_mem_pool_take(size, &u8Pool);
+    SYS_ARCH_UNPROTECT(lev);
+#endif
+
+    if(!pu8Blk)
+    {
+        u32HeapSize = LWIP_MEM_BLK_SIZE(size);
+        pu8Blk = (uint8_t *)g_fpLwipMemMallocOrig(u32HeapSize);
+
+        if(!pu8Blk)
+        {
+            // the ROM mem_malloc() has counted it in lwip_stats.mem.err
+            u8StatErr = 0;
+            goto fail;
+        }
+    }
+
+    SYS_ARCH_PROTECT(lev);
+
+    g_tLwipMemStat.u32Allocs++;
+
+    if(u8Pool == LWIP_MEM_HDR_HEAP)
+    {
+        g_tLwipMemStat.u32HeapAllocs++;
+        g_tLwipMemStat.u32HeapBytes += u32HeapSize;
+
+        if(g_tLwipMemStat.u32HeapBytes > g_tLwipMemStat.u32HeapBytesMax)
+        {
+            g_tLwipMemStat.u32HeapBytesMax = g_tLwipMemStat.u32HeapBytes;
+        }
+    }
+    else
+    {
+        g_tLwipMemStat.u32PoolAllocs++;
+    }
+
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_PROFILE)
+    {
+        T_LwipMemProfBucket *ptBucket = &g_taLwipMemProf[lwip_mem_prof_bucket(size)];
+
+        ptBucket->u32Allocs++;
+        ptBucket->u16Live++;
+
+        if(ptBucket->u16Live > ptBucket->u16Peak)
+        {
+            ptBucket->u16Peak = ptBucket->u16Live;
+        }
+    }
+#endif
+
+#if MEM_STATS
+    // heap blocks are added to used by the ROM mem_malloc(), only pool blocks
+    // here; the ROM does not track max
+    if(u8Pool != LWIP_MEM_HDR_HEAP)
+    {
+        lwip_stats.mem.used += size;
+    }
+
+    if(lwip_stats.mem.used > lwip_stats.mem.max)
+    {
+        lwip_stats.mem.max = lwip_stats.mem.used;
+    }
+#endif
+
+    SYS_ARCH_UNPROTECT(lev);
+
+    return lwip_mem_hdr_fill(pu8Blk, size, u8Pool);
+
+fail:
+    SYS_ARCH_PROTECT(lev);
+    g_tLwipMemStat.u32Fails++;
+#if MEM_STATS
+    if(u8StatErr)
+    {
+        lwip_stats.mem.err++;
+    }
+#endif
+    SYS_ARCH_UNPROTECT(lev);
+    return NULL;
+}
+
+static void mem_free_patch(void *rmem)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+    T_LwipMemHdr *ptHdr = NULL;
+    uint8_t *pu8Blk = NULL;
+    uint32_t u32Size = 0;
+
+    if(!rmem)
+    {
+        return;
+    }
+
+    pu8Blk = (uint8_t *)rmem - sizeof(T_LwipMemHdr);
+    ptHdr = (T_LwipMemHdr *)pu8Blk;
+
+    if((ptHdr->u8Magic != LWIP_MEM_HDR_MAGIC) ||
+       ((ptHdr->u8Pool != LWIP_MEM_HDR_HEAP) && (ptHdr->u8Pool >= LWIP_MEM_POOL_NUM)))
+    {
+        // not allocated by mem_malloc_patch, leave it to the original allocator
+        SYS_ARCH_PROTECT(lev);
+        g_tLwipMemStat.u32Illegal++;
+#if MEM_STATS
+        lwip_stats.mem.illegal++;
+#endif
+        SYS_ARCH_UNPROTECT(lev);
+
+        g_fpLwipMemFreeOrig(rmem);
+        return;
+    }
+
+    u32Size = ptHdr->u16Size;
+
+#if LWIP_MEM_PATCH_OVERFLOW_CHECK
+    {
+        uint32_t u32Guard = 0;
+
+        memcpy(&u32Guard, (uint8_t *)rmem + u32Size, sizeof(u32Guard));
+
+        if(u32Guard != LWIP_MEM_GUARD)
+        {
+            g_tLwipMemStat.u32Overflows++;
+            LWIP_PLATFORM_DIAG(("mem_free: overflow %p size %u\n", rmem, (unsigned int)u32Size));
+        }
+    }
+#endif
+
+    ptHdr->u8Magic = 0;
+
+    SYS_ARCH_PROTECT(lev);
+
+    g_tLwipMemStat.u32Frees++;
+
+#if MEM_STATS
+    // the ROM mem_free() takes heap blocks out of the stats
+    if(ptHdr->u8Pool != LWIP_MEM_HDR_HEAP)
+    {
+        lwip_stats.mem.used -= u32Size;
+    }
+#endif
+
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_PROFILE)
+    {
+        T_LwipMemProfBucket *ptBucket = &g_taLwipMemProf[lwip_mem_prof_bucket(u32Size)];
+
+        if(ptBucket->u16Live)
+        {
+            ptBucket->u16Live--;
+        }
+    }
+#endif
+
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_POOLS)
+    if(ptHdr->u8Pool != LWIP_MEM_HDR_HEAP)
+    {
+        T_LwipMemPool *ptPool = &g_taLwipMemPool[ptHdr->u8Pool];
+
+        *(uint8_t **)rmem = ptPool->pu8Free;
+        ptPool->pu8Free = pu8Blk;
+        ptPool->u16Used--;
+
+        SYS_ARCH_UNPROTECT(lev);
+        return;
+    }
+#endif
+
+    g_tLwipMemStat.u32HeapBytes -= LWIP_MEM_BLK_SIZE(u32Size);
+
+    SYS_ARCH_UNPROTECT(lev);
+
+    g_fpLwipMemFreeOrig(pu8Blk);
+}
+
+/*
+ * With MEM_LIBC_MALLOC the ROM mem_trim() returns the block unchanged, which
+ * is also right for our blocks: the header keeps the original size.
+ */
+#endif //#if (LWIP_MEM_PATCH_MODE != LWIP_MEM_MODE_LIBC)
+
+uint32_t lwip_mem_patch_mode(void)
+{
+    return LWIP_MEM_PATCH_MODE;
+}
+
+void lwip_mem_patch_stat_get(T_LwipMemPatchStat *ptStat)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    if(!ptStat)
+    {
+        return;
+    }
+
+    SYS_ARCH_PROTECT(lev);
+    memcpy(ptStat, &g_tLwipMemStat, sizeof(*ptStat));
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+uint32_t lwip_mem_patch_pool_num(void)
+{
+    return LWIP_MEM_POOL_NUM;
+}
+
+int lwip_mem_patch_pool_get(uint32_t u32Idx, T_LwipMemPoolStat *ptStat)
+{
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_POOLS)
+    if((!ptStat) || (u32Idx >= LWIP_MEM_POOL_NUM))
+    {
+        return -1;
+    }
+
+    ptStat->u16Size = g_taLwipMemPoolCfg[u32Idx].u16Size;
+    ptStat->u16Num = g_taLwipMemPoolCfg[u32Idx].u16Num;
+    ptStat->u16Used = g_taLwipMemPool[u32Idx].u16Used;
+    ptStat->u16Max = g_taLwipMemPool[u32Idx].u16Max;
+    ptStat->u32Err = g_taLwipMemPool[u32Idx].u32Err;
+    return 0;
+#else
+    (void)u32Idx;
+    (void)ptStat;
+    return -1;
+#endif
+}
+
+int lwip_mem_patch_prof_get(uint32_t u32Idx, T_LwipMemProfBucket *ptBucket)
+{
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_PROFILE)
+    if((!ptBucket) || (u32Idx >= LWIP_MEM_PROF_BUCKET_NUM))
+    {
+        return -1;
+    }
+
+    *ptBucket = g_taLwipMemProf[u32Idx];
+    return 0;
+#else
+    (void)u32Idx;
+    (void)ptBucket;
+    return -1;
+#endif
+}
+
+/*
+ * Clear the counters and peaks. Live block counts are kept, otherwise the
+ * frees of blocks allocated before the reset would underflow them.
+ */
+void lwip_mem_patch_reset(void)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+    uint32_t u32HeapBytes = 0;
+    uint32_t i = 0;
+
+    SYS_ARCH_PROTECT(lev);
+
+    u32HeapBytes = g_tLwipMemStat.u32HeapBytes;
+    memset(&g_tLwipMemStat, 0, sizeof(g_tLwipMemStat));
+    g_tLwipMemStat.u32HeapBytes = u32HeapBytes;
+    g_tLwipMemStat.u32HeapBytesMax = u32HeapBytes;
+
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_PROFILE)
+    for(i = 0; i < LWIP_MEM_PROF_BUCKET_NUM; i++)
+    {
+        g_taLwipMemProf[i].u32Allocs = 0;
+        g_taLwipMemProf[i].u16Peak = g_taLwipMemProf[i].u16Live;
+    }
+#elif (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_POOLS)
+    for(i = 0; i < LWIP_MEM_POOL_NUM; i++)
+    {
+        g_taLwipMemPool[i].u16Max = g_taLwipMemPool[i].u16Used;
+        g_taLwipMemPool[i].u32Err = 0;
+    }
+#else
+    (void)i;
+#endif
+
+#if MEM_STATS
+    lwip_stats.mem.max = lwip_stats.mem.used;
+    lwip_stats.mem.err = 0;
+    lwip_stats.mem.illegal = 0;
+#endif
+
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+static void lwip_mem_patch_stat_dump(void)
+{
+    T_LwipMemPatchStat tStat;
+    T_LwipMemPoolStat tPool;
+    uint32_t i = 0;
+
+    lwip_mem_patch_stat_get(&tStat);
+
+    LWIP_MEM_LOG("lwipmem: mode=%u overflow_check=%u allocs=%u frees=%u pool_allocs=%u heap_allocs=%u\n",
+                 LWIP_MEM_PATCH_MODE, LWIP_MEM_PATCH_OVERFLOW_CHECK, tStat.u32Allocs, tStat.u32Frees,
+                 tStat.u32PoolAllocs, tStat.u32HeapAllocs);
+    LWIP_MEM_LOG("lwipmem: fallbacks=%u fails=%u overflows=%u illegal=%u heap_bytes=%u heap_bytes_max=%u\n",
+                 tStat.u32Fallbacks, tStat.u32Fails, tStat.u32Overflows, tStat.u32Illegal,
+                 tStat.u32HeapBytes, tStat.u32HeapBytesMax);
+
+    for(i = 0; i < lwip_mem_patch_pool_num(); i++)
+    {
+        if(lwip_mem_patch_pool_get(i, &tPool))
+        {
+            break;
+        }
+
+        LWIP_MEM_LOG("pool: size=%u num=%u used=%u max=%u err=%u\n",
+                     tPool.u16Size, tPool.u16Num, tPool.u16Used, tPool.u16Max, tPool.u32Err);
+    }
+}
+
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_PROFILE)
+static uint32_t lwip_mem_patch_gen_class(uint32_t u32Peak, uint32_t u32Size, uint32_t u32Headroom)
+{
+    uint32_t u32Num = u32Peak + ((u32Peak * u32Headroom) + 99) / 100;
+
+    LWIP_MEM_LOG("LWIP_MEM_PATCH_POOL(%u, %u)\n", u32Num, u32Size);
+
+    return u32Num * LWIP_MEM_BLK_SIZE(u32Size);
+}
+#endif
+
+/*
+ * Turn the recorded profile into a pool list.
+ *
+ * Adjacent non-empty buckets are merged into one class as long as the class
+ * size stays within twice the smallest request in it. The block count of a
+ * class is the sum of the bucket peaks (an upper bound of the real peak of
+ * the class) plus the headroom.
+ */
+static void lwip_mem_patch_gen(uint32_t u32Headroom)
+{
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_PROFILE)
+    T_LwipMemProfBucket tBucket;
+    uint32_t u32Lo = 0;
+    uint32_t u32Hi = 0;
+    uint32_t u32Size = 0;
+    uint32_t u32Peak = 0;
+    uint32_t u32Classes = 0;
+    uint32_t u32Bytes = 0;
+    uint32_t i = 0;
+
+    LWIP_MEM_LOG("/* lwippools_patch.h: generated by \"lwipmem gen %u\" */\n", u32Headroom);
+
+    for(i = 0; i < LWIP_MEM_PROF_BUCKET_NUM; i++)
+    {
+        lwip_mem_patch_prof_get(i, &tBucket);
+
+        if(!tBucket.u16Peak)
+        {
+            continue;
+        }
+
+        // bucket i holds the requests of (i * 32, (i + 1) * 32] bytes
+        u32Size = (i + 1) * LWIP_MEM_PROF_BUCKET_SIZE;
+
+        if((u32Peak) && ((u32Size <= (2 * u32Lo)) || (u32Classes == (LWIP_MEM_GEN_CLASS_MAX - 1))))
+        {
+            u32Hi = u32Size;
+            u32Peak += tBucket.u16Peak;
+            continue;
+        }
+
+        if(u32Peak)
+        {
+            u32Bytes += lwip_mem_patch_gen_class(u32Peak, u32Hi, u32Headroom);
+            u32Classes++;
+        }
+
+        u32Lo = (i * LWIP_MEM_PROF_BUCKET_SIZE) + 1;
+        u32Hi = u32Size;
+        u32Peak = tBucket.u16Peak;
+    }
+
+    if(u32Peak)
+    {
+        u32Bytes += lwip_mem_patch_gen_class(u32Peak, u32Hi, u32Headroom);
+        u32Classes++;
+    }
+
+    LWIP_MEM_LOG("/* classes=%u arena_bytes=%u, requests above %u bytes are counted in the last class */\n",
+                 u32Classes, u32Bytes, (LWIP_MEM_PROF_BUCKET_NUM - 1) * LWIP_MEM_PROF_BUCKET_SIZE);
+#else
+    (void)u32Headroom;
+    LWIP_MEM_LOG("lwipmem: gen needs LWIP_MEM_PATCH_MODE = LWIP_MEM_MODE_PROFILE\n");
+#endif
+
+#if MEMP_STATS
+    {
+        uint32_t j = 0;
+
+        // memp pools are sized in ROM, report their peaks for reference only
+        for(j = 0; j < MEMP_MAX; j++)
+        {
+            if(lwip_stats.memp[j])
+            {
+                LWIP_MEM_LOG("/* memp %s: avail=%u max=%u err=%u */\n",
+                             lwip_stats.memp[j]->name ? lwip_stats.memp[j]->name : "-",
+                             (uint32_t)lwip_stats.memp[j]->avail, (uint32_t)lwip_stats.memp[j]->max,
+                             (uint32_t)lwip_stats.memp[j]->err);
+            }
+        }
+    }
+#endif
+}
+
+static void lwip_mem_patch_prof_dump(void)
+{
+    T_LwipMemProfBucket tBucket;
+    uint32_t i = 0;
+
+    for(i = 0; i < LWIP_MEM_PROF_BUCKET_NUM; i++)
+    {
+        if(lwip_mem_patch_prof_get(i, &tBucket))
+        {
+            LWIP_MEM_LOG("lwipmem: no profile in this mode\n");
+            return;
+        }
+
+        if(!tBucket.u32Allocs && !tBucket.u16Peak)
+        {
+            continue;
+        }
+
+        LWIP_MEM_LOG("prof: size_max=%u allocs=%u live=%u peak=%u\n",
+                     (i + 1) * LWIP_MEM_PROF_BUCKET_SIZE, tBucket.u32Allocs, tBucket.u16Live, tBucket.u16Peak);
+    }
+}
+
+/*
+ * lwipmem stat
+ * lwipmem prof
+ * lwipmem gen [headroom_percent]
+ * lwipmem reset
+ */
+void lwip_mem_patch_cmd(char *sCmd)
+{
+    char *baParam[LWIP_MEM_PARAM_MAX] = {0};
+    uint32_t u32Num = 0;
+
+    u32Num = ParseParam(sCmd, baParam, LWIP_MEM_PARAM_MAX);
+
+    if((u32Num < 2) || (!strcmp(baParam[1], "stat")))
+    {
+        lwip_mem_patch_stat_dump();
+    }
+    else if(!strcmp(baParam[1], "prof"))
+    {
+        lwip_mem_patch_prof_dump();
+    }
+    else if(!strcmp(baParam[1], "gen"))
+    {
+        lwip_mem_patch_gen((u32Num > 2) ? strtoul(baParam[2], NULL, 0) : LWIP_MEM_GEN_HEADROOM_DEF);
+    }
+    else if(!strcmp(baParam[1], "reset"))
+    {
+        lwip_mem_patch_reset();
+    }
+    else
+    {
+        LWIP_MEM_LOG("lwipmem stat|prof|gen [headroom_percent]|reset\n");
+    }
+}
+
+void lwip_load_interface_mem_patch(void)
+{
+#if (LWIP_MEM_PATCH_MODE != LWIP_MEM_MODE_LIBC)
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_POOLS)
+    lwip_mem_pool_init();
+#endif
+
+    g_fpLwipMemMallocOrig = mem_malloc_adpt;
+    g_fpLwipMemFreeOrig = mem_free_adpt;
+
+    mem_malloc_adpt = mem_malloc_patch;
+    mem_free_adpt = mem_free_patch;
+#else
+    (void)g_fpLwipMemMallocOrig;
+    (void)g_fpLwipMemFreeOrig;
+#endif
+    return;
+}
@@ -0,0 +1,95 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#ifndef __MEM_IF_PATCH_H__
+#define __MEM_IF_PATCH_H__
+
+#include <stdint.h>
+
+/*
+ * Allocator used behind mem_malloc()/mem_free() (pbuf RAM, netbufs, ...)
+ *
+ * LWIP_MEM_MODE_LIBC    : keep the ROM allocator (C library malloc on the
+ *                         shared FreeRTOS heap). No patch is installed.
+ * LWIP_MEM_MODE_PROFILE : still allocate from the heap, but record the peak
+ *                         number of live blocks per size bucket so that
+ *                         "lwipmem gen" can print a tuned lwippools_patch.h.
+ * LWIP_MEM_MODE_POOLS   : serve requests from the static pools listed in
+ *                         lwippools_patch.h and only fall back to the heap
+ *                         when the matching pools are exhausted (release).
+ *
+ * The memp pools (PCBs, segments, PBUF_POOL) are laid out by the ROM and
+ * cannot be resized here; "lwipmem gen" only reports their peaks.
+ */
+#define LWIP_MEM_MODE_LIBC              0
+#define LWIP_MEM_MODE_PROFILE           1
+#define LWIP_MEM_MODE_POOLS             2
+
+#ifndef LWIP_MEM_PATCH_MODE
+#define LWIP_MEM_PATCH_MODE             LWIP_MEM_MODE_LIBC
+#endif
+
+// guard word behind every block, checked in mem_free(); off for release
+#ifndef LWIP_MEM_PATCH_OVERFLOW_CHECK
+#if (LWIP_MEM_PATCH_MODE == LWIP_MEM_MODE_PROFILE)
+#define LWIP_MEM_PATCH_OVERFLOW_CHECK   1
+#else
+#define LWIP_MEM_PATCH_OVERFLOW_CHECK   0
+#endif
+#endif
+
+#define LWIP_MEM_PROF_BUCKET_SIZE       32
+#define LWIP_MEM_PROF_BUCKET_NUM        64      // the last bucket also takes the larger requests
+#define LWIP_MEM_GEN_CLASS_MAX          8
+#define LWIP_MEM_GEN_HEADROOM_DEF       25      // percent
+
+typedef struct
+{
+    uint32_t u32Allocs;
+    uint32_t u32Frees;
+    uint32_t u32PoolAllocs;
+    uint32_t u32HeapAllocs;
+    uint32_t u32Fallbacks;          // pool class empty, served by a larger class or the heap
+    uint32_t u32Fails;
+    uint32_t u32Overflows;          // guard word corrupted
+    uint32_t u32Illegal;            // mem_free() of a pointer without our header
+    uint32_t u32HeapBytes;          // bytes currently taken from the heap
+    uint32_t u32HeapBytesMax;
+} T_LwipMemPatchStat;
+
+typedef struct
+{
+    uint16_t u16Size;
+    uint16_t u16Num;
+    uint16_t u16Used;
+    uint16_t u16Max;
+    uint32_t u32Err;
+} T_LwipMemPoolStat;
+
+typedef struct
+{
+    uint32_t u32Allocs;
+    uint16_t u16Live;
+    uint16_t u16Peak;
+} T_LwipMemProfBucket;
+
+void lwip_load_interface_mem_patch(void);
+
+uint32_t lwip_mem_patch_mode(void);
+void lwip_mem_patch_stat_get(T_LwipMemPatchStat *ptStat);
+uint32_t lwip_mem_patch_pool_num(void);
+int lwip_mem_patch_pool_get(uint32_t u32Idx, T_LwipMemPoolStat *ptStat);
+int lwip_mem_patch_prof_get(uint32_t u32Idx, T_LwipMemProfBucket *ptBucket);
+void lwip_mem_patch_reset(void);
+
+void lwip_mem_patch_cmd(char *sCmd);
+
+#endif //#ifndef __MEM_IF_PATCH_H__
@@ -0,0 +1,598 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmsis_os.h"
+#include "lwip/opt.h"
+#include "lwip/tcp.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+#include "lwip/tcpip.h"
+#include "tcp_if.h"
+
+#include "msg.h"
+#include "diag_task.h"
+#include "tcp_if_patch.h"
+
+
+#define TCP_AUTOTUNE_PARAM_MAX          3
+#define TCP_AUTOTUNE_LOG(...)           tracer_cli(LOG_HIGH_LEVEL, __VA_ARGS__)
+
+#define TCP_AUTOTUNE_MSS_ROUNDUP(x)     ((((x) + TCP_MSS - 1) / TCP_MSS) * TCP_MSS)
+
+typedef struct
+{
+    T_TcpAutotuneConn tInfo;
+    struct tcp_pcb *ptPcb;
+    uint32_t u32LastRcvNxt;
+    uint32_t u32LastAck;
+    uint8_t u8Seen;
+    uint8_t u8SndLimited;       // tcp_write() used up the whole send buffer in this interval
+    uint8_t u8RxIdle;
+    uint8_t u8TxIdle;
+    uint16_t u16WantWnd;
+    uint16_t u16WantSndBuf;
+} T_TcpAutotuneEntry;
+
+static T_TcpAutotuneEntry g_taTcpAutotune[TCP_AUTOTUNE_CONN_MAX];
+static T_TcpAutotuneStat g_tTcpAutotuneStat =
+{
+    .u32Enable = TCP_AUTOTUNE_ENABLE,
+    .u32Budget = TCP_AUTOTUNE_BUDGET_DEF,
+};
+static uint8_t g_u8TcpAutotuneTick = 0;
+
+static tcp_slowtmr_fp_t g_fpTcpSlowtmrOrig = NULL;
+static tcp_recved_fp_t g_fpTcpRecvedOrig = NULL;
+static tcp_write_fp_t g_fpTcpWriteOrig = NULL;
+
+
+static T_TcpAutotuneEntry *tcp_autotune_find(struct tcp_pcb *pcb)
+{
+    uint32_t i = 0;
+
+    for(i = 0; i < TCP_AUTOTUNE_CONN_MAX; i++)
+    {
+        if((g_taTcpAutotune[i].tInfo.u8Used) && (g_taTcpAutotune[i].ptPcb == pcb))
+        {
+            return &g_taTcpAutotune[i];
+        }
+    }
+
+    return NULL;
+}
+
+static uint8_t tcp_autotune_match(T_TcpAutotuneEntry *ptEntry, struct tcp_pcb *pcb)
+{
+    // the pcb memory may have been reused by another connection between two runs
+    return ((ptEntry->tInfo.u16LocalPort == pcb->local_port) &&
+            (ptEntry->tInfo.u16RemotePort == pcb->remote_port) &&
+            (ptEntry->tInfo.u32RemoteIp == ip_2_ip4(&pcb->remote_ip)->addr));
+}
+
+static T_TcpAutotuneEntry *tcp_autotune_attach(struct tcp_pcb *pcb)
+{
+    T_TcpAutotuneEntry *ptEntry = tcp_autotune_find(pcb);
+    uint32_t i = 0;
+
+    if((ptEntry) && (tcp_autotune_match(ptEntry, pcb)))
+    {
+        return ptEntry;
+    }
+
+    if(!ptEntry)
+    {
+        for(i = 0; i < TCP_AUTOTUNE_CONN_MAX; i++)
+        {
+            if(!g_taTcpAutotune[i].tInfo.u8Used)
+            {
+                ptEntry = &g_taTcpAutotune[i];
+                break;
+            }
+        }
+
+        if(!ptEntry)
+        {
+            return NULL;
+        }
+    }
+
+    memset(ptEntry, 0, sizeof(*ptEntry));
+    ptEntry->tInfo.u8Used = 1;
+    ptEntry->tInfo.u16LocalPort = pcb->local_port;
+    ptEntry->tInfo.u16RemotePort = pcb->remote_port;
+    ptEntry->tInfo.u32RemoteIp = ip_2_ip4(&pcb->remote_ip)->addr;
+    ptEntry->tInfo.u16Wnd = TCP_AUTOTUNE_WND_MAX;
+    ptEntry->tInfo.u16SndBuf = TCP_AUTOTUNE_SND_BUF_MIN;
+    ptEntry->ptPcb = pcb;
+    ptEntry->u32LastRcvNxt = pcb->rcv_nxt;
+    ptEntry->u32LastAck = pcb->lastack;
+
+    return ptEntry;
+}
+
+/*
+ * Move the receive window and the send buffer of one connection to the
+ * targets in u16WantWnd / u16WantSndBuf.
+ */
+static void tcp_autotune_apply(T_TcpAutotuneEntry *ptEntry)
+{
+    struct tcp_pcb *pcb = ptEntry->ptPcb;
+    T_TcpAutotuneConn *ptInfo = &ptEntry->tInfo;
+    uint16_t u16Withhold = TCP_AUTOTUNE_WND_MAX - ptEntry->u16WantWnd;
+    uint16_t u16Cur = TCP_AUTOTUNE_SND_BUF_MIN + ptInfo->u16SndExtra;
+    uint16_t u16Delta = 0;
+
+    if(ptEntry->u16WantWnd > ptInfo->u16Wnd)
+    {
+        g_tTcpAutotuneStat.u32WndGrow++;
+    }
+    else if(ptEntry->u16WantWnd < ptInfo->u16Wnd)
+    {
+        g_tTcpAutotuneStat.u32WndShrink++;
+    }
+
+    ptInfo->u16Wnd = ptEntry->u16WantWnd;
+
+    // growing: give back what was held, shrinking happens lazily in tcp_recved()
+    if(ptInfo->u16Withheld > u16Withhold)
+    {
+        u16Delta = ptInfo->u16Withheld - u16Withhold;
+        ptInfo->u16Withheld = u16Withhold;
+        g_fpTcpRecvedOrig(pcb, u16Delta);
+    }
+
+    if(ptEntry->u16WantSndBuf > u16Cur)
+    {
+        u16Delta = ptEntry->u16WantSndBuf - u16Cur;
+        pcb->snd_buf += u16Delta;
+        ptInfo->u16SndExtra += u16Delta;
+        g_tTcpAutotuneStat.u32SndGrow++;
+    }
+    else if(ptEntry->u16WantSndBuf < u16Cur)
+    {
+        // only the free part of the buffer can be taken back now
+        u16Delta = u16Cur - ptEntry->u16WantSndBuf;
+
+        if(u16Delta > pcb->snd_buf)
+        {
+            u16Delta = pcb->snd_buf;
+        }
+
+        pcb->snd_buf -= u16Delta;
+        ptInfo->u16SndExtra -= u16Delta;
+
+        if(u16Delta)
+        {
+            g_tTcpAutotuneStat.u32SndShrink++;
+        }
+    }
+
+    ptInfo->u16SndBuf = TCP_AUTOTUNE_SND_BUF_MIN + ptInfo->u16SndExtra;
+}
+
+static uint8_t tcp_autotune_pressure(void)
+{
+#if MEMP_STATS
+    const struct stats_mem *ptPool = lwip_stats.memp[MEMP_PBUF_POOL];
+
+    if((ptPool) && (ptPool->avail))
+    {
+        if(((uint32_t)(ptPool->avail - ptPool->used) * 100) < ((uint32_t)ptPool->avail * TCP_AUTOTUNE_PBUF_LOW_PCT))
+        {
+            return 1;
+        }
+    }
+#endif
+
+    if(xPortGetFreeHeapSize() < TCP_AUTOTUNE_HEAP_LOW)
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * One autotuning pass, called in the tcpip thread from the slow timer.
+ *
+ * Active connections never shrink; a direction only drops back to the
+ * minimum after TCP_AUTOTUNE_IDLE_INTERVALS intervals without traffic.
+ */
+static void tcp_autotune_run(void)
+{
+    T_TcpAutotuneEntry *ptEntry = NULL;
+    struct tcp_pcb *pcb = NULL;
+    uint32_t u32IntervalMs = TCP_AUTOTUNE_INTERVAL * TCP_SLOW_INTERVAL;
+    uint32_t u32Bytes = 0;
+    uint32_t u32Bdp = 0;
+    uint32_t u32Want = 0;
+    uint32_t u32Base = 0;
+    uint32_t u32Extra = 0;
+    uint32_t u32Spare = 0;
+    uint32_t u32Sum = 0;
+    uint8_t u8Pressure = 0;
+    uint32_t i = 0;
+
+    g_tTcpAutotuneStat.u32Runs++;
+
+    for(i = 0; i < TCP_AUTOTUNE_CONN_MAX; i++)
+    {
+        g_taTcpAutotune[i].u8Seen = 0;
+    }
+
+    for(pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next)
+    {
+        if((pcb->state < ESTABLISHED) || (pcb->state > CLOSE_WAIT))
+        {
+            continue;
+        }
+
+        ptEntry = tcp_autotune_attach(pcb);
+
+        if(ptEntry)
+        {
+            ptEntry->u8Seen = 1;
+        }
+    }
+
+    u8Pressure = tcp_autotune_pressure();
+
+    if(u8Pressure)
+    {
+        g_tTcpAutotuneStat.u32Pressure++;
+    }
+
+    for(i = 0; i < TCP_AUTOTUNE_CONN_MAX; i++)
+    {
+        ptEntry = &g_taTcpAutotune[i];
+
+        if(!ptEntry->tInfo.u8Used)
+        {
+            continue;
+        }
+
+        if(!ptEntry->u8Seen)
+        {
+            // the connection is gone, nothing to restore
+            memset(ptEntry, 0, sizeof(*ptEntry));
+            continue;
+        }
+
+        pcb = ptEntry->ptPcb;
+
+        ptEntry->tInfo.u32RttMs = ((uint32_t)(pcb->sa >> 3)) * TCP_SLOW_INTERVAL;
+
+        if(ptEntry->tInfo.u32RttMs < TCP_AUTOTUNE_RTT_MIN_MS)
+        {
+            ptEntry->tInfo.u32RttMs = TCP_AUTOTUNE_RTT_MIN_MS;
+        }
+
+        // receive direction
+        u32Bytes = pcb->rcv_nxt - ptEntry->u32LastRcvNxt;
+        ptEntry->u32LastRcvNxt = pcb->rcv_nxt;
+        ptEntry->tInfo.u32RxBps = (u32Bytes * 1000) / u32IntervalMs;
+        u32Want = ptEntry->tInfo.u16Wnd;
+
+        if(u32Bytes)
+        {
+            ptEntry->u8RxIdle = 0;
+            u32Bdp = (ptEntry->tInfo.u32RxBps * ptEntry->tInfo.u32RttMs) / 1000;
+
+            if((2 * u32Bdp) > u32Want)
+            {
+                u32Want = TCP_AUTOTUNE_MSS_ROUNDUP(2 * u32Bdp);
+            }
+        }
+        else if(++ptEntry->u8RxIdle >= TCP_AUTOTUNE_IDLE_INTERVALS)
+        {
+            ptEntry->u8RxIdle = TCP_AUTOTUNE_IDLE_INTERVALS;
+            u32Want = TCP_AUTOTUNE_WND_MIN;
+        }
+
+        if(u32Want > TCP_AUTOTUNE_WND_MAX)
+        {
+            u32Want = TCP_AUTOTUNE_WND_MAX;
+        }
+
+        ptEntry->u16WantWnd = (uint16_t)u32Want;
+
+        // send direction
+        u32Bytes = pcb->lastack - ptEntry->u32LastAck;
+        ptEntry->u32LastAck = pcb->lastack;
+        ptEntry->tInfo.u32TxBps = (u32Bytes * 1000) / u32IntervalMs;
+        u32Want = ptEntry->tInfo.u16SndBuf;
+
+        if((u32Bytes) || (pcb->unsent) || (pcb->unacked))
+        {
+            ptEntry->u8TxIdle = 0;
+
+            if(ptEntry->u8SndLimited)
+            {
+                u32Bdp = (ptEntry->tInfo.u32TxBps * ptEntry->tInfo.u32RttMs) / 1000;
+                u32Want = (2 * u32Bdp > u32Want + TCP_MSS) ? (2 * u32Bdp) : (u32Want + TCP_MSS);
+            }
+        }
+        else if(++ptEntry->u8TxIdle >= TCP_AUTOTUNE_IDLE_INTERVALS)
+        {
+            ptEntry->u8TxIdle = TCP_AUTOTUNE_IDLE_INTERVALS;
+            u32Want = TCP_AUTOTUNE_SND_BUF_MIN;
+        }
+
+        if(u32Want > TCP_AUTOTUNE_SND_BUF_MAX)
+        {
+            u32Want = TCP_AUTOTUNE_SND_BUF_MAX;
+        }
+
+        ptEntry->u16WantSndBuf = (uint16_t)u32Want;
+        ptEntry->u8SndLimited = 0;
+
+        if(u8Pressure)
+        {
+            // an idle window is already at the minimum, an active one keeps room for fast retransmit
+            if(ptEntry->u16WantWnd > TCP_AUTOTUNE_WND_PRESSURE)
+            {
+                ptEntry->u16WantWnd = TCP_AUTOTUNE_WND_PRESSURE;
+            }
+
+            ptEntry->u16WantSndBuf = TCP_AUTOTUNE_SND_BUF_MIN;
+        }
+
+        u32Base += TCP_AUTOTUNE_WND_MIN + TCP_AUTOTUNE_SND_BUF_MIN;
+        u32Extra += (ptEntry->u16WantWnd - TCP_AUTOTUNE_WND_MIN) + (ptEntry->u16WantSndBuf - TCP_AUTOTUNE_SND_BUF_MIN);
+    }
+
+    // the minimum of every connection is always granted, the rest is shared
+    u32Spare = (g_tTcpAutotuneStat.u32Budget > u32Base) ? (g_tTcpAutotuneStat.u32Budget - u32Base) : 0;
+
+    if(u32Extra > u32Spare)
+    {
+        g_tTcpAutotuneStat.u32Clipped++;
+    }
+
+    for(i = 0; i < TCP_AUTOTUNE_CONN_MAX; i++)
+    {
+        ptEntry = &g_taTcpAutotune[i];
+
+        if(!ptEntry->tInfo.u8Used)
+        {
+            continue;
+        }
+
+        if(u32Extra > u32Spare)
+        {
+            u32Want = ((ptEntry->u16WantWnd - TCP_AUTOTUNE_WND_MIN) * u32Spare) / u32Extra;
+            ptEntry->u16WantWnd = TCP_AUTOTUNE_WND_MIN + (uint16_t)((u32Want / TCP_MSS) * TCP_MSS);
+
+            u32Want = ((ptEntry->u16WantSndBuf - TCP_AUTOTUNE_SND_BUF_MIN) * u32Spare) / u32Extra;
+            ptEntry->u16WantSndBuf = TCP_AUTOTUNE_SND_BUF_MIN + (uint16_t)u32Want;
+        }
+
+        tcp_autotune_apply(ptEntry);
+
+        u32Sum += ptEntry->tInfo.u16Wnd + ptEntry->tInfo.u16SndBuf;
+    }
+
+    g_tTcpAutotuneStat.u32InUse = u32Sum;
+}
+
+/*
+ * Put every connection back to TCP_WND / TCP_SND_BUF and forget it.
+ */
+static void tcp_autotune_restore(void)
+{
+    T_TcpAutotuneEntry *ptEntry = NULL;
+    struct tcp_pcb *pcb = NULL;
+
+    // only touch pcbs that are still active
+    for(pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next)
+    {
+        ptEntry = tcp_autotune_find(pcb);
+
+        if((ptEntry) && (tcp_autotune_match(ptEntry, pcb)))
+        {
+            ptEntry->u16WantWnd = TCP_AUTOTUNE_WND_MAX;
+            ptEntry->u16WantSndBuf = TCP_AUTOTUNE_SND_BUF_MIN;
+            tcp_autotune_apply(ptEntry);
+        }
+    }
+
+    memset(g_taTcpAutotune, 0, sizeof(g_taTcpAutotune));
+    g_tTcpAutotuneStat.u32InUse = 0;
+}
+
+static void tcp_slowtmr_patch(void)
+{
+    g_fpTcpSlowtmrOrig();
+
+    if(!g_tTcpAutotuneStat.u32Enable)
+    {
+        return;
+    }
+
+    if(++g_u8TcpAutotuneTick >= TCP_AUTOTUNE_INTERVAL)
+    {
+        g_u8TcpAutotuneTick = 0;
+        tcp_autotune_run();
+    }
+}
+
+static void tcp_recved_patch(struct tcp_pcb *pcb, u16_t len)
+{
+    T_TcpAutotuneEntry *ptEntry = NULL;
+    uint16_t u16Withhold = 0;
+    uint16_t u16Take = 0;
+
+    if(g_tTcpAutotuneStat.u32Enable)
+    {
+        ptEntry = tcp_autotune_find(pcb);
+    }
+
+    if((ptEntry) && (tcp_autotune_match(ptEntry, pcb)))
+    {
+        u16Withhold = TCP_AUTOTUNE_WND_MAX - ptEntry->tInfo.u16Wnd;
+
+        if(ptEntry->tInfo.u16Withheld < u16Withhold)
+        {
+            u16Take = u16Withhold - ptEntry->tInfo.u16Withheld;
+
+            if(u16Take > len)
+            {
+                u16Take = len;
+            }
+
+            ptEntry->tInfo.u16Withheld += u16Take;
+            len -= u16Take;
+        }
+    }
+
+    if(len)
+    {
+        g_fpTcpRecvedOrig(pcb, len);
+    }
+}
+
+static err_t tcp_write_patch(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags)
+{
+    T_TcpAutotuneEntry *ptEntry = NULL;
+
+    if((g_tTcpAutotuneStat.u32Enable) && (len >= pcb->snd_buf))
+    {
+        ptEntry = tcp_autotune_find(pcb);
+
+        if(ptEntry)
+        {
+            ptEntry->u8SndLimited = 1;
+        }
+    }
+
+    return g_fpTcpWriteOrig(pcb, dataptr, len, apiflags);
+}
+
+static void tcp_autotune_enable_cb(void *ctx)
+{
+    uint8_t u8Enable = (uint8_t)(uint32_t)ctx;
+
+    if((!u8Enable) && (g_tTcpAutotuneStat.u32Enable))
+    {
+        tcp_autotune_restore();
+    }
+
+    g_tTcpAutotuneStat.u32Enable = u8Enable;
+}
+
+void tcp_autotune_enable(uint8_t u8Enable)
+{
+    // the pcbs belong to the tcpip thread
+    tcpip_callback(tcp_autotune_enable_cb, (void *)(uint32_t)(u8Enable ? 1 : 0));
+}
+
+static void tcp_autotune_budget_set_cb(void *ctx)
+{
+    // the next tcp_autotune_run() shares the new budget out
+    g_tTcpAutotuneStat.u32Budget = (uint32_t)ctx;
+}
+
+void tcp_autotune_budget_set(uint32_t u32Bytes)
+{
+    // tcp_autotune_run() reads the budget in the tcpip thread
+    tcpip_callback(tcp_autotune_budget_set_cb, (void *)u32Bytes);
+}
+
+void tcp_autotune_stat_get(T_TcpAutotuneStat *ptStat)
+{
+    if(ptStat)
+    {
+        memcpy(ptStat, &g_tTcpAutotuneStat, sizeof(*ptStat));
+    }
+}
+
+int tcp_autotune_conn_get(uint32_t u32Idx, T_TcpAutotuneConn *ptConn)
+{
+    if((!ptConn) || (u32Idx >= TCP_AUTOTUNE_CONN_MAX))
+    {
+        return -1;
+    }
+
+    memcpy(ptConn, &g_taTcpAutotune[u32Idx].tInfo, sizeof(*ptConn));
+    return 0;
+}
+
+/*
+ * tcptune [stat]
+ * tcptune on|off
+ * tcptune budget <bytes>
+ */
+void tcp_autotune_cmd(char *sCmd)
+{
+    char *baParam[TCP_AUTOTUNE_PARAM_MAX] = {0};
+    T_TcpAutotuneStat tStat;
+    T_TcpAutotuneConn tConn;
+    uint32_t u32Num = 0;
+    uint32_t i = 0;
+
+    u32Num = ParseParam(sCmd, baParam, TCP_AUTOTUNE_PARAM_MAX);
+
+    if((u32Num >= 2) && (!strcmp(baParam[1], "on")))
+    {
+        tcp_autotune_enable(1);
+    }
+    else if((u32Num >= 2) && (!strcmp(baParam[1], "off")))
+    {
+        tcp_autotune_enable(0);
+    }
+    else if((u32Num >= 3) && (!strcmp(baParam[1], "budget")))
+    {
+        tcp_autotune_budget_set(strtoul(baParam[2], NULL, 0));
+    }
+    else if((u32Num >= 2) && (strcmp(baParam[1], "stat")))
+    {
+        TCP_AUTOTUNE_LOG("tcptune [stat]|on|off|budget <bytes>\n");
+        return;
+    }
+
+    tcp_autotune_stat_get(&tStat);
+
+    TCP_AUTOTUNE_LOG("tcptune: enable=%u budget=%u in_use=%u runs=%u pressure=%u clipped=%u\n",
+                     tStat.u32Enable, tStat.u32Budget, tStat.u32InUse, tStat.u32Runs,
+                     tStat.u32Pressure, tStat.u32Clipped);
+    TCP_AUTOTUNE_LOG("tcptune: wnd_grow=%u wnd_shrink=%u snd_grow=%u snd_shrink=%u wnd=[%u,%u] snd_buf=[%u,%u]\n",
+                     tStat.u32WndGrow, tStat.u32WndShrink, tStat.u32SndGrow, tStat.u32SndShrink,
+                     TCP_AUTOTUNE_WND_MIN, TCP_AUTOTUNE_WND_MAX, TCP_AUTOTUNE_SND_BUF_MIN, TCP_AUTOTUNE_SND_BUF_MAX);
+
+    for(i = 0; i < TCP_AUTOTUNE_CONN_MAX; i++)
+    {
+        if((tcp_autotune_conn_get(i, &tConn)) || (!tConn.u8Used))
+        {
+            continue;
+        }
+
+        TCP_AUTOTUNE_LOG("conn: lport=%u rport=%u rip=%08X rtt_ms=%u rx_bps=%u tx_bps=%u wnd=%u withheld=%u snd_buf=%u\n",
+                         tConn.u16LocalPort, tConn.u16RemotePort, lwip_ntohl(tConn.u32RemoteIp),
+                         tConn.u32RttMs, tConn.u32RxBps, tConn.u32TxBps,
+                         tConn.u16Wnd, tConn.u16Withheld, tConn.u16SndBuf);
+    }
+}
+
+void lwip_load_interface_tcp_patch(void)
+{
+    g_fpTcpSlowtmrOrig = tcp_slowtmr_adpt;
+    g_fpTcpRecvedOrig = tcp_recved_adpt;
+    g_fpTcpWriteOrig = tcp_write_adpt;
+
+    tcp_slowtmr_adpt = tcp_slowtmr_patch;
+    tcp_recved_adpt = tcp_recved_patch;
+    tcp_write_adpt = tcp_write_patch;
+    return;
+}
@@ -0,0 +1,91 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#ifndef __TCP_IF_PATCH_H__
+#define __TCP_IF_PATCH_H__
+
+#include <stdint.h>
+#include "lwip/opt.h"
+
+/*
+ * TCP receive window / send buffer autotuning
+ *
+ * TCP_WND and TCP_SND_BUF are fixed in ROM. The receive window of a
+ * connection is lowered by holding back part of the bytes given to
+ * tcp_recved() and raised again by releasing them. The send buffer is
+ * raised or lowered by adjusting pcb->snd_buf by the unused amount.
+ *
+ * Every TCP_AUTOTUNE_INTERVAL slow timer ticks the targets are derived
+ * from the bytes moved in the interval and the smoothed RTT, and then
+ * scaled down to fit the global budget. Under pbuf pool or heap pressure
+ * the send buffers drop to the minimum and the receive windows of active
+ * connections to TCP_AUTOTUNE_WND_PRESSURE: with fewer than four segments
+ * in flight a loss gets no three duplicate ACKs and waits for the RTO.
+ */
+#ifndef TCP_AUTOTUNE_ENABLE
+#define TCP_AUTOTUNE_ENABLE             1
+#endif
+
+#define TCP_AUTOTUNE_INTERVAL           2           // in TCP_SLOW_INTERVAL (500 ms) ticks
+#define TCP_AUTOTUNE_CONN_MAX           MEMP_NUM_TCP_PCB
+
+#define TCP_AUTOTUNE_WND_MIN            (2 * TCP_MSS)
+#define TCP_AUTOTUNE_WND_MAX            TCP_WND
+#define TCP_AUTOTUNE_WND_PRESSURE       LWIP_MIN(4 * TCP_MSS, TCP_WND)
+#define TCP_AUTOTUNE_SND_BUF_MIN        TCP_SND_BUF
+// tcp_write() is also limited by TCP_SND_QUEUELEN pbufs, more buffer than this is never used
+#define TCP_AUTOTUNE_SND_BUF_MAX        ((TCP_SND_QUEUELEN / 2) * TCP_MSS)
+
+#define TCP_AUTOTUNE_BUDGET_DEF         (24 * 1024)  // sum of windows and send buffers, bytes
+#define TCP_AUTOTUNE_RTT_MIN_MS         100         // floor for the coarse lwIP RTT estimate
+#define TCP_AUTOTUNE_IDLE_INTERVALS     3           // shrink to the minimum after this many idle intervals
+#define TCP_AUTOTUNE_PBUF_LOW_PCT       25          // pbuf pool free below this is pressure
+#define TCP_AUTOTUNE_HEAP_LOW           (8 * 1024)  // heap free below this is pressure
+
+typedef struct
+{
+    uint8_t u8Used;
+    uint16_t u16LocalPort;
+    uint16_t u16RemotePort;
+    uint32_t u32RemoteIp;
+    uint32_t u32RttMs;
+    uint32_t u32RxBps;
+    uint32_t u32TxBps;
+    uint16_t u16Wnd;            // current receive window target
+    uint16_t u16SndBuf;         // current send buffer target
+    uint16_t u16Withheld;       // bytes held back from tcp_recved()
+    uint16_t u16SndExtra;       // bytes added to snd_buf above TCP_SND_BUF
+} T_TcpAutotuneConn;
+
+typedef struct
+{
+    uint32_t u32Enable;
+    uint32_t u32Budget;
+    uint32_t u32InUse;          // sum of the targets after the last run
+    uint32_t u32Runs;
+    uint32_t u32Pressure;       // runs under pbuf/heap pressure
+    uint32_t u32Clipped;        // runs where the budget clipped the demand
+    uint32_t u32WndGrow;
+    uint32_t u32WndShrink;
+    uint32_t u32SndGrow;
+    uint32_t u32SndShrink;
+} T_TcpAutotuneStat;
+
+void lwip_load_interface_tcp_patch(void);
+
+void tcp_autotune_enable(uint8_t u8Enable);
+void tcp_autotune_budget_set(uint32_t u32Bytes);
+void tcp_autotune_stat_get(T_TcpAutotuneStat *ptStat);
+int tcp_autotune_conn_get(uint32_t u32Idx, T_TcpAutotuneConn *ptConn);
+
+void tcp_autotune_cmd(char *sCmd);
+
+#endif //#ifndef __TCP_IF_PATCH_H__
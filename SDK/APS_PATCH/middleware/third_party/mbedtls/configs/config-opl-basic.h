@@ -53,10 +53,12 @@
 #define MBEDTLS_ASN1_PARSE_C
 #define MBEDTLS_ASN1_WRITE_C
 #define MBEDTLS_BIGNUM_C
+#define MBEDTLS_CCM_C
 #define MBEDTLS_CIPHER_C
 #define MBEDTLS_CTR_DRBG_C
 #define MBEDTLS_DES_C
 #define MBEDTLS_ENTROPY_C
+#define MBEDTLS_GCM_C
 #define MBEDTLS_MD_C
 #define MBEDTLS_MD5_C
 #define MBEDTLS_NET_C
@@ -104,6 +106,9 @@
 #define MBEDTLS_OPL
 #define MBEDTLS_THREADING_FREERTOS
 
+/* AES-128 CCM/GCM records on the SCRT engine, see port/scrt_aead.c */
+#define MBEDTLS_SCRT_AEAD
+
 
 /* enable SHA512 for home_ref_design requirement */
 #define MBEDTLS_SHA512_C
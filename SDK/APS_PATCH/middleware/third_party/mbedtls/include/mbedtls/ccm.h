@@ -37,6 +37,10 @@ extern "C" {
  */
 typedef struct {
     mbedtls_cipher_context_t cipher_ctx;    /*!< cipher context used */
+#if defined(MBEDTLS_SCRT_AEAD)
+    unsigned char scrt_key[16];             /*!< AES-128 key for the SCRT engine */
+    int scrt_key_set;                       /*!< scrt_key is valid */
+#endif
 }
 mbedtls_ccm_context;
 
@@ -150,6 +150,11 @@
 #error "MBEDTLS_GCM_C defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_SCRT_AEAD) && ( !defined(MBEDTLS_AES_C) ||           \
+    ( !defined(MBEDTLS_CCM_C) && !defined(MBEDTLS_GCM_C) ) )
+#error "MBEDTLS_SCRT_AEAD defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_ECP_RANDOMIZE_JAC_ALT) && !defined(MBEDTLS_ECP_INTERNAL_ALT)
 #error "MBEDTLS_ECP_RANDOMIZE_JAC_ALT defined, but not all prerequisites"
 #endif
@@ -50,6 +50,10 @@ typedef struct {
     unsigned char y[16];        /*!< Y working value */
     unsigned char buf[16];      /*!< buf working value */
     int mode;                   /*!< Encrypt or Decrypt */
+#if defined(MBEDTLS_SCRT_AEAD)
+    unsigned char scrt_key[16]; /*!< AES-128 key for the SCRT engine */
+    int scrt_key_set;           /*!< scrt_key is valid */
+#endif
 }
 mbedtls_gcm_context;
 
@@ -40,6 +40,10 @@
 
 #include <string.h>
 
+#if defined(MBEDTLS_SCRT_AEAD)
+#include "scrt_aead.h"
+#endif
+
 #if defined(MBEDTLS_SELF_TEST) && defined(MBEDTLS_AES_C)
 #if defined(MBEDTLS_PLATFORM_C)
 #include "mbedtls/platform.h"
@@ -82,6 +86,10 @@ int mbedtls_ccm_setkey( mbedtls_ccm_context *ctx,
 
     mbedtls_cipher_free( &ctx->cipher_ctx );
 
+#if defined(MBEDTLS_SCRT_AEAD)
+    ctx->scrt_key_set = 0;
+#endif
+
     if( ( ret = mbedtls_cipher_setup( &ctx->cipher_ctx, cipher_info ) ) != 0 )
         return( ret );
 
@@ -91,6 +99,15 @@ int mbedtls_ccm_setkey( mbedtls_ccm_context *ctx,
         return( ret );
     }
 
+#if defined(MBEDTLS_SCRT_AEAD)
+    /* The SCRT engine takes the whole message, with AES-128 only */
+    if( cipher == MBEDTLS_CIPHER_ID_AES && keybits == MBEDTLS_SCRT_AEAD_KEY_LEN * 8 )
+    {
+        memcpy( ctx->scrt_key, key, MBEDTLS_SCRT_AEAD_KEY_LEN );
+        ctx->scrt_key_set = 1;
+    }
+#endif
+
     return( 0 );
 }
 
@@ -310,6 +327,18 @@ int mbedtls_ccm_encrypt_and_tag( mbedtls_ccm_context *ctx, size_t length,
                          const unsigned char *input, unsigned char *output,
                          unsigned char *tag, size_t tag_len )
 {
+#if defined(MBEDTLS_SCRT_AEAD)
+    if( ctx->scrt_key_set &&
+        mbedtls_scrt_ccm_crypt( 1, ctx->scrt_key, length, iv, iv_len,
+                                add, add_len, input, output, tag, tag_len ) == 0 )
+    {
+        mbedtls_scrt_aead_count( 1, 1, length );
+        return( 0 );
+    }
+
+    mbedtls_scrt_aead_count( 1, 0, length );
+#endif
+
     return( ccm_auth_crypt( ctx, CCM_ENCRYPT, length, iv, iv_len,
                             add, add_len, input, output, tag, tag_len ) );
 }
@@ -328,6 +357,21 @@ int mbedtls_ccm_auth_decrypt( mbedtls_ccm_context *ctx, size_t length,
     unsigned char i;
     int diff;
 
+#if defined(MBEDTLS_SCRT_AEAD)
+    /* The engine checks the tag too. It cannot tell a wrong tag from its own
+     * failure, so any failure goes on in software, which has the last word. */
+    if( ctx->scrt_key_set &&
+        mbedtls_scrt_ccm_crypt( 0, ctx->scrt_key, length, iv, iv_len,
+                                add, add_len, input, output,
+                                (unsigned char *) tag, tag_len ) == 0 )
+    {
+        mbedtls_scrt_aead_count( 1, 1, length );
+        return( 0 );
+    }
+
+    mbedtls_scrt_aead_count( 1, 0, length );
+#endif
+
     if( ( ret = ccm_auth_crypt( ctx, CCM_DECRYPT, length,
                                 iv, iv_len, add, add_len,
                                 input, output, check_tag, tag_len ) ) != 0 )
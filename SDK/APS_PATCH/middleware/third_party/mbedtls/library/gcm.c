@@ -41,6 +41,10 @@
 
 #include <string.h>
 
+#if defined(MBEDTLS_SCRT_AEAD)
+#include "scrt_aead.h"
+#endif
+
 #if defined(MBEDTLS_AESNI_C)
 #include "mbedtls/aesni.h"
 #endif
@@ -175,6 +179,10 @@ int mbedtls_gcm_setkey( mbedtls_gcm_context *ctx,
 
     mbedtls_cipher_free( &ctx->cipher_ctx );
 
+#if defined(MBEDTLS_SCRT_AEAD)
+    ctx->scrt_key_set = 0;
+#endif
+
     if( ( ret = mbedtls_cipher_setup( &ctx->cipher_ctx, cipher_info ) ) != 0 )
         return( ret );
 
@@ -187,6 +195,15 @@ int mbedtls_gcm_setkey( mbedtls_gcm_context *ctx,
     if( ( ret = gcm_gen_table( ctx ) ) != 0 )
         return( ret );
 
+#if defined(MBEDTLS_SCRT_AEAD)
+    /* The SCRT engine makes the key stream, with AES-128 only */
+    if( cipher == MBEDTLS_CIPHER_ID_AES && keybits == MBEDTLS_SCRT_AEAD_KEY_LEN * 8 )
+    {
+        memcpy( ctx->scrt_key, key, MBEDTLS_SCRT_AEAD_KEY_LEN );
+        ctx->scrt_key_set = 1;
+    }
+#endif
+
     return( 0 );
 }
 
@@ -346,6 +363,57 @@ int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
     return( 0 );
 }
 
+#if defined(MBEDTLS_SCRT_AEAD)
+/*
+ * Key stream from the SCRT engine in batches of counter blocks, GHASH stays
+ * here. ctx->y moves only with the batches done, so the software loop can
+ * take over the rest at any point. Returns the number of bytes done.
+ */
+static size_t gcm_update_scrt( mbedtls_gcm_context *ctx,
+                               size_t length,
+                               const unsigned char *input,
+                               unsigned char *output )
+{
+    unsigned char stream[MBEDTLS_SCRT_AEAD_CTR_BLOCKS * 16 + MBEDTLS_SCRT_AEAD_PAD];
+    const unsigned char *ectr;
+    size_t blocks, n, i;
+    size_t use_len, done = 0;
+
+    while( done < length )
+    {
+        blocks = ( length - done + 15 ) / 16;
+        if( blocks > MBEDTLS_SCRT_AEAD_CTR_BLOCKS )
+            blocks = MBEDTLS_SCRT_AEAD_CTR_BLOCKS;
+
+        if( mbedtls_scrt_gcm_ctr32( ctx->scrt_key, ctx->y, blocks, stream ) != 0 )
+            break;
+
+        for( n = 0; n < blocks; n++ )
+        {
+            use_len = ( length - done < 16 ) ? length - done : 16;
+            ectr = stream + n * 16;
+
+            for( i = 0; i < use_len; i++ )
+            {
+                if( ctx->mode == MBEDTLS_GCM_DECRYPT )
+                    ctx->buf[i] ^= input[done + i];
+                output[done + i] = ectr[i] ^ input[done + i];
+                if( ctx->mode == MBEDTLS_GCM_ENCRYPT )
+                    ctx->buf[i] ^= output[done + i];
+            }
+
+            gcm_mult( ctx, ctx->buf, ctx->buf );
+
+            done += use_len;
+        }
+    }
+
+    mbedtls_zeroize( stream, sizeof( stream ) );
+
+    return( done );
+}
+#endif /* MBEDTLS_SCRT_AEAD */
+
 int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
                 size_t length,
                 const unsigned char *input,
@@ -372,6 +440,23 @@ int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
     ctx->len += length;
 
     p = input;
+
+#if defined(MBEDTLS_SCRT_AEAD)
+    if( ctx->scrt_key_set && length > 0 )
+    {
+        use_len = gcm_update_scrt( ctx, length, p, out_p );
+        if( use_len > 0 )
+            mbedtls_scrt_aead_count( 0, 1, use_len );
+
+        length -= use_len;
+        p += use_len;
+        out_p += use_len;
+    }
+
+    if( length > 0 )
+        mbedtls_scrt_aead_count( 0, 0, length );
+#endif
+
     while( length > 0 )
     {
         use_len = ( length < 16 ) ? length : 16;
@@ -0,0 +1,141 @@
+/**
+ * \file scrt_aead.h
+ *
+ * \brief AES-CCM and AES-GCM record offload to the OPL1000 SCRT engine
+ *
+ *  The CCM records go whole to the engine (nl_scrt_aes_ccm). The engine has
+ *  no counter mode interface, so GCM gets its key stream from the engine in
+ *  batches of counter blocks (nl_scrt_aes_ecb) and keeps GHASH in software.
+ *
+ *  The engine takes 128-bit keys only, other keys and the inputs it cannot
+ *  take (no additional data, no payload) stay in software. A failure of the
+ *  engine falls back to software too, the caller sees no difference.
+ */
+#ifndef MBEDTLS_SCRT_AEAD_H
+#define MBEDTLS_SCRT_AEAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MBEDTLS_ERR_SCRT_AEAD_UNSUPPORTED   -0x0054  /**< The input is not for the engine, use software. */
+#define MBEDTLS_ERR_SCRT_AEAD_HW_FAILED     -0x0056  /**< The engine failed (or the tag did not match). */
+
+#define MBEDTLS_SCRT_AEAD_KEY_LEN           16      /**< The engine takes AES-128 keys only */
+#define MBEDTLS_SCRT_AEAD_PAD               4       /**< The engine writes a token word after the data */
+
+#if !defined(MBEDTLS_SCRT_AEAD_CTR_BLOCKS)
+#define MBEDTLS_SCRT_AEAD_CTR_BLOCKS        16      /**< Counter blocks per request of the GCM key stream */
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          Counters of the offload, for the comparison with software
+ */
+typedef struct
+{
+    uint32_t ccm_hw;            /*!< CCM records done by the engine */
+    uint32_t ccm_sw;            /*!< CCM records done in software */
+    uint32_t gcm_hw;            /*!< GCM updates with the key stream of the engine */
+    uint32_t gcm_sw;            /*!< GCM updates done in software */
+    uint32_t hw_fail;           /*!< engine failures that fell back to software */
+    uint32_t hw_bytes;          /*!< payload bytes done by the engine */
+    uint32_t sw_bytes;          /*!< payload bytes done in software */
+}
+mbedtls_scrt_aead_stats;
+
+/**
+ * \brief          Turn the offload on or off (on by default)
+ *
+ * \param enable   1: use the engine, 0: software only
+ */
+void mbedtls_scrt_aead_enable( int enable );
+
+/**
+ * \brief          Check whether the offload is on
+ */
+int mbedtls_scrt_aead_enabled( void );
+
+/**
+ * \brief          Get the counters of the offload
+ */
+void mbedtls_scrt_aead_stats_get( mbedtls_scrt_aead_stats *stats );
+
+/**
+ * \brief          Clear the counters of the offload
+ */
+void mbedtls_scrt_aead_stats_reset( void );
+
+/**
+ * \brief          Count the payload of a CCM record or a GCM update
+ *
+ * \param ccm      1: CCM, 0: GCM
+ * \param hw       1: done by the engine, 0: done in software
+ * \param length   payload bytes
+ */
+void mbedtls_scrt_aead_count( int ccm, int hw, size_t length );
+
+/**
+ * \brief          CCM encryption or decryption of a whole message by the engine
+ *
+ * \param encrypt  1: encrypt and write the tag, 0: decrypt and check the tag
+ * \param key      AES-128 key
+ * \param length   length of the input data, not 0
+ * \param iv       nonce, 7 ~ 13 bytes
+ * \param iv_len   length of the nonce
+ * \param add      additional data
+ * \param add_len  length of the additional data, 1 ~ 0xFF00
+ * \param input    input data
+ * \param output   output data, written only on success
+ * \param tag      tag, written on encryption, checked on decryption
+ * \param tag_len  length of the tag, 4 ~ 16, even
+ *
+ * \return         0 if successful,
+ *                 MBEDTLS_ERR_SCRT_AEAD_UNSUPPORTED if the engine is off or
+ *                 cannot take the input,
+ *                 MBEDTLS_ERR_SCRT_AEAD_HW_FAILED if the engine failed, on
+ *                 decryption this includes a wrong tag; the caller has to run
+ *                 the software path in both cases.
+ */
+int mbedtls_scrt_ccm_crypt( int encrypt, const unsigned char *key, size_t length,
+                            const unsigned char *iv, size_t iv_len,
+                            const unsigned char *add, size_t add_len,
+                            const unsigned char *input, unsigned char *output,
+                            unsigned char *tag, size_t tag_len );
+
+/**
+ * \brief          AES-128 key stream of the 32-bit counter mode of GCM
+ *
+ *                 Before each block the last 4 bytes of y are increased
+ *                 (big endian) and the block is encrypted to the stream.
+ *
+ * \param key      AES-128 key
+ * \param y        counter block, updated only on success
+ * \param blocks   number of blocks, 1 ~ MBEDTLS_SCRT_AEAD_CTR_BLOCKS
+ * \param stream   output, blocks * 16 + MBEDTLS_SCRT_AEAD_PAD bytes
+ *
+ * \return         0 if successful, or MBEDTLS_ERR_SCRT_AEAD_xxx
+ */
+int mbedtls_scrt_gcm_ctr32( const unsigned char *key, unsigned char y[16],
+                            size_t blocks, unsigned char *stream );
+
+/**
+ * \brief          Diag command of the offload
+ *
+ *                 tlsaead                      the counters
+ *                 tlsaead on|off               turn the offload on or off
+ *                 tlsaead reset                clear the counters
+ *                 tlsaead test [n]             n random records, engine vs software
+ *                 tlsaead bench [kb]           throughput of the engine vs software
+ *
+ * \param cmd      the command line
+ */
+void mbedtls_scrt_aead_cmd( char *cmd );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* scrt_aead.h */
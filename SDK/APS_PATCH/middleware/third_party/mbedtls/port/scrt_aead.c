@@ -0,0 +1,513 @@
+/*
+ *  AES-CCM and AES-GCM record offload to the OPL1000 SCRT engine
+ *
+ *  The engine works on DMA buffers of whole blocks and writes a token word
+ *  after the output, so the records go through a bounce buffer of their own.
+ *  It only takes 128-bit keys; the callers in ccm.c and gcm.c keep the
+ *  software path for the rest and for any failure of the engine.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include "scrt_aead.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(MBEDTLS_SCRT_AEAD)
+
+#if defined(MBEDTLS_PLATFORM_C)
+#include "mbedtls/platform.h"
+#else
+#define mbedtls_calloc    calloc
+#define mbedtls_free      free
+#endif
+
+#include "mbedtls/ccm.h"
+#include "mbedtls/gcm.h"
+#include "cmsis_os.h"
+#include "scrt.h"
+
+#define SCRT_AEAD_TEST_LEN      1024        /* the longest random record of the test */
+#define SCRT_AEAD_BENCH_LEN     1024        /* the record of the bench */
+#define SCRT_AEAD_IV_LEN        12          /* the nonce of TLS 1.2 AEAD */
+#define SCRT_AEAD_ADD_LEN       13          /* the additional data of TLS 1.2 */
+
+static int scrt_aead_on = 1;
+static mbedtls_scrt_aead_stats scrt_aead_stats;
+
+/* Implementation that should never be optimized out by the compiler */
+static void scrt_aead_zeroize( void *v, size_t n ) {
+    volatile unsigned char *p = v; while( n-- ) *p++ = 0;
+}
+
+void mbedtls_scrt_aead_enable( int enable )
+{
+    scrt_aead_on = ( enable != 0 );
+}
+
+int mbedtls_scrt_aead_enabled( void )
+{
+    return( scrt_aead_on );
+}
+
+void mbedtls_scrt_aead_stats_get( mbedtls_scrt_aead_stats *stats )
+{
+    memcpy( stats, &scrt_aead_stats, sizeof( mbedtls_scrt_aead_stats ) );
+}
+
+void mbedtls_scrt_aead_stats_reset( void )
+{
+    memset( &scrt_aead_stats, 0, sizeof( mbedtls_scrt_aead_stats ) );
+}
+
+void mbedtls_scrt_aead_count( int ccm, int hw, size_t length )
+{
+    if( hw )
+    {
+        if( ccm )
+            scrt_aead_stats.ccm_hw++;
+        else
+            scrt_aead_stats.gcm_hw++;
+
+        scrt_aead_stats.hw_bytes += length;
+    }
+    else
+    {
+        if( ccm )
+            scrt_aead_stats.ccm_sw++;
+        else
+            scrt_aead_stats.gcm_sw++;
+
+        scrt_aead_stats.sw_bytes += length;
+    }
+}
+
+/*
+ * Whole CCM message through the engine
+ *
+ * The bounce buffer holds the input padded to a block, then the output and
+ * the token word of the engine. The output is copied out only on success.
+ */
+int mbedtls_scrt_ccm_crypt( int encrypt, const unsigned char *key, size_t length,
+                            const unsigned char *iv, size_t iv_len,
+                            const unsigned char *add, size_t add_len,
+                            const unsigned char *input, unsigned char *output,
+                            unsigned char *tag, size_t tag_len )
+{
+    int ret = MBEDTLS_ERR_SCRT_AEAD_UNSUPPORTED;
+    unsigned char check_tag[16];
+    unsigned char *buf = NULL;
+    unsigned char *in;
+    unsigned char *out;
+    size_t blk_len;
+
+    if( !scrt_aead_on )
+        goto cleanup;
+
+    /* The same limits as ccm_auth_crypt(), plus no empty payload or
+     * additional data, which the engine does not take */
+    if( length == 0 || length > 0xFFFFFF00 || add_len == 0 || add_len > 0xFF00 ||
+        iv_len < 7 || iv_len > 13 ||
+        tag_len < 4 || tag_len > 16 || tag_len % 2 != 0 )
+    {
+        goto cleanup;
+    }
+
+    blk_len = ( length + 15 ) & ~( (size_t) 15 );
+
+    if( ( buf = mbedtls_calloc( 1, blk_len * 2 + MBEDTLS_SCRT_AEAD_PAD ) ) == NULL )
+    {
+        ret = MBEDTLS_ERR_SCRT_AEAD_HW_FAILED;
+        goto cleanup;
+    }
+
+    in = buf;
+    out = buf + blk_len;
+    memcpy( in, input, length );
+
+    if( encrypt )
+    {
+        if( nl_scrt_aes_ccm( 1, (unsigned char *) key, MBEDTLS_SCRT_AEAD_KEY_LEN,
+                             (unsigned char *) iv, (int) iv_len,
+                             (unsigned char *) add, (int) add_len,
+                             in, out, (int) length, tag, (int) tag_len ) != 1 )
+        {
+            ret = MBEDTLS_ERR_SCRT_AEAD_HW_FAILED;
+            goto cleanup;
+        }
+    }
+    else
+    {
+        /* the engine checks the tag, a mismatch is a failure like any other */
+        memcpy( check_tag, tag, tag_len );
+
+        if( nl_scrt_aes_ccm( 0, (unsigned char *) key, MBEDTLS_SCRT_AEAD_KEY_LEN,
+                             (unsigned char *) iv, (int) iv_len,
+                             (unsigned char *) add, (int) add_len,
+                             out, in, (int) length, check_tag, (int) tag_len ) != 1 )
+        {
+            ret = MBEDTLS_ERR_SCRT_AEAD_HW_FAILED;
+            goto cleanup;
+        }
+    }
+
+    memcpy( output, out, length );
+    ret = 0;
+
+cleanup:
+    if( ret == MBEDTLS_ERR_SCRT_AEAD_HW_FAILED )
+        scrt_aead_stats.hw_fail++;
+
+    if( buf != NULL )
+    {
+        scrt_aead_zeroize( buf, blk_len * 2 + MBEDTLS_SCRT_AEAD_PAD );
+        mbedtls_free( buf );
+    }
+
+    return( ret );
+}
+
+/*
+ * GCM key stream: the counter blocks of one batch through the ECB of the engine
+ */
+int mbedtls_scrt_gcm_ctr32( const unsigned char *key, unsigned char y[16],
+                            size_t blocks, unsigned char *stream )
+{
+    unsigned char ctr[MBEDTLS_SCRT_AEAD_CTR_BLOCKS * 16];
+    unsigned char next[16];
+    size_t n, i;
+
+    if( !scrt_aead_on || blocks == 0 || blocks > MBEDTLS_SCRT_AEAD_CTR_BLOCKS )
+        return( MBEDTLS_ERR_SCRT_AEAD_UNSUPPORTED );
+
+    memcpy( next, y, 16 );
+
+    for( n = 0; n < blocks; n++ )
+    {
+        for( i = 16; i > 12; i-- )
+            if( ++next[i - 1] != 0 )
+                break;
+
+        memcpy( ctr + n * 16, next, 16 );
+    }
+
+    if( nl_scrt_aes_ecb( 1, (unsigned char *) key, MBEDTLS_SCRT_AEAD_KEY_LEN,
+                         ctr, stream, (unsigned) ( blocks * 16 ) ) != 1 )
+    {
+        scrt_aead_stats.hw_fail++;
+        return( MBEDTLS_ERR_SCRT_AEAD_HW_FAILED );
+    }
+
+    memcpy( y, next, 16 );
+
+    return( 0 );
+}
+
+/*
+ * Random records through the engine and through software, the outputs and
+ * tags have to match, a wrong tag has to fail
+ */
+static int scrt_aead_test( unsigned int num )
+{
+    mbedtls_ccm_context ccm;
+    mbedtls_gcm_context gcm;
+    unsigned char key[16];
+    unsigned char iv[SCRT_AEAD_IV_LEN];
+    unsigned char add[SCRT_AEAD_ADD_LEN];
+    unsigned char tag_hw[16];
+    unsigned char tag_sw[16];
+    unsigned char *plain = NULL;
+    unsigned char *enc_hw = NULL;
+    unsigned char *enc_sw = NULL;
+    unsigned char *dec = NULL;
+    mbedtls_scrt_aead_stats before;
+    mbedtls_scrt_aead_stats after;
+    size_t len, tag_len, i;
+    unsigned int k;
+    int on = scrt_aead_on;
+    int fail = 0;
+
+    mbedtls_ccm_init( &ccm );
+    mbedtls_gcm_init( &gcm );
+
+    plain = mbedtls_calloc( 4, SCRT_AEAD_TEST_LEN );
+    if( plain == NULL )
+    {
+        printf( "tlsaead: no memory\n" );
+        return( -1 );
+    }
+
+    enc_hw = plain + SCRT_AEAD_TEST_LEN;
+    enc_sw = enc_hw + SCRT_AEAD_TEST_LEN;
+    dec = enc_sw + SCRT_AEAD_TEST_LEN;
+
+    mbedtls_scrt_aead_stats_get( &before );
+
+    for( k = 0; ( k < num ) && ( fail == 0 ); k++ )
+    {
+        len = 1 + rand() % SCRT_AEAD_TEST_LEN;
+        tag_len = ( k & 1 ) ? 8 : 16;   /* CCM_8 and the full tag */
+
+        for( i = 0; i < sizeof( key ); i++ )
+            key[i] = (unsigned char) rand();
+        for( i = 0; i < sizeof( iv ); i++ )
+            iv[i] = (unsigned char) rand();
+        for( i = 0; i < sizeof( add ); i++ )
+            add[i] = (unsigned char) rand();
+        for( i = 0; i < len; i++ )
+            plain[i] = (unsigned char) rand();
+
+        /* CCM */
+        if( mbedtls_ccm_setkey( &ccm, MBEDTLS_CIPHER_ID_AES, key, 128 ) != 0 )
+        {
+            fail = 1;
+            break;
+        }
+
+        scrt_aead_on = 1;
+        mbedtls_ccm_encrypt_and_tag( &ccm, len, iv, sizeof( iv ), add, sizeof( add ),
+                                     plain, enc_hw, tag_hw, tag_len );
+        scrt_aead_on = 0;
+        mbedtls_ccm_encrypt_and_tag( &ccm, len, iv, sizeof( iv ), add, sizeof( add ),
+                                     plain, enc_sw, tag_sw, tag_len );
+
+        if( memcmp( enc_hw, enc_sw, len ) != 0 || memcmp( tag_hw, tag_sw, tag_len ) != 0 )
+        {
+            printf( "tlsaead: ccm #%u len %u encrypt mismatch\n", k, (unsigned) len );
+            fail = 1;
+            break;
+        }
+
+        scrt_aead_on = 1;
+        if( mbedtls_ccm_auth_decrypt( &ccm, len, iv, sizeof( iv ), add, sizeof( add ),
+                                      enc_hw, dec, tag_hw, tag_len ) != 0 ||
+            memcmp( dec, plain, len ) != 0 )
+        {
+            printf( "tlsaead: ccm #%u len %u decrypt mismatch\n", k, (unsigned) len );
+            fail = 1;
+            break;
+        }
+
+        tag_hw[0] ^= 0x01;
+        if( mbedtls_ccm_auth_decrypt( &ccm, len, iv, sizeof( iv ), add, sizeof( add ),
+                                      enc_hw, dec, tag_hw, tag_len ) != MBEDTLS_ERR_CCM_AUTH_FAILED )
+        {
+            printf( "tlsaead: ccm #%u len %u wrong tag accepted\n", k, (unsigned) len );
+            fail = 1;
+            break;
+        }
+
+        /* GCM */
+        if( mbedtls_gcm_setkey( &gcm, MBEDTLS_CIPHER_ID_AES, key, 128 ) != 0 )
+        {
+            fail = 1;
+            break;
+        }
+
+        scrt_aead_on = 1;
+        mbedtls_gcm_crypt_and_tag( &gcm, MBEDTLS_GCM_ENCRYPT, len, iv, sizeof( iv ),
+                                   add, sizeof( add ), plain, enc_hw, 16, tag_hw );
+        scrt_aead_on = 0;
+        mbedtls_gcm_crypt_and_tag( &gcm, MBEDTLS_GCM_ENCRYPT, len, iv, sizeof( iv ),
+                                   add, sizeof( add ), plain, enc_sw, 16, tag_sw );
+
+        if( memcmp( enc_hw, enc_sw, len ) != 0 || memcmp( tag_hw, tag_sw, 16 ) != 0 )
+        {
+            printf( "tlsaead: gcm #%u len %u encrypt mismatch\n", k, (unsigned) len );
+            fail = 1;
+            break;
+        }
+
+        scrt_aead_on = 1;
+        if( mbedtls_gcm_auth_decrypt( &gcm, len, iv, sizeof( iv ), add, sizeof( add ),
+                                      tag_hw, 16, enc_hw, dec ) != 0 ||
+            memcmp( dec, plain, len ) != 0 )
+        {
+            printf( "tlsaead: gcm #%u len %u decrypt mismatch\n", k, (unsigned) len );
+            fail = 1;
+            break;
+        }
+
+        tag_hw[15] ^= 0x80;
+        if( mbedtls_gcm_auth_decrypt( &gcm, len, iv, sizeof( iv ), add, sizeof( add ),
+                                      tag_hw, 16, enc_hw, dec ) != MBEDTLS_ERR_GCM_AUTH_FAILED )
+        {
+            printf( "tlsaead: gcm #%u len %u wrong tag accepted\n", k, (unsigned) len );
+            fail = 1;
+            break;
+        }
+    }
+
+    scrt_aead_on = on;
+    mbedtls_scrt_aead_stats_get( &after );
+
+    printf( "tlsaead: %u records %s, engine ccm %u gcm %u, failures %u\n", k,
+            fail ? "FAIL" : "ok",
+            (unsigned) ( after.ccm_hw - before.ccm_hw ),
+            (unsigned) ( after.gcm_hw - before.gcm_hw ),
+            (unsigned) ( after.hw_fail - before.hw_fail ) );
+
+#if defined(MBEDTLS_SELF_TEST)
+    /* the vectors of SP800-38C and of the GCM spec, with the offload on */
+    scrt_aead_on = 1;
+    if( mbedtls_ccm_self_test( 0 ) != 0 )
+    {
+        printf( "tlsaead: ccm self test FAIL\n" );
+        fail = 1;
+    }
+    if( mbedtls_gcm_self_test( 0 ) != 0 )
+    {
+        printf( "tlsaead: gcm self test FAIL\n" );
+        fail = 1;
+    }
+    scrt_aead_on = on;
+#endif
+
+    mbedtls_ccm_free( &ccm );
+    mbedtls_gcm_free( &gcm );
+    mbedtls_free( plain );
+
+    return( fail ? -1 : 0 );
+}
+
+/*
+ * Records of SCRT_AEAD_BENCH_LEN encrypted for kb KB, engine and software
+ */
+static void scrt_aead_bench( unsigned int kb )
+{
+    mbedtls_ccm_context ccm;
+    mbedtls_gcm_context gcm;
+    unsigned char key[16];
+    unsigned char iv[SCRT_AEAD_IV_LEN];
+    unsigned char add[SCRT_AEAD_ADD_LEN];
+    unsigned char tag[16];
+    unsigned char *buf;
+    uint32_t tick;
+    uint32_t ms;
+    unsigned int num;
+    unsigned int k;
+    int on = scrt_aead_on;
+    int ccm_mode;
+    int hw;
+
+    num = ( kb * 1024 + SCRT_AEAD_BENCH_LEN - 1 ) / SCRT_AEAD_BENCH_LEN;
+    if( num == 0 )
+        num = 1;
+
+    buf = mbedtls_calloc( 1, SCRT_AEAD_BENCH_LEN );
+    if( buf == NULL )
+    {
+        printf( "tlsaead: no memory\n" );
+        return;
+    }
+
+    memset( key, 0x5A, sizeof( key ) );
+    memset( iv, 0x3C, sizeof( iv ) );
+    memset( add, 0x17, sizeof( add ) );
+
+    mbedtls_ccm_init( &ccm );
+    mbedtls_gcm_init( &gcm );
+    mbedtls_ccm_setkey( &ccm, MBEDTLS_CIPHER_ID_AES, key, 128 );
+    mbedtls_gcm_setkey( &gcm, MBEDTLS_CIPHER_ID_AES, key, 128 );
+
+    for( ccm_mode = 1; ccm_mode >= 0; ccm_mode-- )
+    {
+        for( hw = 1; hw >= 0; hw-- )
+        {
+            scrt_aead_on = hw;
+            tick = osKernelSysTick();
+
+            for( k = 0; k < num; k++ )
+            {
+                /* in place, as the record layer does */
+                if( ccm_mode )
+                    mbedtls_ccm_encrypt_and_tag( &ccm, SCRT_AEAD_BENCH_LEN, iv, sizeof( iv ),
+                                                 add, sizeof( add ), buf, buf, tag, 16 );
+                else
+                    mbedtls_gcm_crypt_and_tag( &gcm, MBEDTLS_GCM_ENCRYPT, SCRT_AEAD_BENCH_LEN,
+                                               iv, sizeof( iv ), add, sizeof( add ),
+                                               buf, buf, 16, tag );
+            }
+
+            ms = osKernelSysTick() - tick;
+            if( ms == 0 )
+                ms = 1;
+
+            printf( "tlsaead: %s %s %u KB in %u ms, %u KB/s, %u us/KB\n",
+                    ccm_mode ? "ccm" : "gcm", hw ? "engine  " : "software",
+                    num * SCRT_AEAD_BENCH_LEN / 1024, (unsigned) ms,
+                    (unsigned) ( num * SCRT_AEAD_BENCH_LEN / 1024 * 1000 / ms ),
+                    (unsigned) ( ms * 1000 / ( num * SCRT_AEAD_BENCH_LEN / 1024 ) ) );
+        }
+    }
+
+    scrt_aead_on = on;
+
+    mbedtls_ccm_free( &ccm );
+    mbedtls_gcm_free( &gcm );
+    mbedtls_free( buf );
+}
+
+void mbedtls_scrt_aead_cmd( char *cmd )
+{
+    char *arg[3] = { NULL, NULL, NULL };
+    char *p = cmd;
+    int n = 0;
+
+    /* the command name, the sub-command and its value */
+    while( ( p != NULL ) && ( *p != '\0' ) && ( n < 3 ) )
+    {
+        while( ( *p == ' ' ) || ( *p == '\t' ) )
+            p++;
+
+        if( ( *p == '\0' ) || ( *p == '\r' ) || ( *p == '\n' ) )
+            break;
+
+        arg[n++] = p;
+
+        while( ( *p != '\0' ) && ( *p != ' ' ) && ( *p != '\t' ) && ( *p != '\r' ) && ( *p != '\n' ) )
+            p++;
+
+        if( *p != '\0' )
+            *p++ = '\0';
+    }
+
+    if( arg[1] == NULL )
+    {
+        printf( "tlsaead: %s, ccm engine %u software %u, gcm engine %u software %u\n",
+                scrt_aead_on ? "on" : "off",
+                (unsigned) scrt_aead_stats.ccm_hw, (unsigned) scrt_aead_stats.ccm_sw,
+                (unsigned) scrt_aead_stats.gcm_hw, (unsigned) scrt_aead_stats.gcm_sw );
+        printf( "tlsaead: bytes engine %u software %u, engine failures %u\n",
+                (unsigned) scrt_aead_stats.hw_bytes, (unsigned) scrt_aead_stats.sw_bytes,
+                (unsigned) scrt_aead_stats.hw_fail );
+    }
+    else if( strcmp( arg[1], "on" ) == 0 )
+        mbedtls_scrt_aead_enable( 1 );
+    else if( strcmp( arg[1], "off" ) == 0 )
+        mbedtls_scrt_aead_enable( 0 );
+    else if( strcmp( arg[1], "reset" ) == 0 )
+        mbedtls_scrt_aead_stats_reset();
+    else if( strcmp( arg[1], "test" ) == 0 )
+        scrt_aead_test( ( arg[2] != NULL ) ? (unsigned int) strtoul( arg[2], NULL, 0 ) : 100 );
+    else if( strcmp( arg[1], "bench" ) == 0 )
+        scrt_aead_bench( ( arg[2] != NULL ) ? (unsigned int) strtoul( arg[2], NULL, 0 ) : 64 );
+    else
+        printf( "tlsaead [on|off|reset|test [n]|bench [kb]]\n" );
+}
+
+#else /* MBEDTLS_SCRT_AEAD */
+
+void mbedtls_scrt_aead_cmd( char *cmd )
+{
+    (void) cmd;
+    printf( "tlsaead: MBEDTLS_SCRT_AEAD is not in the mbedTLS config of this build\n" );
+}
+
+#endif /* MBEDTLS_SCRT_AEAD */
@@ -0,0 +1,30 @@
+/*
+ *  Host configuration of the SCRT AEAD suite
+ *
+ *  The cipher part of config-opl-basic.h with MBEDTLS_SCRT_AEAD, for a Linux
+ *  build against the software model of the SCRT engine (scrt_model.c).
+ *  The FreeRTOS heap and threading of the target are left out.
+ */
+
+#ifndef MBEDTLS_CONFIG_H
+#define MBEDTLS_CONFIG_H
+
+/* System support */
+#define MBEDTLS_HAVE_ASM
+
+/* mbed TLS modules */
+#define MBEDTLS_PLATFORM_C
+#define MBEDTLS_AES_C
+#define MBEDTLS_CCM_C
+#define MBEDTLS_CIPHER_C
+#define MBEDTLS_GCM_C
+
+#define MBEDTLS_AES_ROM_TABLES
+#define MBEDTLS_SELF_TEST
+
+/* OPL1000 */
+#define MBEDTLS_SCRT_AEAD
+
+#include "mbedtls/check_config.h"
+
+#endif /* MBEDTLS_CONFIG_H */
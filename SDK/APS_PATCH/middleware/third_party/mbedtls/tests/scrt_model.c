@@ -0,0 +1,287 @@
+/*
+ *  Software model of the OPL1000 SCRT engine for the host suite
+ *
+ *  nl_scrt_aes_ccm_impl() and nl_scrt_aes_ecb_impl() of the ROM hand the
+ *  engine a DMA buffer of whole blocks and expect the output, padded to a
+ *  block, followed by the token word of the request. The model writes the
+ *  same, and checks what the driver checks before the mailbox is written.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include "scrt_model.h"
+
+#include <string.h>
+
+#include "mbedtls/aes.h"
+#include "cmsis_os.h"
+#include "scrt.h"
+
+static scrt_model_stats model_stats;
+static uint32_t model_fail_at;
+
+void scrt_model_reset( void )
+{
+    memset( &model_stats, 0, sizeof( model_stats ) );
+    model_fail_at = 0;
+}
+
+void scrt_model_fail_at( uint32_t call )
+{
+    model_fail_at = call;
+}
+
+void scrt_model_stats_get( scrt_model_stats *stats )
+{
+    memcpy( stats, &model_stats, sizeof( model_stats ) );
+}
+
+/* the planned failure, counted down on every call */
+static int model_failing( void )
+{
+    if( model_fail_at == 0 )
+        return( 0 );
+
+    return( --model_fail_at == 0 );
+}
+
+/* the DMA of the engine reads and writes whole blocks */
+static size_t model_blk_len( size_t len )
+{
+    return( ( len + 15 ) & ~( (size_t) 15 ) );
+}
+
+static int model_overlap( const unsigned char *a, size_t a_len,
+                          const unsigned char *b, size_t b_len )
+{
+    return( a < b + b_len && b < a + a_len );
+}
+
+/* output of the request: the token word after the padded data */
+static void model_token( unsigned char *out, size_t blk_len )
+{
+    uint32_t token = SCRT_MODEL_TOKEN;
+
+    memcpy( out + blk_len, &token, sizeof( token ) );
+}
+
+/*
+ * CBC-MAC of a padded segment, x is the running MAC
+ */
+static void model_mac( mbedtls_aes_context *aes, unsigned char x[16],
+                       const unsigned char *data, size_t len )
+{
+    size_t i, use_len;
+
+    while( len > 0 )
+    {
+        use_len = ( len < 16 ) ? len : 16;
+
+        for( i = 0; i < use_len; i++ )
+            x[i] ^= data[i];
+
+        mbedtls_aes_crypt_ecb( aes, MBEDTLS_AES_ENCRYPT, x, x );
+
+        data += use_len;
+        len -= use_len;
+    }
+}
+
+/*
+ * CCM of RFC 3610 on the AES-ECB of the library, the engine the ROM drives
+ */
+static int model_ccm( int encrypt, const unsigned char *key,
+                      const unsigned char *nonce, size_t nonce_len,
+                      const unsigned char *adata, size_t adata_len,
+                      const unsigned char *in, unsigned char *out, size_t len,
+                      unsigned char *tag, size_t tag_len )
+{
+    mbedtls_aes_context aes;
+    unsigned char b[16];
+    unsigned char x[16];
+    unsigned char ctr[16];
+    unsigned char s[16];
+    unsigned char first[16];
+    size_t q = 15 - nonce_len;
+    size_t i, n, use_len, first_len;
+    size_t blk_len = model_blk_len( len );
+    uint32_t cnt;
+    int diff = 0;
+
+    mbedtls_aes_init( &aes );
+    mbedtls_aes_setkey_enc( &aes, key, 128 );
+
+    /* B0: flags, nonce, length */
+    memset( b, 0, sizeof( b ) );
+    b[0] = (unsigned char) ( 0x40 | ( ( ( tag_len - 2 ) / 2 ) << 3 ) | ( q - 1 ) );
+    memcpy( b + 1, nonce, nonce_len );
+    for( i = 0; i < q && i < sizeof( size_t ); i++ )
+        b[15 - i] = (unsigned char) ( len >> ( 8 * i ) );
+
+    mbedtls_aes_crypt_ecb( &aes, MBEDTLS_AES_ENCRYPT, b, x );
+
+    /* the additional data after its 2-byte length, padded */
+    memset( first, 0, sizeof( first ) );
+    first[0] = (unsigned char) ( adata_len >> 8 );
+    first[1] = (unsigned char) adata_len;
+    first_len = ( adata_len < 14 ) ? adata_len : 14;
+    memcpy( first + 2, adata, first_len );
+    model_mac( &aes, x, first, 16 );
+    model_mac( &aes, x, adata + first_len, adata_len - first_len );
+
+    /* the payload in counter mode from A1, A0 is for the tag */
+    memset( ctr, 0, sizeof( ctr ) );
+    ctr[0] = (unsigned char) ( q - 1 );
+    memcpy( ctr + 1, nonce, nonce_len );
+
+    for( n = 0, cnt = 1; n < blk_len; n += 16, cnt++ )
+    {
+        use_len = ( len - n < 16 ) ? len - n : 16;
+
+        for( i = 0; i < q && i < 4; i++ )
+            ctr[15 - i] = (unsigned char) ( cnt >> ( 8 * i ) );
+
+        mbedtls_aes_crypt_ecb( &aes, MBEDTLS_AES_ENCRYPT, ctr, s );
+
+        /* the engine fills the whole block, the pad is key stream */
+        for( i = 0; i < 16; i++ )
+            out[n + i] = s[i] ^ ( ( i < use_len ) ? in[n + i] : 0 );
+
+        model_mac( &aes, x, encrypt ? in + n : out + n, use_len );
+    }
+
+    memset( ctr + 1 + nonce_len, 0, q );
+    mbedtls_aes_crypt_ecb( &aes, MBEDTLS_AES_ENCRYPT, ctr, s );
+
+    for( i = 0; i < tag_len; i++ )
+    {
+        if( encrypt )
+            tag[i] = x[i] ^ s[i];
+        else
+            diff |= tag[i] ^ x[i] ^ s[i];
+    }
+
+    model_token( out, blk_len );
+    mbedtls_aes_free( &aes );
+
+    return( diff == 0 );
+}
+
+/*
+ * nl_scrt_aes_ccm: bEncrypt 1 reads plain_text and writes encrypted_text,
+ * 0 reads encrypted_text and writes plain_text
+ */
+static int model_aes_ccm( int bEncrypt, unsigned char *sk, int sk_len,
+                          unsigned char *nonce, int nonce_len,
+                          unsigned char *adata, int adata_len,
+                          unsigned char *plain_text, unsigned char *encrypted_text,
+                          int text_len, unsigned char *tag, int tag_len )
+{
+    unsigned char *in = bEncrypt ? plain_text : encrypted_text;
+    unsigned char *out = bEncrypt ? encrypted_text : plain_text;
+    size_t blk_len;
+
+    model_stats.ccm++;
+
+    /* the checks of nl_scrt_aes_ccm_impl, and the 128-bit key and the
+     * 4-bit nonce length of the mailbox words */
+    if( !sk || sk_len != 16 || !nonce || nonce_len < 7 || nonce_len > 13 ||
+        !adata || adata_len <= 0 || !plain_text || !encrypted_text || text_len <= 0 ||
+        !tag || tag_len < 4 || tag_len > 16 || ( tag_len & 1 ) )
+    {
+        model_stats.misuse++;
+        model_stats.fail++;
+        return( 0 );
+    }
+
+    blk_len = model_blk_len( text_len );
+
+    /* the DMA reads the input while it writes the output */
+    if( model_overlap( in, blk_len, out, blk_len + 4 ) )
+    {
+        model_stats.misuse++;
+        model_stats.fail++;
+        return( 0 );
+    }
+
+    if( model_failing() )
+    {
+        memset( out, SCRT_MODEL_SCRIBBLE, blk_len + 4 );
+        model_stats.fail++;
+        return( 0 );
+    }
+
+    if( !model_ccm( bEncrypt, sk, nonce, nonce_len, adata, adata_len,
+                    in, out, text_len, tag, tag_len ) )
+    {
+        /* the plain text is out, only the result token tells */
+        model_stats.tag_fail++;
+        model_stats.fail++;
+        return( 0 );
+    }
+
+    return( 1 );
+}
+
+static int model_aes_ecb( int bEncrypt, unsigned char *sk, int sk_len,
+                          unsigned char *data_in, unsigned char *data_out,
+                          unsigned data_len )
+{
+    mbedtls_aes_context aes;
+    unsigned char blk[16];
+    size_t blk_len;
+    size_t n;
+
+    model_stats.ecb++;
+
+    if( !sk || ( sk_len != 16 && sk_len != 24 && sk_len != 32 ) ||
+        !data_in || !data_out || data_len == 0 )
+    {
+        model_stats.misuse++;
+        model_stats.fail++;
+        return( 0 );
+    }
+
+    blk_len = model_blk_len( data_len );
+
+    if( model_overlap( data_in, blk_len, data_out, blk_len + 4 ) )
+    {
+        model_stats.misuse++;
+        model_stats.fail++;
+        return( 0 );
+    }
+
+    if( model_failing() )
+    {
+        memset( data_out, SCRT_MODEL_SCRIBBLE, blk_len + 4 );
+        model_stats.fail++;
+        return( 0 );
+    }
+
+    mbedtls_aes_init( &aes );
+
+    if( bEncrypt )
+        mbedtls_aes_setkey_enc( &aes, sk, sk_len * 8 );
+    else
+        mbedtls_aes_setkey_dec( &aes, sk, sk_len * 8 );
+
+    for( n = 0; n < blk_len; n += 16 )
+    {
+        memset( blk, 0, sizeof( blk ) );
+        memcpy( blk, data_in + n, ( data_len - n < 16 ) ? data_len - n : 16 );
+        mbedtls_aes_crypt_ecb( &aes, bEncrypt ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT,
+                               blk, data_out + n );
+    }
+
+    model_token( data_out, blk_len );
+    mbedtls_aes_free( &aes );
+
+    return( 1 );
+}
+
+nl_scrt_aes_ccm_fp_t nl_scrt_aes_ccm = model_aes_ccm;
+nl_scrt_aes_ecb_fp_t nl_scrt_aes_ecb = model_aes_ecb;
@@ -0,0 +1,53 @@
+/**
+ * \file scrt_model.h
+ *
+ * \brief Software model of the OPL1000 SCRT engine for the host suite
+ *
+ *  The model gives the ROM function pointers port/scrt_aead.c calls,
+ *  nl_scrt_aes_ccm and nl_scrt_aes_ecb, as the engine behaves: it returns 1
+ *  on success and 0 on failure, takes AES-128 keys only for CCM, reads and
+ *  writes whole blocks and puts a token word after the output. A CCM
+ *  decryption with a wrong tag fails, with the plain text written anyway.
+ *
+ *  The CCM of the model is built on AES-ECB here and not on ccm.c, so the
+ *  suite compares two implementations. Any call can be made to fail.
+ */
+#ifndef SCRT_MODEL_H
+#define SCRT_MODEL_H
+
+#include <stdint.h>
+
+#define SCRT_MODEL_TOKEN        0x0000D1D1  /**< token word after the output */
+#define SCRT_MODEL_SCRIBBLE     0xA5        /**< output of a failed call */
+
+/**
+ * \brief          Calls to the model since scrt_model_reset()
+ */
+typedef struct
+{
+    uint32_t ccm;           /*!< nl_scrt_aes_ccm calls */
+    uint32_t ecb;           /*!< nl_scrt_aes_ecb calls */
+    uint32_t fail;          /*!< calls that returned 0 */
+    uint32_t tag_fail;      /*!< CCM decryptions with a wrong tag */
+    uint32_t misuse;        /*!< calls with a bad parameter or overlapping buffers */
+}
+scrt_model_stats;
+
+/**
+ * \brief          Clear the counters and any planned failure
+ */
+void scrt_model_reset( void );
+
+/**
+ * \brief          Make a later call fail
+ *
+ * \param call     1: the next call fails, 2: the one after, ...; 0: none
+ */
+void scrt_model_fail_at( uint32_t call );
+
+/**
+ * \brief          Get the counters of the model
+ */
+void scrt_model_stats_get( scrt_model_stats *stats );
+
+#endif /* scrt_model.h */
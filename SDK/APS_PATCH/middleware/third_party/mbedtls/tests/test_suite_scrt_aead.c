@@ -0,0 +1,650 @@
+/*
+ *  Host suite of the AES-CCM and AES-GCM offload to the SCRT engine
+ *
+ *  ccm.c, gcm.c and port/scrt_aead.c run as they are with MBEDTLS_SCRT_AEAD,
+ *  the engine is the software model of scrt_model.c. Every case compares the
+ *  offload with the software path of the library (the offload turned off),
+ *  and the model keeps its own CCM, so a record that passes is right twice.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mbedtls/ccm.h"
+#include "mbedtls/gcm.h"
+#include "scrt_aead.h"
+#include "scrt_model.h"
+#include "cmsis_os.h"
+
+#define TEST_BUF_LEN        1200
+
+static int test_errors;
+static const char *test_case;
+
+static void test_fail( const char *test, int line_no )
+{
+    printf( "  %s: FAILED at line %d: %s\n", test_case, line_no, test );
+    test_errors++;
+}
+
+#define TEST_ASSERT( TEST )                         \
+    do {                                            \
+        if( ! (TEST) )                              \
+        {                                           \
+            test_fail( #TEST, __LINE__ );           \
+            goto exit;                              \
+        }                                           \
+    } while( 0 )
+
+/* the tick of the bench of scrt_aead.c, in ms as osKernelSysTick() */
+static uint32_t test_tick( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return( (uint32_t) ( ts.tv_sec * 1000 + ts.tv_nsec / 1000000 ) );
+}
+
+T_osKernelSysTickFp osKernelSysTick = test_tick;
+
+static unsigned char key[32];
+static unsigned char iv[16];
+static unsigned char add[64];
+static unsigned char plain[TEST_BUF_LEN];
+static unsigned char enc_hw[TEST_BUF_LEN];
+static unsigned char enc_sw[TEST_BUF_LEN];
+static unsigned char dec[TEST_BUF_LEN];
+
+static void test_fill( unsigned char *buf, size_t len, unsigned int seed )
+{
+    size_t i;
+
+    for( i = 0; i < len; i++ )
+        buf[i] = (unsigned char) ( seed * 131 + i * 29 + ( i >> 8 ) );
+}
+
+static void test_start( void )
+{
+    test_fill( key, sizeof( key ), 1 );
+    test_fill( iv, sizeof( iv ), 2 );
+    test_fill( add, sizeof( add ), 3 );
+    test_fill( plain, sizeof( plain ), 4 );
+
+    mbedtls_scrt_aead_enable( 1 );
+    mbedtls_scrt_aead_stats_reset();
+    scrt_model_reset();
+}
+
+static int test_all_zero( const unsigned char *buf, size_t len )
+{
+    size_t i;
+
+    for( i = 0; i < len; i++ )
+        if( buf[i] != 0 )
+            return( 0 );
+
+    return( 1 );
+}
+
+/*
+ * The known vectors of SP800-38C and of the GCM spec with the offload on
+ */
+static void test_ccm_self_test( void )
+{
+    mbedtls_scrt_aead_stats st;
+
+    TEST_ASSERT( mbedtls_ccm_self_test( 1 ) == 0 );
+
+    /* three vectors, encrypted and decrypted on the engine */
+    mbedtls_scrt_aead_stats_get( &st );
+    TEST_ASSERT( st.ccm_hw == 6 );
+    TEST_ASSERT( st.ccm_sw == 0 );
+    TEST_ASSERT( st.hw_fail == 0 );
+
+exit:
+    return;
+}
+
+static void test_gcm_self_test( void )
+{
+    mbedtls_scrt_aead_stats st;
+    scrt_model_stats ms;
+
+    TEST_ASSERT( mbedtls_gcm_self_test( 1 ) == 0 );
+
+    /* the 128-bit keys get the key stream of the engine */
+    mbedtls_scrt_aead_stats_get( &st );
+    scrt_model_stats_get( &ms );
+    TEST_ASSERT( st.gcm_hw > 0 );
+    TEST_ASSERT( ms.ecb > 0 );
+    TEST_ASSERT( st.hw_fail == 0 );
+
+exit:
+    return;
+}
+
+/*
+ * CCM records of every length class, nonce and tag length on the engine and
+ * in software: the same cipher text and tag, and the way back
+ */
+static void test_ccm_engine_vs_software( void )
+{
+    static const size_t lens[] = { 1, 4, 15, 16, 17, 31, 32, 33, 255, 256, 257, 1000, 1024, 1199 };
+    static const size_t add_lens[] = { 1, 13, 14, 15, 64 };
+    mbedtls_ccm_context ctx;
+    mbedtls_scrt_aead_stats st;
+    scrt_model_stats ms;
+    unsigned char tag_hw[16];
+    unsigned char tag_sw[16];
+    size_t l, a, iv_len, tag_len;
+    uint32_t records = 0;
+
+    mbedtls_ccm_init( &ctx );
+    TEST_ASSERT( mbedtls_ccm_setkey( &ctx, MBEDTLS_CIPHER_ID_AES, key, 128 ) == 0 );
+
+    for( l = 0; l < sizeof( lens ) / sizeof( lens[0] ); l++ )
+    for( a = 0; a < sizeof( add_lens ) / sizeof( add_lens[0] ); a++ )
+    for( iv_len = 7; iv_len <= 13; iv_len += 3 )
+    for( tag_len = 4; tag_len <= 16; tag_len += 2 )
+    {
+        mbedtls_scrt_aead_enable( 1 );
+        TEST_ASSERT( mbedtls_ccm_encrypt_and_tag( &ctx, lens[l], iv, iv_len, add, add_lens[a],
+                                                  plain, enc_hw, tag_hw, tag_len ) == 0 );
+        mbedtls_scrt_aead_enable( 0 );
+        TEST_ASSERT( mbedtls_ccm_encrypt_and_tag( &ctx, lens[l], iv, iv_len, add, add_lens[a],
+                                                  plain, enc_sw, tag_sw, tag_len ) == 0 );
+
+        TEST_ASSERT( memcmp( enc_hw, enc_sw, lens[l] ) == 0 );
+        TEST_ASSERT( memcmp( tag_hw, tag_sw, tag_len ) == 0 );
+
+        mbedtls_scrt_aead_enable( 1 );
+        memset( dec, 0, lens[l] );
+        TEST_ASSERT( mbedtls_ccm_auth_decrypt( &ctx, lens[l], iv, iv_len, add, add_lens[a],
+                                               enc_hw, dec, tag_hw, tag_len ) == 0 );
+        TEST_ASSERT( memcmp( dec, plain, lens[l] ) == 0 );
+
+        records++;
+    }
+
+    /* in place, as the record layer does */
+    memcpy( dec, plain, 1024 );
+    TEST_ASSERT( mbedtls_ccm_encrypt_and_tag( &ctx, 1024, iv, 12, add, 13,
+                                              dec, dec, tag_hw, 16 ) == 0 );
+    TEST_ASSERT( mbedtls_ccm_auth_decrypt( &ctx, 1024, iv, 12, add, 13,
+                                           dec, dec, tag_hw, 16 ) == 0 );
+    TEST_ASSERT( memcmp( dec, plain, 1024 ) == 0 );
+
+    mbedtls_scrt_aead_stats_get( &st );
+    scrt_model_stats_get( &ms );
+    TEST_ASSERT( st.ccm_hw == records * 2 + 2 );
+    TEST_ASSERT( st.hw_fail == 0 );
+    TEST_ASSERT( ms.ccm == records * 2 + 2 );
+    TEST_ASSERT( ms.misuse == 0 );
+
+exit:
+    mbedtls_ccm_free( &ctx );
+}
+
+/*
+ * A wrong tag fails on the engine, which cannot tell it from a failure of its
+ * own: mbedtls_ccm_auth_decrypt() runs the record again in software, which
+ * rejects it and clears the output; the plain text the engine wrote to the
+ * bounce buffer does not get out
+ */
+static void test_ccm_tag_mismatch( void )
+{
+    static const size_t lens[] = { 1, 16, 100, 1024 };
+    mbedtls_ccm_context ctx;
+    mbedtls_scrt_aead_stats st;
+    scrt_model_stats ms;
+    unsigned char tag[16];
+    size_t l;
+    int what;
+    uint32_t checks = 0;
+
+    mbedtls_ccm_init( &ctx );
+    TEST_ASSERT( mbedtls_ccm_setkey( &ctx, MBEDTLS_CIPHER_ID_AES, key, 128 ) == 0 );
+
+    for( l = 0; l < sizeof( lens ) / sizeof( lens[0] ); l++ )
+    {
+        TEST_ASSERT( mbedtls_ccm_encrypt_and_tag( &ctx, lens[l], iv, 12, add, 13,
+                                                  plain, enc_hw, tag, 16 ) == 0 );
+
+        /* 0: the tag, 1: the cipher text, 2: the additional data */
+        for( what = 0; what < 3; what++ )
+        {
+            unsigned char *p = ( what == 0 ) ? tag + 15 :
+                               ( what == 1 ) ? enc_hw + lens[l] - 1 : add + 12;
+
+            *p ^= 0x01;
+
+            mbedtls_scrt_aead_stats_reset();
+            scrt_model_reset();
+            memset( dec, 0xEE, lens[l] );
+
+            TEST_ASSERT( mbedtls_ccm_auth_decrypt( &ctx, lens[l], iv, 12, add, 13,
+                                                   enc_hw, dec, tag, 16 ) ==
+                         MBEDTLS_ERR_CCM_AUTH_FAILED );
+            TEST_ASSERT( test_all_zero( dec, lens[l] ) );
+
+            mbedtls_scrt_aead_stats_get( &st );
+            scrt_model_stats_get( &ms );
+            TEST_ASSERT( ms.ccm == 1 && ms.tag_fail == 1 );
+            TEST_ASSERT( st.hw_fail == 1 );
+            TEST_ASSERT( st.ccm_hw == 0 && st.ccm_sw == 1 );
+
+            *p ^= 0x01;
+
+            /* the good record still passes on the engine */
+            TEST_ASSERT( mbedtls_ccm_auth_decrypt( &ctx, lens[l], iv, 12, add, 13,
+                                                   enc_hw, dec, tag, 16 ) == 0 );
+            TEST_ASSERT( memcmp( dec, plain, lens[l] ) == 0 );
+            mbedtls_scrt_aead_stats_get( &st );
+            TEST_ASSERT( st.ccm_hw == 1 );
+
+            checks++;
+        }
+    }
+
+    TEST_ASSERT( checks == 3 * sizeof( lens ) / sizeof( lens[0] ) );
+
+exit:
+    mbedtls_ccm_free( &ctx );
+}
+
+/*
+ * A failure of the engine with a good record: software takes it over and
+ * the caller gets the right result, not the scribble of the engine
+ */
+static void test_ccm_engine_failure( void )
+{
+    mbedtls_ccm_context ctx;
+    mbedtls_scrt_aead_stats st;
+    unsigned char tag_hw[16];
+    unsigned char tag_sw[16];
+
+    mbedtls_ccm_init( &ctx );
+    TEST_ASSERT( mbedtls_ccm_setkey( &ctx, MBEDTLS_CIPHER_ID_AES, key, 128 ) == 0 );
+
+    mbedtls_scrt_aead_enable( 0 );
+    TEST_ASSERT( mbedtls_ccm_encrypt_and_tag( &ctx, 300, iv, 12, add, 13,
+                                              plain, enc_sw, tag_sw, 16 ) == 0 );
+    mbedtls_scrt_aead_enable( 1 );
+    mbedtls_scrt_aead_stats_reset();
+
+    scrt_model_fail_at( 1 );
+    TEST_ASSERT( mbedtls_ccm_encrypt_and_tag( &ctx, 300, iv, 12, add, 13,
+                                              plain, enc_hw, tag_hw, 16 ) == 0 );
+    TEST_ASSERT( memcmp( enc_hw, enc_sw, 300 ) == 0 );
+    TEST_ASSERT( memcmp( tag_hw, tag_sw, 16 ) == 0 );
+
+    scrt_model_fail_at( 1 );
+    TEST_ASSERT( mbedtls_ccm_auth_decrypt( &ctx, 300, iv, 12, add, 13,
+                                           enc_sw, dec, tag_sw, 16 ) == 0 );
+    TEST_ASSERT( memcmp( dec, plain, 300 ) == 0 );
+
+    mbedtls_scrt_aead_stats_get( &st );
+    TEST_ASSERT( st.hw_fail == 2 );
+    TEST_ASSERT( st.ccm_hw == 0 && st.ccm_sw == 2 );
+    TEST_ASSERT( st.sw_bytes == 600 );
+
+exit:
+    mbedtls_ccm_free( &ctx );
+}
+
+/*
+ * What the engine does not take stays in software without a call: other key
+ * sizes, no additional data, no payload, the offload turned off
+ */
+static void test_ccm_not_for_engine( void )
+{
+    mbedtls_ccm_context ctx;
+    mbedtls_scrt_aead_stats st;
+    scrt_model_stats ms;
+    unsigned char tag[16];
+    unsigned int keybits;
+
+    mbedtls_ccm_init( &ctx );
+
+    for( keybits = 192; keybits <= 256; keybits += 64 )
+    {
+        TEST_ASSERT( mbedtls_ccm_setkey( &ctx, MBEDTLS_CIPHER_ID_AES, key, keybits ) == 0 );
+        TEST_ASSERT( mbedtls_ccm_encrypt_and_tag( &ctx, 100, iv, 12, add, 13,
+                                                  plain, enc_hw, tag, 16 ) == 0 );
+        TEST_ASSERT( mbedtls_ccm_auth_decrypt( &ctx, 100, iv, 12, add, 13,
+                                               enc_hw, dec, tag, 16 ) == 0 );
+        TEST_ASSERT( memcmp( dec, plain, 100 ) == 0 );
+    }
+
+    TEST_ASSERT( mbedtls_ccm_setkey( &ctx, MBEDTLS_CIPHER_ID_AES, key, 128 ) == 0 );
+
+    TEST_ASSERT( mbedtls_ccm_encrypt_and_tag( &ctx, 100, iv, 12, add, 0,
+                                              plain, enc_hw, tag, 16 ) == 0 );
+    TEST_ASSERT( mbedtls_ccm_auth_decrypt( &ctx, 100, iv, 12, add, 0,
+                                           enc_hw, dec, tag, 16 ) == 0 );
+    TEST_ASSERT( memcmp( dec, plain, 100 ) == 0 );
+
+    TEST_ASSERT( mbedtls_ccm_encrypt_and_tag( &ctx, 0, iv, 12, add, 13,
+                                              plain, enc_hw, tag, 16 ) == 0 );
+    TEST_ASSERT( mbedtls_ccm_auth_decrypt( &ctx, 0, iv, 12, add, 13,
+                                           enc_hw, dec, tag, 16 ) == 0 );
+
+    mbedtls_scrt_aead_enable( 0 );
+    TEST_ASSERT( mbedtls_ccm_encrypt_and_tag( &ctx, 100, iv, 12, add, 13,
+                                              plain, enc_hw, tag, 16 ) == 0 );
+
+    mbedtls_scrt_aead_stats_get( &st );
+    scrt_model_stats_get( &ms );
+    TEST_ASSERT( ms.ccm == 0 );
+    TEST_ASSERT( st.ccm_hw == 0 && st.ccm_sw == 9 );
+    TEST_ASSERT( st.hw_fail == 0 );
+
+exit:
+    mbedtls_ccm_free( &ctx );
+}
+
+/* GCM of one message in updates of the given sizes, the last may be short */
+static int test_gcm_run( mbedtls_gcm_context *ctx, int mode, size_t len,
+                         const size_t *parts, const unsigned char *input,
+                         unsigned char *output, unsigned char tag[16] )
+{
+    size_t done = 0;
+    size_t use_len;
+    int ret;
+
+    if( ( ret = mbedtls_gcm_starts( ctx, mode, iv, 12, add, 13 ) ) != 0 )
+        return( ret );
+
+    while( done < len )
+    {
+        use_len = ( parts != NULL && *parts != 0 ) ? *parts++ : len - done;
+        if( use_len > len - done )
+            use_len = len - done;
+
+        if( ( ret = mbedtls_gcm_update( ctx, use_len, input + done, output + done ) ) != 0 )
+            return( ret );
+
+        done += use_len;
+    }
+
+    return( mbedtls_gcm_finish( ctx, tag, 16 ) );
+}
+
+/*
+ * GCM messages across the batches of counter blocks: short, on a block, on a
+ * batch, one over, and in several updates; the same as software, and one
+ * engine call per batch of each update
+ */
+static void test_gcm_engine_vs_software( void )
+{
+    static const size_t lens[] = { 1, 15, 16, 17, 255, 256, 257, 271, 272, 512, 513, 1029, 1199 };
+    static const size_t split_a[] = { 16, 32, 48, 0 };
+    static const size_t split_b[] = { 256, 16, 0 };
+    static const size_t split_c[] = { 272, 0 };
+    static const size_t *splits[] = { NULL, split_a, split_b, split_c };
+    mbedtls_gcm_context ctx;
+    mbedtls_scrt_aead_stats st;
+    scrt_model_stats ms0, ms1;
+    unsigned char tag_hw[16];
+    unsigned char tag_sw[16];
+    size_t l, s, done, use_len;
+    const size_t *part;
+    uint32_t batches;
+
+    mbedtls_gcm_init( &ctx );
+    TEST_ASSERT( mbedtls_gcm_setkey( &ctx, MBEDTLS_CIPHER_ID_AES, key, 128 ) == 0 );
+
+    for( l = 0; l < sizeof( lens ) / sizeof( lens[0] ); l++ )
+    for( s = 0; s < sizeof( splits ) / sizeof( splits[0] ); s++ )
+    {
+        /* the batches the updates take */
+        batches = 0;
+        for( done = 0, part = splits[s]; done < lens[l]; done += use_len )
+        {
+            use_len = ( part != NULL && *part != 0 ) ? *part++ : lens[l] - done;
+            if( use_len > lens[l] - done )
+                use_len = lens[l] - done;
+
+            batches += (uint32_t) ( ( ( use_len + 15 ) / 16 + MBEDTLS_SCRT_AEAD_CTR_BLOCKS - 1 ) /
+                                    MBEDTLS_SCRT_AEAD_CTR_BLOCKS );
+        }
+
+        mbedtls_scrt_aead_enable( 1 );
+        scrt_model_stats_get( &ms0 );
+        TEST_ASSERT( test_gcm_run( &ctx, MBEDTLS_GCM_ENCRYPT, lens[l], splits[s],
+                                   plain, enc_hw, tag_hw ) == 0 );
+        scrt_model_stats_get( &ms1 );
+        TEST_ASSERT( ms1.ecb - ms0.ecb == batches );
+
+        mbedtls_scrt_aead_enable( 0 );
+        TEST_ASSERT( test_gcm_run( &ctx, MBEDTLS_GCM_ENCRYPT, lens[l], splits[s],
+                                   plain, enc_sw, tag_sw ) == 0 );
+
+        TEST_ASSERT( memcmp( enc_hw, enc_sw, lens[l] ) == 0 );
+        TEST_ASSERT( memcmp( tag_hw, tag_sw, 16 ) == 0 );
+
+        mbedtls_scrt_aead_enable( 1 );
+        TEST_ASSERT( test_gcm_run( &ctx, MBEDTLS_GCM_DECRYPT, lens[l], splits[s],
+                                   enc_hw, dec, tag_sw ) == 0 );
+        TEST_ASSERT( memcmp( dec, plain, lens[l] ) == 0 );
+        TEST_ASSERT( memcmp( tag_hw, tag_sw, 16 ) == 0 );
+    }
+
+    /* in place, through the one-shot calls */
+    memcpy( dec, plain, 1024 );
+    TEST_ASSERT( mbedtls_gcm_crypt_and_tag( &ctx, MBEDTLS_GCM_ENCRYPT, 1024, iv, 12, add, 13,
+                                            dec, dec, 16, tag_hw ) == 0 );
+    TEST_ASSERT( mbedtls_gcm_auth_decrypt( &ctx, 1024, iv, 12, add, 13, tag_hw, 16,
+                                           dec, dec ) == 0 );
+    TEST_ASSERT( memcmp( dec, plain, 1024 ) == 0 );
+
+    mbedtls_scrt_aead_stats_get( &st );
+    scrt_model_stats_get( &ms1 );
+    TEST_ASSERT( st.hw_fail == 0 );
+    TEST_ASSERT( ms1.misuse == 0 );
+
+exit:
+    mbedtls_gcm_free( &ctx );
+}
+
+/*
+ * The engine fails in the middle of an update: the counter stays at the last
+ * batch done and software goes on from there
+ */
+static void test_gcm_engine_failure( void )
+{
+    mbedtls_gcm_context ctx;
+    mbedtls_scrt_aead_stats st;
+    unsigned char tag_hw[16];
+    unsigned char tag_sw[16];
+    uint32_t at;
+
+    mbedtls_gcm_init( &ctx );
+    TEST_ASSERT( mbedtls_gcm_setkey( &ctx, MBEDTLS_CIPHER_ID_AES, key, 128 ) == 0 );
+
+    mbedtls_scrt_aead_enable( 0 );
+    TEST_ASSERT( mbedtls_gcm_crypt_and_tag( &ctx, MBEDTLS_GCM_ENCRYPT, 1100, iv, 12, add, 13,
+                                            plain, enc_sw, 16, tag_sw ) == 0 );
+    mbedtls_scrt_aead_enable( 1 );
+
+    /* 1100 bytes are 5 batches, fail each of them */
+    for( at = 1; at <= 5; at++ )
+    {
+        mbedtls_scrt_aead_stats_reset();
+        memset( enc_hw, 0, sizeof( enc_hw ) );
+
+        scrt_model_fail_at( at );
+        TEST_ASSERT( mbedtls_gcm_crypt_and_tag( &ctx, MBEDTLS_GCM_ENCRYPT, 1100, iv, 12, add, 13,
+                                                plain, enc_hw, 16, tag_hw ) == 0 );
+        TEST_ASSERT( memcmp( enc_hw, enc_sw, 1100 ) == 0 );
+        TEST_ASSERT( memcmp( tag_hw, tag_sw, 16 ) == 0 );
+
+        mbedtls_scrt_aead_stats_get( &st );
+        TEST_ASSERT( st.hw_fail == 1 );
+        TEST_ASSERT( st.gcm_sw == 1 );
+        TEST_ASSERT( st.gcm_hw == ( at > 1 ) );
+        TEST_ASSERT( st.hw_bytes == ( at - 1 ) * MBEDTLS_SCRT_AEAD_CTR_BLOCKS * 16 );
+        TEST_ASSERT( st.hw_bytes + st.sw_bytes == 1100 );
+    }
+
+exit:
+    mbedtls_gcm_free( &ctx );
+}
+
+/*
+ * A wrong tag of GCM is found by the software GHASH, the output is cleared
+ */
+static void test_gcm_tag_mismatch( void )
+{
+    mbedtls_gcm_context ctx;
+    mbedtls_scrt_aead_stats st;
+    unsigned char tag[16];
+
+    mbedtls_gcm_init( &ctx );
+    TEST_ASSERT( mbedtls_gcm_setkey( &ctx, MBEDTLS_CIPHER_ID_AES, key, 128 ) == 0 );
+
+    TEST_ASSERT( mbedtls_gcm_crypt_and_tag( &ctx, MBEDTLS_GCM_ENCRYPT, 600, iv, 12, add, 13,
+                                            plain, enc_hw, 16, tag ) == 0 );
+
+    tag[0] ^= 0x80;
+    memset( dec, 0xEE, 600 );
+    TEST_ASSERT( mbedtls_gcm_auth_decrypt( &ctx, 600, iv, 12, add, 13, tag, 16,
+                                           enc_hw, dec ) == MBEDTLS_ERR_GCM_AUTH_FAILED );
+    TEST_ASSERT( test_all_zero( dec, 600 ) );
+    tag[0] ^= 0x80;
+
+    enc_hw[599] ^= 0x01;
+    TEST_ASSERT( mbedtls_gcm_auth_decrypt( &ctx, 600, iv, 12, add, 13, tag, 16,
+                                           enc_hw, dec ) == MBEDTLS_ERR_GCM_AUTH_FAILED );
+    TEST_ASSERT( test_all_zero( dec, 600 ) );
+    enc_hw[599] ^= 0x01;
+
+    TEST_ASSERT( mbedtls_gcm_auth_decrypt( &ctx, 600, iv, 12, add, 13, tag, 16,
+                                           enc_hw, dec ) == 0 );
+    TEST_ASSERT( memcmp( dec, plain, 600 ) == 0 );
+
+    mbedtls_scrt_aead_stats_get( &st );
+    TEST_ASSERT( st.gcm_hw == 4 && st.gcm_sw == 0 );
+    TEST_ASSERT( st.hw_fail == 0 );
+
+exit:
+    mbedtls_gcm_free( &ctx );
+}
+
+static void test_gcm_not_for_engine( void )
+{
+    mbedtls_gcm_context ctx;
+    mbedtls_scrt_aead_stats st;
+    scrt_model_stats ms;
+    unsigned char tag[16];
+    unsigned int keybits;
+
+    mbedtls_gcm_init( &ctx );
+
+    for( keybits = 192; keybits <= 256; keybits += 64 )
+    {
+        TEST_ASSERT( mbedtls_gcm_setkey( &ctx, MBEDTLS_CIPHER_ID_AES, key, keybits ) == 0 );
+        TEST_ASSERT( mbedtls_gcm_crypt_and_tag( &ctx, MBEDTLS_GCM_ENCRYPT, 300, iv, 12, add, 13,
+                                                plain, enc_hw, 16, tag ) == 0 );
+        TEST_ASSERT( mbedtls_gcm_auth_decrypt( &ctx, 300, iv, 12, add, 13, tag, 16,
+                                               enc_hw, dec ) == 0 );
+        TEST_ASSERT( memcmp( dec, plain, 300 ) == 0 );
+    }
+
+    mbedtls_scrt_aead_stats_get( &st );
+    scrt_model_stats_get( &ms );
+    TEST_ASSERT( ms.ecb == 0 );
+    TEST_ASSERT( st.gcm_hw == 0 && st.gcm_sw == 4 );
+
+exit:
+    mbedtls_gcm_free( &ctx );
+}
+
+/*
+ * The diag command: the random records of tlsaead test and the bench,
+ * against the model
+ */
+static void test_diag_cmd( void )
+{
+    char cmd[32];
+    mbedtls_scrt_aead_stats st;
+    scrt_model_stats ms;
+
+    srand( 1 );
+
+    strcpy( cmd, "tlsaead test 200" );
+    mbedtls_scrt_aead_cmd( cmd );
+
+    /* a wrong tag of CCM and of GCM a record, only CCM checks it on the engine */
+    mbedtls_scrt_aead_stats_get( &st );
+    scrt_model_stats_get( &ms );
+    TEST_ASSERT( ms.tag_fail == 200 );
+    TEST_ASSERT( st.hw_fail == 200 );
+    TEST_ASSERT( ms.misuse == 0 );
+
+    strcpy( cmd, "tlsaead bench 64" );
+    mbedtls_scrt_aead_cmd( cmd );
+
+    strcpy( cmd, "tlsaead" );
+    mbedtls_scrt_aead_cmd( cmd );
+
+exit:
+    return;
+}
+
+typedef struct
+{
+    const char *name;
+    void (*run)( void );
+}
+test_entry;
+
+static const test_entry tests[] =
+{
+    { "ccm_self_test",              test_ccm_self_test },
+    { "gcm_self_test",              test_gcm_self_test },
+    { "ccm_engine_vs_software",     test_ccm_engine_vs_software },
+    { "ccm_tag_mismatch",           test_ccm_tag_mismatch },
+    { "ccm_engine_failure",         test_ccm_engine_failure },
+    { "ccm_not_for_engine",         test_ccm_not_for_engine },
+    { "gcm_engine_vs_software",     test_gcm_engine_vs_software },
+    { "gcm_engine_failure",         test_gcm_engine_failure },
+    { "gcm_tag_mismatch",           test_gcm_tag_mismatch },
+    { "gcm_not_for_engine",         test_gcm_not_for_engine },
+    { "diag_cmd",                   test_diag_cmd },
+};
+
+int main( void )
+{
+    size_t i;
+    int errors;
+    int failed = 0;
+
+    for( i = 0; i < sizeof( tests ) / sizeof( tests[0] ); i++ )
+    {
+        test_case = tests[i].name;
+        errors = test_errors;
+
+        test_start();
+        tests[i].run();
+
+        printf( "%-40s %s\n", tests[i].name, ( test_errors == errors ) ? "PASS" : "FAILED" );
+        failed += ( test_errors != errors );
+    }
+
+    printf( "\n----------------------------------------------------------------------------\n\n" );
+    printf( "%s (%d / %d tests)\n", failed ? "FAILED" : "PASSED",
+            (int) ( sizeof( tests ) / sizeof( tests[0] ) ) - failed,
+            (int) ( sizeof( tests ) / sizeof( tests[0] ) ) );
+
+    return( failed ? 1 : 0 );
+}
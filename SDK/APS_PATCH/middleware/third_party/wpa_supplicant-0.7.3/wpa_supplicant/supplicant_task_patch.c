@@ -38,9 +38,13 @@
 #include "at_cmd_msg_ext.h"
 #include "at_cmd_msg_ext.h"
 #include "controller_wifi_com_patch.h"
+#include "sys_wdt.h"
 
 extern struct wpa_supplicant *wpa_s;
 extern auto_connect_cfg_t g_AutoConnect; //Fast Connect Report
+extern osPoolId supplicantMemPoolId;
+
+static int g_iSuppWdtId = -1;
 
 void supplicant_task_evt_handle_patch(uint32_t evt_type)
 {
@@ -149,6 +153,9 @@ void supplicant_task_evt_handle_patch(uint32_t evt_type)
         case MLME_EVT_AUTO_CONNECT_START:
             msg_print(LOG_HIGH_LEVEL, "Supplicant Receive EVT_AUTO_CONNECT_START \r\n");
             control_auto_connect();
+            break;
+        case SUPPLICANT_EVT_WDT_PROBE:
+            Sys_WdtKick(g_iSuppWdtId);
             break;
 
 		default:
@@ -156,6 +163,34 @@ void supplicant_task_evt_handle_patch(uint32_t evt_type)
 	}
 }
 
+/*
+   The liveness probe of the watchdog supervisor, sent from the idle hook:
+   supplicant_task_send waits for the pool and the queue, this does not.
+ */
+int supplicant_task_wdt_probe(int iId)
+{
+    xSupplicantMessage_t *pMsg = NULL;
+
+    g_iSuppWdtId = iId;
+
+    if (xSupplicantQueue == NULL)
+        return -1;
+
+    pMsg = (xSupplicantMessage_t *)osPoolCAlloc(supplicantMemPoolId);
+    if (pMsg == NULL)
+        return -1;
+
+    pMsg->event = SUPPLICANT_EVT_WDT_PROBE;
+
+    if (osMessagePut(xSupplicantQueue, (uint32_t)pMsg, 0) != osOK)
+    {
+        osPoolFree(supplicantMemPoolId, pMsg);
+        return -1;
+    }
+
+    return 0;
+}
+
 /*
    Interface Initialization: Supplicant Task
  */
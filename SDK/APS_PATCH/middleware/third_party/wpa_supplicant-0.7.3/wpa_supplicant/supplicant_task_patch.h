@@ -12,6 +12,10 @@
 #ifndef _SUPPLICANT_TASK_PATCH_H_
 #define _SUPPLICANT_TASK_PATCH_H_
 
+// private, the liveness probe of the watchdog supervisor (sys_wdt.h)
+#define SUPPLICANT_EVT_WDT_PROBE    0xF0
+
 void wpa_supplicant_task_func_init_patch(void);
+int supplicant_task_wdt_probe(int iId);
 
 #endif /* _SUPPLICANT_TASK_PATCH_H_ */
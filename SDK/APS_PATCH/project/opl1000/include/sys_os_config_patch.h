@@ -29,14 +29,26 @@ extern "C" {
 // Sec 2: Constant Definitions, Imported Symbols, miscellaneous
 // Task - Priority, the type of cmsis_os priority
 #define OS_TASK_PRIORITY_AGENT          osPriorityLow
+#define OS_TASK_PRIORITY_LWIP_BENCH     osPriorityNormal
+#define OS_TASK_PRIORITY_FLASH_SVC      osPriorityLow
+#define OS_TASK_PRIORITY_LOG_FLASH      osPriorityLow
+#define OS_TASK_PRIORITY_CRYPTO_TEST    osPriorityLow
 
 // Task - Stack Size, the count of 4 bytes
 #define OS_TASK_STACK_SIZE_TRACER_PATCH (128)
 #define OS_TASK_STACK_SIZE_AGENT        (128)
+#define OS_TASK_STACK_SIZE_LWIP_BENCH   (256)
+#define OS_TASK_STACK_SIZE_FLASH_SVC    (128)
+#define OS_TASK_STACK_SIZE_LOG_FLASH    (256)
+#define OS_TASK_STACK_SIZE_CRYPTO_TEST  (1024)
 
 
 // Task - Name (max length is 15 bytes (not including '\0'))
 #define OS_TASK_NAME_AGENT              "opl_agent"
+#define OS_TASK_NAME_LWIP_BENCH         "lwip_bench"
+#define OS_TASK_NAME_FLASH_SVC          "flash_svc"
+#define OS_TASK_NAME_LOG_FLASH          "log_flash"
+#define OS_TASK_NAME_CRYPTO_TEST        "crypto_test"
 
 
 /******************************
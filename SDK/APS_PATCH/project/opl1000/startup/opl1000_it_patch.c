@@ -20,9 +20,12 @@
 #include "hal_tmr.h"
 #include "hal_i2c.h"
 #include "hal_wdt.h"
+#include "hal_spi_master.h"
 
 #include "ipc.h"
 #include "diag_task.h"
+#include "sys_fault.h"
+#include "sys_boot.h"
 
 #ifdef ENHANCE_IPC
 #else
@@ -52,14 +55,57 @@ extern T_InterruptHandler WDT_IRQHandler_Entry;
 extern T_InterruptHandler JTAG_IRQHandler_Entry;
 extern T_InterruptHandler DMA_IRQHandler_Entry;
 
+void IPC0_IRQHandler_Entry_patch(void)
+{
+    // Clear interrupt
+    Hal_Vic_IpcIntClear(IPC_IDX_0);
+
+    // the M0 is up, wake the boot sequencer
+    Sys_BootM0Isr();
+
+    //IPC0 bit0
+    #ifdef ENHANCE_IPC
+        #ifdef IPC_SUT
+            ipc_peer_ready(1, 1);
+        #endif
+    #else
+        g_INIT_DATA_FLOW = 1;
+        data_flow_task();
+    #endif
+}
+
 void WDT_IRQHandler_Entry_patch(void)
 {
     printf("Watchdog expired!!\r\n");
     // VIC 1) Clear interrupt
     Hal_Vic_IntClear(WDT_IRQn);
+
+    // save the crash record and reset, no return
+    Sys_FaultWdtCapture();
+}
+void SPI1_IRQHandler_Entry_patch(void)
+{
+    // handle the queued transfers
+    Hal_Spi_MasterIntHandler(SPI_IDX_1);
+
+    // Clear VIC interrupt
+    Hal_Vic_IntClear(SPI1_IRQn);
 }
+
+void SPI2_IRQHandler_Entry_patch(void)
+{
+    // handle the queued transfers
+    Hal_Spi_MasterIntHandler(SPI_IDX_2);
+
+    // Clear VIC interrupt
+    Hal_Vic_IntClear(SPI2_IRQn);
+}
+
 void ISR_Pre_Init_patch(void)
 {
+    IPC0_IRQHandler_Entry    = IPC0_IRQHandler_Entry_patch;
     WDT_IRQHandler_Entry     = WDT_IRQHandler_Entry_patch;
+    SPI1_IRQHandler_Entry    = SPI1_IRQHandler_Entry_patch;
+    SPI2_IRQHandler_Entry    = SPI2_IRQHandler_Entry_patch;
 }
 
@@ -0,0 +1,712 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_boot.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This source file defines the boot sequencer, the M0 ready handshake, the
+*  boot timeline and the "boot" diag command.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "sys_common.h"
+#include "sys_init.h"
+#include "hal_system.h"
+#include "hal_tick.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "sys_boot.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SYS_BOOT_M0_READY_MSK       (1 << 4)        // SPARE_0, set by the M0
+
+#define SYS_BOOT_PARAM_MAX          2
+
+#define SYS_BOOT_CRIT_ENTER(x)      do { x = __get_PRIMASK(); __disable_irq(); } while(0)
+#define SYS_BOOT_CRIT_EXIT(x)       __set_PRIMASK(x)
+
+#define SYS_BOOT_LOG(...)           tracer_cli(LOG_HIGH_LEVEL, __VA_ARGS__)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    const char *sName;
+    uint32_t u32Tick;               // since the boot base
+} S_SysBootMark_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+static const S_SysBootStep_t *g_ptSysBootStep;
+static uint32_t g_u32SysBootStepNum;
+static uint32_t g_u32SysBootDone;                       // SYS_BOOT_DEP() of the steps done
+static uint8_t g_u8aSysBootState[SYS_BOOT_STEP_MAX];
+static uint32_t g_u32aSysBootStart[SYS_BOOT_STEP_MAX];  // ticks since the base
+static uint32_t g_u32aSysBootTime[SYS_BOOT_STEP_MAX];
+
+static S_SysBootMark_t g_taSysBootMark[SYS_BOOT_MARK_MAX];
+static uint32_t g_u32SysBootMarkNum;
+static uint32_t g_u32SysBootBase;
+
+static uint8_t g_u8SysBootM0Ready;
+static uint32_t g_u32SysBootM0Tick;                     // first seen up
+static uint32_t g_u32SysBootM0Wait;                     // ticks waited for it
+static osSemaphoreId g_tSysBootM0Sem;                   // released by the IPC0 handler
+
+static const char *g_saSysBootState[] = {"pending", "running", "done"};
+
+static T_Sys_AppInit_fp g_fpSysBootAppInit;
+static osTimerId g_tSysBootDeferTimer;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static uint32_t _Sys_BootNow(void)
+{
+    return Hal_Tick_Diff(g_u32SysBootBase);
+}
+
+static uint32_t _Sys_BootUs(uint32_t u32Tick)
+{
+    return (uint32_t)(((uint64_t)u32Tick * 1000) / Hal_Tick_PerMilliSec());
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_BootMark
+*
+* DESCRIPTION:
+*   1. Add a phase to the timeline. The first mark is the time base, it
+*      must follow the clock setup.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. sName : [In] a constant string
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_BootMark(const char *sName)
+{
+    uint32_t u32Tick = 0;
+
+    if (g_u32SysBootMarkNum == 0)
+    {
+        Hal_Tick_Init();
+        Hal_Tick_DiffEx(0, &g_u32SysBootBase);
+    }
+    else
+    {
+        u32Tick = _Sys_BootNow();
+    }
+
+    if (g_u32SysBootMarkNum >= SYS_BOOT_MARK_MAX)
+        return;
+
+    g_taSysBootMark[g_u32SysBootMarkNum].sName = sName;
+    g_taSysBootMark[g_u32SysBootMarkNum].u32Tick = u32Tick;
+    g_u32SysBootMarkNum++;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_BootM0Poll
+*
+* DESCRIPTION:
+*   1. Check the M0 ready flag without waiting, the flag is cleared for the
+*      next boot once seen
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   1: the M0 is up
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint8_t Sys_BootM0Poll(void)
+{
+    uint32_t u32Val = 0;
+
+    if (g_u8SysBootM0Ready)
+        return 1;
+
+    Hal_Sys_SpareRegRead(SPARE_0, &u32Val);
+
+    if (!(u32Val & SYS_BOOT_M0_READY_MSK))
+        return 0;
+
+    Hal_Sys_SpareRegWrite(SPARE_0, u32Val & ~SYS_BOOT_M0_READY_MSK);
+
+    g_u8SysBootM0Ready = 1;
+    g_u32SysBootM0Tick = g_u32SysBootMarkNum ? _Sys_BootNow() : 0;
+    return 1;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_BootM0Isr
+*
+* DESCRIPTION:
+*   1. The M0 raises IPC0 once it is up: wake Sys_BootM0Wait. Called by the
+*      IPC0 handler, the flag itself is read by the waiter.
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_BootM0Isr(void)
+{
+    if (g_tSysBootM0Sem != NULL)
+        osSemaphoreRelease(g_tSysBootM0Sem);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_BootM0Wait
+*
+* DESCRIPTION:
+*   1. Wait until the M0 is up, print once if it is late
+*   2. The wait blocks on the semaphore of the IPC0 handler. Before the
+*      kernel starts it cannot block, the core sleeps until the next
+*      interrupt instead; FreeRTOS keeps BASEPRI raised from its first
+*      critical section until then, so it is opened for the wait.
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_BootM0Wait(void)
+{
+    uint32_t u32Start = 0;
+    uint32_t u32Warn = 0;
+    uint32_t u32Basepri = 0;
+    uint32_t u32Primask = 0;
+    uint8_t u8Kernel = 0;
+    uint8_t u8Late = 0;
+
+    if (Sys_BootM0Poll())
+        return;
+
+    Hal_Tick_Init();
+    Hal_Tick_DiffEx(0, &u32Start);
+    u32Warn = SYS_BOOT_M0_WARN_MS * Hal_Tick_PerMilliSec();
+
+    u8Kernel = (osKernelRunning() > 0) ? 1 : 0;
+    u32Basepri = __get_BASEPRI();
+
+    while (!Sys_BootM0Poll())
+    {
+        if (g_tSysBootM0Sem == NULL)
+        {
+            // no semaphore, poll the flag
+        }
+        else if (u8Kernel)
+        {
+            osSemaphoreWait(g_tSysBootM0Sem, SYS_BOOT_M0_WARN_MS);
+        }
+        else
+        {
+            // the IPC0 handler may run between the check and the sleep: WFI
+            // with PRIMASK set still wakes up on it, and it runs right after
+            u32Primask = __get_PRIMASK();
+            __disable_irq();
+
+            if (osSemaphoreWait(g_tSysBootM0Sem, 0) != osOK)
+            {
+                __set_BASEPRI(0);
+                __WFI();
+            }
+
+            __set_PRIMASK(u32Primask);
+        }
+
+        if (!u8Late && (Hal_Tick_Diff(u32Start) > u32Warn))
+        {
+            printf("boot: M0 not ready after %u ms\n", SYS_BOOT_M0_WARN_MS);
+            u8Late = 1;
+        }
+    }
+
+    if (!u8Kernel)
+        __set_BASEPRI(u32Basepri);
+
+    g_u32SysBootM0Wait += Hal_Tick_Diff(u32Start);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_BootInit
+*
+* DESCRIPTION:
+*   1. Set the step table and clear the timeline, for every boot (cold and
+*      warm). A dependency on a later step or from a step on a deferred one
+*      is reported.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptStep : [In] the steps, constant
+*   2. u32Num : [In] up to SYS_BOOT_STEP_MAX
+*
+* RETURNS
+*   0  : success
+*   -1 : the table is not valid
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+int Sys_BootInit(const S_SysBootStep_t *ptStep, uint32_t u32Num)
+{
+    osSemaphoreDef_t tSemaphoreDef;
+    uint32_t u32Defer = 0;
+    uint32_t i = 0;
+    int iRet = 0;
+
+    if (u32Num > SYS_BOOT_STEP_MAX)
+        u32Num = SYS_BOOT_STEP_MAX;
+
+    g_ptSysBootStep = ptStep;
+    g_u32SysBootStepNum = u32Num;
+    g_u32SysBootDone = 0;
+    g_u32SysBootMarkNum = 0;
+    g_u8SysBootM0Ready = 0;
+    g_u32SysBootM0Tick = 0;
+    g_u32SysBootM0Wait = 0;
+
+    // a binary semaphore starts given, and a warm boot may have left it given
+    if (g_tSysBootM0Sem == NULL)
+    {
+        tSemaphoreDef.dummy = 0;                        // reserved, it is no used
+        g_tSysBootM0Sem = osSemaphoreCreate(&tSemaphoreDef, 1);
+    }
+
+    if (g_tSysBootM0Sem != NULL)
+        osSemaphoreWait(g_tSysBootM0Sem, 0);
+    else
+        printf("boot: no M0 semaphore, the wait polls\n");
+
+    memset(g_u8aSysBootState, SYS_BOOT_STATE_PENDING, sizeof(g_u8aSysBootState));
+    memset(g_u32aSysBootStart, 0, sizeof(g_u32aSysBootStart));
+    memset(g_u32aSysBootTime, 0, sizeof(g_u32aSysBootTime));
+
+    for (i = 0; i < u32Num; i++)
+    {
+        // a step may only wait for the ones before it, so there is no cycle
+        if (ptStep[i].u32Deps & ~(SYS_BOOT_DEP(i) - 1))
+        {
+            printf("boot: %s depends on a later step\n", ptStep[i].sName);
+            iRet = -1;
+        }
+
+        if (!(ptStep[i].u8Flag & SYS_BOOT_FLAG_DEFER) && (ptStep[i].u32Deps & u32Defer))
+        {
+            printf("boot: %s depends on a deferred step\n", ptStep[i].sName);
+            iRet = -1;
+        }
+
+        if ((ptStep[i].u8Flag & SYS_BOOT_FLAG_DEFER) && (ptStep[i].u8Stage != SYS_BOOT_STAGE_SERVICE))
+        {
+            printf("boot: %s deferred out of the service stage\n", ptStep[i].sName);
+            iRet = -1;
+        }
+
+        if (ptStep[i].u8Flag & SYS_BOOT_FLAG_DEFER)
+            u32Defer |= SYS_BOOT_DEP(i);
+    }
+
+    return iRet;
+}
+
+static void _Sys_BootStepRun(uint32_t u32Idx)
+{
+    const S_SysBootStep_t *ptStep = &g_ptSysBootStep[u32Idx];
+
+    g_u8aSysBootState[u32Idx] = SYS_BOOT_STATE_RUNNING;
+    g_u32aSysBootStart[u32Idx] = _Sys_BootNow();
+
+    ptStep->fpFunc();
+
+    g_u32aSysBootTime[u32Idx] = _Sys_BootNow() - g_u32aSysBootStart[u32Idx];
+    g_u32SysBootDone |= SYS_BOOT_DEP(u32Idx);
+    g_u8aSysBootState[u32Idx] = SYS_BOOT_STATE_DONE;
+}
+
+// the first step in the table order that can run now, -1 if none
+static int _Sys_BootStepNext(uint32_t u32Stage, uint8_t u8M0)
+{
+    const S_SysBootStep_t *ptStep = NULL;
+    uint32_t i = 0;
+
+    for (i = 0; i < g_u32SysBootStepNum; i++)
+    {
+        ptStep = &g_ptSysBootStep[i];
+
+        if ((g_u8aSysBootState[i] != SYS_BOOT_STATE_PENDING) || (ptStep->u8Stage > u32Stage))
+            continue;
+
+        if (ptStep->u8Flag & SYS_BOOT_FLAG_DEFER)
+            continue;
+
+        if (ptStep->u32Deps & ~g_u32SysBootDone)
+            continue;
+
+        if ((ptStep->u8Flag & SYS_BOOT_FLAG_M0) && !u8M0)
+            continue;
+
+        return i;
+    }
+
+    return -1;
+}
+
+static uint8_t _Sys_BootLeft(uint32_t u32Stage)
+{
+    uint32_t i = 0;
+
+    for (i = 0; i < g_u32SysBootStepNum; i++)
+    {
+        if ((g_u8aSysBootState[i] == SYS_BOOT_STATE_PENDING) && (g_ptSysBootStep[i].u8Stage <= u32Stage) &&
+            !(g_ptSysBootStep[i].u8Flag & SYS_BOOT_FLAG_DEFER))
+            return 1;
+    }
+
+    return 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_BootRun
+*
+* DESCRIPTION:
+*   1. Run the steps of the stage (and the ones left of the stages before)
+*      that can run. The M0 is polled between the steps.
+*   2. u8Finish: wait for the M0 when only the steps needing it are left,
+*      and return when all of them are done. Else the steps needing the M0
+*      stay for the next stage.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. u32Stage : [In] E_SysBootStage_t
+*   2. u8Finish : [In] 1: run every step up to the stage
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_BootRun(uint32_t u32Stage, uint8_t u8Finish)
+{
+    int iIdx = 0;
+    uint32_t i = 0;
+
+    while (1)
+    {
+        iIdx = _Sys_BootStepNext(u32Stage, Sys_BootM0Poll());
+
+        if (iIdx >= 0)
+        {
+            _Sys_BootStepRun(iIdx);
+            continue;
+        }
+
+        if (!u8Finish || !_Sys_BootLeft(u32Stage))
+            break;
+
+        if (!g_u8SysBootM0Ready)
+        {
+            Sys_BootM0Wait();
+            continue;
+        }
+
+        // not reachable with a valid table, keep the boot going in order
+        printf("boot: dependency stall\n");
+
+        for (i = 0; i < g_u32SysBootStepNum; i++)
+        {
+            if ((g_u8aSysBootState[i] == SYS_BOOT_STATE_PENDING) && (g_ptSysBootStep[i].u8Stage <= u32Stage) &&
+                !(g_ptSysBootStep[i].u8Flag & SYS_BOOT_FLAG_DEFER))
+                _Sys_BootStepRun(i);
+        }
+
+        break;
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_BootUse
+*
+* DESCRIPTION:
+*   1. Run a deferred step now if it has not run, for its first user, and
+*      the deferred steps it depends on before it. Task context.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. sName : [In] the step
+*
+* RETURNS
+*   0  : done (now or before)
+*   -1 : no such step
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+int Sys_BootUse(const char *sName)
+{
+    uint32_t u32Primask = 0;
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint8_t u8Run = 0;
+
+    for (i = 0; i < g_u32SysBootStepNum; i++)
+    {
+        if (!strcmp(g_ptSysBootStep[i].sName, sName))
+            break;
+    }
+
+    if (i >= g_u32SysBootStepNum)
+        return -1;
+
+    // the deferred steps it depends on first, they are earlier in the table
+    for (j = 0; j < i; j++)
+    {
+        if ((g_ptSysBootStep[i].u32Deps & SYS_BOOT_DEP(j)) && (g_ptSysBootStep[j].u8Flag & SYS_BOOT_FLAG_DEFER))
+            Sys_BootUse(g_ptSysBootStep[j].sName);
+    }
+
+    SYS_BOOT_CRIT_ENTER(u32Primask);
+
+    if (g_u8aSysBootState[i] == SYS_BOOT_STATE_PENDING)
+    {
+        g_u8aSysBootState[i] = SYS_BOOT_STATE_RUNNING;
+        u8Run = 1;
+    }
+
+    SYS_BOOT_CRIT_EXIT(u32Primask);
+
+    if (u8Run)
+    {
+        _Sys_BootStepRun(i);
+        return 0;
+    }
+
+    // the other user is running it
+    while (g_u8aSysBootState[i] != SYS_BOOT_STATE_DONE)
+        osDelay(1);
+
+    return 0;
+}
+
+static void _Sys_BootDeferTimer(void const *argu)
+{
+    uint32_t i = 0;
+
+    for (i = 0; i < g_u32SysBootStepNum; i++)
+    {
+        if (g_ptSysBootStep[i].u8Flag & SYS_BOOT_FLAG_DEFER)
+            Sys_BootUse(g_ptSysBootStep[i].sName);
+    }
+}
+
+static void _Sys_BootAppInit(void)
+{
+    osTimerDef_t tTimerDef;
+
+    Sys_BootMark("app");
+
+    if (g_fpSysBootAppInit)
+        g_fpSysBootAppInit();
+
+    Sys_BootMark("app done");
+
+    // the deferred steps, once the kernel runs
+    if (g_tSysBootDeferTimer == NULL)
+    {
+        tTimerDef.ptimer = _Sys_BootDeferTimer;
+        g_tSysBootDeferTimer = osTimerCreate(&tTimerDef, osTimerOnce, NULL);
+    }
+
+    if (g_tSysBootDeferTimer != NULL)
+        osTimerStart(g_tSysBootDeferTimer, SYS_BOOT_DEFER_MS);
+    else
+        _Sys_BootDeferTimer(NULL);
+
+    Sys_BootDump();
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_BootAppHook
+*
+* DESCRIPTION:
+*   1. Wrap Sys_AppInit for the time to the application and the start of
+*      the deferred steps. At the end of Sys_ServiceInit, the application
+*      sets Sys_AppInit after SysInit_EntryPoint.
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_BootAppHook(void)
+{
+    if (Sys_AppInit == _Sys_BootAppInit)
+        return;
+
+    g_fpSysBootAppInit = Sys_AppInit;
+    Sys_AppInit = _Sys_BootAppInit;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_BootDump
+*
+* DESCRIPTION:
+*   1. Print the timeline of the last boot
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_BootDump(void)
+{
+    const S_SysBootStep_t *ptStep = NULL;
+    uint32_t i = 0;
+
+    printf("boot: M0 up at %u us, waited %u us\n",
+           g_u8SysBootM0Ready ? _Sys_BootUs(g_u32SysBootM0Tick) : 0, _Sys_BootUs(g_u32SysBootM0Wait));
+
+    for (i = 0; i < g_u32SysBootMarkNum; i++)
+        printf("  %-12s %8u us\n", g_taSysBootMark[i].sName, _Sys_BootUs(g_taSysBootMark[i].u32Tick));
+
+    printf("  %-12s %8s %8s %s\n", "step", "start", "us", "");
+
+    for (i = 0; i < g_u32SysBootStepNum; i++)
+    {
+        ptStep = &g_ptSysBootStep[i];
+
+        printf("  %-12s %8u %8u %s%s%s\n", ptStep->sName, _Sys_BootUs(g_u32aSysBootStart[i]),
+               _Sys_BootUs(g_u32aSysBootTime[i]), g_saSysBootState[g_u8aSysBootState[i]],
+               (ptStep->u8Flag & SYS_BOOT_FLAG_M0) ? " m0" : "",
+               (ptStep->u8Flag & SYS_BOOT_FLAG_DEFER) ? " defer" : "");
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Sys_BootCmd
+*
+* DESCRIPTION:
+*   diag command: boot [use <step>]
+*     no argument: the boot timeline
+*     use: run a deferred step now
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void Sys_BootCmd(char *sCmd)
+{
+    char *baParam[SYS_BOOT_PARAM_MAX + 1] = {0};
+    uint32_t u32Num = 0;
+
+    u32Num = ParseParam(sCmd, baParam, SYS_BOOT_PARAM_MAX + 1);
+
+    if (u32Num < 2)
+    {
+        Sys_BootDump();
+        goto done;
+    }
+
+    if ((u32Num >= 3) && (!strcmp(baParam[1], "use")))
+    {
+        SYS_BOOT_LOG("boot: %s %s\n", baParam[2], Sys_BootUse(baParam[2]) ? "no such step" : "done");
+        goto done;
+    }
+
+    SYS_BOOT_LOG("usage: boot [use <step>]\n");
+
+done:
+    return;
+}
@@ -0,0 +1,117 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_boot.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This include file defines the boot sequencer of the M3.
+*
+*  The init after the driver setup is a table of steps. A step may need the
+*  M0 (MSQ) to be up, and may depend on earlier steps. The M0 ready flag is
+*  polled between the steps and the steps that do not need the M0 run while
+*  it boots. When nothing else is left the M3 sleeps until the M0 raises
+*  IPC0, the handler calls Sys_BootM0Isr. A deferred step runs
+*  SYS_BOOT_DEFER_MS after the kernel starts, or at the first Sys_BootUse
+*  of it.
+*
+*  Every step and phase mark is timed with the DWT cycle counter, the
+*  timeline is printed after the application init of a cold boot and by the
+*  "boot" diag command (the last boot, a warm boot runs the driver stage).
+*
+******************************************************************************/
+#ifndef __SYS_BOOT_H__
+#define __SYS_BOOT_H__
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdint.h>
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SYS_BOOT_STEP_MAX           32
+#define SYS_BOOT_MARK_MAX           8
+
+#define SYS_BOOT_DEFER_MS           1000
+#define SYS_BOOT_M0_WARN_MS         500     // print once if the M0 is not up by then
+
+#define SYS_BOOT_FLAG_M0            0x01    // needs the M0 up
+#define SYS_BOOT_FLAG_DEFER         0x02    // after the kernel start or at Sys_BootUse
+
+#define SYS_BOOT_DEP(idx)           (1UL << (idx))
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef enum
+{
+    SYS_BOOT_STAGE_DRIVER = 0,      // Sys_DriverInit
+    SYS_BOOT_STAGE_SERVICE,         // Sys_ServiceInit
+
+    SYS_BOOT_STAGE_NUM
+} E_SysBootStage_t;
+
+typedef enum
+{
+    SYS_BOOT_STATE_PENDING = 0,
+    SYS_BOOT_STATE_RUNNING,
+    SYS_BOOT_STATE_DONE
+} E_SysBootState_t;
+
+typedef void (*T_SysBootFunc)(void);
+
+typedef struct
+{
+    const char *sName;
+    T_SysBootFunc fpFunc;
+    uint8_t u8Stage;                // E_SysBootStage_t
+    uint8_t u8Flag;                 // SYS_BOOT_FLAG_xxx
+    uint32_t u32Deps;               // SYS_BOOT_DEP() of earlier steps
+} S_SysBootStep_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+int Sys_BootInit(const S_SysBootStep_t *ptStep, uint32_t u32Num);
+void Sys_BootRun(uint32_t u32Stage, uint8_t u8Finish);
+void Sys_BootAppHook(void);
+int Sys_BootUse(const char *sName);
+
+void Sys_BootMark(const char *sName);
+
+uint8_t Sys_BootM0Poll(void);
+void Sys_BootM0Wait(void);
+void Sys_BootM0Isr(void);
+
+void Sys_BootDump(void);
+void Sys_BootCmd(char *sCmd);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+
+// Sec 7: declaration of static function prototype
+
+#endif // __SYS_BOOT_H__
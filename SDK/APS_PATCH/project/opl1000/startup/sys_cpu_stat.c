@@ -0,0 +1,673 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_cpu_stat.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This source file defines the CPU time accounting per task, the interrupt
+*  time and the "top" diag command.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "sys_common.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "hal_tick.h"
+#include "sys_fault.h"
+#include "sys_cpu_stat.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SYS_CPU_STAT_EXC_PENDSV     (16 + PendSV_IRQn)
+#define SYS_CPU_STAT_EXC_SYSTICK    (16 + SysTick_IRQn)
+
+#define SYS_CPU_STAT_IDLE_NAME      "IDLE"
+#define SYS_CPU_STAT_SAMPLE_MAX     60000   // ms
+#define SYS_CPU_STAT_PARAM_MAX      2
+
+#define SYS_CPU_STAT_CRIT_ENTER(x)  do { x = __get_PRIMASK(); __disable_irq(); } while(0)
+#define SYS_CPU_STAT_CRIT_EXIT(x)   __set_PRIMASK(x)
+
+#define SYS_CPU_STAT_LOG(...)       tracer_cli(LOG_HIGH_LEVEL, __VA_ARGS__)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+// the handlers under the wrappers, indexed by the exception number
+RET_DATA uint32_t g_u32aSysCpuStatVector[SYS_FAULT_VECTOR_NUM];
+RET_DATA uint8_t g_u8SysCpuStatRun;
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+static S_SysCpuStat_t g_tSysCpuStat;
+static uint32_t g_u32SysCpuStatMark;        // CYCCNT of the last charge
+static uint32_t g_u32SysCpuStatDepth;       // interrupt nesting
+static void *g_pSysCpuStatLast;             // the task charged last
+static uint32_t g_u32SysCpuStatLastIdx;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+__asm void Sys_CpuStatPendSvWrapper(void)
+{
+    PRESERVE8
+    IMPORT  Sys_CpuStatSwitch
+    IMPORT  g_u32aSysCpuStatVector
+
+    PUSH    {r4, lr}
+    BL      Sys_CpuStatSwitch
+    POP     {r4, lr}
+    LDR     r0, =g_u32aSysCpuStatVector
+    LDR     r0, [r0, #56]       ; PendSV, the exception number 14
+    BX      r0
+}
+
+__asm void Sys_CpuStatIsrWrapper(void)
+{
+    PRESERVE8
+    IMPORT  Sys_CpuStatIsrEnter
+    IMPORT  Sys_CpuStatIsrExit
+    IMPORT  g_u32aSysCpuStatVector
+
+    PUSH    {r4, lr}
+    BL      Sys_CpuStatIsrEnter
+    MRS     r0, IPSR
+    LDR     r1, =g_u32aSysCpuStatVector
+    LDR     r0, [r1, r0, LSL #2]
+    BLX     r0
+    BL      Sys_CpuStatIsrExit
+    POP     {r4, pc}            ; EXC_RETURN
+}
+
+static S_SysCpuTask_t *_Sys_CpuStatTask(void *pHandle)
+{
+    S_SysCpuStat_t *ptStat = &g_tSysCpuStat;
+    S_SysCpuTask_t *ptTask = NULL;
+    uint32_t i = 0;
+
+    if (pHandle == NULL)
+        return NULL;
+
+    if ((g_u32SysCpuStatLastIdx < ptStat->u32TaskNum) && (ptStat->taTask[g_u32SysCpuStatLastIdx].pHandle == pHandle))
+        return &ptStat->taTask[g_u32SysCpuStatLastIdx];
+
+    for (i = 0; i < ptStat->u32TaskNum; i++)
+    {
+        if (ptStat->taTask[i].pHandle == pHandle)
+            goto done;
+    }
+
+    if (ptStat->u32TaskNum >= SYS_CPU_STAT_TASK_NUM)
+        return NULL;
+
+    ptTask = &ptStat->taTask[ptStat->u32TaskNum++];
+    ptTask->pHandle = pHandle;
+    strncpy(ptTask->baName, pcTaskGetName((TaskHandle_t)pHandle), SYS_CPU_STAT_NAME_LEN - 1);
+    ptTask->baName[SYS_CPU_STAT_NAME_LEN - 1] = 0;
+
+done:
+    g_u32SysCpuStatLastIdx = i;
+    return &ptStat->taTask[i];
+}
+
+// the caller disables the interrupts
+static void _Sys_CpuStatCharge(uint32_t u32Now)
+{
+    S_SysCpuStat_t *ptStat = &g_tSysCpuStat;
+    S_SysCpuTask_t *ptTask = NULL;
+    void *pHandle = NULL;
+    uint32_t u32Delta = u32Now - g_u32SysCpuStatMark;
+
+    g_u32SysCpuStatMark = u32Now;
+
+    pHandle = (void *)xTaskGetCurrentTaskHandle();
+    ptTask = _Sys_CpuStatTask(pHandle);
+
+    ptStat->u64Total += u32Delta;
+
+    if (ptTask)
+        ptTask->u64Cycles += u32Delta;
+    else
+        ptStat->u64Other += u32Delta;
+
+    if (pHandle != g_pSysCpuStatLast)
+    {
+        g_pSysCpuStatLast = pHandle;
+        ptStat->u32Switch++;
+
+        if (ptTask)
+            ptTask->u32Switch++;
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_CpuStatSwitch
+*
+* DESCRIPTION:
+*   1. PendSV: charge the task being switched out
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_CpuStatSwitch(void)
+{
+    uint32_t u32Primask = 0;
+
+    SYS_CPU_STAT_CRIT_ENTER(u32Primask);
+    _Sys_CpuStatCharge(DWT->CYCCNT);
+    SYS_CPU_STAT_CRIT_EXIT(u32Primask);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_CpuStatIsrEnter
+*
+* DESCRIPTION:
+*   1. Interrupt entry: charge the running task, a nested interrupt is
+*      part of the outer one
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_CpuStatIsrEnter(void)
+{
+    uint32_t u32Primask = 0;
+
+    SYS_CPU_STAT_CRIT_ENTER(u32Primask);
+
+    if (g_u32SysCpuStatDepth++ == 0)
+        _Sys_CpuStatCharge(DWT->CYCCNT);
+
+    SYS_CPU_STAT_CRIT_EXIT(u32Primask);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_CpuStatIsrExit
+*
+* DESCRIPTION:
+*   1. Interrupt exit: charge the ISR bucket
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_CpuStatIsrExit(void)
+{
+    S_SysCpuStat_t *ptStat = &g_tSysCpuStat;
+    uint32_t u32Primask = 0;
+    uint32_t u32Now = 0;
+
+    SYS_CPU_STAT_CRIT_ENTER(u32Primask);
+
+    if ((g_u32SysCpuStatDepth > 0) && (--g_u32SysCpuStatDepth == 0))
+    {
+        u32Now = DWT->CYCCNT;
+
+        ptStat->u64Isr += (u32Now - g_u32SysCpuStatMark);
+        ptStat->u64Total += (u32Now - g_u32SysCpuStatMark);
+        ptStat->u32Isr++;
+
+        g_u32SysCpuStatMark = u32Now;
+    }
+
+    SYS_CPU_STAT_CRIT_EXIT(u32Primask);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_CpuStatReset
+*
+* DESCRIPTION:
+*   1. Clear the counters, the task list is built again
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_CpuStatReset(void)
+{
+    uint32_t u32Primask = 0;
+
+    SYS_CPU_STAT_CRIT_ENTER(u32Primask);
+
+    memset(&g_tSysCpuStat, 0, sizeof(g_tSysCpuStat));
+    g_pSysCpuStatLast = NULL;
+    g_u32SysCpuStatLastIdx = 0;
+    g_u32SysCpuStatMark = DWT->CYCCNT;
+
+    SYS_CPU_STAT_CRIT_EXIT(u32Primask);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_CpuStatStart
+*
+* DESCRIPTION:
+*   1. Reset the counters and put the wrappers in the RAM vector table:
+*      PendSV, SysTick and the interrupts
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   0  : success
+*   -1 : the RAM vector table is not there
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+int Sys_CpuStatStart(void)
+{
+    uint32_t u32Primask = 0;
+    uint32_t i = 0;
+
+    if (g_u8SysCpuStatRun)
+        return 0;
+
+    if (!Sys_VectorGet(SYS_CPU_STAT_EXC_PENDSV))
+        return -1;
+
+    Hal_Tick_Init();
+    Sys_CpuStatReset();
+
+    SYS_CPU_STAT_CRIT_ENTER(u32Primask);
+
+    g_u32SysCpuStatDepth = 0;
+
+    for (i = SYS_CPU_STAT_EXC_PENDSV; i < SYS_FAULT_VECTOR_NUM; i++)
+        g_u32aSysCpuStatVector[i] = Sys_VectorGet(i);
+
+    Sys_VectorSet(SYS_CPU_STAT_EXC_PENDSV, (uint32_t)Sys_CpuStatPendSvWrapper);
+
+    for (i = SYS_CPU_STAT_EXC_SYSTICK; i < SYS_FAULT_VECTOR_NUM; i++)
+        Sys_VectorSet(i, (uint32_t)Sys_CpuStatIsrWrapper);
+
+    g_u8SysCpuStatRun = 1;
+
+    SYS_CPU_STAT_CRIT_EXIT(u32Primask);
+    return 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_CpuStatStop
+*
+* DESCRIPTION:
+*   1. Put the original handlers back, the counters are kept
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_CpuStatStop(void)
+{
+    uint32_t u32Primask = 0;
+    uint32_t i = 0;
+
+    if (!g_u8SysCpuStatRun)
+        return;
+
+    SYS_CPU_STAT_CRIT_ENTER(u32Primask);
+
+    for (i = SYS_CPU_STAT_EXC_PENDSV; i < SYS_FAULT_VECTOR_NUM; i++)
+        Sys_VectorSet(i, g_u32aSysCpuStatVector[i]);
+
+    g_u8SysCpuStatRun = 0;
+
+    SYS_CPU_STAT_CRIT_EXIT(u32Primask);
+}
+
+uint8_t Sys_CpuStatIsRunning(void)
+{
+    return g_u8SysCpuStatRun;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_CpuStatGet
+*
+* DESCRIPTION:
+*   1. Copy the counters. The running task is charged up to now first, so
+*      the sample does not lag by its current slice.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptStat : [Out] the counters since the start or the reset
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_CpuStatGet(S_SysCpuStat_t *ptStat)
+{
+    uint32_t u32Primask = 0;
+
+    SYS_CPU_STAT_CRIT_ENTER(u32Primask);
+
+    if (g_u8SysCpuStatRun)
+        _Sys_CpuStatCharge(DWT->CYCCNT);
+
+    memcpy(ptStat, &g_tSysCpuStat, sizeof(S_SysCpuStat_t));
+
+    SYS_CPU_STAT_CRIT_EXIT(u32Primask);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_CpuStatDelta
+*
+* DESCRIPTION:
+*   1. Turn a sample into the interval since an earlier one. For periodic
+*      sampling: keep the last sample, get a new one and take the delta.
+*      Tasks new in ptCurr keep their counters. A reset in between leaves
+*      ptCurr as it is.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptPrev : [In] the earlier sample
+*   2. ptCurr : [In/Out] the later sample, the interval on return
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_CpuStatDelta(const S_SysCpuStat_t *ptPrev, S_SysCpuStat_t *ptCurr)
+{
+    uint32_t i = 0;
+    uint32_t j = 0;
+
+    if (ptCurr->u64Total < ptPrev->u64Total)
+        return;
+
+    ptCurr->u64Total -= ptPrev->u64Total;
+    ptCurr->u64Isr -= ptPrev->u64Isr;
+    ptCurr->u64Other -= ptPrev->u64Other;
+    ptCurr->u32Isr -= ptPrev->u32Isr;
+    ptCurr->u32Switch -= ptPrev->u32Switch;
+
+    for (i = 0; i < ptCurr->u32TaskNum; i++)
+    {
+        for (j = 0; j < ptPrev->u32TaskNum; j++)
+        {
+            if (ptPrev->taTask[j].pHandle == ptCurr->taTask[i].pHandle)
+            {
+                ptCurr->taTask[i].u64Cycles -= ptPrev->taTask[j].u64Cycles;
+                ptCurr->taTask[i].u32Switch -= ptPrev->taTask[j].u32Switch;
+                break;
+            }
+        }
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_CpuStatPermille
+*
+* DESCRIPTION:
+*   1. u64Part / u64Total in 0.1%, rounded
+*
+* CALLS
+*
+* PARAMETERS
+*   1. u64Part  : [In] cycles of a task or of the ISR
+*   2. u64Total : [In] cycles of the sample
+*
+* RETURNS
+*   0 ~ 1000
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Sys_CpuStatPermille(uint64_t u64Part, uint64_t u64Total)
+{
+    if (u64Total == 0)
+        return 0;
+
+    return (uint32_t)(((u64Part * 1000) + (u64Total / 2)) / u64Total);
+}
+
+static void _Sys_CpuStatDump(const S_SysCpuStat_t *ptStat)
+{
+    uint8_t u8aOrder[SYS_CPU_STAT_TASK_NUM];
+    const S_SysCpuTask_t *ptTask = NULL;
+    uint64_t u64Idle = 0;
+    uint32_t u32PerMs = Hal_Tick_PerMilliSec();
+    uint32_t u32Val = 0;
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint8_t u8Tmp = 0;
+
+    for (i = 0; i < ptStat->u32TaskNum; i++)
+    {
+        u8aOrder[i] = i;
+
+        if (!strcmp(ptStat->taTask[i].baName, SYS_CPU_STAT_IDLE_NAME))
+            u64Idle += ptStat->taTask[i].u64Cycles;
+    }
+
+    // the busiest first
+    for (i = 0; i < ptStat->u32TaskNum; i++)
+    {
+        for (j = i + 1; j < ptStat->u32TaskNum; j++)
+        {
+            if (ptStat->taTask[u8aOrder[j]].u64Cycles > ptStat->taTask[u8aOrder[i]].u64Cycles)
+            {
+                u8Tmp = u8aOrder[i];
+                u8aOrder[i] = u8aOrder[j];
+                u8aOrder[j] = u8Tmp;
+            }
+        }
+    }
+
+    u32Val = Sys_CpuStatPermille(ptStat->u64Total - u64Idle, ptStat->u64Total);
+    SYS_CPU_STAT_LOG("top: %u ms busy=%u.%u%% switch=%u\n",
+                     (uint32_t)(ptStat->u64Total / u32PerMs), u32Val / 10, u32Val % 10, ptStat->u32Switch);
+
+    u32Val = Sys_CpuStatPermille(ptStat->u64Isr, ptStat->u64Total);
+    SYS_CPU_STAT_LOG("top: isr=%u.%u%% count=%u avg=%u cycles\n",
+                     u32Val / 10, u32Val % 10, ptStat->u32Isr,
+                     ptStat->u32Isr ? (uint32_t)(ptStat->u64Isr / ptStat->u32Isr) : 0);
+
+    SYS_CPU_STAT_LOG("  %-16s %6s %10s %8s\n", "task", "cpu", "ms", "switch");
+
+    for (i = 0; i < ptStat->u32TaskNum; i++)
+    {
+        ptTask = &ptStat->taTask[u8aOrder[i]];
+        u32Val = Sys_CpuStatPermille(ptTask->u64Cycles, ptStat->u64Total);
+
+        SYS_CPU_STAT_LOG("  %-16s %4u.%u%% %10u %8u\n", ptTask->baName, u32Val / 10, u32Val % 10,
+                         (uint32_t)(ptTask->u64Cycles / u32PerMs), ptTask->u32Switch);
+    }
+
+    if (ptStat->u64Other)
+    {
+        u32Val = Sys_CpuStatPermille(ptStat->u64Other, ptStat->u64Total);
+        SYS_CPU_STAT_LOG("  %-16s %4u.%u%% %10u\n", "(other)", u32Val / 10, u32Val % 10,
+                         (uint32_t)(ptStat->u64Other / u32PerMs));
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Sys_CpuStatCmd
+*
+* DESCRIPTION:
+*   diag command: top [on|off|reset|<ms>]
+*     no argument: since "top on" or "top reset"
+*     <ms>: sample for the given time
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void Sys_CpuStatCmd(char *sCmd)
+{
+    char *baParam[SYS_CPU_STAT_PARAM_MAX + 1] = {0};
+    uint32_t u32Num = 0;
+    uint32_t u32Ms = 0;
+    S_SysCpuStat_t *ptPrev = NULL;
+    S_SysCpuStat_t *ptCurr = NULL;
+
+    u32Num = ParseParam(sCmd, baParam, SYS_CPU_STAT_PARAM_MAX + 1);
+
+    if ((u32Num >= 2) && (!strcmp(baParam[1], "on")))
+    {
+        if (Sys_CpuStatStart())
+        {
+            SYS_CPU_STAT_LOG("top: no RAM vector table\n");
+            goto done;
+        }
+
+        SYS_CPU_STAT_LOG("top: on\n");
+        goto done;
+    }
+
+    if ((u32Num >= 2) && (!strcmp(baParam[1], "off")))
+    {
+        Sys_CpuStatStop();
+        SYS_CPU_STAT_LOG("top: off\n");
+        goto done;
+    }
+
+    if ((u32Num >= 2) && (!strcmp(baParam[1], "reset")))
+    {
+        Sys_CpuStatReset();
+        goto done;
+    }
+
+    if (!Sys_CpuStatIsRunning())
+    {
+        SYS_CPU_STAT_LOG("top: off, \"top on\" to start\n");
+        goto done;
+    }
+
+    ptCurr = (S_SysCpuStat_t *)malloc(sizeof(S_SysCpuStat_t));
+    if (!ptCurr)
+        goto nomem;
+
+    if (u32Num < 2)
+    {
+        Sys_CpuStatGet(ptCurr);
+        _Sys_CpuStatDump(ptCurr);
+        goto done;
+    }
+
+    u32Ms = strtoul(baParam[1], NULL, 0);
+    if ((u32Ms == 0) || (u32Ms > SYS_CPU_STAT_SAMPLE_MAX))
+        goto usage;
+
+    ptPrev = (S_SysCpuStat_t *)malloc(sizeof(S_SysCpuStat_t));
+    if (!ptPrev)
+        goto nomem;
+
+    Sys_CpuStatGet(ptPrev);
+    osDelay(u32Ms);
+    Sys_CpuStatGet(ptCurr);
+
+    Sys_CpuStatDelta(ptPrev, ptCurr);
+    _Sys_CpuStatDump(ptCurr);
+    goto done;
+
+nomem:
+    SYS_CPU_STAT_LOG("top: malloc fail\n");
+    goto done;
+
+usage:
+    SYS_CPU_STAT_LOG("usage: top [on|off|reset|<ms 1~%u>]\n", SYS_CPU_STAT_SAMPLE_MAX);
+
+done:
+    if (ptPrev)
+        free(ptPrev);
+
+    if (ptCurr)
+        free(ptCurr);
+}
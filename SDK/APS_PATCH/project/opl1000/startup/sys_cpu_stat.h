@@ -0,0 +1,103 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_cpu_stat.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This include file defines the CPU time accounting per task.
+*
+*  The kernel is in ROM and built without the run time statistics, so the
+*  accounting sits in the RAM vector table instead: PendSV charges the
+*  cycles since the last mark to the task switched out, every interrupt
+*  (SysTick included) charges the time before it to the running task and
+*  its own time to the ISR bucket. The time base is the DWT cycle counter.
+*  The counter stops while the core sleeps in WFI, the shares are of the
+*  cycles the core really ran.
+*
+*  Sys_CpuStatStart installs the hooks and Sys_CpuStatStop takes them out,
+*  nothing is charged (and nothing costs) while stopped.
+*
+******************************************************************************/
+#ifndef __SYS_CPU_STAT_H__
+#define __SYS_CPU_STAT_H__
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdint.h>
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SYS_CPU_STAT_TASK_NUM       24
+#define SYS_CPU_STAT_NAME_LEN       16      // include '\0', configMAX_TASK_NAME_LEN
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    void *pHandle;                  // TaskHandle_t
+    char baName[SYS_CPU_STAT_NAME_LEN];
+    uint64_t u64Cycles;
+    uint32_t u32Switch;             // times switched in
+} S_SysCpuTask_t;
+
+typedef struct
+{
+    uint64_t u64Total;              // cycles charged, tasks + ISR + other
+    uint64_t u64Isr;
+    uint64_t u64Other;              // tasks beyond SYS_CPU_STAT_TASK_NUM
+    uint32_t u32Isr;                // interrupts, nested ones not counted
+    uint32_t u32Switch;             // context switches
+    uint32_t u32TaskNum;
+    S_SysCpuTask_t taTask[SYS_CPU_STAT_TASK_NUM];
+} S_SysCpuStat_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+int Sys_CpuStatStart(void);
+void Sys_CpuStatStop(void);
+uint8_t Sys_CpuStatIsRunning(void);
+void Sys_CpuStatReset(void);
+
+void Sys_CpuStatGet(S_SysCpuStat_t *ptStat);
+void Sys_CpuStatDelta(const S_SysCpuStat_t *ptPrev, S_SysCpuStat_t *ptCurr);
+uint32_t Sys_CpuStatPermille(uint64_t u64Part, uint64_t u64Total);
+
+// called by the vector wrappers
+void Sys_CpuStatSwitch(void);
+void Sys_CpuStatIsrEnter(void);
+void Sys_CpuStatIsrExit(void);
+
+void Sys_CpuStatCmd(char *sCmd);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+
+// Sec 7: declaration of static function prototype
+
+#endif // __SYS_CPU_STAT_H__
@@ -0,0 +1,851 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_fault.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This source file defines the crash capture of the M3 and the report of
+*  the record at the next boot.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "sys_common.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "at_cmd.h"
+#include "at_cmd_common.h"
+#include "at_cmd_data_process.h"
+#include "hal_system.h"
+#include "hal_flash.h"
+#include "hal_flash_internal.h"
+#include "hal_flash_patch.h"
+#include "hal_flash_sched.h"
+#include "boot_sequence.h"
+#include "sys_fault.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SYS_FAULT_STACK_ROW         8       // words per dump line
+#define SYS_FAULT_LINE_SIZE         128
+#define SYS_FAULT_PARAM_MAX         3
+
+#define SYS_FAULT_CRIT_ENTER(x)     do { x = __get_PRIMASK(); __disable_irq(); } while(0)
+#define SYS_FAULT_CRIT_EXIT(x)      __set_PRIMASK(x)
+
+#define SYS_FAULT_EXC_RETURN_PSP    0x04    // the frame is on the process stack
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef enum
+{
+    SYS_FAULT_OUT_BOOT = 0,
+    SYS_FAULT_OUT_CLI,
+    SYS_FAULT_OUT_AT
+} E_SysFaultOut_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+RET_DATA uint32_t g_u32SysFaultSeq;         // seq of the stored record
+
+// Sec 5: declaration of global function prototype
+// the ROM flash functions, below the cache and the scheduler
+extern void Hal_Flash_Reset_Internal_impl(E_SpiIdx_t u32SpiIdx);
+extern uint32_t Hal_Flash_4KSectorAddrErase_Internal_impl(E_SpiIdx_t u32SpiIdx, uint32_t u32SecAddr);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+// VTOR: aligned to the table size rounded up to a power of 2. Kept over the
+// warm boot with the handlers other modules put in it.
+RET_DATA static uint32_t g_u32aSysFaultVector[SYS_FAULT_VECTOR_NUM] __attribute__((aligned(256)));
+
+static S_SysFaultRecord_t g_tSysFaultRecord;    // not on the stack, it may be the broken one
+static uint8_t g_u8SysFaultBusy;
+
+static char g_baSysFaultTrace[SYS_FAULT_TRACE_NUM][SYS_FAULT_TRACE_LEN];
+static uint32_t g_u32SysFaultTraceIdx;          // the next line to write, the oldest one
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static uint32_t _Sys_FaultCrc32(const uint8_t *pu8Data, uint32_t u32Size)
+{
+    uint32_t u32Crc = 0xFFFFFFFF;
+    uint32_t i = 0;
+    uint32_t j = 0;
+
+    for (i = 0; i < u32Size; i++)
+    {
+        u32Crc ^= pu8Data[i];
+
+        for (j = 0; j < 8; j++)
+            u32Crc = (u32Crc >> 1) ^ (0xEDB88320 & (0 - (u32Crc & 1)));
+    }
+
+    return ~u32Crc;
+}
+
+static uint32_t _Sys_FaultRecordCrc(const S_SysFaultRecord_t *ptRecord)
+{
+    return _Sys_FaultCrc32((const uint8_t *)ptRecord, offsetof(S_SysFaultRecord_t, u32Crc));
+}
+
+static int _Sys_FaultRecordCheck(const S_SysFaultRecord_t *ptRecord)
+{
+    if ((ptRecord->u32Magic != SYS_FAULT_MAGIC) ||
+        (ptRecord->u16Version != SYS_FAULT_VERSION) ||
+        (ptRecord->u16Size != sizeof(S_SysFaultRecord_t)) ||
+        (ptRecord->u32StackNum > SYS_FAULT_STACK_NUM))
+        return -1;
+
+    if (ptRecord->u32Crc != _Sys_FaultRecordCrc(ptRecord))
+        return -1;
+
+    return 0;
+}
+
+static const char *_Sys_FaultTypeName(uint32_t u32Type)
+{
+    switch (u32Type)
+    {
+        case SYS_FAULT_TYPE_HARD:   return "hardfault";
+        case SYS_FAULT_TYPE_MEM:    return "memmanage";
+        case SYS_FAULT_TYPE_BUS:    return "busfault";
+        case SYS_FAULT_TYPE_USAGE:  return "usagefault";
+        case SYS_FAULT_TYPE_STALL:  return "task stall";
+        case SYS_FAULT_TYPE_WDT:    return "watchdog";
+        default:                    return "unknown";
+    }
+}
+
+static void _Sys_FaultRecordFill(uint32_t u32Type, uint32_t *pu32Frame, uint32_t u32ExcReturn, TaskHandle_t tTask)
+{
+    S_SysFaultRecord_t *ptRecord = &g_tSysFaultRecord;
+    uint32_t u32Addr = (uint32_t)pu32Frame;
+    const char *sName = NULL;
+    uint32_t u32Idx = 0;
+    uint32_t i = 0;
+
+    memset(ptRecord, 0, sizeof(S_SysFaultRecord_t));
+
+    ptRecord->u32Magic = SYS_FAULT_MAGIC;
+    ptRecord->u16Version = SYS_FAULT_VERSION;
+    ptRecord->u16Size = sizeof(S_SysFaultRecord_t);
+    ptRecord->u32Seq = ++g_u32SysFaultSeq;
+    ptRecord->u32Type = u32Type;
+    ptRecord->u32Tick = osKernelSysTick();
+
+    ptRecord->u32Sp = u32Addr;
+    ptRecord->u32ExcReturn = u32ExcReturn;
+    ptRecord->u32Cfsr = SCB->CFSR;
+    ptRecord->u32Hfsr = SCB->HFSR;
+    ptRecord->u32Mmfar = SCB->MMFAR;
+    ptRecord->u32Bfar = SCB->BFAR;
+
+    // a broken SP must not fault again here
+    if ((u32Addr >= SYS_FAULT_RAM_START) && (u32Addr <= (SYS_FAULT_RAM_END - sizeof(ptRecord->u32aReg))))
+    {
+        for (i = 0; i < SYS_FAULT_REG_NUM; i++)
+            ptRecord->u32aReg[i] = pu32Frame[i];
+
+        // the words above the frame: locals and return addresses of the callers
+        u32Addr += sizeof(ptRecord->u32aReg);
+
+        for (i = 0; (i < SYS_FAULT_STACK_NUM) && (u32Addr < SYS_FAULT_RAM_END); i++, u32Addr += 4)
+            ptRecord->u32aStack[i] = *(uint32_t *)u32Addr;
+
+        ptRecord->u32StackNum = i;
+    }
+
+    if (u32Type != SYS_FAULT_TYPE_STALL)
+        tTask = xTaskGetCurrentTaskHandle();
+
+    // the record is zeroed above, the name stays terminated
+    if (tTask)
+    {
+        sName = pcTaskGetName(tTask);
+
+        for (i = 0; (i < (SYS_FAULT_TASK_NAME_LEN - 1)) && sName[i]; i++)
+            ptRecord->baTask[i] = sName[i];
+    }
+
+    // oldest first
+    u32Idx = g_u32SysFaultTraceIdx;
+
+    for (i = 0; i < SYS_FAULT_TRACE_NUM; i++)
+    {
+        memcpy(ptRecord->baTrace[i], g_baSysFaultTrace[u32Idx], SYS_FAULT_TRACE_LEN);
+        u32Idx = (u32Idx + 1) % SYS_FAULT_TRACE_NUM;
+    }
+
+    ptRecord->u32Crc = _Sys_FaultRecordCrc(ptRecord);
+}
+
+static void _Sys_FaultCommit(uint32_t u32Type, uint32_t *pu32Frame, uint32_t u32ExcReturn, TaskHandle_t tTask)
+{
+    __disable_irq();
+
+    // faulted again inside the capture, keep the sector as it is
+    if (g_u8SysFaultBusy)
+        goto done;
+
+    g_u8SysFaultBusy = 1;
+
+    _Sys_FaultRecordFill(u32Type, pu32Frame, u32ExcReturn, tTask);
+
+    printf("\r\n%s: pc=0x%08X lr=0x%08X task=%s, saving the crash record\r\n",
+           _Sys_FaultTypeName(u32Type),
+           (unsigned int)g_tSysFaultRecord.u32aReg[SYS_FAULT_REG_PC],
+           (unsigned int)g_tSysFaultRecord.u32aReg[SYS_FAULT_REG_LR],
+           g_tSysFaultRecord.baTask);
+
+    // This path runs with the interrupt disabled and must not block: no
+    // semaphore, and not the *_Internal pointers either, the cache and the
+    // background erase put in front of them may be what faulted. Call the
+    // ROM implementations (the program one is patched) directly.
+    //
+    // A background erase of hal_flash_sched.c may be running, or suspended
+    // by the read the fault hit: Hal_Flash_EraseSettle resumes it and lets
+    // it end without the semaphore, the reset below would abort it. If it
+    // does not end in time it is aborted and its sector is left partly
+    // erased, the same as a power cut in the middle of the erase, which the
+    // owners of the sector (MW_FIM, the log, the FS) already go through.
+    if (Hal_Flash_EraseSettle(SPI_IDX_0))
+        printf("the background erase is aborted\r\n");
+
+    // The fault may have hit a flash operation: reset the flash first. The
+    // poll of the ROM erase ends before a slow part does, wait it out.
+    Hal_Flash_Reset_Internal_impl(SPI_IDX_0);
+    if (Hal_Flash_4KSectorAddrErase_Internal_impl(SPI_IDX_0, SYS_FAULT_FLASH_ADDR))
+        Hal_Flash_WipWait(SPI_IDX_0, HAL_FLASH_SCHED_SETTLE_MS);
+
+    Hal_Flash_AddrProgram_Internal_patch(SPI_IDX_0, SYS_FAULT_FLASH_ADDR, 0,
+                                         sizeof(S_SysFaultRecord_t), (uint8_t *)&g_tSysFaultRecord);
+
+done:
+    Hal_Sys_SwResetAll();
+
+    while (1)
+        ;
+}
+
+static void _Sys_FaultPrint(uint8_t u8Out, const char *sFmt, ...)
+{
+    char sLine[SYS_FAULT_LINE_SIZE];
+    va_list tArgs;
+
+    va_start(tArgs, sFmt);
+    vsnprintf(sLine, sizeof(sLine), sFmt, tArgs);
+    va_end(tArgs);
+
+    switch (u8Out)
+    {
+        case SYS_FAULT_OUT_CLI:
+            tracer_cli(LOG_HIGH_LEVEL, "crash: %s\n", sLine);
+            break;
+
+        case SYS_FAULT_OUT_AT:
+            msg_print_uart1("+CRASH:%s\r\n", sLine);
+            break;
+
+        default:
+            printf("crash: %s\r\n", sLine);
+            break;
+    }
+}
+
+static void _Sys_FaultSummary(uint8_t u8Out, const S_SysFaultRecord_t *ptRecord)
+{
+    const uint32_t *pu32Reg = ptRecord->u32aReg;
+
+    _Sys_FaultPrint(u8Out, "seq=%u type=%s tick=%u task=%s",
+                    ptRecord->u32Seq, _Sys_FaultTypeName(ptRecord->u32Type),
+                    ptRecord->u32Tick, ptRecord->baTask[0] ? ptRecord->baTask : "-");
+    _Sys_FaultPrint(u8Out, "pc=0x%08X lr=0x%08X sp=0x%08X xpsr=0x%08X exc_return=0x%08X",
+                    pu32Reg[SYS_FAULT_REG_PC], pu32Reg[SYS_FAULT_REG_LR], ptRecord->u32Sp,
+                    pu32Reg[SYS_FAULT_REG_XPSR], ptRecord->u32ExcReturn);
+}
+
+static void _Sys_FaultDump(uint8_t u8Out, const S_SysFaultRecord_t *ptRecord)
+{
+    const uint32_t *pu32Reg = ptRecord->u32aReg;
+    const uint32_t *pu32Word = NULL;
+    uint32_t i = 0;
+
+    _Sys_FaultSummary(u8Out, ptRecord);
+
+    _Sys_FaultPrint(u8Out, "r0=0x%08X r1=0x%08X r2=0x%08X r3=0x%08X r12=0x%08X",
+                    pu32Reg[SYS_FAULT_REG_R0], pu32Reg[SYS_FAULT_REG_R1], pu32Reg[SYS_FAULT_REG_R2],
+                    pu32Reg[SYS_FAULT_REG_R3], pu32Reg[SYS_FAULT_REG_R12]);
+    _Sys_FaultPrint(u8Out, "cfsr=0x%08X hfsr=0x%08X mmfar=0x%08X bfar=0x%08X",
+                    ptRecord->u32Cfsr, ptRecord->u32Hfsr, ptRecord->u32Mmfar, ptRecord->u32Bfar);
+
+    // offsets from the end of the exception frame
+    for (i = 0; i < ptRecord->u32StackNum; i += SYS_FAULT_STACK_ROW)
+    {
+        pu32Word = &ptRecord->u32aStack[i];
+
+        if ((ptRecord->u32StackNum - i) >= SYS_FAULT_STACK_ROW)
+        {
+            _Sys_FaultPrint(u8Out, "stack+0x%03X %08X %08X %08X %08X %08X %08X %08X %08X", i * 4,
+                            pu32Word[0], pu32Word[1], pu32Word[2], pu32Word[3],
+                            pu32Word[4], pu32Word[5], pu32Word[6], pu32Word[7]);
+        }
+        else
+        {
+            // the frame was close to the end of RAM
+            for (; i < ptRecord->u32StackNum; i++)
+                _Sys_FaultPrint(u8Out, "stack+0x%03X %08X", i * 4, ptRecord->u32aStack[i]);
+        }
+    }
+
+    for (i = 0; i < SYS_FAULT_TRACE_NUM; i++)
+    {
+        if (ptRecord->baTrace[i][0])
+            _Sys_FaultPrint(u8Out, "trace %s", ptRecord->baTrace[i]);
+    }
+}
+
+static void _Sys_FaultTest(const char *sType)
+{
+    volatile uint32_t u32Zero = 0;
+    void (*fpFunc)(void) = NULL;
+
+    if (!strcmp(sType, "div"))
+    {
+        SCB->CCR |= SCB_CCR_DIV_0_TRP_Msk;
+        u32Zero = 1 / u32Zero;
+    }
+    else if (!strcmp(sType, "usage"))
+    {
+        // the Thumb bit is clear: INVSTATE
+        fpFunc = (void (*)(void))((uint32_t)_Sys_FaultTest & ~1UL);
+        fpFunc();
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_FaultHandler
+*
+* DESCRIPTION:
+*   1. The HardFault/MemManage/BusFault/UsageFault entry of the RAM vector
+*      table. Both stack pointers and EXC_RETURN go to Sys_FaultCapture,
+*      nothing is pushed before MSP is read.
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None, the system is reset
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+__asm void Sys_FaultHandler(void)
+{
+    PRESERVE8
+    IMPORT  Sys_FaultCapture
+
+    MRS     r0, MSP
+    MRS     r1, PSP
+    MOV     r2, lr
+    B       Sys_FaultCapture
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_FaultCapture
+*
+* DESCRIPTION:
+*   1. Save the crash record of the fault and reset the system.
+*   2. Bit 2 of EXC_RETURN tells which stack holds the exception frame:
+*      0 the main stack (an ISR or the boot), 1 the process stack (a task).
+*
+* CALLS
+*
+* PARAMETERS
+*   1. u32Msp       : [In] MSP at the entry of the fault
+*   2. u32Psp       : [In] PSP at the entry of the fault
+*   3. u32ExcReturn : [In] EXC_RETURN of the fault
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_FaultCapture(uint32_t u32Msp, uint32_t u32Psp, uint32_t u32ExcReturn)
+{
+    uint32_t u32Frame = (u32ExcReturn & SYS_FAULT_EXC_RETURN_PSP) ? u32Psp : u32Msp;
+
+    _Sys_FaultCommit(__get_IPSR() & 0x1FF, (uint32_t *)u32Frame, u32ExcReturn, NULL);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_FaultWdtCapture
+*
+* DESCRIPTION:
+*   1. Save the crash record of a watchdog timeout and reset the system.
+*      The watchdog interrupt keeps no EXC_RETURN for us, the frame is taken
+*      from PSP: the task that was running, unless another ISR was.
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_FaultWdtCapture(void)
+{
+    _Sys_FaultCommit(SYS_FAULT_TYPE_WDT, (uint32_t *)__get_PSP(), 0, NULL);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_FaultStallCapture
+*
+* DESCRIPTION:
+*   1. Save the crash record of a task that is not running (a stall found
+*      by the watchdog supervisor) and reset the system.
+*      The frame is the context saved by the kernel at the last switch:
+*      pxTopOfStack is the first word of the TCB, r4-r11 are below the
+*      exception frame (ARM_CM3 port, no FPU).
+*
+* CALLS
+*
+* PARAMETERS
+*   1. pTask : [In] the handle of the stalled task, NULL: unknown
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_FaultStallCapture(void *pTask)
+{
+    uint32_t *pu32Frame = NULL;
+
+    if ((pTask) && (pTask != xTaskGetCurrentTaskHandle()))
+        pu32Frame = *(uint32_t **)pTask + 8;
+
+    _Sys_FaultCommit(SYS_FAULT_TYPE_STALL, pu32Frame, 0, (TaskHandle_t)pTask);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_FaultTraceAdd
+*
+* DESCRIPTION:
+*   1. Keep a tracer line for the next crash record. The line ends at the
+*      first CR/LF and is cut to SYS_FAULT_TRACE_LEN - 1 characters.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. sLine : [In] the formatted tracer line
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_FaultTraceAdd(const char *sLine)
+{
+    char *sDst = NULL;
+    uint32_t u32Primask = 0;
+    uint32_t i = 0;
+
+    while ((*sLine == '\r') || (*sLine == '\n'))
+        sLine++;
+
+    if (*sLine == 0)
+        return;
+
+    SYS_FAULT_CRIT_ENTER(u32Primask);
+
+    sDst = g_baSysFaultTrace[g_u32SysFaultTraceIdx];
+    g_u32SysFaultTraceIdx = (g_u32SysFaultTraceIdx + 1) % SYS_FAULT_TRACE_NUM;
+
+    for (i = 0; (i < (SYS_FAULT_TRACE_LEN - 1)) && sLine[i] && (sLine[i] != '\r') && (sLine[i] != '\n'); i++)
+        sDst[i] = sLine[i];
+
+    sDst[i] = 0;
+
+    SYS_FAULT_CRIT_EXIT(u32Primask);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_FaultRecordGet
+*
+* DESCRIPTION:
+*   1. Read the crash record from flash
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptRecord : [Out] the record
+*
+* RETURNS
+*   0  : a valid record
+*   -1 : no record
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+int Sys_FaultRecordGet(S_SysFaultRecord_t *ptRecord)
+{
+    if (Hal_Flash_AddrRead(SPI_IDX_0, SYS_FAULT_FLASH_ADDR, 0, sizeof(S_SysFaultRecord_t), (uint8_t *)ptRecord))
+        return -1;
+
+    return _Sys_FaultRecordCheck(ptRecord);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_FaultRecordClear
+*
+* DESCRIPTION:
+*   1. Erase the crash record, the sequence starts again from 1
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   0  : success
+*   -1 : fail
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+int Sys_FaultRecordClear(void)
+{
+    if (Hal_Flash_4KSectorAddrErase(SPI_IDX_0, SYS_FAULT_FLASH_ADDR))
+        return -1;
+
+    g_u32SysFaultSeq = 0;
+    return 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_FaultInit
+*
+* DESCRIPTION:
+*   1. Copy the vector table to RAM and take the fault entries
+*   2. Enable MemManage, BusFault and UsageFault, so they do not escalate
+*   3. At cold boot, report the stored crash record
+*   Call at every boot, after the flash of SPI0 is initialized.
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_FaultInit(void)
+{
+    uint32_t *pu32Vector = (uint32_t *)SCB->VTOR;
+    uint32_t i = 0;
+
+    // built once at cold boot, the warm boot only points VTOR at it again
+    if (g_u32aSysFaultVector[SYS_FAULT_TYPE_HARD] != (uint32_t)Sys_FaultHandler)
+    {
+        for (i = 0; i < SYS_FAULT_VECTOR_NUM; i++)
+            g_u32aSysFaultVector[i] = pu32Vector[i];
+
+        g_u32aSysFaultVector[SYS_FAULT_TYPE_HARD] = (uint32_t)Sys_FaultHandler;
+        g_u32aSysFaultVector[SYS_FAULT_TYPE_MEM] = (uint32_t)Sys_FaultHandler;
+        g_u32aSysFaultVector[SYS_FAULT_TYPE_BUS] = (uint32_t)Sys_FaultHandler;
+        g_u32aSysFaultVector[SYS_FAULT_TYPE_USAGE] = (uint32_t)Sys_FaultHandler;
+    }
+
+    if (pu32Vector != g_u32aSysFaultVector)
+    {
+        __DMB();
+        SCB->VTOR = (uint32_t)g_u32aSysFaultVector;
+        __DSB();
+        __ISB();
+    }
+
+    SCB->SHCSR |= (SCB_SHCSR_MEMFAULTENA_Msk | SCB_SHCSR_BUSFAULTENA_Msk | SCB_SHCSR_USGFAULTENA_Msk);
+
+    // warm boot: the seq is kept in RET_DATA and the record was reported
+    if (Boot_CheckWarmBoot())
+        return;
+
+    g_u32SysFaultSeq = 0;
+
+    if (Sys_FaultRecordGet(&g_tSysFaultRecord))
+        return;
+
+    g_u32SysFaultSeq = g_tSysFaultRecord.u32Seq;
+
+    printf("\r\n");
+    _Sys_FaultSummary(SYS_FAULT_OUT_BOOT, &g_tSysFaultRecord);
+    printf("crash: \"crash show\" for the dump, \"crash clear\" to drop it\r\n");
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_VectorGet
+*
+* DESCRIPTION:
+*   1. Get an entry of the RAM vector table
+*
+* CALLS
+*
+* PARAMETERS
+*   1. u32Num : [In] the exception number, 16 + IRQn for the interrupts
+*
+* RETURNS
+*   the handler, 0 if u32Num is out of range
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Sys_VectorGet(uint32_t u32Num)
+{
+    if (u32Num >= SYS_FAULT_VECTOR_NUM)
+        return 0;
+
+    return g_u32aSysFaultVector[u32Num];
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_VectorSet
+*
+* DESCRIPTION:
+*   1. Replace an entry of the RAM vector table. The stack pointer and the
+*      fault entries are not allowed. The next exception takes the new
+*      handler, nothing is disabled here.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. u32Num     : [In] the exception number, 16 + IRQn for the interrupts
+*   2. u32Handler : [In] the handler, Thumb bit set
+*
+* RETURNS
+*   0  : success
+*   -1 : fail
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+int Sys_VectorSet(uint32_t u32Num, uint32_t u32Handler)
+{
+    if ((u32Num >= SYS_FAULT_VECTOR_NUM) ||
+        ((u32Num >= SYS_FAULT_TYPE_HARD) && (u32Num <= SYS_FAULT_TYPE_USAGE)) ||
+        (u32Num == 0))
+        return -1;
+
+    // not built yet
+    if (g_u32aSysFaultVector[SYS_FAULT_TYPE_HARD] != (uint32_t)Sys_FaultHandler)
+        return -1;
+
+    g_u32aSysFaultVector[u32Num] = u32Handler;
+    __DSB();
+    return 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Sys_FaultCmd
+*
+* DESCRIPTION:
+*   diag command: crash [show|clear|test div|usage]
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void Sys_FaultCmd(char *sCmd)
+{
+    char *baParam[SYS_FAULT_PARAM_MAX + 1] = {0};
+    uint32_t u32Num = 0;
+    S_SysFaultRecord_t *ptRecord = NULL;
+
+    u32Num = ParseParam(sCmd, baParam, SYS_FAULT_PARAM_MAX + 1);
+
+    if ((u32Num < 2) || (!strcmp(baParam[1], "show")))
+    {
+        ptRecord = (S_SysFaultRecord_t *)malloc(sizeof(S_SysFaultRecord_t));
+        if (!ptRecord)
+        {
+            tracer_cli(LOG_HIGH_LEVEL, "crash: malloc fail\n");
+            goto done;
+        }
+
+        if (Sys_FaultRecordGet(ptRecord))
+        {
+            tracer_cli(LOG_HIGH_LEVEL, "crash: no record\n");
+            goto done;
+        }
+
+        _Sys_FaultDump(SYS_FAULT_OUT_CLI, ptRecord);
+    }
+    else if (!strcmp(baParam[1], "clear"))
+    {
+        tracer_cli(LOG_HIGH_LEVEL, "crash: clear %s\n", Sys_FaultRecordClear() ? "fail" : "done");
+    }
+    else if ((!strcmp(baParam[1], "test")) && (u32Num >= 3))
+    {
+        _Sys_FaultTest(baParam[2]);
+        goto usage;
+    }
+    else
+    {
+        goto usage;
+    }
+
+    goto done;
+
+usage:
+    tracer_cli(LOG_HIGH_LEVEL, "usage: crash [show|clear|test div|usage]\n");
+
+done:
+    if (ptRecord)
+        free(ptRecord);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Sys_FaultAtCmd
+*
+* DESCRIPTION:
+*   AT command: at+crash? dumps the crash record, at+crash=0 erases it
+*
+* PARAMETERS
+*   buf :       [IN] command line
+*   len :       [IN] length of the command line
+*   mode :      [IN] AT_CMD_MODE_*
+*
+* RETURNS
+*   1 : OK
+*   0 : ERROR
+*
+*************************************************************************/
+int Sys_FaultAtCmd(char *buf, int len, int mode)
+{
+    int argc = 0;
+    char *argv[AT_MAX_CMD_ARGS] = {0};
+    S_SysFaultRecord_t *ptRecord = NULL;
+    int iRet = 0;
+
+    _at_cmd_buf_to_argc_argv(buf, &argc, argv, AT_MAX_CMD_ARGS);
+
+    switch (mode)
+    {
+        case AT_CMD_MODE_READ:
+            ptRecord = (S_SysFaultRecord_t *)malloc(sizeof(S_SysFaultRecord_t));
+            if (!ptRecord)
+            {
+                goto done;
+            }
+
+            msg_print_uart1("\r\n");
+
+            if (Sys_FaultRecordGet(ptRecord))
+            {
+                msg_print_uart1("+CRASH:none\r\n");
+            }
+            else
+            {
+                _Sys_FaultDump(SYS_FAULT_OUT_AT, ptRecord);
+            }
+            break;
+
+        case AT_CMD_MODE_SET:
+            if ((argc != 2) || (atoi(argv[1]) != 0))
+            {
+                goto done;
+            }
+
+            if (Sys_FaultRecordClear())
+            {
+                goto done;
+            }
+            break;
+
+        default:
+            goto done;
+    }
+
+    iRet = 1;
+
+done:
+    if (ptRecord)
+    {
+        free(ptRecord);
+    }
+
+    if (iRet)
+    {
+        msg_print_uart1("\r\nOK\r\n");
+    }
+    else
+    {
+        msg_print_uart1("\r\nERROR\r\n");
+    }
+
+    return iRet;
+}
@@ -0,0 +1,150 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_fault.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This include file defines the crash capture of the M3.
+*
+*  The vector table is copied to RAM and the HardFault, MemManage, BusFault
+*  and UsageFault entries point to Sys_FaultHandler. The stacked registers,
+*  the fault status registers, the current task, a window of the faulting
+*  stack and the last tracer lines are written to one flash sector, then the
+*  system is reset. The watchdog interrupt records the same way, so a task
+*  stuck in a loop (e.g. after the stack overflow hook) leaves a record too.
+*  A task stall found by the watchdog supervisor records the context saved
+*  in the stalled task, the place where it blocks.
+*
+*  The record is summarized at every cold boot until it is cleared, and
+*  dumped by the "crash" diag command and "at+crash". PC, LR and the stack
+*  words are code addresses of the image, decode them with the symbol file
+*  of the build (fromelf/addr2line on the .axf).
+*
+******************************************************************************/
+#ifndef __SYS_FAULT_H__
+#define __SYS_FAULT_H__
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdint.h>
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SYS_FAULT_VECTOR_NUM        48              // 16 system + 32 IRQ, the size of __Vectors
+
+#define SYS_FAULT_FLASH_ADDR        0x00083000      // one 4KB sector, after the MW_FIM zones
+#define SYS_FAULT_MAGIC             0x544C4146      // "FALT"
+#define SYS_FAULT_VERSION           1
+
+#define SYS_FAULT_TASK_NAME_LEN     16              // include '\0'
+#define SYS_FAULT_STACK_NUM         64              // words above the exception frame
+#define SYS_FAULT_TRACE_NUM         8               // the last tracer lines
+#define SYS_FAULT_TRACE_LEN         64              // include '\0'
+
+#define SYS_FAULT_RAM_START         0x00400000
+#define SYS_FAULT_RAM_END           0x00450000      // __initial_sp
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef enum
+{
+    SYS_FAULT_TYPE_HARD = 3,        // the exception number
+    SYS_FAULT_TYPE_MEM = 4,
+    SYS_FAULT_TYPE_BUS = 5,
+    SYS_FAULT_TYPE_USAGE = 6,
+    SYS_FAULT_TYPE_STALL = 0xFE,    // a task missed its deadline, see sys_wdt.h
+    SYS_FAULT_TYPE_WDT = 0xFF
+} E_SysFaultType_t;
+
+typedef enum
+{
+    SYS_FAULT_REG_R0 = 0,           // the order of the exception frame
+    SYS_FAULT_REG_R1,
+    SYS_FAULT_REG_R2,
+    SYS_FAULT_REG_R3,
+    SYS_FAULT_REG_R12,
+    SYS_FAULT_REG_LR,
+    SYS_FAULT_REG_PC,
+    SYS_FAULT_REG_XPSR,
+
+    SYS_FAULT_REG_NUM
+} E_SysFaultReg_t;
+
+typedef struct
+{
+    uint32_t u32Magic;
+    uint16_t u16Version;
+    uint16_t u16Size;               // sizeof(S_SysFaultRecord_t)
+    uint32_t u32Seq;                // crashes since the sector was cleared
+    uint32_t u32Type;               // E_SysFaultType_t
+    uint32_t u32Tick;               // osKernelSysTick, ms since boot
+
+    uint32_t u32aReg[SYS_FAULT_REG_NUM];
+    uint32_t u32Sp;                 // address of the exception frame
+    uint32_t u32ExcReturn;          // 0: unknown (watchdog, task stall)
+    uint32_t u32Cfsr;
+    uint32_t u32Hfsr;
+    uint32_t u32Mmfar;
+    uint32_t u32Bfar;
+
+    char baTask[SYS_FAULT_TASK_NAME_LEN];
+
+    uint32_t u32StackNum;
+    uint32_t u32aStack[SYS_FAULT_STACK_NUM];
+
+    char baTrace[SYS_FAULT_TRACE_NUM][SYS_FAULT_TRACE_LEN];   // oldest first
+
+    uint32_t u32Crc;                // CRC-32 of the fields above
+} S_SysFaultRecord_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+void Sys_FaultInit(void);
+void Sys_FaultHandler(void);
+void Sys_FaultCapture(uint32_t u32Msp, uint32_t u32Psp, uint32_t u32ExcReturn);
+void Sys_FaultWdtCapture(void);
+void Sys_FaultStallCapture(void *pTask);
+void Sys_FaultTraceAdd(const char *sLine);
+
+// the RAM vector table, for the modules that hook an exception
+uint32_t Sys_VectorGet(uint32_t u32Num);
+int Sys_VectorSet(uint32_t u32Num, uint32_t u32Handler);
+
+int Sys_FaultRecordGet(S_SysFaultRecord_t *ptRecord);
+int Sys_FaultRecordClear(void);
+
+void Sys_FaultCmd(char *sCmd);
+int Sys_FaultAtCmd(char *buf, int len, int mode);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+
+// Sec 7: declaration of static function prototype
+
+#endif // __SYS_FAULT_H__
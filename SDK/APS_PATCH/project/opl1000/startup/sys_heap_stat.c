@@ -0,0 +1,971 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_heap_stat.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This source file defines the heap statistics, the allocation failure hook
+*  and the "heap" diag command.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "sys_common.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "sys_heap_stat.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SYS_HEAP_STAT_BLOCK_MASK    (SYS_HEAP_STAT_BLOCK_NUM - 1)
+#define SYS_HEAP_STAT_BLOCK_SIZE_MAX 0xFFFF
+
+#define SYS_HEAP_STAT_LIBC_WINDOW   0x40    // bytes of malloc/calloc/realloc before the call
+#define SYS_HEAP_STAT_SCAN_NUM      16      // stack words searched for the caller
+
+#define SYS_HEAP_STAT_ROM_END       0x00100000
+#define SYS_HEAP_STAT_RAM_START     0x00400000
+#define SYS_HEAP_STAT_RAM_END       0x00450000
+
+#define SYS_HEAP_STAT_PARAM_MAX     2
+
+#define SYS_HEAP_STAT_CRIT_ENTER(x) do { x = __get_PRIMASK(); __disable_irq(); } while(0)
+#define SYS_HEAP_STAT_CRIT_EXIT(x)  __set_PRIMASK(x)
+
+#define SYS_HEAP_STAT_LOG(...)      tracer_cli(LOG_HIGH_LEVEL, __VA_ARGS__)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    uint32_t u32Ptr;                // 0: empty
+    uint16_t u16Size;
+    uint8_t u8Site;                 // index of the site table
+    uint8_t u8Task;                 // index of the task table
+} S_SysHeapBlock_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+// the allocator under the wrappers
+RET_DATA T_osMemoryAllocateFp g_fpSysHeapAlloc;
+RET_DATA T_osMemoryDeallocateFp g_fpSysHeapFree;
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+static S_SysHeapStat_t g_tSysHeapStat;
+static S_SysHeapBlock_t g_taSysHeapBlock[SYS_HEAP_STAT_BLOCK_NUM];
+static S_SysHeapSite_t g_taSysHeapSite[SYS_HEAP_STAT_SITE_NUM];
+static S_SysHeapSite_t g_tSysHeapSiteOther;     // the sites beyond the table
+static uint32_t g_u32SysHeapSiteNum;
+static S_SysHeapTask_t g_taSysHeapTask[SYS_HEAP_STAT_TASK_NUM];
+static uint32_t g_u32SysHeapTaskNum;
+
+static T_SysHeapFailHook g_fpSysHeapFailHook;
+static uint8_t g_u8SysHeapFailBusy;
+
+// the minimum free since the first probe of Sys_HeapLargestFree, 0: no probe yet
+static uint32_t g_u32SysHeapMinEver;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static uint8_t _Sys_HeapInLibc(uint32_t u32Addr)
+{
+    uint32_t u32aFunc[3];
+    uint32_t i = 0;
+
+    u32aFunc[0] = (uint32_t)malloc & ~1UL;
+    u32aFunc[1] = (uint32_t)calloc & ~1UL;
+    u32aFunc[2] = (uint32_t)realloc & ~1UL;
+
+    for (i = 0; i < 3; i++)
+    {
+        if ((u32Addr > u32aFunc[i]) && (u32Addr < u32aFunc[i] + SYS_HEAP_STAT_LIBC_WINDOW))
+            return 1;
+    }
+
+    return 0;
+}
+
+static uint8_t _Sys_HeapIsCode(uint32_t u32Addr)
+{
+    // a return address has the Thumb bit
+    if (!(u32Addr & 1))
+        return 0;
+
+    if (u32Addr < SYS_HEAP_STAT_ROM_END)
+        return 1;
+
+    if ((u32Addr >= SYS_HEAP_STAT_RAM_START) && (u32Addr < SYS_HEAP_STAT_RAM_END))
+        return 1;
+
+    return 0;
+}
+
+// the caller of malloc/calloc/realloc: the first return address on the stack
+// that is not in them, best effort
+static uint32_t _Sys_HeapSite(uint32_t u32Ret, uint32_t *pu32Sp)
+{
+    uint32_t u32Word = 0;
+    uint32_t i = 0;
+
+    if (!_Sys_HeapInLibc(u32Ret & ~1UL))
+        return u32Ret;
+
+    for (i = 0; i < SYS_HEAP_STAT_SCAN_NUM; i++)
+    {
+        if ((uint32_t)&pu32Sp[i] >= SYS_HEAP_STAT_RAM_END)
+            break;
+
+        u32Word = pu32Sp[i];
+
+        if ((u32Word != u32Ret) && _Sys_HeapIsCode(u32Word) && !_Sys_HeapInLibc(u32Word & ~1UL))
+            return u32Word;
+    }
+
+    return u32Ret;
+}
+
+static void *_Sys_HeapTaskHandle(void)
+{
+    if (__get_IPSR() != 0)
+        return SYS_HEAP_STAT_HANDLE_ISR;
+
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+        return NULL;
+
+    return (void *)xTaskGetCurrentTaskHandle();
+}
+
+static void _Sys_HeapTaskName(void *pHandle, char *sName)
+{
+    if (pHandle == SYS_HEAP_STAT_HANDLE_ISR)
+        strncpy(sName, "(isr)", SYS_HEAP_STAT_NAME_LEN - 1);
+    else if (pHandle)
+        strncpy(sName, pcTaskGetName((TaskHandle_t)pHandle), SYS_HEAP_STAT_NAME_LEN - 1);
+    else
+        strncpy(sName, "(init)", SYS_HEAP_STAT_NAME_LEN - 1);
+
+    sName[SYS_HEAP_STAT_NAME_LEN - 1] = 0;
+}
+
+// the caller disables the interrupts
+static uint8_t _Sys_HeapSiteIdx(uint32_t u32Site)
+{
+    uint32_t i = 0;
+
+    for (i = 0; i < g_u32SysHeapSiteNum; i++)
+    {
+        if (g_taSysHeapSite[i].u32Site == u32Site)
+            return i;
+    }
+
+    if (g_u32SysHeapSiteNum >= SYS_HEAP_STAT_SITE_NUM)
+        return SYS_HEAP_STAT_IDX_NONE;
+
+    g_taSysHeapSite[g_u32SysHeapSiteNum].u32Site = u32Site;
+    return g_u32SysHeapSiteNum++;
+}
+
+// the caller disables the interrupts
+static uint8_t _Sys_HeapTaskIdx(void *pHandle)
+{
+    uint32_t i = 0;
+
+    for (i = 0; i < g_u32SysHeapTaskNum; i++)
+    {
+        if (g_taSysHeapTask[i].pHandle == pHandle)
+            return i;
+    }
+
+    if (g_u32SysHeapTaskNum >= SYS_HEAP_STAT_TASK_NUM)
+        return SYS_HEAP_STAT_IDX_NONE;
+
+    g_taSysHeapTask[g_u32SysHeapTaskNum].pHandle = pHandle;
+    _Sys_HeapTaskName(pHandle, g_taSysHeapTask[g_u32SysHeapTaskNum].baName);
+    return g_u32SysHeapTaskNum++;
+}
+
+static S_SysHeapSite_t *_Sys_HeapSiteGet(uint8_t u8Idx)
+{
+    if (u8Idx == SYS_HEAP_STAT_IDX_NONE)
+        return &g_tSysHeapSiteOther;
+
+    return &g_taSysHeapSite[u8Idx];
+}
+
+// the caller disables the interrupts
+static void _Sys_HeapTrackAdd(void *pPtr, uint32_t u32Size, uint32_t u32Site, void *pHandle)
+{
+    S_SysHeapStat_t *ptStat = &g_tSysHeapStat;
+    S_SysHeapBlock_t *ptBlock = NULL;
+    S_SysHeapSite_t *ptSite = NULL;
+    S_SysHeapTask_t *ptTask = NULL;
+    uint32_t u32Idx = ((uint32_t)pPtr >> 3) & SYS_HEAP_STAT_BLOCK_MASK;
+    uint32_t i = 0;
+
+    if ((u32Size > SYS_HEAP_STAT_BLOCK_SIZE_MAX) || (ptStat->u32Blocks >= SYS_HEAP_STAT_BLOCK_NUM - 1))
+        goto untracked;
+
+    for (i = 0; i < SYS_HEAP_STAT_BLOCK_NUM; i++)
+    {
+        ptBlock = &g_taSysHeapBlock[(u32Idx + i) & SYS_HEAP_STAT_BLOCK_MASK];
+
+        if (ptBlock->u32Ptr == 0)
+            break;
+    }
+
+    ptBlock->u32Ptr = (uint32_t)pPtr;
+    ptBlock->u16Size = (uint16_t)u32Size;
+    ptBlock->u8Site = _Sys_HeapSiteIdx(u32Site);
+    ptBlock->u8Task = _Sys_HeapTaskIdx(pHandle);
+
+    ptStat->u32Blocks++;
+    ptStat->u32Live += u32Size;
+
+    if (ptStat->u32Live > ptStat->u32Peak)
+        ptStat->u32Peak = ptStat->u32Live;
+
+    ptSite = _Sys_HeapSiteGet(ptBlock->u8Site);
+    ptSite->u32Blocks++;
+    ptSite->u32Alloc++;
+    ptSite->u32Live += u32Size;
+
+    if (ptSite->u32Live > ptSite->u32Peak)
+        ptSite->u32Peak = ptSite->u32Live;
+
+    if (ptBlock->u8Task != SYS_HEAP_STAT_IDX_NONE)
+    {
+        ptTask = &g_taSysHeapTask[ptBlock->u8Task];
+        ptTask->u32Live += u32Size;
+
+        if (ptTask->u32Live > ptTask->u32Peak)
+            ptTask->u32Peak = ptTask->u32Live;
+    }
+
+    return;
+
+untracked:
+    ptStat->u32Untracked++;
+}
+
+// the caller disables the interrupts
+static void _Sys_HeapTrackDel(void *pPtr)
+{
+    S_SysHeapStat_t *ptStat = &g_tSysHeapStat;
+    S_SysHeapBlock_t *ptBlock = NULL;
+    S_SysHeapSite_t *ptSite = NULL;
+    uint32_t u32Idx = ((uint32_t)pPtr >> 3) & SYS_HEAP_STAT_BLOCK_MASK;
+    uint32_t u32Next = 0;
+    uint32_t u32Home = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < SYS_HEAP_STAT_BLOCK_NUM; i++)
+    {
+        ptBlock = &g_taSysHeapBlock[u32Idx];
+
+        if (ptBlock->u32Ptr == (uint32_t)pPtr)
+            goto found;
+
+        if (ptBlock->u32Ptr == 0)
+            break;
+
+        u32Idx = (u32Idx + 1) & SYS_HEAP_STAT_BLOCK_MASK;
+    }
+
+    ptStat->u32FreeUnknown++;
+    return;
+
+found:
+    ptStat->u32Blocks--;
+    ptStat->u32Live -= ptBlock->u16Size;
+
+    ptSite = _Sys_HeapSiteGet(ptBlock->u8Site);
+    ptSite->u32Blocks--;
+    ptSite->u32Live -= ptBlock->u16Size;
+
+    if (ptBlock->u8Task != SYS_HEAP_STAT_IDX_NONE)
+        g_taSysHeapTask[ptBlock->u8Task].u32Live -= ptBlock->u16Size;
+
+    // backward shift, so the probe chains stay unbroken without tombstones
+    u32Next = u32Idx;
+
+    while (1)
+    {
+        u32Next = (u32Next + 1) & SYS_HEAP_STAT_BLOCK_MASK;
+
+        if (g_taSysHeapBlock[u32Next].u32Ptr == 0)
+            break;
+
+        u32Home = (g_taSysHeapBlock[u32Next].u32Ptr >> 3) & SYS_HEAP_STAT_BLOCK_MASK;
+
+        // leave the entry if its home is cyclically in (u32Idx, u32Next]
+        if (((u32Next - u32Home) & SYS_HEAP_STAT_BLOCK_MASK) < ((u32Next - u32Idx) & SYS_HEAP_STAT_BLOCK_MASK))
+            continue;
+
+        g_taSysHeapBlock[u32Idx] = g_taSysHeapBlock[u32Next];
+        u32Idx = u32Next;
+    }
+
+    g_taSysHeapBlock[u32Idx].u32Ptr = 0;
+}
+
+static void _Sys_HeapFail(uint32_t u32Size, uint32_t u32Site, void *pHandle)
+{
+    S_SysHeapFail_t *ptFail = &g_tSysHeapStat.tLastFail;
+    uint32_t u32Primask = 0;
+
+    SYS_HEAP_STAT_CRIT_ENTER(u32Primask);
+
+    g_tSysHeapStat.u32Fail++;
+
+    ptFail->u32Size = u32Size;
+    ptFail->u32Site = u32Site;
+    ptFail->u32Tick = osKernelSysTick();
+    ptFail->u32Free = xPortGetFreeHeapSize();
+    _Sys_HeapTaskName(pHandle, ptFail->baTask);
+
+    // printf or the hook may allocate
+    if (g_u8SysHeapFailBusy)
+    {
+        SYS_HEAP_STAT_CRIT_EXIT(u32Primask);
+        return;
+    }
+
+    g_u8SysHeapFailBusy = 1;
+    SYS_HEAP_STAT_CRIT_EXIT(u32Primask);
+
+    printf("heap: alloc %u fail, site 0x%08X task %s free %u\r\n",
+           u32Size, u32Site, ptFail->baTask, ptFail->u32Free);
+
+    if (g_fpSysHeapFailHook)
+        g_fpSysHeapFailHook(u32Size, u32Site);
+
+    g_u8SysHeapFailBusy = 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_HeapAlloc
+*
+* DESCRIPTION:
+*   1. osMemoryAllocate: count, track the block and report a failure
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ulWantedSize : [In] bytes
+*
+* RETURNS
+*   the block, NULL if fail
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void *Sys_HeapAlloc(uint32_t ulWantedSize)
+{
+    uint32_t u32Ret = __return_address();
+    uint32_t *pu32Sp = (uint32_t *)__current_sp();
+    uint32_t u32Primask = 0;
+    void *pPtr = NULL;
+
+    pPtr = g_fpSysHeapAlloc(ulWantedSize);
+
+    if (!pPtr)
+    {
+        _Sys_HeapFail(ulWantedSize, _Sys_HeapSite(u32Ret, pu32Sp), _Sys_HeapTaskHandle());
+        return NULL;
+    }
+
+    SYS_HEAP_STAT_CRIT_ENTER(u32Primask);
+
+    g_tSysHeapStat.u32Alloc++;
+
+    if ((g_u32SysHeapMinEver) && (xPortGetFreeHeapSize() < g_u32SysHeapMinEver))
+        g_u32SysHeapMinEver = xPortGetFreeHeapSize();
+
+    if (g_tSysHeapStat.u8Track)
+        _Sys_HeapTrackAdd(pPtr, ulWantedSize, _Sys_HeapSite(u32Ret, pu32Sp), _Sys_HeapTaskHandle());
+
+    SYS_HEAP_STAT_CRIT_EXIT(u32Primask);
+    return pPtr;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_HeapFree
+*
+* DESCRIPTION:
+*   1. osMemoryDeallocate: count and untrack the block
+*
+* CALLS
+*
+* PARAMETERS
+*   1. pvMemPtr : [In] the block
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_HeapFree(void *pvMemPtr)
+{
+    uint32_t u32Primask = 0;
+
+    if (pvMemPtr)
+    {
+        SYS_HEAP_STAT_CRIT_ENTER(u32Primask);
+
+        g_tSysHeapStat.u32Free++;
+
+        if (g_tSysHeapStat.u8Track)
+            _Sys_HeapTrackDel(pvMemPtr);
+
+        SYS_HEAP_STAT_CRIT_EXIT(u32Primask);
+    }
+
+    g_fpSysHeapFree(pvMemPtr);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_HeapStatInit
+*
+* DESCRIPTION:
+*   1. Put the wrappers over osMemoryAllocate/osMemoryDeallocate, cold boot
+*      only, before the first allocation
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_HeapStatInit(void)
+{
+    if (osMemoryAllocate == Sys_HeapAlloc)
+        return;
+
+    g_fpSysHeapAlloc = osMemoryAllocate;
+    g_fpSysHeapFree = osMemoryDeallocate;
+
+    osMemoryAllocate = Sys_HeapAlloc;
+    osMemoryDeallocate = Sys_HeapFree;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_HeapStatFailHookSet
+*
+* DESCRIPTION:
+*   1. Set the function called after an allocation fails, in the context of
+*      the caller (maybe an ISR). It must not block.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. fpHook : [In] NULL to remove
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_HeapStatFailHookSet(T_SysHeapFailHook fpHook)
+{
+    g_fpSysHeapFailHook = fpHook;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_HeapStatReset
+*
+* DESCRIPTION:
+*   1. Clear the counters and the tables. The blocks allocated before are
+*      not known any more, their frees count as u32FreeUnknown.
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_HeapStatReset(void)
+{
+    uint32_t u32Primask = 0;
+    uint8_t u8Track = 0;
+
+    SYS_HEAP_STAT_CRIT_ENTER(u32Primask);
+
+    u8Track = g_tSysHeapStat.u8Track;
+    memset(&g_tSysHeapStat, 0, sizeof(g_tSysHeapStat));
+    g_tSysHeapStat.u8Track = u8Track;
+
+    memset(g_taSysHeapBlock, 0, sizeof(g_taSysHeapBlock));
+    memset(g_taSysHeapSite, 0, sizeof(g_taSysHeapSite));
+    memset(&g_tSysHeapSiteOther, 0, sizeof(g_tSysHeapSiteOther));
+    memset(g_taSysHeapTask, 0, sizeof(g_taSysHeapTask));
+    g_u32SysHeapSiteNum = 0;
+    g_u32SysHeapTaskNum = 0;
+
+    SYS_HEAP_STAT_CRIT_EXIT(u32Primask);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_HeapStatTrackSet
+*
+* DESCRIPTION:
+*   1. Start the tracking from empty tables, or stop it. The reports stay
+*      as they were at the stop.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. u8Enable : [In] 1: start, 0: stop
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_HeapStatTrackSet(uint8_t u8Enable)
+{
+    if (u8Enable)
+    {
+        if (g_tSysHeapStat.u8Track)
+            return;
+
+        Sys_HeapStatReset();
+    }
+
+    g_tSysHeapStat.u8Track = u8Enable ? 1 : 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_HeapStatGet
+*
+* DESCRIPTION:
+*   1. Copy the counters
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptStat : [Out] the counters
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_HeapStatGet(S_SysHeapStat_t *ptStat)
+{
+    uint32_t u32Primask = 0;
+
+    SYS_HEAP_STAT_CRIT_ENTER(u32Primask);
+    memcpy(ptStat, &g_tSysHeapStat, sizeof(S_SysHeapStat_t));
+    SYS_HEAP_STAT_CRIT_EXIT(u32Primask);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_HeapStatSiteGet
+*
+* DESCRIPTION:
+*   1. Copy the call sites, the most live bytes first. The sites beyond the
+*      table are summed in one last entry of u32Site 0.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptSite : [Out] the sites
+*   2. u32Max : [In] entries of ptSite
+*
+* RETURNS
+*   entries copied
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Sys_HeapStatSiteGet(S_SysHeapSite_t *ptSite, uint32_t u32Max)
+{
+    S_SysHeapSite_t tTmp;
+    uint32_t u32Primask = 0;
+    uint32_t u32Num = 0;
+    uint32_t i = 0;
+    uint32_t j = 0;
+
+    SYS_HEAP_STAT_CRIT_ENTER(u32Primask);
+
+    u32Num = (g_u32SysHeapSiteNum < u32Max) ? g_u32SysHeapSiteNum : u32Max;
+    memcpy(ptSite, g_taSysHeapSite, u32Num * sizeof(S_SysHeapSite_t));
+
+    if ((g_tSysHeapSiteOther.u32Alloc) && (u32Num < u32Max))
+        ptSite[u32Num++] = g_tSysHeapSiteOther;
+
+    SYS_HEAP_STAT_CRIT_EXIT(u32Primask);
+
+    for (i = 0; i < u32Num; i++)
+    {
+        for (j = i + 1; j < u32Num; j++)
+        {
+            if (ptSite[j].u32Live > ptSite[i].u32Live)
+            {
+                tTmp = ptSite[i];
+                ptSite[i] = ptSite[j];
+                ptSite[j] = tTmp;
+            }
+        }
+    }
+
+    return u32Num;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_HeapStatTaskGet
+*
+* DESCRIPTION:
+*   1. Copy the tasks, in the order of their first allocation
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptTask : [Out] the tasks
+*   2. u32Max : [In] entries of ptTask
+*
+* RETURNS
+*   entries copied
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Sys_HeapStatTaskGet(S_SysHeapTask_t *ptTask, uint32_t u32Max)
+{
+    uint32_t u32Primask = 0;
+    uint32_t u32Num = 0;
+
+    SYS_HEAP_STAT_CRIT_ENTER(u32Primask);
+
+    u32Num = (g_u32SysHeapTaskNum < u32Max) ? g_u32SysHeapTaskNum : u32Max;
+    memcpy(ptTask, g_taSysHeapTask, u32Num * sizeof(S_SysHeapTask_t));
+
+    SYS_HEAP_STAT_CRIT_EXIT(u32Primask);
+    return u32Num;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_HeapLargestFree
+*
+* DESCRIPTION:
+*   1. The largest block the heap can give now: binary search of the size
+*      with pvPortMallocEx/vPortFreeEx, the scheduler suspended. The
+*      partition pools are not counted.
+*   2. The probe takes the heap down to nothing, and heap_4 keeps that as
+*      its minimum ever: the minimum is saved before the first probe and
+*      followed by Sys_HeapAlloc from then on (Sys_HeapMinEverFree).
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   bytes
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Sys_HeapLargestFree(void)
+{
+    uint32_t u32Low = 0;
+    uint32_t u32High = 0;
+    uint32_t u32Mid = 0;
+    void *pPtr = NULL;
+
+    vTaskSuspendAll();
+
+    if (!g_u32SysHeapMinEver)
+        g_u32SysHeapMinEver = xPortGetMinimumEverFreeHeapSize();
+
+    u32High = xPortGetFreeHeapSize();
+
+    while (u32Low < u32High)
+    {
+        u32Mid = u32Low + ((u32High - u32Low + 1) / 2);
+        pPtr = pvPortMallocEx(u32Mid, 0);
+
+        if (pPtr)
+        {
+            vPortFreeEx(pPtr);
+            u32Low = u32Mid;
+        }
+        else
+        {
+            u32High = u32Mid - 1;
+        }
+    }
+
+    xTaskResumeAll();
+    return u32Low;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_HeapMinEverFree
+*
+* DESCRIPTION:
+*   1. xPortGetMinimumEverFreeHeapSize, not lowered by the probes of
+*      Sys_HeapLargestFree. After the first probe, the allocations made
+*      past osMemoryAllocate (pvPortMalloc direct) are not seen.
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   bytes
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Sys_HeapMinEverFree(void)
+{
+    if (!g_u32SysHeapMinEver)
+        return xPortGetMinimumEverFreeHeapSize();
+
+    return g_u32SysHeapMinEver;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_HeapFragPermille
+*
+* DESCRIPTION:
+*   1. Fragmentation index in 0.1%: 0 when the free bytes are one block,
+*      near 1000 when the largest block is a small part of them
+*
+* CALLS
+*
+* PARAMETERS
+*   1. u32Free    : [In] xPortGetFreeHeapSize
+*   2. u32Largest : [In] Sys_HeapLargestFree
+*
+* RETURNS
+*   0 ~ 1000
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Sys_HeapFragPermille(uint32_t u32Free, uint32_t u32Largest)
+{
+    if ((u32Free == 0) || (u32Largest >= u32Free))
+        return 0;
+
+    return 1000 - ((u32Largest * 1000) / u32Free);
+}
+
+static void _Sys_HeapStatDump(void)
+{
+    S_SysHeapStat_t tStat;
+    S_SysHeapFail_t *ptFail = &tStat.tLastFail;
+    uint32_t u32Free = 0;
+    uint32_t u32Largest = 0;
+    uint32_t u32Frag = 0;
+
+    u32Largest = Sys_HeapLargestFree();
+    u32Free = xPortGetFreeHeapSize();
+    u32Frag = Sys_HeapFragPermille(u32Free, u32Largest);
+
+    Sys_HeapStatGet(&tStat);
+
+    SYS_HEAP_STAT_LOG("heap: total %u free %u min-ever %u largest %u frag %u.%u%%\n",
+                      (uint32_t)configTOTAL_HEAP_SIZE, u32Free, Sys_HeapMinEverFree(),
+                      u32Largest, u32Frag / 10, u32Frag % 10);
+    SYS_HEAP_STAT_LOG("heap: alloc %u free %u fail %u\n", tStat.u32Alloc, tStat.u32Free, tStat.u32Fail);
+
+    if (tStat.u32Fail)
+    {
+        SYS_HEAP_STAT_LOG("heap: last fail %u bytes site 0x%08X task %s at %u ms, free %u\n",
+                          ptFail->u32Size, ptFail->u32Site, ptFail->baTask, ptFail->u32Tick, ptFail->u32Free);
+    }
+
+    if (!tStat.u8Track && !tStat.u32Peak)
+    {
+        SYS_HEAP_STAT_LOG("heap: track off\n");
+        return;
+    }
+
+    SYS_HEAP_STAT_LOG("heap: track %s live %u peak %u blocks %u untracked %u unknown-free %u\n",
+                      tStat.u8Track ? "on" : "off", tStat.u32Live, tStat.u32Peak, tStat.u32Blocks,
+                      tStat.u32Untracked, tStat.u32FreeUnknown);
+}
+
+static void _Sys_HeapSiteDump(void)
+{
+    S_SysHeapSite_t *ptSite = NULL;
+    uint32_t u32Num = 0;
+    uint32_t i = 0;
+
+    ptSite = (S_SysHeapSite_t *)malloc((SYS_HEAP_STAT_SITE_NUM + 1) * sizeof(S_SysHeapSite_t));
+    if (!ptSite)
+    {
+        SYS_HEAP_STAT_LOG("heap: malloc fail\n");
+        return;
+    }
+
+    u32Num = Sys_HeapStatSiteGet(ptSite, SYS_HEAP_STAT_SITE_NUM + 1);
+
+    SYS_HEAP_STAT_LOG("  %-10s %8s %8s %8s %8s\n", "site", "live", "peak", "blocks", "alloc");
+
+    for (i = 0; i < u32Num; i++)
+    {
+        if (ptSite[i].u32Site)
+            SYS_HEAP_STAT_LOG("  0x%08X %8u %8u %8u %8u\n", ptSite[i].u32Site, ptSite[i].u32Live,
+                              ptSite[i].u32Peak, ptSite[i].u32Blocks, ptSite[i].u32Alloc);
+        else
+            SYS_HEAP_STAT_LOG("  %-10s %8u %8u %8u %8u\n", "(other)", ptSite[i].u32Live,
+                              ptSite[i].u32Peak, ptSite[i].u32Blocks, ptSite[i].u32Alloc);
+    }
+
+    free(ptSite);
+}
+
+static void _Sys_HeapTaskDump(void)
+{
+    S_SysHeapTask_t *ptTask = NULL;
+    uint32_t u32Num = 0;
+    uint32_t i = 0;
+
+    ptTask = (S_SysHeapTask_t *)malloc(SYS_HEAP_STAT_TASK_NUM * sizeof(S_SysHeapTask_t));
+    if (!ptTask)
+    {
+        SYS_HEAP_STAT_LOG("heap: malloc fail\n");
+        return;
+    }
+
+    u32Num = Sys_HeapStatTaskGet(ptTask, SYS_HEAP_STAT_TASK_NUM);
+
+    SYS_HEAP_STAT_LOG("  %-16s %8s %8s\n", "task", "live", "peak");
+
+    for (i = 0; i < u32Num; i++)
+        SYS_HEAP_STAT_LOG("  %-16s %8u %8u\n", ptTask[i].baName, ptTask[i].u32Live, ptTask[i].u32Peak);
+
+    free(ptTask);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Sys_HeapStatCmd
+*
+* DESCRIPTION:
+*   diag command: heap [stat|site|task|track on|off|reset]
+*     stat: free, largest block, fragmentation, counters, the last failure
+*     site/task: live bytes and peak since "heap track on"
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void Sys_HeapStatCmd(char *sCmd)
+{
+    char *baParam[SYS_HEAP_STAT_PARAM_MAX + 1] = {0};
+    uint32_t u32Num = 0;
+
+    u32Num = ParseParam(sCmd, baParam, SYS_HEAP_STAT_PARAM_MAX + 1);
+
+    if ((u32Num < 2) || (!strcmp(baParam[1], "stat")))
+    {
+        _Sys_HeapStatDump();
+        goto done;
+    }
+
+    if (!strcmp(baParam[1], "site"))
+    {
+        _Sys_HeapSiteDump();
+        goto done;
+    }
+
+    if (!strcmp(baParam[1], "task"))
+    {
+        _Sys_HeapTaskDump();
+        goto done;
+    }
+
+    if ((u32Num >= 3) && (!strcmp(baParam[1], "track")))
+    {
+        if (!strcmp(baParam[2], "on"))
+            Sys_HeapStatTrackSet(1);
+        else if (!strcmp(baParam[2], "off"))
+            Sys_HeapStatTrackSet(0);
+        else if (!strcmp(baParam[2], "reset"))
+            Sys_HeapStatReset();
+        else
+            goto usage;
+
+        SYS_HEAP_STAT_LOG("heap: track %s\n", g_tSysHeapStat.u8Track ? "on" : "off");
+        goto done;
+    }
+
+usage:
+    SYS_HEAP_STAT_LOG("usage: heap [stat|site|task|track on|off|reset]\n");
+
+done:
+    return;
+}
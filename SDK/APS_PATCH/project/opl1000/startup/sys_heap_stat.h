@@ -0,0 +1,147 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_heap_stat.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This include file defines the heap statistics of pvPortMalloc/vPortFree
+*  (osMemoryAllocate/osMemoryDeallocate, the C library malloc/free included).
+*
+*  Always on: call counters and the allocation failure hook. A failure is
+*  recorded with its size, call site and task, printed, and passed to the
+*  hook set by Sys_HeapStatFailHookSet.
+*
+*  Tracking (Sys_HeapStatTrackSet): every live block is kept in a table
+*  outside the heap, so the block layout of the ROM heap does not change
+*  and tracking can be switched at any time. Blocks allocated before it
+*  are not known, nor are the ones beyond SYS_HEAP_STAT_BLOCK_NUM. Live
+*  bytes and the peak are summed per call site and per task.
+*
+*  The call site is the return address of the allocation. For the C
+*  library malloc/calloc/realloc it is taken one frame up from the stack,
+*  best effort.
+*
+*  The largest free block is found by probing the heap with allocations of
+*  the halved size, with the scheduler suspended. The probe would be the
+*  minimum ever free of heap_4, Sys_HeapMinEverFree gives the real one.
+*
+******************************************************************************/
+#ifndef __SYS_HEAP_STAT_H__
+#define __SYS_HEAP_STAT_H__
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdint.h>
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SYS_HEAP_STAT_BLOCK_NUM     128     // live blocks tracked, power of 2
+#define SYS_HEAP_STAT_SITE_NUM      32
+#define SYS_HEAP_STAT_TASK_NUM      16
+#define SYS_HEAP_STAT_NAME_LEN      16      // include '\0'
+
+#define SYS_HEAP_STAT_IDX_NONE      0xFF    // the site or task table is full
+
+#define SYS_HEAP_STAT_HANDLE_ISR    ((void *)1) // pHandle of the ISR allocations
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    uint32_t u32Site;               // return address of the allocation
+    uint32_t u32Live;               // bytes
+    uint32_t u32Peak;
+    uint32_t u32Blocks;             // live blocks
+    uint32_t u32Alloc;              // allocations since the tracking started
+} S_SysHeapSite_t;
+
+typedef struct
+{
+    void *pHandle;                  // TaskHandle_t, NULL: before the scheduler, SYS_HEAP_STAT_HANDLE_ISR
+    char baName[SYS_HEAP_STAT_NAME_LEN];
+    uint32_t u32Live;
+    uint32_t u32Peak;
+} S_SysHeapTask_t;
+
+typedef struct
+{
+    uint32_t u32Size;
+    uint32_t u32Site;
+    uint32_t u32Tick;               // osKernelSysTick
+    uint32_t u32Free;               // xPortGetFreeHeapSize at the failure
+    char baTask[SYS_HEAP_STAT_NAME_LEN];
+} S_SysHeapFail_t;
+
+typedef struct
+{
+    uint32_t u32Alloc;
+    uint32_t u32Free;
+    uint32_t u32Fail;
+    S_SysHeapFail_t tLastFail;
+
+    // tracking
+    uint8_t u8Track;
+    uint32_t u32Live;               // bytes of the tracked blocks
+    uint32_t u32Peak;
+    uint32_t u32Blocks;
+    uint32_t u32Untracked;          // allocations the block table had no room for
+    uint32_t u32FreeUnknown;        // frees of blocks not in the table
+} S_SysHeapStat_t;
+
+typedef void (*T_SysHeapFailHook)(uint32_t u32Size, uint32_t u32Site);
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+void Sys_HeapStatInit(void);
+
+// osMemoryAllocate/osMemoryDeallocate after Sys_HeapStatInit
+void *Sys_HeapAlloc(uint32_t ulWantedSize);
+void Sys_HeapFree(void *pvMemPtr);
+
+void Sys_HeapStatFailHookSet(T_SysHeapFailHook fpHook);
+
+void Sys_HeapStatTrackSet(uint8_t u8Enable);
+void Sys_HeapStatReset(void);
+
+void Sys_HeapStatGet(S_SysHeapStat_t *ptStat);
+uint32_t Sys_HeapStatSiteGet(S_SysHeapSite_t *ptSite, uint32_t u32Max);
+uint32_t Sys_HeapStatTaskGet(S_SysHeapTask_t *ptTask, uint32_t u32Max);
+
+uint32_t Sys_HeapLargestFree(void);
+uint32_t Sys_HeapMinEverFree(void);
+uint32_t Sys_HeapFragPermille(uint32_t u32Free, uint32_t u32Largest);
+
+void Sys_HeapStatCmd(char *sCmd);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+
+// Sec 7: declaration of static function prototype
+
+#endif // __SYS_HEAP_STAT_H__
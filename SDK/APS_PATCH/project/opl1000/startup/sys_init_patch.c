@@ -41,6 +41,7 @@ Head Block of The File
 #include "hal_uart.h"
 #include "hal_spi.h"
 #include "hal_flash.h"
+#include "hal_flash_cache.h"
 #include "hal_pwm.h"
 #include "hal_auxadc.h"
 #include "hal_wdt.h"
@@ -53,13 +54,16 @@ Head Block of The File
 #include "mw_fim\mw_fim_default_group01.h"
 #include "controller_wifi_com.h"
 #include "mw_fim_default_patch.h"
+#include "mw_fim_patch.h"
 #include "ipc_patch.h"
+#include "ipc_batch.h"
 #include "msg_patch.h"
 #include "agent.h"
 #include "le_ctrl_patch.h"
 #include "ble_host_patch_init.h"
 #include "at_cmd_sys_patch.h"
 #include "diag_task_patch.h"
+#include "diag_cmd_table_ext.h"
 #include "controller_wifi_patch.h"
 #include "wpas_init_patch.h"
 #include "at_cmd_patch.h"
@@ -67,9 +71,15 @@ Head Block of The File
 #include "at_cmd_func_patch.h"
 #include "wifi_nvm_patch.h"
 #include "wifi_service_func_init_patch.h"
+#include "wifi_scan_cache.h"
 #include "lwip_jmptbl_patch.h"
 #include "cmsis_os_patch.h"
 #include "opl1000_it_patch.h"
+#include "sys_fault.h"
+#include "sys_heap_stat.h"
+#include "sys_stack.h"
+#include "sys_boot.h"
+#include "sys_wdt.h"
 
 #define __SVN_REVISION__
 #define __DIAG_TASK__
@@ -123,6 +133,9 @@ extern void lwip_task_create(void);
 #include "hal_patch.h"
 #include "peri_patch_init.h"
 #include "mw_ota.h"
+#include "mw_flash_svc.h"
+#include "mw_log_flash.h"
+#include "mw_fs.h"
 #include "scrt_patch.h"
 #include "controller_task_patch.h"
 #include "rf_cfg.h"
@@ -139,7 +152,38 @@ extern void lwip_task_create(void);
 Declaration of data structure
 ********************************************/
 // Sec 3: structure, uniou, enum, linked list
-
+// the index of g_taSysBootStep
+typedef enum
+{
+    SYS_STEP_DBG_UART = 0,
+    SYS_STEP_UART1,
+    SYS_STEP_MISC_CFG,
+    SYS_STEP_PS,
+    SYS_STEP_WDT,
+    SYS_STEP_VERSION,
+    SYS_STEP_DIAG,
+    SYS_STEP_AT,
+    SYS_STEP_WIFI_MAC,
+    SYS_STEP_LWIP,
+    SYS_STEP_SCRT,
+    SYS_STEP_SUPPLICANT,
+    SYS_STEP_CONTROLLER,
+    SYS_STEP_IPC,
+    SYS_STEP_LE,
+    SYS_STEP_AUTO_CONN,
+    SYS_STEP_STA_INFO,
+    SYS_STEP_SCAN_CACHE,
+    SYS_STEP_AGENT,
+    SYS_STEP_TRACER,
+    SYS_STEP_OTA,
+    SYS_STEP_FLASH_SVC,
+    SYS_STEP_STACK,
+    SYS_STEP_WDT_SVC,
+    SYS_STEP_LOG_FLASH,
+    SYS_STEP_FS,
+
+    SYS_STEP_NUM
+} E_SysStep_t;
 
 /********************************************
 Declaration of Global Variables & Functions
@@ -168,6 +212,33 @@ static void Sys_ServiceInit_patch(void);
 static void SysInit_LibVersion(void);
 static void Sys_IdleHook_patch(void);
 
+static void Sys_BootStepDbgUart(void);
+static void Sys_BootStepUart1(void);
+static void Sys_BootStepMiscCfg(void);
+static void Sys_BootStepPs(void);
+static void Sys_BootStepWdt(void);
+static void Sys_BootStepVersion(void);
+static void Sys_BootStepDiag(void);
+static void Sys_BootStepAt(void);
+static void Sys_BootStepWifiMac(void);
+static void Sys_BootStepLwip(void);
+static void Sys_BootStepScrt(void);
+static void Sys_BootStepSupplicant(void);
+static void Sys_BootStepController(void);
+static void Sys_BootStepIpc(void);
+static void Sys_BootStepLe(void);
+static void Sys_BootStepAutoConn(void);
+static void Sys_BootStepStaInfo(void);
+static void Sys_BootStepScanCache(void);
+static void Sys_BootStepAgent(void);
+static void Sys_BootStepTracer(void);
+static void Sys_BootStepOta(void);
+static void Sys_BootStepFlashSvc(void);
+static void Sys_BootStepStack(void);
+static void Sys_BootStepWdtSvc(void);
+static void Sys_BootStepLogFlash(void);
+static void Sys_BootStepFs(void);
+
 /***********
 C Functions
 ***********/
@@ -207,6 +278,7 @@ void SysInit_EntryPoint(void)
 
     // FIM Default
     mw_fim_default_patch_init();
+    mw_fim_patch_init();
 
     // IPC
     ipc_patch_init();
@@ -240,6 +312,7 @@ void SysInit_EntryPoint(void)
     
     // diag task
     diag_task_func_patch_init();
+    diag_cmd_ext_init_patch();
     
     // LwIP
     lwip_module_interface_init_patch();
@@ -261,6 +334,8 @@ void SysInit_EntryPoint(void)
 	
 	// CMSIS-RTOS
 	freertos_patch_init();
+	Sys_HeapStatInit();
+	Sys_StackInit();
 	ISR_Pre_Init_patch();
 }
 
@@ -322,22 +397,17 @@ void Sys_ClockSetup_patch(void)
 *************************************************************************/
 void Main_WaitforMsqReady()
 {
-	const uint32_t m0_ready_msk = 1 << 4;
-	uint32_t reg_spare_0_val;
-
-	do {
-		Hal_Sys_SpareRegRead(SPARE_0, &reg_spare_0_val);
-	} while (!(reg_spare_0_val & m0_ready_msk));
-
-	Hal_Sys_SpareRegWrite(SPARE_0, reg_spare_0_val & ~m0_ready_msk);
+    // the flag may be latched already by the boot sequencer
+    Sys_BootM0Wait();
 }
 
 /*************************************************************************
 * FUNCTION:
-*   Sys_DriverInit
+*   Sys_BootStepDbgUart
 *
 * DESCRIPTION:
-*   the initial for driver
+*   the boot steps of g_taSysBootStep, split from Sys_DriverInit and
+*   Sys_ServiceInit with the same content
 *
 * PARAMETERS
 *   none
@@ -346,70 +416,8 @@ void Main_WaitforMsqReady()
 *   none
 *
 *************************************************************************/
-static void Sys_DriverInit_patch(void)
+static void Sys_BootStepDbgUart(void)
 {
-    // Set power
-    Sys_PowerSetup();
-
-    // Set system clock
-    Sys_ClockSetup();
-
-    // Set pin-mux
-    Hal_SysPinMuxAppInit();
-
-	  // Added for mapping IO8/9 to mini-USB UART 
-	  // Hal_SysPinMuxDownloadInit();
-	
-    // Init VIC
-    Hal_Vic_Init();
-    
-    // Init GPIO
-    Hal_Vic_GpioInit();
-
-	// Init IPC
-    Hal_Vic_IpcIntEn(IPC_IDX_0, 1);
-    Hal_Vic_IpcIntEn(IPC_IDX_1, 1);
-    Hal_Vic_IpcIntEn(IPC_IDX_2, 1);
-    Hal_Vic_IpcIntEn(IPC_IDX_3, 1);
-
-    // Init DBG_UART
-    Hal_DbgUart_Init(115200);
-    printf("\n");
-
-    // Init SPI 0/1/2
-    Hal_Spi_Init(SPI_IDX_0, SystemCoreClockGet()/2,
-        SPI_CLK_PLOAR_HIGH_ACT, SPI_CLK_PHASE_START, SPI_FMT_MOTOROLA, SPI_DFS_08_bit, 1);
-    Hal_Spi_Init(SPI_IDX_1, SystemCoreClockGet()/2,
-        SPI_CLK_PLOAR_HIGH_ACT, SPI_CLK_PHASE_START, SPI_FMT_MOTOROLA, SPI_DFS_08_bit, 1);
-    Hal_Spi_Init(SPI_IDX_2, SystemCoreClockGet()/2,
-        SPI_CLK_PLOAR_HIGH_ACT, SPI_CLK_PHASE_START, SPI_FMT_MOTOROLA, SPI_DFS_08_bit, 1);
-
-    // Init flash on SPI 0/1/2
-    Hal_Flash_Init(SPI_IDX_0);
-    Hal_Flash_Init(SPI_IDX_1);
-    Hal_Flash_Init(SPI_IDX_2);
-
-    // FIM
-    MwFim_Init();
-
-    // Init UART0 / UART1
-    Sys_UartInit();
-    
-    // Init PWM
-    Hal_Pwm_Init();
-    
-    // Init AUXADC
-    Hal_Aux_Init();
-
-    // Other modules' init
-    Sys_MiscModulesInit();
-
-    // Wait for M0 initialization to be completed
-    Main_WaitforMsqReady();
-
-    //-------------------------------------------------------------------------------------
-    // Other driver config need by Task-level (sleep strategy)
-
     // Diag task
     Hal_DbgUart_RxCallBackFuncSet(uartdbg_rx_int_handler);
     // cold boot
@@ -438,13 +446,22 @@ static void Sys_DriverInit_patch(void)
     {
         Hal_DbgUart_RxIntEn(Hal_DbgUart_RxIntEnStatusGet());
     }
+}
 
+static void Sys_BootStepUart1(void)
+{
     // HCI and AT command
     uart1_mode_set_default();
+}
 
+static void Sys_BootStepMiscCfg(void)
+{
     // Other tasks' driver config
     Sys_MiscDriverConfigSetup();
+}
 
+static void Sys_BootStepPs(void)
+{
 	// power-saving module init
 	ps_init();
 
@@ -457,6 +474,10 @@ static void Sys_DriverInit_patch(void)
 		uart1_mode_set_default();
 		uart1_mode_set_at();
 	}
+}
+
+static void Sys_BootStepWdt(void)
+{
     if (Hal_Sys_StrapModeRead() == BOOT_MODE_NORMAL)
     {
         Hal_Vic_IntTypeSel(WDT_IRQn, INT_TYPE_FALLING_EDGE);
@@ -465,77 +486,112 @@ static void Sys_DriverInit_patch(void)
     }
 }
 
-/*************************************************************************
-* FUNCTION:
-*   Sys_ServiceInit
-*
-* DESCRIPTION:
-*   the initial for service
-*
-* PARAMETERS
-*   none
-*
-* RETURNS
-*   none
-*
-*************************************************************************/
-static void Sys_ServiceInit_patch(void)
+static void Sys_BootStepVersion(void)
 {
-    T_MwOtaLayoutInfo tLayout;
-    
     Sys_RomVersion();
     
     SysInit_LibVersion();
+}
 
+static void Sys_BootStepDiag(void)
+{
 #if defined(__DIAG_TASK__)
     diag_task_create();
 #endif
+}
 
+static void Sys_BootStepAt(void)
+{
 #if defined(__AT_CMD_TASK__)
     at_task_create();
 #endif
+}
 
+static void Sys_BootStepWifiMac(void)
+{
 #if defined(__WIFI_MAC_TASK__)
     wifi_mac_task_create();
 #endif
+}
 
+static void Sys_BootStepLwip(void)
+{
 #if defined(__LWIP_TASK__)
     lwip_task_create();
 #endif
+}
 
+static void Sys_BootStepScrt(void)
+{
 #if defined(__HW_CRYPTO_ENGINE__)
     nl_scrt_Init();
 #endif
+}
 
+static void Sys_BootStepSupplicant(void)
+{
 #if defined(__WPA_SUPPLICANT__)
     do_supplicant_init();
 #endif
+}
 
+static void Sys_BootStepController(void)
+{
 #if defined(__CONTROLLER_TASK__)
 	controller_task_create();
 #endif
+}
 
+static void Sys_BootStepIpc(void)
+{
 #ifdef ENHANCE_IPC
     ipc_init();
 #endif
 
+    // IPC doorbell coalescing (passthrough until ipcbatch set)
+    ipc_batch_init();
+}
+
+static void Sys_BootStepLe(void)
+{
 #if defined(__BLE__)
     LeRtosTaskCreat();
 #endif
+}
 
+static void Sys_BootStepAutoConn(void)
+{
 #if defined(__WIFI_AUTO_CONNECT__)
     auto_connect_init();
 #endif
+}
 
+static void Sys_BootStepStaInfo(void)
+{
     wifi_sta_info_init();
-    
-    // Agent
+}
+
+static void Sys_BootStepScanCache(void)
+{
+    // Scan result cache for the reconnect
+    wifi_scan_cache_init();
+}
+
+static void Sys_BootStepAgent(void)
+{
     agent_init();
+}
 
+static void Sys_BootStepTracer(void)
+{
     // Load param from FIM for Tracer
     tracer_load();
-    
-    // OTA
+}
+
+static void Sys_BootStepOta(void)
+{
+    T_MwOtaLayoutInfo tLayout;
+
     MwOta_PreInitCold();
     tLayout.ulaHeaderAddr[0] = MW_OTA_HEADER_ADDR_1;
     tLayout.ulaHeaderAddr[1] = MW_OTA_HEADER_ADDR_2;
@@ -544,11 +600,195 @@ static void Sys_ServiceInit_patch(void)
     tLayout.ulImageSize = MW_OTA_IMAGE_SIZE;
     MwOta_Init(&tLayout, 0);
 }
+
+static void Sys_BootStepFlashSvc(void)
+{
+    // Flash erase service (OTA image, FIM swap), the users fall back to the
+    // blocking erase until it is up
+    MwFlashSvc_Init();
+}
+
+static void Sys_BootStepStack(void)
+{
+    // Stack high-water marks, the worst cases in FIM
+    Sys_StackStart();
+}
+
+static void Sys_BootStepWdtSvc(void)
+{
+    // Watchdog supervisor, the probes of the tcpip thread and the supplicant
+    Sys_WdtStart();
+}
+
+static void Sys_BootStepLogFlash(void)
+{
+    // Flash log of the tracer, the lines before it wait in RAM
+    MwLogFlash_Init();
+}
+
+static void Sys_BootStepFs(void)
+{
+    // File system of the user data, the default partition
+    MwFs_Init(NULL);
+}
+
+// The steps after the driver setup, in the order of the former code. The
+// ones without SYS_BOOT_FLAG_M0 run while the M0 boots.
+static const S_SysBootStep_t g_taSysBootStep[SYS_STEP_NUM] =
+{
+    { "dbg_uart",   Sys_BootStepDbgUart,    SYS_BOOT_STAGE_DRIVER,  0,                      0 },
+    { "uart1",      Sys_BootStepUart1,      SYS_BOOT_STAGE_DRIVER,  SYS_BOOT_FLAG_M0,       0 },
+    { "misc_cfg",   Sys_BootStepMiscCfg,    SYS_BOOT_STAGE_DRIVER,  SYS_BOOT_FLAG_M0,       0 },
+    { "ps",         Sys_BootStepPs,         SYS_BOOT_STAGE_DRIVER,  SYS_BOOT_FLAG_M0,       SYS_BOOT_DEP(SYS_STEP_UART1) | SYS_BOOT_DEP(SYS_STEP_MISC_CFG) },
+    { "wdt",        Sys_BootStepWdt,        SYS_BOOT_STAGE_DRIVER,  0,                      0 },
+    { "version",    Sys_BootStepVersion,    SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "diag",       Sys_BootStepDiag,       SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "at",         Sys_BootStepAt,         SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "wifi_mac",   Sys_BootStepWifiMac,    SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "lwip",       Sys_BootStepLwip,       SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "scrt",       Sys_BootStepScrt,       SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "supplicant", Sys_BootStepSupplicant, SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_M0,       SYS_BOOT_DEP(SYS_STEP_WIFI_MAC) | SYS_BOOT_DEP(SYS_STEP_LWIP) },
+    { "controller", Sys_BootStepController, SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_M0,       SYS_BOOT_DEP(SYS_STEP_PS) },
+    { "ipc",        Sys_BootStepIpc,        SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_M0,       SYS_BOOT_DEP(SYS_STEP_PS) },
+    { "le",         Sys_BootStepLe,         SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_M0,       SYS_BOOT_DEP(SYS_STEP_UART1) | SYS_BOOT_DEP(SYS_STEP_IPC) },
+    { "auto_conn",  Sys_BootStepAutoConn,   SYS_BOOT_STAGE_SERVICE, 0,                      SYS_BOOT_DEP(SYS_STEP_SUPPLICANT) },
+    { "sta_info",   Sys_BootStepStaInfo,    SYS_BOOT_STAGE_SERVICE, 0,                      SYS_BOOT_DEP(SYS_STEP_SUPPLICANT) },
+    { "scan_cache", Sys_BootStepScanCache,  SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "agent",      Sys_BootStepAgent,      SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_M0,       SYS_BOOT_DEP(SYS_STEP_IPC) },
+    { "tracer",     Sys_BootStepTracer,     SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "ota",        Sys_BootStepOta,        SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "flash_svc",  Sys_BootStepFlashSvc,   SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_DEFER,    SYS_BOOT_DEP(SYS_STEP_OTA) },
+    { "stack",      Sys_BootStepStack,      SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_DEFER,    0 },
+    { "wdt_svc",    Sys_BootStepWdtSvc,     SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_DEFER,    SYS_BOOT_DEP(SYS_STEP_LWIP) | SYS_BOOT_DEP(SYS_STEP_SUPPLICANT) },
+    { "log_flash",  Sys_BootStepLogFlash,   SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_DEFER,    SYS_BOOT_DEP(SYS_STEP_FLASH_SVC) },
+    { "fs",         Sys_BootStepFs,         SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_DEFER,    SYS_BOOT_DEP(SYS_STEP_FLASH_SVC) },
+};
+
+/*************************************************************************
+* FUNCTION:
+*   Sys_DriverInit
+*
+* DESCRIPTION:
+*   the initial for driver
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+static void Sys_DriverInit_patch(void)
+{
+    uint8_t u8Cache;
+
+    // Set power
+    Sys_PowerSetup();
+
+    // Set system clock
+    Sys_ClockSetup();
+
+    // the DWT for the boot timeline, and the table of the steps
+    Sys_BootInit(g_taSysBootStep, SYS_STEP_NUM);
+    Sys_BootMark("clock");
+
+    // Set pin-mux
+    Hal_SysPinMuxAppInit();
+
+	  // Added for mapping IO8/9 to mini-USB UART 
+	  // Hal_SysPinMuxDownloadInit();
+	
+    // Init VIC
+    Hal_Vic_Init();
+    
+    // Init GPIO
+    Hal_Vic_GpioInit();
+
+	// Init IPC
+    Hal_Vic_IpcIntEn(IPC_IDX_0, 1);
+    Hal_Vic_IpcIntEn(IPC_IDX_1, 1);
+    Hal_Vic_IpcIntEn(IPC_IDX_2, 1);
+    Hal_Vic_IpcIntEn(IPC_IDX_3, 1);
+
+    // Init DBG_UART
+    Hal_DbgUart_Init(115200);
+    printf("\n");
+
+    // Init SPI 0/1/2
+    Hal_Spi_Init(SPI_IDX_0, SystemCoreClockGet()/2,
+        SPI_CLK_PLOAR_HIGH_ACT, SPI_CLK_PHASE_START, SPI_FMT_MOTOROLA, SPI_DFS_08_bit, 1);
+    Hal_Spi_Init(SPI_IDX_1, SystemCoreClockGet()/2,
+        SPI_CLK_PLOAR_HIGH_ACT, SPI_CLK_PHASE_START, SPI_FMT_MOTOROLA, SPI_DFS_08_bit, 1);
+    Hal_Spi_Init(SPI_IDX_2, SystemCoreClockGet()/2,
+        SPI_CLK_PLOAR_HIGH_ACT, SPI_CLK_PHASE_START, SPI_FMT_MOTOROLA, SPI_DFS_08_bit, 1);
+
+    // Init flash on SPI 0/1/2
+    Hal_Flash_Init(SPI_IDX_0);
+    Hal_Flash_Init(SPI_IDX_1);
+    Hal_Flash_Init(SPI_IDX_2);
+
+    // fault handlers, and the report of the last crash
+    Sys_FaultInit();
+
+    // FIM: its parse reads each block once in small steps, the line fills
+    // of the flash cache cost more than they save there
+    u8Cache = Hal_Flash_CacheIsEnabled();
+    Hal_Flash_CacheEnable(0);
+    MwFim_Init();
+    Hal_Flash_CacheEnable(u8Cache);
+    Sys_BootMark("fim");
+
+    // Init UART0 / UART1
+    Sys_UartInit();
+    
+    // Init PWM
+    Hal_Pwm_Init();
+    
+    // Init AUXADC
+    Hal_Aux_Init();
+
+    // Other modules' init
+    Sys_MiscModulesInit();
+    Sys_BootMark("driver");
+
+    //-------------------------------------------------------------------------------------
+    // Other driver config need by Task-level (sleep strategy)
+    // The M0 is polled between the steps. A cold boot may leave the steps
+    // of the M0 to Sys_ServiceInit, a warm boot does not get there.
+    Sys_BootRun(SYS_BOOT_STAGE_DRIVER, Boot_CheckWarmBoot() ? 1 : 0);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Sys_ServiceInit
+*
+* DESCRIPTION:
+*   the initial for service
+*
+* PARAMETERS
+*   none
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+static void Sys_ServiceInit_patch(void)
+{
+    Sys_BootMark("service");
+
+    // the steps of the driver stage left, then the services
+    Sys_BootRun(SYS_BOOT_STAGE_SERVICE, 1);
+
+    // time the application init, and start the deferred steps after it
+    Sys_BootAppHook();
+}
+
 void Sys_IdleHook_patch(void)
 {
     if (Hal_Sys_StrapModeRead() == BOOT_MODE_NORMAL)
     {
-        Hal_Wdt_Clear();
+        // fed only when the supervised tasks are alive
+        Sys_WdtFeed();
     }
 	ps_sleep();
 }
@@ -0,0 +1,738 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_stack.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This source file defines the stack high-water marks of the tasks, the
+*  worst cases in MW_FIM and the "stack" diag command.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "sys_common.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "mw_fim_default_group01_patch.h"
+#include "sys_stack.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SYS_STACK_PARAM_MAX         2
+
+#define SYS_STACK_CRIT_ENTER(x)     do { x = __get_PRIMASK(); __disable_irq(); } while(0)
+#define SYS_STACK_CRIT_EXIT(x)      __set_PRIMASK(x)
+
+#define SYS_STACK_LOG(...)          tracer_cli(LOG_HIGH_LEVEL, __VA_ARGS__)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+// the head of the task control block of the kernel in ROM (FreeRTOS V9.0.0,
+// no MPU, no list integrity bytes), the stack base is not exported
+typedef struct
+{
+    volatile StackType_t *pxTopOfStack;
+    ListItem_t xStateListItem;
+    ListItem_t xEventListItem;
+    UBaseType_t uxPriority;
+    StackType_t *pxStack;
+    char pcTaskName[configMAX_TASK_NAME_LEN];
+} S_SysStackTcb_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+// the functions under the wrappers
+RET_DATA T_osThreadCreateFp g_fpSysStackThreadCreate;
+RET_DATA T_osThreadTerminateFp g_fpSysStackThreadTerminate;
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+static S_SysStackTask_t g_taSysStackTask[SYS_STACK_TASK_NUM];
+static uint32_t g_u32SysStackTaskNum;
+
+static S_SysStackRecord_t g_taSysStackRecord[SYS_STACK_RECORD_NUM];
+static uint8_t g_u8SysStackRecordLoad;
+
+static osTimerId g_tSysStackTimer;
+static uint8_t g_u8SysStackTimerAdd;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static uint32_t *_Sys_StackBase(void *pHandle)
+{
+    S_SysStackTcb_t *ptTcb = (S_SysStackTcb_t *)pHandle;
+
+    // the name follows pxStack, a layout mismatch shows here
+    if (pcTaskGetName((TaskHandle_t)pHandle) != ptTcb->pcTaskName)
+        return NULL;
+
+    return (uint32_t *)ptTcb->pxStack;
+}
+
+// words from the bottom never written
+static uint32_t _Sys_StackUnused(const uint32_t *pu32Base, uint32_t u32Size)
+{
+    uint32_t i = 0;
+
+    while ((i < u32Size) && (pu32Base[i] == SYS_STACK_FILL))
+        i++;
+
+    return i;
+}
+
+static S_SysStackRecord_t *_Sys_StackRecordFind(const char *sName, uint8_t u8Create)
+{
+    uint32_t i = 0;
+    uint32_t u32Len = 0;
+
+    for (i = 0; i < SYS_STACK_RECORD_NUM; i++)
+    {
+        if (!strncmp(g_taSysStackRecord[i].baName, sName, SYS_STACK_NAME_LEN))
+            return &g_taSysStackRecord[i];
+    }
+
+    if (!u8Create)
+        return NULL;
+
+    for (i = 0; i < SYS_STACK_RECORD_NUM; i++)
+    {
+        if (g_taSysStackRecord[i].baName[0] == 0)
+        {
+            u32Len = strlen(sName);
+            if (u32Len > SYS_STACK_NAME_LEN - 1)
+                u32Len = SYS_STACK_NAME_LEN - 1;
+
+            memset(&g_taSysStackRecord[i], 0, sizeof(S_SysStackRecord_t));
+            memcpy(g_taSysStackRecord[i].baName, sName, u32Len);
+            g_taSysStackRecord[i].baName[u32Len] = 0;
+            return &g_taSysStackRecord[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_StackTaskAdd
+*
+* DESCRIPTION:
+*   1. Add a task to the check, or update its size. osThreadCreate adds
+*      its tasks already.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. pHandle : [In] TaskHandle_t, NULL: the calling task
+*   2. u32Size : [In] stack depth in words (xTaskCreate usStackDepth),
+*                     0 if unknown
+*
+* RETURNS
+*   0  : success
+*   -1 : the table is full or the stack base is not found
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+int Sys_StackTaskAdd(void *pHandle, uint32_t u32Size)
+{
+    S_SysStackTask_t *ptTask = NULL;
+    uint32_t *pu32Base = NULL;
+    uint32_t u32Primask = 0;
+    uint32_t i = 0;
+    int iRet = -1;
+
+    if (pHandle == NULL)
+        pHandle = (void *)xTaskGetCurrentTaskHandle();
+
+    pu32Base = _Sys_StackBase(pHandle);
+    if (pu32Base == NULL)
+        return -1;
+
+    SYS_STACK_CRIT_ENTER(u32Primask);
+
+    // the same handle: a size update, or the TCB of a deleted task reused
+    for (i = 0; i < g_u32SysStackTaskNum; i++)
+    {
+        if (g_taSysStackTask[i].pHandle == pHandle)
+            break;
+    }
+
+    if (i >= SYS_STACK_TASK_NUM)
+        goto done;
+
+    if (i == g_u32SysStackTaskNum)
+        g_u32SysStackTaskNum++;
+
+    ptTask = &g_taSysStackTask[i];
+    memset(ptTask, 0, sizeof(S_SysStackTask_t));
+    ptTask->pHandle = pHandle;
+    ptTask->pu32Base = pu32Base;
+    ptTask->u32Size = u32Size;
+    strncpy(ptTask->baName, pcTaskGetName((TaskHandle_t)pHandle), SYS_STACK_NAME_LEN - 1);
+
+    iRet = 0;
+
+done:
+    SYS_STACK_CRIT_EXIT(u32Primask);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_StackTaskDel
+*
+* DESCRIPTION:
+*   1. Remove a task before it is deleted, osThreadTerminate does it
+*
+* CALLS
+*
+* PARAMETERS
+*   1. pHandle : [In] TaskHandle_t, NULL: the calling task
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_StackTaskDel(void *pHandle)
+{
+    uint32_t u32Primask = 0;
+    uint32_t i = 0;
+
+    if (pHandle == NULL)
+        pHandle = (void *)xTaskGetCurrentTaskHandle();
+
+    SYS_STACK_CRIT_ENTER(u32Primask);
+
+    for (i = 0; i < g_u32SysStackTaskNum; i++)
+    {
+        if (g_taSysStackTask[i].pHandle == pHandle)
+        {
+            g_taSysStackTask[i] = g_taSysStackTask[--g_u32SysStackTaskNum];
+            break;
+        }
+    }
+
+    SYS_STACK_CRIT_EXIT(u32Primask);
+}
+
+static osThreadId _Sys_StackThreadCreate(const osThreadDef_t *thread_def, void *argument)
+{
+    osThreadId tId = NULL;
+
+    tId = g_fpSysStackThreadCreate(thread_def, argument);
+
+    if (tId)
+        Sys_StackTaskAdd((void *)tId, thread_def->stacksize);
+
+    return tId;
+}
+
+static osStatus _Sys_StackThreadTerminate(osThreadId thread_id)
+{
+    Sys_StackTaskDel((void *)thread_id);
+
+    return g_fpSysStackThreadTerminate(thread_id);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_StackInit
+*
+* DESCRIPTION:
+*   1. Put the wrappers over osThreadCreate/osThreadTerminate, cold boot
+*      only, before the first task
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_StackInit(void)
+{
+    if (osThreadCreate == _Sys_StackThreadCreate)
+        return;
+
+    g_fpSysStackThreadCreate = osThreadCreate;
+    g_fpSysStackThreadTerminate = osThreadTerminate;
+
+    osThreadCreate = _Sys_StackThreadCreate;
+    osThreadTerminate = _Sys_StackThreadTerminate;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_StackCheck
+*
+* DESCRIPTION:
+*   1. Update the high-water mark of every task, report a task over
+*      SYS_STACK_WARN_PERCENT of its size once
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   the tasks over SYS_STACK_WARN_PERCENT
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Sys_StackCheck(void)
+{
+    S_SysStackTask_t tTask;
+    uint32_t u32Primask = 0;
+    uint32_t u32Peak = 0;
+    uint32_t u32Warn = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < SYS_STACK_TASK_NUM; i++)
+    {
+        SYS_STACK_CRIT_ENTER(u32Primask);
+
+        if (i >= g_u32SysStackTaskNum)
+        {
+            SYS_STACK_CRIT_EXIT(u32Primask);
+            break;
+        }
+
+        tTask = g_taSysStackTask[i];
+        SYS_STACK_CRIT_EXIT(u32Primask);
+
+        if (tTask.u32Size == 0)
+            continue;
+
+        u32Peak = tTask.u32Size - _Sys_StackUnused(tTask.pu32Base, tTask.u32Size);
+
+        if ((u32Peak * 100) >= (tTask.u32Size * SYS_STACK_WARN_PERCENT))
+        {
+            u32Warn++;
+
+            if (!tTask.u8Warn)
+            {
+                printf("stack: %s uses %u of %u words\r\n", tTask.baName, u32Peak, tTask.u32Size);
+                tTask.u8Warn = 1;
+            }
+        }
+
+        SYS_STACK_CRIT_ENTER(u32Primask);
+
+        // the entry may have moved or gone meanwhile
+        if ((i < g_u32SysStackTaskNum) && (g_taSysStackTask[i].pHandle == tTask.pHandle))
+        {
+            if (u32Peak > g_taSysStackTask[i].u32Peak)
+                g_taSysStackTask[i].u32Peak = u32Peak;
+
+            g_taSysStackTask[i].u8Warn = tTask.u8Warn;
+        }
+
+        SYS_STACK_CRIT_EXIT(u32Primask);
+    }
+
+    return u32Warn;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_StackSave
+*
+* DESCRIPTION:
+*   1. Write the worst case of the tasks to MW_FIM, a record only when its
+*      peak grows by SYS_STACK_SAVE_STEP words or the size changes. Task
+*      context only, the periodic check runs it in the timer task (whose
+*      stack is in the list too).
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   the records written, -1 if a write fails
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+int Sys_StackSave(void)
+{
+    S_SysStackTask_t tTask;
+    S_SysStackRecord_t *ptRecord = NULL;
+    S_SysStackRecord_t tNew;
+    uint32_t u32Primask = 0;
+    uint32_t i = 0;
+    int iNum = 0;
+
+    if (!g_u8SysStackRecordLoad)
+        return 0;
+
+    for (i = 0; i < SYS_STACK_TASK_NUM; i++)
+    {
+        SYS_STACK_CRIT_ENTER(u32Primask);
+
+        if (i >= g_u32SysStackTaskNum)
+        {
+            SYS_STACK_CRIT_EXIT(u32Primask);
+            break;
+        }
+
+        tTask = g_taSysStackTask[i];
+        SYS_STACK_CRIT_EXIT(u32Primask);
+
+        if ((tTask.u32Size == 0) || (tTask.u32Peak == 0))
+            continue;
+
+        ptRecord = _Sys_StackRecordFind(tTask.baName, 1);
+        if (ptRecord == NULL)
+            continue;
+
+        if ((ptRecord->u16Size == tTask.u32Size) && (tTask.u32Peak < ptRecord->u16Peak + SYS_STACK_SAVE_STEP))
+            continue;
+
+        // the record changes when it is written, so a failed write is tried again
+        tNew = *ptRecord;
+
+        if (tNew.u16Size != tTask.u32Size)
+            tNew.u16Peak = 0;
+
+        tNew.u16Size = tTask.u32Size;
+
+        if (tTask.u32Peak > tNew.u16Peak)
+            tNew.u16Peak = tTask.u32Peak;
+
+        if (MwFim_FileWrite(MW_FIM_IDX_GP01_STACK_PEAK, (uint16_t)(ptRecord - g_taSysStackRecord),
+                            MW_FIM_STACK_PEAK_SIZE, (uint8_t *)&tNew) != MW_FIM_OK)
+            return -1;
+
+        *ptRecord = tNew;
+        iNum++;
+    }
+
+    return iNum;
+}
+
+static void _Sys_StackTimer(void const *argu)
+{
+    // the timer task is created by the kernel, add it at the first run
+    if (!g_u8SysStackTimerAdd)
+    {
+        Sys_StackTaskAdd(NULL, configTIMER_TASK_STACK_DEPTH);
+        g_u8SysStackTimerAdd = 1;
+    }
+
+    Sys_StackCheck();
+    Sys_StackSave();
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_StackStart
+*
+* DESCRIPTION:
+*   1. Load the worst cases from MW_FIM and start the periodic check
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_StackStart(void)
+{
+    osTimerDef_t tTimerDef;
+    uint32_t i = 0;
+
+    for (i = 0; i < SYS_STACK_RECORD_NUM; i++)
+    {
+        if (MwFim_FileRead(MW_FIM_IDX_GP01_STACK_PEAK, i, MW_FIM_STACK_PEAK_SIZE, (uint8_t *)&g_taSysStackRecord[i]) != MW_FIM_OK)
+            memset(&g_taSysStackRecord[i], 0, sizeof(S_SysStackRecord_t));
+
+        // never written
+        if ((uint8_t)g_taSysStackRecord[i].baName[0] == 0xFF)
+            memset(&g_taSysStackRecord[i], 0, sizeof(S_SysStackRecord_t));
+
+        g_taSysStackRecord[i].baName[SYS_STACK_NAME_LEN - 1] = 0;
+    }
+
+    g_u8SysStackRecordLoad = 1;
+
+    if (g_tSysStackTimer == NULL)
+    {
+        tTimerDef.ptimer = _Sys_StackTimer;
+        g_tSysStackTimer = osTimerCreate(&tTimerDef, osTimerPeriodic, NULL);
+        if (g_tSysStackTimer == NULL)
+            return;
+    }
+
+    osTimerStart(g_tSysStackTimer, SYS_STACK_CHECK_MS);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_StackTaskGet
+*
+* DESCRIPTION:
+*   1. Copy the tasks
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptTask : [Out] the tasks, NULL to get the number only
+*   2. u32Max : [In] entries of ptTask
+*
+* RETURNS
+*   entries copied, or the tasks if ptTask is NULL
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Sys_StackTaskGet(S_SysStackTask_t *ptTask, uint32_t u32Max)
+{
+    uint32_t u32Primask = 0;
+    uint32_t u32Num = 0;
+
+    SYS_STACK_CRIT_ENTER(u32Primask);
+
+    if (ptTask == NULL)
+    {
+        u32Num = g_u32SysStackTaskNum;
+        goto done;
+    }
+
+    u32Num = (g_u32SysStackTaskNum < u32Max) ? g_u32SysStackTaskNum : u32Max;
+    memcpy(ptTask, g_taSysStackTask, u32Num * sizeof(S_SysStackTask_t));
+
+done:
+    SYS_STACK_CRIT_EXIT(u32Primask);
+    return u32Num;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_StackRecordGet
+*
+* DESCRIPTION:
+*   1. Copy the worst cases of the earlier boots and this one (as saved)
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptRecord : [Out] the records
+*   2. u32Max   : [In] entries of ptRecord
+*
+* RETURNS
+*   entries copied
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Sys_StackRecordGet(S_SysStackRecord_t *ptRecord, uint32_t u32Max)
+{
+    uint32_t u32Num = 0;
+    uint32_t i = 0;
+
+    for (i = 0; (i < SYS_STACK_RECORD_NUM) && (u32Num < u32Max); i++)
+    {
+        if (g_taSysStackRecord[i].baName[0])
+            ptRecord[u32Num++] = g_taSysStackRecord[i];
+    }
+
+    return u32Num;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_StackRecordClear
+*
+* DESCRIPTION:
+*   1. Clear the worst cases in MW_FIM, they are saved again from the
+*      current peaks at the next check
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   0  : success
+*   -1 : fail
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+int Sys_StackRecordClear(void)
+{
+    uint32_t i = 0;
+
+    memset(g_taSysStackRecord, 0, sizeof(g_taSysStackRecord));
+
+    for (i = 0; i < SYS_STACK_RECORD_NUM; i++)
+    {
+        if (MwFim_FileWrite(MW_FIM_IDX_GP01_STACK_PEAK, i, MW_FIM_STACK_PEAK_SIZE, (uint8_t *)&g_taSysStackRecord[i]) != MW_FIM_OK)
+            return -1;
+    }
+
+    return 0;
+}
+
+static void _Sys_StackDump(void)
+{
+    S_SysStackTask_t *ptTask = NULL;
+    S_SysStackRecord_t *ptRecord = NULL;
+    uint32_t u32Num = 0;
+    uint32_t i = 0;
+
+    ptTask = (S_SysStackTask_t *)malloc(SYS_STACK_TASK_NUM * sizeof(S_SysStackTask_t));
+    if (!ptTask)
+    {
+        SYS_STACK_LOG("stack: malloc fail\n");
+        return;
+    }
+
+    Sys_StackCheck();
+    u32Num = Sys_StackTaskGet(ptTask, SYS_STACK_TASK_NUM);
+
+    SYS_STACK_LOG("  %-16s %6s %6s %5s %6s\n", "task", "size", "peak", "use", "worst");
+
+    for (i = 0; i < u32Num; i++)
+    {
+        ptRecord = _Sys_StackRecordFind(ptTask[i].baName, 0);
+
+        if (ptTask[i].u32Size == 0)
+        {
+            SYS_STACK_LOG("  %-16s %6s %6s %5s %6s\n", ptTask[i].baName, "?", "?", "", "");
+            continue;
+        }
+
+        SYS_STACK_LOG("  %-16s %6u %6u %4u%% %6u%s\n", ptTask[i].baName, ptTask[i].u32Size, ptTask[i].u32Peak,
+                      (ptTask[i].u32Peak * 100) / ptTask[i].u32Size,
+                      (ptRecord && (ptRecord->u16Peak > ptTask[i].u32Peak)) ? ptRecord->u16Peak : ptTask[i].u32Peak,
+                      ptTask[i].u8Warn ? " !" : "");
+    }
+
+    SYS_STACK_LOG("stack: words, worst of all boots, ! over %u%%\n", SYS_STACK_WARN_PERCENT);
+
+    free(ptTask);
+}
+
+static void _Sys_StackHistory(void)
+{
+    S_SysStackRecord_t *ptRecord = NULL;
+    uint32_t i = 0;
+
+    SYS_STACK_LOG("  %-16s %6s %6s\n", "task", "size", "worst");
+
+    for (i = 0; i < SYS_STACK_RECORD_NUM; i++)
+    {
+        ptRecord = &g_taSysStackRecord[i];
+
+        if (ptRecord->baName[0])
+            SYS_STACK_LOG("  %-16s %6u %6u\n", ptRecord->baName, ptRecord->u16Size, ptRecord->u16Peak);
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Sys_StackCmd
+*
+* DESCRIPTION:
+*   diag command: stack [save|history|clear]
+*     no argument: the high-water marks of the tasks
+*     save: write the grown worst cases to MW_FIM now
+*     history: the worst cases in MW_FIM
+*     clear: clear them
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void Sys_StackCmd(char *sCmd)
+{
+    char *baParam[SYS_STACK_PARAM_MAX + 1] = {0};
+    uint32_t u32Num = 0;
+
+    u32Num = ParseParam(sCmd, baParam, SYS_STACK_PARAM_MAX + 1);
+
+    if (u32Num < 2)
+    {
+        _Sys_StackDump();
+        goto done;
+    }
+
+    if (!strcmp(baParam[1], "save"))
+    {
+        Sys_StackCheck();
+        SYS_STACK_LOG("stack: %d saved\n", Sys_StackSave());
+        goto done;
+    }
+
+    if (!strcmp(baParam[1], "history"))
+    {
+        _Sys_StackHistory();
+        goto done;
+    }
+
+    if (!strcmp(baParam[1], "clear"))
+    {
+        SYS_STACK_LOG("stack: clear %s\n", Sys_StackRecordClear() ? "fail" : "ok");
+        goto done;
+    }
+
+    SYS_STACK_LOG("usage: stack [save|history|clear]\n");
+
+done:
+    return;
+}
@@ -0,0 +1,111 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_stack.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This include file defines the stack high-water marks of the tasks.
+*
+*  The kernel fills every new stack with 0xA5 (configCHECK_FOR_STACK_OVERFLOW
+*  is 2), the words still 0xA5 from the bottom were never used. The tasks
+*  are known from osThreadCreate, the ones created by xTaskCreate directly
+*  can be added by Sys_StackTaskAdd.
+*
+*  A timer checks all tasks every SYS_STACK_CHECK_MS. The worst case of each
+*  task (by name) is kept in MW_FIM, updated when it grows by
+*  SYS_STACK_SAVE_STEP words, and reported by the "stack" diag command with
+*  the current boot.
+*
+*  The static side is the linker: --callgraph --info=stack give the maximum
+*  stack depth of every function in the .htm next to the .axf. Compare the
+*  entry function of a task with its stacksize, calls through function
+*  pointers (the ROM tables) are not counted there.
+*
+******************************************************************************/
+#ifndef __SYS_STACK_H__
+#define __SYS_STACK_H__
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdint.h>
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SYS_STACK_TASK_NUM          24
+#define SYS_STACK_RECORD_NUM        16      // worst cases kept in MW_FIM
+#define SYS_STACK_NAME_LEN          16      // include '\0', configMAX_TASK_NAME_LEN
+
+#define SYS_STACK_FILL              0xA5A5A5A5
+#define SYS_STACK_CHECK_MS          10000
+#define SYS_STACK_SAVE_STEP         16      // words
+#define SYS_STACK_WARN_PERCENT      90      // used / size
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    void *pHandle;                  // TaskHandle_t
+    uint32_t *pu32Base;             // pxStack, the lowest word
+    uint32_t u32Size;               // words, 0: unknown
+    uint32_t u32Peak;               // words used, this boot
+    uint8_t u8Warn;                 // reported over SYS_STACK_WARN_PERCENT
+    char baName[SYS_STACK_NAME_LEN];
+} S_SysStackTask_t;
+
+// MW_FIM_IDX_GP01_STACK_PEAK
+typedef struct
+{
+    char baName[SYS_STACK_NAME_LEN];    // "": empty
+    uint16_t u16Size;                   // words
+    uint16_t u16Peak;                   // words used, all boots
+} S_SysStackRecord_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+void Sys_StackInit(void);
+void Sys_StackStart(void);
+
+int Sys_StackTaskAdd(void *pHandle, uint32_t u32Size);
+void Sys_StackTaskDel(void *pHandle);
+
+uint32_t Sys_StackCheck(void);
+int Sys_StackSave(void);
+
+uint32_t Sys_StackTaskGet(S_SysStackTask_t *ptTask, uint32_t u32Max);
+uint32_t Sys_StackRecordGet(S_SysStackRecord_t *ptRecord, uint32_t u32Max);
+int Sys_StackRecordClear(void);
+
+void Sys_StackCmd(char *sCmd);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+
+// Sec 7: declaration of static function prototype
+
+#endif // __SYS_STACK_H__
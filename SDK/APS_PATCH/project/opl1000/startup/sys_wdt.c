@@ -0,0 +1,616 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_wdt.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This source file defines the watchdog supervisor of the M3: the liveness
+*  of the registered tasks decides if the idle hook feeds the watchdog.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "sys_common.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "hal_wdt.h"
+#if defined(__LWIP_TASK__)
+#include "lwip/tcpip.h"
+#endif
+#if defined(__WPA_SUPPLICANT__)
+#include "supplicant_task_patch.h"
+#endif
+#include "sys_fault.h"
+#include "sys_wdt.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SYS_WDT_PARAM_MAX           2
+#define SYS_WDT_LINE_SIZE           64      // SYS_FAULT_TRACE_LEN
+
+#define SYS_WDT_CRIT_ENTER(x)       do { x = __get_PRIMASK(); __disable_irq(); } while(0)
+#define SYS_WDT_CRIT_EXIT(x)        __set_PRIMASK(x)
+
+#define SYS_WDT_LOG(...)            tracer_cli(LOG_HIGH_LEVEL, __VA_ARGS__)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+// the head of the task control block of the kernel in ROM, as sys_stack.c
+typedef struct
+{
+    volatile StackType_t *pxTopOfStack;
+    ListItem_t xStateListItem;
+    ListItem_t xEventListItem;
+    UBaseType_t uxPriority;
+} S_SysWdtTcb_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+static S_SysWdtClient_t g_taSysWdtClient[SYS_WDT_CLIENT_NUM];
+static uint8_t g_u8SysWdtAction = SYS_WDT_ACTION_RESET;
+static uint32_t g_u32SysWdtProbeTick;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static S_SysWdtClient_t *_Sys_WdtClient(int iId)
+{
+    if ((iId < 0) || (iId >= SYS_WDT_CLIENT_NUM) || (g_taSysWdtClient[iId].sName == NULL))
+        return NULL;
+
+    return &g_taSysWdtClient[iId];
+}
+
+// the check-in of an armed client
+static void _Sys_WdtCheckIn(S_SysWdtClient_t *ptClient, uint32_t u32Now)
+{
+    uint32_t u32Age = u32Now - ptClient->u32Last;
+
+    if ((ptClient->u8Armed) && (u32Age > ptClient->u32Max))
+        ptClient->u32Max = u32Age;
+
+    ptClient->pHandle = (void *)xTaskGetCurrentTaskHandle();
+}
+
+#if defined(__LWIP_TASK__)
+static void _Sys_WdtTcpipAck(void *ctx)
+{
+    Sys_WdtKick((int)ctx);
+}
+
+static int _Sys_WdtTcpipProbe(int iId)
+{
+    // no block: a full mailbox is retried, and times out if it stays full
+    if (tcpip_callback_with_block(_Sys_WdtTcpipAck, (void *)iId, 0) != ERR_OK)
+        return -1;
+
+    return 0;
+}
+#endif
+
+static void _Sys_WdtProbe(uint32_t u32Now)
+{
+    S_SysWdtClient_t *ptClient = NULL;
+    uint32_t i = 0;
+
+    for (i = 0; i < SYS_WDT_CLIENT_NUM; i++)
+    {
+        ptClient = &g_taSysWdtClient[i];
+
+        if ((ptClient->sName == NULL) || (ptClient->fpProbe == NULL))
+            continue;
+
+        // the deadline counts from the first try
+        if (!ptClient->u8Armed)
+        {
+            ptClient->u32Last = u32Now;
+            ptClient->u8Armed = 1;
+        }
+
+        ptClient->fpProbe((int)i);
+    }
+}
+
+// the stall line for the crash record: name, time armed and the task state
+static void _Sys_WdtStallLine(const S_SysWdtClient_t *ptClient, uint32_t u32Age, char *sLine)
+{
+    const S_SysWdtTcb_t *ptTcb = (const S_SysWdtTcb_t *)ptClient->pHandle;
+
+    if (ptTcb == NULL)
+    {
+        snprintf(sLine, SYS_WDT_LINE_SIZE, "wdt: %s stalled %ums, no check-in", ptClient->sName, u32Age);
+        return;
+    }
+
+    // a task waiting for a queue, semaphore or mutex is on its event list
+    snprintf(sLine, SYS_WDT_LINE_SIZE, "wdt: %s stalled %ums %s prio=%u wait=%08X",
+             ptClient->sName, u32Age, pcTaskGetName((TaskHandle_t)ptTcb), (unsigned int)ptTcb->uxPriority,
+             (unsigned int)ptTcb->xEventListItem.pvContainer);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_WdtStart
+*
+* DESCRIPTION:
+*   1. Register the probes of the system tasks with a loop in ROM: the
+*      tcpip thread and the supplicant. The AT task registers itself.
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_WdtStart(void)
+{
+#if defined(__LWIP_TASK__)
+    Sys_WdtRegister("tcpip", SYS_WDT_DEADLINE_TCPIP_MS, _Sys_WdtTcpipProbe);
+#endif
+
+#if defined(__WPA_SUPPLICANT__)
+    Sys_WdtRegister("supplicant", SYS_WDT_DEADLINE_SUPP_MS, supplicant_task_wdt_probe);
+#endif
+
+    g_u32SysWdtProbeTick = osKernelSysTick();
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_WdtFeed
+*
+* DESCRIPTION:
+*   1. Called by the idle hook instead of Hal_Wdt_Clear: send the probes,
+*      check the deadlines, and feed the watchdog if no client missed its
+*      deadline. A miss records the stalled task and resets the system,
+*      in the log mode it is printed and the client is disarmed.
+*
+* CALLS
+*
+* PARAMETERS
+*   None
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_WdtFeed(void)
+{
+    S_SysWdtClient_t *ptClient = NULL;
+    char sLine[SYS_WDT_LINE_SIZE];
+    uint32_t u32Now = osKernelSysTick();
+    uint32_t u32Age = 0;
+    uint32_t i = 0;
+
+    if ((u32Now - g_u32SysWdtProbeTick) >= SYS_WDT_PROBE_MS)
+    {
+        g_u32SysWdtProbeTick = u32Now;
+        _Sys_WdtProbe(u32Now);
+    }
+
+    for (i = 0; i < SYS_WDT_CLIENT_NUM; i++)
+    {
+        ptClient = &g_taSysWdtClient[i];
+
+        if ((ptClient->sName == NULL) || (!ptClient->u8Armed))
+            continue;
+
+        u32Age = u32Now - ptClient->u32Last;
+        if (u32Age <= ptClient->u32Deadline)
+            continue;
+
+        ptClient->u32Miss++;
+
+        _Sys_WdtStallLine(ptClient, u32Age, sLine);
+        Sys_FaultTraceAdd(sLine);
+        printf("\r\n%s\r\n", sLine);
+
+        if (g_u8SysWdtAction == SYS_WDT_ACTION_RESET)
+            Sys_FaultStallCapture(ptClient->pHandle);
+
+        ptClient->u8Armed = 0;
+    }
+
+    Hal_Wdt_Clear();
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_WdtRegister
+*
+* DESCRIPTION:
+*   1. Add a client. Without fpProbe it is armed at once, for the calling
+*      task: a periodic client, or a busy/idle one that calls Sys_WdtIdle
+*      before its first wait.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. sName         : [In] a constant string, shown in the record
+*   2. u32DeadlineMs : [In] the longest time armed without a check-in
+*   3. fpProbe       : [In] the message to the task, NULL: none
+*
+* RETURNS
+*   the id of the client
+*   -1 : the table is full
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+int Sys_WdtRegister(const char *sName, uint32_t u32DeadlineMs, T_SysWdtProbe fpProbe)
+{
+    S_SysWdtClient_t *ptClient = NULL;
+    uint32_t u32Primask = 0;
+    int iRet = -1;
+    int i = 0;
+
+    SYS_WDT_CRIT_ENTER(u32Primask);
+
+    for (i = 0; i < SYS_WDT_CLIENT_NUM; i++)
+    {
+        if (g_taSysWdtClient[i].sName == NULL)
+            break;
+    }
+
+    if (i >= SYS_WDT_CLIENT_NUM)
+        goto done;
+
+    ptClient = &g_taSysWdtClient[i];
+    memset(ptClient, 0, sizeof(S_SysWdtClient_t));
+    ptClient->fpProbe = fpProbe;
+    ptClient->u32Deadline = u32DeadlineMs;
+
+    if (fpProbe == NULL)
+    {
+        ptClient->pHandle = (void *)xTaskGetCurrentTaskHandle();
+        ptClient->u32Last = osKernelSysTick();
+        ptClient->u8Armed = 1;
+    }
+
+    // the entry is used from here
+    ptClient->sName = sName;
+
+    iRet = i;
+
+done:
+    SYS_WDT_CRIT_EXIT(u32Primask);
+    return iRet;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_WdtUnregister
+*
+* DESCRIPTION:
+*   1. Remove a client, before its task is deleted
+*
+* CALLS
+*
+* PARAMETERS
+*   1. iId : [In] the id of Sys_WdtRegister
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_WdtUnregister(int iId)
+{
+    S_SysWdtClient_t *ptClient = _Sys_WdtClient(iId);
+    uint32_t u32Primask = 0;
+
+    if (ptClient == NULL)
+        return;
+
+    SYS_WDT_CRIT_ENTER(u32Primask);
+    ptClient->u8Armed = 0;
+    ptClient->sName = NULL;
+    SYS_WDT_CRIT_EXIT(u32Primask);
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_WdtKick
+*
+* DESCRIPTION:
+*   1. The check-in of the client. A periodic client is armed again, a
+*      probe client is disarmed until the next probe.
+*
+* CALLS
+*
+* PARAMETERS
+*   1. iId : [In] the id of Sys_WdtRegister
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_WdtKick(int iId)
+{
+    S_SysWdtClient_t *ptClient = _Sys_WdtClient(iId);
+    uint32_t u32Now = osKernelSysTick();
+
+    if (ptClient == NULL)
+        return;
+
+    _Sys_WdtCheckIn(ptClient, u32Now);
+
+    if (ptClient->fpProbe)
+    {
+        ptClient->u8Armed = 0;
+    }
+    else
+    {
+        // the tick first, the idle hook may read both in between
+        ptClient->u32Last = u32Now;
+        ptClient->u8Armed = 1;
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_WdtBusy
+*
+* DESCRIPTION:
+*   1. Arm the client: the task got a message, the handling is timed
+*
+* CALLS
+*
+* PARAMETERS
+*   1. iId : [In] the id of Sys_WdtRegister
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_WdtBusy(int iId)
+{
+    S_SysWdtClient_t *ptClient = _Sys_WdtClient(iId);
+
+    if (ptClient == NULL)
+        return;
+
+    ptClient->pHandle = (void *)xTaskGetCurrentTaskHandle();
+    ptClient->u32Last = osKernelSysTick();
+    ptClient->u8Armed = 1;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_WdtIdle
+*
+* DESCRIPTION:
+*   1. Disarm the client: the task waits for messages with no deadline
+*
+* CALLS
+*
+* PARAMETERS
+*   1. iId : [In] the id of Sys_WdtRegister
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_WdtIdle(int iId)
+{
+    S_SysWdtClient_t *ptClient = _Sys_WdtClient(iId);
+
+    if (ptClient == NULL)
+        return;
+
+    _Sys_WdtCheckIn(ptClient, osKernelSysTick());
+    ptClient->u8Armed = 0;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_WdtActionSet
+*
+* DESCRIPTION:
+*   1. Set what a missed deadline does
+*
+* CALLS
+*
+* PARAMETERS
+*   1. u8Action : [In] E_SysWdtAction_t
+*
+* RETURNS
+*   None
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+void Sys_WdtActionSet(uint8_t u8Action)
+{
+    g_u8SysWdtAction = u8Action;
+}
+
+/*************************************************************************
+* FUNCTION:
+*  Sys_WdtClientGet
+*
+* DESCRIPTION:
+*   1. Copy the used entries of the client table
+*
+* CALLS
+*
+* PARAMETERS
+*   1. ptClient : [Out] the clients
+*   2. u32Max   : [In] the size of ptClient
+*
+* RETURNS
+*   the number of the clients copied
+*
+* GLOBALS AFFECTED
+*
+*************************************************************************/
+uint32_t Sys_WdtClientGet(S_SysWdtClient_t *ptClient, uint32_t u32Max)
+{
+    uint32_t u32Primask = 0;
+    uint32_t u32Num = 0;
+    uint32_t i = 0;
+
+    SYS_WDT_CRIT_ENTER(u32Primask);
+
+    for (i = 0; (i < SYS_WDT_CLIENT_NUM) && (u32Num < u32Max); i++)
+    {
+        if (g_taSysWdtClient[i].sName)
+            ptClient[u32Num++] = g_taSysWdtClient[i];
+    }
+
+    SYS_WDT_CRIT_EXIT(u32Primask);
+    return u32Num;
+}
+
+static void _Sys_WdtDump(void)
+{
+    S_SysWdtClient_t taClient[SYS_WDT_CLIENT_NUM];
+    uint32_t u32Now = osKernelSysTick();
+    uint32_t u32Num = 0;
+    uint32_t i = 0;
+
+    u32Num = Sys_WdtClientGet(taClient, SYS_WDT_CLIENT_NUM);
+
+    SYS_WDT_LOG("  %-12s %-8s %8s %8s %8s %5s\n", "client", "type", "deadline", "armed", "max", "miss");
+
+    for (i = 0; i < u32Num; i++)
+    {
+        SYS_WDT_LOG("  %-12s %-8s %8u %8u %8u %5u\n", taClient[i].sName,
+                    taClient[i].fpProbe ? "probe" : "task", taClient[i].u32Deadline,
+                    taClient[i].u8Armed ? (u32Now - taClient[i].u32Last) : 0,
+                    taClient[i].u32Max, taClient[i].u32Miss);
+    }
+
+    SYS_WDT_LOG("wdt: ms, a miss does %s\n", (g_u8SysWdtAction == SYS_WDT_ACTION_RESET) ? "record and reset" : "log");
+}
+
+// a client of the diag task that never checks in
+static void _Sys_WdtTest(uint32_t u32Ms)
+{
+    static int iTest = -1;
+
+    if (_Sys_WdtClient(iTest) == NULL)
+    {
+        iTest = Sys_WdtRegister("test", u32Ms, NULL);
+        if (iTest < 0)
+        {
+            SYS_WDT_LOG("wdt: table full\n");
+            return;
+        }
+    }
+    else
+    {
+        g_taSysWdtClient[iTest].u32Deadline = u32Ms;
+        Sys_WdtBusy(iTest);
+    }
+
+    SYS_WDT_LOG("wdt: test armed, %ums\n", u32Ms);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   Sys_WdtCmd
+*
+* DESCRIPTION:
+*   diag command: wdt [reset|log|test <ms>]
+*     no argument: the clients, their deadlines and the longest time armed
+*     reset: a missed deadline records the task and resets (default)
+*     log: a missed deadline is printed only
+*     test: a client of the diag task that misses after <ms>
+*
+* PARAMETERS
+*   sCmd :      [IN] command line
+*
+* RETURNS
+*   none
+*
+*************************************************************************/
+void Sys_WdtCmd(char *sCmd)
+{
+    char *baParam[SYS_WDT_PARAM_MAX + 1] = {0};
+    uint32_t u32Num = 0;
+
+    u32Num = ParseParam(sCmd, baParam, SYS_WDT_PARAM_MAX + 1);
+
+    if (u32Num < 2)
+    {
+        _Sys_WdtDump();
+        goto done;
+    }
+
+    if (!strcmp(baParam[1], "reset"))
+    {
+        Sys_WdtActionSet(SYS_WDT_ACTION_RESET);
+        goto done;
+    }
+
+    if (!strcmp(baParam[1], "log"))
+    {
+        Sys_WdtActionSet(SYS_WDT_ACTION_LOG);
+        goto done;
+    }
+
+    if ((!strcmp(baParam[1], "test")) && (u32Num > 2))
+    {
+        _Sys_WdtTest(strtoul(baParam[2], NULL, 0));
+        goto done;
+    }
+
+    SYS_WDT_LOG("usage: wdt [reset|log|test <ms>]\n");
+
+done:
+    return;
+}
@@ -0,0 +1,114 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_wdt.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  This include file defines the watchdog supervisor of the M3.
+*
+*  The idle hook feeds the hardware watchdog only when every registered task
+*  is alive. A client is armed with a deadline in ms:
+*    - periodic: armed from the registration, every Sys_WdtKick re-arms it.
+*    - busy/idle: a task waiting for messages forever calls Sys_WdtIdle
+*      before the wait and Sys_WdtBusy after it, only the handling is timed.
+*    - probe: for the task loops in ROM, the idle hook sends a message with
+*      fpProbe every SYS_WDT_PROBE_MS, the handler in the task calls
+*      Sys_WdtKick and disarms it.
+*
+*  A client armed longer than its deadline is a stall: the name, the state
+*  of its task and the time are added to the tracer lines of the crash
+*  record, then the context saved in that task is recorded and the system
+*  is reset (see sys_fault.h). In the log mode the miss is printed and
+*  counted only, for the tuning of the deadlines.
+*
+******************************************************************************/
+#ifndef __SYS_WDT_H__
+#define __SYS_WDT_H__
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdint.h>
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SYS_WDT_CLIENT_NUM          8
+#define SYS_WDT_PROBE_MS            5000    // sent from the idle hook, no wakeup of its own
+
+// the deadlines of the system tasks
+#define SYS_WDT_DEADLINE_AT_MS      30000   // one AT command
+#define SYS_WDT_DEADLINE_TCPIP_MS   10000
+#define SYS_WDT_DEADLINE_SUPP_MS    10000
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef enum
+{
+    SYS_WDT_ACTION_RESET = 0,       // record and reset
+    SYS_WDT_ACTION_LOG              // print, count and keep feeding
+} E_SysWdtAction_t;
+
+// send a message to the task, the handler calls Sys_WdtKick(iId)
+// 0: sent, -1: no space, sent again at the next period
+typedef int (*T_SysWdtProbe)(int iId);
+
+typedef struct
+{
+    const char *sName;              // NULL: free entry
+    T_SysWdtProbe fpProbe;          // NULL: periodic or busy/idle
+    uint32_t u32Deadline;           // ms
+    volatile uint32_t u32Last;      // tick of the arming
+    volatile uint8_t u8Armed;
+    void *pHandle;                  // TaskHandle_t, from the last check-in
+    uint32_t u32Max;                // longest armed time checked in, ms
+    uint32_t u32Miss;
+} S_SysWdtClient_t;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global  variable
+
+// Sec 5: declaration of global function prototype
+void Sys_WdtStart(void);
+void Sys_WdtFeed(void);
+
+int Sys_WdtRegister(const char *sName, uint32_t u32DeadlineMs, T_SysWdtProbe fpProbe);
+void Sys_WdtUnregister(int iId);
+
+void Sys_WdtKick(int iId);
+void Sys_WdtBusy(int iId);
+void Sys_WdtIdle(int iId);
+
+void Sys_WdtActionSet(uint8_t u8Action);
+uint32_t Sys_WdtClientGet(S_SysWdtClient_t *ptClient, uint32_t u32Max);
+
+void Sys_WdtCmd(char *sCmd);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global  variable
+
+// Sec 7: declaration of static function prototype
+
+#endif // __SYS_WDT_H__
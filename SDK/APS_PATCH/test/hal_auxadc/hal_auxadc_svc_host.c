@@ -0,0 +1,690 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_auxadc_svc_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The AUXADC sampling service of hal_auxadc_svc.c, with the ROM one-shot
+*  readings next to it, against a register model of the converter.
+*
+*  A rising edge of the trigger bit in AUX_ADC_CK_GEN_CTL starts one
+*  conversion of the input selected by RG_SPARE / PMS_SPARE / RG_AUX_IN_SEL:
+*  RG_AUX_ADC_ECL_OUT reads EOCB for two polls, then the value. Without
+*  ADC_CTL, PU_VAL and the clock gate on, or once stuck is injected, the
+*  conversion never ends. The first conversion after the input changed
+*  reads SETTLE high, the temperature sensor reads the rail unless it is
+*  enabled, and the optional noise cancels out over four conversions.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <math.h>
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "hal_auxadc.h"
+#include "hal_auxadc_internal.h"
+#include "hal_auxadc_svc.h"
+#include "mw_fim.h"
+#include "mw_fim_default_group03.h"
+#include "host_os.h"
+#include "host_reg.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define AUX_HOST_HPBG_CTL       (AOS_BASE + 0x028)
+#define AUX_HOST_PMS_SPARE      (AOS_BASE + 0x084)
+#define AUX_HOST_ADC_CTL        (AOS_BASE + 0x088)
+
+#define AUX_HOST_RG_SPARE       (RF_BASE + 0x008)
+#define AUX_HOST_CK_GATE_CTRL   (RF_BASE + 0x048)
+#define AUX_HOST_IN_SEL         (RF_BASE + 0x064)
+#define AUX_HOST_PU_VAL         (RF_BASE + 0x090)
+#define AUX_HOST_CK_GEN_CTL     (RF_BASE + 0x0CC)
+#define AUX_HOST_ECL_OUT        (RF_BASE + 0x0D0)
+
+#define AUX_HOST_EOCB           (1 << 16)
+#define AUX_HOST_BUSY_POLL      (2)
+#define AUX_HOST_SETTLE         (40)        // LSB, the first conversion after the input changed
+#define AUX_HOST_KEY_INTERNAL   (0x100)
+#define AUX_HOST_KEY_NONE       (0xFFFFFFFF)
+#define AUX_HOST_WAIT_MS        (2000)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    uint16_t u16aGpio[HAL_AUX_GPIO_NUM_MAX];
+    uint16_t u16aSrc[HAL_AUX_SRC_MAX];      // the internal sources
+
+    // the conversion
+    uint8_t u8Trig;
+    uint8_t u8Valid;
+    uint32_t u32Busy;
+    uint32_t u32Value;
+    uint32_t u32Key;                        // the input of the last conversion
+
+    // injected
+    uint8_t u8Stuck;
+    uint8_t u8Noise;
+
+    uint8_t u8AdcOn;
+    uint32_t u32PowerUp;
+    uint32_t u32Convert;
+    uint32_t u32Unpowered;                  // triggers while the converter was off
+} T_AuxHostAdc;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+extern uint8_t g_ubHalAux_Init;
+extern osSemaphoreId g_taHalAux_SemaphoreId;
+extern T_HalAuxCalData g_tHalAux_CalData;
+
+// the ROM boot and FIM code the AUXADC driver calls
+T_MwFim_FileRead_Fp MwFim_FileRead;
+
+// Sec 5: declaration of global function prototype
+void Hal_Aux_PreInitCold(void);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_AuxHostAdc g_tAuxHostAdc;
+
+static const int8_t g_s8aAuxHostNoise[4] = { -2, 2, -1, 1 };
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+uint32_t Boot_CheckWarmBoot(void)
+{
+    return 0;
+}
+
+// no calibration in flash: the driver takes g_tMwFimDefaultCalAuxadc
+static uint8_t _AuxHost_FimRead(uint32_t ulFileId, uint16_t uwRecIdx, uint16_t uwFileSize, uint8_t *pubFileData)
+{
+    return MW_FIM_FAIL;
+}
+
+static uint8_t _AuxHost_Powered(void)
+{
+    return ((HostReg_Get(AUX_HOST_ADC_CTL) & (1 << 0)) &&
+            (HostReg_Get(AUX_HOST_PU_VAL) & (1 << 26)) &&
+            (HostReg_Get(AUX_HOST_CK_GATE_CTRL) & (1 << 6)));
+}
+
+static void _AuxHost_Convert(void)
+{
+    T_AuxHostAdc *ptAdc = &g_tAuxHostAdc;
+    uint32_t u32Key;
+    uint32_t u32Src;
+    int32_t s32Val;
+
+    if (!_AuxHost_Powered())
+    {
+        ptAdc->u8Valid = 0;
+        ptAdc->u32Unpowered++;
+        return;
+    }
+
+    if (HostReg_Get(AUX_HOST_RG_SPARE) & (1 << 19))
+    {
+        u32Src = (HostReg_Get(AUX_HOST_PMS_SPARE) >> 1) & 0x7;
+        u32Key = AUX_HOST_KEY_INTERNAL | u32Src;
+
+        if ((u32Src == HAL_AUX_SRC_TEMP_SEN) && (!(HostReg_Get(AUX_HOST_HPBG_CTL) & (1 << 18))))
+            s32Val = 0x3FF;
+        else
+            s32Val = ptAdc->u16aSrc[u32Src];
+    }
+    else
+    {
+        u32Key = HostReg_Get(AUX_HOST_IN_SEL) & 0xF;
+        s32Val = ptAdc->u16aGpio[u32Key];
+    }
+
+    if (u32Key != ptAdc->u32Key)
+        s32Val += AUX_HOST_SETTLE;
+    ptAdc->u32Key = u32Key;
+
+    if (ptAdc->u8Noise)
+        s32Val += g_s8aAuxHostNoise[ptAdc->u32Convert % 4];
+
+    if (s32Val < 0)
+        s32Val = 0;
+    if (s32Val > 0x3FF)
+        s32Val = 0x3FF;
+
+    ptAdc->u32Value = (uint32_t)s32Val;
+    ptAdc->u32Busy = AUX_HOST_BUSY_POLL;
+    ptAdc->u8Valid = 1;
+    ptAdc->u32Convert++;
+}
+
+static uint32_t _AuxHost_RfRead(uint32_t u32Addr, uint32_t u32Val, void *pArg)
+{
+    T_AuxHostAdc *ptAdc = &g_tAuxHostAdc;
+
+    if (u32Addr != AUX_HOST_ECL_OUT)
+        return u32Val;
+
+    if ((ptAdc->u8Stuck) || (!ptAdc->u8Valid))
+        return AUX_HOST_EOCB;
+
+    if (ptAdc->u32Busy)
+    {
+        ptAdc->u32Busy--;
+        return AUX_HOST_EOCB;
+    }
+
+    return ptAdc->u32Value;
+}
+
+static void _AuxHost_RfWrite(uint32_t u32Addr, uint32_t u32Val, void *pArg)
+{
+    T_AuxHostAdc *ptAdc = &g_tAuxHostAdc;
+    uint8_t u8Trig = (u32Val & (1 << 0)) ? 1 : 0;
+
+    if (u32Addr != AUX_HOST_CK_GEN_CTL)
+        return;
+
+    if ((u8Trig) && (!ptAdc->u8Trig))
+        _AuxHost_Convert();
+
+    ptAdc->u8Trig = u8Trig;
+}
+
+static void _AuxHost_AosWrite(uint32_t u32Addr, uint32_t u32Val, void *pArg)
+{
+    T_AuxHostAdc *ptAdc = &g_tAuxHostAdc;
+    uint8_t u8On = (u32Val & (1 << 0)) ? 1 : 0;
+
+    if (u32Addr != AUX_HOST_ADC_CTL)
+        return;
+
+    if ((u8On) && (!ptAdc->u8AdcOn))
+        ptAdc->u32PowerUp++;
+
+    ptAdc->u8AdcOn = u8On;
+}
+
+static void _AuxHost_Reset(void)
+{
+    T_HalAuxSvcSample taSample[HAL_AUX_SVC_RING_NUM];
+    T_AuxHostAdc *ptAdc = &g_tAuxHostAdc;
+    uint32_t i;
+
+    Hal_Aux_SvcStop();
+    while (Hal_Aux_SvcRead(taSample, HAL_AUX_SVC_RING_NUM))
+        ;
+    Hal_Aux_SvcStatReset();
+
+    memcpy(&g_tHalAux_CalData, &g_tMwFimDefaultCalAuxadc, sizeof(T_HalAuxCalData));
+
+    memset(ptAdc, 0, sizeof(T_AuxHostAdc));
+    ptAdc->u32Key = AUX_HOST_KEY_NONE;
+    ptAdc->u8AdcOn = (HostReg_Get(AUX_HOST_ADC_CTL) & (1 << 0)) ? 1 : 0;
+    for (i = 0; i < HAL_AUX_GPIO_NUM_MAX; i++)
+        ptAdc->u16aGpio[i] = 300 + 50 * i;
+    for (i = 0; i < HAL_AUX_SRC_MAX; i++)
+        ptAdc->u16aSrc[i] = 512;
+    ptAdc->u16aSrc[HAL_AUX_SRC_VBAT] = 900;
+    ptAdc->u16aSrc[HAL_AUX_SRC_TEMP_SEN] = 600;
+}
+
+static void _AuxHost_CfgSet(T_HalAuxSvcCfg *ptCfg, uint8_t ubOversample, uint8_t ubDiscard)
+{
+    memset(ptCfg, 0, sizeof(T_HalAuxSvcCfg));
+    ptCfg->ulPeriodMs = HAL_AUX_SVC_PERIOD_MIN;
+    ptCfg->ubOversample = ubOversample;
+    ptCfg->ubDiscard = ubDiscard;
+}
+
+static void _AuxHost_ChAdd(T_HalAuxSvcCfg *ptCfg, E_HalAux_Src_t tSrc, uint8_t ubGpioIdx)
+{
+    ptCfg->taCh[ptCfg->ubChNum].tSrc = tSrc;
+    ptCfg->taCh[ptCfg->ubChNum].ubGpioIdx = ubGpioIdx;
+    ptCfg->ubChNum++;
+}
+
+static uint32_t _AuxHost_ScanGet(void)
+{
+    T_HalAuxSvcStat tStat;
+
+    Hal_Aux_SvcStatGet(&tStat);
+    return tStat.ulScan;
+}
+
+// wait for the scan counter to reach ulScan, 0 on time-out
+static uint8_t _AuxHost_WaitScan(uint32_t ulScan)
+{
+    uint64_t u64Start = HostOs_TimeUs();
+
+    while (_AuxHost_ScanGet() < ulScan)
+    {
+        if (HostOs_TimeUs() - u64Start > AUX_HOST_WAIT_MS * 1000ULL)
+            return 0;
+        osDelay(1);
+    }
+
+    return 1;
+}
+
+// mV as Hal_Aux_VbatGet / Hal_Aux_IoVoltageGet compute it, rounded
+static uint32_t _AuxHost_MvRef(uint32_t ulRaw, float fSlope, uint16_t uwOffset)
+{
+    if (ulRaw <= uwOffset)
+        return HAL_AUX_BASE_VBAT;
+
+    return (uint32_t)lroundf((HAL_AUX_BASE_VBAT + (ulRaw - uwOffset) * fSlope) * 1000);
+}
+
+static uint8_t _AuxHost_Near(uint32_t ulA, uint32_t ulB, uint32_t ulTol)
+{
+    return (ulA > ulB) ? (ulA - ulB <= ulTol) : (ulB - ulA <= ulTol);
+}
+
+// bad configurations are refused and leave the converter off
+static void _AuxHost_StartCheck(void)
+{
+    T_HalAuxSvcCfg tCfg;
+
+    _AuxHost_Reset();
+
+    HOST_TEST_EQ(Hal_Aux_SvcStart(NULL), HAL_AUX_FAIL);
+
+    _AuxHost_CfgSet(&tCfg, 1, 0);
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_FAIL);
+
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_VBAT, 0);
+    tCfg.ubChNum = HAL_AUX_SVC_CH_MAX + 1;
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_FAIL);
+    tCfg.ubChNum = 1;
+
+    tCfg.ubOversample = 0;
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_FAIL);
+    tCfg.ubOversample = HAL_AUX_SVC_OVERSAMPLE_MAX + 1;
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_FAIL);
+    tCfg.ubOversample = 1;
+
+    tCfg.ulPeriodMs = HAL_AUX_SVC_PERIOD_MIN - 1;
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_FAIL);
+    tCfg.ulPeriodMs = HAL_AUX_SVC_PERIOD_MIN;
+
+    tCfg.taCh[0].tSrc = HAL_AUX_SRC_MAX;
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_FAIL);
+    tCfg.taCh[0].tSrc = HAL_AUX_SRC_GPIO;
+    tCfg.taCh[0].ubGpioIdx = HAL_AUX_GPIO_NUM_MAX;
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_FAIL);
+
+    HOST_TEST_EQ(Hal_Aux_SvcActive(), 0);
+    HOST_TEST_EQ(g_tAuxHostAdc.u32PowerUp, 0);
+    HOST_TEST_EQ(HostReg_Get(AUX_HOST_ADC_CTL) & (1 << 0), 0);
+
+    tCfg.taCh[0].ubGpioIdx = HAL_AUX_GPIO_NUM_MAX - 1;
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_OK);
+    HOST_TEST_EQ(Hal_Aux_SvcActive(), 1);
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_FAIL);
+
+    Hal_Aux_SvcStop();
+    HOST_TEST_EQ(Hal_Aux_SvcActive(), 0);
+}
+
+// powered up once for the whole run, the temperature sensor with it, off after the stop
+static void _AuxHost_Power(void)
+{
+    T_HalAuxSvcCfg tCfg;
+    T_HalAuxSvcSample tSample;
+
+    _AuxHost_Reset();
+    _AuxHost_CfgSet(&tCfg, 2, 1);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_GPIO, 2);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_TEMP_SEN, 0);
+
+    HOST_TEST_ASSERT(!_AuxHost_Powered());
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_OK);
+    HOST_TEST_ASSERT(_AuxHost_Powered());
+    HOST_TEST_ASSERT(HostReg_Get(AUX_HOST_HPBG_CTL) & (1 << 18));
+
+    HOST_TEST_ASSERT(_AuxHost_WaitScan(4));
+    HOST_TEST_EQ(g_tAuxHostAdc.u32PowerUp, 1);
+    HOST_TEST_EQ(g_tAuxHostAdc.u32Unpowered, 0);
+
+    HOST_TEST_EQ(Hal_Aux_SvcLatestGet(0, &tSample), HAL_AUX_OK);
+    HOST_TEST_EQ(tSample.uwRaw, 400);
+    HOST_TEST_EQ(Hal_Aux_SvcLatestGet(1, &tSample), HAL_AUX_OK);
+    HOST_TEST_EQ(tSample.uwRaw, 600);
+    HOST_TEST_EQ(tSample.uwMilliVolt, HAL_AUX_SVC_MV_NONE);
+    HOST_TEST_EQ(Hal_Aux_SvcLatestGet(2, &tSample), HAL_AUX_FAIL);
+
+    Hal_Aux_SvcStop();
+    HOST_TEST_ASSERT(!(HostReg_Get(AUX_HOST_ADC_CTL) & (1 << 0)));
+    HOST_TEST_ASSERT(!(HostReg_Get(AUX_HOST_PU_VAL) & (1 << 26)));
+    HOST_TEST_ASSERT(!(HostReg_Get(AUX_HOST_CK_GATE_CTRL) & (1 << 6)));
+    HOST_TEST_ASSERT(!(HostReg_Get(AUX_HOST_HPBG_CTL) & (1 << 18)));
+    HOST_TEST_EQ(g_tAuxHostAdc.u32PowerUp, 1);
+}
+
+// the noise averages out, the settling conversion is dropped on every input change
+static void _AuxHost_Average(void)
+{
+    T_HalAuxSvcCfg tCfg;
+    T_HalAuxSvcSample taSample[HAL_AUX_SVC_RING_NUM];
+    T_HalAuxSvcStat tStat;
+    uint32_t ulNum;
+    uint32_t i;
+
+    _AuxHost_Reset();
+    g_tAuxHostAdc.u8Noise = 1;
+
+    _AuxHost_CfgSet(&tCfg, 4, 1);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_VBAT, 0);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_GPIO, 3);
+
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_OK);
+    HOST_TEST_ASSERT(_AuxHost_WaitScan(3));
+    Hal_Aux_SvcStop();
+
+    ulNum = Hal_Aux_SvcRead(taSample, HAL_AUX_SVC_RING_NUM);
+    Hal_Aux_SvcStatGet(&tStat);
+    HOST_TEST_EQ(ulNum, tStat.ulScan * 2);
+    HOST_TEST_EQ(tStat.ulConvert, tStat.ulScan * 2 * (4 + 1));
+    HOST_TEST_EQ(tStat.ulFail, 0);
+
+    for (i = 0; i < ulNum; i++)
+    {
+        HOST_TEST_EQ(taSample[i].ubCh, i % 2);
+        if (taSample[i].ubCh == 0)
+        {
+            HOST_TEST_EQ(taSample[i].uwRaw, 900);
+            HOST_TEST_EQ(taSample[i].uwMilliVolt, 2400);
+        }
+        else
+        {
+            HOST_TEST_EQ(taSample[i].uwRaw, 450);
+            HOST_TEST_EQ(taSample[i].uwMilliVolt, 1050);
+        }
+    }
+}
+
+// without the discard the settling error is averaged in, with it the first sample is right
+static void _AuxHost_Settle(void)
+{
+    T_HalAuxSvcCfg tCfg;
+    T_HalAuxSvcSample taSample[HAL_AUX_SVC_RING_NUM];
+    T_HalAuxSvcStat tStat;
+    float fVbat = 0;
+
+    _AuxHost_Reset();
+    _AuxHost_CfgSet(&tCfg, 4, 0);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_GPIO, 5);
+
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_OK);
+    HOST_TEST_ASSERT(_AuxHost_WaitScan(2));
+    Hal_Aux_SvcStop();
+
+    HOST_TEST_ASSERT(Hal_Aux_SvcRead(taSample, HAL_AUX_SVC_RING_NUM) >= 2);
+    HOST_TEST_EQ(taSample[0].uwRaw, 550 + AUX_HOST_SETTLE / 4);
+    HOST_TEST_EQ(taSample[1].uwRaw, 550);
+
+    // a one-shot reading moves the input away
+    HOST_TEST_EQ(Hal_Aux_VbatGet(&fVbat), HAL_AUX_OK);
+    Hal_Aux_SvcStatReset();
+
+    tCfg.ubDiscard = 2;
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_OK);
+    HOST_TEST_ASSERT(_AuxHost_WaitScan(2));
+    Hal_Aux_SvcStop();
+
+    HOST_TEST_ASSERT(Hal_Aux_SvcRead(taSample, HAL_AUX_SVC_RING_NUM) >= 2);
+    HOST_TEST_EQ(taSample[0].uwRaw, 550);
+    HOST_TEST_EQ(taSample[1].uwRaw, 550);
+
+    // the discard only after a change of the input
+    Hal_Aux_SvcStatGet(&tStat);
+    HOST_TEST_EQ(tStat.ulConvert, 2 + tStat.ulScan * 4);
+}
+
+// the Q16 calibration against the float one of the ROM over the whole range
+static void _AuxHost_MilliVolt(void)
+{
+    static const uint16_t uwaRaw[] = { 0, 50, 87, 88, 95, 96, 300, 512, 777, 1000, 1023 };
+    T_HalAuxSvcCfg tCfg;
+    T_HalAuxSvcSample tSample;
+    uint32_t ulScan;
+    float fVbat = 0;
+    uint32_t i;
+
+    _AuxHost_Reset();
+    g_tHalAux_CalData.fSlopeVbat = 0.00412f;
+    g_tHalAux_CalData.fSlopeIo = 0.0029f;
+    g_tHalAux_CalData.uwDcOffsetVbat = 87;
+    g_tHalAux_CalData.uwDcOffsetIo = 95;
+
+    _AuxHost_CfgSet(&tCfg, 1, 1);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_VBAT, 0);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_GPIO, 0);
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_OK);
+
+    for (i = 0; i < sizeof(uwaRaw) / sizeof(uwaRaw[0]); i++)
+    {
+        g_tAuxHostAdc.u16aSrc[HAL_AUX_SRC_VBAT] = uwaRaw[i];
+        g_tAuxHostAdc.u16aGpio[0] = uwaRaw[i];
+
+        // one whole scan after the change
+        ulScan = _AuxHost_ScanGet();
+        HOST_TEST_ASSERT(_AuxHost_WaitScan(ulScan + 2));
+
+        HOST_TEST_EQ(Hal_Aux_SvcLatestGet(0, &tSample), HAL_AUX_OK);
+        HOST_TEST_EQ(tSample.uwRaw, uwaRaw[i]);
+        HOST_TEST_ASSERT(_AuxHost_Near(tSample.uwMilliVolt, _AuxHost_MvRef(uwaRaw[i], 0.00412f, 87), 1));
+
+        HOST_TEST_EQ(Hal_Aux_SvcLatestGet(1, &tSample), HAL_AUX_OK);
+        HOST_TEST_EQ(tSample.uwRaw, uwaRaw[i]);
+        HOST_TEST_ASSERT(_AuxHost_Near(tSample.uwMilliVolt, _AuxHost_MvRef(uwaRaw[i], 0.0029f, 95), 1));
+    }
+
+    // the ROM reading while the service runs, at full scale the settling does not show
+    HOST_TEST_EQ(Hal_Aux_VbatGet(&fVbat), HAL_AUX_OK);
+    HOST_TEST_ASSERT(fabsf(fVbat - (1023 - 87) * 0.00412f) < 1e-4f);
+
+    Hal_Aux_SvcStop();
+}
+
+// the full ring drops the oldest samples and counts them
+static void _AuxHost_Overrun(void)
+{
+    T_HalAuxSvcCfg tCfg;
+    T_HalAuxSvcSample taSample[HAL_AUX_SVC_RING_NUM + 8];
+    T_HalAuxSvcStat tStat;
+    uint32_t i;
+
+    _AuxHost_Reset();
+    _AuxHost_CfgSet(&tCfg, 1, 1);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_VBAT, 0);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_GPIO, 1);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_GPIO, 2);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_GPIO, 3);
+
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_OK);
+    HOST_TEST_ASSERT(_AuxHost_WaitScan(10));
+    Hal_Aux_SvcStop();
+
+    Hal_Aux_SvcStatGet(&tStat);
+    HOST_TEST_EQ(tStat.ulOverrun, tStat.ulScan * 4 - HAL_AUX_SVC_RING_NUM);
+
+    HOST_TEST_EQ(Hal_Aux_SvcRead(taSample, HAL_AUX_SVC_RING_NUM + 8), HAL_AUX_SVC_RING_NUM);
+    HOST_TEST_EQ(taSample[0].ubCh, 0);
+    for (i = 1; i < HAL_AUX_SVC_RING_NUM; i++)
+    {
+        HOST_TEST_EQ(taSample[i].ubCh, (taSample[i - 1].ubCh + 1) % 4);
+        HOST_TEST_ASSERT(taSample[i].ulTick >= taSample[i - 1].ulTick);
+        HOST_TEST_EQ(taSample[i].uwRaw, (taSample[i].ubCh == 0) ? 900 : 300 + 50 * taSample[i].ubCh);
+    }
+
+    HOST_TEST_EQ(Hal_Aux_SvcRead(taSample, 1), 0);
+}
+
+// a converter that never ends: the channel fails, the scans go on and recover
+static void _AuxHost_Timeout(void)
+{
+    T_HalAuxSvcCfg tCfg;
+    T_HalAuxSvcSample tStuck;
+    T_HalAuxSvcSample tSample;
+    T_HalAuxSvcStat tStat;
+    uint32_t ulScan;
+
+    _AuxHost_Reset();
+    _AuxHost_CfgSet(&tCfg, 2, 1);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_GPIO, 4);
+
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_OK);
+    HOST_TEST_ASSERT(_AuxHost_WaitScan(2));
+
+    g_tAuxHostAdc.u8Stuck = 1;
+    ulScan = _AuxHost_ScanGet();
+    HOST_TEST_ASSERT(_AuxHost_WaitScan(ulScan + 1));
+    HOST_TEST_EQ(Hal_Aux_SvcLatestGet(0, &tStuck), HAL_AUX_OK);
+    HOST_TEST_ASSERT(_AuxHost_WaitScan(ulScan + 4));
+
+    Hal_Aux_SvcStatGet(&tStat);
+    HOST_TEST_ASSERT(tStat.ulFail >= 3);
+    HOST_TEST_EQ(Hal_Aux_SvcLatestGet(0, &tSample), HAL_AUX_OK);
+    HOST_TEST_EQ(tSample.ulTick, tStuck.ulTick);
+
+    g_tAuxHostAdc.u8Stuck = 0;
+    ulScan = _AuxHost_ScanGet();
+    HOST_TEST_ASSERT(_AuxHost_WaitScan(ulScan + 2));
+    Hal_Aux_SvcStop();
+
+    HOST_TEST_EQ(Hal_Aux_SvcLatestGet(0, &tSample), HAL_AUX_OK);
+    HOST_TEST_ASSERT(tSample.ulTick > tStuck.ulTick);
+    HOST_TEST_EQ(tSample.uwRaw, 500);
+}
+
+// one-shot readings go on during the service without a power cycle of their own
+static void _AuxHost_OneShot(void)
+{
+    T_HalAuxSvcCfg tCfg;
+    T_HalAuxSvcSample tSample;
+    uint32_t ulPowerUp;
+    uint32_t ulScan;
+    float fVolt = 0;
+
+    _AuxHost_Reset();
+    _AuxHost_CfgSet(&tCfg, 2, 1);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_VBAT, 0);
+
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_OK);
+    HOST_TEST_ASSERT(_AuxHost_WaitScan(1));
+    ulPowerUp = g_tAuxHostAdc.u32PowerUp;
+
+    // no discard here: it reads the settling conversion, as on the ROM path
+    HOST_TEST_EQ(Hal_Aux_IoVoltageGet(7, &fVolt), HAL_AUX_OK);
+    HOST_TEST_ASSERT(fabsf(fVolt - (650 + AUX_HOST_SETTLE - 100) * 0.003f) < 1e-4f);
+    HOST_TEST_EQ(g_tAuxHostAdc.u32PowerUp, ulPowerUp);
+    HOST_TEST_ASSERT(_AuxHost_Powered());
+
+    // the next scan settles its input again
+    ulScan = _AuxHost_ScanGet();
+    HOST_TEST_ASSERT(_AuxHost_WaitScan(ulScan + 2));
+    HOST_TEST_EQ(Hal_Aux_SvcLatestGet(0, &tSample), HAL_AUX_OK);
+    HOST_TEST_EQ(tSample.uwRaw, 900);
+
+    Hal_Aux_SvcStop();
+
+    // the ROM path again: one power cycle per reading
+    HOST_TEST_EQ(Hal_Aux_VbatGet(&fVolt), HAL_AUX_OK);
+    HOST_TEST_EQ(g_tAuxHostAdc.u32PowerUp, ulPowerUp + 1);
+    HOST_TEST_ASSERT(!_AuxHost_Powered());
+}
+
+// a period that finds the AUXADC taken is skipped, not queued
+static void _AuxHost_Skip(void)
+{
+    T_HalAuxSvcCfg tCfg;
+    T_HalAuxSvcStat tStat;
+    uint32_t ulScan;
+
+    _AuxHost_Reset();
+    _AuxHost_CfgSet(&tCfg, 1, 0);
+    _AuxHost_ChAdd(&tCfg, HAL_AUX_SRC_VBAT, 0);
+
+    HOST_TEST_EQ(Hal_Aux_SvcStart(&tCfg), HAL_AUX_OK);
+    HOST_TEST_ASSERT(_AuxHost_WaitScan(1));
+
+    osSemaphoreWait(g_taHalAux_SemaphoreId, osWaitForever);
+    ulScan = _AuxHost_ScanGet();
+    osDelay(HAL_AUX_SVC_PERIOD_MIN * 4);
+    HOST_TEST_EQ(_AuxHost_ScanGet(), ulScan);
+    osSemaphoreRelease(g_taHalAux_SemaphoreId);
+
+    HOST_TEST_ASSERT(_AuxHost_WaitScan(ulScan + 1));
+    Hal_Aux_SvcStop();
+
+    Hal_Aux_SvcStatGet(&tStat);
+    HOST_TEST_ASSERT(tStat.ulSkip >= 2);
+}
+
+static const T_HostTestCase g_taAuxHostCase[] =
+{
+    HOST_TEST_CASE(_AuxHost_StartCheck),
+    HOST_TEST_CASE(_AuxHost_Power),
+    HOST_TEST_CASE(_AuxHost_Average),
+    HOST_TEST_CASE(_AuxHost_Settle),
+    HOST_TEST_CASE(_AuxHost_MilliVolt),
+    HOST_TEST_CASE(_AuxHost_Overrun),
+    HOST_TEST_CASE(_AuxHost_Timeout),
+    HOST_TEST_CASE(_AuxHost_OneShot),
+    HOST_TEST_CASE(_AuxHost_Skip),
+};
+
+int main(void)
+{
+    HostOs_Init();
+
+    if (HostReg_Init())
+        return 1;
+
+    if ((HostReg_Hook(AOS_BASE, NULL, _AuxHost_AosWrite, NULL)) ||
+        (HostReg_Hook(RF_BASE, _AuxHost_RfRead, _AuxHost_RfWrite, NULL)))
+        return 1;
+
+    MwFim_FileRead = _AuxHost_FimRead;
+    Hal_Aux_PreInitCold();
+    Hal_Aux_Init();
+    if (g_ubHalAux_Init != 1)
+        return 1;
+
+    return HostTest_Run("hal_auxadc_svc", g_taAuxHostCase, HOST_TEST_NUM(g_taAuxHostCase));
+}
@@ -0,0 +1,610 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_flash_cache_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The read cache of hal_flash_cache.c in front of the ROM hal_flash.c,
+*  hal_flash_patch.c and hal_flash_sched.c, installed as peri_patch_init.c
+*  does it, against the SPI flash simulator (host/host_flash).
+*
+*  The cases check the LRU replacement, the prefetch of a sequential read,
+*  the invalidation by a program and by the start of a background erase,
+*  and the bypass of the long reads. The last one runs the ROM MW_FIM over a
+*  zone of 8 groups that has seen some writes, and gives the bus reads and
+*  the time of MwFim_Init, of reading every record once and of reading the
+*  records of a group again and again, with the cache off and on.
+*
+*  The parse of MwFim_Init reads each block once in steps of a file header:
+*  a line holds few of them, and filling it costs more than the reads it
+*  saves. The case checks that trade, the reason why Sys_DriverInit runs
+*  MwFim_Init with the cache off; the reads that come back to the same
+*  records are the ones the cache is for.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <string.h>
+#include "opl1000.h"
+#include "hal_spi.h"
+#include "hal_flash.h"
+#include "hal_flash_internal.h"
+#include "hal_flash_patch.h"
+#include "hal_flash_sched.h"
+#include "hal_flash_cache.h"
+#include "mw_fim.h"
+#include "mw_fim_default.h"
+#include "host_flash.h"
+#include "host_os.h"
+#include "host_reg.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define CACHE_HOST_BOOT_SIZE    (0x1000)
+#define CACHE_HOST_DATA_ADDR    (0x40000)   // 16 sectors of a known pattern
+#define CACHE_HOST_DATA_SIZE    (0x10000)
+#define CACHE_HOST_READ_SIZE    (16)
+#define CACHE_HOST_LINE         HAL_FLASH_CACHE_LINE_SIZE
+
+#define CACHE_HOST_GROUP_NUM    (8)         // zone 0 as the SDK lays it out
+#define CACHE_HOST_FILE_NUM     (6)         // per group
+#define CACHE_HOST_RECORD_MAX   (4)
+#define CACHE_HOST_FILE_MAX     (200)       // the largest data size
+#define CACHE_HOST_HISTORY      (3)         // writes of every record after the defaults
+#define CACHE_HOST_REREAD       (4)
+
+// the file ID: zone 0, the group, the index
+#define CACHE_HOST_FILE_ID(g, f)    ((((uint32_t)(g)) << 16) | (uint32_t)(f))
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    uint64_t u64Us;
+    uint32_t u32BusReads;               // read transactions on the bus
+    uint32_t u32BusBytes;
+    uint32_t u32Erase;                  // sector erases in the time
+} T_CacheHostCost;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+// of mw_fim.c, mw_fim_internal.h defines the internal pointers
+extern uint8_t g_ubMwFimInit;
+
+// the layout of mw_fim_default.c, with the groups of the test
+uint8_t g_ubaMwFimVersionTable[MW_FIM_ZONE_MAX][MW_FIM_GROUP_MAX] =
+{
+    {0x01, 0x03, 0x03, 0x03, 0x02, 0x01, 0x01, 0x02, 0x01},
+    {0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01},
+    {0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01},
+    {0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01}
+};
+
+T_MwFimZoneInfo g_taMwFimZoneInfoTable[MW_FIM_ZONE_MAX] =
+{
+    {MW_FIM_ZONE0_BASE_ADDR, MW_FIM_ZONE0_BLOCK_SIZE, CACHE_HOST_GROUP_NUM + 1, g_ubaMwFimVersionTable[0]},
+    {MW_FIM_ZONE1_BASE_ADDR, MW_FIM_ZONE1_BLOCK_SIZE, 0, g_ubaMwFimVersionTable[1]},
+    {MW_FIM_ZONE2_BASE_ADDR, MW_FIM_ZONE2_BLOCK_SIZE, 0, g_ubaMwFimVersionTable[2]},
+    {MW_FIM_ZONE3_BASE_ADDR, MW_FIM_ZONE3_BLOCK_SIZE, 0, g_ubaMwFimVersionTable[3]}
+};
+
+T_MwFimFileInfo* g_ptaMwFimGroupInfoTable[MW_FIM_ZONE_MAX][MW_FIM_GROUP_MAX];
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_HostFlashCfg g_tCacheHostCfg;
+static uint8_t g_u8aCacheHostBuf[HAL_FLASH_CACHE_BYPASS_SIZE];
+
+// the data sizes and records of the files of a group, as the SDK groups mix them
+static const uint16_t g_uwaCacheHostFileSize[CACHE_HOST_FILE_NUM] = {8, 24, 48, 100, 16, CACHE_HOST_FILE_MAX};
+static const uint16_t g_uwaCacheHostFileRec[CACHE_HOST_FILE_NUM] = {1, 1, 2, 1, CACHE_HOST_RECORD_MAX, 1};
+
+static T_MwFimFileInfo g_taCacheHostGroup[CACHE_HOST_GROUP_NUM + 1][CACHE_HOST_FILE_NUM + 1];
+static uint32_t g_ulaCacheHostAddr[CACHE_HOST_GROUP_NUM + 1][CACHE_HOST_FILE_NUM][CACHE_HOST_RECORD_MAX];
+static uint8_t g_ubaCacheHostDefault[CACHE_HOST_FILE_MAX];
+static uint8_t g_ubaCacheHostFile[CACHE_HOST_FILE_MAX];
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+uint32_t Boot_CheckWarmBoot(void)
+{
+    return 0;
+}
+
+// a blank part with the data area, the cache empty and all counters at 0
+static uint32_t _CacheHost_Part(void)
+{
+    uint8_t *pu8Mem;
+    uint32_t i;
+
+    HostFlash_CfgDefault(&g_tCacheHostCfg, GIGADEVICE_ID);
+    if (HostFlash_Init(&g_tCacheHostCfg))
+        return 1;
+
+    // the boot agent: the quad I/O check of the init reads it
+    pu8Mem = HostFlash_Mem();
+    for (i = 0; i < CACHE_HOST_BOOT_SIZE; i++)
+        pu8Mem[i] = (uint8_t)(i * 3 + 1);
+    for (i = 0; i < CACHE_HOST_DATA_SIZE; i++)
+        pu8Mem[CACHE_HOST_DATA_ADDR + i] = (uint8_t)((i * 7) ^ (i >> 8));
+
+    Hal_Flash_ReadModeSet(SPI_IDX_0, HAL_FLASH_READ_MODE_AUTO);
+    if (Hal_Flash_Init(SPI_IDX_0))
+        return 1;
+
+    Hal_Flash_CacheEnable(1);
+    HostFlash_StatReset();
+    Hal_Flash_CacheStatReset();
+    return 0;
+}
+
+static uint8_t _CacheHost_ReadOk(uint32_t u32Addr, uint32_t u32Size)
+{
+    memset(g_u8aCacheHostBuf, 0, sizeof(g_u8aCacheHostBuf));
+
+    if (Hal_Flash_AddrRead(SPI_IDX_0, u32Addr, 0, u32Size, g_u8aCacheHostBuf))
+        return 0;
+
+    return (0 == memcmp(g_u8aCacheHostBuf, HostFlash_Mem() + u32Addr, u32Size));
+}
+
+static uint32_t _CacheHost_Line(uint32_t u32Idx)
+{
+    // one line per sector, never the next line of the previous read
+    return CACHE_HOST_DATA_ADDR + (u32Idx * HOST_FLASH_SECTOR_SIZE) + 0x40;
+}
+
+static void _CacheHost_Lru(void)
+{
+    S_FlashCacheStat_t tStat;
+    uint32_t i;
+
+    HOST_TEST_EQ(_CacheHost_Part(), 0);
+
+    // fill every line: all misses, one bus read each
+    for (i = 0; i < HAL_FLASH_CACHE_LINE_NUM; i++)
+        HOST_TEST_ASSERT(_CacheHost_ReadOk(_CacheHost_Line(i), CACHE_HOST_READ_SIZE));
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Miss, HAL_FLASH_CACHE_LINE_NUM);
+    HOST_TEST_EQ(tStat.u32Hit, 0);
+    HOST_TEST_EQ(tStat.u32BusReads, HAL_FLASH_CACHE_LINE_NUM);
+    HOST_TEST_EQ(tStat.u32BusBytes, HAL_FLASH_CACHE_LINE_NUM * CACHE_HOST_LINE);
+    HOST_TEST_EQ(tStat.u32Prefetch, 0);
+
+    // again, from line 1: all hits, nothing on the bus, line 0 is now the oldest
+    Hal_Flash_CacheStatReset();
+    HostFlash_StatReset();
+    for (i = 1; i < HAL_FLASH_CACHE_LINE_NUM; i++)
+        HOST_TEST_ASSERT(_CacheHost_ReadOk(_CacheHost_Line(i), CACHE_HOST_READ_SIZE));
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(_CacheHost_Line(1) + 0x80, CACHE_HOST_READ_SIZE));
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Hit, HAL_FLASH_CACHE_LINE_NUM);
+    HOST_TEST_EQ(tStat.u32Miss, 0);
+    HOST_TEST_EQ(tStat.u32BusReads, 0);
+
+    {
+        T_HostFlashStat tFlash;
+
+        HostFlash_StatGet(&tFlash);
+        HOST_TEST_EQ(tFlash.u32ReadBytes, 0);
+    }
+
+    // a ninth line takes the place of line 0, line 0 then the place of line 2
+    Hal_Flash_CacheStatReset();
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(_CacheHost_Line(HAL_FLASH_CACHE_LINE_NUM), CACHE_HOST_READ_SIZE));
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(_CacheHost_Line(3), CACHE_HOST_READ_SIZE));
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(_CacheHost_Line(0), CACHE_HOST_READ_SIZE));
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(_CacheHost_Line(1), CACHE_HOST_READ_SIZE));
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(_CacheHost_Line(2), CACHE_HOST_READ_SIZE));
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Miss, 3);     // line 8, line 0 and line 2
+    HOST_TEST_EQ(tStat.u32Hit, 2);      // line 3 and line 1
+    HOST_TEST_EQ(tStat.u32BusReads, 3);
+}
+
+static void _CacheHost_Prefetch(void)
+{
+    S_FlashCacheStat_t tStat;
+    uint32_t u32Addr = CACHE_HOST_DATA_ADDR + 0x2000;
+
+    HOST_TEST_EQ(_CacheHost_Part(), 0);
+
+    // the second line in a row brings the third one
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Addr, CACHE_HOST_READ_SIZE));
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Addr + CACHE_HOST_LINE, CACHE_HOST_READ_SIZE));
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Miss, 2);
+    HOST_TEST_EQ(tStat.u32Prefetch, HAL_FLASH_CACHE_PREFETCH);
+    HOST_TEST_EQ(tStat.u32BusReads, 2 + HAL_FLASH_CACHE_PREFETCH);
+
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Addr + (2 * CACHE_HOST_LINE) + 0x10, CACHE_HOST_READ_SIZE));
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Hit, 1);
+    HOST_TEST_EQ(tStat.u32PrefetchHit, 1);
+
+    // the run stays a line ahead: a read across the next two lines finds both
+    Hal_Flash_CacheStatReset();
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Addr + (4 * CACHE_HOST_LINE) - 8, CACHE_HOST_READ_SIZE));
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Miss, 0);
+    HOST_TEST_EQ(tStat.u32PrefetchHit, 2);
+
+    // and the data of a prefetched line is the one of the part
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Addr + (5 * CACHE_HOST_LINE), CACHE_HOST_LINE));
+}
+
+static void _CacheHost_WriteThrough(void)
+{
+    S_FlashCacheStat_t tStat;
+    uint8_t u8aData[CACHE_HOST_READ_SIZE];
+    uint32_t u32Addr = CACHE_HOST_DATA_ADDR + 0x3000;
+    uint32_t i;
+
+    HOST_TEST_EQ(_CacheHost_Part(), 0);
+
+    // a blank place in a cached line
+    memset(HostFlash_Mem() + u32Addr, 0xFF, CACHE_HOST_LINE);
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Addr, CACHE_HOST_LINE));
+
+    for (i = 0; i < sizeof(u8aData); i++)
+        u8aData[i] = (uint8_t)(0xA0 + i);
+    HOST_TEST_EQ(Hal_Flash_AddrProgram(SPI_IDX_0, u32Addr + 0x20, 0, sizeof(u8aData), u8aData), 0);
+    HOST_TEST_EQ(memcmp(HostFlash_Mem() + u32Addr + 0x20, u8aData, sizeof(u8aData)), 0);
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Invalidate, 1);
+
+    // the next read goes to the part and sees the new data
+    Hal_Flash_CacheStatReset();
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Addr, CACHE_HOST_LINE));
+    HOST_TEST_EQ(memcmp(g_u8aCacheHostBuf + 0x20, u8aData, sizeof(u8aData)), 0);
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Miss, 1);
+    HOST_TEST_EQ(tStat.u32Hit, 0);
+
+    // a program of another line keeps this one
+    HOST_TEST_EQ(Hal_Flash_AddrProgram(SPI_IDX_0, u32Addr + CACHE_HOST_LINE, 0, sizeof(u8aData), u8aData), 0);
+    Hal_Flash_CacheStatReset();
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Addr, CACHE_HOST_READ_SIZE));
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Hit, 1);
+}
+
+static void _CacheHost_Bypass(void)
+{
+    S_FlashCacheStat_t tStat;
+    uint32_t u32Addr = CACHE_HOST_DATA_ADDR + 0x4000;
+
+    HOST_TEST_EQ(_CacheHost_Part(), 0);
+
+    // at the bypass size: one bus read of the whole, no line filled
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Addr, HAL_FLASH_CACHE_BYPASS_SIZE));
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Bypass, 1);
+    HOST_TEST_EQ(tStat.u32Miss, 0);
+    HOST_TEST_EQ(tStat.u32BusReads, 1);
+    HOST_TEST_EQ(tStat.u32BusBytes, HAL_FLASH_CACHE_BYPASS_SIZE);
+
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Addr, CACHE_HOST_READ_SIZE));
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Miss, 1);
+
+    // one byte less goes through the lines
+    Hal_Flash_CacheStatReset();
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Addr + 0x1000, HAL_FLASH_CACHE_BYPASS_SIZE - 1));
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Bypass, 0);
+    HOST_TEST_EQ(tStat.u32Miss + tStat.u32Hit, HAL_FLASH_CACHE_BYPASS_SIZE / CACHE_HOST_LINE);
+
+    // and so does everything once the cache is off, without a line
+    Hal_Flash_CacheEnable(0);
+    Hal_Flash_CacheStatReset();
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Addr + 0x1000, CACHE_HOST_READ_SIZE));
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Addr + 0x1000, CACHE_HOST_READ_SIZE));
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Hit + tStat.u32Miss, 0);
+    HOST_TEST_EQ(tStat.u32BusReads, 2);
+    Hal_Flash_CacheEnable(1);
+}
+
+static void _CacheHost_EraseStart(void)
+{
+    S_FlashCacheStat_t tStat;
+    uint32_t u32Sector = CACHE_HOST_DATA_ADDR + 0x5000;
+    uint32_t u32Other = CACHE_HOST_DATA_ADDR + 0x7000;
+    uint32_t i;
+
+    HOST_TEST_EQ(_CacheHost_Part(), 0);
+
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Sector + 0x300, CACHE_HOST_READ_SIZE));
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Other, CACHE_HOST_READ_SIZE));
+
+    // the lines of the sector go when the erase starts, not when it ends
+    Hal_Flash_CacheStatReset();
+    HOST_TEST_EQ(Hal_Flash_EraseStart(SPI_IDX_0, u32Sector), 0);
+    HOST_TEST_EQ(Hal_Flash_EraseBusy(SPI_IDX_0), 1);
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Invalidate, 1);
+
+    // the other line is still served while the part erases
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Other, CACHE_HOST_READ_SIZE));
+
+    Hal_Flash_CacheStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Hit, 1);
+
+    // the erased sector reads blank, never the old line
+    memset(g_u8aCacheHostBuf, 0, sizeof(g_u8aCacheHostBuf));
+    HOST_TEST_EQ(Hal_Flash_AddrRead(SPI_IDX_0, u32Sector + 0x300, 0, CACHE_HOST_READ_SIZE, g_u8aCacheHostBuf), 0);
+    for (i = 0; i < CACHE_HOST_READ_SIZE; i++)
+        HOST_TEST_EQ(g_u8aCacheHostBuf[i], 0xFF);
+
+    HOST_TEST_EQ(Hal_Flash_EraseBusy(SPI_IDX_0), 0);
+    HOST_TEST_EQ(HostFlash_Mem()[u32Sector + 0xFFF], 0xFF);
+
+    // the program that follows the erase is cached after it
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Sector + 0x300, CACHE_HOST_READ_SIZE));
+    HOST_TEST_EQ(Hal_Flash_AddrProgram(SPI_IDX_0, u32Sector + 0x300, 0, CACHE_HOST_READ_SIZE, (uint8_t *)"0123456789abcdef"), 0);
+    HOST_TEST_ASSERT(_CacheHost_ReadOk(u32Sector + 0x300, CACHE_HOST_READ_SIZE));
+    HOST_TEST_EQ(memcmp(g_u8aCacheHostBuf, "0123456789abcdef", CACHE_HOST_READ_SIZE), 0);
+}
+
+// the groups of the zone: files of the sizes above, each with a default value
+static void _CacheHost_FimLayout(void)
+{
+    T_MwFimFileInfo *ptFile;
+    uint32_t g, f;
+
+    memset(g_ptaMwFimGroupInfoTable, 0, sizeof(g_ptaMwFimGroupInfoTable));
+    memset(g_taCacheHostGroup, 0, sizeof(g_taCacheHostGroup));
+
+    for (f = 0; f < sizeof(g_ubaCacheHostDefault); f++)
+        g_ubaCacheHostDefault[f] = (uint8_t)(0x30 + f);
+
+    for (g = 0; g <= CACHE_HOST_GROUP_NUM; g++)
+    {
+        // group 0 is the swap block, it has no file
+        for (f = 0; (g > 0) && (f < CACHE_HOST_FILE_NUM); f++)
+        {
+            ptFile = &g_taCacheHostGroup[g][f];
+            ptFile->ulFileId = CACHE_HOST_FILE_ID(g, f);
+            ptFile->uwRecordMax = g_uwaCacheHostFileRec[f];
+            ptFile->uwDataSize = g_uwaCacheHostFileSize[f];
+            ptFile->pubDefaultValue = g_ubaCacheHostDefault;
+            ptFile->pulDataAddr = g_ulaCacheHostAddr[g][f];
+        }
+
+        g_taCacheHostGroup[g][f].ulFileId = 0xFFFFFFFF;
+        g_ptaMwFimGroupInfoTable[0][g] = g_taCacheHostGroup[g];
+    }
+
+    for (g = 1; g < MW_FIM_ZONE_MAX; g++)
+    {
+        for (f = 0; f < MW_FIM_GROUP_MAX; f++)
+            g_ptaMwFimGroupInfoTable[g][f] = g_taCacheHostGroup[0];
+    }
+}
+
+static void _CacheHost_FimData(uint32_t u32Round, uint32_t g, uint32_t f, uint32_t r)
+{
+    uint32_t i;
+
+    for (i = 0; i < g_uwaCacheHostFileSize[f]; i++)
+        g_ubaCacheHostFile[i] = (uint8_t)(u32Round * 31 + g * 7 + f * 3 + r + i);
+}
+
+// read the files of the groups back, they hold the data of the round
+static uint8_t _CacheHost_FimRead(uint32_t u32Round, uint32_t u32GroupFirst, uint32_t u32GroupLast)
+{
+    uint8_t ubaExpect[CACHE_HOST_FILE_MAX];
+    uint32_t g, f, r;
+    uint8_t u8Ok = 1;
+
+    for (g = u32GroupFirst; g <= u32GroupLast; g++)
+    {
+        for (f = 0; f < CACHE_HOST_FILE_NUM; f++)
+        {
+            for (r = 0; r < g_uwaCacheHostFileRec[f]; r++)
+            {
+                _CacheHost_FimData(u32Round, g, f, r);
+                memcpy(ubaExpect, g_ubaCacheHostFile, g_uwaCacheHostFileSize[f]);
+                memset(g_ubaCacheHostFile, 0, sizeof(g_ubaCacheHostFile));
+
+                if (MW_FIM_OK != MwFim_FileRead(CACHE_HOST_FILE_ID(g, f), r, g_uwaCacheHostFileSize[f], g_ubaCacheHostFile))
+                    u8Ok = 0;
+                else if (memcmp(ubaExpect, g_ubaCacheHostFile, g_uwaCacheHostFileSize[f]))
+                    u8Ok = 0;
+            }
+        }
+    }
+
+    return u8Ok;
+}
+
+static void _CacheHost_CostStart(T_CacheHostCost *ptCost)
+{
+    HostFlash_StatReset();
+    Hal_Flash_CacheStatReset();
+    ptCost->u64Us = HostOs_TimeUs();
+}
+
+static void _CacheHost_CostEnd(T_CacheHostCost *ptCost)
+{
+    T_HostFlashStat tFlash;
+    S_FlashCacheStat_t tStat;
+
+    ptCost->u64Us = HostOs_TimeUs() - ptCost->u64Us;
+
+    HostFlash_StatGet(&tFlash);
+    Hal_Flash_CacheStatGet(&tStat);
+    ptCost->u32BusReads = tStat.u32BusReads;
+    ptCost->u32BusBytes = tStat.u32BusBytes;
+    ptCost->u32Erase = tFlash.u32aCmd[0x20];
+}
+
+static void _CacheHost_CostPrint(const char *pszName, const T_CacheHostCost *ptCost)
+{
+    printf("    %-24s %6llu us %5u reads %6u B",
+           pszName, (unsigned long long)ptCost->u64Us, ptCost->u32BusReads, ptCost->u32BusBytes);
+
+    if (ptCost->u32Erase)
+        printf(", %u erase(s) of %u us in it", ptCost->u32Erase, g_tCacheHostCfg.u32EraseUs);
+
+    printf("\n");
+}
+
+// the cold boot of MW_FIM and the reads after it, with the cache off and on
+static void _CacheHost_Fim(void)
+{
+    T_CacheHostCost taInit[2];
+    T_CacheHostCost taRead[2];
+    T_CacheHostCost taReRead[2];
+    uint32_t u32Round, g, f, r, i;
+    uint8_t u8Cache;
+
+    HOST_TEST_EQ(_CacheHost_Part(), 0);
+    _CacheHost_FimLayout();
+
+    // the first boot on a blank zone writes the group headers and the defaults
+    MwFim_PreInitCold();
+    MwFim_Init();
+    HOST_TEST_EQ(g_ubMwFimInit, 1);
+
+    // then the life of a device: every record rewritten, the old headers stay
+    for (u32Round = 1; u32Round <= CACHE_HOST_HISTORY; u32Round++)
+    {
+        for (g = 1; g <= CACHE_HOST_GROUP_NUM; g++)
+        {
+            for (f = 0; f < CACHE_HOST_FILE_NUM; f++)
+            {
+                for (r = 0; r < g_uwaCacheHostFileRec[f]; r++)
+                {
+                    _CacheHost_FimData(u32Round, g, f, r);
+                    HOST_TEST_EQ(MwFim_FileWrite(CACHE_HOST_FILE_ID(g, f), r, g_uwaCacheHostFileSize[f], g_ubaCacheHostFile), MW_FIM_OK);
+                }
+            }
+        }
+    }
+
+    for (u8Cache = 0; u8Cache <= 1; u8Cache++)
+    {
+        Hal_Flash_CacheEnable(u8Cache);
+        memset(g_ulaCacheHostAddr, 0, sizeof(g_ulaCacheHostAddr));
+
+        // the parser walks the file headers of each block, a small read each
+        MwFim_PreInitCold();
+        _CacheHost_CostStart(&taInit[u8Cache]);
+        MwFim_Init();
+        _CacheHost_CostEnd(&taInit[u8Cache]);
+        HOST_TEST_EQ(g_ubMwFimInit, 1);
+
+        // each record once, as the tasks read their configuration
+        _CacheHost_CostStart(&taRead[u8Cache]);
+        HOST_TEST_ASSERT(_CacheHost_FimRead(CACHE_HOST_HISTORY, 1, CACHE_HOST_GROUP_NUM));
+        _CacheHost_CostEnd(&taRead[u8Cache]);
+
+        // the records of one group again and again
+        _CacheHost_CostStart(&taReRead[u8Cache]);
+        for (i = 0; i < CACHE_HOST_REREAD; i++)
+            HOST_TEST_ASSERT(_CacheHost_FimRead(CACHE_HOST_HISTORY, 1, 1));
+        _CacheHost_CostEnd(&taReRead[u8Cache]);
+    }
+
+    printf("  MW_FIM, %u groups of %u files, %u writes of each record:\n",
+           CACHE_HOST_GROUP_NUM, CACHE_HOST_FILE_NUM, CACHE_HOST_HISTORY + 1);
+    for (u8Cache = 0; u8Cache <= 1; u8Cache++)
+    {
+        printf("   cache %s\n", u8Cache ? "on" : "off");
+        _CacheHost_CostPrint("MwFim_Init", &taInit[u8Cache]);
+        _CacheHost_CostPrint("every record once", &taRead[u8Cache]);
+        _CacheHost_CostPrint("one group, again", &taReRead[u8Cache]);
+    }
+
+    // one pass over small records: fewer reads, but the line fills move
+    // more bytes than they save, the boot runs MwFim_Init without the cache
+    HOST_TEST_ASSERT(taInit[1].u32BusReads < taInit[0].u32BusReads);
+    HOST_TEST_ASSERT(taInit[1].u32BusBytes > taInit[0].u32BusBytes);
+    HOST_TEST_ASSERT(taInit[1].u64Us > taInit[0].u64Us);
+
+    // the records read again come from the lines
+    HOST_TEST_ASSERT(taReRead[1].u32BusBytes < taReRead[0].u32BusBytes);
+    HOST_TEST_ASSERT((taReRead[1].u64Us * 2) < taReRead[0].u64Us);
+}
+
+static const T_HostTestCase g_taCacheHostCase[] =
+{
+    HOST_TEST_CASE(_CacheHost_Lru),
+    HOST_TEST_CASE(_CacheHost_Prefetch),
+    HOST_TEST_CASE(_CacheHost_WriteThrough),
+    HOST_TEST_CASE(_CacheHost_Bypass),
+    HOST_TEST_CASE(_CacheHost_EraseStart),
+    HOST_TEST_CASE(_CacheHost_Fim),
+};
+
+int main(void)
+{
+    HostOs_Init();
+
+    if (HostReg_Init())
+        return 1;
+
+    // the bus time only, not the time of the register traps
+    HostOs_TimeFreeze(1);
+
+    Hal_Spi_Pre_Init();
+    Hal_Flash_Pre_Init();
+
+    // the driver as peri_patch_init.c installs it
+    Hal_Flash_Init_Internal = Hal_Flash_Init_Internal_patch;
+    Hal_Flash_AddrProgram_Internal = Hal_Flash_AddrProgram_Internal_patch;
+    Hal_Flash_AddrRead_Internal = Hal_Flash_AddrRead_Internal_patch;
+    Hal_Flash_SchedInit();
+    Hal_Flash_CacheInit();
+
+    return HostTest_Run("hal_flash_cache", g_taCacheHostCase, HOST_TEST_NUM(g_taCacheHostCase));
+}
@@ -0,0 +1,306 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_flash_patch_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The read modes of hal_flash_patch.c on the ROM hal_flash.c, against the
+*  SPI flash simulator (host/host_flash) of the three vendors.
+*
+*  Every mode reads back what is in the part. AUTO picks quad I/O on SPI0
+*  only after the check of the init, which turns it off for a board whose
+*  IO2/IO3 give wrong data; the other ports follow u8UseQuadMode. The bench
+*  reads 4 KB with the ROM functions (before) and each mode of the patch
+*  (after) on the simulated bus clock.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <string.h>
+#include "opl1000.h"
+#include "hal_spi.h"
+#include "hal_flash.h"
+#include "hal_flash_internal.h"
+#include "hal_flash_patch.h"
+#include "host_flash.h"
+#include "host_os.h"
+#include "host_reg.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define FLASH_HOST_BOOT_SIZE    (0x4000)
+#define FLASH_HOST_DATA_ADDR    (0x40000)
+#define FLASH_HOST_DATA_SIZE    (0x10000)
+#define FLASH_HOST_READ_ADDR    (FLASH_HOST_DATA_ADDR + 0x123)  // not page aligned
+#define FLASH_HOST_READ_SIZE    (0x1000)
+#define FLASH_HOST_CHECK_SIZE   (16)        // HAL_FLASH_QUAD_IO_CHECK_SIZE
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+extern uint8_t g_u8aHalFlashID[SPI_IDX_MAX];
+
+// Sec 5: declaration of global function prototype
+extern uint32_t Hal_Flash_AddrRead_Internal_impl(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static const uint8_t g_u8aFlashHostVendor[] = {GIGADEVICE_ID, MACRONIX_ID, WINBOND_NEX_ID};
+static uint8_t g_u8aFlashHostBuf[FLASH_HOST_READ_SIZE];
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+uint32_t Boot_CheckWarmBoot(void)
+{
+    return 0;
+}
+
+// a part of the vendor with a boot agent and data, through Hal_Flash_Init
+static uint32_t _FlashHost_Part(const T_HostFlashCfg *ptCfg)
+{
+    uint8_t *pu8Mem;
+    uint32_t i;
+
+    if (HostFlash_Init(ptCfg))
+        return 1;
+
+    pu8Mem = HostFlash_Mem();
+    for (i = 0; i < FLASH_HOST_BOOT_SIZE; i++)
+        pu8Mem[i] = (uint8_t)(i * 7 + (i >> 8));
+    for (i = 0; i < FLASH_HOST_DATA_SIZE; i++)
+        pu8Mem[FLASH_HOST_DATA_ADDR + i] = (uint8_t)(i ^ (i >> 8) ^ 0x3C);
+
+    Hal_Flash_ReadModeSet(SPI_IDX_0, HAL_FLASH_READ_MODE_AUTO);
+    Hal_Flash_ReadStatReset(SPI_IDX_0);
+
+    return Hal_Flash_Init(SPI_IDX_0);
+}
+
+static uint32_t _FlashHost_Vendor(uint8_t u8Vendor)
+{
+    T_HostFlashCfg tCfg;
+
+    HostFlash_CfgDefault(&tCfg, u8Vendor);
+    return _FlashHost_Part(&tCfg);
+}
+
+static uint8_t _FlashHost_ReadOk(E_FlashReadMode_t eMode, uint8_t u8UseQuadMode)
+{
+    memset(g_u8aFlashHostBuf, 0, sizeof(g_u8aFlashHostBuf));
+    Hal_Flash_ReadModeSet(SPI_IDX_0, eMode);
+
+    if (Hal_Flash_AddrRead(SPI_IDX_0, FLASH_HOST_READ_ADDR, u8UseQuadMode, FLASH_HOST_READ_SIZE, g_u8aFlashHostBuf))
+        return 0;
+
+    return (0 == memcmp(g_u8aFlashHostBuf, HostFlash_Mem() + FLASH_HOST_READ_ADDR, FLASH_HOST_READ_SIZE));
+}
+
+static void _FlashHost_Modes(void)
+{
+    T_HostFlashStat tStat;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(g_u8aFlashHostVendor); i++)
+    {
+        HOST_TEST_EQ(_FlashHost_Vendor(g_u8aFlashHostVendor[i]), 0);
+        HOST_TEST_EQ(g_u8aHalFlashID[SPI_IDX_0], g_u8aFlashHostVendor[i]);
+        HostFlash_StatReset();
+
+        HOST_TEST_ASSERT(_FlashHost_ReadOk(HAL_FLASH_READ_MODE_FAST, 0));
+        HOST_TEST_ASSERT(_FlashHost_ReadOk(HAL_FLASH_READ_MODE_QUAD_OUT, 0));
+        HOST_TEST_ASSERT(_FlashHost_ReadOk(HAL_FLASH_READ_MODE_QUAD_IO, 0));
+        HOST_TEST_ASSERT(_FlashHost_ReadOk(HAL_FLASH_READ_MODE_AUTO, 0));
+        HOST_TEST_EQ(Hal_Flash_ReadModeGet(SPI_IDX_0, 0), HAL_FLASH_READ_MODE_QUAD_IO);
+
+        HostFlash_StatGet(&tStat);
+        HOST_TEST_EQ(tStat.u32BadRead, 0);
+        HOST_TEST_EQ(tStat.u32Ignored, 0);
+        HOST_TEST_ASSERT(tStat.u32aCmd[0x0B] > 0);
+        HOST_TEST_ASSERT(tStat.u32aCmd[0x6B] > 0);
+        HOST_TEST_ASSERT(tStat.u32aCmd[0xEB] > 0);
+    }
+}
+
+// IO2/IO3 not wired: the part answers a quad read with wrong data, no timeout
+static void _FlashHost_QuadBroken(void)
+{
+    T_HostFlashCfg tCfg;
+    S_FlashReadStat_t tRead;
+    T_HostFlashStat tStat;
+
+    HostFlash_CfgDefault(&tCfg, GIGADEVICE_ID);
+    tCfg.u8QuadBroken = 1;
+    HOST_TEST_EQ(_FlashHost_Part(&tCfg), 0);
+
+    // the init compared 0xEB with 0x0B and did not take it
+    HOST_TEST_EQ(Hal_Flash_ReadModeGet(SPI_IDX_0, 0), HAL_FLASH_READ_MODE_FAST);
+    HostFlash_StatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32aCmd[0xEB], 1);
+
+    // set again, checked again on the first read
+    HostFlash_StatReset();
+    HOST_TEST_ASSERT(_FlashHost_ReadOk(HAL_FLASH_READ_MODE_AUTO, 0));
+    HostFlash_StatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32BadRead, FLASH_HOST_CHECK_SIZE);
+
+    // forced, it reads wrong data and the timeout fallback never sees it
+    HOST_TEST_ASSERT(!_FlashHost_ReadOk(HAL_FLASH_READ_MODE_QUAD_IO, 0));
+    Hal_Flash_ReadStatGet(SPI_IDX_0, &tRead);
+    HOST_TEST_EQ(tRead.u32Fallback, 0);
+}
+
+// blank where the boot agent should be: floating lines could pass, not used
+static void _FlashHost_Blank(void)
+{
+    T_HostFlashCfg tCfg;
+
+    HostFlash_CfgDefault(&tCfg, WINBOND_NEX_ID);
+    HOST_TEST_EQ(HostFlash_Init(&tCfg), 0);
+    Hal_Flash_ReadModeSet(SPI_IDX_0, HAL_FLASH_READ_MODE_AUTO);
+    HOST_TEST_EQ(Hal_Flash_Init(SPI_IDX_0), 0);
+
+    HOST_TEST_EQ(Hal_Flash_ReadModeGet(SPI_IDX_0, 0), HAL_FLASH_READ_MODE_FAST);
+    HOST_TEST_EQ(Hal_Flash_ReadModeGet(SPI_IDX_0, 1), HAL_FLASH_READ_MODE_QUAD_OUT);
+}
+
+// SPI1/SPI2 are not checked: AUTO follows the caller, no SPI0 traffic
+static void _FlashHost_OtherPorts(void)
+{
+    T_HostFlashStat tStat;
+    uint8_t u8Id = g_u8aHalFlashID[SPI_IDX_1];
+
+    HOST_TEST_EQ(_FlashHost_Vendor(MACRONIX_ID), 0);
+    HostFlash_StatReset();
+
+    g_u8aHalFlashID[SPI_IDX_1] = MACRONIX_ID;
+    Hal_Flash_ReadModeSet(SPI_IDX_1, HAL_FLASH_READ_MODE_AUTO);
+    Hal_Flash_ReadModeSet(SPI_IDX_2, HAL_FLASH_READ_MODE_AUTO);
+
+    HOST_TEST_EQ(Hal_Flash_ReadModeGet(SPI_IDX_1, 0), HAL_FLASH_READ_MODE_FAST);
+    HOST_TEST_EQ(Hal_Flash_ReadModeGet(SPI_IDX_1, 1), HAL_FLASH_READ_MODE_QUAD_OUT);
+    HOST_TEST_EQ(Hal_Flash_ReadModeGet(SPI_IDX_2, 0), HAL_FLASH_READ_MODE_FAST);
+    HOST_TEST_EQ(Hal_Flash_ReadModeGet(SPI_IDX_2, 1), HAL_FLASH_READ_MODE_QUAD_OUT);
+
+    // a mode set by hand is kept
+    Hal_Flash_ReadModeSet(SPI_IDX_1, HAL_FLASH_READ_MODE_QUAD_IO);
+    HOST_TEST_EQ(Hal_Flash_ReadModeGet(SPI_IDX_1, 0), HAL_FLASH_READ_MODE_QUAD_IO);
+    Hal_Flash_ReadModeSet(SPI_IDX_1, HAL_FLASH_READ_MODE_AUTO);
+    g_u8aHalFlashID[SPI_IDX_1] = u8Id;
+
+    HostFlash_StatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Frames, 0);
+}
+
+static uint64_t _FlashHost_Time(uint32_t (*fpRead)(E_SpiIdx_t, uint32_t, uint8_t, uint32_t, uint8_t *), uint8_t u8UseQuadMode)
+{
+    uint64_t u64Start;
+
+    memset(g_u8aFlashHostBuf, 0, sizeof(g_u8aFlashHostBuf));
+    u64Start = HostOs_TimeUs();
+
+    if (fpRead(SPI_IDX_0, FLASH_HOST_DATA_ADDR, u8UseQuadMode, FLASH_HOST_READ_SIZE, g_u8aFlashHostBuf))
+        return 0;
+    if (memcmp(g_u8aFlashHostBuf, HostFlash_Mem() + FLASH_HOST_DATA_ADDR, FLASH_HOST_READ_SIZE))
+        return 0;
+
+    return HostOs_TimeUs() - u64Start;
+}
+
+static uint64_t _FlashHost_TimeMode(E_FlashReadMode_t eMode)
+{
+    Hal_Flash_ReadModeSet(SPI_IDX_0, eMode);
+    return _FlashHost_Time(Hal_Flash_AddrRead_Internal_patch, 0);
+}
+
+static void _FlashHost_Bench(void)
+{
+    const char *saName[] = {"ROM 0x0B", "ROM 0x6B", "FAST 0x0B", "QUAD_OUT 0x6B", "QUAD_IO 0xEB"};
+    uint64_t u64aUs[5];
+    uint32_t i;
+
+    HOST_TEST_EQ(_FlashHost_Vendor(GIGADEVICE_ID), 0);
+
+    u64aUs[0] = _FlashHost_Time(Hal_Flash_AddrRead_Internal_impl, 0);
+    u64aUs[1] = _FlashHost_Time(Hal_Flash_AddrRead_Internal_impl, 1);
+    u64aUs[2] = _FlashHost_TimeMode(HAL_FLASH_READ_MODE_FAST);
+    u64aUs[3] = _FlashHost_TimeMode(HAL_FLASH_READ_MODE_QUAD_OUT);
+    u64aUs[4] = _FlashHost_TimeMode(HAL_FLASH_READ_MODE_QUAD_IO);
+    Hal_Flash_ReadModeSet(SPI_IDX_0, HAL_FLASH_READ_MODE_AUTO);
+
+    printf("  4 KB read, SCLK 20 MHz:\n");
+    for (i = 0; i < 5; i++)
+    {
+        HOST_TEST_ASSERT(u64aUs[i] != 0);
+        printf("    %-14s %6llu us %6.2f MB/s\n", saName[i], (unsigned long long)u64aUs[i],
+               (double)FLASH_HOST_READ_SIZE / (double)u64aUs[i]);
+    }
+
+    // streamed beats the byte per round trip of the ROM, 4 lanes beat 1
+    HOST_TEST_ASSERT(u64aUs[2] < u64aUs[0]);
+    HOST_TEST_ASSERT(u64aUs[3] < u64aUs[1]);
+    HOST_TEST_ASSERT(u64aUs[3] < u64aUs[2]);
+    HOST_TEST_ASSERT(u64aUs[4] <= u64aUs[3]);
+}
+
+static const T_HostTestCase g_taFlashHostCase[] =
+{
+    HOST_TEST_CASE(_FlashHost_Modes),
+    HOST_TEST_CASE(_FlashHost_QuadBroken),
+    HOST_TEST_CASE(_FlashHost_Blank),
+    HOST_TEST_CASE(_FlashHost_OtherPorts),
+    HOST_TEST_CASE(_FlashHost_Bench),
+};
+
+int main(void)
+{
+    HostOs_Init();
+
+    if (HostReg_Init())
+        return 1;
+
+    // the bus time only, not the time of the register traps
+    HostOs_TimeFreeze(1);
+
+    Hal_Spi_Pre_Init();
+    Hal_Flash_Pre_Init();
+
+    // the driver as peri_patch_init.c installs it, without the scheduler and the cache
+    Hal_Flash_Init_Internal = Hal_Flash_Init_Internal_patch;
+    Hal_Flash_AddrProgram_Internal = Hal_Flash_AddrProgram_Internal_patch;
+    Hal_Flash_AddrRead_Internal = Hal_Flash_AddrRead_Internal_patch;
+
+    return HostTest_Run("hal_flash_patch", g_taFlashHostCase, HOST_TEST_NUM(g_taFlashHostCase));
+}
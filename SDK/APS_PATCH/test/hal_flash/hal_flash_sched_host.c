@@ -0,0 +1,393 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_flash_sched_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The background erase of hal_flash_sched.c on the ROM hal_flash.c and
+*  hal_flash_patch.c, against the SPI flash simulator (host/host_flash).
+*
+*  The simulator takes only the suspend/resume opcodes of its vendor, keeps
+*  WIP set for the erase time of the bus clock and answers a read of the
+*  sector under a suspended erase, or any read while busy, with garbage. The
+*  cases check the opcodes per vendor, the suspend budget per erase, the
+*  reads of the erased sector, EraseStart/EraseBusy/EraseWait and the
+*  operations that wait the erase out. The cache is not installed.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <string.h>
+#include "opl1000.h"
+#include "hal_spi.h"
+#include "hal_flash.h"
+#include "hal_flash_internal.h"
+#include "hal_flash_patch.h"
+#include "hal_flash_sched.h"
+#include "host_flash.h"
+#include "host_os.h"
+#include "host_reg.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SCHED_HOST_BOOT_SIZE    (0x1000)
+#define SCHED_HOST_DATA_ADDR    (0x40000)   // read while the erase runs
+#define SCHED_HOST_ERASE_ADDR   (0x50000)   // erased in the background
+#define SCHED_HOST_PROG_ADDR    (0x60000)
+#define SCHED_HOST_READ_SIZE    (64)
+#define SCHED_HOST_VENDOR_OTHER (0x1C)      // known to the ROM, no suspend commands
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_HostFlashCfg g_tSchedHostCfg;
+static uint8_t g_u8aSchedHostBuf[SCHED_HOST_READ_SIZE];
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+uint32_t Boot_CheckWarmBoot(void)
+{
+    return 0;
+}
+
+// a part of the vendor, the boot agent and two sectors of data
+static uint32_t _SchedHost_Part(uint8_t u8Vendor)
+{
+    uint8_t *pu8Mem;
+    uint32_t i;
+
+    HostFlash_CfgDefault(&g_tSchedHostCfg, u8Vendor);
+    if (HostFlash_Init(&g_tSchedHostCfg))
+        return 1;
+
+    pu8Mem = HostFlash_Mem();
+    for (i = 0; i < SCHED_HOST_BOOT_SIZE; i++)
+        pu8Mem[i] = (uint8_t)(i * 3 + 1);
+    for (i = 0; i < HOST_FLASH_SECTOR_SIZE; i++)
+    {
+        pu8Mem[SCHED_HOST_DATA_ADDR + i] = (uint8_t)(i ^ 0x5A);
+        pu8Mem[SCHED_HOST_ERASE_ADDR + i] = (uint8_t)(i ^ 0xC3);
+    }
+
+    Hal_Flash_ReadModeSet(SPI_IDX_0, HAL_FLASH_READ_MODE_AUTO);
+    if (Hal_Flash_Init(SPI_IDX_0))
+        return 1;
+
+    HostFlash_StatReset();
+    Hal_Flash_SchedStatReset();
+    return 0;
+}
+
+static uint8_t _SchedHost_ReadOk(uint32_t u32Addr)
+{
+    memset(g_u8aSchedHostBuf, 0, sizeof(g_u8aSchedHostBuf));
+
+    if (Hal_Flash_AddrRead(SPI_IDX_0, u32Addr, 0, SCHED_HOST_READ_SIZE, g_u8aSchedHostBuf))
+        return 0;
+
+    return (0 == memcmp(g_u8aSchedHostBuf, HostFlash_Mem() + u32Addr, SCHED_HOST_READ_SIZE));
+}
+
+static uint8_t _SchedHost_Erased(uint32_t u32Addr)
+{
+    uint8_t *pu8Mem = HostFlash_Mem() + u32Addr;
+    uint32_t i;
+
+    for (i = 0; i < HOST_FLASH_SECTOR_SIZE; i++)
+    {
+        if (pu8Mem[i] != 0xFF)
+            return 0;
+    }
+
+    return 1;
+}
+
+// each vendor gets its own suspend/resume pair, the part takes all of them
+static void _SchedHost_Vendor(void)
+{
+    const uint8_t u8aVendor[] = {MACRONIX_ID, GIGADEVICE_ID, WINBOND_NEX_ID};
+    S_FlashSchedStat_t tSched;
+    T_HostFlashStat tStat;
+    uint8_t u8IsMx;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(u8aVendor); i++)
+    {
+        u8IsMx = (u8aVendor[i] == MACRONIX_ID);
+        HOST_TEST_EQ(_SchedHost_Part(u8aVendor[i]), 0);
+
+        HOST_TEST_EQ(Hal_Flash_EraseStart(SPI_IDX_0, SCHED_HOST_ERASE_ADDR), 0);
+        HOST_TEST_ASSERT(HostFlash_Busy());
+
+        HOST_TEST_ASSERT(_SchedHost_ReadOk(SCHED_HOST_DATA_ADDR));
+        HOST_TEST_EQ(HostFlash_SuspendedAddr(), 0xFFFFFFFF);  // resumed
+        HOST_TEST_ASSERT(HostFlash_Busy());
+
+        HostFlash_StatGet(&tStat);
+        HOST_TEST_EQ(tStat.u32aCmd[0xB0], u8IsMx);
+        HOST_TEST_EQ(tStat.u32aCmd[0x30], u8IsMx);
+        HOST_TEST_EQ(tStat.u32aCmd[0x75], !u8IsMx);
+        HOST_TEST_EQ(tStat.u32aCmd[0x7A], !u8IsMx);
+        HOST_TEST_EQ(tStat.u32Suspend, 1);
+        HOST_TEST_EQ(tStat.u32Ignored, 0);
+        HOST_TEST_EQ(tStat.u32BadRead, 0);
+
+        Hal_Flash_EraseWait(SPI_IDX_0);
+        HOST_TEST_ASSERT(!HostFlash_Busy());
+        HOST_TEST_ASSERT(_SchedHost_Erased(SCHED_HOST_ERASE_ADDR));
+
+        Hal_Flash_SchedStatGet(&tSched);
+        HOST_TEST_EQ(tSched.u32Suspend, 1);
+        HOST_TEST_EQ(tSched.u32SuspendSkip, 0);
+        HOST_TEST_EQ(tSched.taOp[HAL_FLASH_OP_SUSPEND].u32Count, 1);
+        HOST_TEST_EQ(tSched.taOp[HAL_FLASH_OP_ERASE_BG].u32Count, 1);
+    }
+}
+
+// a part the scheduler has no suspend pair for: the read waits the erase out
+static void _SchedHost_VendorOther(void)
+{
+    S_FlashSchedStat_t tSched;
+    T_HostFlashStat tStat;
+
+    HOST_TEST_EQ(_SchedHost_Part(SCHED_HOST_VENDOR_OTHER), 0);
+    HOST_TEST_EQ(Hal_Flash_EraseStart(SPI_IDX_0, SCHED_HOST_ERASE_ADDR), 0);
+
+    HOST_TEST_ASSERT(_SchedHost_ReadOk(SCHED_HOST_DATA_ADDR));
+    HOST_TEST_ASSERT(!HostFlash_Busy());
+    HOST_TEST_ASSERT(_SchedHost_Erased(SCHED_HOST_ERASE_ADDR));
+
+    HostFlash_StatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Suspend, 0);
+    HOST_TEST_EQ(tStat.u32Ignored, 0);
+    Hal_Flash_SchedStatGet(&tSched);
+    HOST_TEST_EQ(tSched.u32SuspendSkip, 1);
+    HOST_TEST_EQ(tSched.u32EraseWait, 1);
+}
+
+// HAL_FLASH_SCHED_SUSPEND_MAX reads suspend, the next one waits the erase out
+static void _SchedHost_SuspendMax(void)
+{
+    S_FlashSchedStat_t tSched;
+    T_HostFlashStat tStat;
+    uint32_t i;
+
+    HOST_TEST_EQ(_SchedHost_Part(GIGADEVICE_ID), 0);
+    HOST_TEST_EQ(Hal_Flash_EraseStart(SPI_IDX_0, SCHED_HOST_ERASE_ADDR), 0);
+
+    for (i = 0; i < HAL_FLASH_SCHED_SUSPEND_MAX; i++)
+    {
+        HOST_TEST_ASSERT(_SchedHost_ReadOk(SCHED_HOST_DATA_ADDR + i * SCHED_HOST_READ_SIZE));
+        HOST_TEST_ASSERT(HostFlash_Busy());
+    }
+
+    HOST_TEST_ASSERT(_SchedHost_ReadOk(SCHED_HOST_DATA_ADDR));
+    HOST_TEST_ASSERT(!HostFlash_Busy());
+    HOST_TEST_ASSERT(_SchedHost_ReadOk(SCHED_HOST_DATA_ADDR));
+
+    HostFlash_StatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Suspend, HAL_FLASH_SCHED_SUSPEND_MAX);
+    HOST_TEST_EQ(tStat.u32BadRead, 0);
+    HOST_TEST_EQ(tStat.u32EraseDone, 1);
+
+    Hal_Flash_SchedStatGet(&tSched);
+    HOST_TEST_EQ(tSched.u32Suspend, HAL_FLASH_SCHED_SUSPEND_MAX);
+    HOST_TEST_EQ(tSched.u32SuspendSkip, 1);
+    HOST_TEST_EQ(tSched.u32EraseWait, 1);
+
+    // the budget is per erase
+    HOST_TEST_EQ(Hal_Flash_EraseStart(SPI_IDX_0, SCHED_HOST_ERASE_ADDR), 0);
+    HOST_TEST_ASSERT(_SchedHost_ReadOk(SCHED_HOST_DATA_ADDR));
+    Hal_Flash_SchedStatGet(&tSched);
+    HOST_TEST_EQ(tSched.u32Suspend, HAL_FLASH_SCHED_SUSPEND_MAX + 1);
+    Hal_Flash_EraseWait(SPI_IDX_0);
+}
+
+// a read of the sector being erased gets the erased content, never a suspend
+static void _SchedHost_SameSector(void)
+{
+    S_FlashSchedStat_t tSched;
+    T_HostFlashStat tStat;
+    uint32_t i;
+
+    HOST_TEST_EQ(_SchedHost_Part(WINBOND_NEX_ID), 0);
+    HOST_TEST_EQ(Hal_Flash_EraseStart(SPI_IDX_0, SCHED_HOST_ERASE_ADDR + 0x234), 0);
+
+    // also a read that only overlaps the sector at its start
+    memset(g_u8aSchedHostBuf, 0, sizeof(g_u8aSchedHostBuf));
+    HOST_TEST_EQ(Hal_Flash_AddrRead(SPI_IDX_0, SCHED_HOST_ERASE_ADDR - 16, 0, SCHED_HOST_READ_SIZE, g_u8aSchedHostBuf), 0);
+    HOST_TEST_ASSERT(!HostFlash_Busy());
+
+    for (i = 16; i < SCHED_HOST_READ_SIZE; i++)
+        HOST_TEST_EQ(g_u8aSchedHostBuf[i], 0xFF);
+    HOST_TEST_ASSERT(_SchedHost_Erased(SCHED_HOST_ERASE_ADDR));
+
+    HostFlash_StatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Suspend, 0);
+    HOST_TEST_EQ(tStat.u32BadRead, 0);
+
+    Hal_Flash_SchedStatGet(&tSched);
+    HOST_TEST_EQ(tSched.u32Suspend, 0);
+    HOST_TEST_EQ(tSched.u32EraseWait, 1);
+}
+
+// EraseBusy follows WIP, a second EraseStart is refused until the first ends
+static void _SchedHost_BusyWait(void)
+{
+    S_FlashSchedStat_t tSched;
+
+    HOST_TEST_EQ(_SchedHost_Part(MACRONIX_ID), 0);
+    HOST_TEST_EQ(Hal_Flash_EraseBusy(SPI_IDX_0), 0);
+
+    HOST_TEST_EQ(Hal_Flash_EraseStart(SPI_IDX_0, SCHED_HOST_ERASE_ADDR), 0);
+    HOST_TEST_EQ(Hal_Flash_EraseStart(SPI_IDX_0, SCHED_HOST_DATA_ADDR), 1);
+    HOST_TEST_EQ(Hal_Flash_EraseBusy(SPI_IDX_0), 1);
+
+    HostOs_TimeAdvanceUs(g_tSchedHostCfg.u32EraseUs);
+    HOST_TEST_EQ(Hal_Flash_EraseBusy(SPI_IDX_0), 0);
+    HOST_TEST_ASSERT(_SchedHost_Erased(SCHED_HOST_ERASE_ADDR));
+
+    Hal_Flash_SchedStatGet(&tSched);
+    HOST_TEST_EQ(tSched.taOp[HAL_FLASH_OP_ERASE_BG].u32Count, 1);
+    HOST_TEST_ASSERT(tSched.taOp[HAL_FLASH_OP_ERASE_BG].u32TotalUs >= g_tSchedHostCfg.u32EraseUs);
+    HOST_TEST_EQ(tSched.u32EraseWait, 0);
+
+    // EraseWait returns with the part idle
+    HOST_TEST_EQ(Hal_Flash_EraseStart(SPI_IDX_0, SCHED_HOST_DATA_ADDR), 0);
+    Hal_Flash_EraseWait(SPI_IDX_0);
+    HOST_TEST_ASSERT(!HostFlash_Busy());
+    HOST_TEST_EQ(Hal_Flash_EraseBusy(SPI_IDX_0), 0);
+    HOST_TEST_ASSERT(_SchedHost_Erased(SCHED_HOST_DATA_ADDR));
+}
+
+// a program or a blocking erase waits the background erase out, none is dropped
+static void _SchedHost_WriteWaits(void)
+{
+    uint8_t u8aData[SCHED_HOST_READ_SIZE];
+    S_FlashSchedStat_t tSched;
+    T_HostFlashStat tStat;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(u8aData); i++)
+        u8aData[i] = (uint8_t)(0xA0 + i);
+
+    HOST_TEST_EQ(_SchedHost_Part(GIGADEVICE_ID), 0);
+
+    HOST_TEST_EQ(Hal_Flash_EraseStart(SPI_IDX_0, SCHED_HOST_ERASE_ADDR), 0);
+    HOST_TEST_EQ(Hal_Flash_AddrProgram(SPI_IDX_0, SCHED_HOST_PROG_ADDR, 0, sizeof(u8aData), u8aData), 0);
+    HOST_TEST_ASSERT(_SchedHost_Erased(SCHED_HOST_ERASE_ADDR));
+    HOST_TEST_EQ(memcmp(HostFlash_Mem() + SCHED_HOST_PROG_ADDR, u8aData, sizeof(u8aData)), 0);
+
+    HOST_TEST_EQ(Hal_Flash_EraseStart(SPI_IDX_0, SCHED_HOST_ERASE_ADDR), 0);
+    HOST_TEST_EQ(Hal_Flash_4KSectorAddrErase(SPI_IDX_0, SCHED_HOST_DATA_ADDR), 0);
+    HOST_TEST_ASSERT(_SchedHost_Erased(SCHED_HOST_DATA_ADDR));
+
+    HostFlash_StatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Ignored, 0);
+    HOST_TEST_EQ(tStat.u32EraseDone, 3);
+
+    Hal_Flash_SchedStatGet(&tSched);
+    HOST_TEST_EQ(tSched.u32EraseWait, 2);
+}
+
+// read latency while a sector erase runs: suspended against waited out
+static void _SchedHost_Latency(void)
+{
+    S_FlashSchedStat_t tSched;
+    uint64_t u64Start;
+    uint64_t u64Suspend;
+    uint64_t u64Wait;
+
+    HOST_TEST_EQ(_SchedHost_Part(GIGADEVICE_ID), 0);
+
+    HOST_TEST_EQ(Hal_Flash_EraseStart(SPI_IDX_0, SCHED_HOST_ERASE_ADDR), 0);
+    u64Start = HostOs_TimeUs();
+    HOST_TEST_ASSERT(_SchedHost_ReadOk(SCHED_HOST_DATA_ADDR));
+    u64Suspend = HostOs_TimeUs() - u64Start;
+    Hal_Flash_EraseWait(SPI_IDX_0);
+
+    // the same read as the scheduler without a suspend pair does it
+    HOST_TEST_EQ(_SchedHost_Part(SCHED_HOST_VENDOR_OTHER), 0);
+    HOST_TEST_EQ(Hal_Flash_EraseStart(SPI_IDX_0, SCHED_HOST_ERASE_ADDR), 0);
+    u64Start = HostOs_TimeUs();
+    HOST_TEST_ASSERT(_SchedHost_ReadOk(SCHED_HOST_DATA_ADDR));
+    u64Wait = HostOs_TimeUs() - u64Start;
+
+    Hal_Flash_SchedStatGet(&tSched);
+    printf("  %u B read during a %u us erase: suspended %llu us, waited %llu us\n",
+           SCHED_HOST_READ_SIZE, g_tSchedHostCfg.u32EraseUs, (unsigned long long)u64Suspend, (unsigned long long)u64Wait);
+
+    HOST_TEST_ASSERT(u64Suspend < 500);
+    HOST_TEST_ASSERT(u64Wait >= g_tSchedHostCfg.u32EraseUs - 100);
+}
+
+static const T_HostTestCase g_taSchedHostCase[] =
+{
+    HOST_TEST_CASE(_SchedHost_Vendor),
+    HOST_TEST_CASE(_SchedHost_VendorOther),
+    HOST_TEST_CASE(_SchedHost_SuspendMax),
+    HOST_TEST_CASE(_SchedHost_SameSector),
+    HOST_TEST_CASE(_SchedHost_BusyWait),
+    HOST_TEST_CASE(_SchedHost_WriteWaits),
+    HOST_TEST_CASE(_SchedHost_Latency),
+};
+
+int main(void)
+{
+    HostOs_Init();
+
+    if (HostReg_Init())
+        return 1;
+
+    // the bus time only, not the time of the register traps
+    HostOs_TimeFreeze(1);
+
+    Hal_Spi_Pre_Init();
+    Hal_Flash_Pre_Init();
+
+    // the driver as peri_patch_init.c installs it, without the cache
+    Hal_Flash_Init_Internal = Hal_Flash_Init_Internal_patch;
+    Hal_Flash_AddrProgram_Internal = Hal_Flash_AddrProgram_Internal_patch;
+    Hal_Flash_AddrRead_Internal = Hal_Flash_AddrRead_Internal_patch;
+    Hal_Flash_SchedInit();
+
+    return HostTest_Run("hal_flash_sched", g_taSchedHostCase, HOST_TEST_NUM(g_taSchedHostCase));
+}
@@ -0,0 +1,744 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_i2c_master_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  Queued transactions of hal_i2c_master.c against a register model of the
+*  DW_apb_i2c controller and the devices on its bus.
+*
+*  Every command written to DATA_CMD is put on the bus at once: a START or
+*  RESTART addresses the device of TAR, the first byte written after a
+*  START sets its register pointer, writes and reads go through it, STOP
+*  ends the transaction. Missing devices, data NACKs and arbitration loss
+*  raise TX_ABRT with the source the controller would report; a stalled
+*  bus (SCL held low) leaves the commands in the TX FIFO. A module reset
+*  through Hal_Sys_ApsModuleRst clears the controller.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <pthread.h>
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "hal_system.h"
+#include "hal_vic.h"
+#include "hal_i2c.h"
+#include "hal_i2c_master.h"
+#include "host_os.h"
+#include "host_reg.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define I2C_HOST_CON            (I2C_BASE + 0x00)
+#define I2C_HOST_TAR            (I2C_BASE + 0x04)
+#define I2C_HOST_DATA_CMD       (I2C_BASE + 0x10)
+#define I2C_HOST_INTR_STAT      (I2C_BASE + 0x2C)
+#define I2C_HOST_INTR_MASK      (I2C_BASE + 0x30)
+#define I2C_HOST_RAW_INTR       (I2C_BASE + 0x34)
+#define I2C_HOST_RX_TL          (I2C_BASE + 0x38)
+#define I2C_HOST_TX_TL          (I2C_BASE + 0x3C)
+#define I2C_HOST_CIR_INTR       (I2C_BASE + 0x40)
+#define I2C_HOST_CLR_TX_ABRT    (I2C_BASE + 0x54)
+#define I2C_HOST_CLR_STOP_DET   (I2C_BASE + 0x60)
+#define I2C_HOST_ENABLE         (I2C_BASE + 0x6C)
+#define I2C_HOST_STATUS         (I2C_BASE + 0x70)
+#define I2C_HOST_TXFLR          (I2C_BASE + 0x74)
+#define I2C_HOST_RXFLR          (I2C_BASE + 0x78)
+#define I2C_HOST_ABRT_SOURCE    (I2C_BASE + 0x80)
+#define I2C_HOST_ENABLE_STATUS  (I2C_BASE + 0x9C)
+#define I2C_HOST_REG_END        (I2C_BASE + 0x100)
+
+#define I2C_HOST_CMD_READ       (1<<8)
+#define I2C_HOST_CMD_STOP       (1<<9)
+#define I2C_HOST_CMD_RESTART    (1<<10)
+#define I2C_HOST_TAR_10BIT      (1<<12)
+#define I2C_HOST_CON_SPEED      (3<<1)
+#define I2C_HOST_STATUS_TFNF    (1<<1)
+
+#define I2C_HOST_INT_RX_OVER    (1<<1)
+#define I2C_HOST_INT_RX_FULL    (1<<2)
+#define I2C_HOST_INT_TX_EMPTY   (1<<4)
+#define I2C_HOST_INT_TX_ABRT    (1<<6)
+#define I2C_HOST_INT_STOP_DET   (1<<9)
+
+#define I2C_HOST_ABRT_7B_NOACK  (1<<0)
+#define I2C_HOST_ABRT_10B_NOACK (1<<1)
+#define I2C_HOST_ABRT_DATA_NOACK (1<<3)
+#define I2C_HOST_ABRT_ARB_LOST  (1<<12)
+
+#define I2C_HOST_FIFO_DEPTH     (8)
+#define I2C_HOST_SLAVE_NUM      (2)
+#define I2C_HOST_LOG_MAX        (64)
+#define I2C_HOST_XFER_MAX       (8)
+#define I2C_HOST_NVIC_ISER      (0xE000E100)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    uint16_t u16Addr;
+    uint8_t u8Is10;
+    uint8_t u8Ptr;
+    uint8_t u8aReg[256];
+    int32_t s32NackByte;            // NACK this written byte of a transaction, -1: none
+} T_I2cHostSlave;
+
+typedef struct
+{
+    uint32_t u32Tar;
+    uint32_t u32Con;
+    uint8_t u8Read;
+    uint8_t u8Restart;
+} T_I2cHostAddr;
+
+typedef struct
+{
+    uint32_t u32aTx[I2C_HOST_FIFO_DEPTH];
+    uint32_t u32TxNum;
+    uint32_t u32aRx[I2C_HOST_FIFO_DEPTH];
+    uint32_t u32RxHead;
+    uint32_t u32RxNum;
+    uint32_t u32Raw;                // TX_ABRT, STOP_DET and RX_OVER until cleared
+
+    // the transaction on the bus
+    T_I2cHostSlave *ptSlave;
+    uint8_t u8InXfer;
+    uint8_t u8First;
+    uint32_t u32WrIdx;
+
+    // injected
+    uint8_t u8Stall;
+    uint8_t u8ArbLost;
+
+    T_I2cHostSlave taSlave[I2C_HOST_SLAVE_NUM];
+    T_I2cHostAddr taAddr[I2C_HOST_LOG_MAX];
+    uint32_t u32AddrNum;
+    uint32_t u32Stops;
+    uint32_t u32Resets;
+    uint32_t u32RxOverrun;
+} T_I2cHostBus;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_I2cHostBus g_tI2cHostBus;
+static volatile uint8_t g_u8I2cHostExit;
+static T_Hal_Sys_ApsModuleRst g_fpI2cHostModuleRst;
+static volatile uint32_t g_u32I2cHostSlaveIrqs;
+
+static S_I2cXfer_t *g_ptaI2cHostDone[I2C_HOST_XFER_MAX];
+static volatile uint32_t g_u32I2cHostDoneNum;
+
+static const S_I2cDev_t g_tI2cHostDevEeprom = { 0x50, I2C_07BIT, I2C_SPEED_STANDARD };
+static const S_I2cDev_t g_tI2cHostDevSensor = { 0x2A1, I2C_10BIT, I2C_SPEED_FAST };
+static const S_I2cDev_t g_tI2cHostDevAbsent = { 0x33, I2C_07BIT, I2C_SPEED_STANDARD };
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static T_I2cHostSlave *_I2cHost_SlaveFind(uint32_t u32Tar)
+{
+    uint32_t i;
+
+    for (i = 0; i < I2C_HOST_SLAVE_NUM; i++)
+    {
+        T_I2cHostSlave *ptSlave = &g_tI2cHostBus.taSlave[i];
+
+        if ((ptSlave->u16Addr == (u32Tar & 0x3FF)) && (ptSlave->u8Is10 == !!(u32Tar & I2C_HOST_TAR_10BIT)))
+            return ptSlave;
+    }
+
+    return NULL;
+}
+
+// the controller flushes the TX FIFO and, unless it lost the bus, sends STOP
+static void _I2cHost_Abort(uint32_t u32Src)
+{
+    T_I2cHostBus *ptBus = &g_tI2cHostBus;
+
+    HostReg_Set(I2C_HOST_ABRT_SOURCE, u32Src);
+    ptBus->u32Raw |= I2C_HOST_INT_TX_ABRT;
+    ptBus->u32TxNum = 0;
+    ptBus->u8InXfer = 0;
+
+    if (!(u32Src & I2C_HOST_ABRT_ARB_LOST))
+    {
+        ptBus->u32Raw |= I2C_HOST_INT_STOP_DET;
+        ptBus->u32Stops++;
+    }
+}
+
+static void _I2cHost_Cmd(uint32_t u32Cmd)
+{
+    T_I2cHostBus *ptBus = &g_tI2cHostBus;
+    uint32_t u32Tar = HostReg_Get(I2C_HOST_TAR);
+
+    if ((!ptBus->u8InXfer) || (u32Cmd & I2C_HOST_CMD_RESTART))
+    {
+        if (ptBus->u32AddrNum < I2C_HOST_LOG_MAX)
+        {
+            ptBus->taAddr[ptBus->u32AddrNum].u32Tar = u32Tar;
+            ptBus->taAddr[ptBus->u32AddrNum].u32Con = HostReg_Get(I2C_HOST_CON);
+            ptBus->taAddr[ptBus->u32AddrNum].u8Read = !!(u32Cmd & I2C_HOST_CMD_READ);
+            ptBus->taAddr[ptBus->u32AddrNum].u8Restart = ptBus->u8InXfer;
+            ptBus->u32AddrNum++;
+        }
+
+        if (ptBus->u8ArbLost)
+        {
+            ptBus->u8ArbLost = 0;
+            _I2cHost_Abort(I2C_HOST_ABRT_ARB_LOST);
+            return;
+        }
+
+        ptBus->ptSlave = _I2cHost_SlaveFind(u32Tar);
+        if (ptBus->ptSlave == NULL)
+        {
+            _I2cHost_Abort((u32Tar & I2C_HOST_TAR_10BIT) ? I2C_HOST_ABRT_10B_NOACK : I2C_HOST_ABRT_7B_NOACK);
+            return;
+        }
+
+        if (!ptBus->u8InXfer)
+        {
+            ptBus->u8First = 1;
+            ptBus->u32WrIdx = 0;
+        }
+        ptBus->u8InXfer = 1;
+    }
+
+    if (u32Cmd & I2C_HOST_CMD_READ)
+    {
+        if (ptBus->u32RxNum >= I2C_HOST_FIFO_DEPTH)
+        {
+            ptBus->u32Raw |= I2C_HOST_INT_RX_OVER;
+            ptBus->u32RxOverrun++;
+        }
+        else
+        {
+            ptBus->u32aRx[(ptBus->u32RxHead + ptBus->u32RxNum) % I2C_HOST_FIFO_DEPTH] = ptBus->ptSlave->u8aReg[ptBus->ptSlave->u8Ptr++];
+            ptBus->u32RxNum++;
+        }
+    }
+    else
+    {
+        if ((int32_t)ptBus->u32WrIdx == ptBus->ptSlave->s32NackByte)
+        {
+            _I2cHost_Abort(I2C_HOST_ABRT_DATA_NOACK);
+            return;
+        }
+
+        if (ptBus->u8First)
+            ptBus->ptSlave->u8Ptr = (uint8_t)u32Cmd;
+        else
+            ptBus->ptSlave->u8aReg[ptBus->ptSlave->u8Ptr++] = (uint8_t)u32Cmd;
+
+        ptBus->u8First = 0;
+        ptBus->u32WrIdx++;
+    }
+
+    if (u32Cmd & I2C_HOST_CMD_STOP)
+    {
+        ptBus->u8InXfer = 0;
+        ptBus->u32Raw |= I2C_HOST_INT_STOP_DET;
+        ptBus->u32Stops++;
+    }
+}
+
+static void _I2cHost_Run(void)
+{
+    T_I2cHostBus *ptBus = &g_tI2cHostBus;
+    uint32_t u32Cmd = 0;
+
+    while ((!ptBus->u8Stall) && (ptBus->u32TxNum))
+    {
+        u32Cmd = ptBus->u32aTx[0];
+        memmove(&ptBus->u32aTx[0], &ptBus->u32aTx[1], (--ptBus->u32TxNum) * sizeof(uint32_t));
+        _I2cHost_Cmd(u32Cmd);
+    }
+}
+
+static uint32_t _I2cHost_RawGet(void)
+{
+    T_I2cHostBus *ptBus = &g_tI2cHostBus;
+    uint32_t u32Raw = ptBus->u32Raw;
+
+    if (ptBus->u32RxNum > HostReg_Get(I2C_HOST_RX_TL))
+        u32Raw |= I2C_HOST_INT_RX_FULL;
+    if (ptBus->u32TxNum <= HostReg_Get(I2C_HOST_TX_TL))
+        u32Raw |= I2C_HOST_INT_TX_EMPTY;
+
+    return u32Raw;
+}
+
+static uint32_t _I2cHost_RegRead(uint32_t u32Addr, uint32_t u32Val, void *pArg)
+{
+    T_I2cHostBus *ptBus = &g_tI2cHostBus;
+
+    switch (u32Addr)
+    {
+        case I2C_HOST_DATA_CMD:
+            if (ptBus->u32RxNum == 0)
+                return 0;
+            u32Val = ptBus->u32aRx[ptBus->u32RxHead];
+            ptBus->u32RxHead = (ptBus->u32RxHead + 1) % I2C_HOST_FIFO_DEPTH;
+            ptBus->u32RxNum--;
+            return u32Val;
+
+        case I2C_HOST_INTR_STAT:
+            return _I2cHost_RawGet() & HostReg_Get(I2C_HOST_INTR_MASK);
+
+        case I2C_HOST_RAW_INTR:
+            return _I2cHost_RawGet();
+
+        case I2C_HOST_CIR_INTR:
+            ptBus->u32Raw = 0;
+            HostReg_Set(I2C_HOST_ABRT_SOURCE, 0);
+            return 0;
+
+        case I2C_HOST_CLR_TX_ABRT:
+            ptBus->u32Raw &= ~I2C_HOST_INT_TX_ABRT;
+            HostReg_Set(I2C_HOST_ABRT_SOURCE, 0);
+            return 0;
+
+        case I2C_HOST_CLR_STOP_DET:
+            ptBus->u32Raw &= ~I2C_HOST_INT_STOP_DET;
+            return 0;
+
+        case I2C_HOST_STATUS:
+            return (ptBus->u32TxNum < I2C_HOST_FIFO_DEPTH) ? I2C_HOST_STATUS_TFNF : 0;
+
+        case I2C_HOST_TXFLR:
+            return ptBus->u32TxNum;
+
+        case I2C_HOST_RXFLR:
+            return ptBus->u32RxNum;
+
+        case I2C_HOST_ENABLE_STATUS:
+            return HostReg_Get(I2C_HOST_ENABLE) & 1;
+
+        default:
+            return u32Val;
+    }
+}
+
+static void _I2cHost_RegWrite(uint32_t u32Addr, uint32_t u32Val, void *pArg)
+{
+    T_I2cHostBus *ptBus = &g_tI2cHostBus;
+
+    if (u32Addr == I2C_HOST_DATA_CMD)
+    {
+        // a TX_ABRT not cleared yet keeps the FIFO flushed
+        if ((ptBus->u32Raw & I2C_HOST_INT_TX_ABRT) || (ptBus->u32TxNum >= I2C_HOST_FIFO_DEPTH))
+            return;
+
+        ptBus->u32aTx[ptBus->u32TxNum++] = u32Val;
+        _I2cHost_Run();
+        return;
+    }
+
+    if ((u32Addr == I2C_HOST_ENABLE) && (!(u32Val & 1)))
+    {
+        ptBus->u32TxNum = 0;
+        ptBus->u32RxNum = 0;
+        ptBus->u8InXfer = 0;
+    }
+}
+
+static uint32_t _I2cHost_ModuleRst(E_ApsRstModule_t eModule)
+{
+    T_I2cHostBus *ptBus = &g_tI2cHostBus;
+    uint32_t u32Ret = g_fpI2cHostModuleRst(eModule);
+    uint32_t u32Addr;
+
+    if (eModule == ASP_RST_I2C)
+    {
+        for (u32Addr = I2C_BASE; u32Addr < I2C_HOST_REG_END; u32Addr += 4)
+            HostReg_Set(u32Addr, 0);
+
+        ptBus->u32TxNum = 0;
+        ptBus->u32RxNum = 0;
+        ptBus->u32Raw = 0;
+        ptBus->u8InXfer = 0;
+        ptBus->u32Resets++;
+    }
+
+    return u32Ret;
+}
+
+static void _I2cHost_Isr(void *pArg)
+{
+    // I2C_IRQHandler_Entry_impl
+    Hal_I2c_IntHandler();
+    Hal_Vic_IntClear(I2C_IRQn);
+}
+
+static void *_I2cHost_IrqMain(void *pArg)
+{
+    uint32_t u32Pm = 0;
+
+    while (!g_u8I2cHostExit)
+    {
+        u32Pm = HostOs_IrqSave();
+
+        if ((HostReg_Get(I2C_HOST_NVIC_ISER) & (1 << I2C_IRQn)) &&
+            (_I2cHost_RawGet() & HostReg_Get(I2C_HOST_INTR_MASK)))
+            HostOs_IsrRun(_I2cHost_Isr, NULL);
+
+        HostOs_IrqSet(u32Pm);
+        HostOs_SleepUs(20);
+    }
+
+    return NULL;
+}
+
+static void _I2cHost_SlaveHandler(void)
+{
+    g_u32I2cHostSlaveIrqs++;
+}
+
+static void _I2cHost_Stall(uint8_t u8Stall)
+{
+    uint32_t u32Pm = HostOs_IrqSave();
+
+    g_tI2cHostBus.u8Stall = u8Stall;
+    _I2cHost_Run();
+
+    HostOs_IrqSet(u32Pm);
+}
+
+static void _I2cHost_Reset(void)
+{
+    T_I2cHostBus *ptBus = &g_tI2cHostBus;
+    uint32_t u32Pm = HostOs_IrqSave();
+    uint32_t i;
+
+    memset(ptBus, 0, sizeof(T_I2cHostBus));
+
+    ptBus->taSlave[0].u16Addr = g_tI2cHostDevEeprom.u16Addr;
+    ptBus->taSlave[1].u16Addr = g_tI2cHostDevSensor.u16Addr;
+    ptBus->taSlave[1].u8Is10 = 1;
+
+    for (i = 0; i < 256; i++)
+    {
+        ptBus->taSlave[0].u8aReg[i] = (uint8_t)(i ^ 0x5A);
+        ptBus->taSlave[1].u8aReg[i] = (uint8_t)(255 - i);
+    }
+    ptBus->taSlave[0].s32NackByte = -1;
+    ptBus->taSlave[1].s32NackByte = -1;
+
+    g_u32I2cHostDoneNum = 0;
+    HostOs_IrqSet(u32Pm);
+
+    Hal_I2c_MasterStatReset();
+}
+
+static void _I2cHost_DoneCallBack(S_I2cXfer_t *ptXfer)
+{
+    if (g_u32I2cHostDoneNum < I2C_HOST_XFER_MAX)
+        g_ptaI2cHostDone[g_u32I2cHostDoneNum] = ptXfer;
+    g_u32I2cHostDoneNum++;
+}
+
+static uint8_t _I2cHost_WaitIdle(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < 1000; i++)
+    {
+        if (!Hal_I2c_MasterBusy())
+            return 1;
+        osDelay(1);
+    }
+
+    return 0;
+}
+
+static void _I2cHost_XferSet(S_I2cXfer_t *ptXfer, const S_I2cDev_t *ptDev, const uint8_t *pu8Tx, uint32_t u32TxLen, uint8_t *pu8Rx, uint32_t u32RxLen)
+{
+    memset(ptXfer, 0, sizeof(S_I2cXfer_t));
+    ptXfer->ptDev = ptDev;
+    ptXfer->pu8TxData = pu8Tx;
+    ptXfer->u32TxLen = u32TxLen;
+    ptXfer->pu8RxData = pu8Rx;
+    ptXfer->u32RxLen = u32RxLen;
+    ptXfer->fpCallBack = _I2cHost_DoneCallBack;
+}
+
+static void _I2cHost_Init(void)
+{
+    HOST_TEST_EQ(Hal_I2c_MasterEngineInit(), 0);
+    HOST_TEST_ASSERT(HostReg_Get(I2C_HOST_NVIC_ISER) & (1 << I2C_IRQn));
+
+    // no master transaction: the interrupt belongs to the slave mode
+    _I2cHost_Isr(NULL);
+    HOST_TEST_EQ(g_u32I2cHostSlaveIrqs, 1);
+    HOST_TEST_EQ(Hal_I2c_MasterBusy(), 0);
+}
+
+// register write, then pointer write + repeated START + read
+static void _I2cHost_WriteRead(void)
+{
+    uint8_t u8aWr[4] = { 0x10, 0xDE, 0xAD, 0xBE };
+    uint8_t u8Reg = 0x10;
+    uint8_t u8aRd[3] = { 0 };
+    T_I2cHostBus *ptBus = &g_tI2cHostBus;
+
+    _I2cHost_Reset();
+
+    HOST_TEST_EQ(Hal_I2c_MasterWriteRead(&g_tI2cHostDevEeprom, u8aWr, 4, NULL, 0), HAL_I2C_XFER_DONE);
+    HOST_TEST_EQ(Hal_I2c_MasterWriteRead(&g_tI2cHostDevEeprom, &u8Reg, 1, u8aRd, 3), HAL_I2C_XFER_DONE);
+
+    HOST_TEST_EQ(memcmp(u8aRd, &u8aWr[1], 3), 0);
+
+    // START write, START write, RESTART read, one STOP each
+    HOST_TEST_EQ(ptBus->u32AddrNum, 3);
+    HOST_TEST_EQ(ptBus->taAddr[1].u8Restart, 0);
+    HOST_TEST_EQ(ptBus->taAddr[2].u8Restart, 1);
+    HOST_TEST_EQ(ptBus->taAddr[2].u8Read, 1);
+    HOST_TEST_EQ(ptBus->u32Stops, 2);
+    HOST_TEST_EQ(ptBus->taAddr[0].u32Tar, 0x50);
+}
+
+// more reads than the RX FIFO holds: the window keeps it from overrunning
+static void _I2cHost_LongRead(void)
+{
+    uint8_t u8Reg = 0x20;
+    uint8_t u8aRd[40];
+    S_I2cMasterStat_t tStat;
+    uint32_t i;
+
+    _I2cHost_Reset();
+
+    HOST_TEST_EQ(Hal_I2c_MasterWriteRead(&g_tI2cHostDevEeprom, &u8Reg, 1, u8aRd, sizeof(u8aRd)), HAL_I2C_XFER_DONE);
+
+    for (i = 0; i < sizeof(u8aRd); i++)
+        HOST_TEST_EQ(u8aRd[i], (uint8_t)((0x20 + i) ^ 0x5A));
+
+    HOST_TEST_EQ(g_tI2cHostBus.u32RxOverrun, 0);
+
+    Hal_I2c_MasterStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Xfers, 1);
+    HOST_TEST_EQ(tStat.u32Bytes, 41);
+}
+
+// two devices, 7/10-bit and standard/fast, interleaved in one queue
+static void _I2cHost_MultiDevice(void)
+{
+    static const uint8_t u8aReg[4] = { 0x00, 0x10, 0x40, 0x80 };
+    const S_I2cDev_t *ptaDev[4] = { &g_tI2cHostDevEeprom, &g_tI2cHostDevSensor, &g_tI2cHostDevEeprom, &g_tI2cHostDevSensor };
+    uint8_t u8aRd[4][6];
+    S_I2cXfer_t taXfer[4];
+    T_I2cHostBus *ptBus = &g_tI2cHostBus;
+    S_I2cMasterStat_t tStat;
+    uint32_t i, j;
+
+    _I2cHost_Reset();
+    _I2cHost_Stall(1);
+
+    for (i = 0; i < 4; i++)
+    {
+        _I2cHost_XferSet(&taXfer[i], ptaDev[i], &u8aReg[i], 1, u8aRd[i], 6);
+        HOST_TEST_EQ(Hal_I2c_MasterSubmit(&taXfer[i]), 0);
+    }
+
+    _I2cHost_Stall(0);
+    HOST_TEST_ASSERT(_I2cHost_WaitIdle());
+    HOST_TEST_EQ(g_u32I2cHostDoneNum, 4);
+
+    for (i = 0; i < 4; i++)
+    {
+        HOST_TEST_ASSERT(g_ptaI2cHostDone[i] == &taXfer[i]);
+        HOST_TEST_EQ(taXfer[i].u32Status, HAL_I2C_XFER_DONE);
+
+        for (j = 0; j < 6; j++)
+        {
+            if (ptaDev[i] == &g_tI2cHostDevEeprom)
+                HOST_TEST_EQ(u8aRd[i][j], (uint8_t)((u8aReg[i] + j) ^ 0x5A));
+            else
+                HOST_TEST_EQ(u8aRd[i][j], (uint8_t)(255 - (u8aReg[i] + j)));
+        }
+
+        // each transaction addresses twice (write, RESTART read)
+        HOST_TEST_EQ(ptBus->taAddr[i * 2].u32Tar & 0x3FF, ptaDev[i]->u16Addr);
+        HOST_TEST_EQ(!!(ptBus->taAddr[i * 2].u32Tar & I2C_HOST_TAR_10BIT), ptaDev[i]->eAddrMode == I2C_10BIT);
+        HOST_TEST_EQ((ptBus->taAddr[i * 2].u32Con & I2C_HOST_CON_SPEED) >> 1, (ptaDev[i]->eSpeed == I2C_SPEED_FAST) ? 2 : 1);
+    }
+
+    Hal_I2c_MasterStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32QueueMax, 4);
+    HOST_TEST_EQ(tStat.u32Nack + tStat.u32ArbLost + tStat.u32Timeout, 0);
+}
+
+// no device answers the address, then one NACKs a data byte
+static void _I2cHost_Nack(void)
+{
+    uint8_t u8aWr[4] = { 0x00, 1, 2, 3 };
+    uint8_t u8Rd = 0;
+    S_I2cXfer_t tXfer;
+    S_I2cMasterStat_t tStat;
+
+    _I2cHost_Reset();
+
+    _I2cHost_XferSet(&tXfer, &g_tI2cHostDevAbsent, u8aWr, 1, &u8Rd, 1);
+    HOST_TEST_EQ(Hal_I2c_MasterTransfer(&tXfer), 1);
+    HOST_TEST_EQ(tXfer.u32Status, HAL_I2C_XFER_NACK);
+    HOST_TEST_EQ(tXfer.u32AbrtSrc, I2C_HOST_ABRT_7B_NOACK);
+
+    g_tI2cHostBus.taSlave[0].s32NackByte = 2;
+    _I2cHost_XferSet(&tXfer, &g_tI2cHostDevEeprom, u8aWr, 4, NULL, 0);
+    HOST_TEST_EQ(Hal_I2c_MasterTransfer(&tXfer), 1);
+    HOST_TEST_EQ(tXfer.u32Status, HAL_I2C_XFER_NACK);
+    HOST_TEST_EQ(tXfer.u32AbrtSrc, I2C_HOST_ABRT_DATA_NOACK);
+
+    // the bus is fine afterwards, no reset needed for a NACK
+    g_tI2cHostBus.taSlave[0].s32NackByte = -1;
+    HOST_TEST_EQ(Hal_I2c_MasterWriteRead(&g_tI2cHostDevEeprom, u8aWr, 4, NULL, 0), HAL_I2C_XFER_DONE);
+    HOST_TEST_EQ(g_tI2cHostBus.taSlave[0].u8aReg[2], 3);
+
+    Hal_I2c_MasterStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Nack, 2);
+    HOST_TEST_EQ(tStat.u32Recover, 0);
+    HOST_TEST_EQ(g_tI2cHostBus.u32Resets, 0);
+}
+
+// arbitration lost: the controller is reset and programmed again
+static void _I2cHost_ArbLost(void)
+{
+    uint8_t u8Reg = 0x30;
+    uint8_t u8aRd[2];
+    S_I2cMasterStat_t tStat;
+    T_I2cHostBus *ptBus = &g_tI2cHostBus;
+
+    _I2cHost_Reset();
+
+    ptBus->u8ArbLost = 1;
+    HOST_TEST_EQ(Hal_I2c_MasterWriteRead(&g_tI2cHostDevSensor, &u8Reg, 1, u8aRd, 2), HAL_I2C_XFER_ARB_LOST);
+    HOST_TEST_EQ(ptBus->u32Resets, 1);
+    HOST_TEST_EQ(HostReg_Get(I2C_HOST_TAR), 0);
+
+    HOST_TEST_EQ(Hal_I2c_MasterWriteRead(&g_tI2cHostDevSensor, &u8Reg, 1, u8aRd, 2), HAL_I2C_XFER_DONE);
+    HOST_TEST_EQ(u8aRd[0], 255 - 0x30);
+    HOST_TEST_EQ(HostReg_Get(I2C_HOST_TAR), 0x2A1 | I2C_HOST_TAR_10BIT);
+
+    Hal_I2c_MasterStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32ArbLost, 1);
+    HOST_TEST_EQ(tStat.u32Recover, 1);
+}
+
+// SCL held low: the timer fails the transaction, the queue goes on after the reset
+static void _I2cHost_Timeout(void)
+{
+    uint8_t u8Reg = 0x00;
+    uint8_t u8aRd[2][4];
+    S_I2cXfer_t taXfer[2];
+    S_I2cMasterStat_t tStat;
+    uint64_t u64Start = 0;
+
+    _I2cHost_Reset();
+    _I2cHost_Stall(1);
+
+    _I2cHost_XferSet(&taXfer[0], &g_tI2cHostDevEeprom, &u8Reg, 1, u8aRd[0], 4);
+    taXfer[0].u32TimeoutMs = 30;
+    _I2cHost_XferSet(&taXfer[1], &g_tI2cHostDevEeprom, &u8Reg, 1, u8aRd[1], 4);
+
+    u64Start = HostOs_TimeUs();
+    HOST_TEST_EQ(Hal_I2c_MasterSubmit(&taXfer[0]), 0);
+    HOST_TEST_EQ(Hal_I2c_MasterSubmit(&taXfer[1]), 0);
+
+    while ((taXfer[0].u32Status == HAL_I2C_XFER_ACTIVE) && (HostOs_TimeUs() - u64Start < 1000000))
+        osDelay(1);
+
+    HOST_TEST_EQ(taXfer[0].u32Status, HAL_I2C_XFER_TIMEOUT);
+    HOST_TEST_ASSERT(HostOs_TimeUs() - u64Start >= 25000);
+    HOST_TEST_EQ(g_tI2cHostBus.u32Resets, 1);
+
+    _I2cHost_Stall(0);
+    HOST_TEST_ASSERT(_I2cHost_WaitIdle());
+    HOST_TEST_EQ(taXfer[1].u32Status, HAL_I2C_XFER_DONE);
+    HOST_TEST_EQ(u8aRd[1][3], 0x03 ^ 0x5A);
+
+    Hal_I2c_MasterStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Timeout, 1);
+    HOST_TEST_EQ(tStat.u32Recover, 1);
+    HOST_TEST_EQ(tStat.u32Xfers, 2);
+}
+
+static const T_HostTestCase g_taI2cHostCase[] =
+{
+    HOST_TEST_CASE(_I2cHost_Init),
+    HOST_TEST_CASE(_I2cHost_WriteRead),
+    HOST_TEST_CASE(_I2cHost_LongRead),
+    HOST_TEST_CASE(_I2cHost_MultiDevice),
+    HOST_TEST_CASE(_I2cHost_Nack),
+    HOST_TEST_CASE(_I2cHost_ArbLost),
+    HOST_TEST_CASE(_I2cHost_Timeout),
+};
+
+int main(void)
+{
+    pthread_t tIrq;
+    int iRet = 0;
+
+    HostOs_Init();
+
+    if (HostReg_Init())
+        return 1;
+
+    Hal_Sys_Pre_Init();
+    Hal_Vic_Pre_Init();
+    Hal_I2c_Pre_Init();
+    SystemCoreClockSet(22000000);
+    SystemCoreClockDivFactorSet(16);
+
+    g_fpI2cHostModuleRst = Hal_Sys_ApsModuleRst;
+    Hal_Sys_ApsModuleRst = _I2cHost_ModuleRst;
+    Hal_I2c_IntHandler = _I2cHost_SlaveHandler;
+
+    if (HostReg_Hook(I2C_BASE, _I2cHost_RegRead, _I2cHost_RegWrite, NULL))
+        return 1;
+
+    _I2cHost_Reset();
+    pthread_create(&tIrq, NULL, _I2cHost_IrqMain, NULL);
+
+    iRet = HostTest_Run("hal_i2c_master", g_taI2cHostCase, HOST_TEST_NUM(g_taI2cHostCase));
+
+    g_u8I2cHostExit = 1;
+    pthread_join(tIrq, NULL);
+    return iRet;
+}
@@ -0,0 +1,592 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_spi_master_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  Queued SPI1 transfers of hal_spi_master.c against a register model of
+*  the port, with the ROM hal_spi.c/hal_vic.c underneath.
+*
+*  The model answers each frame written to DR at once (data ^ pattern, or
+*  a counter for TAG_READ frames) into an RX FIFO of the driver's depth, and
+*  reports RXFLR, ISR and the overrun/underrun flags from it. A stalled
+*  device holds the frames instead, like a slave that never clocks back.
+*  The interrupt thread runs the SPI1 handler sequence of
+*  opl1000_it_patch.c whenever the unmasked ISR bits are set.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <pthread.h>
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "hal_vic.h"
+#include "hal_spi.h"
+#include "hal_spi_master.h"
+#include "host_os.h"
+#include "host_reg.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SPI_HOST_SSIENR         (SPI1_BASE + 0x08)
+#define SPI_HOST_RXFTLR         (SPI1_BASE + 0x1C)
+#define SPI_HOST_RXFLR          (SPI1_BASE + 0x24)
+#define SPI_HOST_IMR            (SPI1_BASE + 0x2C)
+#define SPI_HOST_ISR            (SPI1_BASE + 0x30)
+#define SPI_HOST_ICR            (SPI1_BASE + 0x48)
+#define SPI_HOST_DR             (SPI1_BASE + 0x60)
+#define SPI_HOST_DR_END         (SPI1_BASE + 0xF0)
+
+#define SPI_HOST_INT_RX_UNDERFLOW   (1<<2)
+#define SPI_HOST_INT_RX_OVERFLOW    (1<<3)
+#define SPI_HOST_INT_RX_FULL        (1<<4)
+
+#define SPI_HOST_NVIC_ISER      (0xE000E100)
+#define SPI_HOST_GPO            (AOS_BASE + 0x0A0)  // PIN->RG_GPO of hal_vic.c
+
+#define SPI_HOST_PATTERN_08     (0xA5)
+#define SPI_HOST_PATTERN_16     (0xA55A)
+#define SPI_HOST_READ_BASE      (0x80)
+
+#define SPI_HOST_LOG_MAX        (256)
+#define SPI_HOST_XFER_MAX       (8)
+#define SPI_HOST_WAIT_MS        (1000)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    uint32_t u32aRx[HAL_SPI_MASTER_FIFO_DEPTH];
+    uint32_t u32RxHead;
+    uint32_t u32RxNum;
+    uint32_t u32aHeld[SPI_HOST_LOG_MAX];
+    uint32_t u32HeldNum;
+    uint32_t u32Err;                // ISR overrun/underrun bits until ICR is read
+    uint32_t u32ReadCnt;
+    uint8_t u8Stall;
+
+    // every frame the driver wrote to DR, with the CS GPIO level at that time
+    uint32_t u32aMosi[SPI_HOST_LOG_MAX];
+    uint8_t u8aCs[SPI_HOST_LOG_MAX];
+    uint32_t u32MosiNum;
+} T_SpiHostDev;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_SpiHostDev g_tSpiHostDev;
+static volatile uint8_t g_u8SpiHostExit;
+
+static S_SpiXfer_t *g_ptaSpiHostDone[SPI_HOST_XFER_MAX];
+static volatile uint32_t g_u32SpiHostDoneNum;
+
+static const S_SpiDev_t g_tSpiHostDev08 =
+{
+    SPI_IDX_1, 1000000, SPI_CLK_PLOAR_HIGH_ACT, SPI_CLK_PHASE_START, SPI_DFS_08_bit, HAL_SPI_CS_HW
+};
+
+static const S_SpiDev_t g_tSpiHostDev16 =
+{
+    SPI_IDX_1, 4000000, SPI_CLK_PLOAR_HIGH_ACT, SPI_CLK_PHASE_START, SPI_DFS_16_bit, HAL_SPI_CS_HW
+};
+
+static const S_SpiDev_t g_tSpiHostDevGpio =
+{
+    SPI_IDX_1, 1000000, SPI_CLK_PLOAR_HIGH_ACT, SPI_CLK_PHASE_START, SPI_DFS_08_bit, GPIO_IDX_05
+};
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static uint32_t _SpiHost_Answer(uint32_t u32Frame)
+{
+    uint8_t u8Is16 = (((u32Frame >> 20) & 0xF) == SPI_DFS_16_bit);
+
+    if (u32Frame & TAG_READ)
+        return SPI_HOST_READ_BASE + g_tSpiHostDev.u32ReadCnt++;
+
+    return (u32Frame & 0xFFFF) ^ ((u8Is16) ? SPI_HOST_PATTERN_16 : SPI_HOST_PATTERN_08);
+}
+
+static void _SpiHost_RxPush(uint32_t u32Frame)
+{
+    T_SpiHostDev *ptDev = &g_tSpiHostDev;
+
+    if (ptDev->u32RxNum >= HAL_SPI_MASTER_FIFO_DEPTH)
+    {
+        ptDev->u32Err |= SPI_HOST_INT_RX_OVERFLOW;
+        return;
+    }
+
+    ptDev->u32aRx[(ptDev->u32RxHead + ptDev->u32RxNum) % HAL_SPI_MASTER_FIFO_DEPTH] = _SpiHost_Answer(u32Frame);
+    ptDev->u32RxNum++;
+}
+
+static uint32_t _SpiHost_IsrGet(void)
+{
+    uint32_t u32Isr = g_tSpiHostDev.u32Err;
+
+    if (g_tSpiHostDev.u32RxNum > HostReg_Get(SPI_HOST_RXFTLR))
+        u32Isr |= SPI_HOST_INT_RX_FULL;
+
+    return u32Isr & HostReg_Get(SPI_HOST_IMR);
+}
+
+static uint32_t _SpiHost_RegRead(uint32_t u32Addr, uint32_t u32Val, void *pArg)
+{
+    T_SpiHostDev *ptDev = &g_tSpiHostDev;
+
+    if ((u32Addr >= SPI_HOST_DR) && (u32Addr < SPI_HOST_DR_END))
+    {
+        if (ptDev->u32RxNum == 0)
+        {
+            ptDev->u32Err |= SPI_HOST_INT_RX_UNDERFLOW;
+            return 0;
+        }
+
+        u32Val = ptDev->u32aRx[ptDev->u32RxHead];
+        ptDev->u32RxHead = (ptDev->u32RxHead + 1) % HAL_SPI_MASTER_FIFO_DEPTH;
+        ptDev->u32RxNum--;
+        return u32Val;
+    }
+
+    switch (u32Addr)
+    {
+        case SPI_HOST_RXFLR:
+            return ptDev->u32RxNum;
+
+        case SPI_HOST_ISR:
+            return _SpiHost_IsrGet();
+
+        case SPI_HOST_ICR:
+            ptDev->u32Err = 0;
+            return 0;
+
+        default:
+            return u32Val;
+    }
+}
+
+static void _SpiHost_RegWrite(uint32_t u32Addr, uint32_t u32Val, void *pArg)
+{
+    T_SpiHostDev *ptDev = &g_tSpiHostDev;
+
+    if ((u32Addr >= SPI_HOST_DR) && (u32Addr < SPI_HOST_DR_END))
+    {
+        if (ptDev->u32MosiNum < SPI_HOST_LOG_MAX)
+        {
+            ptDev->u32aMosi[ptDev->u32MosiNum] = u32Val;
+            ptDev->u8aCs[ptDev->u32MosiNum] = (HostReg_Get(SPI_HOST_GPO) >> GPIO_IDX_05) & 1;
+            ptDev->u32MosiNum++;
+        }
+
+        if ((ptDev->u8Stall) && (ptDev->u32HeldNum < SPI_HOST_LOG_MAX))
+            ptDev->u32aHeld[ptDev->u32HeldNum++] = u32Val;
+        else
+            _SpiHost_RxPush(u32Val);
+        return;
+    }
+
+    // disabling the port flushes the FIFOs and what is on the wire
+    if ((u32Addr == SPI_HOST_SSIENR) && (u32Val == 0))
+    {
+        ptDev->u32RxNum = 0;
+        ptDev->u32HeldNum = 0;
+    }
+}
+
+static void _SpiHost_Isr(void *pArg)
+{
+    // SPI1_IRQHandler_Entry_patch
+    Hal_Spi_MasterIntHandler(SPI_IDX_1);
+    Hal_Vic_IntClear(SPI1_IRQn);
+}
+
+static void *_SpiHost_IrqMain(void *pArg)
+{
+    uint32_t u32Pm = 0;
+
+    while (!g_u8SpiHostExit)
+    {
+        u32Pm = HostOs_IrqSave();
+
+        if ((HostReg_Get(SPI_HOST_NVIC_ISER) & (1 << SPI1_IRQn)) && (_SpiHost_IsrGet()))
+            HostOs_IsrRun(_SpiHost_Isr, NULL);
+
+        HostOs_IrqSet(u32Pm);
+        HostOs_SleepUs(20);
+    }
+
+    return NULL;
+}
+
+static void _SpiHost_Stall(uint8_t u8Stall)
+{
+    T_SpiHostDev *ptDev = &g_tSpiHostDev;
+    uint32_t u32Pm = HostOs_IrqSave();
+    uint32_t i;
+
+    ptDev->u8Stall = u8Stall;
+
+    if (!u8Stall)
+    {
+        for (i = 0; i < ptDev->u32HeldNum; i++)
+            _SpiHost_RxPush(ptDev->u32aHeld[i]);
+        ptDev->u32HeldNum = 0;
+    }
+
+    HostOs_IrqSet(u32Pm);
+}
+
+static void _SpiHost_Reset(void)
+{
+    uint32_t u32Pm = HostOs_IrqSave();
+
+    memset(&g_tSpiHostDev, 0, sizeof(g_tSpiHostDev));
+    g_u32SpiHostDoneNum = 0;
+    HostReg_Set(SPI_HOST_GPO, HostReg_Get(SPI_HOST_GPO) | (1 << GPIO_IDX_05));
+
+    HostOs_IrqSet(u32Pm);
+
+    Hal_Spi_MasterStatReset(SPI_IDX_1);
+}
+
+static void _SpiHost_DoneCallBack(S_SpiXfer_t *ptXfer)
+{
+    if (g_u32SpiHostDoneNum < SPI_HOST_XFER_MAX)
+        g_ptaSpiHostDone[g_u32SpiHostDoneNum] = ptXfer;
+    g_u32SpiHostDoneNum++;
+}
+
+static uint8_t _SpiHost_WaitIdle(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < SPI_HOST_WAIT_MS; i++)
+    {
+        if (!Hal_Spi_MasterBusy(SPI_IDX_1))
+            return 1;
+        osDelay(1);
+    }
+
+    return 0;
+}
+
+static void _SpiHost_XferSet(S_SpiXfer_t *ptXfer, const S_SpiDev_t *ptDev, const void *pTx, void *pRx, uint32_t u32Frames)
+{
+    memset(ptXfer, 0, sizeof(S_SpiXfer_t));
+    ptXfer->ptDev = ptDev;
+    ptXfer->pTxData = pTx;
+    ptXfer->pRxData = pRx;
+    ptXfer->u32Frames = u32Frames;
+    ptXfer->fpCallBack = _SpiHost_DoneCallBack;
+}
+
+static void _SpiHost_Init(void)
+{
+    HOST_TEST_EQ(Hal_Spi_MasterInit(SPI_IDX_0), 1);
+    HOST_TEST_EQ(Hal_Spi_MasterInit(SPI_IDX_1), 0);
+    HOST_TEST_ASSERT(HostReg_Get(SPI_HOST_NVIC_ISER) & (1 << SPI1_IRQn));
+    HOST_TEST_EQ(Hal_Spi_MasterBusy(SPI_IDX_1), 0);
+}
+
+// three queued blocks come out in order, each one closing CS on its last frame
+static void _SpiHost_Queue08(void)
+{
+    static const uint32_t u32aLen[3] = { 10, 1, 23 };
+    uint8_t u8aTx[3][32];
+    uint8_t u8aRx[3][32];
+    S_SpiXfer_t taXfer[3];
+    S_SpiMasterStat_t tStat;
+    uint32_t u32Frame = 0;
+    uint32_t i, j;
+
+    _SpiHost_Reset();
+    _SpiHost_Stall(1);
+
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < u32aLen[i]; j++)
+            u8aTx[i][j] = (uint8_t)(i * 64 + j);
+        memset(u8aRx[i], 0, sizeof(u8aRx[i]));
+
+        _SpiHost_XferSet(&taXfer[i], &g_tSpiHostDev08, u8aTx[i], u8aRx[i], u32aLen[i]);
+        HOST_TEST_EQ(Hal_Spi_MasterSubmit(&taXfer[i]), 0);
+    }
+
+    HOST_TEST_EQ(taXfer[0].u32Status, HAL_SPI_XFER_ACTIVE);
+    HOST_TEST_EQ(taXfer[2].u32Status, HAL_SPI_XFER_QUEUED);
+
+    _SpiHost_Stall(0);
+    HOST_TEST_ASSERT(_SpiHost_WaitIdle());
+
+    HOST_TEST_EQ(g_u32SpiHostDoneNum, 3);
+
+    for (i = 0; i < 3; i++)
+    {
+        HOST_TEST_ASSERT(g_ptaSpiHostDone[i] == &taXfer[i]);
+        HOST_TEST_EQ(taXfer[i].u32Status, HAL_SPI_XFER_DONE);
+
+        for (j = 0; j < u32aLen[i]; j++, u32Frame++)
+        {
+            HOST_TEST_EQ(u8aRx[i][j], u8aTx[i][j] ^ SPI_HOST_PATTERN_08);
+            HOST_TEST_EQ(g_tSpiHostDev.u32aMosi[u32Frame] & 0xFFFF, u8aTx[i][j]);
+            HOST_TEST_EQ(g_tSpiHostDev.u32aMosi[u32Frame] & TAG_CS_COMP, (j == u32aLen[i] - 1) ? TAG_CS_COMP : 0);
+        }
+    }
+
+    HOST_TEST_EQ(g_tSpiHostDev.u32MosiNum, u32Frame);
+
+    Hal_Spi_MasterStatGet(SPI_IDX_1, &tStat);
+    HOST_TEST_EQ(tStat.u32Xfers, 3);
+    HOST_TEST_EQ(tStat.u32Frames, u32Frame);
+    HOST_TEST_EQ(tStat.u32Errors, 0);
+    HOST_TEST_EQ(tStat.u32QueueMax, 3);
+}
+
+// a 16-bit device reprograms the port, the FIFO is refilled over a long block
+static void _SpiHost_Frame16(void)
+{
+    uint16_t u16aTx[37];
+    uint16_t u16aRx[37];
+    S_SpiXfer_t tXfer;
+    S_SpiMasterStat_t tStat;
+    uint32_t i;
+
+    _SpiHost_Reset();
+
+    for (i = 0; i < 37; i++)
+        u16aTx[i] = (uint16_t)(0x1234 + i * 0x101);
+    memset(u16aRx, 0, sizeof(u16aRx));
+
+    _SpiHost_XferSet(&tXfer, &g_tSpiHostDev16, u16aTx, u16aRx, 37);
+    HOST_TEST_EQ(Hal_Spi_MasterTransfer(&tXfer, SPI_HOST_WAIT_MS), 0);
+
+    for (i = 0; i < 37; i++)
+    {
+        HOST_TEST_EQ(u16aRx[i], u16aTx[i] ^ SPI_HOST_PATTERN_16);
+        HOST_TEST_EQ((g_tSpiHostDev.u32aMosi[i] >> 20) & 0xF, SPI_DFS_16_bit);
+    }
+
+    HOST_TEST_EQ(HostReg_Get(SPI1_BASE) & 0xF, SPI_DFS_16_bit);
+    HOST_TEST_EQ(HostReg_Get(SPI_HOST_SSIENR), 0x3);
+
+    Hal_Spi_MasterStatGet(SPI_IDX_1, &tStat);
+    HOST_TEST_EQ(tStat.u32Reconfig, 1);
+    HOST_TEST_EQ(tStat.u32Errors, 0);
+    HOST_TEST_ASSERT(tStat.u32Irqs >= 1);
+}
+
+// no TX data: the frames go out as TAG_READ
+static void _SpiHost_ReadOnly(void)
+{
+    uint8_t u8aRx[9];
+    S_SpiXfer_t tXfer;
+    uint32_t i;
+
+    _SpiHost_Reset();
+
+    _SpiHost_XferSet(&tXfer, &g_tSpiHostDev08, NULL, u8aRx, 9);
+    HOST_TEST_EQ(Hal_Spi_MasterTransfer(&tXfer, SPI_HOST_WAIT_MS), 0);
+
+    for (i = 0; i < 9; i++)
+    {
+        HOST_TEST_EQ(u8aRx[i], SPI_HOST_READ_BASE + i);
+        HOST_TEST_ASSERT(g_tSpiHostDev.u32aMosi[i] & TAG_READ);
+    }
+}
+
+// a GPIO chip select is low for every frame and high again at the end
+static void _SpiHost_GpioCs(void)
+{
+    uint8_t u8aTx[6] = { 1, 2, 3, 4, 5, 6 };
+    S_SpiXfer_t tXfer;
+    uint32_t i;
+
+    _SpiHost_Reset();
+
+    _SpiHost_XferSet(&tXfer, &g_tSpiHostDevGpio, u8aTx, NULL, 6);
+    HOST_TEST_EQ(Hal_Spi_MasterTransfer(&tXfer, SPI_HOST_WAIT_MS), 0);
+
+    HOST_TEST_EQ(g_tSpiHostDev.u32MosiNum, 6);
+    for (i = 0; i < 6; i++)
+        HOST_TEST_EQ(g_tSpiHostDev.u8aCs[i], GPIO_LEVEL_LOW);
+
+    HOST_TEST_EQ((HostReg_Get(SPI_HOST_GPO) >> GPIO_IDX_05) & 1, GPIO_LEVEL_HIGH);
+}
+
+static uint32_t _SpiHost_StackTransfer(uint32_t u32TimeoutMs, uint32_t *pu32Status)
+{
+    uint8_t u8aTx[12];
+    uint8_t u8aRx[12];
+    S_SpiXfer_t tXfer;
+    uint32_t u32Ret = 0;
+
+    memset(u8aTx, 0x3C, sizeof(u8aTx));
+    _SpiHost_XferSet(&tXfer, &g_tSpiHostDev08, u8aTx, u8aRx, sizeof(u8aTx));
+
+    u32Ret = Hal_Spi_MasterTransfer(&tXfer, u32TimeoutMs);
+    *pu32Status = tXfer.u32Status;
+
+    // the stack frame goes away here: the driver must not hold it any more
+    memset(&tXfer, 0xEE, sizeof(tXfer));
+    return u32Ret;
+}
+
+// a stalled device: the transfer times out, is taken off the port and the
+// next one neither wakes up early nor finds the port stuck
+static void _SpiHost_TimeoutAbort(void)
+{
+    uint8_t u8aTx[5] = { 0x11, 0x22, 0x33, 0x44, 0x55 };
+    uint8_t u8aRx[5];
+    S_SpiXfer_t tXfer;
+    S_SpiMasterStat_t tStat;
+    uint32_t u32Status = 0;
+    uint64_t u64Start = 0;
+    uint32_t i;
+
+    _SpiHost_Reset();
+    _SpiHost_Stall(1);
+
+    HOST_TEST_EQ(_SpiHost_StackTransfer(20, &u32Status), 1);
+    HOST_TEST_EQ(u32Status, HAL_SPI_XFER_ABORTED);
+    HOST_TEST_EQ(Hal_Spi_MasterBusy(SPI_IDX_1), 0);
+    HOST_TEST_EQ(HostReg_Get(SPI_HOST_IMR), 0);
+    HOST_TEST_EQ(HostReg_Get(SPI_HOST_SSIENR), 0x3);
+    HOST_TEST_EQ(g_tSpiHostDev.u32HeldNum, 0);
+
+    // still stalled: the whole time-out elapses, no stale completion
+    u64Start = HostOs_TimeUs();
+    HOST_TEST_EQ(_SpiHost_StackTransfer(50, &u32Status), 1);
+    HOST_TEST_ASSERT(HostOs_TimeUs() - u64Start >= 45000);
+    HOST_TEST_EQ(u32Status, HAL_SPI_XFER_ABORTED);
+
+    _SpiHost_Stall(0);
+
+    _SpiHost_XferSet(&tXfer, &g_tSpiHostDev08, u8aTx, u8aRx, 5);
+    HOST_TEST_EQ(Hal_Spi_MasterTransfer(&tXfer, SPI_HOST_WAIT_MS), 0);
+    for (i = 0; i < 5; i++)
+        HOST_TEST_EQ(u8aRx[i], u8aTx[i] ^ SPI_HOST_PATTERN_08);
+
+    Hal_Spi_MasterStatGet(SPI_IDX_1, &tStat);
+    HOST_TEST_EQ(tStat.u32Errors, 2);
+    HOST_TEST_EQ(tStat.u32Xfers, 1);
+}
+
+// abort in the middle, at the tail and the active head of the queue
+static void _SpiHost_AbortQueued(void)
+{
+    uint8_t u8aTx[5][4];
+    uint8_t u8aRx[5][4];
+    S_SpiXfer_t taXfer[5];
+    uint32_t i, j;
+
+    _SpiHost_Reset();
+    _SpiHost_Stall(1);
+
+    for (i = 0; i < 5; i++)
+    {
+        for (j = 0; j < 4; j++)
+            u8aTx[i][j] = (uint8_t)(i * 16 + j);
+        _SpiHost_XferSet(&taXfer[i], &g_tSpiHostDev08, u8aTx[i], u8aRx[i], 4);
+    }
+
+    for (i = 0; i < 4; i++)
+        HOST_TEST_EQ(Hal_Spi_MasterSubmit(&taXfer[i]), 0);
+
+    HOST_TEST_EQ(Hal_Spi_MasterAbort(&taXfer[1]), HAL_SPI_XFER_ABORTED);
+    HOST_TEST_EQ(Hal_Spi_MasterAbort(&taXfer[3]), HAL_SPI_XFER_ABORTED);
+    HOST_TEST_EQ(Hal_Spi_MasterAbort(&taXfer[0]), HAL_SPI_XFER_ABORTED);
+    HOST_TEST_EQ(Hal_Spi_MasterAbort(&taXfer[0]), HAL_SPI_XFER_ABORTED);
+    HOST_TEST_EQ(taXfer[2].u32Status, HAL_SPI_XFER_ACTIVE);
+
+    // appended behind the aborted tail
+    HOST_TEST_EQ(Hal_Spi_MasterSubmit(&taXfer[4]), 0);
+
+    _SpiHost_Stall(0);
+    HOST_TEST_ASSERT(_SpiHost_WaitIdle());
+
+    HOST_TEST_EQ(g_u32SpiHostDoneNum, 2);
+    HOST_TEST_ASSERT(g_ptaSpiHostDone[0] == &taXfer[2]);
+    HOST_TEST_ASSERT(g_ptaSpiHostDone[1] == &taXfer[4]);
+    HOST_TEST_EQ(Hal_Spi_MasterAbort(&taXfer[2]), HAL_SPI_XFER_DONE);
+
+    for (j = 0; j < 4; j++)
+    {
+        HOST_TEST_EQ(u8aRx[2][j], u8aTx[2][j] ^ SPI_HOST_PATTERN_08);
+        HOST_TEST_EQ(u8aRx[4][j], u8aTx[4][j] ^ SPI_HOST_PATTERN_08);
+    }
+}
+
+static const T_HostTestCase g_taSpiHostCase[] =
+{
+    HOST_TEST_CASE(_SpiHost_Init),
+    HOST_TEST_CASE(_SpiHost_Queue08),
+    HOST_TEST_CASE(_SpiHost_Frame16),
+    HOST_TEST_CASE(_SpiHost_ReadOnly),
+    HOST_TEST_CASE(_SpiHost_GpioCs),
+    HOST_TEST_CASE(_SpiHost_TimeoutAbort),
+    HOST_TEST_CASE(_SpiHost_AbortQueued),
+};
+
+int main(void)
+{
+    pthread_t tIrq;
+    int iRet = 0;
+
+    HostOs_Init();
+
+    if (HostReg_Init())
+        return 1;
+
+    Hal_Vic_Pre_Init();
+    Hal_Spi_Pre_Init();
+    SystemCoreClockSet(22000000);
+    SystemCoreClockDivFactorSet(16);
+
+    if (HostReg_Hook(SPI1_BASE, _SpiHost_RegRead, _SpiHost_RegWrite, NULL))
+        return 1;
+
+    pthread_create(&tIrq, NULL, _SpiHost_IrqMain, NULL);
+
+    iRet = HostTest_Run("hal_spi_master", g_taSpiHostCase, HOST_TEST_NUM(g_taSpiHostCase));
+
+    g_u8SpiHostExit = 1;
+    pthread_join(tIrq, NULL);
+    return iRet;
+}
@@ -0,0 +1,443 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  hal_temperature_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The fixed-point thermistor conversion of hal_temperature_patch.c against
+*  the float one of the ROM: every ohm across both calibration tables, the
+*  whole reading path from the AUXADC voltages, the fall-back for a table
+*  the binary search cannot use and the offset kept in MW_FIM.
+*
+*  The AUXADC readings and MW_FIM are stubs. The last case reports the TSC
+*  cycles per conversion of both; the host has an FPU, so the ratio is a
+*  floor of what the soft-float M3 gains.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hal_auxadc.h"
+#include "hal_temperature.h"
+#include "hal_temperature_internal.h"
+#include "hal_temperature_patch.h"
+#include "mw_fim.h"
+#include "mw_fim_default_group03.h"
+#include "mw_fim_default_group03_patch.h"
+#include "host_os.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define TMPR_HOST_SWEEP_MARGIN  (2000)      // ohm beyond both ends of the table
+#define TMPR_HOST_TABLE_TOL     (2)         // milli-degree, the ohm rounding of the table
+#define TMPR_HOST_READ_TOL      (25)        // milli-degree, with the mV rounding of the voltages
+#define TMPR_HOST_BENCH_NUM     (4096)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    float fVbat;
+    float fIo;
+    uint8_t ubFail;
+} T_TmprHostAux;
+
+typedef struct
+{
+    int32_t lOffset;
+    uint8_t ubValid;
+    uint8_t ubWriteFail;
+    uint32_t ulWrite;
+} T_TmprHostFim;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+extern uint8_t g_ubHalTmpr_Init;
+extern const T_HalTmprCalData g_tMwFimDefaultCalTmpr;
+extern const T_HalTmprCalData g_tMwFimDefaultCalTmpr_patch;
+
+// the ROM FIM code the drivers call
+T_MwFim_FileRead_Fp MwFim_FileRead;
+T_MwFim_FileWrite_Fp MwFim_FileWrite;
+
+// Sec 5: declaration of global function prototype
+void Hal_Tmpr_PreInitCold(void);
+extern uint8_t Hal_Tmpr_TemperatureGet_impl(uint8_t ubGpioIdx, float *pfTemperature);
+extern uint8_t Hal_Tmpr_CompareResistor_impl(float fResistor, float *pfTemperature);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_TmprHostAux g_tTmprHostAux;
+static T_TmprHostFim g_tTmprHostFim;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+uint32_t Boot_CheckWarmBoot(void)
+{
+    return 0;
+}
+
+// only the offset is in flash, the temperature table is the default one
+static uint8_t _TmprHost_FimRead(uint32_t ulFileId, uint16_t uwRecIdx, uint16_t uwFileSize, uint8_t *pubFileData)
+{
+    if ((ulFileId != MW_FIM_IDX_GP03_PATCH_CAL_TMPR_OFFSET) || (!g_tTmprHostFim.ubValid))
+        return MW_FIM_FAIL;
+
+    memcpy(pubFileData, &g_tTmprHostFim.lOffset, uwFileSize);
+    return MW_FIM_OK;
+}
+
+static uint8_t _TmprHost_FimWrite(uint32_t ulFileId, uint16_t uwRecIdx, uint16_t uwFileSize, uint8_t *pubFileData)
+{
+    if ((ulFileId != MW_FIM_IDX_GP03_PATCH_CAL_TMPR_OFFSET) || (uwFileSize != MW_FIM_CAL_TMPR_OFFSET_SIZE) ||
+        (g_tTmprHostFim.ubWriteFail))
+        return MW_FIM_FAIL;
+
+    memcpy(&g_tTmprHostFim.lOffset, pubFileData, uwFileSize);
+    g_tTmprHostFim.ubValid = 1;
+    g_tTmprHostFim.ulWrite++;
+    return MW_FIM_OK;
+}
+
+static uint8_t _TmprHost_VbatGet(float *pfVbat)
+{
+    if (g_tTmprHostAux.ubFail)
+        return HAL_AUX_FAIL;
+
+    *pfVbat = g_tTmprHostAux.fVbat;
+    return HAL_AUX_OK;
+}
+
+static uint8_t _TmprHost_IoVoltageGet(uint8_t ubGpioIdx, float *pfVoltage)
+{
+    if (g_tTmprHostAux.ubFail)
+        return HAL_AUX_FAIL;
+
+    *pfVoltage = g_tTmprHostAux.fIo;
+    return HAL_AUX_OK;
+}
+
+static void _TmprHost_TableSet(const T_HalTmprCalData *ptCal)
+{
+    memcpy(&g_tHalTmpr_CalData, ptCal, sizeof(T_HalTmprCalData));
+    Hal_Tmpr_FixTableUpdate();
+}
+
+static int32_t _TmprHost_FloatMilli(float fTemperature)
+{
+    return (int32_t)lroundf(fTemperature * HAL_TMPR_FIX_MILLI);
+}
+
+// the ROM reading, with its own float search
+static uint8_t _TmprHost_FloatGet(float *pfTemperature)
+{
+    uint8_t ubRet;
+
+    Hal_Tmpr_CompareResistor = Hal_Tmpr_CompareResistor_impl;
+    ubRet = Hal_Tmpr_TemperatureGet_impl(0, pfTemperature);
+    Hal_Tmpr_CompareResistor = Hal_Tmpr_CompareResistor_patch;
+
+    return ubRet;
+}
+
+// every ohm from above the first entry to below the last one, the max difference in milli-degree
+static uint32_t _TmprHost_Sweep(const T_HalTmprCalData *ptCal, uint32_t *pulNum)
+{
+    uint32_t ulHigh = (uint32_t)(ptCal->faThermistor[0] * HAL_TMPR_FIX_OHM_PER_UNIT) + TMPR_HOST_SWEEP_MARGIN;
+    uint32_t ulLow = (uint32_t)(ptCal->faThermistor[HAL_TMPR_STEP_MAX - 1] * HAL_TMPR_FIX_OHM_PER_UNIT) - TMPR_HOST_SWEEP_MARGIN;
+    uint32_t ulMax = 0;
+    uint32_t ulDiff;
+    uint32_t ulR;
+    int32_t lFix;
+    float fFloat;
+
+    _TmprHost_TableSet(ptCal);
+    *pulNum = 0;
+
+    for (ulR = ulHigh; ulR >= ulLow; ulR--)
+    {
+        if ((Hal_Tmpr_CompareResistorFix(ulR, &lFix) != HAL_TMPR_OK) ||
+            (Hal_Tmpr_CompareResistor_impl((float)ulR / HAL_TMPR_FIX_OHM_PER_UNIT, &fFloat) != HAL_TMPR_OK))
+            return 0xFFFFFFFF;
+
+        ulDiff = (uint32_t)abs(lFix - _TmprHost_FloatMilli(fFloat));
+        if (ulDiff > ulMax)
+            ulMax = ulDiff;
+        (*pulNum)++;
+    }
+
+    return ulMax;
+}
+
+// the offset from MW_FIM on cold boot, the integer table built from the calibration data
+static void _TmprHost_Init(void)
+{
+    g_tTmprHostFim.lOffset = 1500;
+    g_tTmprHostFim.ubValid = 1;
+
+    Hal_Tmpr_Init();
+
+    HOST_TEST_EQ(g_ubHalTmpr_Init, 1);
+    HOST_TEST_EQ(Hal_Tmpr_OffsetGet(), 1500);
+    HOST_TEST_ASSERT(memcmp(&g_tHalTmpr_CalData, &g_tMwFimDefaultCalTmpr, sizeof(T_HalTmprCalData)) == 0);
+    HOST_TEST_EQ(Hal_Tmpr_FixTableUpdate(), HAL_TMPR_OK);
+
+    // nothing in flash: the default offset
+    g_tTmprHostFim.ubValid = 0;
+    Hal_Tmpr_Init();
+    HOST_TEST_EQ(Hal_Tmpr_OffsetGet(), g_lMwFimDefaultCalTmprOffset);
+}
+
+// both calibration tables, every ohm: within the ohm rounding of the float result
+static void _TmprHost_SweepTable(void)
+{
+    uint32_t ulMax;
+    uint32_t ulNum;
+
+    ulMax = _TmprHost_Sweep(&g_tMwFimDefaultCalTmpr, &ulNum);
+    printf("  ROM table:   %u resistors, max difference %u milli-degree\n", ulNum, ulMax);
+    HOST_TEST_ASSERT(ulMax <= TMPR_HOST_TABLE_TOL);
+
+    ulMax = _TmprHost_Sweep(&g_tMwFimDefaultCalTmpr_patch, &ulNum);
+    printf("  patch table: %u resistors, max difference %u milli-degree\n", ulNum, ulMax);
+    HOST_TEST_ASSERT(ulMax <= TMPR_HOST_TABLE_TOL);
+}
+
+// the table entries give whole degrees, the ends clamp as the ROM does
+static void _TmprHost_Edges(void)
+{
+    const T_HalTmprCalData *ptCal = &g_tMwFimDefaultCalTmpr_patch;
+    int32_t lBase = (int32_t)(ptCal->fBaseTemperature * HAL_TMPR_FIX_MILLI);
+    int32_t lFix;
+    float fFloat;
+    uint32_t i;
+
+    _TmprHost_TableSet(ptCal);
+
+    for (i = 0; i < HAL_TMPR_STEP_MAX; i++)
+    {
+        HOST_TEST_EQ(Hal_Tmpr_CompareResistorFix((uint32_t)lroundf(ptCal->faThermistor[i] * HAL_TMPR_FIX_OHM_PER_UNIT), &lFix), HAL_TMPR_OK);
+        HOST_TEST_EQ(lFix, lBase + i * HAL_TMPR_FIX_MILLI);
+    }
+
+    HOST_TEST_EQ(Hal_Tmpr_CompareResistorFix(0xFFFFFFFF, &lFix), HAL_TMPR_OK);
+    HOST_TEST_EQ(lFix, lBase);
+    HOST_TEST_EQ(Hal_Tmpr_CompareResistorFix(0, &lFix), HAL_TMPR_OK);
+    HOST_TEST_EQ(lFix, lBase + (HAL_TMPR_STEP_MAX - 1) * HAL_TMPR_FIX_MILLI);
+
+    // the patched float entry point goes through the integer search
+    HOST_TEST_EQ(Hal_Tmpr_CompareResistor(33.0f, &fFloat), HAL_TMPR_OK);
+    HOST_TEST_EQ(Hal_Tmpr_CompareResistorFix(33000, &lFix), HAL_TMPR_OK);
+    HOST_TEST_EQ(_TmprHost_FloatMilli(fFloat), lFix);
+}
+
+// from the AUXADC voltages: the integer path against the ROM one, the offset added
+static void _TmprHost_Reading(void)
+{
+    uint32_t ulMax = 0;
+    uint32_t ulDiff;
+    uint32_t ulUv;
+    int32_t lFix;
+    float fFloat;
+    float fPatch;
+
+    _TmprHost_TableSet(&g_tMwFimDefaultCalTmpr_patch);
+    HOST_TEST_EQ(Hal_Tmpr_OffsetSet(0), HAL_TMPR_OK);
+
+    g_tTmprHostAux.fVbat = 3.3f;
+    // a quarter of a mV apart: the integer path rounds the voltages to mV
+    for (ulUv = 1000000; ulUv <= 2300000; ulUv += 250)
+    {
+        g_tTmprHostAux.fIo = ulUv / 1000000.0f;
+
+        HOST_TEST_EQ(_TmprHost_FloatGet(&fFloat), HAL_TMPR_OK);
+        HOST_TEST_EQ(Hal_Tmpr_TemperatureGet(0, &fPatch), HAL_TMPR_OK);
+        HOST_TEST_EQ(Hal_Tmpr_MilliDegreeGet(0, &lFix), HAL_TMPR_OK);
+        HOST_TEST_EQ(_TmprHost_FloatMilli(fPatch), lFix);
+
+        ulDiff = (uint32_t)abs(lFix - _TmprHost_FloatMilli(fFloat));
+        if (ulDiff > ulMax)
+            ulMax = ulDiff;
+    }
+    printf("  1000 ~ 2300 mV at 3300 mV: max difference %u milli-degree\n", ulMax);
+    HOST_TEST_ASSERT(ulMax <= TMPR_HOST_READ_TOL);
+
+    // no voltage on the divider: the coldest, at the battery: the hottest
+    g_tTmprHostAux.fIo = 0;
+    HOST_TEST_EQ(Hal_Tmpr_MilliDegreeGet(0, &lFix), HAL_TMPR_OK);
+    HOST_TEST_EQ(lFix, 25000);
+    g_tTmprHostAux.fIo = 3.3f;
+    HOST_TEST_EQ(Hal_Tmpr_MilliDegreeGet(0, &lFix), HAL_TMPR_OK);
+    HOST_TEST_EQ(lFix, 25000 + (HAL_TMPR_STEP_MAX - 1) * HAL_TMPR_FIX_MILLI);
+
+    g_tTmprHostAux.fIo = 1.65f;
+    HOST_TEST_EQ(Hal_Tmpr_MilliDegreeGet(0, &lFix), HAL_TMPR_OK);
+    HOST_TEST_EQ(Hal_Tmpr_OffsetSet(-2500), HAL_TMPR_OK);
+    HOST_TEST_EQ(Hal_Tmpr_TemperatureGet(0, &fPatch), HAL_TMPR_OK);
+    HOST_TEST_EQ(_TmprHost_FloatMilli(fPatch), lFix - 2500);
+
+    g_tTmprHostAux.ubFail = 1;
+    HOST_TEST_EQ(Hal_Tmpr_TemperatureGet(0, &fPatch), HAL_TMPR_FAIL);
+    g_tTmprHostAux.ubFail = 0;
+
+    HOST_TEST_EQ(Hal_Tmpr_OffsetSet(0), HAL_TMPR_OK);
+}
+
+// a table the binary search cannot use: the ROM float code, plus the offset
+static void _TmprHost_Fallback(void)
+{
+    T_HalTmprCalData tCal;
+    int32_t lFix;
+    float fFloat;
+    float fPatch;
+
+    memcpy(&tCal, &g_tMwFimDefaultCalTmpr_patch, sizeof(T_HalTmprCalData));
+    tCal.faThermistor[10] = tCal.faThermistor[9];
+    memcpy(&g_tHalTmpr_CalData, &tCal, sizeof(T_HalTmprCalData));
+    HOST_TEST_EQ(Hal_Tmpr_FixTableUpdate(), HAL_TMPR_FAIL);
+
+    HOST_TEST_EQ(Hal_Tmpr_CompareResistorFix(33000, &lFix), HAL_TMPR_FAIL);
+    HOST_TEST_EQ(Hal_Tmpr_CompareResistor(33.0f, &fPatch), HAL_TMPR_OK);
+    HOST_TEST_EQ(Hal_Tmpr_CompareResistor_impl(33.0f, &fFloat), HAL_TMPR_OK);
+    HOST_TEST_ASSERT(fPatch == fFloat);
+
+    g_tTmprHostAux.fVbat = 3.3f;
+    g_tTmprHostAux.fIo = 1.5f;
+    HOST_TEST_EQ(Hal_Tmpr_MilliDegreeGet(0, &lFix), HAL_TMPR_FAIL);
+    HOST_TEST_EQ(Hal_Tmpr_OffsetSet(500), HAL_TMPR_OK);
+    HOST_TEST_EQ(_TmprHost_FloatGet(&fFloat), HAL_TMPR_OK);
+    HOST_TEST_EQ(Hal_Tmpr_TemperatureGet(0, &fPatch), HAL_TMPR_OK);
+    HOST_TEST_ASSERT(fabsf(fPatch - (fFloat + 0.5f)) < 1e-4f);
+
+    HOST_TEST_EQ(Hal_Tmpr_OffsetSet(0), HAL_TMPR_OK);
+    _TmprHost_TableSet(&g_tMwFimDefaultCalTmpr_patch);
+}
+
+// the offset is written to MW_FIM first and kept only when that worked
+static void _TmprHost_Offset(void)
+{
+    uint32_t ulWrite = g_tTmprHostFim.ulWrite;
+
+    HOST_TEST_EQ(Hal_Tmpr_OffsetSet(-750), HAL_TMPR_OK);
+    HOST_TEST_EQ(Hal_Tmpr_OffsetGet(), -750);
+    HOST_TEST_EQ(g_tTmprHostFim.lOffset, -750);
+    HOST_TEST_EQ(g_tTmprHostFim.ulWrite, ulWrite + 1);
+
+    g_tTmprHostFim.ubWriteFail = 1;
+    HOST_TEST_EQ(Hal_Tmpr_OffsetSet(900), HAL_TMPR_FAIL);
+    HOST_TEST_EQ(Hal_Tmpr_OffsetGet(), -750);
+    g_tTmprHostFim.ubWriteFail = 0;
+
+    // read back on the next cold boot
+    Hal_Tmpr_Init();
+    HOST_TEST_EQ(Hal_Tmpr_OffsetGet(), -750);
+
+    HOST_TEST_EQ(Hal_Tmpr_OffsetSet(0), HAL_TMPR_OK);
+}
+
+// TSC cycles per conversion of the ROM linear float search and of the integer one
+static void _TmprHost_Bench(void)
+{
+    static uint32_t ulaOhm[TMPR_HOST_BENCH_NUM];
+    static float faKohm[TMPR_HOST_BENCH_NUM];
+    const T_HalTmprCalData *ptCal = &g_tMwFimDefaultCalTmpr_patch;
+    uint32_t ulHigh = (uint32_t)(ptCal->faThermistor[0] * HAL_TMPR_FIX_OHM_PER_UNIT);
+    uint32_t ulLow = (uint32_t)(ptCal->faThermistor[HAL_TMPR_STEP_MAX - 1] * HAL_TMPR_FIX_OHM_PER_UNIT);
+    volatile int64_t llSink = 0;
+    uint64_t ullFloat;
+    uint64_t ullFix;
+    int32_t lFix;
+    float fFloat;
+    uint32_t i;
+
+    _TmprHost_TableSet(ptCal);
+
+    for (i = 0; i < TMPR_HOST_BENCH_NUM; i++)
+    {
+        ulaOhm[i] = ulLow + (uint32_t)(((uint64_t)(ulHigh - ulLow) * i) / TMPR_HOST_BENCH_NUM);
+        faKohm[i] = (float)ulaOhm[i] / HAL_TMPR_FIX_OHM_PER_UNIT;
+    }
+
+    ullFloat = __builtin_ia32_rdtsc();
+    for (i = 0; i < TMPR_HOST_BENCH_NUM; i++)
+    {
+        Hal_Tmpr_CompareResistor_impl(faKohm[i], &fFloat);
+        llSink += (int64_t)fFloat;
+    }
+    ullFloat = __builtin_ia32_rdtsc() - ullFloat;
+
+    ullFix = __builtin_ia32_rdtsc();
+    for (i = 0; i < TMPR_HOST_BENCH_NUM; i++)
+    {
+        Hal_Tmpr_CompareResistorFix(ulaOhm[i], &lFix);
+        llSink += lFix;
+    }
+    ullFix = __builtin_ia32_rdtsc() - ullFix;
+
+    printf("  cycles per conversion: float %llu, fixed %llu\n",
+           (unsigned long long)(ullFloat / TMPR_HOST_BENCH_NUM), (unsigned long long)(ullFix / TMPR_HOST_BENCH_NUM));
+    HOST_TEST_ASSERT(llSink != 0);
+}
+
+static const T_HostTestCase g_taTmprHostCase[] =
+{
+    HOST_TEST_CASE(_TmprHost_Init),
+    HOST_TEST_CASE(_TmprHost_SweepTable),
+    HOST_TEST_CASE(_TmprHost_Edges),
+    HOST_TEST_CASE(_TmprHost_Reading),
+    HOST_TEST_CASE(_TmprHost_Fallback),
+    HOST_TEST_CASE(_TmprHost_Offset),
+    HOST_TEST_CASE(_TmprHost_Bench),
+};
+
+int main(void)
+{
+    HostOs_Init();
+
+    MwFim_FileRead = _TmprHost_FimRead;
+    MwFim_FileWrite = _TmprHost_FimWrite;
+    Hal_Aux_VbatGet = _TmprHost_VbatGet;
+    Hal_Aux_IoVoltageGet = _TmprHost_IoVoltageGet;
+
+    // the driver as peri_patch_init.c installs it
+    Hal_Tmpr_PreInitCold();
+    Hal_Tmpr_Init = Hal_Tmpr_Init_patch;
+    Hal_Tmpr_TemperatureGet = Hal_Tmpr_TemperatureGet_patch;
+    Hal_Tmpr_CompareResistor = Hal_Tmpr_CompareResistor_patch;
+
+    return HostTest_Run("hal_temperature", g_taTmprHostCase, HOST_TEST_NUM(g_taTmprHostCase));
+}
@@ -0,0 +1,763 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  host_flash.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  SPI flash simulator behind the SPI0 registers, see host_flash.h.
+*
+*  The part decodes each transaction frame by frame: frame 0 is the
+*  command, the address follows, then the mode/dummy bytes and the data.
+*  Programs, erases and status writes take effect when CS goes high and keep
+*  WIP set for their duration; an erase clears the sector when it ends, so a
+*  reset in between leaves it half erased, as a power cut does.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdlib.h>
+#include <string.h>
+#include "opl1000.h"
+#include "hal_spi.h"
+#include "hal_flash_internal.h"
+#include "host_os.h"
+#include "host_reg.h"
+#include "host_flash.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HOST_FLASH_TXFLR        (SPI0_BASE + 0x20)
+#define HOST_FLASH_RXFLR        (SPI0_BASE + 0x24)
+#define HOST_FLASH_SR           (SPI0_BASE + 0x28)
+#define HOST_FLASH_DR           (SPI0_BASE + 0x60)
+#define HOST_FLASH_DR_END       (SPI0_BASE + 0xF0)
+
+#define HOST_FLASH_SR_TX_NOT_FULL   (1<<1)
+#define HOST_FLASH_SR_TX_EMPTY      (1<<2)
+#define HOST_FLASH_SR_RX_NOT_EMPTY  (1<<3)
+#define HOST_FLASH_SR_RX_FULL       (1<<4)
+
+#define HOST_FLASH_FIFO_MAX     (16)
+
+#define HOST_FLASH_SR1_WIP      (0x01)
+#define HOST_FLASH_SR1_WEL      (0x02)
+#define HOST_FLASH_SR1_QE_MX    (0x40)
+#define HOST_FLASH_SR2_QE       (0x02)
+#define HOST_FLASH_SR2_SUS      (0x80)
+#define HOST_FLASH_SCUR_ESB_MX  (0x08)
+
+#define HOST_FLASH_TYPE         (0x40)
+#define HOST_FLASH_GARBAGE      (0x5B)
+
+#define HOST_FLASH_NONE         (0xFFFFFFFF)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef enum
+{
+    HOST_FLASH_OP_NONE = 0,
+    HOST_FLASH_OP_ERASE,
+    HOST_FLASH_OP_PROGRAM,
+    HOST_FLASH_OP_STATUS
+} E_HostFlashOp;
+
+typedef struct
+{
+    T_HostFlashCfg tCfg;
+    uint8_t *pu8Mem;
+
+    uint8_t u8Wel;
+    uint8_t u8Qe;
+    uint8_t u8ResetEn;              // 0x66 was the last command
+
+    // the transaction of the current CS assertion
+    uint8_t u8InCs;
+    uint8_t u8Cmd;
+    uint8_t u8Bad;
+    uint8_t u8Busy;                 // the part was busy at the command
+    uint32_t u32Idx;
+    uint32_t u32Addr;
+    uint32_t u32Len;
+    uint8_t u8aData[HOST_FLASH_PAGE_SIZE];
+
+    // the running operation
+    E_HostFlashOp eOp;
+    uint32_t u32OpAddr;
+    uint64_t u64OpEndUs;
+    uint64_t u64OpLeftUs;           // of a suspended erase
+    uint8_t u8Suspended;
+    uint64_t u64SettleEndUs;        // WIP of the suspend command
+
+    uint32_t u32aRx[HOST_FLASH_FIFO_MAX];
+    uint32_t u32RxHead;
+    uint32_t u32RxNum;
+    uint32_t u32NsLeft;             // below 1 us, not given to the clock yet
+    uint32_t u32Garbage;
+
+    T_HostFlashStat tStat;
+    T_HostFlashLog taLog[HOST_FLASH_LOG_MAX];
+    uint32_t u32LogNum;             // ever written
+} T_HostFlashDev;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_HostFlashDev g_tHostFlash;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static uint8_t _HostFlash_IsMx(void)
+{
+    return (g_tHostFlash.tCfg.u8Vendor == MACRONIX_ID);
+}
+
+static void _HostFlash_OpEnd(void)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+
+    if (ptDev->eOp == HOST_FLASH_OP_ERASE)
+    {
+        memset(&ptDev->pu8Mem[ptDev->u32OpAddr], 0xFF, HOST_FLASH_SECTOR_SIZE);
+        ptDev->tStat.u32EraseDone++;
+    }
+
+    ptDev->eOp = HOST_FLASH_OP_NONE;
+    ptDev->u8Suspended = 0;
+}
+
+// finish the operation whose time has passed
+static void _HostFlash_Update(void)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+
+    if ((ptDev->eOp != HOST_FLASH_OP_NONE) && !ptDev->u8Suspended && (HostOs_TimeUs() >= ptDev->u64OpEndUs))
+        _HostFlash_OpEnd();
+}
+
+static uint8_t _HostFlash_IsBusy(void)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+
+    if (HostOs_TimeUs() < ptDev->u64SettleEndUs)
+        return 1;
+
+    return ((ptDev->eOp != HOST_FLASH_OP_NONE) && !ptDev->u8Suspended);
+}
+
+static void _HostFlash_OpStart(E_HostFlashOp eOp, uint32_t u32Addr, uint32_t u32Us)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+
+    ptDev->eOp = eOp;
+    ptDev->u32OpAddr = u32Addr;
+    ptDev->u64OpEndUs = HostOs_TimeUs() + u32Us;
+    ptDev->u8Suspended = 0;
+    ptDev->u8Wel = 0;
+}
+
+// bytes after the command before the data phase: address, mode and dummy
+static uint32_t _HostFlash_HeaderNum(uint8_t u8Cmd)
+{
+    switch (u8Cmd)
+    {
+        case 0x03:
+        case 0x02:
+        case 0x32:
+        case 0x38:
+        case 0x20:
+            return 3;
+
+        case 0x0B:
+        case 0x6B:
+            return 4;
+
+        case 0xEB:
+            return 6;
+
+        default:
+            return 0;
+    }
+}
+
+// lanes the part expects for frame u32Idx of the command
+static uint8_t _HostFlash_Lanes(uint8_t u8Cmd, uint32_t u32Idx)
+{
+    if (u32Idx == 0)
+        return 1;
+
+    switch (u8Cmd)
+    {
+        case 0xEB:
+        case 0x38:
+            return 4;
+
+        case 0x6B:
+            return (u32Idx >= 5) ? 4 : 1;
+
+        case 0x32:
+            return (u32Idx >= 4) ? 4 : 1;
+
+        default:
+            return 1;
+    }
+}
+
+// 1: the part decodes the command, 0: not a command of this vendor
+static uint8_t _HostFlash_Known(uint8_t u8Cmd)
+{
+    switch (u8Cmd)
+    {
+        case 0x9F: case 0x05: case 0x35: case 0x15: case 0x06: case 0x04: case 0x01:
+        case 0x03: case 0x0B: case 0x6B: case 0xEB: case 0x02: case 0x20: case 0x66: case 0x99:
+            return 1;
+
+        case 0x38: case 0x2B: case 0xB0: case 0x30:
+            return _HostFlash_IsMx();
+
+        case 0x32: case 0x75: case 0x7A:
+            return !_HostFlash_IsMx();
+
+        default:
+            return 0;
+    }
+}
+
+// 1: the command is taken while an operation runs
+static uint8_t _HostFlash_BusyAllowed(uint8_t u8Cmd)
+{
+    switch (u8Cmd)
+    {
+        case 0x05: case 0x35: case 0x15: case 0x2B:
+        case 0xB0: case 0x30: case 0x75: case 0x7A:
+        case 0x66: case 0x99:
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+static uint8_t _HostFlash_NeedQe(uint8_t u8Cmd)
+{
+    return ((u8Cmd == 0x6B) || (u8Cmd == 0xEB) || (u8Cmd == 0x32) || (u8Cmd == 0x38));
+}
+
+static uint8_t _HostFlash_Sr1(void)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+    uint8_t u8Sr = 0;
+
+    if (_HostFlash_IsBusy())
+        u8Sr |= HOST_FLASH_SR1_WIP;
+    if (ptDev->u8Wel)
+        u8Sr |= HOST_FLASH_SR1_WEL;
+    if (_HostFlash_IsMx() && ptDev->u8Qe)
+        u8Sr |= HOST_FLASH_SR1_QE_MX;
+
+    return u8Sr;
+}
+
+static uint8_t _HostFlash_Garbage(void)
+{
+    // what floats on the data lines: not the data, not 0xFF either
+    g_tHostFlash.u32Garbage = g_tHostFlash.u32Garbage * 13 + 7;
+    return (uint8_t)(HOST_FLASH_GARBAGE ^ g_tHostFlash.u32Garbage);
+}
+
+// the byte the part drives on MISO for a data frame of a read
+static uint8_t _HostFlash_ReadByte(uint8_t u8Lanes)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+    uint32_t u32Addr = ptDev->u32Addr + ptDev->u32Len;
+    uint8_t u8Ok = 1;
+
+    u32Addr %= ptDev->tCfg.u32Size;
+    ptDev->tStat.u32ReadBytes++;
+
+    if (ptDev->u8Bad || ptDev->u8Busy)
+        u8Ok = 0;
+    else if ((u8Lanes == 4) && ptDev->tCfg.u8QuadBroken)
+        u8Ok = 0;
+    else if (ptDev->u8Suspended && ((u32Addr & ~(HOST_FLASH_SECTOR_SIZE - 1)) == ptDev->u32OpAddr))
+        u8Ok = 0;
+
+    if (!u8Ok)
+    {
+        ptDev->tStat.u32BadRead++;
+        return _HostFlash_Garbage();
+    }
+
+    return ptDev->pu8Mem[u32Addr];
+}
+
+static uint8_t _HostFlash_Answer(uint8_t u8Byte, uint8_t u8Lanes)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+    uint32_t u32Idx = ptDev->u32Idx;
+    uint32_t u32Header = _HostFlash_HeaderNum(ptDev->u8Cmd);
+
+    if (u32Idx == 0)
+        return 0xFF;
+
+    if ((u32Idx <= 3) && (u32Header >= 3))
+    {
+        ptDev->u32Addr = (ptDev->u32Addr << 8) | u8Byte;
+        return 0xFF;
+    }
+
+    if (u32Idx <= u32Header)
+        return 0xFF;
+
+    switch (ptDev->u8Cmd)
+    {
+        case 0x9F:
+            if (u32Idx == 1)
+                return ptDev->tCfg.u8Vendor;
+            if (u32Idx == 2)
+                return HOST_FLASH_TYPE;
+            if (u32Idx == 3)
+            {
+                uint8_t u8Density = 0;
+
+                while ((1UL << u8Density) < ptDev->tCfg.u32Size)
+                    u8Density++;
+
+                return u8Density;
+            }
+            return 0xFF;
+
+        case 0x05:
+            return _HostFlash_Sr1();
+
+        case 0x35:
+            return (ptDev->u8Qe ? HOST_FLASH_SR2_QE : 0) | (ptDev->u8Suspended ? HOST_FLASH_SR2_SUS : 0);
+
+        case 0x2B:
+            return (ptDev->u8Suspended ? HOST_FLASH_SCUR_ESB_MX : 0);
+
+        case 0x03:
+        case 0x0B:
+        case 0x6B:
+        case 0xEB:
+            u8Byte = _HostFlash_ReadByte(u8Lanes);
+            ptDev->u32Len++;
+            return u8Byte;
+
+        case 0x01:
+        case 0x02:
+        case 0x32:
+        case 0x38:
+            if (ptDev->u32Len < HOST_FLASH_PAGE_SIZE)
+                ptDev->u8aData[ptDev->u32Len] = u8Byte;
+            ptDev->u32Len++;
+            return 0xFF;
+
+        default:
+            return 0xFF;
+    }
+}
+
+static void _HostFlash_Program(void)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+    uint32_t u32Page = ptDev->u32Addr & ~(HOST_FLASH_PAGE_SIZE - 1);
+    uint32_t u32Num = ptDev->u32Len;
+    uint32_t i;
+
+    if ((ptDev->u32Addr >= ptDev->tCfg.u32Size) || (u32Num == 0))
+        return;
+
+    if (u32Num > HOST_FLASH_PAGE_SIZE)
+        u32Num = HOST_FLASH_PAGE_SIZE;
+
+    // the address wraps within the page, the bits only go from 1 to 0
+    for (i = 0; i < u32Num; i++)
+        ptDev->pu8Mem[u32Page + ((ptDev->u32Addr + i) & (HOST_FLASH_PAGE_SIZE - 1))] &= ptDev->u8aData[i];
+
+    _HostFlash_OpStart(HOST_FLASH_OP_PROGRAM, u32Page, ptDev->tCfg.u32PageUs);
+}
+
+static void _HostFlash_Reset(void)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+
+    if (ptDev->eOp == HOST_FLASH_OP_ERASE)
+    {
+        // cut half way: the sector is neither the old data nor blank
+        memset(&ptDev->pu8Mem[ptDev->u32OpAddr], 0xFF, HOST_FLASH_SECTOR_SIZE / 2);
+        ptDev->tStat.u32Aborted++;
+    }
+    else if (ptDev->eOp != HOST_FLASH_OP_NONE)
+    {
+        ptDev->tStat.u32Aborted++;
+    }
+
+    ptDev->eOp = HOST_FLASH_OP_NONE;
+    ptDev->u8Suspended = 0;
+    ptDev->u64SettleEndUs = 0;
+    ptDev->u8Wel = 0;
+}
+
+// CS high: the command takes effect
+static void _HostFlash_End(void)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+    T_HostFlashLog *ptLog = &ptDev->taLog[ptDev->u32LogNum % HOST_FLASH_LOG_MAX];
+    uint8_t u8Cmd = ptDev->u8Cmd;
+    uint8_t u8Done = 1;
+    uint8_t u8ResetEn = 0;
+    uint64_t u64Now = HostOs_TimeUs();
+
+    ptDev->tStat.u32aCmd[u8Cmd]++;
+
+    if (ptDev->u8Bad || ptDev->u8Busy)
+    {
+        u8Done = 0;
+    }
+    else
+    {
+        switch (u8Cmd)
+        {
+            case 0x06:
+                ptDev->u8Wel = 1;
+                break;
+
+            case 0x04:
+                ptDev->u8Wel = 0;
+                break;
+
+            case 0x01:
+                if (!ptDev->u8Wel || (ptDev->u32Len == 0))
+                {
+                    u8Done = 0;
+                    break;
+                }
+                if (_HostFlash_IsMx())
+                    ptDev->u8Qe = !!(ptDev->u8aData[0] & HOST_FLASH_SR1_QE_MX);
+                else if (ptDev->u32Len >= 2)
+                    ptDev->u8Qe = !!(ptDev->u8aData[1] & HOST_FLASH_SR2_QE);
+                _HostFlash_OpStart(HOST_FLASH_OP_STATUS, 0, ptDev->tCfg.u32StatusUs);
+                break;
+
+            case 0x02:
+            case 0x32:
+            case 0x38:
+                if (!ptDev->u8Wel || (ptDev->u32Idx < 4) ||
+                    (ptDev->u8Suspended && ((ptDev->u32Addr & ~(HOST_FLASH_SECTOR_SIZE - 1)) == ptDev->u32OpAddr)))
+                {
+                    u8Done = 0;
+                    break;
+                }
+                _HostFlash_Program();
+                break;
+
+            case 0x20:
+                if (!ptDev->u8Wel || (ptDev->u32Idx != 4) || ptDev->u8Suspended ||
+                    (ptDev->u32Addr >= ptDev->tCfg.u32Size))
+                {
+                    u8Done = 0;
+                    break;
+                }
+                _HostFlash_OpStart(HOST_FLASH_OP_ERASE, ptDev->u32Addr & ~(HOST_FLASH_SECTOR_SIZE - 1), ptDev->tCfg.u32EraseUs);
+                break;
+
+            case 0xB0:
+            case 0x75:
+                if ((ptDev->eOp != HOST_FLASH_OP_ERASE) || ptDev->u8Suspended)
+                {
+                    u8Done = 0;
+                    break;
+                }
+                ptDev->u64OpLeftUs = (ptDev->u64OpEndUs > u64Now) ? (ptDev->u64OpEndUs - u64Now) : 0;
+                ptDev->u8Suspended = 1;
+                ptDev->u64SettleEndUs = u64Now + ptDev->tCfg.u32SuspendUs;
+                ptDev->tStat.u32Suspend++;
+                break;
+
+            case 0x30:
+            case 0x7A:
+                if (!ptDev->u8Suspended)
+                {
+                    u8Done = 0;
+                    break;
+                }
+                ptDev->u8Suspended = 0;
+                ptDev->u64OpEndUs = u64Now + ptDev->u64OpLeftUs;
+                break;
+
+            case 0x66:
+                u8ResetEn = 1;
+                break;
+
+            case 0x99:
+                if (!ptDev->u8ResetEn)
+                {
+                    u8Done = 0;
+                    break;
+                }
+                _HostFlash_Reset();
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if (!u8Done)
+        ptDev->tStat.u32Ignored++;
+
+    ptDev->u8ResetEn = u8ResetEn;
+
+    ptLog->u8Cmd = u8Cmd;
+    ptLog->u8Bad = !u8Done;
+    ptLog->u32Addr = (_HostFlash_HeaderNum(u8Cmd) >= 3) ? ptDev->u32Addr : 0;
+    ptLog->u32Len = ptDev->u32Len;
+    ptLog->u64Us = u64Now;
+    ptDev->u32LogNum++;
+
+    ptDev->u8InCs = 0;
+}
+
+// the bus time of a frame, given to the clock of host_os
+static void _HostFlash_Clock(uint8_t u8Lanes)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+    uint32_t u32BusNs = 8000000 / (u8Lanes * ptDev->tCfg.u32ClkKhz);
+    uint32_t u32Ns;
+
+    if (ptDev->u32RxNum == 0)
+        u32Ns = u32BusNs + ptDev->tCfg.u32TurnNs;
+    else
+        u32Ns = (u32BusNs > ptDev->tCfg.u32CpuNs) ? u32BusNs : ptDev->tCfg.u32CpuNs;
+
+    ptDev->tStat.u64BusNs += u32Ns;
+    ptDev->u32NsLeft += u32Ns;
+
+    if (ptDev->u32NsLeft >= 1000)
+    {
+        HostOs_TimeAdvanceUs(ptDev->u32NsLeft / 1000);
+        ptDev->u32NsLeft %= 1000;
+    }
+}
+
+static void _HostFlash_Frame(uint32_t u32Frame)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+    uint8_t u8Byte = (uint8_t)(u32Frame & 0xFF);
+    uint8_t u8Lanes = ((u32Frame & TAG_4_BIT) == TAG_4_BIT) ? 4 : 1;
+    uint8_t u8Out;
+
+    _HostFlash_Clock(u8Lanes);
+    _HostFlash_Update();
+    ptDev->tStat.u32Frames++;
+
+    if (!ptDev->u8InCs)
+    {
+        ptDev->u8InCs = 1;
+        ptDev->u8Cmd = u8Byte;
+        ptDev->u8Bad = 0;
+        ptDev->u8Busy = 0;
+        ptDev->u32Idx = 0;
+        ptDev->u32Addr = 0;
+        ptDev->u32Len = 0;
+
+        if (!_HostFlash_Known(u8Byte))
+            ptDev->u8Bad = 1;
+        else if (_HostFlash_NeedQe(u8Byte) && !ptDev->u8Qe)
+            ptDev->u8Bad = 1;
+        else if (_HostFlash_IsBusy() && !_HostFlash_BusyAllowed(u8Byte))
+            ptDev->u8Busy = 1;
+    }
+
+    // a phase in the wrong width, or quad bits the board does not carry
+    if (u8Lanes != _HostFlash_Lanes(ptDev->u8Cmd, ptDev->u32Idx))
+        ptDev->u8Bad = 1;
+    else if ((u8Lanes == 4) && ptDev->tCfg.u8QuadBroken && (ptDev->u32Idx <= _HostFlash_HeaderNum(ptDev->u8Cmd)))
+        ptDev->u8Bad = 1;
+
+    u8Out = _HostFlash_Answer(u8Byte, u8Lanes);
+    ptDev->u32Idx++;
+
+    if (ptDev->u32RxNum < HOST_FLASH_FIFO_MAX)
+    {
+        ptDev->u32aRx[(ptDev->u32RxHead + ptDev->u32RxNum) % HOST_FLASH_FIFO_MAX] = u8Out;
+        ptDev->u32RxNum++;
+    }
+
+    if (u32Frame & TAG_CS_COMP)
+        _HostFlash_End();
+}
+
+static uint32_t _HostFlash_RegRead(uint32_t u32Addr, uint32_t u32Val, void *pArg)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+
+    if ((u32Addr >= HOST_FLASH_DR) && (u32Addr < HOST_FLASH_DR_END))
+    {
+        if (ptDev->u32RxNum == 0)
+            return 0;
+
+        u32Val = ptDev->u32aRx[ptDev->u32RxHead];
+        ptDev->u32RxHead = (ptDev->u32RxHead + 1) % HOST_FLASH_FIFO_MAX;
+        ptDev->u32RxNum--;
+        return u32Val;
+    }
+
+    switch (u32Addr)
+    {
+        case HOST_FLASH_SR:
+            u32Val = HOST_FLASH_SR_TX_NOT_FULL | HOST_FLASH_SR_TX_EMPTY;
+            if (ptDev->u32RxNum)
+                u32Val |= HOST_FLASH_SR_RX_NOT_EMPTY;
+            if (ptDev->u32RxNum >= HOST_FLASH_FIFO_MAX)
+                u32Val |= HOST_FLASH_SR_RX_FULL;
+            return u32Val;
+
+        case HOST_FLASH_RXFLR:
+            return ptDev->u32RxNum;
+
+        case HOST_FLASH_TXFLR:
+            return 0;
+
+        default:
+            return u32Val;
+    }
+}
+
+static void _HostFlash_RegWrite(uint32_t u32Addr, uint32_t u32Val, void *pArg)
+{
+    if ((u32Addr >= HOST_FLASH_DR) && (u32Addr < HOST_FLASH_DR_END))
+        _HostFlash_Frame(u32Val);
+}
+
+void HostFlash_CfgDefault(T_HostFlashCfg *ptCfg, uint8_t u8Vendor)
+{
+    memset(ptCfg, 0, sizeof(T_HostFlashCfg));
+
+    ptCfg->u8Vendor = u8Vendor;
+    ptCfg->u8QuadEnable = 1;
+    ptCfg->u32Size = 0x100000;
+    ptCfg->u32ClkKhz = 20000;
+    ptCfg->u32CpuNs = 250;
+    ptCfg->u32TurnNs = 1500;
+    ptCfg->u32EraseUs = 30000;
+    ptCfg->u32PageUs = 700;
+    ptCfg->u32StatusUs = 5000;
+    ptCfg->u32SuspendUs = 20;
+}
+
+int HostFlash_Init(const T_HostFlashCfg *ptCfg)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+    uint8_t *pu8Mem;
+
+    if ((ptCfg->u32Size < HOST_FLASH_SECTOR_SIZE) || (ptCfg->u32ClkKhz == 0))
+        return -1;
+
+    pu8Mem = realloc(ptDev->pu8Mem, ptCfg->u32Size);
+    if (pu8Mem == NULL)
+        return -1;
+
+    memset(ptDev, 0, sizeof(T_HostFlashDev));
+    ptDev->tCfg = *ptCfg;
+    ptDev->pu8Mem = pu8Mem;
+    ptDev->u8Qe = ptCfg->u8QuadEnable;
+    memset(pu8Mem, 0xFF, ptCfg->u32Size);
+
+    return HostReg_Hook(SPI0_BASE, _HostFlash_RegRead, _HostFlash_RegWrite, NULL);
+}
+
+uint8_t *HostFlash_Mem(void)
+{
+    return g_tHostFlash.pu8Mem;
+}
+
+void HostFlash_StatGet(T_HostFlashStat *ptStat)
+{
+    *ptStat = g_tHostFlash.tStat;
+}
+
+void HostFlash_StatReset(void)
+{
+    memset(&g_tHostFlash.tStat, 0, sizeof(T_HostFlashStat));
+    g_tHostFlash.u32LogNum = 0;
+}
+
+uint32_t HostFlash_LogGet(T_HostFlashLog *ptaLog, uint32_t u32Max)
+{
+    T_HostFlashDev *ptDev = &g_tHostFlash;
+    uint32_t u32Num = ptDev->u32LogNum;
+    uint32_t u32First = 0;
+    uint32_t i;
+
+    if (u32Num > HOST_FLASH_LOG_MAX)
+    {
+        u32First = u32Num - HOST_FLASH_LOG_MAX;
+        u32Num = HOST_FLASH_LOG_MAX;
+    }
+
+    if (u32Num > u32Max)
+    {
+        u32First += u32Num - u32Max;
+        u32Num = u32Max;
+    }
+
+    for (i = 0; i < u32Num; i++)
+        ptaLog[i] = ptDev->taLog[(u32First + i) % HOST_FLASH_LOG_MAX];
+
+    return u32Num;
+}
+
+uint8_t HostFlash_Busy(void)
+{
+    _HostFlash_Update();
+    return _HostFlash_IsBusy();
+}
+
+uint32_t HostFlash_SuspendedAddr(void)
+{
+    _HostFlash_Update();
+    return (g_tHostFlash.u8Suspended) ? g_tHostFlash.u32OpAddr : HOST_FLASH_NONE;
+}
+
+void HostFlash_Finish(void)
+{
+    if (!g_tHostFlash.u8Suspended)
+        _HostFlash_OpEnd();
+
+    g_tHostFlash.u64SettleEndUs = 0;
+}
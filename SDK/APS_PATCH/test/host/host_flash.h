@@ -0,0 +1,142 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  host_flash.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  SPI flash simulator of the host test build, behind the SPI0 registers of
+*  host_reg. The ROM hal_flash.c and the patches above it run unchanged: each
+*  frame written to DR (TAG_* of hal_spi.h) is one byte on the bus, answered
+*  into the RX FIFO as the part would drive MISO.
+*
+*  Commands: 0x9F, 0x05/0x35/0x15/0x2B, 0x06/0x04, 0x01, 0x03/0x0B/0x6B/0xEB,
+*  0x02/0x32/0x38, 0x20, 0x66/0x99 and the erase suspend/resume of the
+*  vendor (Macronix 0xB0/0x30, GigaDevice/Winbond 0x75/0x7A). Quad commands
+*  need the QE bit. A phase sent with the wrong lane width, a read while the
+*  part is busy or of the sector under a suspended erase, and quad data on a
+*  board without IO2/IO3 return garbage and count as a bad read: the driver
+*  sees wrong data, not a timeout, as on the bus.
+*
+*  Time is simulated at the command level. A frame takes its bus clocks
+*  (8 / lanes at u32ClkKhz); while frames are queued the CPU work per frame
+*  (u32CpuNs) overlaps the bus, and a frame written when the RX FIFO was
+*  empty pays u32TurnNs, the round trip of a driver that waits for each
+*  answer. The time is added to HostOs_TimeAdvanceUs, so Hal_Tick and
+*  osKernelSysTick see it; erase, program and status writes stay busy for
+*  their durations of that clock. Use HostOs_TimeFreeze for exact figures.
+*
+******************************************************************************/
+
+#ifndef __HOST_FLASH_H__
+#define __HOST_FLASH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sec 1: Include File
+#include <stdint.h>
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HOST_FLASH_SECTOR_SIZE  (0x1000)
+#define HOST_FLASH_PAGE_SIZE    (0x100)
+#define HOST_FLASH_LOG_MAX      (256)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    uint8_t u8Vendor;               // manufacturer ID of 0x9F, e.g. GIGADEVICE_ID
+    uint8_t u8QuadBroken;           // IO2/IO3 not wired: quad data is garbage
+    uint8_t u8QuadEnable;           // QE at power on
+    uint32_t u32Size;               // bytes
+    uint32_t u32ClkKhz;             // SCLK
+    uint32_t u32CpuNs;              // CPU work per frame, overlaps the bus
+    uint32_t u32TurnNs;             // a frame written on an empty RX FIFO
+    uint32_t u32EraseUs;            // 4 KB sector erase
+    uint32_t u32PageUs;             // page program
+    uint32_t u32StatusUs;           // write status register
+    uint32_t u32SuspendUs;          // suspend command to WIP low
+} T_HostFlashCfg;
+
+typedef struct
+{
+    uint32_t u32aCmd[256];          // transactions per opcode
+    uint32_t u32Frames;
+    uint32_t u32ReadBytes;          // data bytes of the read commands
+    uint32_t u32BadRead;            // data bytes answered with garbage
+    uint32_t u32Ignored;            // commands the part dropped: busy, WEL clear, no QE
+    uint32_t u32Suspend;            // erases suspended
+    uint32_t u32Aborted;            // erases and programs cut by a reset
+    uint32_t u32EraseDone;
+    uint64_t u64BusNs;              // time of all the frames
+} T_HostFlashStat;
+
+typedef struct
+{
+    uint8_t u8Cmd;
+    uint8_t u8Bad;                  // a phase in the wrong mode, or dropped
+    uint32_t u32Addr;               // address phase, 0 if none
+    uint32_t u32Len;                // bytes after the address and dummy phases
+    uint64_t u64Us;                 // HostOs_TimeUs at CS high
+} T_HostFlashLog;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+/*
+ * The parameters of a 1 MB part of the vendor: SCLK 20 MHz, 4 KB erase in
+ * 30 ms, page program in 0.7 ms, QE set.
+ */
+void HostFlash_CfgDefault(T_HostFlashCfg *ptCfg, uint8_t u8Vendor);
+
+/*
+ * Hook the SPI0 page of host_reg (HostReg_Init first) with a blank part of
+ * ptCfg. May be called again for another part. Returns 0 on success.
+ */
+int HostFlash_Init(const T_HostFlashCfg *ptCfg);
+
+// the array of the part, for the tests to fill and check
+uint8_t *HostFlash_Mem(void);
+
+void HostFlash_StatGet(T_HostFlashStat *ptStat);
+void HostFlash_StatReset(void);
+
+// the last transactions, oldest first; returns the count copied
+uint32_t HostFlash_LogGet(T_HostFlashLog *ptaLog, uint32_t u32Max);
+
+// 1: an erase, program or status write is running (not suspended)
+uint8_t HostFlash_Busy(void);
+
+// the start of the suspended erase, 0xFFFFFFFF if none
+uint32_t HostFlash_SuspendedAddr(void);
+
+// end the running operation now, as if its time had passed
+void HostFlash_Finish(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HOST_FLASH_H__
@@ -0,0 +1,928 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  host_os.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The CMSIS-RTOS API of the SDK is a table of function pointers loaded by
+*  the ROM; the host test build loads it here with pthread implementations
+*  instead, so the patch sources run unchanged on Linux.
+*
+*  - semaphores, mutexes, message queues: mutex + condition variable
+*  - threads: one pthread each, osThreadGetId() is the calling thread
+*  - timers: one pthread each, the callbacks run in it like in the timer task
+*  - PRIMASK: one recursive lock for the whole "core", see HostOs_IrqSet()
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "cmsis_os.h"
+#include "msg.h"
+#include "diag_task.h"
+#include "host_os.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HOST_OS_NAME_LEN        (16)
+#define HOST_OS_PARAM_DELIM     " \t\r\n"
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    pthread_mutex_t tLock;
+    pthread_cond_t tCond;
+    uint32_t u32Count;
+    uint32_t u32Max;
+} T_HostOsSem;
+
+typedef struct
+{
+    pthread_mutex_t tLock;
+    pthread_cond_t tCond;
+    uint32_t *pu32Buf;
+    uint32_t u32Size;
+    uint32_t u32Head;
+    uint32_t u32Num;
+} T_HostOsQueue;
+
+typedef struct
+{
+    pthread_t tThread;
+    os_pthread fpFunc;
+    void *pArg;
+    char baName[HOST_OS_NAME_LEN];
+} T_HostOsThread;
+
+typedef struct
+{
+    pthread_t tThread;
+    pthread_mutex_t tLock;
+    pthread_cond_t tCond;
+    os_ptimer fpFunc;
+    void *pArg;
+    os_timer_type eType;
+    uint32_t u32PeriodMs;
+    uint64_t u64DueUs;
+    uint8_t u8Run;
+    uint8_t u8Exit;
+} T_HostOsTimer;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static pthread_mutex_t g_tHostOsIrqLock;
+static pthread_once_t g_tHostOsOnce = PTHREAD_ONCE_INIT;
+static uint64_t g_u64HostOsStartUs;
+static volatile uint64_t g_u64HostOsAdvanceUs;
+static volatile uint64_t g_u64HostOsFrozenUs;
+static volatile uint8_t g_u8HostOsFrozen;
+static T_HostOsWfiFp g_fpHostOsWfi;
+
+static __thread uint32_t g_u32HostOsPrimask;
+static __thread uint32_t g_u32HostOsIpsr;
+static __thread uint32_t g_u32HostOsCritNest;
+static __thread uint32_t g_u32HostOsCritSaved;
+static __thread T_HostOsThread *g_ptHostOsSelf;
+
+static T_HostOsThread g_tHostOsMainThread = { .baName = "main" };
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static uint64_t _HostOs_MonoUs(void)
+{
+    struct timespec tTs;
+
+    clock_gettime(CLOCK_MONOTONIC, &tTs);
+    return ((uint64_t)tTs.tv_sec * 1000000) + ((uint64_t)tTs.tv_nsec / 1000);
+}
+
+static void _HostOs_Once(void)
+{
+    pthread_mutexattr_t tAttr;
+
+    pthread_mutexattr_init(&tAttr);
+    pthread_mutexattr_settype(&tAttr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&g_tHostOsIrqLock, &tAttr);
+    pthread_mutexattr_destroy(&tAttr);
+
+    g_u64HostOsStartUs = _HostOs_MonoUs();
+}
+
+static void _HostOs_CondInit(pthread_mutex_t *ptLock, pthread_cond_t *ptCond)
+{
+    pthread_condattr_t tAttr;
+
+    pthread_mutex_init(ptLock, NULL);
+    pthread_condattr_init(&tAttr);
+    pthread_condattr_setclock(&tAttr, CLOCK_MONOTONIC);
+    pthread_cond_init(ptCond, &tAttr);
+    pthread_condattr_destroy(&tAttr);
+}
+
+static void _HostOs_Deadline(struct timespec *ptTs, uint64_t u64Us)
+{
+    clock_gettime(CLOCK_MONOTONIC, ptTs);
+
+    u64Us += (uint64_t)ptTs->tv_nsec / 1000;
+    ptTs->tv_sec += (time_t)(u64Us / 1000000);
+    ptTs->tv_nsec = (long)((u64Us % 1000000) * 1000);
+}
+
+// 0: the condition may have changed, 1: timed out
+static int _HostOs_CondWait(pthread_cond_t *ptCond, pthread_mutex_t *ptLock, uint32_t u32Ms)
+{
+    struct timespec tTs;
+
+    if (u32Ms == osWaitForever)
+    {
+        pthread_cond_wait(ptCond, ptLock);
+        return 0;
+    }
+
+    _HostOs_Deadline(&tTs, (uint64_t)u32Ms * 1000);
+    return (pthread_cond_timedwait(ptCond, ptLock, &tTs) == ETIMEDOUT);
+}
+
+uint32_t HostOs_IrqGet(void)
+{
+    return g_u32HostOsPrimask;
+}
+
+void HostOs_IrqSet(uint32_t u32Mask)
+{
+    pthread_once(&g_tHostOsOnce, _HostOs_Once);
+
+    if ((u32Mask) && (!g_u32HostOsPrimask))
+    {
+        pthread_mutex_lock(&g_tHostOsIrqLock);
+        g_u32HostOsPrimask = 1;
+    }
+    else if ((!u32Mask) && (g_u32HostOsPrimask))
+    {
+        g_u32HostOsPrimask = 0;
+        pthread_mutex_unlock(&g_tHostOsIrqLock);
+    }
+}
+
+uint32_t HostOs_IrqSave(void)
+{
+    uint32_t u32Pm = g_u32HostOsPrimask;
+
+    HostOs_IrqSet(1);
+    return u32Pm;
+}
+
+uint32_t HostOs_IpsrGet(void)
+{
+    return g_u32HostOsIpsr;
+}
+
+/*
+ * Run fpIsr as an interrupt handler: with the "core" taken, so it cannot
+ * preempt a section under __disable_irq(), and with IPSR set.
+ */
+void HostOs_IsrRun(T_HostOsIsrFp fpIsr, void *pArg)
+{
+    HostOs_ExcRun(16, fpIsr, pArg);
+}
+
+void HostOs_ExcRun(uint32_t u32Exc, T_HostOsIsrFp fpIsr, void *pArg)
+{
+    uint32_t u32Pm = HostOs_IrqSave();
+    uint32_t u32Ipsr = g_u32HostOsIpsr;
+
+    g_u32HostOsIpsr = u32Exc;
+    fpIsr(pArg);
+    g_u32HostOsIpsr = u32Ipsr;
+
+    HostOs_IrqSet(u32Pm);
+}
+
+void vPortEnterCritical(void)
+{
+    if (g_u32HostOsCritNest++ == 0)
+        g_u32HostOsCritSaved = HostOs_IrqSave();
+}
+
+void vPortExitCritical(void)
+{
+    if ((g_u32HostOsCritNest) && (--g_u32HostOsCritNest == 0))
+        HostOs_IrqSet(g_u32HostOsCritSaved);
+}
+
+void HostOs_Yield(void)
+{
+    sched_yield();
+}
+
+/*
+ * __WFI(): the hook of the test stands for the interrupt that ends the
+ * sleep, else the other threads get the core.
+ */
+void HostOs_Wfi(void)
+{
+    if (g_fpHostOsWfi)
+        g_fpHostOsWfi();
+    else
+        sched_yield();
+}
+
+void HostOs_WfiHookSet(T_HostOsWfiFp fpWfi)
+{
+    g_fpHostOsWfi = fpWfi;
+}
+
+void HostOs_SleepUs(uint32_t u32Us)
+{
+    struct timespec tTs;
+
+    tTs.tv_sec = u32Us / 1000000;
+    tTs.tv_nsec = (long)(u32Us % 1000000) * 1000;
+
+    while (nanosleep(&tTs, &tTs) && (errno == EINTR))
+        ;
+}
+
+uint64_t HostOs_TimeUs(void)
+{
+    uint64_t u64Real;
+
+    pthread_once(&g_tHostOsOnce, _HostOs_Once);
+
+    if (g_u8HostOsFrozen)
+        u64Real = g_u64HostOsFrozenUs;
+    else
+        u64Real = _HostOs_MonoUs() - g_u64HostOsStartUs;
+
+    return u64Real + g_u64HostOsAdvanceUs;
+}
+
+void HostOs_TimeAdvanceUs(uint32_t u32Us)
+{
+    __sync_fetch_and_add(&g_u64HostOsAdvanceUs, (uint64_t)u32Us);
+}
+
+void HostOs_TimeFreeze(uint8_t u8Freeze)
+{
+    pthread_once(&g_tHostOsOnce, _HostOs_Once);
+
+    if ((u8Freeze) && (!g_u8HostOsFrozen))
+        g_u64HostOsFrozenUs = _HostOs_MonoUs() - g_u64HostOsStartUs;
+    else if ((!u8Freeze) && (g_u8HostOsFrozen))
+        g_u64HostOsStartUs = _HostOs_MonoUs() - g_u64HostOsFrozenUs;
+
+    g_u8HostOsFrozen = u8Freeze;
+}
+
+/*
+ * Kernel
+ */
+static osStatus _HostOs_KernelNop(void)
+{
+    return osOK;
+}
+
+static int32_t _HostOs_KernelRunning(void)
+{
+    return 1;
+}
+
+static uint32_t _HostOs_KernelSysTick(void)
+{
+    return (uint32_t)(HostOs_TimeUs() / 1000);
+}
+
+static void _HostOs_KernelSysTickEx(uint32_t *pulTicks, int32_t *plNumOfOverflows)
+{
+    uint64_t u64Ms = HostOs_TimeUs() / 1000;
+
+    if (pulTicks)
+        *pulTicks = (uint32_t)u64Ms;
+    if (plNumOfOverflows)
+        *plNumOfOverflows = (int32_t)(u64Ms >> 32);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return _HostOs_KernelSysTick();
+}
+
+/*
+ * Threads
+ */
+static void *_HostOs_ThreadMain(void *pArg)
+{
+    T_HostOsThread *ptThread = (T_HostOsThread *)pArg;
+
+    g_ptHostOsSelf = ptThread;
+    ptThread->fpFunc(ptThread->pArg);
+
+    // a CMSIS thread must not return, but be tolerant
+    return NULL;
+}
+
+static osThreadId _HostOs_ThreadCreate(const osThreadDef_t *thread_def, void *argument)
+{
+    T_HostOsThread *ptThread = NULL;
+    pthread_attr_t tAttr;
+
+    if ((thread_def == NULL) || (thread_def->pthread == NULL))
+        return NULL;
+
+    ptThread = (T_HostOsThread *)calloc(1, sizeof(T_HostOsThread));
+    if (ptThread == NULL)
+        return NULL;
+
+    ptThread->fpFunc = thread_def->pthread;
+    ptThread->pArg = argument;
+    if (thread_def->name)
+        strncpy(ptThread->baName, thread_def->name, HOST_OS_NAME_LEN - 1);
+
+    pthread_attr_init(&tAttr);
+    pthread_attr_setdetachstate(&tAttr, PTHREAD_CREATE_DETACHED);
+
+    if (pthread_create(&ptThread->tThread, &tAttr, _HostOs_ThreadMain, ptThread))
+    {
+        pthread_attr_destroy(&tAttr);
+        free(ptThread);
+        return NULL;
+    }
+
+    pthread_attr_destroy(&tAttr);
+    return (osThreadId)ptThread;
+}
+
+static osThreadId _HostOs_ThreadGetId(void)
+{
+    if (g_ptHostOsSelf == NULL)
+        g_ptHostOsSelf = &g_tHostOsMainThread;
+
+    return (osThreadId)g_ptHostOsSelf;
+}
+
+static osStatus _HostOs_ThreadTerminate(osThreadId thread_id)
+{
+    // only a thread ending itself can be done safely with pthreads
+    if ((thread_id != NULL) && (thread_id != _HostOs_ThreadGetId()))
+        return osErrorOS;
+
+    if (g_u32HostOsPrimask)
+        HostOs_IrqSet(0);
+
+    pthread_exit(NULL);
+    return osOK;
+}
+
+static osStatus _HostOs_ThreadYield(void)
+{
+    sched_yield();
+    return osOK;
+}
+
+static osStatus _HostOs_ThreadSetPriority(osThreadId thread_id, osPriority priority)
+{
+    (void)thread_id;
+    (void)priority;
+    return osOK;
+}
+
+static osPriority _HostOs_ThreadGetPriority(osThreadId thread_id)
+{
+    (void)thread_id;
+    return osPriorityNormal;
+}
+
+static osStatus _HostOs_Delay(uint32_t millisec)
+{
+    HostOs_SleepUs(millisec * 1000);
+    return osOK;
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    _HostOs_ThreadTerminate((osThreadId)xTaskToDelete);
+}
+
+// weak: a test that makes its own task control blocks gives its own
+__attribute__((weak)) char *pcTaskGetName(TaskHandle_t xTaskToQuery)
+{
+    T_HostOsThread *ptThread = (T_HostOsThread *)xTaskToQuery;
+
+    if (ptThread == NULL)
+        ptThread = (T_HostOsThread *)_HostOs_ThreadGetId();
+
+    return ptThread->baName;
+}
+
+/*
+ * Semaphores and mutexes
+ */
+static T_HostOsSem *_HostOs_SemNew(uint32_t u32Count, uint32_t u32Max)
+{
+    T_HostOsSem *ptSem = (T_HostOsSem *)calloc(1, sizeof(T_HostOsSem));
+
+    if (ptSem == NULL)
+        return NULL;
+
+    _HostOs_CondInit(&ptSem->tLock, &ptSem->tCond);
+    ptSem->u32Count = u32Count;
+    ptSem->u32Max = u32Max;
+    return ptSem;
+}
+
+static osStatus _HostOs_SemTake(T_HostOsSem *ptSem, uint32_t u32Ms)
+{
+    osStatus tRet = osOK;
+
+    if (ptSem == NULL)
+        return osErrorParameter;
+
+    pthread_mutex_lock(&ptSem->tLock);
+
+    while (ptSem->u32Count == 0)
+    {
+        if ((u32Ms == 0) || (_HostOs_CondWait(&ptSem->tCond, &ptSem->tLock, u32Ms)))
+        {
+            if (ptSem->u32Count == 0)
+            {
+                tRet = osErrorOS;
+                goto done;
+            }
+        }
+    }
+
+    ptSem->u32Count--;
+
+done:
+    pthread_mutex_unlock(&ptSem->tLock);
+    return tRet;
+}
+
+static osStatus _HostOs_SemGive(T_HostOsSem *ptSem)
+{
+    osStatus tRet = osOK;
+
+    if (ptSem == NULL)
+        return osErrorParameter;
+
+    pthread_mutex_lock(&ptSem->tLock);
+
+    if (ptSem->u32Count >= ptSem->u32Max)
+    {
+        tRet = osErrorOS;
+    }
+    else
+    {
+        ptSem->u32Count++;
+        pthread_cond_signal(&ptSem->tCond);
+    }
+
+    pthread_mutex_unlock(&ptSem->tLock);
+    return tRet;
+}
+
+static osStatus _HostOs_SemFree(T_HostOsSem *ptSem)
+{
+    if (ptSem == NULL)
+        return osErrorParameter;
+
+    pthread_cond_destroy(&ptSem->tCond);
+    pthread_mutex_destroy(&ptSem->tLock);
+    free(ptSem);
+    return osOK;
+}
+
+// count 1 is a binary semaphore, like the FreeRTOS port it starts given
+static osSemaphoreId _HostOs_SemaphoreCreate(const osSemaphoreDef_t *semaphore_def, int32_t count)
+{
+    (void)semaphore_def;
+
+    if (count <= 0)
+        return NULL;
+
+    return (osSemaphoreId)_HostOs_SemNew((uint32_t)count, (uint32_t)count);
+}
+
+static int32_t _HostOs_SemaphoreWait(osSemaphoreId semaphore_id, uint32_t millisec)
+{
+    return (int32_t)_HostOs_SemTake((T_HostOsSem *)semaphore_id, millisec);
+}
+
+static osStatus _HostOs_SemaphoreRelease(osSemaphoreId semaphore_id)
+{
+    return _HostOs_SemGive((T_HostOsSem *)semaphore_id);
+}
+
+static osStatus _HostOs_SemaphoreDelete(osSemaphoreId semaphore_id)
+{
+    return _HostOs_SemFree((T_HostOsSem *)semaphore_id);
+}
+
+static osMutexId _HostOs_MutexCreate(const osMutexDef_t *mutex_def)
+{
+    (void)mutex_def;
+    return (osMutexId)_HostOs_SemNew(1, 1);
+}
+
+static osStatus _HostOs_MutexWait(osMutexId mutex_id, uint32_t millisec)
+{
+    return _HostOs_SemTake((T_HostOsSem *)mutex_id, millisec);
+}
+
+static osStatus _HostOs_MutexRelease(osMutexId mutex_id)
+{
+    return _HostOs_SemGive((T_HostOsSem *)mutex_id);
+}
+
+static osStatus _HostOs_MutexDelete(osMutexId mutex_id)
+{
+    return _HostOs_SemFree((T_HostOsSem *)mutex_id);
+}
+
+/*
+ * Message queues
+ */
+static osMessageQId _HostOs_MessageCreate(const osMessageQDef_t *queue_def, osThreadId thread_id)
+{
+    T_HostOsQueue *ptQueue = NULL;
+
+    (void)thread_id;
+
+    if ((queue_def == NULL) || (queue_def->queue_sz == 0))
+        return NULL;
+
+    ptQueue = (T_HostOsQueue *)calloc(1, sizeof(T_HostOsQueue));
+    if (ptQueue == NULL)
+        return NULL;
+
+    ptQueue->pu32Buf = (uint32_t *)calloc(queue_def->queue_sz, sizeof(uint32_t));
+    if (ptQueue->pu32Buf == NULL)
+    {
+        free(ptQueue);
+        return NULL;
+    }
+
+    _HostOs_CondInit(&ptQueue->tLock, &ptQueue->tCond);
+    ptQueue->u32Size = queue_def->queue_sz;
+    return (osMessageQId)ptQueue;
+}
+
+static osStatus _HostOs_MessagePut(osMessageQId queue_id, uint32_t info, uint32_t millisec)
+{
+    T_HostOsQueue *ptQueue = (T_HostOsQueue *)queue_id;
+    osStatus tRet = osOK;
+
+    if (ptQueue == NULL)
+        return osErrorParameter;
+
+    pthread_mutex_lock(&ptQueue->tLock);
+
+    while (ptQueue->u32Num >= ptQueue->u32Size)
+    {
+        if ((millisec == 0) || (_HostOs_CondWait(&ptQueue->tCond, &ptQueue->tLock, millisec)))
+        {
+            if (ptQueue->u32Num >= ptQueue->u32Size)
+            {
+                tRet = osErrorResource;
+                goto done;
+            }
+        }
+    }
+
+    ptQueue->pu32Buf[(ptQueue->u32Head + ptQueue->u32Num) % ptQueue->u32Size] = info;
+    ptQueue->u32Num++;
+    pthread_cond_broadcast(&ptQueue->tCond);
+
+done:
+    pthread_mutex_unlock(&ptQueue->tLock);
+    return tRet;
+}
+
+static osEvent _HostOs_MessageGet(osMessageQId queue_id, uint32_t millisec)
+{
+    T_HostOsQueue *ptQueue = (T_HostOsQueue *)queue_id;
+    osEvent tEvent;
+
+    memset(&tEvent, 0, sizeof(tEvent));
+    tEvent.def.message_id = queue_id;
+
+    if (ptQueue == NULL)
+    {
+        tEvent.status = osErrorParameter;
+        return tEvent;
+    }
+
+    pthread_mutex_lock(&ptQueue->tLock);
+
+    while (ptQueue->u32Num == 0)
+    {
+        if ((millisec == 0) || (_HostOs_CondWait(&ptQueue->tCond, &ptQueue->tLock, millisec)))
+        {
+            if (ptQueue->u32Num == 0)
+            {
+                tEvent.status = (millisec) ? osEventTimeout : osOK;
+                goto done;
+            }
+        }
+    }
+
+    tEvent.value.v = ptQueue->pu32Buf[ptQueue->u32Head];
+    tEvent.status = osEventMessage;
+    ptQueue->u32Head = (ptQueue->u32Head + 1) % ptQueue->u32Size;
+    ptQueue->u32Num--;
+    pthread_cond_broadcast(&ptQueue->tCond);
+
+done:
+    pthread_mutex_unlock(&ptQueue->tLock);
+    return tEvent;
+}
+
+/*
+ * Timers
+ */
+static void *_HostOs_TimerMain(void *pArg)
+{
+    T_HostOsTimer *ptTimer = (T_HostOsTimer *)pArg;
+    struct timespec tTs;
+    uint64_t u64Now = 0;
+
+    pthread_mutex_lock(&ptTimer->tLock);
+
+    while (!ptTimer->u8Exit)
+    {
+        if (!ptTimer->u8Run)
+        {
+            pthread_cond_wait(&ptTimer->tCond, &ptTimer->tLock);
+            continue;
+        }
+
+        u64Now = _HostOs_MonoUs();
+
+        if (u64Now < ptTimer->u64DueUs)
+        {
+            _HostOs_Deadline(&tTs, ptTimer->u64DueUs - u64Now);
+            pthread_cond_timedwait(&ptTimer->tCond, &ptTimer->tLock, &tTs);
+            continue;
+        }
+
+        if (ptTimer->eType == osTimerPeriodic)
+            ptTimer->u64DueUs += (uint64_t)ptTimer->u32PeriodMs * 1000;
+        else
+            ptTimer->u8Run = 0;
+
+        pthread_mutex_unlock(&ptTimer->tLock);
+        ptTimer->fpFunc(ptTimer->pArg);
+        pthread_mutex_lock(&ptTimer->tLock);
+    }
+
+    pthread_mutex_unlock(&ptTimer->tLock);
+    return NULL;
+}
+
+static osTimerId _HostOs_TimerCreate(const osTimerDef_t *timer_def, os_timer_type type, void *argument)
+{
+    T_HostOsTimer *ptTimer = NULL;
+
+    if ((timer_def == NULL) || (timer_def->ptimer == NULL))
+        return NULL;
+
+    ptTimer = (T_HostOsTimer *)calloc(1, sizeof(T_HostOsTimer));
+    if (ptTimer == NULL)
+        return NULL;
+
+    _HostOs_CondInit(&ptTimer->tLock, &ptTimer->tCond);
+    ptTimer->fpFunc = timer_def->ptimer;
+    ptTimer->pArg = argument;
+    ptTimer->eType = type;
+
+    if (pthread_create(&ptTimer->tThread, NULL, _HostOs_TimerMain, ptTimer))
+    {
+        free(ptTimer);
+        return NULL;
+    }
+
+    return (osTimerId)ptTimer;
+}
+
+static osStatus _HostOs_TimerStart(osTimerId timer_id, uint32_t millisec)
+{
+    T_HostOsTimer *ptTimer = (T_HostOsTimer *)timer_id;
+
+    if ((ptTimer == NULL) || (millisec == 0))
+        return osErrorParameter;
+
+    pthread_mutex_lock(&ptTimer->tLock);
+    ptTimer->u32PeriodMs = millisec;
+    ptTimer->u64DueUs = _HostOs_MonoUs() + ((uint64_t)millisec * 1000);
+    ptTimer->u8Run = 1;
+    pthread_cond_signal(&ptTimer->tCond);
+    pthread_mutex_unlock(&ptTimer->tLock);
+
+    return osOK;
+}
+
+static osStatus _HostOs_TimerStop(osTimerId timer_id)
+{
+    T_HostOsTimer *ptTimer = (T_HostOsTimer *)timer_id;
+
+    if (ptTimer == NULL)
+        return osErrorParameter;
+
+    pthread_mutex_lock(&ptTimer->tLock);
+    ptTimer->u8Run = 0;
+    pthread_cond_signal(&ptTimer->tCond);
+    pthread_mutex_unlock(&ptTimer->tLock);
+
+    return osOK;
+}
+
+static osStatus _HostOs_TimerDelete(osTimerId timer_id)
+{
+    T_HostOsTimer *ptTimer = (T_HostOsTimer *)timer_id;
+
+    if (ptTimer == NULL)
+        return osErrorParameter;
+
+    pthread_mutex_lock(&ptTimer->tLock);
+    ptTimer->u8Exit = 1;
+    pthread_cond_signal(&ptTimer->tCond);
+    pthread_mutex_unlock(&ptTimer->tLock);
+
+    // a callback deleting its own timer cannot join itself
+    if (pthread_equal(pthread_self(), ptTimer->tThread))
+    {
+        pthread_detach(ptTimer->tThread);
+        return osOK;
+    }
+
+    pthread_join(ptTimer->tThread, NULL);
+    pthread_cond_destroy(&ptTimer->tCond);
+    pthread_mutex_destroy(&ptTimer->tLock);
+    free(ptTimer);
+    return osOK;
+}
+
+/*
+ * Critical sections and memory
+ */
+static osStatus _HostOs_EnterCritical(void)
+{
+    vPortEnterCritical();
+    return osOK;
+}
+
+static osStatus _HostOs_ExitCritical(void)
+{
+    vPortExitCritical();
+    return osOK;
+}
+
+static void *_HostOs_MemoryAllocate(uint32_t ulWantedSize)
+{
+    return malloc(ulWantedSize);
+}
+
+static void _HostOs_MemoryDeallocate(void *pvMemPtr)
+{
+    free(pvMemPtr);
+}
+
+/*
+ * Tracer and diag
+ */
+static int _HostOs_TracerPrintf(const char *sFmt, ...)
+{
+    va_list tVa;
+    int iRet = 0;
+
+    va_start(tVa, sFmt);
+    iRet = vfprintf(stdout, sFmt, tVa);
+    va_end(tVa);
+
+    return iRet;
+}
+
+static int _HostOs_TracerMsg(uint8_t bType, uint8_t bLevel, char *sFmt, ...)
+{
+    va_list tVa;
+    int iRet = 0;
+
+    (void)bType;
+    (void)bLevel;
+
+    va_start(tVa, sFmt);
+    iRet = vfprintf(stdout, sFmt, tVa);
+    va_end(tVa);
+
+    return iRet;
+}
+
+static uint32_t _HostOs_ParseParam(char *sCmd, char **ppbParam, uint32_t dwNum)
+{
+    uint32_t u32Cnt = 0;
+    char *sSave = NULL;
+    char *sTok = strtok_r(sCmd, HOST_OS_PARAM_DELIM, &sSave);
+
+    while ((sTok) && (u32Cnt < dwNum))
+    {
+        ppbParam[u32Cnt++] = sTok;
+        sTok = strtok_r(NULL, HOST_OS_PARAM_DELIM, &sSave);
+    }
+
+    return u32Cnt;
+}
+
+T_osKernelInitializeFp osKernelInitialize = _HostOs_KernelNop;
+T_osKernelStartFp osKernelStart = _HostOs_KernelNop;
+T_osKernelRunningFp osKernelRunning = _HostOs_KernelRunning;
+T_osKernelSysTickFp osKernelSysTick = _HostOs_KernelSysTick;
+T_osKernelSysTickExFp osKernelSysTickEx = _HostOs_KernelSysTickEx;
+
+T_osThreadCreateFp osThreadCreate = _HostOs_ThreadCreate;
+T_osThreadGetIdFp osThreadGetId = _HostOs_ThreadGetId;
+T_osThreadTerminateFp osThreadTerminate = _HostOs_ThreadTerminate;
+T_osThreadYieldFp osThreadYield = _HostOs_ThreadYield;
+T_osThreadSetPriorityFp osThreadSetPriority = _HostOs_ThreadSetPriority;
+T_osThreadGetPriorityFp osThreadGetPriority = _HostOs_ThreadGetPriority;
+T_osDelayFp osDelay = _HostOs_Delay;
+
+T_osTimerCreateFp osTimerCreate = _HostOs_TimerCreate;
+T_osTimerStartFp osTimerStart = _HostOs_TimerStart;
+T_osTimerStopFp osTimerStop = _HostOs_TimerStop;
+T_osTimerDeleteFp osTimerDelete = _HostOs_TimerDelete;
+
+T_osMutexCreateFp osMutexCreate = _HostOs_MutexCreate;
+T_osMutexWaitFp osMutexWait = _HostOs_MutexWait;
+T_osMutexReleaseFp osMutexRelease = _HostOs_MutexRelease;
+T_osMutexDeleteFp osMutexDelete = _HostOs_MutexDelete;
+
+T_osSemaphoreCreateFp osSemaphoreCreate = _HostOs_SemaphoreCreate;
+T_osSemaphoreWaitFp osSemaphoreWait = _HostOs_SemaphoreWait;
+T_osSemaphoreReleaseFp osSemaphoreRelease = _HostOs_SemaphoreRelease;
+T_osSemaphoreDeleteFp osSemaphoreDelete = _HostOs_SemaphoreDelete;
+
+T_osMessageCreateFp osMessageCreate = _HostOs_MessageCreate;
+T_osMessagePutFp osMessagePut = _HostOs_MessagePut;
+T_osMessageGetFp osMessageGet = _HostOs_MessageGet;
+
+T_osEnterCriticalFp osEnterCritical = _HostOs_EnterCritical;
+T_osExitCriticalFp osExitCritical = _HostOs_ExitCritical;
+T_osMemoryAllocateFp osMemoryAllocate = _HostOs_MemoryAllocate;
+T_osMemoryDeallocateFp osMemoryDeallocate = _HostOs_MemoryDeallocate;
+
+T_TracerPrintfFp tracer_drct_printf = _HostOs_TracerPrintf;
+T_TracerMsgFp tracer_msg = _HostOs_TracerMsg;
+ParseParam_fp_t ParseParam = _HostOs_ParseParam;
+
+void HostOs_Init(void)
+{
+    pthread_once(&g_tHostOsOnce, _HostOs_Once);
+
+    g_ptHostOsSelf = &g_tHostOsMainThread;
+
+    // the tests print progress lines, keep them in order with the asserts
+    setvbuf(stdout, NULL, _IOLBF, 0);
+}
@@ -0,0 +1,91 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  host_os.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  CMSIS-RTOS, tick, tracer and interrupt emulation of the host test build.
+*
+******************************************************************************/
+
+#ifndef __HOST_OS_H__
+#define __HOST_OS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sec 1: Include File
+#include <stdint.h>
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+// the simulated CPU ticks at 1 MHz for Hal_Tick_*
+#define HOST_OS_TICK_PER_MS     (1000)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef void (*T_HostOsIsrFp)(void *pArg);
+typedef void (*T_HostOsWfiFp)(void);
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+/*
+ * Load the CMSIS-RTOS, Hal_Tick and tracer function pointers with the
+ * pthread based implementations. Call it first in main().
+ */
+void HostOs_Init(void);
+
+/*
+ * PRIMASK emulation: one lock stands for the single core. Code that masks
+ * the interrupts and the handlers run by HostOs_IsrRun() exclude each other.
+ */
+uint32_t HostOs_IrqGet(void);
+void HostOs_IrqSet(uint32_t u32Mask);
+uint32_t HostOs_IrqSave(void);
+uint32_t HostOs_IpsrGet(void);
+void HostOs_IsrRun(T_HostOsIsrFp fpIsr, void *pArg);
+
+// the same as the handler of the exception number u32Exc, e.g. 3 HardFault
+void HostOs_ExcRun(uint32_t u32Exc, T_HostOsIsrFp fpIsr, void *pArg);
+
+void HostOs_Yield(void);
+
+// __WFI(): runs the hook, NULL to yield
+void HostOs_Wfi(void);
+void HostOs_WfiHookSet(T_HostOsWfiFp fpWfi);
+void HostOs_SleepUs(uint32_t u32Us);
+uint64_t HostOs_TimeUs(void);
+
+// simulated time: Hal_Tick_* and osKernelSysTick advance by this offset too
+void HostOs_TimeAdvanceUs(uint32_t u32Us);
+
+// 1: the real time stops, only HostOs_TimeAdvanceUs() moves the time
+void HostOs_TimeFreeze(uint8_t u8Freeze);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HOST_OS_H__
@@ -0,0 +1,340 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  host_reg.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  Each window is a memfd mapped twice: at its target address for the code
+*  under test, and anywhere for HostReg_Get/Set, so the tests and the hooks
+*  never fault.
+*
+*  A hooked page is mapped PROT_NONE. The access of the driver faults, the
+*  SIGSEGV handler calls the read hook and stores its value, opens the page
+*  and returns with the trap flag set; the CPU runs the one instruction and
+*  the SIGTRAP handler closes the page again and calls the write hook with
+*  what was stored. A spin lock keeps one access of one thread in between.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include "host_reg.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HOST_REG_WIN_MAX        (8)
+#define HOST_REG_HOOK_MAX       (16)
+
+#define HOST_REG_EFL_TF         (0x100)     // x86 trap flag: debug exception after one instruction
+#define HOST_REG_ERR_WRITE      (0x2)       // page fault error code: the access was a write
+
+#define HOST_REG_APS_BASE       (0x30000000)
+#define HOST_REG_MSQ_BASE       (0x40000000)
+#define HOST_REG_PERIPH_SIZE    (0x10000)
+#define HOST_REG_SCS_BASE       (0xE000E000)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    uint32_t u32Base;
+    uint32_t u32Size;
+    uint8_t *pu8Shadow;
+} T_HostRegWin;
+
+typedef struct
+{
+    uint32_t u32Base;
+    T_HostRegReadFp fpRead;
+    T_HostRegWriteFp fpWrite;
+    void *pArg;
+} T_HostRegHook;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_HostRegWin g_taHostRegWin[HOST_REG_WIN_MAX];
+static uint32_t g_u32HostRegWinNum;
+static T_HostRegHook g_taHostRegHook[HOST_REG_HOOK_MAX];
+static uint8_t g_u8HostRegSig;
+static volatile uint8_t g_u8HostRegBusy;
+
+// the access between the two signals
+static __thread T_HostRegHook *g_ptHostRegStep;
+static __thread uint32_t g_u32HostRegStepAddr;
+static __thread uint8_t g_u8HostRegStepWrite;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static volatile uint32_t *_HostReg_Shadow(uint32_t u32Addr)
+{
+    uint32_t i;
+
+    for (i = 0; i < g_u32HostRegWinNum; i++)
+    {
+        if ((u32Addr >= g_taHostRegWin[i].u32Base) &&
+            (u32Addr - g_taHostRegWin[i].u32Base < g_taHostRegWin[i].u32Size))
+            return (volatile uint32_t *)(g_taHostRegWin[i].pu8Shadow + ((u32Addr - g_taHostRegWin[i].u32Base) & ~3U));
+    }
+
+    fprintf(stderr, "host_reg: 0x%08x is not mapped\n", u32Addr);
+    abort();
+    return NULL;
+}
+
+static T_HostRegHook *_HostReg_HookFind(uint32_t u32Page)
+{
+    uint32_t i;
+
+    for (i = 0; i < HOST_REG_HOOK_MAX; i++)
+    {
+        if ((g_taHostRegHook[i].u32Base == u32Page) &&
+            ((g_taHostRegHook[i].fpRead) || (g_taHostRegHook[i].fpWrite)))
+            return &g_taHostRegHook[i];
+    }
+
+    return NULL;
+}
+
+static void _HostReg_Protect(uint32_t u32Page, int iProt)
+{
+    mprotect((void *)(uintptr_t)u32Page, HOST_REG_PAGE_SIZE, iProt);
+}
+
+static void _HostReg_SegvHandler(int iSig, siginfo_t *ptInfo, void *pCtx)
+{
+    ucontext_t *ptUc = (ucontext_t *)pCtx;
+    uintptr_t uAddr = (uintptr_t)ptInfo->si_addr;
+    T_HostRegHook *ptHook = NULL;
+    volatile uint32_t *pu32Reg = NULL;
+
+    if (uAddr <= 0xFFFFFFFF)
+        ptHook = _HostReg_HookFind((uint32_t)uAddr & ~(HOST_REG_PAGE_SIZE - 1));
+
+    if (ptHook == NULL)
+    {
+        // a real fault: crash on it
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+
+    while (__atomic_test_and_set(&g_u8HostRegBusy, __ATOMIC_ACQUIRE))
+        ;
+
+    g_ptHostRegStep = ptHook;
+    g_u32HostRegStepAddr = (uint32_t)uAddr & ~3U;
+    g_u8HostRegStepWrite = ((ptUc->uc_mcontext.gregs[REG_ERR] & HOST_REG_ERR_WRITE) != 0);
+
+    if ((!g_u8HostRegStepWrite) && (ptHook->fpRead))
+    {
+        pu32Reg = _HostReg_Shadow(g_u32HostRegStepAddr);
+        *pu32Reg = ptHook->fpRead(g_u32HostRegStepAddr, *pu32Reg, ptHook->pArg);
+    }
+
+    _HostReg_Protect(ptHook->u32Base, PROT_READ | PROT_WRITE);
+    ptUc->uc_mcontext.gregs[REG_EFL] |= HOST_REG_EFL_TF;
+}
+
+static void _HostReg_TrapHandler(int iSig, siginfo_t *ptInfo, void *pCtx)
+{
+    ucontext_t *ptUc = (ucontext_t *)pCtx;
+    T_HostRegHook *ptHook = g_ptHostRegStep;
+
+    if (ptHook == NULL)
+    {
+        signal(SIGTRAP, SIG_DFL);
+        raise(SIGTRAP);
+        return;
+    }
+
+    g_ptHostRegStep = NULL;
+    ptUc->uc_mcontext.gregs[REG_EFL] &= ~HOST_REG_EFL_TF;
+    _HostReg_Protect(ptHook->u32Base, PROT_NONE);
+
+    if ((g_u8HostRegStepWrite) && (ptHook->fpWrite))
+        ptHook->fpWrite(g_u32HostRegStepAddr, *_HostReg_Shadow(g_u32HostRegStepAddr), ptHook->pArg);
+
+    __atomic_clear(&g_u8HostRegBusy, __ATOMIC_RELEASE);
+}
+
+int HostReg_Map(uint32_t u32Base, uint32_t u32Size)
+{
+    T_HostRegWin *ptWin = NULL;
+    void *pView = NULL;
+    int iFd = -1;
+    uint32_t i;
+
+    u32Size = (u32Size + (u32Base & (HOST_REG_PAGE_SIZE - 1)) + HOST_REG_PAGE_SIZE - 1) & ~(HOST_REG_PAGE_SIZE - 1);
+    u32Base &= ~(HOST_REG_PAGE_SIZE - 1);
+
+    for (i = 0; i < g_u32HostRegWinNum; i++)
+    {
+        if ((g_taHostRegWin[i].u32Base == u32Base) && (g_taHostRegWin[i].u32Size == u32Size))
+            return 0;
+    }
+
+    if (g_u32HostRegWinNum >= HOST_REG_WIN_MAX)
+        return -1;
+
+    ptWin = &g_taHostRegWin[g_u32HostRegWinNum];
+
+    iFd = memfd_create("host_reg", 0);
+    if (iFd < 0)
+        return -1;
+
+    if (ftruncate(iFd, u32Size) != 0)
+        goto fail;
+
+    pView = mmap((void *)(uintptr_t)u32Base, u32Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED_NOREPLACE, iFd, 0);
+    if (pView != (void *)(uintptr_t)u32Base)
+        goto fail;
+
+    pView = mmap(NULL, u32Size, PROT_READ | PROT_WRITE, MAP_SHARED, iFd, 0);
+    if (pView == MAP_FAILED)
+    {
+        munmap((void *)(uintptr_t)u32Base, u32Size);
+        goto fail;
+    }
+
+    close(iFd);
+
+    ptWin->u32Base = u32Base;
+    ptWin->u32Size = u32Size;
+    ptWin->pu8Shadow = (uint8_t *)pView;
+    g_u32HostRegWinNum++;
+    return 0;
+
+fail:
+    fprintf(stderr, "host_reg: cannot map 0x%08x\n", u32Base);
+    close(iFd);
+    return -1;
+}
+
+int HostReg_Init(void)
+{
+    struct sigaction tAct;
+
+    if (!g_u8HostRegSig)
+    {
+        memset(&tAct, 0, sizeof(tAct));
+        tAct.sa_flags = SA_SIGINFO;
+        sigemptyset(&tAct.sa_mask);
+
+        tAct.sa_sigaction = _HostReg_SegvHandler;
+        sigaction(SIGSEGV, &tAct, NULL);
+        tAct.sa_sigaction = _HostReg_TrapHandler;
+        sigaction(SIGTRAP, &tAct, NULL);
+
+        g_u8HostRegSig = 1;
+    }
+
+    if ((HostReg_Map(HOST_REG_APS_BASE, HOST_REG_PERIPH_SIZE)) ||
+        (HostReg_Map(HOST_REG_MSQ_BASE, HOST_REG_PERIPH_SIZE)) ||
+        (HostReg_Map(HOST_REG_SCS_BASE, HOST_REG_PAGE_SIZE)))
+        return -1;
+
+    return 0;
+}
+
+void HostReg_Reset(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < HOST_REG_HOOK_MAX; i++)
+    {
+        if ((g_taHostRegHook[i].fpRead) || (g_taHostRegHook[i].fpWrite))
+            HostReg_Unhook(g_taHostRegHook[i].u32Base);
+    }
+
+    for (i = 0; i < g_u32HostRegWinNum; i++)
+        memset(g_taHostRegWin[i].pu8Shadow, 0, g_taHostRegWin[i].u32Size);
+}
+
+int HostReg_Hook(uint32_t u32Base, T_HostRegReadFp fpRead, T_HostRegWriteFp fpWrite, void *pArg)
+{
+    T_HostRegHook *ptHook = NULL;
+    uint32_t i;
+
+    u32Base &= ~(HOST_REG_PAGE_SIZE - 1);
+    (void)_HostReg_Shadow(u32Base);
+
+    ptHook = _HostReg_HookFind(u32Base);
+
+    for (i = 0; (ptHook == NULL) && (i < HOST_REG_HOOK_MAX); i++)
+    {
+        if ((g_taHostRegHook[i].fpRead == NULL) && (g_taHostRegHook[i].fpWrite == NULL))
+            ptHook = &g_taHostRegHook[i];
+    }
+
+    if (ptHook == NULL)
+        return -1;
+
+    ptHook->pArg = pArg;
+    ptHook->fpRead = fpRead;
+    ptHook->fpWrite = fpWrite;
+    ptHook->u32Base = u32Base;
+
+    _HostReg_Protect(u32Base, PROT_NONE);
+    return 0;
+}
+
+void HostReg_Unhook(uint32_t u32Base)
+{
+    T_HostRegHook *ptHook = _HostReg_HookFind(u32Base & ~(HOST_REG_PAGE_SIZE - 1));
+
+    if (ptHook == NULL)
+        return;
+
+    _HostReg_Protect(ptHook->u32Base, PROT_READ | PROT_WRITE);
+    memset(ptHook, 0, sizeof(T_HostRegHook));
+}
+
+uint32_t HostReg_Get(uint32_t u32Addr)
+{
+    return *_HostReg_Shadow(u32Addr);
+}
+
+void HostReg_Set(uint32_t u32Addr, uint32_t u32Val)
+{
+    *_HostReg_Shadow(u32Addr) = u32Val;
+}
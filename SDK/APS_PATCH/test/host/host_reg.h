@@ -0,0 +1,97 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  host_reg.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  Register windows of the host test build. The peripheral address ranges
+*  of opl1000.h and the Cortex-M system control space are backed by RAM at
+*  their target addresses, so the drivers (ROM *_impl sources included) run
+*  unchanged and a test sees what they wrote.
+*
+*  Registers with side effects (FIFO data, read-to-clear, status computed
+*  from a device model) are emulated per 4 KB page: once a page is hooked,
+*  every 32-bit load or store of the driver to it calls the read or write
+*  hook of the test. Stores that read and modify in one instruction are
+*  reported as a write and read the stored value. x86-64 Linux only.
+*
+******************************************************************************/
+
+#ifndef __HOST_REG_H__
+#define __HOST_REG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sec 1: Include File
+#include <stdint.h>
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HOST_REG_PAGE_SIZE      (0x1000)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+// u32Val is the value stored in the register, the return value is what the driver reads
+typedef uint32_t (*T_HostRegReadFp)(uint32_t u32Addr, uint32_t u32Val, void *pArg);
+
+// called after the store, the register already holds u32Val
+typedef void (*T_HostRegWriteFp)(uint32_t u32Addr, uint32_t u32Val, void *pArg);
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+/*
+ * Map the APS and MSQ peripheral windows and the system control space,
+ * all registers zero. Returns 0 on success. May be called again.
+ */
+int HostReg_Init(void);
+
+/*
+ * Map one more window, e.g. a shared memory of the target. u32Base and
+ * u32Size are rounded to pages. Returns 0 on success.
+ */
+int HostReg_Map(uint32_t u32Base, uint32_t u32Size);
+
+// clear all the registers of the mapped windows and drop the hooks
+void HostReg_Reset(void);
+
+/*
+ * Emulate the page at u32Base: fpRead/fpWrite (either may be NULL) are
+ * called for each access of the code under test. Returns 0 on success.
+ */
+int HostReg_Hook(uint32_t u32Base, T_HostRegReadFp fpRead, T_HostRegWriteFp fpWrite, void *pArg);
+void HostReg_Unhook(uint32_t u32Base);
+
+/*
+ * Raw register access for the tests and the hooks: no hook is called.
+ */
+uint32_t HostReg_Get(uint32_t u32Addr);
+void HostReg_Set(uint32_t u32Addr, uint32_t u32Val);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HOST_REG_H__
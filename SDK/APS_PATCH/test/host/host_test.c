@@ -0,0 +1,102 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  host_test.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  Minimal test runner of the host test build.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include "host_os.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static uint32_t g_u32HostTestFailed;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+void HostTest_Fail(const char *sFile, int iLine, const char *sCond)
+{
+    printf("  %s:%d: check failed: %s\n", sFile, iLine, sCond);
+    g_u32HostTestFailed = 1;
+}
+
+void HostTest_FailEq(const char *sFile, int iLine, const char *sExpr, long long llActual, long long llExpected)
+{
+    printf("  %s:%d: %s is %lld, expected %lld\n", sFile, iLine, sExpr, llActual, llExpected);
+    g_u32HostTestFailed = 1;
+}
+
+uint32_t HostTest_Failed(void)
+{
+    return g_u32HostTestFailed;
+}
+
+int HostTest_Run(const char *sSuite, const T_HostTestCase *ptaCase, uint32_t u32Num)
+{
+    uint32_t u32Fail = 0;
+    uint32_t i = 0;
+
+    HostOs_Init();
+
+    for (i = 0; i < u32Num; i++)
+    {
+        g_u32HostTestFailed = 0;
+        printf("[ RUN  ] %s.%s\n", sSuite, ptaCase[i].sName);
+
+        ptaCase[i].fpTest();
+
+        if (g_u32HostTestFailed)
+            u32Fail++;
+
+        printf("[ %s ] %s.%s\n", (g_u32HostTestFailed) ? "FAIL" : " OK ", sSuite, ptaCase[i].sName);
+    }
+
+    printf("%s: %u case(s), %u failed\n", sSuite, u32Num, u32Fail);
+    return (u32Fail) ? 1 : 0;
+}
@@ -0,0 +1,95 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  host_test.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  Minimal test runner of the host test build. A suite is a table of cases;
+*  a failed check ends its case and makes the executable exit with 1, so
+*  ctest reports it.
+*
+******************************************************************************/
+
+#ifndef __HOST_TEST_H__
+#define __HOST_TEST_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sec 1: Include File
+#include <stdint.h>
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HOST_TEST_CASE(func)        { #func, func }
+#define HOST_TEST_NUM(table)        (sizeof(table) / sizeof((table)[0]))
+
+#define HOST_TEST_ASSERT(cond) \
+    do { \
+        if (!(cond)) { \
+            HostTest_Fail(__FILE__, __LINE__, #cond); \
+            return; \
+        } \
+    } while (0)
+
+#define HOST_TEST_EQ(actual, expected) \
+    do { \
+        long long llA_ = (long long)(actual); \
+        long long llE_ = (long long)(expected); \
+        if (llA_ != llE_) { \
+            HostTest_FailEq(__FILE__, __LINE__, #actual, llA_, llE_); \
+            return; \
+        } \
+    } while (0)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef void (*T_HostTestFp)(void);
+
+typedef struct
+{
+    const char *sName;
+    T_HostTestFp fpTest;
+} T_HostTestCase;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+void HostTest_Fail(const char *sFile, int iLine, const char *sCond);
+void HostTest_FailEq(const char *sFile, int iLine, const char *sExpr, long long llActual, long long llExpected);
+
+// 1: a check of the running case failed
+uint32_t HostTest_Failed(void);
+
+/*
+ * Run the cases in order and print one line per case plus a summary.
+ * Returns the process exit code: 0 if all passed, 1 otherwise.
+ */
+int HostTest_Run(const char *sSuite, const T_HostTestCase *ptaCase, uint32_t u32Num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HOST_TEST_H__
@@ -0,0 +1,89 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  host_tick.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  Hal_Tick_* of the host test build: a 1 MHz tick taken from the monotonic
+*  clock plus the simulated time of HostOs_TimeAdvanceUs().
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include "hal_tick.h"
+#include "host_os.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+void Hal_Tick_Init(void)
+{
+}
+
+uint32_t Hal_Tick_Diff(uint32_t u32Base)
+{
+    return (uint32_t)HostOs_TimeUs() - u32Base;
+}
+
+uint32_t Hal_Tick_DiffEx(uint32_t u32Base, uint32_t *pu32Current)
+{
+    uint32_t u32Curr = (uint32_t)HostOs_TimeUs();
+
+    if (pu32Current)
+        *pu32Current = u32Curr;
+
+    return u32Curr - u32Base;
+}
+
+uint32_t Hal_Tick_PerMilliSec(void)
+{
+    return HOST_OS_TICK_PER_MS;
+}
+
+uint32_t Hal_Tick_MilliSecMax(void)
+{
+    return 0xFFFFFFFF / HOST_OS_TICK_PER_MS;
+}
@@ -0,0 +1,78 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  cmsis_gcc.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  Cortex-M intrinsics of the host test build. core_cm3.h includes this file
+*  for GCC; PRIMASK is emulated by the interrupt lock of host_os.c, so code
+*  under __disable_irq() excludes the simulated interrupt handlers.
+*
+******************************************************************************/
+
+#ifndef __CMSIS_GCC_H
+#define __CMSIS_GCC_H
+
+#include <stdint.h>
+
+#define __ASM                       __asm
+#define __INLINE                    inline
+#define __STATIC_INLINE             static inline
+#define __STATIC_FORCEINLINE        static inline
+#define __NO_RETURN                 __attribute__((__noreturn__))
+#define __USED                      __attribute__((used))
+#define __WEAK                      __attribute__((weak))
+#define __PACKED                    __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT             struct __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)                __attribute__((aligned(x)))
+#define __RESTRICT                  __restrict
+
+extern uint32_t HostOs_IrqGet(void);
+extern void HostOs_IrqSet(uint32_t u32Mask);
+extern uint32_t HostOs_IpsrGet(void);
+extern void HostOs_Wfi(void);
+
+__STATIC_INLINE void __enable_irq(void)             { HostOs_IrqSet(0); }
+__STATIC_INLINE void __disable_irq(void)            { HostOs_IrqSet(1); }
+__STATIC_INLINE uint32_t __get_PRIMASK(void)        { return HostOs_IrqGet(); }
+__STATIC_INLINE void __set_PRIMASK(uint32_t u32Pm)  { HostOs_IrqSet(u32Pm); }
+
+__STATIC_INLINE uint32_t __get_IPSR(void)           { return HostOs_IpsrGet(); }
+__STATIC_INLINE uint32_t __get_CONTROL(void)        { return 0; }
+__STATIC_INLINE uint32_t __get_MSP(void)            { return 0; }
+__STATIC_INLINE uint32_t __get_PSP(void)            { return 0; }
+__STATIC_INLINE uint32_t __get_BASEPRI(void)        { return 0; }
+__STATIC_INLINE void __set_BASEPRI(uint32_t u32Val) { (void)u32Val; }
+
+__STATIC_INLINE void __NOP(void)                    { }
+__STATIC_INLINE void __WFI(void)                    { HostOs_Wfi(); }
+__STATIC_INLINE void __WFE(void)                    { }
+__STATIC_INLINE void __SEV(void)                    { }
+__STATIC_INLINE void __ISB(void)                    { __sync_synchronize(); }
+__STATIC_INLINE void __DSB(void)                    { __sync_synchronize(); }
+__STATIC_INLINE void __DMB(void)                    { __sync_synchronize(); }
+
+__STATIC_INLINE uint32_t __REV(uint32_t u32Val)     { return __builtin_bswap32(u32Val); }
+__STATIC_INLINE uint8_t __CLZ(uint32_t u32Val)      { return (u32Val) ? (uint8_t)__builtin_clz(u32Val) : 32; }
+
+// armcc intrinsics, of the function they are used in
+#define __return_address()          ((uint32_t)(uintptr_t)__builtin_return_address(0))
+#define __current_sp()              ((uint32_t)(uintptr_t)__builtin_frame_address(0))
+
+#endif /* __CMSIS_GCC_H */
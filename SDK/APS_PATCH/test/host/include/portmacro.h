@@ -0,0 +1,88 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  portmacro.h
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  FreeRTOS port definitions of the host test build. It replaces the Keil
+*  ARM_CM3 port, so the FreeRTOS and CMSIS-RTOS headers compile on Linux;
+*  the critical sections go to the interrupt lock of host_os.c.
+*
+******************************************************************************/
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define portCHAR                    char
+#define portFLOAT                   float
+#define portDOUBLE                  double
+#define portLONG                    long
+#define portSHORT                   short
+#define portSTACK_TYPE              uint32_t
+#define portBASE_TYPE               long
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+typedef uint32_t TickType_t;
+#define portMAX_DELAY               ( TickType_t ) 0xffffffffUL
+#define portTICK_TYPE_IS_ATOMIC     1
+
+#define portSTACK_GROWTH            ( -1 )
+#define portTICK_PERIOD_MS          ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT          8
+
+extern void HostOs_Yield(void);
+extern uint32_t HostOs_IrqSave(void);
+extern void HostOs_IrqSet(uint32_t u32Mask);
+extern void vPortEnterCritical(void);
+extern void vPortExitCritical(void);
+
+#define portYIELD()                                 HostOs_Yield()
+#define portEND_SWITCHING_ISR( xSwitchRequired )    (void)( xSwitchRequired )
+#define portYIELD_FROM_ISR( x )                     portEND_SWITCHING_ISR( x )
+
+#define portDISABLE_INTERRUPTS()                    HostOs_IrqSet(1)
+#define portENABLE_INTERRUPTS()                     HostOs_IrqSet(0)
+#define portENTER_CRITICAL()                        vPortEnterCritical()
+#define portEXIT_CRITICAL()                         vPortExitCritical()
+#define portSET_INTERRUPT_MASK_FROM_ISR()           HostOs_IrqSave()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )      HostOs_IrqSet(x)
+
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION     0
+
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
+
+#define portNOP()
+#define portINLINE                  inline
+#define portFORCE_INLINE            inline
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
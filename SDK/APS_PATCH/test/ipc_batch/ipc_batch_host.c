@@ -0,0 +1,462 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  ipc_batch_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  Doorbell coalescing of ipc_batch.c between two threads sharing the IPC
+*  rings at IPC_SHARED_MEM_ADDR.
+*
+*  The test thread is M3: it stamps a sequence number in the next APS TX
+*  buffer, moves the write index and rings IPC_BATCH_DOORBELL through
+*  Hal_Vic_IpcIntTrig as the IPC driver does. The M0 thread waits for the
+*  doorbell, then drains the ring and checks the sequence. The interrupts
+*  taken by M0 are counted against the descriptors it consumed.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmsis_os.h"
+#include "hal_vic.h"
+#include "ipc_batch.h"
+#include "host_os.h"
+#include "host_reg.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define IPC_BATCH_HOST_MASK         (IPC_WIFI_APS_TX_BUF_NUM - 1)
+#define IPC_BATCH_HOST_PKT_NUM      (2000)
+#define IPC_BATCH_HOST_WAIT_US      (200000)
+
+#define IPC_BATCH_HOST_INDEX(addr)  (*(volatile uint32_t *)(addr))
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    pthread_mutex_t tLock;
+    pthread_cond_t tCond;
+    uint32_t u32Doorbell;           // IPC_BATCH_DOORBELL rung by M3
+    uint32_t u32Other;              // any other IPC index
+    uint32_t u32Seen;               // doorbells M0 took
+    uint32_t u32Irq;                // interrupts M0 ran
+    uint32_t u32Desc;               // APS TX descriptors M0 consumed
+    uint32_t u32Seq;                // the next sequence number M0 expects
+    uint32_t u32Error;              // descriptors out of order
+    uint8_t u8Exit;
+} T_IpcBatchHostM0;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+T_Hal_Vic_IpcIntTrig Hal_Vic_IpcIntTrig;
+
+static T_IpcBatchHostM0 g_tIpcBatchHostM0 =
+{
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+};
+
+// the next sequence number M3 posts
+static uint32_t g_u32IpcBatchHostSeq;
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+
+// Sec 7: declaration of static function prototype
+
+/***********************************************************************
+*  Sec 8: C Functions
+***********************************************************************/
+
+/*
+ * M0
+ */
+static void _IpcBatchHost_Doorbell(E_IpcIdx_t eIpc)
+{
+    T_IpcBatchHostM0 *ptM0 = &g_tIpcBatchHostM0;
+
+    pthread_mutex_lock(&ptM0->tLock);
+
+    if (eIpc == IPC_BATCH_DOORBELL)
+        ptM0->u32Doorbell++;
+    else
+        ptM0->u32Other++;
+
+    pthread_cond_broadcast(&ptM0->tCond);
+    pthread_mutex_unlock(&ptM0->tLock);
+}
+
+static void _IpcBatchHost_Drain(T_IpcBatchHostM0 *ptM0)
+{
+    uint32_t u32Read = IPC_BATCH_HOST_INDEX(IPC_WIFI_APS_TX_QUEUE_READ);
+    uint32_t u32Stamp = 0;
+
+    while (u32Read != IPC_BATCH_HOST_INDEX(IPC_WIFI_APS_TX_QUEUE_WRITE))
+    {
+        __sync_synchronize();
+        u32Stamp = *(volatile uint32_t *)(IPC_WIFI_APS_TX_QUEUE_START + ((u32Read & IPC_BATCH_HOST_MASK) * IPC_WIFI_APS_TX_BUF_SIZE));
+
+        if (u32Stamp != ptM0->u32Seq)
+            ptM0->u32Error++;
+
+        ptM0->u32Seq = u32Stamp + 1;
+        ptM0->u32Desc++;
+
+        u32Read++;
+        __sync_synchronize();
+        IPC_BATCH_HOST_INDEX(IPC_WIFI_APS_TX_QUEUE_READ) = u32Read;
+    }
+}
+
+static void *_IpcBatchHost_M0Main(void *pArg)
+{
+    T_IpcBatchHostM0 *ptM0 = &g_tIpcBatchHostM0;
+
+    pthread_mutex_lock(&ptM0->tLock);
+
+    while (!ptM0->u8Exit)
+    {
+        if (ptM0->u32Seen == ptM0->u32Doorbell)
+        {
+            pthread_cond_wait(&ptM0->tCond, &ptM0->tLock);
+            continue;
+        }
+
+        // the interrupt is pending once for all the doorbells rung so far
+        ptM0->u32Seen = ptM0->u32Doorbell;
+        ptM0->u32Irq++;
+
+        _IpcBatchHost_Drain(ptM0);
+        pthread_cond_broadcast(&ptM0->tCond);
+    }
+
+    pthread_mutex_unlock(&ptM0->tLock);
+    return NULL;
+}
+
+/*
+ * M3
+ */
+static uint32_t _IpcBatchHost_TxCount(void)
+{
+    return IPC_BATCH_HOST_INDEX(IPC_WIFI_APS_TX_QUEUE_WRITE) - IPC_BATCH_HOST_INDEX(IPC_WIFI_APS_TX_QUEUE_READ);
+}
+
+// 0: no room in the ring for IPC_BATCH_HOST_WAIT_US
+static int _IpcBatchHost_Post(void)
+{
+    uint32_t u32Write = IPC_BATCH_HOST_INDEX(IPC_WIFI_APS_TX_QUEUE_WRITE);
+    uint64_t u64Due = HostOs_TimeUs() + IPC_BATCH_HOST_WAIT_US;
+
+    while (_IpcBatchHost_TxCount() >= IPC_WIFI_APS_TX_BUF_NUM)
+    {
+        if (HostOs_TimeUs() > u64Due)
+            return 0;
+
+        HostOs_Yield();
+    }
+
+    *(volatile uint32_t *)(IPC_WIFI_APS_TX_QUEUE_START + ((u32Write & IPC_BATCH_HOST_MASK) * IPC_WIFI_APS_TX_BUF_SIZE)) = g_u32IpcBatchHostSeq++;
+    __sync_synchronize();
+    IPC_BATCH_HOST_INDEX(IPC_WIFI_APS_TX_QUEUE_WRITE) = u32Write + 1;
+
+    Hal_Vic_IpcIntTrig(IPC_BATCH_DOORBELL);
+    return 1;
+}
+
+// wait until M0 consumed every descriptor posted
+static int _IpcBatchHost_Settle(void)
+{
+    T_IpcBatchHostM0 *ptM0 = &g_tIpcBatchHostM0;
+    uint64_t u64Due = HostOs_TimeUs() + IPC_BATCH_HOST_WAIT_US;
+    int iRet = 0;
+
+    pthread_mutex_lock(&ptM0->tLock);
+
+    while ((ptM0->u32Seq != g_u32IpcBatchHostSeq) || (ptM0->u32Seen != ptM0->u32Doorbell))
+    {
+        if (HostOs_TimeUs() > u64Due)
+            goto done;
+
+        pthread_mutex_unlock(&ptM0->tLock);
+        HostOs_SleepUs(100);
+        pthread_mutex_lock(&ptM0->tLock);
+    }
+
+    iRet = 1;
+
+done:
+    pthread_mutex_unlock(&ptM0->tLock);
+    return iRet;
+}
+
+static void _IpcBatchHost_Counter(uint32_t *pu32Irq, uint32_t *pu32Desc, uint32_t *pu32Error)
+{
+    T_IpcBatchHostM0 *ptM0 = &g_tIpcBatchHostM0;
+
+    pthread_mutex_lock(&ptM0->tLock);
+    *pu32Irq = ptM0->u32Irq;
+    *pu32Desc = ptM0->u32Desc;
+    *pu32Error = ptM0->u32Error;
+    pthread_mutex_unlock(&ptM0->tLock);
+}
+
+static void _IpcBatchHost_Reset(uint32_t u32Batch, uint32_t u32LatencyMs)
+{
+    T_IpcBatchHostM0 *ptM0 = &g_tIpcBatchHostM0;
+
+    ipc_batch_set(1, u32LatencyMs);
+    _IpcBatchHost_Settle();
+    ipc_batch_set(u32Batch, u32LatencyMs);
+    ipc_batch_stat_reset();
+
+    pthread_mutex_lock(&ptM0->tLock);
+    ptM0->u32Other = 0;
+    ptM0->u32Desc = 0;
+    ptM0->u32Error = 0;
+    ptM0->u32Doorbell = 0;
+    ptM0->u32Seen = 0;
+    ptM0->u32Irq = 0;
+    pthread_mutex_unlock(&ptM0->tLock);
+}
+
+/*
+ * Test cases
+ */
+
+// batch 1: one interrupt per descriptor, in order
+static void _IpcBatchHost_Order(void)
+{
+    T_IpcBatchStat tStat;
+    uint32_t u32Irq = 0;
+    uint32_t u32Desc = 0;
+    uint32_t u32Error = 0;
+    uint32_t i;
+
+    _IpcBatchHost_Reset(1, 1);
+
+    for (i = 0; i < IPC_BATCH_HOST_PKT_NUM; i++)
+        HOST_TEST_ASSERT(_IpcBatchHost_Post());
+
+    HOST_TEST_ASSERT(_IpcBatchHost_Settle());
+    _IpcBatchHost_Counter(&u32Irq, &u32Desc, &u32Error);
+    ipc_batch_stat_get(&tStat);
+
+    HOST_TEST_EQ(u32Desc, IPC_BATCH_HOST_PKT_NUM);
+    HOST_TEST_EQ(u32Error, 0);
+    HOST_TEST_EQ(tStat.dwRequest, IPC_BATCH_HOST_PKT_NUM);
+    HOST_TEST_EQ(tStat.dwRaise, IPC_BATCH_HOST_PKT_NUM);
+    HOST_TEST_EQ(tStat.dwHeld, 0);
+    HOST_TEST_EQ(tStat.dwTxDesc, IPC_BATCH_HOST_PKT_NUM);
+    HOST_TEST_ASSERT(u32Irq <= IPC_BATCH_HOST_PKT_NUM);
+    HOST_TEST_ASSERT(tStat.dwaHighWater[IPC_BATCH_RB_WIFI_APS_TX] <= IPC_WIFI_APS_TX_BUF_NUM);
+
+    printf("    batch 1: %u desc, %u doorbells, %u interrupts\n", u32Desc, tStat.dwRaise, u32Irq);
+}
+
+// the largest batch: fewer doorbells, same order, the ring never overruns
+static void _IpcBatchHost_Batch(void)
+{
+    T_IpcBatchStat tStat;
+    uint32_t u32Irq = 0;
+    uint32_t u32Desc = 0;
+    uint32_t u32Error = 0;
+    uint32_t i;
+
+    _IpcBatchHost_Reset(IPC_BATCH_NUM_MAX, 1);
+
+    for (i = 0; i < IPC_BATCH_HOST_PKT_NUM; i++)
+        HOST_TEST_ASSERT(_IpcBatchHost_Post());
+
+    ipc_batch_flush();
+
+    HOST_TEST_ASSERT(_IpcBatchHost_Settle());
+    _IpcBatchHost_Counter(&u32Irq, &u32Desc, &u32Error);
+    ipc_batch_stat_get(&tStat);
+
+    HOST_TEST_EQ(u32Desc, IPC_BATCH_HOST_PKT_NUM);
+    HOST_TEST_EQ(u32Error, 0);
+    HOST_TEST_EQ(tStat.dwRequest, IPC_BATCH_HOST_PKT_NUM);
+    HOST_TEST_EQ(tStat.dwTxDesc, IPC_BATCH_HOST_PKT_NUM);
+    HOST_TEST_EQ(tStat.dwFlushCtrl, 0);
+    HOST_TEST_ASSERT(tStat.dwHeld > 0);
+
+    // held until a batch is pending or the ring is one short of full
+    HOST_TEST_ASSERT((tStat.dwRaise * (IPC_WIFI_APS_TX_BUF_NUM - 2)) <= IPC_BATCH_HOST_PKT_NUM);
+    HOST_TEST_ASSERT(u32Irq <= tStat.dwRaise);
+    HOST_TEST_ASSERT(tStat.dwaHighWater[IPC_BATCH_RB_WIFI_APS_TX] <= IPC_WIFI_APS_TX_BUF_NUM);
+
+    printf("    batch %u: %u desc, %u doorbells (%u/100 desc), %u interrupts\n",
+           IPC_BATCH_NUM_MAX, u32Desc, tStat.dwRaise, (tStat.dwRaise * 100) / u32Desc, u32Irq);
+}
+
+// a lone descriptor goes out with the latency timer
+static void _IpcBatchHost_Latency(void)
+{
+    T_IpcBatchStat tStat;
+    uint32_t u32Irq = 0;
+    uint32_t u32Desc = 0;
+    uint32_t u32Error = 0;
+
+    _IpcBatchHost_Reset(IPC_BATCH_NUM_MAX, 2);
+
+    HOST_TEST_ASSERT(_IpcBatchHost_Post());
+
+    ipc_batch_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.dwRaise, 0);
+    HOST_TEST_EQ(tStat.dwHeld, 1);
+
+    HOST_TEST_ASSERT(_IpcBatchHost_Settle());
+    _IpcBatchHost_Counter(&u32Irq, &u32Desc, &u32Error);
+    ipc_batch_stat_get(&tStat);
+
+    HOST_TEST_EQ(u32Desc, 1);
+    HOST_TEST_EQ(u32Irq, 1);
+    HOST_TEST_EQ(tStat.dwRaise, 1);
+    HOST_TEST_EQ(tStat.dwFlushTimer, 1);
+}
+
+// a command ring takes the held data with it at once
+static void _IpcBatchHost_Ctrl(void)
+{
+    T_IpcBatchStat tStat;
+    uint32_t u32Irq = 0;
+    uint32_t u32Desc = 0;
+    uint32_t u32Error = 0;
+
+    _IpcBatchHost_Reset(IPC_BATCH_NUM_MAX, 50);
+
+    HOST_TEST_ASSERT(_IpcBatchHost_Post());
+
+    IPC_BATCH_HOST_INDEX(IPC_WIFI_CMD_QUEUE_WRITE) += 1;
+    Hal_Vic_IpcIntTrig(IPC_BATCH_DOORBELL);
+
+    ipc_batch_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.dwHeld, 1);
+    HOST_TEST_EQ(tStat.dwFlushCtrl, 1);
+    HOST_TEST_EQ(tStat.dwRaise, 1);
+
+    HOST_TEST_ASSERT(_IpcBatchHost_Settle());
+    _IpcBatchHost_Counter(&u32Irq, &u32Desc, &u32Error);
+    HOST_TEST_EQ(u32Desc, 1);
+
+    // M0 handled the command
+    IPC_BATCH_HOST_INDEX(IPC_WIFI_CMD_QUEUE_READ) += 1;
+}
+
+// one ring forward and another wrapped back by as much: still a change
+static void _IpcBatchHost_CtrlWrap(void)
+{
+    T_IpcBatchStat tStat;
+
+    _IpcBatchHost_Reset(IPC_BATCH_NUM_MAX, 50);
+
+    // the event ring read index wraps at IPC_EVT_BUF_NUM
+    IPC_BATCH_HOST_INDEX(IPC_EVT_QUEUE_READ) = 1;
+    Hal_Vic_IpcIntTrig(IPC_BATCH_DOORBELL);
+
+    ipc_batch_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.dwFlushCtrl, 1);
+
+    HOST_TEST_ASSERT(_IpcBatchHost_Post());
+
+    IPC_BATCH_HOST_INDEX(IPC_CMD_QUEUE_WRITE) += 1;
+    IPC_BATCH_HOST_INDEX(IPC_EVT_QUEUE_READ) = 0;
+    Hal_Vic_IpcIntTrig(IPC_BATCH_DOORBELL);
+
+    ipc_batch_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.dwFlushCtrl, 2);
+    HOST_TEST_EQ(tStat.dwRaise, 2);
+    HOST_TEST_ASSERT(_IpcBatchHost_Settle());
+
+    IPC_BATCH_HOST_INDEX(IPC_CMD_QUEUE_READ) += 1;
+}
+
+// the other IPC indexes are not touched
+static void _IpcBatchHost_Passthrough(void)
+{
+    T_IpcBatchStat tStat;
+    T_IpcBatchHostM0 *ptM0 = &g_tIpcBatchHostM0;
+    uint32_t u32Other = 0;
+
+    _IpcBatchHost_Reset(IPC_BATCH_NUM_MAX, 50);
+
+    Hal_Vic_IpcIntTrig(IPC_IDX_0);
+    Hal_Vic_IpcIntTrig(IPC_IDX_1);
+
+    pthread_mutex_lock(&ptM0->tLock);
+    u32Other = ptM0->u32Other;
+    pthread_mutex_unlock(&ptM0->tLock);
+
+    ipc_batch_stat_get(&tStat);
+    HOST_TEST_EQ(u32Other, 2);
+    HOST_TEST_EQ(tStat.dwRequest, 0);
+}
+
+static const T_HostTestCase g_taIpcBatchHostCase[] =
+{
+    HOST_TEST_CASE(_IpcBatchHost_Order),
+    HOST_TEST_CASE(_IpcBatchHost_Batch),
+    HOST_TEST_CASE(_IpcBatchHost_Latency),
+    HOST_TEST_CASE(_IpcBatchHost_Ctrl),
+    HOST_TEST_CASE(_IpcBatchHost_CtrlWrap),
+    HOST_TEST_CASE(_IpcBatchHost_Passthrough),
+};
+
+int main(void)
+{
+    pthread_t tM0;
+    int iRet = 0;
+
+    HostOs_Init();
+
+    if (HostReg_Map(IPC_SHARED_MEM_ADDR, IPC_SHM_AVAIL_ADDR - IPC_SHARED_MEM_ADDR))
+        return 1;
+
+    Hal_Vic_IpcIntTrig = _IpcBatchHost_Doorbell;
+    ipc_batch_init();
+
+    pthread_create(&tM0, NULL, _IpcBatchHost_M0Main, NULL);
+
+    iRet = HostTest_Run("ipc_batch", g_taIpcBatchHostCase, HOST_TEST_NUM(g_taIpcBatchHostCase));
+
+    pthread_mutex_lock(&g_tIpcBatchHostM0.tLock);
+    g_tIpcBatchHostM0.u8Exit = 1;
+    pthread_cond_broadcast(&g_tIpcBatchHostM0.tCond);
+    pthread_mutex_unlock(&g_tIpcBatchHostM0.tLock);
+
+    pthread_join(tM0, NULL);
+    return iRet;
+}
@@ -0,0 +1,824 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  lwip_bench_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  Runs lwip_bench.c on the host lwIP build.
+*
+*  Without arguments it is a ctest case: throughput, latency and memory
+*  runs that must succeed and give the memory back. With arguments they are
+*  passed to the "lwipbench" command, e.g.
+*
+*    lwip_bench_host all
+*    lwip_bench_host tput 1048576 1024
+*
+*  and the key=value lines can be compared between lwipopts.h builds.
+*
+*  The link cases run the throughput test over the emulated link of the
+*  host port (delay, loss) with the TCP autotuning off and on, and print
+*  the throughput with the peaks of the lwIP heap and of the pools.
+*
+*  The heap case runs the bench workload once and counts the heap
+*  allocations per IP packet and the fragmentation of the target heap
+*  model. The same mem_malloc() requests also go to a second heap model,
+*  as the build without the mem patch would make them, which is the
+*  baseline of the same run.
+*
+*  The pipe case sends UDP and TCP to LWIP_HOST_PIPE_PEER over the pipe
+*  netif of the host port. The peer reflects every packet, source and
+*  destination swapped, so the stack talks to itself through the driver
+*  path (netif->output, tcpip_input) instead of the loopback.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <string.h>
+#include "cmsis_os.h"
+#include "lwip/opt.h"
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+#include "lwip/mem.h"
+#include "lwip/tcpip.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/sockets.h"
+#include "lwip/prot/udp.h"
+#include "mem_if.h"
+#include "mem_if_patch.h"
+#include "tcp_if_patch.h"
+#include "lwip_bench.h"
+#include "lwip_host_port.h"
+#include "host_os.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define LWIP_BENCH_HOST_CMD_LEN     (128)
+#define LWIP_BENCH_HOST_TPUT_TOTAL  (1024 * 1024)
+#define LWIP_BENCH_HOST_MEM_BLK     (8)
+#define LWIP_BENCH_HOST_MEM_SIZE    (100)
+#define LWIP_BENCH_HOST_SETTLE_MS   (500)
+#define LWIP_BENCH_HOST_SHADOW_MAX  (512)       // blocks live at once
+#define LWIP_BENCH_HOST_PIPE_PORT   (LWIP_BENCH_PORT + 10)
+#define LWIP_BENCH_HOST_PIPE_UDP    (16)
+#define LWIP_BENCH_HOST_PIPE_TCP    (64 * 1024)
+#define LWIP_BENCH_HOST_PIPE_CHUNK  (1024)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    uint32_t u32DelayMs;
+    uint32_t u32LossPermille;
+    uint32_t u32Total;
+    uint32_t u32GainPct;                    // least throughput with the tuning on, % of off, 0 not checked
+} T_LwipBenchHostLink;
+
+typedef struct
+{
+    T_LwipBenchTput tTput;
+    T_LwipHostLinkStat tLink;
+    uint32_t u32HeapPeak;                   // lwip_stats.mem.used, bytes
+    uint32_t u32SegMax;
+    uint32_t u32PbufMax;
+    uint32_t u32SndGrow;
+    uint32_t u32WndGrow;
+} T_LwipBenchHostLinkRes;
+
+typedef struct
+{
+    void *pMem;                             // from mem_malloc()
+    void *pShadow;                          // the same request on the baseline heap
+} T_LwipBenchHostShadow;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static uint32_t g_u32LwipBenchHostMemBase;
+static uint32_t g_u32LwipBenchHostMempBase;
+
+// every mem_malloc() of the stack, for the peak of the heap
+static mem_malloc_fp_t g_fpLwipBenchHostMalloc;
+static mem_free_fp_t g_fpLwipBenchHostFree;
+static volatile uint32_t g_u32LwipBenchHostHeapPeak;
+
+// the baseline heap: every mem_malloc() as the build without the mem patch asks it
+static uint64_t g_u64aLwipBenchHostShadowArena[LWIP_HOST_HEAP_SIZE / sizeof(uint64_t)];
+static T_LwipHostHeap g_tLwipBenchHostShadowHeap;
+static T_LwipBenchHostShadow g_taLwipBenchHostShadow[LWIP_BENCH_HOST_SHADOW_MAX];
+static uint8_t g_u8LwipBenchHostShadowOn;
+static uint32_t g_u32LwipBenchHostShadowMallocs;
+static uint32_t g_u32LwipBenchHostShadowLost;
+
+// RTT 10 ms clean, RTT 40 ms, RTT 10 ms with 0.5 % loss: a few losses,
+// and whether one of them waits for the RTO is up to the timing of the host
+static const T_LwipBenchHostLink g_taLwipBenchHostLink[] =
+{
+    {5, 0, 512 * 1024, 90},
+    {20, 0, 256 * 1024, 120},
+    {5, 5, 256 * 1024, 0},
+};
+
+#define LWIP_BENCH_HOST_LINK_NUM    (sizeof(g_taLwipBenchHostLink) / sizeof(g_taLwipBenchHostLink[0]))
+
+static uint8_t g_u8LwipBenchHostPeerLive;
+static uint32_t g_u32LwipBenchHostPeerPkts;
+static uint8_t g_u8aLwipBenchHostPipeTx[LWIP_BENCH_HOST_PIPE_CHUNK + 512];
+static uint8_t g_u8aLwipBenchHostPipeRx[LWIP_BENCH_HOST_PIPE_CHUNK + 512];
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+static uint32_t _LwipBenchHost_MempUsed(void)
+{
+    uint32_t u32Used = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < MEMP_MAX; i++)
+    {
+        if (lwip_stats.memp[i])
+            u32Used += lwip_stats.memp[i]->used;
+    }
+
+    return u32Used;
+}
+
+/*
+ * The loopback netif schedules one netif_poll message per packet and one
+ * poll drains the whole queue, so TCPIP_MSG_API runs out on every burst
+ * without losing anything: that pool is left out of the error count.
+ */
+static uint32_t _LwipBenchHost_MempErr(void)
+{
+    uint32_t u32Err = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < MEMP_MAX; i++)
+    {
+        if ((lwip_stats.memp[i]) && (i != MEMP_TCPIP_MSG_API))
+            u32Err += lwip_stats.memp[i]->err;
+    }
+
+    return u32Err;
+}
+
+/*
+ * The active closer keeps its pcb in TIME-WAIT for 2 * TCP_MSL, and the tcp
+ * timer stays armed (one SYS_TIMEOUT) while any is left: those are not leaks.
+ */
+static uint32_t _LwipBenchHost_TimeWaitUsed(void)
+{
+    struct tcp_pcb *ptPcb = NULL;
+    uint32_t u32Used = 0;
+
+    LOCK_TCPIP_CORE();
+
+    for (ptPcb = tcp_tw_pcbs; ptPcb; ptPcb = ptPcb->next)
+        u32Used++;
+
+    UNLOCK_TCPIP_CORE();
+
+    return (u32Used) ? (u32Used + 1) : 0;
+}
+
+static void _LwipBenchHost_Tput(void)
+{
+    T_LwipBenchTput tRes;
+
+    HOST_TEST_EQ(lwip_bench_tput_run(LWIP_BENCH_HOST_TPUT_TOTAL, LWIP_BENCH_TPUT_CHUNK_DEF, &tRes), 0);
+    HOST_TEST_EQ(tRes.u32Bytes, LWIP_BENCH_HOST_TPUT_TOTAL);
+    HOST_TEST_ASSERT(tRes.u32Kbps > 0);
+
+    printf("tput: result=ok bytes=%u time_ms=%u kbps=%u chunk=%u\n",
+           tRes.u32Bytes, tRes.u32TimeMs, tRes.u32Kbps, LWIP_BENCH_TPUT_CHUNK_DEF);
+}
+
+static void _LwipBenchHost_TputSmallChunk(void)
+{
+    T_LwipBenchTput tRes;
+
+    // one segment per write: the pbuf and segment pools cycle the most
+    HOST_TEST_EQ(lwip_bench_tput_run(LWIP_BENCH_HOST_TPUT_TOTAL / 4, 64, &tRes), 0);
+    HOST_TEST_EQ(tRes.u32Bytes, LWIP_BENCH_HOST_TPUT_TOTAL / 4);
+
+    printf("tput: result=ok bytes=%u time_ms=%u kbps=%u chunk=%u\n",
+           tRes.u32Bytes, tRes.u32TimeMs, tRes.u32Kbps, 64);
+}
+
+static void _LwipBenchHost_Latency(void)
+{
+    T_LwipBenchLatency tRes;
+
+    HOST_TEST_EQ(lwip_bench_latency_run(LWIP_BENCH_LAT_ROUNDS_DEF * 10, LWIP_BENCH_LAT_SIZE_DEF, &tRes), 0);
+    HOST_TEST_EQ(tRes.u32Lost, 0);
+    HOST_TEST_ASSERT(tRes.u32MinUs <= tRes.u32AvgUs);
+    HOST_TEST_ASSERT(tRes.u32AvgUs <= tRes.u32MaxUs);
+
+    printf("lat: result=ok rounds=%u size=%u lost=%u min_us=%u avg_us=%u max_us=%u\n",
+           tRes.u32Rounds, LWIP_BENCH_LAT_SIZE_DEF, tRes.u32Lost,
+           tRes.u32MinUs, tRes.u32AvgUs, tRes.u32MaxUs);
+}
+
+static void _LwipBenchHost_BadArgs(void)
+{
+    T_LwipBenchTput tTput;
+    T_LwipBenchLatency tLat;
+
+    HOST_TEST_EQ(lwip_bench_tput_run(0, LWIP_BENCH_TPUT_CHUNK_DEF, &tTput), -1);
+    HOST_TEST_EQ(lwip_bench_tput_run(1024, LWIP_BENCH_TPUT_CHUNK_DEF + 1, &tTput), -1);
+    HOST_TEST_EQ(lwip_bench_latency_run(10, LWIP_BENCH_LAT_SIZE_MAX + 1, &tLat), -1);
+}
+
+/*
+ * Each mem_malloc() is counted once in lwip_stats.mem.used: by the ROM for
+ * heap blocks (with the patch header), by mem_if_patch.c for pool blocks.
+ */
+static void _LwipBenchHost_MemStats(void)
+{
+    void *pBlk[LWIP_BENCH_HOST_MEM_BLK] = {0};
+    T_LwipMemPatchStat tStat;
+    uint32_t u32Used = lwip_stats.mem.used;
+    uint32_t u32Err = lwip_stats.mem.err;
+    uint32_t u32Delta = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < LWIP_BENCH_HOST_MEM_BLK; i++)
+    {
+        pBlk[i] = mem_malloc(LWIP_BENCH_HOST_MEM_SIZE);
+        HOST_TEST_ASSERT(pBlk[i] != NULL);
+    }
+
+    u32Delta = lwip_stats.mem.used - u32Used;
+    lwip_mem_patch_stat_get(&tStat);
+
+    printf("memstat: mode=%u blocks=%u size=%u used_delta=%u pool_allocs=%u heap_allocs=%u\n",
+           lwip_mem_patch_mode(), LWIP_BENCH_HOST_MEM_BLK, LWIP_BENCH_HOST_MEM_SIZE, u32Delta,
+           tStat.u32PoolAllocs, tStat.u32HeapAllocs);
+
+    HOST_TEST_ASSERT(u32Delta >= LWIP_BENCH_HOST_MEM_BLK * LWIP_BENCH_HOST_MEM_SIZE);
+    HOST_TEST_ASSERT(u32Delta < LWIP_BENCH_HOST_MEM_BLK * LWIP_BENCH_HOST_MEM_SIZE * 2);
+
+    // the ROM libc mem_malloc() leaves max alone, the patch keeps it
+    if (lwip_mem_patch_mode() != LWIP_MEM_MODE_LIBC)
+        HOST_TEST_ASSERT(lwip_stats.mem.max >= lwip_stats.mem.used);
+
+    for (i = 0; i < LWIP_BENCH_HOST_MEM_BLK; i++)
+        mem_free(pBlk[i]);
+
+    HOST_TEST_EQ(lwip_stats.mem.used, u32Used);
+    HOST_TEST_EQ(lwip_stats.mem.err, u32Err);
+}
+
+static void _LwipBenchHost_TcpipSync(void *pArg)
+{
+    sys_sem_signal((sys_sem_t *)pArg);
+}
+
+// the budget is changed by the tcpip thread, in order with its other work
+static void _LwipBenchHost_TuneBudget(void)
+{
+    T_TcpAutotuneStat tStat;
+    uint32_t u32Orig = 0;
+    sys_sem_t tSync;
+
+    tcp_autotune_stat_get(&tStat);
+    u32Orig = tStat.u32Budget;
+
+    HOST_TEST_EQ(sys_sem_new(&tSync, 0), ERR_OK);
+
+    tcp_autotune_budget_set(u32Orig + TCP_MSS);
+    HOST_TEST_EQ(tcpip_callback(_LwipBenchHost_TcpipSync, &tSync), ERR_OK);
+    sys_arch_sem_wait(&tSync, 0);
+
+    tcp_autotune_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.u32Budget, u32Orig + TCP_MSS);
+
+    tcp_autotune_budget_set(u32Orig);
+    HOST_TEST_EQ(tcpip_callback(_LwipBenchHost_TcpipSync, &tSync), ERR_OK);
+    sys_arch_sem_wait(&tSync, 0);
+    sys_sem_free(&tSync);
+
+    tcp_autotune_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.u32Budget, u32Orig);
+}
+
+/*
+ * The ROM mem_malloc() of MEM_LIBC_MALLOC asks the heap for the size and
+ * its MEM_STATS helper, one heap block per call. Both allocations are
+ * made under the lock, so the two heaps see the requests in one order.
+ */
+static void *_LwipBenchHost_Malloc(mem_size_t tSize)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+    void *pMem = NULL;
+    uint32_t i = 0;
+
+    SYS_ARCH_PROTECT(lev);
+
+    pMem = g_fpLwipBenchHostMalloc(tSize);
+
+    if (lwip_stats.mem.used > g_u32LwipBenchHostHeapPeak)
+        g_u32LwipBenchHostHeapPeak = lwip_stats.mem.used;
+
+    if ((g_u8LwipBenchHostShadowOn) && (pMem != NULL))
+    {
+        g_u32LwipBenchHostShadowMallocs++;
+
+        for (i = 0; i < LWIP_BENCH_HOST_SHADOW_MAX; i++)
+        {
+            if (g_taLwipBenchHostShadow[i].pMem == NULL)
+                break;
+        }
+
+        if (i < LWIP_BENCH_HOST_SHADOW_MAX)
+        {
+            g_taLwipBenchHostShadow[i].pMem = pMem;
+            g_taLwipBenchHostShadow[i].pShadow = LwipHost_HeapAlloc(&g_tLwipBenchHostShadowHeap,
+                                                                    tSize + LWIP_MEM_ALIGN_SIZE(sizeof(mem_size_t)));
+        }
+        else
+        {
+            g_u32LwipBenchHostShadowLost++;
+        }
+    }
+
+    SYS_ARCH_UNPROTECT(lev);
+
+    return pMem;
+}
+
+static void _LwipBenchHost_Free(void *pMem)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+    uint32_t i = 0;
+
+    SYS_ARCH_PROTECT(lev);
+
+    // the blocks from before the run have no shadow
+    for (i = 0; (pMem != NULL) && (i < LWIP_BENCH_HOST_SHADOW_MAX); i++)
+    {
+        if (g_taLwipBenchHostShadow[i].pMem == pMem)
+        {
+            LwipHost_HeapFree(&g_tLwipBenchHostShadowHeap, g_taLwipBenchHostShadow[i].pShadow);
+            g_taLwipBenchHostShadow[i].pMem = NULL;
+            g_taLwipBenchHostShadow[i].pShadow = NULL;
+            break;
+        }
+    }
+
+    g_fpLwipBenchHostFree(pMem);
+
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+static void _LwipBenchHost_TuneSet(uint8_t u8Enable)
+{
+    sys_sem_t tSync;
+
+    HOST_TEST_EQ(sys_sem_new(&tSync, 0), ERR_OK);
+
+    tcp_autotune_enable(u8Enable);
+    HOST_TEST_EQ(tcpip_callback(_LwipBenchHost_TcpipSync, &tSync), ERR_OK);
+    sys_arch_sem_wait(&tSync, 0);
+    sys_sem_free(&tSync);
+}
+
+// one throughput run over the link, the peaks are of this run only
+static void _LwipBenchHost_LinkRun(const T_LwipBenchHostLink *ptLink, uint8_t u8Tune, T_LwipBenchHostLinkRes *ptRes)
+{
+    T_TcpAutotuneStat tBefore;
+    T_TcpAutotuneStat tAfter;
+
+    memset(ptRes, 0, sizeof(*ptRes));
+    _LwipBenchHost_TuneSet(u8Tune);
+    HOST_TEST_EQ(LwipHost_LinkSet(ptLink->u32DelayMs, ptLink->u32LossPermille), 0);
+
+    LOCK_TCPIP_CORE();
+    lwip_stats.memp[MEMP_TCP_SEG]->max = lwip_stats.memp[MEMP_TCP_SEG]->used;
+    lwip_stats.memp[MEMP_PBUF]->max = lwip_stats.memp[MEMP_PBUF]->used;
+    g_u32LwipBenchHostHeapPeak = lwip_stats.mem.used;
+    UNLOCK_TCPIP_CORE();
+
+    tcp_autotune_stat_get(&tBefore);
+
+    HOST_TEST_EQ(lwip_bench_tput_run(ptLink->u32Total, LWIP_BENCH_TPUT_CHUNK_DEF, &ptRes->tTput), 0);
+    HOST_TEST_EQ(ptRes->tTput.u32Bytes, ptLink->u32Total);
+
+    tcp_autotune_stat_get(&tAfter);
+
+    ptRes->u32HeapPeak = g_u32LwipBenchHostHeapPeak;
+    ptRes->u32SegMax = lwip_stats.memp[MEMP_TCP_SEG]->max;
+    ptRes->u32PbufMax = lwip_stats.memp[MEMP_PBUF]->max;
+    ptRes->u32SndGrow = tAfter.u32SndGrow - tBefore.u32SndGrow;
+    ptRes->u32WndGrow = tAfter.u32WndGrow - tBefore.u32WndGrow;
+
+    // the FIN exchange and the last ACKs still cross the link
+    osDelay(LWIP_BENCH_HOST_SETTLE_MS + (ptLink->u32DelayMs * 4));
+    LwipHost_LinkStatGet(&ptRes->tLink);
+    HOST_TEST_EQ(LwipHost_LinkSet(0, 0), 0);
+
+    HOST_TEST_EQ(ptRes->tLink.u32Delivered + ptRes->tLink.u32Lost + ptRes->tLink.u32Overflow + ptRes->tLink.u32Refused,
+                 ptRes->tLink.u32Sent);
+    HOST_TEST_EQ(ptRes->tLink.u32Overflow, 0);
+
+    if (ptLink->u32LossPermille)
+        HOST_TEST_ASSERT(ptRes->tLink.u32Lost > 0);
+    else
+        HOST_TEST_EQ(ptRes->tLink.u32Lost, 0);
+
+    printf("link: delay_ms=%u loss=%u/1000 tune=%s bytes=%u time_ms=%u kbps=%u heap_peak=%u seg_max=%u pbuf_max=%u "
+           "snd_grow=%u wnd_grow=%u sent=%u lost=%u refused=%u in_flight_max=%u\n",
+           ptLink->u32DelayMs, ptLink->u32LossPermille, (u8Tune) ? "on" : "off",
+           ptRes->tTput.u32Bytes, ptRes->tTput.u32TimeMs, ptRes->tTput.u32Kbps,
+           ptRes->u32HeapPeak, ptRes->u32SegMax, ptRes->u32PbufMax, ptRes->u32SndGrow, ptRes->u32WndGrow,
+           ptRes->tLink.u32Sent, ptRes->tLink.u32Lost, ptRes->tLink.u32Refused, ptRes->tLink.u32InFlightMax);
+}
+
+/*
+ * The 2-segment send buffer is the limit once the link has a delay: the
+ * autotuning grows it to the bandwidth-delay product, within
+ * TCP_AUTOTUNE_SND_BUF_MAX, and the heap takes the extra segments.
+ */
+static void _LwipBenchHost_Link(void)
+{
+    T_LwipBenchHostLinkRes tOff;
+    T_LwipBenchHostLinkRes tOn;
+    T_TcpAutotuneStat tStat;
+    uint32_t i = 0;
+
+    tcp_autotune_stat_get(&tStat);
+
+    for (i = 0; i < LWIP_BENCH_HOST_LINK_NUM; i++)
+    {
+        _LwipBenchHost_LinkRun(&g_taLwipBenchHostLink[i], 0, &tOff);
+        _LwipBenchHost_LinkRun(&g_taLwipBenchHostLink[i], 1, &tOn);
+
+        printf("link: delay_ms=%u loss=%u/1000 kbps_off=%u kbps_on=%u heap_peak_off=%u heap_peak_on=%u\n",
+               g_taLwipBenchHostLink[i].u32DelayMs, g_taLwipBenchHostLink[i].u32LossPermille,
+               tOff.tTput.u32Kbps, tOn.tTput.u32Kbps, tOff.u32HeapPeak, tOn.u32HeapPeak);
+
+        HOST_TEST_EQ(tOff.u32SndGrow, 0);
+        HOST_TEST_ASSERT((tOn.tTput.u32Kbps * 100) >= (tOff.tTput.u32Kbps * g_taLwipBenchHostLink[i].u32GainPct));
+        HOST_TEST_ASSERT(tOn.u32HeapPeak < configTOTAL_HEAP_SIZE);
+
+        if (g_taLwipBenchHostLink[i].u32GainPct > 100)
+            HOST_TEST_ASSERT(tOn.u32SndGrow > 0);
+    }
+
+    // as it was for the other cases
+    _LwipBenchHost_TuneSet((uint8_t)tStat.u32Enable);
+}
+
+/*
+ * The peer of the pipe netif: IPv4 comes back with the addresses swapped.
+ * The IP, UDP and TCP checksums hold as they are, the pseudo header sums
+ * the same both ways.
+ */
+static void _LwipBenchHost_PeerThread(void *pArg)
+{
+    uint8_t u8aPkt[LWIP_HOST_PIPE_MTU];
+    uint8_t u8aAddr[4];
+    int s32Len = 0;
+
+    while (1)
+    {
+        s32Len = LwipHost_PipePeerRecv(u8aPkt, sizeof(u8aPkt));
+
+        // the IPv6 of the netif (MLD, ND) has nobody to talk to
+        if ((s32Len < IP_HLEN) || ((u8aPkt[0] >> 4) != 4))
+            continue;
+
+        memcpy(u8aAddr, &u8aPkt[12], 4);
+        memcpy(&u8aPkt[12], &u8aPkt[16], 4);
+        memcpy(&u8aPkt[16], u8aAddr, 4);
+
+        g_u32LwipBenchHostPeerPkts++;
+        LwipHost_PipePeerSend(u8aPkt, (uint32_t)s32Len);
+    }
+}
+
+static void _LwipBenchHost_PipeAddr(struct sockaddr_in *ptAddr, const char *sIp)
+{
+    memset(ptAddr, 0, sizeof(*ptAddr));
+    ptAddr->sin_len = sizeof(*ptAddr);
+    ptAddr->sin_family = AF_INET;
+    ptAddr->sin_port = htons(LWIP_BENCH_HOST_PIPE_PORT);
+    ptAddr->sin_addr.s_addr = (sIp) ? inet_addr(sIp) : htonl(INADDR_ANY);
+}
+
+static int _LwipBenchHost_RecvAll(int s32Sock, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    uint32_t u32Got = 0;
+    int s32Len = 0;
+
+    while (u32Got < u32Len)
+    {
+        s32Len = lwip_recv(s32Sock, pu8Buf + u32Got, u32Len - u32Got, 0);
+
+        if (s32Len <= 0)
+            return -1;
+
+        u32Got += (uint32_t)s32Len;
+    }
+
+    return 0;
+}
+
+/*
+ * UDP datagrams up to the MTU, then a TCP connection to the peer address
+ * that the local listener takes: one chunk out and back at a time, the
+ * handshake is done by the stack before accept().
+ */
+static void _LwipBenchHost_Pipe(void)
+{
+    T_LwipHostPipeStat tStat;
+    struct sockaddr_in tAny;
+    struct sockaddr_in tPeer;
+    struct sockaddr_in tFrom;
+    socklen_t tFromLen = sizeof(tFrom);
+    uint32_t u32Size = 0;
+    uint32_t u32Sent = 0;
+    uint32_t u32Start = 0;
+    uint32_t u32TimeMs = 0;
+    int s32Udp = -1;
+    int s32Listen = -1;
+    int s32Cli = -1;
+    int s32Srv = -1;
+    int s32Opt = 1;
+    uint32_t i = 0;
+
+    HOST_TEST_EQ(LwipHost_PipeInit(), 0);
+
+    if (!g_u8LwipBenchHostPeerLive)
+    {
+        g_u8LwipBenchHostPeerLive = 1;
+        sys_thread_new("lwip_bench_peer", _LwipBenchHost_PeerThread, NULL, 0, 0);
+    }
+
+    _LwipBenchHost_PipeAddr(&tAny, NULL);
+    _LwipBenchHost_PipeAddr(&tPeer, LWIP_HOST_PIPE_PEER);
+
+    // UDP: the datagram to the peer comes back to the same port
+    s32Udp = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+    HOST_TEST_ASSERT(s32Udp >= 0);
+    HOST_TEST_EQ(lwip_bind(s32Udp, (struct sockaddr *)&tAny, sizeof(tAny)), 0);
+
+    for (i = 0; i < LWIP_BENCH_HOST_PIPE_UDP; i++)
+    {
+        u32Size = 1 + ((i * (LWIP_HOST_PIPE_MTU - IP_HLEN - UDP_HLEN)) / (LWIP_BENCH_HOST_PIPE_UDP - 1));
+
+        if (u32Size > LWIP_HOST_PIPE_MTU - IP_HLEN - UDP_HLEN)
+            u32Size = LWIP_HOST_PIPE_MTU - IP_HLEN - UDP_HLEN;
+
+        memset(g_u8aLwipBenchHostPipeTx, (int)i, u32Size);
+        HOST_TEST_EQ(lwip_sendto(s32Udp, g_u8aLwipBenchHostPipeTx, u32Size, 0, (struct sockaddr *)&tPeer, sizeof(tPeer)),
+                     (int)u32Size);
+
+        tFromLen = sizeof(tFrom);
+        HOST_TEST_EQ(lwip_recvfrom(s32Udp, g_u8aLwipBenchHostPipeRx, sizeof(g_u8aLwipBenchHostPipeRx), 0,
+                                   (struct sockaddr *)&tFrom, &tFromLen), (int)u32Size);
+        HOST_TEST_EQ(tFrom.sin_addr.s_addr, tPeer.sin_addr.s_addr);
+        HOST_TEST_EQ(memcmp(g_u8aLwipBenchHostPipeRx, g_u8aLwipBenchHostPipeTx, u32Size), 0);
+    }
+
+    lwip_close(s32Udp);
+
+    // TCP: to the peer address, the listener on any address answers it
+    s32Listen = lwip_socket(AF_INET, SOCK_STREAM, 0);
+    HOST_TEST_ASSERT(s32Listen >= 0);
+    lwip_setsockopt(s32Listen, SOL_SOCKET, SO_REUSEADDR, &s32Opt, sizeof(s32Opt));
+    HOST_TEST_EQ(lwip_bind(s32Listen, (struct sockaddr *)&tAny, sizeof(tAny)), 0);
+    HOST_TEST_EQ(lwip_listen(s32Listen, 1), 0);
+
+    s32Cli = lwip_socket(AF_INET, SOCK_STREAM, 0);
+    HOST_TEST_ASSERT(s32Cli >= 0);
+    lwip_setsockopt(s32Cli, IPPROTO_TCP, TCP_NODELAY, &s32Opt, sizeof(s32Opt));
+    HOST_TEST_EQ(lwip_connect(s32Cli, (struct sockaddr *)&tPeer, sizeof(tPeer)), 0);
+
+    s32Srv = lwip_accept(s32Listen, NULL, NULL);
+    HOST_TEST_ASSERT(s32Srv >= 0);
+    lwip_setsockopt(s32Srv, IPPROTO_TCP, TCP_NODELAY, &s32Opt, sizeof(s32Opt));
+    lwip_close(s32Listen);
+
+    u32Start = osKernelSysTick();
+
+    for (u32Sent = 0; u32Sent < LWIP_BENCH_HOST_PIPE_TCP; u32Sent += LWIP_BENCH_HOST_PIPE_CHUNK)
+    {
+        memset(g_u8aLwipBenchHostPipeTx, (int)(u32Sent / LWIP_BENCH_HOST_PIPE_CHUNK), LWIP_BENCH_HOST_PIPE_CHUNK);
+
+        HOST_TEST_EQ(lwip_send(s32Cli, g_u8aLwipBenchHostPipeTx, LWIP_BENCH_HOST_PIPE_CHUNK, 0), LWIP_BENCH_HOST_PIPE_CHUNK);
+        HOST_TEST_EQ(_LwipBenchHost_RecvAll(s32Srv, g_u8aLwipBenchHostPipeRx, LWIP_BENCH_HOST_PIPE_CHUNK), 0);
+        HOST_TEST_EQ(memcmp(g_u8aLwipBenchHostPipeRx, g_u8aLwipBenchHostPipeTx, LWIP_BENCH_HOST_PIPE_CHUNK), 0);
+
+        HOST_TEST_EQ(lwip_send(s32Srv, g_u8aLwipBenchHostPipeRx, LWIP_BENCH_HOST_PIPE_CHUNK, 0), LWIP_BENCH_HOST_PIPE_CHUNK);
+        HOST_TEST_EQ(_LwipBenchHost_RecvAll(s32Cli, g_u8aLwipBenchHostPipeRx, LWIP_BENCH_HOST_PIPE_CHUNK), 0);
+        HOST_TEST_EQ(memcmp(g_u8aLwipBenchHostPipeRx, g_u8aLwipBenchHostPipeTx, LWIP_BENCH_HOST_PIPE_CHUNK), 0);
+    }
+
+    u32TimeMs = osKernelSysTick() - u32Start;
+
+    // the client closes first and keeps the TIME-WAIT, the server sees the FIN
+    lwip_close(s32Cli);
+    HOST_TEST_EQ(lwip_recv(s32Srv, g_u8aLwipBenchHostPipeRx, sizeof(g_u8aLwipBenchHostPipeRx), 0), 0);
+    lwip_close(s32Srv);
+
+    osDelay(LWIP_BENCH_HOST_SETTLE_MS);
+    LwipHost_PipeStatGet(&tStat);
+
+    printf("pipe: udp=%u tcp_bytes=%u time_ms=%u tx_pkts=%u tx_bytes=%u tx_err=%u rx_pkts=%u rx_bytes=%u rx_drop=%u\n",
+           LWIP_BENCH_HOST_PIPE_UDP, LWIP_BENCH_HOST_PIPE_TCP * 2, u32TimeMs, tStat.u32TxPkts, tStat.u32TxBytes,
+           tStat.u32TxErr, tStat.u32RxPkts, tStat.u32RxBytes, tStat.u32RxDrop);
+
+    // nothing but IPv4 goes out on it, and every packet came back
+    HOST_TEST_EQ(tStat.u32TxErr, 0);
+    HOST_TEST_EQ(tStat.u32RxDrop, 0);
+    HOST_TEST_EQ(tStat.u32RxPkts, g_u32LwipBenchHostPeerPkts);
+    HOST_TEST_EQ(tStat.u32RxPkts, tStat.u32TxPkts);
+    HOST_TEST_EQ(tStat.u32RxBytes, tStat.u32TxBytes);
+    HOST_TEST_ASSERT(tStat.u32TxBytes > LWIP_BENCH_HOST_PIPE_TCP * 2);
+}
+
+/*
+ * The bench workload (bulk TCP, one segment per write, UDP ping-pong) on a
+ * quiet stack. Per IP packet sent: heap blocks of this build against the
+ * baseline, and how far the free space of each heap fell apart.
+ */
+static void _LwipBenchHost_HeapUse(void)
+{
+    T_LwipHostHeapStat tStart;
+    T_LwipHostHeapStat tEnd;
+    T_LwipHostHeapStat tBase;
+    T_LwipBenchTput tTput;
+    T_LwipBenchLatency tLat;
+    uint32_t u32Mode = lwip_mem_patch_mode();
+    uint32_t u32Xmit = 0;
+    uint32_t u32Pkts = 0;
+    uint32_t u32Allocs = 0;
+
+    // the closes of the cases before, nothing may be live the shadow does not know
+    osDelay(LWIP_BENCH_HOST_SETTLE_MS);
+
+    LOCK_TCPIP_CORE();
+    LwipHost_HeapInit(&g_tLwipBenchHostShadowHeap, (uint8_t *)g_u64aLwipBenchHostShadowArena,
+                      sizeof(g_u64aLwipBenchHostShadowArena));
+    memset(g_taLwipBenchHostShadow, 0, sizeof(g_taLwipBenchHostShadow));
+    g_u32LwipBenchHostShadowMallocs = 0;
+    g_u32LwipBenchHostShadowLost = 0;
+
+    LwipHost_HeapStatReset(LwipHost_Heap());
+    LwipHost_HeapStatGet(LwipHost_Heap(), &tStart);
+    u32Xmit = lwip_stats.ip.xmit;
+    g_u8LwipBenchHostShadowOn = 1;
+    UNLOCK_TCPIP_CORE();
+
+    HOST_TEST_EQ(lwip_bench_tput_run(LWIP_BENCH_HOST_TPUT_TOTAL / 4, LWIP_BENCH_TPUT_CHUNK_DEF, &tTput), 0);
+    HOST_TEST_EQ(lwip_bench_tput_run(LWIP_BENCH_HOST_TPUT_TOTAL / 16, 64, &tTput), 0);
+    HOST_TEST_EQ(lwip_bench_latency_run(LWIP_BENCH_LAT_ROUNDS_DEF * 2, LWIP_BENCH_LAT_SIZE_DEF, &tLat), 0);
+
+    osDelay(LWIP_BENCH_HOST_SETTLE_MS);
+
+    LOCK_TCPIP_CORE();
+    g_u8LwipBenchHostShadowOn = 0;
+    u32Pkts = lwip_stats.ip.xmit - u32Xmit;
+    LwipHost_HeapStatGet(LwipHost_Heap(), &tEnd);
+    LwipHost_HeapStatGet(&g_tLwipBenchHostShadowHeap, &tBase);
+    UNLOCK_TCPIP_CORE();
+
+    u32Allocs = tEnd.u32Allocs - tStart.u32Allocs;
+
+    printf("heapuse: mode=%u pkts=%u mallocs=%u heap_allocs=%u per_pkt_x100=%u free_min=%u largest_min=%u frag_max_pct=%u "
+           "base_heap_allocs=%u base_per_pkt_x100=%u base_free_min=%u base_largest_min=%u base_frag_max_pct=%u base_fails=%u\n",
+           u32Mode, u32Pkts, g_u32LwipBenchHostShadowMallocs, u32Allocs, (u32Allocs * 100) / u32Pkts,
+           tEnd.u32FreeMin, tEnd.u32LargestMin, tEnd.u32FragMaxPct,
+           tBase.u32Allocs, (tBase.u32Allocs * 100) / u32Pkts, tBase.u32FreeMin, tBase.u32LargestMin,
+           tBase.u32FragMaxPct, tBase.u32Fails);
+
+    HOST_TEST_ASSERT(u32Pkts > 0);
+    HOST_TEST_EQ(g_u32LwipBenchHostShadowLost, 0);
+    HOST_TEST_EQ(tBase.u32Allocs + tBase.u32Fails, g_u32LwipBenchHostShadowMallocs);
+    HOST_TEST_EQ(tEnd.u32Fails, tStart.u32Fails);
+
+    // both heaps are whole again
+    HOST_TEST_EQ(tEnd.u32Free, tStart.u32Free);
+    HOST_TEST_EQ(tBase.u32Free, sizeof(g_u64aLwipBenchHostShadowArena));
+
+    if (u32Mode == LWIP_MEM_MODE_LIBC)
+    {
+        // this is the baseline build: the two heaps must agree
+        HOST_TEST_EQ(u32Allocs, tBase.u32Allocs);
+        HOST_TEST_EQ(tEnd.u32LargestMin, tBase.u32LargestMin);
+        HOST_TEST_EQ(tEnd.u32FragMaxPct, tBase.u32FragMaxPct);
+    }
+    else if (u32Mode == LWIP_MEM_MODE_POOLS)
+    {
+        // the pools of lwippools_patch.h take most of the workload, a burst falls back to
+        // the heap: about 1 in 8 of the baseline blocks alone, 1 in 3 on a busy host
+        HOST_TEST_ASSERT((u32Allocs * 2) <= tBase.u32Allocs);
+        // the peak of the fragmentation is one sample and goes with the timing: reported only
+        HOST_TEST_ASSERT(tEnd.u32LargestMin >= tBase.u32LargestMin);
+    }
+}
+
+// everything the runs took must be back once the sockets are closed
+static void _LwipBenchHost_Memory(void)
+{
+    T_LwipBenchMem tMem;
+    char baCmd[] = "lwipbench mem";
+
+    // let the tcpip thread finish the closes
+    osDelay(500);
+
+    lwip_bench_mem_get(&tMem);
+    lwip_bench_cmd(baCmd);
+
+    printf("mem: mem_used=%u mem_max=%u mem_err=%u memp_err=%u memp_used=%u\n",
+           tMem.u32MemUsed, tMem.u32MemMax, tMem.u32MemErr, tMem.u32MempErr,
+           _LwipBenchHost_MempUsed());
+
+    HOST_TEST_EQ(tMem.u32MemErr, 0);
+    HOST_TEST_EQ(_LwipBenchHost_MempErr(), 0);
+    HOST_TEST_EQ(tMem.u32MemUsed, g_u32LwipBenchHostMemBase);
+    HOST_TEST_EQ(_LwipBenchHost_MempUsed(), g_u32LwipBenchHostMempBase + _LwipBenchHost_TimeWaitUsed());
+}
+
+static const T_HostTestCase g_taLwipBenchHostCase[] =
+{
+    HOST_TEST_CASE(_LwipBenchHost_Tput),
+    HOST_TEST_CASE(_LwipBenchHost_TputSmallChunk),
+    HOST_TEST_CASE(_LwipBenchHost_Latency),
+    HOST_TEST_CASE(_LwipBenchHost_BadArgs),
+    HOST_TEST_CASE(_LwipBenchHost_MemStats),
+    HOST_TEST_CASE(_LwipBenchHost_TuneBudget),
+    HOST_TEST_CASE(_LwipBenchHost_Link),
+    HOST_TEST_CASE(_LwipBenchHost_Pipe),
+    HOST_TEST_CASE(_LwipBenchHost_HeapUse),
+    HOST_TEST_CASE(_LwipBenchHost_Memory),
+};
+
+int main(int argc, char *argv[])
+{
+    char baCmd[LWIP_BENCH_HOST_CMD_LEN] = "lwipbench";
+    int i = 0;
+
+    HostOs_Init();
+
+    if (LwipHost_Init())
+        return 1;
+
+    g_fpLwipBenchHostMalloc = mem_malloc_adpt;
+    mem_malloc_adpt = _LwipBenchHost_Malloc;
+    g_fpLwipBenchHostFree = mem_free_adpt;
+    mem_free_adpt = _LwipBenchHost_Free;
+
+    if (argc > 1)
+    {
+        for (i = 1; i < argc; i++)
+        {
+            strncat(baCmd, " ", sizeof(baCmd) - strlen(baCmd) - 1);
+            strncat(baCmd, argv[i], sizeof(baCmd) - strlen(baCmd) - 1);
+        }
+
+        lwip_bench_cmd(baCmd);
+        return 0;
+    }
+
+    lwip_bench_cmd(strcpy(baCmd, "lwipbench cfg"));
+    g_u32LwipBenchHostMemBase = lwip_stats.mem.used;
+    g_u32LwipBenchHostMempBase = _LwipBenchHost_MempUsed();
+
+    return HostTest_Run("lwip_bench", g_taLwipBenchHostCase, HOST_TEST_NUM(g_taLwipBenchHostCase));
+}
@@ -0,0 +1,694 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  net_stats_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The counters of net_stats.c against scripted traffic on the host lwIP
+*  build. The Wi-Fi netif is the ROM wlannetif.c with wlannetif_patch.c on
+*  top, as the boot loads them; wifi_mac_tx_start() is a script that keeps
+*  the frames sent and answers TX_QUEUE_FULL when told to. The frames are
+*  given to ethernetif_input() as the Wi-Fi RX task does, and the pools are
+*  emptied by hand for the pbuf and tcpip mbox shortages.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "cmsis_os.h"
+#include "lwip/opt.h"
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+#include "lwip/pbuf.h"
+#include "lwip/netif.h"
+#include "lwip/tcpip.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/prot/ethernet.h"
+#include "lwip/prot/etharp.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/icmp.h"
+#include "wlannetif.h"
+#include "wifi_mac_task.h"
+#include "wifi_mac_dcf.h"
+#include "wifi_mac_sta.h"
+#include "wifi_nvm.h"
+#include "sys_common_ctrl.h"
+#include "ipc.h"
+#include "msg.h"
+#include "at_cmd_data_process.h"
+#include "at_cmd_common.h"
+#include "net_stats.h"
+#include "lwip_host_port.h"
+#include "host_os.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+extern sys_sem_t TxReadySem;
+
+#define NET_HOST_FRAME_MIN          (60)        // without the FCS
+#define NET_HOST_FRAME_MAX          (1514)
+#define NET_HOST_TX_MAX             (8)
+#define NET_HOST_POOL_MAX           (256)
+#define NET_HOST_OUT_SIZE           (4096)
+#define NET_HOST_PING_DATA          (32)
+#define NET_HOST_BURST              (8)
+
+#define NET_HOST_ETHTYPE_LLDP       (0x88CC)
+
+// "netstats" and AT+NETSTATS? with the RX and TX groups of the script
+#define NET_HOST_RX_LINE            "netif_rx: pkts=%u bytes=%u nobuf=1 bad=3 input_err=1 unknown_type=2\n"
+#define NET_HOST_TX_LINE            "+NETSTATS:netif_tx,pkts=%u,bytes=%u,queue_full=7,retry=6,drop=1,stall=6,"
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+struct netif netif;
+
+WifiSta_StaInfo_s s_StaInfo;
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static const uint8_t g_u8aNetHostMac[ETH_HWADDR_LEN] = {0x22, 0x33, 0x44, 0x55, 0x66, 0x77};
+static const uint8_t g_u8aNetHostPeerMac[ETH_HWADDR_LEN] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+static ip4_addr_t g_tNetHostIp;
+static ip4_addr_t g_tNetHostPeerIp;
+
+// the frames wifi_mac_tx_start() took, and how many TX_QUEUE_FULL to answer first
+static uint8_t g_u8aNetHostTx[NET_HOST_TX_MAX][NET_HOST_FRAME_MAX];
+static uint32_t g_u32aNetHostTxLen[NET_HOST_TX_MAX];
+static uint32_t g_u32NetHostTxNum;
+static uint32_t g_u32NetHostTxFull;
+static uint8_t g_u8NetHostTxReady;          // signal TxReadySem with each TX_QUEUE_FULL
+
+static void *g_paNetHostPool[NET_HOST_POOL_MAX];
+static uint32_t g_u32NetHostPoolNum;
+
+static char g_baNetHostOut[NET_HOST_OUT_SIZE];
+static uint32_t g_u32NetHostOutLen;
+
+static uint32_t g_u32NetHostRxNum;
+static uint32_t g_u32NetHostRxFree;
+static uint32_t g_u32NetHostRxBytes;
+static uint32_t g_u32NetHostTxBytes;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+/*
+ * The Wi-Fi side of the netif
+ */
+static u32 _NetHost_TxStart(u8 *pu8Data, u32 u32Len)
+{
+    if (g_u32NetHostTxFull)
+    {
+        g_u32NetHostTxFull--;
+
+        // the MAC frees a slot at once: the wait of the netif ends on the semaphore
+        if (g_u8NetHostTxReady)
+            sys_sem_signal(&TxReadySem);
+
+        return TX_QUEUE_FULL;
+    }
+
+    if (g_u32NetHostTxNum < NET_HOST_TX_MAX)
+    {
+        memcpy(g_u8aNetHostTx[g_u32NetHostTxNum], pu8Data, u32Len);
+        g_u32aNetHostTxLen[g_u32NetHostTxNum] = u32Len;
+    }
+
+    g_u32NetHostTxNum++;
+    return TX_IN_QUEUE_SUCCESS;
+}
+
+wifi_mac_tx_start_fp_t wifi_mac_tx_start = _NetHost_TxStart;
+
+// every frame given to the netif, taken or not, frees its entry of the RX queue
+osStatus wifi_mac_rx_queue_first_entry_free(void)
+{
+    g_u32NetHostRxFree++;
+    return osOK;
+}
+
+void wifi_mac_rx_notify_tcp_callback_registration(wifi_mac_rx_notify_tcp_callback_t callback)
+{
+}
+
+void wifi_mac_tx_notify_tcp_callback_registration(wifi_mac_tx_notify_tcp_callback_t callback)
+{
+}
+
+// the MAC address is in the flash, not in the OTP
+int base_mac_addr_src_get_cfg(u8 iface, u8 *type)
+{
+    *type = BASE_NVM_MAC_SRC_TYPE_ID_FLASH;
+    return 0;
+}
+
+static u16 _NetHost_StaInfoRead(u16 id, u16 len, void *buf)
+{
+    memcpy(buf, g_u8aNetHostMac, len);
+    return 0;
+}
+
+wifi_nvm_sta_info_read_fp_t wifi_nvm_sta_info_read = _NetHost_StaInfoRead;
+
+/*
+ * The IPC rings of net_stats.c, empty
+ */
+static uint32_t _NetHost_IpcCount(uint32_t *pu32Total)
+{
+    *pu32Total = 8;
+    return 0;
+}
+
+static uint32_t _NetHost_IpcWifiCount(void)
+{
+    return 0;
+}
+
+T_IpcCountGetFp ipc_cmd_count_get = _NetHost_IpcCount;
+T_IpcCountGetFp ipc_evt_count_get = _NetHost_IpcCount;
+T_IpcCountGetFp ipc_wifi_cmd_count_get = _NetHost_IpcCount;
+T_IpcCountGetFp ipc_wifi_evt_count_get = _NetHost_IpcCount;
+T_IpcWifiCountGetFp ipc_wifi_msq_tx_count_get = _NetHost_IpcWifiCount;
+T_IpcWifiCountGetFp ipc_wifi_msq_rx_count_get = _NetHost_IpcWifiCount;
+T_IpcWifiCountGetFp ipc_wifi_aps_tx_count_get = _NetHost_IpcWifiCount;
+T_IpcWifiCountGetFp ipc_wifi_aps_rx_count_get = _NetHost_IpcWifiCount;
+
+/*
+ * The output of "netstats" and AT+NETSTATS
+ */
+static void _NetHost_OutAdd(const char *sFmt, va_list tList)
+{
+    int iLen;
+
+    iLen = vsnprintf(&g_baNetHostOut[g_u32NetHostOutLen], sizeof(g_baNetHostOut) - g_u32NetHostOutLen,
+                     sFmt, tList);
+
+    if (iLen > 0)
+        g_u32NetHostOutLen += iLen;
+
+    if (g_u32NetHostOutLen >= sizeof(g_baNetHostOut))
+        g_u32NetHostOutLen = sizeof(g_baNetHostOut) - 1;
+}
+
+static int _NetHost_Tracer(const char *sFmt, ...)
+{
+    va_list tList;
+
+    va_start(tList, sFmt);
+    _NetHost_OutAdd(sFmt, tList);
+    va_end(tList);
+    return 0;
+}
+
+static void _NetHost_AtPrint(char *sFmt, ...)
+{
+    va_list tList;
+
+    va_start(tList, sFmt);
+    _NetHost_OutAdd(sFmt, tList);
+    va_end(tList);
+}
+
+msg_print_uart1_fp_t msg_print_uart1 = _NetHost_AtPrint;
+
+int _at_cmd_buf_to_argc_argv(char *pbuf, int *argc, char *argv[], int iArgvNum)
+{
+    int iCount = 0;
+    char *p;
+
+    argv[iCount++] = strtok(pbuf, "=");
+
+    while ((iCount < iArgvNum) && ((p = strtok(NULL, ",")) != NULL))
+        argv[iCount++] = p;
+
+    *argc = iCount;
+    return 1;
+}
+
+static void _NetHost_OutReset(void)
+{
+    g_u32NetHostOutLen = 0;
+    g_baNetHostOut[0] = 0;
+}
+
+/*
+ * Frames of the peer
+ */
+static uint32_t _NetHost_EthHdr(uint8_t *pu8Frame, const uint8_t *pu8Dst, uint16_t u16Type)
+{
+    struct eth_hdr *ptEth = (struct eth_hdr *)pu8Frame;
+
+    memset(pu8Frame, 0, NET_HOST_FRAME_MIN);
+    memcpy(&ptEth->dest, pu8Dst, ETH_HWADDR_LEN);
+    memcpy(&ptEth->src, g_u8aNetHostPeerMac, ETH_HWADDR_LEN);
+    ptEth->type = PP_HTONS(u16Type);
+
+    return SIZEOF_ETH_HDR;
+}
+
+// "who has our address", from the peer
+static uint32_t _NetHost_ArpRequest(uint8_t *pu8Frame)
+{
+    static const uint8_t u8aBcast[ETH_HWADDR_LEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    struct etharp_hdr *ptArp = (struct etharp_hdr *)&pu8Frame[SIZEOF_ETH_HDR];
+
+    _NetHost_EthHdr(pu8Frame, u8aBcast, ETHTYPE_ARP);
+
+    ptArp->hwtype = PP_HTONS(1);
+    ptArp->proto = PP_HTONS(ETHTYPE_IP);
+    ptArp->hwlen = ETH_HWADDR_LEN;
+    ptArp->protolen = sizeof(ip4_addr_t);
+    ptArp->opcode = PP_HTONS(ARP_REQUEST);
+    memcpy(&ptArp->shwaddr, g_u8aNetHostPeerMac, ETH_HWADDR_LEN);
+    memcpy(&ptArp->sipaddr, &g_tNetHostPeerIp, sizeof(ip4_addr_t));
+    memcpy(&ptArp->dipaddr, &g_tNetHostIp, sizeof(ip4_addr_t));
+
+    return NET_HOST_FRAME_MIN;
+}
+
+static uint32_t _NetHost_EchoRequest(uint8_t *pu8Frame, uint16_t u16Seq)
+{
+    struct ip_hdr *ptIp = (struct ip_hdr *)&pu8Frame[SIZEOF_ETH_HDR];
+    struct icmp_echo_hdr *ptIcmp = (struct icmp_echo_hdr *)&pu8Frame[SIZEOF_ETH_HDR + IP_HLEN];
+    uint16_t u16IcmpLen = sizeof(struct icmp_echo_hdr) + NET_HOST_PING_DATA;
+
+    _NetHost_EthHdr(pu8Frame, g_u8aNetHostMac, ETHTYPE_IP);
+
+    IPH_VHL_SET(ptIp, 4, IP_HLEN / 4);
+    IPH_LEN_SET(ptIp, lwip_htons(IP_HLEN + u16IcmpLen));
+    IPH_TTL_SET(ptIp, 64);
+    IPH_PROTO_SET(ptIp, IP_PROTO_ICMP);
+    memcpy(&ptIp->src, &g_tNetHostPeerIp, sizeof(ip4_addr_t));
+    memcpy(&ptIp->dest, &g_tNetHostIp, sizeof(ip4_addr_t));
+    IPH_CHKSUM_SET(ptIp, inet_chksum(ptIp, IP_HLEN));
+
+    ICMPH_TYPE_SET(ptIcmp, ICMP_ECHO);
+    ptIcmp->id = PP_HTONS(0x4F50);
+    ptIcmp->seqno = lwip_htons(u16Seq);
+    memset(&ptIcmp[1], 0xA5, NET_HOST_PING_DATA);
+    ptIcmp->chksum = inet_chksum(ptIcmp, u16IcmpLen);
+
+    return SIZEOF_ETH_HDR + IP_HLEN + u16IcmpLen;
+}
+
+static void _NetHost_TcpipSync(void *pArg)
+{
+    sys_sem_signal((sys_sem_t *)pArg);
+}
+
+// everything queued to the tcpip thread before is done
+static void _NetHost_TcpipWait(void)
+{
+    sys_sem_t tSync;
+
+    HOST_TEST_EQ(sys_sem_new(&tSync, 0), ERR_OK);
+    HOST_TEST_EQ(tcpip_callback(_NetHost_TcpipSync, &tSync), ERR_OK);
+    sys_arch_sem_wait(&tSync, 0);
+    sys_sem_free(&tSync);
+}
+
+// the Wi-Fi RX task: a frame of the MAC to the netif
+static void _NetHost_Rx(void *pFrame, uint32_t u32Len)
+{
+    wlanif_input(&netif, pFrame, (u16_t)u32Len, NULL);
+    g_u32NetHostRxNum++;
+    HOST_TEST_EQ(g_u32NetHostRxFree, g_u32NetHostRxNum);
+
+    _NetHost_TcpipWait();
+}
+
+// take every element of the pool
+static void _NetHost_PoolEmpty(memp_t tType)
+{
+    g_u32NetHostPoolNum = 0;
+
+    while (g_u32NetHostPoolNum < NET_HOST_POOL_MAX)
+    {
+        g_paNetHostPool[g_u32NetHostPoolNum] = memp_malloc(tType);
+
+        if (!g_paNetHostPool[g_u32NetHostPoolNum])
+            break;
+
+        g_u32NetHostPoolNum++;
+    }
+
+    HOST_TEST_ASSERT(g_u32NetHostPoolNum < NET_HOST_POOL_MAX);
+}
+
+static void _NetHost_PoolRefill(memp_t tType)
+{
+    while (g_u32NetHostPoolNum)
+        memp_free(tType, g_paNetHostPool[--g_u32NetHostPoolNum]);
+}
+
+static void _NetHost_TxClear(void)
+{
+    g_u32NetHostTxNum = 0;
+    memset(g_u32aNetHostTxLen, 0, sizeof(g_u32aNetHostTxLen));
+}
+
+/*
+ * The cases, in order: each one adds to the counters of the ones before
+ */
+static void _NetHost_Arp(void)
+{
+    uint8_t u8aFrame[NET_HOST_FRAME_MAX];
+    struct etharp_hdr *ptArp = (struct etharp_hdr *)&g_u8aNetHostTx[0][SIZEOF_ETH_HDR];
+    uint32_t u32Len = _NetHost_ArpRequest(u8aFrame);
+    T_NetStatsNetif tStat;
+
+    _NetHost_TxClear();
+    _NetHost_Rx(u8aFrame, u32Len);
+
+    // the reply, to the peer
+    HOST_TEST_EQ(g_u32NetHostTxNum, 1);
+    HOST_TEST_ASSERT(!memcmp(g_u8aNetHostTx[0], g_u8aNetHostPeerMac, ETH_HWADDR_LEN));
+    HOST_TEST_EQ(((struct eth_hdr *)g_u8aNetHostTx[0])->type, PP_HTONS(ETHTYPE_ARP));
+    HOST_TEST_EQ(ptArp->opcode, PP_HTONS(ARP_REPLY));
+
+    g_u32NetHostRxBytes += u32Len;
+    g_u32NetHostTxBytes += g_u32aNetHostTxLen[0];
+
+    net_stats_netif_get(&tStat);
+    HOST_TEST_EQ(tStat.u32RxPkts, 1);
+    HOST_TEST_EQ(tStat.u32RxBytes, u32Len);
+    HOST_TEST_EQ(tStat.u32TxPkts, 1);
+    HOST_TEST_EQ(tStat.u32TxBytes, g_u32aNetHostTxLen[0]);
+    HOST_TEST_EQ(lwip_stats.link.recv, 1);
+    HOST_TEST_EQ(lwip_stats.link.xmit, 1);
+}
+
+static void _NetHost_Echo(void)
+{
+    uint8_t u8aFrame[NET_HOST_FRAME_MAX];
+    T_NetStatsNetif tStat;
+    uint32_t u32Len = 0;
+    uint16_t i = 0;
+
+    _NetHost_TxClear();
+
+    // the peer is in the ARP table since its request: the replies go at once
+    for (i = 0; i < NET_HOST_BURST; i++)
+    {
+        u32Len = _NetHost_EchoRequest(u8aFrame, i);
+        _NetHost_Rx(u8aFrame, u32Len);
+
+        g_u32NetHostRxBytes += u32Len;
+    }
+
+    HOST_TEST_EQ(g_u32NetHostTxNum, NET_HOST_BURST);
+
+    for (i = 0; i < NET_HOST_BURST; i++)
+    {
+        HOST_TEST_EQ(g_u32aNetHostTxLen[i], u32Len);
+        HOST_TEST_EQ(g_u8aNetHostTx[i][SIZEOF_ETH_HDR + IP_HLEN], ICMP_ER);
+        g_u32NetHostTxBytes += g_u32aNetHostTxLen[i];
+    }
+
+    net_stats_netif_get(&tStat);
+    HOST_TEST_EQ(tStat.u32RxPkts, 1 + NET_HOST_BURST);
+    HOST_TEST_EQ(tStat.u32RxBytes, g_u32NetHostRxBytes);
+    HOST_TEST_EQ(tStat.u32TxPkts, 1 + NET_HOST_BURST);
+    HOST_TEST_EQ(tStat.u32TxBytes, g_u32NetHostTxBytes);
+    HOST_TEST_EQ(lwip_stats.icmp.recv, NET_HOST_BURST);
+    HOST_TEST_EQ(lwip_stats.icmp.xmit, NET_HOST_BURST);
+}
+
+static void _NetHost_UnknownType(void)
+{
+    uint8_t u8aFrame[NET_HOST_FRAME_MAX];
+    T_NetStatsNetif tStat;
+
+    _NetHost_EthHdr(u8aFrame, g_u8aNetHostMac, NET_HOST_ETHTYPE_LLDP);
+    _NetHost_Rx(u8aFrame, NET_HOST_FRAME_MIN);
+    g_u32NetHostRxBytes += NET_HOST_FRAME_MIN;
+
+    // taken from the MAC, then dropped by type
+    net_stats_netif_get(&tStat);
+    HOST_TEST_EQ(tStat.u32RxPkts, 2 + NET_HOST_BURST);
+    HOST_TEST_EQ(tStat.u32RxUnknownType, 1);
+    HOST_TEST_EQ(tStat.u32RxNoBuf, 0);
+}
+
+// not a frame: none of them takes a pbuf, and none is a shortage
+static void _NetHost_Bad(void)
+{
+    uint8_t u8aFrame[NET_HOST_FRAME_MAX + 1];
+    T_NetStatsNetif tStat;
+    uint32_t u32PoolUsed = lwip_stats.memp[MEMP_PBUF_POOL]->used;
+
+    _NetHost_EchoRequest(u8aFrame, 0);
+
+    _NetHost_Rx(NULL, NET_HOST_FRAME_MIN);
+    _NetHost_Rx(u8aFrame, SIZEOF_ETH_HDR - 1);
+    _NetHost_Rx(u8aFrame, NET_HOST_FRAME_MAX + 1);
+
+    // the longest frame is still one
+    _NetHost_EthHdr(u8aFrame, g_u8aNetHostMac, NET_HOST_ETHTYPE_LLDP);
+    _NetHost_Rx(u8aFrame, NET_HOST_FRAME_MAX);
+    g_u32NetHostRxBytes += NET_HOST_FRAME_MAX;
+
+    net_stats_netif_get(&tStat);
+    HOST_TEST_EQ(tStat.u32RxBad, 3);
+    HOST_TEST_EQ(tStat.u32RxNoBuf, 0);
+    HOST_TEST_EQ(tStat.u32RxUnknownType, 2);
+    HOST_TEST_EQ(tStat.u32RxPkts, 3 + NET_HOST_BURST);
+    HOST_TEST_EQ(tStat.u32RxBytes, g_u32NetHostRxBytes);
+    HOST_TEST_EQ(lwip_stats.memp[MEMP_PBUF_POOL]->used, u32PoolUsed);
+}
+
+// a good frame and no pbuf for it
+static void _NetHost_NoBuf(void)
+{
+    uint8_t u8aFrame[NET_HOST_FRAME_MAX];
+    T_NetStatsNetif tStat;
+
+    _NetHost_PoolEmpty(MEMP_PBUF_POOL);
+    _NetHost_Rx(u8aFrame, _NetHost_EchoRequest(u8aFrame, 0));
+    _NetHost_PoolRefill(MEMP_PBUF_POOL);
+
+    net_stats_netif_get(&tStat);
+    HOST_TEST_EQ(tStat.u32RxNoBuf, 1);
+    HOST_TEST_EQ(tStat.u32RxBad, 3);
+    HOST_TEST_EQ(tStat.u32RxPkts, 3 + NET_HOST_BURST);
+}
+
+// a pbuf, and no message to the tcpip thread for it
+static void _NetHost_InputErr(void)
+{
+    uint8_t u8aFrame[NET_HOST_FRAME_MAX];
+    T_NetStatsNetif tStat;
+    uint32_t u32Len = _NetHost_EchoRequest(u8aFrame, 0);
+    uint32_t u32PoolUsed = lwip_stats.memp[MEMP_PBUF_POOL]->used;
+
+    _NetHost_TxClear();
+    _NetHost_PoolEmpty(MEMP_TCPIP_MSG_INPKT);
+    _NetHost_Rx(u8aFrame, u32Len);
+    _NetHost_PoolRefill(MEMP_TCPIP_MSG_INPKT);
+    g_u32NetHostRxBytes += u32Len;
+
+    net_stats_netif_get(&tStat);
+    HOST_TEST_EQ(tStat.u32RxInputErr, 1);
+    HOST_TEST_EQ(tStat.u32RxPkts, 4 + NET_HOST_BURST);
+    HOST_TEST_EQ(tStat.u32RxBytes, g_u32NetHostRxBytes);
+    HOST_TEST_EQ(g_u32NetHostTxNum, 0);
+
+    // the pbuf is freed
+    HOST_TEST_EQ(lwip_stats.memp[MEMP_PBUF_POOL]->used, u32PoolUsed);
+}
+
+// the echo of u16Seq, with u32Full TX_QUEUE_FULL before the MAC takes it
+static void _NetHost_EchoFull(uint16_t u16Seq, uint32_t u32Full, uint8_t u8Ready)
+{
+    uint8_t u8aFrame[NET_HOST_FRAME_MAX];
+    uint32_t u32Len = _NetHost_EchoRequest(u8aFrame, u16Seq);
+
+    _NetHost_TxClear();
+    g_u32NetHostTxFull = u32Full;
+    g_u8NetHostTxReady = u8Ready;
+
+    _NetHost_Rx(u8aFrame, u32Len);
+    g_u32NetHostRxBytes += u32Len;
+
+    HOST_TEST_EQ(g_u32NetHostTxFull, 0);
+    g_u8NetHostTxReady = 0;
+}
+
+static void _NetHost_TxQueueFull(void)
+{
+    T_NetStatsNetif tStat;
+    uint32_t u32Drop = lwip_stats.link.drop;
+
+    // the MAC frees a slot each time: no timeout
+    _NetHost_EchoFull(1, 2, 1);
+    HOST_TEST_EQ(g_u32NetHostTxNum, 1);
+    g_u32NetHostTxBytes += g_u32aNetHostTxLen[0];
+
+    net_stats_netif_get(&tStat);
+    HOST_TEST_EQ(tStat.u32TxQueueFull, 2);
+    HOST_TEST_EQ(tStat.u32TxRetry, 2);
+    HOST_TEST_EQ(tStat.u32TxStall, 2);
+    HOST_TEST_EQ(tStat.u32TxStallTimeout, 0);
+    HOST_TEST_EQ(tStat.u32TxDrop, 0);
+    HOST_TEST_EQ(tStat.u32TxPkts, 2 + NET_HOST_BURST);
+
+    // it does not: each wait times out after 1 ms
+    _NetHost_EchoFull(2, 1, 0);
+    HOST_TEST_EQ(g_u32NetHostTxNum, 1);
+    g_u32NetHostTxBytes += g_u32aNetHostTxLen[0];
+
+    net_stats_netif_get(&tStat);
+    HOST_TEST_EQ(tStat.u32TxQueueFull, 3);
+    HOST_TEST_EQ(tStat.u32TxStallTimeout, 1);
+    HOST_TEST_ASSERT(tStat.u32TxStallMs >= 1);
+    HOST_TEST_ASSERT(tStat.u32TxStallMaxMs >= 1);
+    HOST_TEST_EQ(tStat.u32TxPkts, 3 + NET_HOST_BURST);
+    HOST_TEST_EQ(tStat.u32TxBytes, g_u32NetHostTxBytes);
+
+    // given up after WLANNETIF_TX_RETRY_MAX: a link drop, not a packet
+    _NetHost_EchoFull(3, 3 + 1, 1);
+    HOST_TEST_EQ(g_u32NetHostTxNum, 0);
+
+    net_stats_netif_get(&tStat);
+    HOST_TEST_EQ(tStat.u32TxQueueFull, 3 + 3 + 1);
+    HOST_TEST_EQ(tStat.u32TxRetry, 2 + 1 + 3);
+    HOST_TEST_EQ(tStat.u32TxDrop, 1);
+    HOST_TEST_EQ(tStat.u32TxPkts, 3 + NET_HOST_BURST);
+    HOST_TEST_EQ(tStat.u32TxBytes, g_u32NetHostTxBytes);
+    HOST_TEST_EQ(lwip_stats.link.drop, u32Drop + 1);
+}
+
+static void _NetHost_Report(void)
+{
+    char baCmd[] = "netstats";
+    char baAt[] = "at+netstats?";
+    char baLine[256];
+    T_NetStatsNetif tStat;
+
+    net_stats_netif_get(&tStat);
+
+    _NetHost_OutReset();
+    net_stats_cmd(baCmd);
+    snprintf(baLine, sizeof(baLine), NET_HOST_RX_LINE, tStat.u32RxPkts, tStat.u32RxBytes);
+    HOST_TEST_ASSERT(strstr(g_baNetHostOut, baLine) != NULL);
+
+    _NetHost_OutReset();
+    HOST_TEST_EQ(net_stats_at_cmd(baAt, strlen(baAt), AT_CMD_MODE_READ), 1);
+    snprintf(baLine, sizeof(baLine), NET_HOST_TX_LINE, tStat.u32TxPkts, tStat.u32TxBytes);
+    HOST_TEST_ASSERT(strstr(g_baNetHostOut, baLine) != NULL);
+}
+
+static void _NetHost_Reset(void)
+{
+    char baCmd[] = "netstats reset";
+    T_NetStatsNetif tStat;
+    T_NetStatsNetif tZero;
+
+    _NetHost_OutReset();
+    net_stats_cmd(baCmd);
+    HOST_TEST_ASSERT(strstr(g_baNetHostOut, "netstats: reset=1") != NULL);
+
+    memset(&tZero, 0, sizeof(tZero));
+    net_stats_netif_get(&tStat);
+    HOST_TEST_ASSERT(!memcmp(&tStat, &tZero, sizeof(tStat)));
+    HOST_TEST_EQ(lwip_stats.link.recv, 0);
+    HOST_TEST_EQ(lwip_stats.link.drop, 0);
+}
+
+static const T_HostTestCase g_taNetHostCase[] =
+{
+    HOST_TEST_CASE(_NetHost_Arp),
+    HOST_TEST_CASE(_NetHost_Echo),
+    HOST_TEST_CASE(_NetHost_UnknownType),
+    HOST_TEST_CASE(_NetHost_Bad),
+    HOST_TEST_CASE(_NetHost_NoBuf),
+    HOST_TEST_CASE(_NetHost_InputErr),
+    HOST_TEST_CASE(_NetHost_TxQueueFull),
+    HOST_TEST_CASE(_NetHost_Report),
+    HOST_TEST_CASE(_NetHost_Reset),
+};
+
+// the Wi-Fi netif as the network task adds it, with a static address
+static void _NetHost_NetifAdd(void *pArg)
+{
+    ip4_addr_t tMask;
+    ip4_addr_t tGw;
+
+    IP4_ADDR(&tMask, 255, 255, 255, 0);
+    IP4_ADDR(&tGw, 192, 168, 1, 1);
+
+    if (netif_add(&netif, &g_tNetHostIp, &tMask, &tGw, NULL, ethernetif_init, tcpip_input))
+        netif_set_up(&netif);
+
+    sys_sem_signal((sys_sem_t *)pArg);
+}
+
+int main(void)
+{
+    sys_sem_t tDone;
+
+    HostOs_Init();
+
+    IP4_ADDR(&g_tNetHostIp, 192, 168, 1, 2);
+    IP4_ADDR(&g_tNetHostPeerIp, 192, 168, 1, 1);
+
+    // the ROM wlannetif.c and wlannetif_patch.c are loaded with the table
+    if (LwipHost_Init())
+        return 1;
+
+    if (sys_sem_new(&tDone, 0) != ERR_OK)
+        return 1;
+
+    tcpip_callback(_NetHost_NetifAdd, &tDone);
+    sys_arch_sem_wait(&tDone, 0);
+    sys_sem_free(&tDone);
+
+    if ((!netif_is_up(&netif)) || (memcmp(netif.hwaddr, g_u8aNetHostMac, ETH_HWADDR_LEN)))
+        return 1;
+
+    tracer_drct_printf = _NetHost_Tracer;
+    net_stats_reset();
+
+    return HostTest_Run("net_stats", g_taNetHostCase, HOST_TEST_NUM(g_taNetHostCase));
+}
@@ -0,0 +1,90 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/*
+ * arch/cc.h of the host lwIP build.
+ *
+ * Same as ports/freertos/include/arch/cc.h, so the core is built with
+ * LWIP_ROMBUILD and reached through the rom_if function pointers like on the
+ * target, except:
+ * - the fixed-size types come from stdint.h (long is 64 bit on the host)
+ * - the retention section and the ROM memp symbol map are left out
+ * - sys_arch.h is the pthread one of contrib/ports/unix; the FreeRTOS
+ *   headers are still included, as the target sys_arch.h does
+ * - struct timeval and fd_set are lwIP's own, as on the target; the host
+ *   headers must not bring the libc ones (see CMakeLists.txt)
+ * - MEM_LIBC_MALLOC takes its blocks from the model of the target heap in
+ *   lwip_host_port.c, not from the host C library
+ */
+
+#ifndef __ARCH_CC_H__
+#define __ARCH_CC_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define LWIP_PROVIDE_ERRNO
+
+#ifndef BYTE_ORDER
+#define BYTE_ORDER LITTLE_ENDIAN
+#endif /* BYTE_ORDER */
+
+typedef uint8_t     u8_t;
+typedef int8_t      s8_t;
+typedef uint16_t    u16_t;
+typedef int16_t     s16_t;
+typedef uint32_t    u32_t;
+typedef int32_t     s32_t;
+typedef uintptr_t   mem_ptr_t;
+
+#define X8_F  "02x"
+#define U16_F "u"
+#define S16_F "d"
+#define X16_F "x"
+#define U32_F "u"
+#define S32_F "d"
+#define X32_F "x"
+#define SZT_F "zu"
+
+#define PACK_STRUCT_FIELD(x) x
+#define PACK_STRUCT_STRUCT __attribute__((packed))
+#define PACK_STRUCT_BEGIN
+#define PACK_STRUCT_END
+
+#define LWIP_PLATFORM_DIAG(x) do {printf x;} while(0)
+#define LWIP_PLATFORM_ASSERT(x) do {printf("Assertion \"%s\" failed at line %d in %s\n", \
+                                     x, __LINE__, __FILE__); fflush(NULL); abort();} while(0)
+
+#define LWIP_RAND() ((u32_t)rand())
+
+void *LwipHost_MemClibMalloc(size_t tSize);
+void LwipHost_MemClibFree(void *pMem);
+void *LwipHost_MemClibCalloc(size_t tNum, size_t tSize);
+
+#define mem_clib_malloc     LwipHost_MemClibMalloc
+#define mem_clib_free       LwipHost_MemClibFree
+#define mem_clib_calloc     LwipHost_MemClibCalloc
+
+#define LWIP_ROMBUILD
+
+#if defined(LWIP_ROMBUILD)
+    #define LWIP_ROMFN(_fn)  _fn##_impl
+    #define LWIP_RETDATA
+#else
+    #define LWIP_ROMFN(_fn)  _fn
+    #define LWIP_RETDATA
+#endif
+
+#endif /* __ARCH_CC_H__ */
@@ -0,0 +1,838 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  lwip_host_port.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  Target-only parts of the lwIP module table for the host build, the
+*  stack bring-up used by the host benchmarks and tests, the heap of the
+*  target under MEM_LIBC_MALLOC, and the emulated
+*  link: netif_loop_output() behind a delay and loss, as the ROM function
+*  is patched on the target. The pipe netif is a second interface with a
+*  peer outside the stack, the test, on a socket pair.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "cmsis_os.h"
+#include "lwip/opt.h"
+#include "lwip/tcpip.h"
+#include "lwip/sys.h"
+#include "lwip/pbuf.h"
+#include "lwip/netif.h"
+#include "lwip/stats.h"
+#include "netif_if.h"
+#include "lwip_jmptbl.h"
+#include "lwip_jmptbl_patch.h"
+#include "lwip_host_port.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define LWIP_HOST_HEAP_USED         (0xFFFFFFFF)    // next of an allocated block
+#define LWIP_HOST_HEAP_MIN_BLK      (LWIP_HOST_HEAP_HDR * 2)
+
+#define LWIP_HOST_LINK_DRAIN_MS     (10)
+
+#define LWIP_HOST_PIPE_FD_NETIF     (0)
+#define LWIP_HOST_PIPE_FD_PEER      (1)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+// at the start of every block, free or not
+typedef struct
+{
+    uint32_t u32Next;                           // offset of the next free block
+    uint32_t u32Size;                           // the header included
+} T_LwipHostHeapBlk;
+
+typedef struct
+{
+    uint32_t u32DueMs;
+    struct netif *ptNetif;
+    uint8_t *pu8Data;
+    uint16_t u16Len;
+} T_LwipHostLinkPkt;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+#if defined(LWIP_DYNAMIC_DEBUG_ENABLE)
+// lwip_cli.c owns the table on the target; here every flag stays off
+struct lwip_debug_flags lwip_debug_flags[LWIP_DEBUG_IDX(DNS_DEBUG) + 2];
+#endif
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static size_t g_tLwipHostHeapMinEver = configTOTAL_HEAP_SIZE;
+
+// the FreeRTOS heap of the target
+static uint64_t g_u64aLwipHostHeapArena[LWIP_HOST_HEAP_SIZE / sizeof(uint64_t)];
+static T_LwipHostHeap g_tLwipHostHeap;
+
+// the link: a FIFO, the delay is the same for every packet
+static netif_loop_output_fp_t g_fpLwipHostLoopOutput = NULL;
+static T_LwipHostLinkPkt g_taLwipHostLink[LWIP_HOST_LINK_QUEUE_MAX];
+static uint32_t g_u32LwipHostLinkHead;
+static uint32_t g_u32LwipHostLinkNum;
+static uint32_t g_u32LwipHostLinkSeed;
+static T_LwipHostLinkStat g_tLwipHostLink;
+static sys_mutex_t g_tLwipHostLinkLock;
+static sys_sem_t g_tLwipHostLinkSem;
+
+// the pipe: the counters are taken under the tcpip core lock
+static struct netif g_tLwipHostPipe;
+static int g_s32aLwipHostPipeFd[2] = {-1, -1};
+static T_LwipHostPipeStat g_tLwipHostPipeStat;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+/*
+ * The host sys_arch (contrib/ports/unix) is called directly, and the Wi-Fi
+ * netif, the helpers and the CLIs of the table do not exist here.
+ */
+void lwip_load_interface_sys_arch(void)
+{
+}
+
+// a test with the Wi-Fi netif (net_stats_host) links the real loaders
+__attribute__((weak)) void lwip_load_interface_wlannetif(void)
+{
+}
+
+__attribute__((weak)) void lwip_load_interface_wlannetif_patch(void)
+{
+}
+
+void lwip_load_interface_lwip_helper(void)
+{
+}
+
+void lwip_load_interface_network_config(void)
+{
+}
+
+void lwip_load_interface_cli(void)
+{
+}
+
+void lwip_load_interface_socket_app(void)
+{
+}
+
+/*
+ * The heap model
+ */
+#define LWIP_HOST_HEAP_BLK(ptHeap, u32Off)  ((T_LwipHostHeapBlk *)((ptHeap)->pu8Arena + (u32Off)))
+
+// after every change: the largest block and the peaks
+static void _LwipHost_HeapTrack(T_LwipHostHeap *ptHeap)
+{
+    T_LwipHostHeapStat *ptStat = &ptHeap->tStat;
+    uint32_t u32Off = ptHeap->u32FreeHead;
+    uint32_t u32Largest = 0;
+    uint32_t u32Frag = 0;
+
+    while (u32Off < ptHeap->u32Size)
+    {
+        if (LWIP_HOST_HEAP_BLK(ptHeap, u32Off)->u32Size > u32Largest)
+            u32Largest = LWIP_HOST_HEAP_BLK(ptHeap, u32Off)->u32Size;
+
+        u32Off = LWIP_HOST_HEAP_BLK(ptHeap, u32Off)->u32Next;
+    }
+
+    ptStat->u32Largest = u32Largest;
+
+    if (ptStat->u32Free < ptStat->u32FreeMin)
+        ptStat->u32FreeMin = ptStat->u32Free;
+
+    if (u32Largest < ptStat->u32LargestMin)
+        ptStat->u32LargestMin = u32Largest;
+
+    u32Frag = ((ptStat->u32Free - u32Largest) * 100) / ptHeap->u32Size;
+
+    if (u32Frag > ptStat->u32FragMaxPct)
+        ptStat->u32FragMaxPct = u32Frag;
+}
+
+void LwipHost_HeapInit(T_LwipHostHeap *ptHeap, uint8_t *pu8Arena, uint32_t u32Size)
+{
+    memset(ptHeap, 0, sizeof(*ptHeap));
+
+    ptHeap->pu8Arena = pu8Arena;
+    ptHeap->u32Size = u32Size & ~(LWIP_HOST_HEAP_ALIGN - 1);
+    ptHeap->u32FreeHead = 0;
+
+    LWIP_HOST_HEAP_BLK(ptHeap, 0)->u32Next = ptHeap->u32Size;
+    LWIP_HOST_HEAP_BLK(ptHeap, 0)->u32Size = ptHeap->u32Size;
+
+    ptHeap->tStat.u32Free = ptHeap->u32Size;
+    LwipHost_HeapStatReset(ptHeap);
+}
+
+// the first free block that fits, split when the rest is a block of its own
+void *LwipHost_HeapAlloc(T_LwipHostHeap *ptHeap, uint32_t u32Size)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+    T_LwipHostHeapBlk *ptBlk = NULL;
+    T_LwipHostHeapBlk *ptRest = NULL;
+    uint32_t u32Want = 0;
+    uint32_t u32Prev = 0;
+    uint32_t u32Off = 0;
+    void *pMem = NULL;
+
+    SYS_ARCH_PROTECT(lev);
+
+    if ((!u32Size) || (u32Size > ptHeap->u32Size))
+        goto done;
+
+    u32Want = ((u32Size + LWIP_HOST_HEAP_ALIGN - 1) & ~(LWIP_HOST_HEAP_ALIGN - 1)) + LWIP_HOST_HEAP_HDR;
+    u32Prev = ptHeap->u32Size;
+    u32Off = ptHeap->u32FreeHead;
+
+    while ((u32Off < ptHeap->u32Size) && (LWIP_HOST_HEAP_BLK(ptHeap, u32Off)->u32Size < u32Want))
+    {
+        u32Prev = u32Off;
+        u32Off = LWIP_HOST_HEAP_BLK(ptHeap, u32Off)->u32Next;
+    }
+
+    if (u32Off >= ptHeap->u32Size)
+        goto done;
+
+    ptBlk = LWIP_HOST_HEAP_BLK(ptHeap, u32Off);
+
+    if ((ptBlk->u32Size - u32Want) >= LWIP_HOST_HEAP_MIN_BLK)
+    {
+        ptRest = LWIP_HOST_HEAP_BLK(ptHeap, u32Off + u32Want);
+        ptRest->u32Next = ptBlk->u32Next;
+        ptRest->u32Size = ptBlk->u32Size - u32Want;
+        ptBlk->u32Next = u32Off + u32Want;
+        ptBlk->u32Size = u32Want;
+    }
+
+    if (u32Prev < ptHeap->u32Size)
+        LWIP_HOST_HEAP_BLK(ptHeap, u32Prev)->u32Next = ptBlk->u32Next;
+    else
+        ptHeap->u32FreeHead = ptBlk->u32Next;
+
+    ptBlk->u32Next = LWIP_HOST_HEAP_USED;
+    ptHeap->tStat.u32Free -= ptBlk->u32Size;
+    ptHeap->tStat.u32Allocs++;
+
+    _LwipHost_HeapTrack(ptHeap);
+
+    pMem = (uint8_t *)ptBlk + LWIP_HOST_HEAP_HDR;
+
+done:
+    if (pMem == NULL)
+        ptHeap->tStat.u32Fails++;
+
+    SYS_ARCH_UNPROTECT(lev);
+
+    return pMem;
+}
+
+// back in address order, merged with the free neighbours
+void LwipHost_HeapFree(T_LwipHostHeap *ptHeap, void *pMem)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+    T_LwipHostHeapBlk *ptBlk = NULL;
+    T_LwipHostHeapBlk *ptPrev = NULL;
+    uint32_t u32Off = 0;
+    uint32_t u32Prev = 0;
+    uint32_t u32Next = 0;
+
+    if (pMem == NULL)
+        return;
+
+    u32Off = (uint32_t)((uint8_t *)pMem - ptHeap->pu8Arena) - LWIP_HOST_HEAP_HDR;
+    ptBlk = LWIP_HOST_HEAP_BLK(ptHeap, u32Off);
+
+    LWIP_ASSERT("LwipHost_HeapFree: not an allocated block", ptBlk->u32Next == LWIP_HOST_HEAP_USED);
+
+    SYS_ARCH_PROTECT(lev);
+
+    ptHeap->tStat.u32Free += ptBlk->u32Size;
+    ptHeap->tStat.u32Frees++;
+
+    u32Prev = ptHeap->u32Size;
+    u32Next = ptHeap->u32FreeHead;
+
+    while (u32Next < u32Off)
+    {
+        u32Prev = u32Next;
+        u32Next = LWIP_HOST_HEAP_BLK(ptHeap, u32Next)->u32Next;
+    }
+
+    ptBlk->u32Next = u32Next;
+
+    if ((u32Next < ptHeap->u32Size) && ((u32Off + ptBlk->u32Size) == u32Next))
+    {
+        ptBlk->u32Size += LWIP_HOST_HEAP_BLK(ptHeap, u32Next)->u32Size;
+        ptBlk->u32Next = LWIP_HOST_HEAP_BLK(ptHeap, u32Next)->u32Next;
+    }
+
+    if (u32Prev < ptHeap->u32Size)
+    {
+        ptPrev = LWIP_HOST_HEAP_BLK(ptHeap, u32Prev);
+
+        if ((u32Prev + ptPrev->u32Size) == u32Off)
+        {
+            ptPrev->u32Size += ptBlk->u32Size;
+            ptPrev->u32Next = ptBlk->u32Next;
+        }
+        else
+        {
+            ptPrev->u32Next = u32Off;
+        }
+    }
+    else
+    {
+        ptHeap->u32FreeHead = u32Off;
+    }
+
+    _LwipHost_HeapTrack(ptHeap);
+
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+void LwipHost_HeapStatGet(T_LwipHostHeap *ptHeap, T_LwipHostHeapStat *ptStat)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    memcpy(ptStat, &ptHeap->tStat, sizeof(*ptStat));
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+void LwipHost_HeapStatReset(T_LwipHostHeap *ptHeap)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    ptHeap->tStat.u32FreeMin = ptHeap->tStat.u32Free;
+    ptHeap->tStat.u32LargestMin = ptHeap->u32Size;
+    ptHeap->tStat.u32FragMaxPct = 0;
+    _LwipHost_HeapTrack(ptHeap);
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+T_LwipHostHeap *LwipHost_Heap(void)
+{
+    if (g_tLwipHostHeap.pu8Arena == NULL)
+        LwipHost_HeapInit(&g_tLwipHostHeap, (uint8_t *)g_u64aLwipHostHeapArena, sizeof(g_u64aLwipHostHeapArena));
+
+    return &g_tLwipHostHeap;
+}
+
+// mem_clib_malloc() and friends of arch/cc.h
+void *LwipHost_MemClibMalloc(size_t tSize)
+{
+    void *pMem = LwipHost_HeapAlloc(LwipHost_Heap(), (uint32_t)tSize);
+
+    xPortGetFreeHeapSize();
+
+    return pMem;
+}
+
+void LwipHost_MemClibFree(void *pMem)
+{
+    LwipHost_HeapFree(LwipHost_Heap(), pMem);
+}
+
+void *LwipHost_MemClibCalloc(size_t tNum, size_t tSize)
+{
+    void *pMem = LwipHost_MemClibMalloc(tNum * tSize);
+
+    if (pMem != NULL)
+        memset(pMem, 0, tNum * tSize);
+
+    return pMem;
+}
+
+/*
+ * lwIP is the only user of the heap here: task stacks and queues are
+ * taken by pthread and the host C library. What is in use is counted
+ * against configTOTAL_HEAP_SIZE, as the device would have it.
+ */
+size_t xPortGetFreeHeapSize(void)
+{
+    T_LwipHostHeapStat tStat;
+    size_t tUsed;
+    size_t tFree = 0;
+
+    LwipHost_HeapStatGet(LwipHost_Heap(), &tStat);
+    tUsed = LWIP_HOST_HEAP_SIZE - tStat.u32Free;
+
+    if (tUsed < configTOTAL_HEAP_SIZE)
+        tFree = configTOTAL_HEAP_SIZE - tUsed;
+
+    if (tFree < g_tLwipHostHeapMinEver)
+        g_tLwipHostHeapMinEver = tFree;
+
+    return tFree;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize(void)
+{
+    xPortGetFreeHeapSize();
+    return g_tLwipHostHeapMinEver;
+}
+
+static void _LwipHost_TcpipDone(void *pArg)
+{
+    sys_sem_signal((sys_sem_t *)pArg);
+}
+
+/*************************************************************************
+* FUNCTION:
+*   LwipHost_Init
+*
+* DESCRIPTION:
+*   Load the lwIP function table like the boot does (ROM table, then the
+*   patches) and start the tcpip thread with the loopback interface.
+*
+* RETURNS
+*   0 : success
+*   -1 : fail
+*
+*************************************************************************/
+int LwipHost_Init(void)
+{
+    sys_sem_t tDone;
+
+    lwip_module_interface_init();
+    lwip_module_interface_init_patch();
+
+    if (sys_sem_new(&tDone, 0) != ERR_OK)
+        return -1;
+
+    tcpip_init(_LwipHost_TcpipDone, &tDone);
+    sys_arch_sem_wait(&tDone, 0);
+    sys_sem_free(&tDone);
+
+    return 0;
+}
+
+/*
+ * The emulated link
+ */
+static uint32_t _LwipHost_LinkRand(void)
+{
+    g_u32LwipHostLinkSeed = (g_u32LwipHostLinkSeed * 1103515245) + 12345;
+    return g_u32LwipHostLinkSeed >> 8;
+}
+
+// netif_loop_output_adpt while the link is on, the core is locked by the caller
+static err_t _LwipHost_LinkOutput(struct netif *netif, struct pbuf *p)
+{
+    T_LwipHostLinkPkt *ptPkt = NULL;
+    uint8_t *pu8Data = NULL;
+
+    sys_mutex_lock(&g_tLwipHostLinkLock);
+
+    g_tLwipHostLink.u32Sent++;
+
+    if ((_LwipHost_LinkRand() % 1000) < g_tLwipHostLink.u32LossPermille)
+    {
+        g_tLwipHostLink.u32Lost++;
+        goto done;
+    }
+
+    if (g_u32LwipHostLinkNum >= LWIP_HOST_LINK_QUEUE_MAX)
+    {
+        g_tLwipHostLink.u32Overflow++;
+        goto done;
+    }
+
+    // the air: not lwIP memory
+    pu8Data = (uint8_t *)malloc(p->tot_len);
+
+    if (pu8Data == NULL)
+    {
+        g_tLwipHostLink.u32Overflow++;
+        goto done;
+    }
+
+    pbuf_copy_partial(p, pu8Data, p->tot_len, 0);
+
+    ptPkt = &g_taLwipHostLink[(g_u32LwipHostLinkHead + g_u32LwipHostLinkNum) % LWIP_HOST_LINK_QUEUE_MAX];
+    ptPkt->u32DueMs = sys_now() + g_tLwipHostLink.u32DelayMs;
+    ptPkt->ptNetif = netif;
+    ptPkt->pu8Data = pu8Data;
+    ptPkt->u16Len = p->tot_len;
+
+    g_u32LwipHostLinkNum++;
+
+    if (g_u32LwipHostLinkNum > g_tLwipHostLink.u32InFlightMax)
+        g_tLwipHostLink.u32InFlightMax = g_u32LwipHostLinkNum;
+
+    // the link thread sleeps for good on an empty queue
+    if (g_u32LwipHostLinkNum == 1)
+        sys_sem_signal(&g_tLwipHostLinkSem);
+
+done:
+    sys_mutex_unlock(&g_tLwipHostLinkLock);
+
+    // a lost packet is sent as far as the sender knows
+    return ERR_OK;
+}
+
+// hands each packet to the ROM netif_loop_output() once its delay is over
+static void _LwipHost_LinkThread(void *pArg)
+{
+    T_LwipHostLinkPkt tPkt;
+    struct pbuf *ptBuf = NULL;
+    uint32_t u32Now = 0;
+    err_t tErr = ERR_OK;
+
+    while (1)
+    {
+        sys_mutex_lock(&g_tLwipHostLinkLock);
+
+        if (!g_u32LwipHostLinkNum)
+        {
+            sys_mutex_unlock(&g_tLwipHostLinkLock);
+            sys_arch_sem_wait(&g_tLwipHostLinkSem, 0);
+            continue;
+        }
+
+        tPkt = g_taLwipHostLink[g_u32LwipHostLinkHead];
+        u32Now = sys_now();
+
+        if ((int32_t)(tPkt.u32DueMs - u32Now) > 0)
+        {
+            sys_mutex_unlock(&g_tLwipHostLinkLock);
+            sys_arch_sem_wait(&g_tLwipHostLinkSem, tPkt.u32DueMs - u32Now);
+            continue;
+        }
+
+        sys_mutex_unlock(&g_tLwipHostLinkLock);
+
+        LOCK_TCPIP_CORE();
+
+        // netif_loop_output() copies the packet, a reference is enough
+        tErr = ERR_MEM;
+        ptBuf = pbuf_alloc(PBUF_RAW, tPkt.u16Len, PBUF_REF);
+
+        if (ptBuf != NULL)
+        {
+            ptBuf->payload = tPkt.pu8Data;
+            tErr = g_fpLwipHostLoopOutput(tPkt.ptNetif, ptBuf);
+            pbuf_free(ptBuf);
+        }
+
+        // dequeued after the hand-over: LwipHost_LinkSet(0, 0) waits for an empty queue
+        sys_mutex_lock(&g_tLwipHostLinkLock);
+
+        g_u32LwipHostLinkHead = (g_u32LwipHostLinkHead + 1) % LWIP_HOST_LINK_QUEUE_MAX;
+        g_u32LwipHostLinkNum--;
+
+        if (tErr == ERR_OK)
+            g_tLwipHostLink.u32Delivered++;
+        else
+            g_tLwipHostLink.u32Refused++;
+
+        sys_mutex_unlock(&g_tLwipHostLinkLock);
+
+        UNLOCK_TCPIP_CORE();
+
+        free(tPkt.pu8Data);
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   LwipHost_LinkSet
+*
+* DESCRIPTION:
+*   Put the loopback netif behind the emulated link, or back to the plain
+*   loopback with both 0 once the packets in flight are delivered. The
+*   counters and the loss sequence restart, so runs can be compared.
+*
+* PARAMETERS
+*   u32DelayMs :        [IN] one-way delay
+*   u32LossPermille :   [IN] packets lost in 1000, 0 ~ 1000
+*
+* RETURNS
+*   0 : success
+*   -1 : fail
+*
+*************************************************************************/
+int LwipHost_LinkSet(uint32_t u32DelayMs, uint32_t u32LossPermille)
+{
+    uint32_t u32Num = 0;
+
+    if (u32LossPermille > 1000)
+        return -1;
+
+    if (g_fpLwipHostLoopOutput == NULL)
+    {
+        if (sys_mutex_new(&g_tLwipHostLinkLock) != ERR_OK)
+            return -1;
+
+        if (sys_sem_new(&g_tLwipHostLinkSem, 0) != ERR_OK)
+            return -1;
+
+        g_fpLwipHostLoopOutput = netif_loop_output_adpt;
+        sys_thread_new("lwip_host_link", _LwipHost_LinkThread, NULL, 0, 0);
+    }
+
+    if ((!u32DelayMs) && (!u32LossPermille))
+    {
+        do
+        {
+            sys_mutex_lock(&g_tLwipHostLinkLock);
+            u32Num = g_u32LwipHostLinkNum;
+            sys_mutex_unlock(&g_tLwipHostLinkLock);
+
+            if (u32Num)
+                osDelay(LWIP_HOST_LINK_DRAIN_MS);
+        } while (u32Num);
+    }
+
+    LOCK_TCPIP_CORE();
+    sys_mutex_lock(&g_tLwipHostLinkLock);
+
+    memset(&g_tLwipHostLink, 0, sizeof(g_tLwipHostLink));
+    g_tLwipHostLink.u32DelayMs = u32DelayMs;
+    g_tLwipHostLink.u32LossPermille = u32LossPermille;
+    g_u32LwipHostLinkSeed = 1;
+
+    netif_loop_output_adpt = ((u32DelayMs) || (u32LossPermille)) ? _LwipHost_LinkOutput : g_fpLwipHostLoopOutput;
+
+    sys_mutex_unlock(&g_tLwipHostLinkLock);
+    UNLOCK_TCPIP_CORE();
+
+    return 0;
+}
+
+void LwipHost_LinkStatGet(T_LwipHostLinkStat *ptStat)
+{
+    if (g_fpLwipHostLoopOutput == NULL)
+    {
+        memset(ptStat, 0, sizeof(*ptStat));
+        return;
+    }
+
+    sys_mutex_lock(&g_tLwipHostLinkLock);
+    memcpy(ptStat, &g_tLwipHostLink, sizeof(*ptStat));
+    sys_mutex_unlock(&g_tLwipHostLinkLock);
+}
+
+/*
+ * The pipe netif
+ */
+// netif->output, in the tcpip thread: one packet, one datagram
+static err_t _LwipHost_PipeOutput(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    uint8_t u8aBuf[LWIP_HOST_PIPE_MTU];
+    ssize_t tLen = -1;
+
+    if (p->tot_len <= sizeof(u8aBuf))
+    {
+        pbuf_copy_partial(p, u8aBuf, p->tot_len, 0);
+
+        // blocks while the peer is behind, as a full TX queue of the MAC would
+        do
+        {
+            tLen = send(g_s32aLwipHostPipeFd[LWIP_HOST_PIPE_FD_NETIF], u8aBuf, p->tot_len, 0);
+        } while ((tLen < 0) && (errno == EINTR));
+    }
+
+    if (tLen != (ssize_t)p->tot_len)
+    {
+        g_tLwipHostPipeStat.u32TxErr++;
+        return ERR_IF;
+    }
+
+    g_tLwipHostPipeStat.u32TxPkts++;
+    g_tLwipHostPipeStat.u32TxBytes += p->tot_len;
+
+    return ERR_OK;
+}
+
+static err_t _LwipHost_PipeIfInit(struct netif *netif)
+{
+    netif->name[0] = 'p';
+    netif->name[1] = 'i';
+    netif->mtu = LWIP_HOST_PIPE_MTU;
+    netif->output = _LwipHost_PipeOutput;
+    netif->flags = NETIF_FLAG_BROADCAST;
+
+    return ERR_OK;
+}
+
+// what the peer writes, to tcpip_input() as the RX task of a driver does
+static void _LwipHost_PipeThread(void *pArg)
+{
+    uint8_t u8aBuf[LWIP_HOST_PIPE_MTU];
+    struct pbuf *ptBuf = NULL;
+    ssize_t tLen = 0;
+    uint8_t u8Drop = 0;
+
+    while (1)
+    {
+        tLen = recv(g_s32aLwipHostPipeFd[LWIP_HOST_PIPE_FD_NETIF], u8aBuf, sizeof(u8aBuf), 0);
+
+        if (tLen <= 0)
+            continue;
+
+        u8Drop = 1;
+        ptBuf = pbuf_alloc(PBUF_RAW, (u16_t)tLen, PBUF_POOL);
+
+        if (ptBuf != NULL)
+        {
+            pbuf_take(ptBuf, u8aBuf, (u16_t)tLen);
+
+            if (g_tLwipHostPipe.input(ptBuf, &g_tLwipHostPipe) == ERR_OK)
+                u8Drop = 0;
+            else
+                pbuf_free(ptBuf);
+        }
+
+        LOCK_TCPIP_CORE();
+
+        if (u8Drop)
+        {
+            g_tLwipHostPipeStat.u32RxDrop++;
+        }
+        else
+        {
+            g_tLwipHostPipeStat.u32RxPkts++;
+            g_tLwipHostPipeStat.u32RxBytes += (uint32_t)tLen;
+        }
+
+        UNLOCK_TCPIP_CORE();
+    }
+}
+
+/*************************************************************************
+* FUNCTION:
+*   LwipHost_PipeInit
+*
+* DESCRIPTION:
+*   Add the pipe netif at LWIP_HOST_PIPE_ADDR and bring it up. The subnet
+*   is routed to it, the loopback netif stays the default. Once is enough,
+*   a second call does nothing.
+*
+* RETURNS
+*   0 : success
+*   -1 : fail
+*
+*************************************************************************/
+int LwipHost_PipeInit(void)
+{
+    ip4_addr_t tAddr;
+    ip4_addr_t tMask;
+    ip4_addr_t tGw;
+    int iRet = -1;
+
+    if (g_s32aLwipHostPipeFd[LWIP_HOST_PIPE_FD_NETIF] >= 0)
+        return 0;
+
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, g_s32aLwipHostPipeFd))
+        return -1;
+
+    ip4addr_aton(LWIP_HOST_PIPE_ADDR, &tAddr);
+    ip4addr_aton(LWIP_HOST_PIPE_MASK, &tMask);
+    ip4_addr_set_zero(&tGw);
+
+    LOCK_TCPIP_CORE();
+
+    if (netif_add(&g_tLwipHostPipe, &tAddr, &tMask, &tGw, NULL, _LwipHost_PipeIfInit, tcpip_input) == NULL)
+        goto done;
+
+    netif_set_up(&g_tLwipHostPipe);
+    netif_set_link_up(&g_tLwipHostPipe);
+
+    iRet = 0;
+
+done:
+    UNLOCK_TCPIP_CORE();
+
+    if (iRet)
+    {
+        close(g_s32aLwipHostPipeFd[LWIP_HOST_PIPE_FD_NETIF]);
+        close(g_s32aLwipHostPipeFd[LWIP_HOST_PIPE_FD_PEER]);
+        g_s32aLwipHostPipeFd[LWIP_HOST_PIPE_FD_NETIF] = -1;
+        g_s32aLwipHostPipeFd[LWIP_HOST_PIPE_FD_PEER] = -1;
+        return -1;
+    }
+
+    sys_thread_new("lwip_host_pipe", _LwipHost_PipeThread, NULL, 0, 0);
+
+    return 0;
+}
+
+// the peer: one packet the netif sent, blocks until there is one
+int LwipHost_PipePeerRecv(uint8_t *pu8Buf, uint32_t u32Size)
+{
+    ssize_t tLen = -1;
+
+    do
+    {
+        tLen = recv(g_s32aLwipHostPipeFd[LWIP_HOST_PIPE_FD_PEER], pu8Buf, u32Size, 0);
+    } while ((tLen < 0) && (errno == EINTR));
+
+    return (int)tLen;
+}
+
+// the peer: one packet to the netif
+int LwipHost_PipePeerSend(const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    ssize_t tLen = -1;
+
+    if (u32Len > LWIP_HOST_PIPE_MTU)
+        return -1;
+
+    do
+    {
+        tLen = send(g_s32aLwipHostPipeFd[LWIP_HOST_PIPE_FD_PEER], pu8Buf, u32Len, 0);
+    } while ((tLen < 0) && (errno == EINTR));
+
+    return (tLen == (ssize_t)u32Len) ? 0 : -1;
+}
+
+void LwipHost_PipeStatGet(T_LwipHostPipeStat *ptStat)
+{
+    LOCK_TCPIP_CORE();
+    memcpy(ptStat, &g_tLwipHostPipeStat, sizeof(*ptStat));
+    UNLOCK_TCPIP_CORE();
+}
@@ -0,0 +1,112 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+#ifndef __LWIP_HOST_PORT_H__
+#define __LWIP_HOST_PORT_H__
+
+#include <stdint.h>
+
+/*
+ * The heap of the target behind MEM_LIBC_MALLOC (mem_clib_* of arch/cc.h):
+ * first fit over an arena with the free blocks in address
+ * order and merged with their neighbours, as heap_4 of FreeRTOS, with the
+ * 8-byte block header of the 32-bit target. A test can run an instance of
+ * its own on another arena, e.g. to replay the requests of another build.
+ *
+ * Both ends of a loopback connection are on this heap, where the device
+ * holds one of them: the arena is twice the heap of the target, and
+ * xPortGetFreeHeapSize() still tells what is left of configTOTAL_HEAP_SIZE.
+ */
+#define LWIP_HOST_HEAP_SIZE         (2 * configTOTAL_HEAP_SIZE)
+#define LWIP_HOST_HEAP_ALIGN        (8)
+#define LWIP_HOST_HEAP_HDR          (8)
+
+typedef struct
+{
+    uint32_t u32Allocs;
+    uint32_t u32Frees;
+    uint32_t u32Fails;
+    uint32_t u32Free;                           // bytes in free blocks, headers included
+    uint32_t u32Largest;                        // largest free block
+    // since LwipHost_HeapStatReset()
+    uint32_t u32FreeMin;
+    uint32_t u32LargestMin;
+    uint32_t u32FragMaxPct;                     // peak of free bytes outside the largest block, % of the heap
+} T_LwipHostHeapStat;
+
+typedef struct
+{
+    uint8_t *pu8Arena;                          // LWIP_HOST_HEAP_ALIGN aligned
+    uint32_t u32Size;
+    uint32_t u32FreeHead;                       // offset of the first free block, u32Size for none
+    T_LwipHostHeapStat tStat;
+} T_LwipHostHeap;
+
+/*
+ * The emulated link: every packet of the loopback netif is lost with
+ * u32LossPermille / 1000 and the rest are handed to the netif u32DelayMs
+ * later, in order. LwipHost_LinkSet(0, 0) is the plain loopback again.
+ */
+#define LWIP_HOST_LINK_QUEUE_MAX    (256)       // packets in flight, more are dropped
+
+typedef struct
+{
+    uint32_t u32DelayMs;
+    uint32_t u32LossPermille;
+    uint32_t u32Sent;                           // packets given to the link
+    uint32_t u32Lost;
+    uint32_t u32Overflow;                       // dropped, LWIP_HOST_LINK_QUEUE_MAX in flight
+    uint32_t u32Delivered;
+    uint32_t u32Refused;                        // the loopback queue of the netif was full
+    uint32_t u32InFlightMax;
+} T_LwipHostLinkStat;
+
+/*
+ * The pipe netif: IPv4 without a link layer, every packet it sends is one
+ * datagram to the far end of a socket pair and every datagram written
+ * there comes in. The test is the peer at the far end, with
+ * LwipHost_PipePeerRecv() / LwipHost_PipePeerSend().
+ */
+#define LWIP_HOST_PIPE_ADDR         "10.9.0.1"
+#define LWIP_HOST_PIPE_PEER         "10.9.0.2"
+#define LWIP_HOST_PIPE_MASK         "255.255.255.0"
+#define LWIP_HOST_PIPE_MTU          (1500)
+
+typedef struct
+{
+    uint32_t u32TxPkts;                         // to the peer
+    uint32_t u32TxBytes;
+    uint32_t u32TxErr;
+    uint32_t u32RxPkts;                         // from the peer, given to tcpip
+    uint32_t u32RxBytes;
+    uint32_t u32RxDrop;                         // no pbuf or tcpip mailbox full
+} T_LwipHostPipeStat;
+
+// load the lwIP function tables, start tcpip and the loopback netif
+int LwipHost_Init(void);
+
+void LwipHost_HeapInit(T_LwipHostHeap *ptHeap, uint8_t *pu8Arena, uint32_t u32Size);
+void *LwipHost_HeapAlloc(T_LwipHostHeap *ptHeap, uint32_t u32Size);
+void LwipHost_HeapFree(T_LwipHostHeap *ptHeap, void *pMem);
+void LwipHost_HeapStatGet(T_LwipHostHeap *ptHeap, T_LwipHostHeapStat *ptStat);
+void LwipHost_HeapStatReset(T_LwipHostHeap *ptHeap);
+// the instance under mem_clib_malloc()
+T_LwipHostHeap *LwipHost_Heap(void);
+
+int LwipHost_LinkSet(uint32_t u32DelayMs, uint32_t u32LossPermille);
+void LwipHost_LinkStatGet(T_LwipHostLinkStat *ptStat);
+
+int LwipHost_PipeInit(void);
+int LwipHost_PipePeerRecv(uint8_t *pu8Buf, uint32_t u32Size);
+int LwipHost_PipePeerSend(const uint8_t *pu8Buf, uint32_t u32Len);
+void LwipHost_PipeStatGet(T_LwipHostPipeStat *ptStat);
+
+#endif /* __LWIP_HOST_PORT_H__ */
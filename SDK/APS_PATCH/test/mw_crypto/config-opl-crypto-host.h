@@ -0,0 +1,41 @@
+/*
+ *  Host configuration of the crypto self-test, every optional case
+ *
+ *  The algorithms of config-opl-mini.h with the ones mw_crypto_test.c runs
+ *  when a config has them: AES-CTR and ECDH P-256 of config-opl-homekit.h,
+ *  AES-CCM and AES-GCM with MBEDTLS_SCRT_AEAD of config-opl-basic.h. The
+ *  FreeRTOS heap and threading of the target are left out, and so is TLS.
+ */
+
+#ifndef MBEDTLS_CONFIG_H
+#define MBEDTLS_CONFIG_H
+
+/* System support */
+#define MBEDTLS_HAVE_ASM
+
+/* mbed TLS feature support */
+#define MBEDTLS_CIPHER_MODE_CBC
+#define MBEDTLS_CIPHER_MODE_CTR
+#define MBEDTLS_ECP_DP_SECP256R1_ENABLED
+#define MBEDTLS_ECP_NIST_OPTIM
+
+/* mbed TLS modules */
+#define MBEDTLS_PLATFORM_C
+#define MBEDTLS_AES_C
+#define MBEDTLS_BIGNUM_C
+#define MBEDTLS_CCM_C
+#define MBEDTLS_CIPHER_C
+#define MBEDTLS_CTR_DRBG_C
+#define MBEDTLS_ECDH_C
+#define MBEDTLS_ECP_C
+#define MBEDTLS_GCM_C
+#define MBEDTLS_MD_C
+#define MBEDTLS_SHA1_C
+#define MBEDTLS_SHA256_C
+
+/* OPL1000 */
+#define MBEDTLS_SCRT_AEAD
+
+#include "mbedtls/check_config.h"
+
+#endif /* MBEDTLS_CONFIG_H */
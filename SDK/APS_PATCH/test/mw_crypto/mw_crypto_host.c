@@ -0,0 +1,569 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  mw_crypto_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The crypto self-test and benchmark of mw_crypto_test.c with software
+*  providers: every KAT passes, every benchmark runs, and the filter, the
+*  engine not ready, a failure of the engine and the diag command in a task
+*  of its own give what the firmware prints.
+*
+*  The engine: AES-ECB and AES-CCM are the model of mbedtls/tests/
+*  scrt_model.c, HMAC-SHA1 is mbedtls and ECDH P-256 is tinycrypt, behind
+*  the ROM function pointers with the checks of the driver. The OTP is
+*  ready unless a case says otherwise.
+*
+*  The lines of the test are read back from tracer_cli: a row of each case
+*  (the algorithm, the provider, the KAT, the operations, us per operation,
+*  KB/s and the stack) and the summary.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmsis_os.h"
+#include "msg.h"
+#include "scrt.h"
+
+#include "tinycrypt/constants.h"
+#include "tinycrypt/ecc.h"
+#include "tinycrypt/ecc_dh.h"
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+#include "mbedtls/md.h"
+
+#include "mw_crypto_test.h"
+#include "scrt_model.h"
+#include "host_os.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define CRYPTO_HOST_ROW_MAX         (64)
+#define CRYPTO_HOST_LINE_MAX        (160)
+#define CRYPTO_HOST_BENCH_MS        (20)
+#define CRYPTO_HOST_WAIT_US         (20000000)
+
+#define CRYPTO_HOST_ECC_LEN         (32)
+#define CRYPTO_HOST_HMAC_KEY_MAX    (64)        // the key length of the mailbox, a block of SHA-1
+
+// the cases of every config, then the ones of a config of mbedtls
+#define CRYPTO_HOST_CASE_BASE       (23)
+#define CRYPTO_HOST_SCRT_CASES      (5)         // aes-ecb, aes-ccm, hmac-sha1, ecdh-p256, pbkdf2-sha1
+#define CRYPTO_HOST_TC_CASES        (9)
+#define CRYPTO_HOST_AES_BASE        (8)
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+#define CRYPTO_HOST_CTR             (1)
+#else
+#define CRYPTO_HOST_CTR             (0)
+#endif
+
+#if defined(MBEDTLS_CCM_C)
+#define CRYPTO_HOST_CCM             (1)
+#else
+#define CRYPTO_HOST_CCM             (0)
+#endif
+
+#if defined(MBEDTLS_GCM_C)
+#define CRYPTO_HOST_GCM             (1)
+#else
+#define CRYPTO_HOST_GCM             (0)
+#endif
+
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+#define CRYPTO_HOST_ECDH            (1)
+#else
+#define CRYPTO_HOST_ECDH            (0)
+#endif
+
+#define CRYPTO_HOST_CASES           (CRYPTO_HOST_CASE_BASE + CRYPTO_HOST_CTR + CRYPTO_HOST_CCM + \
+                                     CRYPTO_HOST_GCM + CRYPTO_HOST_ECDH)
+#define CRYPTO_HOST_AES_CASES       (CRYPTO_HOST_AES_BASE + CRYPTO_HOST_CTR + CRYPTO_HOST_CCM + CRYPTO_HOST_GCM)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+// a row of the table of mw_crypto_test.c
+typedef struct
+{
+    char baAlgo[16];
+    char baProv[12];
+    char baKat[6];
+    uint32_t u32Ops;
+    uint32_t u32UsPerOp;
+    uint32_t u32KBps;
+    uint32_t u32Stack;
+} T_CryptoHostRow;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_CryptoHostRow g_taCryptoHostRow[CRYPTO_HOST_ROW_MAX];
+static uint32_t g_u32CryptoHostRowNum;
+static T_MwCryptoTestSum g_tCryptoHostSum;          // of the last summary line
+static volatile uint32_t g_u32CryptoHostDone;       // summary lines
+static uint32_t g_u32CryptoHostUsage;
+static int g_iCryptoHostCmdErr;
+
+// the engine
+static uint8_t g_u8CryptoHostOtp;
+static uint32_t g_u32CryptoHostHmac;
+static uint32_t g_u32CryptoHostEcdh;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+/*
+ * The engine
+ */
+static void _CryptoHost_Reverse(uint8_t *pu8Dst, const uint8_t *pu8Src, uint32_t u32Len)
+{
+    uint32_t i;
+
+    for (i = 0; i < u32Len; i++)
+        pu8Dst[i] = pu8Src[u32Len - 1 - i];
+}
+
+// the checks of nl_hmac_sha_1_impl, the key goes to the mailbox
+static int _CryptoHost_HmacSha1(uint8_t *sk, int sk_len, uint8_t *in_data, int data_len, uint8_t *mac)
+{
+    g_u32CryptoHostHmac++;
+
+    if ((!sk) || (sk_len <= 0) || (sk_len > CRYPTO_HOST_HMAC_KEY_MAX) ||
+        (!in_data) || (data_len <= 0) || (!mac))
+        return 0;
+
+    if (mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA1), sk, sk_len, in_data, data_len, mac))
+        return 0;
+
+    return 1;
+}
+
+static int _CryptoHost_OtpStatusGet(void)
+{
+    return g_u8CryptoHostOtp;
+}
+
+// the point and the private key little endian, the DHKey big endian as
+// mw_crypto_test.c reads it; no key of the engine is kept, u32PrivKeyId fails
+static int _CryptoHost_EcdhDhkeyGen(uint8_t *u8aPubKeyX, uint8_t *u8aPubKeyY, uint32_t *u32aPrivKey, void *pDhKey, uint32_t u32PrivKeyId)
+{
+    EccPoint tPub;
+    uint32_t u32aPriv[NUM_ECC_DIGITS];
+    uint32_t u32aSecret[NUM_ECC_DIGITS];
+    uint8_t u8aBe[CRYPTO_HOST_ECC_LEN];
+
+    g_u32CryptoHostEcdh++;
+
+    if (!g_u8CryptoHostOtp)
+        return 0;
+
+    if ((!u8aPubKeyX) || (!u8aPubKeyY) || (!u32aPrivKey) || (!pDhKey) || (u32PrivKeyId))
+        return 0;
+
+    _CryptoHost_Reverse(u8aBe, u8aPubKeyX, CRYPTO_HOST_ECC_LEN);
+    ecc_bytes2native(tPub.x, u8aBe);
+    _CryptoHost_Reverse(u8aBe, u8aPubKeyY, CRYPTO_HOST_ECC_LEN);
+    ecc_bytes2native(tPub.y, u8aBe);
+    _CryptoHost_Reverse(u8aBe, (uint8_t *)u32aPrivKey, CRYPTO_HOST_ECC_LEN);
+    ecc_bytes2native(u32aPriv, u8aBe);
+
+    if (ecc_valid_public_key(&tPub) != 0)
+        return 0;
+    if (ecdh_shared_secret(u32aSecret, &tPub, u32aPriv) != TC_CRYPTO_SUCCESS)
+        return 0;
+
+    ecc_native2bytes((uint8_t *)pDhKey, u32aSecret);
+    return 1;
+}
+
+nl_hmac_sha_1_fp_t nl_hmac_sha_1 = _CryptoHost_HmacSha1;
+nl_scrt_common_fp_t nl_scrt_otp_status_get = _CryptoHost_OtpStatusGet;
+nl_scrt_ecdh_dhkey_gen_fp_t nl_scrt_ecdh_dhkey_gen = _CryptoHost_EcdhDhkeyGen;
+
+/*
+ * The lines of the test
+ */
+static void _CryptoHost_Parse(const char *sLine)
+{
+    T_CryptoHostRow tRow;
+    T_MwCryptoTestSum tSum;
+    int iErr = 0;
+
+    if (sscanf(sLine, "crypto: %u cases, %u pass, %u fail, %u n/a",
+               &tSum.ulCase, &tSum.ulPass, &tSum.ulFail, &tSum.ulNa) == 4)
+    {
+        g_tCryptoHostSum = tSum;
+        __sync_fetch_and_add(&g_u32CryptoHostDone, 1);
+        return;
+    }
+
+    if (sscanf(sLine, "crypto: fail %d", &iErr) == 1)
+    {
+        g_iCryptoHostCmdErr = iErr;
+        return;
+    }
+
+    if (!strncmp(sLine, "usage: crypto", 13))
+    {
+        g_u32CryptoHostUsage++;
+        return;
+    }
+
+    // the header has no numbers
+    memset(&tRow, 0, sizeof(tRow));
+    if (sscanf(sLine, "%15s %11s %5s %u %u %u %u", tRow.baAlgo, tRow.baProv, tRow.baKat,
+               &tRow.u32Ops, &tRow.u32UsPerOp, &tRow.u32KBps, &tRow.u32Stack) != 7)
+        return;
+
+    if (g_u32CryptoHostRowNum < CRYPTO_HOST_ROW_MAX)
+        g_taCryptoHostRow[g_u32CryptoHostRowNum++] = tRow;
+}
+
+static int _CryptoHost_Printf(const char *sFmt, ...)
+{
+    char baLine[CRYPTO_HOST_LINE_MAX];
+    va_list tList;
+    int iRet = 0;
+
+    va_start(tList, sFmt);
+    iRet = vsnprintf(baLine, sizeof(baLine), sFmt, tList);
+    va_end(tList);
+
+    fputs(baLine, stdout);
+    _CryptoHost_Parse(baLine);
+
+    return iRet;
+}
+
+static void _CryptoHost_Reset(void)
+{
+    memset(g_taCryptoHostRow, 0, sizeof(g_taCryptoHostRow));
+    memset(&g_tCryptoHostSum, 0, sizeof(g_tCryptoHostSum));
+    g_u32CryptoHostRowNum = 0;
+    g_u32CryptoHostDone = 0;
+    g_u32CryptoHostUsage = 0;
+    g_iCryptoHostCmdErr = MW_CRYPTO_TEST_OK;
+
+    g_u8CryptoHostOtp = 1;
+    g_u32CryptoHostHmac = 0;
+    g_u32CryptoHostEcdh = 0;
+    scrt_model_reset();
+}
+
+static T_CryptoHostRow *_CryptoHost_Row(const char *sAlgo, const char *sProv)
+{
+    uint32_t i;
+
+    for (i = 0; i < g_u32CryptoHostRowNum; i++)
+    {
+        if ((!strcmp(g_taCryptoHostRow[i].baAlgo, sAlgo)) && (!strcmp(g_taCryptoHostRow[i].baProv, sProv)))
+            return &g_taCryptoHostRow[i];
+    }
+
+    return NULL;
+}
+
+// the rows of a throughput case have KB/s, ECDH and PBKDF2 only the latency
+static uint8_t _CryptoHost_Latency(const T_CryptoHostRow *ptRow)
+{
+    return (!strncmp(ptRow->baAlgo, "ecdh", 4)) || (!strncmp(ptRow->baAlgo, "pbkdf2", 6));
+}
+
+// the task of MwCryptoTest_Start prints its summary, then gives the test back
+static uint8_t _CryptoHost_WaitTask(void)
+{
+    uint32_t u32Us = 0;
+
+    while (__sync_add_and_fetch(&g_u32CryptoHostDone, 0) == 0)
+    {
+        if (u32Us >= CRYPTO_HOST_WAIT_US)
+            return 0;
+
+        HostOs_SleepUs(1000);
+        u32Us += 1000;
+    }
+
+    // no case has "rsa"
+    while (MwCryptoTest_Run(MW_CRYPTO_TEST_MODE_KAT, "rsa", 0, NULL) == MW_CRYPTO_TEST_ERR_BUSY)
+    {
+        if (u32Us >= CRYPTO_HOST_WAIT_US)
+            return 0;
+
+        HostOs_SleepUs(1000);
+        u32Us += 1000;
+    }
+
+    return 1;
+}
+
+/*
+ * The cases
+ */
+// every KAT of every provider, nothing on the engine fails
+static void _CryptoHost_Kat(void)
+{
+    T_MwCryptoTestSum tSum;
+    scrt_model_stats tStats;
+    uint32_t i;
+
+    _CryptoHost_Reset();
+
+    HOST_TEST_EQ(MwCryptoTest_Run(MW_CRYPTO_TEST_MODE_KAT, NULL, 0, &tSum), MW_CRYPTO_TEST_OK);
+    HOST_TEST_EQ(tSum.ulCase, CRYPTO_HOST_CASES);
+    HOST_TEST_EQ(tSum.ulPass, CRYPTO_HOST_CASES);
+    HOST_TEST_EQ(tSum.ulFail, 0);
+    HOST_TEST_EQ(tSum.ulNa, 0);
+
+    HOST_TEST_EQ(g_u32CryptoHostDone, 1);
+    HOST_TEST_EQ(g_tCryptoHostSum.ulPass, CRYPTO_HOST_CASES);
+    HOST_TEST_EQ(g_u32CryptoHostRowNum, CRYPTO_HOST_CASES);
+
+    for (i = 0; i < g_u32CryptoHostRowNum; i++)
+    {
+        HOST_TEST_ASSERT(!strcmp(g_taCryptoHostRow[i].baKat, "pass"));
+        HOST_TEST_EQ(g_taCryptoHostRow[i].u32Ops, 0);
+        HOST_TEST_EQ(g_taCryptoHostRow[i].u32Stack, 0);
+    }
+
+    // the engine did the scrt cases
+    scrt_model_stats_get(&tStats);
+    HOST_TEST_ASSERT(tStats.ecb > 0);
+    HOST_TEST_ASSERT(tStats.ccm > 0);
+    HOST_TEST_EQ(tStats.fail, 0);
+    HOST_TEST_EQ(tStats.misuse, 0);
+    HOST_TEST_ASSERT(g_u32CryptoHostHmac > 0);
+    HOST_TEST_EQ(g_u32CryptoHostEcdh, 1);
+}
+
+// the KATs and a short benchmark of each case
+static void _CryptoHost_Bench(void)
+{
+    T_MwCryptoTestSum tSum;
+    scrt_model_stats tStats;
+    T_CryptoHostRow *ptRow = NULL;
+    uint32_t i;
+
+    _CryptoHost_Reset();
+
+    HOST_TEST_EQ(MwCryptoTest_Run(MW_CRYPTO_TEST_MODE_ALL, NULL, CRYPTO_HOST_BENCH_MS, &tSum), MW_CRYPTO_TEST_OK);
+    HOST_TEST_EQ(tSum.ulCase, CRYPTO_HOST_CASES);
+    HOST_TEST_EQ(tSum.ulPass, CRYPTO_HOST_CASES);
+    HOST_TEST_EQ(g_u32CryptoHostRowNum, CRYPTO_HOST_CASES);
+
+    for (i = 0; i < g_u32CryptoHostRowNum; i++)
+    {
+        ptRow = &g_taCryptoHostRow[i];
+
+        HOST_TEST_ASSERT(!strcmp(ptRow->baKat, "pass"));
+        HOST_TEST_ASSERT(ptRow->u32Ops > 0);
+
+        if (_CryptoHost_Latency(ptRow))
+            HOST_TEST_EQ(ptRow->u32KBps, 0);
+        else
+            HOST_TEST_ASSERT(ptRow->u32KBps > 0);
+    }
+
+    // the operations of the engine are as clean as its KATs
+    scrt_model_stats_get(&tStats);
+    HOST_TEST_ASSERT(tStats.ecb > _CryptoHost_Row("aes-ecb", "scrt")->u32Ops);
+    HOST_TEST_ASSERT(tStats.ccm > _CryptoHost_Row("aes-ccm", "scrt")->u32Ops);
+    HOST_TEST_EQ(tStats.fail, 0);
+    HOST_TEST_EQ(tStats.misuse, 0);
+    HOST_TEST_ASSERT(g_u32CryptoHostEcdh > _CryptoHost_Row("ecdh-p256", "scrt")->u32Ops);
+}
+
+// a part of the name of the algorithm or the provider, and the bad calls
+static void _CryptoHost_Filter(void)
+{
+    T_MwCryptoTestSum tSum;
+    uint32_t i;
+
+    _CryptoHost_Reset();
+
+    HOST_TEST_EQ(MwCryptoTest_Run(MW_CRYPTO_TEST_MODE_KAT, "scrt", 0, &tSum), MW_CRYPTO_TEST_OK);
+    HOST_TEST_EQ(tSum.ulCase, CRYPTO_HOST_SCRT_CASES);
+    HOST_TEST_EQ(tSum.ulPass, CRYPTO_HOST_SCRT_CASES);
+
+    for (i = 0; i < g_u32CryptoHostRowNum; i++)
+        HOST_TEST_ASSERT(!strcmp(g_taCryptoHostRow[i].baProv, "scrt"));
+
+    HOST_TEST_EQ(MwCryptoTest_Run(MW_CRYPTO_TEST_MODE_KAT, "tinycrypt", 0, &tSum), MW_CRYPTO_TEST_OK);
+    HOST_TEST_EQ(tSum.ulCase, CRYPTO_HOST_TC_CASES);
+
+    HOST_TEST_EQ(MwCryptoTest_Run(MW_CRYPTO_TEST_MODE_KAT, "aes-", 0, &tSum), MW_CRYPTO_TEST_OK);
+    HOST_TEST_EQ(tSum.ulCase, CRYPTO_HOST_AES_CASES);
+
+    HOST_TEST_EQ(MwCryptoTest_Run(MW_CRYPTO_TEST_MODE_KAT, "", 0, &tSum), MW_CRYPTO_TEST_OK);
+    HOST_TEST_EQ(tSum.ulCase, CRYPTO_HOST_CASES);
+
+    HOST_TEST_EQ(MwCryptoTest_Run(MW_CRYPTO_TEST_MODE_KAT, "rsa", 0, &tSum), MW_CRYPTO_TEST_ERR_NOENT);
+    HOST_TEST_EQ(tSum.ulCase, 0);
+
+    // no mode, the stack only, a filter too long for the task
+    HOST_TEST_EQ(MwCryptoTest_Run(0, NULL, 0, NULL), MW_CRYPTO_TEST_ERR_INVAL);
+    HOST_TEST_EQ(MwCryptoTest_Run(MW_CRYPTO_TEST_MODE_STACK, NULL, 0, NULL), MW_CRYPTO_TEST_ERR_INVAL);
+    HOST_TEST_EQ(MwCryptoTest_Start(0, NULL, 0), MW_CRYPTO_TEST_ERR_INVAL);
+    HOST_TEST_EQ(MwCryptoTest_Start(MW_CRYPTO_TEST_MODE_KAT, "0123456789abcdef", 0), MW_CRYPTO_TEST_ERR_INVAL);
+}
+
+// the OTP is not ready: the ECDH of the engine is n/a, not a failure, and
+// it is not benchmarked
+static void _CryptoHost_OtpNotReady(void)
+{
+    T_MwCryptoTestSum tSum;
+    T_CryptoHostRow *ptRow = NULL;
+
+    _CryptoHost_Reset();
+    g_u8CryptoHostOtp = 0;
+
+    HOST_TEST_EQ(MwCryptoTest_Run(MW_CRYPTO_TEST_MODE_ALL, "ecdh", CRYPTO_HOST_BENCH_MS, &tSum), MW_CRYPTO_TEST_OK);
+    HOST_TEST_EQ(tSum.ulCase, 2 + CRYPTO_HOST_ECDH);
+    HOST_TEST_EQ(tSum.ulNa, 1);
+    HOST_TEST_EQ(tSum.ulFail, 0);
+    HOST_TEST_EQ(tSum.ulPass, 1 + CRYPTO_HOST_ECDH);
+
+    ptRow = _CryptoHost_Row("ecdh-p256", "scrt");
+    HOST_TEST_ASSERT(ptRow != NULL);
+    HOST_TEST_ASSERT(!strcmp(ptRow->baKat, "n/a"));
+    HOST_TEST_EQ(ptRow->u32Ops, 0);
+    HOST_TEST_EQ(g_u32CryptoHostEcdh, 0);
+
+    ptRow = _CryptoHost_Row("ecdh-p256", "tinycrypt");
+    HOST_TEST_ASSERT(ptRow != NULL);
+    HOST_TEST_ASSERT(ptRow->u32Ops > 0);
+}
+
+// the engine fails the KAT: the case fails and is not benchmarked, the
+// others of the algorithm go on
+static void _CryptoHost_EngineFail(void)
+{
+    T_MwCryptoTestSum tSum;
+    scrt_model_stats tStats;
+    T_CryptoHostRow *ptRow = NULL;
+
+    _CryptoHost_Reset();
+    scrt_model_fail_at(1);
+
+    HOST_TEST_EQ(MwCryptoTest_Run(MW_CRYPTO_TEST_MODE_ALL, "aes-ecb", CRYPTO_HOST_BENCH_MS, &tSum), MW_CRYPTO_TEST_ERR_FAIL);
+    HOST_TEST_EQ(tSum.ulCase, 3);
+    HOST_TEST_EQ(tSum.ulFail, 1);
+    HOST_TEST_EQ(tSum.ulPass, 2);
+
+    ptRow = _CryptoHost_Row("aes-ecb", "scrt");
+    HOST_TEST_ASSERT(ptRow != NULL);
+    HOST_TEST_ASSERT(!strcmp(ptRow->baKat, "FAIL"));
+    HOST_TEST_EQ(ptRow->u32Ops, 0);
+
+    scrt_model_stats_get(&tStats);
+    HOST_TEST_EQ(tStats.ecb, 1);
+    HOST_TEST_EQ(tStats.fail, 1);
+
+    ptRow = _CryptoHost_Row("aes-ecb", "mbedtls");
+    HOST_TEST_ASSERT(ptRow != NULL);
+    HOST_TEST_ASSERT(ptRow->u32Ops > 0);
+}
+
+// the diag command: the run in a task of its own with the stack measured,
+// busy while it runs, and the bad commands
+static void _CryptoHost_Cmd(void)
+{
+    char baCmd[] = "crypto all aes- 10";
+    char baUsage[] = "crypto go";
+    char baLong[] = "crypto kat 0123456789abcdef";
+    T_CryptoHostRow *ptRow = NULL;
+    uint32_t i;
+
+    _CryptoHost_Reset();
+
+    MwCryptoTest_Cmd(baCmd);
+
+    // the lock is taken before the task starts
+    HOST_TEST_EQ(MwCryptoTest_Run(MW_CRYPTO_TEST_MODE_KAT, NULL, 0, NULL), MW_CRYPTO_TEST_ERR_BUSY);
+    HOST_TEST_EQ(MwCryptoTest_Start(MW_CRYPTO_TEST_MODE_KAT, NULL, 0), MW_CRYPTO_TEST_ERR_BUSY);
+
+    HOST_TEST_ASSERT(_CryptoHost_WaitTask());
+    HOST_TEST_EQ(g_iCryptoHostCmdErr, MW_CRYPTO_TEST_OK);
+
+    // the rows of the command, none of the run of the wait
+    HOST_TEST_EQ(g_u32CryptoHostRowNum, CRYPTO_HOST_AES_CASES);
+
+    for (i = 0; i < g_u32CryptoHostRowNum; i++)
+    {
+        ptRow = &g_taCryptoHostRow[i];
+
+        HOST_TEST_ASSERT(!strcmp(ptRow->baKat, "pass"));
+        HOST_TEST_ASSERT(ptRow->u32Ops > 0);
+        HOST_TEST_ASSERT(ptRow->u32Stack > 0);
+        HOST_TEST_ASSERT(ptRow->u32Stack <= (MW_CRYPTO_TEST_STACK_PAINT + 32) * 4);
+    }
+
+    _CryptoHost_Reset();
+
+    MwCryptoTest_Cmd(baUsage);
+    HOST_TEST_EQ(g_u32CryptoHostUsage, 1);
+
+    MwCryptoTest_Cmd(baLong);
+    HOST_TEST_EQ(g_iCryptoHostCmdErr, MW_CRYPTO_TEST_ERR_INVAL);
+    HOST_TEST_EQ(g_u32CryptoHostDone, 0);
+}
+
+static const T_HostTestCase g_taCryptoHostCase[] =
+{
+    HOST_TEST_CASE(_CryptoHost_Kat),
+    HOST_TEST_CASE(_CryptoHost_Bench),
+    HOST_TEST_CASE(_CryptoHost_Filter),
+    HOST_TEST_CASE(_CryptoHost_OtpNotReady),
+    HOST_TEST_CASE(_CryptoHost_EngineFail),
+    HOST_TEST_CASE(_CryptoHost_Cmd),
+};
+
+int main(void)
+{
+    HostOs_Init();
+
+    tracer_drct_printf = _CryptoHost_Printf;
+
+    return HostTest_Run("mw_crypto", g_taCryptoHostCase, HOST_TEST_NUM(g_taCryptoHostCase));
+}
@@ -0,0 +1,1328 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  mw_fs_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The file system of mw_fs.c over a RAM flash, with the power lost at random
+*  and in every program and erase of a fixed sequence, and a bench of the
+*  time and the wear of the usual writes.
+*
+*  The flash is a NOR model in shared memory under the ROM flash functions,
+*  as in the test of the flash log: a program only clears bits, an erase sets
+*  the block to 0xFF, and a program that would set a bit back is counted as
+*  a fault. Every boot is a child process, so the RAM and the statics of the
+*  file system start over while the flash stays. A power cut stops the child
+*  after some bytes of one program or erase.
+*
+*  A boot mounts, checks every file against what the boots before it
+*  committed, then runs random writes, appends, removes and renames. The
+*  bytes of a write are a generation and a hash of the offset, and every
+*  append has its own generation, so a read tells which version a file is
+*  and a lost append differs from the one after it. The file of the op that
+*  the power cut may be at its old state, at the state of a sync in the
+*  middle of the op or at the new one; every other file is exactly as
+*  committed, no block is leaked and the next ops work.
+*
+*  The flash takes the time of a typical 25-series SPI NOR in the simulated
+*  clock (4KB erase 45 ms, 256 B page program 0.7 ms, single SPI read at
+*  20 MHz), so "fs bench" and the bench of the test give the throughput of
+*  the flash, the erases and the bytes programmed of each kind of write.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "cmsis_os.h"
+#include "msg.h"
+#include "hal_system.h"
+#include "hal_flash.h"
+#include "mw_flash_svc.h"
+#include "mw_fs.h"
+#include "host_os.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define FS_HOST_FLASH_SIZE          (MW_FS_BLOCK_NUM * MW_FS_BLOCK_SIZE)
+#define FS_HOST_BLOCK_NUM           16          // the partition of the power loss, small to wrap often
+#define FS_HOST_DATA_SIZE           (MW_FS_BLOCK_SIZE - 8)  // after the head of a data block
+#define FS_HOST_OP_MAX              4096
+#define FS_HOST_ANY                 (0xFFFFFFFF)
+
+// the files of the power loss, 2 blocks at most each
+#define FS_HOST_FILE_NUM            4
+#define FS_HOST_ALLOW_MAX           4
+#define FS_HOST_LEN_MAX             6000
+#define FS_HOST_APPEND_MAX          1500
+#define FS_HOST_APPEND_BELOW        5000        // a larger file is written again
+#define FS_HOST_SEG_MAX             8           // appends of a file before it is written again
+#define FS_HOST_CHUNK_MAX           700
+
+#define FS_HOST_ROUND_NUM           300
+#define FS_HOST_ROUND_OPS           8
+#define FS_HOST_ROUND_CUT           300         // the cut is in the first flash ops of a round
+#define FS_HOST_SWEEP_OPS           6
+#define FS_HOST_AFTER_OPS           2
+
+// where a file is: its two names
+#define FS_HOST_NONE                0
+#define FS_HOST_MAIN                1
+#define FS_HOST_ALT                 2
+
+// the flash in the simulated time
+#define FS_HOST_ERASE_US            45000
+#define FS_HOST_PAGE_SIZE           256
+#define FS_HOST_PAGE_US             700
+#define FS_HOST_READ_NS             400         // a byte
+
+#define FS_HOST_BENCH_OPS           100
+#define FS_HOST_BENCH_LEN           64
+#define FS_HOST_CFG_OPS             200
+#define FS_HOST_CFG_LEN             100
+
+// the exit code of a boot
+#define FS_HOST_EXIT_OK             (0)
+#define FS_HOST_EXIT_FAIL           (1)
+#define FS_HOST_EXIT_CUT            (2)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+// a file: where it is, and its content, a generation from the end of the
+// segment before to u32aEnd; every write or append is a new segment
+typedef struct
+{
+    uint8_t u8Where;                // FS_HOST_NONE / MAIN / ALT
+    uint8_t u8SegNum;
+    uint32_t u32Size;
+    uint32_t u32aGen[FS_HOST_SEG_MAX];
+    uint32_t u32aEnd[FS_HOST_SEG_MAX];
+} T_FsHostState;
+
+// in shared memory: what a boot leaves to the next one and to the test
+typedef struct
+{
+    uint8_t u8aMem[FS_HOST_FLASH_SIZE];
+
+    // the power cut: the op counted from 1, 0: none, and the bytes done in it
+    uint32_t u32CutOp;
+    uint32_t u32CutBytes;
+
+    // the programs and erases of the last boot
+    uint32_t u32Op;
+    uint32_t u32aOpSize[FS_HOST_OP_MAX];
+    uint8_t u8aOpErase[FS_HOST_OP_MAX];
+    uint32_t u32Erase;
+    uint32_t u32Program;            // bytes
+    uint32_t u32aErase[MW_FS_BLOCK_NUM];
+    uint32_t u32Overwrite;          // a bit programmed from 0 to 1
+
+    // the plan of a boot
+    uint32_t u32BlockNum;           // of the partition
+    uint32_t u32Seed;
+    uint32_t u32OpNum;              // random ops after the check
+    uint32_t u32OpDone;
+
+    // the files as committed, and the one of the op in flight
+    T_FsHostState taFile[FS_HOST_FILE_NUM];
+    uint32_t u32Inflight;           // FS_HOST_ANY: none
+    uint32_t u32AllowNum;
+    T_FsHostState taAllow[FS_HOST_ALLOW_MAX];
+} T_FsHostFlash;
+
+typedef void (*T_FsHostBootFp)(void);
+
+// a kind of write of the bench, 1: done
+typedef uint8_t (*T_FsHostBenchFp)(uint32_t u32Op);
+
+typedef struct
+{
+    const char *sName;
+    T_FsHostBenchFp fpOp;
+    uint32_t u32OpNum;
+    uint32_t u32Len;                // bytes of an op
+} T_FsHostBench;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_FsHostFlash *g_ptFsHostFlash;
+
+static const char *g_saFsHostPath[FS_HOST_FILE_NUM][3] =
+{
+    { NULL, "/a/f0", "/b/r0" },
+    { NULL, "/a/f1", "/r1" },
+    { NULL, "/b/f2", "/a/r2" },
+    { NULL, "/f3", "/b/r3" },
+};
+
+static uint32_t g_u32FsHostReadNs;
+
+// the lines of the diag command
+static uint32_t g_u32FsHostGood;        // "check PASS", "data ok"
+static uint32_t g_u32FsHostBad;         // "FAIL", "BAD DATA", "bad at", "stopped"
+
+static uint32_t g_u32FsHostAhead = FS_HOST_ANY;     // queued to the erase service
+
+static int g_iFsHostSyncFd = -1;                    // the file of the bench kept open
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+/*
+ * The flash
+ */
+static void _FsHost_PowerOff(void)
+{
+    fflush(stdout);
+    _exit(FS_HOST_EXIT_CUT);
+}
+
+static uint8_t *_FsHost_FlashAt(uint32_t u32Addr, uint32_t u32Size)
+{
+    if ((u32Addr < MW_FS_ADDR) || ((u32Addr + u32Size) > (MW_FS_ADDR + FS_HOST_FLASH_SIZE)))
+        return NULL;
+
+    return &g_ptFsHostFlash->u8aMem[u32Addr - MW_FS_ADDR];
+}
+
+// the next program or erase, 1: the power is cut in it after *pu32Done bytes
+static uint8_t _FsHost_OpStart(uint32_t u32Size, uint8_t u8Erase, uint32_t *pu32Done)
+{
+    T_FsHostFlash *ptFlash = g_ptFsHostFlash;
+    uint32_t u32Op = ptFlash->u32Op++;
+
+    if (u32Op < FS_HOST_OP_MAX)
+    {
+        ptFlash->u32aOpSize[u32Op] = u32Size;
+        ptFlash->u8aOpErase[u32Op] = u8Erase;
+    }
+
+    *pu32Done = u32Size;
+
+    if ((u32Op + 1) != ptFlash->u32CutOp)
+        return 0;
+
+    if (ptFlash->u32CutBytes < u32Size)
+        *pu32Done = ptFlash->u32CutBytes;
+
+    return 1;
+}
+
+static uint32_t _FsHost_FlashRead(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data)
+{
+    uint8_t *pu8Mem = _FsHost_FlashAt(u32StartAddr, u32Size);
+
+    if (pu8Mem == NULL)
+        return 1;
+
+    memcpy(pu8Data, pu8Mem, u32Size);
+
+    g_u32FsHostReadNs += u32Size * FS_HOST_READ_NS;
+    HostOs_TimeAdvanceUs(g_u32FsHostReadNs / 1000);
+    g_u32FsHostReadNs %= 1000;
+
+    return 0;
+}
+
+static uint32_t _FsHost_FlashProgram(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data)
+{
+    T_FsHostFlash *ptFlash = g_ptFsHostFlash;
+    uint8_t *pu8Mem = _FsHost_FlashAt(u32StartAddr, u32Size);
+    uint32_t u32Pages;
+    uint32_t u32Done;
+    uint8_t u8Cut;
+    uint32_t i;
+
+    if (pu8Mem == NULL)
+        return 1;
+
+    u8Cut = _FsHost_OpStart(u32Size, 0, &u32Done);
+
+    // NOR: a program clears bits only
+    for (i = 0; i < u32Done; i++)
+    {
+        if (pu8Data[i] & ~pu8Mem[i])
+            ptFlash->u32Overwrite++;
+
+        pu8Mem[i] &= pu8Data[i];
+    }
+
+    if (u8Cut)
+        _FsHost_PowerOff();
+
+    ptFlash->u32Program += u32Size;
+
+    // every page touched
+    u32Pages = ((u32StartAddr + u32Size + FS_HOST_PAGE_SIZE - 1) / FS_HOST_PAGE_SIZE) - (u32StartAddr / FS_HOST_PAGE_SIZE);
+    HostOs_TimeAdvanceUs(u32Pages * FS_HOST_PAGE_US);
+
+    return 0;
+}
+
+static uint32_t _FsHost_FlashErase(E_SpiIdx_t u32SpiIdx, uint32_t u32SecAddr)
+{
+    T_FsHostFlash *ptFlash = g_ptFsHostFlash;
+    uint8_t *pu8Mem = _FsHost_FlashAt(u32SecAddr, MW_FS_BLOCK_SIZE);
+    uint32_t u32Done;
+    uint8_t u8Cut;
+
+    if ((pu8Mem == NULL) || (u32SecAddr % MW_FS_BLOCK_SIZE))
+        return 1;
+
+    u8Cut = _FsHost_OpStart(MW_FS_BLOCK_SIZE, 1, &u32Done);
+    ptFlash->u32aErase[(u32SecAddr - MW_FS_ADDR) / MW_FS_BLOCK_SIZE]++;
+    ptFlash->u32Erase++;
+
+    memset(pu8Mem, 0xFF, u32Done);
+
+    if (u8Cut)
+        _FsHost_PowerOff();
+
+    HostOs_TimeAdvanceUs(FS_HOST_ERASE_US);
+    return 0;
+}
+
+T_Hal_Flash_AddrRead Hal_Flash_AddrRead = _FsHost_FlashRead;
+T_Hal_Flash_AddrProgram Hal_Flash_AddrProgram = _FsHost_FlashProgram;
+T_Hal_Flash_4KSectorAddrErase Hal_Flash_4KSectorAddrErase = _FsHost_FlashErase;
+
+// "fs cut": the reset after the program cut by the file system itself
+static uint32_t _FsHost_SwResetAll(void)
+{
+    _FsHost_PowerOff();
+    return 0;
+}
+
+T_Hal_Sys_SwResetAll Hal_Sys_SwResetAll = _FsHost_SwResetAll;
+
+// the service erases at once, the wait has nothing left
+uint8_t MwFlashSvc_EraseLater(uint32_t ulSecAddr)
+{
+    if (0 != Hal_Flash_4KSectorAddrErase(SPI_IDX_0, ulSecAddr))
+        return MW_FLASH_SVC_FAIL;
+
+    g_u32FsHostAhead = ulSecAddr;
+    return MW_FLASH_SVC_OK;
+}
+
+uint8_t MwFlashSvc_EraseSync(uint32_t ulSecAddr)
+{
+    if (g_u32FsHostAhead != ulSecAddr)
+        return MW_FLASH_SVC_FAIL;
+
+    g_u32FsHostAhead = FS_HOST_ANY;
+    return MW_FLASH_SVC_OK;
+}
+
+// printf() of mw_fs.c, the result of the diag command is counted
+static int _FsHost_TracerMsg(uint8_t bType, uint8_t bLevel, char *sFmt, ...)
+{
+    char baLine[256];
+    va_list tList;
+
+    va_start(tList, sFmt);
+    vsnprintf(baLine, sizeof(baLine), sFmt, tList);
+    va_end(tList);
+
+    if ((strstr(baLine, "check PASS")) || (strstr(baLine, "data ok")))
+        g_u32FsHostGood++;
+
+    if ((strstr(baLine, "FAIL")) || (strstr(baLine, "BAD DATA")) || (strstr(baLine, " bad at ")) ||
+        (strstr(baLine, "stopped")))
+        g_u32FsHostBad++;
+
+    return fputs(baLine, stdout);
+}
+
+/*
+ * The files, in the child process
+ */
+static uint32_t _FsHost_Rand(uint32_t *pu32Seed)
+{
+    uint32_t x = *pu32Seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    *pu32Seed = x;
+    return x;
+}
+
+// the content of a version: the generation in the first 4 bytes, then a hash of the offset
+static void _FsHost_Fill(uint32_t u32Gen, uint32_t u32Off, uint8_t *pu8Buf, uint32_t u32Size)
+{
+    uint32_t x;
+    uint32_t i;
+
+    for (i = 0; i < u32Size; i++, u32Off++)
+    {
+        if (u32Off < sizeof(u32Gen))
+        {
+            pu8Buf[i] = (uint8_t)(u32Gen >> (u32Off * 8));
+            continue;
+        }
+
+        x = u32Gen ^ (u32Off * 0x9E3779B1);
+        x ^= x >> 15;
+        x *= 0x85EBCA6B;
+        x ^= x >> 13;
+        pu8Buf[i] = (uint8_t)x;
+    }
+}
+
+// u32Size bytes of a version from u32Off, in random pieces; 1: all written
+static uint8_t _FsHost_Write(int iFd, uint32_t u32Gen, uint32_t u32Off, uint32_t u32Size, uint32_t *pu32Seed)
+{
+    uint8_t u8aBuf[FS_HOST_CHUNK_MAX];
+    uint32_t u32Chunk;
+
+    while (u32Size)
+    {
+        u32Chunk = 1 + (_FsHost_Rand(pu32Seed) % FS_HOST_CHUNK_MAX);
+        if (u32Chunk > u32Size)
+            u32Chunk = u32Size;
+
+        _FsHost_Fill(u32Gen, u32Off, u8aBuf, u32Chunk);
+
+        if (MwFs_Write(iFd, u8aBuf, u32Chunk) != (int)u32Chunk)
+            return 0;
+
+        u32Off += u32Chunk;
+        u32Size -= u32Chunk;
+    }
+
+    return 1;
+}
+
+// the generation and the size of a file of the bench; 1: it is one version
+static uint8_t _FsHost_Read(const char *sPath, uint32_t *pu32Gen, uint32_t *pu32Size)
+{
+    uint8_t u8aBuf[256];
+    uint8_t u8aWant[256];
+    uint32_t u32Gen = 0;
+    uint32_t u32Off = 0;
+    uint8_t u8Ok = 1;
+    int iFd;
+    int iLen;
+
+    iFd = MwFs_Open(sPath, MW_FS_O_RDONLY);
+    if (iFd < 0)
+        return 0;
+
+    while ((iLen = MwFs_Read(iFd, u8aBuf, sizeof(u8aBuf))) > 0)
+    {
+        if (u32Off == 0)
+        {
+            if (iLen < (int)sizeof(u32Gen))
+                u8Ok = 0;
+            else
+                u32Gen = u8aBuf[0] | (u8aBuf[1] << 8) | (u8aBuf[2] << 16) | ((uint32_t)u8aBuf[3] << 24);
+        }
+
+        _FsHost_Fill(u32Gen, u32Off, u8aWant, iLen);
+        if (memcmp(u8aBuf, u8aWant, iLen))
+            u8Ok = 0;
+
+        u32Off += iLen;
+    }
+
+    if (MW_FS_OK != MwFs_Close(iFd))
+        u8Ok = 0;
+
+    *pu32Gen = u32Gen;
+    *pu32Size = u32Off;
+
+    return (u8Ok) && (iLen == 0);
+}
+
+// the content of a state from u32Off
+static void _FsHost_SegFill(const T_FsHostState *ptState, uint32_t u32Off, uint8_t *pu8Buf, uint32_t u32Size)
+{
+    uint32_t u32Seg = 0;
+    uint32_t u32Chunk;
+
+    while (u32Size)
+    {
+        while (u32Off >= ptState->u32aEnd[u32Seg])
+            u32Seg++;
+
+        u32Chunk = ptState->u32aEnd[u32Seg] - u32Off;
+        if (u32Chunk > u32Size)
+            u32Chunk = u32Size;
+
+        _FsHost_Fill(ptState->u32aGen[u32Seg], u32Off, pu8Buf, u32Chunk);
+
+        pu8Buf += u32Chunk;
+        u32Off += u32Chunk;
+        u32Size -= u32Chunk;
+    }
+}
+
+// 1: a file of the power loss is found at its name only, with the content of ptState
+static uint8_t _FsHost_Match(uint32_t u32File, const T_FsHostState *ptState)
+{
+    uint8_t u8aBuf[256];
+    uint8_t u8aWant[256];
+    T_MwFsStat taStat[3];
+    T_MwFsStat *ptStat = &taStat[ptState->u8Where];
+    uint32_t u32Off = 0;
+    uint8_t u8Where;
+    uint8_t u8Ok = 1;
+    int iFd;
+    int iLen;
+
+    for (u8Where = FS_HOST_MAIN; u8Where <= FS_HOST_ALT; u8Where++)
+    {
+        if ((MW_FS_OK == MwFs_Stat(g_saFsHostPath[u32File][u8Where], &taStat[u8Where])) != (u8Where == ptState->u8Where))
+            return 0;
+    }
+
+    if (ptState->u8Where == FS_HOST_NONE)
+        return 1;
+
+    if ((ptStat->ubType != MW_FS_TYPE_FILE) || (ptStat->ulSize != ptState->u32Size))
+        return 0;
+
+    iFd = MwFs_Open(g_saFsHostPath[u32File][ptState->u8Where], MW_FS_O_RDONLY);
+    if (iFd < 0)
+        return 0;
+
+    while ((iLen = MwFs_Read(iFd, u8aBuf, sizeof(u8aBuf))) > 0)
+    {
+        if ((u32Off + iLen) > ptState->u32Size)
+        {
+            u8Ok = 0;
+            break;
+        }
+
+        _FsHost_SegFill(ptState, u32Off, u8aWant, iLen);
+        if (memcmp(u8aBuf, u8aWant, iLen))
+            u8Ok = 0;
+
+        u32Off += iLen;
+    }
+
+    if (MW_FS_OK != MwFs_Close(iFd))
+        u8Ok = 0;
+
+    return (u8Ok) && (iLen == 0) && (u32Off == ptState->u32Size);
+}
+
+static void _FsHost_SegAdd(T_FsHostState *ptState, uint32_t u32Gen, uint32_t u32Size)
+{
+    if (u32Size == 0)
+        return;
+
+    ptState->u32aGen[ptState->u8SegNum] = u32Gen;
+    ptState->u32Size += u32Size;
+    ptState->u32aEnd[ptState->u8SegNum++] = ptState->u32Size;
+}
+
+// the entries of a dir
+static uint32_t _FsHost_DirCount(const char *sDir)
+{
+    T_MwFsStat tStat;
+    uint32_t u32Cookie = 0;
+    uint32_t u32Num = 0;
+
+    while (MwFs_DirRead(sDir, &u32Cookie, &tStat) == 1)
+        u32Num++;
+
+    return u32Num;
+}
+
+// the files of the power loss in a dir, "/x" is in "/"
+static uint32_t _FsHost_DirFiles(const char *sDir)
+{
+    T_FsHostState *ptFile;
+    const char *sPath;
+    uint32_t u32Len;
+    uint32_t u32Num = 0;
+    uint32_t i;
+
+    for (i = 0; i < FS_HOST_FILE_NUM; i++)
+    {
+        ptFile = &g_ptFsHostFlash->taFile[i];
+        if (ptFile->u8Where == FS_HOST_NONE)
+            continue;
+
+        sPath = g_saFsHostPath[i][ptFile->u8Where];
+        u32Len = strrchr(sPath, '/') - sPath;
+
+        if ((u32Len == strlen(sDir)) && (!strncmp(sPath, sDir, u32Len)))
+            u32Num++;
+        else if ((u32Len == 0) && (!strcmp(sDir, "/")))
+            u32Num++;
+    }
+
+    return u32Num;
+}
+
+static void _FsHost_Mount(void)
+{
+    T_MwFsLayout tLayout;
+
+    tLayout.ulAddr = MW_FS_ADDR;
+    tLayout.ulBlockNum = g_ptFsHostFlash->u32BlockNum;
+
+    HOST_TEST_EQ(MwFs_Init(&tLayout), MW_FS_OK);
+}
+
+// the files as committed, the one cut in any state allowed, no block lost
+static void _FsHost_Verify(void)
+{
+    T_FsHostFlash *ptFlash = g_ptFsHostFlash;
+    T_FsHostState *ptFile;
+    T_MwFsStat tStat;
+    T_MwFsInfo tInfo;
+    uint32_t u32Blocks = 1;     // the table
+    uint32_t i, j;
+
+    for (i = 0; i < FS_HOST_FILE_NUM; i++)
+    {
+        ptFile = &ptFlash->taFile[i];
+
+        if (i == ptFlash->u32Inflight)
+        {
+            for (j = 0; j < ptFlash->u32AllowNum; j++)
+            {
+                if (_FsHost_Match(i, &ptFlash->taAllow[j]))
+                    break;
+            }
+
+            if (j < ptFlash->u32AllowNum)
+                *ptFile = ptFlash->taAllow[j];
+            else
+                ptFile = NULL;
+        }
+        else if (!_FsHost_Match(i, ptFile))
+        {
+            ptFile = NULL;
+        }
+
+        if (ptFile == NULL)
+        {
+            tracer_cli(LOG_HIGH_LEVEL, "  file %u: not at %u with %u bytes in %u segments as committed%s\n",
+                       i, ptFlash->taFile[i].u8Where, ptFlash->taFile[i].u32Size, ptFlash->taFile[i].u8SegNum,
+                       (i == ptFlash->u32Inflight) ? ", nor in a state of the op in flight" : "");
+            HOST_TEST_ASSERT(0);
+        }
+
+        u32Blocks += (ptFile->u32Size + FS_HOST_DATA_SIZE - 1) / FS_HOST_DATA_SIZE;
+    }
+
+    ptFlash->u32Inflight = FS_HOST_ANY;
+
+    HOST_TEST_EQ(MwFs_Stat("/a", &tStat), MW_FS_OK);
+    HOST_TEST_EQ(tStat.ubType, MW_FS_TYPE_DIR);
+    HOST_TEST_EQ(MwFs_Stat("/b", &tStat), MW_FS_OK);
+    HOST_TEST_EQ(tStat.ubType, MW_FS_TYPE_DIR);
+
+    HOST_TEST_EQ(_FsHost_DirCount("/"), 2 + _FsHost_DirFiles("/"));
+    HOST_TEST_EQ(_FsHost_DirCount("/a"), _FsHost_DirFiles("/a"));
+    HOST_TEST_EQ(_FsHost_DirCount("/b"), _FsHost_DirFiles("/b"));
+
+    // the blocks of a lost write are free again
+    HOST_TEST_EQ(MwFs_Info(&tInfo), MW_FS_OK);
+    HOST_TEST_EQ(tInfo.ulBlockFree, ptFlash->u32BlockNum - u32Blocks);
+}
+
+// the states of the op in flight, the old one first and the new one last
+static void _FsHost_Inflight(uint32_t u32File, uint32_t u32AllowNum)
+{
+    g_ptFsHostFlash->u32AllowNum = u32AllowNum;
+    g_ptFsHostFlash->u32Inflight = u32File;
+}
+
+// a random write, append, remove or rename of a file
+static void _FsHost_Op(uint32_t *pu32Seed)
+{
+    T_FsHostFlash *ptFlash = g_ptFsHostFlash;
+    uint32_t u32File = _FsHost_Rand(pu32Seed) % FS_HOST_FILE_NUM;
+    uint32_t u32Kind = _FsHost_Rand(pu32Seed) % 100;
+    T_FsHostState tOld = ptFlash->taFile[u32File];
+    T_FsHostState *ptAllow = ptFlash->taAllow;
+    const char *sPath;
+    uint32_t u32Num = 0;
+    uint32_t u32Gen;
+    uint32_t u32Size;
+    uint32_t u32Sync;
+    uint8_t u8Where;
+    int iFd;
+
+    u8Where = (tOld.u8Where != FS_HOST_NONE) ? tOld.u8Where : FS_HOST_MAIN;
+    sPath = g_saFsHostPath[u32File][u8Where];
+
+    ptAllow[u32Num++] = tOld;
+
+    if ((tOld.u8Where != FS_HOST_NONE) && (u32Kind >= 85))
+    {
+        ptAllow[u32Num] = tOld;
+        ptAllow[u32Num++].u8Where = (u8Where == FS_HOST_MAIN) ? FS_HOST_ALT : FS_HOST_MAIN;
+        _FsHost_Inflight(u32File, u32Num);
+
+        HOST_TEST_EQ(MwFs_Rename(sPath, g_saFsHostPath[u32File][ptAllow[1].u8Where]), MW_FS_OK);
+    }
+    else if ((tOld.u8Where != FS_HOST_NONE) && (u32Kind >= 70))
+    {
+        memset(&ptAllow[u32Num++], 0, sizeof(T_FsHostState));
+        _FsHost_Inflight(u32File, u32Num);
+
+        HOST_TEST_EQ(MwFs_Remove(sPath), MW_FS_OK);
+    }
+    else if ((tOld.u8Where != FS_HOST_NONE) && (u32Kind >= 40) && (tOld.u32Size < FS_HOST_APPEND_BELOW) &&
+             (tOld.u8SegNum < FS_HOST_SEG_MAX))
+    {
+        // the bytes of a lost append differ from the next one
+        u32Gen = _FsHost_Rand(pu32Seed);
+        u32Size = 1 + (_FsHost_Rand(pu32Seed) % FS_HOST_APPEND_MAX);
+        u32Sync = _FsHost_Rand(pu32Seed) % (u32Size + 1);
+
+        ptAllow[u32Num] = tOld;
+        _FsHost_SegAdd(&ptAllow[u32Num++], u32Gen, u32Sync);
+        ptAllow[u32Num] = tOld;
+        _FsHost_SegAdd(&ptAllow[u32Num++], u32Gen, u32Size);
+        _FsHost_Inflight(u32File, u32Num);
+
+        iFd = MwFs_Open(sPath, MW_FS_O_WRONLY | MW_FS_O_APPEND);
+        HOST_TEST_ASSERT(iFd >= 0);
+        HOST_TEST_ASSERT(_FsHost_Write(iFd, u32Gen, tOld.u32Size, u32Sync, pu32Seed));
+        HOST_TEST_EQ(MwFs_Sync(iFd), MW_FS_OK);
+        HOST_TEST_ASSERT(_FsHost_Write(iFd, u32Gen, tOld.u32Size + u32Sync, u32Size - u32Sync, pu32Seed));
+        HOST_TEST_EQ(MwFs_Close(iFd), MW_FS_OK);
+    }
+    else
+    {
+        u32Gen = _FsHost_Rand(pu32Seed);
+        u32Size = 1 + (_FsHost_Rand(pu32Seed) % FS_HOST_LEN_MAX);
+        u32Sync = 1 + (_FsHost_Rand(pu32Seed) % u32Size);
+
+        // created empty by the open
+        if (tOld.u8Where == FS_HOST_NONE)
+        {
+            memset(&ptAllow[u32Num], 0, sizeof(T_FsHostState));
+            ptAllow[u32Num++].u8Where = FS_HOST_MAIN;
+        }
+
+        memset(&ptAllow[u32Num], 0, sizeof(T_FsHostState));
+        ptAllow[u32Num].u8Where = u8Where;
+        _FsHost_SegAdd(&ptAllow[u32Num++], u32Gen, u32Sync);
+        memset(&ptAllow[u32Num], 0, sizeof(T_FsHostState));
+        ptAllow[u32Num].u8Where = u8Where;
+        _FsHost_SegAdd(&ptAllow[u32Num++], u32Gen, u32Size);
+        _FsHost_Inflight(u32File, u32Num);
+
+        iFd = MwFs_Open(sPath, MW_FS_O_WRONLY | MW_FS_O_CREAT | MW_FS_O_TRUNC);
+        HOST_TEST_ASSERT(iFd >= 0);
+        HOST_TEST_ASSERT(_FsHost_Write(iFd, u32Gen, 0, u32Sync, pu32Seed));
+        HOST_TEST_EQ(MwFs_Sync(iFd), MW_FS_OK);
+        HOST_TEST_ASSERT(_FsHost_Write(iFd, u32Gen, u32Sync, u32Size - u32Sync, pu32Seed));
+        HOST_TEST_EQ(MwFs_Close(iFd), MW_FS_OK);
+    }
+
+    HOST_TEST_ASSERT(_FsHost_Match(u32File, &ptAllow[u32Num - 1]));
+
+    ptFlash->taFile[u32File] = ptAllow[u32Num - 1];
+    ptFlash->u32Inflight = FS_HOST_ANY;
+}
+
+// mount, check the files, run the ops of the plan
+static void _FsHost_BootRun(void)
+{
+    T_FsHostFlash *ptFlash = g_ptFsHostFlash;
+    uint32_t u32Seed = ptFlash->u32Seed;
+    uint32_t i;
+
+    _FsHost_Mount();
+    if (!HostTest_Failed())
+        _FsHost_Verify();
+
+    for (i = 0; (i < ptFlash->u32OpNum) && (!HostTest_Failed()); i++)
+    {
+        _FsHost_Op(&u32Seed);
+        ptFlash->u32OpDone++;
+    }
+}
+
+// a new file system with the dirs of the power loss
+static void _FsHost_BootSetup(void)
+{
+    _FsHost_Mount();
+
+    HOST_TEST_EQ(MwFs_Mkdir("/a"), MW_FS_OK);
+    HOST_TEST_EQ(MwFs_Mkdir("/b"), MW_FS_OK);
+}
+
+/*
+ * The test
+ */
+// one boot in a child: the RAM starts over, the flash stays
+static int _FsHost_Boot(T_FsHostBootFp fpBoot)
+{
+    int iStatus = 0;
+    pid_t tPid;
+
+    g_ptFsHostFlash->u32Op = 0;
+    g_ptFsHostFlash->u32OpDone = 0;
+
+    fflush(stdout);
+    tPid = fork();
+
+    if (tPid == 0)
+    {
+        fpBoot();
+        fflush(stdout);
+        _exit(HostTest_Failed() ? FS_HOST_EXIT_FAIL : FS_HOST_EXIT_OK);
+    }
+
+    if ((tPid < 0) || (waitpid(tPid, &iStatus, 0) != tPid) || (!WIFEXITED(iStatus)))
+        return FS_HOST_EXIT_FAIL;
+
+    return WEXITSTATUS(iStatus);
+}
+
+static void _FsHost_Plan(uint32_t u32Seed, uint32_t u32OpNum, uint32_t u32CutOp, uint32_t u32CutBytes)
+{
+    T_FsHostFlash *ptFlash = g_ptFsHostFlash;
+
+    ptFlash->u32Seed = u32Seed;
+    ptFlash->u32OpNum = u32OpNum;
+    ptFlash->u32CutOp = u32CutOp;
+    ptFlash->u32CutBytes = u32CutBytes;
+}
+
+// an erased flash, no file
+static void _FsHost_Start(uint32_t u32BlockNum)
+{
+    T_FsHostFlash *ptFlash = g_ptFsHostFlash;
+
+    memset(ptFlash->u8aMem, 0xFF, FS_HOST_FLASH_SIZE);
+    memset(ptFlash->u32aErase, 0, sizeof(ptFlash->u32aErase));
+    memset(ptFlash->taFile, 0, sizeof(ptFlash->taFile));
+    ptFlash->u32Erase = 0;
+    ptFlash->u32Program = 0;
+    ptFlash->u32Overwrite = 0;
+    ptFlash->u32BlockNum = u32BlockNum;
+    ptFlash->u32Inflight = FS_HOST_ANY;
+
+    _FsHost_Plan(0, 0, 0, 0);
+}
+
+// the power lost at random in random ops
+static void _FsHost_PowerLoss(void)
+{
+    T_FsHostFlash *ptFlash = g_ptFsHostFlash;
+    uint32_t u32Seed = 0x2545F491;
+    uint32_t u32Cut = 0;
+    uint32_t u32Done = 0;
+    int iRet;
+    uint32_t i;
+
+    _FsHost_Start(FS_HOST_BLOCK_NUM);
+    HOST_TEST_EQ(_FsHost_Boot(_FsHost_BootSetup), FS_HOST_EXIT_OK);
+
+    for (i = 0; i < FS_HOST_ROUND_NUM; i++)
+    {
+        _FsHost_Plan(_FsHost_Rand(&u32Seed) | 1, FS_HOST_ROUND_OPS, 1 + (_FsHost_Rand(&u32Seed) % FS_HOST_ROUND_CUT),
+                     _FsHost_Rand(&u32Seed) % MW_FS_BLOCK_SIZE);
+
+        iRet = _FsHost_Boot(_FsHost_BootRun);
+        if (iRet == FS_HOST_EXIT_FAIL)
+        {
+            tracer_cli(LOG_HIGH_LEVEL, "  round %u, seed %u: cut in op %u after %u bytes\n", i, ptFlash->u32Seed,
+                       ptFlash->u32CutOp, ptFlash->u32CutBytes);
+            HOST_TEST_ASSERT(0);
+        }
+
+        if (iRet == FS_HOST_EXIT_CUT)
+            u32Cut++;
+
+        u32Done += ptFlash->u32OpDone;
+    }
+
+    _FsHost_Plan(0, 0, 0, 0);
+    HOST_TEST_EQ(_FsHost_Boot(_FsHost_BootRun), FS_HOST_EXIT_OK);
+    HOST_TEST_EQ(ptFlash->u32Overwrite, 0);
+
+    tracer_cli(LOG_HIGH_LEVEL, "powerloss: %u rounds, %u cut, %u ops done, %u erases, no commit lost\n",
+               FS_HOST_ROUND_NUM, u32Cut, u32Done, ptFlash->u32Erase);
+}
+
+// a power cut in every program and erase of a fixed sequence
+static void _FsHost_Sweep(void)
+{
+    T_FsHostFlash *ptFlash = g_ptFsHostFlash;
+    T_FsHostState taFile[FS_HOST_FILE_NUM];
+    uint32_t u32aSize[FS_HOST_OP_MAX];
+    uint8_t u8aErase[FS_HOST_OP_MAX];
+    uint32_t u32aBytes[4];
+    uint8_t *pu8Image;
+    uint32_t u32OpNum;
+    uint32_t u32BytesNum;
+    uint32_t u32Cut = 0;
+    uint32_t i, j;
+
+    pu8Image = malloc(FS_HOST_FLASH_SIZE);
+    HOST_TEST_ASSERT(pu8Image != NULL);
+
+    // some files to change
+    _FsHost_Start(FS_HOST_BLOCK_NUM);
+    HOST_TEST_EQ(_FsHost_Boot(_FsHost_BootSetup), FS_HOST_EXIT_OK);
+    _FsHost_Plan(11, 12, 0, 0);
+    HOST_TEST_EQ(_FsHost_Boot(_FsHost_BootRun), FS_HOST_EXIT_OK);
+
+    memcpy(pu8Image, ptFlash->u8aMem, FS_HOST_FLASH_SIZE);
+    memcpy(taFile, ptFlash->taFile, sizeof(taFile));
+
+    _FsHost_Plan(23, FS_HOST_SWEEP_OPS, 0, 0);
+    HOST_TEST_EQ(_FsHost_Boot(_FsHost_BootRun), FS_HOST_EXIT_OK);
+
+    u32OpNum = ptFlash->u32Op;
+    HOST_TEST_ASSERT(u32OpNum <= FS_HOST_OP_MAX);
+    memcpy(u32aSize, ptFlash->u32aOpSize, sizeof(u32aSize));
+    memcpy(u8aErase, ptFlash->u8aOpErase, sizeof(u8aErase));
+
+    for (i = 0; i < u32OpNum; i++)
+    {
+        if (u8aErase[i])
+        {
+            u32aBytes[0] = u32aSize[i] / 2;
+            u32BytesNum = 1;
+        }
+        else
+        {
+            u32aBytes[0] = 0;
+            u32aBytes[1] = 1;
+            u32aBytes[2] = u32aSize[i] / 2;
+            u32aBytes[3] = u32aSize[i] - 1;
+            u32BytesNum = (u32aSize[i] > 1) ? 4 : 1;
+        }
+
+        for (j = 0; j < u32BytesNum; j++)
+        {
+            memcpy(ptFlash->u8aMem, pu8Image, FS_HOST_FLASH_SIZE);
+            memcpy(ptFlash->taFile, taFile, sizeof(taFile));
+            ptFlash->u32Inflight = FS_HOST_ANY;
+
+            _FsHost_Plan(23, FS_HOST_SWEEP_OPS, i + 1, u32aBytes[j]);
+            HOST_TEST_EQ(_FsHost_Boot(_FsHost_BootRun), FS_HOST_EXIT_CUT);
+
+            // the files found, then more ops on them, then found again
+            _FsHost_Plan(37, FS_HOST_AFTER_OPS, 0, 0);
+            if (_FsHost_Boot(_FsHost_BootRun) != FS_HOST_EXIT_OK)
+            {
+                tracer_cli(LOG_HIGH_LEVEL, "  cut in op %u (%s of %u) after %u bytes\n", i + 1,
+                           (u8aErase[i]) ? "erase" : "program", u32aSize[i], u32aBytes[j]);
+                HOST_TEST_ASSERT(0);
+            }
+
+            _FsHost_Plan(0, 0, 0, 0);
+            if (_FsHost_Boot(_FsHost_BootRun) != FS_HOST_EXIT_OK)
+            {
+                tracer_cli(LOG_HIGH_LEVEL, "  after the cut in op %u, bytes %u: the next boot\n", i + 1, u32aBytes[j]);
+                HOST_TEST_ASSERT(0);
+            }
+
+            u32Cut++;
+        }
+    }
+
+    free(pu8Image);
+    HOST_TEST_EQ(ptFlash->u32Overwrite, 0);
+
+    tracer_cli(LOG_HIGH_LEVEL, "sweep: %u ops, %u programs and erases, %u cuts, no commit lost\n",
+               FS_HOST_SWEEP_OPS, u32OpNum, u32Cut);
+}
+
+static void _FsHost_BootApi(void)
+{
+    T_MwFsStat tStat;
+    uint32_t u32Cookie = 0;
+    char baBuf[16];
+    char baPath[8];
+    int iaFd[MW_FS_FILE_MAX];
+    int iFd;
+    uint32_t i;
+
+    // a new flash is formatted
+    _FsHost_Mount();
+
+    HOST_TEST_EQ(MwFs_Mkdir("/etc"), MW_FS_OK);
+    HOST_TEST_EQ(MwFs_Mkdir("/etc"), MW_FS_ERR_EXIST);
+    HOST_TEST_EQ(MwFs_Mkdir("/no/dir"), MW_FS_ERR_NOENT);
+    HOST_TEST_EQ(MwFs_Open("/etc/cfg", MW_FS_O_RDONLY), MW_FS_ERR_NOENT);
+    HOST_TEST_EQ(MwFs_Open("/etc/cfg", MW_FS_O_CREAT), MW_FS_ERR_INVAL);
+    HOST_TEST_EQ(MwFs_Open("/etc", MW_FS_O_RDONLY), MW_FS_ERR_ISDIR);
+    HOST_TEST_EQ(MwFs_Open("/etc/abcdefghijklmnopqrstuvwx", MW_FS_O_WRONLY | MW_FS_O_CREAT), MW_FS_ERR_NAMETOOLONG);
+
+    // the create is committed, the data at the close
+    iFd = MwFs_Open("/etc/cfg", MW_FS_O_WRONLY | MW_FS_O_CREAT);
+    HOST_TEST_ASSERT(iFd >= 0);
+    HOST_TEST_EQ(MwFs_Write(iFd, "hello", 5), 5);
+    HOST_TEST_EQ(MwFs_Read(iFd, baBuf, 5), MW_FS_ERR_BADF);
+    HOST_TEST_EQ(MwFs_Seek(iFd, 0, MW_FS_SEEK_SET), 0);
+    HOST_TEST_EQ(MwFs_Write(iFd, "x", 1), MW_FS_ERR_INVAL);
+    HOST_TEST_EQ(MwFs_Seek(iFd, 6, MW_FS_SEEK_SET), MW_FS_ERR_INVAL);
+    HOST_TEST_EQ(MwFs_Open("/etc/cfg", MW_FS_O_RDONLY), MW_FS_ERR_BUSY);
+    HOST_TEST_EQ(MwFs_Remove("/etc/cfg"), MW_FS_ERR_BUSY);
+    HOST_TEST_EQ(MwFs_Stat("/etc/cfg", &tStat), MW_FS_OK);
+    HOST_TEST_EQ(tStat.ulSize, 0);
+    HOST_TEST_EQ(MwFs_Close(iFd), MW_FS_OK);
+    HOST_TEST_EQ(MwFs_Close(iFd), MW_FS_ERR_BADF);
+    HOST_TEST_EQ(MwFs_Stat("/etc/cfg", &tStat), MW_FS_OK);
+    HOST_TEST_EQ(tStat.ulSize, 5);
+
+    HOST_TEST_EQ(MwFs_Open("/etc/cfg", MW_FS_O_WRONLY | MW_FS_O_CREAT | MW_FS_O_EXCL), MW_FS_ERR_EXIST);
+    HOST_TEST_EQ(MwFs_Open("/etc/cfg/x", MW_FS_O_WRONLY | MW_FS_O_CREAT), MW_FS_ERR_NOTDIR);
+
+    // read anywhere, write at the end
+    iFd = MwFs_Open("/etc/cfg", MW_FS_O_RDWR | MW_FS_O_APPEND);
+    HOST_TEST_ASSERT(iFd >= 0);
+    HOST_TEST_EQ(MwFs_Seek(iFd, -2, MW_FS_SEEK_END), 3);
+    HOST_TEST_EQ(MwFs_Read(iFd, baBuf, sizeof(baBuf)), 2);
+    HOST_TEST_ASSERT(!memcmp(baBuf, "lo", 2));
+    HOST_TEST_EQ(MwFs_Seek(iFd, 0, MW_FS_SEEK_SET), 0);
+    HOST_TEST_EQ(MwFs_Write(iFd, " world", 6), 6);
+    HOST_TEST_EQ(MwFs_Seek(iFd, 0, MW_FS_SEEK_SET), 0);
+    HOST_TEST_EQ(MwFs_Read(iFd, baBuf, sizeof(baBuf)), 11);
+    HOST_TEST_ASSERT(!memcmp(baBuf, "hello world", 11));
+    HOST_TEST_EQ(MwFs_Read(iFd, baBuf, sizeof(baBuf)), 0);
+    HOST_TEST_EQ(MwFs_Close(iFd), MW_FS_OK);
+
+    HOST_TEST_EQ(MwFs_Remove("/etc"), MW_FS_ERR_NOTEMPTY);
+    HOST_TEST_EQ(MwFs_Remove("/"), MW_FS_ERR_INVAL);
+    HOST_TEST_EQ(MwFs_Rename("/etc", "/etc/sub"), MW_FS_ERR_INVAL);
+    HOST_TEST_EQ(MwFs_Rename("/none", "/x"), MW_FS_ERR_NOENT);
+    HOST_TEST_EQ(MwFs_Rename("/etc/cfg", "/cfg"), MW_FS_OK);
+    HOST_TEST_EQ(MwFs_Rename("/cfg", "/etc"), MW_FS_ERR_EXIST);
+
+    // the handles
+    for (i = 0; i < MW_FS_FILE_MAX; i++)
+    {
+        sprintf(baPath, "/f%u", i);
+        iaFd[i] = MwFs_Open(baPath, MW_FS_O_WRONLY | MW_FS_O_CREAT);
+        HOST_TEST_ASSERT(iaFd[i] >= 0);
+    }
+
+    HOST_TEST_EQ(MwFs_Open("/cfg", MW_FS_O_RDONLY), MW_FS_ERR_MFILE);
+
+    for (i = 0; i < MW_FS_FILE_MAX; i++)
+        HOST_TEST_EQ(MwFs_Close(iaFd[i]), MW_FS_OK);
+
+    HOST_TEST_EQ(_FsHost_DirCount("/"), 2 + MW_FS_FILE_MAX);
+    HOST_TEST_EQ(_FsHost_DirCount("/etc"), 0);
+    HOST_TEST_EQ(MwFs_DirRead("/cfg", &u32Cookie, &tStat), MW_FS_ERR_NOTDIR);
+
+    // written, not committed: lost at the reset
+    iFd = MwFs_Open("/cfg", MW_FS_O_WRONLY | MW_FS_O_APPEND);
+    HOST_TEST_ASSERT(iFd >= 0);
+    HOST_TEST_EQ(MwFs_Write(iFd, "!!!", 3), 3);
+}
+
+static void _FsHost_BootApiAgain(void)
+{
+    T_MwFsStat tStat;
+    T_MwFsInfo tInfo;
+    char baBuf[16];
+    int iFd;
+
+    _FsHost_Mount();
+
+    iFd = MwFs_Open("/cfg", MW_FS_O_RDONLY);
+    HOST_TEST_ASSERT(iFd >= 0);
+    HOST_TEST_EQ(MwFs_Read(iFd, baBuf, sizeof(baBuf)), 11);
+    HOST_TEST_ASSERT(!memcmp(baBuf, "hello world", 11));
+    HOST_TEST_EQ(MwFs_Close(iFd), MW_FS_OK);
+
+    // the table and the block of /cfg, the empty files have none
+    HOST_TEST_EQ(MwFs_Info(&tInfo), MW_FS_OK);
+    HOST_TEST_EQ(tInfo.ulBlockFree, FS_HOST_BLOCK_NUM - 2);
+    HOST_TEST_EQ(tInfo.ulEntryUsed, 2 + MW_FS_FILE_MAX);
+
+    HOST_TEST_EQ(MwFs_Remove("/etc"), MW_FS_OK);
+    HOST_TEST_EQ(MwFs_Format(), MW_FS_OK);
+    HOST_TEST_EQ(MwFs_Stat("/cfg", &tStat), MW_FS_ERR_NOENT);
+    HOST_TEST_EQ(_FsHost_DirCount("/"), 0);
+}
+
+// the calls and their errors, a write kept at the close only
+static void _FsHost_Api(void)
+{
+    _FsHost_Start(FS_HOST_BLOCK_NUM);
+
+    HOST_TEST_EQ(_FsHost_Boot(_FsHost_BootApi), FS_HOST_EXIT_OK);
+    HOST_TEST_EQ(_FsHost_Boot(_FsHost_BootApiAgain), FS_HOST_EXIT_OK);
+    HOST_TEST_EQ(g_ptFsHostFlash->u32Overwrite, 0);
+}
+
+static void _FsHost_BootCmd(void)
+{
+    char baMkdir[] = "fs mkdir /d";
+    char baWrite[] = "fs write /d/x hello";
+    char baLs[] = "fs ls /d";
+    char baCat[] = "fs cat /d/x";
+    char baStress[] = "fs stress 40 7";
+    char baCheck[] = "fs check";
+    char baInfo[] = "fs";
+    char baCut[] = "fs cut 30";
+    char baAgain[] = "fs stress 40 9";
+
+    HOST_TEST_EQ(MwFs_Init(NULL), MW_FS_OK);
+
+    g_u32FsHostGood = 0;
+    g_u32FsHostBad = 0;
+
+    MwFs_Cmd(baMkdir);
+    MwFs_Cmd(baWrite);
+    MwFs_Cmd(baLs);
+    MwFs_Cmd(baCat);
+    MwFs_Cmd(baStress);
+    MwFs_Cmd(baCheck);
+    MwFs_Cmd(baInfo);
+
+    // the stress checks at its end too
+    HOST_TEST_EQ(g_u32FsHostGood, 2);
+    HOST_TEST_EQ(g_u32FsHostBad, 0);
+
+    // the 30th program stops in the middle and resets
+    MwFs_Cmd(baCut);
+    MwFs_Cmd(baAgain);
+
+    HOST_TEST_ASSERT(0);
+}
+
+static void _FsHost_BootCheck(void)
+{
+    char baCheck[] = "fs check";
+    char baCat[] = "fs cat /d/x";
+
+    HOST_TEST_EQ(MwFs_Init(NULL), MW_FS_OK);
+
+    g_u32FsHostGood = 0;
+    g_u32FsHostBad = 0;
+
+    MwFs_Cmd(baCheck);
+    MwFs_Cmd(baCat);
+
+    HOST_TEST_EQ(g_u32FsHostGood, 1);
+    HOST_TEST_EQ(g_u32FsHostBad, 0);
+}
+
+// the diag command, and the cut of the file system itself
+static void _FsHost_Cmd(void)
+{
+    _FsHost_Start(MW_FS_BLOCK_NUM);
+
+    HOST_TEST_EQ(_FsHost_Boot(_FsHost_BootCmd), FS_HOST_EXIT_CUT);
+    HOST_TEST_EQ(_FsHost_Boot(_FsHost_BootCheck), FS_HOST_EXIT_OK);
+}
+
+/*
+ * The bench, on the default partition
+ */
+// a setting written again each time
+static uint8_t _FsHost_BenchRewrite(uint32_t u32Op)
+{
+    uint8_t u8aBuf[FS_HOST_CFG_LEN];
+    int iFd = MwFs_Open("/cfg", MW_FS_O_WRONLY | MW_FS_O_CREAT | MW_FS_O_TRUNC);
+
+    if (iFd < 0)
+        return 0;
+
+    _FsHost_Fill(u32Op, 0, u8aBuf, sizeof(u8aBuf));
+
+    return (MwFs_Write(iFd, u8aBuf, sizeof(u8aBuf)) == sizeof(u8aBuf)) && (MW_FS_OK == MwFs_Close(iFd));
+}
+
+// a record added by an open, a write and a close
+static uint8_t _FsHost_BenchReopen(uint32_t u32Op)
+{
+    uint8_t u8aBuf[FS_HOST_BENCH_LEN];
+    int iFd = MwFs_Open("/reopen", MW_FS_O_WRONLY | MW_FS_O_CREAT | MW_FS_O_APPEND);
+
+    if (iFd < 0)
+        return 0;
+
+    _FsHost_Fill(1, u32Op * sizeof(u8aBuf), u8aBuf, sizeof(u8aBuf));
+
+    return (MwFs_Write(iFd, u8aBuf, sizeof(u8aBuf)) == sizeof(u8aBuf)) && (MW_FS_OK == MwFs_Close(iFd));
+}
+
+// a record added to an open file and synced
+static uint8_t _FsHost_BenchSync(uint32_t u32Op)
+{
+    uint8_t u8aBuf[FS_HOST_BENCH_LEN];
+
+    if (g_iFsHostSyncFd < 0)
+        g_iFsHostSyncFd = MwFs_Open("/sync", MW_FS_O_WRONLY | MW_FS_O_CREAT | MW_FS_O_APPEND);
+
+    if (g_iFsHostSyncFd < 0)
+        return 0;
+
+    _FsHost_Fill(1, u32Op * sizeof(u8aBuf), u8aBuf, sizeof(u8aBuf));
+
+    return (MwFs_Write(g_iFsHostSyncFd, u8aBuf, sizeof(u8aBuf)) == sizeof(u8aBuf)) && (MW_FS_OK == MwFs_Sync(g_iFsHostSyncFd));
+}
+
+static const T_FsHostBench g_taFsHostBench[] =
+{
+    { "rewrite of 100 B",      _FsHost_BenchRewrite,   FS_HOST_CFG_OPS,    FS_HOST_CFG_LEN },
+    { "append 64 B, reopen",   _FsHost_BenchReopen,    FS_HOST_BENCH_OPS,  FS_HOST_BENCH_LEN },
+    { "append 64 B, sync",     _FsHost_BenchSync,      FS_HOST_BENCH_OPS,  FS_HOST_BENCH_LEN },
+};
+
+static void _FsHost_BootBench(void)
+{
+    T_FsHostFlash *ptFlash = g_ptFsHostFlash;
+    const T_FsHostBench *ptBench;
+    char baBench[] = "fs bench 32";
+    uint64_t u64Us;
+    uint32_t u32Erase;
+    uint32_t u32Program;
+    uint32_t u32Data;
+    uint32_t u32Gen;
+    uint32_t u32Size;
+    uint32_t i, j;
+
+    HOST_TEST_EQ(MwFs_Init(NULL), MW_FS_OK);
+
+    // the throughput of the flash
+    g_u32FsHostGood = 0;
+    g_u32FsHostBad = 0;
+    MwFs_Cmd(baBench);
+    HOST_TEST_EQ(g_u32FsHostGood, 1);
+    HOST_TEST_EQ(g_u32FsHostBad, 0);
+
+    // the erases and the programs of each kind of write
+    for (i = 0; i < HOST_TEST_NUM(g_taFsHostBench); i++)
+    {
+        ptBench = &g_taFsHostBench[i];
+
+        u64Us = HostOs_TimeUs();
+        u32Erase = ptFlash->u32Erase;
+        u32Program = ptFlash->u32Program;
+
+        for (j = 0; j < ptBench->u32OpNum; j++)
+            HOST_TEST_ASSERT(ptBench->fpOp(j));
+
+        u64Us = HostOs_TimeUs() - u64Us;
+        u32Erase = ptFlash->u32Erase - u32Erase;
+        u32Program = ptFlash->u32Program - u32Program;
+        u32Data = ptBench->u32OpNum * ptBench->u32Len;
+
+        tracer_cli(LOG_HIGH_LEVEL, "bench: %-20s %3u ops, %u.%02u erases, %4u B programmed (x%u) and %3u ms an op\n",
+                   ptBench->sName, ptBench->u32OpNum, u32Erase / ptBench->u32OpNum,
+                   (u32Erase % ptBench->u32OpNum) * 100 / ptBench->u32OpNum, u32Program / ptBench->u32OpNum,
+                   u32Program / u32Data, (uint32_t)(u64Us / 1000 / ptBench->u32OpNum));
+
+        // a commit erases the block of the new table, at least
+        HOST_TEST_ASSERT(u32Erase >= ptBench->u32OpNum);
+        HOST_TEST_ASSERT(u32Program >= u32Data);
+    }
+
+    HOST_TEST_EQ(MwFs_Close(g_iFsHostSyncFd), MW_FS_OK);
+
+    HOST_TEST_ASSERT(_FsHost_Read("/cfg", &u32Gen, &u32Size));
+    HOST_TEST_EQ(u32Gen, FS_HOST_CFG_OPS - 1);
+    HOST_TEST_EQ(u32Size, FS_HOST_CFG_LEN);
+    HOST_TEST_ASSERT(_FsHost_Read("/reopen", &u32Gen, &u32Size));
+    HOST_TEST_EQ(u32Size, FS_HOST_BENCH_OPS * FS_HOST_BENCH_LEN);
+    HOST_TEST_ASSERT(_FsHost_Read("/sync", &u32Gen, &u32Size));
+    HOST_TEST_EQ(u32Size, FS_HOST_BENCH_OPS * FS_HOST_BENCH_LEN);
+}
+
+// the throughput, the erases of each kind of write and their spread
+static void _FsHost_Bench(void)
+{
+    T_FsHostFlash *ptFlash = g_ptFsHostFlash;
+    uint32_t u32Min = FS_HOST_ANY;
+    uint32_t u32Max = 0;
+    uint32_t i;
+
+    _FsHost_Start(MW_FS_BLOCK_NUM);
+
+    HOST_TEST_EQ(_FsHost_Boot(_FsHost_BootBench), FS_HOST_EXIT_OK);
+    HOST_TEST_EQ(ptFlash->u32Overwrite, 0);
+
+    for (i = 0; i < MW_FS_BLOCK_NUM; i++)
+    {
+        if (ptFlash->u32aErase[i] < u32Min)
+            u32Min = ptFlash->u32aErase[i];
+        if (ptFlash->u32aErase[i] > u32Max)
+            u32Max = ptFlash->u32aErase[i];
+    }
+
+    tracer_cli(LOG_HIGH_LEVEL, "wear: %u erases over %u blocks, %u to %u a block\n",
+               ptFlash->u32Erase, MW_FS_BLOCK_NUM, u32Min, u32Max);
+
+    // round-robin: no block takes more than its share, the blocks of the
+    // data kept are erased less
+    HOST_TEST_ASSERT((u32Max * MW_FS_BLOCK_NUM) <= (ptFlash->u32Erase + (2 * MW_FS_BLOCK_NUM)));
+}
+
+static const T_HostTestCase g_taFsHostCase[] =
+{
+    HOST_TEST_CASE(_FsHost_Api),
+    HOST_TEST_CASE(_FsHost_PowerLoss),
+    HOST_TEST_CASE(_FsHost_Sweep),
+    HOST_TEST_CASE(_FsHost_Cmd),
+    HOST_TEST_CASE(_FsHost_Bench),
+};
+
+int main(void)
+{
+    HostOs_Init();
+
+    // the flash takes its time in the simulated clock only
+    HostOs_TimeFreeze(1);
+
+    g_ptFsHostFlash = mmap(NULL, sizeof(T_FsHostFlash), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (g_ptFsHostFlash == MAP_FAILED)
+        return 1;
+
+    tracer_msg = _FsHost_TracerMsg;
+
+    return HostTest_Run("mw_fs", g_taFsHostCase, HOST_TEST_NUM(g_taFsHostCase));
+}
@@ -0,0 +1,897 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  mw_log_flash_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The flash log of mw_log_flash.c over a RAM flash, with the power cut in
+*  every program and erase of it.
+*
+*  The flash is a NOR model in shared memory under the ROM flash functions:
+*  a program only clears bits, an erase sets the sector to 0xFF, and a
+*  program that would set a bit back is counted as a fault of the log. Every
+*  boot is a child process, so the RAM, the task and the statics of the log
+*  start over while the flash stays. A power cut stops the child after some
+*  bytes of one program or erase.
+*
+*  A boot with no cut lists the programs and erases of writing the lines on
+*  a used flash. The sweep then cuts the power in each of them, at the
+*  start, after one byte, in the middle and one byte before the end (an
+*  erase in the middle), boots again and checks that every line programmed
+*  in full is found in order, that the log goes on after it and that the
+*  next boot finds both.
+*
+*  The tracer lines reach the log through a tracer_msg that copies them as
+*  msg_patch.c does, with no UART attached. The erase service queues
+*  nothing: MwFlashSvc_EraseLater erases at once, so its erase can be cut
+*  too.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "cmsis_os.h"
+#include "msg.h"
+#include "at_cmd_common.h"
+#include "at_cmd_data_process.h"
+#include "hal_system.h"
+#include "hal_flash.h"
+#include "mw_flash_svc.h"
+#include "mw_log_flash.h"
+#include "host_os.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define LOG_HOST_FLASH_SIZE         (MW_LOG_FLASH_SECTOR_NUM * MW_LOG_FLASH_SECTOR_SIZE)
+#define LOG_HOST_OP_MAX             (1024)
+#define LOG_HOST_LINE_MAX           (LOG_HOST_FLASH_SIZE / 20)
+#define LOG_HOST_WAIT_US            (2000000)
+#define LOG_HOST_ANY                (0xFFFFFFFF)
+
+// "line nnnnn " and the pad fill MW_LOG_FLASH_TEXT_MAX
+#define LOG_HOST_PAD_LEN            (MW_LOG_FLASH_TEXT_MAX - 11)
+#define LOG_HOST_REC_SIZE           ((sizeof(T_MwLogFlashRec) + MW_LOG_FLASH_TEXT_MAX + 3) & ~3)
+#define LOG_HOST_SEC_LINES          ((MW_LOG_FLASH_SECTOR_SIZE - sizeof(T_MwLogFlashSec)) / LOG_HOST_REC_SIZE)
+
+#define LOG_HOST_CUT_LINES          (LOG_HOST_SEC_LINES + 4)    // into the second sector
+#define LOG_HOST_MORE_LINES         (5)
+#define LOG_HOST_ROTATE_LINES       (400)
+
+// a line of the test to the log, not printed
+#define LOG_HOST_LOG(level, args...) \
+    do { \
+        g_u8LogHostQuiet = 1; \
+        tracer_log(level, args); \
+        g_u8LogHostQuiet = 0; \
+    } while (0)
+
+// the exit code of a boot
+#define LOG_HOST_EXIT_OK            (0)
+#define LOG_HOST_EXIT_FAIL          (1)
+#define LOG_HOST_EXIT_CUT           (2)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+// in shared memory: what a boot leaves to the next one and to the test
+typedef struct
+{
+    uint8_t u8aMem[LOG_HOST_FLASH_SIZE];
+
+    // the power cut: the op counted from 1, 0: none, and the bytes done in it
+    uint32_t u32CutOp;
+    uint32_t u32CutBytes;
+
+    // the programs and erases of the last boot
+    uint32_t u32Op;
+    uint32_t u32aOpSize[LOG_HOST_OP_MAX];
+    uint8_t u8aOpErase[LOG_HOST_OP_MAX];
+    uint32_t u32RecDone;            // records programmed in full
+    uint32_t u32aErase[MW_LOG_FLASH_SECTOR_NUM];
+    uint32_t u32Overwrite;          // a bit programmed from 0 to 1
+
+    // the plan of the boot: the lines found, then the lines put
+    uint32_t u32Expect;             // LOG_HOST_ANY: any number
+    uint32_t u32First;              // the line after the last one found, the first put
+    uint32_t u32Put;
+    uint32_t u32SeqFirst;           // of the first line found, 0: any
+    uint32_t u32BootFirst;          // the first line of a later boot, LOG_HOST_ANY: none
+    uint32_t u32Torn;               // sectors closed at the mount, LOG_HOST_ANY: any
+} T_LogHostFlash;
+
+// a line of the AT dump
+typedef struct
+{
+    uint32_t u32Seq;
+    uint32_t u32Boot;
+    uint32_t u32Tick;
+    char cLevel;
+    uint32_t u32Line;               // "line nnnnn", LOG_HOST_ANY: another text
+} T_LogHostLine;
+
+typedef void (*T_LogHostBootFp)(void);
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_LogHostFlash *g_ptLogHostFlash;
+
+static char g_baLogHostPad[LOG_HOST_PAD_LEN + 1];
+
+static T_LogHostLine g_taLogHostLine[LOG_HOST_LINE_MAX];
+static uint32_t g_u32LogHostLineNum;
+static uint32_t g_u32aLogHostStatus[6];        // on, level, lines, written, dropped, torn
+static uint8_t g_u8LogHostStatus;
+
+static osThreadId g_tLogHostMain;
+static volatile uint8_t g_u8LogHostMounted;
+static T_osSemaphoreReleaseFp g_fpLogHostSemRelease;
+static uint32_t g_u32LogHostTracer;             // lines of the tracer
+static uint8_t g_u8LogHostQuiet;
+
+static uint32_t g_u32LogHostAhead = LOG_HOST_ANY;   // queued to the erase service
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+/*
+ * The flash
+ */
+static void _LogHost_PowerOff(void)
+{
+    fflush(stdout);
+    _exit(LOG_HOST_EXIT_CUT);
+}
+
+static uint8_t *_LogHost_FlashAt(uint32_t u32Addr, uint32_t u32Size)
+{
+    if ((u32Addr < MW_LOG_FLASH_ADDR) || ((u32Addr + u32Size) > (MW_LOG_FLASH_ADDR + LOG_HOST_FLASH_SIZE)))
+        return NULL;
+
+    return &g_ptLogHostFlash->u8aMem[u32Addr - MW_LOG_FLASH_ADDR];
+}
+
+// the next program or erase, 1: the power is cut in it after *pu32Done bytes
+static uint8_t _LogHost_OpStart(uint32_t u32Size, uint8_t u8Erase, uint32_t *pu32Done)
+{
+    T_LogHostFlash *ptFlash = g_ptLogHostFlash;
+    uint32_t u32Op = ptFlash->u32Op++;
+
+    if (u32Op < LOG_HOST_OP_MAX)
+    {
+        ptFlash->u32aOpSize[u32Op] = u32Size;
+        ptFlash->u8aOpErase[u32Op] = u8Erase;
+    }
+
+    *pu32Done = u32Size;
+
+    if ((u32Op + 1) != ptFlash->u32CutOp)
+        return 0;
+
+    if (ptFlash->u32CutBytes < u32Size)
+        *pu32Done = ptFlash->u32CutBytes;
+
+    return 1;
+}
+
+static uint32_t _LogHost_FlashRead(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data)
+{
+    uint8_t *pu8Mem = _LogHost_FlashAt(u32StartAddr, u32Size);
+
+    if (pu8Mem == NULL)
+        return 1;
+
+    memcpy(pu8Data, pu8Mem, u32Size);
+    return 0;
+}
+
+static uint32_t _LogHost_FlashProgram(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data)
+{
+    T_LogHostFlash *ptFlash = g_ptLogHostFlash;
+    uint8_t *pu8Mem = _LogHost_FlashAt(u32StartAddr, u32Size);
+    uint32_t u32Done;
+    uint8_t u8Cut;
+    uint32_t i;
+
+    if (pu8Mem == NULL)
+        return 1;
+
+    u8Cut = _LogHost_OpStart(u32Size, 0, &u32Done);
+
+    // NOR: a program clears bits only
+    for (i = 0; i < u32Done; i++)
+    {
+        if (pu8Data[i] & ~pu8Mem[i])
+            ptFlash->u32Overwrite++;
+
+        pu8Mem[i] &= pu8Data[i];
+    }
+
+    if (u8Cut)
+        _LogHost_PowerOff();
+
+    // a whole record: the head and ubLen of text
+    if ((u32Size > sizeof(T_MwLogFlashRec)) && (pu8Data[0] == MW_LOG_FLASH_REC_MAGIC) &&
+        (u32Size == (sizeof(T_MwLogFlashRec) + ((T_MwLogFlashRec *)pu8Data)->ubLen)))
+        ptFlash->u32RecDone++;
+
+    return 0;
+}
+
+static uint32_t _LogHost_FlashErase(E_SpiIdx_t u32SpiIdx, uint32_t u32SecAddr)
+{
+    T_LogHostFlash *ptFlash = g_ptLogHostFlash;
+    uint8_t *pu8Mem = _LogHost_FlashAt(u32SecAddr, MW_LOG_FLASH_SECTOR_SIZE);
+    uint32_t u32Done;
+    uint8_t u8Cut;
+
+    if ((pu8Mem == NULL) || (u32SecAddr % MW_LOG_FLASH_SECTOR_SIZE))
+        return 1;
+
+    u8Cut = _LogHost_OpStart(MW_LOG_FLASH_SECTOR_SIZE, 1, &u32Done);
+    ptFlash->u32aErase[(u32SecAddr - MW_LOG_FLASH_ADDR) / MW_LOG_FLASH_SECTOR_SIZE]++;
+
+    memset(pu8Mem, 0xFF, u32Done);
+
+    if (u8Cut)
+        _LogHost_PowerOff();
+
+    return 0;
+}
+
+T_Hal_Flash_AddrRead Hal_Flash_AddrRead = _LogHost_FlashRead;
+T_Hal_Flash_AddrProgram Hal_Flash_AddrProgram = _LogHost_FlashProgram;
+T_Hal_Flash_4KSectorAddrErase Hal_Flash_4KSectorAddrErase = _LogHost_FlashErase;
+
+// "logflash cut": the reset after the program cut by the log itself
+static uint32_t _LogHost_SwResetAll(void)
+{
+    _LogHost_PowerOff();
+    return 0;
+}
+
+T_Hal_Sys_SwResetAll Hal_Sys_SwResetAll = _LogHost_SwResetAll;
+
+// the service erases at once, the wait has nothing left
+uint8_t MwFlashSvc_EraseLater(uint32_t ulSecAddr)
+{
+    if (0 != Hal_Flash_4KSectorAddrErase(SPI_IDX_0, ulSecAddr))
+        return MW_FLASH_SVC_FAIL;
+
+    g_u32LogHostAhead = ulSecAddr;
+    return MW_FLASH_SVC_OK;
+}
+
+uint8_t MwFlashSvc_EraseSync(uint32_t ulSecAddr)
+{
+    if (g_u32LogHostAhead != ulSecAddr)
+        return MW_FLASH_SVC_FAIL;
+
+    g_u32LogHostAhead = LOG_HOST_ANY;
+    return MW_FLASH_SVC_OK;
+}
+
+/*
+ * The tracer and the AT output
+ */
+// the copy of msg_patch.c, every task at every level, once a boot started
+// the log; printf() of the test comes here too
+static int _LogHost_TracerMsg(uint8_t bType, uint8_t bLevel, char *sFmt, ...)
+{
+    va_list tList;
+    int iRet = 0;
+
+    g_u32LogHostTracer++;
+
+    if ((g_tLogHostMain != NULL) && (bType == TRACER_TYPE_LOG) && (MwLogFlash_LevelCheck(bLevel)))
+    {
+        va_start(tList, sFmt);
+        MwLogFlash_VPut(bLevel, sFmt, tList);
+        va_end(tList);
+    }
+
+    if (!g_u8LogHostQuiet)
+    {
+        va_start(tList, sFmt);
+        iRet = vfprintf(stdout, sFmt, tList);
+        va_end(tList);
+    }
+
+    return iRet;
+}
+
+// the lines of at+logflash, into the table
+static void _LogHost_AtPrint(char *sFmt, ...)
+{
+    char baLine[MW_LOG_FLASH_TEXT_MAX + 64];
+    char baText[MW_LOG_FLASH_TEXT_MAX + 1];
+    T_LogHostLine tLine;
+    uint32_t *pu32Status = g_u32aLogHostStatus;
+    va_list tList;
+
+    va_start(tList, sFmt);
+    vsnprintf(baLine, sizeof(baLine), sFmt, tList);
+    va_end(tList);
+
+    // the level of a line is a letter, the status has numbers only
+    if (sscanf(baLine, "+LOGFLASH:%u,%u,%u,%u,%u,%u", &pu32Status[0], &pu32Status[1], &pu32Status[2],
+               &pu32Status[3], &pu32Status[4], &pu32Status[5]) == 6)
+    {
+        g_u8LogHostStatus = 1;
+        return;
+    }
+
+    if (sscanf(baLine, "+LOGFLASH:%u,%u,%u,%c,%96[^\r\n]", &tLine.u32Seq, &tLine.u32Boot, &tLine.u32Tick,
+               &tLine.cLevel, baText) == 5)
+    {
+        if (sscanf(baText, "line %u", &tLine.u32Line) != 1)
+            tLine.u32Line = LOG_HOST_ANY;
+
+        if (g_u32LogHostLineNum < LOG_HOST_LINE_MAX)
+            g_taLogHostLine[g_u32LogHostLineNum++] = tLine;
+    }
+}
+
+msg_print_uart1_fp_t msg_print_uart1 = _LogHost_AtPrint;
+
+int _at_cmd_buf_to_argc_argv(char *pbuf, int *argc, char *argv[], int iArgvNum)
+{
+    int iCount = 0;
+    char *p;
+
+    argv[iCount++] = strtok(pbuf, "=");
+
+    while ((iCount < iArgvNum) && ((p = strtok(NULL, ",")) != NULL))
+        argv[iCount++] = p;
+
+    *argc = iCount;
+    return 1;
+}
+
+// the log task releases its lock first after the mount
+static osStatus _LogHost_SemRelease(osSemaphoreId semaphore_id)
+{
+    if (osThreadGetId() != g_tLogHostMain)
+        g_u8LogHostMounted = 1;
+
+    return g_fpLogHostSemRelease(semaphore_id);
+}
+
+/*
+ * A boot, in the child process
+ */
+static uint8_t _LogHost_MountWait(void)
+{
+    uint32_t u32Us;
+
+    for (u32Us = 0; u32Us < LOG_HOST_WAIT_US; u32Us += 50)
+    {
+        if (g_u8LogHostMounted)
+            return 1;
+
+        HostOs_SleepUs(50);
+    }
+
+    return 0;
+}
+
+static uint32_t _LogHost_Written(void)
+{
+    T_MwLogFlashStat tStat;
+
+    MwLogFlash_StatGet(&tStat);
+    return tStat.ulWritten;
+}
+
+// 1: the task wrote u32Num records since the boot
+static uint8_t _LogHost_WrittenWait(uint32_t u32Num)
+{
+    uint32_t u32Us;
+
+    for (u32Us = 0; u32Us < LOG_HOST_WAIT_US; u32Us += 50)
+    {
+        if (_LogHost_Written() >= u32Num)
+            return 1;
+
+        HostOs_SleepUs(50);
+    }
+
+    return 0;
+}
+
+// a full line a second, under the rate of the high level; 1: written
+static uint8_t _LogHost_Put(uint32_t u32Line)
+{
+    uint32_t u32Written = _LogHost_Written();
+
+    HostOs_TimeAdvanceUs(1000 * 1000);
+    LOG_HOST_LOG(LOG_HIGH_LEVEL, "line %05u %s\n", u32Line, g_baLogHostPad);
+
+    return _LogHost_WrittenWait(u32Written + 1);
+}
+
+static uint32_t _LogHost_AtDump(void)
+{
+    char baCmd[] = "at+logflash=1";
+
+    g_u32LogHostLineNum = 0;
+    if (1 != MwLogFlash_AtCmd(baCmd, strlen(baCmd), AT_CMD_MODE_SET))
+        return LOG_HOST_ANY;
+
+    return g_u32LogHostLineNum;
+}
+
+static void _LogHost_AtStatus(void)
+{
+    char baCmd[] = "at+logflash?";
+
+    g_u8LogHostStatus = 0;
+    HOST_TEST_EQ(MwLogFlash_AtCmd(baCmd, strlen(baCmd), AT_CMD_MODE_READ), 1);
+    HOST_TEST_ASSERT(g_u8LogHostStatus);
+}
+
+static void _LogHost_Start(void)
+{
+    g_tLogHostMain = osThreadGetId();
+
+    MwLogFlash_Init();
+    HOST_TEST_ASSERT(_LogHost_MountWait());
+}
+
+// the lines of the plan: the last ones before u32First, in order, no gap
+static void _LogHost_Check(void)
+{
+    T_LogHostFlash *ptFlash = g_ptLogHostFlash;
+    T_LogHostLine *ptLine;
+    uint32_t u32Num = _LogHost_AtDump();
+    uint32_t i;
+
+    HOST_TEST_ASSERT(u32Num != LOG_HOST_ANY);
+
+    if (ptFlash->u32Expect != LOG_HOST_ANY)
+        HOST_TEST_EQ(u32Num, ptFlash->u32Expect);
+
+    if ((u32Num) && (ptFlash->u32SeqFirst))
+        HOST_TEST_EQ(g_taLogHostLine[0].u32Seq, ptFlash->u32SeqFirst);
+
+    for (i = 0; i < u32Num; i++)
+    {
+        ptLine = &g_taLogHostLine[i];
+
+        HOST_TEST_EQ(ptLine->u32Line, ptFlash->u32First - u32Num + i);
+        HOST_TEST_EQ(ptLine->cLevel, 'H');
+
+        if (i == 0)
+            continue;
+
+        HOST_TEST_ASSERT(ptLine->u32Seq > ptLine[-1].u32Seq);
+        HOST_TEST_ASSERT(ptLine->u32Tick >= ptLine[-1].u32Tick || ptLine->u32Boot != ptLine[-1].u32Boot);
+
+        if (ptLine->u32Line == ptFlash->u32BootFirst)
+            HOST_TEST_ASSERT(ptLine->u32Boot > ptLine[-1].u32Boot);
+        else
+            HOST_TEST_EQ(ptLine->u32Boot, ptLine[-1].u32Boot);
+    }
+
+    _LogHost_AtStatus();
+    HOST_TEST_EQ(g_u32aLogHostStatus[2], u32Num);
+
+    if (ptFlash->u32Torn != LOG_HOST_ANY)
+        HOST_TEST_EQ(g_u32aLogHostStatus[5], ptFlash->u32Torn);
+}
+
+// mount, check the lines found, put the lines of the plan
+static void _LogHost_BootLines(void)
+{
+    T_LogHostFlash *ptFlash = g_ptLogHostFlash;
+    uint32_t i;
+
+    _LogHost_Start();
+    if (!HostTest_Failed())
+        _LogHost_Check();
+
+    if (HostTest_Failed())
+        return;
+
+    for (i = 0; i < ptFlash->u32Put; i++)
+        HOST_TEST_ASSERT(_LogHost_Put(ptFlash->u32First + i));
+}
+
+/*
+ * The test
+ */
+static void _LogHost_FlashFill(uint8_t u8Value)
+{
+    memset(g_ptLogHostFlash->u8aMem, u8Value, LOG_HOST_FLASH_SIZE);
+    memset(g_ptLogHostFlash->u32aErase, 0, sizeof(g_ptLogHostFlash->u32aErase));
+}
+
+static void _LogHost_Plan(uint32_t u32Expect, uint32_t u32First, uint32_t u32Put)
+{
+    T_LogHostFlash *ptFlash = g_ptLogHostFlash;
+
+    ptFlash->u32Expect = u32Expect;
+    ptFlash->u32First = u32First;
+    ptFlash->u32Put = u32Put;
+    ptFlash->u32SeqFirst = 0;
+    ptFlash->u32BootFirst = LOG_HOST_ANY;
+    ptFlash->u32Torn = 0;
+    ptFlash->u32CutOp = 0;
+    ptFlash->u32CutBytes = 0;
+}
+
+// one boot in a child: the RAM and the tasks start over, the flash stays
+static int _LogHost_Boot(T_LogHostBootFp fpBoot)
+{
+    int iStatus = 0;
+    pid_t tPid;
+
+    g_ptLogHostFlash->u32Op = 0;
+    g_ptLogHostFlash->u32RecDone = 0;
+
+    fflush(stdout);
+    tPid = fork();
+
+    if (tPid == 0)
+    {
+        fpBoot();
+        fflush(stdout);
+        _exit(HostTest_Failed() ? LOG_HOST_EXIT_FAIL : LOG_HOST_EXIT_OK);
+    }
+
+    if ((tPid < 0) || (waitpid(tPid, &iStatus, 0) != tPid) || (!WIFEXITED(iStatus)))
+        return LOG_HOST_EXIT_FAIL;
+
+    return WEXITSTATUS(iStatus);
+}
+
+// lines on an erased flash, found by the next boot
+static void _LogHost_Mount(void)
+{
+    _LogHost_FlashFill(0xFF);
+
+    _LogHost_Plan(0, 0, 10);
+    HOST_TEST_EQ(_LogHost_Boot(_LogHost_BootLines), LOG_HOST_EXIT_OK);
+    HOST_TEST_EQ(g_ptLogHostFlash->u32RecDone, 10);
+
+    _LogHost_Plan(10, 10, 3);
+    g_ptLogHostFlash->u32SeqFirst = 1;
+    HOST_TEST_EQ(_LogHost_Boot(_LogHost_BootLines), LOG_HOST_EXIT_OK);
+
+    _LogHost_Plan(13, 13, 0);
+    g_ptLogHostFlash->u32BootFirst = 10;
+    HOST_TEST_EQ(_LogHost_Boot(_LogHost_BootLines), LOG_HOST_EXIT_OK);
+    HOST_TEST_EQ(g_ptLogHostFlash->u32Overwrite, 0);
+}
+
+// a power cut in every program and erase of the lines
+static void _LogHost_PowerCut(void)
+{
+    T_LogHostFlash *ptFlash = g_ptLogHostFlash;
+    uint32_t u32aSize[LOG_HOST_OP_MAX];
+    uint8_t u8aErase[LOG_HOST_OP_MAX];
+    uint32_t u32aBytes[4];
+    uint32_t u32OpNum;
+    uint32_t u32BytesNum;
+    uint32_t u32Done;
+    uint32_t u32Cut = 0;
+    uint32_t i, j;
+
+    // the flash held something else: the erases are real
+    _LogHost_FlashFill(0x00);
+    ptFlash->u32Overwrite = 0;
+
+    _LogHost_Plan(0, 0, LOG_HOST_CUT_LINES);
+    HOST_TEST_EQ(_LogHost_Boot(_LogHost_BootLines), LOG_HOST_EXIT_OK);
+    HOST_TEST_EQ(ptFlash->u32RecDone, LOG_HOST_CUT_LINES);
+
+    u32OpNum = ptFlash->u32Op;
+    HOST_TEST_ASSERT(u32OpNum <= LOG_HOST_OP_MAX);
+    memcpy(u32aSize, ptFlash->u32aOpSize, sizeof(u32aSize));
+    memcpy(u8aErase, ptFlash->u8aOpErase, sizeof(u8aErase));
+
+    for (i = 0; i < u32OpNum; i++)
+    {
+        if (u8aErase[i])
+        {
+            u32aBytes[0] = u32aSize[i] / 2;
+            u32BytesNum = 1;
+        }
+        else
+        {
+            u32aBytes[0] = 0;
+            u32aBytes[1] = 1;
+            u32aBytes[2] = u32aSize[i] / 2;
+            u32aBytes[3] = u32aSize[i] - 1;
+            u32BytesNum = 4;
+        }
+
+        for (j = 0; j < u32BytesNum; j++)
+        {
+            _LogHost_FlashFill(0x00);
+
+            _LogHost_Plan(0, 0, LOG_HOST_CUT_LINES);
+            ptFlash->u32CutOp = i + 1;
+            ptFlash->u32CutBytes = u32aBytes[j];
+            HOST_TEST_EQ(_LogHost_Boot(_LogHost_BootLines), LOG_HOST_EXIT_CUT);
+
+            // every line programmed in full is found, the log goes on after it
+            u32Done = ptFlash->u32RecDone;
+
+            _LogHost_Plan(u32Done, u32Done, LOG_HOST_MORE_LINES);
+            ptFlash->u32SeqFirst = (u32Done) ? 1 : 0;
+            ptFlash->u32Torn = LOG_HOST_ANY;
+            if (_LogHost_Boot(_LogHost_BootLines) != LOG_HOST_EXIT_OK)
+            {
+                tracer_cli(LOG_HIGH_LEVEL, "  cut in op %u (%s of %u) after %u bytes\n", i + 1,
+                           (u8aErase[i]) ? "erase" : "program", u32aSize[i], u32aBytes[j]);
+                HOST_TEST_ASSERT(0);
+            }
+
+            _LogHost_Plan(u32Done + LOG_HOST_MORE_LINES, u32Done + LOG_HOST_MORE_LINES, 0);
+            ptFlash->u32BootFirst = (u32Done) ? u32Done : LOG_HOST_ANY;
+            ptFlash->u32Torn = LOG_HOST_ANY;
+            if (_LogHost_Boot(_LogHost_BootLines) != LOG_HOST_EXIT_OK)
+            {
+                tracer_cli(LOG_HIGH_LEVEL, "  after the cut in op %u, bytes %u: the next boot\n", i + 1, u32aBytes[j]);
+                HOST_TEST_ASSERT(0);
+            }
+
+            u32Cut++;
+        }
+    }
+
+    HOST_TEST_EQ(ptFlash->u32Overwrite, 0);
+
+    tracer_cli(LOG_HIGH_LEVEL, "powercut: %u lines, %u programs and erases, %u cuts, no line lost\n",
+               LOG_HOST_CUT_LINES, u32OpNum, u32Cut);
+}
+
+// the oldest sector goes, one erase per sector used
+static void _LogHost_Rotate(void)
+{
+    T_LogHostFlash *ptFlash = g_ptLogHostFlash;
+    uint32_t u32Open = (LOG_HOST_ROTATE_LINES + LOG_HOST_SEC_LINES - 1) / LOG_HOST_SEC_LINES;
+    uint32_t u32Kept;
+    uint32_t u32Sum = 0;
+    uint32_t u32Max = 0;
+    uint32_t i;
+
+    HOST_TEST_ASSERT(u32Open > MW_LOG_FLASH_SECTOR_NUM);
+
+    _LogHost_FlashFill(0xFF);
+    ptFlash->u32Overwrite = 0;
+
+    _LogHost_Plan(0, 0, LOG_HOST_ROTATE_LINES);
+    HOST_TEST_EQ(_LogHost_Boot(_LogHost_BootLines), LOG_HOST_EXIT_OK);
+
+    // the full sectors but the one erased ahead, and the head
+    u32Kept = ((MW_LOG_FLASH_SECTOR_NUM - 2) * LOG_HOST_SEC_LINES) +
+              (LOG_HOST_ROTATE_LINES - ((u32Open - 1) * LOG_HOST_SEC_LINES));
+
+    for (i = 0; i < MW_LOG_FLASH_SECTOR_NUM; i++)
+    {
+        u32Sum += ptFlash->u32aErase[i];
+        if (ptFlash->u32aErase[i] > u32Max)
+            u32Max = ptFlash->u32aErase[i];
+    }
+
+    // the first sector, then the one ahead of each sector opened
+    HOST_TEST_EQ(u32Sum, u32Open + 1);
+    HOST_TEST_EQ(u32Max, (u32Open + MW_LOG_FLASH_SECTOR_NUM - 1) / MW_LOG_FLASH_SECTOR_NUM);
+
+    _LogHost_Plan(u32Kept, LOG_HOST_ROTATE_LINES, 0);
+    HOST_TEST_EQ(_LogHost_Boot(_LogHost_BootLines), LOG_HOST_EXIT_OK);
+    HOST_TEST_EQ(ptFlash->u32Overwrite, 0);
+
+    tracer_cli(LOG_HIGH_LEVEL, "wear: %u lines, %u sectors opened, %u erases, at most %u per sector, %u lines kept\n",
+               LOG_HOST_ROTATE_LINES, u32Open, u32Sum, u32Max, u32Kept);
+}
+
+static void _LogHost_BootRate(void)
+{
+    T_MwLogFlashStat tStat;
+    char baLevel[] = "logflash level 7";
+    char baOff[] = "logflash off";
+    uint32_t i;
+
+    _LogHost_Start();
+
+    // the default levels at their bursts
+    for (i = 0; i < 40; i++)
+        LOG_HOST_LOG(LOG_HIGH_LEVEL, "high %02u\n", i);
+    HOST_TEST_ASSERT(_LogHost_WrittenWait(32));
+
+    for (i = 0; i < 20; i++)
+        LOG_HOST_LOG(LOG_MED_LEVEL, "med %02u\n", i);
+    HOST_TEST_ASSERT(_LogHost_WrittenWait(32 + 16));
+
+    for (i = 0; i < 5; i++)
+        LOG_HOST_LOG(LOG_LOW_LEVEL, "low %02u\n", i);
+
+    MwLogFlash_StatGet(&tStat);
+    HOST_TEST_EQ(tStat.ulDropRate, 8 + 4);
+
+    // the low level kept too
+    MwLogFlash_Cmd(baLevel);
+    for (i = 0; i < 10; i++)
+        LOG_HOST_LOG(LOG_LOW_LEVEL, "low %02u\n", i);
+    HOST_TEST_ASSERT(_LogHost_WrittenWait(32 + 16 + 8));
+
+    // 10s refill 2 lines a second of the high level
+    HostOs_TimeAdvanceUs(10 * 1000 * 1000);
+    for (i = 0; i < 25; i++)
+        LOG_HOST_LOG(LOG_HIGH_LEVEL, "high %02u\n", i);
+    HOST_TEST_ASSERT(_LogHost_WrittenWait(32 + 16 + 8 + 20));
+
+    MwLogFlash_Cmd(baOff);
+    for (i = 0; i < 5; i++)
+        LOG_HOST_LOG(LOG_HIGH_LEVEL, "high %02u\n", i);
+
+    MwLogFlash_StatGet(&tStat);
+    HOST_TEST_EQ(tStat.ulWritten, 32 + 16 + 8 + 20);
+    HOST_TEST_EQ(tStat.ulDropRate, 8 + 4 + 2 + 5);
+    HOST_TEST_EQ(tStat.ulDropFull, 0);
+    HOST_TEST_EQ(_LogHost_AtDump(), tStat.ulWritten);
+}
+
+// the levels and the rate of each
+static void _LogHost_Rate(void)
+{
+    _LogHost_FlashFill(0xFF);
+
+    HOST_TEST_EQ(_LogHost_Boot(_LogHost_BootRate), LOG_HOST_EXIT_OK);
+}
+
+static void _LogHost_BootErase(void)
+{
+    char baCmd[] = "at+logflash=0";
+    uint32_t i;
+
+    _LogHost_Start();
+
+    for (i = 0; i < 5; i++)
+        HOST_TEST_ASSERT(_LogHost_Put(i));
+
+    HOST_TEST_EQ(MwLogFlash_AtCmd(baCmd, strlen(baCmd), AT_CMD_MODE_SET), 1);
+    HOST_TEST_EQ(_LogHost_AtDump(), 0);
+
+    for (i = 5; i < 8; i++)
+        HOST_TEST_ASSERT(_LogHost_Put(i));
+}
+
+// the lines are erased, the sequence goes on
+static void _LogHost_Erase(void)
+{
+    _LogHost_FlashFill(0xFF);
+
+    HOST_TEST_EQ(_LogHost_Boot(_LogHost_BootErase), LOG_HOST_EXIT_OK);
+
+    _LogHost_Plan(3, 8, 0);
+    g_ptLogHostFlash->u32SeqFirst = 6;
+    HOST_TEST_EQ(_LogHost_Boot(_LogHost_BootLines), LOG_HOST_EXIT_OK);
+}
+
+static void _LogHost_BootCmd(void)
+{
+    char baDump[] = "logflash dump 3";
+    char baStatus[] = "logflash";
+    char baBad[] = "logflash x";
+    char baCut[] = "logflash cut 20";
+    uint32_t u32Tracer;
+    uint32_t i;
+
+    _LogHost_Start();
+
+    for (i = 0; i < 10; i++)
+        HOST_TEST_ASSERT(_LogHost_Put(i));
+
+    // the dump is printed, not logged again
+    u32Tracer = g_u32LogHostTracer;
+    HOST_TEST_EQ(MwLogFlash_Dump(3, MW_LOG_FLASH_OUT_CLI), 3);
+    MwLogFlash_Cmd(baDump);
+    MwLogFlash_Cmd(baStatus);
+    MwLogFlash_Cmd(baBad);
+    HOST_TEST_EQ(g_u32LogHostTracer, u32Tracer);
+    HOST_TEST_EQ(_LogHost_Written(), 10);
+
+    // the next program stops after 20 bytes and resets
+    MwLogFlash_Cmd(baCut);
+    _LogHost_Put(10);
+
+    HOST_TEST_ASSERT(0);
+}
+
+// the diag command, and the cut of the log itself
+static void _LogHost_Cmd(void)
+{
+    _LogHost_FlashFill(0xFF);
+
+    HOST_TEST_EQ(_LogHost_Boot(_LogHost_BootCmd), LOG_HOST_EXIT_CUT);
+
+    // the cut record closes its sector
+    _LogHost_Plan(10, 10, 2);
+    g_ptLogHostFlash->u32Torn = 1;
+    HOST_TEST_EQ(_LogHost_Boot(_LogHost_BootLines), LOG_HOST_EXIT_OK);
+
+    // an older sector is not the head, the mount does not count it
+    _LogHost_Plan(12, 12, 0);
+    g_ptLogHostFlash->u32BootFirst = 10;
+    HOST_TEST_EQ(_LogHost_Boot(_LogHost_BootLines), LOG_HOST_EXIT_OK);
+}
+
+static const T_HostTestCase g_taLogHostCase[] =
+{
+    HOST_TEST_CASE(_LogHost_Mount),
+    HOST_TEST_CASE(_LogHost_PowerCut),
+    HOST_TEST_CASE(_LogHost_Rotate),
+    HOST_TEST_CASE(_LogHost_Rate),
+    HOST_TEST_CASE(_LogHost_Erase),
+    HOST_TEST_CASE(_LogHost_Cmd),
+};
+
+// the task writes as soon as it is woken
+static osStatus _LogHost_Delay(uint32_t millisec)
+{
+    return osOK;
+}
+
+int main(void)
+{
+    HostOs_Init();
+
+    // the lines carry the simulated time only
+    HostOs_TimeFreeze(1);
+
+    g_ptLogHostFlash = mmap(NULL, sizeof(T_LogHostFlash), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (g_ptLogHostFlash == MAP_FAILED)
+        return 1;
+
+    memset(g_baLogHostPad, 'x', LOG_HOST_PAD_LEN);
+
+    tracer_msg = _LogHost_TracerMsg;
+    osDelay = _LogHost_Delay;
+    g_fpLogHostSemRelease = osSemaphoreRelease;
+    osSemaphoreRelease = _LogHost_SemRelease;
+
+    return HostTest_Run("mw_log_flash", g_taLogHostCase, HOST_TEST_NUM(g_taLogHostCase));
+}
@@ -0,0 +1,640 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_boot_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The boot sequencer of sys_boot.c on a simulation of the init graph.
+*
+*  The step table has the steps, flags and dependencies of g_taSysBootStep
+*  in sys_init_patch.c; each step only moves the simulated time by its
+*  mocked duration and checks that its dependencies are done, that the M0
+*  is up if it needs it and that it runs once. The M0 sets the ready flag
+*  of SPARE_0 and raises IPC0 at a scripted time, and __WFI() sleeps until
+*  then, or for BOOT_HOST_WAKE_US when another interrupt would end it.
+*
+*  Sys_DriverInit and Sys_ServiceInit are replayed around the steps, and
+*  the time to the application is checked against the serial boot, which
+*  waited for the M0 at the end of the driver init.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <string.h>
+#include "cmsis_os.h"
+#include "hal_system.h"
+#include "sys_init.h"
+#include "sys_boot.h"
+#include "host_os.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define BOOT_HOST_M0_READY_MSK      (1 << 4)
+
+#define BOOT_HOST_DRIVER_US         5000        // Sys_DriverInit up to the steps
+#define BOOT_HOST_APP_US            3000
+#define BOOT_HOST_WAKE_US           100000      // another interrupt ends the sleep
+
+#define BOOT_HOST_STEP_FUNC(idx)    static void _BootHost_Step##idx(void) { _BootHost_Step(idx); }
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+// the index of g_taSysBootStep
+typedef enum
+{
+    BOOT_HOST_DBG_UART = 0,
+    BOOT_HOST_UART1,
+    BOOT_HOST_MISC_CFG,
+    BOOT_HOST_PS,
+    BOOT_HOST_WDT,
+    BOOT_HOST_VERSION,
+    BOOT_HOST_DIAG,
+    BOOT_HOST_AT,
+    BOOT_HOST_WIFI_MAC,
+    BOOT_HOST_LWIP,
+    BOOT_HOST_SCRT,
+    BOOT_HOST_SUPPLICANT,
+    BOOT_HOST_CONTROLLER,
+    BOOT_HOST_IPC,
+    BOOT_HOST_LE,
+    BOOT_HOST_AUTO_CONN,
+    BOOT_HOST_STA_INFO,
+    BOOT_HOST_SCAN_CACHE,
+    BOOT_HOST_AGENT,
+    BOOT_HOST_TRACER,
+    BOOT_HOST_OTA,
+    BOOT_HOST_FLASH_SVC,
+    BOOT_HOST_STACK,
+    BOOT_HOST_WDT_SVC,
+    BOOT_HOST_LOG_FLASH,
+    BOOT_HOST_FS,
+
+    BOOT_HOST_STEP_NUM
+} E_BootHostStep_t;
+
+typedef struct
+{
+    uint64_t u64Base;               // the "clock" mark
+    uint64_t u64M0At;               // the M0 is up, 0: not scheduled
+    uint8_t u8M0Raised;
+    uint32_t u32Spare;              // SPARE_0
+    uint8_t u8Kernel;
+
+    uint32_t u32Done;               // SYS_BOOT_DEP() of the steps run
+    uint32_t u32Order;              // dependency, M0 or run twice errors
+    uint32_t u32Num;                // steps run
+    uint64_t u64aEnd[BOOT_HOST_STEP_NUM];
+    uint8_t u8App;
+    uint64_t u64App;                // the application init starts
+
+    uint32_t u32Wfi;
+    uint32_t u32Ipc0;
+} T_BootHost;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+T_Hal_Sys_SpareRegRead Hal_Sys_SpareRegRead;
+T_Hal_Sys_SpareRegWrite Hal_Sys_SpareRegWrite;
+T_Sys_AppInit_fp Sys_AppInit;
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_BootHost g_tBootHost;
+
+static os_ptimer g_fpBootHostTimer;
+static uint32_t g_u32BootHostTimerMs;
+
+// the mocked durations
+static const uint32_t g_u32aBootHostUs[BOOT_HOST_STEP_NUM] =
+{
+    1000, 2000, 1000, 3000, 1000,                   // dbg_uart .. wdt
+    1000, 2000, 3000, 4000, 5000, 2000,             // version .. scrt
+    6000, 3000, 2000, 8000, 1000, 1000,             // supplicant .. sta_info
+    1000, 2000, 2000, 2000,                         // scan_cache .. ota
+    3000, 1000, 1000, 2000, 4000                    // the deferred ones
+};
+
+// Sec 7: declaration of static function prototype
+static void _BootHost_Step(uint32_t u32Idx);
+
+/***********************************************************************
+*  Sec 8: C Functions
+***********************************************************************/
+
+/*
+ * The M0, IPC0 and the core
+ */
+static uint64_t _BootHost_Now(void)
+{
+    return HostOs_TimeUs() - g_tBootHost.u64Base;
+}
+
+static void _BootHost_Ipc0(void *pArg)
+{
+    // IPC0_IRQHandler_Entry_patch
+    g_tBootHost.u32Ipc0++;
+    Sys_BootM0Isr();
+}
+
+// the M0 comes up once its time is reached
+static void _BootHost_M0Tick(void)
+{
+    uint32_t u32Pm = HostOs_IrqSave();
+
+    if ((g_tBootHost.u64M0At) && (!g_tBootHost.u8M0Raised) && (HostOs_TimeUs() >= g_tBootHost.u64M0At))
+    {
+        g_tBootHost.u8M0Raised = 1;
+        g_tBootHost.u32Spare |= BOOT_HOST_M0_READY_MSK;
+        HostOs_IsrRun(_BootHost_Ipc0, NULL);
+    }
+
+    HostOs_IrqSet(u32Pm);
+}
+
+static uint32_t _BootHost_SpareRead(E_SpareRegIdx_t eSpareIdx, uint32_t *pu32Data)
+{
+    _BootHost_M0Tick();
+    *pu32Data = (eSpareIdx == SPARE_0) ? g_tBootHost.u32Spare : 0;
+    return 0;
+}
+
+static uint32_t _BootHost_SpareWrite(E_SpareRegIdx_t eSpareIdx, uint32_t u32Data)
+{
+    if (eSpareIdx == SPARE_0)
+        g_tBootHost.u32Spare = u32Data;
+    return 0;
+}
+
+// the sleep ends at the M0 interrupt, or at another one before it
+static void _BootHost_Wfi(void)
+{
+    uint64_t u64Now = HostOs_TimeUs();
+    uint64_t u64Us = BOOT_HOST_WAKE_US;
+
+    g_tBootHost.u32Wfi++;
+
+    if ((g_tBootHost.u64M0At) && (!g_tBootHost.u8M0Raised) && (g_tBootHost.u64M0At - u64Now < u64Us))
+        u64Us = (g_tBootHost.u64M0At > u64Now) ? (g_tBootHost.u64M0At - u64Now) : 0;
+
+    HostOs_TimeAdvanceUs((uint32_t)u64Us);
+    _BootHost_M0Tick();
+}
+
+static int32_t _BootHost_KernelRunning(void)
+{
+    return g_tBootHost.u8Kernel;
+}
+
+static osTimerId _BootHost_TimerCreate(const osTimerDef_t *timer_def, os_timer_type type, void *argument)
+{
+    g_fpBootHostTimer = timer_def->ptimer;
+    return (osTimerId)&g_fpBootHostTimer;
+}
+
+static osStatus _BootHost_TimerStart(osTimerId timer_id, uint32_t millisec)
+{
+    g_u32BootHostTimerMs = millisec;
+    return osOK;
+}
+
+/*
+ * The init graph of sys_init_patch.c
+ */
+BOOT_HOST_STEP_FUNC(0)  BOOT_HOST_STEP_FUNC(1)  BOOT_HOST_STEP_FUNC(2)  BOOT_HOST_STEP_FUNC(3)
+BOOT_HOST_STEP_FUNC(4)  BOOT_HOST_STEP_FUNC(5)  BOOT_HOST_STEP_FUNC(6)  BOOT_HOST_STEP_FUNC(7)
+BOOT_HOST_STEP_FUNC(8)  BOOT_HOST_STEP_FUNC(9)  BOOT_HOST_STEP_FUNC(10) BOOT_HOST_STEP_FUNC(11)
+BOOT_HOST_STEP_FUNC(12) BOOT_HOST_STEP_FUNC(13) BOOT_HOST_STEP_FUNC(14) BOOT_HOST_STEP_FUNC(15)
+BOOT_HOST_STEP_FUNC(16) BOOT_HOST_STEP_FUNC(17) BOOT_HOST_STEP_FUNC(18) BOOT_HOST_STEP_FUNC(19)
+BOOT_HOST_STEP_FUNC(20) BOOT_HOST_STEP_FUNC(21) BOOT_HOST_STEP_FUNC(22) BOOT_HOST_STEP_FUNC(23)
+BOOT_HOST_STEP_FUNC(24) BOOT_HOST_STEP_FUNC(25)
+
+static const S_SysBootStep_t g_taBootHostStep[BOOT_HOST_STEP_NUM] =
+{
+    { "dbg_uart",   _BootHost_Step0,    SYS_BOOT_STAGE_DRIVER,  0,                      0 },
+    { "uart1",      _BootHost_Step1,    SYS_BOOT_STAGE_DRIVER,  SYS_BOOT_FLAG_M0,       0 },
+    { "misc_cfg",   _BootHost_Step2,    SYS_BOOT_STAGE_DRIVER,  SYS_BOOT_FLAG_M0,       0 },
+    { "ps",         _BootHost_Step3,    SYS_BOOT_STAGE_DRIVER,  SYS_BOOT_FLAG_M0,       SYS_BOOT_DEP(BOOT_HOST_UART1) | SYS_BOOT_DEP(BOOT_HOST_MISC_CFG) },
+    { "wdt",        _BootHost_Step4,    SYS_BOOT_STAGE_DRIVER,  0,                      0 },
+    { "version",    _BootHost_Step5,    SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "diag",       _BootHost_Step6,    SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "at",         _BootHost_Step7,    SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "wifi_mac",   _BootHost_Step8,    SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "lwip",       _BootHost_Step9,    SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "scrt",       _BootHost_Step10,   SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "supplicant", _BootHost_Step11,   SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_M0,       SYS_BOOT_DEP(BOOT_HOST_WIFI_MAC) | SYS_BOOT_DEP(BOOT_HOST_LWIP) },
+    { "controller", _BootHost_Step12,   SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_M0,       SYS_BOOT_DEP(BOOT_HOST_PS) },
+    { "ipc",        _BootHost_Step13,   SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_M0,       SYS_BOOT_DEP(BOOT_HOST_PS) },
+    { "le",         _BootHost_Step14,   SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_M0,       SYS_BOOT_DEP(BOOT_HOST_UART1) | SYS_BOOT_DEP(BOOT_HOST_IPC) },
+    { "auto_conn",  _BootHost_Step15,   SYS_BOOT_STAGE_SERVICE, 0,                      SYS_BOOT_DEP(BOOT_HOST_SUPPLICANT) },
+    { "sta_info",   _BootHost_Step16,   SYS_BOOT_STAGE_SERVICE, 0,                      SYS_BOOT_DEP(BOOT_HOST_SUPPLICANT) },
+    { "scan_cache", _BootHost_Step17,   SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "agent",      _BootHost_Step18,   SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_M0,       SYS_BOOT_DEP(BOOT_HOST_IPC) },
+    { "tracer",     _BootHost_Step19,   SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "ota",        _BootHost_Step20,   SYS_BOOT_STAGE_SERVICE, 0,                      0 },
+    { "flash_svc",  _BootHost_Step21,   SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_DEFER,    SYS_BOOT_DEP(BOOT_HOST_OTA) },
+    { "stack",      _BootHost_Step22,   SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_DEFER,    0 },
+    { "wdt_svc",    _BootHost_Step23,   SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_DEFER,    SYS_BOOT_DEP(BOOT_HOST_LWIP) | SYS_BOOT_DEP(BOOT_HOST_SUPPLICANT) },
+    { "log_flash",  _BootHost_Step24,   SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_DEFER,    SYS_BOOT_DEP(BOOT_HOST_FLASH_SVC) },
+    { "fs",         _BootHost_Step25,   SYS_BOOT_STAGE_SERVICE, SYS_BOOT_FLAG_DEFER,    SYS_BOOT_DEP(BOOT_HOST_FLASH_SVC) },
+};
+
+static void _BootHost_Step(uint32_t u32Idx)
+{
+    const S_SysBootStep_t *ptStep = &g_taBootHostStep[u32Idx];
+
+    if (ptStep->u32Deps & ~g_tBootHost.u32Done)
+    {
+        printf("  %s before its dependencies\n", ptStep->sName);
+        g_tBootHost.u32Order++;
+    }
+
+    if ((ptStep->u8Flag & SYS_BOOT_FLAG_M0) && !(g_tBootHost.u8M0Raised))
+    {
+        printf("  %s before the M0\n", ptStep->sName);
+        g_tBootHost.u32Order++;
+    }
+
+    if ((ptStep->u8Flag & SYS_BOOT_FLAG_DEFER) && !(g_tBootHost.u8App))
+    {
+        printf("  %s deferred but before the application\n", ptStep->sName);
+        g_tBootHost.u32Order++;
+    }
+
+    if (g_tBootHost.u32Done & SYS_BOOT_DEP(u32Idx))
+    {
+        printf("  %s twice\n", ptStep->sName);
+        g_tBootHost.u32Order++;
+    }
+
+    HostOs_TimeAdvanceUs(g_u32aBootHostUs[u32Idx]);
+
+    g_tBootHost.u32Done |= SYS_BOOT_DEP(u32Idx);
+    g_tBootHost.u64aEnd[u32Idx] = _BootHost_Now();
+    g_tBootHost.u32Num++;
+}
+
+static void _BootHost_App(void)
+{
+    g_tBootHost.u64App = _BootHost_Now();
+    g_tBootHost.u8App = 1;
+
+    HostOs_TimeAdvanceUs(BOOT_HOST_APP_US);
+}
+
+// the SYS_BOOT_DEP() of the steps that match
+static uint32_t _BootHost_Mask(uint8_t u8Flag, uint8_t u8Set)
+{
+    uint32_t u32Mask = 0;
+    uint32_t i;
+
+    for (i = 0; i < BOOT_HOST_STEP_NUM; i++)
+    {
+        if (((g_taBootHostStep[i].u8Flag & u8Flag) != 0) == (u8Set != 0))
+            u32Mask |= SYS_BOOT_DEP(i);
+    }
+
+    return u32Mask;
+}
+
+static uint32_t _BootHost_Us(uint32_t u32Mask)
+{
+    uint32_t u32Us = 0;
+    uint32_t i;
+
+    for (i = 0; i < BOOT_HOST_STEP_NUM; i++)
+    {
+        if (u32Mask & SYS_BOOT_DEP(i))
+            u32Us += g_u32aBootHostUs[i];
+    }
+
+    return u32Us;
+}
+
+/*
+ * The simulation
+ */
+// the time of a boot is the simulated time only, the scheduler of the host
+// adds nothing to it
+static void _BootHost_Begin(uint32_t u32M0Us)
+{
+    memset(&g_tBootHost, 0, sizeof(g_tBootHost));
+
+    HostOs_TimeFreeze(1);
+
+    HostOs_WfiHookSet(_BootHost_Wfi);
+    osKernelRunning = _BootHost_KernelRunning;
+    Sys_AppInit = _BootHost_App;
+
+    HOST_TEST_EQ(Sys_BootInit(g_taBootHostStep, BOOT_HOST_STEP_NUM), 0);
+
+    g_tBootHost.u64Base = HostOs_TimeUs();
+    g_tBootHost.u64M0At = g_tBootHost.u64Base + u32M0Us;
+}
+
+// Sys_DriverInit_patch, Sys_ServiceInit_patch and Main_AppRun
+static void _BootHost_Boot(uint8_t u8Warm)
+{
+    Sys_BootMark("clock");
+    HostOs_TimeAdvanceUs(BOOT_HOST_DRIVER_US);
+    Sys_BootMark("driver");
+    Sys_BootRun(SYS_BOOT_STAGE_DRIVER, u8Warm);
+
+    if (u8Warm)
+        return;
+
+    Sys_BootMark("service");
+    Sys_BootRun(SYS_BOOT_STAGE_SERVICE, 1);
+    Sys_BootAppHook();
+
+    Sys_AppInit();
+}
+
+static void _BootHost_End(void)
+{
+    HostOs_TimeFreeze(0);
+    HostOs_WfiHookSet(NULL);
+    g_tBootHost.u64M0At = 0;
+}
+
+// the M0 is up after the M3-only work is done: the wait is the only idle time
+static void _BootHost_Cold(void)
+{
+    uint32_t u32M0Us = 40000;
+    uint32_t u32Free = _BootHost_Mask(SYS_BOOT_FLAG_DEFER, 0) & ~_BootHost_Mask(SYS_BOOT_FLAG_M0, 1);
+    uint32_t u32Late = 0;
+    uint32_t u32App;
+    uint32_t u32Serial;
+    uint32_t i;
+
+    _BootHost_Begin(u32M0Us);
+    _BootHost_Boot(0);
+
+    HOST_TEST_EQ(g_tBootHost.u32Order, 0);
+    HOST_TEST_ASSERT(g_tBootHost.u8App);
+    HOST_TEST_EQ(g_tBootHost.u32Done, _BootHost_Mask(SYS_BOOT_FLAG_DEFER, 0));
+    HOST_TEST_EQ(g_tBootHost.u32Ipc0, 1);
+    HOST_TEST_ASSERT(g_tBootHost.u32Wfi >= 1);
+
+    // the steps needing the M0, and the ones after them, are what is left
+    // after the wait
+    for (i = 0; i < BOOT_HOST_STEP_NUM; i++)
+    {
+        if ((u32Free & SYS_BOOT_DEP(i)) && (g_taBootHostStep[i].u32Deps & ~u32Free))
+            u32Free &= ~SYS_BOOT_DEP(i);
+    }
+
+    u32Late = _BootHost_Mask(SYS_BOOT_FLAG_DEFER, 0) & ~u32Free;
+    HOST_TEST_ASSERT(BOOT_HOST_DRIVER_US + _BootHost_Us(u32Free) < u32M0Us);
+
+    u32App = u32M0Us + _BootHost_Us(u32Late);
+    u32Serial = u32M0Us + _BootHost_Us(_BootHost_Mask(SYS_BOOT_FLAG_DEFER, 0));
+
+    printf("  cold: app at %u us, serial %u us, M0 at %u us\n", (uint32_t)g_tBootHost.u64App, u32Serial, u32M0Us);
+    HOST_TEST_EQ(g_tBootHost.u64App, u32App);
+    HOST_TEST_ASSERT(g_tBootHost.u64App + _BootHost_Us(u32Free) <= u32Serial);
+
+    // the deferred steps when the timer fires
+    HOST_TEST_ASSERT(g_fpBootHostTimer != NULL);
+    HOST_TEST_EQ(g_u32BootHostTimerMs, SYS_BOOT_DEFER_MS);
+    g_fpBootHostTimer(NULL);
+
+    HOST_TEST_EQ(g_tBootHost.u32Order, 0);
+    HOST_TEST_EQ(g_tBootHost.u32Done, SYS_BOOT_DEP(BOOT_HOST_STEP_NUM) - 1);
+    HOST_TEST_EQ(g_tBootHost.u32Num, BOOT_HOST_STEP_NUM);
+
+    _BootHost_End();
+}
+
+// the M0 is up while the M3 is busy: no idle time, nothing to wait for
+static void _BootHost_Fast(void)
+{
+    uint32_t u32M0Us = 20000;
+    uint32_t u32App = BOOT_HOST_DRIVER_US + _BootHost_Us(_BootHost_Mask(SYS_BOOT_FLAG_DEFER, 0));
+    uint32_t u32Serial = u32M0Us + _BootHost_Us(_BootHost_Mask(SYS_BOOT_FLAG_DEFER, 0));
+
+    _BootHost_Begin(u32M0Us);
+    _BootHost_Boot(0);
+
+    printf("  fast: app at %u us, serial %u us, M0 at %u us\n", (uint32_t)g_tBootHost.u64App, u32Serial, u32M0Us);
+    HOST_TEST_EQ(g_tBootHost.u32Order, 0);
+    HOST_TEST_EQ(g_tBootHost.u32Wfi, 0);
+    HOST_TEST_EQ(g_tBootHost.u32Ipc0, 1);
+    HOST_TEST_EQ(g_tBootHost.u64App, u32App);
+
+    // the steps needing the M0 start after its flag is seen
+    HOST_TEST_ASSERT(g_tBootHost.u64aEnd[BOOT_HOST_UART1] - g_u32aBootHostUs[BOOT_HOST_UART1] >= u32M0Us);
+
+    g_fpBootHostTimer(NULL);
+    HOST_TEST_EQ(g_tBootHost.u32Order, 0);
+
+    _BootHost_End();
+}
+
+// the M0 is late: the core wakes up for other interrupts and sleeps again
+static void _BootHost_Late(void)
+{
+    uint32_t u32M0Us = 6 * BOOT_HOST_WAKE_US - 30000;
+
+    _BootHost_Begin(u32M0Us);
+    _BootHost_Boot(0);
+
+    printf("  late: app at %u us, %u wakeups\n", (uint32_t)g_tBootHost.u64App, g_tBootHost.u32Wfi);
+    HOST_TEST_EQ(g_tBootHost.u32Order, 0);
+    HOST_TEST_EQ(g_tBootHost.u32Wfi, 6);
+    HOST_TEST_EQ(g_tBootHost.u32Ipc0, 1);
+    HOST_TEST_ASSERT(g_tBootHost.u64App >= u32M0Us);
+    HOST_TEST_ASSERT(g_tBootHost.u64App < 6 * BOOT_HOST_WAKE_US);
+
+    g_fpBootHostTimer(NULL);
+    _BootHost_End();
+}
+
+// a warm boot runs the driver stage only, and waits for the M0 in it
+static void _BootHost_Warm(void)
+{
+    uint32_t u32Driver = 0;
+    uint32_t i;
+
+    for (i = 0; i < BOOT_HOST_STEP_NUM; i++)
+    {
+        if (g_taBootHostStep[i].u8Stage == SYS_BOOT_STAGE_DRIVER)
+            u32Driver |= SYS_BOOT_DEP(i);
+    }
+
+    // the last boot left the semaphore given
+    Sys_BootM0Isr();
+
+    _BootHost_Begin(30000);
+    _BootHost_Boot(1);
+
+    HOST_TEST_EQ(g_tBootHost.u32Order, 0);
+    HOST_TEST_EQ(g_tBootHost.u32Done, u32Driver);
+    HOST_TEST_ASSERT(!g_tBootHost.u8App);
+    HOST_TEST_ASSERT(g_tBootHost.u32Wfi >= 1);
+    HOST_TEST_EQ(g_tBootHost.u32Ipc0, 1);
+    HOST_TEST_ASSERT(g_tBootHost.u64aEnd[BOOT_HOST_PS] >= 30000);
+
+    _BootHost_End();
+}
+
+// once the kernel runs, the wait blocks on the semaphore of IPC0
+static void _BootHost_M0Thread(void *argu)
+{
+    HostOs_SleepUs(20000);
+
+    g_tBootHost.u64M0At = HostOs_TimeUs();
+    _BootHost_M0Tick();
+}
+
+static void _BootHost_Kernel(void)
+{
+    osThreadDef_t tDef;
+    uint64_t u64Start;
+
+    _BootHost_Begin(0);
+    g_tBootHost.u64M0At = 0;
+    g_tBootHost.u8Kernel = 1;
+
+    // a real thread and a real semaphore: the real time runs
+    HostOs_TimeFreeze(0);
+
+    Sys_BootMark("clock");
+
+    // the M0 thread counts from its creation, take the start before it
+    u64Start = HostOs_TimeUs();
+
+    memset(&tDef, 0, sizeof(tDef));
+    tDef.name = "m0";
+    tDef.pthread = _BootHost_M0Thread;
+    HOST_TEST_ASSERT(osThreadCreate(&tDef, NULL) != NULL);
+
+    Sys_BootM0Wait();
+
+    HOST_TEST_ASSERT(Sys_BootM0Poll());
+    HOST_TEST_EQ(g_tBootHost.u32Ipc0, 1);
+    HOST_TEST_EQ(g_tBootHost.u32Wfi, 0);
+    HOST_TEST_ASSERT(HostOs_TimeUs() - u64Start >= 20000);
+    // woken by the handler, not the timeout of SYS_BOOT_M0_WARN_MS
+    HOST_TEST_ASSERT(HostOs_TimeUs() - u64Start < SYS_BOOT_M0_WARN_MS * 1000 / 2);
+
+    // the flag is cleared for the next boot
+    HOST_TEST_EQ(g_tBootHost.u32Spare & BOOT_HOST_M0_READY_MSK, 0);
+
+    g_tBootHost.u8Kernel = 0;
+    _BootHost_End();
+}
+
+// a deferred step used early brings its deferred dependencies along
+static void _BootHost_Use(void)
+{
+    char baUse[] = "boot use fs";
+    char baBad[] = "boot use none";
+    char baDump[] = "boot";
+
+    _BootHost_Begin(10000);
+    _BootHost_Boot(0);
+
+    Sys_BootCmd(baUse);
+    HOST_TEST_EQ(g_tBootHost.u32Order, 0);
+    HOST_TEST_ASSERT(g_tBootHost.u32Done & SYS_BOOT_DEP(BOOT_HOST_FS));
+    HOST_TEST_ASSERT(g_tBootHost.u32Done & SYS_BOOT_DEP(BOOT_HOST_FLASH_SVC));
+    HOST_TEST_ASSERT(!(g_tBootHost.u32Done & SYS_BOOT_DEP(BOOT_HOST_LOG_FLASH)));
+
+    // once
+    HOST_TEST_EQ(Sys_BootUse("flash_svc"), 0);
+    HOST_TEST_EQ(Sys_BootUse("none"), -1);
+    Sys_BootCmd(baBad);
+
+    // the timer runs the rest
+    g_fpBootHostTimer(NULL);
+    HOST_TEST_EQ(g_tBootHost.u32Order, 0);
+    HOST_TEST_EQ(g_tBootHost.u32Done, SYS_BOOT_DEP(BOOT_HOST_STEP_NUM) - 1);
+
+    Sys_BootCmd(baDump);
+    _BootHost_End();
+}
+
+// the tables Sys_BootInit turns down
+static void _BootHost_Table(void)
+{
+    S_SysBootStep_t taStep[BOOT_HOST_STEP_NUM];
+
+    memcpy(taStep, g_taBootHostStep, sizeof(taStep));
+    HOST_TEST_EQ(Sys_BootInit(taStep, BOOT_HOST_STEP_NUM), 0);
+
+    // on a later step
+    taStep[BOOT_HOST_PS].u32Deps |= SYS_BOOT_DEP(BOOT_HOST_LE);
+    HOST_TEST_EQ(Sys_BootInit(taStep, BOOT_HOST_STEP_NUM), -1);
+    taStep[BOOT_HOST_PS] = g_taBootHostStep[BOOT_HOST_PS];
+
+    // on itself
+    taStep[BOOT_HOST_IPC].u32Deps |= SYS_BOOT_DEP(BOOT_HOST_IPC);
+    HOST_TEST_EQ(Sys_BootInit(taStep, BOOT_HOST_STEP_NUM), -1);
+    taStep[BOOT_HOST_IPC] = g_taBootHostStep[BOOT_HOST_IPC];
+
+    // a step at boot on a deferred one
+    taStep[BOOT_HOST_STACK].u8Flag = 0;
+    taStep[BOOT_HOST_STACK].u32Deps = SYS_BOOT_DEP(BOOT_HOST_FLASH_SVC);
+    HOST_TEST_EQ(Sys_BootInit(taStep, BOOT_HOST_STEP_NUM), -1);
+    taStep[BOOT_HOST_STACK] = g_taBootHostStep[BOOT_HOST_STACK];
+
+    // deferred in the driver stage
+    taStep[BOOT_HOST_WDT].u8Flag = SYS_BOOT_FLAG_DEFER;
+    HOST_TEST_EQ(Sys_BootInit(taStep, BOOT_HOST_STEP_NUM), -1);
+    taStep[BOOT_HOST_WDT] = g_taBootHostStep[BOOT_HOST_WDT];
+
+    HOST_TEST_EQ(Sys_BootInit(taStep, BOOT_HOST_STEP_NUM), 0);
+}
+
+static const T_HostTestCase g_taBootHostCase[] =
+{
+    HOST_TEST_CASE(_BootHost_Table),
+    HOST_TEST_CASE(_BootHost_Cold),
+    HOST_TEST_CASE(_BootHost_Fast),
+    HOST_TEST_CASE(_BootHost_Late),
+    HOST_TEST_CASE(_BootHost_Warm),
+    HOST_TEST_CASE(_BootHost_Kernel),
+    HOST_TEST_CASE(_BootHost_Use),
+};
+
+int main(void)
+{
+    HostOs_Init();
+
+    Hal_Sys_SpareRegRead = _BootHost_SpareRead;
+    Hal_Sys_SpareRegWrite = _BootHost_SpareWrite;
+    osTimerCreate = _BootHost_TimerCreate;
+    osTimerStart = _BootHost_TimerStart;
+
+    return HostTest_Run("sys_boot", g_taBootHostCase, HOST_TEST_NUM(g_taBootHostCase));
+}
@@ -0,0 +1,656 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_cpu_stat_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The CPU accounting of sys_cpu_stat.c on a simulated core running scripted
+*  task workloads.
+*
+*  The simulator owns the clock: DWT->CYCCNT only moves when a task, PendSV
+*  or an interrupt handler spends cycles, and every cycle is also booked to
+*  its owner in a reference account. The kernel is reduced to what the
+*  accounting sees: the current task handle and the PendSV that switches
+*  it. Exceptions go through the RAM vector table of Sys_VectorGet/Set, so
+*  the wrappers installed by Sys_CpuStatStart are the ones taken; they stand
+*  in for the armcc ones here and do the same calls. SysTick fires every
+*  CPU_HOST_TICK_CYCLES, other interrupts (nested or not) where the script
+*  puts them. The counters of sys_cpu_stat.c must match the reference to
+*  the cycle.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <string.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "sys_fault.h"
+#include "sys_cpu_stat.h"
+#include "host_os.h"
+#include "host_reg.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define CPU_HOST_DWT_BASE           (0xE0001000)
+#define CPU_HOST_CYCCNT             (CPU_HOST_DWT_BASE + 0x004)
+
+#define CPU_HOST_EXC_PENDSV         (16 + PendSV_IRQn)
+#define CPU_HOST_EXC_SYSTICK        (16 + SysTick_IRQn)
+#define CPU_HOST_EXC_UART           (16 + UART0_IRQn)
+#define CPU_HOST_EXC_IPC            (16 + IPC0_IRQn)
+
+// the core runs at the rate of Hal_Tick_PerMilliSec on the host, 1 MHz
+#define CPU_HOST_TICK_CYCLES        (HOST_OS_TICK_PER_MS)
+#define CPU_HOST_TICK_COST          (12)
+#define CPU_HOST_PENDSV_COST        (6)
+#define CPU_HOST_UART_COST          (40)
+#define CPU_HOST_IPC_COST           (16)
+
+#define CPU_HOST_TASK_MAX           (SYS_CPU_STAT_TASK_NUM + 4)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    osThreadId tId;                 // the handle, a host_os thread for pcTaskGetName
+    uint64_t u64Cycles;
+    uint32_t u32Switch;
+} T_CpuHostTask;
+
+typedef struct
+{
+    uint64_t u64Total;
+    uint64_t u64Isr;
+    uint32_t u32Isr;
+    uint32_t u32Switch;
+    void *pLast;                    // the task booked last
+    T_CpuHostTask taTask[CPU_HOST_TASK_MAX];
+} T_CpuHostRef;
+
+// a step of a workload: the task runs for u32Cycles, the interrupt u32Exc
+// (0: none) comes u32IrqAt cycles into the step
+typedef struct
+{
+    uint32_t u32Task;
+    uint32_t u32Cycles;
+    uint32_t u32Exc;
+    uint32_t u32IrqAt;
+} T_CpuHostStep;
+
+typedef void (*T_CpuHostHandlerFp)(void);
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+extern uint32_t g_u32aSysCpuStatVector[SYS_FAULT_VECTOR_NUM];
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static const char *g_saCpuHostName[] = {"IDLE", "tcpip", "app", "tracer", "at", "supplicant"};
+
+static uint32_t g_u32aCpuHostVector[SYS_FAULT_VECTOR_NUM];
+static uint8_t g_u8CpuHostVtor;             // 0: no RAM vector table
+
+static T_CpuHostRef g_tCpuHostRef;
+static uint32_t g_u32CpuHostTaskNum;
+static void *g_pCpuHostCurr;                // the running task
+static void *g_pCpuHostNext;                // the task PendSV switches to
+static uint32_t g_u32CpuHostDepth;          // interrupt nesting
+static uint32_t g_u32CpuHostExc;            // the exception being taken
+static uint32_t g_u32CpuHostTickLeft;       // cycles to the next SysTick
+
+// Sec 7: declaration of static function prototype
+static void _CpuHost_Exception(uint32_t u32Exc);
+
+/***********************************************************************
+*  Sec 8: C Functions
+***********************************************************************/
+
+/*
+ * Kernel, vector table and the armcc wrappers
+ */
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)g_pCpuHostCurr;
+}
+
+uint32_t Sys_VectorGet(uint32_t u32Num)
+{
+    if ((!g_u8CpuHostVtor) || (u32Num >= SYS_FAULT_VECTOR_NUM))
+        return 0;
+
+    return g_u32aCpuHostVector[u32Num];
+}
+
+int Sys_VectorSet(uint32_t u32Num, uint32_t u32Handler)
+{
+    if ((!g_u8CpuHostVtor) || (u32Num >= SYS_FAULT_VECTOR_NUM))
+        return -1;
+
+    g_u32aCpuHostVector[u32Num] = u32Handler;
+    return 0;
+}
+
+// Sys_CpuStatPendSvWrapper: charge, then the handler under it
+void Sys_CpuStatPendSvWrapper(void)
+{
+    Sys_CpuStatSwitch();
+    ((T_CpuHostHandlerFp)g_u32aSysCpuStatVector[CPU_HOST_EXC_PENDSV])();
+}
+
+// Sys_CpuStatIsrWrapper: the handler of IPSR between enter and exit
+void Sys_CpuStatIsrWrapper(void)
+{
+    Sys_CpuStatIsrEnter();
+    ((T_CpuHostHandlerFp)g_u32aSysCpuStatVector[g_u32CpuHostExc])();
+    Sys_CpuStatIsrExit();
+}
+
+static T_CpuHostTask *_CpuHost_RefTask(void *pHandle)
+{
+    uint32_t i;
+
+    for (i = 0; i < g_u32CpuHostTaskNum; i++)
+    {
+        if ((void *)g_tCpuHostRef.taTask[i].tId == pHandle)
+            return &g_tCpuHostRef.taTask[i];
+    }
+
+    return NULL;
+}
+
+// spend cycles in the current context and book them
+static void _CpuHost_Spend(uint32_t u32Cycles)
+{
+    T_CpuHostRef *ptRef = &g_tCpuHostRef;
+    T_CpuHostTask *ptTask = NULL;
+
+    HostReg_Set(CPU_HOST_CYCCNT, HostReg_Get(CPU_HOST_CYCCNT) + u32Cycles);
+
+    if (!u32Cycles)
+        return;
+
+    ptRef->u64Total += u32Cycles;
+
+    if (g_u32CpuHostDepth)
+    {
+        ptRef->u64Isr += u32Cycles;
+        return;
+    }
+
+    ptTask = _CpuHost_RefTask(g_pCpuHostCurr);
+    ptTask->u64Cycles += u32Cycles;
+
+    if (ptRef->pLast != g_pCpuHostCurr)
+    {
+        ptRef->pLast = g_pCpuHostCurr;
+        ptRef->u32Switch++;
+        ptTask->u32Switch++;
+    }
+}
+
+static void _CpuHost_PendSvHandler(void)
+{
+    // the kernel switches first, the rest of PendSV is the new task's
+    g_pCpuHostCurr = g_pCpuHostNext;
+    _CpuHost_Spend(CPU_HOST_PENDSV_COST);
+}
+
+static void _CpuHost_SysTickHandler(void)
+{
+    _CpuHost_Spend(CPU_HOST_TICK_COST);
+}
+
+static void _CpuHost_IpcHandler(void)
+{
+    _CpuHost_Spend(CPU_HOST_IPC_COST);
+}
+
+// the UART handler is interrupted by IPC half way
+static void _CpuHost_UartHandler(void)
+{
+    _CpuHost_Spend(CPU_HOST_UART_COST / 2);
+    _CpuHost_Exception(CPU_HOST_EXC_IPC);
+    _CpuHost_Spend(CPU_HOST_UART_COST / 2);
+}
+
+static void _CpuHost_Exception(uint32_t u32Exc)
+{
+    uint32_t u32Prev = g_u32CpuHostExc;
+
+    g_u32CpuHostExc = u32Exc;
+
+    // PendSV runs as the task it switches out, the reference books it so
+    if (u32Exc != CPU_HOST_EXC_PENDSV)
+    {
+        if (g_u32CpuHostDepth++ == 0)
+            g_tCpuHostRef.u32Isr++;
+    }
+
+    ((T_CpuHostHandlerFp)g_u32aCpuHostVector[u32Exc])();
+
+    if (u32Exc != CPU_HOST_EXC_PENDSV)
+        g_u32CpuHostDepth--;
+
+    g_u32CpuHostExc = u32Prev;
+}
+
+/*
+ * Workloads
+ */
+static void _CpuHost_Switch(uint32_t u32Task)
+{
+    void *pTask = (void *)g_tCpuHostRef.taTask[u32Task].tId;
+
+    if (pTask == g_pCpuHostCurr)
+        return;
+
+    g_pCpuHostNext = pTask;
+    _CpuHost_Exception(CPU_HOST_EXC_PENDSV);
+}
+
+// the current task runs, SysTick comes on time
+static void _CpuHost_Run(uint32_t u32Cycles)
+{
+    uint32_t u32Slice = 0;
+
+    while (u32Cycles)
+    {
+        u32Slice = (u32Cycles < g_u32CpuHostTickLeft) ? u32Cycles : g_u32CpuHostTickLeft;
+
+        _CpuHost_Spend(u32Slice);
+        u32Cycles -= u32Slice;
+        g_u32CpuHostTickLeft -= u32Slice;
+
+        if (!g_u32CpuHostTickLeft)
+        {
+            g_u32CpuHostTickLeft = CPU_HOST_TICK_CYCLES;
+            _CpuHost_Exception(CPU_HOST_EXC_SYSTICK);
+        }
+    }
+}
+
+static void _CpuHost_Script(const T_CpuHostStep *ptaStep, uint32_t u32Num, uint32_t u32Loop)
+{
+    const T_CpuHostStep *ptStep = NULL;
+    uint32_t i;
+
+    while (u32Loop--)
+    {
+        for (i = 0; i < u32Num; i++)
+        {
+            ptStep = &ptaStep[i];
+
+            _CpuHost_Switch(ptStep->u32Task);
+
+            if (!ptStep->u32Exc)
+            {
+                _CpuHost_Run(ptStep->u32Cycles);
+                continue;
+            }
+
+            _CpuHost_Run(ptStep->u32IrqAt);
+            _CpuHost_Exception(ptStep->u32Exc);
+            _CpuHost_Run(ptStep->u32Cycles - ptStep->u32IrqAt);
+        }
+    }
+}
+
+static void _CpuHost_TaskMain(void *argument)
+{
+}
+
+static void _CpuHost_TaskCreate(uint32_t u32Num)
+{
+    osThreadDef_t tDef;
+    char baName[SYS_CPU_STAT_NAME_LEN];
+
+    while (g_u32CpuHostTaskNum < u32Num)
+    {
+        if (g_u32CpuHostTaskNum < HOST_TEST_NUM(g_saCpuHostName))
+            snprintf(baName, sizeof(baName), "%s", g_saCpuHostName[g_u32CpuHostTaskNum]);
+        else
+            snprintf(baName, sizeof(baName), "task%u", g_u32CpuHostTaskNum);
+
+        memset(&tDef, 0, sizeof(tDef));
+        tDef.name = baName;
+        tDef.pthread = _CpuHost_TaskMain;
+
+        g_tCpuHostRef.taTask[g_u32CpuHostTaskNum++].tId = osThreadCreate(&tDef, NULL);
+    }
+}
+
+// counters of the task in the sample, NULL: not there
+static const S_SysCpuTask_t *_CpuHost_StatTask(const S_SysCpuStat_t *ptStat, uint32_t u32Task)
+{
+    uint32_t i;
+
+    for (i = 0; i < ptStat->u32TaskNum; i++)
+    {
+        if (ptStat->taTask[i].pHandle == (void *)g_tCpuHostRef.taTask[u32Task].tId)
+            return &ptStat->taTask[i];
+    }
+
+    return NULL;
+}
+
+// clear the reference and the counters together, the task list stays
+static void _CpuHost_Reset(void)
+{
+    T_CpuHostRef *ptRef = &g_tCpuHostRef;
+    uint32_t i;
+
+    Sys_CpuStatReset();
+
+    ptRef->u64Total = 0;
+    ptRef->u64Isr = 0;
+    ptRef->u32Isr = 0;
+    ptRef->u32Switch = 0;
+    ptRef->pLast = NULL;
+
+    for (i = 0; i < g_u32CpuHostTaskNum; i++)
+    {
+        ptRef->taTask[i].u64Cycles = 0;
+        ptRef->taTask[i].u32Switch = 0;
+    }
+}
+
+static void _CpuHost_Start(void)
+{
+    uint32_t i;
+
+    Sys_CpuStatStop();
+
+    for (i = 0; i < SYS_FAULT_VECTOR_NUM; i++)
+        g_u32aCpuHostVector[i] = (uint32_t)(uintptr_t)_CpuHost_IpcHandler;
+
+    g_u32aCpuHostVector[CPU_HOST_EXC_PENDSV] = (uint32_t)(uintptr_t)_CpuHost_PendSvHandler;
+    g_u32aCpuHostVector[CPU_HOST_EXC_SYSTICK] = (uint32_t)(uintptr_t)_CpuHost_SysTickHandler;
+    g_u32aCpuHostVector[CPU_HOST_EXC_UART] = (uint32_t)(uintptr_t)_CpuHost_UartHandler;
+    g_u8CpuHostVtor = 1;
+
+    _CpuHost_TaskCreate(HOST_TEST_NUM(g_saCpuHostName));
+    g_pCpuHostCurr = (void *)g_tCpuHostRef.taTask[0].tId;
+    g_u32CpuHostTickLeft = CPU_HOST_TICK_CYCLES;
+
+    Sys_CpuStatStart();
+    _CpuHost_Reset();
+
+    // IDLE runs first: a task is counted when it is charged, not before
+    _CpuHost_Run(100);
+}
+
+// the sample is the reference, to the cycle
+static int _CpuHost_Match(const S_SysCpuStat_t *ptStat, const T_CpuHostRef *ptRef, uint32_t u32TaskNum)
+{
+    const S_SysCpuTask_t *ptTask = NULL;
+    uint32_t i;
+
+    if ((ptStat->u64Total != ptRef->u64Total) || (ptStat->u64Isr != ptRef->u64Isr) ||
+        (ptStat->u32Isr != ptRef->u32Isr) || (ptStat->u32Switch != ptRef->u32Switch))
+    {
+        printf("    total %llu/%llu isr %llu/%llu count %u/%u switch %u/%u\n",
+               (unsigned long long)ptStat->u64Total, (unsigned long long)ptRef->u64Total,
+               (unsigned long long)ptStat->u64Isr, (unsigned long long)ptRef->u64Isr,
+               ptStat->u32Isr, ptRef->u32Isr, ptStat->u32Switch, ptRef->u32Switch);
+        return 0;
+    }
+
+    for (i = 0; i < u32TaskNum; i++)
+    {
+        ptTask = _CpuHost_StatTask(ptStat, i);
+
+        if (!ptRef->taTask[i].u64Cycles)
+            continue;
+
+        if ((!ptTask) || (ptTask->u64Cycles != ptRef->taTask[i].u64Cycles) ||
+            (ptTask->u32Switch != ptRef->taTask[i].u32Switch))
+        {
+            printf("    %s: %llu/%llu cycles\n", pcTaskGetName((TaskHandle_t)ptRef->taTask[i].tId),
+                   ptTask ? (unsigned long long)ptTask->u64Cycles : 0ULL,
+                   (unsigned long long)ptRef->taTask[i].u64Cycles);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Test cases
+ */
+static const T_CpuHostStep g_taCpuHostLoad[] =
+{
+    // tcpip takes a packet, app and tracer answer, AT prints, then idle
+    {1,  200, 0, 0},
+    {2, 1300, CPU_HOST_EXC_UART, 450},
+    {3,  175, 0, 0},
+    {4,   60, CPU_HOST_EXC_IPC, 30},
+    {5,  400, 0, 0},
+    {0, 2250, CPU_HOST_EXC_IPC, 1500},
+    {1,  125, 0, 0},
+    {0, 1500, 0, 0},
+};
+
+// a mixed load: every task, SysTick, nested and single interrupts
+static void _CpuHost_Workload(void)
+{
+    S_SysCpuStat_t tStat;
+    char baCmd[] = "top";
+    uint32_t u32Busy = 0;
+    uint32_t u32Sum = 0;
+    uint32_t i;
+
+    _CpuHost_Start();
+    _CpuHost_Script(g_taCpuHostLoad, HOST_TEST_NUM(g_taCpuHostLoad), 2000);
+
+    Sys_CpuStatGet(&tStat);
+
+    HOST_TEST_ASSERT(_CpuHost_Match(&tStat, &g_tCpuHostRef, g_u32CpuHostTaskNum));
+    HOST_TEST_EQ(tStat.u32TaskNum, HOST_TEST_NUM(g_saCpuHostName));
+    HOST_TEST_EQ(tStat.u64Other, 0);
+
+    // the shares add up, rounding aside
+    u32Sum = Sys_CpuStatPermille(tStat.u64Isr, tStat.u64Total);
+
+    for (i = 0; i < tStat.u32TaskNum; i++)
+        u32Sum += Sys_CpuStatPermille(tStat.taTask[i].u64Cycles, tStat.u64Total);
+
+    HOST_TEST_ASSERT((u32Sum >= 997) && (u32Sum <= 1003));
+
+    u32Busy = 1000 - Sys_CpuStatPermille(_CpuHost_StatTask(&tStat, 0)->u64Cycles, tStat.u64Total);
+    printf("    %llu cycles, busy %u.%u%%, isr %u.%u%%, %u interrupts, %u switches\n",
+           (unsigned long long)tStat.u64Total, u32Busy / 10, u32Busy % 10,
+           Sys_CpuStatPermille(tStat.u64Isr, tStat.u64Total) / 10,
+           Sys_CpuStatPermille(tStat.u64Isr, tStat.u64Total) % 10, tStat.u32Isr, tStat.u32Switch);
+
+    Sys_CpuStatCmd(baCmd);
+}
+
+// the cycle counter wraps during the load
+static void _CpuHost_Wrap(void)
+{
+    S_SysCpuStat_t tStat;
+
+    HostReg_Set(CPU_HOST_CYCCNT, 0xFFFFFFFF - 5000);
+    _CpuHost_Start();
+
+    _CpuHost_Script(g_taCpuHostLoad, HOST_TEST_NUM(g_taCpuHostLoad), 3);
+
+    HOST_TEST_ASSERT(HostReg_Get(CPU_HOST_CYCCNT) < 0x80000000);
+
+    Sys_CpuStatGet(&tStat);
+    HOST_TEST_ASSERT(_CpuHost_Match(&tStat, &g_tCpuHostRef, g_u32CpuHostTaskNum));
+}
+
+// periodic sampling: the delta of two samples is the load in between
+static void _CpuHost_Delta(void)
+{
+    S_SysCpuStat_t tPrev;
+    S_SysCpuStat_t tCurr;
+    T_CpuHostRef tRef;
+    const S_SysCpuTask_t *ptTask = NULL;
+    uint32_t i;
+
+    _CpuHost_Start();
+    _CpuHost_Script(g_taCpuHostLoad, HOST_TEST_NUM(g_taCpuHostLoad), 10);
+
+    Sys_CpuStatGet(&tPrev);
+    memcpy(&tRef, &g_tCpuHostRef, sizeof(tRef));
+
+    // a task created between the samples
+    _CpuHost_TaskCreate(g_u32CpuHostTaskNum + 1);
+    _CpuHost_Script(g_taCpuHostLoad, HOST_TEST_NUM(g_taCpuHostLoad), 5);
+    _CpuHost_Switch(g_u32CpuHostTaskNum - 1);
+    _CpuHost_Run(3500);
+
+    Sys_CpuStatGet(&tCurr);
+    Sys_CpuStatDelta(&tPrev, &tCurr);
+
+    HOST_TEST_EQ(tCurr.u64Total, g_tCpuHostRef.u64Total - tRef.u64Total);
+    HOST_TEST_EQ(tCurr.u64Isr, g_tCpuHostRef.u64Isr - tRef.u64Isr);
+    HOST_TEST_EQ(tCurr.u32Isr, g_tCpuHostRef.u32Isr - tRef.u32Isr);
+    HOST_TEST_EQ(tCurr.u32Switch, g_tCpuHostRef.u32Switch - tRef.u32Switch);
+
+    for (i = 0; i < g_u32CpuHostTaskNum; i++)
+    {
+        ptTask = _CpuHost_StatTask(&tCurr, i);
+        HOST_TEST_ASSERT(ptTask);
+        HOST_TEST_EQ(ptTask->u64Cycles, g_tCpuHostRef.taTask[i].u64Cycles - tRef.taTask[i].u64Cycles);
+    }
+
+    // the new task keeps all it has
+    ptTask = _CpuHost_StatTask(&tCurr, g_u32CpuHostTaskNum - 1);
+    HOST_TEST_EQ(ptTask->u64Cycles, 3500 + CPU_HOST_PENDSV_COST);
+}
+
+// a sample in the middle of a slice takes the running task up to now
+static void _CpuHost_MidSlice(void)
+{
+    S_SysCpuStat_t tStat;
+    const S_SysCpuTask_t *ptTask = NULL;
+
+    _CpuHost_Start();
+    _CpuHost_Switch(2);
+    _CpuHost_Run(2500);
+
+    Sys_CpuStatGet(&tStat);
+    ptTask = _CpuHost_StatTask(&tStat, 2);
+
+    HOST_TEST_ASSERT(ptTask);
+    HOST_TEST_EQ(ptTask->u64Cycles, 2500 + CPU_HOST_PENDSV_COST);
+    HOST_TEST_EQ(tStat.u64Total, g_tCpuHostRef.u64Total);
+}
+
+// more tasks than the table: the rest goes to "other"
+static void _CpuHost_Overflow(void)
+{
+    S_SysCpuStat_t tStat;
+    uint64_t u64Listed = 0;
+    uint64_t u64All = 0;
+    uint32_t i;
+
+    _CpuHost_Start();
+    _CpuHost_TaskCreate(CPU_HOST_TASK_MAX);
+
+    for (i = 0; i < CPU_HOST_TASK_MAX; i++)
+    {
+        _CpuHost_Switch(i);
+        _CpuHost_Run(100 + i);
+    }
+
+    Sys_CpuStatGet(&tStat);
+
+    HOST_TEST_EQ(tStat.u32TaskNum, SYS_CPU_STAT_TASK_NUM);
+    HOST_TEST_EQ(tStat.u64Total, g_tCpuHostRef.u64Total);
+
+    for (i = 0; i < tStat.u32TaskNum; i++)
+        u64Listed += tStat.taTask[i].u64Cycles;
+
+    for (i = 0; i < CPU_HOST_TASK_MAX; i++)
+        u64All += g_tCpuHostRef.taTask[i].u64Cycles;
+
+    HOST_TEST_ASSERT(tStat.u64Other > 0);
+    HOST_TEST_EQ(u64Listed + tStat.u64Other + tStat.u64Isr, tStat.u64Total);
+    HOST_TEST_EQ(u64All + g_tCpuHostRef.u64Isr, tStat.u64Total);
+}
+
+// stopped: the handlers are back and nothing is charged
+static void _CpuHost_Stop(void)
+{
+    S_SysCpuStat_t tStat;
+    uint64_t u64Total = 0;
+
+    _CpuHost_Start();
+    HOST_TEST_ASSERT(Sys_CpuStatIsRunning());
+    HOST_TEST_EQ(g_u32aCpuHostVector[CPU_HOST_EXC_PENDSV], (uint32_t)(uintptr_t)Sys_CpuStatPendSvWrapper);
+    HOST_TEST_EQ(g_u32aCpuHostVector[CPU_HOST_EXC_UART], (uint32_t)(uintptr_t)Sys_CpuStatIsrWrapper);
+
+    _CpuHost_Script(g_taCpuHostLoad, HOST_TEST_NUM(g_taCpuHostLoad), 2);
+    Sys_CpuStatStop();
+
+    HOST_TEST_EQ(g_u32aCpuHostVector[CPU_HOST_EXC_PENDSV], (uint32_t)(uintptr_t)_CpuHost_PendSvHandler);
+    HOST_TEST_EQ(g_u32aCpuHostVector[CPU_HOST_EXC_SYSTICK], (uint32_t)(uintptr_t)_CpuHost_SysTickHandler);
+
+    Sys_CpuStatGet(&tStat);
+    u64Total = tStat.u64Total;
+
+    _CpuHost_Script(g_taCpuHostLoad, HOST_TEST_NUM(g_taCpuHostLoad), 2);
+
+    Sys_CpuStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u64Total, u64Total);
+
+    // no RAM vector table, no start
+    g_u8CpuHostVtor = 0;
+    HOST_TEST_EQ(Sys_CpuStatStart(), -1);
+    HOST_TEST_ASSERT(!Sys_CpuStatIsRunning());
+}
+
+static const T_HostTestCase g_taCpuHostCase[] =
+{
+    HOST_TEST_CASE(_CpuHost_Workload),
+    HOST_TEST_CASE(_CpuHost_Wrap),
+    HOST_TEST_CASE(_CpuHost_Delta),
+    HOST_TEST_CASE(_CpuHost_MidSlice),
+    HOST_TEST_CASE(_CpuHost_Overflow),
+    HOST_TEST_CASE(_CpuHost_Stop),
+};
+
+int main(void)
+{
+    HostOs_Init();
+
+    if ((HostReg_Init()) || (HostReg_Map(CPU_HOST_DWT_BASE, HOST_REG_PAGE_SIZE)))
+        return 1;
+
+    return HostTest_Run("sys_cpu_stat", g_taCpuHostCase, HOST_TEST_NUM(g_taCpuHostCase));
+}
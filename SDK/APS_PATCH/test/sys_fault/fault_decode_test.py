@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+###############################################################################
+#  Copyright 2017 - 2018, Opulinks Technology Ltd.
+#  ----------------------------------------------------------------------------
+#  Statement:
+#  ----------
+#  This software is protected by Copyright and the information contained
+#  herein is confidential. The software may not be copied and the information
+#  contained herein may not be used or disclosed except with the written
+#  permission of Opulinks Technology Ltd. (C) 2018
+###############################################################################
+#
+# tools/fault_decode.py on an ARM ELF made by the test and the "crash show"
+# and AT+CRASH? lines of a record, then on the dump of sys_fault_host
+# (SYS_FAULT_HOST, set by ctest) against the symbols of that program.
+###############################################################################
+
+import io
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+import unittest
+from contextlib import redirect_stdout
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'tools'))
+import fault_decode
+
+# name, address (Thumb bit set as armlink writes it), size, type
+SYMS = [
+    ('Reset_Handler', 0x00010001, 0x20, 2),
+    ('App_Task', 0x00010101, 0x80, 2),
+    ('App_Work', 0x00010181, 0x40, 2),
+    ('g_u32Data', 0x00410000, 4, 1),        # an object, not a function
+]
+
+CLI_DUMP = '''
+> crash show
+crash: seq=3 type=usagefault tick=1234 task=opl_app
+crash: pc=0x000101A4 lr=0x0001012B sp=0x0043F000 xpsr=0x01000000 exc_return=0xFFFFFFFD
+crash: r0=0x00000001 r1=0x00000002 r2=0x00000003 r3=0x00000004 r12=0x00000005
+crash: cfsr=0x02000000 hfsr=0x40000000 mmfar=0xE000EDF8 bfar=0xE000EDF8
+crash: stack+0x000 00000000 0001015D 00410000 FFFFFFFF 00000000 00000000 00000000 00000000
+crash: stack+0x020 00000000
+crash: stack+0x024 00010011
+crash: trace wifi: connected
+'''
+
+AT_DUMP = '''
++CRASH:seq=1 type=busfault tick=10 task=-
++CRASH:pc=0x00000100 lr=0x00010003 sp=0x00400100 xpsr=0x01000000 exc_return=0xFFFFFFF1
++CRASH:cfsr=0x00008200 hfsr=0x00000000 mmfar=0x00000000 bfar=0x60000010
+
+OK
+'''
+
+
+def elf32_arm(syms):
+    """ An ELF32 ARM with a symbol table and its strings, nothing else. """
+    strtab = b'\0'
+    entries = [struct.pack('<IIIBBH', 0, 0, 0, 0, 0, 0)]
+    for name, value, size, stype in syms:
+        entries.append(struct.pack('<IIIBBH', len(strtab), value, size, (1 << 4) | stype, 0, 1))
+        strtab += name.encode() + b'\0'
+    symtab = b''.join(entries)
+
+    shoff = 52 + len(symtab) + len(strtab)
+    sections = [
+        struct.pack('<IIIIIIIIII', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0),
+        struct.pack('<IIIIIIIIII', 0, 1, 0, 0, 0, 0, 0, 0, 4, 0),                                   # .text
+        struct.pack('<IIIIIIIIII', 0, 2, 0, 0, 52, len(symtab), 3, 1, 4, 16),                       # .symtab
+        struct.pack('<IIIIIIIIII', 0, 3, 0, 0, 52 + len(symtab), len(strtab), 0, 0, 1, 0),          # .strtab
+    ]
+    header = b'\x7fELF' + bytes([1, 1, 1]) + bytes(9)
+    header += struct.pack('<HHIIIIIHHHHHH', 2, fault_decode.EM_ARM, 1, 0, 0, shoff, 0, 52, 0, 0, 40,
+                          len(sections), 0)
+    return header + symtab + strtab + b''.join(sections)
+
+
+class FaultDecodeTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.TemporaryDirectory()
+        self.elf = os.path.join(self.dir.name, 'app.axf')
+        with open(self.elf, 'wb') as f:
+            f.write(elf32_arm(SYMS))
+
+    def tearDown(self):
+        self.dir.cleanup()
+
+    def _run(self, text):
+        dump = os.path.join(self.dir.name, 'dump.txt')
+        with open(dump, 'w') as f:
+            f.write(text)
+        out = io.StringIO()
+        with redirect_stdout(out):
+            rc = fault_decode.main([self.elf, dump])
+        return rc, out.getvalue().splitlines()
+
+    def test_elf(self):
+        with open(self.elf, 'rb') as f:
+            funcs = fault_decode.elf_funcs(f.read())
+        self.assertEqual([(f.name, f.addr) for f in funcs],
+                         [('Reset_Handler', 0x10000), ('App_Task', 0x10100), ('App_Work', 0x10180)])
+        self.assertEqual(fault_decode.lookup(funcs, 0x10100), 'App_Task+0x0')
+        self.assertEqual(fault_decode.lookup(funcs, 0x1017E), 'App_Task+0x7e')
+        self.assertIsNone(fault_decode.lookup(funcs, 0x101C0))        # after App_Work
+        self.assertIsNone(fault_decode.lookup(funcs, 0x100))
+
+    def test_cli(self):
+        rc, lines = self._run(CLI_DUMP)
+        self.assertEqual(rc, 0)
+        self.assertEqual(lines[0], 'usagefault in opl_app, seq 3, tick 1234')
+        self.assertEqual(lines[1], 'pc   0x000101a4 App_Work+0x24')
+        self.assertEqual(lines[2], 'lr   0x0001012b App_Task+0x2a')
+        self.assertIn('cfsr 0x02000000 DIVBYZERO', lines)
+        self.assertIn('hfsr 0x40000000 FORCED', lines)
+        self.assertIn('stack+0x004 0x0001015d App_Task+0x5c', lines)
+        self.assertIn('stack+0x024 0x00010011 Reset_Handler+0x10', lines)
+        self.assertFalse([l for l in lines if '00410000' in l])       # the object is not a caller
+        self.assertEqual(lines[-1], 'trace wifi: connected')
+
+    def test_at(self):
+        rc, lines = self._run(AT_DUMP)
+        self.assertEqual(rc, 0)
+        self.assertEqual(lines[0], 'busfault in -, seq 1, tick 10')
+        self.assertEqual(lines[1], 'pc   0x00000100 ?')                 # in the ROM
+        self.assertEqual(lines[2], 'lr   0x00010003 Reset_Handler+0x2')
+        self.assertIn('cfsr 0x00008200 PRECISERR BFARVALID', lines)
+        self.assertIn('bfar 0x60000010', lines)
+
+    def test_none(self):
+        rc, lines = self._run('+CRASH:none\r\n\r\nOK\r\n')
+        self.assertEqual(rc, 1)
+
+    @unittest.skipUnless(os.environ.get('SYS_FAULT_HOST'), 'SYS_FAULT_HOST is not set')
+    def test_host(self):
+        host = os.environ['SYS_FAULT_HOST']
+        dump = subprocess.run([host, '--dump'], stdout=subprocess.PIPE, check=True,
+                              universal_newlines=True).stdout
+        path = os.path.join(self.dir.name, 'host.txt')
+        with open(path, 'w') as f:
+            f.write(dump)
+
+        out = io.StringIO()
+        with redirect_stdout(out):
+            rc = fault_decode.main([host, path])
+        lines = out.getvalue().splitlines()
+
+        self.assertEqual(rc, 0)
+        self.assertTrue(lines[0].startswith('usagefault in app_task_with_a, seq 1'), lines[0])
+        self.assertTrue(lines[1].endswith(' FaultHost_DumpPc+0x4'), lines[1])
+        self.assertTrue(lines[2].endswith(' FaultHost_DumpLr+0x2'), lines[2])
+        self.assertIn('DIVBYZERO', '\n'.join(lines))
+        self.assertTrue([l for l in lines if l.startswith('stack+0x004 ') and l.endswith(' Sys_FaultInit+0x8')],
+                        lines)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,943 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_fault_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The crash record of sys_fault.c, from the capture to the decode, on the
+*  ROM hal_flash.c, hal_flash_patch.c and hal_flash_sched.c against the SPI
+*  flash simulator (host/host_flash).
+*
+*  The RAM of the target is a host_reg window, the exception frames and the
+*  stacks are written in it by the test. A crash is a child process: it runs
+*  the capture as the handler of the exception (IPSR set) and stops in
+*  Hal_Sys_SwResetAll, which hands the flash array and the simulator figures
+*  to the parent through shared memory. The parent is the next boot: it takes
+*  the flash, runs Sys_FaultInit and reads the record back.
+*
+*  The cases check the CRC, each field of _Sys_FaultRecordFill, the frame
+*  EXC_RETURN selects (MSP/PSP), a broken SP, the stall and nested captures,
+*  the background erase the capture lets end (running, suspended by the read
+*  the fault hit, or too long and aborted) and the "crash show" and AT+CRASH
+*  output.
+*
+*  "sys_fault_host --dump" prints the "crash show" of a record whose PC, LR
+*  and stack point into this program, for tools/fault_decode.py.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "opl1000.h"
+#include "cmsis_os.h"
+#include "msg.h"
+#include "at_cmd.h"
+#include "at_cmd_common.h"
+#include "at_cmd_data_process.h"
+#include "hal_system.h"
+#include "hal_spi.h"
+#include "hal_flash.h"
+#include "hal_flash_internal.h"
+#include "hal_flash_patch.h"
+#include "hal_flash_sched.h"
+#include "sys_fault.h"
+#include "host_flash.h"
+#include "host_os.h"
+#include "host_reg.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define FAULT_HOST_BOOT_SIZE    (0x1000)
+#define FAULT_HOST_DATA_ADDR    (0x40000)       // read when the fault hits
+#define FAULT_HOST_ERASE_ADDR   (0x50000)       // erased in the background
+#define FAULT_HOST_ERASE_US     (2000)          // 4KB erase, short for the poll traps
+#define FAULT_HOST_ERASE_LONG   (60000)         // above the ROM poll (47 ms here) and HAL_FLASH_SCHED_SETTLE_MS
+
+#define FAULT_HOST_VTOR         (SYS_FAULT_RAM_START)
+#define FAULT_HOST_MSP          (0x0044F000)    // the frame of an ISR
+#define FAULT_HOST_PSP          (0x00420000)    // the frame of a task
+#define FAULT_HOST_TASK_TOP     (0x00430000)    // pxTopOfStack of a switched out task
+
+#define FAULT_HOST_EXC_HANDLER  (0xFFFFFFF1)    // EXC_RETURN: nested, MSP
+#define FAULT_HOST_EXC_THREAD   (0xFFFFFFF9)    // thread mode, MSP
+#define FAULT_HOST_EXC_TASK     (0xFFFFFFFD)    // thread mode, PSP
+
+#define FAULT_HOST_TAG_MSP      (0x11)
+#define FAULT_HOST_TAG_PSP      (0x22)
+#define FAULT_HOST_TAG_TASK     (0x33)
+
+#define FAULT_HOST_OUT_SIZE     (8192)
+#define FAULT_HOST_READ_SIZE    (64)
+
+#define FAULT_HOST_EXIT_RETURN  (2)             // the capture came back
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef enum
+{
+    FAULT_HOST_KIND_FAULT = 0,                  // Sys_FaultHandler
+    FAULT_HOST_KIND_STALL,
+    FAULT_HOST_KIND_WDT
+} T_FaultHostKind;
+
+typedef void (*T_FaultHostFp)(void);
+
+typedef struct
+{
+    uint8_t u8Kind;
+    uint32_t u32Exc;                            // IPSR of the handler
+    uint32_t u32Msp;
+    uint32_t u32Psp;
+    uint32_t u32ExcReturn;
+    void *pStall;                               // the task of a stall
+    T_FaultHostFp fpCrash;                      // runs in the child up to the fault, NULL: at once
+    uint8_t u8Nested;                           // fault again in the reset
+} T_FaultHostArg;
+
+// the end of the crashed boot, in shared memory
+typedef struct
+{
+    uint32_t u32Reset;                          // calls of Hal_Sys_SwResetAll
+    T_HostFlashStat tStat;
+    uint8_t u8aMem[];                           // the flash array
+} T_FaultHostShared;
+
+typedef struct
+{
+    uint32_t *pu32Top;                          // pxTopOfStack, the first field of a TCB
+    const char *sName;
+} T_FaultHostTcb;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+void FaultHost_DumpPc(void);
+void FaultHost_DumpLr(void);
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_HostFlashCfg g_tFaultHostCfg;
+static T_FaultHostShared *g_ptFaultHostShared;
+static const T_FaultHostArg *g_ptFaultHostArg;
+static uint32_t g_u32FaultHostReset;
+
+static uint8_t g_u8FaultHostReadCrash;
+
+static T_FaultHostTcb g_tFaultHostTask = {NULL, "app_task_with_a_long_name"};
+static T_FaultHostTcb g_tFaultHostStall = {(uint32_t *)FAULT_HOST_TASK_TOP, "stalled"};
+static T_FaultHostTcb *g_ptFaultHostCurr = &g_tFaultHostTask;
+
+static char g_baFaultHostOut[FAULT_HOST_OUT_SIZE];
+static uint32_t g_u32FaultHostOutLen;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+uint32_t Boot_CheckWarmBoot(void)
+{
+    return 0;
+}
+
+// the asm entry is not built here, the cases call Sys_FaultCapture
+void Sys_FaultHandler(void)
+{
+}
+
+/*
+ * The kernel
+ */
+char *pcTaskGetName(TaskHandle_t xTaskToQuery)
+{
+    T_FaultHostTcb *ptTcb = (T_FaultHostTcb *)xTaskToQuery;
+
+    if (ptTcb == NULL)
+        ptTcb = g_ptFaultHostCurr;
+
+    return (char *)ptTcb->sName;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)g_ptFaultHostCurr;
+}
+
+/*
+ * The output of "crash show" and AT+CRASH
+ */
+static void _FaultHost_OutAdd(const char *sFmt, va_list tList)
+{
+    int iLen;
+
+    iLen = vsnprintf(&g_baFaultHostOut[g_u32FaultHostOutLen], sizeof(g_baFaultHostOut) - g_u32FaultHostOutLen,
+                     sFmt, tList);
+
+    if (iLen > 0)
+        g_u32FaultHostOutLen += iLen;
+
+    if (g_u32FaultHostOutLen >= sizeof(g_baFaultHostOut))
+        g_u32FaultHostOutLen = sizeof(g_baFaultHostOut) - 1;
+}
+
+static int _FaultHost_Tracer(const char *sFmt, ...)
+{
+    va_list tList;
+
+    va_start(tList, sFmt);
+    _FaultHost_OutAdd(sFmt, tList);
+    va_end(tList);
+    return 0;
+}
+
+static void _FaultHost_AtPrint(char *sFmt, ...)
+{
+    va_list tList;
+
+    va_start(tList, sFmt);
+    _FaultHost_OutAdd(sFmt, tList);
+    va_end(tList);
+}
+
+msg_print_uart1_fp_t msg_print_uart1 = _FaultHost_AtPrint;
+
+int _at_cmd_buf_to_argc_argv(char *pbuf, int *argc, char *argv[], int iArgvNum)
+{
+    int iCount = 0;
+    char *p;
+
+    argv[iCount++] = strtok(pbuf, "=");
+
+    while ((iCount < iArgvNum) && ((p = strtok(NULL, ",")) != NULL))
+        argv[iCount++] = p;
+
+    *argc = iCount;
+    return 1;
+}
+
+static void _FaultHost_OutReset(void)
+{
+    g_u32FaultHostOutLen = 0;
+    g_baFaultHostOut[0] = 0;
+}
+
+/*
+ * Frames and stacks in the RAM of the target
+ */
+static uint32_t _FaultHost_Reg(uint32_t u32Tag, uint32_t i)
+{
+    return 0xA0000000 | (u32Tag << 16) | i;
+}
+
+static uint32_t _FaultHost_Word(uint32_t u32Tag, uint32_t i)
+{
+    return 0x50000000 | (u32Tag << 16) | i;
+}
+
+// the frame at u32Addr and the words above it, up to the end of the RAM
+static void _FaultHost_Frame(uint32_t u32Addr, uint32_t u32Tag)
+{
+    uint32_t *pu32Word = (uint32_t *)(uintptr_t)u32Addr;
+    uint32_t i;
+
+    for (i = 0; i < SYS_FAULT_REG_NUM; i++)
+        pu32Word[i] = _FaultHost_Reg(u32Tag, i);
+
+    for (i = 0; (i < SYS_FAULT_STACK_NUM) && ((u32Addr + (SYS_FAULT_REG_NUM + i) * 4) < SYS_FAULT_RAM_END); i++)
+        pu32Word[SYS_FAULT_REG_NUM + i] = _FaultHost_Word(u32Tag, i);
+}
+
+/*
+ * The crash
+ */
+static void _FaultHost_Isr(void *pArg)
+{
+    const T_FaultHostArg *ptArg = (const T_FaultHostArg *)pArg;
+
+    switch (ptArg->u8Kind)
+    {
+        case FAULT_HOST_KIND_STALL:
+            Sys_FaultStallCapture(ptArg->pStall);
+            break;
+
+        case FAULT_HOST_KIND_WDT:
+            Sys_FaultWdtCapture();
+            break;
+
+        default:
+            Sys_FaultCapture(ptArg->u32Msp, ptArg->u32Psp, ptArg->u32ExcReturn);
+            break;
+    }
+}
+
+static void _FaultHost_Exc(void)
+{
+    HostOs_ExcRun(g_ptFaultHostArg->u32Exc, _FaultHost_Isr, (void *)g_ptFaultHostArg);
+}
+
+// the end of the crashed boot: the flash is what the next boot finds
+static uint32_t _FaultHost_SwResetAll(void)
+{
+    T_FaultHostArg tNested;
+
+    g_u32FaultHostReset++;
+
+    if ((g_u32FaultHostReset == 1) && (g_ptFaultHostArg->u8Nested))
+    {
+        tNested = *g_ptFaultHostArg;
+        tNested.u32Msp = FAULT_HOST_PSP;
+        tNested.u32Psp = FAULT_HOST_MSP;
+        _FaultHost_Isr(&tNested);
+    }
+
+    g_ptFaultHostShared->u32Reset = g_u32FaultHostReset;
+    HostFlash_StatGet(&g_ptFaultHostShared->tStat);
+    memcpy(g_ptFaultHostShared->u8aMem, HostFlash_Mem(), g_tFaultHostCfg.u32Size);
+
+    fflush(stdout);
+    _exit(0);
+    return 0;
+}
+
+// below the scheduler: the fault hits the read, while the erase is suspended
+static uint32_t _FaultHost_Read(E_SpiIdx_t u32SpiIdx, uint32_t u32StartAddr, uint8_t u8UseQuadMode, uint32_t u32Size, uint8_t *pu8Data)
+{
+    if (g_u8FaultHostReadCrash)
+        _FaultHost_Exc();
+
+    return Hal_Flash_AddrRead_Internal_patch(u32SpiIdx, u32StartAddr, u8UseQuadMode, u32Size, pu8Data);
+}
+
+/*
+ * Run the crash in a child and boot again with its flash. The simulator
+ * figures of the crashed boot are in g_ptFaultHostShared->tStat.
+ * Returns 0 when the child reached the reset.
+ */
+static uint32_t _FaultHost_Crash(const T_FaultHostArg *ptArg)
+{
+    pid_t tPid;
+    int iStatus;
+
+    memset(g_ptFaultHostShared, 0, sizeof(T_FaultHostShared));
+    fflush(stdout);
+
+    tPid = fork();
+    if (tPid == 0)
+    {
+        g_ptFaultHostArg = ptArg;
+
+        if (ptArg->fpCrash)
+            ptArg->fpCrash();
+        else
+            _FaultHost_Exc();
+
+        _exit(FAULT_HOST_EXIT_RETURN);
+    }
+
+    if ((tPid < 0) || (waitpid(tPid, &iStatus, 0) != tPid) || (!WIFEXITED(iStatus)) || (WEXITSTATUS(iStatus)))
+        return 1;
+
+    memcpy(HostFlash_Mem(), g_ptFaultHostShared->u8aMem, g_tFaultHostCfg.u32Size);
+
+    // the next boot
+    Sys_FaultInit();
+    return 0;
+}
+
+static uint32_t _FaultHost_CrashRecord(const T_FaultHostArg *ptArg, S_SysFaultRecord_t *ptRecord)
+{
+    if (_FaultHost_Crash(ptArg))
+        return 1;
+
+    memset(ptRecord, 0, sizeof(S_SysFaultRecord_t));
+    if (Sys_FaultRecordGet(ptRecord))
+        return 1;
+
+    return 0;
+}
+
+// a fault of the exception u32Exc, the frame as EXC_RETURN says
+static T_FaultHostArg _FaultHost_Arg(uint32_t u32Exc, uint32_t u32ExcReturn)
+{
+    T_FaultHostArg tArg;
+
+    memset(&tArg, 0, sizeof(tArg));
+    tArg.u8Kind = FAULT_HOST_KIND_FAULT;
+    tArg.u32Exc = u32Exc;
+    tArg.u32Msp = FAULT_HOST_MSP;
+    tArg.u32Psp = FAULT_HOST_PSP;
+    tArg.u32ExcReturn = u32ExcReturn;
+    return tArg;
+}
+
+// a blank part with the boot agent and a sector of data to erase
+static uint32_t _FaultHost_Part(uint32_t u32EraseUs)
+{
+    uint8_t *pu8Mem;
+    uint32_t i;
+
+    HostFlash_CfgDefault(&g_tFaultHostCfg, GIGADEVICE_ID);
+    g_tFaultHostCfg.u32EraseUs = (u32EraseUs) ? u32EraseUs : FAULT_HOST_ERASE_US;
+
+    if (HostFlash_Init(&g_tFaultHostCfg))
+        return 1;
+
+    pu8Mem = HostFlash_Mem();
+    for (i = 0; i < FAULT_HOST_BOOT_SIZE; i++)
+        pu8Mem[i] = (uint8_t)(i * 3 + 1);
+    for (i = 0; i < HOST_FLASH_SECTOR_SIZE; i++)
+        pu8Mem[FAULT_HOST_ERASE_ADDR + i] = (uint8_t)(i ^ 0xC3);
+
+    Hal_Flash_ReadModeSet(SPI_IDX_0, HAL_FLASH_READ_MODE_AUTO);
+    if (Hal_Flash_Init(SPI_IDX_0))
+        return 1;
+
+    HostReg_Set((uint32_t)(uintptr_t)&SCB->CFSR, 0);
+    HostReg_Set((uint32_t)(uintptr_t)&SCB->HFSR, 0);
+    HostReg_Set((uint32_t)(uintptr_t)&SCB->MMFAR, 0);
+    HostReg_Set((uint32_t)(uintptr_t)&SCB->BFAR, 0);
+
+    _FaultHost_Frame(FAULT_HOST_MSP, FAULT_HOST_TAG_MSP);
+    _FaultHost_Frame(FAULT_HOST_PSP, FAULT_HOST_TAG_PSP);
+    _FaultHost_Frame(FAULT_HOST_TASK_TOP + 8 * 4, FAULT_HOST_TAG_TASK);
+
+    g_ptFaultHostCurr = &g_tFaultHostTask;
+    g_u8FaultHostReadCrash = 0;
+
+    // a cold boot with no record
+    Sys_FaultInit();
+    HostFlash_StatReset();
+    return 0;
+}
+
+static uint8_t _FaultHost_Erased(const uint8_t *pu8Mem, uint32_t u32Addr)
+{
+    uint32_t i;
+
+    for (i = 0; i < HOST_FLASH_SECTOR_SIZE; i++)
+    {
+        if (pu8Mem[u32Addr + i] != 0xFF)
+            return 0;
+    }
+
+    return 1;
+}
+
+// CRC-32 of IEEE 802.3, bit by bit
+static uint32_t _FaultHost_Crc32(const uint8_t *pu8Data, uint32_t u32Size)
+{
+    uint32_t u32Crc = 0xFFFFFFFF;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0; i < u32Size; i++)
+    {
+        u32Crc ^= pu8Data[i];
+
+        for (j = 0; j < 8; j++)
+            u32Crc = (u32Crc & 1) ? ((u32Crc >> 1) ^ 0xEDB88320) : (u32Crc >> 1);
+    }
+
+    return ~u32Crc;
+}
+
+static uint8_t _FaultHost_OutHas(const char *sText)
+{
+    return (strstr(g_baFaultHostOut, sText) != NULL);
+}
+
+/*
+ * The cases
+ */
+// the CRC covers every field before it, a changed byte or version is no record
+static void _FaultHost_Crc(void)
+{
+    T_FaultHostArg tArg = _FaultHost_Arg(SYS_FAULT_TYPE_HARD, FAULT_HOST_EXC_TASK);
+    S_SysFaultRecord_t tRecord;
+    uint8_t *pu8Rec;
+    uint8_t u8Save;
+
+    HOST_TEST_EQ(_FaultHost_Crc32((const uint8_t *)"123456789", 9), 0xCBF43926);
+
+    HOST_TEST_EQ(_FaultHost_Part(0), 0);
+    HOST_TEST_ASSERT(Sys_FaultRecordGet(&tRecord) != 0);
+
+    HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+    HOST_TEST_EQ(tRecord.u32Magic, SYS_FAULT_MAGIC);
+    HOST_TEST_EQ(tRecord.u16Version, SYS_FAULT_VERSION);
+    HOST_TEST_EQ(tRecord.u16Size, sizeof(S_SysFaultRecord_t));
+    HOST_TEST_EQ(tRecord.u32Crc, _FaultHost_Crc32((const uint8_t *)&tRecord, offsetof(S_SysFaultRecord_t, u32Crc)));
+
+    pu8Rec = HostFlash_Mem() + SYS_FAULT_FLASH_ADDR;
+    HOST_TEST_EQ(memcmp(pu8Rec, &tRecord, sizeof(tRecord)), 0);
+
+    // a bit of the stack flipped, as a program cut short would leave it
+    u8Save = pu8Rec[offsetof(S_SysFaultRecord_t, u32aStack) + 5];
+    pu8Rec[offsetof(S_SysFaultRecord_t, u32aStack) + 5] = u8Save ^ 0x10;
+    HOST_TEST_ASSERT(Sys_FaultRecordGet(&tRecord) != 0);
+    pu8Rec[offsetof(S_SysFaultRecord_t, u32aStack) + 5] = u8Save;
+    HOST_TEST_EQ(Sys_FaultRecordGet(&tRecord), 0);
+
+    // the CRC is good but the layout is another one
+    tRecord.u16Version = SYS_FAULT_VERSION + 1;
+    tRecord.u32Crc = _FaultHost_Crc32((const uint8_t *)&tRecord, offsetof(S_SysFaultRecord_t, u32Crc));
+    memcpy(pu8Rec, &tRecord, sizeof(tRecord));
+    HOST_TEST_ASSERT(Sys_FaultRecordGet(&tRecord) != 0);
+}
+
+// every field of _Sys_FaultRecordFill, from a task on PSP
+static void _FaultHost_Fill(void)
+{
+    T_FaultHostArg tArg = _FaultHost_Arg(SYS_FAULT_TYPE_BUS, FAULT_HOST_EXC_TASK);
+    S_SysFaultRecord_t tRecord;
+    char baLine[SYS_FAULT_TRACE_LEN + 32];
+    uint32_t u32Tick;
+    uint32_t i;
+
+    HOST_TEST_EQ(_FaultHost_Part(0), 0);
+
+    HostReg_Set((uint32_t)(uintptr_t)&SCB->CFSR, 0x00008200);     // BFARVALID, PRECISERR
+    HostReg_Set((uint32_t)(uintptr_t)&SCB->HFSR, 0x40000000);
+    HostReg_Set((uint32_t)(uintptr_t)&SCB->MMFAR, 0x12345678);
+    HostReg_Set((uint32_t)(uintptr_t)&SCB->BFAR, 0x60000010);
+
+    // 10 lines: the first 2 are dropped, the long one is cut, CR/LF end a line
+    for (i = 0; i < 10; i++)
+    {
+        if (i == 4)
+        {
+            memset(baLine, 'x', sizeof(baLine) - 1);
+            baLine[sizeof(baLine) - 1] = 0;
+        }
+        else if (i == 6)
+        {
+            snprintf(baLine, sizeof(baLine), "\r\nline %u\r\nnext", i);
+        }
+        else
+        {
+            snprintf(baLine, sizeof(baLine), "line %u", i);
+        }
+
+        Sys_FaultTraceAdd(baLine);
+    }
+    Sys_FaultTraceAdd("\r\n");      // empty, not kept
+
+    u32Tick = osKernelSysTick();
+    HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+
+    HOST_TEST_EQ(tRecord.u32Seq, 1);
+    HOST_TEST_EQ(tRecord.u32Type, SYS_FAULT_TYPE_BUS);
+    HOST_TEST_EQ(tRecord.u32Tick, u32Tick);
+    HOST_TEST_EQ(tRecord.u32Sp, FAULT_HOST_PSP);
+    HOST_TEST_EQ(tRecord.u32ExcReturn, FAULT_HOST_EXC_TASK);
+    HOST_TEST_EQ(tRecord.u32Cfsr, 0x00008200);
+    HOST_TEST_EQ(tRecord.u32Hfsr, 0x40000000);
+    HOST_TEST_EQ(tRecord.u32Mmfar, 0x12345678);
+    HOST_TEST_EQ(tRecord.u32Bfar, 0x60000010);
+
+    for (i = 0; i < SYS_FAULT_REG_NUM; i++)
+        HOST_TEST_EQ(tRecord.u32aReg[i], _FaultHost_Reg(FAULT_HOST_TAG_PSP, i));
+
+    HOST_TEST_EQ(tRecord.u32StackNum, SYS_FAULT_STACK_NUM);
+    for (i = 0; i < SYS_FAULT_STACK_NUM; i++)
+        HOST_TEST_EQ(tRecord.u32aStack[i], _FaultHost_Word(FAULT_HOST_TAG_PSP, i));
+
+    HOST_TEST_EQ(strlen(tRecord.baTask), SYS_FAULT_TASK_NAME_LEN - 1);
+    HOST_TEST_EQ(strncmp(tRecord.baTask, g_tFaultHostTask.sName, SYS_FAULT_TASK_NAME_LEN - 1), 0);
+
+    HOST_TEST_EQ(strcmp(tRecord.baTrace[0], "line 2"), 0);
+    HOST_TEST_EQ(strcmp(tRecord.baTrace[1], "line 3"), 0);
+    HOST_TEST_EQ(strlen(tRecord.baTrace[2]), SYS_FAULT_TRACE_LEN - 1);
+    HOST_TEST_EQ(strspn(tRecord.baTrace[2], "x"), SYS_FAULT_TRACE_LEN - 1);
+    HOST_TEST_EQ(strcmp(tRecord.baTrace[3], "line 5"), 0);
+    HOST_TEST_EQ(strcmp(tRecord.baTrace[4], "line 6"), 0);
+    HOST_TEST_EQ(strcmp(tRecord.baTrace[7], "line 9"), 0);
+
+    // the next boot took the seq of the record, the next crash counts on
+    HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+    HOST_TEST_EQ(tRecord.u32Seq, 2);
+
+    HOST_TEST_EQ(Sys_FaultRecordClear(), 0);
+    HOST_TEST_ASSERT(Sys_FaultRecordGet(&tRecord) != 0);
+    HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+    HOST_TEST_EQ(tRecord.u32Seq, 1);
+}
+
+// bit 2 of EXC_RETURN picks the stack of the frame, the exception is the type
+static void _FaultHost_Frames(void)
+{
+    const struct
+    {
+        uint32_t u32Exc;
+        uint32_t u32ExcReturn;
+        uint32_t u32Sp;
+        uint32_t u32Tag;
+    } taCase[] =
+    {
+        {SYS_FAULT_TYPE_HARD,  FAULT_HOST_EXC_THREAD,  FAULT_HOST_MSP, FAULT_HOST_TAG_MSP},
+        {SYS_FAULT_TYPE_HARD,  FAULT_HOST_EXC_TASK,    FAULT_HOST_PSP, FAULT_HOST_TAG_PSP},
+        {SYS_FAULT_TYPE_MEM,   FAULT_HOST_EXC_HANDLER, FAULT_HOST_MSP, FAULT_HOST_TAG_MSP},
+        {SYS_FAULT_TYPE_USAGE, FAULT_HOST_EXC_TASK,    FAULT_HOST_PSP, FAULT_HOST_TAG_PSP},
+    };
+    T_FaultHostArg tArg;
+    S_SysFaultRecord_t tRecord;
+    uint32_t i;
+
+    HOST_TEST_EQ(_FaultHost_Part(0), 0);
+
+    for (i = 0; i < HOST_TEST_NUM(taCase); i++)
+    {
+        tArg = _FaultHost_Arg(taCase[i].u32Exc, taCase[i].u32ExcReturn);
+        HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+
+        HOST_TEST_EQ(tRecord.u32Type, taCase[i].u32Exc);
+        HOST_TEST_EQ(tRecord.u32ExcReturn, taCase[i].u32ExcReturn);
+        HOST_TEST_EQ(tRecord.u32Sp, taCase[i].u32Sp);
+        HOST_TEST_EQ(tRecord.u32aReg[SYS_FAULT_REG_PC], _FaultHost_Reg(taCase[i].u32Tag, SYS_FAULT_REG_PC));
+        HOST_TEST_EQ(tRecord.u32aStack[0], _FaultHost_Word(taCase[i].u32Tag, 0));
+    }
+}
+
+// a frame at the end of the RAM keeps the words it has, a broken SP none
+static void _FaultHost_BrokenSp(void)
+{
+    T_FaultHostArg tArg = _FaultHost_Arg(SYS_FAULT_TYPE_HARD, FAULT_HOST_EXC_THREAD);
+    S_SysFaultRecord_t tRecord;
+    uint32_t u32Sp = SYS_FAULT_RAM_END - (SYS_FAULT_REG_NUM + 3) * 4;
+    uint32_t i;
+
+    HOST_TEST_EQ(_FaultHost_Part(0), 0);
+
+    _FaultHost_Frame(u32Sp, FAULT_HOST_TAG_MSP);
+    tArg.u32Msp = u32Sp;
+    HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+    HOST_TEST_EQ(tRecord.u32Sp, u32Sp);
+    HOST_TEST_EQ(tRecord.u32aReg[SYS_FAULT_REG_XPSR], _FaultHost_Reg(FAULT_HOST_TAG_MSP, SYS_FAULT_REG_XPSR));
+    HOST_TEST_EQ(tRecord.u32StackNum, 3);
+    HOST_TEST_EQ(tRecord.u32aStack[2], _FaultHost_Word(FAULT_HOST_TAG_MSP, 2));
+
+    // half a frame in the RAM, below it, and far out
+    {
+        const uint32_t u32aSp[] = {SYS_FAULT_RAM_END - 16, SYS_FAULT_RAM_START - 4, 0x20000000};
+
+        for (i = 0; i < HOST_TEST_NUM(u32aSp); i++)
+        {
+            tArg.u32Msp = u32aSp[i];
+            HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+            HOST_TEST_EQ(tRecord.u32Sp, u32aSp[i]);
+            HOST_TEST_EQ(tRecord.u32aReg[SYS_FAULT_REG_PC], 0);
+            HOST_TEST_EQ(tRecord.u32StackNum, 0);
+        }
+    }
+
+    // the watchdog takes PSP, which the host keeps at 0
+    tArg.u8Kind = FAULT_HOST_KIND_WDT;
+    tArg.u32Exc = 16;
+    HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+    HOST_TEST_EQ(tRecord.u32Type, SYS_FAULT_TYPE_WDT);
+    HOST_TEST_EQ(tRecord.u32Sp, 0);
+    HOST_TEST_EQ(tRecord.u32ExcReturn, 0);
+    HOST_TEST_EQ(tRecord.u32StackNum, 0);
+}
+
+// the context of a switched out task, and the name of that task
+static void _FaultHost_Stall(void)
+{
+    T_FaultHostArg tArg = _FaultHost_Arg(16, 0);
+    S_SysFaultRecord_t tRecord;
+
+    HOST_TEST_EQ(_FaultHost_Part(0), 0);
+
+    tArg.u8Kind = FAULT_HOST_KIND_STALL;
+    tArg.pStall = &g_tFaultHostStall;
+    HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+    HOST_TEST_EQ(tRecord.u32Type, SYS_FAULT_TYPE_STALL);
+    HOST_TEST_EQ(tRecord.u32Sp, FAULT_HOST_TASK_TOP + 8 * 4);
+    HOST_TEST_EQ(tRecord.u32aReg[SYS_FAULT_REG_PC], _FaultHost_Reg(FAULT_HOST_TAG_TASK, SYS_FAULT_REG_PC));
+    HOST_TEST_EQ(strcmp(tRecord.baTask, "stalled"), 0);
+
+    // the running task has no saved context
+    g_ptFaultHostCurr = &g_tFaultHostStall;
+    HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+    HOST_TEST_EQ(tRecord.u32Sp, 0);
+    HOST_TEST_EQ(tRecord.u32StackNum, 0);
+    HOST_TEST_EQ(strcmp(tRecord.baTask, "stalled"), 0);
+    g_ptFaultHostCurr = &g_tFaultHostTask;
+}
+
+// a fault inside the capture goes to the reset and keeps the first record
+static void _FaultHost_Nested(void)
+{
+    T_FaultHostArg tArg = _FaultHost_Arg(SYS_FAULT_TYPE_HARD, FAULT_HOST_EXC_THREAD);
+    S_SysFaultRecord_t tRecord;
+
+    HOST_TEST_EQ(_FaultHost_Part(0), 0);
+
+    tArg.u8Nested = 1;
+    HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+    HOST_TEST_EQ(g_ptFaultHostShared->u32Reset, 2);
+    HOST_TEST_EQ(g_ptFaultHostShared->tStat.u32aCmd[0x20], 1);         // one erase
+    HOST_TEST_EQ(tRecord.u32Seq, 1);
+    HOST_TEST_EQ(tRecord.u32Sp, FAULT_HOST_MSP);
+}
+
+static void _FaultHost_EraseRunCrash(void)
+{
+    if (Hal_Flash_EraseStart(SPI_IDX_0, FAULT_HOST_ERASE_ADDR))
+        _exit(1);
+
+    _FaultHost_Exc();
+}
+
+static void _FaultHost_EraseReadCrash(void)
+{
+    uint8_t u8aBuf[FAULT_HOST_READ_SIZE];
+
+    if (Hal_Flash_EraseStart(SPI_IDX_0, FAULT_HOST_ERASE_ADDR))
+        _exit(1);
+
+    g_u8FaultHostReadCrash = 1;
+    Hal_Flash_AddrRead(SPI_IDX_0, FAULT_HOST_DATA_ADDR, 0, sizeof(u8aBuf), u8aBuf);
+}
+
+// the background erase ends before the reset of the flash
+static void _FaultHost_EraseRun(void)
+{
+    T_FaultHostArg tArg = _FaultHost_Arg(SYS_FAULT_TYPE_HARD, FAULT_HOST_EXC_TASK);
+    S_SysFaultRecord_t tRecord;
+    T_HostFlashStat *ptStat = &g_ptFaultHostShared->tStat;
+
+    HOST_TEST_EQ(_FaultHost_Part(0), 0);
+
+    tArg.fpCrash = _FaultHost_EraseRunCrash;
+    HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+    HOST_TEST_EQ(ptStat->u32Aborted, 0);
+    HOST_TEST_EQ(ptStat->u32EraseDone, 2);                 // the erase and the record sector
+    HOST_TEST_EQ(ptStat->u32BadRead, 0);
+    HOST_TEST_ASSERT(_FaultHost_Erased(HostFlash_Mem(), FAULT_HOST_ERASE_ADDR));
+    HOST_TEST_EQ(tRecord.u32Sp, FAULT_HOST_PSP);
+}
+
+// the fault hits the read that suspended the erase: it is resumed and ends
+static void _FaultHost_EraseSuspended(void)
+{
+    T_FaultHostArg tArg = _FaultHost_Arg(SYS_FAULT_TYPE_HARD, FAULT_HOST_EXC_TASK);
+    S_SysFaultRecord_t tRecord;
+    T_HostFlashStat *ptStat = &g_ptFaultHostShared->tStat;
+
+    HOST_TEST_EQ(_FaultHost_Part(0), 0);
+
+    tArg.fpCrash = _FaultHost_EraseReadCrash;
+    HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+    HOST_TEST_EQ(ptStat->u32Suspend, 1);
+    HOST_TEST_EQ(ptStat->u32aCmd[0x7A], 1);                // resumed by the capture
+    HOST_TEST_EQ(ptStat->u32Aborted, 0);
+    HOST_TEST_EQ(ptStat->u32EraseDone, 2);
+    HOST_TEST_EQ(ptStat->u32BadRead, 0);
+    HOST_TEST_ASSERT(_FaultHost_Erased(HostFlash_Mem(), FAULT_HOST_ERASE_ADDR));
+}
+
+// an erase longer than the capture waits is aborted, the record is still good
+static void _FaultHost_EraseAbort(void)
+{
+    T_FaultHostArg tArg = _FaultHost_Arg(SYS_FAULT_TYPE_HARD, FAULT_HOST_EXC_TASK);
+    S_SysFaultRecord_t tRecord;
+    T_HostFlashStat *ptStat = &g_ptFaultHostShared->tStat;
+
+    HOST_TEST_EQ(_FaultHost_Part(FAULT_HOST_ERASE_LONG), 0);
+
+    tArg.fpCrash = _FaultHost_EraseReadCrash;
+    HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+    HOST_TEST_EQ(ptStat->u32Aborted, 1);
+    HOST_TEST_EQ(ptStat->u32Ignored, 0);
+    HOST_TEST_EQ(tRecord.u32Sp, FAULT_HOST_PSP);
+    HOST_TEST_ASSERT(!_FaultHost_Erased(HostFlash_Mem(), FAULT_HOST_ERASE_ADDR));
+}
+
+// "crash show" and AT+CRASH give the same lines, then "+CRASH:none"
+static void _FaultHost_Decode(void)
+{
+    T_FaultHostArg tArg = _FaultHost_Arg(SYS_FAULT_TYPE_USAGE, FAULT_HOST_EXC_TASK);
+    S_SysFaultRecord_t tRecord;
+    char baCmd[32];
+    char baText[64];
+    uint32_t u32Sp = SYS_FAULT_RAM_END - (SYS_FAULT_REG_NUM + 11) * 4;
+
+    HOST_TEST_EQ(_FaultHost_Part(0), 0);
+
+    HostReg_Set((uint32_t)(uintptr_t)&SCB->CFSR, 0x00020000);     // INVSTATE
+    Sys_FaultTraceAdd("wifi: connected");
+    _FaultHost_Frame(u32Sp, FAULT_HOST_TAG_PSP);
+    tArg.u32Psp = u32Sp;
+    HOST_TEST_EQ(_FaultHost_CrashRecord(&tArg, &tRecord), 0);
+
+    _FaultHost_OutReset();
+    snprintf(baCmd, sizeof(baCmd), "crash show");
+    Sys_FaultCmd(baCmd);
+
+    HOST_TEST_ASSERT(_FaultHost_OutHas("crash: seq=1 type=usagefault tick="));
+    HOST_TEST_ASSERT(_FaultHost_OutHas("task=app_task_with"));
+    snprintf(baText, sizeof(baText), "crash: pc=0x%08X lr=0x%08X sp=0x%08X",
+             _FaultHost_Reg(FAULT_HOST_TAG_PSP, SYS_FAULT_REG_PC), _FaultHost_Reg(FAULT_HOST_TAG_PSP, SYS_FAULT_REG_LR), u32Sp);
+    HOST_TEST_ASSERT(_FaultHost_OutHas(baText));
+    HOST_TEST_ASSERT(_FaultHost_OutHas("exc_return=0xFFFFFFFD"));
+    HOST_TEST_ASSERT(_FaultHost_OutHas("crash: cfsr=0x00020000"));
+    snprintf(baText, sizeof(baText), "crash: stack+0x000 %08X", _FaultHost_Word(FAULT_HOST_TAG_PSP, 0));
+    HOST_TEST_ASSERT(_FaultHost_OutHas(baText));
+    snprintf(baText, sizeof(baText), "crash: stack+0x020 %08X\n", _FaultHost_Word(FAULT_HOST_TAG_PSP, 8));
+    HOST_TEST_ASSERT(_FaultHost_OutHas(baText));                // the last 3 words one per line
+    HOST_TEST_ASSERT(_FaultHost_OutHas("crash: trace wifi: connected\n"));
+
+    _FaultHost_OutReset();
+    snprintf(baCmd, sizeof(baCmd), "at+crash");
+    HOST_TEST_EQ(Sys_FaultAtCmd(baCmd, strlen(baCmd), AT_CMD_MODE_READ), 1);
+    HOST_TEST_ASSERT(_FaultHost_OutHas("+CRASH:seq=1 type=usagefault"));
+    HOST_TEST_ASSERT(_FaultHost_OutHas("+CRASH:trace wifi: connected\r\n"));
+    HOST_TEST_ASSERT(_FaultHost_OutHas("\r\nOK\r\n"));
+
+    _FaultHost_OutReset();
+    snprintf(baCmd, sizeof(baCmd), "crash clear");
+    Sys_FaultCmd(baCmd);
+    HOST_TEST_ASSERT(_FaultHost_OutHas("crash: clear done"));
+
+    _FaultHost_OutReset();
+    snprintf(baCmd, sizeof(baCmd), "at+crash");
+    HOST_TEST_EQ(Sys_FaultAtCmd(baCmd, strlen(baCmd), AT_CMD_MODE_READ), 1);
+    HOST_TEST_ASSERT(_FaultHost_OutHas("+CRASH:none\r\n"));
+}
+
+/*
+ * The dump for tools/fault_decode.py: PC, LR and a stack word point into the
+ * functions below and into sys_fault.c.
+ */
+void __attribute__((noinline)) FaultHost_DumpPc(void)
+{
+    volatile uint32_t u32aWork[4];
+    uint32_t i;
+
+    for (i = 0; i < 4; i++)
+        u32aWork[i] = i * 7;
+}
+
+void __attribute__((noinline)) FaultHost_DumpLr(void)
+{
+    volatile uint32_t u32aWork[4];
+    uint32_t i;
+
+    for (i = 0; i < 4; i++)
+        u32aWork[i] = i * 5;
+}
+
+static int _FaultHost_Dump(void)
+{
+    T_FaultHostArg tArg = _FaultHost_Arg(SYS_FAULT_TYPE_USAGE, FAULT_HOST_EXC_TASK);
+    uint32_t *pu32Frame = (uint32_t *)(uintptr_t)FAULT_HOST_PSP;
+    char baCmd[] = "crash show";
+
+    if (_FaultHost_Part(0))
+        return 1;
+
+    pu32Frame[SYS_FAULT_REG_PC] = (uint32_t)(uintptr_t)FaultHost_DumpPc + 4;
+    pu32Frame[SYS_FAULT_REG_LR] = (uint32_t)(uintptr_t)FaultHost_DumpLr + 2;
+    pu32Frame[SYS_FAULT_REG_NUM + 1] = (uint32_t)(uintptr_t)Sys_FaultInit + 8;
+    HostReg_Set((uint32_t)(uintptr_t)&SCB->CFSR, 0x02000000);     // DIVBYZERO
+
+    if (_FaultHost_Crash(&tArg))
+        return 1;
+
+    _FaultHost_OutReset();
+    Sys_FaultCmd(baCmd);
+    fputs(g_baFaultHostOut, stdout);
+    return 0;
+}
+
+static const T_HostTestCase g_taFaultHostCase[] =
+{
+    HOST_TEST_CASE(_FaultHost_Crc),
+    HOST_TEST_CASE(_FaultHost_Fill),
+    HOST_TEST_CASE(_FaultHost_Frames),
+    HOST_TEST_CASE(_FaultHost_BrokenSp),
+    HOST_TEST_CASE(_FaultHost_Stall),
+    HOST_TEST_CASE(_FaultHost_Nested),
+    HOST_TEST_CASE(_FaultHost_EraseRun),
+    HOST_TEST_CASE(_FaultHost_EraseSuspended),
+    HOST_TEST_CASE(_FaultHost_EraseAbort),
+    HOST_TEST_CASE(_FaultHost_Decode),
+};
+
+int main(int argc, char *argv[])
+{
+    uint8_t u8Dump = ((argc > 1) && (!strcmp(argv[1], "--dump")));
+    uint32_t *pu32Vector = (uint32_t *)(uintptr_t)FAULT_HOST_VTOR;
+    uint32_t i;
+
+    HostOs_Init();
+
+    if ((HostReg_Init()) || (HostReg_Map(SYS_FAULT_RAM_START, SYS_FAULT_RAM_END - SYS_FAULT_RAM_START)))
+        return 1;
+
+    g_ptFaultHostShared = mmap(NULL, sizeof(T_FaultHostShared) + 0x100000, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (g_ptFaultHostShared == MAP_FAILED)
+        return 1;
+
+    // the bus time only, not the time of the register traps
+    HostOs_TimeFreeze(1);
+
+    Hal_Spi_Pre_Init();
+    Hal_Flash_Pre_Init();
+    Hal_Sys_SwResetAll = _FaultHost_SwResetAll;
+
+    // the driver as peri_patch_init.c installs it, the test read below the scheduler
+    Hal_Flash_Init_Internal = Hal_Flash_Init_Internal_patch;
+    Hal_Flash_AddrProgram_Internal = Hal_Flash_AddrProgram_Internal_patch;
+    Hal_Flash_AddrRead_Internal = _FaultHost_Read;
+    Hal_Flash_SchedInit();
+
+    // the ROM vector table Sys_FaultInit copies
+    for (i = 0; i < SYS_FAULT_VECTOR_NUM; i++)
+        pu32Vector[i] = 0x00000101 + i * 4;
+    SCB->VTOR = FAULT_HOST_VTOR;
+
+    tracer_drct_printf = _FaultHost_Tracer;
+
+    if (u8Dump)
+        return _FaultHost_Dump();
+
+    return HostTest_Run("sys_fault", g_taFaultHostCase, HOST_TEST_NUM(g_taFaultHostCase));
+}
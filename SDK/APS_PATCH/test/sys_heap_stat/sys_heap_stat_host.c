@@ -0,0 +1,966 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_heap_stat_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The heap statistics of sys_heap_stat.c over a heap_4 allocator.
+*
+*  The heap of the ROM is FreeRTOS heap_4: a first fit free list in address
+*  order, blocks split when the rest is big enough and merged with their
+*  free neighbours on free. The test carries the same allocator over a
+*  configTOTAL_HEAP_SIZE array (the block header is 16 bytes on the host, 8
+*  on the target) and puts it under osMemoryAllocate/osMemoryDeallocate
+*  as the ROM does, so Sys_HeapStatInit wraps it. The counters, the live
+*  block table, the call sites and tasks, the failure hook and the largest
+*  free block are checked against what the test did and against a walk of
+*  the free list.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <string.h>
+#include "cmsis_os.h"
+#include "sys_heap_stat.h"
+#include "host_os.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define HEAP_HOST_SIZE              (configTOTAL_HEAP_SIZE)
+#define HEAP_HOST_ALIGN_MASK        (portBYTE_ALIGNMENT - 1)
+#define HEAP_HOST_HDR               ((sizeof(T_HeapHostBlock) + HEAP_HOST_ALIGN_MASK) & ~(size_t)HEAP_HOST_ALIGN_MASK)
+#define HEAP_HOST_MIN_BLOCK         (HEAP_HOST_HDR * 2)
+#define HEAP_HOST_USED              ((size_t)1 << ((sizeof(size_t) * 8) - 1))
+
+#define HEAP_HOST_SLOT_NUM          (64)
+#define HEAP_HOST_CHURN             (20000)
+
+#define HEAP_HOST_SITE_FUNC_NUM     (SYS_HEAP_STAT_SITE_NUM + 8)
+#define HEAP_HOST_SITE_WINDOW       (0x40)      // bytes of a site function before the return address
+
+#define HEAP_HOST_THREAD_NUM        (3)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+// BlockLink_t of heap_4
+typedef struct T_HeapHostBlock
+{
+    struct T_HeapHostBlock *ptNext;
+    size_t xSize;                   // HEAP_HOST_USED: allocated
+} T_HeapHostBlock;
+
+typedef void *(*T_HeapHostSiteFp)(uint32_t u32Size);
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+extern T_osMemoryAllocateFp g_fpSysHeapAlloc;
+extern T_osMemoryDeallocateFp g_fpSysHeapFree;
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static uint8_t g_u8aHeapHost[HEAP_HOST_SIZE] __attribute__((aligned(portBYTE_ALIGNMENT)));
+static T_HeapHostBlock g_tHeapHostStart;
+static T_HeapHostBlock *g_ptHeapHostEnd;
+static size_t g_xHeapHostFree;
+static size_t g_xHeapHostMinEver;
+static size_t g_xHeapHostEmpty;             // free bytes of the empty heap
+
+static uint32_t g_u32HeapHostSuspend;
+static uint32_t g_u32HeapHostSuspendPm;
+static BaseType_t g_xHeapHostScheduler = taskSCHEDULER_NOT_STARTED;
+
+static volatile uint32_t g_u32HeapHostMark;
+
+static uint32_t g_u32HeapHostHookNum;
+static uint32_t g_u32HeapHostHookSize;
+static uint32_t g_u32HeapHostHookSite;
+
+static void *g_paHeapHostThreadPtr[HEAP_HOST_THREAD_NUM];
+static osSemaphoreId g_tHeapHostThreadSem;
+
+// Sec 7: declaration of static function prototype
+
+/***********************************************************************
+*  Sec 8: C Functions
+***********************************************************************/
+
+/*
+ * heap_4 and the kernel calls of sys_heap_stat.c
+ */
+static void _HeapHost_HeapInit(void)
+{
+    T_HeapHostBlock *ptFirst = (T_HeapHostBlock *)g_u8aHeapHost;
+    uint8_t *pu8End = g_u8aHeapHost + HEAP_HOST_SIZE - HEAP_HOST_HDR;
+
+    g_tHeapHostStart.ptNext = ptFirst;
+    g_tHeapHostStart.xSize = 0;
+
+    g_ptHeapHostEnd = (T_HeapHostBlock *)pu8End;
+    g_ptHeapHostEnd->ptNext = NULL;
+    g_ptHeapHostEnd->xSize = 0;
+
+    ptFirst->xSize = pu8End - (uint8_t *)ptFirst;
+    ptFirst->ptNext = g_ptHeapHostEnd;
+
+    g_xHeapHostFree = ptFirst->xSize;
+    g_xHeapHostMinEver = ptFirst->xSize;
+    g_xHeapHostEmpty = ptFirst->xSize;
+}
+
+// prvInsertBlockIntoFreeList: in address order, merged with its neighbours
+static void _HeapHost_Insert(T_HeapHostBlock *ptBlock)
+{
+    T_HeapHostBlock *ptIter = &g_tHeapHostStart;
+
+    while (ptIter->ptNext < ptBlock)
+        ptIter = ptIter->ptNext;
+
+    if (((uint8_t *)ptIter + ptIter->xSize) == (uint8_t *)ptBlock)
+    {
+        ptIter->xSize += ptBlock->xSize;
+        ptBlock = ptIter;
+    }
+
+    if (((uint8_t *)ptBlock + ptBlock->xSize) == (uint8_t *)ptIter->ptNext)
+    {
+        if (ptIter->ptNext != g_ptHeapHostEnd)
+        {
+            ptBlock->xSize += ptIter->ptNext->xSize;
+            ptBlock->ptNext = ptIter->ptNext->ptNext;
+        }
+        else
+        {
+            ptBlock->ptNext = g_ptHeapHostEnd;
+        }
+    }
+    else
+    {
+        ptBlock->ptNext = ptIter->ptNext;
+    }
+
+    if (ptIter != ptBlock)
+        ptIter->ptNext = ptBlock;
+}
+
+void *pvPortMallocEx(size_t xWantedSize, uint32_t ulInstanceId)
+{
+    T_HeapHostBlock *ptPrev = NULL;
+    T_HeapHostBlock *ptBlock = NULL;
+    T_HeapHostBlock *ptNew = NULL;
+    void *pRet = NULL;
+    uint32_t u32Pm = HostOs_IrqSave();
+
+    if (g_ptHeapHostEnd == NULL)
+        _HeapHost_HeapInit();
+
+    if ((xWantedSize == 0) || (xWantedSize & HEAP_HOST_USED))
+        goto done;
+
+    xWantedSize = (xWantedSize + HEAP_HOST_HDR + HEAP_HOST_ALIGN_MASK) & ~(size_t)HEAP_HOST_ALIGN_MASK;
+
+    if (xWantedSize > g_xHeapHostFree)
+        goto done;
+
+    ptPrev = &g_tHeapHostStart;
+    ptBlock = g_tHeapHostStart.ptNext;
+
+    while ((ptBlock->xSize < xWantedSize) && (ptBlock->ptNext != NULL))
+    {
+        ptPrev = ptBlock;
+        ptBlock = ptBlock->ptNext;
+    }
+
+    if (ptBlock == g_ptHeapHostEnd)
+        goto done;
+
+    pRet = (uint8_t *)ptBlock + HEAP_HOST_HDR;
+    ptPrev->ptNext = ptBlock->ptNext;
+
+    if ((ptBlock->xSize - xWantedSize) > HEAP_HOST_MIN_BLOCK)
+    {
+        ptNew = (T_HeapHostBlock *)((uint8_t *)ptBlock + xWantedSize);
+        ptNew->xSize = ptBlock->xSize - xWantedSize;
+        ptBlock->xSize = xWantedSize;
+        _HeapHost_Insert(ptNew);
+    }
+
+    g_xHeapHostFree -= ptBlock->xSize;
+
+    if (g_xHeapHostFree < g_xHeapHostMinEver)
+        g_xHeapHostMinEver = g_xHeapHostFree;
+
+    ptBlock->xSize |= HEAP_HOST_USED;
+    ptBlock->ptNext = NULL;
+
+done:
+    HostOs_IrqSet(u32Pm);
+    return pRet;
+}
+
+void vPortFreeEx(void *pv)
+{
+    T_HeapHostBlock *ptBlock = NULL;
+    uint32_t u32Pm = 0;
+
+    if (pv == NULL)
+        return;
+
+    ptBlock = (T_HeapHostBlock *)((uint8_t *)pv - HEAP_HOST_HDR);
+
+    // heap_4 asserts these: a double or a foreign free breaks the list
+    if ((!(ptBlock->xSize & HEAP_HOST_USED)) || (ptBlock->ptNext != NULL))
+    {
+        HostTest_Fail(__FILE__, __LINE__, "vPortFreeEx of a block not allocated");
+        return;
+    }
+
+    u32Pm = HostOs_IrqSave();
+
+    ptBlock->xSize &= ~HEAP_HOST_USED;
+    g_xHeapHostFree += ptBlock->xSize;
+    _HeapHost_Insert(ptBlock);
+
+    HostOs_IrqSet(u32Pm);
+}
+
+size_t xPortGetFreeHeapSize(void)
+{
+    return g_xHeapHostFree;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize(void)
+{
+    return g_xHeapHostMinEver;
+}
+
+// osMemoryAllocate/osMemoryDeallocate of the ROM
+static void *_HeapHost_Alloc(uint32_t ulWantedSize)
+{
+    return pvPortMallocEx(ulWantedSize, 0);
+}
+
+static void _HeapHost_Free(void *pvMemPtr)
+{
+    vPortFreeEx(pvMemPtr);
+}
+
+void vTaskSuspendAll(void)
+{
+    uint32_t u32Pm = HostOs_IrqSave();
+
+    if (g_u32HeapHostSuspend++ == 0)
+        g_u32HeapHostSuspendPm = u32Pm;
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+    if (--g_u32HeapHostSuspend == 0)
+        HostOs_IrqSet(g_u32HeapHostSuspendPm);
+
+    return pdFALSE;
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    return g_xHeapHostScheduler;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)osThreadGetId();
+}
+
+// the largest free block of the list, as an allocation size
+static uint32_t _HeapHost_LargestWalk(void)
+{
+    T_HeapHostBlock *ptBlock = g_tHeapHostStart.ptNext;
+    size_t xMax = 0;
+
+    for ( ; ptBlock != g_ptHeapHostEnd; ptBlock = ptBlock->ptNext)
+    {
+        if (ptBlock->xSize > xMax)
+            xMax = ptBlock->xSize;
+    }
+
+    return (xMax > HEAP_HOST_HDR) ? (uint32_t)(xMax - HEAP_HOST_HDR) : 0;
+}
+
+static uint32_t _HeapHost_FreeBlockNum(void)
+{
+    T_HeapHostBlock *ptBlock = g_tHeapHostStart.ptNext;
+    uint32_t u32Num = 0;
+
+    for ( ; ptBlock != g_ptHeapHostEnd; ptBlock = ptBlock->ptNext)
+        u32Num++;
+
+    return u32Num;
+}
+
+/*
+ * Call sites: functions that allocate, each its own return address. The
+ * store after the call keeps it from being a tail call, and makes the
+ * bodies differ so they are not folded.
+ */
+#define HEAP_HOST_SITE(n) \
+    static __attribute__((noinline)) void *_HeapHost_Site##n(uint32_t u32Size) \
+    { \
+        void *pPtr = osMemoryAllocate(u32Size); \
+        g_u32HeapHostMark = n; \
+        return pPtr; \
+    }
+
+HEAP_HOST_SITE(0)  HEAP_HOST_SITE(1)  HEAP_HOST_SITE(2)  HEAP_HOST_SITE(3)
+HEAP_HOST_SITE(4)  HEAP_HOST_SITE(5)  HEAP_HOST_SITE(6)  HEAP_HOST_SITE(7)
+HEAP_HOST_SITE(8)  HEAP_HOST_SITE(9)  HEAP_HOST_SITE(10) HEAP_HOST_SITE(11)
+HEAP_HOST_SITE(12) HEAP_HOST_SITE(13) HEAP_HOST_SITE(14) HEAP_HOST_SITE(15)
+HEAP_HOST_SITE(16) HEAP_HOST_SITE(17) HEAP_HOST_SITE(18) HEAP_HOST_SITE(19)
+HEAP_HOST_SITE(20) HEAP_HOST_SITE(21) HEAP_HOST_SITE(22) HEAP_HOST_SITE(23)
+HEAP_HOST_SITE(24) HEAP_HOST_SITE(25) HEAP_HOST_SITE(26) HEAP_HOST_SITE(27)
+HEAP_HOST_SITE(28) HEAP_HOST_SITE(29) HEAP_HOST_SITE(30) HEAP_HOST_SITE(31)
+HEAP_HOST_SITE(32) HEAP_HOST_SITE(33) HEAP_HOST_SITE(34) HEAP_HOST_SITE(35)
+HEAP_HOST_SITE(36) HEAP_HOST_SITE(37) HEAP_HOST_SITE(38) HEAP_HOST_SITE(39)
+
+static const T_HeapHostSiteFp g_fpaHeapHostSite[HEAP_HOST_SITE_FUNC_NUM] =
+{
+    _HeapHost_Site0,  _HeapHost_Site1,  _HeapHost_Site2,  _HeapHost_Site3,
+    _HeapHost_Site4,  _HeapHost_Site5,  _HeapHost_Site6,  _HeapHost_Site7,
+    _HeapHost_Site8,  _HeapHost_Site9,  _HeapHost_Site10, _HeapHost_Site11,
+    _HeapHost_Site12, _HeapHost_Site13, _HeapHost_Site14, _HeapHost_Site15,
+    _HeapHost_Site16, _HeapHost_Site17, _HeapHost_Site18, _HeapHost_Site19,
+    _HeapHost_Site20, _HeapHost_Site21, _HeapHost_Site22, _HeapHost_Site23,
+    _HeapHost_Site24, _HeapHost_Site25, _HeapHost_Site26, _HeapHost_Site27,
+    _HeapHost_Site28, _HeapHost_Site29, _HeapHost_Site30, _HeapHost_Site31,
+    _HeapHost_Site32, _HeapHost_Site33, _HeapHost_Site34, _HeapHost_Site35,
+    _HeapHost_Site36, _HeapHost_Site37, _HeapHost_Site38, _HeapHost_Site39,
+};
+
+// the site of a function: its return address from Sys_HeapAlloc
+static uint8_t _HeapHost_SiteOf(uint32_t u32Site, uint32_t u32Func)
+{
+    uint32_t u32Addr = (uint32_t)(uintptr_t)g_fpaHeapHostSite[u32Func];
+    uint32_t u32Next;
+    uint32_t i;
+
+    if ((u32Site <= u32Addr) || (u32Site >= u32Addr + HEAP_HOST_SITE_WINDOW))
+        return 0;
+
+    // the site functions may be closer than the window: the return address
+    // belongs to the last one that starts before it
+    for (i = 0; i < HEAP_HOST_SITE_FUNC_NUM; i++)
+    {
+        u32Next = (uint32_t)(uintptr_t)g_fpaHeapHostSite[i];
+
+        if ((u32Next > u32Addr) && (u32Next < u32Site))
+            return 0;
+    }
+
+    return 1;
+}
+
+static const S_SysHeapSite_t *_HeapHost_SiteFind(const S_SysHeapSite_t *ptSite, uint32_t u32Num, uint32_t u32Func)
+{
+    uint32_t i;
+
+    for (i = 0; i < u32Num; i++)
+    {
+        if (_HeapHost_SiteOf(ptSite[i].u32Site, u32Func))
+            return &ptSite[i];
+    }
+
+    return NULL;
+}
+
+static const S_SysHeapTask_t *_HeapHost_TaskFind(const S_SysHeapTask_t *ptTask, uint32_t u32Num, const char *sName)
+{
+    uint32_t i;
+
+    for (i = 0; i < u32Num; i++)
+    {
+        if (!strcmp(ptTask[i].baName, sName))
+            return &ptTask[i];
+    }
+
+    return NULL;
+}
+
+// every case starts and ends with the heap empty
+static void _HeapHost_Begin(uint8_t u8Track)
+{
+    Sys_HeapStatTrackSet(0);
+    Sys_HeapStatReset();
+    Sys_HeapStatTrackSet(u8Track);
+    Sys_HeapStatFailHookSet(NULL);
+}
+
+static uint32_t _HeapHost_Rand(uint32_t *pu32Seed)
+{
+    *pu32Seed = (*pu32Seed * 1103515245) + 12345;
+    return (*pu32Seed >> 16) & 0x7FFF;
+}
+
+/*
+ * Cases
+ */
+static void _HeapHost_Init(void)
+{
+    HOST_TEST_ASSERT(osMemoryAllocate == Sys_HeapAlloc);
+    HOST_TEST_ASSERT(osMemoryDeallocate == Sys_HeapFree);
+
+    // again: the wrappers are not stacked on themselves
+    Sys_HeapStatInit();
+
+    HOST_TEST_ASSERT(g_fpSysHeapAlloc == _HeapHost_Alloc);
+    HOST_TEST_ASSERT(g_fpSysHeapFree == _HeapHost_Free);
+}
+
+static void _HeapHost_Count(void)
+{
+    S_SysHeapStat_t tStat;
+    void *paPtr[10];
+    uint32_t i;
+
+    _HeapHost_Begin(0);
+
+    for (i = 0; i < HOST_TEST_NUM(paPtr); i++)
+    {
+        paPtr[i] = osMemoryAllocate(24 + (i * 8));
+        HOST_TEST_ASSERT(paPtr[i] != NULL);
+    }
+
+    HOST_TEST_ASSERT(xPortGetFreeHeapSize() < g_xHeapHostEmpty);
+
+    for (i = 0; i < HOST_TEST_NUM(paPtr); i++)
+        osMemoryDeallocate(paPtr[i]);
+
+    // free(NULL) passes through and is not counted
+    osMemoryDeallocate(NULL);
+
+    Sys_HeapStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Alloc, 10);
+    HOST_TEST_EQ(tStat.u32Free, 10);
+    HOST_TEST_EQ(tStat.u32Fail, 0);
+    HOST_TEST_EQ(tStat.u8Track, 0);
+    HOST_TEST_EQ(tStat.u32Live, 0);
+    HOST_TEST_EQ(tStat.u32Blocks, 0);
+    HOST_TEST_EQ(xPortGetFreeHeapSize(), g_xHeapHostEmpty);
+}
+
+// random allocations and frees: the live bytes, the blocks and the peak
+// follow the reference, every free finds its block
+static void _HeapHost_Churn(void)
+{
+    S_SysHeapStat_t tStat;
+    void *paPtr[HEAP_HOST_SLOT_NUM] = {0};
+    uint32_t u32aSize[HEAP_HOST_SLOT_NUM] = {0};
+    uint32_t u32Seed = 0x2018;
+    uint32_t u32Live = 0;
+    uint32_t u32Peak = 0;
+    uint32_t u32Blocks = 0;
+    uint32_t u32Alloc = 0;
+    uint32_t u32Slot;
+    uint32_t i;
+
+    _HeapHost_Begin(1);
+
+    for (i = 0; i < HEAP_HOST_CHURN; i++)
+    {
+        u32Slot = _HeapHost_Rand(&u32Seed) % HEAP_HOST_SLOT_NUM;
+
+        if (paPtr[u32Slot])
+        {
+            osMemoryDeallocate(paPtr[u32Slot]);
+            paPtr[u32Slot] = NULL;
+            u32Live -= u32aSize[u32Slot];
+            u32Blocks--;
+        }
+        else
+        {
+            u32aSize[u32Slot] = 1 + (_HeapHost_Rand(&u32Seed) % 256);
+            paPtr[u32Slot] = osMemoryAllocate(u32aSize[u32Slot]);
+            HOST_TEST_ASSERT(paPtr[u32Slot] != NULL);
+
+            u32Live += u32aSize[u32Slot];
+            u32Blocks++;
+            u32Alloc++;
+
+            if (u32Live > u32Peak)
+                u32Peak = u32Live;
+        }
+
+        Sys_HeapStatGet(&tStat);
+        HOST_TEST_EQ(tStat.u32Live, u32Live);
+        HOST_TEST_EQ(tStat.u32Blocks, u32Blocks);
+        HOST_TEST_EQ(tStat.u32Peak, u32Peak);
+    }
+
+    for (u32Slot = 0; u32Slot < HEAP_HOST_SLOT_NUM; u32Slot++)
+        osMemoryDeallocate(paPtr[u32Slot]);
+
+    Sys_HeapStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Alloc, u32Alloc);
+    HOST_TEST_EQ(tStat.u32Live, 0);
+    HOST_TEST_EQ(tStat.u32Blocks, 0);
+    HOST_TEST_EQ(tStat.u32Untracked, 0);
+    HOST_TEST_EQ(tStat.u32FreeUnknown, 0);
+    HOST_TEST_EQ(xPortGetFreeHeapSize(), g_xHeapHostEmpty);
+    HOST_TEST_EQ(_HeapHost_FreeBlockNum(), 1);
+
+    printf("    %u allocations, peak %u bytes, min-ever free %u\n",
+           u32Alloc, u32Peak, (uint32_t)xPortGetMinimumEverFreeHeapSize());
+}
+
+// more live blocks than the table: the rest are counted, not tracked
+static void _HeapHost_TableFull(void)
+{
+    S_SysHeapStat_t tStat;
+    void *paPtr[SYS_HEAP_STAT_BLOCK_NUM + 12];
+    uint32_t u32Over = HOST_TEST_NUM(paPtr) - (SYS_HEAP_STAT_BLOCK_NUM - 1);
+    uint32_t i;
+
+    _HeapHost_Begin(1);
+
+    for (i = 0; i < HOST_TEST_NUM(paPtr); i++)
+    {
+        paPtr[i] = osMemoryAllocate(16);
+        HOST_TEST_ASSERT(paPtr[i] != NULL);
+    }
+
+    Sys_HeapStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Blocks, SYS_HEAP_STAT_BLOCK_NUM - 1);
+    HOST_TEST_EQ(tStat.u32Live, (SYS_HEAP_STAT_BLOCK_NUM - 1) * 16);
+    HOST_TEST_EQ(tStat.u32Untracked, u32Over);
+
+    for (i = 0; i < HOST_TEST_NUM(paPtr); i++)
+        osMemoryDeallocate(paPtr[i]);
+
+    Sys_HeapStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Blocks, 0);
+    HOST_TEST_EQ(tStat.u32Live, 0);
+    HOST_TEST_EQ(tStat.u32FreeUnknown, u32Over);
+    HOST_TEST_EQ(xPortGetFreeHeapSize(), g_xHeapHostEmpty);
+}
+
+static void _HeapHost_Site(void)
+{
+    S_SysHeapSite_t taSite[SYS_HEAP_STAT_SITE_NUM + 1];
+    const S_SysHeapSite_t *ptSite = NULL;
+    void *paPtr[6];
+    void *paMany[HEAP_HOST_SITE_FUNC_NUM];
+    uint32_t u32Num;
+    uint32_t i;
+
+    _HeapHost_Begin(1);
+
+    paPtr[0] = _HeapHost_Site0(100);
+    paPtr[1] = _HeapHost_Site0(100);
+    paPtr[2] = _HeapHost_Site0(100);
+    paPtr[3] = _HeapHost_Site1(500);
+    paPtr[4] = _HeapHost_Site2(50);
+    paPtr[5] = _HeapHost_Site2(50);
+
+    // the most live bytes first
+    u32Num = Sys_HeapStatSiteGet(taSite, HOST_TEST_NUM(taSite));
+    HOST_TEST_EQ(u32Num, 3);
+    HOST_TEST_ASSERT(_HeapHost_SiteOf(taSite[0].u32Site, 1));
+    HOST_TEST_ASSERT(_HeapHost_SiteOf(taSite[1].u32Site, 0));
+    HOST_TEST_ASSERT(_HeapHost_SiteOf(taSite[2].u32Site, 2));
+    HOST_TEST_EQ(taSite[0].u32Live, 500);
+    HOST_TEST_EQ(taSite[1].u32Live, 300);
+    HOST_TEST_EQ(taSite[1].u32Blocks, 3);
+    HOST_TEST_EQ(taSite[1].u32Alloc, 3);
+    HOST_TEST_EQ(taSite[2].u32Live, 100);
+
+    // fewer entries asked: the first ones of the table, then sorted
+    HOST_TEST_EQ(Sys_HeapStatSiteGet(taSite, 1), 1);
+    HOST_TEST_ASSERT(_HeapHost_SiteOf(taSite[0].u32Site, 0));
+
+    for (i = 0; i < 3; i++)
+        osMemoryDeallocate(paPtr[i]);
+
+    u32Num = Sys_HeapStatSiteGet(taSite, HOST_TEST_NUM(taSite));
+    ptSite = _HeapHost_SiteFind(taSite, u32Num, 0);
+    HOST_TEST_ASSERT(ptSite != NULL);
+    HOST_TEST_EQ(ptSite->u32Live, 0);
+    HOST_TEST_EQ(ptSite->u32Peak, 300);
+    HOST_TEST_EQ(ptSite->u32Blocks, 0);
+    HOST_TEST_ASSERT(_HeapHost_SiteOf(taSite[u32Num - 1].u32Site, 0));
+
+    for (i = 3; i < HOST_TEST_NUM(paPtr); i++)
+        osMemoryDeallocate(paPtr[i]);
+
+    // more sites than the table: the rest sum in one entry of site 0
+    _HeapHost_Begin(1);
+
+    for (i = 0; i < HEAP_HOST_SITE_FUNC_NUM; i++)
+        paMany[i] = g_fpaHeapHostSite[i](8 + i);
+
+    u32Num = Sys_HeapStatSiteGet(taSite, HOST_TEST_NUM(taSite));
+    HOST_TEST_EQ(u32Num, SYS_HEAP_STAT_SITE_NUM + 1);
+
+    ptSite = NULL;
+
+    for (i = 0; i < u32Num; i++)
+    {
+        if (taSite[i].u32Site == 0)
+            ptSite = &taSite[i];
+    }
+
+    HOST_TEST_ASSERT(ptSite != NULL);
+    HOST_TEST_EQ(ptSite->u32Alloc, HEAP_HOST_SITE_FUNC_NUM - SYS_HEAP_STAT_SITE_NUM);
+    HOST_TEST_EQ(ptSite->u32Blocks, HEAP_HOST_SITE_FUNC_NUM - SYS_HEAP_STAT_SITE_NUM);
+
+    for (i = 0; i < SYS_HEAP_STAT_SITE_NUM; i++)
+    {
+        HOST_TEST_ASSERT(_HeapHost_SiteFind(taSite, u32Num, i) != NULL);
+        HOST_TEST_EQ(_HeapHost_SiteFind(taSite, u32Num, i)->u32Live, 8 + i);
+    }
+
+    for (i = 0; i < HEAP_HOST_SITE_FUNC_NUM; i++)
+        osMemoryDeallocate(paMany[i]);
+
+    u32Num = Sys_HeapStatSiteGet(taSite, HOST_TEST_NUM(taSite));
+
+    for (i = 0; i < u32Num; i++)
+        HOST_TEST_EQ(taSite[i].u32Live, 0);
+}
+
+static void _HeapHost_IsrAlloc(void *pArg)
+{
+    *(void **)pArg = osMemoryAllocate(40);
+}
+
+static void _HeapHost_ThreadMain(void *argument)
+{
+    uint32_t u32Idx = (uint32_t)(uintptr_t)argument;
+
+    g_paHeapHostThreadPtr[u32Idx] = osMemoryAllocate(100 * (u32Idx + 1));
+    osSemaphoreRelease(g_tHeapHostThreadSem);
+}
+
+static void _HeapHost_Task(void)
+{
+    static const char *saName[HEAP_HOST_THREAD_NUM] = {"wifi_mac", "lwip", "app"};
+    osSemaphoreDef_t tSemDef = {0};
+    osThreadDef_t tDef;
+    S_SysHeapTask_t taTask[SYS_HEAP_STAT_TASK_NUM];
+    const S_SysHeapTask_t *ptTask = NULL;
+    void *pInit = NULL;
+    void *pMain = NULL;
+    void *pIsr = NULL;
+    uint32_t u32Num;
+    uint32_t i;
+
+    _HeapHost_Begin(1);
+
+    // before the scheduler
+    pInit = osMemoryAllocate(10);
+
+    g_xHeapHostScheduler = taskSCHEDULER_RUNNING;
+    pMain = osMemoryAllocate(20);
+    HostOs_IsrRun(_HeapHost_IsrAlloc, &pIsr);
+
+    // binary, created free as in CMSIS-RTOS: taken first
+    g_tHeapHostThreadSem = osSemaphoreCreate(&tSemDef, 1);
+    HOST_TEST_ASSERT(g_tHeapHostThreadSem != NULL);
+    HOST_TEST_EQ(osSemaphoreWait(g_tHeapHostThreadSem, 0), osOK);
+
+    // one after the other, so the tasks come in this order
+    for (i = 0; i < HEAP_HOST_THREAD_NUM; i++)
+    {
+        memset(&tDef, 0, sizeof(tDef));
+        tDef.name = (char *)saName[i];
+        tDef.pthread = _HeapHost_ThreadMain;
+
+        HOST_TEST_ASSERT(osThreadCreate(&tDef, (void *)(uintptr_t)i) != NULL);
+        HOST_TEST_EQ(osSemaphoreWait(g_tHeapHostThreadSem, 5000), osOK);
+        HOST_TEST_ASSERT(g_paHeapHostThreadPtr[i] != NULL);
+    }
+
+    u32Num = Sys_HeapStatTaskGet(taTask, HOST_TEST_NUM(taTask));
+    HOST_TEST_EQ(u32Num, 3 + HEAP_HOST_THREAD_NUM);
+    HOST_TEST_ASSERT(!strcmp(taTask[0].baName, "(init)"));
+    HOST_TEST_ASSERT(taTask[0].pHandle == NULL);
+    HOST_TEST_EQ(taTask[0].u32Live, 10);
+    HOST_TEST_ASSERT(!strcmp(taTask[1].baName, "main"));
+    HOST_TEST_EQ(taTask[1].u32Live, 20);
+    HOST_TEST_ASSERT(!strcmp(taTask[2].baName, "(isr)"));
+    HOST_TEST_ASSERT(taTask[2].pHandle == SYS_HEAP_STAT_HANDLE_ISR);
+    HOST_TEST_EQ(taTask[2].u32Live, 40);
+
+    for (i = 0; i < HEAP_HOST_THREAD_NUM; i++)
+    {
+        HOST_TEST_ASSERT(!strcmp(taTask[3 + i].baName, saName[i]));
+        HOST_TEST_EQ(taTask[3 + i].u32Live, 100 * (i + 1));
+    }
+
+    // a block freed by another task is taken off its owner
+    for (i = 0; i < HEAP_HOST_THREAD_NUM; i++)
+        osMemoryDeallocate(g_paHeapHostThreadPtr[i]);
+
+    osMemoryDeallocate(pIsr);
+    osMemoryDeallocate(pMain);
+    osMemoryDeallocate(pInit);
+
+    u32Num = Sys_HeapStatTaskGet(taTask, HOST_TEST_NUM(taTask));
+
+    for (i = 0; i < u32Num; i++)
+        HOST_TEST_EQ(taTask[i].u32Live, 0);
+
+    ptTask = _HeapHost_TaskFind(taTask, u32Num, "app");
+    HOST_TEST_ASSERT(ptTask != NULL);
+    HOST_TEST_EQ(ptTask->u32Peak, 300);
+
+    osSemaphoreDelete(g_tHeapHostThreadSem);
+    g_xHeapHostScheduler = taskSCHEDULER_NOT_STARTED;
+}
+
+static void _HeapHost_FailHook(uint32_t u32Size, uint32_t u32Site)
+{
+    g_u32HeapHostHookNum++;
+    g_u32HeapHostHookSize = u32Size;
+    g_u32HeapHostHookSite = u32Site;
+
+    // a failure inside the hook is counted, the hook is not entered again
+    HOST_TEST_ASSERT(osMemoryAllocate(HEAP_HOST_SIZE * 2) == NULL);
+}
+
+static void _HeapHost_Fail(void)
+{
+    S_SysHeapStat_t tStat;
+    void *pPtr = NULL;
+
+    _HeapHost_Begin(0);
+    g_u32HeapHostHookNum = 0;
+    Sys_HeapStatFailHookSet(_HeapHost_FailHook);
+
+    pPtr = _HeapHost_Site5(HEAP_HOST_SIZE);
+    HOST_TEST_ASSERT(pPtr == NULL);
+
+    Sys_HeapStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Fail, 2);
+    HOST_TEST_EQ(tStat.u32Alloc, 0);
+    HOST_TEST_EQ(g_u32HeapHostHookNum, 1);
+    HOST_TEST_EQ(g_u32HeapHostHookSize, HEAP_HOST_SIZE);
+    HOST_TEST_ASSERT(_HeapHost_SiteOf(g_u32HeapHostHookSite, 5));
+
+    // the last one is the failure inside the hook
+    HOST_TEST_EQ(tStat.tLastFail.u32Size, HEAP_HOST_SIZE * 2);
+    HOST_TEST_EQ(tStat.tLastFail.u32Free, g_xHeapHostEmpty);
+    HOST_TEST_ASSERT(!strcmp(tStat.tLastFail.baTask, "(init)"));
+
+    // without a hook
+    Sys_HeapStatFailHookSet(NULL);
+    HOST_TEST_ASSERT(_HeapHost_Site6(HEAP_HOST_SIZE) == NULL);
+
+    Sys_HeapStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Fail, 3);
+    HOST_TEST_EQ(g_u32HeapHostHookNum, 1);
+    HOST_TEST_EQ(tStat.tLastFail.u32Size, HEAP_HOST_SIZE);
+    HOST_TEST_ASSERT(_HeapHost_SiteOf(tStat.tLastFail.u32Site, 6));
+}
+
+// the largest free block by probing equals the walk of the free list
+static void _HeapHost_Largest(void)
+{
+    void *paPtr[48];
+    uint32_t u32MinEver = xPortGetMinimumEverFreeHeapSize();
+    uint32_t u32Largest;
+    uint32_t u32Free;
+    uint32_t u32Frag;
+    uint32_t i;
+
+    _HeapHost_Begin(0);
+
+    u32Largest = Sys_HeapLargestFree();
+    HOST_TEST_EQ(u32Largest, _HeapHost_LargestWalk());
+    HOST_TEST_EQ(u32Largest, g_xHeapHostEmpty - HEAP_HOST_HDR);
+    // one block: only its header is not given
+    HOST_TEST_ASSERT(Sys_HeapFragPermille(xPortGetFreeHeapSize(), u32Largest) <= 1);
+
+    // the scheduler is resumed
+    HOST_TEST_EQ(g_u32HeapHostSuspend, 0);
+    HOST_TEST_EQ(HostOs_IrqGet(), 0);
+
+    // the probe is the minimum of heap_4 now, not the one reported
+    HOST_TEST_ASSERT(xPortGetMinimumEverFreeHeapSize() < HEAP_HOST_MIN_BLOCK);
+    HOST_TEST_EQ(Sys_HeapMinEverFree(), u32MinEver);
+
+    for (i = 0; i < HOST_TEST_NUM(paPtr); i++)
+    {
+        paPtr[i] = osMemoryAllocate(400);
+        HOST_TEST_ASSERT(paPtr[i] != NULL);
+    }
+
+    HOST_TEST_ASSERT(xPortGetFreeHeapSize() < u32MinEver);
+    HOST_TEST_EQ(Sys_HeapMinEverFree(), xPortGetFreeHeapSize());
+
+    // holes of 400 bytes between the blocks kept
+    for (i = 0; i < HOST_TEST_NUM(paPtr); i += 2)
+    {
+        osMemoryDeallocate(paPtr[i]);
+        paPtr[i] = NULL;
+    }
+
+    u32Free = xPortGetFreeHeapSize();
+    u32Largest = Sys_HeapLargestFree();
+    u32Frag = Sys_HeapFragPermille(u32Free, u32Largest);
+
+    HOST_TEST_EQ(u32Largest, _HeapHost_LargestWalk());
+    HOST_TEST_EQ(u32Frag, 1000 - ((u32Largest * 1000) / u32Free));
+    HOST_TEST_ASSERT(u32Frag > 500);
+
+    // the probing leaves the heap as it was
+    HOST_TEST_EQ(xPortGetFreeHeapSize(), u32Free);
+    HOST_TEST_EQ(Sys_HeapMinEverFree(), g_xHeapHostEmpty - (HOST_TEST_NUM(paPtr) * (400 + HEAP_HOST_HDR)));
+
+    printf("    free %u in %u blocks, largest %u, frag %u.%u%%\n",
+           u32Free, _HeapHost_FreeBlockNum(), u32Largest, u32Frag / 10, u32Frag % 10);
+
+    for (i = 1; i < HOST_TEST_NUM(paPtr); i += 2)
+        osMemoryDeallocate(paPtr[i]);
+
+    // merged back into one block
+    HOST_TEST_EQ(_HeapHost_FreeBlockNum(), 1);
+    HOST_TEST_EQ(Sys_HeapLargestFree(), g_xHeapHostEmpty - HEAP_HOST_HDR);
+
+    HOST_TEST_EQ(Sys_HeapFragPermille(0, 0), 0);
+    HOST_TEST_EQ(Sys_HeapFragPermille(1000, 1000), 0);
+    HOST_TEST_EQ(Sys_HeapFragPermille(1000, 250), 750);
+    HOST_TEST_EQ(Sys_HeapFragPermille(1000, 1), 999);
+}
+
+static void _HeapHost_Reset(void)
+{
+    S_SysHeapStat_t tStat;
+    void *paPtr[5];
+    uint32_t i;
+
+    _HeapHost_Begin(1);
+
+    for (i = 0; i < HOST_TEST_NUM(paPtr); i++)
+        paPtr[i] = osMemoryAllocate(32);
+
+    // stopped: the reports stay as they were
+    Sys_HeapStatTrackSet(0);
+    Sys_HeapStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u8Track, 0);
+    HOST_TEST_EQ(tStat.u32Live, 5 * 32);
+    HOST_TEST_EQ(tStat.u32Blocks, 5);
+
+    // started again: from empty tables, the blocks before are not known
+    Sys_HeapStatTrackSet(1);
+    Sys_HeapStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Live, 0);
+    HOST_TEST_EQ(tStat.u32Alloc, 0);
+
+    osMemoryDeallocate(paPtr[0]);
+
+    // on while on: no reset
+    Sys_HeapStatTrackSet(1);
+    Sys_HeapStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32Free, 1);
+    HOST_TEST_EQ(tStat.u32FreeUnknown, 1);
+
+    for (i = 1; i < HOST_TEST_NUM(paPtr); i++)
+        osMemoryDeallocate(paPtr[i]);
+
+    Sys_HeapStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u32FreeUnknown, 5);
+    HOST_TEST_EQ(tStat.u32Live, 0);
+    HOST_TEST_EQ(xPortGetFreeHeapSize(), g_xHeapHostEmpty);
+}
+
+static void _HeapHost_Cmd(void)
+{
+    S_SysHeapStat_t tStat;
+    char baStat[] = "heap";
+    char baSite[] = "heap site";
+    char baTask[] = "heap task";
+    char baOn[] = "heap track on";
+    char baOff[] = "heap track off";
+    char baReset[] = "heap track reset";
+    char baBad[] = "heap track x";
+    void *pPtr = NULL;
+
+    _HeapHost_Begin(0);
+
+    Sys_HeapStatCmd(baOn);
+    Sys_HeapStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u8Track, 1);
+
+    pPtr = _HeapHost_Site3(64);
+
+    Sys_HeapStatCmd(baStat);
+    Sys_HeapStatCmd(baSite);
+    Sys_HeapStatCmd(baTask);
+
+    Sys_HeapStatCmd(baReset);
+    Sys_HeapStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u8Track, 1);
+    HOST_TEST_EQ(tStat.u32Live, 0);
+
+    Sys_HeapStatCmd(baOff);
+    Sys_HeapStatCmd(baBad);
+    Sys_HeapStatGet(&tStat);
+    HOST_TEST_EQ(tStat.u8Track, 0);
+
+    osMemoryDeallocate(pPtr);
+}
+
+static const T_HostTestCase g_taHeapHostCase[] =
+{
+    HOST_TEST_CASE(_HeapHost_Init),
+    HOST_TEST_CASE(_HeapHost_Count),
+    HOST_TEST_CASE(_HeapHost_Churn),
+    HOST_TEST_CASE(_HeapHost_TableFull),
+    HOST_TEST_CASE(_HeapHost_Site),
+    HOST_TEST_CASE(_HeapHost_Task),
+    HOST_TEST_CASE(_HeapHost_Fail),
+    HOST_TEST_CASE(_HeapHost_Largest),
+    HOST_TEST_CASE(_HeapHost_Reset),
+    HOST_TEST_CASE(_HeapHost_Cmd),
+};
+
+int main(void)
+{
+    HostOs_Init();
+
+    // heap_4 under the CMSIS-RTOS allocation, as in the ROM
+    _HeapHost_HeapInit();
+    osMemoryAllocate = _HeapHost_Alloc;
+    osMemoryDeallocate = _HeapHost_Free;
+
+    Sys_HeapStatInit();
+
+    return HostTest_Run("sys_heap_stat", g_taHeapHostCase, HOST_TEST_NUM(g_taHeapHostCase));
+}
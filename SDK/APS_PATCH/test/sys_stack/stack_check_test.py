@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+###############################################################################
+#  Copyright 2017 - 2018, Opulinks Technology Ltd.
+#  ----------------------------------------------------------------------------
+#  Statement:
+#  ----------
+#  This software is protected by Copyright and the information contained
+#  herein is confidential. The software may not be copied and the information
+#  contained herein may not be used or disclosed except with the written
+#  permission of Opulinks Technology Ltd. (C) 2018
+###############################################################################
+#
+# tools/stack_check.py on a callgraph and sources made by the test: a ROM
+# header and a patch header that overrides it, tasks made by osThreadDef_t with
+# a macro, a number and a cast, and the armlink records of their entries.
+###############################################################################
+
+import io
+import os
+import sys
+import tempfile
+import unittest
+from contextlib import redirect_stdout
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'tools'))
+import stack_check
+
+ROM_H = '''
+#define OS_TASK_STACK_SIZE_APP          (512)
+#define OS_TASK_STACK_SIZE_SVC          (128)
+#define OS_TASK_NAME_APP                "opl_app"
+'''
+
+PATCH_H = '''
+#undef OS_TASK_STACK_SIZE_SVC
+#define OS_TASK_STACK_SIZE_SVC          (64)        // the patch one wins
+#define OS_TASK_NAME_SVC                "svc"
+'''
+
+TASK_C = '''
+void Task_Init(void)
+{
+    osThreadDef_t tThreadDef;
+    osThreadDef_t task_def;
+
+    tThreadDef.name = OS_TASK_NAME_APP;
+    tThreadDef.pthread = App_Task;
+    tThreadDef.stacksize = OS_TASK_STACK_SIZE_APP;      // (512), unit: 4-byte
+    osThreadCreate(&tThreadDef, NULL);
+
+    tThreadDef.name = OS_TASK_NAME_SVC;
+    tThreadDef.pthread = (os_pthread) Svc_Task;
+    tThreadDef.stacksize = OS_TASK_STACK_SIZE_SVC;
+    osThreadCreate(&tThreadDef, NULL);
+
+    task_def.name = "deep";
+    task_def.pthread = Deep_Task;
+    task_def.stacksize = 0x40;
+    osThreadCreate(&task_def, NULL);
+
+    task_def.name = "rom";
+    task_def.pthread = Rom_Task;
+    task_def.stacksize = 256;
+    osThreadCreate(&task_def, NULL);
+}
+'''
+
+CALLGRAPH = '''<HTML><BODY>
+<H3>Maximum Stack Usage = 600 bytes + Unknown(Cycles, Untraceable Function Pointers)</H3>
+<P><STRONG><a name="[10]"></a>App_Task</STRONG> (Thumb, 96 bytes, Stack size 32 bytes, app.o(.text))
+<BR><BR>[Stack]<UL><LI>Max Depth = 600<LI>Call Chain = App_Task &rArr; App_Work &rArr; memcpy
+</UL>
+<BR>[Calls]<UL><LI><a href="#[11]">&gt;&gt;</a>&nbsp;&nbsp;&nbsp;App_Work
+</UL>
+<P><STRONG><a name="[12]"></a>Svc_Task</STRONG> (Thumb, 40 bytes, Stack size 16 bytes, svc.o(.text))
+<BR><BR>[Stack]<UL><LI>Max Depth = 200 + Unknown Stack Size<LI>Call Chain = Svc_Task &rArr; Svc_Run
+</UL>
+<P><STRONG><a name="[13]"></a>Deep_Task</STRONG> (Thumb, 60 bytes, Stack size 8 bytes, deep.o(.text))
+<BR><BR>[Stack]<UL><LI>Max Depth = 280 + In Cycle<LI>Call Chain = Deep_Task &rArr; Deep_Walk &rArr; Deep_Walk
+</UL>
+<P><STRONG><a name="[14]"></a>Leaf</STRONG> (Thumb, 12 bytes, Stack size 8 bytes, leaf.o(.text))
+<P><STRONG><a name="[15]"></a>Asm</STRONG> (Thumb, 0 bytes, Stack size unknown bytes, asm.o(.text))
+</BODY></HTML>
+'''
+
+
+def _write(path, text):
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, 'w') as f:
+        f.write(text)
+
+
+class StackCheckTest(unittest.TestCase):
+    def setUp(self):
+        self.tmp = tempfile.TemporaryDirectory()
+        d = self.tmp.name
+        self.rom = os.path.join(d, 'APS')
+        self.patch = os.path.join(d, 'APS_PATCH')
+        self.htm = os.path.join(d, 'opl1000_app_m3.htm')
+        _write(os.path.join(self.rom, 'include', 'sys_os_config.h'), ROM_H)
+        _write(os.path.join(self.patch, 'include', 'sys_os_config_patch.h'), PATCH_H)
+        _write(os.path.join(self.patch, 'app', 'task.c'), TASK_C)
+        _write(self.htm, CALLGRAPH)
+
+    def tearDown(self):
+        self.tmp.cleanup()
+
+    def _run(self, *argv):
+        out = io.StringIO()
+        with redirect_stdout(out):
+            rc = stack_check.main([self.htm, '--src', self.rom, '--src', self.patch] + list(argv))
+        rows = {}
+        for line in out.getvalue().splitlines()[1:]:
+            cols = line.split()
+            rows[cols[0]] = cols
+        return rc, rows
+
+    def test_callgraph(self):
+        funcs = stack_check.callgraph_parse(CALLGRAPH)
+        self.assertEqual(funcs['App_Task'].depth, 600)
+        self.assertFalse(funcs['App_Task'].unknown)
+        self.assertEqual(funcs['App_Task'].chain, 'App_Task -> App_Work -> memcpy')
+        self.assertTrue(funcs['Svc_Task'].unknown)
+        self.assertTrue(funcs['Deep_Task'].unknown)
+        self.assertEqual(funcs['Leaf'].depth, 8)                # no [Stack], only its own frame
+        self.assertIsNone(funcs['Asm'].depth)
+
+    def test_tasks(self):
+        macros = stack_check.macros_load([self.rom, self.patch])
+        tasks = {t.name: t for t in stack_check.tasks_scan([self.patch], macros)}
+        self.assertEqual(sorted(tasks), ['deep', 'opl_app', 'rom', 'svc'])
+        self.assertEqual((tasks['opl_app'].entry, tasks['opl_app'].words), ('App_Task', 512))
+        self.assertEqual((tasks['svc'].entry, tasks['svc'].words), ('Svc_Task', 64))
+        self.assertEqual((tasks['deep'].entry, tasks['deep'].words), ('Deep_Task', 64))
+        self.assertEqual(tasks['rom'].words, 256)
+
+    def test_check(self):
+        # 2048 >= 600 + 64, 256 < 200 + 64, 256 < 280 + 64
+        rc, rows = self._run()
+        self.assertEqual(rc, 1)
+        self.assertEqual(rows['opl_app'][2:5], ['2048', '664', 'OK'])
+        self.assertEqual(rows['svc'][2:5], ['256', '264+?', 'LOW'])
+        self.assertEqual(rows['deep'][2:5], ['256', '344+?', 'LOW'])
+        self.assertNotIn('rom', rows)
+
+    def test_margin_strict(self):
+        rc, rows = self._run('--margin', '0', '--task', 'deep=Deep_Task:128')
+        self.assertEqual(rc, 0)
+        self.assertEqual(rows['svc'][4], 'OK')
+        self.assertEqual(rows['deep'][2:5], ['512', '280+?', 'OK'])
+
+        rc, rows = self._run('--margin', '0', '--task', 'deep=Deep_Task:128', '--strict')
+        self.assertEqual(rc, 1)
+
+    def test_all(self):
+        rc, rows = self._run('--all')
+        self.assertEqual(rows['rom'][3:5], ['-', '-'])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,674 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_stack_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The stack high-water marks of sys_stack.c on simulated tasks.
+*
+*  The test is the kernel: osThreadCreate makes a task control block with
+*  the head of the V9.0.0 one and a stack filled with 0xA5 as the kernel
+*  does with configCHECK_FOR_STACK_OVERFLOW 2, and pcTaskGetName reads the
+*  name from it. A task "runs" by writing its stack from the top down to a
+*  depth and leaving it dirty when it returns, as calls do. The marks are
+*  checked against the deepest point of every task, then the warning, the
+*  worst cases in a RAM MW_FIM and the periodic check of the timer task.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmsis_os.h"
+#include "mw_fim.h"
+#include "mw_fim_default_group01_patch.h"
+#include "sys_stack.h"
+#include "host_os.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define STACK_HOST_TCB_NUM          (SYS_STACK_TASK_NUM + 4)
+#define STACK_HOST_WORKLOAD         (400)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    // the head of the TCB of V9.0.0, as sys_stack.c reads it
+    volatile StackType_t *pxTopOfStack;
+    ListItem_t xStateListItem;
+    ListItem_t xEventListItem;
+    UBaseType_t uxPriority;
+    StackType_t *pxStack;
+    char pcTaskName[configMAX_TASK_NAME_LEN];
+
+    // the simulation
+    uint8_t u8Used;
+    uint8_t u8Other;                // the name is not in the TCB: another layout
+    char baOther[configMAX_TASK_NAME_LEN];
+    uint32_t u32Size;               // words
+    uint32_t u32Deepest;            // words ever written from the top
+} T_StackHostTcb;
+
+typedef struct
+{
+    S_SysStackRecord_t taRecord[SYS_STACK_RECORD_NUM];
+    uint32_t u32Write;
+    uint8_t u8WriteFail;
+} T_StackHostFim;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+T_MwFim_FileRead_Fp MwFim_FileRead;
+T_MwFim_FileWrite_Fp MwFim_FileWrite;
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_StackHostTcb g_taStackHostTcb[STACK_HOST_TCB_NUM];
+static T_StackHostTcb *g_ptStackHostCurr;
+static uint32_t g_u32StackHostTerminate;
+
+static T_StackHostFim g_tStackHostFim;
+
+static os_ptimer g_fpStackHostTimer;
+static uint32_t g_u32StackHostTimerMs;
+
+// Sec 7: declaration of static function prototype
+
+/***********************************************************************
+*  Sec 8: C Functions
+***********************************************************************/
+
+/*
+ * Kernel and MW_FIM
+ */
+char *pcTaskGetName(TaskHandle_t xTaskToQuery)
+{
+    T_StackHostTcb *ptTcb = (T_StackHostTcb *)xTaskToQuery;
+
+    if (ptTcb == NULL)
+        ptTcb = g_ptStackHostCurr;
+
+    return (ptTcb->u8Other) ? ptTcb->baOther : ptTcb->pcTaskName;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)g_ptStackHostCurr;
+}
+
+static T_StackHostTcb *_StackHost_TcbNew(const char *sName, uint32_t u32Size)
+{
+    T_StackHostTcb *ptTcb = NULL;
+    uint32_t i;
+
+    for (i = 0; i < STACK_HOST_TCB_NUM; i++)
+    {
+        if (!g_taStackHostTcb[i].u8Used)
+        {
+            ptTcb = &g_taStackHostTcb[i];
+            break;
+        }
+    }
+
+    if (ptTcb == NULL)
+        return NULL;
+
+    memset(ptTcb, 0, sizeof(T_StackHostTcb));
+    ptTcb->u8Used = 1;
+    ptTcb->u32Size = u32Size;
+    strncpy(ptTcb->pcTaskName, sName, configMAX_TASK_NAME_LEN - 1);
+
+    // prvInitialiseNewTask: the whole stack is the fill, the top is the last word
+    ptTcb->pxStack = (StackType_t *)malloc(u32Size * sizeof(StackType_t));
+    memset(ptTcb->pxStack, 0xA5, u32Size * sizeof(StackType_t));
+    ptTcb->pxTopOfStack = ptTcb->pxStack + u32Size - 1;
+
+    return ptTcb;
+}
+
+static void _StackHost_TcbFree(T_StackHostTcb *ptTcb)
+{
+    free(ptTcb->pxStack);
+    memset(ptTcb, 0, sizeof(T_StackHostTcb));
+}
+
+static osThreadId _StackHost_ThreadCreate(const osThreadDef_t *thread_def, void *argument)
+{
+    return (osThreadId)_StackHost_TcbNew(thread_def->name, thread_def->stacksize);
+}
+
+static osStatus _StackHost_ThreadTerminate(osThreadId thread_id)
+{
+    g_u32StackHostTerminate++;
+    _StackHost_TcbFree((T_StackHostTcb *)thread_id);
+    return osOK;
+}
+
+static osTimerId _StackHost_TimerCreate(const osTimerDef_t *timer_def, os_timer_type type, void *argument)
+{
+    g_fpStackHostTimer = timer_def->ptimer;
+    return (osTimerId)&g_fpStackHostTimer;
+}
+
+static osStatus _StackHost_TimerStart(osTimerId timer_id, uint32_t millisec)
+{
+    g_u32StackHostTimerMs = millisec;
+    return osOK;
+}
+
+static uint8_t _StackHost_FimRead(uint32_t ulFileId, uint16_t uwRecIdx, uint16_t uwFileSize, uint8_t *pubFileData)
+{
+    if ((ulFileId != MW_FIM_IDX_GP01_STACK_PEAK) || (uwRecIdx >= MW_FIM_STACK_PEAK_NUM) ||
+        (uwFileSize != MW_FIM_STACK_PEAK_SIZE))
+        return MW_FIM_FAIL;
+
+    memcpy(pubFileData, &g_tStackHostFim.taRecord[uwRecIdx], uwFileSize);
+    return MW_FIM_OK;
+}
+
+static uint8_t _StackHost_FimWrite(uint32_t ulFileId, uint16_t uwRecIdx, uint16_t uwFileSize, uint8_t *pubFileData)
+{
+    if ((ulFileId != MW_FIM_IDX_GP01_STACK_PEAK) || (uwRecIdx >= MW_FIM_STACK_PEAK_NUM) ||
+        (uwFileSize != MW_FIM_STACK_PEAK_SIZE) || (g_tStackHostFim.u8WriteFail))
+        return MW_FIM_FAIL;
+
+    memcpy(&g_tStackHostFim.taRecord[uwRecIdx], pubFileData, uwFileSize);
+    g_tStackHostFim.u32Write++;
+    return MW_FIM_OK;
+}
+
+/*
+ * The simulation
+ */
+static T_StackHostTcb *_StackHost_Create(const char *sName, uint32_t u32Size)
+{
+    osThreadDef_t tDef;
+
+    memset(&tDef, 0, sizeof(tDef));
+    tDef.name = (char *)sName;
+    tDef.stacksize = u32Size;
+
+    return (T_StackHostTcb *)osThreadCreate(&tDef, NULL);
+}
+
+// the task goes u32Depth words deep: the frames are written, and stay so
+// when they return
+static void _StackHost_Run(T_StackHostTcb *ptTcb, uint32_t u32Depth)
+{
+    uint32_t i;
+
+    g_ptStackHostCurr = ptTcb;
+
+    for (i = ptTcb->u32Size - u32Depth; i < ptTcb->u32Size; i++)
+    {
+        if (ptTcb->pxStack[i] == SYS_STACK_FILL)
+            ptTcb->pxStack[i] = 0x20000000 | i;
+    }
+
+    if (u32Depth > ptTcb->u32Deepest)
+        ptTcb->u32Deepest = u32Depth;
+}
+
+static const S_SysStackTask_t *_StackHost_Find(const S_SysStackTask_t *ptTask, uint32_t u32Num, const T_StackHostTcb *ptTcb)
+{
+    uint32_t i;
+
+    for (i = 0; i < u32Num; i++)
+    {
+        if (ptTask[i].pHandle == (void *)ptTcb)
+            return &ptTask[i];
+    }
+
+    return NULL;
+}
+
+static const S_SysStackRecord_t *_StackHost_Record(const char *sName)
+{
+    static S_SysStackRecord_t taRecord[SYS_STACK_RECORD_NUM];
+    uint32_t u32Num;
+    uint32_t i;
+
+    u32Num = Sys_StackRecordGet(taRecord, SYS_STACK_RECORD_NUM);
+
+    for (i = 0; i < u32Num; i++)
+    {
+        if (!strcmp(taRecord[i].baName, sName))
+            return &taRecord[i];
+    }
+
+    return NULL;
+}
+
+// every case ends with its tasks gone
+static void _StackHost_End(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < STACK_HOST_TCB_NUM; i++)
+    {
+        if (g_taStackHostTcb[i].u8Used)
+            osThreadTerminate((osThreadId)&g_taStackHostTcb[i]);
+    }
+
+    g_ptStackHostCurr = NULL;
+}
+
+static uint32_t _StackHost_Rand(uint32_t *pu32Seed)
+{
+    *pu32Seed = (*pu32Seed * 1103515245) + 12345;
+    return (*pu32Seed >> 16) & 0x7FFF;
+}
+
+/*
+ * Cases
+ */
+static void _StackHost_Add(void)
+{
+    S_SysStackTask_t taTask[SYS_STACK_TASK_NUM];
+    T_StackHostTcb *ptaTcb[3];
+    uint32_t u32Num;
+    uint32_t i;
+
+    HOST_TEST_ASSERT(osThreadCreate != _StackHost_ThreadCreate);
+
+    ptaTcb[0] = _StackHost_Create("wifi_mac", 512);
+    ptaTcb[1] = _StackHost_Create("lwip", 512);
+    ptaTcb[2] = _StackHost_Create("app", 256);
+
+    u32Num = Sys_StackTaskGet(taTask, HOST_TEST_NUM(taTask));
+    HOST_TEST_EQ(u32Num, 3);
+    HOST_TEST_EQ(Sys_StackTaskGet(NULL, 0), 3);
+
+    for (i = 0; i < 3; i++)
+    {
+        HOST_TEST_ASSERT(taTask[i].pHandle == (void *)ptaTcb[i]);
+        HOST_TEST_ASSERT(taTask[i].pu32Base == (uint32_t *)ptaTcb[i]->pxStack);
+        HOST_TEST_EQ(taTask[i].u32Size, ptaTcb[i]->u32Size);
+        HOST_TEST_EQ(taTask[i].u32Peak, 0);
+        HOST_TEST_ASSERT(!strcmp(taTask[i].baName, ptaTcb[i]->pcTaskName));
+    }
+
+    // a size update keeps one entry
+    HOST_TEST_EQ(Sys_StackTaskAdd(ptaTcb[2], 300), 0);
+    u32Num = Sys_StackTaskGet(taTask, HOST_TEST_NUM(taTask));
+    HOST_TEST_EQ(u32Num, 3);
+    HOST_TEST_EQ(taTask[2].u32Size, 300);
+
+    // osThreadTerminate takes the task off, then ends it
+    g_u32StackHostTerminate = 0;
+    osThreadTerminate((osThreadId)ptaTcb[0]);
+    HOST_TEST_EQ(g_u32StackHostTerminate, 1);
+
+    u32Num = Sys_StackTaskGet(taTask, HOST_TEST_NUM(taTask));
+    HOST_TEST_EQ(u32Num, 2);
+    HOST_TEST_ASSERT(_StackHost_Find(taTask, u32Num, ptaTcb[0]) == NULL);
+    HOST_TEST_ASSERT(_StackHost_Find(taTask, u32Num, ptaTcb[1]) != NULL);
+    HOST_TEST_ASSERT(_StackHost_Find(taTask, u32Num, ptaTcb[2]) != NULL);
+
+    _StackHost_End();
+    HOST_TEST_EQ(Sys_StackTaskGet(NULL, 0), 0);
+}
+
+// tasks made by xTaskCreate are added by hand, the calling one by NULL
+static void _StackHost_AddByHand(void)
+{
+    S_SysStackTask_t taTask[SYS_STACK_TASK_NUM];
+    T_StackHostTcb *ptTcb = _StackHost_TcbNew("ble_host", 400);
+    T_StackHostTcb *ptOther = _StackHost_TcbNew("other", 64);
+
+    g_ptStackHostCurr = ptTcb;
+    HOST_TEST_EQ(Sys_StackTaskAdd(NULL, 0), 0);
+    HOST_TEST_EQ(Sys_StackTaskGet(taTask, HOST_TEST_NUM(taTask)), 1);
+    HOST_TEST_ASSERT(taTask[0].pHandle == (void *)ptTcb);
+    HOST_TEST_EQ(taTask[0].u32Size, 0);
+
+    // size unknown: not checked
+    _StackHost_Run(ptTcb, 200);
+    HOST_TEST_EQ(Sys_StackCheck(), 0);
+    HOST_TEST_EQ(Sys_StackTaskGet(taTask, HOST_TEST_NUM(taTask)), 1);
+    HOST_TEST_EQ(taTask[0].u32Peak, 0);
+
+    HOST_TEST_EQ(Sys_StackTaskAdd(ptTcb, 400), 0);
+    Sys_StackCheck();
+    Sys_StackTaskGet(taTask, HOST_TEST_NUM(taTask));
+    HOST_TEST_EQ(taTask[0].u32Peak, 200);
+
+    // the name is not where this layout has it: refused
+    ptOther->u8Other = 1;
+    strcpy(ptOther->baOther, "other");
+    HOST_TEST_EQ(Sys_StackTaskAdd(ptOther, 64), -1);
+    HOST_TEST_EQ(Sys_StackTaskGet(NULL, 0), 1);
+
+    Sys_StackTaskDel(NULL);
+    HOST_TEST_EQ(Sys_StackTaskGet(NULL, 0), 0);
+
+    _StackHost_TcbFree(ptTcb);
+    _StackHost_TcbFree(ptOther);
+    g_ptStackHostCurr = NULL;
+}
+
+static void _StackHost_Full(void)
+{
+    char baName[configMAX_TASK_NAME_LEN];
+    uint32_t i;
+
+    for (i = 0; i < SYS_STACK_TASK_NUM; i++)
+    {
+        snprintf(baName, sizeof(baName), "task%u", i);
+        HOST_TEST_ASSERT(_StackHost_Create(baName, 128) != NULL);
+    }
+
+    HOST_TEST_EQ(Sys_StackTaskGet(NULL, 0), SYS_STACK_TASK_NUM);
+
+    // created, not checked
+    HOST_TEST_ASSERT(_StackHost_Create("late", 128) != NULL);
+    HOST_TEST_EQ(Sys_StackTaskGet(NULL, 0), SYS_STACK_TASK_NUM);
+
+    _StackHost_End();
+    HOST_TEST_EQ(Sys_StackTaskGet(NULL, 0), 0);
+}
+
+// random workloads: the mark is the deepest point of each task, also the
+// points between two checks
+static void _StackHost_Mark(void)
+{
+    static const uint32_t u32aSize[] = {128, 256, 512, 1024, 200};
+    S_SysStackTask_t taTask[SYS_STACK_TASK_NUM];
+    const S_SysStackTask_t *ptTask = NULL;
+    T_StackHostTcb *ptaTcb[HOST_TEST_NUM(u32aSize)];
+    char baName[configMAX_TASK_NAME_LEN];
+    uint32_t u32Seed = 0x1000;
+    uint32_t u32Num;
+    uint32_t u32Task;
+    uint32_t u32Depth;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0; i < HOST_TEST_NUM(u32aSize); i++)
+    {
+        snprintf(baName, sizeof(baName), "load%u", i);
+        ptaTcb[i] = _StackHost_Create(baName, u32aSize[i]);
+        HOST_TEST_ASSERT(ptaTcb[i] != NULL);
+    }
+
+    for (i = 0; i < STACK_HOST_WORKLOAD; i++)
+    {
+        u32Task = _StackHost_Rand(&u32Seed) % HOST_TEST_NUM(u32aSize);
+
+        // mostly shallow, now and then a deep path, under the warning
+        u32Depth = 16 + (_StackHost_Rand(&u32Seed) % (u32aSize[u32Task] / 4));
+
+        if ((_StackHost_Rand(&u32Seed) % 16) == 0)
+            u32Depth = (u32aSize[u32Task] * (40 + (_StackHost_Rand(&u32Seed) % 45))) / 100;
+
+        _StackHost_Run(ptaTcb[u32Task], u32Depth);
+
+        if ((i % 7) != 0)
+            continue;
+
+        HOST_TEST_EQ(Sys_StackCheck(), 0);
+        u32Num = Sys_StackTaskGet(taTask, HOST_TEST_NUM(taTask));
+
+        for (j = 0; j < HOST_TEST_NUM(u32aSize); j++)
+        {
+            ptTask = _StackHost_Find(taTask, u32Num, ptaTcb[j]);
+            HOST_TEST_ASSERT(ptTask != NULL);
+            HOST_TEST_EQ(ptTask->u32Peak, ptaTcb[j]->u32Deepest);
+            HOST_TEST_EQ(ptTask->u8Warn, 0);
+        }
+    }
+
+    for (j = 0; j < HOST_TEST_NUM(u32aSize); j++)
+        printf("    %s: %u of %u words\n", ptaTcb[j]->pcTaskName, ptaTcb[j]->u32Deepest, ptaTcb[j]->u32Size);
+
+    _StackHost_End();
+}
+
+static void _StackHost_Warn(void)
+{
+    S_SysStackTask_t taTask[SYS_STACK_TASK_NUM];
+    T_StackHostTcb *ptTcb = _StackHost_Create("at", 200);
+    T_StackHostTcb *ptFull = _StackHost_Create("full", 64);
+
+    // 89%
+    _StackHost_Run(ptTcb, 178);
+    HOST_TEST_EQ(Sys_StackCheck(), 0);
+
+    // 90%: reported, once
+    _StackHost_Run(ptTcb, 180);
+    HOST_TEST_EQ(Sys_StackCheck(), 1);
+    Sys_StackTaskGet(taTask, HOST_TEST_NUM(taTask));
+    HOST_TEST_EQ(taTask[0].u8Warn, 1);
+    HOST_TEST_EQ(taTask[0].u32Peak, 180);
+
+    HOST_TEST_EQ(Sys_StackCheck(), 1);
+    Sys_StackTaskGet(taTask, HOST_TEST_NUM(taTask));
+    HOST_TEST_EQ(taTask[0].u8Warn, 1);
+
+    // every word written: the whole stack
+    _StackHost_Run(ptFull, 64);
+    HOST_TEST_EQ(Sys_StackCheck(), 2);
+    Sys_StackTaskGet(taTask, HOST_TEST_NUM(taTask));
+    HOST_TEST_EQ(taTask[1].u32Peak, 64);
+
+    _StackHost_End();
+}
+
+static void _StackHost_Save(void)
+{
+    S_SysStackRecord_t taRecord[SYS_STACK_RECORD_NUM];
+    const S_SysStackRecord_t *ptRecord = NULL;
+    T_StackHostTcb *ptTcb = NULL;
+    T_StackHostTcb *ptIdle = NULL;
+    uint32_t u32Write;
+
+    // the worst cases of the boots before
+    memset(&g_tStackHostFim, 0xFF, sizeof(g_tStackHostFim.taRecord));
+    g_tStackHostFim.u32Write = 0;
+    g_tStackHostFim.u8WriteFail = 0;
+    strcpy(g_tStackHostFim.taRecord[3].baName, "lwip");
+    g_tStackHostFim.taRecord[3].u16Size = 512;
+    g_tStackHostFim.taRecord[3].u16Peak = 300;
+
+    Sys_StackStart();
+    HOST_TEST_ASSERT(g_fpStackHostTimer != NULL);
+    HOST_TEST_EQ(g_u32StackHostTimerMs, SYS_STACK_CHECK_MS);
+
+    // the never written records are empty
+    HOST_TEST_EQ(Sys_StackRecordGet(taRecord, HOST_TEST_NUM(taRecord)), 1);
+    ptRecord = _StackHost_Record("lwip");
+    HOST_TEST_ASSERT(ptRecord != NULL);
+    HOST_TEST_EQ(ptRecord->u16Peak, 300);
+
+    ptTcb = _StackHost_Create("lwip", 512);
+    ptIdle = _StackHost_Create("IDLE", 128);
+
+    // under the worst case: no write for lwip, IDLE not run yet
+    _StackHost_Run(ptTcb, 250);
+    Sys_StackCheck();
+    HOST_TEST_EQ(Sys_StackSave(), 0);
+    HOST_TEST_EQ(g_tStackHostFim.u32Write, 0);
+
+    // a new record for IDLE
+    _StackHost_Run(ptIdle, 40);
+    Sys_StackCheck();
+    HOST_TEST_EQ(Sys_StackSave(), 1);
+    HOST_TEST_EQ(_StackHost_Record("IDLE")->u16Peak, 40);
+
+    // grown by less than SYS_STACK_SAVE_STEP, then by it
+    _StackHost_Run(ptIdle, 40 + SYS_STACK_SAVE_STEP - 1);
+    Sys_StackCheck();
+    HOST_TEST_EQ(Sys_StackSave(), 0);
+
+    _StackHost_Run(ptIdle, 40 + SYS_STACK_SAVE_STEP);
+    Sys_StackCheck();
+    HOST_TEST_EQ(Sys_StackSave(), 1);
+    HOST_TEST_EQ(_StackHost_Record("IDLE")->u16Peak, 40 + SYS_STACK_SAVE_STEP);
+
+    _StackHost_Run(ptTcb, 300 + SYS_STACK_SAVE_STEP);
+    Sys_StackCheck();
+    HOST_TEST_EQ(Sys_StackSave(), 1);
+    HOST_TEST_EQ(_StackHost_Record("lwip")->u16Peak, 300 + SYS_STACK_SAVE_STEP);
+    HOST_TEST_EQ(g_tStackHostFim.u32Write, 3);
+
+    // made again with another size: the worst case starts again
+    osThreadTerminate((osThreadId)ptTcb);
+    ptTcb = _StackHost_Create("lwip", 600);
+    _StackHost_Run(ptTcb, 200);
+    Sys_StackCheck();
+    HOST_TEST_EQ(Sys_StackSave(), 1);
+    ptRecord = _StackHost_Record("lwip");
+    HOST_TEST_EQ(ptRecord->u16Size, 600);
+    HOST_TEST_EQ(ptRecord->u16Peak, 200);
+
+    // the next boot reads them back
+    u32Write = g_tStackHostFim.u32Write;
+    Sys_StackStart();
+    HOST_TEST_EQ(_StackHost_Record("lwip")->u16Size, 600);
+    HOST_TEST_EQ(_StackHost_Record("IDLE")->u16Peak, 40 + SYS_STACK_SAVE_STEP);
+    HOST_TEST_EQ(g_tStackHostFim.u32Write, u32Write);
+
+    // a write that fails
+    _StackHost_Run(ptIdle, 100);
+    Sys_StackCheck();
+    g_tStackHostFim.u8WriteFail = 1;
+    HOST_TEST_EQ(Sys_StackSave(), -1);
+    HOST_TEST_EQ(_StackHost_Record("IDLE")->u16Peak, 40 + SYS_STACK_SAVE_STEP);
+
+    // tried again at the next save
+    g_tStackHostFim.u8WriteFail = 0;
+    HOST_TEST_EQ(Sys_StackSave(), 1);
+    HOST_TEST_EQ(_StackHost_Record("IDLE")->u16Peak, 100);
+
+    // in the first empty record
+    HOST_TEST_ASSERT(!strcmp(g_tStackHostFim.taRecord[0].baName, "IDLE"));
+    HOST_TEST_EQ(g_tStackHostFim.taRecord[0].u16Peak, 100);
+
+    _StackHost_End();
+}
+
+// the periodic check runs in the timer task, which adds itself
+static void _StackHost_Timer(void)
+{
+    S_SysStackTask_t taTask[SYS_STACK_TASK_NUM];
+    const S_SysStackTask_t *ptTask = NULL;
+    T_StackHostTcb *ptTimer = _StackHost_TcbNew("Tmr Svc", configTIMER_TASK_STACK_DEPTH);
+    T_StackHostTcb *ptTcb = _StackHost_Create("ps", 128);
+    uint32_t u32Write = g_tStackHostFim.u32Write;
+    uint32_t u32Num;
+
+    HOST_TEST_ASSERT(g_fpStackHostTimer != NULL);
+
+    _StackHost_Run(ptTcb, 70);
+    _StackHost_Run(ptTimer, 50);
+    g_fpStackHostTimer(NULL);
+
+    u32Num = Sys_StackTaskGet(taTask, HOST_TEST_NUM(taTask));
+    HOST_TEST_EQ(u32Num, 2);
+
+    ptTask = _StackHost_Find(taTask, u32Num, ptTimer);
+    HOST_TEST_ASSERT(ptTask != NULL);
+    HOST_TEST_EQ(ptTask->u32Size, configTIMER_TASK_STACK_DEPTH);
+    HOST_TEST_EQ(ptTask->u32Peak, 50);
+    HOST_TEST_EQ(_StackHost_Find(taTask, u32Num, ptTcb)->u32Peak, 70);
+
+    // saved in the same run
+    HOST_TEST_EQ(g_tStackHostFim.u32Write, u32Write + 2);
+    HOST_TEST_EQ(_StackHost_Record("Tmr Svc")->u16Peak, 50);
+
+    // added once
+    _StackHost_Run(ptTimer, 60);
+    g_fpStackHostTimer(NULL);
+    HOST_TEST_EQ(Sys_StackTaskGet(NULL, 0), 2);
+
+    Sys_StackTaskDel(ptTimer);
+    _StackHost_TcbFree(ptTimer);
+    _StackHost_End();
+}
+
+static void _StackHost_Cmd(void)
+{
+    char baDump[] = "stack";
+    char baSave[] = "stack save";
+    char baHistory[] = "stack history";
+    char baClear[] = "stack clear";
+    char baBad[] = "stack x";
+    T_StackHostTcb *ptTcb = _StackHost_Create("diag", 256);
+    uint32_t i;
+
+    _StackHost_Run(ptTcb, 240);
+
+    Sys_StackCmd(baDump);
+    Sys_StackCmd(baSave);
+    HOST_TEST_EQ(_StackHost_Record("diag")->u16Peak, 240);
+    Sys_StackCmd(baHistory);
+    Sys_StackCmd(baBad);
+
+    Sys_StackCmd(baClear);
+    HOST_TEST_ASSERT(_StackHost_Record("diag") == NULL);
+
+    for (i = 0; i < SYS_STACK_RECORD_NUM; i++)
+        HOST_TEST_EQ(g_tStackHostFim.taRecord[i].baName[0], 0);
+
+    _StackHost_End();
+}
+
+static const T_HostTestCase g_taStackHostCase[] =
+{
+    HOST_TEST_CASE(_StackHost_Add),
+    HOST_TEST_CASE(_StackHost_AddByHand),
+    HOST_TEST_CASE(_StackHost_Full),
+    HOST_TEST_CASE(_StackHost_Mark),
+    HOST_TEST_CASE(_StackHost_Warn),
+    HOST_TEST_CASE(_StackHost_Save),
+    HOST_TEST_CASE(_StackHost_Timer),
+    HOST_TEST_CASE(_StackHost_Cmd),
+};
+
+int main(void)
+{
+    HostOs_Init();
+
+    // the kernel of the test under the CMSIS-RTOS calls, as the ROM loads it
+    osThreadCreate = _StackHost_ThreadCreate;
+    osThreadTerminate = _StackHost_ThreadTerminate;
+    osTimerCreate = _StackHost_TimerCreate;
+    osTimerStart = _StackHost_TimerStart;
+    MwFim_FileRead = _StackHost_FimRead;
+    MwFim_FileWrite = _StackHost_FimWrite;
+
+    Sys_StackInit();
+
+    return HostTest_Run("sys_stack", g_taStackHostCase, HOST_TEST_NUM(g_taStackHostCase));
+}
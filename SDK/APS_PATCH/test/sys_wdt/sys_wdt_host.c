@@ -0,0 +1,825 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  sys_wdt_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  The watchdog supervisor of sys_wdt.c on simulated tasks and a register
+*  model of the watchdog.
+*
+*  The watchdog is the model of the test under the ROM driver: the LOCK key
+*  gates the writes, LOAD and INTCLR reload the counter, which runs from
+*  the simulated time at the core clock. The first timeout raises the
+*  interrupt and the second one, with the interrupt still raised, resets.
+*
+*  The tasks are control blocks with the head of the V9.0.0 one. The AT
+*  task is armed while it handles a command, the tcpip thread and the
+*  supplicant ack the probes through their mailboxes, and a periodic client
+*  kicks on its own. Each step of the simulation moves the time, lets the
+*  tasks run, then the idle hook calls Sys_WdtFeed. A stalled task stops
+*  checking in; Sys_FaultStallCapture, which does not return on the target,
+*  leaves the step as the reset.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include "cmsis_os.h"
+#include "hal_system.h"
+#include "hal_vic.h"
+#include "hal_wdt.h"
+#include "lwip/tcpip.h"
+#include "supplicant_task_patch.h"
+#include "sys_fault.h"
+#include "sys_wdt.h"
+#include "host_os.h"
+#include "host_reg.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define WDT_HOST_TIMEOUT_SECS       10          // WDT_TIMEOUT_SECS of sys_init_patch.c
+#define WDT_HOST_STEP_MS            100
+#define WDT_HOST_PERIOD_MS          1000        // the periodic client
+#define WDT_HOST_PERIOD_DEADLINE    2000
+
+#define WDT_HOST_LOAD               (WDT_BASE + 0x000)
+#define WDT_HOST_VALUE              (WDT_BASE + 0x004)
+#define WDT_HOST_CTRL               (WDT_BASE + 0x008)
+#define WDT_HOST_INTCLR             (WDT_BASE + 0x00C)
+#define WDT_HOST_RAWINTSTAT         (WDT_BASE + 0x010)
+#define WDT_HOST_MASKINTSTAT        (WDT_BASE + 0x014)
+#define WDT_HOST_LOCK               (WDT_BASE + 0xC00)
+
+#define WDT_HOST_UNLOCK_KEY         0x1ACCE551
+#define WDT_HOST_CTRL_INTEN         (1 << 0)
+#define WDT_HOST_CTRL_RESEN         (1 << 1)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    // the head of the TCB of V9.0.0, as sys_wdt.c reads it
+    volatile StackType_t *pxTopOfStack;
+    ListItem_t xStateListItem;
+    ListItem_t xEventListItem;
+    UBaseType_t uxPriority;
+
+    // the simulation
+    const char *sName;
+} T_WdtHostTcb;
+
+typedef struct
+{
+    uint8_t u8Unlock;
+    uint32_t u32Load;
+    uint32_t u32Ctrl;
+    uint8_t u8Int;
+    uint64_t u64Reload;             // the time of the last reload, us
+
+    uint32_t u32Clear;              // INTCLR written unlocked
+    uint32_t u32Ignored;            // written while locked
+    uint32_t u32Irq;
+    uint32_t u32Reset;
+} T_WdtHostModel;
+
+// a task with a mailbox of probes
+typedef struct
+{
+    T_WdtHostTcb *ptTcb;
+    int iId;
+    uint8_t u8Pending;
+    uint8_t u8Stuck;                // the probes stay in the mailbox
+    uint8_t u8Full;                 // the mailbox takes no more
+    uint32_t u32Probe;
+} T_WdtHostMbox;
+
+typedef struct
+{
+    char baLine[SYS_FAULT_TRACE_LEN];
+    void *pTask;
+    uint32_t u32Capture;
+    uint32_t u32Ms;                 // the time of the capture
+} T_WdtHostFault;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables & Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_WdtHostModel g_tWdtHostModel;
+static T_WdtHostFault g_tWdtHostFault;
+static jmp_buf g_tWdtHostReset;
+
+static T_WdtHostTcb g_tWdtHostIdle = { .uxPriority = 0, .sName = "IDLE" };
+static T_WdtHostTcb g_tWdtHostAt = { .uxPriority = 2, .sName = "at" };
+static T_WdtHostTcb g_tWdtHostTcpip = { .uxPriority = 4, .sName = "tcpip" };
+static T_WdtHostTcb g_tWdtHostSupp = { .uxPriority = 3, .sName = "supplicant" };
+static T_WdtHostTcb g_tWdtHostSensor = { .uxPriority = 1, .sName = "sensor" };
+static T_WdtHostTcb g_tWdtHostDiag = { .uxPriority = 1, .sName = "diag" };
+static T_WdtHostTcb *g_ptWdtHostCurr = &g_tWdtHostIdle;
+
+static T_WdtHostMbox g_tWdtHostTcpipBox = { .ptTcb = &g_tWdtHostTcpip, .iId = -1 };
+static T_WdtHostMbox g_tWdtHostSuppBox = { .ptTcb = &g_tWdtHostSupp, .iId = -1 };
+
+static uint32_t g_u32WdtHostMutex;          // what the stalled tasks wait on
+static uint64_t g_u64WdtHostBase;
+static uint32_t g_u32WdtHostStep;
+
+// Sec 7: declaration of static function prototype
+
+/***********************************************************************
+*  Sec 8: C Functions
+***********************************************************************/
+
+/*
+ * The watchdog
+ */
+static uint64_t _WdtHost_Ticks(uint64_t u64Us)
+{
+    return u64Us * SystemCoreClockGet() / 1000000;
+}
+
+// the counter up to now: the first timeout raises the interrupt, the next
+// one with it raised is the reset
+static void _WdtHost_Run(void)
+{
+    T_WdtHostModel *ptModel = &g_tWdtHostModel;
+    uint64_t u64Now = HostOs_TimeUs();
+    uint64_t u64Period = 0;
+
+    if ((!(ptModel->u32Ctrl & WDT_HOST_CTRL_INTEN)) || (!ptModel->u32Load))
+    {
+        ptModel->u64Reload = u64Now;
+        return;
+    }
+
+    u64Period = (uint64_t)ptModel->u32Load * 1000000 / SystemCoreClockGet();
+
+    while (u64Now - ptModel->u64Reload >= u64Period)
+    {
+        ptModel->u64Reload += u64Period;
+
+        if (!ptModel->u8Int)
+        {
+            ptModel->u8Int = 1;
+            ptModel->u32Irq++;
+        }
+        else if (ptModel->u32Ctrl & WDT_HOST_CTRL_RESEN)
+        {
+            ptModel->u32Reset++;
+        }
+    }
+}
+
+static uint32_t _WdtHost_RegRead(uint32_t u32Addr, uint32_t u32Val, void *pArg)
+{
+    T_WdtHostModel *ptModel = &g_tWdtHostModel;
+    uint64_t u64Left = 0;
+
+    _WdtHost_Run();
+
+    switch (u32Addr)
+    {
+        case WDT_HOST_LOAD:
+            return ptModel->u32Load;
+
+        case WDT_HOST_VALUE:
+            u64Left = _WdtHost_Ticks(HostOs_TimeUs() - ptModel->u64Reload);
+            return (u64Left < ptModel->u32Load) ? (uint32_t)(ptModel->u32Load - u64Left) : 0;
+
+        case WDT_HOST_CTRL:
+            return ptModel->u32Ctrl;
+
+        case WDT_HOST_RAWINTSTAT:
+            return ptModel->u8Int;
+
+        case WDT_HOST_MASKINTSTAT:
+            return (ptModel->u32Ctrl & WDT_HOST_CTRL_INTEN) ? ptModel->u8Int : 0;
+
+        case WDT_HOST_LOCK:
+            return !ptModel->u8Unlock;
+
+        default:
+            return 0;
+    }
+}
+
+static void _WdtHost_RegWrite(uint32_t u32Addr, uint32_t u32Val, void *pArg)
+{
+    T_WdtHostModel *ptModel = &g_tWdtHostModel;
+
+    _WdtHost_Run();
+
+    if (u32Addr == WDT_HOST_LOCK)
+    {
+        ptModel->u8Unlock = (u32Val == WDT_HOST_UNLOCK_KEY);
+        return;
+    }
+
+    if (!ptModel->u8Unlock)
+    {
+        ptModel->u32Ignored++;
+        return;
+    }
+
+    switch (u32Addr)
+    {
+        case WDT_HOST_LOAD:
+            ptModel->u32Load = u32Val;
+            ptModel->u64Reload = HostOs_TimeUs();
+            break;
+
+        case WDT_HOST_CTRL:
+            if ((u32Val & WDT_HOST_CTRL_INTEN) && (!(ptModel->u32Ctrl & WDT_HOST_CTRL_INTEN)))
+                ptModel->u64Reload = HostOs_TimeUs();
+            ptModel->u32Ctrl = u32Val;
+            break;
+
+        case WDT_HOST_INTCLR:
+            ptModel->u8Int = 0;
+            ptModel->u64Reload = HostOs_TimeUs();
+            ptModel->u32Clear++;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*
+ * The kernel, the fault record and the probes
+ */
+char *pcTaskGetName(TaskHandle_t xTaskToQuery)
+{
+    T_WdtHostTcb *ptTcb = (T_WdtHostTcb *)xTaskToQuery;
+
+    if (ptTcb == NULL)
+        ptTcb = g_ptWdtHostCurr;
+
+    return (char *)ptTcb->sName;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)g_ptWdtHostCurr;
+}
+
+void Sys_FaultTraceAdd(const char *sLine)
+{
+    strncpy(g_tWdtHostFault.baLine, sLine, SYS_FAULT_TRACE_LEN - 1);
+}
+
+// records the stalled task and resets: no return
+void Sys_FaultStallCapture(void *pTask)
+{
+    g_tWdtHostFault.pTask = pTask;
+    g_tWdtHostFault.u32Capture++;
+    g_tWdtHostFault.u32Ms = (uint32_t)((HostOs_TimeUs() - g_u64WdtHostBase) / 1000);
+
+    longjmp(g_tWdtHostReset, 1);
+}
+
+static int _WdtHost_MboxPut(T_WdtHostMbox *ptBox, int iId)
+{
+    ptBox->iId = iId;
+    ptBox->u32Probe++;
+
+    if (ptBox->u8Full)
+        return -1;
+
+    ptBox->u8Pending = 1;
+    return 0;
+}
+
+err_t tcpip_callback_with_block(tcpip_callback_fn function, void *ctx, u8_t block)
+{
+    // only the probe posts here, the ack is Sys_WdtKick(ctx)
+    if (_WdtHost_MboxPut(&g_tWdtHostTcpipBox, (int)(intptr_t)ctx))
+        return ERR_MEM;
+
+    return ERR_OK;
+}
+
+int supplicant_task_wdt_probe(int iId)
+{
+    return _WdtHost_MboxPut(&g_tWdtHostSuppBox, iId);
+}
+
+/*
+ * The simulation
+ */
+static void _WdtHost_Run1(T_WdtHostTcb *ptTcb)
+{
+    g_ptWdtHostCurr = ptTcb;
+}
+
+// the task takes the probe from its mailbox and the handler acks it
+static void _WdtHost_MboxRun(T_WdtHostMbox *ptBox)
+{
+    if ((!ptBox->u8Pending) || (ptBox->u8Stuck))
+        return;
+
+    ptBox->u8Pending = 0;
+    _WdtHost_Run1(ptBox->ptTcb);
+    Sys_WdtKick(ptBox->iId);
+}
+
+// the idle task runs the hook, 1: the system was reset
+static int _WdtHost_IdleHook(void)
+{
+    _WdtHost_Run1(&g_tWdtHostIdle);
+
+    if (setjmp(g_tWdtHostReset))
+        return 1;
+
+    Sys_WdtFeed();
+    return 0;
+}
+
+// one step: the time, the tasks, then the idle hook, 1: reset
+static int _WdtHost_Step(int iSensor)
+{
+    HostOs_TimeAdvanceUs(WDT_HOST_STEP_MS * 1000);
+    g_u32WdtHostStep++;
+
+    _WdtHost_MboxRun(&g_tWdtHostTcpipBox);
+    _WdtHost_MboxRun(&g_tWdtHostSuppBox);
+
+    if ((iSensor >= 0) && (g_u32WdtHostStep % (WDT_HOST_PERIOD_MS / WDT_HOST_STEP_MS) == 0))
+    {
+        _WdtHost_Run1(&g_tWdtHostSensor);
+        Sys_WdtKick(iSensor);
+    }
+
+    return _WdtHost_IdleHook();
+}
+
+static uint32_t _WdtHost_Now(void)
+{
+    return (uint32_t)((HostOs_TimeUs() - g_u64WdtHostBase) / 1000);
+}
+
+static const S_SysWdtClient_t *_WdtHost_Client(const char *sName)
+{
+    static S_SysWdtClient_t taClient[SYS_WDT_CLIENT_NUM];
+    uint32_t u32Num = Sys_WdtClientGet(taClient, SYS_WDT_CLIENT_NUM);
+    uint32_t i;
+
+    for (i = 0; i < u32Num; i++)
+    {
+        if (!strcmp(taClient[i].sName, sName))
+            return &taClient[i];
+    }
+
+    return NULL;
+}
+
+static int _WdtHost_AtRegister(void)
+{
+    int iAt;
+
+    _WdtHost_Run1(&g_tWdtHostAt);
+    iAt = Sys_WdtRegister("at", SYS_WDT_DEADLINE_AT_MS, NULL);
+    Sys_WdtIdle(iAt);
+
+    return iAt;
+}
+
+static void _WdtHost_Begin(void)
+{
+    memset(&g_tWdtHostFault, 0, sizeof(g_tWdtHostFault));
+    g_u64WdtHostBase = HostOs_TimeUs();
+}
+
+// the task gets going again and acks the probe it is on
+static void _WdtHost_MboxEnd(T_WdtHostMbox *ptBox)
+{
+    ptBox->u8Stuck = 0;
+    ptBox->u8Full = 0;
+    ptBox->u8Pending = 0;
+    ptBox->ptTcb->xEventListItem.pvContainer = NULL;
+
+    _WdtHost_Run1(ptBox->ptTcb);
+    Sys_WdtKick(ptBox->iId);
+}
+
+static void _WdtHost_End(void)
+{
+    g_tWdtHostAt.xEventListItem.pvContainer = NULL;
+
+    // after the reset nothing is armed for the next case
+    _WdtHost_MboxEnd(&g_tWdtHostTcpipBox);
+    _WdtHost_MboxEnd(&g_tWdtHostSuppBox);
+
+    Sys_WdtActionSet(SYS_WDT_ACTION_RESET);
+}
+
+// every task checks in: the watchdog is fed at every idle hook, and never
+// gets to its interrupt
+static void _WdtHost_Healthy(void)
+{
+    const S_SysWdtClient_t *ptClient = NULL;
+    uint32_t u32Clear = g_tWdtHostModel.u32Clear;
+    uint32_t u32Irq = g_tWdtHostModel.u32Irq;
+    uint32_t u32Probe = g_tWdtHostTcpipBox.u32Probe;
+    int iSensor;
+    int iAt;
+    uint32_t i;
+
+    _WdtHost_Begin();
+    iAt = _WdtHost_AtRegister();
+    _WdtHost_Run1(&g_tWdtHostSensor);
+    iSensor = Sys_WdtRegister("sensor", WDT_HOST_PERIOD_DEADLINE, NULL);
+    HOST_TEST_ASSERT(iSensor >= 0);
+
+    // one minute, an AT command of 200 ms every 3 s
+    for (i = 0; i < 600; i++)
+    {
+        if (i % 30 == 0)
+        {
+            _WdtHost_Run1(&g_tWdtHostAt);
+            Sys_WdtBusy(iAt);
+        }
+        else if (i % 30 == 2)
+        {
+            _WdtHost_Run1(&g_tWdtHostAt);
+            Sys_WdtIdle(iAt);
+        }
+
+        HOST_TEST_EQ(_WdtHost_Step(iSensor), 0);
+    }
+
+    HOST_TEST_EQ(g_tWdtHostFault.u32Capture, 0);
+    HOST_TEST_EQ(g_tWdtHostModel.u32Clear - u32Clear, 600);
+    HOST_TEST_EQ(g_tWdtHostModel.u32Irq, u32Irq);
+    HOST_TEST_EQ(g_tWdtHostModel.u32Ignored, 0);
+
+    // a probe every SYS_WDT_PROBE_MS
+    HOST_TEST_ASSERT(g_tWdtHostTcpipBox.u32Probe - u32Probe >= 60000 / SYS_WDT_PROBE_MS - 1);
+    HOST_TEST_ASSERT(g_tWdtHostTcpipBox.u32Probe - u32Probe <= 60000 / SYS_WDT_PROBE_MS + 1);
+
+    ptClient = _WdtHost_Client("at");
+    HOST_TEST_ASSERT(ptClient != NULL);
+    HOST_TEST_EQ(ptClient->u32Miss, 0);
+    HOST_TEST_ASSERT(ptClient->u32Max >= 2 * WDT_HOST_STEP_MS);
+    HOST_TEST_ASSERT(ptClient->u32Max < 3 * WDT_HOST_STEP_MS);
+    HOST_TEST_ASSERT(ptClient->pHandle == &g_tWdtHostAt);
+
+    // acked in the step after the probe
+    ptClient = _WdtHost_Client("tcpip");
+    HOST_TEST_ASSERT(ptClient != NULL);
+    HOST_TEST_ASSERT(ptClient->u32Max <= WDT_HOST_STEP_MS + 5);
+    HOST_TEST_ASSERT(ptClient->pHandle == &g_tWdtHostTcpip);
+
+    ptClient = _WdtHost_Client("sensor");
+    HOST_TEST_ASSERT(ptClient != NULL);
+    HOST_TEST_ASSERT(ptClient->u32Max >= WDT_HOST_PERIOD_MS);
+    HOST_TEST_ASSERT(ptClient->u32Max <= WDT_HOST_PERIOD_MS + 5);
+    HOST_TEST_ASSERT(ptClient->u8Armed);
+
+    Sys_WdtUnregister(iSensor);
+    Sys_WdtUnregister(iAt);
+    HOST_TEST_ASSERT(_WdtHost_Client("at") == NULL);
+    _WdtHost_End();
+}
+
+// the AT task blocks on a mutex in a command: caught at its deadline, and
+// the record names it with what it waits on
+static void _WdtHost_AtStall(void)
+{
+    char baExpect[SYS_FAULT_TRACE_LEN];
+    uint32_t u32Clear;
+    uint32_t u32Busy;
+    uint32_t u32Step = 0;
+    int iAt;
+
+    _WdtHost_Begin();
+    iAt = _WdtHost_AtRegister();
+
+    HOST_TEST_EQ(_WdtHost_Step(-1), 0);
+    _WdtHost_Run1(&g_tWdtHostAt);
+    Sys_WdtBusy(iAt);
+    u32Busy = _WdtHost_Now();
+    g_tWdtHostAt.xEventListItem.pvContainer = (void *)&g_u32WdtHostMutex;
+
+    u32Clear = g_tWdtHostModel.u32Clear;
+
+    while (!_WdtHost_Step(-1))
+    {
+        u32Step++;
+        HOST_TEST_ASSERT(u32Step < 2 * SYS_WDT_DEADLINE_AT_MS / WDT_HOST_STEP_MS);
+    }
+
+    HOST_TEST_EQ(g_tWdtHostFault.u32Capture, 1);
+    HOST_TEST_ASSERT(g_tWdtHostFault.pTask == &g_tWdtHostAt);
+    HOST_TEST_ASSERT(g_tWdtHostFault.u32Ms - u32Busy > SYS_WDT_DEADLINE_AT_MS);
+    HOST_TEST_ASSERT(g_tWdtHostFault.u32Ms - u32Busy <= SYS_WDT_DEADLINE_AT_MS + 2 * WDT_HOST_STEP_MS);
+
+    printf("  %s\n", g_tWdtHostFault.baLine);
+    HOST_TEST_ASSERT(!strncmp(g_tWdtHostFault.baLine, "wdt: at stalled ", 16));
+    snprintf(baExpect, sizeof(baExpect), " at prio=2 wait=%08X", (unsigned int)(uintptr_t)&g_u32WdtHostMutex);
+    HOST_TEST_ASSERT(strstr(g_tWdtHostFault.baLine, baExpect) != NULL);
+
+    // fed up to the step of the reset, not in it: the hardware is the
+    // backstop if the capture does not get to the reset
+    HOST_TEST_EQ(g_tWdtHostModel.u32Clear - u32Clear, u32Step);
+    HOST_TEST_EQ(_WdtHost_Client("at")->u32Miss, 1);
+
+    // after the reset
+    Sys_WdtIdle(iAt);
+    Sys_WdtUnregister(iAt);
+    _WdtHost_End();
+}
+
+// the tcpip thread stops taking its mailbox: the probe that is not acked
+// is caught at the deadline from the probe, the later probes do not move it
+static void _WdtHost_ProbeStall(void)
+{
+    const S_SysWdtClient_t *ptClient = NULL;
+    uint32_t u32Probe = 0;
+    uint32_t u32Step = 0;
+
+    _WdtHost_Begin();
+
+    // up to a probe
+    u32Probe = g_tWdtHostTcpipBox.u32Probe;
+    g_tWdtHostTcpipBox.u8Stuck = 1;
+    g_tWdtHostTcpip.xEventListItem.pvContainer = (void *)&g_u32WdtHostMutex;
+
+    while (g_tWdtHostTcpipBox.u32Probe == u32Probe)
+        HOST_TEST_EQ(_WdtHost_Step(-1), 0);
+
+    ptClient = _WdtHost_Client("tcpip");
+    HOST_TEST_ASSERT(ptClient->u8Armed);
+    u32Probe = ptClient->u32Last - (uint32_t)(g_u64WdtHostBase / 1000);
+
+    while (!_WdtHost_Step(-1))
+    {
+        u32Step++;
+        HOST_TEST_ASSERT(u32Step < 2 * SYS_WDT_DEADLINE_TCPIP_MS / WDT_HOST_STEP_MS);
+    }
+
+    printf("  %s\n", g_tWdtHostFault.baLine);
+    HOST_TEST_ASSERT(!strncmp(g_tWdtHostFault.baLine, "wdt: tcpip stalled ", 19));
+    HOST_TEST_ASSERT(g_tWdtHostFault.pTask == &g_tWdtHostTcpip);
+    HOST_TEST_ASSERT(g_tWdtHostFault.u32Ms - u32Probe > SYS_WDT_DEADLINE_TCPIP_MS);
+    HOST_TEST_ASSERT(g_tWdtHostFault.u32Ms - u32Probe <= SYS_WDT_DEADLINE_TCPIP_MS + 2 * WDT_HOST_STEP_MS);
+
+    _WdtHost_End();
+
+    // a full mailbox: the probe is sent again, the deadline counts from
+    // the first try
+    _WdtHost_Begin();
+    u32Probe = g_tWdtHostSuppBox.u32Probe;
+    g_tWdtHostSuppBox.u8Full = 1;
+
+    while (g_tWdtHostSuppBox.u32Probe == u32Probe)
+        HOST_TEST_EQ(_WdtHost_Step(-1), 0);
+
+    u32Probe = _WdtHost_Now();
+    u32Step = 0;
+
+    while (!_WdtHost_Step(-1))
+        u32Step++;
+
+    HOST_TEST_ASSERT(!strncmp(g_tWdtHostFault.baLine, "wdt: supplicant stalled ", 24));
+    HOST_TEST_ASSERT(g_tWdtHostFault.u32Ms - u32Probe > SYS_WDT_DEADLINE_SUPP_MS - WDT_HOST_STEP_MS);
+    HOST_TEST_ASSERT(g_tWdtHostFault.u32Ms - u32Probe <= SYS_WDT_DEADLINE_SUPP_MS + 2 * WDT_HOST_STEP_MS);
+
+    _WdtHost_End();
+}
+
+// the log mode: the miss is printed and counted, the watchdog still fed
+static void _WdtHost_Log(void)
+{
+    const S_SysWdtClient_t *ptClient = NULL;
+    uint32_t u32Clear;
+    uint32_t u32Irq = g_tWdtHostModel.u32Irq;
+    uint32_t i;
+    int iAt;
+
+    _WdtHost_Begin();
+    Sys_WdtActionSet(SYS_WDT_ACTION_LOG);
+    iAt = _WdtHost_AtRegister();
+
+    _WdtHost_Run1(&g_tWdtHostAt);
+    Sys_WdtBusy(iAt);
+    u32Clear = g_tWdtHostModel.u32Clear;
+
+    for (i = 0; i < 2 * SYS_WDT_DEADLINE_AT_MS / WDT_HOST_STEP_MS; i++)
+        HOST_TEST_EQ(_WdtHost_Step(-1), 0);
+
+    HOST_TEST_EQ(g_tWdtHostFault.u32Capture, 0);
+    HOST_TEST_ASSERT(!strncmp(g_tWdtHostFault.baLine, "wdt: at stalled ", 16));
+    HOST_TEST_EQ(g_tWdtHostModel.u32Clear - u32Clear, i);
+    HOST_TEST_EQ(g_tWdtHostModel.u32Irq, u32Irq);
+
+    // disarmed at the miss, counted once
+    ptClient = _WdtHost_Client("at");
+    HOST_TEST_EQ(ptClient->u32Miss, 1);
+    HOST_TEST_ASSERT(!ptClient->u8Armed);
+
+    // and armed again by the next command
+    _WdtHost_Run1(&g_tWdtHostAt);
+    Sys_WdtBusy(iAt);
+    HOST_TEST_ASSERT(_WdtHost_Client("at")->u8Armed);
+    Sys_WdtIdle(iAt);
+
+    Sys_WdtUnregister(iAt);
+    _WdtHost_End();
+}
+
+// the idle task does not run: nothing feeds the watchdog, its interrupt
+// comes at the timeout and the reset at the next one
+static void _WdtHost_Starve(void)
+{
+    uint32_t u32Irq = g_tWdtHostModel.u32Irq;
+    uint32_t u32Reset = g_tWdtHostModel.u32Reset;
+
+    _WdtHost_Begin();
+
+    HostOs_TimeAdvanceUs(WDT_HOST_TIMEOUT_SECS * 1000000 - 100000);
+    HOST_TEST_EQ(*(volatile uint32_t *)WDT_HOST_RAWINTSTAT, 0);
+    HOST_TEST_ASSERT(*(volatile uint32_t *)WDT_HOST_VALUE > 0);
+
+    HostOs_TimeAdvanceUs(200000);
+    HOST_TEST_EQ(*(volatile uint32_t *)WDT_HOST_RAWINTSTAT, 1);
+    HOST_TEST_EQ(g_tWdtHostModel.u32Irq, u32Irq + 1);
+    HOST_TEST_EQ(g_tWdtHostModel.u32Reset, u32Reset);
+
+    HostOs_TimeAdvanceUs(WDT_HOST_TIMEOUT_SECS * 1000000);
+    HOST_TEST_EQ(*(volatile uint32_t *)WDT_HOST_RAWINTSTAT, 1);
+    HOST_TEST_EQ(g_tWdtHostModel.u32Reset, u32Reset + 1);
+
+    // the feed clears the interrupt and reloads
+    HOST_TEST_EQ(_WdtHost_IdleHook(), 0);
+    HOST_TEST_EQ(*(volatile uint32_t *)WDT_HOST_RAWINTSTAT, 0);
+    HOST_TEST_ASSERT(*(volatile uint32_t *)WDT_HOST_VALUE > (WDT_HOST_TIMEOUT_SECS - 1) * SystemCoreClockGet());
+
+    // a write without the key does nothing; the model counts it in the
+    // fault handler, which the compiler does not see: read after the store
+    *(volatile uint32_t *)WDT_HOST_INTCLR = 1;
+    __sync_synchronize();
+    HOST_TEST_EQ(g_tWdtHostModel.u32Ignored, 1);
+    g_tWdtHostModel.u32Ignored = 0;
+
+    _WdtHost_End();
+}
+
+static void _WdtHost_Table(void)
+{
+    int iaId[SYS_WDT_CLIENT_NUM];
+    uint32_t u32Num = 0;
+    uint32_t i;
+
+    _WdtHost_Begin();
+    _WdtHost_Run1(&g_tWdtHostDiag);
+
+    // tcpip and supplicant are in
+    for (i = 0; i < SYS_WDT_CLIENT_NUM; i++)
+    {
+        iaId[i] = Sys_WdtRegister("fill", 60000, NULL);
+        if (iaId[i] < 0)
+            break;
+        u32Num++;
+    }
+
+    HOST_TEST_EQ(u32Num, SYS_WDT_CLIENT_NUM - 2);
+    HOST_TEST_EQ(Sys_WdtRegister("more", 60000, NULL), -1);
+
+    // a free entry is used again
+    Sys_WdtUnregister(iaId[1]);
+    HOST_TEST_EQ(Sys_WdtRegister("more", 60000, NULL), iaId[1]);
+
+    for (i = 0; i < u32Num; i++)
+        Sys_WdtUnregister(iaId[i]);
+
+    // the ids not in use are ignored
+    Sys_WdtKick(-1);
+    Sys_WdtKick(SYS_WDT_CLIENT_NUM);
+    Sys_WdtBusy(iaId[0]);
+    Sys_WdtIdle(iaId[0]);
+    Sys_WdtUnregister(iaId[0]);
+    HOST_TEST_ASSERT(_WdtHost_Client("fill") == NULL);
+    HOST_TEST_ASSERT(_WdtHost_Client("more") == NULL);
+
+    _WdtHost_End();
+}
+
+// the test client of the diag command misses after its time
+static void _WdtHost_Cmd(void)
+{
+    char baDump[] = "wdt";
+    char baLog[] = "wdt log";
+    char baReset[] = "wdt reset";
+    char baTest[] = "wdt test 300";
+    char baAgain[] = "wdt test 300";
+    char baTune[] = "wdt log";
+    char baList[] = "wdt";
+    char baBad[] = "wdt x";
+    uint32_t u32Armed;
+    uint32_t u32Step = 0;
+
+    _WdtHost_Begin();
+    _WdtHost_Run1(&g_tWdtHostDiag);
+
+    Sys_WdtCmd(baDump);
+    Sys_WdtCmd(baBad);
+    Sys_WdtCmd(baLog);
+    Sys_WdtCmd(baReset);
+
+    Sys_WdtCmd(baTest);
+    u32Armed = _WdtHost_Now();
+    HOST_TEST_ASSERT(_WdtHost_Client("test") != NULL);
+
+    while (!_WdtHost_Step(-1))
+        u32Step++;
+
+    HOST_TEST_ASSERT(!strncmp(g_tWdtHostFault.baLine, "wdt: test stalled ", 18));
+    HOST_TEST_ASSERT(g_tWdtHostFault.pTask == &g_tWdtHostDiag);
+    HOST_TEST_ASSERT(g_tWdtHostFault.u32Ms - u32Armed > 300);
+    HOST_TEST_ASSERT(g_tWdtHostFault.u32Ms - u32Armed <= 300 + 2 * WDT_HOST_STEP_MS);
+
+    // the same client armed again
+    _WdtHost_Run1(&g_tWdtHostDiag);
+    Sys_WdtCmd(baAgain);
+    HOST_TEST_EQ(_WdtHost_Client("test")->u32Miss, 1);
+    HOST_TEST_ASSERT(_WdtHost_Client("test")->u8Armed);
+
+    // the log mode keeps it for the tuning
+    Sys_WdtCmd(baTune);
+    HOST_TEST_EQ(_WdtHost_Step(-1), 0);
+    while (_WdtHost_Client("test")->u8Armed)
+        HOST_TEST_EQ(_WdtHost_Step(-1), 0);
+    HOST_TEST_EQ(_WdtHost_Client("test")->u32Miss, 2);
+    Sys_WdtCmd(baList);
+
+    _WdtHost_End();
+}
+
+static const T_HostTestCase g_taWdtHostCase[] =
+{
+    HOST_TEST_CASE(_WdtHost_Healthy),
+    HOST_TEST_CASE(_WdtHost_AtStall),
+    HOST_TEST_CASE(_WdtHost_ProbeStall),
+    HOST_TEST_CASE(_WdtHost_Log),
+    HOST_TEST_CASE(_WdtHost_Starve),
+    HOST_TEST_CASE(_WdtHost_Table),
+    HOST_TEST_CASE(_WdtHost_Cmd),
+};
+
+int main(void)
+{
+    HostOs_Init();
+
+    // the steps alone move the time, a slow host does not stall a client
+    HostOs_TimeFreeze(1);
+
+    if (HostReg_Init())
+        return 1;
+
+    Hal_Sys_Pre_Init();
+    Hal_Vic_Pre_Init();
+    Hal_Wdt_Pre_Init();
+    SystemCoreClockSet(22000000);
+
+    if (HostReg_Hook(WDT_BASE, _WdtHost_RegRead, _WdtHost_RegWrite, NULL))
+        return 1;
+
+    // Sys_BootStepWdt and Sys_BootStepWdtSvc
+    Hal_Wdt_Init(WDT_HOST_TIMEOUT_SECS * SystemCoreClockGet());
+    Sys_WdtStart();
+
+    return HostTest_Run("sys_wdt", g_taWdtHostCase, HOST_TEST_NUM(g_taWdtHostCase));
+}
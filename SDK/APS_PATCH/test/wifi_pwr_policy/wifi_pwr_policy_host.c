@@ -0,0 +1,676 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  wifi_pwr_policy_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  wifi_pwr_policy.c over synthetic traffic traces: the latency/power curve.
+*
+*  The test is M0 and the AP: a trace is a list of downlink frames and
+*  uplink sends in ms. The AP buffers the downlink frames, the STA takes
+*  them at the DTIM it wakes for and then sleeps the skip count M0 has,
+*  the uplink goes at once. The netif counters are the frames taken and
+*  sent, and the window timer of the policy is called every second of
+*  simulated time. The awake time is the cost model of the policy: wakes
+*  * WIFI_PWR_POLICY_WAKE_US_DEF + frames * WIFI_PWR_POLICY_PKT_US_DEF.
+*
+*  Every trace runs with every DTIM (the policy off), with the skip count
+*  of each budget fixed, and with the policy at that budget; the latency
+*  of the downlink frames and the awake time of each run are printed.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "cmsis_os.h"
+#include "wifi_api.h"
+#include "wifi_api_if.h"
+#include "driver_netlink.h"
+#include "controller_wifi_com_patch.h"
+#include "net_stats.h"
+#include "wifi_pwr_policy.h"
+#include "host_os.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define PWR_HOST_BEACON_TU          (100)
+#define PWR_HOST_DTIM_MS            ((PWR_HOST_BEACON_TU * 1024) / 1000)    // DTIM 1, as the policy rounds it
+#define PWR_HOST_RUN_MS             (600 * 1000)
+#define PWR_HOST_TRACE_END_MS       (PWR_HOST_RUN_MS - 30000)               // the longest sleep delivers the rest
+#define PWR_HOST_EVENT_MAX          (4096)
+#define PWR_HOST_OUT_SIZE           (2048)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef enum
+{
+    PWR_HOST_MODE_OFF = 0,                  // every DTIM
+    PWR_HOST_MODE_FIXED,                    // the skip count of the budget, always
+    PWR_HOST_MODE_POLICY,
+
+    PWR_HOST_MODE_NUM
+} T_PwrHostMode;
+
+typedef struct
+{
+    uint32_t u32Ms;
+    uint8_t u8Tx;                           // 1: uplink, 0: downlink
+} T_PwrHostEvent;
+
+typedef struct
+{
+    uint32_t u32Wakes;
+    uint32_t u32Rx;
+    uint32_t u32Tx;
+    uint32_t u32LatAvg;                     // ms, downlink
+    uint32_t u32LatMax;
+    uint32_t u32AwakeUs;                    // per second
+    uint32_t u32Active;                     // windows at every DTIM, policy
+    uint32_t u32Window;
+} T_PwrHostResult;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static const uint32_t g_u32aPwrHostBudget[] = {300, 1000, 3000, 10000, 30000};
+
+#define PWR_HOST_BUDGET_NUM         (sizeof(g_u32aPwrHostBudget) / sizeof(g_u32aPwrHostBudget[0]))
+
+static const char *g_saPwrHostMode[PWR_HOST_MODE_NUM] = {"off", "fixed", "policy"};
+
+// M0 and the AP
+static uint8_t g_u8PwrHostSkip;
+static uint8_t g_u8PwrHostSkipApp;
+static uint8_t g_u8PwrHostListen;
+static uint8_t g_u8PwrHostListenApp;
+static uint8_t g_u8PwrHostConnected;
+static uint32_t g_u32PwrHostSkipSet;
+static T_NetStatsNetif g_tPwrHostNetif;
+
+// the window timer of the policy
+static os_ptimer g_fpPwrHostWindow;
+static uint8_t g_u8PwrHostTimerRun;
+static uint32_t g_u32PwrHostTimerMs;
+
+// the trace, and the results of the last curve by budget and mode
+static T_PwrHostEvent g_taPwrHostEvent[PWR_HOST_EVENT_MAX];
+static uint32_t g_u32PwrHostEventNum;
+static uint32_t g_u32PwrHostSeed;
+static T_PwrHostResult g_tPwrHostOff;
+static T_PwrHostResult g_taPwrHostFixed[PWR_HOST_BUDGET_NUM];
+static T_PwrHostResult g_taPwrHostPolicy[PWR_HOST_BUDGET_NUM];
+
+static char g_baPwrHostOut[PWR_HOST_OUT_SIZE];
+static uint32_t g_u32PwrHostOutLen;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+/*
+ * M0 and the AP
+ */
+static Boolean _PwrHost_StaCfg(u8 mode, u8 cmd_idx, u8 *value)
+{
+    if ((mode != MLME_CMD_SET_PARAM) || (cmd_idx != E_WIFI_PARAM_SKIP_DTIM_PERIODS))
+        return FALSE;
+
+    g_u8PwrHostSkip = *value;
+    g_u32PwrHostSkipSet++;
+    return TRUE;
+}
+
+static int _PwrHost_ApInfo(wifi_ap_record_t *ptAp)
+{
+    if (!g_u8PwrHostConnected)
+        return -1;
+
+    ptAp->beacon_interval = PWR_HOST_BEACON_TU;
+    ptAp->dtim_period = 1;
+    ptAp->channel = 6;
+    return 0;
+}
+
+static int _PwrHost_ListenSet(uint8_t u8Interval)
+{
+    g_u8PwrHostListen = u8Interval;
+    return 0;
+}
+
+wpa_driver_netlink_sta_cfg_fp_t wpa_driver_netlink_sta_cfg = _PwrHost_StaCfg;
+wifi_sta_get_ap_info_fp_t wifi_sta_get_ap_info_api = _PwrHost_ApInfo;
+wifi_config_set_listen_interval_fp_t wifi_config_set_listen_interval_api = _PwrHost_ListenSet;
+
+// the settings of the application in flash
+int wifi_config_get_skip_dtim(uint8_t *value)
+{
+    *value = g_u8PwrHostSkipApp;
+    return 0;
+}
+
+int wifi_config_get_listen_interval(uint8_t *interval)
+{
+    *interval = g_u8PwrHostListenApp;
+    return 0;
+}
+
+void net_stats_netif_get(T_NetStatsNetif *ptStat)
+{
+    memcpy(ptStat, &g_tPwrHostNetif, sizeof(*ptStat));
+}
+
+/*
+ * The window timer, called by the run
+ */
+static osTimerId _PwrHost_TimerCreate(const osTimerDef_t *timer_def, os_timer_type type, void *argument)
+{
+    g_fpPwrHostWindow = timer_def->ptimer;
+    return (osTimerId)&g_fpPwrHostWindow;
+}
+
+static osStatus _PwrHost_TimerStart(osTimerId timer_id, uint32_t millisec)
+{
+    g_u8PwrHostTimerRun = 1;
+    g_u32PwrHostTimerMs = millisec;
+    return osOK;
+}
+
+static osStatus _PwrHost_TimerStop(osTimerId timer_id)
+{
+    g_u8PwrHostTimerRun = 0;
+    return osOK;
+}
+
+/*
+ * The output of "wifipwr"
+ */
+static int _PwrHost_Tracer(const char *sFmt, ...)
+{
+    va_list tList;
+    int iLen;
+
+    va_start(tList, sFmt);
+    iLen = vsnprintf(&g_baPwrHostOut[g_u32PwrHostOutLen], sizeof(g_baPwrHostOut) - g_u32PwrHostOutLen,
+                     sFmt, tList);
+    va_end(tList);
+
+    if (iLen > 0)
+        g_u32PwrHostOutLen += iLen;
+
+    if (g_u32PwrHostOutLen >= sizeof(g_baPwrHostOut))
+        g_u32PwrHostOutLen = sizeof(g_baPwrHostOut) - 1;
+
+    return 0;
+}
+
+static void _PwrHost_OutReset(void)
+{
+    g_u32PwrHostOutLen = 0;
+    g_baPwrHostOut[0] = 0;
+}
+
+/*
+ * The traces
+ */
+static uint32_t _PwrHost_Rand(uint32_t u32Max)
+{
+    g_u32PwrHostSeed = (g_u32PwrHostSeed * 1103515245) + 12345;
+    return (g_u32PwrHostSeed >> 8) % u32Max;
+}
+
+static void _PwrHost_Add(uint32_t u32Ms, uint8_t u8Tx)
+{
+    HOST_TEST_ASSERT(g_u32PwrHostEventNum < PWR_HOST_EVENT_MAX);
+    HOST_TEST_ASSERT((!g_u32PwrHostEventNum) || (g_taPwrHostEvent[g_u32PwrHostEventNum - 1].u32Ms <= u32Ms));
+
+    g_taPwrHostEvent[g_u32PwrHostEventNum].u32Ms = u32Ms;
+    g_taPwrHostEvent[g_u32PwrHostEventNum].u8Tx = u8Tx;
+    g_u32PwrHostEventNum++;
+}
+
+static void _PwrHost_TraceReset(void)
+{
+    g_u32PwrHostEventNum = 0;
+    g_u32PwrHostSeed = 1;
+}
+
+// a downlink frame every 200 ms, acked every second
+static void _PwrHost_TraceStream(void)
+{
+    uint32_t u32Ms = 0;
+
+    _PwrHost_TraceReset();
+
+    for (u32Ms = 100; u32Ms < PWR_HOST_TRACE_END_MS; u32Ms += 200)
+    {
+        _PwrHost_Add(u32Ms, 0);
+
+        if ((u32Ms % 1000) == 900)
+            _PwrHost_Add(u32Ms, 1);
+    }
+}
+
+// pushes from the cloud, 5 ~ 25 s apart
+static void _PwrHost_TracePush(void)
+{
+    uint32_t u32Ms = 0;
+
+    _PwrHost_TraceReset();
+
+    for (u32Ms = 5000 + _PwrHost_Rand(20000); u32Ms < PWR_HOST_TRACE_END_MS; u32Ms += 5000 + _PwrHost_Rand(20000))
+        _PwrHost_Add(u32Ms, 0);
+}
+
+// a report every minute, the reply 40 ms later
+static void _PwrHost_TraceSensor(void)
+{
+    uint32_t u32Ms = 0;
+
+    _PwrHost_TraceReset();
+
+    for (u32Ms = 30000; u32Ms < PWR_HOST_TRACE_END_MS; u32Ms += 60000)
+    {
+        _PwrHost_Add(u32Ms, 1);
+        _PwrHost_Add(u32Ms + 40, 0);
+    }
+}
+
+// a 10 s download every minute: 200 frames 50 ms apart, an ack every 10
+static void _PwrHost_TraceBurst(void)
+{
+    uint32_t u32Start = 0;
+    uint32_t i = 0;
+
+    _PwrHost_TraceReset();
+
+    for (u32Start = 10000; u32Start < PWR_HOST_TRACE_END_MS; u32Start += 60000)
+    {
+        for (i = 0; i < 200; i++)
+        {
+            _PwrHost_Add(u32Start + (i * 50), 0);
+
+            if ((i % 10) == 9)
+                _PwrHost_Add(u32Start + (i * 50), 1);
+        }
+    }
+}
+
+/*
+ * The run
+ */
+// the skip count the budget allows, as the policy takes it
+static uint8_t _PwrHost_SkipMax(uint32_t u32Budget)
+{
+    uint32_t u32Skip = (u32Budget / PWR_HOST_DTIM_MS) - 1;
+
+    return (uint8_t)((u32Skip > WIFI_MAX_SKIP_DTIM_PERIODS_PATCH) ? WIFI_MAX_SKIP_DTIM_PERIODS_PATCH : u32Skip);
+}
+
+static void _PwrHost_Run(uint32_t u32Budget, T_PwrHostMode eMode, T_PwrHostResult *ptRes)
+{
+    wifi_pwr_policy_stat_t tStat;
+    uint64_t u64LatSum = 0;
+    uint64_t u64BufSum = 0;                 // the arrivals of the frames the AP holds
+    uint32_t u32BufNum = 0;
+    uint32_t u32BufFirst = 0;
+    uint32_t u32NextWake = 0;
+    uint32_t u32Synced = 0;
+    uint32_t u32Event = 0;
+    uint32_t u32Now = 0;
+
+    memset(ptRes, 0, sizeof(*ptRes));
+    memset(&g_tPwrHostNetif, 0, sizeof(g_tPwrHostNetif));
+    g_u8PwrHostSkip = (eMode == PWR_HOST_MODE_FIXED) ? _PwrHost_SkipMax(u32Budget) : g_u8PwrHostSkipApp;
+
+    if (eMode == PWR_HOST_MODE_POLICY)
+    {
+        HOST_TEST_EQ(wifi_pwr_policy_budget_set(u32Budget), 0);
+        HOST_TEST_EQ(g_u8PwrHostTimerRun, 1);
+        HOST_TEST_EQ(g_u32PwrHostTimerMs, WIFI_PWR_POLICY_WINDOW_MS);
+        wifi_pwr_policy_stat_reset();
+    }
+
+    for (u32Now = 0; u32Now < PWR_HOST_RUN_MS; u32Now++)
+    {
+        for (; (u32Event < g_u32PwrHostEventNum) && (g_taPwrHostEvent[u32Event].u32Ms == u32Now); u32Event++)
+        {
+            if (g_taPwrHostEvent[u32Event].u8Tx)
+            {
+                g_tPwrHostNetif.u32TxPkts++;
+                ptRes->u32Tx++;
+                continue;
+            }
+
+            if (!u32BufNum)
+                u32BufFirst = u32Now;
+
+            u64BufSum += u32Now;
+            u32BufNum++;
+        }
+
+        if (((u32Now % PWR_HOST_DTIM_MS) == 0) && (u32Now >= u32NextWake))
+        {
+            ptRes->u32Wakes++;
+
+            if (u32BufNum)
+            {
+                if ((u32Now - u32BufFirst) > ptRes->u32LatMax)
+                    ptRes->u32LatMax = u32Now - u32BufFirst;
+
+                u64LatSum += ((uint64_t)u32BufNum * u32Now) - u64BufSum;
+                g_tPwrHostNetif.u32RxPkts += u32BufNum;
+                ptRes->u32Rx += u32BufNum;
+                u64BufSum = 0;
+                u32BufNum = 0;
+            }
+
+            // the skip count M0 has at this wake
+            u32NextWake = u32Now + (PWR_HOST_DTIM_MS * (g_u8PwrHostSkip + 1));
+        }
+
+        if ((eMode == PWR_HOST_MODE_POLICY) && (g_u8PwrHostTimerRun) && (u32Now) &&
+            ((u32Now % g_u32PwrHostTimerMs) == 0))
+        {
+            HostOs_TimeAdvanceUs((u32Now - u32Synced) * 1000);
+            u32Synced = u32Now;
+            g_fpPwrHostWindow(NULL);
+        }
+    }
+
+    HostOs_TimeAdvanceUs((PWR_HOST_RUN_MS - u32Synced) * 1000);
+
+    HOST_TEST_EQ(u32Event, g_u32PwrHostEventNum);
+    HOST_TEST_EQ(u32BufNum, 0);
+
+    if (ptRes->u32Rx)
+        ptRes->u32LatAvg = (uint32_t)(u64LatSum / ptRes->u32Rx);
+
+    ptRes->u32AwakeUs = ((ptRes->u32Wakes * WIFI_PWR_POLICY_WAKE_US_DEF) +
+                         ((ptRes->u32Rx + ptRes->u32Tx) * WIFI_PWR_POLICY_PKT_US_DEF)) / (PWR_HOST_RUN_MS / 1000);
+
+    if (eMode == PWR_HOST_MODE_POLICY)
+    {
+        wifi_pwr_policy_stat_get(&tStat);
+        ptRes->u32Active = tStat.window_active;
+        ptRes->u32Window = tStat.window;
+
+        HOST_TEST_EQ(tStat.skip_max, _PwrHost_SkipMax(u32Budget));
+        HOST_TEST_EQ(wifi_pwr_policy_budget_set(0), 0);
+        HOST_TEST_EQ(g_u8PwrHostTimerRun, 0);
+        HOST_TEST_EQ(g_u8PwrHostSkip, g_u8PwrHostSkipApp);
+    }
+
+    // the frame waits one wake period at most
+    if (eMode == PWR_HOST_MODE_OFF)
+        HOST_TEST_ASSERT(ptRes->u32LatMax < PWR_HOST_DTIM_MS);
+    else
+        HOST_TEST_ASSERT(ptRes->u32LatMax < u32Budget);
+}
+
+static void _PwrHost_Print(uint32_t u32Budget, T_PwrHostMode eMode, const T_PwrHostResult *ptRes)
+{
+    printf("  %6u  %-6s  %6u  %10u  %10u  %10u", u32Budget, g_saPwrHostMode[eMode], ptRes->u32Wakes,
+           ptRes->u32LatAvg, ptRes->u32LatMax, ptRes->u32AwakeUs);
+
+    if (eMode == PWR_HOST_MODE_POLICY)
+        printf("  %u/%u", ptRes->u32Active, ptRes->u32Window);
+
+    printf("\n");
+}
+
+// the trace with every DTIM, then fixed and the policy at each budget
+static void _PwrHost_Curve(const char *sTrace)
+{
+    uint32_t i = 0;
+
+    _PwrHost_Run(0, PWR_HOST_MODE_OFF, &g_tPwrHostOff);
+
+    printf("curve: trace=%s rx=%u tx=%u dtim=%u ms run=%u s\n", sTrace, g_tPwrHostOff.u32Rx, g_tPwrHostOff.u32Tx,
+           PWR_HOST_DTIM_MS, PWR_HOST_RUN_MS / 1000);
+    printf("  budget  mode     wakes  lat_avg_ms  lat_max_ms  awake_us/s  active\n");
+    _PwrHost_Print(0, PWR_HOST_MODE_OFF, &g_tPwrHostOff);
+
+    for (i = 0; i < PWR_HOST_BUDGET_NUM; i++)
+    {
+        _PwrHost_Run(g_u32aPwrHostBudget[i], PWR_HOST_MODE_FIXED, &g_taPwrHostFixed[i]);
+        _PwrHost_Run(g_u32aPwrHostBudget[i], PWR_HOST_MODE_POLICY, &g_taPwrHostPolicy[i]);
+
+        _PwrHost_Print(g_u32aPwrHostBudget[i], PWR_HOST_MODE_FIXED, &g_taPwrHostFixed[i]);
+        _PwrHost_Print(g_u32aPwrHostBudget[i], PWR_HOST_MODE_POLICY, &g_taPwrHostPolicy[i]);
+
+        // the same frames whatever the mode
+        HOST_TEST_EQ(g_taPwrHostFixed[i].u32Rx, g_tPwrHostOff.u32Rx);
+        HOST_TEST_EQ(g_taPwrHostPolicy[i].u32Rx, g_tPwrHostOff.u32Rx);
+
+        // never above every DTIM, never below the fixed skip count
+        HOST_TEST_ASSERT(g_taPwrHostPolicy[i].u32AwakeUs <= g_tPwrHostOff.u32AwakeUs);
+        HOST_TEST_ASSERT(g_taPwrHostPolicy[i].u32AwakeUs >= g_taPwrHostFixed[i].u32AwakeUs);
+    }
+}
+
+/*
+ * The cases
+ */
+
+// busy: every window with traffic or its linger is every DTIM, as the policy off
+static void _PwrHost_Stream(void)
+{
+    uint32_t i = 0;
+
+    _PwrHost_TraceStream();
+    _PwrHost_Curve("stream");
+
+    for (i = 0; i < PWR_HOST_BUDGET_NUM; i++)
+    {
+        HOST_TEST_ASSERT(g_taPwrHostPolicy[i].u32Active >= (PWR_HOST_TRACE_END_MS / WIFI_PWR_POLICY_WINDOW_MS));
+        HOST_TEST_EQ(g_taPwrHostPolicy[i].u32LatAvg, g_tPwrHostOff.u32LatAvg);
+        HOST_TEST_EQ(g_taPwrHostPolicy[i].u32LatMax, g_tPwrHostOff.u32LatMax);
+    }
+}
+
+// idle between pushes: the power of the fixed skip count
+static void _PwrHost_Push(void)
+{
+    uint32_t i = 0;
+
+    _PwrHost_TracePush();
+    _PwrHost_Curve("push");
+
+    for (i = 0; i < PWR_HOST_BUDGET_NUM; i++)
+    {
+        if (g_u32aPwrHostBudget[i] < 1000)
+            continue;
+
+        HOST_TEST_ASSERT(g_taPwrHostPolicy[i].u32AwakeUs < (g_tPwrHostOff.u32AwakeUs / 4));
+
+        if (i)
+            HOST_TEST_ASSERT(g_taPwrHostPolicy[i].u32AwakeUs <= g_taPwrHostPolicy[i - 1].u32AwakeUs);
+    }
+}
+
+// a report and its reply a minute: the TX linger keeps every DTIM for the reply
+static void _PwrHost_Sensor(void)
+{
+    uint32_t i = 0;
+
+    _PwrHost_TraceSensor();
+    _PwrHost_Curve("sensor");
+
+    for (i = 0; i < PWR_HOST_BUDGET_NUM; i++)
+    {
+        if (g_u32aPwrHostBudget[i] < 1000)
+            continue;
+
+        HOST_TEST_ASSERT(g_taPwrHostPolicy[i].u32AwakeUs < (g_tPwrHostOff.u32AwakeUs / 4));
+    }
+}
+
+// downloads: every DTIM after the first frames, the fixed skip count delays all of
+// them. A wake period as long as the download takes it all at once either way.
+static void _PwrHost_Burst(void)
+{
+    uint32_t i = 0;
+
+    _PwrHost_TraceBurst();
+    _PwrHost_Curve("burst");
+
+    for (i = 0; i < PWR_HOST_BUDGET_NUM; i++)
+    {
+        if ((g_u32aPwrHostBudget[i] < 1000) || (g_u32aPwrHostBudget[i] > 3000))
+            continue;
+
+        HOST_TEST_ASSERT(g_taPwrHostPolicy[i].u32LatAvg < (g_taPwrHostFixed[i].u32LatAvg / 2));
+        HOST_TEST_ASSERT(g_taPwrHostPolicy[i].u32AwakeUs < (g_tPwrHostOff.u32AwakeUs / 2));
+    }
+}
+
+// off restores the skip count and the listen interval of the application
+static void _PwrHost_Restore(void)
+{
+    wifi_pwr_policy_stat_t tStat;
+
+    g_u8PwrHostSkipApp = 2;
+    g_u8PwrHostListenApp = 3;
+    g_u8PwrHostSkip = g_u8PwrHostSkipApp;
+    g_u8PwrHostListen = g_u8PwrHostListenApp;
+
+    HOST_TEST_EQ(wifi_pwr_policy_budget_set(WIFI_PWR_POLICY_BUDGET_MAX + 1), -1);
+    HOST_TEST_EQ(wifi_pwr_policy_budget_get(), 0);
+
+    HOST_TEST_EQ(wifi_pwr_policy_budget_set(5000), 0);
+    HOST_TEST_EQ(g_u8PwrHostListen, (5000 * 1000) / (PWR_HOST_BEACON_TU * 1024));
+
+    // the first window sends the skip count whatever M0 has
+    g_u32PwrHostSkipSet = 0;
+    g_fpPwrHostWindow(NULL);
+    HOST_TEST_EQ(g_u32PwrHostSkipSet, 1);
+
+    wifi_pwr_policy_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.skip_app, 2);
+    HOST_TEST_EQ(tStat.listen_interval_app, 3);
+    HOST_TEST_EQ(tStat.skip_max, _PwrHost_SkipMax(5000));
+
+    HOST_TEST_EQ(wifi_pwr_policy_budget_set(0), 0);
+    HOST_TEST_EQ(g_u8PwrHostSkip, 2);
+    HOST_TEST_EQ(g_u8PwrHostListen, 3);
+
+    g_u8PwrHostSkipApp = 0;
+    g_u8PwrHostListenApp = 1;
+    g_u8PwrHostSkip = 0;
+}
+
+// not connected: the window leaves M0 alone, the next association gets the skip count again
+static void _PwrHost_Disconnect(void)
+{
+    wifi_pwr_policy_stat_t tStat;
+
+    HOST_TEST_EQ(wifi_pwr_policy_budget_set(3000), 0);
+    g_fpPwrHostWindow(NULL);
+
+    g_u8PwrHostConnected = 0;
+    g_u32PwrHostSkipSet = 0;
+    HostOs_TimeAdvanceUs(WIFI_PWR_POLICY_WINDOW_MS * 1000);
+    g_fpPwrHostWindow(NULL);
+    HOST_TEST_EQ(g_u32PwrHostSkipSet, 0);
+
+    // M0 starts from its flash setting after the association
+    g_u8PwrHostConnected = 1;
+    g_u8PwrHostSkip = 0;
+    HostOs_TimeAdvanceUs(WIFI_PWR_POLICY_WINDOW_MS * 1000);
+    g_fpPwrHostWindow(NULL);
+    HOST_TEST_EQ(g_u32PwrHostSkipSet, 1);
+
+    wifi_pwr_policy_stat_get(&tStat);
+    HOST_TEST_EQ(g_u8PwrHostSkip, tStat.skip);
+
+    HOST_TEST_EQ(wifi_pwr_policy_budget_set(0), 0);
+}
+
+static void _PwrHost_Cmd(void)
+{
+    char baCmd[64];
+
+    _PwrHost_OutReset();
+    strcpy(baCmd, "wifipwr budget 1000");
+    wifi_pwr_policy_cmd(baCmd);
+    HOST_TEST_ASSERT(strstr(g_baPwrHostOut, "wifipwr: budget=1000 ms") != NULL);
+
+    _PwrHost_OutReset();
+    strcpy(baCmd, "wifipwr curve 2");
+    wifi_pwr_policy_cmd(baCmd);
+    HOST_TEST_ASSERT(strstr(g_baPwrHostOut, "wifipwr: dtim=102 ms pkt/s=2") != NULL);
+    HOST_TEST_ASSERT(strstr(g_baPwrHostOut, "     0         102       32000") != NULL);
+    HOST_TEST_ASSERT(strstr(g_baPwrHostOut, "   127       13056        5000") != NULL);
+
+    _PwrHost_OutReset();
+    strcpy(baCmd, "wifipwr budget 0");
+    wifi_pwr_policy_cmd(baCmd);
+    HOST_TEST_ASSERT(strstr(g_baPwrHostOut, "wifipwr: budget=0 ms") != NULL);
+    HOST_TEST_EQ(g_u8PwrHostTimerRun, 0);
+}
+
+static const T_HostTestCase g_taPwrHostCase[] =
+{
+    HOST_TEST_CASE(_PwrHost_Stream),
+    HOST_TEST_CASE(_PwrHost_Push),
+    HOST_TEST_CASE(_PwrHost_Sensor),
+    HOST_TEST_CASE(_PwrHost_Burst),
+    HOST_TEST_CASE(_PwrHost_Restore),
+    HOST_TEST_CASE(_PwrHost_Disconnect),
+    HOST_TEST_CASE(_PwrHost_Cmd),
+};
+
+int main(void)
+{
+    HostOs_Init();
+    HostOs_TimeFreeze(1);
+
+    // past the linger of a TX at tick 0
+    HostOs_TimeAdvanceUs(10 * 1000 * 1000);
+
+    g_u8PwrHostConnected = 1;
+    g_u8PwrHostListenApp = 1;
+
+    osTimerCreate = _PwrHost_TimerCreate;
+    osTimerStart = _PwrHost_TimerStart;
+    osTimerStop = _PwrHost_TimerStop;
+    tracer_drct_printf = _PwrHost_Tracer;
+
+    return HostTest_Run("wifi_pwr_policy", g_taPwrHostCase, HOST_TEST_NUM(g_taPwrHostCase));
+}
@@ -0,0 +1,711 @@
+/******************************************************************************
+*  Copyright 2017 - 2018, Opulinks Technology Ltd.
+*  ---------------------------------------------------------------------------
+*  Statement:
+*  ----------
+*  This software is protected by Copyright and the information contained
+*  herein is confidential. The software may not be copied and the information
+*  contained herein may not be used or disclosed except with the written
+*  permission of Opulinks Technology Ltd. (C) 2018
+******************************************************************************/
+
+/******************************************************************************
+*  Filename:
+*  ---------
+*  wifi_scan_cache_host.c
+*
+*  Project:
+*  --------
+*  OPL1000 series
+*
+*  Description:
+*  ------------
+*  wifi_scan_cache.c against scripted scan results.
+*
+*  The test is the Wi-Fi API: the APs in the air are a table the cases
+*  change (channel, RSSI, gone), a scan returns those of the channels it
+*  covers and takes its dwell per channel of simulated time, and a connect
+*  takes SCAN_HOST_ASSOC_MS more before the STA_CONNECTED event goes to the
+*  handler the cache hooked. The time is frozen otherwise, so the time to
+*  associate of the fast and the full path is exact.
+*
+******************************************************************************/
+
+/***********************
+Head Block of The File
+***********************/
+// Sec 0: Comment block of the file
+
+// Sec 1: Include File
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "cmsis_os.h"
+#include "wifi_types.h"
+#include "wifi_event.h"
+#include "wifi_api_if.h"
+#include "wifi_event_handler_if.h"
+#include "wifi_scan_cache.h"
+#include "host_os.h"
+#include "host_test.h"
+
+// Sec 2: Constant Definitions, Imported Symbols, miscellaneous
+#define SCAN_HOST_AP_MAX            (12)
+#define SCAN_HOST_CH_NUM            (13)
+#define SCAN_HOST_FULL_DWELL_MS     (120)       // per channel, the default of the full scan
+#define SCAN_HOST_ASSOC_MS          (60)        // auth, assoc and the 4-way handshake
+#define SCAN_HOST_SCAN_MAX          (32)
+#define SCAN_HOST_OUT_SIZE          (2048)
+
+#define SCAN_HOST_FULL_MS           (SCAN_HOST_CH_NUM * SCAN_HOST_FULL_DWELL_MS)
+
+/********************************************
+Declaration of data structure
+********************************************/
+// Sec 3: structure, uniou, enum, linked list...
+typedef struct
+{
+    const char *sSsid;
+    uint8_t u8aBssid[WIFI_MAC_ADDRESS_LENGTH];
+    uint8_t u8Channel;
+    int8_t s8Rssi;
+    uint8_t u8Present;
+} T_ScanHostAp;
+
+typedef struct
+{
+    uint8_t u8Channel;                      // 0: all
+    uint32_t u32DwellMs;
+} T_ScanHostScan;
+
+/********************************************
+Declaration of Global Variables & Functions
+********************************************/
+// Sec 4: declaration of global variable
+
+// Sec 5: declaration of global function prototype
+
+/***************************************************
+Declaration of static Global Variables &  Functions
+***************************************************/
+// Sec 6: declaration of static global variable
+static T_ScanHostAp g_taScanHostAp[SCAN_HOST_AP_MAX];
+static uint32_t g_u32ScanHostApNum;
+
+// the scans of the last connect, and the list of the last scan
+static T_ScanHostScan g_taScanHostScan[SCAN_HOST_SCAN_MAX];
+static uint32_t g_u32ScanHostScanNum;
+static wifi_scan_list_t g_tScanHostList;
+
+// the configuration of the last connect, and the events the original handler got
+static wifi_config_t g_tScanHostConn;
+static uint32_t g_u32ScanHostConnNum;
+static uint32_t g_u32ScanHostEvent;
+static wifi_config_t g_tScanHostSta;
+static uint32_t g_u32ScanHostRunMs;
+
+static char g_baScanHostOut[SCAN_HOST_OUT_SIZE];
+static uint32_t g_u32ScanHostOutLen;
+
+// Sec 7: declaration of static function prototype
+
+/***********
+C Functions
+***********/
+// Sec 8: C Functions
+
+/*
+ * The APs in the air
+ */
+static T_ScanHostAp *_ScanHost_ApAdd(const char *sSsid, uint8_t u8Id, uint8_t u8Channel, int8_t s8Rssi)
+{
+    T_ScanHostAp *ptAp = &g_taScanHostAp[g_u32ScanHostApNum++];
+    uint8_t u8aBssid[WIFI_MAC_ADDRESS_LENGTH] = {0x02, 0x4F, 0x50, 0x4C, 0x00, 0x00};
+
+    u8aBssid[5] = u8Id;
+
+    ptAp->sSsid = sSsid;
+    memcpy(ptAp->u8aBssid, u8aBssid, WIFI_MAC_ADDRESS_LENGTH);
+    ptAp->u8Channel = u8Channel;
+    ptAp->s8Rssi = s8Rssi;
+    ptAp->u8Present = 1;
+
+    return ptAp;
+}
+
+static T_ScanHostAp *_ScanHost_ApGet(const uint8_t *pu8Bssid)
+{
+    uint32_t i = 0;
+
+    for (i = 0; i < g_u32ScanHostApNum; i++)
+    {
+        if (!memcmp(g_taScanHostAp[i].u8aBssid, pu8Bssid, WIFI_MAC_ADDRESS_LENGTH))
+            return &g_taScanHostAp[i];
+    }
+
+    return NULL;
+}
+
+/*
+ * The Wi-Fi API
+ */
+// the scan of the case, and the time it takes
+static void _ScanHost_ScanLog(const wifi_scan_config_t *ptConfig, bool bBlock)
+{
+    uint32_t u32Dwell = 0;
+
+    HOST_TEST_ASSERT(bBlock);
+    HOST_TEST_ASSERT(g_u32ScanHostScanNum < SCAN_HOST_SCAN_MAX);
+
+    u32Dwell = (ptConfig->scan_time.active.max) ? ptConfig->scan_time.active.max : SCAN_HOST_FULL_DWELL_MS;
+
+    g_taScanHostScan[g_u32ScanHostScanNum].u8Channel = ptConfig->channel;
+    g_taScanHostScan[g_u32ScanHostScanNum].u32DwellMs = u32Dwell;
+    g_u32ScanHostScanNum++;
+
+    HostOs_TimeAdvanceUs(u32Dwell * ((ptConfig->channel) ? 1 : SCAN_HOST_CH_NUM) * 1000);
+}
+
+static int _ScanHost_ScanStart(const wifi_scan_config_t *ptConfig, bool bBlock)
+{
+    wifi_scan_info_t *ptInfo = NULL;
+    T_ScanHostAp *ptAp = NULL;
+    uint32_t i = 0;
+
+    _ScanHost_ScanLog(ptConfig, bBlock);
+
+    // the list of this scan only, as the supplicant keeps it
+    memset(&g_tScanHostList, 0, sizeof(g_tScanHostList));
+
+    for (i = 0; i < g_u32ScanHostApNum; i++)
+    {
+        ptAp = &g_taScanHostAp[i];
+
+        if ((!ptAp->u8Present) || ((ptConfig->channel) && (ptConfig->channel != ptAp->u8Channel)))
+            continue;
+
+        ptInfo = &g_tScanHostList.ap_record[g_tScanHostList.num++];
+        ptInfo->ssid_length = (uint8_t)strlen(ptAp->sSsid);
+        memcpy(ptInfo->ssid, ptAp->sSsid, ptInfo->ssid_length);
+        memcpy(ptInfo->bssid, ptAp->u8aBssid, WIFI_MAC_ADDRESS_LENGTH);
+        ptInfo->channel = ptAp->u8Channel;
+        ptInfo->rssi = ptAp->s8Rssi;
+        ptInfo->auth_mode = WIFI_AUTH_WPA2_PSK;
+    }
+
+    return 0;
+}
+
+static int _ScanHost_ApList(wifi_scan_list_t *ptList)
+{
+    memcpy(ptList, &g_tScanHostList, sizeof(*ptList));
+    return 0;
+}
+
+// STA_CONNECTED once the AP of the BSSID is associated, through the hooked handler
+static int _ScanHost_Connect(wifi_config_t *ptConfig)
+{
+    wifi_event_sta_connected_t tConn;
+    T_ScanHostAp *ptAp = NULL;
+
+    memcpy(&g_tScanHostConn, ptConfig, sizeof(g_tScanHostConn));
+    g_u32ScanHostConnNum++;
+
+    if (!ptConfig->sta_config.bssid_present)
+        return -1;
+
+    ptAp = _ScanHost_ApGet(ptConfig->sta_config.bssid);
+
+    if ((!ptAp) || (!ptAp->u8Present))
+        return -1;
+
+    HostOs_TimeAdvanceUs(SCAN_HOST_ASSOC_MS * 1000);
+
+    memset(&tConn, 0, sizeof(tConn));
+    tConn.ssid_len = (uint8_t)strlen(ptAp->sSsid);
+    memcpy(tConn.ssid, ptAp->sSsid, tConn.ssid_len);
+    memcpy(tConn.bssid, ptAp->u8aBssid, WIFI_MAC_ADDRESS_LENGTH);
+    tConn.channel = ptAp->u8Channel;
+    tConn.authmode = WIFI_AUTH_WPA2_PSK;
+
+    wifi_event_process_handler_api(WIFI_EVENT_STA_CONNECTED, (uint8_t *)&tConn, sizeof(tConn));
+    return 0;
+}
+
+static int _ScanHost_GetConfig(wifi_mode_t tMode, wifi_config_t *ptConfig)
+{
+    memcpy(ptConfig, &g_tScanHostSta, sizeof(*ptConfig));
+    return 0;
+}
+
+// the handler of the ROM the cache forwards to
+static int _ScanHost_Event(wifi_event_t tEvent, uint8_t *pu8Payload, uint32_t u32Len)
+{
+    g_u32ScanHostEvent++;
+    return 0;
+}
+
+wifi_scan_start_fp_t wifi_scan_start_api = _ScanHost_ScanStart;
+wifi_scan_get_ap_list_fp_t wifi_scan_get_ap_list_api = _ScanHost_ApList;
+wifi_connection_connect_fp_t wifi_connection_connect_api = _ScanHost_Connect;
+wifi_get_config_fp_t wifi_get_config_api = _ScanHost_GetConfig;
+wifi_event_process_handler_fp_t wifi_event_process_handler_api = _ScanHost_Event;
+
+/*
+ * The output of "scancache"
+ */
+static int _ScanHost_Tracer(const char *sFmt, ...)
+{
+    va_list tList;
+    int iLen;
+
+    va_start(tList, sFmt);
+    iLen = vsnprintf(&g_baScanHostOut[g_u32ScanHostOutLen], sizeof(g_baScanHostOut) - g_u32ScanHostOutLen,
+                     sFmt, tList);
+    va_end(tList);
+
+    if (iLen > 0)
+        g_u32ScanHostOutLen += iLen;
+
+    if (g_u32ScanHostOutLen >= sizeof(g_baScanHostOut))
+        g_u32ScanHostOutLen = sizeof(g_baScanHostOut) - 1;
+
+    return 0;
+}
+
+static void _ScanHost_OutReset(void)
+{
+    g_u32ScanHostOutLen = 0;
+    g_baScanHostOut[0] = 0;
+}
+
+/*
+ * Helpers of the cases
+ */
+static void _ScanHost_Config(wifi_config_t *ptConfig, const char *sSsid, const T_ScanHostAp *ptPin)
+{
+    memset(ptConfig, 0, sizeof(*ptConfig));
+    ptConfig->sta_config.ssid_length = (uint8_t)strlen(sSsid);
+    memcpy(ptConfig->sta_config.ssid, sSsid, ptConfig->sta_config.ssid_length);
+
+    if (ptPin)
+    {
+        ptConfig->sta_config.bssid_present = 1;
+        memcpy(ptConfig->sta_config.bssid, ptPin->u8aBssid, WIFI_MAC_ADDRESS_LENGTH);
+    }
+}
+
+// wifi_scan_cache_connect, and the time it took to STA_CONNECTED
+static void _ScanHost_Run(const char *sSsid, const T_ScanHostAp *ptPin, int iRet)
+{
+    wifi_config_t tConfig;
+    uint32_t u32Start = osKernelSysTick();
+
+    g_u32ScanHostScanNum = 0;
+    _ScanHost_Config(&tConfig, sSsid, ptPin);
+
+    HOST_TEST_EQ(wifi_scan_cache_connect(&tConfig), iRet);
+
+    g_u32ScanHostRunMs = osKernelSysTick() - u32Start;
+}
+
+static void _ScanHost_Reset(void)
+{
+    wifi_scan_cache_clear();
+    wifi_scan_cache_stat_reset();
+    HOST_TEST_EQ(wifi_scan_cache_age_set(WIFI_SCAN_CACHE_AGE_DEF), 0);
+
+    memset(g_taScanHostAp, 0, sizeof(g_taScanHostAp));
+    g_u32ScanHostApNum = 0;
+    g_u32ScanHostScanNum = 0;
+    g_u32ScanHostConnNum = 0;
+}
+
+/*
+ * The cases
+ */
+
+// nothing cached: one full scan, the strongest AP of the SSID by its BSSID
+static void _ScanHost_ColdFull(void)
+{
+    wifi_scan_cache_stat_t tStat;
+    T_ScanHostAp *ptStrong = NULL;
+
+    _ScanHost_Reset();
+    _ScanHost_ApAdd("opl_home", 1, 1, -70);
+    ptStrong = _ScanHost_ApAdd("opl_home", 2, 6, -48);
+    _ScanHost_ApAdd("neighbour", 3, 11, -40);
+
+    _ScanHost_Run("opl_home", NULL, 0);
+
+    HOST_TEST_EQ(g_u32ScanHostScanNum, 1);
+    HOST_TEST_EQ(g_taScanHostScan[0].u8Channel, 0);
+    HOST_TEST_EQ(g_tScanHostConn.sta_config.bssid_present, 1);
+    HOST_TEST_ASSERT(!memcmp(g_tScanHostConn.sta_config.bssid, ptStrong->u8aBssid, WIFI_MAC_ADDRESS_LENGTH));
+
+    wifi_scan_cache_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.connect, 1);
+    HOST_TEST_EQ(tStat.probe, 0);
+    HOST_TEST_EQ(tStat.full_scan, 1);
+    HOST_TEST_EQ(tStat.full_hit, 1);
+    HOST_TEST_EQ(tStat.assoc_full, 1);
+    HOST_TEST_EQ(tStat.assoc_fast, 0);
+    HOST_TEST_EQ(tStat.assoc_ms_last, SCAN_HOST_FULL_MS + SCAN_HOST_ASSOC_MS);
+    HOST_TEST_EQ(g_u32ScanHostRunMs, tStat.assoc_ms_last);
+
+    printf("assoc: path=full ms=%u\n", tStat.assoc_ms_last);
+}
+
+// the full scan cached the APs: one probe on the channel of the strongest
+static void _ScanHost_WarmFast(void)
+{
+    wifi_scan_cache_entry_t taEntry[WIFI_SCAN_CACHE_NUM];
+    wifi_scan_cache_stat_t tStat;
+    uint32_t u32Dwell = 0;
+
+    // the cache of _ScanHost_ColdFull
+    HOST_TEST_EQ(wifi_scan_cache_find(NULL, 0, taEntry, WIFI_SCAN_CACHE_NUM), 3);
+    HOST_TEST_EQ(wifi_scan_cache_find((const uint8_t *)"opl_home", 8, taEntry, WIFI_SCAN_CACHE_NUM), 2);
+    HOST_TEST_EQ(taEntry[0].channel, 6);
+    HOST_TEST_EQ(taEntry[0].rssi, -48);
+    HOST_TEST_EQ(taEntry[1].channel, 1);
+
+    wifi_scan_cache_stat_get(&tStat);
+    u32Dwell = tStat.dwell;
+
+    _ScanHost_Run("opl_home", NULL, 0);
+
+    HOST_TEST_EQ(g_u32ScanHostScanNum, 1);
+    HOST_TEST_EQ(g_taScanHostScan[0].u8Channel, 6);
+    HOST_TEST_EQ(g_taScanHostScan[0].u32DwellMs, u32Dwell);
+    HOST_TEST_EQ(g_tScanHostConn.sta_config.bssid[5], 2);
+
+    wifi_scan_cache_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.probe, 1);
+    HOST_TEST_EQ(tStat.probe_hit, 1);
+    HOST_TEST_EQ(tStat.full_scan, 1);
+    HOST_TEST_EQ(tStat.assoc_fast, 1);
+    HOST_TEST_EQ(tStat.assoc_ms_last, u32Dwell + SCAN_HOST_ASSOC_MS);
+    HOST_TEST_EQ(g_u32ScanHostRunMs, tStat.assoc_ms_last);
+    HOST_TEST_EQ(tStat.assoc_ms_max, SCAN_HOST_FULL_MS + SCAN_HOST_ASSOC_MS);
+
+    // a hit shortens the next dwell
+    HOST_TEST_ASSERT(tStat.dwell < u32Dwell);
+
+    printf("assoc: path=fast ms=%u dwell=%u full_ms=%u\n", tStat.assoc_ms_last, u32Dwell,
+           SCAN_HOST_FULL_MS + SCAN_HOST_ASSOC_MS);
+}
+
+// the AP left channel 6 for 11: the cached channels miss, the full scan finds it
+static void _ScanHost_Moved(void)
+{
+    wifi_scan_cache_entry_t taEntry[WIFI_SCAN_CACHE_NUM];
+    wifi_scan_cache_stat_t tStat;
+    wifi_scan_cache_stat_t tBefore;
+    T_ScanHostAp *ptAp = _ScanHost_ApGet((const uint8_t *)"\x02\x4F\x50\x4C\x00\x02");
+
+    ptAp->u8Channel = 11;
+    g_taScanHostAp[0].u8Present = 0;
+    wifi_scan_cache_stat_get(&tBefore);
+
+    _ScanHost_Run("opl_home", NULL, 0);
+
+    // both cached channels, the strongest first, then all
+    HOST_TEST_EQ(g_u32ScanHostScanNum, 3);
+    HOST_TEST_EQ(g_taScanHostScan[0].u8Channel, 6);
+    HOST_TEST_EQ(g_taScanHostScan[1].u8Channel, 1);
+    HOST_TEST_EQ(g_taScanHostScan[2].u8Channel, 0);
+    HOST_TEST_EQ(g_tScanHostConn.sta_config.bssid[5], 2);
+
+    wifi_scan_cache_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.probe, tBefore.probe + 2);
+    HOST_TEST_EQ(tStat.probe_hit, tBefore.probe_hit);
+    HOST_TEST_EQ(tStat.full_hit, tBefore.full_hit + 1);
+    HOST_TEST_EQ(tStat.assoc_full, tBefore.assoc_full + 1);
+    HOST_TEST_EQ(tStat.assoc_ms_last, tBefore.dwell + g_taScanHostScan[1].u32DwellMs +
+                                      SCAN_HOST_FULL_MS + SCAN_HOST_ASSOC_MS);
+
+    // misses lengthen the dwell
+    HOST_TEST_ASSERT(tStat.hit_rate < tBefore.hit_rate);
+    HOST_TEST_ASSERT(tStat.dwell > tBefore.dwell);
+
+    // the new channel is cached for the next time
+    HOST_TEST_EQ(wifi_scan_cache_find((const uint8_t *)"opl_home", 8, taEntry, WIFI_SCAN_CACHE_NUM), 2);
+    HOST_TEST_EQ(taEntry[0].channel, 11);
+
+    _ScanHost_Run("opl_home", NULL, 0);
+    HOST_TEST_EQ(g_u32ScanHostScanNum, 1);
+    HOST_TEST_EQ(g_taScanHostScan[0].u8Channel, 11);
+}
+
+// a pinned BSSID probes its own channels only, and connects to it
+static void _ScanHost_Pinned(void)
+{
+    T_ScanHostAp *ptWeak = NULL;
+
+    _ScanHost_Reset();
+    _ScanHost_ApAdd("opl_home", 1, 3, -45);
+    ptWeak = _ScanHost_ApAdd("opl_home", 2, 9, -75);
+    _ScanHost_Run("opl_home", NULL, 0);
+
+    _ScanHost_Run("opl_home", ptWeak, 0);
+
+    HOST_TEST_EQ(g_u32ScanHostScanNum, 1);
+    HOST_TEST_EQ(g_taScanHostScan[0].u8Channel, 9);
+    HOST_TEST_ASSERT(!memcmp(g_tScanHostConn.sta_config.bssid, ptWeak->u8aBssid, WIFI_MAC_ADDRESS_LENGTH));
+}
+
+// entries older than the age are dropped: no probe, the full scan
+static void _ScanHost_Expiry(void)
+{
+    wifi_scan_cache_entry_t taEntry[WIFI_SCAN_CACHE_NUM];
+    wifi_scan_cache_stat_t tStat;
+
+    _ScanHost_Reset();
+    _ScanHost_ApAdd("opl_home", 1, 4, -50);
+    _ScanHost_ApAdd("opl_home", 2, 8, -60);
+    _ScanHost_Run("opl_home", NULL, 0);
+
+    HOST_TEST_EQ(wifi_scan_cache_age_set(0), -1);
+    HOST_TEST_EQ(wifi_scan_cache_age_set(WIFI_SCAN_CACHE_AGE_MAX + 1), -1);
+    HOST_TEST_EQ(wifi_scan_cache_age_set(10), 0);
+    HOST_TEST_EQ(wifi_scan_cache_age_get(), 10);
+
+    // the age since the scan, and a tick past it since the connect
+    HostOs_TimeAdvanceUs(10 * 1000 * 1000 - SCAN_HOST_ASSOC_MS * 1000);
+    HOST_TEST_EQ(wifi_scan_cache_find(NULL, 0, taEntry, WIFI_SCAN_CACHE_NUM), 2);
+
+    HostOs_TimeAdvanceUs(1000);
+    HOST_TEST_EQ(wifi_scan_cache_find(NULL, 0, taEntry, WIFI_SCAN_CACHE_NUM), 1);
+    HOST_TEST_EQ(taEntry[0].bssid[5], 1);
+
+    HostOs_TimeAdvanceUs(SCAN_HOST_ASSOC_MS * 1000);
+    HOST_TEST_EQ(wifi_scan_cache_find(NULL, 0, taEntry, WIFI_SCAN_CACHE_NUM), 0);
+
+    wifi_scan_cache_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.expired, 2);
+
+    _ScanHost_Run("opl_home", NULL, 0);
+    HOST_TEST_EQ(g_u32ScanHostScanNum, 1);
+    HOST_TEST_EQ(g_taScanHostScan[0].u8Channel, 0);
+
+    wifi_scan_cache_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.probe, 0);
+    HOST_TEST_EQ(tStat.full_scan, 2);
+}
+
+// the SSID is not in the air: the config goes to connect as it is
+static void _ScanHost_NotFound(void)
+{
+    wifi_scan_cache_stat_t tStat;
+
+    _ScanHost_Reset();
+    _ScanHost_ApAdd("neighbour", 1, 6, -40);
+
+    _ScanHost_Run("opl_home", NULL, -1);
+
+    HOST_TEST_EQ(g_u32ScanHostConnNum, 1);
+    HOST_TEST_EQ(g_tScanHostConn.sta_config.bssid_present, 0);
+
+    wifi_scan_cache_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.full_scan, 1);
+    HOST_TEST_EQ(tStat.full_hit, 0);
+    HOST_TEST_EQ(tStat.assoc_full, 0);
+
+    HOST_TEST_EQ(wifi_scan_cache_connect(NULL), -1);
+}
+
+// hidden and channel-less records stay out, the oldest BSSID makes room
+static void _ScanHost_Entries(void)
+{
+    wifi_scan_cache_entry_t taEntry[WIFI_SCAN_CACHE_NUM];
+    wifi_scan_info_t taInfo[WIFI_SCAN_CACHE_NUM + 1];
+    uint32_t i = 0;
+
+    _ScanHost_Reset();
+    memset(taInfo, 0, sizeof(taInfo));
+
+    taInfo[0].channel = 1;                          // hidden
+    taInfo[1].ssid_length = 3;                      // no channel
+    memcpy(taInfo[1].ssid, "abc", 3);
+    wifi_scan_cache_update(taInfo, 2);
+    HOST_TEST_EQ(wifi_scan_cache_find(NULL, 0, taEntry, WIFI_SCAN_CACHE_NUM), 0);
+
+    for (i = 0; i <= WIFI_SCAN_CACHE_NUM; i++)
+    {
+        taInfo[i].ssid_length = 3;
+        memcpy(taInfo[i].ssid, "abc", 3);
+        taInfo[i].bssid[5] = (uint8_t)i;
+        taInfo[i].channel = 1;
+        taInfo[i].rssi = -90 + (int)i;
+
+        // one at a time, a tick apart
+        wifi_scan_cache_update(&taInfo[i], 1);
+        HostOs_TimeAdvanceUs(1000);
+    }
+
+    HOST_TEST_EQ(wifi_scan_cache_find(NULL, 0, taEntry, WIFI_SCAN_CACHE_NUM), WIFI_SCAN_CACHE_NUM);
+
+    // the strongest first, the first one gone
+    HOST_TEST_EQ(taEntry[0].bssid[5], WIFI_SCAN_CACHE_NUM);
+    HOST_TEST_EQ(taEntry[WIFI_SCAN_CACHE_NUM - 1].bssid[5], 1);
+
+    // the same BSSID again is an update, not a new entry
+    taInfo[3].rssi = -20;
+    wifi_scan_cache_update(&taInfo[3], 1);
+    HOST_TEST_EQ(wifi_scan_cache_find(NULL, 0, taEntry, WIFI_SCAN_CACHE_NUM), WIFI_SCAN_CACHE_NUM);
+    HOST_TEST_EQ(taEntry[0].bssid[5], 3);
+
+    // fewer slots than entries: the strongest ones
+    HOST_TEST_EQ(wifi_scan_cache_find(NULL, 0, taEntry, 2), 2);
+    HOST_TEST_EQ(taEntry[0].rssi, -20);
+    HOST_TEST_EQ(taEntry[1].bssid[5], WIFI_SCAN_CACHE_NUM);
+}
+
+// the events reach the original handler; STA_CONNECTED keeps the RSSI of the scan
+static void _ScanHost_Events(void)
+{
+    wifi_scan_cache_entry_t taEntry[WIFI_SCAN_CACHE_NUM];
+    wifi_event_sta_connected_t tConn;
+    wifi_scan_cache_stat_t tStat;
+    uint32_t u32Event = g_u32ScanHostEvent;
+
+    _ScanHost_Reset();
+    _ScanHost_ApAdd("opl_home", 1, 5, -55);
+    _ScanHost_ApAdd("opl_guest", 2, 5, -65);
+
+    // a scan of the application lands in the cache too
+    g_u32ScanHostScanNum = 0;
+    HOST_TEST_EQ(wifi_scan_start_api(&(wifi_scan_config_t){0}, true), 0);
+    HOST_TEST_EQ(wifi_event_process_handler_api(WIFI_EVENT_SCAN_COMPLETE, NULL, 0), 0);
+    HOST_TEST_EQ(wifi_scan_cache_find(NULL, 0, taEntry, WIFI_SCAN_CACHE_NUM), 2);
+
+    memset(&tConn, 0, sizeof(tConn));
+    tConn.ssid_len = 8;
+    memcpy(tConn.ssid, "opl_home", 8);
+    memcpy(tConn.bssid, g_taScanHostAp[0].u8aBssid, WIFI_MAC_ADDRESS_LENGTH);
+    tConn.channel = 5;
+    HOST_TEST_EQ(wifi_event_process_handler_api(WIFI_EVENT_STA_CONNECTED, (uint8_t *)&tConn, sizeof(tConn)), 0);
+
+    HOST_TEST_EQ(wifi_scan_cache_find((const uint8_t *)"opl_home", 8, taEntry, WIFI_SCAN_CACHE_NUM), 1);
+    HOST_TEST_EQ(taEntry[0].rssi, -55);
+
+    // not from wifi_scan_cache_connect (the one of _ScanHost_NotFound failed): no time to associate
+    wifi_scan_cache_stat_get(&tStat);
+    HOST_TEST_EQ(tStat.assoc_fast + tStat.assoc_full, 0);
+    HOST_TEST_EQ(g_u32ScanHostEvent, u32Event + 2);
+    HOST_TEST_EQ(wifi_event_process_handler_api(WIFI_EVENT_STA_CONNECTED, NULL, 0), 0);
+    HOST_TEST_EQ(g_u32ScanHostEvent, u32Event + 3);
+}
+
+// the dwell follows the hit rate within its range
+static void _ScanHost_Dwell(void)
+{
+    wifi_scan_cache_stat_t tStat;
+    uint32_t u32Prev = 0;
+    uint32_t i = 0;
+
+    _ScanHost_Reset();
+    _ScanHost_ApAdd("opl_home", 1, 7, -50);
+    _ScanHost_Run("opl_home", NULL, 0);
+
+    wifi_scan_cache_stat_get(&tStat);
+    u32Prev = tStat.dwell;
+    HOST_TEST_EQ(u32Prev, (WIFI_SCAN_CACHE_DWELL_MIN + WIFI_SCAN_CACHE_DWELL_MAX) / 2);
+
+    for (i = 0; i < 40; i++)
+    {
+        _ScanHost_Run("opl_home", NULL, 0);
+
+        wifi_scan_cache_stat_get(&tStat);
+        HOST_TEST_ASSERT(tStat.dwell <= u32Prev);
+        HOST_TEST_ASSERT(tStat.dwell >= WIFI_SCAN_CACHE_DWELL_MIN);
+        u32Prev = tStat.dwell;
+    }
+
+    HOST_TEST_ASSERT(tStat.dwell < WIFI_SCAN_CACHE_DWELL_MIN + 10);
+    HOST_TEST_EQ(tStat.assoc_ms_last, g_taScanHostScan[0].u32DwellMs + SCAN_HOST_ASSOC_MS);
+
+    printf("assoc: path=fast ms=%u dwell=%u hit_rate=%u%%\n", tStat.assoc_ms_last,
+           g_taScanHostScan[0].u32DwellMs, (tStat.hit_rate * 100) / WIFI_SCAN_CACHE_RATE_ONE);
+
+    // the AP is gone for good: every probe misses
+    g_taScanHostAp[0].u8Present = 0;
+
+    for (i = 0; i < 40; i++)
+    {
+        _ScanHost_Run("opl_home", NULL, -1);
+
+        wifi_scan_cache_stat_get(&tStat);
+        HOST_TEST_ASSERT(tStat.dwell >= u32Prev);
+        HOST_TEST_ASSERT(tStat.dwell <= WIFI_SCAN_CACHE_DWELL_MAX);
+        u32Prev = tStat.dwell;
+    }
+
+    HOST_TEST_ASSERT(tStat.dwell > WIFI_SCAN_CACHE_DWELL_MAX - 10);
+}
+
+static void _ScanHost_Cmd(void)
+{
+    wifi_scan_cache_entry_t taEntry[WIFI_SCAN_CACHE_NUM];
+    char baCmd[32];
+
+    _ScanHost_Reset();
+    _ScanHost_ApAdd("opl_home", 1, 6, -48);
+    _ScanHost_Config(&g_tScanHostSta, "opl_home", NULL);
+
+    _ScanHost_OutReset();
+    strcpy(baCmd, "scancache connect");
+    wifi_scan_cache_cmd(baCmd);
+    HOST_TEST_ASSERT(strstr(g_baScanHostOut, "scancache: connect=0") != NULL);
+
+    _ScanHost_OutReset();
+    strcpy(baCmd, "scancache list");
+    wifi_scan_cache_cmd(baCmd);
+    HOST_TEST_ASSERT(strstr(g_baScanHostOut, "scancache: num=1 age=300 s") != NULL);
+    HOST_TEST_ASSERT(strstr(g_baScanHostOut, "02:4f:50:4c:00:01 ch= 6 rssi= -48") != NULL);
+
+    _ScanHost_OutReset();
+    strcpy(baCmd, "scancache stat");
+    wifi_scan_cache_cmd(baCmd);
+    HOST_TEST_ASSERT(strstr(g_baScanHostOut, "scancache: connect=1 probe=0 hit=0 full=1 full_hit=1") != NULL);
+    HOST_TEST_ASSERT(strstr(g_baScanHostOut, "assoc: fast=0 full=1 last=1620 ms") != NULL);
+
+    _ScanHost_OutReset();
+    strcpy(baCmd, "scancache age 0");
+    wifi_scan_cache_cmd(baCmd);
+    HOST_TEST_ASSERT(strstr(g_baScanHostOut, "invalid") != NULL);
+    HOST_TEST_EQ(wifi_scan_cache_age_get(), WIFI_SCAN_CACHE_AGE_DEF);
+
+    strcpy(baCmd, "scancache clear");
+    wifi_scan_cache_cmd(baCmd);
+    HOST_TEST_EQ(wifi_scan_cache_find(NULL, 0, taEntry, WIFI_SCAN_CACHE_NUM), 0);
+}
+
+static const T_HostTestCase g_taScanHostCase[] =
+{
+    HOST_TEST_CASE(_ScanHost_ColdFull),
+    HOST_TEST_CASE(_ScanHost_WarmFast),
+    HOST_TEST_CASE(_ScanHost_Moved),
+    HOST_TEST_CASE(_ScanHost_Pinned),
+    HOST_TEST_CASE(_ScanHost_Expiry),
+    HOST_TEST_CASE(_ScanHost_NotFound),
+    HOST_TEST_CASE(_ScanHost_Entries),
+    HOST_TEST_CASE(_ScanHost_Events),
+    HOST_TEST_CASE(_ScanHost_Dwell),
+    HOST_TEST_CASE(_ScanHost_Cmd),
+};
+
+int main(void)
+{
+    HostOs_Init();
+    HostOs_TimeFreeze(1);
+
+    // not at tick 0, which marks the unused entry
+    HostOs_TimeAdvanceUs(1000 * 1000);
+
+    tracer_drct_printf = _ScanHost_Tracer;
+    wifi_scan_cache_init();
+
+    return HostTest_Run("wifi_scan_cache", g_taScanHostCase, HOST_TEST_NUM(g_taScanHostCase));
+}
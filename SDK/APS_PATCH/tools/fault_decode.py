@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+###############################################################################
+#  Copyright 2017 - 2018, Opulinks Technology Ltd.
+#  ----------------------------------------------------------------------------
+#  Statement:
+#  ----------
+#  This software is protected by Copyright and the information contained
+#  herein is confidential. The software may not be copied and the information
+#  contained herein may not be used or disclosed except with the written
+#  permission of Opulinks Technology Ltd. (C) 2018
+###############################################################################
+#
+# Decode a crash record of sys_fault.c against the symbols of the image.
+#
+#   fault_decode.py <image.axf> [dump]
+#
+# The dump is the output of "crash show" on the CLI ("crash: ..." lines) or
+# of AT+CRASH? ("+CRASH:..." lines), read from stdin when not given; other
+# lines are left out. The image is the ELF armlink writes
+# (Output\Objects\opl1000_app_m3.axf). Only its symbol table is read, no
+# debug information is needed.
+#
+# PC, LR and every stack word that falls in a function of the image are
+# printed as function+offset, the Thumb bit cleared; the stack words are the
+# return addresses of the callers, and the locals that happen to look like
+# one. The fault status registers are spelled out. Addresses of the ROM are
+# not in the image and are printed as they are.
+#
+# The exit code is 1 when the dump has no record, else 0.
+###############################################################################
+
+import argparse
+import re
+import struct
+import sys
+
+EM_ARM = 40
+SHT_SYMTAB = 2
+STT_FUNC = 2
+
+CFSR_BITS = [
+    (0, 'IACCVIOL'), (1, 'DACCVIOL'), (3, 'MUNSTKERR'), (4, 'MSTKERR'), (7, 'MMARVALID'),
+    (8, 'IBUSERR'), (9, 'PRECISERR'), (10, 'IMPRECISERR'), (11, 'UNSTKERR'), (12, 'STKERR'), (15, 'BFARVALID'),
+    (16, 'UNDEFINSTR'), (17, 'INVSTATE'), (18, 'INVPC'), (19, 'NOCP'), (24, 'UNALIGNED'), (25, 'DIVBYZERO'),
+]
+HFSR_BITS = [(1, 'VECTTBL'), (30, 'FORCED'), (31, 'DEBUGEVT')]
+
+_RE_LINE = re.compile(r'^\s*(?:crash: |\+CRASH:)(.*?)\s*$')
+_RE_FIELD = re.compile(r'(\w+)=(\S+)')
+_RE_STACK = re.compile(r'^stack\+0x([0-9A-Fa-f]+)((?:\s+[0-9A-Fa-f]{8})+)$')
+
+
+class Func(object):
+    def __init__(self, name, addr, size):
+        self.name = name
+        self.addr = addr
+        self.size = size
+
+
+class Record(object):
+    def __init__(self):
+        self.fields = {}            # name -> text, of the key=value lines
+        self.stack = []             # (offset, word)
+        self.trace = []
+
+
+def elf_funcs(data):
+    """ FUNC symbols of a little endian ELF32/ELF64, sorted by address. """
+    if data[:4] != b'\x7fELF' or data[5] != 1:
+        raise ValueError('not a little endian ELF')
+
+    is64 = (data[4] == 2)
+    machine = struct.unpack_from('<H', data, 18)[0]
+
+    if is64:
+        shoff, = struct.unpack_from('<Q', data, 40)
+        shentsize, shnum = struct.unpack_from('<HH', data, 58)
+    else:
+        shoff, = struct.unpack_from('<I', data, 32)
+        shentsize, shnum = struct.unpack_from('<HH', data, 46)
+
+    def section(i):
+        off = shoff + i * shentsize
+        if is64:
+            _, stype, _, _, soff, ssize, link, _, _, entsize = struct.unpack_from('<IIQQQQIIQQ', data, off)
+        else:
+            _, stype, _, _, soff, ssize, link, _, _, entsize = struct.unpack_from('<IIIIIIIIII', data, off)
+        return stype, soff, ssize, link, entsize
+
+    funcs = []
+    for i in range(shnum):
+        stype, soff, ssize, link, entsize = section(i)
+        if stype != SHT_SYMTAB or not entsize:
+            continue
+
+        _, stroff, _, _, _ = section(link)
+
+        for off in range(soff, soff + ssize, entsize):
+            if is64:
+                name, info, _, shndx, value, size = struct.unpack_from('<IBBHQQ', data, off)
+            else:
+                name, value, size, info, _, shndx = struct.unpack_from('<IIIBBH', data, off)
+
+            if (info & 0xF) != STT_FUNC or shndx == 0:
+                continue
+
+            end = data.index(b'\0', stroff + name)
+            if machine == EM_ARM:
+                value &= ~1
+            funcs.append(Func(data[stroff + name:end].decode('ascii', 'replace'), value, size))
+
+    funcs.sort(key=lambda f: f.addr)
+    return funcs
+
+
+def lookup(funcs, addr):
+    """ 'name+0xoff' of the function holding addr, None if none does. """
+    lo, hi = 0, len(funcs)
+    while lo < hi:
+        mid = (lo + hi) // 2
+        if funcs[mid].addr <= addr:
+            lo = mid + 1
+        else:
+            hi = mid
+
+    # the last function at or below addr with a size that covers it
+    for f in reversed(funcs[max(0, lo - 4):lo]):
+        if f.addr <= addr < f.addr + max(f.size, 1):
+            return '%s+0x%x' % (f.name, addr - f.addr)
+    return None
+
+
+def dump_parse(text):
+    """ The record of the dump lines, None if there is no record. """
+    rec = Record()
+
+    for line in text.splitlines():
+        m = _RE_LINE.match(line)
+        if not m:
+            continue
+        body = m.group(1)
+
+        s = _RE_STACK.match(body)
+        if s:
+            base = int(s.group(1), 16)
+            for i, word in enumerate(s.group(2).split()):
+                rec.stack.append((base + i * 4, int(word, 16)))
+        elif body.startswith('trace '):
+            rec.trace.append(body[6:])
+        else:
+            for k, v in _RE_FIELD.findall(body):
+                rec.fields[k] = v
+
+    if 'pc' not in rec.fields:
+        return None
+    return rec
+
+
+def _bits(value, names):
+    return ' '.join(n for b, n in names if value & (1 << b)) or '-'
+
+
+def decode(funcs, rec):
+    """ The lines of the decoded record. """
+    f = rec.fields
+    out = []
+
+    def num(k):
+        return int(f.get(k, '0'), 16)
+
+    def where(addr):
+        return lookup(funcs, addr & ~1) or '?'
+
+    out.append('%s in %s, seq %s, tick %s' % (f.get('type', '?'), f.get('task', '-'), f.get('seq', '?'),
+                                               f.get('tick', '?')))
+    out.append('pc   0x%08x %s' % (num('pc'), where(num('pc'))))
+    # LR is the return address of the call, the call itself is just before it
+    out.append('lr   0x%08x %s' % (num('lr'), where(num('lr'))))
+    out.append('sp   0x%08x exc_return 0x%08x' % (num('sp'), num('exc_return')))
+
+    if 'cfsr' in f:
+        out.append('cfsr 0x%08x %s' % (num('cfsr'), _bits(num('cfsr'), CFSR_BITS)))
+        out.append('hfsr 0x%08x %s' % (num('hfsr'), _bits(num('hfsr'), HFSR_BITS)))
+        if num('cfsr') & (1 << 7):
+            out.append('mmfar 0x%08x' % num('mmfar'))
+        if num('cfsr') & (1 << 15):
+            out.append('bfar 0x%08x' % num('bfar'))
+
+    for off, word in rec.stack:
+        name = lookup(funcs, word & ~1)
+        if name:
+            out.append('stack+0x%03x 0x%08x %s' % (off, word, name))
+
+    for line in rec.trace:
+        out.append('trace %s' % line)
+
+    return out
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='decode a crash record against the symbols of the image')
+    parser.add_argument('image', help='the ELF of the build')
+    parser.add_argument('dump', nargs='?', help='"crash show" or AT+CRASH? output, default stdin')
+    args = parser.parse_args(argv)
+
+    with open(args.image, 'rb') as f:
+        funcs = elf_funcs(f.read())
+
+    if args.dump:
+        with open(args.dump, 'r', errors='replace') as f:
+            text = f.read()
+    else:
+        text = sys.stdin.read()
+
+    rec = dump_parse(text)
+    if rec is None:
+        print('no crash record in the dump')
+        return 1
+
+    for line in decode(funcs, rec):
+        print(line)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
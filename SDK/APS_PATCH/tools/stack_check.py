@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+###############################################################################
+#  Copyright 2017 - 2018, Opulinks Technology Ltd.
+#  ----------------------------------------------------------------------------
+#  Statement:
+#  ----------
+#  This software is protected by Copyright and the information contained
+#  herein is confidential. The software may not be copied and the information
+#  contained herein may not be used or disclosed except with the written
+#  permission of Opulinks Technology Ltd. (C) 2018
+###############################################################################
+#
+# Static stack check of the tasks, run on the build output.
+#
+#   stack_check.py <callgraph.htm> [--src DIR]... [--task NAME=ENTRY:WORDS]...
+#                  [--margin BYTES] [--strict] [--all]
+#
+# The callgraph is the .htm armlink writes with --callgraph --info=stack
+# (Output\Objects\opl1000_app_m3.htm). It gives the maximum depth of every
+# function of the image.
+#
+# The tasks are found in the sources: each osThreadDef_t of a .c file under
+# --src (default: APS, then APS_PATCH) gives its entry by ".pthread = Entry"
+# and its size by ".stacksize = MACRO" or a number. The macros are read from
+# the .h files under the same folders; a folder given later overrides an
+# earlier one, so APS_PATCH is given after APS. --task adds or replaces a task
+# by hand.
+#
+# A task is LOW when its stack (words * 4) is below the maximum depth of its
+# entry plus the margin. The margin (default 64) is the context the kernel
+# keeps on the task stack: 8 words of the exception frame and r4-r11 of
+# PendSV. The interrupts run on MSP and are not counted.
+#
+# The depth is a lower bound when armlink says "Unknown Stack Size" or
+# "In Cycle" (recursion, calls through function pointers). Most ROM code is
+# reached by function pointers and is not in the image either, so such tasks
+# are marked "+?"; --strict makes them fail too. A task whose entry is not in
+# the image (a ROM task, or another example) is left out, or listed as "-"
+# with --all.
+#
+# The exit code is 1 when a task is LOW (or unknown with --strict), else 0.
+###############################################################################
+
+import argparse
+import html
+import os
+import re
+import sys
+
+MARGIN_DEFAULT = 64
+
+_RE_FUNC = re.compile(r'<P><STRONG><a name="\[\w+\]"></a>([^<]+)</STRONG>\s*'
+                      r'\([^,]*,\s*\d+ bytes,\s*Stack size (\d+|unknown) bytes')
+_RE_DEPTH = re.compile(r'Max Depth = (\d+)((?:\s*\+\s*(?:Unknown Stack Size|In Cycle))*)')
+_RE_CHAIN = re.compile(r'Call Chain = ([^\n<]*)')
+_RE_DEFINE = re.compile(r'^\s*#\s*define\s+(\w+)\s+(\(?\s*\w+\s*\)?|"[^"\n]*")\s*(?://.*|/\*.*)?$', re.M)
+_RE_FIELD = re.compile(r'\b(\w+)\s*\.\s*(pthread|stacksize|name)\s*=\s*(?:\(\s*os_pthread\s*\)\s*)?([^;]+);')
+
+
+class Func(object):
+    def __init__(self, name, own):
+        self.name = name
+        self.own = own              # None when armlink does not know it
+        self.depth = own
+        self.unknown = (own is None)
+        self.chain = name
+
+
+class Task(object):
+    def __init__(self, name, entry, words, where):
+        self.name = name
+        self.entry = entry
+        self.words = words
+        self.where = where
+
+
+def callgraph_parse(text):
+    """ Functions of an armlink callgraph, by name. """
+    funcs = {}
+    starts = [m for m in _RE_FUNC.finditer(text)]
+
+    for i, m in enumerate(starts):
+        end = starts[i + 1].start() if i + 1 < len(starts) else len(text)
+        body = text[m.end():end]
+        own = None if m.group(2) == 'unknown' else int(m.group(2))
+        f = Func(html.unescape(m.group(1)).strip(), own)
+
+        d = _RE_DEPTH.search(body)
+        if d:
+            f.depth = int(d.group(1))
+            f.unknown = f.unknown or bool(d.group(2))
+            c = _RE_CHAIN.search(body)
+            if c:
+                f.chain = html.unescape(c.group(1)).replace('\u21d2', '->').strip()
+
+        funcs[f.name] = f
+
+    return funcs
+
+
+def _files(dirs, ext):
+    for d in dirs:
+        for root, _, names in sorted(os.walk(d)):
+            for n in sorted(names):
+                if n.endswith(ext):
+                    yield os.path.join(root, n)
+
+
+def _read(path):
+    with open(path, 'r', errors='replace') as f:
+        return f.read()
+
+
+def macros_load(dirs):
+    """ Plain "#define NAME value" of the headers, the later folders win. """
+    macros = {}
+
+    for d in dirs:
+        for path in _files([d], '.h'):
+            for m in _RE_DEFINE.finditer(_read(path)):
+                macros[m.group(1)] = m.group(2).strip('( )')
+
+    return macros
+
+
+def _value(token, macros):
+    seen = set()
+
+    while token not in seen:
+        seen.add(token)
+        try:
+            return int(token, 0)
+        except ValueError:
+            pass
+        if token not in macros:
+            return None
+        token = macros[token]
+
+    return None
+
+
+def tasks_scan(dirs, macros):
+    """ Tasks of the osThreadDef_t assignments in the sources. """
+    tasks = []
+
+    for path in _files(dirs, '.c'):
+        text = re.sub(r'//[^\n]*', '', _read(path))
+        pending = {}
+
+        for m in _RE_FIELD.finditer(text):
+            var, field, value = m.group(1), m.group(2), m.group(3).strip()
+            cur = pending.setdefault(var, {})
+            cur[field] = value
+
+            if field != 'stacksize' or 'pthread' not in cur:
+                continue
+
+            words = _value(value, macros)
+            name = cur.get('name', cur['pthread'])
+            name = macros.get(name, name).strip('"')
+            line = text.count('\n', 0, m.start()) + 1
+
+            if words is not None:
+                tasks.append(Task(name, cur['pthread'], words, '%s:%d' % (path, line)))
+            pending[var] = {}
+
+    return tasks
+
+
+def task_check(task, funcs, margin):
+    """ (status, need) of a task; status is OK, LOW or - """
+    f = funcs.get(task.entry)
+    if f is None or f.depth is None:
+        return '-', None
+
+    need = f.depth + margin
+    return ('LOW' if task.words * 4 < need else 'OK'), need
+
+
+def main(argv):
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description='flag the tasks whose stack is below the static worst case')
+    parser.add_argument('callgraph', help='.htm of armlink --callgraph --info=stack')
+    parser.add_argument('--src', action='append', help='source folder, later ones override (default: APS APS_PATCH)')
+    parser.add_argument('--task', action='append', default=[], help='NAME=ENTRY:WORDS, added by hand')
+    parser.add_argument('--margin', type=int, default=MARGIN_DEFAULT, help='bytes kept by the kernel (default 64)')
+    parser.add_argument('--strict', action='store_true', help='a task with an unknown part fails too')
+    parser.add_argument('--all', action='store_true', help='list the tasks not in the image too')
+    args = parser.parse_args(argv)
+
+    sdk = os.path.dirname(os.path.dirname(here))
+    dirs = args.src or [os.path.join(sdk, 'APS'), os.path.join(sdk, 'APS_PATCH')]
+    funcs = callgraph_parse(_read(args.callgraph))
+    macros = macros_load(dirs)
+    tasks = tasks_scan(dirs, macros)
+
+    for t in args.task:
+        m = re.match(r'^([^=]+)=(\w+):(\w+)$', t)
+        if not m or _value(m.group(3), macros) is None:
+            parser.error('bad --task %s' % t)
+        tasks = [x for x in tasks if x.name != m.group(1)]
+        tasks.append(Task(m.group(1), m.group(2), _value(m.group(3), macros), '--task'))
+
+    fail = 0
+    print('%-16s %-28s %6s %6s  %s' % ('task', 'entry', 'stack', 'need', 'status'))
+
+    for task in sorted(tasks, key=lambda x: (x.name, x.where)):
+        status, need = task_check(task, funcs, args.margin)
+        if status == '-' and not args.all:
+            continue
+
+        f = funcs.get(task.entry)
+        unknown = (f is not None and f.unknown)
+
+        if status == 'LOW' or (args.strict and status != '-' and unknown):
+            fail = 1
+
+        print('%-16s %-28s %6d %6s  %s%s' % (task.name, task.entry, task.words * 4,
+                                            '-' if need is None else '%d%s' % (need, '+?' if unknown else ''),
+                                            status, '' if status != 'LOW' else '  ' + f.chain))
+
+    return fail
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))